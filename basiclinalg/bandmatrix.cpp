@@ -79,6 +79,111 @@ namespace ngbla
   }
   
   
+  // sum_{i<n} a[i]*b[i]
+  INLINE double BandDot (int n, const double * a, const double * b)
+  {
+    constexpr int SW = SIMD<double>::Size();
+    SIMD<double> sum = 0.0;
+    int i = 0;
+    for ( ; i+SW <= n; i += SW)
+      sum = FMA (SIMD<double>(a+i), SIMD<double>(b+i), sum);
+    if (i < n)
+      {
+        SIMD<mask64> mask(size_t(n-i));
+        sum = FMA (SIMD<double>(a+i, mask), SIMD<double>(b+i, mask), sum);
+      }
+    return HSum(sum);
+  }
+
+  // y[i] -= s * a[i], i < n
+  INLINE void BandSubAxpy (int n, double s, const double * a, double * y)
+  {
+    constexpr int SW = SIMD<double>::Size();
+    int i = 0;
+    for ( ; i+SW <= n; i += SW)
+      {
+        SIMD<double> yi = SIMD<double>(y+i) - s * SIMD<double>(a+i);
+        yi.Store (y+i);
+      }
+    if (i < n)
+      {
+        SIMD<mask64> mask(size_t(n-i));
+        SIMD<double> yi = SIMD<double>(y+i, mask) - s * SIMD<double>(a+i, mask);
+        yi.Store (y+i, mask);
+      }
+  }
+
+  
+  template <>
+  void FlatBandCholeskyFactors<double> :: 
+  Factor (const FlatSymBandMatrix<double> & a )
+  {
+    static Timer timer ("Band Cholesky, SIMD");
+    RegionTimer reg (timer);
+
+    ArrayMem<double, 100> help(n);
+
+    for (int i = 0; i < n; i++)
+      {
+        int mink = max2(0, i-bw+1);
+        int ki = Index(i, mink);
+
+        for (int k = mink; k < i; k++, ki++)
+          help[k] = mem[k] * mem[ki];
+
+        int maxj = min2(n, i+bw);
+        for (int j = i; j < maxj; j++)
+          {
+            int mink = max2(0, j-bw+1);
+            double x = a(j,i);
+            if (mink < i)
+              x -= BandDot (i-mink, &mem[Index(j, mink)], &help[mink]);
+            timer.AddFlops (2*max2(0, i-mink));
+
+            if (i == j)
+              mem[i] = x;
+            else
+              (*this)(j,i) = x / mem[i];
+          }
+      }
+
+    for (int i = 0; i < n; i++)
+      mem[i] = 1.0 / mem[i];
+  }
+
+
+  template <> template <>
+  void FlatBandCholeskyFactors<double> :: 
+  Mult (const FlatVector<double> & x, FlatVector<double> & y) const
+  {
+    double * hy = y.Data();
+    const double * hm = &mem[0];
+
+    for (int i = 0; i < n; i++)
+      hy[i] = x(i);
+
+    // forward substitution with unit lower factor, row-wise storage
+    int jj = n;
+    for (int i = 1; i < n; i++)
+      {
+        int firstj = max2(0, i-bw+1);
+        hy[i] -= BandDot (i-firstj, hm+jj, hy+firstj);
+        jj += i-firstj;
+      }
+
+    for (int i = 0; i < n; i++)
+      hy[i] *= hm[i];
+
+    // backward substitution, column updates from the stored rows
+    for (int i = n-1; i >= 1; i--)
+      {
+        int firstj = max2(0, i-bw+1);
+        jj -= i-firstj;
+        BandSubAxpy (i-firstj, hy[i], hm+jj, hy+firstj);
+      }
+  }
+
+  
   /*
   template <class T>  
   void FlatBandCholeskyFactors<T> :: 
@@ -161,6 +266,7 @@ namespace ngbla
 
   template class FlatBandCholeskyFactors<double>;
   template class FlatBandCholeskyFactors<Complex>;
+  template class FlatBandCholeskyFactors<SIMD<double>>;
 #if MAX_SYS_DIM >= 1
   template class FlatBandCholeskyFactors<Mat<1,1,double> >;
   template class FlatBandCholeskyFactors<Mat<1,1,Complex> >;
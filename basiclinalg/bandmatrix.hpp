@@ -163,6 +163,10 @@ namespace ngbla
      1    2   d2        
      3    4   d3   
      \end{verbatim}
+
+     For T = double, factorization and solve use SIMD kernels.
+     T = SIMD<double> factors SIMD<double>::Size() matrices of the same
+     dimension and bandwidth at once, matrix k is stored in lane k.
   */
   template <class T = double>
   class FlatBandCholeskyFactors
@@ -294,6 +298,14 @@ namespace ngbla
   };
   
 
+  template <>
+  NGS_DLL_HEADER void FlatBandCholeskyFactors<double> :: Factor (const FlatSymBandMatrix<double> & a);
+
+  template <> template <>
+  NGS_DLL_HEADER void FlatBandCholeskyFactors<double> ::
+  Mult (const FlatVector<double> & x, FlatVector<double> & y) const;
+
+
   ///  output operator.
   template<typename T>
   inline std::ostream & operator<< (std::ostream & s, const FlatBandCholeskyFactors<T> & m)
@@ -128,6 +128,177 @@ namespace ngbla
 
 
 
+  // c -= a * b, tiles of c are distributed to the tasks
+  static void ParallelSubAB (SliceMatrix<double> a, SliceMatrix<double> b, SliceMatrix<double> c)
+  {
+    constexpr size_t BH = 96;
+    constexpr size_t BW = 128;
+    size_t nr = (c.Height()+BH-1) / BH;
+    size_t nc = (c.Width()+BW-1) / BW;
+    if (nr*nc == 0 || a.Width() == 0) return;
+    if (nr*nc == 1)
+      {
+        SubAB (a, b, c);
+        return;
+      }
+    ParallelFor (nr*nc, [a,b,c,nr] (size_t i)
+                 {
+                   size_t br = i % nr, bc = i / nr;
+                   IntRange rowr(BH*br, min(BH*(br+1), c.Height()));
+                   IntRange colr(BW*bc, min(BW*(bc+1), c.Width()));
+                   SubAB (a.Rows(rowr), b.Cols(colr), c.Rows(rowr).Cols(colr));
+                 });
+  }
+
+  // b = L^{-1} b for a small unit lower, or b = U^{-1} b for a small upper
+  // triangular block, the columns of b are split between the tasks
+  template <bool UPPER>
+  static void SolveTrigBlock (SliceMatrix<double> lu, SliceMatrix<double> b)
+  {
+    size_t nb = lu.Height();
+    auto solve = [lu,b,nb] (IntRange r)
+      {
+        if (UPPER)
+          for (size_t i = nb; i-- > 0; )
+            {
+              auto bi = b.Row(i).Range(r);
+              for (size_t j = i+1; j < nb; j++)
+                bi -= lu(i,j) * b.Row(j).Range(r);
+              bi *= 1.0/lu(i,i);
+            }
+        else
+          for (size_t i = 1; i < nb; i++)
+            {
+              auto bi = b.Row(i).Range(r);
+              for (size_t j = 0; j < i; j++)
+                bi -= lu(i,j) * b.Row(j).Range(r);
+            }
+      };
+    if (b.Width() < 256)
+      solve (IntRange(b.Width()));
+    else
+      ParallelForRange (IntRange(b.Width()), solve);
+  }
+  
+  void CalcLU (SliceMatrix<double> a, FlatArray<int> p)
+  {
+    static Timer t("CalcLU"); RegionTimer reg(t);
+    size_t n = a.Height();
+    t.AddFlops (2.0/3*n*n*n);
+    constexpr size_t NB = 64;
+
+    for (size_t i = 0; i < n; i++) p[i] = i;
+
+    for (size_t k = 0; k < n; k += NB)
+      {
+        size_t k2 = min(n, k+NB);
+
+        // unblocked factorization of the panel, rows are swapped over the full width
+        for (size_t j = k; j < k2; j++)
+          {
+            size_t piv = j;
+            double maxval = fabs(a(j,j));
+            for (size_t i = j+1; i < n; i++)
+              if (fabs(a(i,j)) > maxval)
+                {
+                  piv = i;
+                  maxval = fabs(a(i,j));
+                }
+            if (maxval == 0)
+              throw Exception ("CalcLU: Matrix singular");
+
+            if (piv != j)
+              {
+                for (size_t l = 0; l < n; l++)
+                  swap (a(j,l), a(piv,l));
+                swap (p[j], p[piv]);
+              }
+
+            double invd = 1.0 / a(j,j);
+            auto urow = a.Row(j).Range(j+1, k2);
+            auto update = [a,urow,invd,j,k2] (IntRange r)
+              {
+                for (size_t i : r)
+                  {
+                    double lij = (a(i,j) *= invd);
+                    a.Row(i).Range(j+1, k2) -= lij * urow;
+                  }
+              };
+            if (n-j < 1024)
+              update (IntRange(j+1, n));
+            else
+              ParallelForRange (IntRange(j+1, n), update);
+          }
+
+        if (k2 == n) break;
+        
+        // U12 = L11^{-1} A12,  A22 -= L21 U12
+        SolveTrigBlock<false> (a.Rows(k,k2).Cols(k,k2), a.Rows(k,k2).Cols(k2,n));
+        ParallelSubAB (a.Rows(k2,n).Cols(k,k2), a.Rows(k,k2).Cols(k2,n), a.Rows(k2,n).Cols(k2,n));
+      }
+  }
+
+  void SolveFromLU (SliceMatrix<double> a, FlatArray<int> p, SliceMatrix<double> b)
+  {
+    static Timer t("SolveFromLU"); RegionTimer reg(t);
+    size_t n = a.Height();
+    t.AddFlops (2.0*n*n*b.Width());
+    constexpr size_t NB = 64;
+
+    Matrix<> hb(n, b.Width());
+    for (size_t i = 0; i < n; i++)
+      hb.Row(i) = b.Row(p[i]);
+    b = hb;
+
+    for (size_t k = 0; k < n; k += NB)
+      {
+        size_t k2 = min(n, k+NB);
+        SolveTrigBlock<false> (a.Rows(k,k2).Cols(k,k2), b.Rows(k,k2));
+        ParallelSubAB (a.Rows(k2,n).Cols(k,k2), b.Rows(k,k2), b.Rows(k2,n));
+      }
+
+    for (size_t k2 = n; k2 > 0; )
+      {
+        size_t k = (k2 > NB) ? k2-NB : 0;
+        SolveTrigBlock<true> (a.Rows(k,k2).Cols(k,k2), b.Rows(k,k2));
+        ParallelSubAB (a.Rows(0,k).Cols(k,k2), b.Rows(k,k2), b.Rows(0,k));
+        k2 = k;
+      }
+  }
+
+  // A^{-1} = U^{-1} L^{-1} P, L^{-1} is lower triangular, so the forward
+  // substitution only works on the columns left of the diagonal block
+  void InverseFromLU (SliceMatrix<double> a, FlatArray<int> p)
+  {
+    static Timer t("InverseFromLU"); RegionTimer reg(t);
+    size_t n = a.Height();
+    t.AddFlops (4.0/3*n*n*n);
+    constexpr size_t NB = 64;
+
+    Matrix<> inv(n, n);
+    inv = Identity(n);
+
+    for (size_t k = 0; k < n; k += NB)
+      {
+        size_t k2 = min(n, k+NB);
+        SolveTrigBlock<false> (a.Rows(k,k2).Cols(k,k2), inv.Rows(k,k2).Cols(0,k2));
+        ParallelSubAB (a.Rows(k2,n).Cols(k,k2), inv.Rows(k,k2).Cols(0,k2), inv.Rows(k2,n).Cols(0,k2));
+      }
+
+    for (size_t k2 = n; k2 > 0; )
+      {
+        size_t k = (k2 > NB) ? k2-NB : 0;
+        SolveTrigBlock<true> (a.Rows(k,k2).Cols(k,k2), inv.Rows(k,k2));
+        ParallelSubAB (a.Rows(0,k).Cols(k,k2), inv.Rows(k,k2), inv.Rows(0,k));
+        k2 = k;
+      }
+
+    for (size_t i = 0; i < n; i++)
+      a.Col(p[i]) = inv.Col(i);
+  }
+  
+
+  
   void CalcSchurComplement (const FlatMatrix<double> a, 
 			    FlatMatrix<double> s,
 			    const BitArray & used,
@@ -195,8 +366,23 @@ namespace ngbla
   {
 #ifdef LAPACK
     if (il == INVERSE_LIB::INV_LAPACK)
-      LapackInverse(inv);
-    else if (il == INVERSE_LIB::INV_CHOOSE && inv.Height() >= 20)
+      {
+        LapackInverse(inv);
+        return;
+      }
+#endif
+
+    // blocked LU, parallel through the task manager
+    if (inv.Height() >= 200)
+      {
+        ArrayMem<int,1000> p(inv.Height());
+        CalcLU (inv, p);
+        InverseFromLU (inv, p);
+        return;
+      }
+    
+#ifdef LAPACK
+    if (il == INVERSE_LIB::INV_CHOOSE && inv.Height() >= 20)
       LapackInverse(inv);        
     else
 #endif
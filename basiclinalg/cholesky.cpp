@@ -8,6 +8,38 @@ namespace ngbla
    See Stoer, Einf. in die Num. Math, S 146
 */
 
+  template <class T>
+  bool FactorLDLBlocked (const FlatMatrix<T> & a, T * diag, T * lfact)
+  {
+    return false;
+  }
+
+  // large real matrices: recursive LDL^T with parallel updates, then
+  // pack into the row-wise storage
+  bool FactorLDLBlocked (const FlatMatrix<double> & a, double * diag, double * lfact)
+  {
+    size_t n = a.Height();
+    if (n < 128) return false;
+
+    Matrix<double,ColMajor> ldl(n,n);
+    for (size_t j = 0; j < n; j++)
+      for (size_t i = j; i < n; i++)
+        ldl(i,j) = a(i,j);
+
+    // afterwards ldl(i,i) = 1/D_ii and ldl(i,j) = L_ij D_jj, i > j
+    CalcLDL (SliceMatrix<double,ColMajor> (ldl));
+
+    for (size_t i = 0; i < n; i++)
+      {
+        diag[i] = ldl(i,i);
+        double * prow = lfact + (i*(i-1))/2;
+        for (size_t j = 0; j < i; j++)
+          prow[j] = ldl(i,j) * ldl(j,j);
+      }
+    return true;
+  }
+  
+
   // Compute A = L D L^T decomposition
   // A_{ij} = \sum_k L_ik D_kk L_jk
   // L .. lower left factor, row-wise storage
@@ -22,6 +54,9 @@ namespace ngbla
     //    diag = new T[n*(n+1)/2];
     lfact = diag+n;
 
+    if (FactorLDLBlocked (a, diag, lfact))
+      return;
+
     T x;
     
     for (int i = 0; i < n; i++)
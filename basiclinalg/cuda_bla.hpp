@@ -165,7 +165,93 @@ namespace ngs_cuda
 
 
 
+  /*
+    A batch of equally sized row-major matrices in device memory.
+    On the host side the batch is a FlatMatrix of height batch*h,
+    where matrix e is stored in rows e*h ... (e+1)*h-1.
+  */
+  template <typename T = double>
+  class DevBatchMatrix 
+  {
+    int batch, h, w;
+    T * dev_data;
+  
+  public: 
+    DevBatchMatrix (int abatch, int ah, int aw)
+      : batch(abatch), h(ah), w(aw)
+    {
+      cudaMalloc((T**)&dev_data, batch*h*w*sizeof(T));
+    }
+
+    DevBatchMatrix (int abatch, FlatMatrix<T> a2)
+      : batch(abatch), h(a2.Height()/abatch), w(a2.Width())
+    {
+      cudaMalloc((T**)&dev_data, batch*h*w*sizeof(T));
+      cudaMemcpy (dev_data, &a2(0,0), sizeof(T)*batch*h*w, cudaMemcpyHostToDevice);
+    }
+
+    DevBatchMatrix (const DevBatchMatrix &) = delete;
+
+    ~DevBatchMatrix ()
+    {
+      cudaFree (dev_data);
+    }
+
+    T * Data() const { return dev_data; }
+
+    DevBatchMatrix & operator= (FlatMatrix<T> a2)
+    {
+      cudaMemcpy (dev_data, &a2(0,0), sizeof(T)*batch*h*w, cudaMemcpyHostToDevice);
+      return *this;
+    }
 
+    void D2H (FlatMatrix<T> a2) const
+    {
+      cudaMemcpy (&a2(0,0), dev_data, sizeof(T)*batch*h*w, cudaMemcpyDeviceToHost);    
+    }
+
+    INLINE int BatchSize() const { return batch; }
+    INLINE int Height() const { return h; }
+    INLINE int Width() const { return w; }
+
+    Matrix<T> Host() const
+    {
+      Matrix<T> temp(batch*h, w);
+      D2H (temp);
+      return temp;
+    }
+  };
+
+
+  /*
+    Batched dense kernels on device pointers, implemented with cuBLAS
+    in linalg/cuda_linalg.cpp.  All matrices are row-major, matrix e of
+    a batch starts at e*height*width.
+  */
+  
+  // c_e = a_e * b_e, or c_e += a_e * b_e,  a_e is h x k, b_e is k x w
+  extern void MultBatched (int batch, int h, int w, int k,
+                           const double * a, const double * b, double * c,
+                           bool add = false);
+
+  // c_e += Trans(a_e) * diag(d_e) * b_e,  a_e is npts x n, b_e is npts x m, d_e has npts entries
+  extern void AddAtDBBatched (int batch, int npts, int n, int m,
+                              const double * a, const double * d, const double * b, double * c);
+
+  inline void MultBatched (const DevBatchMatrix<double> & a, const DevBatchMatrix<double> & b,
+                           DevBatchMatrix<double> & c, bool add = false)
+  {
+    MultBatched (a.BatchSize(), a.Height(), b.Width(), a.Width(),
+                 a.Data(), b.Data(), c.Data(), add); 
+  }
+
+  // d is a batch of npts x 1 matrices
+  inline void AddAtDBBatched (const DevBatchMatrix<double> & a, const DevBatchMatrix<double> & d,
+                              const DevBatchMatrix<double> & b, DevBatchMatrix<double> & c)
+  {
+    AddAtDBBatched (a.BatchSize(), a.Height(), a.Width(), b.Width(),
+                    a.Data(), d.Data(), b.Data(), c.Data());
+  }
 }
 
 #endif
@@ -45,6 +45,21 @@ namespace ngbla
   template <bool ADD, bool POS, ORDERING ord>
   void NgGEMV (SliceMatrix<double,ord> a, FlatVector<double> x, FlatVector<double> y);
 
+  template <bool ADD, bool POS, ORDERING orda, ORDERING ordb>
+  void NgGEMM (SliceMatrix<Complex,orda> a, SliceMatrix<Complex, ordb> b, SliceMatrix<Complex> c);
+
+  template <bool ADD, bool POS, ORDERING orda, ORDERING ordb>
+  void NgGEMM (SliceMatrix<Complex,orda> a, SliceMatrix<Complex, ordb> b, SliceMatrix<Complex,ColMajor> c);
+  
+  template <bool ADD, bool POS, ORDERING ord>
+  void NgGEMV (SliceMatrix<Complex,ord> a, FlatVector<Complex> x, FlatVector<Complex> y);
+
+  template <bool ADD, bool POS, ORDERING orda, ORDERING ordb>
+  void NgGEMM (SliceMatrix<float,orda> a, SliceMatrix<double, ordb> b, SliceMatrix<double> c);
+
+  template <bool ADD, bool POS, ORDERING ord>
+  void NgGEMV (SliceMatrix<float,ord> a, FlatVector<double> x, FlatVector<double> y);
+
   /*
     Matrix expression templates
   */
@@ -651,6 +666,69 @@ namespace ngbla
 
 
     
+    template <typename OP, typename TA, typename TB,
+              typename enable_if<IsConvertibleToSliceMatrix<TA,Complex>(),int>::type = 0,
+              typename enable_if<IsConvertibleToSliceMatrix<TB,Complex>(),int>::type = 0,
+              typename enable_if<IsConvertibleToSliceMatrix<typename pair<T,TB>::first_type,Complex>(),int>::type = 0>
+    INLINE T & Assign (const Expr<MultExpr<TA, TB>> & prod) 
+    {
+      constexpr bool ADD = std::is_same<OP,AsAdd>::value || std::is_same<OP,AsSub>::value;
+      constexpr bool POS = std::is_same<OP,As>::value || std::is_same<OP,AsAdd>::value;
+      
+      NgGEMM<ADD,POS> (make_SliceMatrix(prod.Spec().A()),
+                       make_SliceMatrix(prod.Spec().B()),
+                       make_SliceMatrix(Spec()));
+      return Spec();
+    }
+
+    template <typename OP, typename TA, typename TB,
+              typename enable_if<IsConvertibleToSliceMatrix<TA,Complex>(),int>::type = 0,
+              typename enable_if<is_convertible<TB,FlatVector<Complex>>::value,int>::type = 0,
+              typename enable_if<is_convertible<typename pair<T,TB>::first_type,FlatVector<Complex>>::value,int>::type = 0>
+    INLINE T & Assign (const Expr<MultExpr<TA, TB>> & prod)
+    {
+      constexpr bool ADD = std::is_same<OP,AsAdd>::value || std::is_same<OP,AsSub>::value;
+      constexpr bool POS = std::is_same<OP,As>::value || std::is_same<OP,AsAdd>::value;
+      
+      NgGEMV<ADD,POS> (make_SliceMatrix(prod.Spec().A()),
+                       prod.Spec().B(),
+                       Spec());
+      return Spec();
+    }
+
+
+    
+    template <typename OP, typename TA, typename TB,
+              typename enable_if<IsConvertibleToSliceMatrix<TA,float>(),int>::type = 0,
+              typename enable_if<IsConvertibleToSliceMatrix<TB,double>(),int>::type = 0,
+              typename enable_if<IsConvertibleToSliceMatrix<typename pair<T,TB>::first_type,double>(),int>::type = 0>
+    INLINE T & Assign (const Expr<MultExpr<TA, TB>> & prod) 
+    {
+      constexpr bool ADD = std::is_same<OP,AsAdd>::value || std::is_same<OP,AsSub>::value;
+      constexpr bool POS = std::is_same<OP,As>::value || std::is_same<OP,AsAdd>::value;
+      
+      NgGEMM<ADD,POS> (make_SliceMatrix(prod.Spec().A()),
+                       make_SliceMatrix(prod.Spec().B()),
+                       make_SliceMatrix(Spec()));
+      return Spec();
+    }
+
+    template <typename OP, typename TA, typename TB,
+              typename enable_if<IsConvertibleToSliceMatrix<TA,float>(),int>::type = 0,
+              typename enable_if<is_convertible<TB,FlatVector<double>>::value,int>::type = 0,
+              typename enable_if<is_convertible<typename pair<T,TB>::first_type,FlatVector<double>>::value,int>::type = 0>
+    INLINE T & Assign (const Expr<MultExpr<TA, TB>> & prod)
+    {
+      constexpr bool ADD = std::is_same<OP,AsAdd>::value || std::is_same<OP,AsSub>::value;
+      constexpr bool POS = std::is_same<OP,As>::value || std::is_same<OP,AsAdd>::value;
+      
+      NgGEMV<ADD,POS> (make_SliceMatrix(prod.Spec().A()),
+                       prod.Spec().B(),
+                       Spec());
+      return Spec();
+    }
+
+    
     template<typename TB>
     INLINE T & operator= (const Expr<TB> & v)
     {
@@ -1700,6 +1778,12 @@ namespace ngbla
     inv = 1.0 / m;
   }
 
+  template <int N>
+  INLINE void CalcInverse (const SIMD<double,N> & m, SIMD<double,N> & inv)
+  {
+    inv = 1.0 / m;
+  }
+
   template <int H, int W, typename T, typename TINV>
   inline void CalcInverse (const Mat<H,W,T> & m, TINV & inv)
   {
@@ -8,6 +8,9 @@ using namespace std;
 #include "../ngstd/simd.hpp"
 using namespace ngstd;
 
+// SIMD width the generated code is tuned for, host width by default
+int simd_width = SIMD<double>::Size();
+
 enum OP { ADD, SUB, SET, SETNEG };
 
 string ToString (OP op)
@@ -860,7 +863,7 @@ void  GenerateMatVec (ostream & out, int wa, OP op)
   out << "template <> INLINE void KernelMatVec<" << wa << ", " << ToString(op) << ">" << endl
       << "(size_t ha, double * pa, size_t da, double * x, double * y) {" << endl;
 
-  int SW = SIMD<double>::Size();  // generate optimal code for my host
+  int SW = simd_width;  // generate optimal code for the target
   // out << "constexpr int SW = SIMD<double>::Size();" << endl;
   int i = 0;
   for ( ; SW*(i+1) <= wa; i++)
@@ -987,9 +990,14 @@ void  GenerateMatVec (ostream & out, int wa, OP op)
 
 
 
-int main ()
+// kernel_generator [outfile [simd-width]]
+// e.g. kernel_generator matkernel_avx512.hpp 8 for the runtime-dispatched AVX-512 kernels
+int main (int argc, char ** argv)
 {
-  ofstream out("matkernel.hpp");
+  string filename = argc > 1 ? argv[1] : "matkernel.hpp";
+  if (argc > 2)
+    simd_width = atoi(argv[2]);
+  ofstream out(filename);
 
   out << "enum OPERATION { ADD, SUB, SET, SETNEG };" << endl;
 
@@ -1957,6 +1957,12 @@ namespace ngbla
     return FlatMatrix<Complex,ColMajor> (mat.Width(), mat.Height(), &mat(0,0));
   }
 
+  INLINE
+  FlatMatrix<float,ColMajor> Trans (FlatMatrix<float,RowMajor> mat)
+  {
+    return FlatMatrix<float,ColMajor> (mat.Width(), mat.Height(), &mat(0,0));
+  }
+
   INLINE
   FlatMatrix<double,RowMajor> Trans (FlatMatrix<double,ColMajor> mat)
   {
@@ -1984,6 +1990,12 @@ namespace ngbla
     return SliceMatrix<Complex> (mat.Width(), mat.Height(), mat.Dist(), &mat(0,0));
   }
 
+  INLINE 
+  const SliceMatrix<float> Trans (SliceMatrix<float,ColMajor> mat)
+  {
+    return SliceMatrix<float> (mat.Width(), mat.Height(), mat.Dist(), &mat(0,0));
+  }
+
   INLINE 
   const SliceMatrix<double,ColMajor> Trans (SliceMatrix<double,RowMajor> mat)
   {
@@ -496,9 +496,28 @@ namespace ngbla
 
   
   
+#if defined(NGS_AVX512_DISPATCH) && !defined(__AVX512F__)
+  // kernels in ngblas_avx512.cpp, used if the cpu supports AVX-512
+  extern void MultMatMat_AVX512 (int op, size_t ha, size_t wa, size_t wb,
+                                 double * pa, size_t da, double * pb, size_t db, double * pc, size_t dc);
+
+  static bool use_avx512_kernels =
+    __builtin_cpu_supports("avx512f") && !getenv("NGS_NO_AVX512");
+  
+#define NGS_DISPATCH_AVX512(OP)                                              \
+  if (use_avx512_kernels)                                                  \
+    {                                                                      \
+      MultMatMat_AVX512 (OP, ha, wa, wb, &a(0), a.Dist(), &b(0), b.Dist(), &c(0), c.Dist()); \
+      return;                                                              \
+    }
+#else
+#define NGS_DISPATCH_AVX512(OP)
+#endif
+  
   void MultMatMat_intern (size_t ha, size_t wa, size_t wb,
                           BareSliceMatrix<> a, BareSliceMatrix<> b, BareSliceMatrix<> c)
   {
+    NGS_DISPATCH_AVX512(SET);
     constexpr size_t BBH = 128;
     if (wa <= BBH)
       {
@@ -524,6 +543,7 @@ namespace ngbla
   void MinusMultAB_intern (size_t ha, size_t wa, size_t wb,
                            BareSliceMatrix<> a, BareSliceMatrix<> b, BareSliceMatrix<> c)
   {
+    NGS_DISPATCH_AVX512(SETNEG);
     constexpr size_t BBH = 128;
     if (wb < 3*SIMD<double>::Size())
       MultMatMat_intern2_SlimB<BBH,SETNEG> (ha, wa, wb, a, b, c);
@@ -552,6 +572,7 @@ namespace ngbla
         ;
       }
     
+    NGS_DISPATCH_AVX512(ADD);
     constexpr size_t BBH = 128;
     if (wb < 3*SIMD<double>::Size())
       MultMatMat_intern2_SlimB<BBH,ADD> (ha, wa, wb, a, b, c);
@@ -566,6 +587,7 @@ namespace ngbla
   void SubAB_intern (size_t ha, size_t wa, size_t wb,
                      BareSliceMatrix<> a, BareSliceMatrix<> b, BareSliceMatrix<> c)
   {
+    NGS_DISPATCH_AVX512(SUB);
     constexpr size_t BBH = 128;
     if (wb < 3*SIMD<double>::Size())
       MultMatMat_intern2_SlimB<BBH,SUB> (ha, wa, wb, a, b, c);
@@ -1075,6 +1097,86 @@ namespace ngbla
   }
 
 
+  // as TAddABt4Sym, but c is the packed lower triangle, row i starts at i*(i+1)/2.
+  // Within the diagonal block only entries j <= i are stored
+  template <typename TAB, typename FUNC>
+  INLINE void TAddABt4SymPacked (size_t wa, size_t hc,
+                                 TAB * pa, size_t da, TAB * pb, size_t db, double * pc,
+                                 FUNC func)
+  {
+#ifdef __AVX512F__
+    constexpr size_t HA = 6;
+#else
+    constexpr size_t HA = 3;
+#endif
+    
+    TAB * pb0 = pb;
+    size_t i = 0;
+    for ( ; i+HA <= hc; i += HA, pa += HA*da)
+      {
+        TAB * pb = pb0;
+        size_t j = 0;
+        for ( ; j+4 <= i+1; j += 4, pb += 4*db)
+          {
+            auto scal = MatKernelScalAB<HA,4>(wa, pa, da, pb, db);
+            Iterate<HA> ([&] (auto ii) {
+                size_t row = i+ii.value;
+                double * pci = pc+row*(row+1)/2+j;
+                auto si = func (SIMD<double,4>(pci), get<ii.value>(scal));
+                si.Store(pci);
+              });
+          }
+        for ( ; j < i+HA; j++, pb += db)
+          {
+            auto scal = MatKernelScalAB<HA,1>(wa, pa, da, pb, db);
+            Iterate<HA> ([&] (auto ii) {
+                size_t row = i+ii.value;
+                if (j <= row)
+                  {
+                    double * pci = pc+row*(row+1)/2+j;
+                    *pci = func (*pci, get<ii.value>(scal));
+                  }
+              });
+          }
+      }
+    for ( ; i < hc; i ++, pa += da)
+      {
+        double * pc1 = pc+i*(i+1)/2;
+        TAB * pb = pb0;
+        size_t j = 0;
+        for ( ; j+3 <= i; j += 4, pb += 4*db)
+          {
+            auto scal = MatKernelScalAB<1,4>(wa, pa, da, pb, db);
+            auto s1 = func (SIMD<double,4>(pc1+j), get<0>(scal));
+            s1.Store(pc1+j);
+          }
+        for ( ; j <= i; j++, pb += db)
+          {
+            auto scal = MatKernelScalAB<1,1>(wa, pa, da, pb, db);
+            pc1[j] = func (pc1[j], get<0>(scal));
+          }
+      }
+  }
+
+  void AddABtSym (SliceMatrix<double> a,
+                  SliceMatrix<double> b,
+                  FlatSymmetricMatrix<double> c)
+  {
+    TAddABt4SymPacked(a.Width(), a.Height(),
+                      &a(0), a.Dist(), &b(0), b.Dist(), c.Data(),
+                      [] (auto c, auto ab) { return c+ab; });
+  }
+
+  void AddABtSym (SliceMatrix<SIMD<double>> a,
+                  SliceMatrix<SIMD<double>> b,
+                  FlatSymmetricMatrix<double> c)
+  {
+    TAddABt4SymPacked(a.Width(), a.Height(),
+                      &a(0), a.Dist(), &b(0), b.Dist(), c.Data(),
+                      [] (auto c, auto ab) { return c+ab; });
+  }
+
+
 
   
   
@@ -1923,6 +2025,463 @@ namespace ngbla
   }
 
 
+
+  /* ************************** Complex A * B ************************* */
+
+  // rows of B are stored as blocks of SIMD<Complex>, in the (permuted)
+  // lane order of LoadFast, C is loaded and stored in the same order
+  INLINE void CopyMatrixIn (size_t h, size_t w,
+                            Complex * ps, size_t dists,
+                            SIMD<Complex> * pd, size_t distd)
+  {
+    constexpr size_t SW = SIMD<double>::Size();
+    for (size_t i = 0; i < h; i++, pd += distd, ps += dists)
+      {
+        size_t js = 0, jd = 0;
+        for ( ; js+SW <= w; js += SW, jd++)
+          pd[jd].LoadFast (ps+js);
+        if (js < w)
+          pd[jd].LoadFast (ps+js, w-js);
+      }
+  }
+
+  // C(0:H, 0:W*SW) op= A(0:H, 0:k) * B, B packed with distance db
+  template <size_t H, size_t W, OPERATION OP, bool MASK>
+  INLINE void MatKernelComplexAB (size_t k,
+                                  Complex * pa, size_t da,
+                                  SIMD<Complex> * pb, size_t db,
+                                  Complex * pc, size_t dc, int nr = 0)
+  {
+    constexpr size_t SW = SIMD<double>::Size();
+    SIMD<double> sumr[H][W], sumi[H][W];
+    Iterate<H> ([&] (auto i) {
+        Iterate<W> ([&] (auto j) {
+            sumr[i.value][j.value] = SIMD<double>(0.0);
+            sumi[i.value][j.value] = SIMD<double>(0.0);
+          }); });
+
+    double * pad = reinterpret_cast<double*> (pa);
+    for (size_t l = 0; l < k; l++, pad += 2, pb += db)
+      Iterate<H> ([&] (auto i) {
+          SIMD<double> ar(pad[2*i.value*da]);
+          SIMD<double> ai(pad[2*i.value*da+1]);
+          SIMD<double> nai = -ai;
+          Iterate<W> ([&] (auto j) {
+              SIMD<double> br = pb[j.value].real();
+              SIMD<double> bi = pb[j.value].imag();
+              sumr[i.value][j.value] = FMA (ar, br, sumr[i.value][j.value]);
+              sumr[i.value][j.value] = FMA (nai, bi, sumr[i.value][j.value]);
+              sumi[i.value][j.value] = FMA (ar, bi, sumi[i.value][j.value]);
+              sumi[i.value][j.value] = FMA (ai, br, sumi[i.value][j.value]);
+            });
+        });
+
+    Iterate<H> ([&] (auto i) {
+        Iterate<W> ([&] (auto j) {
+            Complex * pcij = pc + i.value*dc + j.value*SW;
+            SIMD<Complex> sum(sumr[i.value][j.value], sumi[i.value][j.value]);
+            if (OP == ADD || OP == SUB)
+              {
+                SIMD<Complex> cij;
+                if (MASK)
+                  cij.LoadFast (pcij, nr);
+                else
+                  cij.LoadFast (pcij);
+                sum = (OP == ADD) ? cij+sum : cij-sum;
+              }
+            if (OP == SETNEG)
+              sum = SIMD<Complex>(0.0) - sum;
+            if (MASK)
+              sum.StoreFast (pcij, nr);
+            else
+              sum.StoreFast (pcij);
+          }); });
+  }
+
+  template <size_t H, OPERATION OP>
+  INLINE void MatKernelComplexABRows (size_t k, size_t wb,
+                                      Complex * pa, size_t da,
+                                      SIMD<Complex> * pb, size_t db,
+                                      Complex * pc, size_t dc)
+  {
+    constexpr size_t SW = SIMD<double>::Size();
+    size_t j = 0, jb = 0;
+    for ( ; j+2*SW <= wb; j += 2*SW, jb += 2)
+      MatKernelComplexAB<H,2,OP,false> (k, pa, da, pb+jb, db, pc+j, dc);
+    for ( ; j+SW <= wb; j += SW, jb++)
+      MatKernelComplexAB<H,1,OP,false> (k, pa, da, pb+jb, db, pc+j, dc);
+    if (j < wb)
+      MatKernelComplexAB<H,1,OP,true> (k, pa, da, pb+jb, db, pc+j, dc, wb-j);
+  }
+
+  // same memory per block as the real valued MultMatMat_intern2
+  constexpr size_t CBBH = 128;
+  constexpr size_t CBBW = 48;
+  
+  template <OPERATION OP>
+  void MultMatMatComplex_Block (size_t ha, size_t wa, size_t wb,
+                                Complex * pa, size_t da, Complex * pb, size_t db,
+                                Complex * pc, size_t dc)
+  {
+    constexpr size_t SW = SIMD<double>::Size();
+    static_assert (CBBW % (2*SW) == 0, "complex block width must fit the kernel");
+    SIMD<Complex> bb[CBBH*CBBW/SW];
+
+    for (size_t j = 0; j < wb; j += CBBW)
+      {
+        size_t wbi = min2(CBBW, wb-j);
+        CopyMatrixIn (wa, wbi, pb+j, db, &bb[0], CBBW/SW);
+
+        Complex * pai = pa;
+        Complex * pci = pc+j;
+        size_t i = 0;
+        for ( ; i+2 <= ha; i += 2, pai += 2*da, pci += 2*dc)
+          MatKernelComplexABRows<2,OP> (wa, wbi, pai, da, &bb[0], CBBW/SW, pci, dc);
+        if (i < ha)
+          MatKernelComplexABRows<1,OP> (wa, wbi, pai, da, &bb[0], CBBW/SW, pci, dc);
+      }
+  }
+
+  // the first block of columns of A uses FIRST, the others accumulate with REST 
+  template <OPERATION FIRST, OPERATION REST>
+  void MultMatMatComplex (size_t ha, size_t wa, size_t wb,
+                          BareSliceMatrix<Complex> a, BareSliceMatrix<Complex> b,
+                          BareSliceMatrix<Complex> c)
+  {
+    MultMatMatComplex_Block<FIRST> (ha, min2(CBBH, wa), wb,
+                                    &a(0), a.Dist(), &b(0), b.Dist(), &c(0), c.Dist());
+    for (size_t i = CBBH; i < wa; i += CBBH)
+      MultMatMatComplex_Block<REST> (ha, min2(CBBH, wa-i), wb,
+                                     &a(0,i), a.Dist(), &b(i,0), b.Dist(), &c(0), c.Dist());
+  }
+  
+  void MultMatMat_intern (size_t ha, size_t wa, size_t wb,
+                          BareSliceMatrix<Complex> a, BareSliceMatrix<Complex> b,
+                          BareSliceMatrix<Complex> c)
+  {
+    MultMatMatComplex<SET,ADD> (ha, wa, wb, a, b, c);
+  }
+
+  void MinusMultAB_intern (size_t ha, size_t wa, size_t wb,
+                           BareSliceMatrix<Complex> a, BareSliceMatrix<Complex> b,
+                           BareSliceMatrix<Complex> c)
+  {
+    MultMatMatComplex<SETNEG,SUB> (ha, wa, wb, a, b, c);
+  }
+
+  void AddAB_intern (size_t ha, size_t wa, size_t wb,
+                     BareSliceMatrix<Complex> a, BareSliceMatrix<Complex> b,
+                     BareSliceMatrix<Complex> c)
+  {
+    if (wa == 0) return;
+    MultMatMatComplex<ADD,ADD> (ha, wa, wb, a, b, c);
+  }
+
+  void SubAB_intern (size_t ha, size_t wa, size_t wb,
+                     BareSliceMatrix<Complex> a, BareSliceMatrix<Complex> b,
+                     BareSliceMatrix<Complex> c)
+  {
+    if (wa == 0) return;
+    MultMatMatComplex<SUB,SUB> (ha, wa, wb, a, b, c);
+  }
+
+
+
+  /* ************************** Complex A * x ************************* */
+
+  void MultMatVec (BareSliceMatrix<Complex> a, FlatVector<Complex> x, FlatVector<Complex> y)
+  {
+    constexpr size_t SW = SIMD<double>::Size();
+    size_t h = y.Size();
+    size_t w = x.Size();
+    size_t i = 0;
+    for ( ; i+2 <= h; i += 2)
+      {
+        Complex * pa1 = &a(i,0);
+        Complex * pa2 = pa1 + a.Dist();
+        SIMD<Complex> sum1(0.0), sum2(0.0);
+        size_t j = 0;
+        for ( ; j+SW <= w; j += SW)
+          {
+            SIMD<Complex> xj, a1, a2;
+            xj.LoadFast (&x(j));
+            a1.LoadFast (pa1+j);
+            a2.LoadFast (pa2+j);
+            sum1 += a1 * xj;
+            sum2 += a2 * xj;
+          }
+        if (j < w)
+          {
+            SIMD<Complex> xj, a1, a2;
+            xj.LoadFast (&x(j), w-j);
+            a1.LoadFast (pa1+j, w-j);
+            a2.LoadFast (pa2+j, w-j);
+            sum1 += a1 * xj;
+            sum2 += a2 * xj;
+          }
+        tie(y(i), y(i+1)) = HSum(sum1, sum2);
+      }
+    if (i < h)
+      {
+        Complex * pa1 = &a(i,0);
+        SIMD<Complex> sum1(0.0);
+        size_t j = 0;
+        for ( ; j+SW <= w; j += SW)
+          {
+            SIMD<Complex> xj, a1;
+            xj.LoadFast (&x(j));
+            a1.LoadFast (pa1+j);
+            sum1 += a1 * xj;
+          }
+        if (j < w)
+          {
+            SIMD<Complex> xj, a1;
+            xj.LoadFast (&x(j), w-j);
+            a1.LoadFast (pa1+j, w-j);
+            sum1 += a1 * xj;
+          }
+        y(i) = HSum(sum1);
+      }
+  }
+
+  void MultMatTransVec (BareSliceMatrix<Complex> a, FlatVector<Complex> x, FlatVector<Complex> y)
+  {
+    constexpr size_t SW = SIMD<double>::Size();
+    size_t h = x.Size();
+    size_t w = y.Size();
+    size_t dist = a.Dist();
+    size_t j = 0;
+    for ( ; j+SW <= w; j += SW)
+      {
+        SIMD<Complex> sum1(0.0), sum2(0.0);
+        Complex * pa = &a(0,j);
+        size_t i = 0;
+        for ( ; i+2 <= h; i += 2, pa += 2*dist)
+          {
+            SIMD<Complex> a1, a2;
+            a1.LoadFast (pa);
+            a2.LoadFast (pa+dist);
+            sum1 += SIMD<Complex>(x(i)) * a1;
+            sum2 += SIMD<Complex>(x(i+1)) * a2;
+          }
+        if (i < h)
+          {
+            SIMD<Complex> a1;
+            a1.LoadFast (pa);
+            sum1 += SIMD<Complex>(x(i)) * a1;
+          }
+        (sum1+sum2).StoreFast (&y(j));
+      }
+    if (j < w)
+      {
+        int nr = w-j;
+        SIMD<Complex> sum(0.0);
+        Complex * pa = &a(0,j);
+        for (size_t i = 0; i < h; i++, pa += dist)
+          {
+            SIMD<Complex> a1;
+            a1.LoadFast (pa, nr);
+            sum += SIMD<Complex>(x(i)) * a1;
+          }
+        sum.StoreFast (&y(j), nr);
+      }
+  }
+
+  
+
+  /* ******************* float matrix, double vectors ***************** */
+
+  template <size_t H>
+  INLINE void MatVecFloatRows (size_t w, float * pa, size_t da, double * px, double * py)
+  {
+    constexpr size_t SW = SIMD<double>::Size();
+    SIMD<double> sum[H];
+    Iterate<H> ([&] (auto i) { sum[i.value] = SIMD<double>(0.0); });
+    size_t j = 0;
+    for ( ; j+SW <= w; j += SW)
+      {
+        SIMD<double> xj(px+j);
+        Iterate<H> ([&] (auto i) {
+            SIMD<double> aij = SIMD<float>(pa+i.value*da+j);
+            sum[i.value] = FMA (aij, xj, sum[i.value]);
+          });
+      }
+    if (j < w)
+      {
+        SIMD<mask64> mask(w-j);
+        SIMD<double> xj(px+j, mask);
+        Iterate<H> ([&] (auto i) {
+            SIMD<double> aij = SIMD<float>(pa+i.value*da+j, mask);
+            sum[i.value] = FMA (aij, xj, sum[i.value]);
+          });
+      }
+    Iterate<H> ([&] (auto i) { py[i.value] = HSum(sum[i.value]); });
+  }
+  
+  void MultMatVec (BareSliceMatrix<float> a, FlatVector<double> x, FlatVector<double> y)
+  {
+    size_t h = y.Size();
+    size_t w = x.Size();
+    size_t i = 0;
+    for ( ; i+4 <= h; i += 4)
+      MatVecFloatRows<4> (w, &a(i,0), a.Dist(), &x(0), &y(i));
+    for ( ; i < h; i++)
+      MatVecFloatRows<1> (w, &a(i,0), a.Dist(), &x(0), &y(i));
+  }
+
+  void MultMatTransVec (BareSliceMatrix<float> a, FlatVector<double> x, FlatVector<double> y)
+  {
+    constexpr size_t SW = SIMD<double>::Size();
+    size_t h = x.Size();
+    size_t w = y.Size();
+    size_t dist = a.Dist();
+
+    size_t j = 0;
+    for ( ; j+SW <= w; j += SW)
+      {
+        SIMD<double> s0(0.0), s1(0.0);
+        float * pa = &a(0,j);
+        size_t i = 0;
+        for ( ; i+2 <= h; i += 2, pa += 2*dist)
+          {
+            s0 = FMA (SIMD<double>(x(i)), SIMD<double>(SIMD<float>(pa)), s0);
+            s1 = FMA (SIMD<double>(x(i+1)), SIMD<double>(SIMD<float>(pa+dist)), s1);
+          }
+        if (i < h)
+          s0 = FMA (SIMD<double>(x(i)), SIMD<double>(SIMD<float>(pa)), s0);
+        (s0+s1).Store(&y(j));
+      }
+    if (j < w)
+      {
+        SIMD<mask64> mask(w-j);
+        SIMD<double> sum(0.0);
+        float * pa = &a(0,j);
+        for (size_t i = 0; i < h; i++, pa += dist)
+          sum = FMA (SIMD<double>(x(i)), SIMD<double>(SIMD<float>(pa, mask)), sum);
+        sum.Store(&y(j), mask);
+      }
+  }
+
+  // converts panels of a to double and uses the double kernels 
+  void MultMatMat (SliceMatrix<float> a, SliceMatrix<double> b, SliceMatrix<double> c)
+  {
+    constexpr size_t BH = 64;
+    constexpr size_t BW = 128;
+    double mema[BH*BW];
+    size_t ha = a.Height();
+    size_t wa = a.Width();
+    if (wa == 0)
+      {
+        c = 0.0;
+        return;
+      }
+    for (size_t i = 0; i < ha; i += BH)
+      for (size_t k = 0; k < wa; k += BW)
+        {
+          size_t hi = min2(BH, ha-i);
+          size_t wk = min2(BW, wa-k);
+          FlatMatrix<> ad(hi, wk, &mema[0]);
+          for (size_t r = 0; r < hi; r++)
+            for (size_t l = 0; l < wk; l++)
+              ad(r,l) = a(i+r, k+l);
+          if (k == 0)
+            MultMatMat (ad, b.Rows(k, k+wk), c.Rows(i, i+hi));
+          else
+            AddAB (ad, b.Rows(k, k+wk), c.Rows(i, i+hi));
+        }
+  }
+
+  
+  /* ******************** batched small matrices ********************* */
+
+  template <size_t H, size_t W>
+  INLINE void AddAtB_BatchKernel (size_t k,
+                                  SIMD<double> * pa, size_t da,
+                                  SIMD<double> * pb, size_t db,
+                                  SIMD<double> * pc, size_t dc)
+  {
+    SIMD<double> sum[H][W];
+    Iterate<H> ([&] (auto i) {
+        Iterate<W> ([&] (auto j) { sum[i.value][j.value] = SIMD<double>(0.0); }); });
+    for (size_t l = 0; l < k; l++, pa += da, pb += db)
+      Iterate<H> ([&] (auto i) {
+          SIMD<double> ai = pa[i.value];
+          Iterate<W> ([&] (auto j) {
+              sum[i.value][j.value] = FMA (ai, pb[j.value], sum[i.value][j.value]);
+            });
+        });
+    Iterate<H> ([&] (auto i) {
+        Iterate<W> ([&] (auto j) { pc[i.value*dc+j.value] += sum[i.value][j.value]; }); });
+  }
+
+  template <size_t H>
+  INLINE void AddAtB_BatchRows (size_t k, size_t wc,
+                                SIMD<double> * pa, size_t da,
+                                SIMD<double> * pb, size_t db,
+                                SIMD<double> * pc, size_t dc)
+  {
+    size_t j = 0;
+    for ( ; j+4 <= wc; j += 4)
+      AddAtB_BatchKernel<H,4> (k, pa, da, pb+j, db, pc+j, dc);
+    switch (wc-j)
+      {
+      case 3: AddAtB_BatchKernel<H,3> (k, pa, da, pb+j, db, pc+j, dc); break;
+      case 2: AddAtB_BatchKernel<H,2> (k, pa, da, pb+j, db, pc+j, dc); break;
+      case 1: AddAtB_BatchKernel<H,1> (k, pa, da, pb+j, db, pc+j, dc); break;
+      default: ;
+      }
+  }
+  
+  void AddAtB_Batch (SliceMatrix<SIMD<double>> a, SliceMatrix<SIMD<double>> b,
+                     BareSliceMatrix<SIMD<double>> c)
+  {
+    size_t k = a.Height();
+    size_t hc = a.Width();
+    size_t wc = b.Width();
+    if (k == 0 || hc == 0 || wc == 0) return;
+
+    SIMD<double> * pa = &a(0,0);
+    SIMD<double> * pb = &b(0,0);
+    SIMD<double> * pc = &c(0,0);
+    size_t dc = c.Dist();
+    size_t i = 0;
+    for ( ; i+2 <= hc; i += 2)
+      AddAtB_BatchRows<2> (k, wc, pa+i, a.Dist(), pb, b.Dist(), pc+i*dc, dc);
+    if (i < hc)
+      AddAtB_BatchRows<1> (k, wc, pa+i, a.Dist(), pb, b.Dist(), pc+i*dc, dc);
+  }
+
+  void AddBtDB_Batch (SliceMatrix<SIMD<double>> b1,
+                      SliceMatrix<SIMD<double>> d,
+                      SliceMatrix<SIMD<double>> b2,
+                      BareSliceMatrix<SIMD<double>> c,
+                      LocalHeap & lh)
+  {
+    size_t np = d.Height();
+    if (np == 0) return;
+    size_t dim1 = b1.Height() / np;
+    size_t dim2 = b2.Height() / np;
+    size_t n1 = b1.Width();
+
+    HeapReset hr(lh);
+    FlatMatrix<SIMD<double>> db(b2.Height(), n1, lh);
+    for (size_t p = 0; p < np; p++)
+      for (size_t l = 0; l < dim2; l++)
+        {
+          auto row = db.Row(p*dim2+l);
+          row = SIMD<double>(0.0);
+          for (size_t k = 0; k < dim1; k++)
+            {
+              SIMD<double> dkl = d(p, k*dim2+l);
+              auto b1row = b1.Row(p*dim1+k);
+              for (size_t i = 0; i < n1; i++)
+                row(i) = FMA (dkl, b1row(i), row(i));
+            }
+        }
+    AddAtB_Batch (b2, db, c);
+  }
+
+
   
 
   /**************** timings *********************** */
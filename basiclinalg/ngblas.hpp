@@ -171,6 +171,36 @@ namespace ngbla
   }  
 
 
+  // blocked dense factorizations, the trailing updates run
+  // through the task manager (calcinverse.cpp)
+
+  /// P A = L U with unit lower L and upper U, both stored in a.
+  /// row i of P A is row p[i] of A
+  extern NGS_DLL_HEADER void CalcLU (SliceMatrix<double> a, FlatArray<int> p);
+  /// b = A^{-1} b, with the factors from CalcLU
+  extern NGS_DLL_HEADER void SolveFromLU (SliceMatrix<double> a, FlatArray<int> p, SliceMatrix<double> b);
+  /// a = A^{-1}, with the factors from CalcLU
+  extern NGS_DLL_HEADER void InverseFromLU (SliceMatrix<double> a, FlatArray<int> p);
+
+
+  // batched products for small matrices, e.g. element matrices of
+  // low order elements: lane k of every SIMD entry belongs to matrix k
+
+  // c += Trans(a) * b
+  extern NGS_DLL_HEADER
+  void AddAtB_Batch (SliceMatrix<SIMD<double>> a, SliceMatrix<SIMD<double>> b,
+                     BareSliceMatrix<SIMD<double>> c);
+
+  // c += Trans(b2) * D * b1, with one dim1 x dim2 block D_p per point p:
+  // row p*dim1+k of b1, row p*dim2+l of b2, and d(p, k*dim2+l) = D_p(k,l)
+  extern NGS_DLL_HEADER
+  void AddBtDB_Batch (SliceMatrix<SIMD<double>> b1,
+                      SliceMatrix<SIMD<double>> d,
+                      SliceMatrix<SIMD<double>> b2,
+                      BareSliceMatrix<SIMD<double>> c,
+                      LocalHeap & lh);
+  
+
   // ADD/POS 
   // f   f    C = -A*B
   // f   t    C = A*B
@@ -332,6 +362,175 @@ namespace ngbla
   }
   
   
+  // complex versions, B is copied into split real/imag SIMD blocks
+  extern NGS_DLL_HEADER void MultMatMat_intern (size_t ha, size_t wa, size_t wb,
+                                                BareSliceMatrix<Complex> a, BareSliceMatrix<Complex> b,
+                                                BareSliceMatrix<Complex> c);
+  extern NGS_DLL_HEADER void MinusMultAB_intern (size_t ha, size_t wa, size_t wb,
+                                                 BareSliceMatrix<Complex> a, BareSliceMatrix<Complex> b,
+                                                 BareSliceMatrix<Complex> c);
+  extern NGS_DLL_HEADER void AddAB_intern (size_t ha, size_t wa, size_t wb,
+                                           BareSliceMatrix<Complex> a, BareSliceMatrix<Complex> b,
+                                           BareSliceMatrix<Complex> c);
+  extern NGS_DLL_HEADER void SubAB_intern (size_t ha, size_t wa, size_t wb,
+                                           BareSliceMatrix<Complex> a, BareSliceMatrix<Complex> b,
+                                           BareSliceMatrix<Complex> c);
+
+  inline void MultMatMat (SliceMatrix<Complex> a, SliceMatrix<Complex> b, SliceMatrix<Complex> c)
+  {
+    MultMatMat_intern (a.Height(), a.Width(), b.Width(), a, b, c);
+  }
+  inline void MinusMultAB (SliceMatrix<Complex> a, SliceMatrix<Complex> b, SliceMatrix<Complex> c)
+  {
+    MinusMultAB_intern (a.Height(), a.Width(), b.Width(), a, b, c);
+  }
+  inline void AddAB (SliceMatrix<Complex> a, SliceMatrix<Complex> b, SliceMatrix<Complex> c)
+  {
+    AddAB_intern (a.Height(), a.Width(), b.Width(), a, b, c);
+  }
+  inline void SubAB (SliceMatrix<Complex> a, SliceMatrix<Complex> b, SliceMatrix<Complex> c)
+  {
+    SubAB_intern (a.Height(), a.Width(), b.Width(), a, b, c);
+  }
+
+  extern NGS_DLL_HEADER void MultMatVec (BareSliceMatrix<Complex> a, FlatVector<Complex> x, FlatVector<Complex> y);
+  extern NGS_DLL_HEADER void MultMatTransVec (BareSliceMatrix<Complex> a, FlatVector<Complex> x, FlatVector<Complex> y);
+  
+
+  template <bool ADD, bool POS, ORDERING orda, ORDERING ordb>
+  INLINE void NgGEMM (SliceMatrix<Complex,orda> a, SliceMatrix<Complex, ordb> b, SliceMatrix<Complex> c)
+  {
+    if (!ADD)
+      {
+        if (!POS)
+          c = -1*a*b;
+        else
+          c = 1*a*b;
+      }
+    else
+      {
+        if (!POS)
+          c -= 1*a*b;
+        else
+          c += 1*a*b;
+      }
+  }
+
+  template <> INLINE void NgGEMM<false,true> (SliceMatrix<Complex> a, SliceMatrix<Complex> b, SliceMatrix<Complex> c)
+  {
+    MultMatMat (a, b, c);
+  }
+
+  template <> INLINE void NgGEMM<true,true> (SliceMatrix<Complex> a, SliceMatrix<Complex> b, SliceMatrix<Complex> c)
+  {
+    AddAB (a, b, c);
+  }
+
+  template <> INLINE void NgGEMM<true,false> (SliceMatrix<Complex> a, SliceMatrix<Complex> b, SliceMatrix<Complex> c)
+  {
+    SubAB (a, b, c);
+  }
+
+  template <> INLINE void NgGEMM<false,false> (SliceMatrix<Complex> a, SliceMatrix<Complex> b, SliceMatrix<Complex> c)
+  {
+    MinusMultAB (a, b, c);
+  }
+
+  template <bool ADD, bool POS, ORDERING orda, ORDERING ordb>
+  INLINE void NgGEMM (SliceMatrix<Complex,orda> a, SliceMatrix<Complex, ordb> b, SliceMatrix<Complex,ColMajor> c)
+  {
+    NgGEMM<ADD,POS> (Trans(b), Trans(a), Trans(c));
+  }
+
+  template <bool ADD, bool POS, ORDERING ord>
+  void NgGEMV (SliceMatrix<Complex,ord> a, FlatVector<Complex> x, FlatVector<Complex> y)
+  {
+    if (!ADD)
+      {
+        if (!POS)
+          y = -1*a*x;
+        else
+          y = 1*a*x;
+      }
+    else
+      {
+        if (!POS)
+          y -= 1*a*x;
+        else
+          y += 1*a*x;
+      }
+  }
+
+  template <> INLINE void NgGEMV<false,true> (SliceMatrix<Complex> a, FlatVector<Complex> x, FlatVector<Complex> y)
+  {
+    MultMatVec (a,x,y);
+  }
+  
+  template <> INLINE void NgGEMV<false,true> (SliceMatrix<Complex,ColMajor> a, FlatVector<Complex> x, FlatVector<Complex> y)
+  {
+    MultMatTransVec (Trans(a),x,y);
+  }
+
+  
+  // float matrix with double vectors, accumulation in double
+  extern NGS_DLL_HEADER void MultMatVec (BareSliceMatrix<float> a, FlatVector<double> x, FlatVector<double> y);
+  extern NGS_DLL_HEADER void MultMatTransVec (BareSliceMatrix<float> a, FlatVector<double> x, FlatVector<double> y);
+  extern NGS_DLL_HEADER void MultMatMat (SliceMatrix<float> a, SliceMatrix<double> b, SliceMatrix<double> c);
+
+  template <bool ADD, bool POS, ORDERING orda, ORDERING ordb>
+  INLINE void NgGEMM (SliceMatrix<float,orda> a, SliceMatrix<double, ordb> b, SliceMatrix<double> c)
+  {
+    if (!ADD)
+      {
+        if (!POS)
+          c = -1*a*b;
+        else
+          c = 1*a*b;
+      }
+    else
+      {
+        if (!POS)
+          c -= 1*a*b;
+        else
+          c += 1*a*b;
+      }
+  }
+
+  template <> INLINE void NgGEMM<false,true> (SliceMatrix<float> a, SliceMatrix<double> b, SliceMatrix<double> c)
+  {
+    MultMatMat (a, b, c);
+  }
+  
+  template <bool ADD, bool POS, ORDERING ord>
+  void NgGEMV (SliceMatrix<float,ord> a, FlatVector<double> x, FlatVector<double> y)
+  {
+    if (!ADD)
+      {
+        if (!POS)
+          y = -1*a*x;
+        else
+          y = 1*a*x;
+      }
+    else
+      {
+        if (!POS)
+          y -= 1*a*x;
+        else
+          y += 1*a*x;
+      }
+  }
+
+  template <> INLINE void NgGEMV<false,true> (SliceMatrix<float> a, FlatVector<double> x, FlatVector<double> y)
+  {
+    MultMatVec (a,x,y);
+  }
+  
+  template <> INLINE void NgGEMV<false,true> (SliceMatrix<float,ColMajor> a, FlatVector<double> x, FlatVector<double> y)
+  {
+    MultMatTransVec (Trans(a),x,y);
+  }
+
+  
   extern list<tuple<string,double>> Timing (int what, size_t n, size_t m, size_t k);
 
 }
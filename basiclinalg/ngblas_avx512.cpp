@@ -0,0 +1,167 @@
+/*********************************************************************/
+/* File:   ngblas_avx512.cpp                                         */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+/*
+  AVX-512 versions of the blocked MultAB kernels.
+
+  This file is compiled with AVX-512 flags, ngblas.cpp calls into it
+  if the library is built for a smaller SIMD width, but the cpu
+  supports AVX-512.  The SIMD classes and the generated kernels are
+  instantiated in a private namespace, so no AVX-512 code ends up in
+  inline functions shared with other translation units.
+*/
+
+#include "../include/ngs_stdcpp_include.hpp"
+
+namespace ngbla_avx512
+{
+  using namespace std;
+#include "../ngstd/simd.hpp"
+  using namespace ngstd;
+
+#include "matkernel_avx512.hpp"
+
+  template <typename T>
+  INLINE T min2 (T a, T b) { return (a < b) ? a : b; }
+
+  INLINE void CopyMatrixIn (size_t h, size_t w,
+                            double * ps, size_t dists,
+                            SIMD<double> * pd, size_t distd)
+  {
+    constexpr int SW = SIMD<double>::Size();
+    SIMD<mask64> mask(w % SW);
+
+    for (size_t i = 0; i < h; i++, pd += distd, ps += dists)
+      {
+        size_t js = 0, jd=0;
+        for ( ; js+SW <= w; js+=SW, jd++)
+          pd[jd] = SIMD<double>(ps+js);
+        SIMD<double>(ps+js, mask).Store((double*) (pd+jd), mask);
+      }
+  }
+
+  template <size_t H, OPERATION OP, typename TB>
+  INLINE void MatKernel2AddAB (size_t hb, size_t wb, double * pa, size_t da, TB * pb, size_t db, double * pc, size_t dc)
+  {
+    constexpr size_t SW = SIMD<double>::Size();
+    constexpr size_t SWdTB = sizeof(SIMD<double>)/sizeof(TB);
+    size_t l = 0, lb = 0;
+    for ( ; l+3*SW <= wb; l += 3*SW, lb += 3*SWdTB)
+      MatKernelMultAB<H,3,OP> (hb, pa, da, pb+lb, db, pc+l, dc);
+    for ( ; l+SW <= wb; l += SW, lb += SWdTB)
+      MatKernelMultAB<H,1,OP> (hb, pa, da, pb+lb, db, pc+l, dc);
+    if (l < wb)
+      MatKernelMultABMask<H,OP>(hb, SIMD<mask64>(wb-l), pa, da, pb+lb, db, pc+l, dc);
+  }
+
+  template <size_t BBH, OPERATION OP>
+  void MultMatMat_SlimB (size_t ha, size_t wa, size_t wb,
+                         double * pa0, size_t dista, double * pb, size_t distb,
+                         double * pc, size_t distc)
+  {
+    constexpr size_t SW = SIMD<double>::Size();
+    constexpr size_t HA = 6;
+    alignas(64) SIMD<double> bb[BBH];
+
+    for (size_t j = 0; j+SW <= wb; j+=SW, pb += SW, pc += SW)
+      {
+        for (size_t k = 0; k < wa; k++)
+          bb[k] = SIMD<double> (pb+k*distb);
+
+        double * pc1 = pc;
+        double * pa1 = pa0;
+        size_t k = 0;
+        for ( ; k+2*HA <= ha; k += 2*HA, pc1 += 2*HA*distc, pa1 += 2*HA*dista)
+          MatKernelMultAB<2*HA, 1, OP> (wa, pa1, dista, bb, 1, pc1, distc);
+        for ( ; k+HA <= ha; k += HA, pc1 += HA*distc, pa1 += HA*dista)
+          MatKernelMultAB<HA, 1, OP> (wa, pa1, dista, bb, 1, pc1, distc);
+        for ( ; k+1 <= ha; k += 1, pc1 += distc, pa1 += dista)
+          MatKernelMultAB<1, 1, OP> (wa, pa1, dista, bb, 1, pc1, distc);
+      }
+
+    if (wb % SW != 0)
+      {
+        SIMD<mask64> mask(wb%SW);
+        for (size_t k = 0; k < wa; k++)
+          bb[k] = SIMD<double> (pb+k*distb, mask);
+
+        size_t k = 0;
+        double * pc1 = pc;
+        for ( ; k+HA <= ha; k += HA, pc1 += HA*distc)
+          MatKernelMultABMask<HA, OP> (wa, mask, pa0+k*dista, dista, bb, 1, pc1, distc);
+        for ( ; k+1 <= ha; k += 1, pc1 += distc)
+          MatKernelMultABMask<1, OP> (wa, mask, pa0+k*dista, dista, bb, 1, pc1, distc);
+      }
+  }
+
+  template <size_t BBH, OPERATION OP>
+  void MultMatMat_Block (size_t ha, size_t wa, size_t wb,
+                         double * pa0, size_t dista, double * pb, size_t distb,
+                         double * pc0, size_t distc)
+  {
+    constexpr size_t SW = SIMD<double>::Size();
+    if (wb < 3*SW)
+      {
+        MultMatMat_SlimB<BBH,OP> (ha, wa, wb, pa0, dista, pb, distb, pc0, distc);
+        return;
+      }
+
+    constexpr size_t HA = 6;
+    constexpr size_t BBW = 96;
+    alignas(64) SIMD<double> bb[BBH*BBW/SW];
+
+    for (size_t j = 0; j < wb; j += BBW)
+      {
+        size_t hbi = wa;
+        size_t wbi = min2(BBW, wb-j);
+        CopyMatrixIn (hbi, wbi, pb+j, distb, &bb[0], BBW/SW);
+
+        double * pa = pa0;
+        double * pc = pc0+j;
+
+        size_t k = 0;
+        for ( ; k+HA <= ha; k += HA, pa += HA*dista, pc += HA*distc)
+          MatKernel2AddAB<HA,OP> (hbi, wbi, pa, dista, &bb[0], BBW/SW, pc, distc);
+        switch (ha-k)
+          {
+          case 1: MatKernel2AddAB<1,OP> (hbi, wbi, pa, dista, &bb[0], BBW/SW, pc, distc); break;
+          case 2: MatKernel2AddAB<2,OP> (hbi, wbi, pa, dista, &bb[0], BBW/SW, pc, distc); break;
+          case 3: MatKernel2AddAB<3,OP> (hbi, wbi, pa, dista, &bb[0], BBW/SW, pc, distc); break;
+          case 4: MatKernel2AddAB<4,OP> (hbi, wbi, pa, dista, &bb[0], BBW/SW, pc, distc); break;
+          case 5: MatKernel2AddAB<5,OP> (hbi, wbi, pa, dista, &bb[0], BBW/SW, pc, distc); break;
+          default: ;
+          }
+      }
+  }
+
+  // first block of A-columns with FIRST, the following ones accumulate with REST
+  template <OPERATION FIRST, OPERATION REST>
+  void MultMatMat (size_t ha, size_t wa, size_t wb,
+                   double * pa, size_t da, double * pb, size_t db, double * pc, size_t dc)
+  {
+    constexpr size_t BBH = 128;
+    MultMatMat_Block<BBH,FIRST> (ha, min2(BBH, wa), wb, pa, da, pb, db, pc, dc);
+    for (size_t i = BBH; i < wa; i += BBH)
+      MultMatMat_Block<BBH,REST> (ha, min2(BBH, wa-i), wb, pa+i, da, pb+i*db, db, pc, dc);
+  }
+}
+
+
+namespace ngbla
+{
+  // op is SET, SETNEG, ADD or SUB from matkernel.hpp
+  void MultMatMat_AVX512 (int op, size_t ha, size_t wa, size_t wb,
+                          double * pa, size_t da, double * pb, size_t db, double * pc, size_t dc)
+  {
+    using namespace ngbla_avx512;
+    switch (OPERATION(op))
+      {
+      case SET:    MultMatMat<SET,ADD> (ha, wa, wb, pa, da, pb, db, pc, dc); break;
+      case SETNEG: MultMatMat<SETNEG,SUB> (ha, wa, wb, pa, da, pb, db, pc, dc); break;
+      case ADD:    MultMatMat<ADD,ADD> (ha, wa, wb, pa, da, pb, db, pc, dc); break;
+      case SUB:    MultMatMat<SUB,SUB> (ha, wa, wb, pa, da, pb, db, pc, dc); break;
+      }
+  }
+}
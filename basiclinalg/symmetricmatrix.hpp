@@ -76,6 +76,8 @@ namespace ngbla
     ///
     int Height() const { return n; }
 
+    /// packed lower triangle, row i starts at i*(i+1)/2
+    T * Data() const { return data; }
   
     ///
     const T & operator() (int i, int j) const
@@ -134,10 +136,13 @@ namespace ngbla
 
 
 
-
-
-
-
+  /*
+    c += a * b^T for symmetric results, only the lower triangle is
+    computed and stored in packed format.
+   */
+  extern void AddABtSym (SliceMatrix<double> a, SliceMatrix<double> b, FlatSymmetricMatrix<double> c);
+  extern void AddABtSym (SliceMatrix<SIMD<double>> a, SliceMatrix<SIMD<double>> b, FlatSymmetricMatrix<double> c);
+  
 }
 
 
@@ -367,3 +367,94 @@ INLINE ostream & operator<< (ostream & ost, const FlatTensor<0,T> & tensor)
 
 
 
+
+
+
+
+namespace ngbla
+{
+  /*
+    Sum factorization
+
+    A dense tensor is stored row-major (last index fastest), and seen
+    as having shape (outer, n, inner) with respect to the axis the
+    matrix is applied along:
+
+      ApplyTensorMode:        out(o,j,i) = sum_l mat(j,l) * in(o,l,i)
+      ApplyTensorModeTrans:   out(o,l,i) = sum_j mat(j,l) * in(o,j,i)
+
+    Both map onto the blocked matrix-matrix kernels.
+  */
+
+  INLINE void ApplyTensorMode (SliceMatrix<> mat, size_t outer, size_t inner,
+                               double * in, double * out)
+  {
+    size_t n = mat.Width();
+    size_t m = mat.Height();
+    if (inner == 1)
+      MultABt (SliceMatrix<> (outer, n, n, in), mat, SliceMatrix<> (outer, m, m, out));
+    else
+      for (size_t o = 0; o < outer; o++)
+        MultMatMat (mat, SliceMatrix<> (n, inner, inner, in+o*n*inner),
+                    SliceMatrix<> (m, inner, inner, out+o*m*inner));
+  }
+
+  INLINE void ApplyTensorModeTrans (SliceMatrix<> mat, size_t outer, size_t inner,
+                                    double * in, double * out)
+  {
+    size_t n = mat.Width();
+    size_t m = mat.Height();
+    if (inner == 1)
+      MultMatMat (SliceMatrix<> (outer, m, m, in), mat, SliceMatrix<> (outer, n, n, out));
+    else
+      for (size_t o = 0; o < outer; o++)
+        MultAtB (mat, SliceMatrix<> (m, inner, inner, in+o*m*inner),
+                 SliceMatrix<> (n, inner, inner, out+o*n*inner));
+  }
+
+
+  template <bool TRANS>
+  INLINE void ApplyTensorProduct_impl (FlatArray<SliceMatrix<>> mats, double * in, double * out)
+  {
+    size_t D = mats.Size();
+    auto din = [&] (size_t k) { return TRANS ? mats[k].Height() : mats[k].Width(); };
+    auto dout = [&] (size_t k) { return TRANS ? mats[k].Width() : mats[k].Height(); };
+
+    // intermediate k has shape (dout(0), ..., dout(k), din(k+1), ...)
+    size_t maxsize = 0;
+    for (size_t k = 0; k+1 < D; k++)
+      {
+        size_t size = 1;
+        for (size_t i = 0; i <= k; i++) size *= dout(i);
+        for (size_t i = k+1; i < D; i++) size *= din(i);
+        maxsize = max2(maxsize, size);
+      }
+    STACK_ARRAY(double, mem, 2*maxsize);
+
+    double * src = in;
+    for (size_t k = 0; k < D; k++)
+      {
+        size_t outer = 1, inner = 1;
+        for (size_t i = 0; i < k; i++) outer *= dout(i);
+        for (size_t i = k+1; i < D; i++) inner *= din(i);
+        double * dst = (k+1 == D) ? out : &mem[(k%2)*maxsize];
+        if (TRANS)
+          ApplyTensorModeTrans (mats[k], outer, inner, src, dst);
+        else
+          ApplyTensorMode (mats[k], outer, inner, src, dst);
+        src = dst;
+      }
+  }
+
+  /// out = (mats[0] x mats[1] x ... ) in, in O(n^(D+1)) instead of O(n^(2D))
+  INLINE void ApplyTensorProduct (FlatArray<SliceMatrix<>> mats, FlatVector<> in, FlatVector<> out)
+  {
+    ApplyTensorProduct_impl<false> (mats, in.Data(), out.Data());
+  }
+
+  /// out = (Trans(mats[0]) x Trans(mats[1]) x ... ) in
+  INLINE void ApplyTensorProductTrans (FlatArray<SliceMatrix<>> mats, FlatVector<> in, FlatVector<> out)
+  {
+    ApplyTensorProduct_impl<true> (mats, in.Data(), out.Data());
+  }
+}
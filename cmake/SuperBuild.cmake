@@ -198,6 +198,7 @@ set_vars( NGSOLVE_CMAKE_ARGS
   USE_CUDA
   USE_MKL
   USE_HYPRE
+  USE_HDF5
   USE_MUMPS
   USE_PARDISO
   USE_UMFPACK
@@ -205,11 +206,13 @@ set_vars( NGSOLVE_CMAKE_ARGS
   USE_NUMA
   USE_CCACHE
   USE_NATIVE_ARCH
+  USE_AVX512_DISPATCH
   NETGEN_DIR
   Netgen_DIR
   INSTALL_DEPENDENCIES 
   INTEL_MIC
   ENABLE_UNIT_TESTS
+  ENABLE_BENCHMARKS
   )
 
 set_flags_vars(NGSOLVE_CMAKE_ARGS CMAKE_CXX_FLAGS CMAKE_SHARED_LINKER_FLAGS CMAKE_LINKER_FLAGS)
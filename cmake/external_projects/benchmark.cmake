@@ -0,0 +1,18 @@
+include (ExternalProject)
+ExternalProject_Add(
+    project_benchmark
+    PREFIX ${CMAKE_BINARY_DIR}/benchmark
+    GIT_REPOSITORY https://github.com/google/benchmark.git
+    GIT_TAG v1.5.3
+    TIMEOUT 10
+    UPDATE_COMMAND ""
+    CMAKE_ARGS -DCMAKE_BUILD_TYPE=Release
+               -DBENCHMARK_ENABLE_TESTING=OFF
+               -DBENCHMARK_ENABLE_GTEST_TESTS=OFF
+               -DCMAKE_INSTALL_PREFIX=${CMAKE_BINARY_DIR}/benchmark/install
+    LOG_DOWNLOAD ON
+   )
+
+# Expose required variables to parent scope
+set(BENCHMARK_INCLUDE_DIR ${CMAKE_BINARY_DIR}/benchmark/install/include CACHE INTERNAL "Path to include folder for Google Benchmark")
+set(BENCHMARK_LIBRARIES ${CMAKE_BINARY_DIR}/benchmark/install/lib/${CMAKE_STATIC_LIBRARY_PREFIX}benchmark${CMAKE_STATIC_LIBRARY_SUFFIX} CACHE INTERNAL "Google Benchmark library")
@@ -0,0 +1,570 @@
+#include <comp.hpp>
+#include <sys/stat.h>
+#ifdef WIN32
+#include <direct.h>
+#endif
+using namespace ngcomp;
+
+
+
+namespace ngcomp
+{
+
+  namespace
+  {
+    /// default file of the chosen solvers, next to the compiled coefficient functions
+    string DefaultCacheFile ()
+    {
+      if (getenv("NGSOLVE_NO_AUTOSOLVER_CACHE"))
+        return "";
+      string dir;
+      if (const char * env = getenv("NGSOLVE_CACHE_DIR"))
+        dir = env;
+#ifdef WIN32
+      else if (const char * env = getenv("LOCALAPPDATA"))
+        dir = string(env) + "\\ngsolve";
+#else
+      else if (const char * env = getenv("XDG_CACHE_HOME"))
+        dir = string(env) + "/ngsolve";
+      else if (const char * env = getenv("HOME"))
+        dir = string(env) + "/.cache/ngsolve";
+#endif
+      if (dir.empty()) return "";
+      for (size_t pos = dir.find_first_of("/\\", 1); ; pos = dir.find_first_of("/\\", pos+1))
+        {
+          string sub = dir.substr(0, pos);
+#ifdef WIN32
+          _mkdir(sub.c_str());
+#else
+          mkdir(sub.c_str(), 0755);
+#endif
+          if (pos == string::npos) break;
+        }
+      return dir + "/autosolver.txt";
+    }
+
+    /// flop rate of a dense matrix product, an upper bound for the sparse factorization
+    double DenseFlopRate ()
+    {
+      static double rate = [] ()
+        {
+          int n = 256;
+          Matrix<> a(n), b(n), c(n);
+          a = 1.0; b = 1.0;
+          double best = 1e99;
+          for (int k = 0; k < 3; k++)
+            {
+              double t = WallTime();
+              c = a * b;
+              best = min2 (best, WallTime()-t);
+            }
+          return 2.0*n*n*n / max2 (best, 1e-9);
+        } ();
+      return rate * max2 (1, TaskManager::GetNumThreads());
+    }
+
+    /**
+       A few steps of the preconditioned cg-method for a random right hand
+       side. Returns the reduction factor per step of the preconditioned
+       residual, 1 if there is no reduction.
+    */
+    template <typename SCAL>
+    double TrialCG (const BaseMatrix & a, const BaseMatrix & c, shared_ptr<BitArray> freedofs,
+                    int maxsteps, double tol, int & steps, double & steptime)
+    {
+      auto r = a.CreateColVector();
+      auto w = a.CreateColVector();
+      auto s = a.CreateColVector();
+      auto as = a.CreateColVector();
+
+      r.SetRandom();
+      if (freedofs) Projector (freedofs, true).Project (*r);
+
+      double starttime = WallTime();
+      c.Mult (*r, *w);
+      *s = *w;
+      SCAL wr = S_InnerProduct<SCAL> (*w, *r);
+      double err0 = sqrt (abs (wr)), err = err0;
+
+      steps = 0;
+      while (steps < maxsteps && err > tol * err0)
+        {
+          a.Mult (*s, *as);
+          SCAL alpha = wr / S_InnerProduct<SCAL> (*s, *as);
+          r.Add (-alpha, *as);
+          c.Mult (*r, *w);
+          SCAL wrn = S_InnerProduct<SCAL> (*w, *r);
+          err = sqrt (abs (wrn));
+          *s *= wrn / wr;
+          *s += *w;
+          wr = wrn;
+          steps++;
+        }
+      steptime = (WallTime() - starttime) / max2 (steps, 1);
+
+      if (steps == 0 || !(err < err0)) return 1;
+      return pow (err / err0, 1.0 / steps);
+    }
+  }
+
+
+
+  /**
+     Chooses the preconditioner, or a direct solver, for a bilinear-form.
+
+     The candidates are set up side by side during the first assembly,
+     they all get the element matrices. Then every candidate runs a few
+     cg-iterations (trialsteps), which give the time of one step and the
+     convergence rate, and with the setup time the predicted time to
+     reduce the error by tol. A direct solver is only factorized if the
+     estimate of the symbolic factorization fits the memory_limit, and
+     if its flops, at the rate of a dense matrix product, are not already
+     slower than the best iterative candidate.
+
+     The winner is stored in the cachefile, by a signature of the problem:
+     spaces and orders, coupling types, size, symmetry, condensation and
+     threads. A cached choice is set up directly, without trials.
+
+     Flags:
+       candidates   list of preconditioners to try, default from the
+                    problem: local, block, h1amg (p=1), bddc, multigrid, direct
+       trialsteps   cg-steps of a trial
+       tol          relative error the prediction aims at
+       memory_limit bytes, excludes candidates which need more
+       cachefile    '' uses NGSOLVE_CACHE_DIR or ~/.cache/ngsolve/autosolver.txt
+       nocache      neither read nor write the cachefile
+  */
+  class AutoPreconditioner : public Preconditioner
+  {
+    struct Candidate
+    {
+      string name;
+      shared_ptr<Preconditioner> pre;
+      atomic<bool> failed{false};
+      string reason;
+      double setup = 0, steptime = 0, rate = 1, predicted = 1e99;
+      int steps = 0;
+      size_t memory = 0;
+    };
+
+    shared_ptr<BilinearForm> bfa;
+    Array<shared_ptr<Candidate>> candidates;
+    shared_ptr<Candidate> winner;
+    bool finalized = false;
+
+    int trialsteps;
+    double tol;
+    double memory_limit;
+    string cachefile;
+    string signature;
+    bool from_cache = false;
+    /// one line per candidate of the trials, for the report
+    Array<string> trials;
+
+  public:
+    AutoPreconditioner (shared_ptr<BilinearForm> abfa, const Flags & aflags,
+                        const string aname = "auto")
+      : Preconditioner (abfa, aflags, aname), bfa(abfa)
+    {
+      trialsteps = int(flags.GetNumFlag ("trialsteps", 10));
+      tol = flags.GetNumFlag ("tol", 1e-8);
+      memory_limit = flags.GetNumFlag ("memory_limit", 0);
+      cachefile = flags.GetStringFlag ("cachefile", "");
+      if (cachefile == "") cachefile = DefaultCacheFile();
+      if (flags.GetDefineFlag ("nocache")) cachefile = "";
+
+      signature = Signature();
+
+      string cached = ReadCache();
+      if (cached != "" && AddCandidate (cached))
+        {
+          from_cache = true;
+          cout << IM(3) << "auto preconditioner: " << cached << " from " << cachefile << endl;
+          return;
+        }
+
+      Array<string> names;
+      if (flags.StringListFlagDefined ("candidates"))
+        for (auto & name : flags.GetStringListFlag ("candidates"))
+          names.Append (name);
+      else
+        names = DefaultCandidates();
+      for (auto & name : names)
+        AddCandidate (name);
+      if (!candidates.Size())
+        throw Exception ("AutoPreconditioner: no candidate available");
+    }
+
+    AutoPreconditioner (const PDE & pde, const Flags & aflags, const string & aname)
+      : AutoPreconditioner (pde.GetBilinearForm (aflags.GetStringFlag ("bilinearform")),
+                            aflags, aname)
+    { ; }
+
+    virtual void InitLevel (shared_ptr<BitArray> freedofs) override
+    {
+      ForLive ([&] (Candidate & c) { c.pre->InitLevel (freedofs); });
+    }
+
+    virtual void AddElementMatrix (FlatArray<int> dnums,
+                                   const FlatMatrix<double> & elmat,
+                                   ElementId ei, LocalHeap & lh) override
+    {
+      ForLive ([&] (Candidate & c) { c.pre->AddElementMatrix (dnums, elmat, ei, lh); });
+    }
+
+    virtual void AddElementMatrix (FlatArray<int> dnums,
+                                   const FlatMatrix<Complex> & elmat,
+                                   ElementId ei, LocalHeap & lh) override
+    {
+      ForLive ([&] (Candidate & c) { c.pre->AddElementMatrix (dnums, elmat, ei, lh); });
+    }
+
+    virtual void FinalizeLevel (const BaseMatrix * mat) override
+    {
+      static Timer t("AutoPreconditioner::FinalizeLevel"); RegionTimer reg(t);
+      timestamp = bfa->GetTimeStamp();
+      finalized = true;
+      if (winner)
+        {
+          winner->pre->FinalizeLevel (mat);
+          return;
+        }
+
+      if (candidates.Size() == 1 && from_cache)
+        {
+          winner = candidates[0];
+          if (winner->failed)
+            throw Exception ("AutoPreconditioner: cached choice " + winner->name +
+                             " failed, " + winner->reason);
+          winner->pre->FinalizeLevel (mat);
+          return;
+        }
+
+      Choose (mat);
+      if (test) Test();
+    }
+
+    virtual void Update () override
+    {
+      if (!finalized)
+        throw Exception ("An auto preconditioner must be defined before assembling");
+      if (winner) winner->pre->Update();
+    }
+
+    virtual void CleanUpLevel () override
+    {
+      if (winner) winner->pre->CleanUpLevel();
+    }
+
+    virtual const BaseMatrix & GetMatrix() const override
+    {
+      if (!winner) ThrowPreconditionerNotReady();
+      return winner->pre->GetMatrix();
+    }
+
+    virtual shared_ptr<BaseMatrix> GetMatrixPtr() override
+    {
+      if (!winner) ThrowPreconditionerNotReady();
+      return winner->pre->GetMatrixPtr();
+    }
+
+    virtual const BaseMatrix & GetAMatrix() const override
+    {
+      return bfa->GetMatrix();
+    }
+
+    virtual const char * ClassName() const override
+    { return "Auto Preconditioner"; }
+
+    virtual void PrintReport (ostream & ost) const override
+    {
+      ost << "type = " << ClassName() << endl
+          << "signature = " << signature << endl;
+      if (winner) ost << "choice = " << winner->name << (from_cache ? " (cached)" : "") << endl;
+      for (auto & c : trials)
+        ost << c;
+    }
+
+    virtual Array<MemoryUsage> GetMemoryUsage () const override
+    {
+      if (!winner) return Array<MemoryUsage>();
+      return winner->pre->GetMatrix().GetMemoryUsage();
+    }
+
+  private:
+    /// calls func for the winner, or all candidates still in the game
+    template <typename FUNC>
+    void ForLive (FUNC func)
+    {
+      if (winner)
+        {
+          func (*winner);
+          return;
+        }
+      for (auto & c : candidates)
+        if (c->pre)
+          Try (*c, [&] () { func (*c); });
+    }
+
+    template <typename FUNC>
+    void Try (Candidate & c, FUNC func)
+    {
+      if (c.failed) return;
+      try
+        {
+          func();
+        }
+      catch (exception & e)
+        {
+          // element matrices arrive concurrently, only the first reason is kept
+          if (!c.failed.exchange (true))
+            c.reason = e.what();
+        }
+    }
+
+    Array<string> DefaultCandidates () const
+    {
+      auto fes = bfa->GetFESpace();
+      // the trials run the cg-method
+      if (!bfa->IsSymmetric())
+        return Array<string> ({ "direct" });
+
+      Array<string> names ({ "local", "block" });
+      if (!fes->IsComplex() && fes->GetDimension() == 1 && fes->GetOrder() == 1 &&
+          fes->GetClassName().find("H1") == 0)
+        names.Append ("h1amg");
+      // with only wirebasket dofs BDDC is a direct solver
+      bool nonwb = false;
+      for (size_t d = 0; d < fes->GetNDof() && !nonwb; d++)
+        nonwb = (fes->GetDofCouplingType(d) != WIREBASKET_DOF);
+      if (nonwb)
+        names.Append ("bddc");
+      if (ma->GetNLevels() > 1)
+        names.Append ("multigrid");
+      names.Append ("direct");
+      return names;
+    }
+
+    bool AddCandidate (const string & name)
+    {
+      Flags cflags = flags;
+      cflags.SetFlag ("not_register_for_auto_update");
+      cflags.SetFlag ("test", false);
+      string type = name;
+      if (name == "block")
+        {
+          type = "local";
+          cflags.SetFlag ("block");
+        }
+      if (name == "bddc" && bfa->GetFESpace()->IsComplex())
+        type = "bddcc";
+
+      auto info = GetPreconditionerClasses().GetPreconditioner (type);
+      if (!info)
+        {
+          cout << IM(3) << "auto preconditioner: unknown candidate '" << name << "'" << endl;
+          return false;
+        }
+
+      auto c = make_shared<Candidate>();
+      c->name = name;
+      try
+        {
+          c->pre = info->creatorbf (bfa, cflags, GetName()+" "+name);
+        }
+      catch (exception & e)
+        {
+          cout << IM(3) << "auto preconditioner: no " << name << ", " << e.what() << endl;
+          return false;
+        }
+      candidates.Append (c);
+      return true;
+    }
+
+    void Choose (const BaseMatrix * mat)
+    {
+      static Timer t("AutoPreconditioner::Trial"); RegionTimer reg(t);
+      auto freedofs = bfa->GetFESpace()->GetFreeDofs (bfa->UsesEliminateInternal());
+      const BaseMatrix & amat = bfa->GetMatrix();
+
+      // iterative candidates first, their time bounds the direct solvers
+      shared_ptr<Candidate> direct;
+      for (auto & c : candidates)
+        {
+          if (c->name == "direct")
+            {
+              direct = c;
+              continue;
+            }
+          Evaluate (c, mat, [&] ()
+            {
+              const BaseMatrix & pre = c->pre->GetMatrix();
+              c->rate = amat.IsComplex()
+                ? TrialCG<Complex> (amat, pre, freedofs, trialsteps, tol, c->steps, c->steptime)
+                : TrialCG<double> (amat, pre, freedofs, trialsteps, tol, c->steps, c->steptime);
+              if (!(c->rate < 1))
+                throw Exception ("no convergence");
+            });
+        }
+
+      if (direct && !direct->failed)
+        {
+          auto spmat = dynamic_cast<const BaseSparseMatrix*> (&amat);
+          FactorizationEstimate est;
+          if (spmat)
+            est = SparseFactorization::Estimate (*spmat, freedofs);
+          double bound = est.flops / DenseFlopRate();
+          if (memory_limit > 0 && est.peakmemory > memory_limit)
+            Reject (*direct, "needs "+ToString(est.peakmemory)+" bytes");
+          else if (winner && bound > winner->predicted)
+            Reject (*direct, "needs at least "+ToString(bound)+" sec");
+          else
+            Evaluate (direct, mat, [&] ()
+              {
+                auto x = amat.CreateColVector();
+                auto y = amat.CreateColVector();
+                x.SetRandom();
+                double t = WallTime();
+                direct->pre->GetMatrix().Mult (*x, *y);
+                direct->steptime = WallTime()-t;
+                direct->steps = 1;
+                direct->rate = 0;
+              });
+        }
+
+      if (!winner)
+        throw Exception ("AutoPreconditioner: all candidates failed");
+
+      candidates.SetSize0();
+      cout << IM(3) << "auto preconditioner: " << winner->name << endl;
+      WriteCache (winner->name);
+    }
+
+    /// setup and trial of one candidate, the best one so far is kept
+    template <typename FUNC>
+    void Evaluate (shared_ptr<Candidate> pc, const BaseMatrix * mat, FUNC trial)
+    {
+      Candidate & c = *pc;
+      double t = WallTime();
+      Try (c, [&] () { c.pre->FinalizeLevel (mat); });
+      c.setup = WallTime() - t;
+      Try (c, trial);
+
+      if (!c.failed)
+        {
+          for (auto & mu : c.pre->GetMatrix().GetMemoryUsage())
+            c.memory += mu.NBytes();
+          if (memory_limit > 0 && c.memory > memory_limit)
+            {
+              c.failed = true;
+              c.reason = "needs "+ToString(c.memory)+" bytes";
+            }
+        }
+      if (c.failed)
+        {
+          Reject (c, c.reason);
+          return;
+        }
+
+      int nsteps = c.steps;
+      if (c.rate > 0 && pow (c.rate, c.steps) > tol)
+        nsteps = int (ceil (log (tol) / log (c.rate)));
+      c.predicted = c.setup + nsteps * c.steptime;
+
+      stringstream line;
+      line << c.name << ": setup " << c.setup << " sec, " << c.steptime << " sec/step, rate "
+           << c.rate << ", predicted " << c.predicted << " sec, " << c.memory << " bytes" << endl;
+      trials.Append (line.str());
+      cout << IM(3) << "auto preconditioner, " << line.str();
+
+      if (!winner || c.predicted < winner->predicted)
+        {
+          if (winner) winner->pre = nullptr;
+          winner = pc;
+        }
+      else
+        c.pre = nullptr;
+    }
+
+    void Reject (Candidate & c, const string & reason)
+    {
+      string line = c.name + ": " + reason + "\n";
+      trials.Append (line);
+      cout << IM(3) << "auto preconditioner, " << line;
+      c.failed = true;
+      c.pre = nullptr;
+    }
+
+    string Signature () const
+    {
+      auto fes = bfa->GetFESpace();
+      stringstream sig;
+      DescribeSpace (sig, *fes);
+
+      size_t ndof = fes->GetNDof();
+      size_t nwb = 0, nif = 0;
+      for (size_t d = 0; d < ndof; d++)
+        {
+          auto ct = fes->GetDofCouplingType(d);
+          if (ct == WIREBASKET_DOF) nwb++;
+          else if (ct == INTERFACE_DOF) nif++;
+        }
+      auto tenths = [ndof] (size_t n) { return int (10.0*n / max2 (ndof, size_t(1)) + 0.5); };
+
+      sig << " dim=" << ma->GetDimension()
+          << " ndof=2^" << int (log2 (max2 (ndof, size_t(1))) + 0.5)
+          << " wb=" << tenths(nwb) << " if=" << tenths(nif)
+          << " complex=" << fes->IsComplex()
+          << " symmetric=" << bfa->IsSymmetric()
+          << " condense=" << bfa->UsesEliminateInternal()
+          << " levels=" << ma->GetNLevels()
+          << " threads=" << TaskManager::GetNumThreads();
+      if (flags.StringListFlagDefined ("candidates"))
+        for (auto & name : flags.GetStringListFlag ("candidates"))
+          sig << " " << name;
+      return sig.str();
+    }
+
+    static void DescribeSpace (ostream & ost, const FESpace & fes)
+    {
+      ost << fes.GetClassName() << ":" << fes.GetOrder();
+      if (fes.GetDimension() > 1) ost << "x" << fes.GetDimension();
+      if (auto comp = dynamic_cast<const CompoundFESpace*> (&fes))
+        {
+          ost << "(";
+          for (int i = 0; i < comp->GetNSpaces(); i++)
+            {
+              if (i) ost << ",";
+              DescribeSpace (ost, *(*comp)[i]);
+            }
+          ost << ")";
+        }
+    }
+
+    /// the last entry for the signature, file lines are 'signature | choice'
+    string ReadCache () const
+    {
+      if (cachefile == "") return "";
+      ifstream in(cachefile);
+      string line, choice;
+      while (getline (in, line))
+        {
+          auto pos = line.rfind (" | ");
+          if (pos != string::npos && line.substr (0, pos) == signature)
+            choice = line.substr (pos+3);
+        }
+      return choice;
+    }
+
+    void WriteCache (const string & choice) const
+    {
+      if (cachefile == "") return;
+      ofstream out(cachefile, ios::app);
+      if (out)
+        out << signature << " | " << choice << endl;
+    }
+  };
+
+
+  static RegisterPreconditioner<AutoPreconditioner> initauto ("auto");
+}
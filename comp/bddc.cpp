@@ -5,6 +5,27 @@
 namespace ngcomp
 {
 
+  // inverse of the inner block of an element matrix
+  template <class SCAL>
+  inline void CalcInnerInverse (FlatMatrix<SCAL> d, bool spd, LocalHeap & lh)
+  {
+    CalcInverse (d);
+  }
+
+#ifdef LAPACK
+  // Cholesky based for spd forms, half the flops of the pivoted inverse
+  inline void CalcInnerInverse (FlatMatrix<double> d, bool spd, LocalHeap & lh)
+  {
+    if (spd)
+      {
+        HeapReset hr(lh);
+        FlatMatrix<double> dsave = d | lh;
+        if (LapackInverseSPD (d)) return;
+        d = dsave;
+      }
+    CalcInverse (d);
+  }
+#endif
  
   template <class SCAL, class TV>
   class BDDCMatrix : public BaseMatrix
@@ -28,6 +49,8 @@ namespace ngcomp
     bool hypre;
     bool coarse;
     bool local; // act as bddc for the local matrix
+    /// larger wirebasket problems are factorized distributed
+    size_t coarse_mastermaxsize;
     
     shared_ptr<BaseMatrix> inv;
     shared_ptr<BaseMatrix> inv_coarse;
@@ -62,6 +85,7 @@ namespace ngcomp
       hypre = ahypre;
 
       local = flags.GetDefineFlag("local");
+      coarse_mastermaxsize = size_t(flags.GetNumFlag("coarse_mastermaxsize", 50000));
       
       // pwbmat = NULL;
       inv = NULL;
@@ -83,8 +107,9 @@ namespace ngcomp
 
       LocalHeap lh(10000, "BDDC-constr, dummy heap");
       
+      // every element writes only its own entries, no coloring needed
       for (auto vb : { VOL, BND, BBND })
-        IterateElements 
+        IterateElementsUncolored
           (*fes, vb, lh, 
            [&] (FESpace::Element el, LocalHeap & lh)
            {
@@ -108,7 +133,7 @@ namespace ngcomp
       Table<int> el2ifdofs(ifcnt);    // interface dofs on each element
       
       for (auto vb : { VOL, BND, BBND })
-        IterateElements 
+        IterateElementsUncolored 
           (*fes, vb, lh, 
            [&] (FESpace::Element el, LocalHeap & lh)
            {
@@ -138,9 +163,11 @@ namespace ngcomp
       wb_free_dofs->Clear();
 
       // *wb_free_dofs = wbdof;
-      for (auto i : Range(ndof))
-	if (fes->GetDofCouplingType(i) == WIREBASKET_DOF)
-	  wb_free_dofs -> Set(i);
+      ParallelFor (ndof, [&] (size_t i)
+                   {
+                     if (fes->GetDofCouplingType(i) == WIREBASKET_DOF)
+                       wb_free_dofs -> Set(i);
+                   });
 
 
       if (fes->GetFreeDofs())
@@ -244,7 +271,7 @@ namespace ngcomp
           NgProfiler::AddThreadFlops (timer3, TaskManager::GetThreadId(),
                                       sizei*sizei*sizei + 2*sizei*sizei*sizew);
 
-          CalcInverse (d);  // , INVERSE_LIB::INV_NGBLA);
+          CalcInnerInverse (d, bfa->IsSPD(), lh);
           
 	  if (sizew)
 	    {
@@ -266,11 +293,15 @@ namespace ngcomp
 		  het = SCAL(0.0);
 		  het -= b*d  | Lapack;
 		  */
-                  het = -b*d;
-                  
-		  //E * R^T
-		  for (size_t l = 0; l < sizei; l++)
-		    het.Col(l) *= el2ifweight[l];
+                  // symmetric form: -b d^{-1} = (-d^{-1} c)^T, weighted E * R^T
+                  if (bfa->IsSymmetric())
+                    het = Trans(he);
+                  else
+                    {
+                      het = -b*d;
+                      for (size_t l = 0; l < sizei; l++)
+                        het.Col(l) *= el2ifweight[l];
+                    }
 		}
 	    }
 	  //R * A_ii^(-1) * R^T
@@ -395,7 +426,9 @@ namespace ngcomp
 	    {
 	      shared_ptr<ParallelDofs> pardofs = bfa->GetFESpace()->GetParallelDofs();
 
-	      pwbmat = make_shared<ParallelMatrix> (pwbmat, pardofs);
+	      auto parwbmat = make_shared<ParallelMatrix> (pwbmat, pardofs);
+              parwbmat -> SetMasterInverseMaxSize (coarse_mastermaxsize);
+	      pwbmat = parwbmat;
 	      pwbmat -> SetInverseType (inversetype);
 
 #ifdef HYPRE
@@ -420,9 +453,7 @@ namespace ngcomp
 #endif
 	    {
 
-              int cntfreedofs = 0;
-              for (int i = 0; i < wb_free_dofs->Size(); i++)
-                if (wb_free_dofs->Test(i)) cntfreedofs++;
+              size_t cntfreedofs = wb_free_dofs->NumSet();
 
               if (coarse)
               {
@@ -56,6 +56,98 @@ namespace ngcomp
   }
 
 
+  /*
+    Static condensation of the symmetric matrix
+
+      mat = ( D  C^t )     D of size ni, only the lower triangle is used
+            ( C  A   )
+
+    by D = L diag L^t without pivoting. On return the lower triangle of
+    mat.Rows(ni,n).Cols(ni,n) is the Schur complement A - C D^{-1} C^t,
+    dinv = D^{-1} and he = -D^{-1} C^t = -L^{-t} (C L^{-t} diag^{-1})^t.
+    TLANE is SIMD<double> for a batch of element matrices in the lanes.
+  */
+  template <typename TLANE>
+  void CondenseLDL (FlatMatrix<TLANE> mat, size_t ni, FlatVector<TLANE> diag,
+                    FlatMatrix<TLANE> dinv, FlatMatrix<TLANE> he, LocalHeap & lh)
+  {
+    HeapReset hr(lh);
+    size_t n = mat.Height();
+    FlatVector<TLANE> col(n, lh);
+    FlatMatrix<TLANE> linvt(ni, lh);    // transpose of L^{-1}
+
+    for (size_t k = 0; k < ni; k++)
+      {
+        TLANE piv = mat(k,k);
+        TLANE inv = TLANE(1.0) / piv;
+        diag(k) = piv;
+        for (size_t j = k+1; j < n; j++)
+          col(j) = mat(j,k);
+        for (size_t j = k+1; j < n; j++)
+          {
+            TLANE l = col(j) * inv;
+            mat(j,k) = l;
+            for (size_t m = k+1; m <= j; m++)
+              mat(j,m) -= l * col(m);
+          }
+      }
+
+    for (size_t c = 0; c < ni; c++)
+      {
+        for (size_t i = 0; i < c; i++)
+          linvt(c,i) = TLANE(0.0);
+        linvt(c,c) = TLANE(1.0);
+        for (size_t i = c+1; i < ni; i++)
+          {
+            TLANE sum = mat(i,c);
+            for (size_t k = c+1; k < i; k++)
+              sum += mat(i,k) * linvt(c,k);
+            linvt(c,i) = -sum;
+          }
+      }
+
+    for (size_t k = 0; k < ni; k++)
+      col(k) = TLANE(1.0) / diag(k);
+    for (size_t i = 0; i < ni; i++)
+      for (size_t j = 0; j <= i; j++)
+        {
+          TLANE sum(0.0);
+          for (size_t k = i; k < ni; k++)
+            sum += linvt(i,k) * col(k) * linvt(j,k);
+          dinv(i,j) = sum;
+          dinv(j,i) = sum;
+        }
+
+    for (size_t i = 0; i < ni; i++)
+      for (size_t o = 0; o < n-ni; o++)
+        {
+          TLANE sum(0.0);
+          for (size_t k = i; k < ni; k++)
+            sum += linvt(i,k) * mat(ni+o,k);
+          he(i,o) = -sum;
+        }
+  }
+
+  /// element matrices in the lanes of the batched static condensation
+  template <typename SCAL> struct CondensationLanes
+  {
+    typedef SCAL TLANE;
+    static constexpr int W = 1;
+    template <typename FUNC>
+    static TLANE Make (const FUNC & func) { return func(0); }
+    static SCAL Get (TLANE val, int l) { return val; }
+  };
+
+  template <> struct CondensationLanes<double>
+  {
+    typedef SIMD<double> TLANE;
+    static constexpr int W = SIMD<double>::Size();
+    template <typename FUNC>
+    static TLANE Make (const FUNC & func) { return TLANE(func); }
+    static double Get (TLANE val, int l) { return val[l]; }
+  };
+
+
 
 
 
@@ -103,6 +195,17 @@ namespace ngcomp
     SetStoreInner (flags.GetDefineFlag ("store_inner"));
     precompute = flags.GetDefineFlag ("precompute");
     checksum = flags.GetDefineFlag ("checksum");
+    use_scattermap = flags.GetDefineFlag ("scattermap");
+    atomic_assembly = flags.GetDefineFlag ("atomic_assembly");
+    store_elmats = flags.GetDefineFlag ("store_elmats");
+    pipeline_batch = int(flags.GetNumFlag ("pipeline_batch", 0));
+    batch_condense = flags.GetDefineFlag ("batch_condense");
+    compress_condensed_share = flags.GetDefineFlag ("compress_condensed_share");
+    compress_condensed_single = flags.GetDefineFlag ("compress_condensed_single");
+    compress_condensed = flags.GetDefineFlag ("compress_condensed") ||
+      compress_condensed_share || compress_condensed_single;
+    linearization_plan = flags.GetDefineFlag ("linearization_plan");
+    if (linearization_plan) use_scattermap = true;
     spd = flags.GetDefineFlag ("spd");
     if (spd) symmetric = true;
     SetCheckUnused (!flags.GetDefineFlagX("check_unused").IsFalse());
@@ -157,6 +260,17 @@ namespace ngcomp
 
     precompute = flags.GetDefineFlag ("precompute");
     checksum = flags.GetDefineFlag ("checksum");
+    use_scattermap = flags.GetDefineFlag ("scattermap");
+    atomic_assembly = flags.GetDefineFlag ("atomic_assembly");
+    store_elmats = flags.GetDefineFlag ("store_elmats");
+    pipeline_batch = int(flags.GetNumFlag ("pipeline_batch", 0));
+    batch_condense = flags.GetDefineFlag ("batch_condense");
+    compress_condensed_share = flags.GetDefineFlag ("compress_condensed_share");
+    compress_condensed_single = flags.GetDefineFlag ("compress_condensed_single");
+    compress_condensed = flags.GetDefineFlag ("compress_condensed") ||
+      compress_condensed_share || compress_condensed_single;
+    linearization_plan = flags.GetDefineFlag ("linearization_plan");
+    if (linearization_plan) use_scattermap = true;
     SetCheckUnused (!flags.GetDefineFlagX("check_unused").IsFalse());    
   }
 
@@ -531,6 +645,116 @@ namespace ngcomp
   }
 
 
+  bool BilinearForm :: UseUncoloredAssembly (VorB vb) const
+  {
+    // preconditioners and the condensed linearform are updated without atomics
+    if (preconditioners.Size() || linearform) return false;
+    if (atomic_assembly) return true;
+    return HasPoorColoring (*fespace, vb);
+  }
+
+  void BilinearForm :: CalcScatterMap (const MatrixGraph & graph, bool symmetric)
+  {
+    static Timer t("BilinearForm::CalcScatterMap"); RegionTimer reg(t);
+
+    size_t ne = ma->GetNE(VOL);
+    Array<int> ndofs(ne), npos(ne);
+    ParallelForRange
+      (ne, [&] (IntRange r)
+       {
+         Array<DofId> dnums;
+         for (auto i : r)
+           {
+             ElementId ei(VOL, i);
+             dnums.SetSize0();
+             if (fespace->DefinedOn (VOL, ma->GetElIndex(ei)))
+               fespace->GetDofNrs (ei, dnums);
+             ndofs[i] = dnums.Size();
+             npos[i] = sqr(dnums.Size());
+           }
+       });
+
+    scatter_dnums = Table<int> (ndofs);
+    scatter_positions = Table<int> (npos);
+    ParallelForRange
+      (ne, [&] (IntRange r)
+       {
+         Array<DofId> dnums;
+         for (auto i : r)
+           {
+             if (!ndofs[i]) continue;
+             fespace->GetDofNrs (ElementId(VOL, i), dnums);
+             scatter_dnums[i] = dnums;
+             if (symmetric)
+               graph.GetElementPositionsSymmetric (dnums, scatter_positions[i]);
+             else
+               graph.GetElementPositions (dnums, dnums, scatter_positions[i]);
+           }
+       });
+  }
+
+  void BilinearForm :: UpdateLinearizationPlan ()
+  {
+    size_t ndof = fespace->GetNDof();
+    bool valid = ndof == plan_ndof;
+    for (VorB vb : { VOL, BND, BBND, BBBND })
+      if (VB_parts[vb].Size() && plan_dnums[vb].Size() != ma->GetNE(vb))
+        valid = false;
+    if (valid) return;
+
+    static Timer t("BilinearForm::UpdateLinearizationPlan"); RegionTimer reg(t);
+    for (VorB vb : { VOL, BND, BBND, BBBND })
+      {
+        if (!VB_parts[vb].Size())
+          {
+            plan_dnums[vb] = Table<int>();
+            continue;
+          }
+
+        size_t ne = ma->GetNE(vb);
+        Array<int> ndofs(ne);
+        ParallelForRange
+          (ne, [&] (IntRange r)
+           {
+             Array<DofId> dnums;
+             for (auto i : r)
+               {
+                 ElementId ei(vb, i);
+                 dnums.SetSize0();
+                 if (fespace->DefinedOn (ei))
+                   fespace->GetDofNrs (ei, dnums);
+                 ndofs[i] = dnums.Size();
+               }
+           });
+
+        plan_dnums[vb] = Table<int> (ndofs);
+        ParallelForRange
+          (ne, [&] (IntRange r)
+           {
+             Array<DofId> dnums;
+             for (auto i : r)
+               {
+                 if (!ndofs[i]) continue;
+                 fespace->GetDofNrs (ElementId(vb, i), dnums);
+                 plan_dnums[vb][i] = dnums;
+               }
+           });
+      }
+    plan_ndof = ndof;
+  }
+
+  shared_ptr<MatrixGraph> BilinearForm :: GetSharedGraph (int level, bool symmetric)
+  {
+    if (fespace2 || fespace->GetSpecialElements().Size())
+      return shared_ptr<MatrixGraph> (GetGraph (level, symmetric));
+
+    // the graph depends only on the space and the condensation flags
+    int key = int(symmetric) + 2*int(eliminate_internal) + 4*int(eliminate_hidden);
+    return fespace->GetCachedGraph
+      (key, [&] () { return shared_ptr<MatrixGraph> (GetGraph (level, symmetric)); });
+  }
+
+
 
 
 
@@ -825,6 +1049,234 @@ namespace ngcomp
 
 
 
+  template <class SCAL>
+  void S_BilinearForm<SCAL> :: UpdateElementMatrixCaches (LocalHeap & clh)
+  {
+    size_t ndof = fespace->GetNDof();
+    for (VorB vb : { VOL, BND, BBND, BBBND })
+      {
+        Array<shared_ptr<ElementMatrixCache>> caches;
+        for (auto & bfi : VB_parts[vb])
+          {
+            if (!bfi->CacheElementMatrices()) continue;
+
+            shared_ptr<ElementMatrixCache> cache;
+            for (auto & c : elmat_caches[vb])
+              if (c->bfi == bfi && c->ndof == ndof && c->elmats.Size() == ma->GetNE(vb))
+                cache = c;
+
+            if (!cache)
+              {
+                Array<int> sizes(ma->GetNE(vb));
+                sizes = 0;
+                IterateElements
+                  (*fespace, vb, clh, [&] (FESpace::Element el, LocalHeap & lh)
+                   {
+                     sizes[el.Nr()] = sqr(el.GetDofs().Size() * fespace->GetDimension());
+                   });
+                
+                cache = make_shared<ElementMatrixCache>();
+                cache->bfi = bfi;
+                cache->ndof = ndof;
+                cache->elmats = Table<SCAL> (sizes);
+                cache->computed.SetSize (sizes.Size());
+                cache->computed.Clear();
+              }
+            caches.Append (cache);
+          }
+        elmat_caches[vb] = move(caches);
+      }
+  }
+
+  
+  template <class SCAL>
+  void S_BilinearForm<SCAL> :: ReassembleRegion (const BitArray & domains, LocalHeap & clh)
+  {
+    static Timer t("BilinearForm::ReassembleRegion"); RegionTimer reg(t);
+    if (!elmat_store)
+      throw Exception ("ReassembleRegion needs flag 'store_elmats' and an assembled matrix");
+
+    IterateElements
+      (*fespace, VOL, clh, [&] (FESpace::Element el, LocalHeap & lh)
+       {
+         if (!domains.Test(el.GetIndex())) return;
+
+         const FiniteElement & fel = el.GetFE();
+         const ElementTransformation & eltrans = el.GetTrafo();
+         FlatArray<int> dnums = el.GetDofs();
+
+         FlatMatrix<SCAL> sum_elmat(dnums.Size(), lh);
+         bool done = false;
+         while (!done)
+           {
+             done = true;
+             sum_elmat = 0;
+             for (auto & bfi : VB_parts[VOL])
+               {
+                 if (!bfi->DefinedOn (el.GetIndex())) continue;
+                 if (!bfi->DefinedOnElement (el.Nr())) continue;
+                 try
+                   {
+                     auto & mapped_trafo = eltrans.AddDeformation(bfi->GetDeformation().get(), lh);
+                     bfi->CalcElementMatrixAdd (fel, mapped_trafo, sum_elmat, lh);
+                   }
+                 catch (ExceptionNOSIMD & e)
+                   {
+                     done = false;
+                   }
+               }
+           }
+         fespace->TransformMat (el, sum_elmat, TRANSFORM_MAT_LEFT_RIGHT);
+
+         // the store keeps the rows and columns of regular dofs only
+         Array<int> used(dnums.Size(), lh), useddnums(dnums.Size(), lh);
+         used.SetSize0(); useddnums.SetSize0();
+         for (auto i : Range(dnums))
+           if (IsRegularDof(dnums[i]))
+             {
+               used.AppendHaveMem(i);
+               useddnums.AppendHaveMem(dnums[i]);
+             }
+
+         FlatArray<int> olddnums = elmat_store->GetElementRowDNums(el.Nr());
+         FlatMatrix<SCAL> oldmat = elmat_store->GetElementMatrix(el.Nr());
+         if (olddnums.Size() != used.Size())
+           throw Exception ("ReassembleRegion: element dofs changed since Assemble");
+         // elements without integrators have not been stored
+         bool has_old = used.Size() > 0 && olddnums[0] != -1;
+         if (has_old && !(olddnums == useddnums))
+           throw Exception ("ReassembleRegion: element dofs changed since Assemble");
+
+         FlatMatrix<SCAL> diff(used.Size(), lh);
+         for (auto i : Range(used))
+           for (auto j : Range(used))
+             diff(i,j) = sum_elmat(used[i], used[j]) - (has_old ? oldmat(i,j) : SCAL(0.0));
+
+         AddElementMatrix (useddnums, useddnums, diff, el, lh);
+         elmat_store -> AddElementMatrix (el.Nr(), dnums, dnums, sum_elmat);
+       });
+
+    timestamp = ++global_timestamp;
+  }
+
+
+  /// element matrices computed by one thread, waiting for the scatter phase
+  template <class SCAL>
+  class ElementMatrixBatch
+  {
+    VorB vb = VOL;
+    Array<int> elnrs;
+    Array<size_t> firstdof, firstval;
+    Array<int> dnums, firstrow, order;
+    Array<SCAL> vals;
+  public:
+    size_t Size() const { return elnrs.Size(); }
+
+    void Append (ElementId ei, FlatArray<int> adnums, FlatMatrix<SCAL> elmat)
+    {
+      int minrow = numeric_limits<int>::max();
+      for (auto d : adnums)
+        if (IsRegularDof(d) && d < minrow) minrow = d;
+      
+      vb = ei.VB();
+      elnrs.Append (ei.Nr());
+      firstrow.Append (minrow);
+      firstdof.Append (dnums.Size());
+      firstval.Append (vals.Size());
+      dnums.Append (adnums);
+      vals.Append (FlatArray<SCAL> (elmat.Height()*elmat.Width(), &elmat(0,0)));
+    }
+
+    /// scatters the element matrices ordered by their first matrix row,
+    /// and empties the batch keeping the memory
+    template <typename TFUNC>
+    void Flush (const TFUNC & scatter)
+    {
+      size_t n = elnrs.Size();
+      order.SetSize (n);
+      for (size_t i : Range(n))
+        order[i] = i;
+      QuickSortI (firstrow, order);
+
+      firstdof.Append (dnums.Size());
+      for (int i : order)
+        {
+          FlatArray<int> eldnums = dnums.Range (firstdof[i], firstdof[i+1]);
+          FlatMatrix<SCAL> elmat (eldnums.Size(), eldnums.Size(), &vals[firstval[i]]);
+          scatter (ElementId(vb, elnrs[i]), eldnums, elmat);
+        }
+
+      elnrs.SetSize0(); firstrow.SetSize0();
+      firstdof.SetSize0(); firstval.SetSize0();
+      dnums.SetSize0(); vals.SetSize0();
+    }
+  };
+
+
+  /// symmetric element matrices of one thread waiting for the batched
+  /// static condensation, all with the same local inner and outer dofs
+  template <class SCAL>
+  class CondensationBatch
+  {
+    VorB vb = VOL;
+    Array<int> elnrs;
+    Array<int> idofs, odofs;
+    Array<int> dnums;
+    Array<SCAL> vals;
+    size_t ndof = 0, size = 0;
+  public:
+    size_t Size() const { return elnrs.Size(); }
+
+    /// has the element the same local dofs as the waiting ones ?
+    bool Fits (FlatArray<int> adnums, FlatArray<int> aidofs, FlatArray<int> aodofs) const
+    {
+      return Size() == 0 ||
+        (adnums.Size() == ndof && aidofs == FlatArray<int>(idofs) && aodofs == FlatArray<int>(odofs));
+    }
+
+    void Append (ElementId ei, FlatArray<int> adnums,
+                 FlatArray<int> aidofs, FlatArray<int> aodofs, FlatMatrix<SCAL> elmat)
+    {
+      if (Size() == 0)
+        {
+          vb = ei.VB();
+          ndof = adnums.Size();
+          size = elmat.Height();
+          idofs = aidofs;
+          odofs = aodofs;
+        }
+      elnrs.Append (ei.Nr());
+      dnums.Append (adnums);
+      vals.Append (FlatArray<SCAL> (size*size, &elmat(0,0)));
+    }
+
+    ElementId GetElementId (size_t i) const { return ElementId (vb, elnrs[i]); }
+    FlatArray<int> GetDofs (size_t i) { return dnums.Range (i*ndof, (i+1)*ndof); }
+    FlatMatrix<SCAL> GetElmat (size_t i) { return FlatMatrix<SCAL> (size, size, &vals[i*size*size]); }
+    FlatArray<int> GetInnerDofs () const { return idofs; }
+    FlatArray<int> GetOuterDofs () const { return odofs; }
+
+    /// empties the batch keeping the memory
+    void Clear ()
+    {
+      elnrs.SetSize0();
+      dnums.SetSize0();
+      vals.SetSize0();
+    }
+  };
+
+
+  template <class SCAL>
+  void S_BilinearForm<SCAL> :: CompressCondensed ()
+  {
+    if (!compress_condensed || !eliminate_internal || !keep_internal) return;
+    for (auto ebe : { harmonicext, dynamic_pointer_cast<ElementByElementMatrix<SCAL>> (harmonicexttrans),
+                      innersolve, innermatrix })
+      if (ebe)
+        ebe->Compress (compress_condensed_share, compress_condensed_single);
+  }
+
+
   template <class SCAL>
   void S_BilinearForm<SCAL> :: DoAssemble (LocalHeap & clh)
   {
@@ -884,6 +1336,24 @@ namespace ngcomp
             size_t nf = ma->GetNFacets();
 
             GetMatrix().SetZero();
+
+            UpdateElementMatrixCaches (clh);
+
+            if (store_elmats)
+              {
+                if (fespace->GetDimension() != 1 || eliminate_internal || eliminate_hidden)
+                  throw Exception ("store_elmats needs a scalar space without static condensation");
+                Array<int> nused(ma->GetNE(VOL));
+                nused = 0;
+                IterateElements
+                  (*fespace, VOL, clh, [&] (FESpace::Element el, LocalHeap & lh)
+                   {
+                     for (auto d : el.GetDofs())
+                       if (IsRegularDof(d)) nused[el.Nr()]++;
+                   });
+                elmat_store = make_shared<ElementByElementMatrix<SCAL>> (ndof, ndof, nused, nused,
+                                                                          false, false, false);
+              }
 	    
             if (print)
               {
@@ -1014,7 +1484,195 @@ namespace ngcomp
                           innermatrix = make_shared<ElementByElementMatrix<SCAL>>(ndof, ne);
                       }
                     */
-                    IterateElements
+                    assembling_uncolored = UseUncoloredAssembly (vb);
+                    auto iterate = assembling_uncolored ? IterateElementsUncolored : IterateElements;
+
+                    // pipelined mode: every thread collects a batch of element matrices,
+                    // and scatters them in one sweep ordered by matrix rows
+                    int batchsize = (printelmat || elmat_ev) ? 0 : pipeline_batch;
+                    Array<ElementMatrixBatch<SCAL>> batches(batchsize ? TaskManager::GetMaxThreads() : 0);
+                    auto scatter_batch = [&] (LocalHeap & lh)
+                      {
+                        if (!batchsize) return;
+                        static Timer scattertimer("scatter elmat batch", 2);
+                        ThreadRegionTimer reg (scattertimer, TaskManager::GetThreadId());
+                        batches[TaskManager::GetThreadId()].Flush
+                          ([&] (ElementId ei, FlatArray<int> eldnums, FlatMatrix<SCAL> elmat)
+                           {
+                             HeapReset hr(lh);
+                             AddElementMatrix (eldnums, eldnums, elmat, ei, lh);
+                           });
+                      };
+
+                    // the final element matrix into the global matrix, the store and the
+                    // preconditioners. Of a condensed matrix only the outer dofs are
+                    // scattered, if the positions are not precomputed for all dofs
+                    auto add_element = [&] (ElementId ei, FlatArray<int> dnums, FlatMatrix<SCAL> sum_elmat,
+                                            bool condensed, LocalHeap & lh)
+                      {
+                        HeapReset hr(lh);
+                        auto add = [&] (FlatArray<int> adnums, FlatMatrix<SCAL> aelmat)
+                          {
+                            if (batchsize)
+                              {
+                                auto & batch = batches[TaskManager::GetThreadId()];
+                                batch.Append (ei, adnums, aelmat);
+                                if (batch.Size() >= batchsize)
+                                  scatter_batch (lh);
+                              }
+                            else
+                              AddElementMatrix (adnums, adnums, aelmat, ei, lh);
+                          };
+
+                        if (condensed && !use_scattermap)
+                          {
+                            int dim = fespace->GetDimension();
+                            Array<int> odnums(dnums.Size(), lh), orows(sum_elmat.Height(), lh);
+                            odnums.SetSize0();
+                            orows.SetSize0();
+                            for (auto i : Range(dnums))
+                              if (IsRegularDof(dnums[i]))
+                                {
+                                  odnums.AppendHaveMem (dnums[i]);
+                                  for (int j = 0; j < dim; j++)
+                                    orows.AppendHaveMem (dim*i+j);
+                                }
+                            FlatMatrix<SCAL> oelmat = sum_elmat.Rows(orows).Cols(orows) | lh;
+                            add (odnums, oelmat);
+                          }
+                        else
+                          add (dnums, sum_elmat);
+
+                        if (elmat_store && ei.VB() == VOL)
+                          elmat_store -> AddElementMatrix (ei.Nr(), dnums, dnums, sum_elmat);
+
+                        for (auto pre : preconditioners)
+                          pre -> AddElementMatrix (dnums, sum_elmat, ei, lh);
+
+                        if (check_unused)
+                          {
+                            if (printelmat)
+                              *testout << "set these as useddof: " << dnums << endl;
+                            for (auto d : dnums)
+                              if (IsRegularDof(d)) useddof[d] = true;
+                          }
+                      };
+
+                    // static condensation of symmetric matrices by LDL^t, batched over
+                    // the elements of a thread with the same local dofs in SIMD lanes
+                    bool condense_batched = batch_condense && symmetric &&
+                      eliminate_internal && keep_internal && !printelmat && !elmat_ev;
+                    Array<CondensationBatch<SCAL>> condbatches(condense_batched ? TaskManager::GetMaxThreads() : 0);
+                    auto condense_batch = [&] (LocalHeap & lh)
+                      {
+                        if (!condense_batched) return;
+                        auto & cb = condbatches[TaskManager::GetThreadId()];
+                        if (!cb.Size()) return;
+
+                        static Timer statcondtimer_batch("static condensation batch", 2);
+                        typedef CondensationLanes<SCAL> LANES;
+                        typedef typename LANES::TLANE TLANE;
+                        HeapReset hr(lh);
+
+                        int dim = fespace->GetDimension();
+                        FlatArray<int> idofs1 = cb.GetInnerDofs(), odofs1 = cb.GetOuterDofs();
+                        size_t ni = dim*idofs1.Size(), no = dim*odofs1.Size(), n = ni+no;
+                        FlatArray<int> idofs(ni, lh), odofs(no, lh), perm(n, lh);
+                        for (size_t j = 0, k = 0; j < idofs1.Size(); j++)
+                          for (int jj = 0; jj < dim; jj++)
+                            idofs[k++] = dim*idofs1[j]+jj;
+                        for (size_t j = 0, k = 0; j < odofs1.Size(); j++)
+                          for (int jj = 0; jj < dim; jj++)
+                            odofs[k++] = dim*odofs1[j]+jj;
+                        for (size_t i = 0; i < ni; i++) perm[i] = idofs[i];
+                        for (size_t i = 0; i < no; i++) perm[ni+i] = odofs[i];
+
+                        FlatMatrix<TLANE> mat(n, lh), dinv(ni, lh), he(ni, no, lh);
+                        FlatVector<TLANE> diag(ni, lh);
+
+                        for (size_t first = 0; first < cb.Size(); first += LANES::W)
+                          {
+                            // unused lanes repeat the last element
+                            size_t cnt = min2 (size_t(LANES::W), cb.Size()-first);
+                            {
+                              ThreadRegionTimer reg (statcondtimer_batch, TaskManager::GetThreadId());
+                              for (size_t i = 0; i < n; i++)
+                                for (size_t j = 0; j <= i; j++)
+                                  mat(i,j) = LANES::Make ([&] (int l)
+                                                          {
+                                                            return cb.GetElmat (first+min2(size_t(l), cnt-1)) (perm[i], perm[j]);
+                                                          });
+                              CondenseLDL (mat, ni, diag, dinv, he, lh);
+                            }
+
+                            for (size_t l = 0; l < cnt; l++)
+                              {
+                                HeapReset hr(lh);
+                                ElementId ei = cb.GetElementId (first+l);
+                                FlatArray<int> dnums = cb.GetDofs (first+l);
+                                FlatMatrix<SCAL> elmat = cb.GetElmat (first+l);
+
+                                Array<int> idnums(ni, lh), ednums(no, lh);
+                                idnums.SetSize0();
+                                ednums.SetSize0();
+                                for (int d : idofs1)
+                                  idnums += dim*IntRange(dnums[d], dnums[d]+1);
+                                for (int d : odofs1)
+                                  ednums += dim*IntRange(dnums[d], dnums[d]+1);
+
+                                if (store_inner)
+                                  innermatrix->AddElementMatrix (ei.Nr(), idnums, idnums,
+                                                                 elmat.Rows(idofs).Cols(idofs) | lh);
+
+                                bool pivots_ok = true;
+                                for (size_t i = 0; i < ni; i++)
+                                  if (!(fabs (LANES::Get (diag(i), l)) > 1e-14 * fabs (elmat(idofs[i], idofs[i]))))
+                                    pivots_ok = false;
+
+                                FlatMatrix<SCAL> ldinv(ni, lh), lhe(ni, no, lh);
+                                if (pivots_ok)
+                                  {
+                                    for (size_t i = 0; i < ni; i++)
+                                      for (size_t j = 0; j < ni; j++)
+                                        ldinv(i,j) = LANES::Get (dinv(i,j), l);
+                                    for (size_t i = 0; i < ni; i++)
+                                      for (size_t j = 0; j < no; j++)
+                                        lhe(i,j) = LANES::Get (he(i,j), l);
+                                    for (size_t i = 0; i < no; i++)
+                                      for (size_t j = 0; j <= i; j++)
+                                        elmat(odofs[i], odofs[j]) = elmat(odofs[j], odofs[i]) =
+                                          LANES::Get (mat(ni+i, ni+j), l);
+                                  }
+                                else
+                                  {
+                                    // a vanishing pivot, condense this one with pivoting
+                                    FlatMatrix<SCAL> ct = elmat.Rows(idofs).Cols(odofs) | lh;
+                                    FlatMatrix<SCAL> a = elmat.Rows(odofs).Cols(odofs) | lh;
+                                    ldinv = elmat.Rows(idofs).Cols(idofs);
+                                    CalcInverse (ldinv);
+                                    lhe = -ldinv * ct;
+                                    a += Trans(ct) * lhe;
+                                    elmat.Rows(odofs).Cols(odofs) = a;
+                                  }
+
+                                harmonicext->AddElementMatrix (ei.Nr(), idnums, ednums, lhe);
+                                innersolve->AddElementMatrix (ei.Nr(), idnums, idnums, ldinv);
+
+                                for (int d : idofs1)
+                                  dnums[d] = NO_DOF_NR;
+                                add_element (ei, dnums, elmat, true, lh);
+                              }
+                          }
+                        cb.Clear();
+                      };
+
+                    auto flush = [&] (LocalHeap & lh)
+                      {
+                        condense_batch (lh);
+                        scatter_batch (lh);
+                      };
+
+                    iterate
                       (*fespace, vb, clh,  [&] (FESpace::Element el, LocalHeap & lh)
                        {
                          if (elmat_ev && vb == VOL) 
@@ -1093,7 +1751,10 @@ namespace ngcomp
                                                        bfi.Name() + string("\n")));
                                    }
                                  
-                                 sum_elmat += elmat;
+                                 if (bfi.CacheElementMatrices())
+                                   sum_elmat += bfi.CacheFactor() * elmat;
+                                 else
+                                   sum_elmat += elmat;
                                }
                            }
                          else
@@ -1131,6 +1792,7 @@ namespace ngcomp
                                      if (!bfi.DefinedOnElement (el.Nr())) continue;                        
                                      
                                      elem_has_integrator = true;
+                                     if (bfi.CacheElementMatrices()) continue;
                                      
                                      try
                                        {
@@ -1144,6 +1806,35 @@ namespace ngcomp
                                        }
                                    }
                                }
+
+                             for (auto & cache : elmat_caches[vb])
+                               {
+                                 const BilinearFormIntegrator & bfi = *cache->bfi;
+                                 if (!bfi.DefinedOn (el.GetIndex())) continue;                        
+                                 if (!bfi.DefinedOnElement (el.Nr())) continue;                        
+
+                                 FlatMatrix<SCAL> cached(elmat_size, elmat_size, &cache->elmats[el.Nr()][0]);
+                                 if (!cache->computed.Test(el.Nr()))
+                                   {
+                                     bool done = false;
+                                     while (!done)
+                                       {
+                                         done = true;
+                                         cached = 0;
+                                         try
+                                           {
+                                             auto & mapped_trafo = eltrans.AddDeformation(bfi.GetDeformation().get(), lh);
+                                             bfi.CalcElementMatrixAdd (fel, mapped_trafo, cached, lh);
+                                           }
+                                         catch (ExceptionNOSIMD & e)
+                                           {
+                                             done = false;
+                                           }
+                                       }
+                                     cache->computed.Set(el.Nr());
+                                   }
+                                 sum_elmat += bfi.CacheFactor() * cached;
+                               }
                            }
                          } 
                          
@@ -1173,6 +1864,7 @@ namespace ngcomp
 
                          bool elim_only_hidden =
                            (!eliminate_internal) && eliminate_hidden && /* (lhdofs.Size() > 0)*/ has_hidden;
+                         bool condensed = false;
                          if ((vb == VOL || (!VB_parts[VOL].Size() && vb==BND) ) && (elim_only_hidden || eliminate_internal))
                            {
                              // if (!fespace->CouplingTypeArrayAvailable())
@@ -1210,6 +1902,20 @@ namespace ngcomp
                                  *testout << "idofs1 = " << idofs1 << endl;
                                }
                              
+                             size_t batch_mem = 4 * sizeof(typename CondensationLanes<SCAL>::TLANE)
+                               * sum_elmat.Height() * sum_elmat.Height();
+                             if (idofs1.Size() && condense_batched && !elim_only_hidden && !has_hidden &&
+                                 batch_mem < lh.Available())
+                               {
+                                 auto & cb = condbatches[TaskManager::GetThreadId()];
+                                 if (!cb.Fits (dnums, idofs1, odofs1))
+                                   condense_batch (lh);
+                                 cb.Append (el, dnums, idofs1, odofs1, sum_elmat);
+                                 if (cb.Size() == CondensationLanes<SCAL>::W)
+                                   condense_batch (lh);
+                                 return;
+                               }
+
                              if (idofs1.Size())
                                {
                                  HeapReset hr (lh);
@@ -1450,6 +2156,7 @@ namespace ngcomp
                                  
                                  for (int k = 0; k < idofs1.Size(); k++)
                                    dnums[idofs1[k]] = NO_DOF_NR;
+                                 condensed = true;
                                }
                            }
                          if (printelmat)
@@ -1457,21 +2164,11 @@ namespace ngcomp
                              lock_guard<mutex> guard(printelmat_mutex);
                              *testout<< "elem " << el << ", elmat = " << endl << sum_elmat << endl;
                            }
-                         
-                         AddElementMatrix (dnums, dnums, sum_elmat, el, lh);
-			 
-                         for (auto pre : preconditioners)
-                           pre -> AddElementMatrix (dnums, sum_elmat, el, lh);
 
-                         if (check_unused)
-                           {
-                             if (printelmat)
-                               *testout << "set these as useddof: " << dnums << endl;
-                             for (auto d : dnums)
-                               if (IsRegularDof(d)) useddof[d] = true;
-                           }
+                         add_element (el, dnums, sum_elmat, condensed, lh);
                          // timer3_VB[vb].Stop();
-                       });
+                       }, flush);
+                    assembling_uncolored = false;
                     progress.Done();
                     
                     /*
@@ -2248,6 +2945,7 @@ namespace ngcomp
                     }
               }
             
+            CompressCondensed();
             for (auto pre : preconditioners)
               pre -> FinalizeLevel(&GetMatrix());
 
@@ -2425,24 +3123,74 @@ namespace ngcomp
             if (keep_internal)
               {
                 cout << IM(1) << "compute internal element ... ";
-                
-                //Set u_inner to zero
-                for (int i = 0; i < ne; i++)
+
+                auto inner = dynamic_pointer_cast<ElementByElementMatrix<SCAL>> (GetInnerSolve());
+                auto ext = dynamic_pointer_cast<ElementByElementMatrix<SCAL>> (GetHarmonicExtension());
+                const BaseVector & rhs = linearform ? linearform->GetVector() : f;
+
+                if (inner && ext)
                   {
-                    HeapReset hr(clh);
-                    Array<int> dnums;
-                    fespace->GetDofNrs (ElementId(VOL,i), dnums, LOCAL_DOF);            
-                    FlatVector<SCAL> elu (dnums.Size(), clh);
-                    elu = 0.0;
-                    u.SetIndirect (dnums, elu);
+                    // one pass over the elements: u_i = A_ii^{-1} f_i + E_ie u_e
+                    // the rows are local dofs, the columns of E_ie are external dofs,
+                    // so the elements are independent
+                    static Timer tfused ("Compute Internal - fused");
+                    RegionTimer regfused (tfused);
+                    FlatVector<SCAL> fu = u.FV<SCAL>();
+                    FlatVector<SCAL> ff = rhs.FV<SCAL>();
+                    
+                    ParallelForRange
+                      (ne, [&] (IntRange r)
+                       {
+                         LocalHeap lh = clh.Split();
+                         Array<DofId> dnums;
+                         for (size_t i : r)
+                           {
+                             HeapReset hr(lh);
+                             fespace->GetDofNrs (ElementId(VOL,i), dnums, LOCAL_DOF);
+                             FlatVector<SCAL> elu (dnums.Size(), lh);
+                             elu = 0.0;
+                             u.SetIndirect (dnums, elu);
+
+                             FlatArray<int> irows = inner->GetElementRowDNums(i);
+                             FlatArray<int> icols = inner->GetElementColumnDNums(i);
+                             if (irows.Size() && icols.Size() && irows[0] != -1)
+                               {
+                                 FlatVector<SCAL> hf = ff(icols) | lh;
+                                 FlatVector<SCAL> hu(irows.Size(), lh);
+                                 hu = 0.0;
+                                 inner->MultAddElement (i, 1.0, hf, hu);
+                                 fu(irows) += hu;
+                               }
+
+                             FlatArray<int> erows = ext->GetElementRowDNums(i);
+                             FlatArray<int> ecols = ext->GetElementColumnDNums(i);
+                             if (erows.Size() && ecols.Size() && erows[0] != -1 && ecols[0] != -1)
+                               {
+                                 FlatVector<SCAL> hu = fu(ecols) | lh;
+                                 FlatVector<SCAL> hv(erows.Size(), lh);
+                                 hv = 0.0;
+                                 ext->MultAddElement (i, 1.0, hu, hv);
+                                 fu(erows) += hv;
+                               }
+                           }
+                       });
                   }
-                
-                if (linearform)
-                  u += *GetInnerSolve() * linearform->GetVector();
                 else
-                  u += *GetInnerSolve() * f;
-                
-                u += *GetHarmonicExtension() * u;
+                  {
+                    //Set u_inner to zero
+                    for (int i = 0; i < ne; i++)
+                      {
+                        HeapReset hr(clh);
+                        Array<int> dnums;
+                        fespace->GetDofNrs (ElementId(VOL,i), dnums, LOCAL_DOF);            
+                        FlatVector<SCAL> elu (dnums.Size(), clh);
+                        elu = 0.0;
+                        u.SetIndirect (dnums, elu);
+                      }
+                    
+                    u += *GetInnerSolve() * rhs;
+                    u += *GetHarmonicExtension() * u;
+                  }
                 cout << IM(1) << endl;
               }
             else
@@ -2582,6 +3330,8 @@ namespace ngcomp
 
     if (this->mats.Size() < this->ma->GetNLevels())
       AllocateMatrix();
+    else if (harmonicext && harmonicext->IsCompressed())
+      AllocateInternalMatrices();  // compressed matrices take no new element matrices
 
     // timestamp = ++global_timestamp;
     timestamp = GetNextTimeStamp();
@@ -2634,6 +3384,9 @@ namespace ngcomp
         mat = 0.0;
       
         cout << IM(3) << "Assemble linearization" << endl;
+
+        if (linearization_plan)
+          UpdateLinearizationPlan();
       
         Array<int> dnums;
 
@@ -2669,7 +3422,10 @@ namespace ngcomp
                  ElementTransformation & eltrans = ma->GetTrafo (el, lh);
                  
                  Array<int> dnums(fel.GetNDof(), lh);
-                 fespace->GetDofNrs (el, dnums);
+                 if (linearization_plan)
+                   dnums = plan_dnums[vb][el.Nr()];
+                 else
+                   fespace->GetDofNrs (el, dnums);
                  
                  if(fel.GetNDof() != dnums.Size())
                    {
@@ -3141,6 +3897,7 @@ namespace ngcomp
              << ", unused = " << useddof.Size()-cntused
              << ", total = " << useddof.Size() << endl;
 
+        CompressCondensed();
         for (int j = 0; j < preconditioners.Size(); j++)
           preconditioners[j] -> FinalizeLevel(&GetMatrix());
       }
@@ -3602,6 +4359,13 @@ namespace ngcomp
                  [&] (FESpace::Element el, LocalHeap & lh)
                  {
                    // ThreadRegionTimer reg (timer_loop, TaskManager::GetThreadId());                   
+                   // skip elements masked out for all integrators (local time stepping)
+                   bool active = false;
+                   for (auto & bfi : VB_parts[vb])
+                     if (bfi->DefinedOn (el.GetIndex()) && bfi->DefinedOnElement (el.Nr()))
+                       active = true;
+                   if (!active) return;
+
                    auto & fel = el.GetFE();
                    auto & trafo = el.GetTrafo();
                    auto dnums = el.GetDofs();
@@ -3670,6 +4434,9 @@ namespace ngcomp
                     // throw Exception ("skeleton-form needs \"dgjumps\" : True flag for FESpace");
 
                     // facet-loop
+          // MPI is called from the master thread only, not within the loops
+          bool mpi_parallel = MyMPI_GetNTasks() > 1;
+
           if ( (facetwise_skeleton_parts[VOL].Size() > 0) ||
                (facetwise_skeleton_parts[BND].Size() > 0) )
             
@@ -3714,7 +4481,7 @@ namespace ngcomp
                        if(elnums.Size() < 2)
                          {
 #ifdef PARALLEL
-			   if( (ma->GetDistantProcs (NodeId(StdNodeType(NT_FACET, ma->GetDimension()), facet)).Size() > 0) && (MyMPI_GetNTasks()>1) )
+			   if( (ma->GetDistantProcs (NodeId(StdNodeType(NT_FACET, ma->GetDimension()), facet)).Size() > 0) && mpi_parallel )
 			     continue;
 #endif
                            facet2 = ma->GetPeriodicFacet(facet);
@@ -3821,6 +4588,11 @@ namespace ngcomp
                {
                  {
                    int el1 = ei1.Nr();
+                   bool active = false;
+                   for (auto & bfi : elementwise_skeleton_parts)
+                     if (bfi->DefinedOnElement (el1)) active = true;
+                   if (!active) return;
+
                    Array<int> elnums(2, lh), elnums_per(2, lh), fnums1(6, lh), fnums2(6, lh),
                      vnums1(8, lh), vnums2(8, lh);
                    // RegionTimer reg1(timerDG1);
@@ -3836,7 +4608,7 @@ namespace ngcomp
                        ma->GetFacetElements(facet,elnums);
                        if (elnums.Size()<2) {
 #ifdef PARALLEL
-			 if( (ma->GetDistantProcs (NodeId(StdNodeType(NT_FACET, ma->GetDimension()), fnums1[facnr1])).Size() > 0) && (MyMPI_GetNTasks()>1) )
+			 if( (ma->GetDistantProcs (NodeId(StdNodeType(NT_FACET, ma->GetDimension()), fnums1[facnr1])).Size() > 0) && mpi_parallel )
 			   continue;
 #endif
                          facet2 = ma->GetPeriodicFacet(fnums1[facnr1]);
@@ -4445,6 +5217,74 @@ namespace ngcomp
   }
 
 
+  template <class SCAL>
+  double S_BilinearForm<SCAL> :: ApplyEnergy (const BaseVector & x, BaseVector & y,
+                                              LocalHeap & lh) const
+  {
+    // one loop for the element terms only, facet terms and special
+    // elements go through the separate loops
+    bool single_loop = !is_same<SCAL,Complex>::value && !MixedSpaces()
+      && !dynamic_pointer_cast<TPHighOrderFESpace>(fespace)
+      && !facetwise_skeleton_parts[0].Size() && !facetwise_skeleton_parts[1].Size()
+      && !elementwise_skeleton_parts.Size() && !fespace->specialelements.Size();
+    if (!single_loop)
+      return BilinearForm::ApplyEnergy (x, y, lh);
+
+    static Timer t("BilinearForm::ApplyEnergy"); RegionTimer reg(t);
+
+    y = 0;
+    atomic<double> energy(0.0);
+
+    for (auto vb : { VOL, BND, BBND, BBBND })
+      if (VB_parts[vb].Size())
+        IterateElements 
+          (*fespace, vb, lh, 
+           [&] (FESpace::Element el, LocalHeap & lh)
+           {
+             bool active = false;
+             for (auto & bfi : VB_parts[vb])
+               if (bfi->DefinedOn (el.GetIndex()) && bfi->DefinedOnElement (el.Nr()))
+                 active = true;
+             if (!active) return;
+
+             auto & fel = el.GetFE();
+             auto & trafo = el.GetTrafo();
+             auto dnums = el.GetDofs();
+             
+             FlatVector<SCAL> elvecx (dnums.Size() * fespace->GetDimension(), lh);
+             FlatVector<SCAL> elvecy (dnums.Size() * fespace->GetDimension(), lh);
+             
+             x.GetIndirect (dnums, elvecx);
+             fespace->TransformVec (el, elvecx, TRANSFORM_SOL);
+
+             double energy_T = 0;
+             for (auto & bfi : VB_parts[vb])
+               {
+                 if (!bfi->DefinedOn (el.GetIndex())) continue;
+                 if (!bfi->DefinedOnElement (el.Nr())) continue;
+                 
+                 auto & mapped_trafo = trafo.AddDeformation(bfi->GetDeformation().get(), lh);
+                 bfi->ApplyElementMatrix (fel, mapped_trafo, elvecx, elvecy, 0, lh);
+
+                 // symbolic (non-energy) forms have the energy 1/2 x^T A x,
+                 // which comes with the application for free
+                 if (dynamic_cast<const SymbolicBilinearFormIntegrator*> (bfi.get()))
+                   energy_T += 0.5 * std::real (InnerProduct (elvecx, elvecy));
+                 else
+                   energy_T += bfi->Energy (fel, mapped_trafo, elvecx, lh);
+
+                 fespace->TransformVec (el, elvecy, TRANSFORM_RHS);
+                 y.AddIndirect (dnums, elvecy, fespace->HasAtomicDofs());
+               }
+             energy += energy_T;
+           });
+#ifdef PARALLEL
+    y.SetParallelStatus(DISTRIBUTED);
+#endif
+    return energy;
+  }
+
+
   template <class SCAL>
   void S_BilinearForm<SCAL> :: 
   AddDiagElementMatrix (const Array<int> & dnums1,
@@ -4505,10 +5345,13 @@ namespace ngcomp
     if (this->mats.Size() == this->ma->GetNLevels())
       return;
 
-    MatrixGraph * graph = this->GetGraph (this->ma->GetNLevels()-1, false);
+    auto graph = this->GetSharedGraph (this->ma->GetNLevels()-1, false);
 
-    auto spmat = make_shared<SparseMatrix<TM,TV,TV>> (*graph, 1);
+    // a cached graph is copied, a private one is stolen
+    auto spmat = make_shared<SparseMatrix<TM,TV,TV>> (*graph, graph.use_count() == 1);
     mymatrix = spmat.get();
+    if (this->use_scattermap && !this->fespace2)
+      this->CalcScatterMap (*spmat, false);
     
     if (this->spd) spmat->SetSPD();
     shared_ptr<BaseMatrix> mat = spmat;
@@ -4520,8 +5363,6 @@ namespace ngcomp
 #endif
     this->mats.Append (mat);
 
-    delete graph;
-
     if (!this->multilevel || this->low_order_bilinear_form)
       for (int i = 0; i < this->mats.Size()-1; i++)
         this->mats[i].reset();
@@ -4597,7 +5438,12 @@ namespace ngcomp
                     ElementId id,
                     LocalHeap & lh) 
   {
-    mymatrix -> TMATRIX::AddElementMatrix (dnums1, dnums2, elmat, this->fespace->HasAtomicDofs());
+    bool use_atomic = this->fespace->HasAtomicDofs() || this->assembling_uncolored;
+    if (this->HasScatterMap (id, dnums1, dnums2))
+      mymatrix -> TMATRIX::AddElementMatrixIndexed (dnums1, dnums2, this->scatter_positions[id.Nr()],
+                                                    elmat, use_atomic);
+    else
+      mymatrix -> TMATRIX::AddElementMatrix (dnums1, dnums2, elmat, use_atomic);
   }
 
 
@@ -4643,10 +5489,13 @@ namespace ngcomp
     if (this->mats.Size() == this->ma->GetNLevels())
       return;
 
-    MatrixGraph * graph = this->GetGraph (this->ma->GetNLevels()-1, true);
+    auto graph = this->GetSharedGraph (this->ma->GetNLevels()-1, true);
 
-    auto spmat = make_shared<SparseMatrixSymmetric<TM,TV>> (*graph, 1);
+    // a cached graph is copied, a private one is stolen
+    auto spmat = make_shared<SparseMatrixSymmetric<TM,TV>> (*graph, graph.use_count() == 1);
     mymatrix = spmat.get();
+    if (this->use_scattermap && !this->fespace2)
+      this->CalcScatterMap (*spmat, true);
     
     if (this->spd) spmat->SetSPD();
     shared_ptr<BaseMatrix> mat = spmat;
@@ -4657,8 +5506,6 @@ namespace ngcomp
 #endif
     this->mats.Append (mat);
 
-    delete graph;
-
     if (!this->multilevel || this->low_order_bilinear_form)
       for (int i = 0; i < this->mats.Size()-1; i++)
         this->mats[i].reset();
@@ -4707,7 +5554,12 @@ namespace ngcomp
                     ElementId id, 
                     LocalHeap & lh) 
   {
-    mymatrix -> TMATRIX::AddElementMatrixSymmetric (dnums1, elmat, this->fespace->HasAtomicDofs());
+    bool use_atomic = this->fespace->HasAtomicDofs() || this->assembling_uncolored;
+    if (this->HasScatterMap (id, dnums1, dnums2))
+      mymatrix -> TMATRIX::AddElementMatrixIndexed (dnums1, dnums1, this->scatter_positions[id.Nr()],
+                                                    elmat, use_atomic);
+    else
+      mymatrix -> TMATRIX::AddElementMatrixSymmetric (dnums1, elmat, use_atomic);
   }
 
 
@@ -103,6 +103,33 @@ namespace ngcomp
     Array<void*> precomputed_data;
     /// output of norm of matrix entries
     bool checksum;
+    /// keep the volume element matrices for ReassembleRegion
+    bool store_elmats = false;
+    /// assemble without element coloring, using atomic adds
+    bool atomic_assembly = false;
+    /// element matrices a thread collects before scattering them (0 = no batching)
+    int pipeline_batch = 0;
+    /// static condensation of symmetric forms by LDL^t, over elements in SIMD lanes
+    bool batch_condense = false;
+    /// compress the ebe-matrices of static condensation after assembly
+    bool compress_condensed = false;
+    /// ... with equal element matrices stored once
+    bool compress_condensed_share = false;
+    /// ... in float storage for the SIMD groups
+    bool compress_condensed_single = false;
+    /// the running assembly loop is not colored
+    bool assembling_uncolored = false;
+    /// precompute matrix positions of the volume element matrices
+    bool use_scattermap = false;
+    /// keep element dofs and matrix positions between calls of AssembleLinearization
+    bool linearization_plan = false;
+    /// element dofs of the linearization plan, for every VorB
+    Table<int> plan_dnums[4];
+    /// number of dofs the linearization plan was built for
+    size_t plan_ndof = 0;
+    /// dofs and matrix positions of the volume elements
+    Table<int> scatter_dnums;
+    Table<int> scatter_positions;
 
   public:
     /// generate a bilinear-form
@@ -181,6 +208,34 @@ namespace ngcomp
     /// generates matrix graph
     virtual MatrixGraph * GetGraph (int level, bool symmetric);
 
+    /// matrix graph, shared with other forms on the same space until it is updated
+    shared_ptr<MatrixGraph> GetSharedGraph (int level, bool symmetric);
+
+    /// assemble vb-elements without coloring ? 
+    bool UseUncoloredAssembly (VorB vb) const;
+
+    /// computes the matrix positions of all volume element matrices
+    void CalcScatterMap (const MatrixGraph & graph, bool symmetric);
+
+    /// builds the element dof tables used by AssembleLinearization,
+    /// if the space has changed since the last call
+    void UpdateLinearizationPlan ();
+
+    /// are the precomputed positions valid for these dofs ?
+    bool HasScatterMap (ElementId id, FlatArray<int> dnums1, FlatArray<int> dnums2) const
+    {
+      if (id.VB() != VOL || id.Nr() >= scatter_dnums.Size()) return false;
+      FlatArray<int> eldnums = scatter_dnums[id.Nr()];
+      if (dnums1.Size() != eldnums.Size() || dnums2.Size() != eldnums.Size()) return false;
+      for (size_t i = 0; i < eldnums.Size(); i++)
+        {
+          // condensed dofs are replaced by NO_DOF_NR
+          if (dnums1[i] != dnums2[i]) return false;
+          if (IsRegularDof(dnums1[i]) && dnums1[i] != eldnums[i]) return false;
+        }
+      return true;
+    }
+
     /// assembles the matrix
     void Assemble (LocalHeap & lh);
 
@@ -188,6 +243,11 @@ namespace ngcomp
     /// if reallocate is false, the existing matrix is reused
     void ReAssemble (LocalHeap & lh, bool reallocate = 0);
 
+    /// recomputes the volume elements in domains, and replaces their old
+    /// contributions by the new ones. Needs flag "store_elmats"
+    virtual void ReassembleRegion (const BitArray & domains, LocalHeap & lh)
+    { throw Exception ("ReassembleRegion not available for this bilinear-form"); }
+
     /// assembles matrix at linearization point given by lin
     /// needed for Newton's method
     virtual void AssembleLinearization (const BaseVector & lin,
@@ -227,6 +287,14 @@ namespace ngcomp
     /// evaulates internal energy (usually  1/2 x^T A x)
     virtual double Energy (const BaseVector & x, LocalHeap & lh) const = 0;
 
+    /// y = A(x), returns the energy of x. One element loop for both
+    /// where the form allows it, as needed by line searches
+    virtual double ApplyEnergy (const BaseVector & x, BaseVector & y, LocalHeap & lh) const
+    {
+      ApplyMatrix (x, y, lh);
+      return Energy (x, lh);
+    }
+
     /// returns the assembled matrix
     const BaseMatrix & GetMatrix () const { return *mats.Last(); }
     const BaseMatrix & GetMatrix (int level) const { return *mats[level]; }
@@ -412,6 +480,18 @@ namespace ngcomp
     shared_ptr<BaseMatrix> harmonicexttrans; //  = NULL;
     shared_ptr<ElementByElementMatrix<SCAL>> innersolve; //  = NULL;
     shared_ptr<ElementByElementMatrix<SCAL>> innermatrix; //  = NULL;
+    /// volume element matrices of the last assembly, for ReassembleRegion
+    shared_ptr<ElementByElementMatrix<SCAL>> elmat_store;
+
+    /// element matrices of integrators with CacheElementMatrices
+    struct ElementMatrixCache
+    {
+      shared_ptr<BilinearFormIntegrator> bfi;
+      size_t ndof;
+      Table<SCAL> elmats;
+      BitArray computed;
+    };
+    Array<shared_ptr<ElementMatrixCache>> elmat_caches[4];
 
 #ifdef PARALLEL
     //data for mpi-facets; only has data if there are relevant integrators in the BLF!
@@ -454,6 +534,11 @@ namespace ngcomp
 
     ~S_BilinearForm();
 
+  protected:
+    /// compresses harmonicext, harmonicexttrans, innersolve and innermatrix
+    void CompressCondensed ();
+  public:
+
     ///
     void AddMatrix1 (SCAL val, const BaseVector & x,
                     BaseVector & y, LocalHeap & lh) const;
@@ -503,6 +588,8 @@ namespace ngcomp
 
     virtual double Energy (const BaseVector & x, LocalHeap & lh) const;
 
+    virtual double ApplyEnergy (const BaseVector & x, BaseVector & y, LocalHeap & lh) const;
+
     virtual void ComputeInternal (BaseVector & u, const BaseVector & f, LocalHeap & lh) const;
 
     virtual void ModifyRHS (BaseVector & fd) const;
@@ -510,6 +597,11 @@ namespace ngcomp
     ///
     virtual void DoAssemble (LocalHeap & lh);
     ///
+    virtual void ReassembleRegion (const BitArray & domains, LocalHeap & lh) override;
+
+    /// matches elmat_caches to the cached integrators and the current space
+    void UpdateElementMatrixCaches (LocalHeap & lh);
+    ///
     // virtual void DoAssembleIndependent (BitArray & useddof, LocalHeap & lh);
     ///
     virtual void AssembleLinearization (const BaseVector & lin,
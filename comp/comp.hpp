@@ -80,5 +80,11 @@ namespace ngcomp
 #include "hypre_precond.hpp"
 #include "hypre_ams_precond.hpp"
 #include "vtkoutput.hpp"
+#include "xdmfoutput.hpp"
+#include "probes.hpp"
+#include "timestepping.hpp"
+#include "newton.hpp"
+#include "meshtransfer.hpp"
+#include "cuda_assembly.hpp"
 
 #endif
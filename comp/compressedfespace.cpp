@@ -15,6 +15,8 @@ namespace ngcomp
       integrator[vb] = space->GetIntegrator(vb);
     }
     iscomplex = space->IsComplex();
+    // assembly then reads the compressed dofs instead of mapping them per element
+    use_dof_tables = true;
   }
 
   void CompressedFESpace::Update(LocalHeap & lh)
@@ -23,44 +25,139 @@ namespace ngcomp
 
     const int ndofall = space->GetNDof();
     all2comp.SetSize(ndofall);
-    comp2all.SetSize(ndofall);
 
     if (active_dofs && active_dofs->Size() != ndofall)
       throw Exception("active_dofs size doesn't match FESpace (anymore?).");
 
-    int ndof = 0;
-    for (int i : Range(ndofall))
-    {
-      if (   (   active_dofs  && (active_dofs->Test(i))) 
-          || ( (!active_dofs) && ((space->GetDofCouplingType(i) & VISIBLE_DOF))))
+    auto is_active = [&] (size_t i) -> bool
       {
-        comp2all[ndof] = i;
-        all2comp[i] = ndof++;
-      }
-      else
+        if (active_dofs) return active_dofs->Test(i);
+        return space->GetDofCouplingType(i) & VISIBLE_DOF;
+      };
+
+    // compressed numbers by a prefix sum over the active flags
+    Array<DofId> first(ndofall);
+    ParallelFor (ndofall, [&] (size_t i) { first[i] = is_active(i) ? 1 : 0; });
+    DofId ndof = ParallelPrefixSum (first, DofId(0));
+
+    comp2all.SetSize(ndof);
+    ParallelFor (ndofall, [&] (size_t i)
       {
-        // all2comp[i] = -1;
-        if (space->GetDofCouplingType(i) == HIDDEN_DOF)
+        DofId next = (i+1 < ndofall) ? first[i+1] : ndof;
+        if (next > first[i])
+          {
+            comp2all[first[i]] = i;
+            all2comp[i] = first[i];
+          }
+        else if (space->GetDofCouplingType(i) == HIDDEN_DOF)
           all2comp[i] = NO_DOF_NR_CONDENSE;
         else
           all2comp[i] = NO_DOF_NR;
-      }
-    }
-    comp2all.SetSize(ndof);
+      });
+    ReorderDofs (lh);
 
     ctofdof.SetSize(ndof);
-    for (int i : Range(ndof))
-      ctofdof[i] = space->GetDofCouplingType(comp2all[i]);
-
+    ParallelFor (ndof, [&] (size_t i)
+      { ctofdof[i] = space->GetDofCouplingType(comp2all[i]); });
 
-    (*testout) << "dof mapping of the wrapper space:" << endl;
-    for (int i : Range(ndof))
-      (*testout) << i << " -> " << comp2all[i] << endl;
+    if (print)
+      {
+        (*testout) << "dof mapping of the wrapper space:" << endl;
+        for (int i : Range(ndof))
+          (*testout) << i << " -> " << comp2all[i] << endl;
+      }
 
     SetNDof(ndof);
     FESpace::FinalizeUpdate (lh);
   }
 
+  void ReorderedFESpace::ReorderDofs (LocalHeap & lh)
+  {
+    static Timer t("ReorderedFESpace::ReorderDofs"); RegionTimer reg(t);
+    size_t ndof = comp2all.Size();
+
+    // elements of both volume and boundary couple dofs
+    auto create_el2dof = [&] (VorB vb)
+      {
+        return ParallelCreateTable<int>
+          (ma->GetNE(vb), [&] (ParallelTableCreator<int> & creator, size_t nr)
+           {
+             ElementId ei(vb, nr);
+             if (!space->DefinedOn (ei)) return;
+             ArrayMem<DofId,100> dnums;
+             space->GetDofNrs (ei, dnums);
+             for (auto d : dnums)
+               if (IsRegularDof(d) && IsRegularDof(all2comp[d]))
+                 creator.Add (nr, all2comp[d]);
+           }, ma->GetNE(vb));
+      };
+    Table<int> voldofs = create_el2dof(VOL);
+    Table<int> bnddofs = create_el2dof(BND);
+
+    size_t nvol = voldofs.Size();
+    auto eldofs = [&] (size_t el) -> FlatArray<int>
+      { return (el < nvol) ? voldofs[el] : bnddofs[el-nvol]; };
+
+    Table<int> dof2el = ParallelCreateTable<int>
+      (nvol+bnddofs.Size(), [&] (ParallelTableCreator<int> & creator, size_t el)
+       {
+         for (auto d : eldofs(el))
+           creator.Add (d, el);
+       }, ndof);
+
+    // degree of a dof, estimated by the sizes of its elements
+    Array<size_t> degree(ndof);
+    ParallelFor (ndof, [&] (size_t d)
+                 {
+                   size_t deg = 0;
+                   for (auto el : dof2el[d])
+                     deg += eldofs(el).Size();
+                   degree[d] = deg;
+                 });
+
+    // Cuthill-McKee: breadth first search starting from a dof of minimal
+    // degree, neighbours enter the queue by increasing degree
+    Array<int> order;
+    order.SetAllocSize (ndof);
+    BitArray visited(ndof);
+    visited.Clear();
+    Array<int> startcand(ndof);
+    for (size_t i = 0; i < ndof; i++) startcand[i] = i;
+    QuickSortI (degree, startcand);
+    size_t next_start = 0;
+
+    while (order.Size() < ndof)
+      {
+        while (visited.Test(startcand[next_start])) next_start++;
+        int start = startcand[next_start];
+        visited.Set(start);
+        order.Append (start);
+
+        for (size_t qi = order.Size()-1; qi < order.Size(); qi++)
+          {
+            size_t first_new = order.Size();
+            for (auto el : dof2el[order[qi]])
+              for (auto d : eldofs(el))
+                if (!visited.Test(d))
+                  {
+                    visited.Set(d);
+                    order.Append (d);
+                  }
+            FlatArray<int> newdofs = order.Range(first_new, order.Size());
+            QuickSort (newdofs, [&] (int a, int b) { return degree[a] < degree[b]; });
+          }
+      }
+
+    // reverse the order, and apply it to the compressed numbering
+    Array<DofId> oldcomp2all(comp2all);
+    for (size_t i = 0; i < ndof; i++)
+      {
+        DofId dall = oldcomp2all[order[ndof-1-i]];
+        comp2all[i] = dall;
+        all2comp[dall] = i;
+      }
+  }
+
   FiniteElement & CompressedFESpace::GetFE (ElementId ei, Allocator & lh) const
   {
     return space->GetFE(ei,lh);
@@ -68,10 +165,20 @@ namespace ngcomp
 
   void CompressedFESpace::GetDofNrs (ElementId ei, Array<DofId> & dnums) const
   {
+    if (HasDofTable(ei.VB()))
+      {
+        dnums = dof_tables[ei.VB()][ei.Nr()];
+        return;
+      }
     space->GetDofNrs(ei,dnums);
     WrapDofs(dnums);
   }
 
+  shared_ptr<BaseMatrix> CompressedFESpace::GetEmbedding () const
+  {
+    return make_shared<IndexedEmbedding> (comp2all, space->GetNDof(), space->IsComplex());
+  }
+
   void CompressedFESpace::GetElementDofsOfType (ElementId ei, Array<DofId> & dnums, COUPLING_TYPE ctype) const
   {
     space->GetElementDofsOfType(ei,dnums,ctype);
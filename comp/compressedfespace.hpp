@@ -18,12 +18,19 @@ namespace ngcomp
 
     //TODO: flag to hide HIDDEN_DOFs
 
+    /// called by Update after comp2all and all2comp are set up
+    virtual void ReorderDofs (LocalHeap & lh) { ; }
+
   public:
     CompressedFESpace (shared_ptr<FESpace> bfes);
     virtual ~CompressedFESpace () {};
     virtual void Update(LocalHeap & lh) override;
     shared_ptr<FESpace> GetBaseSpace() const { return space; }
 
+    /// maps vectors of this space into vectors of the base space, the
+    /// transpose restricts base vectors to the compressed dofs
+    shared_ptr<BaseMatrix> GetEmbedding () const;
+
     void WrapDofs(Array<DofId> & dnums) const
     {
       /*
@@ -100,4 +107,25 @@ namespace ngcomp
 
   };
 
+
+  /**
+     Wrapper space with all visible dofs of the base space, renumbered by
+     reverse Cuthill-McKee for small bandwidth and better cache locality
+     of sparse matrix operations. Grid-functions on the wrapper space use
+     the same numbering, so vectors stay consistent without extra
+     permutations.
+   */
+  class ReorderedFESpace : public CompressedFESpace
+  {
+  protected:
+    virtual void ReorderDofs (LocalHeap & lh) override;
+  public:
+    ReorderedFESpace (shared_ptr<FESpace> bfes) : CompressedFESpace (bfes) { ; }
+
+    virtual string GetClassName () const override
+    {
+      return "ReorderedFESpace(" + space->GetClassName() + ")";
+    }
+  };
+
 }
@@ -0,0 +1,448 @@
+#ifdef CUDA
+/*********************************************************************/
+/* File:   cuda_assembly.cpp                                         */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+
+#include <comp.hpp>
+
+extern void DevScatterAdd (int n, double s, const int * pos, const double * elvals, double * vals);
+extern void DevGather (int n, const int * pos, const double * vals, double * elvals);
+extern void DevGeomFactors (int nel, int nip, int D, const double * g, const double * u, double * v);
+extern void DevElementDiagonal (int nel, int nip, int D, int ndof,
+                                const double * b, const double * g, double * diag);
+
+
+namespace ngcomp
+{
+
+  /// elements of one integrator with the same type, dofs and points
+  struct DevBilinearFormAssembly::Block
+  {
+    shared_ptr<SymbolicBilinearFormIntegrator> bfi;
+    ELEMENT_TYPE et;
+    int ndof, nip;
+    /// rows of the B matrices, nip * proxy dimension
+    int nrows;
+    Array<int> elnrs;
+
+    unique_ptr<DevBatchMatrix<double>> btrial, btest, d, elmats;
+    unique_ptr<DevBatchMatrix<int>> pos;
+  };
+
+
+  DevBilinearFormAssembly :: DevBilinearFormAssembly (shared_ptr<BilinearForm> abfa,
+                                                      LocalHeap & clh)
+    : bfa(abfa)
+  {
+    static Timer t("DevBilinearFormAssembly"); RegionTimer reg(t);
+
+    auto fes = bfa->GetFESpace();
+    auto ma = fes->GetMeshAccess();
+
+    if (bfa->UsesEliminateInternal())
+      throw Exception ("DevBilinearFormAssembly: static condensation is not supported");
+    auto mat = dynamic_pointer_cast<SparseMatrix<double>> (bfa->GetMatrixPtr());
+    if (!mat || dynamic_pointer_cast<SparseMatrixSymmetric<double>> (mat))
+      throw Exception ("DevBilinearFormAssembly: needs a non-symmetric real sparse matrix");
+
+    Array<shared_ptr<SymbolicBilinearFormIntegrator>> parts;
+    for (auto & bfi : bfa->Integrators())
+      {
+        auto sbfi = dynamic_pointer_cast<SymbolicBilinearFormIntegrator> (bfi);
+        if (!sbfi || bfi->VB() != VOL || bfi->SkeletonForm() || !sbfi->HasDiagonalFactorization())
+          throw Exception ("DevBilinearFormAssembly: integrator "+bfi->Name()+" is not supported");
+        parts.Append (sbfi);
+      }
+
+    // sort the elements into blocks of equal sizes
+    for (auto & bfi : parts)
+      {
+        int dim = bfi->FactorizationDim();
+        for (auto i : Range(ma->GetNE(VOL)))
+          {
+            HeapReset hr(clh);
+            ElementId ei(VOL, i);
+            if (!fes->DefinedOn (ei) || !bfi->DefinedOn (ma->GetElIndex(ei))) continue;
+            const FiniteElement & fel = fes->GetFE (ei, clh);
+            int nip = bfi->GetIntegrationRule (fel, clh).Size();
+
+            shared_ptr<Block> block;
+            for (auto & b : blocks)
+              if (b->bfi == bfi && b->et == fel.ElementType() &&
+                  b->ndof == fel.GetNDof() && b->nip == nip)
+                block = b;
+            if (!block)
+              {
+                block = make_shared<Block>();
+                block->bfi = bfi;
+                block->et = fel.ElementType();
+                block->ndof = fel.GetNDof();
+                block->nip = nip;
+                block->nrows = nip*dim;
+                blocks.Append (block);
+              }
+            block->elnrs.Append (i);
+          }
+      }
+
+    // B matrices and positions in the matrix, they are uploaded once
+    for (auto & block : blocks)
+      {
+        int nel = block->elnrs.Size();
+        int nrows = block->nrows, ndof = block->ndof;
+        auto & bfi = *block->bfi;
+
+        Matrix<double> hbtrial(nel*nrows, ndof), hbtest(nel*nrows, ndof);
+        Matrix<int> hpos(nel*ndof, ndof);
+
+        ParallelForRange
+          (IntRange(nel), [&] (IntRange r)
+           {
+             LocalHeap lh = clh.Split();
+             Array<DofId> dnums;
+             for (auto k : r)
+               {
+                 HeapReset hr(lh);
+                 ElementId ei(VOL, block->elnrs[k]);
+                 const FiniteElement & fel = fes->GetFE (ei, lh);
+                 auto & trafo = ma->GetTrafo (ei, lh).AddDeformation (bfi.GetDeformation().get(), lh);
+                 auto & mir = trafo (bfi.GetIntegrationRule (fel, lh), lh);
+
+                 auto btrial = hbtrial.Rows (k*nrows, (k+1)*nrows);
+                 auto btest = hbtest.Rows (k*nrows, (k+1)*nrows);
+                 bfi.CalcFactorizationB (fel, mir, btrial, btest, lh);
+                 fes->TransformMat (ei, btrial, TRANSFORM_MAT_RIGHT);
+                 fes->TransformMat (ei, btest, TRANSFORM_MAT_RIGHT);
+
+                 fes->GetDofNrs (ei, dnums);
+                 auto pos = hpos.Rows (k*ndof, (k+1)*ndof);
+                 for (auto i : Range(dnums))
+                   for (auto j : Range(dnums))
+                     pos(i,j) = (IsRegularDof(dnums[i]) && IsRegularDof(dnums[j])) ?
+                       int(mat->GetPosition (dnums[i], dnums[j])) : -1;
+               }
+           });
+
+        block->btrial = make_unique<DevBatchMatrix<double>> (nel, hbtrial);
+        block->btest = make_unique<DevBatchMatrix<double>> (nel, hbtest);
+        block->pos = make_unique<DevBatchMatrix<int>> (nel, hpos);
+        block->d = make_unique<DevBatchMatrix<double>> (nel, nrows, 1);
+        block->elmats = make_unique<DevBatchMatrix<double>> (nel, ndof, ndof);
+
+        cout << IM(3) << "device assembly block " << block->et << ", ndof = " << ndof
+             << ", nip = " << block->nip << ", elements = " << nel << endl;
+      }
+
+    devmat = make_shared<DevSparseMatrix> (*mat);
+  }
+
+
+  DevBilinearFormAssembly :: ~DevBilinearFormAssembly () { ; }
+
+
+  void DevBilinearFormAssembly :: Assemble (LocalHeap & clh)
+  {
+    static Timer t("DevBilinearFormAssembly::Assemble"); RegionTimer reg(t);
+    static Timer td("DevBilinearFormAssembly::Assemble - D");
+
+    auto fes = bfa->GetFESpace();
+    auto ma = fes->GetMeshAccess();
+
+    cudaMemset (devmat->DevValues(), 0, devmat->NZE()*sizeof(double));
+
+    for (auto & block : blocks)
+      {
+        int nel = block->elnrs.Size();
+        int nrows = block->nrows, ndof = block->ndof;
+        auto & bfi = *block->bfi;
+
+        // compiled coefficient functions are host code, only D is uploaded
+        Matrix<double> hd(nel, nrows);
+        td.Start();
+        ParallelForRange
+          (IntRange(nel), [&] (IntRange r)
+           {
+             LocalHeap lh = clh.Split();
+             for (auto k : r)
+               {
+                 HeapReset hr(lh);
+                 ElementId ei(VOL, block->elnrs[k]);
+                 const FiniteElement & fel = fes->GetFE (ei, lh);
+                 auto & trafo = ma->GetTrafo (ei, lh).AddDeformation (bfi.GetDeformation().get(), lh);
+                 auto & mir = trafo (bfi.GetIntegrationRule (fel, lh), lh);
+                 bfi.CalcFactorizationD (mir, hd.Row(k), lh);
+               }
+           });
+        td.Stop();
+        *block->d = hd;
+
+        cudaMemset (block->elmats->Data(), 0, nel*ndof*ndof*sizeof(double));
+        ngs_cuda::AddAtDBBatched (*block->btest, *block->d, *block->btrial, *block->elmats);
+        DevScatterAdd (nel*ndof*ndof, 1, block->pos->Data(), block->elmats->Data(), devmat->DevValues());
+      }
+  }
+
+
+
+
+
+  /// elements of one integrator sharing the reference table
+  struct DevMatrixFreeOperator::Block
+  {
+    shared_ptr<SymbolicBilinearFormIntegrator> bfi;
+    ELEMENT_TYPE et;
+    int ndof, nip;
+    /// relative order of the element vertices, shapes depend on it
+    size_t vorder;
+    /// 1 for the identity, the space dimension for the gradient
+    int D;
+    /// rows of the reference table, nip * D
+    int nrows;
+    Array<int> elnrs;
+
+    /// reference table nrows x ndof, and its transpose
+    unique_ptr<DevBatchMatrix<double>> bref, breft;
+    /// dof numbers, interleaved as element vectors
+    unique_ptr<DevBatchMatrix<int>> dnums;
+    /// geometric factors, D x D per element and point
+    unique_ptr<DevBatchMatrix<double>> g;
+    /// element vectors and point values
+    unique_ptr<DevBatchMatrix<double>> xe, ue, ve;
+  };
+
+
+  DevMatrixFreeOperator :: DevMatrixFreeOperator (shared_ptr<BilinearForm> abfa,
+                                                  LocalHeap & clh)
+    : bfa(abfa)
+  {
+    static Timer t("DevMatrixFreeOperator"); RegionTimer reg(t);
+
+    auto fes = bfa->GetFESpace();
+    auto ma = fes->GetMeshAccess();
+    ndof = fes->GetNDof();
+    int sdim = ma->GetDimension();
+
+    if (fes->IsComplex() || fes->GetDimension() != 1 || fes->NeedsTransformVec())
+      throw Exception ("DevMatrixFreeOperator: needs a real scalar space without dof transformation");
+
+    Array<shared_ptr<SymbolicBilinearFormIntegrator>> parts;
+    for (auto & bfi : bfa->Integrators())
+      {
+        auto sbfi = dynamic_pointer_cast<SymbolicBilinearFormIntegrator> (bfi);
+        if (!sbfi || bfi->VB() != VOL || bfi->SkeletonForm() || !sbfi->HasDiagonalFactorization()
+            || bfi->GetDeformation()
+            || (sbfi->FactorizationDim() != 1 && sbfi->FactorizationDim() != sdim))
+          throw Exception ("DevMatrixFreeOperator: integrator "+bfi->Name()+" is not supported");
+        parts.Append (sbfi);
+      }
+
+    for (auto & bfi : parts)
+      for (auto i : Range(ma->GetNE(VOL)))
+        {
+          HeapReset hr(clh);
+          ElementId ei(VOL, i);
+          if (!fes->DefinedOn (ei) || !bfi->DefinedOn (ma->GetElIndex(ei))) continue;
+          if (ma->GetTrafo (ei, clh).IsCurvedElement())
+            throw Exception ("DevMatrixFreeOperator: curved elements are not supported");
+          const FiniteElement & fel = fes->GetFE (ei, clh);
+          int nip = bfi->GetIntegrationRule (fel, clh).Size();
+
+          auto vnums = ma->GetElVertices (ei);
+          size_t vorder = 0;
+          for (auto j : Range(vnums))
+            {
+              size_t rank = 0;
+              for (auto v : vnums)
+                if (v < vnums[j]) rank++;
+              vorder = vorder * vnums.Size() + rank;
+            }
+          
+          shared_ptr<Block> block;
+          for (auto & b : blocks)
+            if (b->bfi == bfi && b->et == fel.ElementType() && b->ndof == fel.GetNDof() &&
+                b->nip == nip && b->vorder == vorder)
+              block = b;
+          if (!block)
+            {
+              block = make_shared<Block>();
+              block->bfi = bfi;
+              block->et = fel.ElementType();
+              block->ndof = fel.GetNDof();
+              block->nip = nip;
+              block->vorder = vorder;
+              block->D = bfi->FactorizationDim();
+              block->nrows = nip*block->D;
+              blocks.Append (block);
+            }
+          block->elnrs.Append (i);
+        }
+
+    for (auto & block : blocks)
+      {
+        int nel = block->elnrs.Size();
+        int nrows = block->nrows, ndofe = block->ndof, D = block->D;
+        auto & bfi = *block->bfi;
+
+        // B = M_e Bref, with M_e = 1 or Jinv^T
+        auto RefTable = [&] (int k, FlatMatrix<double> bref, LocalHeap & lh)
+          {
+            HeapReset hr(lh);
+            ElementId ei(VOL, block->elnrs[k]);
+            const FiniteElement & fel = fes->GetFE (ei, lh);
+            auto & mir = ma->GetTrafo (ei, lh) (bfi.GetIntegrationRule (fel, lh), lh);
+            FlatMatrix<double> btrial(nrows, ndofe, lh), btest(nrows, ndofe, lh);
+            bfi.CalcFactorizationB (fel, mir, btrial, btest, lh);
+            btest -= btrial;
+            if (L2Norm (btest) > 1e-12 * L2Norm (btrial))
+              throw Exception ("DevMatrixFreeOperator: trial and test operators must be the same");
+            if (D == 1)
+              bref = btrial;
+            else
+              for (auto p : Range(block->nip))
+                bref.Rows (p*D, (p+1)*D) = Trans (mir[p].GetJacobian()) * btrial.Rows (p*D, (p+1)*D);
+          };
+
+        Matrix<double> bref(nrows, ndofe), bcheck(nrows, ndofe);
+        RefTable (0, bref, clh);
+        RefTable (nel-1, bcheck, clh);
+        bcheck -= bref;
+        if (L2Norm (bcheck) > 1e-8 * L2Norm (bref))
+          throw Exception ("DevMatrixFreeOperator: operator is not a pull-back of a reference table");
+
+        Matrix<double> breft = Trans (bref);
+        Matrix<int> hdnums(ndofe, nel);
+        Array<DofId> dnums;
+        for (auto k : Range(nel))
+          {
+            fes->GetDofNrs (ElementId(VOL, block->elnrs[k]), dnums);
+            for (auto i : Range(ndofe))
+              hdnums(i,k) = IsRegularDof(dnums[i]) ? dnums[i] : -1;
+          }
+
+        block->bref = make_unique<DevBatchMatrix<double>> (1, bref);
+        block->breft = make_unique<DevBatchMatrix<double>> (1, breft);
+        block->dnums = make_unique<DevBatchMatrix<int>> (1, hdnums);
+        block->g = make_unique<DevBatchMatrix<double>> (1, nel, block->nip*D*D);
+        block->xe = make_unique<DevBatchMatrix<double>> (1, ndofe, nel);
+        block->ue = make_unique<DevBatchMatrix<double>> (1, nrows, nel);
+        block->ve = make_unique<DevBatchMatrix<double>> (1, nrows, nel);
+
+        cout << IM(3) << "matrix-free block " << block->et << ", ndof = " << ndofe
+             << ", nip = " << block->nip << ", elements = " << nel << endl;
+      }
+
+    Update (clh);
+  }
+
+
+  DevMatrixFreeOperator :: ~DevMatrixFreeOperator () { ; }
+
+
+  void DevMatrixFreeOperator :: Update (LocalHeap & clh)
+  {
+    static Timer t("DevMatrixFreeOperator::Update"); RegionTimer reg(t);
+
+    auto fes = bfa->GetFESpace();
+    auto ma = fes->GetMeshAccess();
+
+    for (auto & block : blocks)
+      {
+        int nel = block->elnrs.Size();
+        int nip = block->nip, D = block->D;
+        auto & bfi = *block->bfi;
+
+        // g = M_e^T diag(d) M_e in every point
+        Matrix<double> hg(nel, nip*D*D);
+        ParallelForRange
+          (IntRange(nel), [&] (IntRange r)
+           {
+             LocalHeap lh = clh.Split();
+             for (auto k : r)
+               {
+                 HeapReset hr(lh);
+                 ElementId ei(VOL, block->elnrs[k]);
+                 const FiniteElement & fel = fes->GetFE (ei, lh);
+                 auto & mir = ma->GetTrafo (ei, lh) (bfi.GetIntegrationRule (fel, lh), lh);
+                 FlatVector<double> d(nip*D, lh);
+                 bfi.CalcFactorizationD (mir, d, lh);
+
+                 auto g = hg.Row(k);
+                 if (D == 1)
+                   g = d;
+                 else
+                   {
+                     FlatMatrix<double> jinv(D, D, lh);
+                     for (auto p : Range(nip))
+                       {
+                         CalcInverse (mir[p].GetJacobian(), jinv);
+                         for (auto l1 : Range(D))
+                           for (auto l2 : Range(D))
+                             {
+                               double sum = 0;
+                               for (auto m : Range(D))
+                                 sum += jinv(l1,m) * d(p*D+m) * jinv(l2,m);
+                               g((p*D+l1)*D+l2) = sum;
+                             }
+                       }
+                   }
+               }
+           });
+        *block->g = hg;
+      }
+  }
+
+
+  void DevMatrixFreeOperator :: Mult (const BaseVector & x, BaseVector & y) const
+  {
+    UnifiedVector & uy = dynamic_cast_UnifiedVector (y);
+    cudaMemset (uy.DevDataOverwrite(), 0, ndof*sizeof(double));
+    MultAdd (1, x, y);
+  }
+
+
+  void DevMatrixFreeOperator :: MultAdd (double s, const BaseVector & x, BaseVector & y) const
+  {
+    static Timer t("DevMatrixFreeOperator::MultAdd"); RegionTimer reg(t);
+    const UnifiedVector & ux = dynamic_cast_UnifiedVector (x);
+    UnifiedVector & uy = dynamic_cast_UnifiedVector (y);
+
+    const double * xdata = ux.DevData();
+    double * ydata = uy.DevDataWrite();
+
+    for (auto & block : blocks)
+      {
+        int nel = block->elnrs.Size();
+        int nrows = block->nrows, ndofe = block->ndof;
+
+        DevGather (ndofe*nel, block->dnums->Data(), xdata, block->xe->Data());
+        // one product for all elements, the element vectors are the columns
+        ngs_cuda::MultBatched (1, nrows, nel, ndofe,
+                               block->bref->Data(), block->xe->Data(), block->ue->Data());
+        DevGeomFactors (nel, block->nip, block->D, block->g->Data(),
+                        block->ue->Data(), block->ve->Data());
+        ngs_cuda::MultBatched (1, ndofe, nel, nrows,
+                               block->breft->Data(), block->ve->Data(), block->xe->Data());
+        DevScatterAdd (ndofe*nel, s, block->dnums->Data(), block->xe->Data(), ydata);
+      }
+  }
+
+
+  void DevMatrixFreeOperator :: CalcDiagonal (UnifiedVector & diag) const
+  {
+    double * ddata = diag.DevDataOverwrite();
+    cudaMemset (ddata, 0, ndof*sizeof(double));
+
+    for (auto & block : blocks)
+      {
+        int nel = block->elnrs.Size();
+        DevElementDiagonal (nel, block->nip, block->D, block->ndof,
+                            block->bref->Data(), block->g->Data(), block->xe->Data());
+        DevScatterAdd (block->ndof*nel, 1, block->dnums->Data(), block->xe->Data(), ddata);
+      }
+  }
+
+}
+
+#endif
@@ -0,0 +1,97 @@
+#ifdef CUDA
+
+#ifndef FILE_CUDA_ASSEMBLY
+#define FILE_CUDA_ASSEMBLY
+
+/*********************************************************************/
+/* File:   cuda_assembly.hpp                                         */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+
+namespace ngcomp
+{
+
+  /**
+     Re-assembly of a bilinear form into a device sparse matrix.
+     
+     The integrators must be symbolic volume integrators with a diagonal
+     factorization elmat = Trans(B_test) diag(D) B_trial. The B matrices
+     (shape functions mapped to the geometry) and the matrix positions
+     of the element matrix entries are uploaded once, in batches of
+     elements of equal type and size. Assemble evaluates the coefficient
+     D on the host and uploads only these values, element matrices are
+     computed by a batched cuBLAS product and added to the device matrix
+     with atomics. The matrix never goes back to the host.
+
+     The host matrix of the bilinear form provides the sparsity pattern,
+     it must be a non-symmetric real SparseMatrix.
+  */
+  class NGS_DLL_HEADER DevBilinearFormAssembly
+  {
+    struct Block;
+    shared_ptr<BilinearForm> bfa;
+    shared_ptr<DevSparseMatrix> devmat;
+    Array<shared_ptr<Block>> blocks;
+
+  public:
+    DevBilinearFormAssembly (shared_ptr<BilinearForm> abfa, LocalHeap & lh);
+    ~DevBilinearFormAssembly ();
+
+    /// re-computes the device matrix with the current coefficients
+    void Assemble (LocalHeap & lh);
+
+    shared_ptr<DevSparseMatrix> GetMatrix () const { return devmat; }
+  };
+
+
+
+  /**
+     Matrix-free application of a bilinear form on the device, for
+     affine elements of scalar spaces (e.g. H1, L2).
+
+     The integrators must be symbolic volume integrators with a diagonal
+     factorization (see DevBilinearFormAssembly) whose proxies are the
+     identity or the gradient. On an affine element these are the
+     reference shape functions or their reference gradients times the
+     inverse Jacobian. Elements with the same type, order and vertex
+     ordering share one reference table, per element only the geometric
+     factors Jinv D Jinv^T at the integration points are stored. The
+     application is a gather, two products with the reference table
+     (one cuBLAS gemm for all elements of a block), the point-wise
+     factors, and an atomic scatter.
+
+     Vectors are UnifiedVectors, the operator works with the device
+     Krylov solvers and DevJacobiPreconditioner (see CalcDiagonal).
+  */
+  class NGS_DLL_HEADER DevMatrixFreeOperator : public BaseMatrix
+  {
+    struct Block;
+    shared_ptr<BilinearForm> bfa;
+    Array<shared_ptr<Block>> blocks;
+    int ndof;
+
+  public:
+    DevMatrixFreeOperator (shared_ptr<BilinearForm> abfa, LocalHeap & lh);
+    ~DevMatrixFreeOperator ();
+
+    /// re-computes the geometric factors with the current coefficients
+    void Update (LocalHeap & lh);
+
+    virtual bool IsComplex() const override { return false; }
+    virtual int VHeight() const override { return ndof; }
+    virtual int VWidth() const override { return ndof; }
+    virtual AutoVector CreateVector () const override
+    { return make_shared<UnifiedVector> (ndof); }
+
+    virtual void Mult (const BaseVector & x, BaseVector & y) const override;
+    virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const override;
+
+    /// diagonal of the operator, computed on the device
+    void CalcDiagonal (UnifiedVector & diag) const;
+  };
+
+}
+
+#endif
+#endif
@@ -80,6 +80,19 @@ namespace ngcomp
     dgjumps = flags.GetDefineFlag("dgjumps");
     no_low_order_space = flags.GetDefineFlagX("low_order_space").IsFalse() ||
       flags.GetDefineFlag("no_low_order_space");
+    cachefile = flags.GetStringFlag ("cache", "");
+    if (cachefile.length() && MyMPI_GetNTasks (ma->GetCommunicator()) > 1)
+      cachefile += "_" + ToString (MyMPI_GetId (ma->GetCommunicator()));
+    use_dof_tables = flags.GetDefineFlag ("dof_tables");
+    string coloring = flags.GetStringFlag ("coloring", "default");
+    if (coloring == "default")
+      coloring_strategy = COLORING_DEFAULT;
+    else if (coloring == "balanced")
+      coloring_strategy = COLORING_BALANCED;
+    else if (coloring == "local")
+      coloring_strategy = COLORING_LOCAL;
+    else
+      throw Exception ("FESpace: unknown coloring '" + coloring + "', use default, balanced or local");
     if (dgjumps) 
       *testout << "ATTENTION: flag dgjumps is used!\n This leads to a \
 lot of new non-zero entries in the matrix!\n" << endl;
@@ -326,6 +339,18 @@ lot of new non-zero entries in the matrix!\n" << endl;
       "  NODAL ..... use the same order for nodes of same shape,\n"
       "  VARIBLE ... use an individual order for each edge, face and cell,\n"
       "  OLDSTYLE .. as it used to be for the last decade";
+    docu.Arg("cache") = "string = ''\n"
+      "  File keeping element colorings and matrix graphs between runs.\n"
+      "  They are loaded instead of recomputed if mesh and space did not change.";
+    docu.Arg("dof_tables") = "bool = False\n"
+      "  Keep the dof numbers of all elements in tables built at the update,\n"
+      "  assembly and evaluation read them instead of recomputing them.";
+    docu.Arg("coloring") = "string = 'default'\n"
+      "  Element coloring for parallel assembly:\n"
+      "  default .. parallel Jones-Plassmann coloring,\n"
+      "  balanced . colors of about equal size,\n"
+      "  local .... elements of a color sorted along a space-filling curve,\n"
+      "             the chunks of the threads are spatially compact";
     return docu;
   }
 
@@ -346,6 +371,10 @@ lot of new non-zero entries in the matrix!\n" << endl;
 	*testout << "name = " << name << endl;
       }
 
+    ClearGraphCache();
+    for (auto & table : dof_tables)
+      table = Table<DofId>();
+
     for (int i = 0; i < specialelements.Size(); i++)
       delete specialelements[i]; 
     specialelements.SetSize(0);
@@ -362,20 +391,20 @@ lot of new non-zero entries in the matrix!\n" << endl;
     dirichlet_edge = false;
     dirichlet_face = false;
 
-    // for clang compatibility ... 
-    // #pragma omp parallel    
-    {
-      if (dirichlet_boundaries.Size())
-        for (Ngs_Element ngel : ma->Elements(BND))  // .OmpSplit())
-          if (dirichlet_boundaries[ngel.GetIndex()])
-            {
-              dirichlet_vertex[ngel.Vertices()] = true;
-              if (dim >= 2)
-                dirichlet_edge[ngel.Edges()] = true;
-              if (dim == 3)
-                dirichlet_face[ngel.Faces()[0]] = true;
-            }
-    }
+    if (dirichlet_boundaries.Size())
+      ParallelFor
+        (ma->GetNE(BND), [&] (size_t nr)
+         {
+           Ngs_Element ngel = (*ma)[ElementId(BND, nr)];
+           if (dirichlet_boundaries[ngel.GetIndex()])
+             {
+               dirichlet_vertex[ngel.Vertices()] = true;
+               if (dim >= 2)
+                 dirichlet_edge[ngel.Edges()] = true;
+               if (dim == 3)
+                 dirichlet_face[ngel.Faces()[0]] = true;
+             }
+         });
 
     if (print)
       {
@@ -398,6 +427,110 @@ lot of new non-zero entries in the matrix!\n" << endl;
   }
 
 
+  /*
+    Moves elements from colors larger than the average to the smallest
+    color none of its neighbours uses. Serial, the elements are visited
+    in mesh order.
+  */
+  static void BalanceColoring (FlatArray<int> col, int ncolors,
+                               const Table<DofId> & eldofs, const Table<int> & dofels)
+  {
+    static Timer t("FESpace - balance coloring"); RegionTimer reg(t);
+    if (ncolors <= 1) return;
+
+    Array<size_t> sizes(ncolors);
+    sizes = 0;
+    for (auto c : col)
+      if (c >= 0) sizes[c]++;
+    size_t total = 0;
+    for (auto s : sizes) total += s;
+    size_t target = (total + ncolors - 1) / ncolors;
+
+    Array<bool> used(ncolors);
+    used = false;
+    Array<int> usedlist;
+    for (size_t el : Range(col))
+      {
+        int c = col[el];
+        if (c < 0 || sizes[c] <= target) continue;
+
+        usedlist.SetSize0();
+        for (auto d : eldofs[el])
+          for (auto other : dofels[d])
+            if (!used[col[other]])
+              {
+                used[col[other]] = true;
+                usedlist.Append (col[other]);
+              }
+
+        int best = -1;
+        for (int c2 = 0; c2 < ncolors; c2++)
+          if (!used[c2] && sizes[c2] < target && (best == -1 || sizes[c2] < sizes[best]))
+            best = c2;
+        for (auto c2 : usedlist)
+          used[c2] = false;
+
+        if (best != -1)
+          {
+            sizes[c]--;
+            sizes[best]++;
+            col[el] = best;
+          }
+      }
+  }
+
+  /*
+    Sorts the elements of every color along a Morton curve through the
+    element centers. The chunks of consecutive elements taken by the
+    threads then cover compact parts of the mesh.
+  */
+  static void SortColorsSpatially (const MeshAccess & ma, VorB vb, Table<int> & coloring)
+  {
+    static Timer t("FESpace - sort colors"); RegionTimer reg(t);
+    size_t ne = ma.GetNE(vb);
+    if (!ne) return;
+
+    Array<Vec<3>> centers(ne);
+    ParallelFor (ne, [&] (size_t nr)
+                 {
+                   auto vnums = ma.GetElVertices (ElementId(vb, nr));
+                   Vec<3> c = 0.0;
+                   for (auto v : vnums)
+                     c += ma.GetPoint<3> (v);
+                   centers[nr] = (1.0/vnums.Size()) * c;
+                 });
+
+    Vec<3> pmin = centers[0], pmax = centers[0];
+    for (auto & c : centers)
+      for (int j = 0; j < 3; j++)
+        {
+          pmin(j) = min2 (pmin(j), c(j));
+          pmax(j) = max2 (pmax(j), c(j));
+        }
+
+    // 21 bits per coordinate, interleaved
+    Array<uint64_t> keys(ne);
+    ParallelFor (ne, [&] (size_t nr)
+                 {
+                   uint64_t key = 0;
+                   for (int j = 0; j < 3; j++)
+                     {
+                       double len = pmax(j)-pmin(j);
+                       uint64_t q = (len > 0) ?
+                         uint64_t ((centers[nr](j)-pmin(j)) / len * ((1 << 21) - 1)) : 0;
+                       for (int b = 0; b < 21; b++)
+                         key |= ((q >> b) & 1) << (3*b+j);
+                     }
+                   keys[nr] = key;
+                 });
+
+    ParallelFor (coloring.Size(), [&] (size_t c)
+                 {
+                   QuickSort (coloring[c], [&] (int a, int b) { return keys[a] < keys[b]; });
+                 });
+  }
+
+
   void FESpace :: FinalizeUpdate(LocalHeap & lh)
   {
     static Timer timer ("FESpace::FinalizeUpdate");
@@ -406,11 +539,31 @@ lot of new non-zero entries in the matrix!\n" << endl;
     static Timer timer3 ("FESpace::FinalizeUpdate 3");
     static Timer tcol ("FESpace::FinalizeUpdate - coloring");
     static Timer tcolbits ("FESpace::FinalizeUpdate - bitarrays");
-    static Timer tcolmutex ("FESpace::FinalizeUpdate - coloring, init mutex");
     
     if (low_order_space) low_order_space -> FinalizeUpdate(lh);
 
     RegionTimer reg (timer);
+    ClearGraphCache();
+
+    for (auto vb : { VOL, BND, BBND, BBBND })
+      {
+        dof_tables[vb] = Table<DofId>();
+        if (use_dof_tables && ma->GetNE(vb))
+          {
+            static Timer tdt ("FESpace::FinalizeUpdate - dof tables");
+            RegionTimer rdt (tdt);
+            // the table must be complete before GetElementDofNrs uses it
+            Table<DofId> table = ParallelCreateTable<DofId>
+              (ma->GetNE(vb), [&] (ParallelTableCreator<DofId> & creator, size_t nr)
+               {
+                 ArrayMem<DofId,100> dnums;
+                 GetDofNrs (ElementId(vb, nr), dnums);
+                 creator.Add (nr, dnums);
+               }, ma->GetNE(vb));
+            dof_tables[vb] = move(table);
+          }
+      }
+
     timer1.Start();
     dirichlet_dofs.SetSize (GetNDof());
     dirichlet_dofs.Clear();
@@ -427,10 +580,15 @@ lot of new non-zero entries in the matrix!\n" << endl;
     */
 
     if (dirichlet_boundaries.Size())
-      for (FESpace::Element el : Elements(BND))
-        if (dirichlet_boundaries[el.GetIndex()])
-          for (int d : el.GetDofs())
-            if (IsRegularDof(d)) dirichlet_dofs.Set (d);
+      ParallelFor
+        (ma->GetNE(BND), [&] (size_t nr)
+         {
+           ElementId ei(BND, nr);
+           if (!DefinedOn(ei) || !dirichlet_boundaries[ma->GetElIndex(ei)]) return;
+           ArrayMem<DofId,100> temp;
+           for (DofId d : GetElementDofNrs (ei, temp))
+             if (IsRegularDof(d)) dirichlet_dofs.Set (d);
+         });
 
     /*
     Array<DofId> dnums;
@@ -481,29 +639,37 @@ lot of new non-zero entries in the matrix!\n" << endl;
              }
        });
 
-    Array<DofId> dnums;             
-    for (int i : Range(dirichlet_face))
-      if (dirichlet_face[i])
-	{
-	  GetFaceDofNrs (i, dnums);
-	  for (DofId d : dnums)
-	    if (IsRegularDof(d)) dirichlet_dofs.Set (d);
-	}
+    ParallelForRange
+      (dirichlet_face.Size(),
+       [&] (IntRange r)
+       {
+         Array<DofId> dnums;
+         for (auto i : r)
+           if (dirichlet_face[i])
+             {
+               GetFaceDofNrs (i, dnums);
+               for (DofId d : dnums)
+                 if (IsRegularDof(d)) dirichlet_dofs.Set (d);
+             }
+       });
     
     tcolbits.Start();
+    // hidden or unused dofs are not free, condensable ones not externally free.
+    // BitArray::Set is atomic, Clear is not
     free_dofs = make_shared<BitArray>(GetNDof());
-    *free_dofs = dirichlet_dofs;
-    free_dofs->Invert();
-    
-    for (auto i : Range(ctofdof))
-      if (!(ctofdof[i] & VISIBLE_DOF)) //hidden or unused
-	free_dofs->Clear(i);
-
     external_free_dofs = make_shared<BitArray>(GetNDof());
-    *external_free_dofs = *free_dofs;
-    for (auto i : Range(ctofdof))
-      if (ctofdof[i] & CONDENSABLE_DOF)
-	external_free_dofs->Clear(i);
+    free_dofs->Clear();
+    external_free_dofs->Clear();
+    ParallelFor
+      (GetNDof(), [&] (size_t i)
+       {
+         if (dirichlet_dofs.Test(i)) return;
+         COUPLING_TYPE ct = (i < ctofdof.Size()) ? ctofdof[i] : WIREBASKET_DOF;
+         if (!(ct & VISIBLE_DOF)) return;
+         free_dofs->Set(i);
+         if (!(ct & CONDENSABLE_DOF))
+           external_free_dofs->Set(i);
+       });
 
     if (print)
       *testout << "freedofs = " << endl << *free_dofs << endl;
@@ -514,17 +680,19 @@ lot of new non-zero entries in the matrix!\n" << endl;
     if (print)
       *testout << "coloring ... " << flush;
 
-    if (low_order_space)
+    // invalidate facet_coloring
+    facet_coloring = Table<int>();
+
+    bool cached = LoadCache();
+    if (cached)
+      ;   // colorings from the cache file
+    else if (low_order_space && coloring_strategy == COLORING_DEFAULT)
       {
 	for(auto vb : {VOL, BND, BBND, BBBND})
 	  element_coloring[vb] = Table<int>(low_order_space->element_coloring[vb]);
       }
     else
       {
-        tcolmutex.Start();
-      Array<MyMutex> locks(GetNDof());
-      tcolmutex.Stop();
-      
       for (auto vb : { VOL, BND, BBND, BBBND })
       {
         /*
@@ -605,110 +773,118 @@ lot of new non-zero entries in the matrix!\n" << endl;
 
 
 
+        /*
+          Jones-Plassmann coloring: in every round, the uncolored elements
+          with a higher priority than all uncolored neighbours take the
+          smallest color not used by a colored neighbour. Neighbours share
+          a regular, non-atomic dof. The priorities are a hash of the
+          element number, the coloring does not depend on the threads.
+        */
         tcol.Start();
-        Array<int> col(ma->GetNE(vb));
-        col = -1;
-
-        int maxcolor = 0;
-        
-        int basecol = 0;
-        Array<unsigned int> mask(GetNDof());
-
-        atomic<int> found(0);
-        size_t cnt = 0;
-        for (ElementId el : Elements(vb)) { cnt++; (void)el; } // no warning 
-
-        while (found < cnt)
+        size_t ne = ma->GetNE(vb);
+        bool atomic_dofs = HasAtomicDofs();
+
+        Table<DofId> eldofs = ParallelCreateTable<DofId>
+          (ne, [&] (ParallelTableCreator<DofId> & creator, size_t nr)
+           {
+             ElementId ei(vb, nr);
+             if (!DefinedOn(ei)) return;
+             ArrayMem<DofId,100> temp;
+             for (auto d : GetElementDofNrs(ei, temp))
+               if (IsRegularDof(d) && !(atomic_dofs && IsAtomicDof(d)))
+                 creator.Add (nr, d);
+           }, ne);
+
+        Table<int> dofels = ParallelCreateTable<int>
+          (ne, [&] (ParallelTableCreator<int> & creator, size_t nr)
+           {
+             for (auto d : eldofs[nr])
+               creator.Add (d, int(nr));
+           }, GetNDof());
+
+        // distinct for all elements, multiplication and shift are bijective
+        auto priority = [] (size_t nr)
           {
-            // mask = 0   | tasks;
-
-            ParallelForRange
-              (mask.Size(),
-               [&] (IntRange myrange) { mask[myrange] = 0; });
-
-            size_t ne = ma->GetNE(vb);
-
-            ParallelForRange
-              (ne, [&] (IntRange myrange)
-               {
-                 Array<DofId> dofs;
-                 size_t myfound = 0;
-                 
-                 for (size_t nr : myrange)
-                   {
-                     ElementId el = { vb, nr };
-                     if (!DefinedOn(el)) continue;
-                     if (col[el.Nr()] >= 0) continue;
-                     
-                     unsigned check = 0;
-                     GetDofNrs(el, dofs);
-                     
-                     if (HasAtomicDofs())
-                       {
-                         for (int i = dofs.Size()-1; i >= 0; i--)
-                           if (!IsRegularDof(dofs[i]) || IsAtomicDof(dofs[i])) dofs.DeleteElement(i);
-                       }
-                     else
-                       for (int i = dofs.Size()-1; i >= 0; i--)
-                         if (!IsRegularDof(dofs[i])) dofs.DeleteElement(i);
-                     QuickSort (dofs);   // sort to avoid dead-locks
-                     
-                     for (auto d : dofs) 
-                       locks[d].lock();
-                     
-                     for (auto d : dofs) 
-                       check |= mask[d];
-                     
-                     if (check != UINT_MAX) // 0xFFFFFFFF)
-                       {
-                         myfound++;
-                         unsigned checkbit = 1;
-                         int color = basecol;
-                         while (check & checkbit)
-                           {
-                             color++;
-                             checkbit *= 2;
-                           }
-                         
-                         col[el.Nr()] = color;
-                         if (color > maxcolor) maxcolor = color;
-                         
-                         for (auto d : dofs) // el.GetDofs())
-                           mask[d] |= checkbit;
-                       }
-                     
-                     for (auto d : dofs) 
-                       locks[d].unlock();
-                   }
-                 found += myfound;
-               });
-                 
-            basecol += 8*sizeof(unsigned int); // 32;
+            size_t h = (nr+1) * size_t(0x9E3779B97F4A7C15ull);
+            return h ^ (h >> 31);
+          };
+
+        Array<int> col(ne);
+        ParallelFor (ne, [&] (size_t nr) { col[nr] = -1; });
+        Array<int> todo;
+        for (size_t nr = 0; nr < ne; nr++)
+          if (DefinedOn (ElementId(vb, nr)))
+            todo.Append (nr);
+
+        Array<bool> selected;
+        while (todo.Size())
+          {
+            selected.SetSize (todo.Size());
+            ParallelFor (todo.Size(), [&] (size_t i)
+                         {
+                           int el = todo[i];
+                           auto prio = priority(el);
+                           selected[i] = true;
+                           for (auto d : eldofs[el])
+                             for (auto other : dofels[d])
+                               if (col[other] == -1 && other != el && priority(other) > prio)
+                                 {
+                                   selected[i] = false;
+                                   return;
+                                 }
+                         });
+
+            // selected elements are not neighbours, their colors are set
+            // concurrently from colors of previous rounds
+            ParallelFor (todo.Size(), [&] (size_t i)
+                         {
+                           if (!selected[i]) return;
+                           int el = todo[i];
+                           ArrayMem<int,100> used;
+                           for (auto d : eldofs[el])
+                             for (auto other : dofels[d])
+                               if (col[other] >= 0) used.Append (col[other]);
+                           QuickSort (used);
+                           int color = 0;
+                           for (auto c : used)
+                             if (c == color) color++;
+                             else if (c > color) break;
+                           col[el] = color;
+                         });
+
+            size_t cnt = 0;
+            for (size_t i : Range(todo))
+              if (!selected[i]) todo[cnt++] = todo[i];
+            todo.SetSize (cnt);
           }
 
-        tcol.Stop();
+        int maxcolor = ParallelReduce (ne, [&] (size_t nr) { return col[nr]; },
+                                       [] (int a, int b) { return max2(a,b); }, -1);
 
-        Array<int> cntcol(maxcolor+1);
-        cntcol = 0;
+        if (coloring_strategy == COLORING_BALANCED)
+          BalanceColoring (col, maxcolor+1, eldofs, dofels);
 
-        for (ElementId el : Elements(vb))
-          cntcol[col[el.Nr()]]++;
-        
-        Table<int> & coloring = element_coloring[vb];
-        coloring = Table<int> (cntcol);
+        element_coloring[vb] = ParallelCreateTable<int>
+          (ne, [&] (ParallelTableCreator<int> & creator, size_t nr)
+           {
+             if (col[nr] >= 0) creator.Add (col[nr], int(nr));
+           }, maxcolor+1);
 
-	cntcol = 0;
-        for (ElementId el : Elements(vb))
-          coloring[col[el.Nr()]][cntcol[col[el.Nr()]]++] = el.Nr();
+        if (coloring_strategy == COLORING_LOCAL)
+          SortColorsSpatially (*ma, vb, element_coloring[vb]);
+        tcol.Stop();
         
         if (print)
           *testout << "needed " << maxcolor+1 << " colors" 
                    << " for " << ((vb == VOL) ? "vol" : "bnd") << endl;
       }
       }
-    
-    // invalidate facet_coloring
-    facet_coloring = Table<int>();
+
+    if (!cached)
+      {
+        lock_guard<mutex> guard(graph_cache_mutex);
+        SaveCache();
+      }
        
     level_updated = ma->GetNLevels();
     if (timing) Timing();
@@ -804,6 +980,10 @@ lot of new non-zero entries in the matrix!\n" << endl;
     if (print)
       *testout << "needed " << maxcolor+1 << " colors for facet-coloring" << endl;
 
+    {
+      lock_guard<mutex> guard(graph_cache_mutex);
+      SaveCache();
+    }
     return facet_coloring;
   }
   
@@ -911,13 +1091,15 @@ lot of new non-zero entries in the matrix!\n" << endl;
     
   Table<int> FESpace :: CreateDofTable (VorB vorb) const
   {
-    TableCreator<int> creator;
-    
-    for ( ; !creator.Done(); creator++)
-      for (FESpace::Element el : Elements(vorb))
-        creator.Add(el.Nr(), el.GetDofs());
-
-    return creator.MoveTable();
+    return ParallelCreateTable<int>
+      (ma->GetNE(vorb), [&] (ParallelTableCreator<int> & creator, size_t nr)
+       {
+         ElementId ei(vorb, nr);
+         if (!DefinedOn (ei)) return;
+         ArrayMem<DofId,100> dnums;
+         GetDofNrs (ei, dnums);
+         creator.Add (nr, dnums);
+       });
   }
 
   /*
@@ -1228,10 +1410,213 @@ lot of new non-zero entries in the matrix!\n" << endl;
     archive & dirichlet_vertex & dirichlet_edge & dirichlet_face;
   }
 
+  shared_ptr<MatrixGraph> FESpace ::
+  GetCachedGraph (int key, const function<shared_ptr<MatrixGraph>()> & create) const
+  {
+    lock_guard<mutex> guard(graph_cache_mutex);
+    size_t ndof = GetNDof();
+    for (auto & entry : graph_cache)
+      if (entry.key == key && entry.ndof == ndof)
+        return entry.graph;
+
+    auto graph = create();
+    graph_cache.Append (GraphCacheEntry { key, ndof, graph });
+    SaveCache();
+    return graph;
+  }
+
+  void FESpace :: ClearGraphCache () const
+  {
+    lock_guard<mutex> guard(graph_cache_mutex);
+    graph_cache = Array<GraphCacheEntry>();   // releases the graphs
+  }
+
+
+  static size_t HashCombine (size_t h, size_t v)
+  {
+    uint64_t x = h ^ (v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2));
+    x ^= x >> 31;
+    x *= 0x7fb5d329728ea185ull;
+    x ^= x >> 27;
+    return x;
+  }
+
+  // hashes of items 0..n-1 are computed in parallel, combined in order
+  template <typename FUNC>
+  static size_t HashItems (size_t key, size_t n, FUNC f)
+  {
+    Array<size_t> hashes(n);
+    ParallelForRange (n, [&] (IntRange r)
+                      {
+                        Array<DofId> dnums;
+                        for (auto i : r)
+                          hashes[i] = f(i, dnums);
+                      });
+    key = HashCombine (key, n);
+    for (auto h : hashes)
+      key = HashCombine (key, h);
+    return key;
+  }
+
+  size_t FESpace :: CacheKey () const
+  {
+    static Timer t("FESpace::CacheKey"); RegionTimer reg(t);
+
+    size_t key = HashCombine (std::hash<string>() (type), GetNDof());
+    key = HashCombine (key, HasAtomicDofs() + 2*UsesDGCoupling());
+    key = HashCombine (key, coloring_strategy);
+
+    for (auto vb : { VOL, BND, BBND, BBBND })
+      key = HashItems (key, ma->GetNE(vb), [&] (size_t nr, Array<DofId> & dnums)
+                       {
+                         ElementId ei(vb, nr);
+                         if (!DefinedOn (ei)) return size_t(-1);
+                         GetDofNrs (ei, dnums);
+                         size_t h = dnums.Size();
+                         for (auto d : dnums)
+                           h = HashCombine (h, 2*size_t(d) + (IsRegularDof(d) && IsAtomicDof(d)));
+                         return h;
+                       });
+
+    key = HashItems (key, ctofdof.Size(), [&] (size_t i, Array<DofId> & dnums)
+                     { return size_t(ctofdof[i]); });
+
+    key = HashItems (key, ma->GetNFacets(), [&] (size_t f, Array<DofId> & dnums)
+                     {
+                       ArrayMem<int,2> elnums;
+                       ma->GetFacetElements (f, elnums);
+                       size_t h = HashCombine (elnums.Size(), ma->GetPeriodicFacet(f));
+                       for (auto el : elnums)
+                         h = HashCombine (h, el);
+                       return h;
+                     });
+    return key;
+  }
+
+  static const string fespace_cache_tag = "ngsolve-fespace-cache-1";
+
+  /*
+    The cache file holds the key, the element colorings for VOL to
+    BBBND, the facet coloring and the cached matrix graphs. Tables and
+    graphs are stored as their index and data arrays.
+  */
+  void FESpace :: SaveCache () const
+  {
+    if (cachefile.empty()) return;
+    static Timer t("FESpace::SaveCache"); RegionTimer reg(t);
+
+    MappedOutArchive ar(cachefile);
+    string tag = fespace_cache_tag;
+    size_t key = cache_key;
+    ar & tag & key;
+
+    auto save_table = [&] (const Table<int> & table)
+      {
+        size_t size = table.Size();
+        ar & size;
+        if (!size) return;
+        ar.Do (&table.IndexArray()[0], size+1);
+        if (table.AsArray().Size())
+          ar.Do (table.Data(), table.AsArray().Size());
+      };
+    for (auto vb : { VOL, BND, BBND, BBBND })
+      save_table (element_coloring[vb]);
+    save_table (facet_coloring);
+
+    size_t ngraphs = 0;
+    for (auto & entry : graph_cache)
+      if (entry.ndof == GetNDof()) ngraphs++;
+    ar & ngraphs;
+    for (auto & entry : graph_cache)
+      {
+        if (entry.ndof != GetNDof()) continue;
+        const MatrixGraph & graph = *entry.graph;
+        int gkey = entry.key;
+        size_t size = graph.Size(), nze = graph.NZE();
+        ar & gkey & size & nze;
+        ar.Do (&graph.GetFirstArray()[0], size+1);
+        if (nze)
+          ar.Do (graph.GetRowIndices(0).Addr(0), nze);
+      }
+  }
+
+  bool FESpace :: LoadCache ()
+  {
+    if (cachefile.empty()) return false;
+    static Timer t("FESpace::LoadCache"); RegionTimer reg(t);
+
+    cache_key = CacheKey();
+    if (!ifstream(cachefile)) return false;
+
+    try
+      {
+        MappedInArchive ar(cachefile);
+        string tag;
+        size_t key;
+        ar & tag & key;
+        if (tag != fespace_cache_tag || key != cache_key)
+          return false;
+
+        auto load_table = [&] ()
+          {
+            size_t size;
+            ar & size;
+            if (!size) return Table<int>();
+            Array<size_t> index(size+1);
+            ar.Do (&index[0], size+1);
+            Array<size_t> entrysize(size);
+            for (size_t i = 0; i < size; i++)
+              entrysize[i] = index[i+1]-index[i];
+            Table<int> table(entrysize);
+            if (index[size])
+              ar.Do (table.Data(), index[size]);
+            return table;
+          };
+        Table<int> colorings[5];
+        for (auto & table : colorings)
+          table = load_table();
+
+        size_t ngraphs;
+        ar & ngraphs;
+        Array<GraphCacheEntry> graphs;
+        for (size_t i = 0; i < ngraphs; i++)
+          {
+            int gkey;
+            size_t size, nze;
+            ar & gkey & size & nze;
+            Array<size_t> first(size+1);
+            ar.Do (&first[0], size+1);
+            Array<int> elsperrow(size);
+            for (size_t j = 0; j < size; j++)
+              elsperrow[j] = first[j+1]-first[j];
+            auto graph = make_shared<MatrixGraph> (elsperrow, GetNDof());
+            if (nze)
+              ar.Do (graph->GetRowIndices(0).Addr(0), nze);
+            graphs.Append (GraphCacheEntry { gkey, GetNDof(), graph });
+          }
+
+        for (auto vb : { VOL, BND, BBND, BBBND })
+          element_coloring[vb] = move(colorings[vb]);
+        facet_coloring = move(colorings[4]);
+        lock_guard<mutex> guard(graph_cache_mutex);
+        graph_cache = move(graphs);
+        return true;
+      }
+    catch (Exception &)
+      {
+        // a damaged cache is rebuilt
+        return false;
+      }
+  }
+
   Array<MemoryUsage> FESpace :: GetMemoryUsage () const
   {
     Array<MemoryUsage> mu;
     mu += { "coupling types", ctofdof.Size()*sizeof(COUPLING_TYPE), 1 };
+    for (auto & table : dof_tables)
+      if (table.Size())
+        mu += { "element dof table", table.NElements()*sizeof(DofId) +
+            (table.Size()+1)*sizeof(size_t), 2 };
     return mu;
   }
 
@@ -1476,7 +1861,8 @@ lot of new non-zero entries in the matrix!\n" << endl;
   void IterateElements (const FESpace & fes, 
 			VorB vb, 
 			LocalHeap & clh, 
-			const function<void(FESpace::Element,LocalHeap&)> & func)
+			const function<void(FESpace::Element,LocalHeap&)> & func,
+                        const function<void(LocalHeap&)> & flush)
   {
     static mutex copyex_mutex;
     const Table<int> & element_coloring = fes.ElementColoring(vb);
@@ -1502,6 +1888,7 @@ lot of new non-zero entries in the matrix!\n" << endl;
                       
                       func (move(el), lh);
                     }
+                  if (flush) flush(lh);
 
                   ProgressOutput::SumUpLocal();
                 } );
@@ -1541,6 +1928,7 @@ lot of new non-zero entries in the matrix!\n" << endl;
 	    catch (...)
 	      { ; }
           }
+        if (flush) flush(lh);
       // cout << "lh, used size = " << lh.UsedSize() << endl;
     });
     
@@ -1549,6 +1937,62 @@ lot of new non-zero entries in the matrix!\n" << endl;
         throw Exception (*ex);
       }
   }
+
+
+  bool HasPoorColoring (const FESpace & fes, VorB vb)
+  {
+    if (!task_manager) return false;
+
+    // every color ends with a barrier, with only a few elements
+    // per thread and color the threads mostly wait
+    const Table<int> & coloring = fes.ElementColoring(vb);
+    size_t nthreads = task_manager->GetNumThreads();
+    return coloring.Size() > 1 && coloring.NElements() < 8 * nthreads * coloring.Size();
+  }
+
+  void IterateElementsUncolored (const FESpace & fes, 
+                                 VorB vb, 
+                                 LocalHeap & clh, 
+                                 const function<void(FESpace::Element,LocalHeap&)> & func,
+                                 const function<void(LocalHeap&)> & flush)
+  {
+    size_t ne = fes.GetMeshAccess()->GetNE(vb);
+    if (!task_manager)
+      {
+        ArrayMem<int,100> temp_dnums;
+        for (size_t i = 0; i < ne; i++)
+          {
+            ElementId ei(vb, i);
+            if (!fes.DefinedOn(ei)) continue;
+            HeapReset hr(clh);
+            FESpace::Element el(fes, ei, temp_dnums, clh);
+            func (move(el), clh);
+          }
+        if (flush) flush(clh);
+        return;
+      }
+
+    // contiguous chunks of elements keep the neighbouring dofs in cache
+    SharedLoop2 sl(IntRange(ne));
+    task_manager -> CreateJob
+      ( [&] (const TaskInfo & ti) 
+        {
+          LocalHeap lh = clh.Split(ti.thread_nr, ti.nthreads);
+          ArrayMem<int,100> temp_dnums;
+          
+          for (size_t mynr : sl)
+            {
+              ElementId ei(vb, mynr);
+              if (!fes.DefinedOn(ei)) continue;
+              HeapReset hr(lh);
+              FESpace::Element el(fes, ei, temp_dnums, lh);
+              func (move(el), lh);
+            }
+          if (flush) flush(lh);
+          
+          ProgressOutput::SumUpLocal();
+        } );
+  }
   
   /*
   // Aendern, Bremse!!!
@@ -1697,6 +2141,31 @@ lot of new non-zero entries in the matrix!\n" << endl;
       paralleldofs -> GetNDofGlobal() : GetNDof(); 
   }
 
+  void FESpace :: GetElementWeights (Array<int> & weights) const
+  {
+    weights.SetSize (ma->GetNE(VOL));
+    ParallelFor (weights.Size(), [&] (size_t i)
+                 {
+                   Array<DofId> dnums;
+                   GetDofNrs (ElementId(VOL, i), dnums);
+                   weights[i] = dnums.Size();
+                 });
+  }
+
+  double FESpace :: GetLoadImbalance () const
+  {
+    Array<int> weights;
+    GetElementWeights (weights);
+    double work = 0;
+    for (int w : weights) work += w;
+
+    MPI_Comm comm = ma->GetCommunicator();
+    double maxwork = MyMPI_AllReduce (work, MPI_MAX, comm);
+    double sumwork = MyMPI_AllReduce (work, MPI_SUM, comm);
+    if (sumwork == 0) return 1;
+    return maxwork * MyMPI_GetNTasks(comm) / sumwork;
+  }
+
   BitArray FESpace :: GetDofs (Region reg) const
   {
     BitArray ba(GetNDof());
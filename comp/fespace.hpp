@@ -183,6 +183,10 @@ ANY                  1 1 1 1 | 15
     
     Table<int> element_coloring[4]; 
     Table<int> facet_coloring;  // elements on facet in own colors (DG)
+    /// element coloring (flag coloring): default, balanced color sizes,
+    /// or elements of a color in spatial order
+    enum COLORING_STRATEGY { COLORING_DEFAULT, COLORING_BALANCED, COLORING_LOCAL };
+    COLORING_STRATEGY coloring_strategy = COLORING_DEFAULT;
     Array<COUPLING_TYPE> ctofdof;
 
     shared_ptr<ParallelDofs> paralleldofs;
@@ -202,6 +206,26 @@ ANY                  1 1 1 1 | 15
     // of element vectors
     bool needs_transform_vec = true;
 
+    /// matrix graphs of bilinear-forms, valid until the next update
+    struct GraphCacheEntry
+    {
+      int key;
+      size_t ndof;
+      shared_ptr<MatrixGraph> graph;
+    };
+    mutable Array<GraphCacheEntry> graph_cache;
+    mutable mutex graph_cache_mutex;
+
+    /// file keeping colorings and matrix graphs between runs (flag cache)
+    string cachefile;
+    /// hash of everything the cached data depend on
+    size_t cache_key = 0;
+
+    /// keep the dofs of all elements in tables (flag dof_tables)
+    bool use_dof_tables = false;
+    /// element dofs per VorB, built by FinalizeUpdate
+    Table<DofId> dof_tables[4];
+
     
     // move ndof and ndof_level to FESpace base class
   private:
@@ -237,6 +261,18 @@ ANY                  1 1 1 1 | 15
     /// update element coloring
     virtual void FinalizeUpdate(LocalHeap & lh);
 
+    /// matrix graph with the given key, calls create only if it was not
+    /// built since the last update of the space
+    shared_ptr<MatrixGraph> GetCachedGraph (int key, const function<shared_ptr<MatrixGraph>()> & create) const;
+    void ClearGraphCache () const;
+
+    /// hash of the element dofs, coupling types and facet neighbours
+    size_t CacheKey () const;
+    /// colorings and graphs from the cache file, false if missing or stale
+    bool LoadCache ();
+    /// writes the cache file, the caller holds graph_cache_mutex
+    void SaveCache () const;
+
     /// highest level where update/finalize was called
     int GetLevelUpdated() const { return level_updated; }
 
@@ -295,6 +331,7 @@ ANY                  1 1 1 1 | 15
       const FESpace & fes;
       Array<DofId> & temp_dnums;
       LocalHeap & lh;
+      mutable FlatArray<DofId> dofs;
       mutable bool dofs_set = false;
     public:     
       INLINE Element (const FESpace & afes, ElementId id, Array<DofId> & atemp_dnums,
@@ -309,9 +346,9 @@ ANY                  1 1 1 1 | 15
       INLINE FlatArray<DofId> GetDofs() const
       {
         if (!dofs_set)
-          fes.GetDofNrs (*this, temp_dnums);
+          dofs = fes.GetElementDofNrs (*this, temp_dnums);
         dofs_set = true;
-        return temp_dnums;
+        return dofs;
       }
 
       INLINE const ElementTransformation & GetTrafo() const
@@ -426,6 +463,20 @@ ANY                  1 1 1 1 | 15
     virtual void GetDofNrs (ElementId ei, Array<DofId> & dnums) const = 0;
     
     virtual void GetDofNrs (NodeId ni, Array<DofId> & dnums) const;
+
+    /// dofs of the element, a row of the dof table if it was built
+    /// (flag dof_tables), otherwise computed by GetDofNrs into temp.
+    /// Rows of the table must not be modified.
+    FlatArray<DofId> GetElementDofNrs (ElementId ei, Array<DofId> & temp) const
+    {
+      auto & table = dof_tables[ei.VB()];
+      if (table.Size())
+        return table[ei.Nr()];
+      GetDofNrs (ei, temp);
+      return temp;
+    }
+    bool HasDofTable (VorB vb) const { return dof_tables[vb].Size() > 0; }
+
     BitArray GetDofs (Region reg) const;
     Table<int> CreateDofTable (VorB vorb) const;
 
@@ -659,6 +710,15 @@ ANY                  1 1 1 1 | 15
     /// ndof over all mpi-partitions
     size_t GetNDofGlobal() const;
 
+    /// number of dofs of every volume element, the work of the element
+    void GetElementWeights (Array<int> & weights) const;
+
+    /**
+       Maximal over average work of the mpi-partitions, the work is 
+       the sum of the element weights. 1 for a balanced distribution.
+    */
+    double GetLoadImbalance () const;
+
     virtual int GetRelOrder() const
     { 
       cout << "virtual GetRelOrder called for FiniteElementSpace, not available ! " << endl; 
@@ -834,10 +894,25 @@ ANY                  1 1 1 1 | 15
 
 
 
+  /// the optional flush is called by every thread when it has finished
+  /// its share of elements of one color
   extern NGS_DLL_HEADER void IterateElements (const FESpace & fes,
 			       VorB vb, 
 			       LocalHeap & clh, 
-			       const function<void(FESpace::Element,LocalHeap&)> & func);
+			       const function<void(FESpace::Element,LocalHeap&)> & func,
+                               const function<void(LocalHeap&)> & flush = nullptr);
+
+  /// iterates over the elements in mesh order, without coloring.
+  /// func must write shared data with atomic operations
+  extern NGS_DLL_HEADER void IterateElementsUncolored (const FESpace & fes,
+                                                       VorB vb, 
+                                                       LocalHeap & clh, 
+                                                       const function<void(FESpace::Element,LocalHeap&)> & func,
+                                                       const function<void(LocalHeap&)> & flush = nullptr);
+  /// are there only few elements per thread and color ?
+  /// then the barriers of the colored loops dominate
+  extern NGS_DLL_HEADER bool HasPoorColoring (const FESpace & fes, VorB vb);
+
   /*
   template <typename TFUNC>
   inline void IterateElements (const FESpace & fes, 
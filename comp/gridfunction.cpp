@@ -215,6 +215,22 @@ namespace ngcomp
     multidim++;
   }
 
+  void GridFunction :: SetVector (shared_ptr<BaseVector> v, int comp)
+  {
+    if (comp < 0 || comp >= multidim)
+      throw Exception ("GridFunction::SetVector: component "+ToString(comp)+" out of range");
+    auto & old = *vec[comp];
+    if (v->Size() != old.Size() || v->EntrySize() != old.EntrySize() ||
+        v->IsComplex() != old.IsComplex())
+      throw Exception ("GridFunction::SetVector: vector does not fit the space");
+    if (fespace->GetParallelDofs())
+      throw Exception ("GridFunction::SetVector: not available for distributed spaces");
+    vec[comp] = v;
+    // component gridfunctions are views into the vector
+    for (auto & cgf : compgfs)
+      cgf->Update();
+  }
+
 
   // void GridFunction :: Visualize(const string & given_name)
   void Visualize(shared_ptr<GridFunction> gf, const string & given_name)
@@ -323,19 +339,6 @@ namespace ngcomp
 
 
 
-  template <int N>
-  bool MyLess (const Vec<N,int>& a, const Vec<N,int>& b)
-  {
-    for( int i = 0; i < N; i++)
-      {
-	if (a[i] < b[i]) return true;
-	if (a[i] > b[i]) return false;
-      }
-    
-    return false;  
-  }
-
-
 
 
 
@@ -384,7 +387,8 @@ namespace ngcomp
 	    Array<int> index(nnodes);
 	    for( int i = 0; i < index.Size(); i++) index[i] = i;
 	    
-	    QuickSortI (nodekeys, index, MyLess<8>);
+	    ParallelRadixSortI (FlatArray<Vec<8,int>> (nodekeys), FlatArray<int> (index), 8,
+				[] (const Vec<8,int> & key, int j) { return key[j]; });
 	    
 	    for( int i = 0; i < nnodes; i++)
 	      {
@@ -511,7 +515,8 @@ namespace ngcomp
 	Array<int> index(nnodes);
 	for( int i = 0; i < index.Size(); i++) index[i] = i;
 
-	QuickSortI (nodekeys, index, MyLess<N>);
+	ParallelRadixSortI (FlatArray<Vec<N,int>> (nodekeys), FlatArray<int> (index), N,
+			    [] (const Vec<N,int> & key, int j) { return key[j]; });
 
 	Array<int> inverse_index(nnodes);
 	for (int i = 0; i < index.Size(); i++ ) 	
@@ -555,60 +560,9 @@ namespace ngcomp
   void S_GridFunction<SCAL> :: Save (ostream & ost) const
   {
     int ntasks = MyMPI_GetNTasks();
-    const FESpace & fes = *GetFESpace();
   
     if (ntasks == 1)
-      {
-	Array<DofId> dnums;	    
-	// for (NODE_TYPE nt = NT_VERTEX; nt <= NT_CELL; nt++)
-        for (NODE_TYPE nt : { NT_VERTEX, NT_EDGE, NT_FACE, NT_CELL })
-	  {
-	    size_t nnodes = ma->GetNNodes (nt);
-
-	    Array<Vec<8, int> > nodekeys;
-	    Array<int> pnums, compress;
-	    for(size_t i = 0; i < nnodes; i++)
-	      {
-		fes.GetDofNrs (NodeId(nt, i),  dnums);
-		if (dnums.Size() == 0) continue;
-		
-		switch (nt)
-		  {
-		  case NT_VERTEX: pnums.SetSize(1); pnums[0] = i; break;
-		  case NT_EDGE: pnums = ma->GetEdgePNums (i); break;
-		  case NT_FACE: pnums = ma->GetFacePNums (i); break;
-		  case NT_CELL: pnums = ma->GetElVertices (ElementId(VOL,i)); break;
-                  default:
-                    __assume(false);
-                    break;
-		  }
-		Vec<8> key; 
-		key = -1;
-		for (int j = 0; j < pnums.Size(); j++)
-		  key[j] = pnums[j];
-		nodekeys.Append (key);
-		compress.Append (i);
-	      }
-	    
-	    nnodes = nodekeys.Size();
-
-	    Array<int> index(nnodes);
-	    for( int i = 0; i < index.Size(); i++) index[i] = i;
-	    
-	    QuickSortI (nodekeys, index, MyLess<8>);
-
-
-	    for( int i = 0; i < nnodes; i++)
-	      {
-		fes.GetDofNrs (NodeId(nt, compress[index[i]]),  dnums); 
-		Vector<SCAL> elvec(dnums.Size()*fes.GetDimension());
-		GetElementVector (dnums, elvec);
-		
-		for (int j = 0; j < elvec.Size(); j++)
-		  SaveBin<SCAL>(ost, elvec(j));			
-	      }
-	  }
-      }
+      SaveVector (ost, GetVector(), false);
 #ifdef PARALLEL	 
     else
       {  
@@ -621,6 +575,107 @@ namespace ngcomp
 #endif
   }
 
+  template <class SCAL>
+  void S_GridFunction<SCAL> :: SaveVector (ostream & ost, const BaseVector & v, bool sequential) const
+  {
+    const FESpace & fes = *GetFESpace();
+    Array<DofId> dnums;
+    for (NODE_TYPE nt : { NT_VERTEX, NT_EDGE, NT_FACE, NT_CELL })
+      {
+        size_t nnodes = ma->GetNNodes (nt);
+
+        Array<Vec<8, int> > nodekeys;
+        Array<int> pnums, compress;
+        for(size_t i = 0; i < nnodes; i++)
+          {
+            fes.GetDofNrs (NodeId(nt, i),  dnums);
+            if (dnums.Size() == 0) continue;
+
+            switch (nt)
+              {
+              case NT_VERTEX: pnums.SetSize(1); pnums[0] = i; break;
+              case NT_EDGE: pnums = ma->GetEdgePNums (i); break;
+              case NT_FACE: pnums = ma->GetFacePNums (i); break;
+              case NT_CELL: pnums = ma->GetElVertices (ElementId(VOL,i)); break;
+              default:
+                __assume(false);
+                break;
+              }
+            Vec<8> key;
+            key = -1;
+            for (int j = 0; j < pnums.Size(); j++)
+              key[j] = pnums[j];
+            nodekeys.Append (key);
+            compress.Append (i);
+          }
+
+        nnodes = nodekeys.Size();
+
+        Array<int> index(nnodes);
+        for( int i = 0; i < index.Size(); i++) index[i] = i;
+
+        if (!sequential)
+          ParallelRadixSortI (FlatArray<Vec<8,int>> (nodekeys), FlatArray<int> (index), 8,
+                              [] (const Vec<8,int> & key, int j) { return key[j]; });
+        else if (nnodes)
+          // same (stable, lexicographic) order as the radix sort
+          stable_sort (&index[0], &index[0]+nnodes,
+                       [&nodekeys] (int a, int b)
+                       {
+                         for (int j = 0; j < 8; j++)
+                           if (nodekeys[a][j] != nodekeys[b][j])
+                             return nodekeys[a][j] < nodekeys[b][j];
+                         return false;
+                       });
+
+        for( int i = 0; i < nnodes; i++)
+          {
+            fes.GetDofNrs (NodeId(nt, compress[index[i]]),  dnums);
+            Vector<SCAL> elvec(dnums.Size()*fes.GetDimension());
+            v.GetIndirect (dnums, elvec);
+
+            for (int j = 0; j < elvec.Size(); j++)
+              SaveBin<SCAL>(ost, elvec(j));
+          }
+      }
+  }
+
+
+  template <class SCAL>
+  void S_GridFunction<SCAL> :: SaveBackground (const string & filename, bool parallel) const
+  {
+    if (parallel && MyMPI_GetNTasks() > 1)
+      {
+        // SaveNodeType communicates, it stays on the calling thread
+        WaitSave();
+        ofstream out(filename, ios::binary);
+        Save (out);
+        return;
+      }
+
+    if (!save_writer)
+      save_writer = make_shared<AsyncWriter>();
+
+    // the snapshot is free once the previous file is written
+    save_writer->Wait();
+    const BaseVector & v = GetVector();
+    if (!save_snapshot || save_snapshot->Size() != v.Size() ||
+        save_snapshot->EntrySize() != v.EntrySize())
+      save_snapshot = v.CreateVector();
+    save_snapshot->FVDouble() = v.FVDouble();
+
+    auto snapshot = save_snapshot;
+    save_writer->Submit ([this, snapshot, filename, parallel] ()
+                         {
+                           ofstream out(filename, ios::binary);
+                           if (parallel)
+                             SaveVector (out, *snapshot, true);
+                           else
+                             for (auto d : snapshot->FVDouble())
+                               SaveBin (out, d);
+                         });
+  }
+
 
 
 
@@ -759,7 +814,8 @@ namespace ngcomp
 	static Timer ts ("Save Gridfunction, sort");
 	static Timer tw ("Save Gridfunction, write");
 	ts.Start();
-	QuickSortI (points, index, MyLess<N>);
+	ParallelRadixSortI (FlatArray<Vec<N,int>> (points), FlatArray<int> (index), N,
+			    [] (const Vec<N,int> & key, int j) { return key[j]; });
 	ts.Stop();
 
 	tw.Start();
@@ -780,6 +836,245 @@ namespace ngcomp
 
 
 
+#ifdef PARALLEL
+  template <typename T>
+  static void MyMPI_AllToAllV (FlatArray<T> send, FlatArray<int> sendcnt,
+                               Array<T> & recv, FlatArray<int> recvcnt, MPI_Comm comm)
+  {
+    int ntasks = sendcnt.Size();
+    Array<int> senddispl(ntasks), recvdispl(ntasks);
+    int ssum = 0, rsum = 0;
+    for (int p = 0; p < ntasks; p++)
+      {
+        senddispl[p] = ssum; ssum += sendcnt[p];
+        recvdispl[p] = rsum; rsum += recvcnt[p];
+      }
+    recv.SetSize (rsum);
+    MPI_Alltoallv (send.Size() ? &send[0] : nullptr, &sendcnt[0], &senddispl[0], MyGetMPIType<T>(),
+                   recv.Size() ? &recv[0] : nullptr, &recvcnt[0], &recvdispl[0], MyGetMPIType<T>(),
+                   comm);
+  }
+
+  /*
+    One node type of a collective checkpoint. A node is written (read)
+    by the rank owning the range of global vertex numbers its key starts
+    with. The owners sort their nodes by key, and their blocks follow in
+    the order of the ranks, so the file is the sorted sequence SaveNodeType
+    writes, independent of the partition and the number of ranks.
+  */
+  template <int N, NODE_TYPE NTYPE, class SCAL>
+  static void CollectiveNodeType (S_GridFunction<SCAL> & gf, MPI_File fh,
+                                  MPI_Offset & section_start, bool save)
+  {
+    static Timer t("GridFunction collective I/O"); RegionTimer reg(t);
+    MPI_Comm comm = ngs_comm;
+    int ntasks = MyMPI_GetNTasks (comm);
+
+    const FESpace & fes = *gf.GetFESpace();
+    const MeshAccess & ma = *gf.GetMeshAccess();
+    shared_ptr<ParallelDofs> par = fes.GetParallelDofs ();
+    int dim = fes.GetDimension();
+
+    // master nodes of this rank, key = global vertex numbers, number of values
+    Array<Vec<N+1,int>> keys;
+    Array<int> master_nodes;
+    Array<DofId> dnums;
+    Array<int> pnums;
+    int maxvert = -1;
+    for (size_t i = 0; i < ma.GetNNodes (NTYPE); i++)
+      {
+        fes.GetDofNrs (NodeId(NTYPE,i), dnums);
+        if (dnums.Size() == 0) continue;
+        if (!par->IsMasterDof (dnums[0])) continue;
+
+        switch (NTYPE)
+          {
+          case NT_VERTEX: pnums.SetSize(1); pnums[0] = i; break;
+          case NT_EDGE: pnums = ma.GetEdgePNums (i); break;
+          case NT_FACE: pnums = ma.GetFacePNums (i); break;
+          case NT_CELL: pnums = ma.GetElVertices (ElementId(VOL,i)); break;
+          }
+
+        Vec<N+1,int> key;
+        key = -1;
+        for (int j = 0; j < pnums.Size(); j++)
+          key[j] = ma.GetGlobalNodeNum (Node(NT_VERTEX, pnums[j]));
+        key[N] = dnums.Size() * dim;
+        maxvert = max2 (maxvert, key[0]);
+        keys.Append (key);
+        master_nodes.Append (i);
+      }
+
+    // owner ranks are monotone in the first key component
+    int nv = max2 (MyMPI_AllReduce (maxvert+1, MPI_MAX, comm), 1);
+    auto owner = [nv, ntasks] (int v) { return int ((size_t(max2(v,0)) * ntasks) / nv); };
+    auto comp = [] (const Vec<N+1,int> & key, int j) { return key[j]; };
+
+    // sorted by key, so grouped by owner
+    Array<int> index(keys.Size());
+    for (int i = 0; i < index.Size(); i++) index[i] = i;
+    ParallelRadixSortI (FlatArray<Vec<N+1,int>> (keys), FlatArray<int> (index), N, comp);
+
+    Array<int> sendcnt(ntasks), sendvcnt(ntasks);
+    sendcnt = 0;
+    sendvcnt = 0;
+    Array<int> sendkeys((N+1)*keys.Size());
+    for (int i = 0; i < index.Size(); i++)
+      {
+        auto & key = keys[index[i]];
+        sendcnt[owner(key[0])] += N+1;
+        sendvcnt[owner(key[0])] += key[N];
+        for (int k = 0; k <= N; k++)
+          sendkeys[(N+1)*i+k] = key[k];
+      }
+
+    Array<int> recvcnt(ntasks), recvvcnt(ntasks);
+    MyMPI_AllToAll (FlatArray<int> (sendcnt), FlatArray<int> (recvcnt), comm);
+    MyMPI_AllToAll (FlatArray<int> (sendvcnt), FlatArray<int> (recvvcnt), comm);
+    Array<int> recvkeys;
+    MyMPI_AllToAllV (FlatArray<int> (sendkeys), sendcnt, recvkeys, recvcnt, comm);
+
+    // nodes of this owner: values in the order received, and in the file
+    int nown = recvkeys.Size() / (N+1);
+    Array<Vec<N+1,int>> ownkeys(nown);
+    Array<size_t> recvpos(nown);
+    size_t nvals = 0;
+    for (int i = 0; i < nown; i++)
+      {
+        for (int k = 0; k <= N; k++)
+          ownkeys[i][k] = recvkeys[(N+1)*i+k];
+        recvpos[i] = nvals;
+        nvals += ownkeys[i][N];
+      }
+
+    Array<int> ownindex(nown);
+    for (int i = 0; i < nown; i++) ownindex[i] = i;
+    ParallelRadixSortI (FlatArray<Vec<N+1,int>> (ownkeys), FlatArray<int> (ownindex), N, comp);
+    Array<size_t> filepos(nown);
+    size_t pos = 0;
+    for (int i : ownindex)
+      {
+        filepos[i] = pos;
+        pos += ownkeys[i][N];
+      }
+
+    size_t first = 0;
+    MPI_Exscan (&nvals, &first, 1, MyGetMPIType<size_t>(), MPI_SUM, comm);
+    if (MyMPI_GetId (comm) == 0) first = 0;
+    size_t total = MyMPI_AllReduce (nvals, MPI_SUM, comm);
+    MPI_Offset offset = section_start + MPI_Offset (first * sizeof(SCAL));
+
+    Array<SCAL> filedata(nvals);
+    if (save)
+      {
+        Array<SCAL> sendvals;
+        for (int i : index)
+          {
+            fes.GetDofNrs (NodeId(NTYPE, master_nodes[i]), dnums);
+            Vector<SCAL> elvec(dnums.Size()*dim);
+            gf.GetElementVector (dnums, elvec);
+            for (int j = 0; j < elvec.Size(); j++)
+              sendvals.Append (elvec(j));
+          }
+        Array<SCAL> recvvals;
+        MyMPI_AllToAllV (FlatArray<SCAL> (sendvals), sendvcnt, recvvals, recvvcnt, comm);
+
+        for (int i = 0; i < nown; i++)
+          for (int j = 0; j < ownkeys[i][N]; j++)
+            filedata[filepos[i]+j] = recvvals[recvpos[i]+j];
+        MPI_File_write_at_all (fh, offset, nvals ? &filedata[0] : nullptr, nvals,
+                               MyGetMPIType<SCAL>(), MPI_STATUS_IGNORE);
+      }
+    else
+      {
+        MPI_File_read_at_all (fh, offset, nvals ? &filedata[0] : nullptr, nvals,
+                              MyGetMPIType<SCAL>(), MPI_STATUS_IGNORE);
+        Array<SCAL> sendvals(nvals);
+        for (int i = 0; i < nown; i++)
+          for (int j = 0; j < ownkeys[i][N]; j++)
+            sendvals[recvpos[i]+j] = filedata[filepos[i]+j];
+
+        // back to the ranks which sent the keys, in the order of their keys
+        Array<SCAL> myvals;
+        MyMPI_AllToAllV (FlatArray<SCAL> (sendvals), recvvcnt, myvals, sendvcnt, comm);
+        size_t cnt = 0;
+        for (int i : index)
+          {
+            fes.GetDofNrs (NodeId(NTYPE, master_nodes[i]), dnums);
+            Vector<SCAL> elvec(dnums.Size()*dim);
+            for (int j = 0; j < elvec.Size(); j++)
+              elvec(j) = myvals[cnt++];
+            gf.SetElementVector (dnums, elvec);
+          }
+      }
+
+    section_start += MPI_Offset (total * sizeof(SCAL));
+  }
+#endif
+
+
+  template <class SCAL>
+  void S_GridFunction<SCAL> :: SaveCollective (const string & filename) const
+  {
+    if (MyMPI_GetNTasks() == 1)
+      {
+        ofstream out(filename, ios::binary);
+        Save (out);
+        return;
+      }
+#ifdef PARALLEL
+    GetVector().Cumulate();
+
+    MPI_File fh;
+    if (MPI_File_open (ngs_comm, const_cast<char*> (filename.c_str()),
+                       MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+      throw Exception ("GridFunction::SaveCollective: cannot open file '" + filename + "'");
+    MPI_File_set_size (fh, 0);
+
+    auto & self = const_cast<S_GridFunction<SCAL>&> (*this);
+    MPI_Offset start = 0;
+    CollectiveNodeType<1,NT_VERTEX> (self, fh, start, true);
+    CollectiveNodeType<2,NT_EDGE> (self, fh, start, true);
+    CollectiveNodeType<4,NT_FACE> (self, fh, start, true);
+    CollectiveNodeType<8,NT_CELL> (self, fh, start, true);
+    MPI_File_close (&fh);
+#endif
+  }
+
+  template <class SCAL>
+  void S_GridFunction<SCAL> :: LoadCollective (const string & filename)
+  {
+    if (MyMPI_GetNTasks() == 1)
+      {
+        ifstream in(filename, ios::binary);
+        if (!in)
+          throw Exception ("GridFunction::LoadCollective: cannot open file '" + filename + "'");
+        Load (in);
+        return;
+      }
+#ifdef PARALLEL
+    MPI_File fh;
+    if (MPI_File_open (ngs_comm, const_cast<char*> (filename.c_str()),
+                       MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+      throw Exception ("GridFunction::LoadCollective: cannot open file '" + filename + "'");
+
+    // only master dofs are read
+    GetVector() = 0.0;
+    GetVector().SetParallelStatus (DISTRIBUTED);
+    MPI_Offset start = 0;
+    CollectiveNodeType<1,NT_VERTEX> (*this, fh, start, false);
+    CollectiveNodeType<2,NT_EDGE> (*this, fh, start, false);
+    CollectiveNodeType<4,NT_FACE> (*this, fh, start, false);
+    CollectiveNodeType<8,NT_CELL> (*this, fh, start, false);
+    MPI_File_close (&fh);
+    GetVector().Cumulate();
+#endif
+  }
+
+
+
+
+
   template <class SCAL>
   S_ComponentGridFunction<SCAL> :: 
   S_ComponentGridFunction (const S_GridFunction<SCAL> & agf_parent, int acomp)
@@ -1156,6 +1451,57 @@ namespace ngcomp
 
 
 
+  /*
+    Finite element and dof numbers of the current element, shared by all
+    GridFunctionCoefficientFunctions on the same space which are evaluated
+    for the same ProxyUserData (i.e. within one element of an integrator).
+    One entry per space, a few spaces are kept per thread.
+  */
+  namespace
+  {
+    struct GFElementCacheEntry
+    {
+      size_t stamp = 0;
+      const FESpace * fes = nullptr;
+      ElementId ei = ElementId(VOL, -1);
+      const FiniteElement * fel = nullptr;
+      Array<int> dnums;
+      LocalHeap lh { 100000, "GridFunctionCF - element cache" };
+    };
+
+    const FiniteElement & GetElementData (const FESpace & fes, ElementId ei,
+                                          const ProxyUserData * ud,
+                                          Array<int> & dnums, LocalHeap & lh)
+    {
+      if (!ud)
+        {
+          fes.GetDofNrs (ei, dnums);
+          return fes.GetFE (ei, lh);
+        }
+
+      constexpr int NCACHE = 4;
+      static thread_local GFElementCacheEntry cache[NCACHE];
+      static thread_local int next = 0;
+      for (auto & entry : cache)
+        if (entry.stamp == ud->stamp && entry.fes == &fes && entry.ei == ei)
+          {
+            dnums = entry.dnums;
+            return *entry.fel;
+          }
+
+      auto & entry = cache[next];
+      next = (next+1) % NCACHE;
+      entry.lh.CleanUp();
+      entry.fel = &fes.GetFE (ei, entry.lh);
+      fes.GetDofNrs (ei, entry.dnums);
+      entry.stamp = ud->stamp;
+      entry.fes = &fes;
+      entry.ei = ei;
+      dnums = entry.dnums;
+      return *entry.fel;
+    }
+  }
+
   void GridFunctionCoefficientFunction :: 
   Evaluate (const BaseMappedIntegrationPoint & ip, FlatVector<> result) const
   {
@@ -1198,8 +1544,8 @@ namespace ngcomp
     const FiniteElement & fel = fes->GetFE (ei, lh2);
     int dim = fes->GetDimension();
     
-    ArrayMem<int, 50> dnums;
-    fes->GetDofNrs (ei, dnums);
+    ArrayMem<int, 50> dnums_mem;
+    FlatArray<int> dnums = fes->GetElementDofNrs (ei, dnums_mem);
     
     VectorMem<50> elu(dnums.Size()*dim);
 
@@ -1263,8 +1609,8 @@ namespace ngcomp
     const FiniteElement & fel = fes->GetFE (ei, lh2);
     int dim = fes->GetDimension();
     
-    ArrayMem<int, 50> dnums;
-    fes->GetDofNrs (ei, dnums);
+    ArrayMem<int, 50> dnums_mem;
+    FlatArray<int> dnums = fes->GetElementDofNrs (ei, dnums_mem);
     
     VectorMem<50, Complex> elu(dnums.Size()*dim);
 
@@ -1323,8 +1669,8 @@ namespace ngcomp
     const FiniteElement & fel = fes->GetFE (ei, lh2);
     int dim = fes->GetDimension();
 
-    ArrayMem<int, 50> dnums;
-    fes->GetDofNrs (ei, dnums);
+    ArrayMem<int, 50> dnums_mem;
+    FlatArray<int> dnums = fes->GetElementDofNrs (ei, dnums_mem);
     
     VectorMem<50> elu(dnums.Size()*dim);
 
@@ -1385,8 +1731,8 @@ namespace ngcomp
     const FiniteElement & fel = fes->GetFE (ei, lh2);
     int dim = fes->GetDimension();
 
-    ArrayMem<int, 50> dnums;
-    fes->GetDofNrs (ei, dnums);
+    ArrayMem<int, 50> dnums_mem;
+    FlatArray<int> dnums = fes->GetElementDofNrs (ei, dnums_mem);
     
     VectorMem<50,Complex> elu(dnums.Size()*dim);
 
@@ -1457,11 +1803,10 @@ namespace ngcomp
         return;
       }
     
-    const FiniteElement & fel = fes->GetFE (ei, lh2);
     int dim = fes->GetDimension();
 
     ArrayMem<int, 50> dnums;
-    fes->GetDofNrs (ei, dnums);
+    const FiniteElement & fel = GetElementData (*fes, ei, ud, dnums, lh2);
     
     VectorMem<50> elu(dnums.Size()*dim);
 
@@ -1534,11 +1879,11 @@ namespace ngcomp
         return;
       }
     
-    const FiniteElement & fel = fes.GetFE (ei, lh2);
     int dim = fes.GetDimension();
 
     ArrayMem<int, 50> dnums;
-    fes.GetDofNrs (ei, dnums);
+    ProxyUserData * ud = (ProxyUserData*)trafo.userdata;
+    const FiniteElement & fel = GetElementData (fes, ei, ud, dnums, lh2);
     
     VectorMem<50, Complex> elu(dnums.Size()*dim);
 
@@ -123,6 +123,9 @@ namespace ngcomp
     /// component GridFunctions if fespace is a CompoundFESpace
     Array<shared_ptr<GridFunction>> compgfs;
     shared_ptr<GridFunctionCoefficientFunction> derivcf;
+    /// snapshot of the vector written by SaveBackground, and its writer
+    mutable shared_ptr<BaseVector> save_snapshot;
+    mutable shared_ptr<AsyncWriter> save_writer;
   public:
     /// 
     GridFunction (shared_ptr<FESpace> afespace, 
@@ -139,6 +142,8 @@ namespace ngcomp
     virtual const BaseVector & GetVector (int comp = 0) const  { return *vec[comp]; }
     ///  
     virtual shared_ptr<BaseVector> GetVectorPtr (int comp = 0) const  { return vec[comp]; }
+    /// use v (e.g. a SharedVector) as coefficient vector, keeps the values of v
+    void SetVector (shared_ptr<BaseVector> v, int comp = 0);
     ///
     void SetNested (int anested = 1) { nested = anested; }
     ///
@@ -254,6 +259,26 @@ namespace ngcomp
 
     virtual void Load (istream & ist) = 0;
     virtual void Save (ostream & ost) const = 0;
+
+    /**
+       Checkpoint in the format of Save, written by all ranks with MPI-IO
+       instead of gathered to the master. Files can be loaded on a
+       different number of ranks. Collective over all ranks.
+    */
+    virtual void SaveCollective (const string & filename) const = 0;
+    virtual void LoadCollective (const string & filename) = 0;
+
+    /**
+       Save without blocking the caller: the vector is copied to a
+       snapshot, ordering and writing run on a background thread. The
+       snapshot is reused, the next call waits for the previous file.
+       parallel selects the format of Save, otherwise the raw vector is
+       written. Distributed vectors in the format of Save are written
+       synchronously.
+    */
+    virtual void SaveBackground (const string & filename, bool parallel) const = 0;
+    /// waits until the file of SaveBackground is written
+    void WaitSave () const { if (save_writer) save_writer->Wait(); }
   };
 
 
@@ -283,7 +308,15 @@ namespace ngcomp
     virtual void Load (istream & ist);
     virtual void Save (ostream & ost) const;
 
+    virtual void SaveCollective (const string & filename) const;
+    virtual void LoadCollective (const string & filename);
+
+    virtual void SaveBackground (const string & filename, bool parallel) const;
+
   private:
+    /// Save of a sequential vector, sequential = true does not use the task manager
+    void SaveVector (ostream & ost, const BaseVector & v, bool sequential) const;
+
     template <int N, NODE_TYPE NT> void LoadNodeType (istream & ist);
 
     template <int N, NODE_TYPE NT> void SaveNodeType (ostream & ost) const;
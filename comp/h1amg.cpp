@@ -3,148 +3,56 @@ using namespace ngcomp;
 
 
 
-#include "../linalg/concurrentqueue.h"
-typedef moodycamel::ConcurrentQueue<size_t> TQueue; 
-typedef moodycamel::ProducerToken TPToken; 
-typedef moodycamel::ConsumerToken TCToken; 
-
-
-
 namespace ngcomp
 {
 
-  static TQueue queue;
-
-  template <typename TFUNC>
-  void RunParallelDependency (FlatTable<int> dag,
-                              TFUNC func)
-  {
-    Array<atomic<int>> cnt_dep(dag.Size());
-
-    for (auto & d : cnt_dep) 
-      d.store (0, memory_order_relaxed);
-
-    static Timer t_cntdep("count dep");
-    t_cntdep.Start();
-    ParallelFor (Range(dag),
-                 [&] (int i)
-                 {
-                   for (int j : dag[i])
-                     cnt_dep[j]++;
-                 });
-    t_cntdep.Stop();    
-
-    atomic<size_t> num_ready(0), num_final(0);
-    ParallelForRange (cnt_dep.Size(), [&] (IntRange r)
-                      {
-                        size_t my_ready = 0, my_final = 0;
-                        for (size_t i : r)
-                          {
-                            if (cnt_dep[i] == 0) my_ready++;
-                            if (dag[i].Size() == 0) my_final++;
-                          }
-                        num_ready += my_ready;
-                        num_final += my_final;
-                      });
-
-    Array<int> ready(num_ready);
-    ready.SetSize0();
-    for (int j : Range(cnt_dep))
-      if (cnt_dep[j] == 0) ready.Append(j);
-
-    
-    if (!task_manager)
-      // if (true)
-      {
-        while (ready.Size())
-          {
-            int size = ready.Size();
-            int nr = ready[size-1];
-            ready.SetSize(size-1);
-            
-            func(nr);
-            
-            for (int j : dag[nr])
-              {
-                cnt_dep[j]--;
-                if (cnt_dep[j] == 0)
-                  ready.Append(j);
-              }
-          }
-        return;
-      }
-
-    atomic<int> cnt_final(0);
-    SharedLoop2 sl(Range(ready));
-
-    task_manager -> CreateJob 
-      ([&] (const TaskInfo & ti)
-       {
-         size_t my_final = 0;
-         TPToken ptoken(queue); 
-         TCToken ctoken(queue); 
-        
-         for (int i : sl)
-           queue.enqueue (ptoken, ready[i]);
-
-         while (1)
-           {
-             if (cnt_final >= num_final) break;
-
-             int nr;
-             if(!queue.try_dequeue_from_producer(ptoken, nr)) 
-               if(!queue.try_dequeue(ctoken, nr))
-                 {
-                   if (my_final)
-                     {
-                       cnt_final += my_final;
-                       my_final = 0;
-                     }
-                   continue;
-                 }
-
-             if (dag[nr].Size() == 0)
-               my_final++;
-             // cnt_final++;
-
-             func(nr);
-
-             for (int j : dag[nr])
-               {
-                 if (--cnt_dep[j] == 0)
-                   queue.enqueue (ptoken, j);
-               }
-           }
-       });
-  }
-
-
-
-
-
-
-
-
-  
-
   template <class SCAL>
   class H1AMG_Matrix : public BaseMatrix
   {
     size_t size;
     shared_ptr<SparseMatrixTM<SCAL>> mat;
+    shared_ptr<BitArray> freedofs;
     shared_ptr<BaseBlockJacobiPrecond> smoother;
+    shared_ptr<Table<int>> smoothing_blocks;
+    /// replaces the block Gauss-Seidel smoother if set
+    shared_ptr<ChebyshevPrecond> chebyshev;
+    int chebyshev_degree;
     shared_ptr<SparseMatrixTM<double>> prolongation, restriction;
+    shared_ptr<BaseSparseMatrix> coarsemat;
+    shared_ptr<BitArray> coarse_freedofs;
     shared_ptr<BaseMatrix> coarse_precond;
     int smoothing_steps = 1;
+
+    void BuildSmoother ()
+    {
+      if (chebyshev_degree > 0)
+        {
+          auto dmat = dynamic_pointer_cast<SparseMatrixTM<double>> (mat);
+          if (!dmat)
+            throw Exception ("H1AMG: Chebyshev smoother needs a real matrix");
+          chebyshev = make_shared<ChebyshevPrecond> (*dmat, freedofs, chebyshev_degree);
+        }
+      else
+        smoother = mat->CreateBlockJacobiPrecond(smoothing_blocks);
+    }
+
+    void BuildCoarsePrecond ()
+    {
+      if (auto coarse_amg = dynamic_pointer_cast<H1AMG_Matrix> (coarse_precond))
+        coarse_amg->UpdateValues (dynamic_pointer_cast<SparseMatrixTM<SCAL>> (coarsemat));
+      else
+        coarse_precond = coarsemat->InverseMatrix(coarse_freedofs);
+    }
     
   public:
     H1AMG_Matrix (shared_ptr<SparseMatrixTM<SCAL>> amat,
-                  shared_ptr<BitArray> freedofs,
+                  shared_ptr<BitArray> afreedofs,
                   FlatArray<INT<2>> e2v,
                   FlatArray<double> edge_weights,
                   FlatArray<double> vertex_weights,
-                  size_t level)
-      : mat(amat)
+                  size_t level,
+                  int achebyshev_degree = 0)
+      : mat(amat), freedofs(afreedofs), chebyshev_degree(achebyshev_degree)
     {
       static Timer t("H1AMG"); RegionTimer reg(t);
       
@@ -157,8 +65,8 @@ namespace ngcomp
 
       Array<double> edge_collapse_weights(num_edges);
       Array<double> sum_vertex_weights(num_vertices);
-      for (auto i : Range(num_vertices))
-        sum_vertex_weights[i] = vertex_weights[i];
+      ParallelFor (num_vertices, [&] (size_t i)
+                   { sum_vertex_weights[i] = vertex_weights[i]; });
 
       ParallelFor (num_edges, [&] (size_t i)
                    {
@@ -235,8 +143,7 @@ namespace ngcomp
                      }, TasksPerThread(5));
       Table<int> edge_dag = edge_dag_creator.MoveTable();
     
-      RunParallelDependency (edge_dag,
-                             [&] (int edgenr)
+      TaskGraph(edge_dag).Run ([&] (int edgenr)
                              {
                                auto v0 = e2v[edgenr][0];
                                auto v1 = e2v[edgenr][1];
@@ -249,37 +156,55 @@ namespace ngcomp
                              });
       edge_dag = Table<int>();
       
-      // collapse the larger vertex
+      // collapse the larger vertex, a vertex is in at most one collapsed edge
       vertex_collapse = false;
-      for (int e = 0; e < num_edges; e++)
-        if (edge_collapse[e])
-          {
-            auto v0 = e2v[e][0];
-            auto v1 = e2v[e][1];
-            vertex_collapse[max2(v0,v1)] = true;
-          }
+      ParallelFor (num_edges, [&] (size_t e)
+                   {
+                     if (edge_collapse[e])
+                       vertex_collapse[max2(e2v[e][0], e2v[e][1])] = true;
+                   });
 
       BitArray isolated_verts(num_vertices);
       isolated_verts.Clear();
-      for (size_t i = 0; i < num_vertices; i++)
-        if (sum_vertex_weights[i] == vertex_weights[i])
-          isolated_verts.Set(i);
+      ParallelFor (num_vertices, [&] (size_t i)
+                   {
+                     if (sum_vertex_weights[i] == vertex_weights[i])
+                       isolated_verts.Set(i);
+                   });
       
-      // vertex 2 coarse vertex
+      // vertex 2 coarse vertex, numbered by a parallel prefix sum
       Array<size_t> v2cv(num_vertices);
-      size_t num_coarse_vertices = 0;
-      v2cv = -1; 
-      for (size_t i = 0; i < num_vertices; i++)
-        if (!vertex_collapse[i] && !isolated_verts.Test(i))
-          v2cv[i] = num_coarse_vertices++;
-      for (size_t e = 0; e < num_edges; e++)
-        if (edge_collapse[e])
-          {
-            auto v0 = e2v[e][0];
-            auto v1 = e2v[e][1];
-            if (v0 > v1) Swap (v0,v1);
-            v2cv[v1] = v2cv[v0];
-          }
+      auto is_coarse = [&] (size_t i) { return !vertex_collapse[i] && !isolated_verts.Test(i); };
+      Array<size_t> partial_sums(TaskManager::GetNumThreads()+1);
+      partial_sums[0] = 0;
+      ParallelJob
+        ([&] (TaskInfo ti)
+         {
+           size_t mysum = 0;
+           for (size_t i : IntRange(num_vertices).Split(ti.task_nr, ti.ntasks))
+             if (is_coarse(i)) mysum++;
+           partial_sums[ti.task_nr+1] = mysum;
+         });
+      for (size_t i = 1; i < partial_sums.Size(); i++)
+        partial_sums[i] += partial_sums[i-1];
+      size_t num_coarse_vertices = partial_sums.Last();
+      ParallelJob
+        ([&] (TaskInfo ti)
+         {
+           size_t cnt = partial_sums[ti.task_nr];
+           for (size_t i : IntRange(num_vertices).Split(ti.task_nr, ti.ntasks))
+             v2cv[i] = is_coarse(i) ? cnt++ : -1;
+         });
+      ParallelFor (num_edges, [&] (size_t e)
+                   {
+                     if (edge_collapse[e])
+                       {
+                         auto v0 = e2v[e][0];
+                         auto v1 = e2v[e][1];
+                         if (v0 > v1) Swap (v0,v1);
+                         v2cv[v1] = v2cv[v0];
+                       }
+                   });
 
       // edge to coarse edge
       
@@ -365,26 +290,30 @@ namespace ngcomp
       
 
       // build smoother
-      TableCreator<int> smoothing_blocks_creator(num_coarse_vertices);
-      for ( ; !smoothing_blocks_creator.Done(); smoothing_blocks_creator++)
-        ParallelFor (v2cv.Size(), [&] (size_t v)
-                     {
-                       if (v2cv[v] != -1 && (*freedofs)[v])
-                         smoothing_blocks_creator.Add (v2cv[v], v);
-                     });
-
-      auto blocks = make_shared<Table<int>> (smoothing_blocks_creator.MoveTable());
-      smoother = mat->CreateBlockJacobiPrecond(blocks);
+      if (chebyshev_degree == 0)
+        {
+          TableCreator<int> smoothing_blocks_creator(num_coarse_vertices);
+          for ( ; !smoothing_blocks_creator.Done(); smoothing_blocks_creator++)
+            ParallelFor (v2cv.Size(), [&] (size_t v)
+                         {
+                           if (v2cv[v] != -1 && (*freedofs)[v])
+                             smoothing_blocks_creator.Add (v2cv[v], v);
+                         });
+          smoothing_blocks = make_shared<Table<int>> (smoothing_blocks_creator.MoveTable());
+        }
+      BuildSmoother();
 
       // build prolongation
       Array<int> nne(num_vertices);
 
-      for (int i = 0; i < num_vertices; i++)
-        nne[i] = (v2cv[i] != -1) ? 1 : 0;
+      ParallelFor (num_vertices, [&] (size_t i)
+                   { nne[i] = (v2cv[i] != -1) ? 1 : 0; });
       prolongation = make_shared<SparseMatrix<double>> (nne, num_coarse_vertices);
-      for (int i = 0; i < num_vertices; i++)
-        if (v2cv[i] != -1)
-          (*prolongation)(i, v2cv[i]) = 1;
+      ParallelFor (num_vertices, [&] (size_t i)
+                   {
+                     if (v2cv[i] != -1)
+                       (*prolongation)(i, v2cv[i]) = 1;
+                   });
 
       // smoothed prolongation
       if (level % 4 == 2)
@@ -418,10 +347,10 @@ namespace ngcomp
           prolongation = MatMult (*smoothprol, *prolongation);
         }
 
-      auto coarsemat = mat -> Restrict (*prolongation);
+      coarsemat = mat -> Restrict (*prolongation);
 
       // coarse freedofs
-      auto coarse_freedofs = make_shared<BitArray> (num_coarse_vertices);
+      coarse_freedofs = make_shared<BitArray> (num_coarse_vertices);
       coarse_freedofs->Clear();
       ParallelFor(v2cv.Size(), [&] (int v)
                   {
@@ -432,16 +361,66 @@ namespace ngcomp
       if (num_coarse_vertices < 10)
 	{
 	  coarsemat->SetInverseType(SPARSECHOLESKY);
-	  coarse_precond = coarsemat->InverseMatrix(coarse_freedofs);
+	  BuildCoarsePrecond();
 	}
       else
         coarse_precond = make_shared<H1AMG_Matrix> (dynamic_pointer_cast<SparseMatrixTM<SCAL>> (coarsemat), coarse_freedofs,
-                                                    coarse_e2v, coarse_edge_weights, coarse_vertex_weights, level+1);
+                                                    coarse_e2v, coarse_edge_weights, coarse_vertex_weights, level+1,
+                                                    chebyshev_degree);
 
 
       restriction = TransposeMatrix (*prolongation);
     }
 
+    /**
+       New matrix values on the same graph: the coarsening and the 
+       prolongations are kept, the Galerkin products reuse their 
+       structure, only smoothers and the coarsest inverse are rebuilt.
+     */
+    void UpdateValues (shared_ptr<SparseMatrixTM<SCAL>> amat)
+    {
+      static Timer t("H1AMG::UpdateValues"); RegionTimer reg(t);
+      mat = amat;
+      BuildSmoother();
+      coarsemat = mat -> Restrict (*prolongation, coarsemat);
+      BuildCoarsePrecond();
+    }
+
+#ifdef CUDA
+    /**
+       Appends device copies of this and the coarser levels, levels
+       with less than host_size dofs stay on the host. The block
+       Gauss-Seidel smoother is replaced by damped block Jacobi.
+    */
+    void AddDeviceLevels (DevMultiLevelMatrix & dev, size_t host_size, double damping)
+    {
+      auto dmat = dynamic_pointer_cast<SparseMatrix<double>> (mat);
+      if (!dmat)
+        throw Exception ("H1AMG: device levels need a real matrix");
+      if (size < host_size)
+        {
+          dev.SetCoarseMatrix (shared_from_this());
+          return;
+        }
+
+      auto devmat = make_shared<DevSparseMatrix> (*dmat);
+      shared_ptr<BaseMatrix> devsmoother;
+      if (chebyshev)
+        devsmoother = make_shared<DevChebyshevPrecond> (devmat, *chebyshev);
+      else
+        devsmoother = make_shared<DevBlockJacobiPrecond> (*dmat, *smoothing_blocks, damping);
+      auto prol = dynamic_pointer_cast<SparseMatrix<double>> (prolongation);
+      auto rest = dynamic_pointer_cast<SparseMatrix<double>> (restriction);
+      dev.AddLevel (devmat, devsmoother,
+                    make_shared<DevSparseMatrix> (*prol), make_shared<DevSparseMatrix> (*rest));
+
+      if (auto coarse_amg = dynamic_pointer_cast<H1AMG_Matrix> (coarse_precond))
+        coarse_amg->AddDeviceLevels (dev, host_size, damping);
+      else
+        dev.SetCoarseMatrix (coarse_precond);
+    }
+#endif
+
     virtual int VHeight() const override { return size; }
     virtual int VWidth() const override { return size; }
 
@@ -455,7 +434,11 @@ namespace ngcomp
       static Timer t("H1AMG::Mult"); RegionTimer reg(t);      
       x = 0;
 
-      smoother->GSSmooth(x, b, smoothing_steps);
+      if (chebyshev)
+        for (int i = 0; i < smoothing_steps; i++)
+          chebyshev->Smooth (x, b);
+      else
+        smoother->GSSmooth(x, b, smoothing_steps);
       auto residuum = b.CreateVector();
       residuum = b - (*mat) * x;
 
@@ -466,7 +449,11 @@ namespace ngcomp
       coarse_precond->Mult(coarse_residuum, coarse_x);
     
       x += *prolongation * coarse_x;
-      smoother->GSSmoothBack (x, b, smoothing_steps);
+      if (chebyshev)
+        for (int i = 0; i < smoothing_steps; i++)
+          chebyshev->Smooth (x, b);
+      else
+        smoother->GSSmoothBack (x, b, smoothing_steps);
     }
   };
 
@@ -478,6 +465,19 @@ namespace ngcomp
 
     ParallelHashTable<INT<2>,double> edge_weights_ht;
     ParallelHashTable<INT<1>,double> vertex_weights_ht;
+    /// flag "smoother": "block" (Gauss-Seidel) or "chebyshev"
+    int chebyshev_degree = 0;
+    /// flag "reusehierarchy": keep the coarsening for new matrix values
+    bool reuse_hierarchy = false;
+#ifdef CUDA
+    /// flag "device": V-cycle on the device, for DevCGSolver
+    bool device = false;
+    /// flag "devicehostsize": coarser levels stay on the host
+    size_t device_host_size = 1000;
+    /// flag "devicedamping": damping of the device block Jacobi smoother
+    double device_damping = 0.5;
+    shared_ptr<DevMultiLevelMatrix> devmat;
+#endif
   
   public:
   
@@ -486,6 +486,17 @@ namespace ngcomp
       : Preconditioner (abfa, aflags, aname)
     {
       cout << IM(5) << "Create H1AMG" << endl;
+      string smoother = flags.GetStringFlag ("smoother", "block");
+      if (smoother == "chebyshev")
+        chebyshev_degree = int(flags.GetNumFlag ("chebyshevdegree", 3));
+      else if (smoother != "block")
+        throw Exception ("H1AMG: unknown smoother '" + smoother + "'");
+      reuse_hierarchy = flags.GetDefineFlag ("reusehierarchy");
+#ifdef CUDA
+      device = flags.GetDefineFlag ("device");
+      device_host_size = size_t(flags.GetNumFlag ("devicehostsize", 1000));
+      device_damping = flags.GetNumFlag ("devicedamping", 0.5);
+#endif
     }
 
     H1AMG_Preconditioner (const PDE & pde, const Flags & aflags, const string & aname)
@@ -497,12 +508,22 @@ namespace ngcomp
     virtual void InitLevel (shared_ptr<BitArray> _freedofs) 
     {
       freedofs = _freedofs;
+      // a new space needs a new hierarchy
+      if (mat && (!freedofs || freedofs->Size() != mat->Height()))
+        mat = nullptr;
     }
 
     virtual void FinalizeLevel (const BaseMatrix * matrix)
     {
       auto smat = dynamic_pointer_cast<SparseMatrixTM<SCAL>> (const_cast<BaseMatrix*>(matrix)->shared_from_this());
 
+      if (reuse_hierarchy && mat)
+        {
+          mat->UpdateValues (smat);
+          BuildDeviceLevels();
+          return;
+        }
+
       size_t num_vertices = matrix->Height();
       size_t num_edges = edge_weights_ht.Used();
 
@@ -526,7 +547,19 @@ namespace ngcomp
          });
       vertex_weights_ht = ParallelHashTable<INT<1>,double>();
       
-      mat = make_shared<H1AMG_Matrix<double>> (smat, freedofs, e2v, edge_weights, vertex_weights, 0);
+      mat = make_shared<H1AMG_Matrix<double>> (smat, freedofs, e2v, edge_weights, vertex_weights, 0,
+                                               chebyshev_degree);
+      BuildDeviceLevels();
+    }
+
+    void BuildDeviceLevels ()
+    {
+#ifdef CUDA
+      if (!device) return;
+      devmat = make_shared<DevMultiLevelMatrix> ();
+      mat->AddDeviceLevels (*devmat, device_host_size, device_damping);
+      cout << IM(3) << "H1AMG: " << devmat->NumLevels() << " levels on the device" << endl;
+#endif
     }
 
 
@@ -541,6 +574,8 @@ namespace ngcomp
       static Timer t3("h1amg - addelmat calc e-schur");
       static Timer t5("h1amg - addelmat invert");
       
+      // the weights only define the coarsening
+      if (reuse_hierarchy && mat) return;
       ThreadRegionTimer reg (t, TaskManager::GetThreadId());
       
       size_t ndof = dnums.Size();
@@ -621,6 +656,9 @@ namespace ngcomp
 
     virtual const BaseMatrix & GetMatrix() const
     {
+#ifdef CUDA
+      if (devmat) return *devmat;
+#endif
       return *mat;
     }
 
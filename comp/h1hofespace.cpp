@@ -14,6 +14,7 @@
 #include "../fem/h1hofefo.hpp"
 #include <../fem/hdivhofe.hpp>
 #include <../fem/facethofe.hpp>  
+#include <unordered_map>
 
 using namespace ngmg; 
 
@@ -100,6 +101,74 @@ namespace ngcomp
 
 
 
+  /**
+     Elements of equal ClassKey share one immutable finite element,
+     which carries the vertex ranks instead of the vertex numbers.
+     Every thread owns its table, so lookups need no locking; the
+     memory budget is shared by all threads.
+  */
+  class H1HighOrderFESpace::FECache
+  {
+    typedef std::array<unsigned char,5*sizeof(size_t)> Key;
+
+    struct KeyHash
+    {
+      size_t operator() (const Key & key) const
+      {
+        size_t h = 0;
+        for (auto k : key)
+          h = h * 0x9e3779b97f4a7c15ull + k;
+        return h;
+      }
+    };
+
+    typedef std::unordered_map<Key, unique_ptr<FiniteElement>, KeyHash> T_Table;
+    Array<T_Table> tables;
+    atomic<size_t> mem;
+    size_t maxmem;
+    
+  public:
+    FECache (size_t amaxmem)
+      : tables(TaskManager::GetMaxThreads()), mem(0), maxmem(amaxmem) { ; }
+
+    /// the shared element of fe's class, or a copy of fe in alloc if the cache is full
+    template <ELEMENT_TYPE ET>
+    FiniteElement & Get (const H1HighOrderFE<ET> & fe, Allocator & alloc)
+    {
+      size_t tid = TaskManager::GetThreadId();
+      if (tid >= tables.Size())
+        return *new (alloc) H1HighOrderFE<ET> (fe);
+
+      auto & table = tables[tid];
+      Key key = fe.ClassKey();
+      auto pos = table.find(key);
+      if (pos != table.end()) return *pos->second;
+
+      size_t bytes = sizeof(H1HighOrderFE<ET>) + sizeof(Key) + 4*sizeof(void*);
+      if (mem.fetch_add (bytes, memory_order_relaxed) + bytes > maxmem)
+        {
+          mem.fetch_sub (bytes, memory_order_relaxed);
+          return *new (alloc) H1HighOrderFE<ET> (fe);
+        }
+
+      auto shared = make_unique<H1HighOrderFE<ET>> (fe);
+      for (int i = 0; i < ET_trait<ET>::N_VERTEX; i++)
+        shared -> SetVertexNumber (i, key[2+i]);
+      FiniteElement & ref = *shared;
+      table[key] = move(shared);
+      return ref;
+    }
+
+    size_t NBytes () const { return mem; }
+    size_t NClasses () const
+    {
+      size_t n = 0;
+      for (auto & table : tables) n += table.size();
+      return n;
+    }
+  };
+
+  
   H1HighOrderFESpace ::  
   H1HighOrderFESpace (shared_ptr<MeshAccess> ama, const Flags & flags, bool parseflags)
     : FESpace (ama, flags)
@@ -164,6 +233,8 @@ namespace ngcomp
     if (flags.NumFlagDefined("smoothing")) 
       throw Exception ("Flag 'smoothing' for fespace is obsolete \n Please use flag 'blocktype' in preconditioner instead");
     nodalp2 = flags.GetDefineFlag ("nodalp2");
+    fe_cache_memory = flags.GetDefineFlag ("fe_cache") ?
+      size_t(flags.GetNumFlag ("fe_cache_memory", 16 << 20)) : 0;
           
     Flags loflags;
     loflags.SetFlag ("order", 1);
@@ -275,6 +346,12 @@ into the wirebasket.
       "  use lowest-order edge dofs for BDDC wirebasket";
     docu.Arg("wb_fulledges") = "bool = false\n"
       "  use all edge dofs for BDDC wirebasket";
+    docu.Arg("fe_cache") = "bool = false\n"
+      "  GetFE returns one shared element for all elements with equal\n"
+      "  type, orders and vertex ordering";
+    docu.Arg("fe_cache_memory") = "int = 16777216\n"
+      "  memory budget of the element cache in bytes, elements beyond\n"
+      "  the budget are built as usual";
     return docu;
   }
 
@@ -290,8 +367,22 @@ into the wirebasket.
     // timer1.Start();
     FESpace :: Update (lh);
 
+    // orders may have changed
+    fe_cache.reset();
+    if (fe_cache_memory > 0)
+      fe_cache = make_unique<FECache> (fe_cache_memory);
+
     if (order_policy == CONSTANT_ORDER)
       fixed_order = true;
+    else if (order_policy != OLDSTYLE_ORDER)
+      fixed_order = false;
+
+    // uniform order without per-type or per-node modifications:
+    // GetFE can use the statically sized elements
+    if (!var_order && order_policy == OLDSTYLE_ORDER && !nodalp2 &&
+        uniform_order_inner == -1 && uniform_order_face == -1 && uniform_order_edge == -1 &&
+        et_bonus_order[ET_SEGM] == 0 && et_bonus_order[ET_TRIG] == 0 && et_bonus_order[ET_TET] == 0)
+      fixed_order = true;
     
     TORDER maxorder = 0;
     TORDER minorder = 99; 
@@ -475,14 +566,14 @@ into the wirebasket.
 	if(uniform_order_edge > -1)   
 	  order_edge = uniform_order_edge; 
 
-	for (auto i : Range(used_edge))
-	  if (!used_edge[i]) order_edge[i] = 1; 
+	ParallelFor (used_edge.Size(), [&] (size_t i)
+		     { if (!used_edge[i]) order_edge[i] = 1; });
 
-	for (auto i : used_face.Range())
-	  if (!used_face[i]) order_face[i] = 1; 
+	ParallelFor (used_face.Size(), [&] (size_t i)
+		     { if (!used_face[i]) order_face[i] = 1; });
 
-	for (ElementId ei : ma->Elements<VOL>())
-	  if (!DefinedOn(ei)) order_inner[ei.Nr()] = 1;
+	ParallelFor (ne, [&] (size_t nr)
+		     { if (!DefinedOn(ElementId(VOL,nr))) order_inner[nr] = 1; });
 
 	if(print) 
 	  {
@@ -528,12 +619,9 @@ into the wirebasket.
     int hndof = nv;
 
     first_edge_dof.SetSize (ned+1);
-    for (auto i : Range (ned))
-      {
-	first_edge_dof[i] = hndof;
-	if (order_edge[i] > 1)
-	  hndof += order_edge[i] - 1;
-      }
+    ParallelFor (ned, [&] (size_t i)
+                 { first_edge_dof[i] = max2 (order_edge[i]-1, 0); });
+    hndof = ParallelPrefixSum<int> (first_edge_dof.Range(0, ned), hndof);
     first_edge_dof[ned] = hndof;
 
     first_face_dof.SetSize (nfa+1);
@@ -560,13 +648,7 @@ into the wirebasket.
            first_face_dof[i] = neldof;
          });
 
-    // accumulate
-    for (auto i : Range(nfa))
-      {
-        auto neldof = first_face_dof[i];
-        first_face_dof[i] = hndof;
-        hndof += neldof;
-      }
+    hndof = ParallelPrefixSum<int> (first_face_dof.Range(0, nfa), hndof);
     first_face_dof[nfa] = hndof;
     
 
@@ -615,13 +697,7 @@ into the wirebasket.
         first_element_dof[i] = neldof;        
        });
 
-    // accumulate
-    for (auto i : Range(ne))
-      {
-        auto neldof = first_element_dof[i];
-        first_element_dof[i] = hndof;
-        hndof += neldof;
-      }
+    hndof = ParallelPrefixSum<int> (first_element_dof.Range(0, ne), hndof);
     first_element_dof[ne] = hndof;
     // ndof = hndof;
     SetNDof(hndof);
@@ -726,6 +802,8 @@ into the wirebasket.
     mu += { "H1HighOrder::order_inner", order_inner.Size()*sizeof(INT<3,TORDER>), 1 };
     mu += { "H1HighOrder::order_face", order_face.Size()*sizeof(INT<2,TORDER>), 1 };
     mu += { "H1HighOrder::order_edge", order_edge.Size()*sizeof(TORDER), 1 };
+    if (fe_cache)
+      mu += { "H1HighOrder::fe_cache", fe_cache->NBytes(), fe_cache->NClasses() };
     return mu;
   }
 
@@ -750,30 +828,20 @@ into the wirebasket.
     
     try
       {
-        if (fixed_order && eltype == ET_TRIG)
-          {
-            switch (order)
-              {
-              case 1: return *(new (alloc) H1HighOrderFEFO<ET_TRIG,1> ()) -> SetVertexNumbers(ngel.vertices);
-              case 2: return *(new (alloc) H1HighOrderFEFO<ET_TRIG,2> ()) -> SetVertexNumbers(ngel.vertices);
-              case 3: return *(new (alloc) H1HighOrderFEFO<ET_TRIG,3> ()) -> SetVertexNumbers(ngel.vertices);
-              default:
-                ; 
-              }
-          }
-        
-        if (fixed_order && eltype == ET_TET)
-          {
-            switch (order)
-              {
-              case 1: return *(new (alloc) H1HighOrderFEFO<ET_TET,1> ()) -> SetVertexNumbers(ngel.vertices);
-              case 2: return *(new (alloc) H1HighOrderFEFO<ET_TET,2> ()) -> SetVertexNumbers(ngel.vertices);
-              case 3: return *(new (alloc) H1HighOrderFEFO<ET_TET,3> ()) -> SetVertexNumbers(ngel.vertices);
-              default:
-                ; 
-              }
-          }
-        
+        if (fixed_order && order <= H1_MAX_FIXED_ORDER &&
+            (eltype == ET_SEGM || eltype == ET_TRIG || eltype == ET_TET))
+          return SwitchET<ET_SEGM,ET_TRIG,ET_TET>
+            (eltype, [&] (auto et) -> FiniteElement&
+             {
+               constexpr ELEMENT_TYPE ET = et.ElementType();
+               FiniteElement * fe = nullptr;
+               Iterate<H1_MAX_FIXED_ORDER> ([&] (auto p)
+                 {
+                   if (p.value+1 == order)
+                     fe = (new (alloc) H1HighOrderFEFO<ET,p.value+1> ()) -> SetVertexNumbers(ngel.vertices);
+                 });
+               return *fe;
+             });
         
         auto elnr = ei.Nr();
         if (ei.IsVolume())
@@ -786,7 +854,8 @@ into the wirebasket.
                  constexpr ELEMENT_TYPE ET = et.ElementType();
                  
                  Ngs_Element ngel = ma->GetElement<ET_trait<ET>::DIM,VOL> (elnr);
-                 H1HighOrderFE<ET> * hofe =  new (alloc) H1HighOrderFE<ET> ();
+                 H1HighOrderFE<ET> tmp;
+                 H1HighOrderFE<ET> * hofe = fe_cache ? &tmp : new (alloc) H1HighOrderFE<ET> ();
                  
                  hofe -> SetVertexNumbers (ngel.Vertices());
                  
@@ -822,6 +891,7 @@ into the wirebasket.
                    }
                  
                  hofe -> ComputeNDof();
+                 if (fe_cache) return fe_cache->Get (*hofe, alloc);
                  return *hofe;
                });
             
@@ -869,7 +939,8 @@ into the wirebasket.
                  // auto hofe =  new (alloc) H1HighOrderFE<et.ElementType()> ();
                  
                  constexpr ELEMENT_TYPE ET = et.ElementType();
-                 auto hofe =  new (alloc) H1HighOrderFE<ET> ();
+                 H1HighOrderFE<ET> tmp;
+                 auto hofe = fe_cache ? &tmp : new (alloc) H1HighOrderFE<ET> ();
 
                  hofe -> SetVertexNumbers (ngel.vertices);
 
@@ -880,6 +951,7 @@ into the wirebasket.
                    hofe -> SetOrderFace (0, order_face[ma->GetSElFace(ei.Nr())]);
                  
                  hofe -> ComputeNDof();
+                 if (fe_cache) return fe_cache->Get (*hofe, alloc);
                  return *hofe;
                });
           }
@@ -926,6 +998,7 @@ into the wirebasket.
       throw Exception("In H1HighOrderFESpace::SetOrder. Order policy is constant or node-type!");
     else if (order_policy == OLDSTYLE_ORDER)
       order_policy = VARIABLE_ORDER;
+    fixed_order = false;
       
     if (order < 1)
       order = 1;
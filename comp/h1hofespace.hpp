@@ -48,6 +48,12 @@ namespace ngcomp
   
     bool level_adapted_order; 
     bool nodalp2;
+
+    /// shared, immutable elements per (type, vertex ordering, orders) class
+    class FECache;
+    unique_ptr<FECache> fe_cache;
+    /// memory budget of the element cache in bytes, 0 disables the cache
+    size_t fe_cache_memory;
   public:
 
     H1HighOrderFESpace (shared_ptr<MeshAccess> ama, const Flags & flags, bool checkflags=false);
@@ -122,25 +122,25 @@ namespace ngcomp
          });
 
     // generate edge points, and temporary hash table
-    ClosedHashTable<INT<2>, int> node2edge(5*ned+10);
+    ParallelClosedHashTable<INT<2>, int> node2edge(5*ned+10);
 
-    edgepoints.SetSize0();
+    edgepoints.SetSize (ned);
     
-    for (size_t i = 0; i < ned; i++)
+    ParallelFor (ned, [&] (size_t i)
       {
 	INT<2> edge = ma->GetEdgePNums (i);
 	int edgedir = (edge[0] > edge[1]);
 	if (edgedir) Swap (edge[0], edge[1]);
 	node2edge.Set (edge, i);
-	edgepoints.Append (edge);
-      }
+	edgepoints[i] = edge;
+      });
 
     
-    // build edge hierarchy:
+    // build edge hierarchy, node2edge is complete and only read:
     parentedges.SetSize (ned);
     parentedges = INT<2> (-1,-1);
 
-    for (size_t i = 0; i < ned; i++)
+    ParallelFor (ned, [&] (size_t i)
       {
 	INT<2> i2 (edgepoints[i][0], edgepoints[i][1]);
 	int pa1[2], pa2[2];
@@ -148,7 +148,7 @@ namespace ngcomp
 	ma->GetParentNodes (i2[1], pa2);
 	
 	if (pa1[0] == -1 && pa2[0] == -1)
-	  continue;
+	  return;
 	
 	int issplitedge = 0;
 	if (pa1[0] == i2[1] || pa1[1] == i2[1])
@@ -291,7 +291,7 @@ namespace ngcomp
 		 << ", pa2 = " << pa2[0] << ", " << pa2[1]
 		 << endl;
 	  }
-      }
+      });
     
     
     prol->Update(*this);
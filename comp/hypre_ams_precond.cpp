@@ -12,78 +12,153 @@ namespace ngcomp
 {
 
   /**
-     Create hypre-ij-mat from ngsolve sparse-matrix.
+     Collects the entries of an ngsolve sparse-matrix in global numbering,
+     all rows at once for a single HYPRE_IJMatrixAddToValues.
      If matrix_cumulated==true, assumes that each subprocess has "full" values for a_ij
        (ex: discrete gradient matrix)
      Else, if matrix_cumulated==false, assumes that all have "partial" values
        (ex: locally assembled FEM matrix)
+     Returns false if the dimensions are not consistent.
   **/
-  void Create_IJMat_from_SPMat (HYPRE_IJMatrix* ijmat, HYPRE_ParCSRMatrix* pijmat, 
-				const SparseMatrix<double> & ngsmat, 
-				const shared_ptr<ParallelDofs> & row_pardofs, const shared_ptr<ParallelDofs> & col_pardofs,
-				const shared_ptr<BitArray> & row_freedofs, const shared_ptr<BitArray> & col_freedofs,
-				const int & row_ilower, const int & row_iupper, const int & col_ilower, const int & col_iupper,
-				FlatArray<int> row_gnums, FlatArray<int> col_gnums,
-				bool matrix_cumulated = false)
+  bool Fill_IJ_from_SPMat (const SparseMatrix<double> & ngsmat, 
+			   const shared_ptr<ParallelDofs> & row_pardofs, const shared_ptr<ParallelDofs> & col_pardofs,
+			   const shared_ptr<BitArray> & row_freedofs, const shared_ptr<BitArray> & col_freedofs,
+			   FlatArray<int> row_gnums, FlatArray<int> col_gnums, bool matrix_cumulated,
+			   Array<HYPRE_Int> & rows, Array<HYPRE_Int> & ncols,
+			   Array<HYPRE_Int> & cols, Array<double> & vals)
   {
-    HYPRE_IJMatrixCreate(ngs_comm, row_ilower, row_iupper, col_ilower, col_iupper, ijmat);
-    HYPRE_IJMatrixSetPrintLevel(*ijmat, 1);
-    HYPRE_IJMatrixSetObjectType(*ijmat, HYPRE_PARCSR);
-    HYPRE_IJMatrixInitialize(*ijmat);
-
     size_t nr = ngsmat.Height();
     size_t nc = ngsmat.Width();
     
     if( ( (row_pardofs) && (nr != row_pardofs->GetNDofLocal()) ) || (nr != row_gnums.Size()) ) {
       cerr << "# of rows in Create_IJ_from_spmat not consistent!" 
 	   << nr << " " << row_pardofs->GetNDofLocal() << " " << row_gnums.Size() << endl;
-      return;
+      return false;
     }
     if( ( (col_pardofs) && (nc != col_pardofs->GetNDofLocal()) ) || (nc != col_gnums.Size()) ) {
       cerr << "# of cols in Create_IJ_from_spmat not consistent!" << endl
 	   << nc << " " << col_pardofs->GetNDofLocal() << " " << col_gnums.Size() << endl;
-      return;
+      return false;
     }
-    
-    size_t maxperow = 0;
+
+    auto free_row = [&] (size_t k) { return (!row_freedofs) || row_freedofs->Test(k); };
+    auto use_entry = [&] (size_t k, int c)
+      {
+	if( (row_pardofs) && (matrix_cumulated) && (!row_pardofs->IsMasterDof(k)) && (!col_pardofs->IsMasterDof(c)) )
+	  return false; //if someone else is master of both dofs, they have to have the fill val!
+	if( (col_freedofs) && (!col_freedofs->Test(c)) )
+	  return false;
+	return true;
+      };
+
+    Array<int> cnt(nr);
+    ParallelFor (nr, [&] (size_t k)
+		 {
+		   int s = 0;
+		   if(free_row(k)) {
+		     for(auto c : ngsmat.GetRowIndices(k))
+		       if(use_entry(k, c)) s++;
+		   }
+		   else //dirichlet DOF - only a 1 @ diag
+		     s = ( (row_pardofs) && (!row_pardofs->IsMasterDof(k)) ) ? 0 : 1;
+		   cnt[k] = s;
+		 });
+
+    Array<int> nzrows;
     for(auto k:Range(nr))
-      maxperow = max2(maxperow, ngsmat.GetRowIndices(k).Size());
-    
-    Array<int> cg(maxperow);
-    Array<double> vg(maxperow);
-    int s = 0;
-    for(auto k:Range(nr)) {
-      auto cols = ngsmat.GetRowIndices(k);
-      auto vals = ngsmat.GetRowValues(k);
-      int row = row_gnums[k];
-      s = 0;
-      if( (!row_freedofs) || row_freedofs->Test(k) ) {
-	for(auto j:Range(cols.Size())) {
-	  if( (row_pardofs) && (matrix_cumulated) && (!row_pardofs->IsMasterDof(k)) && (!col_pardofs->IsMasterDof(cols[j])) )
-	    continue; //if someone else is master of both dofs, they have to have the fill val!
-	  if( (col_freedofs) && (!col_freedofs->Test(cols[j])) )
-	    continue;
-	  cg[s] = col_gnums[cols[j]];
-	  vg[s++] = vals[j];
-	}
-      }
-      else { //dirichlet DOF - only a 1 @ diag
-	if( (row_pardofs) && (!row_pardofs->IsMasterDof(k)) )
-	  continue;
-	s = 1;
-	cg[0] = row;
-	vg[0] = 1.0;
-      }
+      if(cnt[k]) nzrows.Append(k);
+    rows.SetSize(nzrows.Size());
+    ncols.SetSize(nzrows.Size());
+    Array<size_t> first(nzrows.Size()+1);
+    first[0] = 0;
+    for(auto j:Range(nzrows.Size())) {
+      rows[j] = row_gnums[nzrows[j]];
+      ncols[j] = cnt[nzrows[j]];
+      first[j+1] = first[j] + ncols[j];
+    }
+    cols.SetSize(first.Last());
+    vals.SetSize(first.Last());
     
-      if(!s) continue; //no entries to add to matrix!
-      HYPRE_IJMatrixAddToValues(*ijmat, 1, &s, &row, &cg[0], &vg[0]);
-    }    
+    ParallelFor (nzrows.Size(), [&] (size_t j)
+		 {
+		   size_t k = nzrows[j];
+		   size_t s = first[j];
+		   if(free_row(k)) {
+		     auto rcols = ngsmat.GetRowIndices(k);
+		     auto rvals = ngsmat.GetRowValues(k);
+		     for(auto i:Range(rcols.Size()))
+		       if(use_entry(k, rcols[i])) {
+			 cols[s] = col_gnums[rcols[i]];
+			 vals[s++] = rvals[i];
+		       }
+		   }
+		   else {
+		     cols[s] = row_gnums[k];
+		     vals[s] = 1.0;
+		   }
+		 });
+    return true;
+  }
+
+  /**
+     Create hypre-ij-mat from ngsolve sparse-matrix, see Fill_IJ_from_SPMat.
+  **/
+  void Create_IJMat_from_SPMat (HYPRE_IJMatrix* ijmat, HYPRE_ParCSRMatrix* pijmat, 
+				const SparseMatrix<double> & ngsmat, 
+				const shared_ptr<ParallelDofs> & row_pardofs, const shared_ptr<ParallelDofs> & col_pardofs,
+				const shared_ptr<BitArray> & row_freedofs, const shared_ptr<BitArray> & col_freedofs,
+				const int & row_ilower, const int & row_iupper, const int & col_ilower, const int & col_iupper,
+				FlatArray<int> row_gnums, FlatArray<int> col_gnums,
+				bool matrix_cumulated = false)
+  {
+    HYPRE_IJMatrixCreate(ngs_comm, row_ilower, row_iupper, col_ilower, col_iupper, ijmat);
+    HYPRE_IJMatrixSetPrintLevel(*ijmat, 1);
+    HYPRE_IJMatrixSetObjectType(*ijmat, HYPRE_PARCSR);
+    HYPRE_IJMatrixInitialize(*ijmat);
+
+    Array<HYPRE_Int> rows, ncols, cols;
+    Array<double> vals;
+    if(!Fill_IJ_from_SPMat (ngsmat, row_pardofs, col_pardofs, row_freedofs, col_freedofs,
+			    row_gnums, col_gnums, matrix_cumulated, rows, ncols, cols, vals))
+      return;
+    if(rows.Size())
+      HYPRE_IJMatrixAddToValues(*ijmat, rows.Size(), &ncols[0], &rows[0], &cols[0], &vals[0]);
+
     HYPRE_IJMatrixAssemble(*ijmat);
     HYPRE_IJMatrixGetObject(*ijmat, (void**) pijmat);
 
     return;
   };
 
+  /**
+     Values-only update of an ij-mat created by Create_IJMat_from_SPMat
+     from a sparse-matrix with the same pattern and freedofs.
+  **/
+  void Update_IJMat_from_SPMat (HYPRE_IJMatrix ijmat, HYPRE_ParCSRMatrix* pijmat, 
+				const SparseMatrix<double> & ngsmat, 
+				const shared_ptr<ParallelDofs> & row_pardofs, const shared_ptr<ParallelDofs> & col_pardofs,
+				const shared_ptr<BitArray> & row_freedofs, const shared_ptr<BitArray> & col_freedofs,
+				FlatArray<int> row_gnums, FlatArray<int> col_gnums,
+				bool matrix_cumulated = false)
+  {
+    static Timer t("Hypre-AMS matrix values");
+    RegionTimer reg(t);
+
+    Array<HYPRE_Int> rows, ncols, cols;
+    Array<double> vals;
+    if(!Fill_IJ_from_SPMat (ngsmat, row_pardofs, col_pardofs, row_freedofs, col_freedofs,
+			    row_gnums, col_gnums, matrix_cumulated, rows, ncols, cols, vals))
+      return;
+
+    // the partial values of all ranks are added up again
+    HYPRE_IJMatrixSetConstantValues(ijmat, 0.0);
+    HYPRE_IJMatrixInitialize(ijmat);
+    if(rows.Size())
+      HYPRE_IJMatrixAddToValues(ijmat, rows.Size(), &ncols[0], &rows[0], &cols[0], &vals[0]);
+    HYPRE_IJMatrixAssemble(ijmat);
+    HYPRE_IJMatrixGetObject(ijmat, (void**) pijmat);
+  }
+
   /**
      Creates hypre-IJvector from ngsolve-vector and copies values.
    **/
@@ -142,7 +217,13 @@ namespace ngcomp
 
   HypreAMSPreconditioner :: ~HypreAMSPreconditioner ()
   {
-    ;
+    if(precond) HYPRE_AMSDestroy(precond);
+    if(grad_mat) HYPRE_IJMatrixDestroy(grad_mat);
+    if(A) HYPRE_IJMatrixDestroy(A);
+    for(auto k:Range(3))
+      if(coords[k]) HYPRE_IJVectorDestroy(coords[k]);
+    if(b) HYPRE_IJVectorDestroy(b);
+    if(x) HYPRE_IJVectorDestroy(x);
   }
   
   void HypreAMSPreconditioner :: Update()
@@ -178,7 +259,40 @@ namespace ngcomp
     static Timer t("Hypre-AMS setup");
     RegionTimer reg(t);
 
-    HYPRE_Int err;	
+    /** main system matrix **/
+    const auto & matrix = this->bfa->GetMatrix();
+    const ParallelMatrix* pma = dynamic_cast<const ParallelMatrix*>(&matrix);
+    const SparseMatrix<double>* spma = dynamic_cast<const SparseMatrix<double>*>( (pma==nullptr) ? (&matrix) : (pma->GetMatrix().get()) );
+    if (dynamic_cast< const SparseMatrixSymmetric<double> *> (spma))
+      throw Exception ("Please use fully stored sparse matrix for hypre (bf -nonsymmetric)");
+
+    /** same pattern: new values for A, gradient and coordinates are kept **/
+    if( (this->precond) && (spma == this->ij_matrix) && (spma->NZE() == this->ij_nze) &&
+	(this->hcurlfes->GetFreeDofs()->Size() == this->hc_ndof) ) {
+      (void) Update_IJMat_from_SPMat(this->A, &this->parcsr_A, *spma,
+				     this->hc_pardofs, this->hc_pardofs,
+				     this->hc_freedofs, this->hc_freedofs,
+				     this->hc_global_nums, this->hc_global_nums);
+      // with "reuse"=n, the AMS hierarchy is kept for n updates
+      if(this->steps_since_setup < int(flags.GetNumFlag("reuse", 0))) {
+	this->steps_since_setup++;
+	cout << IM(3) << "keep Hypre-AMS setup, update " << this->steps_since_setup << endl;
+	return;
+      }
+      HYPRE_AMSDestroy(this->precond);
+      this->SetupAMS();
+      cout << IM(1) << "Hypre-AMS setup done!" << endl;
+      return;
+    }
+
+    /** new pattern or new spaces: start from scratch **/
+    if(this->precond) HYPRE_AMSDestroy(this->precond);
+    if(this->grad_mat) HYPRE_IJMatrixDestroy(this->grad_mat);
+    if(this->A) HYPRE_IJMatrixDestroy(this->A);
+    for(auto k:Range(3))
+      if(this->coords[k]) HYPRE_IJVectorDestroy(this->coords[k]);
+    if(this->b) HYPRE_IJVectorDestroy(this->b);
+    if(this->x) HYPRE_IJVectorDestroy(this->x);
 
     this->rank = MyMPI_GetId();
     this->np = MyMPI_GetNTasks();
@@ -229,12 +343,6 @@ namespace ngcomp
       for(auto k:Range(this->hc_ndof))
 	if(this->hc_pardofs->IsMasterDof(k))
 	  this->hc_masterdofs[s++] = k;
-      this->buf_hc.SetSize(this->hc_masterdofs.Size());
-      this->buf_z.SetSize(this->hc_masterdofs.Size());
-      this->buf_z = 0.0;
-      this->hc_intrange.SetSize(this->hc_iupper-this->hc_ilower+1);
-      for(auto k:Range(this->hc_intrange.Size()))
-	this->hc_intrange[k] = this->hc_ilower+k;
       ParallelVVector<double> v1(this->hc_pardofs);
       BaseVector & bv1(v1);
       v1.FVDouble() = 0.0;
@@ -268,23 +376,11 @@ namespace ngcomp
       this->hc_masterdofs.SetSize(this->hc_ndof);
       for(auto k:Range(hc_masterdofs.Size()))
 	hc_masterdofs[k] = k;
-      this->buf_hc.SetSize(this->hc_ndof);
-      this->buf_z.SetSize(this->hc_ndof);
-      this->buf_z = 0.0;
-      this->hc_intrange.SetSize(this->hc_ndof);
-      for(auto k:Range(this->hc_intrange.Size()))
-	this->hc_intrange[k] = this->hc_ilower+k;
       cout << IM(2) << "hcurl freedofs: " << this->hc_freedofs->NumSet() << " out of " << this->hc_freedofs->Size() << endl;
       cout << IM(2) << "h1    freedofs: " << this->h1_freedofs->NumSet() << " out of " << this->h1_freedofs->Size() << endl;
     }
 
 
-    /** Setup AMS-solver **/
-
-    HYPRE_AMSCreate(&this->precond); // create AMS-solver
-    HYPRE_AMSSetPrintLevel(this->precond, 1); // print-level, 0=none
-    HYPRE_AMSSetDimension(this->precond, this->dimension); // set dimension for solver
-
     /** Gradient Matrix **/
     const SparseMatrix<double>* spgrad = dynamic_cast<SparseMatrix<double>*>(this->ngs_grad_mat.get());
     (void) Create_IJMat_from_SPMat(&this->grad_mat, &this->parcsr_grad_mat, *spgrad,
@@ -293,26 +389,9 @@ namespace ngcomp
 				   this->hc_ilower, this->hc_iupper,
 				   this->h1_ilower, this->h1_iupper,
 				   this->hc_global_nums, this->h1_global_nums, true);
-    if( (err = HYPRE_AMSSetDiscreteGradient(this->precond, this->parcsr_grad_mat)) != 0)
-      cerr << "id = " << rank << ", HYPRE_AMSSetDiscreteGradient returned with err " << err << endl;
-    
-    /** alpha-poisson Matrix **/
-    if(bf_alpha!=nullptr) {
-      // HYPRE_AMSSetAlphaPoissonMatrix(this->precond, this->parcsr_alpha_mat);
-    }
     
-    /** beta-poisson Matrix**/
-    if(this->beta_is_zero) {
-      HYPRE_AMSSetBetaPoissonMatrix(this->precond, NULL);
-    }
-    else if(this->bf_beta!=nullptr) {
-      // HYPRE_AMSSetBetaPoissonMatrix(this->precond, this->parcsr_beta_mat);
-    }
-
     /** x, y and z vectors **/
     {
-      HYPRE_IJVector h[3];
-      HYPRE_ParVector ph[3];
       Array<int> rs(3);
       rs = this->h1_ndof;
       Table<double> c(rs);
@@ -331,9 +410,7 @@ namespace ngcomp
 	  c[j][k] = co[j];
       }
       for(auto k:Range(3))
-	(void) Create_IJVec_from_BVec (h[k], ph[k], cp[k], this->h1_global_nums, this->h1_ilower, this->h1_iupper, true);
-      if( (err = HYPRE_AMSSetCoordinateVectors(this->precond, ph[0], ph[1], ph[2])) != 0)
-	cerr << "HYPRE_AMSSetCoordinateVectors returned with error " << err << endl;      
+	(void) Create_IJVec_from_BVec (this->coords[k], this->par_coords[k], cp[k], this->h1_global_nums, this->h1_ilower, this->h1_iupper, true);
     }
 
     /** working vectors **/
@@ -343,19 +420,52 @@ namespace ngcomp
     (void) Create_IJVec_from_BVec (this->x, this->par_x,  &zeros[0], this->hc_global_nums, this->hc_ilower, this->hc_iupper, true);
     
     /** main system matrix **/
-    const auto & matrix = this->bfa->GetMatrix();
-    const ParallelMatrix* pma = dynamic_cast<const ParallelMatrix*>(&matrix);
-    const SparseMatrix<double>* spma = dynamic_cast<const SparseMatrix<double>*>( (pma==nullptr) ? (&matrix) : (pma->GetMatrix().get()) );
-    if (dynamic_cast< const SparseMatrixSymmetric<double> *> (spma))
-      throw Exception ("Please use fully stored sparse matrix for hypre (bf -nonsymmetric)");
     (void) Create_IJMat_from_SPMat(&this->A, &this->parcsr_A, *spma,
 				   this->hc_pardofs, this->hc_pardofs,
 				   this->hc_freedofs, this->hc_freedofs,
 				   this->hc_ilower, this->hc_iupper,
 				   this->hc_ilower, this->hc_iupper,
 				   this->hc_global_nums, this->hc_global_nums);
-    HYPRE_AMSSetup(this->precond, this->parcsr_A, this->par_b, this->par_x); //call setup
+    this->ij_matrix = spma;
+    this->ij_nze = spma->NZE();
+
+    this->SetupAMS();
+
+    cout << IM(1) << "Hypre-AMS setup done!" << endl;
+    return;
+  }
+
+  void HypreAMSPreconditioner :: SetupAMS ()
+  {
+    HYPRE_Int err;	
+
+    HYPRE_AMSCreate(&this->precond); // create AMS-solver
+    HYPRE_AMSSetPrintLevel(this->precond, 1); // print-level, 0=none
+    HYPRE_AMSSetDimension(this->precond, this->dimension); // set dimension for solver
+
+    /** Gradient Matrix **/
+    if( (err = HYPRE_AMSSetDiscreteGradient(this->precond, this->parcsr_grad_mat)) != 0)
+      cerr << "id = " << rank << ", HYPRE_AMSSetDiscreteGradient returned with err " << err << endl;
+    
+    /** alpha-poisson Matrix **/
+    if(bf_alpha!=nullptr) {
+      // HYPRE_AMSSetAlphaPoissonMatrix(this->precond, this->parcsr_alpha_mat);
+    }
     
+    /** beta-poisson Matrix**/
+    if(this->beta_is_zero) {
+      HYPRE_AMSSetBetaPoissonMatrix(this->precond, NULL);
+    }
+    else if(this->bf_beta!=nullptr) {
+      // HYPRE_AMSSetBetaPoissonMatrix(this->precond, this->parcsr_beta_mat);
+    }
+
+    /** x, y and z vectors **/
+    if( (err = HYPRE_AMSSetCoordinateVectors(this->precond, this->par_coords[0], this->par_coords[1], this->par_coords[2])) != 0)
+      cerr << "HYPRE_AMSSetCoordinateVectors returned with error " << err << endl;      
+
+    HYPRE_AMSSetup(this->precond, this->parcsr_A, this->par_b, this->par_x); //call setup
+    this->steps_since_setup = 0;
     
     /** Set a couple of AMS options **/
 
@@ -372,9 +482,6 @@ namespace ngcomp
     // HYPRE_IJMatrixPrint(grad_mat, "IJ.out.2grad_mat");
     // HYPRE_IJMatrixPrint(alpha_mat, "IJ.out.alpha");
     // HYPRE_IJMatrixPrint(beta_mat, "IJ.out.beta");
-
-    cout << IM(1) << "Hypre-AMS setup done!" << endl;
-    return;
   }
 
   void HypreAMSPreconditioner :: Mult (const BaseVector & f, BaseVector & u) const
@@ -387,31 +494,30 @@ namespace ngcomp
       u.SetParallelStatus(DISTRIBUTED);
     }
     
-    /** re-initialize vectors **/
-    HYPRE_IJVectorInitialize(this->b);
-    HYPRE_IJVectorInitialize(this->x);
-    if(this->hc_ndof) {
-      HYPRE_IJVectorSetValues(this->x, this->hc_intrange.Size(), &this->hc_intrange[0], &this->buf_z[0]);
-      for(auto k:Range(this->buf_hc.Size()))
-	if(this->hc_freedofs->Test(this->hc_masterdofs[k]))
-	  buf_hc[k] = f.FVDouble()[this->hc_masterdofs[k]];
-	else
-	  buf_hc[k] = 0.0;
-      HYPRE_IJVectorSetValues(this->b, this->hc_intrange.Size(), &this->hc_intrange[0], &this->buf_hc[0]);
-    }
-    HYPRE_IJVectorAssemble(this->b);    
-    HYPRE_IJVectorGetObject(this->b, (void **) &this->par_b);
-    HYPRE_IJVectorAssemble(this->x);
-    HYPRE_IJVectorGetObject(this->x, (void **) &this->par_x);
+    /** write directly into the local part of the hypre vectors **/
+    double * hb = hypre_VectorData(hypre_ParVectorLocalVector((hypre_ParVector*) this->par_b));
+    double * hx = hypre_VectorData(hypre_ParVectorLocalVector((hypre_ParVector*) this->par_x));
+    auto fv = f.FVDouble();
+    auto uv = u.FVDouble();
+    ParallelForRange (this->hc_masterdofs.Size(), [&] (IntRange r)
+		      {
+			for(auto k : r) {
+			  auto dof = this->hc_masterdofs[k];
+			  hb[k] = this->hc_freedofs->Test(dof) ? fv[dof] : 0.0;
+			  hx[k] = 0.0;
+			}
+		      });
 
     /** call AMS-solver **/
     HYPRE_AMSSolve(this->precond, this->parcsr_A, this->par_b, this->par_x);
     
     /** get sol **/
-    HYPRE_IJVectorGetValues(x, this->hc_intrange.Size(), &this->hc_intrange[0], &this->buf_hc[0]);    
-    if(this->hc_ndof) u.FVDouble() = 0.0;    
-    for(auto k:Range(this->buf_hc.Size()))
-      u.FVDouble()[this->hc_masterdofs[k]] = this->buf_hc[k];
+    if(this->hc_ndof) uv = 0.0;    
+    ParallelForRange (this->hc_masterdofs.Size(), [&] (IntRange r)
+		      {
+			for(auto k : r)
+			  uv[this->hc_masterdofs[k]] = hx[k];
+		      });
 
     /*
     // check for positiveness of PC
@@ -15,6 +15,8 @@
 
 #include "HYPRE.h"
 #include "HYPRE_parcsr_ls.h"
+// direct access to the local part of the ParVectors
+#include "_hypre_parcsr_mv.h"
 
 
 namespace ngcomp
@@ -26,16 +28,20 @@ class HypreAMSPreconditioner : public Preconditioner
 
   // HYPRE-side
 
-  HYPRE_Solver precond; // the AMS solver
+  HYPRE_Solver precond = nullptr; // the AMS solver
   
   // discrete gradient matrix
-  HYPRE_IJMatrix grad_mat;
+  HYPRE_IJMatrix grad_mat = nullptr;
   HYPRE_ParCSRMatrix parcsr_grad_mat;
 
   // stiffness matrix alpha<curl,curl>+beta<,>
-  HYPRE_IJMatrix A; 
+  HYPRE_IJMatrix A = nullptr; 
   HYPRE_ParCSRMatrix parcsr_A;
 
+  // vertex coordinates
+  HYPRE_IJVector coords[3] = { nullptr, nullptr, nullptr };
+  HYPRE_ParVector par_coords[3];
+
   // alpha <grad,grad>
   HYPRE_IJMatrix alpha_mat;
   HYPRE_ParCSRMatrix parcsr_alpha_mat;
@@ -71,9 +77,6 @@ class HypreAMSPreconditioner : public Preconditioner
   Array<int> hc_global_nums;
   int hc_ilower, hc_iupper;
   Array<int> hc_masterdofs;
-  Array<double> buf_hc;
-  Array<double> buf_z;
-  Array<int> hc_intrange;
 
   shared_ptr<FESpace> h1fes;
   shared_ptr<BitArray> h1_freedofs;
@@ -84,6 +87,13 @@ class HypreAMSPreconditioner : public Preconditioner
 
   bool parallel;
 
+  // pattern of the last system matrix, a matrix with the same pattern
+  // only updates the values of A
+  const void * ij_matrix = nullptr;
+  size_t ij_nze = 0;
+  // number of updates with values only since the last AMS setup
+  int steps_since_setup = 0;
+
 
 public:
 
@@ -113,6 +123,7 @@ public:
 
 private:
   void Setup ();
+  void SetupAMS ();
 };
 
 }
@@ -38,7 +38,10 @@ namespace ngcomp
 
   HyprePreconditioner :: ~HyprePreconditioner ()
   {
-    ;
+    if (precond) HYPRE_BoomerAMGDestroy(precond);
+    if (A) HYPRE_IJMatrixDestroy(A);
+    if (b) HYPRE_IJVectorDestroy(b);
+    if (x) HYPRE_IJVectorDestroy(x);
   }
   
   
@@ -57,6 +60,13 @@ namespace ngcomp
   
 
 
+  /*
+    The IJ matrix and the work vectors are built once per sparsity
+    pattern, a new matrix with the same pattern only gets new values.
+    With the flag "reuse"=n the AMG hierarchy of the last setup is kept
+    for n updates (e.g. during Newton or time steps), only the finest
+    level sees the new matrix values.
+  */
   void HyprePreconditioner :: Setup (const BaseMatrix & matrix)
   {
     cout << IM(1) << "Setup Hypre preconditioner" << endl;
@@ -69,6 +79,65 @@ namespace ngcomp
       throw Exception ("Please use fully stored sparse matrix for hypre (bf -nonsymmetric)");
 
     pardofs = pmat.GetParallelDofs ();
+
+    size_t nfree = freedofs ? freedofs->NumSet() : mat.Height();
+    bool same_pattern = A && ij_matrix == &mat && ij_nze == mat.NZE() && ij_nfree == nfree;
+
+    VT_OFF();
+
+    if (same_pattern)
+      {
+        // values only, the IJ structure is unchanged
+        HYPRE_IJMatrixSetConstantValues(A, 0.0);
+        HYPRE_IJMatrixInitialize(A);
+        UpdateValues (mat);
+        HYPRE_IJMatrixAssemble(A);
+        HYPRE_IJMatrixGetObject(A, (void**) &parcsr_A);
+
+        if (steps_since_setup < int(flags.GetNumFlag ("reuse", 0)))
+          {
+            steps_since_setup++;
+            cout << IM(3) << "keep hypre AMG hierarchy, update " << steps_since_setup << endl;
+            VT_ON();
+            return;
+          }
+      }
+    else
+      {
+        SetupPattern (mat);
+        ij_matrix = &mat;
+        ij_nze = mat.NZE();
+        ij_nfree = nfree;
+      }
+
+    if (precond) HYPRE_BoomerAMGDestroy(precond);
+    HYPRE_BoomerAMGCreate(&precond);
+    steps_since_setup = 0;
+
+    HYPRE_BoomerAMGSetPrintLevel(precond, 1);  /* print solve info + parameters */
+    HYPRE_BoomerAMGSetCoarsenType(precond, 10); /* Falgout coarsening */
+    HYPRE_BoomerAMGSetRelaxType(precond, 6);  // 3 GS, 6 .. sym GS 
+    HYPRE_BoomerAMGSetStrongThreshold(precond, 0.5);
+    HYPRE_BoomerAMGSetInterpType(precond,6);
+    HYPRE_BoomerAMGSetPMaxElmts(precond,4);
+    HYPRE_BoomerAMGSetAggNumLevels(precond,1);
+    HYPRE_BoomerAMGSetNumSweeps(precond, 1);   /* Sweeeps on each level */
+    HYPRE_BoomerAMGSetMaxLevels(precond, 20);  /* maximum number of levels */
+    HYPRE_BoomerAMGSetTol(precond, 0.0);      /* conv. tolerance */
+    HYPRE_BoomerAMGSetMaxIter(precond,1);
+     
+    cout << IM(2) << "Call BoomerAMGSetup" << endl;
+    HYPRE_BoomerAMGSetup (precond, parcsr_A, par_b, par_x);
+	
+    VT_ON();
+  }
+
+
+  void HyprePreconditioner :: SetupPattern (const SparseMatrix<double> & mat)
+  {
+    static Timer t("hypre setup pattern");
+    RegionTimer reg(t);
+
     int ndof = pardofs->GetNDofLocal();
 
     int ntasks = MyMPI_GetNTasks();
@@ -105,64 +174,91 @@ namespace ngcomp
     ScatterDofData (global_nums, pardofs);
     cout << IM(3) << "num glob dofs = " << num_glob_dofs << endl;
 	
-    VT_OFF();
-	
     // range of my master dofs ...
     ilower = first_master_dof[id];
     iupper = first_master_dof[id+1]-1;
-   
+
+    master_rows.SetSize(num_master_dofs);
+    for (int i = 0; i < ndof; i++)
+      if (pardofs->IsMasterDof(i) && global_nums[i] != -1)
+        master_rows[global_nums[i]-ilower] = i;
+
+    // the IJ rows in global numbering, all rows at once
+    Array<int> local_rows;
+    for (int i = 0; i < mat.Height(); i++)
+      if (global_nums[i] != -1)
+        local_rows.Append (i);
+
+    ij_rows.SetSize(local_rows.Size());
+    ij_ncols.SetSize(local_rows.Size());
+    ParallelFor (local_rows.Size(), [&] (size_t k)
+                 {
+                   int i = local_rows[k];
+                   ij_rows[k] = global_nums[i];
+                   int cnt = 0;
+                   for (int c : mat.GetRowIndices(i))
+                     if (global_nums[c] != -1) cnt++;
+                   ij_ncols[k] = cnt;
+                 });
+
+    Array<size_t> first(local_rows.Size()+1);
+    first[0] = 0;
+    for (size_t k = 0; k < local_rows.Size(); k++)
+      first[k+1] = first[k] + ij_ncols[k];
+
+    ij_cols.SetSize(first.Last());
+    ij_pos.SetSize(first.Last());
+    ij_values.SetSize(first.Last());
+    ParallelFor (local_rows.Size(), [&] (size_t k)
+                 {
+                   int i = local_rows[k];
+                   FlatArray<int> cols = mat.GetRowIndices(i);
+                   size_t pos = first[k];
+                   for (int j = 0; j < cols.Size(); j++)
+                     if (global_nums[cols[j]] != -1)
+                       {
+                         ij_cols[pos] = global_nums[cols[j]];
+                         ij_pos[pos++] = mat.First(i)+j;
+                       }
+                 });
+
+    if (A) HYPRE_IJMatrixDestroy(A);
     HYPRE_IJMatrixCreate(ngs_comm, ilower, iupper, ilower, iupper, &A);
     HYPRE_IJMatrixSetObjectType(A, HYPRE_PARCSR);
     HYPRE_IJMatrixInitialize(A);
-   
-
-    for( int i = 0; i < mat.Height(); i++)
-      {
-	int row = global_nums[i];
-	if (row == -1) continue;
-
-	FlatArray<int> cols = mat.GetRowIndices(i);
-	FlatVector<double> values = mat.GetRowValues(i);
-      
-	Array<int> cols_global;
-	Array<double> values_global;
-
-	for( int j = 0; j < cols.Size(); j++)
-	  if (global_nums[cols[j]] != -1)
-	    {
-	      cols_global.Append (global_nums[cols[j]]);
-	      values_global.Append (values[j]);
-	    }
-
-	int size = cols_global.Size();
-	HYPRE_IJMatrixAddToValues(A, 1, &size, &row, &cols_global[0], &values_global[0]);
-      }
-
+    UpdateValues (mat);
     HYPRE_IJMatrixAssemble(A);
     HYPRE_IJMatrixGetObject(A, (void**) &parcsr_A);
     // HYPRE_IJMatrixPrint(A, "IJ.out.A");
 
-    HYPRE_BoomerAMGCreate(&precond);
- 
-    HYPRE_ParVector par_b = NULL;
-    HYPRE_ParVector par_x = NULL;
+    auto create_vector = [this] (HYPRE_IJVector & v, HYPRE_ParVector & pv)
+      {
+        if (v) HYPRE_IJVectorDestroy(v);
+        HYPRE_IJVectorCreate(ngs_comm, ilower, iupper, &v);
+        HYPRE_IJVectorSetObjectType(v, HYPRE_PARCSR);
+        HYPRE_IJVectorInitialize(v);
+        HYPRE_IJVectorAssemble(v);
+        HYPRE_IJVectorGetObject(v, (void **) &pv);
+      };
+    create_vector (b, par_b);
+    create_vector (x, par_x);
+  }
 
-    HYPRE_BoomerAMGSetPrintLevel(precond, 1);  /* print solve info + parameters */
-    HYPRE_BoomerAMGSetCoarsenType(precond, 10); /* Falgout coarsening */
-    HYPRE_BoomerAMGSetRelaxType(precond, 6);  // 3 GS, 6 .. sym GS 
-    HYPRE_BoomerAMGSetStrongThreshold(precond, 0.5);
-    HYPRE_BoomerAMGSetInterpType(precond,6);
-    HYPRE_BoomerAMGSetPMaxElmts(precond,4);
-    HYPRE_BoomerAMGSetAggNumLevels(precond,1);
-    HYPRE_BoomerAMGSetNumSweeps(precond, 1);   /* Sweeeps on each level */
-    HYPRE_BoomerAMGSetMaxLevels(precond, 20);  /* maximum number of levels */
-    HYPRE_BoomerAMGSetTol(precond, 0.0);      /* conv. tolerance */
-    HYPRE_BoomerAMGSetMaxIter(precond,1);
-     
-    cout << IM(2) << "Call BoomerAMGSetup" << endl;
-    HYPRE_BoomerAMGSetup (precond, parcsr_A, par_b, par_x);
-	
-    VT_ON();
+
+  void HyprePreconditioner :: UpdateValues (const SparseMatrix<double> & mat)
+  {
+    static Timer t("hypre matrix values");
+    RegionTimer reg(t);
+
+    FlatVector<double> vals = mat.AsVector().FVDouble();
+    ParallelForRange (ij_pos.Size(), [&] (IntRange r)
+                      {
+                        for (auto k : r)
+                          ij_values[k] = vals(ij_pos[k]);
+                      });
+    if (ij_rows.Size())
+      HYPRE_IJMatrixAddToValues(A, ij_rows.Size(), &ij_ncols[0], &ij_rows[0],
+                                &ij_cols[0], &ij_values[0]);
   }
 
 
@@ -172,88 +268,35 @@ namespace ngcomp
     static Timer t("hypre mult");
     RegionTimer reg(t);
 
-    f.Distribute();
+    // the master holds the full value, no communication through the IJ interface
+    f.Cumulate();
     u.SetParallelStatus(DISTRIBUTED);
     
-    HYPRE_IJVector b;
-    HYPRE_ParVector par_b;
-    HYPRE_IJVector x;
-    HYPRE_ParVector par_x;
-
-    HYPRE_IJVectorCreate(ngs_comm, ilower, iupper,&b);
-    HYPRE_IJVectorSetObjectType(b, HYPRE_PARCSR);
-    HYPRE_IJVectorInitialize(b);
-
-    HYPRE_IJVectorCreate(ngs_comm, ilower, iupper,&x);
-    HYPRE_IJVectorSetObjectType(x, HYPRE_PARCSR);
-    HYPRE_IJVectorInitialize(x);
-  
-    const FlatVector<double> fvf =f.FVDouble();
-    FlatVector<double> fu =u.FVDouble();
-	
-    Array<int> nzglobal;
-    Array<double> free_f;
-    for(auto i : Range(global_nums.Size()))
-      if (global_nums[i] != -1)
-	{
-	  nzglobal.Append (global_nums[i]);
-	  free_f.Append (fvf(i));
-	}
-        
-    Array<int> setzi;
-    Array<double> zeros;
-    if(iupper>=ilower)
-      for(auto k : Range(ilower,iupper+1))
-	{
-	  setzi.Append(k);
-	  zeros.Append(0.0);
-	}
-
-    int local_size = nzglobal.Size();
-
-    //HYPRE_IJVectorAddToValues(b, setzi.Size(), &setzi[0], &zeros[0]);
-    //set vector to 0
-    if(setzi.Size())
-      HYPRE_IJVectorSetValues(b, setzi.Size(), &setzi[0], &zeros[0]);
-    //add values
-    if(local_size)
-      HYPRE_IJVectorAddToValues(b, local_size, &nzglobal[0], &free_f[0]);
-    HYPRE_IJVectorAssemble(b);
-
-	
-    HYPRE_IJVectorGetObject(b, (void **) &par_b);
-
-    if(setzi.Size())
-      HYPRE_IJVectorSetValues(x, setzi.Size(), &setzi[0], &zeros[0]);
-    HYPRE_IJVectorAssemble(x);
-    HYPRE_IJVectorGetObject(x, (void **) &par_x);
+    FlatVector<double> fvf = f.FVDouble();
+    FlatVector<double> fu = u.FVDouble();
+
+    double * hb = hypre_VectorData(hypre_ParVectorLocalVector((hypre_ParVector*) par_b));
+    double * hx = hypre_VectorData(hypre_ParVectorLocalVector((hypre_ParVector*) par_x));
+
+    ParallelForRange (master_rows.Size(), [&] (IntRange r)
+                      {
+                        for (auto k : r)
+                          {
+                            hb[k] = fvf(master_rows[k]);
+                            hx[k] = 0.0;
+                          }
+                      });
    
-    // HYPRE_IJVectorPrint(b, "IJ.out.b");
-
     VT_OFF();
     HYPRE_BoomerAMGSolve(precond, parcsr_A, par_b, par_x);
     VT_ON();
 
-    // HYPRE_IJVectorPrint(x, "IJ.out.x");
-    
-
-    int ndof = pardofs->GetNDofLocal();
-    
-    Vector<> hu(iupper-ilower+1);
-    Array<int> locind(iupper-ilower+1);
-
-    for (int i = 0, cnt = 0; i < ndof; i++)
-      if (pardofs->IsMasterDof(i) && global_nums[i] != -1)
-	locind[cnt++] = global_nums[i];
-    int lsize = locind.Size();
-    
-    HYPRE_IJVectorGetValues (x, lsize, &locind[0], &hu(0));
-    
-    for (int i = 0, cnt = 0; i < ndof; i++)
-      if (pardofs->IsMasterDof(i) && global_nums[i] != -1)
-	fu(i) = hu(cnt++);
-      else
-	fu(i) = 0.0;
+    fu = 0.0;
+    ParallelForRange (master_rows.Size(), [&] (IntRange r)
+                      {
+                        for (auto k : r)
+                          fu(master_rows[k]) = hx[k];
+                      });
 
     u.Cumulate();
   }
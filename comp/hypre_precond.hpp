@@ -16,6 +16,8 @@
 
 #include "HYPRE.h"
 #include "HYPRE_parcsr_ls.h"
+// direct access to the local part of the ParVectors
+#include "_hypre_parcsr_mv.h"
 
 
 namespace ngcomp
@@ -26,15 +28,31 @@ class HyprePreconditioner : public Preconditioner
 {
   shared_ptr<BilinearForm> bfa;
 
-  HYPRE_Solver precond;
-  HYPRE_IJMatrix A;
+  HYPRE_Solver precond = nullptr;
+  HYPRE_IJMatrix A = nullptr;
   HYPRE_ParCSRMatrix parcsr_A;
 
+  // work vectors, Mult writes into their local data
+  HYPRE_IJVector b = nullptr, x = nullptr;
+  HYPRE_ParVector par_b, par_x;
+
   Array<int> global_nums;
   int ilower, iupper;
   shared_ptr<BitArray> freedofs;
   shared_ptr<ParallelDofs> pardofs;
 
+  // the IJ pattern of the matrix in global numbering, kept as long as
+  // the sparsity pattern and the free dofs do not change
+  const void * ij_matrix = nullptr;
+  size_t ij_nze = 0, ij_nfree = 0;
+  Array<HYPRE_Int> ij_rows, ij_ncols, ij_cols;
+  Array<size_t> ij_pos;      // position of the IJ entry in the SparseMatrix values
+  Array<double> ij_values;
+  Array<int> master_rows;    // local dof of the rows ilower ... iupper
+
+  // number of updates with values only since the last AMG setup
+  int steps_since_setup = 0;
+
 public:
     
   HyprePreconditioner (const PDE & pde, const Flags & flags, const string & name);
@@ -56,6 +74,8 @@ public:
 
 private:
   void Setup (const BaseMatrix & matrix);
+  void SetupPattern (const SparseMatrix<double> & mat);
+  void UpdateValues (const SparseMatrix<double> & mat);
 };
 
 }
@@ -370,15 +370,26 @@ global system.
                             { return *new(alloc) ScalarDummyFE<et.ElementType()>(); });
           }
 
-	if (eltype == ET_TRIG && order_policy == CONSTANT_ORDER) 
-          return *CreateL2HighOrderFE<ET_TRIG> (order, INT<3>(ngel.Vertices()), alloc);
-
         if (tensorproduct)
           if (eltype == ET_TET)
             return * new (alloc) L2HighOrderFETP<ET_TET> (order, ngel.Vertices(), alloc);
-        
-        if (eltype == ET_TET && order_policy == CONSTANT_ORDER) 
-          return *CreateL2HighOrderFE<ET_TET> (order, INT<4>(ngel.Vertices()), alloc);
+
+        // uniform order: statically sized elements (fall back to
+        // L2HighOrderFE beyond the fixed orders)
+        bool uniform_order = !var_order && order_policy != VARIABLE_ORDER &&
+          et_bonus_order[eltype] == 0;
+        if (uniform_order)
+          switch (eltype)
+            {
+            case ET_SEGM:
+              return *CreateL2HighOrderFE<ET_SEGM> (order, INT<2>(ngel.Vertices()), alloc);
+            case ET_TRIG:
+              return *CreateL2HighOrderFE<ET_TRIG> (order, INT<3>(ngel.Vertices()), alloc);
+            case ET_TET:
+              return *CreateL2HighOrderFE<ET_TET> (order, INT<4>(ngel.Vertices()), alloc);
+            default:
+              ;
+            }
 
         /*
         return SwitchET(eltype,
@@ -769,6 +780,138 @@ global system.
 
 
 
+  L2MassInverse :: L2MassInverse (shared_ptr<L2HighOrderFESpace> afes,
+                                  shared_ptr<CoefficientFunction> rho, LocalHeap & lh)
+    : fes(afes)
+  {
+    static Timer t("L2MassInverse - setup"); RegionTimer reg(t);
+    int dim = fes->GetDimension();
+    diag.SetSize(fes->GetNDof()*dim);
+    diag = 0.0;
+    factors.SetSize(fes->GetMeshAccess()->GetNE(VOL));
+
+    IterateElements (*fes, VOL, lh,
+                     [&] (FESpace::Element el, LocalHeap & lh)
+                     {
+                       auto & fel = static_cast<const BaseScalarFiniteElement&>(el.GetFE());
+                       const ElementTransformation & trafo = el.GetTrafo();
+                       auto dofs = fes->GetElementDofs(el.Nr());
+                       size_t nd = fel.GetNDof();
+
+                       bool curved = trafo.IsCurvedElement();
+                       if (rho && !rho->ElementwiseConstant()) curved = true;
+
+                       if (!curved)
+                         {
+                           FlatVector<double> diag_mass(nd, lh);
+                           fel.GetDiagMassMatrix (diag_mass);
+                           IntegrationRule ir(fel.ElementType(), 0);
+                           BaseMappedIntegrationRule & mir = trafo(ir, lh);
+                           double jac = mir[0].GetMeasure();
+                           if (rho) jac *= rho->Evaluate(mir[0]);
+                           for (size_t i = 0; i < nd; i++)
+                             for (int j = 0; j < dim; j++)
+                               diag[dim*(dofs.First()+i)+j] = 1.0 / (jac*diag_mass(i));
+                           return;
+                         }
+
+                       SIMD_IntegrationRule ir(fel.ElementType(), 2*fel.Order());
+                       auto & mir = trafo(ir, lh);
+                       FlatMatrix<SIMD<double>> rhovals(1, ir.Size(), lh);
+                       if (rho)
+                         rho->Evaluate (mir, rhovals);
+                       else
+                         rhovals = SIMD<double>(1.0);
+
+                       FlatMatrix<SIMD<double>> shapes(nd, ir.Size(), lh);
+                       FlatMatrix<SIMD<double>> wshapes(nd, ir.Size(), lh);
+                       fel.CalcShape (ir, shapes);
+                       for (size_t j = 0; j < ir.Size(); j++)
+                         {
+                           SIMD<double> w = mir[j].GetWeight() * rhovals(0,j);
+                           for (size_t i = 0; i < nd; i++)
+                             wshapes(i,j) = w * shapes(i,j);
+                         }
+
+                       FlatMatrix<> elmat(nd, nd, lh);
+                       elmat = 0.0;
+                       AddABt (shapes, wshapes, elmat);
+                       factors[el.Nr()] = make_unique<CholeskyFactors<double>> (elmat);
+                     });
+
+    for (size_t i = 0; i < factors.Size(); i++)
+      if (factors[i]) curved_els.Append(i);
+  }
+
+  AutoVector L2MassInverse :: CreateVector () const
+  {
+    return CreateBaseVector (fes->GetNDof(), false, fes->GetDimension());
+  }
+
+  template <bool ADD>
+  void L2MassInverse :: T_Mult (double s, const BaseVector & x, BaseVector & y) const
+  {
+    static Timer t("L2MassInverse::Mult"); RegionTimer reg(t);
+    auto fx = x.FV<double>();
+    auto fy = y.FV<double>();
+    int dim = fes->GetDimension();
+    constexpr size_t SW = SIMD<double>::Size();
+
+    ParallelForRange
+      (diag.Size(), [&] (IntRange r)
+       {
+         double * px = &fx(0), * py = &fy(0);
+         const double * pd = &diag[0];
+         SIMD<double> ss(s);
+         size_t i = r.First();
+         for ( ; i+SW <= r.Next(); i += SW)
+           {
+             SIMD<double> val = ss * SIMD<double>(pd+i) * SIMD<double>(px+i);
+             if (ADD) val += SIMD<double>(py+i);
+             val.Store(py+i);
+           }
+         SIMD<mask64> mask(r.Next()-i);
+         SIMD<double> val = ss * SIMD<double>(pd+i, mask) * SIMD<double>(px+i, mask);
+         if (ADD) val += SIMD<double>(py+i, mask);
+         val.Store(py+i, mask);
+       });
+
+    ParallelForRange
+      (curved_els.Size(), [&] (IntRange r)
+       {
+         for (auto nr : r)
+           {
+             int elnr = curved_els[nr];
+             auto dofs = fes->GetElementDofs(elnr);
+             size_t nd = dofs.Size();
+             auto elx = fx.Range(dim*dofs.First(), dim*dofs.Next()).AsMatrix(nd, dim);
+             auto ely = fy.Range(dim*dofs.First(), dim*dofs.Next()).AsMatrix(nd, dim);
+             STACK_ARRAY(double, mem, nd);
+             FlatVector<> hy(nd, &mem[0]);
+             for (int j = 0; j < dim; j++)
+               {
+                 factors[elnr]->Mult (elx.Col(j), hy);
+                 if (ADD)
+                   ely.Col(j) += s * hy;
+                 else
+                   ely.Col(j) = s * hy;
+               }
+           }
+       });
+  }
+
+  void L2MassInverse :: Mult (const BaseVector & x, BaseVector & y) const
+  {
+    T_Mult<false> (1.0, x, y);
+  }
+
+  void L2MassInverse :: MultAdd (double s, const BaseVector & x, BaseVector & y) const
+  {
+    T_Mult<true> (s, x, y);
+  }
+
+
+
 
   template <int D, typename FEL = ScalarFiniteElement<D-1> >
   class DiffOpSurfaceGradient : public DiffOp<DiffOpSurfaceGradient<D, FEL> >
@@ -114,6 +114,40 @@ namespace ngcomp
   };
 
 
+  /**
+     Inverse of the (rho-weighted) L2 mass matrix, e.g. for explicit
+     time stepping.
+     Affine elements with element-wise constant rho are scaled by the
+     inverse diagonal of the orthogonal basis. Curved elements, or
+     elements with non-constant rho, keep a Cholesky factorization of
+     their element mass matrix.
+  */
+  class NGS_DLL_HEADER L2MassInverse : public BaseMatrix
+  {
+    shared_ptr<L2HighOrderFESpace> fes;
+    /// inverse diagonal for all vector entries of affine elements, 0 otherwise
+    Array<double> diag;
+    /// elements with a factorization
+    Array<int> curved_els;
+    /// per element, nullptr for affine elements
+    Array<unique_ptr<CholeskyFactors<double>>> factors;
+  public:
+    L2MassInverse (shared_ptr<L2HighOrderFESpace> afes,
+                   shared_ptr<CoefficientFunction> rho, LocalHeap & lh);
+
+    virtual bool IsComplex() const override { return false; }
+    virtual int VHeight() const override { return fes->GetNDof(); }
+    virtual int VWidth() const override { return fes->GetNDof(); }
+    virtual AutoVector CreateVector () const override;
+
+    virtual void Mult (const BaseVector & x, BaseVector & y) const override;
+    virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const override;
+  private:
+    template <bool ADD>
+    void T_Mult (double s, const BaseVector & x, BaseVector & y) const;
+  };
+
+
 
 
 
@@ -18,6 +18,7 @@ namespace ngcomp
     allocated = false;
     initialassembling = true;
     checksum = flags.GetDefineFlag ("checksum");
+    atomic_assembly = flags.GetDefineFlag ("atomic_assembly");
     cacheblocksize = 1;
   }
 
@@ -32,6 +33,14 @@ namespace ngcomp
     return *this;
   }
   
+  bool LinearForm :: UseUncoloredAssembly (VorB vb) const
+  {
+    // atomic adds are available for scalar entries only
+    if (fespace->GetDimension() != 1) return false;
+    if (atomic_assembly) return true;
+    return HasPoorColoring (*fespace, vb);
+  }
+
   void LinearForm :: PrintReport (ostream & ost) const
   {
     ost << "on space " << GetFESpace()->GetName() << endl
@@ -205,7 +214,9 @@ namespace ngcomp
 		// ProgressOutput progress (ma, string("assemble ") + vb_str + string(" element"),ne);
                 ProgressOutput progress (ma, string("assemble ") + ToString(vb) + string(" element"),ne);
 		gcnt += ne;
-		IterateElements
+                assembling_uncolored = UseUncoloredAssembly (vb);
+                auto iterate = assembling_uncolored ? IterateElementsUncolored : IterateElements;
+		iterate
 		  (*fespace,vb,clh,[&] (FESpace::Element el, LocalHeap &lh)
 		   {
 		     // RegionTimer reg2(timer2);
@@ -214,6 +225,13 @@ namespace ngcomp
 		     auto & fel = el.GetFE();
 		     auto & eltrans = el.GetTrafo();
 
+		     int elvec_size = fel.GetNDof()*fespace->GetDimension();
+                     // all integrators acting on all components are summed up
+                     // and added to the global vector at once
+		     FlatVector<TSCAL> sum_elvec(elvec_size, lh);
+                     sum_elvec = TSCAL(0);
+                     bool has_sum = false;
+                     
 		     // for(int j = 0; j<parts.Size(); j++)
                      for (auto & lfip : VB_parts[vb])
 		       {
@@ -223,7 +241,7 @@ namespace ngcomp
 			 // if (parts[j] -> IntegrationAlongCurve()) continue;
                          if(!lfip->DefinedOn(el.GetIndex())) continue;
                          
-			 int elvec_size = fel.GetNDof()*fespace->GetDimension();
+                         HeapReset hr(lh);
 			 FlatVector<TSCAL> elvec(elvec_size, lh);
 			 lfip -> CalcElementVector (fel, eltrans, elvec, lh);
 			 
@@ -236,11 +254,25 @@ namespace ngcomp
 				      << "element-index = " << eltrans.GetElementIndex() << endl
 				      << "elvec = " << endl << elvec << endl;
 			   }
+
+                         if (lfip->CacheComp() == 0)
+                           {
+                             sum_elvec += elvec;
+                             has_sum = true;
+                             continue;
+                           }
 			 
 			 fespace->TransformVec (el, elvec, TRANSFORM_RHS);
 			 AddElementVector (el.GetDofs(), elvec, lfip->CacheComp()-1);
 		       }
+
+                     if (has_sum)
+                       {
+                         fespace->TransformVec (el, sum_elvec, TRANSFORM_RHS);
+                         AddElementVector (el.GetDofs(), sum_elvec);
+                       }
 		   });
+                assembling_uncolored = false;
 	      }
 	  }
 		
@@ -693,7 +725,7 @@ namespace ngcomp
 		    FlatVector<double> elvec,
 		    int cachecomp) 
   {
-    vec -> AddIndirect (dnums, elvec, fespace->HasAtomicDofs());
+    vec -> AddIndirect (dnums, elvec, fespace->HasAtomicDofs() || assembling_uncolored);
   }
   
   template <> void T_LinearForm<Complex>::
@@ -701,7 +733,7 @@ namespace ngcomp
 		    FlatVector<Complex> elvec,
 		    int cachecomp) 
   {
-    vec -> AddIndirect (dnums, elvec, fespace->HasAtomicDofs());
+    vec -> AddIndirect (dnums, elvec, fespace->HasAtomicDofs() || assembling_uncolored);
   }
 
   template <typename TV>
@@ -36,6 +36,10 @@ namespace ngcomp
     int cacheblocksize;
     /// output of norm of matrix entries
     bool checksum;
+    /// assemble without element coloring, using atomic adds
+    bool atomic_assembly;
+    /// the running assembly loop is not colored
+    bool assembling_uncolored = false;
 
   public:
     ///
@@ -51,6 +55,9 @@ namespace ngcomp
     ///
     virtual LinearForm & AddIntegrator (shared_ptr<LinearFormIntegrator> lfi);
 
+    /// assemble vb-elements without coloring ? 
+    bool UseUncoloredAssembly (VorB vb) const;
+
     LinearForm & operator+= (shared_ptr<LinearFormIntegrator> lfi)
     {
       return AddIntegrator(lfi);
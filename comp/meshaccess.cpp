@@ -454,6 +454,9 @@ namespace ngcomp
     const MeshAccess * mesh;
     Vec<DIMR> p0;
     Mat<DIMR,DIMS> mat;
+    Mat<DIMS,DIMR> invmat;
+    /// Jacobian, determinant and normals, the same for all points
+    MappedIntegrationPoint<DIMS,DIMR> mip0;
   public:
     INLINE Ng_ConstElementTransformation (const MeshAccess * amesh,
                                           ELEMENT_TYPE aet, ElementId ei, int elindex) 
@@ -461,6 +464,20 @@ namespace ngcomp
         mesh(amesh) 
     { 
       iscurved = false;
+      const double * table = (DIMS == DIMR) ? mesh->GetAffineTrafo (ei) : nullptr;
+      if (table)
+        {
+          p0 = FlatVec<DIMR, const double> (table);
+          for (int k = 0; k < DIMR; k++)
+            for (int j = 0; j < DIMS; j++)
+              {
+                mat(k,j) = table[DIMR+k*DIMS+j];
+                invmat(j,k) = table[DIMR+DIMR*DIMS+j*DIMR+k];
+              }
+          mip0 = MappedIntegrationPoint<DIMS,DIMR> (IntegrationPoint(), *this, p0, mat);
+          return;
+        }
+
       if ( (DIMR==3) && (eltype == ET_TET) )
         {
           Ngs_Element nel = mesh -> GetElement<DIMS,VOL> (elnr);
@@ -519,6 +536,9 @@ namespace ngcomp
           Vec<DIMS> pref = 0.0;
           mesh->mesh.ElementTransformation <DIMS,DIMR> (elnr, &pref(0), &p0(0), &mat(0));
         }
+
+      mip0 = MappedIntegrationPoint<DIMS,DIMR> (IntegrationPoint(), *this, p0, mat);
+      invmat = mip0.GetJacobianInverse();
     }
 
     /*
@@ -655,6 +675,18 @@ namespace ngcomp
       FlatMatrixFixWidth<DIMS> (DIMR, &dxdxi(0,0)) = mat;
     }
 
+    virtual bool GetAffineJacobian (FlatVector<> ap0, FlatMatrix<> jac,
+                                    FlatMatrix<> ijac, double & det) const override
+    {
+      // deformed elements are curved
+      if (iscurved) return false;
+      ap0 = p0;
+      jac = mat;
+      ijac = invmat;
+      det = mip0.GetJacobiDet();
+      return true;
+    }
+
     virtual BaseMappedIntegrationPoint & operator() (const IntegrationPoint & ip, Allocator & lh) const override
     {
       return *new (lh) MappedIntegrationPoint<DIMS,DIMR> (ip, *this);
@@ -678,8 +710,7 @@ namespace ngcomp
         {
           const IntegrationPoint & ip = ir[i];
           mir[i].Point() = p0 + mat * FlatVec<DIMS, const double> (&ip(0));
-          mir[i].Jacobian() = mat;
-          mir[i].Compute();
+          mir[i].SetAffineData (mip0);
         }
     }
 
@@ -699,8 +730,7 @@ namespace ngcomp
       for (size_t i = 0; i < hir.Size(); i++)
         {
           hmir[i].Point() = simd_p0 + simd_mat * FlatVec<DIMS, const SIMD<double>> (&hir[i](0));
-          hmir[i].Jacobian() = simd_mat;
-          hmir[i].Compute();
+          hmir[i].SetAffineData (mip0);
         }
     }
     virtual const ElementTransformation & VAddDeformation (const GridFunction * gf, LocalHeap & lh) const override
@@ -813,6 +843,79 @@ namespace ngcomp
   }
 
 
+  /*
+    For every node with all vertices mapped by vertex_map, the node
+    with the mapped vertices (-1 for the others). Nodes are looked up
+    among the nodes of their smallest vertex, a table built in
+    parallel, nothing stays alive after the matching.
+  */
+  template <int N, typename TFUNC>
+  static Array<int> MatchPeriodicNodes (size_t nnodes, size_t nv, FlatArray<int> vertex_map,
+                                        TFUNC node_vertices)
+  {
+    Table<int> vertex_nodes = ParallelCreateTable<int>
+      (nnodes, [&] (ParallelTableCreator<int> & creator, size_t nr)
+       {
+         INT<N> vts = node_vertices(nr);
+         creator.Add (vts.Sort()[0], nr);
+       }, nv);
+
+    Array<int> master(nnodes);
+    atomic<bool> missing(false);
+    ParallelFor (nnodes, [&] (size_t nr)
+                 {
+                   master[nr] = -1;
+                   INT<N> vts = node_vertices(nr);
+                   INT<N> mv;
+                   for (int j = 0; j < N; j++)
+                     {
+                       mv[j] = vertex_map[vts[j]];
+                       if (mv[j] == vts[j]) return;
+                     }
+                   mv.Sort();
+                   for (auto other : vertex_nodes[mv[0]])
+                     if (node_vertices(other).Sort() == mv)
+                       {
+                         master[nr] = other;
+                         return;
+                       }
+                   missing = true;
+                 });
+    if (missing)
+      throw Exception ("periodic identification: node without partner");
+    return master;
+  }
+
+  static void AppendPeriodicPairs (Array<Array<INT<2>>> & node_pairs, FlatArray<int> master)
+  {
+    size_t count = 0;
+    for (auto m : master)
+      if (m >= 0) count++;
+    Array<INT<2>> pairs(count);
+    count = 0;
+    for (auto nr : Range(master))
+      if (master[nr] >= 0)
+        pairs[count++] = INT<2> (master[nr], nr);
+    node_pairs.Append (move(pairs));
+  }
+
+  // smallest and largest region index of the elements of type vb
+  static pair<int,int> RegionIndexRange (const MeshAccess & ma, VorB vb)
+  {
+    return ParallelReduce (ma.GetNE(vb),
+                           [&] (size_t i)
+                           {
+                             auto ind = ma.GetElIndex(ElementId(vb, i));
+                             return make_pair(ind, ind);
+                           },
+                           [] (pair<int,int> a, pair<int,int> b)
+                           {
+                             return make_pair(min2(a.first, b.first),
+                                              max2(a.second, b.second));
+                           },
+                           pair<int,int> (std::numeric_limits<int>::max(), -1));
+  }
+
   void MeshAccess :: UpdateBuffers()
   {
     static Timer t("MeshAccess::UpdateBuffers");
@@ -840,6 +943,8 @@ namespace ngcomp
     mesh_timestamp = netgen_mesh_timestamp;
     
     timestamp = NGS_Object::GetNextTimeStamp();
+    affine_trafos.SetSize0();
+    ClearPointSearchGrid();
     
 
     dim = mesh.GetDimension();
@@ -911,14 +1016,10 @@ namespace ngcomp
     ndomains = MyMPI_AllReduce (ndomains, MPI_MAX);
     pml_trafos.SetSize(ndomains);
     
-    int nboundaries = -1;
-    for (auto el : Elements(BND))
-      {
-        int elindex = el.GetIndex();
-        if (elindex < 0) throw Exception("mesh with negative boundary-condition number");
-        nboundaries = max2(nboundaries, elindex);
-      }
-    nboundaries++;
+    auto bnd_minmax = RegionIndexRange (*this, BND);
+    if (bnd_minmax.first < 0)
+      throw Exception("mesh with negative boundary-condition number");
+    int nboundaries = bnd_minmax.second + 1;
     nboundaries = MyMPI_AllReduce (nboundaries, MPI_MAX);
     nregions[1] = nboundaries;
 
@@ -930,19 +1031,8 @@ namespace ngcomp
       }
     else
       {
-        nbboundaries = -1;
-        // int ncd2e = nelements_cd[2];
-        // for (int i=0; i< ncd2e; i++)
-        for (auto el : Elements(BBND))          
-          {
-            // ElementId ei(BBND, i);
-            // int elindex = GetElIndex(ei);
-            int elindex = el.GetIndex();            
-            //if (elindex < 0) throw Exception ("mesh with negative cd2 condition number");
-            if (elindex >=0)
-              nbboundaries = max2(nbboundaries, elindex);
-          }
-        nbboundaries++;
+        // negative cd2 condition numbers are ignored
+        nbboundaries = RegionIndexRange (*this, BBND).second + 1;
         nbboundaries = MyMPI_AllReduce(nbboundaries, MPI_MAX);
       }
 
@@ -953,14 +1043,7 @@ namespace ngcomp
       }
     else
       {
-        nbbboundaries = -1;
-        for (auto el : Elements(BBBND))          
-          {
-            int elindex = el.GetIndex();
-            if (elindex >=0)
-              nbbboundaries = max2(nbbboundaries, elindex);
-          }
-        nbbboundaries++;
+        nbbboundaries = RegionIndexRange (*this, BBBND).second + 1;
         nbbboundaries = MyMPI_AllReduce(nbbboundaries, MPI_MAX);
       }
     
@@ -983,78 +1066,26 @@ namespace ngcomp
 
         // build vertex map for idnr
         Array<int> vertex_map(GetNV());
-        for (auto i : Range(GetNV()))
-          vertex_map[i] = i;
+        ParallelFor (GetNV(), [&] (size_t i) { vertex_map[i] = i; });
         for (const auto& pair : (*periodic_node_pairs[NT_VERTEX])[pidnr])
           vertex_map[pair[1]] = pair[0];
 
-        // build vertex-pair to edge hashtable:
-        HashTable<INT<2>, int> vp2e(GetNEdges());
-        
-        for (size_t enr = 0; enr < GetNEdges(); enr++)
-          {
-            INT<2> vts = GetEdgePNums (enr);
-            vts.Sort();
-            vp2e[vts] = enr;
-          }
-        size_t count = 0;
-        for (size_t enr = 0; enr < GetNEdges(); enr++)
-          {
-            INT<2> vts = GetEdgePNums(enr);
-            size_t mv1 = vertex_map[vts[0]];
-            size_t mv2 = vertex_map[vts[1]];
-            if(mv1 != vts[0] && mv2 != vts[1])
-              count++;
-          }
-        periodic_node_pairs[NT_EDGE]->Append(Array<INT<2>>(count));
-        count = 0;
-        for (size_t enr = 0; enr < GetNEdges(); enr++)
-          {
-            INT<2> vts = GetEdgePNums (enr);
-            int mv1 = vertex_map[vts[0]];
-            int mv2 = vertex_map[vts[1]];
-            if(mv1 != vts[0] && mv2 != vts[1])
-              {               
-                if (mv1 > mv2) Swap(mv1,mv2);
-                int menr = vp2e.Get(INT<2>(mv1,mv2));
-                (*periodic_node_pairs[NT_EDGE])[pidnr][count][0] = menr;
-                (*periodic_node_pairs[NT_EDGE])[pidnr][count++][1] = enr;
-              }
-          }
-        // build vertex-triple to face hashtable
-        HashTable<INT<3>, int> v2f(GetNFaces());
-        for (auto fnr : Range(GetNFaces()))
-          {
-            auto pnums = GetFacePNums (fnr);
-            INT<3> i3(pnums[0], pnums[1], pnums[2]);
-            i3.Sort();
-            v2f[i3] = fnr;
-          }
-
-        count = 0;
-        for (auto fnr : Range(GetNFaces()))
-          {
-            auto pnums = GetFacePNums(fnr);
-            if(vertex_map[pnums[0]] != pnums[0] && vertex_map[pnums[1]] != pnums[1] &&
-               vertex_map[pnums[2]] != pnums[2])
-              {
-                count++;
-              }
-          }
-        periodic_node_pairs[NT_FACE]->Append(Array<INT<2>>(count));
-        count = 0;
-        for (auto fnr : Range(GetNFaces()))
-          {
-            auto pnums = GetFacePNums(fnr);
-            INT<3> mv(vertex_map[pnums[0]],vertex_map[pnums[1]],vertex_map[pnums[2]]);
-            if(mv[0] != pnums[0] && mv[1] != pnums[1] && mv[2] != pnums[2])
-              {
-                mv.Sort();
-                int mfnr = v2f[mv];
-                (*periodic_node_pairs[NT_FACE])[pidnr][count][0] = mfnr;
-                (*periodic_node_pairs[NT_FACE])[pidnr][count++][1] = fnr;
-              }
-          }
+        // master edge of every periodic edge: the edge with the mapped
+        // vertices is found among the edges of its smallest vertex
+        Array<int> master = MatchPeriodicNodes<2>
+          (GetNEdges(), GetNV(), vertex_map,
+           [&] (size_t enr) { return GetEdgePNums(enr); });
+        AppendPeriodicPairs (*periodic_node_pairs[NT_EDGE], master);
+
+        // the same for faces, identified by their first three vertices
+        master = MatchPeriodicNodes<3>
+          (GetNFaces(), GetNV(), vertex_map,
+           [&] (size_t fnr)
+           {
+             auto pnums = GetFacePNums(fnr);
+             return INT<3> (pnums[0], pnums[1], pnums[2]);
+           });
+        AppendPeriodicPairs (*periodic_node_pairs[NT_FACE], master);
       }
     
     CalcIdentifiedFacets();
@@ -1281,8 +1312,8 @@ namespace ngcomp
   {
     static Timer t("CalcIdentifiedFacets"); RegionTimer reg(t);
     identified_facets.SetSize(nnodes_cd[1]);
-    for(auto i : Range(identified_facets.Size()))
-      identified_facets[i] = std::tuple<int,int>(i,1);
+    ParallelFor (identified_facets.Size(), [&] (size_t i)
+                 { identified_facets[i] = std::tuple<int,int>(i,1); });
  
     // for periodic identification by now
     for(auto id : Range(GetNPeriodicIdentifications()))
@@ -1780,6 +1811,224 @@ namespace ngcomp
   }
 
 
+  /// uniform grid of the bounding boxes of the volume elements
+  class PointSearchGrid
+  {
+    int dim;
+    Vec<3> pmin, pmax, hinv;
+    INT<3> n;
+    /// elements per cell
+    Table<int> cells;
+
+    INT<3> CellIndex (const Vec<3> & p) const
+    {
+      INT<3> c(0, 0, 0);
+      for (int d = 0; d < dim; d++)
+        c[d] = max2 (0, min2 (n[d]-1, int (floor ((p(d)-pmin(d))*hinv(d)))));
+      return c;
+    }
+    size_t CellNr (INT<3> c) const { return (size_t(c[2])*n[1] + c[1])*n[0] + c[0]; }
+
+  public:
+    PointSearchGrid (const MeshAccess & ma);
+
+    /// elements whose boxes touch the cell of p, empty outside the mesh
+    FlatArray<int> Candidates (const Vec<3> & p) const
+    {
+      for (int d = 0; d < dim; d++)
+        if (!(p(d) >= pmin(d) && p(d) <= pmax(d)))
+          return FlatArray<int> (0, nullptr);
+      return cells[CellNr (CellIndex (p))];
+    }
+  };
+
+  PointSearchGrid :: PointSearchGrid (const MeshAccess & ma)
+  {
+    static Timer t("PointSearchGrid"); RegionTimer reg(t);
+    dim = ma.GetDimension();
+    size_t ne = ma.GetNE(VOL);
+
+    // boxes of vertices and edge midpoints, enlarged for curved elements
+    Array<Vec<3>> bmin(ne), bmax(ne);
+    ParallelForRange (ne, [&] (IntRange r)
+      {
+        LocalHeap lh(100000, "PointSearchGrid");
+        for (size_t i : r)
+          {
+            HeapReset hr(lh);
+            auto & trafo = ma.GetTrafo (ElementId(VOL, i), lh);
+            ELEMENT_TYPE et = trafo.GetElementType();
+            const POINT3D * verts = ElementTopology::GetVertices (et);
+            int nv = ElementTopology::GetNVertices (et);
+            Vec<3> lo(1e99), hi(-1e99);
+            for (int j = 0; j < nv; j++)
+              for (int k = j; k < nv; k++)
+                {
+                  IntegrationPoint ip (0.5*(verts[j][0]+verts[k][0]),
+                                       0.5*(verts[j][1]+verts[k][1]),
+                                       0.5*(verts[j][2]+verts[k][2]));
+                  Vec<3> x(0.0);
+                  trafo.CalcPoint (ip, FlatVector<> (dim, &x(0)));
+                  for (int d = 0; d < 3; d++)
+                    {
+                      lo(d) = min2 (lo(d), x(d));
+                      hi(d) = max2 (hi(d), x(d));
+                    }
+                }
+            Vec<3> margin = 0.1 * (hi-lo);
+            bmin[i] = lo - margin;
+            bmax[i] = hi + margin;
+          }
+      });
+
+    pmin = 1e99; pmax = -1e99;
+    for (size_t i = 0; i < ne; i++)
+      for (int d = 0; d < 3; d++)
+        {
+          pmin(d) = min2 (pmin(d), bmin[i](d));
+          pmax(d) = max2 (pmax(d), bmax[i](d));
+        }
+
+    // about one element per cell
+    n = INT<3> (1, 1, 1);
+    hinv = 0.0;
+    if (ne)
+      {
+        double vol = 1;
+        for (int d = 0; d < dim; d++)
+          vol *= max2 (pmax(d)-pmin(d), 1e-30);
+        double h = pow (vol/ne, 1.0/dim);
+        for (int d = 0; d < dim; d++)
+          {
+            double ext = max2 (pmax(d)-pmin(d), 1e-30);
+            n[d] = max2 (1, min2 (1024, int (ext/h)));
+            hinv(d) = n[d] / ext;
+          }
+      }
+
+    cells = ParallelCreateTable<int>
+      (ne, [&] (ParallelTableCreator<int> & creator, size_t el)
+       {
+         INT<3> c0 = CellIndex (bmin[el]);
+         INT<3> c1 = CellIndex (bmax[el]);
+         INT<3> c;
+         for (c[2] = c0[2]; c[2] <= c1[2]; c[2]++)
+           for (c[1] = c0[1]; c[1] <= c1[1]; c[1]++)
+             for (c[0] = c0[0]; c[0] <= c1[0]; c[0]++)
+               creator.Add (CellNr(c), el);
+       }, size_t(n[0])*n[1]*n[2]);
+  }
+
+
+  static bool IsInsideReference (ELEMENT_TYPE et, const IntegrationPoint & ip, double eps)
+  {
+    double x = ip(0), y = ip(1), z = ip(2);
+    switch (et)
+      {
+      case ET_SEGM: return x >= -eps && x <= 1+eps;
+      case ET_TRIG: return x >= -eps && y >= -eps && x+y <= 1+eps;
+      case ET_QUAD: return x >= -eps && x <= 1+eps && y >= -eps && y <= 1+eps;
+      case ET_TET: return x >= -eps && y >= -eps && z >= -eps && x+y+z <= 1+eps;
+      case ET_PRISM:
+        return x >= -eps && y >= -eps && x+y <= 1+eps && z >= -eps && z <= 1+eps;
+      case ET_PYRAMID:
+        return z >= -eps && z <= 1+eps && x >= -eps && y >= -eps && x <= 1-z+eps && y <= 1-z+eps;
+      case ET_HEX:
+        return x >= -eps && x <= 1+eps && y >= -eps && y <= 1+eps && z >= -eps && z <= 1+eps;
+      default:
+        return false;
+      }
+  }
+
+  /// Newton for the reference coordinates of p, true if p is in the element
+  static bool InverseMap (const ElementTransformation & trafo, int dim,
+                          const Vec<3> & p, IntegrationPoint & ip)
+  {
+    ELEMENT_TYPE et = trafo.GetElementType();
+    const POINT3D * verts = ElementTopology::GetVertices (et);
+    int nv = ElementTopology::GetNVertices (et);
+    Vec<3> xi(0.0);
+    for (int j = 0; j < nv; j++)
+      for (int d = 0; d < 3; d++)
+        xi(d) += verts[j][d] / nv;
+
+    double xmem[3], jmem[9];
+    FlatVector<> x(dim, xmem);
+    FlatMatrix<> jac(dim, dim, jmem);
+    for (int it = 0; it < 20; it++)
+      {
+        IntegrationPoint hip (xi(0), xi(1), xi(2));
+        trafo.CalcPointJacobian (hip, x, jac);
+        Mat<3,3> J = Id<3>();
+        Vec<3> res(0.0);
+        for (int i = 0; i < dim; i++)
+          {
+            res(i) = p(i) - x(i);
+            for (int j = 0; j < dim; j++)
+              J(i,j) = jac(i,j);
+          }
+        double det = Det (J);
+        if (!(fabs(det) > 1e-30)) return false;
+        Vec<3> dxi = Inv(J) * res;
+        xi += dxi;
+        if (!(L2Norm(xi) < 10)) return false;
+        if (L2Norm(dxi) < 1e-12) break;
+      }
+    ip = IntegrationPoint (xi(0), xi(1), xi(2));
+    return IsInsideReference (et, ip, 1e-8);
+  }
+
+  void MeshAccess :: ClearPointSearchGrid () const
+  {
+    lock_guard<mutex> guard(point_search_mutex);
+    point_search_grid = nullptr;
+  }
+
+  void MeshAccess :: FindElementsOfPoints (FlatArray<Vec<3>> points, FlatArray<int> elnrs,
+                                           FlatArray<IntegrationPoint> ips) const
+  {
+    static Timer t("MeshAccess::FindElementsOfPoints"); RegionTimer reg(t);
+    if (elnrs.Size() != points.Size() || ips.Size() != points.Size())
+      throw Exception ("FindElementsOfPoints: need one element number and ip per point");
+
+    shared_ptr<PointSearchGrid> grid;
+    {
+      lock_guard<mutex> guard(point_search_mutex);
+      if (!point_search_grid)
+        point_search_grid = make_shared<PointSearchGrid> (*this);
+      grid = point_search_grid;
+    }
+
+    int ne = GetNE(VOL);
+    ParallelForRange (points.Size(), [&] (IntRange r)
+      {
+        LocalHeap lh(100000, "FindElementsOfPoints");
+        for (size_t i : r)
+          {
+            int hint = elnrs[i];
+            elnrs[i] = -1;
+            auto try_element = [&] (int el)
+              {
+                HeapReset hr(lh);
+                auto & trafo = GetTrafo (ElementId(VOL, el), lh);
+                return InverseMap (trafo, dim, points[i], ips[i]);
+              };
+            if (hint >= 0 && hint < ne && try_element (hint))
+              {
+                elnrs[i] = hint;
+                continue;
+              }
+            for (int el : grid->Candidates (points[i]))
+              if (el != hint && try_element (el))
+                {
+                  elnrs[i] = el;
+                  break;
+                }
+          }
+      });
+  }
+
+
   void NGSolveTaskManager (function<void(int,int)> func)
   {
     // cout << "call ngsolve taskmanager from netgen, tm = " << task_manager << endl;
@@ -1819,6 +2068,8 @@ namespace ngcomp
   void MeshAccess :: Curve (int order)
   {
     mesh.Curve(order);
+    ClearAffineTrafos();
+    ClearPointSearchGrid();
   } 
   
   int MeshAccess :: GetNPairsPeriodicVertices () const 
@@ -1933,6 +2184,46 @@ namespace ngcomp
     elems = GetVertexSurfaceElements(vnr);
   }
 
+  template <int DIM>
+  static void FillAffineTrafos (const MeshAccess & ma, FlatArray<double> table)
+  {
+    size_t ne = ma.GetNE(VOL);
+    size_t size = ma.AffineTrafoSize();
+    ParallelForRange
+      (ne, [&] (IntRange r)
+       {
+         for (auto i : r)
+           {
+             ElementId ei(VOL, i);
+             Ngs_Element el = ma.GetElement(ei);
+             if (el.is_curved) continue;
+             Ng_ConstElementTransformation<DIM,DIM> trafo(&ma, el.GetType(), ei, el.GetIndex());
+             double * data = &table[i*size];
+             double det;
+             trafo.GetAffineJacobian (FlatVector<> (DIM, data),
+                                      FlatMatrix<> (DIM, DIM, data+DIM),
+                                      FlatMatrix<> (DIM, DIM, data+DIM+DIM*DIM), det);
+           }
+       });
+  }
+
+  void MeshAccess :: PrecomputeAffineTrafos ()
+  {
+    static Timer t("MeshAccess::PrecomputeAffineTrafos"); RegionTimer reg(t);
+    // the trafos below must not read the old table
+    affine_trafos.SetSize0();
+    Array<double> table(GetNE(VOL)*AffineTrafoSize());
+    table = 0.0;
+    switch (dim)
+      {
+      case 1: FillAffineTrafos<1> (*this, table); break;
+      case 2: FillAffineTrafos<2> (*this, table); break;
+      case 3: FillAffineTrafos<3> (*this, table); break;
+      default: return;
+      }
+    affine_trafos = move(table);
+  }
+
   void MeshAccess::SetHigherIntegrationOrder(int elnr)
   {
     if(higher_integration_order.Size() != GetNE())
@@ -190,6 +190,7 @@ namespace ngcomp
   */
 
   class GridFunction;
+  class PointSearchGrid;
 
   class NGS_DLL_HEADER MeshAccess : public BaseStatusHandler
   {
@@ -639,6 +640,7 @@ namespace ngcomp
     void SetDeformation (shared_ptr<GridFunction> def = nullptr)
     {
       deformation = def;
+      ClearPointSearchGrid();
     }
 
     const shared_ptr<GridFunction> & GetDeformation () const
@@ -1084,7 +1086,42 @@ namespace ngcomp
 
   private:
     Array<bool> higher_integration_order;
+    /// p0, Jacobian and inverse Jacobian of non-curved volume elements
+    Array<double> affine_trafos;
   public:
+    /**
+       Precomputes the constant mappings of all non-curved volume
+       elements, element transformations take them from the table
+       instead of asking netgen.  The table is dropped when the mesh
+       changes.
+    */
+    void PrecomputeAffineTrafos ();
+    void ClearAffineTrafos () { affine_trafos.SetSize0(); }
+    /// entries per element in the table
+    size_t AffineTrafoSize () const { return dim + 2*dim*dim; }
+    /// nullptr if not precomputed
+    const double * GetAffineTrafo (ElementId ei) const
+    {
+      if (!ei.IsVolume() || affine_trafos.Size() == 0) return nullptr;
+      return &affine_trafos[ei.Nr()*AffineTrafoSize()];
+    }
+
+  private:
+    /// uniform grid of volume element bounding boxes, built on demand
+    mutable shared_ptr<PointSearchGrid> point_search_grid;
+    mutable mutex point_search_mutex;
+  public:
+    /**
+       Batched point location in volume elements, thread safe.  A
+       uniform grid of element bounding boxes is built in parallel on
+       the first call and dropped when the mesh changes.  On input
+       elnrs are search hints (e.g. the elements of the previous time
+       step, or -1), on output the elements found, or -1.
+    */
+    void FindElementsOfPoints (FlatArray<Vec<3>> points, FlatArray<int> elnrs,
+                               FlatArray<IntegrationPoint> ips) const;
+    void ClearPointSearchGrid () const;
+
     void SetHigherIntegrationOrder(int elnr);
     void UnSetHigherIntegrationOrder(int elnr);
 
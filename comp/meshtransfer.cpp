@@ -0,0 +1,205 @@
+/*********************************************************************/
+/* File:   meshtransfer.cpp                                          */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+#include <comp.hpp>
+
+namespace ngcomp
+{
+
+  shared_ptr<SparseMatrix<double>>
+  CreateTransferMatrix (const FESpace & from, const FESpace & to, LocalHeap & clh)
+  {
+    static Timer t("CreateTransferMatrix"); RegionTimer reg(t);
+    static Timer tloc("CreateTransferMatrix - locate");
+    static Timer tmat("CreateTransferMatrix - matrix");
+
+    auto ma_from = from.GetMeshAccess();
+    auto ma_to = to.GetMeshAccess();
+    auto eval_from = from.GetEvaluator(VOL);
+    auto eval_to = to.GetEvaluator(VOL);
+    if (from.IsComplex() || to.IsComplex())
+      throw Exception ("CreateTransferMatrix: only real spaces are supported");
+    if (!eval_from || !eval_to || eval_from->Dim() != eval_to->Dim())
+      throw Exception ("CreateTransferMatrix: spaces need evaluators of equal dimension");
+    if (ma_from->GetDimension() != ma_to->GetDimension())
+      throw Exception ("CreateTransferMatrix: meshes of different dimension");
+
+    size_t ne = ma_to->GetNE(VOL);
+    int dimval = eval_to->Dim();
+    int order_from = from.GetOrder();
+
+    auto get_ir = [&] (const FiniteElement & fel) -> const IntegrationRule &
+      {
+        return SelectIntegrationRule (fel.ElementType(), fel.Order()+max2(fel.Order(), order_from));
+      };
+
+    // the integration points of all target elements, in physical coordinates
+    Array<int> first(ne+1);
+    first[ne] = 0;
+    ParallelForRange (ne, [&] (IntRange r)
+      {
+        LocalHeap lh = clh.Split();
+        for (size_t i : r)
+          {
+            HeapReset hr(lh);
+            ElementId ei(VOL, i);
+            first[i] = to.DefinedOn(ei) ? get_ir (to.GetFE(ei, lh)).Size() : 0;
+          }
+      });
+    size_t np = ParallelPrefixSum (FlatArray<int> (first), 0);
+
+    Array<Vec<3>> points(np);
+    ParallelForRange (ne, [&] (IntRange r)
+      {
+        LocalHeap lh = clh.Split();
+        for (size_t i : r)
+          {
+            if (first[i+1] == first[i]) continue;
+            HeapReset hr(lh);
+            ElementId ei(VOL, i);
+            auto & ir = get_ir (to.GetFE(ei, lh));
+            auto & mir = ma_to->GetTrafo(ei, lh) (ir, lh);
+            for (size_t q = 0; q < ir.Size(); q++)
+              {
+                Vec<3> p = 0.0;
+                auto x = mir[q].GetPoint();
+                for (int d = 0; d < x.Size(); d++)
+                  p(d) = x(d);
+                points[first[i]+q] = p;
+              }
+          }
+      });
+
+    // first points of the elements are located alone, their elements
+    // are the search hints for the other points of the element
+    Array<int> elnrs(np);
+    Array<IntegrationPoint> ips(np);
+    tloc.Start();
+    {
+      Array<Vec<3>> leading(ne);
+      Array<int> lead_elnrs(ne);
+      Array<IntegrationPoint> lead_ips(ne);
+      ParallelFor (ne, [&] (size_t i)
+                   {
+                     leading[i] = (first[i+1] > first[i]) ? points[first[i]] : Vec<3>(1e99);
+                     lead_elnrs[i] = -1;
+                   });
+      ma_from->FindElementsOfPoints (leading, lead_elnrs, lead_ips);
+      ParallelFor (ne, [&] (size_t i)
+                   {
+                     for (int p = first[i]; p < first[i+1]; p++)
+                       elnrs[p] = lead_elnrs[i];
+                   });
+      ma_from->FindElementsOfPoints (points, elnrs, ips);
+    }
+    tloc.Stop();
+
+    RegionTimer rmat(tmat);
+    Table<DofId> rowdofs = ParallelCreateTable<DofId>
+      (ne, [&] (ParallelTableCreator<DofId> & creator, size_t i)
+       {
+         if (first[i+1] == first[i]) return;
+         ArrayMem<DofId,100> dnums;
+         to.GetDofNrs (ElementId(VOL, i), dnums);
+         creator.Add (i, dnums);
+       }, ne);
+
+    // all source dofs seen by the points of the element, without repetition
+    auto collect_coldofs = [&] (size_t i, Array<DofId> & coldofs)
+      {
+        ArrayMem<DofId,100> dnums;
+        coldofs.SetSize0();
+        int last = -1;
+        for (int p = first[i]; p < first[i+1]; p++)
+          if (elnrs[p] >= 0 && elnrs[p] != last)
+            {
+              last = elnrs[p];
+              from.GetDofNrs (ElementId(VOL, last), dnums);
+              for (auto d : dnums)
+                if (IsRegularDof(d) && !coldofs.Contains(d))
+                  coldofs.Append (d);
+            }
+      };
+    Table<DofId> coldofs = ParallelCreateTable<DofId>
+      (ne, [&] (ParallelTableCreator<DofId> & creator, size_t i)
+       {
+         Array<DofId> cols;
+         collect_coldofs (i, cols);
+         creator.Add (i, cols);
+       }, ne);
+
+    // number of target elements sharing a dof, for averaging
+    Array<int> multiplicity(to.GetNDof());
+    multiplicity = 0;
+    for (size_t i = 0; i < ne; i++)
+      for (auto d : rowdofs[i])
+        if (IsRegularDof(d))
+          multiplicity[d]++;
+
+    auto mat = make_shared<SparseMatrix<double>>
+      (MatrixGraph (to.GetNDof(), from.GetNDof(), rowdofs, coldofs, false), true);
+
+    ParallelForRange (ne, [&] (IntRange r)
+      {
+        LocalHeap lh = clh.Split();
+        ArrayMem<DofId,100> dnums_from;
+        for (size_t i : r)
+          {
+            if (first[i+1] == first[i]) continue;
+            HeapReset hr(lh);
+            ElementId ei(VOL, i);
+            auto & fel = to.GetFE(ei, lh);
+            auto & ir = get_ir (fel);
+            auto & mir = ma_to->GetTrafo(ei, lh) (ir, lh);
+            FlatArray<DofId> rows = rowdofs[i];
+            FlatArray<DofId> cols = coldofs[i];
+            size_t nd = fel.GetNDof();
+
+            FlatMatrix<> mass(nd, nd, lh);
+            FlatMatrix<> rhs(nd, cols.Size(), lh);
+            FlatMatrix<double,ColMajor> bmat(dimval, nd, lh);
+            mass = 0.0;
+            rhs = 0.0;
+
+            for (size_t q = 0; q < ir.Size(); q++)
+              {
+                HeapReset hrq(lh);
+                eval_to->CalcMatrix (fel, mir[q], bmat, lh);
+                double w = mir[q].GetWeight();
+                mass += w * Trans(bmat) * bmat;
+
+                int p = first[i]+q;
+                if (elnrs[p] < 0) continue;
+                ElementId ei_from(VOL, elnrs[p]);
+                auto & fel_from = from.GetFE(ei_from, lh);
+                auto & mip_from = ma_from->GetTrafo(ei_from, lh) (ips[p], lh);
+                FlatMatrix<double,ColMajor> amat(dimval, fel_from.GetNDof(), lh);
+                eval_from->CalcMatrix (fel_from, mip_from, amat, lh);
+                FlatMatrix<> amatT(fel_from.GetNDof(), dimval, lh);
+                amatT = Trans(amat);
+                from.TransformMat (ei_from, amatT, TRANSFORM_MAT_LEFT);
+
+                from.GetDofNrs (ei_from, dnums_from);
+                FlatMatrix<> contrib(nd, fel_from.GetNDof(), lh);
+                contrib = w * Trans(bmat) * Trans(amatT);
+                for (size_t k = 0; k < dnums_from.Size(); k++)
+                  if (IsRegularDof(dnums_from[k]))
+                    rhs.Col(cols.Pos(dnums_from[k])) += contrib.Col(k);
+              }
+
+            CalcInverse (mass);
+            FlatMatrix<> elmat(nd, cols.Size(), lh);
+            elmat = mass * rhs;
+            to.TransformMat (ei, elmat, TRANSFORM_MAT_LEFT);
+            for (size_t k = 0; k < nd; k++)
+              if (IsRegularDof(rows[k]))
+                elmat.Row(k) *= 1.0 / multiplicity[rows[k]];
+            mat->AddElementMatrix (rows, cols, elmat, true);
+          }
+      });
+    return mat;
+  }
+
+}
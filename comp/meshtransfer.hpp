@@ -0,0 +1,30 @@
+#pragma once
+
+/*********************************************************************/
+/* File:   meshtransfer.hpp                                          */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+namespace ngcomp
+{
+
+  /**
+     Sparse interpolation from a space on one mesh to a space on
+     another, non-matching mesh, e.g. after remeshing.
+
+     Every element of the target space gets the local L2 projection
+     of the source function, evaluated in the element's integration
+     points; coefficients of dofs shared by several elements are
+     averaged.  Functions of the target space which are also in the
+     source space are reproduced exactly.  The points are located
+     once, so every transfer is a single sparse matrix-vector product:
+
+       gfto.vec.data = mat * gffrom.vec
+
+     Both spaces must be real and have evaluators of equal dimension.
+     Target points outside of the source mesh contribute zero.
+  */
+  NGS_DLL_HEADER shared_ptr<SparseMatrix<double>>
+  CreateTransferMatrix (const FESpace & from, const FESpace & to, LocalHeap & lh);
+
+}
@@ -0,0 +1,234 @@
+/*********************************************************************/
+/* File:   newton.cpp                                                */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+#include <comp.hpp>
+
+namespace ngcomp
+{
+
+  /// y = P A'(lin) P x, applied matrix-free, P the projection on the free dofs
+  class NewtonJacobian : public BaseMatrix
+  {
+    const BilinearForm & bfa;
+    const BaseVector & lin;
+    Projector proj;
+    LocalHeap & lh;
+    mutable AutoVector hx, hy;
+  public:
+    NewtonJacobian (const BilinearForm & abfa, const BaseVector & alin,
+                    shared_ptr<BitArray> freedofs, LocalHeap & alh)
+      : bfa(abfa), lin(alin), proj(freedofs, true), lh(alh),
+        hx(alin.CreateVector()), hy(alin.CreateVector()) { ; }
+
+    virtual bool IsComplex() const override { return false; }
+    virtual int VHeight() const override { return lin.Size(); }
+    virtual int VWidth() const override { return lin.Size(); }
+    virtual AutoVector CreateRowVector () const override { return lin.CreateVector(); }
+    virtual AutoVector CreateColVector () const override { return lin.CreateVector(); }
+
+    virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const override
+    {
+      HeapReset hr(lh);
+      *hx = x;
+      proj.Project (*hx);
+      *hy = 0;
+      bfa.ApplyLinearizedMatrixAdd (1, lin, *hx, *hy, lh);
+      proj.Project (*hy);
+      y.Add (s, *hy);
+    }
+  };
+
+
+  NewtonSolver ::
+  NewtonSolver (shared_ptr<BilinearForm> abfa, shared_ptr<BitArray> afreedofs,
+                const Flags & flags)
+    : bfa(abfa), freedofs(afreedofs)
+  {
+    maxit = int(flags.GetNumFlag ("maxit", 100));
+    maxerr = flags.GetNumFlag ("maxerr", 1e-11);
+    inverse = flags.GetStringFlag ("inverse", "");
+    dampfactor = flags.GetNumFlag ("dampfactor", 1);
+    linesearch = flags.GetDefineFlag ("linesearch");
+    energy = flags.GetDefineFlag ("energy");
+    jacobian_lag = max2 (1, int(flags.GetNumFlag ("jacobian_lag", 1)));
+    jacobian_lag_rate = flags.GetNumFlag ("jacobian_lag_rate", 1);
+    krylov = flags.GetDefineFlag ("krylov");
+    krylov_tol = flags.GetNumFlag ("krylov_tol", 0.1);
+    krylov_maxsteps = int(flags.GetNumFlag ("krylov_maxsteps", 50));
+    printing = flags.GetDefineFlag ("printing");
+
+    if (bfa->GetFESpace()->IsComplex())
+      throw Exception ("NewtonSolver: only real problems");
+    if (krylov && bfa->UsesEliminateInternal())
+      throw Exception ("NewtonSolver: krylov does not work with condense");
+    if (!freedofs)
+      freedofs = bfa->GetFESpace()->GetFreeDofs (bfa->UsesEliminateInternal());
+  }
+
+
+  void NewtonSolver :: Linearize (const BaseVector & u, LocalHeap & lh)
+  {
+    static Timer t("NewtonSolver::Linearize"); RegionTimer reg(t);
+    bfa->AssembleLinearization (u, lh);
+    nassemble++;
+
+    // same matrix object and sparsity, the factorization can reuse its ordering
+    auto mat = bfa->GetMatrixPtr();
+    auto fact = dynamic_pointer_cast<SparseFactorization> (inv);
+    if (fact && fact->SupportsUpdate() && fact->GetAMatrix() == mat)
+      {
+        fact->Update();
+        nupdate++;
+        return;
+      }
+
+    if (inverse != "")
+      mat->SetInverseType (inverse);
+    inv = mat->InverseMatrix (freedofs);
+    nfactor++;
+  }
+
+
+  int NewtonSolver :: Solve (BaseVector & u, LocalHeap & lh)
+  {
+    static Timer t("NewtonSolver::Solve"); RegionTimer reg(t);
+    static Timer tres("NewtonSolver::Residual");
+    static Timer tsolve("NewtonSolver::Correction");
+
+    auto r = u.CreateVector();
+    auto w = u.CreateVector();
+    auto uh = u.CreateVector();
+    auto hv = u.CreateVector();
+
+    // residual merit on all free dofs, also the condensed ones
+    Projector freeproj (bfa->GetFESpace()->GetFreeDofs(), true);
+    auto ResNorm = [&] (const BaseVector & res)
+      {
+        *hv = res;
+        freeproj.Project (*hv);
+        return L2Norm (*hv);
+      };
+
+    // r = A(v), and the merit of v
+    auto Evaluate = [&] (const BaseVector & v)
+      {
+        RegionTimer reg(tres);
+        if (energy)
+          return bfa->ApplyEnergy (v, *r, lh);
+        bfa->ApplyMatrix (v, *r, lh);
+        return ResNorm (*r);
+      };
+
+    bool condense = bfa->UsesEliminateInternal();
+
+    numit = 0;
+    nassemble = nfactor = nupdate = nkrylov = nlinesearch = 0;
+    inv = nullptr;
+
+    int age = 0;
+    double errold = 0;
+    double resnorm = 0, resnorm_old = 0, eta = krylov_tol;
+    double merit = Evaluate (u);
+
+    for (int it = 0; it < maxit; it++)
+      {
+        numit++;
+        bool lagged = inv && age < jacobian_lag && !(errold > 0 && err > jacobian_lag_rate * errold);
+        if (!lagged)
+          {
+            Linearize (u, lh);
+            age = 0;
+          }
+        age++;
+
+        {
+          RegionTimer reg(tsolve);
+          if (condense)
+            {
+              // the condensed system, as assembled with the Jacobian
+              hv.Set (1, *r);
+              bfa->GetHarmonicExtensionTrans()->MultAdd (1, *r, *hv);
+              inv->Mult (*hv, *w);
+              bfa->GetHarmonicExtension()->Mult (*w, *uh);
+              *w += *uh;
+              bfa->GetInnerSolve()->MultAdd (1, *r, *w);
+            }
+          else if (krylov && lagged)
+            {
+              // inexact Newton, Eisenstat-Walker choice 2 for the tolerance
+              resnorm = ResNorm (*r);
+              if (resnorm_old > 0)
+                {
+                  double etanew = 0.9 * sqr (resnorm / resnorm_old);
+                  if (0.9 * sqr (eta) > 0.1)
+                    etanew = max2 (etanew, 0.9 * sqr (eta));
+                  eta = min2 (krylov_tol, etanew);
+                }
+              resnorm_old = resnorm;
+
+              NewtonJacobian jac (*bfa, u, freedofs, lh);
+              GMRESSolver<double> gmres (jac, *inv);
+              gmres.SetRelativePrecision (eta);
+              gmres.SetMaxSteps (krylov_maxsteps);
+              gmres.SetInitialize (1);
+              *hv = *r;
+              Projector (freedofs, true).Project (*hv);
+              gmres.Mult (*hv, *w);
+              nkrylov += gmres.GetSteps();
+            }
+          else
+            {
+              inv->Mult (*r, *w);
+              if (krylov) resnorm_old = ResNorm (*r);
+            }
+        }
+
+        // <r, w> is the decrease of the energy in direction -w
+        double slope = InnerProduct (*w, *r);
+        errold = err;
+        err = sqrt (fabs (slope));
+        if (printing)
+          cout << "Newton iteration " << it << ", err = " << err
+               << (energy ? ", energy = " : ", residual = ") << merit
+               << (lagged ? ", lagged" : "") << endl;
+
+        double tau = linesearch ? 1 : min2 (1.0, numit * dampfactor);
+        uh.Set (1, u);
+        uh.Add (-tau, *w);
+
+        if (linesearch)
+          {
+            // Armijo: sufficient decrease of the merit function
+            constexpr double c = 1e-4;
+            double newmerit = Evaluate (*uh);
+            while (tau > 1e-10 &&
+                   newmerit > (energy ? merit - c * tau * slope : (1 - c * tau) * merit))
+              {
+                tau *= 0.5;
+                nlinesearch++;
+                uh.Set (1, u);
+                uh.Add (-tau, *w);
+                newmerit = Evaluate (*uh);
+                if (printing)
+                  cout << "  tau = " << tau << ", merit = " << newmerit << endl;
+              }
+            u = *uh;
+            merit = newmerit;
+          }
+        else
+          {
+            u = *uh;
+            merit = Evaluate (u);
+          }
+
+        if (err < maxerr)
+          return 0;
+      }
+
+    cout << IM(1) << "Warning: Newton might not converge!" << endl;
+    return -1;
+  }
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+/*********************************************************************/
+/* File:   newton.hpp                                                */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+namespace ngcomp
+{
+
+  /**
+     Newton's method for A(u) = 0, with A given by a (non-linear)
+     bilinear-form. Replaces the Python loops of solvers.Newton.
+
+     The step w solves  A'(u) w = A(u), followed by u -= tau w.
+
+     Flags:
+       maxit, maxerr      iterations, and the error sqrt|<w,A(u)>| to stop
+       inverse            sparse direct solver for A'(u)
+       dampfactor         tau = min(1, it*dampfactor) without line search
+       linesearch         Armijo backtracking from tau = 1
+       energy             the merit function of the line search is the
+                          energy (minimization problems), otherwise |A(u)|
+       jacobian_lag       re-assemble A'(u) every k-th step only
+       jacobian_lag_rate  ... and when the error decreased less than by
+                          this factor
+       krylov             inexact Newton: between re-assemblies solve with
+                          GMRES for the current A'(u), matrix-free, and
+                          the lagged factorization as preconditioner.
+                          The tolerance follows Eisenstat-Walker from
+                          krylov_tol down, krylov_maxsteps steps at most
+       printing
+
+     A re-assembly keeps the matrix, so factorizations which support it
+     are refactored by SparseFactorization::Update, with their ordering.
+     Residual and energy come from BilinearForm::ApplyEnergy, which
+     needs one element loop for both.
+  */
+  class NGS_DLL_HEADER NewtonSolver
+  {
+    shared_ptr<BilinearForm> bfa;
+    shared_ptr<BitArray> freedofs;
+
+    int maxit;
+    double maxerr;
+    string inverse;
+    double dampfactor;
+    bool linesearch;
+    bool energy;
+    int jacobian_lag;
+    double jacobian_lag_rate;
+    bool krylov;
+    double krylov_tol;
+    int krylov_maxsteps;
+    bool printing;
+
+    shared_ptr<BaseMatrix> inv;
+
+    int numit = 0;
+    int nassemble = 0, nfactor = 0, nupdate = 0, nkrylov = 0, nlinesearch = 0;
+    double err = 0;
+
+  public:
+    NewtonSolver (shared_ptr<BilinearForm> abfa, shared_ptr<BitArray> afreedofs,
+                  const Flags & flags);
+
+    /// Newton iteration from u, returns 0 if converged, -1 otherwise
+    int Solve (BaseVector & u, LocalHeap & lh);
+
+    int GetNumIt () const { return numit; }
+    double GetError () const { return err; }
+    /// assemblies of A'(u), new factorizations, and refactorizations by Update
+    int GetNAssemble () const { return nassemble; }
+    int GetNFactor () const { return nfactor; }
+    int GetNUpdate () const { return nupdate; }
+    /// GMRES steps of the inexact Newton steps
+    int GetNKrylov () const { return nkrylov; }
+    /// rejected line search steps
+    int GetNLineSearch () const { return nlinesearch; }
+
+  private:
+    void Linearize (const BaseVector & u, LocalHeap & lh);
+  };
+
+}
@@ -611,6 +611,9 @@ namespace ngcomp
           trace->SetMaxTracefileSize( 1024*1024 * trace_flags.GetNumFlag("max_size", 100.0) + 0.5 );
         trace->SetTraceThreads( !trace_flags.GetDefineFlag("nothreads") );
         trace->SetTraceThreadCounter( !trace_flags.GetDefineFlag("nothread_counter") );
+        if(trace_flags.GetDefineFlag("chrome"))
+          PajeTrace::SetTraceFormat( PajeTrace::CHROME );
+        PajeTrace::SetRingBuffer( trace_flags.GetDefineFlag("ringbuffer") );
         TaskManager::SetPajeTrace(true);
       }
 
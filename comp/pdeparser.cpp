@@ -509,6 +509,27 @@ namespace ngcomp
   };
 
 
+  /*
+    With the constant compile_coefficients = 1 variable coefficients are
+    translated into coefficient function trees and compiled, with 2 into
+    machine code. Coefficients which can not be translated stay with the
+    bytecode interpreter.
+  */
+  static shared_ptr<CoefficientFunction>
+  VariableCoefficient (const PDE & pde, shared_ptr<DomainVariableCoefficientFunction> cf)
+  {
+    double comp = pde.GetConstant ("compile_coefficients", true);
+    if (comp < 0.5) return cf;
+    auto tree = cf->GetCoefficientFunction();
+    if (!tree)
+      {
+        cout << IM(3) << "coefficient not translated, uses bytecode" << endl;
+        return cf;
+      }
+    return Compile (tree, comp > 1.5);
+  }
+
+
   void CommandList (bool nomeshload = false, const bool nogeometryload = false);
   void DefineCommand ();
   void NumProcCommand ();
@@ -844,7 +865,7 @@ namespace ngcomp
                   cnt++;
                   string coefname = "assigncoef" + ToString(cnt);
                   pde->AddCoefficientFunction
-                    (coefname, make_shared<DomainVariableCoefficientFunction>(*fun, depends));
+                    (coefname, VariableCoefficient (*pde, make_shared<DomainVariableCoefficientFunction>(*fun, depends)));
                   Flags flags = ParseFlags();
                   flags.SetFlag ("gridfunction", gfname.c_str());
                   flags.SetFlag ("coefficient", coefname.c_str());
@@ -1190,7 +1211,7 @@ namespace ngcomp
 		{
 		  (*testout) << "material coefficients variable " << endl;
                   pde->AddCoefficientFunction
-                    (name, make_shared<DomainVariableCoefficientFunction>(coeffs));
+                    (name, VariableCoefficient (*pde, make_shared<DomainVariableCoefficientFunction>(coeffs)));
 		}
 
               /*
@@ -1346,7 +1367,7 @@ namespace ngcomp
 		{
 		  (*testout) << "material coefficients variable " << endl;
                   pde->AddCoefficientFunction
-                    (name, make_shared<DomainVariableCoefficientFunction>(coeffs));
+                    (name, VariableCoefficient (*pde, make_shared<DomainVariableCoefficientFunction>(coeffs)));
 		}
 	      
 	      // for (int hi = 0; hi < coeffs.Size(); hi++)
@@ -1520,7 +1541,7 @@ namespace ngcomp
 		    }
 
                   pde->AddCoefficientFunction
-                    (name, make_shared<DomainVariableCoefficientFunction>(coeffs, depends));
+                    (name, VariableCoefficient (*pde, make_shared<DomainVariableCoefficientFunction>(coeffs, depends)));
                   
 		  // for (int hi = 0; hi < coeffs.Size(); hi++)
                   // delete coeffs[hi];
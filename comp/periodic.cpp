@@ -21,6 +21,8 @@ namespace ngcomp {
           integrator[vb] = space->GetIntegrator(vb);
         }
       iscomplex = space->IsComplex();
+      // the periodic dof map is applied once when the element tables are built
+      use_dof_tables = true;
       // not yet working...
       if (space->LowOrderFESpacePtr() && false)
         {
@@ -36,10 +38,8 @@ namespace ngcomp {
       FESpace::Update(lh);
       dofmap.SetSize (space->GetNDof());
       vertex_map.SetSize(ma->GetNV());
-      for (int i = 0; i < dofmap.Size(); i++)
-	dofmap[i] = i;
-      for (int i : Range(vertex_map.Size()))
-        vertex_map[i] = i;
+      ParallelFor (dofmap.Size(), [&] (size_t i) { dofmap[i] = i; });
+      ParallelFor (vertex_map.Size(), [&] (size_t i) { vertex_map[i] = i; });
 
       for (auto idnr : Range(ma->GetNPeriodicIdentifications()))
         {
@@ -67,12 +67,10 @@ namespace ngcomp {
             }
         }
       ctofdof.SetSize(dofmap.Size());
-      for (auto i : Range(ctofdof.Size()))
-        ctofdof[i] = space->GetDofCouplingType(i);
-      for (int i = 0; i < dofmap.Size(); i++)
-	if (dofmap[i] != i){
-          ctofdof[i] = UNUSED_DOF;
-	}
+      ParallelFor (ctofdof.Size(), [&] (size_t i)
+        {
+          ctofdof[i] = (dofmap[i] != int(i)) ? UNUSED_DOF : space->GetDofCouplingType(i);
+        });
     }
     
   FiniteElement& PeriodicFESpace :: GetFE (ElementId ei, Allocator & alloc) const
@@ -132,6 +130,11 @@ namespace ngcomp {
   
   void PeriodicFESpace :: GetDofNrs(ElementId ei, Array<DofId> & dnums) const
     {
+      if (HasDofTable(ei.VB()))
+        {
+          dnums = dof_tables[ei.VB()][ei.Nr()];
+          return;
+        }
       space->GetDofNrs(ei,dnums);
       for (auto & d : dnums)
         if (IsRegularDof(d)) d = dofmap[d];
@@ -176,11 +179,39 @@ namespace ngcomp {
   void QuasiPeriodicFESpace :: Update (LocalHeap & lh)
   {
     space->Update(lh);
-    dof_factors.SetSize(space->GetNDof());
-    for (auto i : Range(dof_factors.Size()))
-      dof_factors[i] = Complex(1.0,0.0);
+    mapped_dofs.SetSize0();
     PeriodicFESpace::Update(lh);
+    SetFactors (factors);
+
+    // local numbers and dofs of the element dofs with a phase factor,
+    // so the transformations need neither dof numbers nor the map
+    static Timer t("QuasiPeriodicFESpace::Update - factor tables");
+    RegionTimer reg(t);
+    for (auto vb : { VOL, BND, BBND, BBBND })
+      factor_dofs[vb] = ParallelCreateTable<INT<2>>
+        (ma->GetNE(vb), [&] (ParallelTableCreator<INT<2>> & creator, size_t nr)
+         {
+           ArrayMem<DofId,100> dofnrs;
+           space->GetDofNrs (ElementId(vb, nr), dofnrs);
+           for (int i : Range(dofnrs.Size()))
+             if (IsRegularDof(dofnrs[i]) && dofnrs[i] != dofmap[dofnrs[i]])
+               creator.Add (nr, INT<2> (i, dofnrs[i]));
+         }, ma->GetNE(vb));
   }
+
+  void QuasiPeriodicFESpace :: SetFactors (shared_ptr<Array<Complex>> afactors)
+  {
+    for (auto md : mapped_dofs)
+      if (size_t(md[1]) >= afactors->Size())
+        throw Exception("QuasiPeriodicFESpace::SetFactors: no factor for identification "
+                        + ToString(md[1]));
+    factors = afactors;
+    dof_factors.SetSize(space->GetNDof());
+    ParallelFor (dof_factors.Size(), [&] (size_t i) { dof_factors[i] = Complex(1.0,0.0); });
+    for (auto md : mapped_dofs)
+      dof_factors[md[0]] *= (*factors)[md[1]];
+  }
+
   void QuasiPeriodicFESpace :: VTransformMR (ElementId ei, SliceMatrix<double> mat, TRANSFORM_TYPE tt) const
   {
     throw Exception("Shouldn't get here: QuasiPeriodicFESpace::TransformMR, space should always be complex");
@@ -189,17 +220,12 @@ namespace ngcomp {
   void QuasiPeriodicFESpace :: VTransformMC (ElementId ei, SliceMatrix<Complex> mat, TRANSFORM_TYPE tt) const
   {
     PeriodicFESpace::VTransformMC(ei, mat, tt);
-    Array<int> dofnrs;
-    space->GetDofNrs(ei, dofnrs);
-    for (int i : Range(dofnrs.Size()))
+    for (auto fd : factor_dofs[ei.VB()][ei.Nr()])
       {
-	if (dofnrs[i] != dofmap[dofnrs[i]])
-	  {
-	    if (tt & TRANSFORM_MAT_LEFT)
-	      mat.Row(i) *= conj(dof_factors[dofnrs[i]]);
-	    if (tt & TRANSFORM_MAT_RIGHT)
-	      mat.Col(i) *= dof_factors[dofnrs[i]];
-	  }
+        if (tt & TRANSFORM_MAT_LEFT)
+          mat.Row(fd[0]) *= conj(dof_factors[fd[1]]);
+        if (tt & TRANSFORM_MAT_RIGHT)
+          mat.Col(fd[0]) *= dof_factors[fd[1]];
       }
   }
 
@@ -211,24 +237,18 @@ namespace ngcomp {
   void QuasiPeriodicFESpace :: VTransformVC (ElementId ei, SliceVector<Complex> vec, TRANSFORM_TYPE tt) const 
   {
     PeriodicFESpace::VTransformVC(ei, vec, tt);
-    Array<int> dofnrs;
-    space->GetDofNrs(ei, dofnrs);
-    for (int i : Range(dofnrs.Size()))
+    for (auto fd : factor_dofs[ei.VB()][ei.Nr()])
       {
-	if (dofnrs[i] != dofmap[dofnrs[i]])
-	  {
-	    if (tt == TRANSFORM_RHS)
-	      vec[i] *= conj(dof_factors[dofnrs[i]]);
-	    else
-	      vec[i] *= dof_factors[dofnrs[i]];
-	  }
+        if (tt == TRANSFORM_RHS)
+          vec[fd[0]] *= conj(dof_factors[fd[1]]);
+        else
+          vec[fd[0]] *= dof_factors[fd[1]];
       }
-    
   }
 
   void QuasiPeriodicFESpace :: DofMapped(size_t from, size_t to, size_t idnr)
   {
-    dof_factors[from] *= (*factors)[idnr];
+    mapped_dofs.Append (INT<2> (from, idnr));
   }
 
 }
@@ -79,6 +79,10 @@ namespace ngcomp
   {
     shared_ptr<Array<Complex>> factors;
     Array<Complex> dof_factors;
+    /// (slave dof, identification number) of every mapping
+    Array<INT<2>> mapped_dofs;
+    /// (local number, dof) of the element dofs with a phase factor
+    Table<INT<2>> factor_dofs[4];
 
   public:
     QuasiPeriodicFESpace (shared_ptr<FESpace> fespace, const Flags & flag, shared_ptr<Array<int>> aused_idnrs, shared_ptr<Array<Complex>> afactors);
@@ -87,6 +91,9 @@ namespace ngcomp
 
     shared_ptr<Array<Complex>> GetFactors() const { return factors; }
 
+    /// new phase factors on the same dof map, no Update needed
+    void SetFactors (shared_ptr<Array<Complex>> afactors);
+
     virtual void VTransformMR (ElementId ei, SliceMatrix<double> mat, TRANSFORM_TYPE tt) const override;
     virtual void VTransformMC (ElementId ei, SliceMatrix<Complex> mat, TRANSFORM_TYPE tt) const override;
     virtual void VTransformVR (ElementId ei, SliceVector<double> vec, TRANSFORM_TYPE tt) const override;
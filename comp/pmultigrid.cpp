@@ -0,0 +1,227 @@
+#include <comp.hpp>
+using namespace ngcomp;
+
+
+
+namespace ngcomp
+{
+
+  /**
+     Two-level cycle in the polynomial degree. The high-order operator
+     is only applied, it is smoothed by a Chebyshev polynomial in
+     diag(A)^{-1} A. The p=1 problem is solved by a preconditioner
+     for the low-order form. The low-order dofs are the first dofs of
+     the high-order space (hierarchical basis), so restriction and
+     prolongation are the embedding of the first nlo dofs.
+  */
+  class PMultigridMatrix : public BaseMatrix
+  {
+    shared_ptr<BaseMatrix> op;
+    shared_ptr<ChebyshevPrecond> smoother;
+    shared_ptr<BaseMatrix> coarse;
+  public:
+    PMultigridMatrix (shared_ptr<BaseMatrix> aop,
+                      shared_ptr<ChebyshevPrecond> asmoother,
+                      shared_ptr<BaseMatrix> acoarse)
+      : op(aop), smoother(asmoother), coarse(acoarse)
+    {
+      if (coarse->VHeight() > op->VHeight())
+        throw Exception ("PMultigrid: low-order space larger than high-order space");
+    }
+
+    virtual bool IsComplex() const override { return false; }
+    virtual int VHeight() const override { return op->VHeight(); }
+    virtual int VWidth() const override { return op->VWidth(); }
+    virtual AutoVector CreateVector () const override { return op->CreateVector(); }
+
+    virtual void Mult (const BaseVector & f, BaseVector & u) const override
+    {
+      static Timer t("PMultigrid::Mult"); RegionTimer reg(t);
+
+      auto res = CreateVector();
+      auto cres = coarse->CreateVector();
+      auto cw = coarse->CreateVector();
+
+      // pre-smoothing, starting from u = 0
+      smoother->Mult (f, u);
+      res = f - (*op) * u;
+
+      cres = *res.Range (0, cres.Size());
+      cw = (*coarse) * cres;
+      u.Range (0, cw.Size()) += cw;
+
+      // same polynomial again, the cycle stays symmetric
+      smoother->Smooth (u, f);
+    }
+  };
+
+
+
+  /**
+     p-multigrid preconditioner for high-order spaces with a nested
+     low-order space. The high-order form may be 'nonassemble', then
+     the diagonal for the smoother is computed element by element and
+     only the p=1 form is assembled.
+  */
+  class PMultigridPreconditioner : public Preconditioner
+  {
+    shared_ptr<BilinearForm> bfa;
+    /// p=1 form, own copy if bfa has none (e.g. non-assembled forms)
+    shared_ptr<BilinearForm> lo_bfa;
+    bool own_lo_bfa;
+    shared_ptr<Preconditioner> coarse_pre;
+    shared_ptr<ChebyshevPrecond> smoother;
+    shared_ptr<PMultigridMatrix> pmg;
+
+    int degree;
+    int eigsteps;
+    double ratio;
+
+  public:
+    PMultigridPreconditioner (shared_ptr<BilinearForm> abfa, const Flags & aflags,
+                              const string aname = "pmultigrid")
+      : Preconditioner (abfa, aflags, aname), bfa(abfa)
+    {
+      auto fes = bfa->GetFESpace();
+      if (!fes->LowOrderFESpacePtr())
+        throw Exception ("PMultigrid: space has no low-order space");
+      if (fes->IsComplex() || fes->GetDimension() != 1)
+        throw Exception ("PMultigrid: only real scalar spaces are supported");
+      if (bfa->UsesEliminateInternal())
+        throw Exception ("PMultigrid: static condensation is not supported");
+
+      degree = int(flags.GetNumFlag ("chebyshevdegree", 3));
+      eigsteps = int(flags.GetNumFlag ("eigensteps", 10));
+      ratio = flags.GetNumFlag ("chebyshevratio", 30);
+
+      lo_bfa = bfa->GetLowOrderBilinearForm();
+      own_lo_bfa = (lo_bfa == nullptr);
+      if (own_lo_bfa)
+        {
+          Flags loflags;
+          if (bfa->IsSymmetric()) loflags.SetFlag ("symmetric");
+          lo_bfa = CreateBilinearForm (fes->LowOrderFESpacePtr(),
+                                       bfa->GetName()+string(" low-order"), loflags);
+        }
+
+      // the coarse preconditioner registers itself with the p=1 form
+      string coarsetype = flags.GetStringFlag ("coarsetype", "h1amg");
+      auto info = GetPreconditionerClasses().GetPreconditioner (coarsetype);
+      if (!info)
+        throw Exception ("PMultigrid: unknown coarsetype '" + coarsetype + "'");
+      Flags coarseflags;
+      if (flags.StringFlagDefined ("inverse"))
+        coarseflags.SetFlag ("inverse", flags.GetStringFlag ("inverse", ""));
+      coarse_pre = info->creatorbf (lo_bfa, coarseflags, aname+string(" coarse"));
+    }
+
+    PMultigridPreconditioner (const PDE & pde, const Flags & aflags, const string & aname)
+      : PMultigridPreconditioner (pde.GetBilinearForm (aflags.GetStringFlag ("bilinearform")),
+                                  aflags, aname)
+    { ; }
+
+    virtual void FinalizeLevel (const BaseMatrix * mat) override
+    {
+      Update();
+    }
+
+    virtual void Update () override
+    {
+      static Timer t("PMultigrid::Update"); RegionTimer reg(t);
+      LocalHeap lh(10000000, "pmultigrid", true);
+
+      if (own_lo_bfa)
+        {
+          // integrators may have been added after the preconditioner
+          for (auto i : Range(lo_bfa->NumIntegrators(), bfa->NumIntegrators()))
+            lo_bfa->AddIntegrator (bfa->GetIntegrator(i));
+          lo_bfa->ReAssemble (lh);
+        }
+      // a non-assembled form only provides its application
+      if (!bfa->GetMatrixPtr())
+        bfa->Assemble (lh);
+
+      Array<double> diag;
+      CalcDiagonal (diag, lh);
+
+      smoother = make_shared<ChebyshevPrecond> (*bfa->GetMatrixPtr(), diag,
+                                                bfa->GetFESpace()->GetFreeDofs(),
+                                                degree, eigsteps, ratio);
+      pmg = make_shared<PMultigridMatrix> (bfa->GetMatrixPtr(), smoother,
+                                           coarse_pre->GetMatrixPtr());
+      if (test) Test();
+    }
+
+    virtual const BaseMatrix & GetMatrix() const override
+    {
+      if (!pmg) ThrowPreconditionerNotReady();
+      return *pmg;
+    }
+
+    virtual const BaseMatrix & GetAMatrix() const override
+    {
+      return bfa->GetMatrix();
+    }
+
+    virtual const char * ClassName() const override
+    { return "p-Multigrid Preconditioner"; }
+
+  private:
+    /// diagonal of the high-order matrix, without assembling it
+    void CalcDiagonal (Array<double> & diag, LocalHeap & clh) const
+    {
+      static Timer t("PMultigrid::CalcDiagonal"); RegionTimer reg(t);
+      auto fes = bfa->GetFESpace();
+      diag.SetSize (fes->GetNDof());
+      diag = 0.0;
+
+      for (VorB vb : { VOL, BND, BBND })
+        {
+          Array<shared_ptr<BilinearFormIntegrator>> parts;
+          for (auto & bfi : bfa->Integrators())
+            if (bfi->VB() == vb && !bfi->SkeletonForm())
+              parts.Append (bfi);
+          if (!parts.Size()) continue;
+
+          // an element writes only diagonal entries
+          IterateElementsUncolored
+            (*fes, vb, clh, [&] (FESpace::Element el, LocalHeap & lh)
+             {
+               const FiniteElement & fel = el.GetFE();
+               const ElementTransformation & eltrans = el.GetTrafo();
+               FlatArray<int> dnums = el.GetDofs();
+
+               FlatMatrix<double> sum_elmat(dnums.Size(), lh);
+               bool done = false;
+               while (!done)
+                 {
+                   done = true;
+                   sum_elmat = 0;
+                   for (auto & bfi : parts)
+                     {
+                       if (!bfi->DefinedOn (el.GetIndex())) continue;
+                       if (!bfi->DefinedOnElement (el.Nr())) continue;
+                       try
+                         {
+                           auto & mapped_trafo = eltrans.AddDeformation(bfi->GetDeformation().get(), lh);
+                           bfi->CalcElementMatrixAdd (fel, mapped_trafo, sum_elmat, lh);
+                         }
+                       catch (ExceptionNOSIMD & e)
+                         {
+                           done = false;
+                         }
+                     }
+                 }
+               fes->TransformMat (el, sum_elmat, TRANSFORM_MAT_LEFT_RIGHT);
+
+               for (auto i : Range(dnums))
+                 if (IsRegularDof(dnums[i]))
+                   MyAtomicAdd (diag[dnums[i]], sum_elmat(i,i));
+             });
+        }
+    }
+  };
+
+
+  static RegisterPreconditioner<PMultigridPreconditioner> initpmg ("pmultigrid");
+}
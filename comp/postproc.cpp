@@ -188,16 +188,20 @@ namespace ngcomp
     flux.GetVector().Cumulate(); 	 
 #endif
 
-    FlatVector<SCAL> fluxi(dimflux, clh);
-    ArrayMem<int,1> dnumsflux(1);
-    for (int i = 0; i < cnti.Size(); i++)
-      if (cnti[i])
-	{
-	  dnumsflux[0] = i;
-	  flux.GetElementVector (dnumsflux, fluxi);
-	  fluxi /= double (cnti[i]);
-	  flux.SetElementVector (dnumsflux, fluxi);
-	}
+    ParallelForRange
+      (cnti.Size(), [&] (IntRange r)
+       {
+         Vector<SCAL> fluxi(dimflux);
+         ArrayMem<int,1> dnumsflux(1);
+         for (int i : r)
+           if (cnti[i])
+             {
+               dnumsflux[0] = i;
+               flux.GetElementVector (dnumsflux, fluxi);
+               fluxi /= double (cnti[i]);
+               flux.SetElementVector (dnumsflux, fluxi);
+             }
+       });
     
     ma->PopStatus ();
   }
@@ -378,6 +382,65 @@ namespace ngcomp
 
 
 
+  /**
+     On a non-curved element the mass matrix of the identity is the
+     reference mass matrix times the constant measure.  SetValues thus
+     inverts it once per element class of H1HighOrderFE, every thread
+     owns its table.
+  */
+  class RefMassInverses
+  {
+    typedef std::array<unsigned char,5*sizeof(size_t)> Key;
+
+    struct KeyHash
+    {
+      size_t operator() (const Key & key) const
+      {
+        size_t h = 0;
+        for (auto k : key)
+          h = h * 0x9e3779b97f4a7c15ull + k;
+        return h;
+      }
+    };
+
+    Array<std::unordered_map<Key, unique_ptr<Matrix<double>>, KeyHash>> tables;
+    
+  public:
+    RefMassInverses () : tables(TaskManager::GetMaxThreads()) { ; }
+
+    /// the inverse reference mass matrix of fel's class, or nullptr if fel has none.
+    /// calc_mass computes the mass matrix of the current element of the given measure
+    template <typename FUNC>
+    const Matrix<double> * Get (const FiniteElement & fel, double measure, FUNC calc_mass)
+    {
+      size_t tid = TaskManager::GetThreadId();
+      if (tid >= tables.Size()) return nullptr;
+
+      Key key;
+      bool has_key = false;
+      SwitchET (fel.ElementType(), [&] (auto et)
+                {
+                  if (auto h1fel = dynamic_cast<const H1HighOrderFE<et.ElementType()>*> (&fel))
+                    {
+                      key = h1fel->ClassKey();
+                      has_key = true;
+                    }
+                });
+      if (!has_key) return nullptr;
+
+      auto & table = tables[tid];
+      auto pos = table.find(key);
+      if (pos != table.end()) return pos->second.get();
+
+      auto inv = make_unique<Matrix<double>> (fel.GetNDof());
+      calc_mass (*inv);
+      CalcInverse (*inv);
+      *inv *= measure;
+      return (table[key] = move(inv)).get();
+    }
+  };
+
+
   template <class SCAL>
   void SetValues (shared_ptr<CoefficientFunction> coef,
 		  GridFunction & bu,
@@ -387,6 +450,7 @@ namespace ngcomp
 		  LocalHeap & clh)
   {
     static Timer sv("timer setvalues"); RegionTimer r(sv);
+    static Timer tref("timer setvalues - reference mass");
 
     S_GridFunction<SCAL> & u = dynamic_cast<S_GridFunction<SCAL> &> (bu);
 
@@ -401,7 +465,9 @@ namespace ngcomp
     shared_ptr<BilinearFormIntegrator> single_bli = bli;
     if (dynamic_pointer_cast<BlockBilinearFormIntegrator> (single_bli))
       single_bli = dynamic_pointer_cast<BlockBilinearFormIntegrator> (single_bli)->BlockPtr();
-    
+
+    // the symbolic mass matrix of the identity scales with the measure
+    bool reuse_mass = false;
     if (!bli)
       {
         cout << IM(5) << "make a symbolic integrator for interpolation" << endl;
@@ -416,36 +482,78 @@ namespace ngcomp
         bli = make_shared<SymbolicBilinearFormIntegrator> (InnerProduct(trial,test), vb, VOL);
         single_bli = bli;
         // throw Exception ("no integrator available");
+
+        Iterate<3> ([&] (auto D)
+                    {
+                      constexpr int DIMS = D.value+1;
+                      auto & eval = *single_evaluator;
+                      if (dynamic_cast<T_DifferentialOperator<DiffOpId<DIMS>>*> (&eval) ||
+                          dynamic_cast<T_DifferentialOperator<DiffOpIdBoundary<DIMS>>*> (&eval))
+                        reuse_mass = true;
+                    });
+        if (fes->NeedsTransformVec()) reuse_mass = false;
       }
 
     int dimflux = diffop ? diffop->Dim() : bli->DimFlux(); 
     if (coef -> Dimension() != dimflux)
       throw Exception(string("Error in SetValues: gridfunction-dim = ") + ToString(dimflux) +
                       ", but coefficient-dim = " + ToString(coef->Dimension()));
+
+    auto selected = [&] (ElementId ei)
+      {
+        if (reg)
+          return reg->Mask().Test(ma->GetElIndex(ei));
+        if (vb==BND)
+          return fes->IsDirichletBoundary(ma->GetElIndex(ei));
+        return true;
+      };
+
+    // Dirichlet and definedon sets have few elements per color,
+    // then the barriers of the colored loop dominate and we add atomically
+    size_t nsel = ParallelReduce (ma->GetNE(vb),
+                                  [&] (size_t i) { return size_t(selected(ElementId(vb,i))); },
+                                  [] (size_t a, size_t b) { return a+b; }, size_t(0));
+    bool uncolored = false;
+    if (task_manager && dim == 1)
+      {
+        const Table<int> & coloring = fes->ElementColoring(vb);
+        uncolored = nsel < 8 * task_manager->GetNumThreads() * coloring.Size();
+      }
+    
     Array<int> cnti(fes->GetNDof());
     cnti = 0;
 
     u.GetVector() = 0.0;
 
-    ProgressOutput progress (ma, "setvalues element", ma->GetNE(vb));
+    ProgressOutput progress (ma, "setvalues element", nsel);
     bool use_simd = true;
+    RefMassInverses refmass;
 
+    // add the element solution and count the elements per dof
+    auto add_element = [&] (FESpace::Element & ei, FlatVector<SCAL> elfluxi, FlatVector<SCAL> elflux)
+      {
+        if (uncolored)
+          {
+            u.GetVector().AddIndirect (ei.GetDofs(), elfluxi, true);
+            for (auto d : ei.GetDofs())
+              if (IsRegularDof(d)) AsAtomic(cnti[d])++;
+            return;
+          }
+        u.GetElementVector (ei.GetDofs(), elflux);
+        elfluxi += elflux;
+        u.SetElementVector (ei.GetDofs(), elfluxi);
+                  
+        for (auto d : ei.GetDofs())
+          if (IsRegularDof(d)) cnti[d]++;
+      };
     
-    IterateElements 
+    auto iterate = uncolored ? IterateElementsUncolored : IterateElements;
+    iterate
       (*fes, vb, clh, 
        [&] (FESpace::Element ei, LocalHeap & lh)
        {
+          if (!selected(ei)) return;
           progress.Update ();
-
-          if (reg)
-            {
-              if (!reg->Mask().Test(ei.GetIndex())) return;
-            }
-          else
-            {
-              if (vb==BND && !fes->IsDirichletBoundary(ei.GetIndex()))
-                return;
-            }
           
 	  const FiniteElement & fel = fes->GetFE (ei, lh);
 	  const ElementTransformation & eltrans = ma->GetTrafo (ei, lh); 
@@ -477,7 +585,26 @@ namespace ngcomp
                   else
                     throw ExceptionNOSIMD("need diffop");
 
-                  if (dim > 1) //  && typeid(*bli)==typeid(BlockBilinearFormIntegrator))
+                  const Matrix<double> * invref = nullptr;
+                  if (reuse_mass && !eltrans.IsCurvedElement())
+                    {
+                      double measure = mir[0].GetMeasure()[0];
+                      invref = refmass.Get (fel, measure, [&] (FlatMatrix<double> elmat)
+                                            {
+                                              RegionTimer reg(tref);
+                                              single_bli->CalcElementMatrix (fel, eltrans, elmat, lh);
+                                            });
+                      if (invref)
+                        {
+                          double scale = 1.0 / measure;
+                          for (int j = 0; j < dim; j++)
+                            elfluxi.Slice (j,dim) = scale * (*invref * elflux.Slice (j,dim));
+                        }
+                    }
+
+                  if (invref)
+                    ;
+                  else if (dim > 1) //  && typeid(*bli)==typeid(BlockBilinearFormIntegrator))
                     {
                       FlatMatrix<SCAL> elmat(fel.GetNDof(), lh);
                       single_bli->CalcElementMatrix (fel, eltrans, elmat, lh);                      
@@ -511,14 +638,8 @@ namespace ngcomp
                     }
                   
                   // fes.TransformVec (i, bound, elfluxi, TRANSFORM_SOL);
-                  
-                  u.GetElementVector (ei.GetDofs(), elflux);
-                  elfluxi += elflux;
-                  u.SetElementVector (ei.GetDofs(), elfluxi);
-                  
-                  for (auto d : ei.GetDofs())
-                    if (IsRegularDof(d)) cnti[d]++;
-                  
+
+                  add_element (ei, elfluxi, elflux);
                   return;
                 }
               catch (ExceptionNOSIMD e)
@@ -581,13 +702,7 @@ namespace ngcomp
 
 	  // fes.TransformVec (i, bound, elfluxi, TRANSFORM_SOL);
 
-          u.GetElementVector (ei.GetDofs(), elflux);
-          elfluxi += elflux;
-          u.SetElementVector (ei.GetDofs(), elfluxi);
-	  
-          for (auto d : ei.GetDofs())
-            if (d != -1) cnti[d]++;
-
+          add_element (ei, elfluxi, elflux);
        });
 
     progress.Done();
@@ -599,21 +714,12 @@ namespace ngcomp
     u.GetVector().Cumulate(); 	 
 #endif
 
-    ParallelForRange
-      (cnti.Size(), [&] (IntRange r)
-       {
-         VectorMem<10,SCAL> fluxi(dim);
-         ArrayMem<int,1> dnums(1);
-         // for (int i = 0; i < cnti.Size(); i++)
-         for (auto i : r)
-           if (cnti[i])
-             {
-               dnums[0] = i;
-               u.GetElementVector (dnums, fluxi);
-               fluxi /= double (cnti[i]);
-               u.SetElementVector (dnums, fluxi);
-             }
-       });
+    FlatVector<SCAL> fv = u.GetVector().FV<SCAL>();
+    ParallelFor (cnti.Size(), [&] (size_t i)
+                 {
+                   if (cnti[i] > 1)
+                     fv.Range(i*dim, (i+1)*dim) *= 1.0 / cnti[i];
+                 });
     
     ma->PopStatus ();
   }
@@ -675,65 +781,52 @@ namespace ngcomp
     // shared_ptr<BilinearFormIntegrator> fluxbli = fesflux.GetIntegrator(vb);
     shared_ptr<DifferentialOperator> flux_diffop = fesflux.GetEvaluator(vb);
 
-    Array<int> dnums;
-    Array<int> dnumsflux;
+    ProgressOutput progress (ma, "error estimator element", ne);
 
-    double sum = 0;
-    for (int i = 0; i < ne; i++)
-      {
-        ElementId ei(vb,i);
-
-	HeapReset hr(lh);
-	ma->SetThreadPercentage ( 100.0*i / ne );
-
-	int eldom = ma->GetElIndex(ei);
-        // bound ? ma->GetSElIndex(i) : ma->GetElIndex(i);
-	
-	if (!domains[eldom]) continue;
-
-	const FiniteElement & fel = fes.GetFE(ei, lh);
-	const FiniteElement & felflux = fesflux.GetFE(ei, lh);
+    // every element writes its own indicator, no coloring needed
+    IterateElementsUncolored
+      (fes, vb, lh,
+       [&] (FESpace::Element ei, LocalHeap & lh)
+       {
+         progress.Update ();
+         if (!domains[ei.GetIndex()]) return;
 
-	ElementTransformation & eltrans = ma->GetTrafo (ei, lh);
-	fes.GetDofNrs(ei,dnums);
-	fesflux.GetDofNrs(ei,dnumsflux);
+         const FiniteElement & fel = ei.GetFE();
+         const FiniteElement & felflux = fesflux.GetFE(ei, lh);
+         const ElementTransformation & eltrans = ei.GetTrafo();
 
-	FlatVector<SCAL> elu(dnums.Size() * dim, lh);
-	FlatVector<SCAL> elflux(dnumsflux.Size() * dimflux, lh);
-	FlatVector<SCAL> fluxi(dimfluxvec, lh);
-	FlatVector<SCAL> fluxi2(dimfluxvec, lh);
+         Array<int> dnumsflux(felflux.GetNDof(), lh);
+         fesflux.GetDofNrs (ei, dnumsflux);
 
+         FlatVector<SCAL> elu(ei.GetDofs().Size() * dim, lh);
+         FlatVector<SCAL> elflux(dnumsflux.Size() * dimflux, lh);
 
-	u.GetElementVector (dnums, elu);
-	fes.TransformVec (ei, elu, TRANSFORM_SOL);
-	flux.GetElementVector (dnumsflux, elflux);
-	fesflux.TransformVec (ei, elflux, TRANSFORM_SOL);
+         u.GetElementVector (ei.GetDofs(), elu);
+         fes.TransformVec (ei, elu, TRANSFORM_SOL);
+         flux.GetElementVector (dnumsflux, elflux);
+         fesflux.TransformVec (ei, elflux, TRANSFORM_SOL);
 
-	IntegrationRule ir(felflux.ElementType(), 2*felflux.Order());
+         IntegrationRule ir(felflux.ElementType(), 2*felflux.Order());
 
-	FlatMatrix<SCAL> mfluxi(ir.GetNIP(), dimfluxvec, lh);
-	FlatMatrix<SCAL> mfluxi2(ir.GetNIP(), dimfluxvec, lh);
+         FlatMatrix<SCAL> mfluxi(ir.GetNIP(), dimfluxvec, lh);
+         FlatMatrix<SCAL> mfluxi2(ir.GetNIP(), dimfluxvec, lh);
 	
-	BaseMappedIntegrationRule & mir = eltrans(ir, lh);
-	bli->CalcFlux (fel, mir, elu, mfluxi, 1, lh);
-        // fluxbli->CalcFlux (felflux, mir, elflux, mfluxi2, 0, lh);
-        // cout << "mfluxi2 - bli = " << mfluxi2 << endl;
-        // mfluxi2 = 0;
-        flux_diffop->Apply (felflux, mir, elflux, mfluxi2, lh);
-        // cout << "mfluxi2 - diffop = " << mfluxi2 << endl;
+         BaseMappedIntegrationRule & mir = eltrans(ir, lh);
+         bli->CalcFlux (fel, mir, elu, mfluxi, 1, lh);
+         flux_diffop->Apply (felflux, mir, elflux, mfluxi2, lh);
         
-	mfluxi -= mfluxi2;
+         mfluxi -= mfluxi2;
 	
-	bli->ApplyDMatInv (fel, mir, mfluxi, mfluxi2, lh);
+         bli->ApplyDMatInv (fel, mir, mfluxi, mfluxi2, lh);
 	
-	double elerr = 0;
-	for (int j = 0; j < ir.GetNIP(); j++)
-	  elerr += ir[j].Weight() * mir[j].GetMeasure() *
-	    fabs (InnerProduct (mfluxi.Row(j), mfluxi2.Row(j)));
+         double elerr = 0;
+         for (int j = 0; j < ir.GetNIP(); j++)
+           elerr += ir[j].Weight() * mir[j].GetMeasure() *
+             fabs (InnerProduct (mfluxi.Row(j), mfluxi2.Row(j)));
 
-	err(i) += elerr;
-	sum += elerr;
-      }
+         err(ei.Nr()) += elerr;
+       });
+    progress.Done();
     ma->PopStatus ();
   }
   
@@ -789,6 +882,7 @@ namespace ngcomp
 		       FlatVector<double> & diff,
 		       int domain, LocalHeap & lh)
   {
+    static Timer t("CalcDifference"); RegionTimer reg(t);
     shared_ptr<MeshAccess> ma = u1.GetMeshAccess();
     ma->PushStatus ("Calc Difference");
 
@@ -806,7 +900,6 @@ namespace ngcomp
 	return; 
       } 
 
-    int ne      = bound1 ? ma->GetNSE() : ma->GetNE();
     int dim1    = fes1.GetDimension();
     int dim2    = fes2.GetDimension();
     int dimflux1 = bli1->DimFlux();
@@ -822,65 +915,43 @@ namespace ngcomp
     bool applyd1 = 0;
     bool applyd2 = 0;
 
-    Array<int> dnums1;
-    Array<int> dnums2;
-
-    double sum = 0;
-    for (int i = 0; i < ne; i++)
-      {
-        ElementId ei(bound1 ? BND : VOL, i);
-	HeapReset hr (lh);
-	ma->SetThreadPercentage ( 100.0*i / ne );
-
-	int eldom = ma->GetElIndex(ei);
-        // bound1 ? ma->GetSElIndex(i) : ma->GetElIndex(i);
-	
-	if ((domain != -1) && (domain != eldom))
-	  continue;
-
-	const FiniteElement & fel1 = fes1.GetFE (ei, lh);
-	const FiniteElement & fel2 = fes2.GetFE (ei, lh);
-	ElementTransformation & eltrans = ma->GetTrafo (ei, lh);
+    // fluxes on the whole integration rule, elements in parallel
+    IterateElementsUncolored
+      (fes1, bound1 ? BND : VOL, lh,
+       [&] (FESpace::Element ei, LocalHeap & lh)
+       {
+         if ((domain != -1) && (domain != ei.GetIndex())) return;
 
-	fes1.GetDofNrs (ei, dnums1);
-	fes2.GetDofNrs (ei, dnums2);
+         const FiniteElement & fel1 = ei.GetFE();
+         const FiniteElement & fel2 = fes2.GetFE (ei, lh);
+         const ElementTransformation & eltrans = ei.GetTrafo();
 
-	FlatVector<SCAL> elu1(dnums1.Size() * dim1, lh);
-	FlatVector<SCAL> elu2(dnums2.Size() * dim2, lh);
-	FlatVector<SCAL> fluxi1(dimflux1, lh);
-	FlatVector<SCAL> fluxi2(dimflux2, lh);
+         Array<int> dnums2(fel2.GetNDof(), lh);
+         fes2.GetDofNrs (ei, dnums2);
 
+         FlatVector<SCAL> elu1(ei.GetDofs().Size() * dim1, lh);
+         FlatVector<SCAL> elu2(dnums2.Size() * dim2, lh);
 
-	u1.GetElementVector (dnums1, elu1);
-	fes1.TransformVec (ei, elu1, TRANSFORM_SOL);
-	u2.GetElementVector (dnums2, elu2);
-	fes2.TransformVec (ei, elu2, TRANSFORM_SOL);
+         u1.GetElementVector (ei.GetDofs(), elu1);
+         fes1.TransformVec (ei, elu1, TRANSFORM_SOL);
+         u2.GetElementVector (dnums2, elu2);
+         fes2.TransformVec (ei, elu2, TRANSFORM_SOL);
 
-	double elerr = 0;
+         int io = max2(fel1.Order(),fel2.Order()); 
+         IntegrationRule ir(fel1.ElementType(), 2*io+2);
+         BaseMappedIntegrationRule & mir = eltrans(ir, lh);
 
-	int io = max2(fel1.Order(),fel2.Order()); 
+         FlatMatrix<SCAL> mfluxi1(ir.GetNIP(), dimflux1, lh);
+         FlatMatrix<SCAL> mfluxi2(ir.GetNIP(), dimflux2, lh);
+         bli1->CalcFlux (fel1, mir, elu1, mfluxi1, applyd1, lh);
+         bli2->CalcFlux (fel2, mir, elu2, mfluxi2, applyd2, lh);
+         mfluxi1 -= mfluxi2;
 
-	IntegrationRule ir(fel1.ElementType(), 2*io+2);
-	BaseMappedIntegrationRule & mir = eltrans(ir, lh);
-	
-	for (int j = 0; j < ir.GetNIP(); j++)
-	  {
-	    HeapReset hr (lh);
-	    
-	    bli1->CalcFlux (fel1, mir[j], elu1, fluxi1, applyd1, lh);
-	    bli2->CalcFlux (fel2, mir[j], elu2, fluxi2, applyd2, lh);
-	    // double det = mir[j].GetMeasure();
-	    
-	    fluxi1 -= fluxi2;
-	     
-	    double dx = mir[j].GetWeight();
-	    elerr += dx * L2Norm2 (fluxi1);
-	  }
-
-	diff(i) += elerr;
-	sum += elerr;
-      }
-    // cout << "difference = " << sqrt(sum) << endl;
+         double elerr = 0;
+         for (int j = 0; j < ir.GetNIP(); j++)
+           elerr += mir[j].GetWeight() * L2Norm2 (mfluxi1.Row(j));
+         diff(ei.Nr()) += elerr;
+       });
     ma->PopStatus ();
   }
   
@@ -909,139 +980,53 @@ namespace ngcomp
 		       FlatVector<double> & diff,
 		       int domain, LocalHeap & lh)
   {
+    static Timer t("CalcDifference - coef"); RegionTimer reg(t);
     shared_ptr<MeshAccess> ma = u1.GetMeshAccess();
 
     ma->PushStatus ("Calc Difference");
 
     const FESpace & fes1 = *u1.GetFESpace();
 
-    bool bound1 = bli1->BoundaryForm();
-
+    if (bli1->BoundaryForm())
+      throw Exception ("CalcDifference on boundary not supported");
 
-    int ne      = bound1 ? ma->GetNSE() : ma->GetNE();
     int dim1    = fes1.GetDimension();
     int dimflux1 = bli1->DimFlux();
 
     bool applyd1 = 0;
 
-    Array<int> dnums1;
-
     double sum = 0;
-    for (int i = 0; i < ne; i++)
-      {
-        ElementId ei(bound1 ? BND : VOL, i);
-
-	ma->SetThreadPercentage ( 100.0*i / ne );
-        
-	lh.CleanUp();
-
-	int eldom = ma->GetElIndex(ei);
-	
-	if ((domain != -1) && (domain != eldom))
-	  continue;
-
-	const FiniteElement & fel1 = fes1.GetFE(ei, lh);
-
-	ElementTransformation & eltrans = ma->GetTrafo (ei, lh);
-	fes1.GetDofNrs (ei, dnums1);
-	/*
-	if (bound1)
-	  {
-	    ma->GetSurfaceElementTransformation (i, eltrans, lh);
-	    fes1.GetSDofNrs (i, dnums1);
-	  }
-	else
-	  {
-	    ma->GetElementTransformation (i, eltrans, lh);
-	    fes1.GetDofNrs (i, dnums1);
-	  }
-	*/
-
-	FlatVector<SCAL> elu1(dnums1.Size() * dim1, lh);
-	FlatVector<SCAL> fluxi1(dimflux1, lh);
-	FlatVector<SCAL> fluxi2(dimflux1, lh);
+    // flux and coefficient on the whole integration rule, elements in parallel
+    IterateElementsUncolored
+      (fes1, VOL, lh,
+       [&] (FESpace::Element ei, LocalHeap & lh)
+       {
+         if ((domain != -1) && (domain != ei.GetIndex())) return;
 
+         const FiniteElement & fel1 = ei.GetFE();
+         const ElementTransformation & eltrans = ei.GetTrafo();
 
-	u1.GetElementVector (dnums1, elu1);
-	fes1.TransformVec (ei, elu1, TRANSFORM_SOL);
+         FlatVector<SCAL> elu1(ei.GetDofs().Size() * dim1, lh);
+         u1.GetElementVector (ei.GetDofs(), elu1);
+         fes1.TransformVec (ei, elu1, TRANSFORM_SOL);
 
-	double elerr = 0;
+         IntegrationRule ir(fel1.ElementType(), 2*fel1.Order()+3);
+         BaseMappedIntegrationRule & mir = eltrans(ir, lh);
 
-	IntegrationRule ir(fel1.ElementType(), 2*fel1.Order()+3);
-	double det = 0;
-	
-	if (bound1) 
-	  throw Exception ("CalcDifference on boundary not supported");
+         FlatMatrix<SCAL> mfluxi(ir.GetNIP(), dimflux1, lh);
+         FlatMatrix<SCAL> mfluxi2(ir.GetNIP(), dimflux1, lh);
+         bli1->CalcFlux (fel1, mir, elu1, mfluxi, applyd1, lh);
+         coef->Evaluate (mir, mfluxi2);
+         mfluxi -= mfluxi2;
 
-	if (ma->GetDimension() == 2)
-	  {
-	    MappedIntegrationRule<2,2> mir(ir, eltrans, lh);
-	    FlatMatrix<SCAL> mfluxi(ir.GetNIP(), dimflux1, lh);
-	    FlatMatrix<SCAL> mfluxi2(ir.GetNIP(), dimflux1, lh);
-	    
-	    bli1->CalcFlux (fel1, mir, elu1, mfluxi, applyd1, lh);
-	    // coef->Evaluate(mir, mfluxi2);
-	    
-	    for (int j = 0; j < ir.GetNIP(); j++)
-	      {
-		coef->Evaluate(mir[j],fluxi2);
-		mfluxi2.Row(j) = fluxi2;
-	      }
-	    mfluxi -= mfluxi2;
-
-	    for (int j = 0; j < ir.GetNIP(); j++)
-	      {
-		double dx = fabs (mir[j].GetJacobiDet()) * ir[j].Weight();
-		elerr += dx * L2Norm2 (mfluxi.Row(j));
-	      }
-	    
-
-	    diff(i) += elerr;
-	    sum += elerr;
-	  }
+         double elerr = 0;
+         for (int j = 0; j < ir.GetNIP(); j++)
+           elerr += mir[j].GetWeight() * L2Norm2 (mfluxi.Row(j));
 
-	else
-	  {
-	    for (int j = 0; j < ir.GetNIP(); j++)
-	      {
-		HeapReset hr(lh);
-		if (!bound1)
-		  {
-		    if (ma->GetDimension() == 2)
-		      {
-			Vec<2> point; 
-			MappedIntegrationPoint<2,2> mip (ir[j], eltrans);
-			eltrans.CalcPoint(mip.IP(), point);
-			bli1->CalcFlux (fel1, mip, elu1, fluxi1, applyd1, lh);
-			coef->Evaluate(mip,fluxi2);
-			det = fabs(mip.GetJacobiDet()); 
-		      }
-		    else
-		      {
-			Vec<3> point;
-			MappedIntegrationPoint<3,3> mip (ir[j], eltrans);
-			eltrans.CalcPoint(mip.IP(), point);
-			bli1->CalcFlux (fel1, mip, elu1, fluxi1, applyd1, lh);
-			coef->Evaluate(mip,fluxi2);
-			det = fabs(mip.GetJacobiDet());  
-		      }
-		  }
-
-	    	  
-		(*testout) << "diff: fluxi = " << fluxi1 << " =?= " << fluxi2 << endl;
-	    
-		fluxi1 -= fluxi2;
-	     
-		double dx = ir[j].Weight() * det; 
-	    
-		elerr += dx * L2Norm2 (fluxi1);
-	      }
-
-	    diff(i) += elerr;
-	    sum += elerr;
-	  }
-      }
-    cout << "difference = " << sqrt(sum) << endl;
+         diff(ei.Nr()) += elerr;
+         AsAtomic(sum) += elerr;
+       });
+    cout << IM(3) << "difference = " << sqrt(sum) << endl;
     ma->PopStatus ();
   }
 
@@ -1060,6 +1045,87 @@ namespace ngcomp
   }
 
 
+  static INLINE SIMD<double> SqrAbs (SIMD<double> x) { return x*x; }
+  static INLINE SIMD<double> SqrAbs (SIMD<Complex> x)
+  { return x.real()*x.real()+x.imag()*x.imag(); }
+
+  template <typename SCAL>
+  static double ElementNorm2 (const CoefficientFunction & cf,
+                              const SIMD_BaseMappedIntegrationRule & mir, LocalHeap & lh)
+  {
+    FlatMatrix<SIMD<SCAL>> values(cf.Dimension(), mir.Size(), lh);
+    cf.Evaluate (mir, values);
+    SIMD<double> sum = 0.0;
+    for (size_t i = 0; i < values.Height(); i++)
+      for (size_t j = 0; j < values.Width(); j++)
+        sum += mir[j].GetWeight() * SqrAbs (values(i,j));
+    return HSum(sum);
+  }
+
+  template <typename SCAL>
+  static double ElementNorm2 (const CoefficientFunction & cf,
+                              const BaseMappedIntegrationRule & mir, LocalHeap & lh)
+  {
+    FlatMatrix<SCAL> values(mir.Size(), cf.Dimension(), lh);
+    cf.Evaluate (mir, values);
+    double sum = 0;
+    for (size_t j = 0; j < values.Height(); j++)
+      sum += mir[j].GetWeight() * L2Norm2 (values.Row(j));
+    return sum;
+  }
+
+  void CalcElementNorms (shared_ptr<MeshAccess> ma,
+                         FlatArray<shared_ptr<CoefficientFunction>> cfs,
+                         VorB vb, int order, const BitArray & domains,
+                         SliceMatrix<double> err, LocalHeap & lh)
+  {
+    static Timer t("CalcElementNorms"); RegionTimer reg(t);
+    if (err.Height() != ma->GetNE(vb) || err.Width() != cfs.Size())
+      throw Exception ("CalcElementNorms: err must be of size ne x ncfs");
+
+    atomic<bool> use_simd(true);
+    ma->IterateElements
+      (vb, lh, [&] (Ngs_Element el, LocalHeap & lh)
+       {
+         if (!domains.Test(el.GetIndex())) return;
+         auto & trafo = ma->GetTrafo (el, lh);
+         auto row = err.Row(el.Nr());
+
+         // all norms share the mapped integration rule
+         bool this_simd = use_simd;
+         if (this_simd)
+           {
+             try
+               {
+                 HeapReset hr(lh);
+                 SIMD_IntegrationRule ir(trafo.GetElementType(), order);
+                 auto & mir = trafo(ir, lh);
+                 FlatVector<> hrow(cfs.Size(), lh);
+                 for (size_t k = 0; k < cfs.Size(); k++)
+                   hrow(k) = cfs[k]->IsComplex()
+                     ? ElementNorm2<Complex> (*cfs[k], mir, lh)
+                     : ElementNorm2<double> (*cfs[k], mir, lh);
+                 row += hrow;
+               }
+             catch (ExceptionNOSIMD e)
+               {
+                 this_simd = false;
+                 use_simd = false;
+               }
+           }
+         if (!this_simd)
+           {
+             IntegrationRule ir(trafo.GetElementType(), order);
+             BaseMappedIntegrationRule & mir = trafo(ir, lh);
+             for (size_t k = 0; k < cfs.Size(); k++)
+               row(k) += cfs[k]->IsComplex()
+                 ? ElementNorm2<Complex> (*cfs[k], mir, lh)
+                 : ElementNorm2<double> (*cfs[k], mir, lh);
+           }
+       });
+  }
+
+
 
 
 
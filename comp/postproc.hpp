@@ -104,6 +104,12 @@ namespace ngcomp
                                       FlatVector<double> & diff,
                                       int domain, LocalHeap & lh);
 
+  // err(el,k) += \int_el |cfs[k]|^2, all cfs on the same (SIMD) rule
+  NGS_DLL_HEADER void CalcElementNorms (shared_ptr<MeshAccess> ma,
+                                        FlatArray<shared_ptr<CoefficientFunction>> cfs,
+                                        VorB vb, int order, const BitArray & domains,
+                                        SliceMatrix<double> err, LocalHeap & lh);
+
 
 
   template <class SCAL>
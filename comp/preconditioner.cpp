@@ -252,7 +252,11 @@ namespace ngcomp
 
     if (smoothertype == "point")
       {
-	sm = make_shared<GSSmoother> (*ma, *lo_bfa);
+	sm = make_shared<GSSmoother> (*ma, *lo_bfa, flags);
+      }
+    else if (smoothertype == "chebyshev")
+      {
+	sm = make_shared<ChebyshevSmoother> (*ma, *lo_bfa, flags);
       }
     else if (smoothertype == "line")
       {
@@ -285,6 +289,8 @@ namespace ngcomp
     mgp->SetIncreaseSmoothingSteps (int(flags.GetNumFlag ("increasesmoothingsteps", 1)));
     mgp->SetCoarseSmoothingSteps (int(flags.GetNumFlag ("coarsesmoothingsteps", 1)));
     mgp->SetUpdateAll( flags.GetDefineFlag( "updateall" ) );
+    mgp->SetFusedRestriction (flags.GetDefineFlag ("fusedrestriction"));
+    mgp->SetAdditive (flags.GetDefineFlag ("additive"));
 
     MultigridPreconditioner::COARSETYPE ct = MultigridPreconditioner::EXACT_COARSE;
     const string & coarse = flags.GetStringFlag ("coarsetype", "direct");
@@ -349,7 +355,11 @@ namespace ngcomp
 
     if (smoothertype == "point")
       {
-	sm = make_shared<GSSmoother> (*ma, *lo_bfa);
+	sm = make_shared<GSSmoother> (*ma, *lo_bfa, flags);
+      }
+    else if (smoothertype == "chebyshev")
+      {
+	sm = make_shared<ChebyshevSmoother> (*ma, *lo_bfa, flags);
       }
     else if (smoothertype == "line")
       {
@@ -384,6 +394,8 @@ namespace ngcomp
     mgp->SetIncreaseSmoothingSteps (int(flags.GetNumFlag ("increasesmoothingsteps", 1)));
     mgp->SetCoarseSmoothingSteps (int(flags.GetNumFlag ("coarsesmoothingsteps", 1)));
     mgp->SetUpdateAll( flags.GetDefineFlag( "updateall" ) );
+    mgp->SetFusedRestriction (flags.GetDefineFlag ("fusedrestriction"));
+    mgp->SetAdditive (flags.GetDefineFlag ("additive"));
 
     MultigridPreconditioner::COARSETYPE ct = MultigridPreconditioner::EXACT_COARSE;
     const string & coarse = flags.GetStringFlag ("coarsetype", "direct");
@@ -432,6 +444,7 @@ namespace ngcomp
                                            fine_smoother,
                                            bfa->GetMeshAccess()->GetNLevels()-1);
         tlp -> SetSmoothingSteps (finesmoothingsteps);
+        tlp -> SetAdditive (flags.GetDefineFlag ("additive"));
 	tlp -> Update();
       }
     else
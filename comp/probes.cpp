@@ -0,0 +1,325 @@
+/*********************************************************************/
+/* File:   probes.cpp                                                */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+#include <comp.hpp>
+
+#ifdef NGS_HDF5
+#include <hdf5.h>
+#endif
+
+namespace ngcomp
+{
+
+#ifdef NGS_HDF5
+
+  static_assert (sizeof(hid_t) == sizeof(int64_t), "ProbeSet stores the hid_t as int64_t");
+
+  /// dataset of rows of ncomp doubles, extended by AppendH5Row
+  static void CreateH5Series (hid_t file, const char * name, size_t ncomp)
+  {
+    hsize_t dims[2] = { 0, ncomp };
+    hsize_t maxdims[2] = { H5S_UNLIMITED, ncomp };
+    hsize_t chunk[2] = { 64, ncomp };
+    hid_t space = H5Screate_simple (2, dims, maxdims);
+    hid_t dcpl = H5Pcreate (H5P_DATASET_CREATE);
+    H5Pset_chunk (dcpl, 2, chunk);
+    hid_t dset = H5Dcreate2 (file, name, H5T_NATIVE_DOUBLE, space, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+    H5Pclose (dcpl);
+    H5Sclose (space);
+    if (dset < 0)
+      throw Exception (string("ProbeSet: cannot create dataset ") + name);
+    H5Dclose (dset);
+  }
+
+  static void AppendH5Row (hid_t file, const char * name, const double * data,
+                           size_t row, size_t ncomp)
+  {
+    hid_t dset = H5Dopen2 (file, name, H5P_DEFAULT);
+    hsize_t dims[2] = { row+1, ncomp };
+    H5Dset_extent (dset, dims);
+
+    hsize_t start[2] = { row, 0 };
+    hsize_t count[2] = { 1, ncomp };
+    hid_t filespace = H5Dget_space (dset);
+    H5Sselect_hyperslab (filespace, H5S_SELECT_SET, start, nullptr, count, nullptr);
+    hid_t memspace = H5Screate_simple (2, count, nullptr);
+    herr_t err = H5Dwrite (dset, H5T_NATIVE_DOUBLE, memspace, filespace, H5P_DEFAULT, data);
+
+    H5Sclose (memspace);
+    H5Sclose (filespace);
+    H5Dclose (dset);
+    if (err < 0)
+      throw Exception (string("ProbeSet: cannot write dataset ") + name);
+  }
+
+#endif
+
+
+  ProbeSet :: ProbeSet (shared_ptr<MeshAccess> ama, const Array<Vec<3>> & apoints,
+                        const Array<shared_ptr<CoefficientFunction>> & acoefs,
+                        const Array<string> & anames, string afilename, string aformat)
+    : ma(ama), coefs(acoefs), names(anames), points(apoints),
+      filename(afilename), format(aformat)
+  {
+    static Timer t("ProbeSet - locate points"); RegionTimer reg(t);
+
+    if (!points.Size())
+      throw Exception ("ProbeSet: no probe points");
+    if (!coefs.Size())
+      throw Exception ("ProbeSet: no coefficient functions");
+    for (auto & cf : coefs)
+      {
+        if (cf->IsComplex())
+          throw Exception ("ProbeSet: complex coefficient functions are not supported");
+        rowsize += cf->Dimension();
+      }
+    while (names.Size() < coefs.Size())
+      names.Append ("cf" + ToString(names.Size()));
+
+    size_t np = points.Size();
+    Array<int> elnr(np);
+    Array<IntegrationPoint> ips(np);
+    elnr = -1;
+    ma->FindElementsOfPoints (points, elnr, ips);
+
+    found.SetSize (np);
+    for (size_t i = 0; i < np; i++)
+      found[i] = (elnr[i] >= 0);
+#ifdef PARALLEL
+    MPI_Comm comm = ma->GetCommunicator();
+    if (MyMPI_GetNTasks (comm) > 1 && np)
+      MPI_Allreduce (MPI_IN_PLACE, &found[0], np, MPI_INT, MPI_SUM, comm);
+#endif
+
+    // probes sorted by element, one integration rule per element
+    Array<int> order;
+    for (size_t i = 0; i < np; i++)
+      if (elnr[i] >= 0)
+        order.Append (i);
+    QuickSortI (elnr, order);
+
+    Array<int> cnt;
+    for (size_t k = 0; k < order.Size(); k++)
+      {
+        if (k == 0 || elnr[order[k]] != elnr[order[k-1]])
+          {
+            elnrs.Append (elnr[order[k]]);
+            cnt.Append (0);
+          }
+        cnt.Last()++;
+      }
+
+    element_probes = Table<int> (cnt);
+    irs.SetSize (elnrs.Size());
+    simd_irs.SetSize (elnrs.Size());
+    for (size_t g = 0, k = 0; g < elnrs.Size(); g++)
+      {
+        auto ir = make_shared<IntegrationRule>();
+        for (auto & p : element_probes[g])
+          {
+            p = order[k++];
+            ir->Append (ips[p]);
+          }
+        ir->SetDim (ElementTopology::GetSpaceDim (ma->GetElType (ElementId(VOL, elnrs[g]))));
+        irs[g] = ir;
+        simd_irs[g] = make_shared<SIMD_IntegrationRule> (*ir);
+      }
+
+    values.SetSize (np, rowsize);
+    values = numeric_limits<double>::quiet_NaN();
+
+    if (filename.length() && MyMPI_GetId (ma->GetCommunicator()) == 0)
+      OpenSink();
+  }
+
+  ProbeSet :: ~ProbeSet ()
+  {
+#ifdef NGS_HDF5
+    if (h5file >= 0)
+      H5Fclose (h5file);
+#endif
+  }
+
+
+  void ProbeSet :: Evaluate (LocalHeap & lh)
+  {
+    static Timer t("ProbeSet::Evaluate"); RegionTimer reg(t);
+
+    values = 0.0;
+
+    // all cfs are evaluated on the SIMD rules, the first cf without
+    // SIMD evaluation switches to the scalar path
+    atomic<bool> use_simd(true);
+    ParallelForRange
+      (elnrs.Size(), [&] (IntRange r)
+       {
+         LocalHeap slh = lh.Split();
+         for (auto g : r)
+           {
+             HeapReset hr(slh);
+             ElementTransformation & trafo = ma->GetTrafo (ElementId(VOL, elnrs[g]), slh);
+             FlatArray<int> probes = element_probes[g];
+             size_t np = probes.Size();
+
+             bool done = false;
+             if (use_simd)
+               try
+                 {
+                   constexpr int SW = SIMD<double>::Size();
+                   auto & smir = trafo (*simd_irs[g], slh);
+                   size_t offset = 0;
+                   for (auto & cf : coefs)
+                     {
+                       int dim = cf->Dimension();
+                       FlatMatrix<SIMD<double>> svalues(dim, smir.Size(), slh);
+                       cf->Evaluate (smir, svalues);
+                       for (size_t j = 0; j < np; j++)
+                         for (int l = 0; l < dim; l++)
+                           values(probes[j], offset+l) = svalues(l, j/SW)[j%SW];
+                       offset += dim;
+                     }
+                   done = true;
+                 }
+               catch (ExceptionNOSIMD & e)
+                 {
+                   use_simd = false;
+                 }
+
+             if (!done)
+               {
+                 auto & mir = trafo (*irs[g], slh);
+                 size_t offset = 0;
+                 for (auto & cf : coefs)
+                   {
+                     int dim = cf->Dimension();
+                     FlatMatrix<> pvalues(np, dim, slh);
+                     cf->Evaluate (mir, pvalues);
+                     for (size_t j = 0; j < np; j++)
+                       for (int l = 0; l < dim; l++)
+                         values(probes[j], offset+l) = pvalues(j, l);
+                     offset += dim;
+                   }
+               }
+           }
+       });
+
+#ifdef PARALLEL
+    MPI_Comm comm = ma->GetCommunicator();
+    if (MyMPI_GetNTasks (comm) > 1 && values.Height())
+      {
+        int rank = MyMPI_GetId (comm);
+        MPI_Reduce (rank == 0 ? MPI_IN_PLACE : &values(0,0), &values(0,0),
+                    values.Height()*values.Width(), MPI_DOUBLE, MPI_SUM, 0, comm);
+      }
+#endif
+
+    // probes on interfaces are found by several ranks
+    for (auto i : Range(points))
+      if (found[i])
+        values.Row(i) *= 1.0 / found[i];
+      else
+        values.Row(i) = numeric_limits<double>::quiet_NaN();
+  }
+
+
+  void ProbeSet :: Do (double time, LocalHeap & lh)
+  {
+    Evaluate (lh);
+    if (filename.length() && MyMPI_GetId (ma->GetCommunicator()) == 0)
+      WriteRow (time);
+    nsteps++;
+  }
+
+
+  void ProbeSet :: OpenSink ()
+  {
+    if (format == "csv")
+      {
+        out.open (filename);
+        out.precision (16);
+        out << "time";
+        for (auto i : Range(points))
+          for (auto k : Range(coefs))
+            {
+              int dim = coefs[k]->Dimension();
+              for (int l = 0; l < dim; l++)
+                {
+                  out << "," << names[k] << "_" << i;
+                  if (dim > 1) out << "_" << l;
+                }
+            }
+        out << endl;
+      }
+    else if (format == "binary")
+      {
+        out.open (filename, ios::binary);
+        int64_t header[2] = { int64_t(points.Size()), int64_t(rowsize) };
+        out.write ((const char*) header, sizeof(header));
+        out.flush();
+      }
+    else if (format == "hdf5")
+      {
+#ifdef NGS_HDF5
+        hid_t file = H5Fcreate (filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+        if (file < 0)
+          throw Exception ("ProbeSet: cannot open " + filename);
+        h5file = file;
+
+        hsize_t dims[2] = { points.Size(), 3 };
+        hid_t space = H5Screate_simple (2, dims, nullptr);
+        hid_t dset = H5Dcreate2 (file, "points", H5T_NATIVE_DOUBLE, space,
+                                 H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+        if (points.Size())
+          H5Dwrite (dset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, &points[0](0));
+        H5Dclose (dset);
+        H5Sclose (space);
+
+        CreateH5Series (file, "time", 1);
+        CreateH5Series (file, "values", points.Size()*rowsize);
+#else
+        throw Exception ("ProbeSet: ngsolve was compiled without HDF5 (USE_HDF5)");
+#endif
+      }
+    else
+      throw Exception ("ProbeSet: unknown format '" + format + "', use csv, binary or hdf5");
+
+    if (format != "hdf5" && !out)
+      throw Exception ("ProbeSet: cannot open " + filename);
+  }
+
+
+  void ProbeSet :: WriteRow (double time)
+  {
+    static Timer t("ProbeSet::WriteRow"); RegionTimer reg(t);
+
+    size_t n = values.Height()*values.Width();
+    if (format == "csv")
+      {
+        out << time;
+        for (size_t i = 0; i < values.Height(); i++)
+          for (size_t j = 0; j < values.Width(); j++)
+            out << "," << values(i,j);
+        out << "\n" << flush;
+      }
+    else if (format == "binary")
+      {
+        out.write ((const char*) &time, sizeof(double));
+        if (n)
+          out.write ((const char*) &values(0,0), n*sizeof(double));
+        out.flush();
+      }
+#ifdef NGS_HDF5
+    else if (format == "hdf5")
+      {
+        AppendH5Row (h5file, "time", &time, nsteps, 1);
+        AppendH5Row (h5file, "values", n ? &values(0,0) : &time, nsteps, n);
+        H5Fflush (h5file, H5F_SCOPE_LOCAL);
+      }
+#endif
+    if (format != "hdf5" && !out)
+      throw Exception ("ProbeSet: cannot write " + filename);
+  }
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+/*********************************************************************/
+/* File:   probes.hpp                                                */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+namespace ngcomp
+{
+
+  /**
+     Point evaluation of coefficient functions in a fixed set of probe
+     points, e.g. virtual sensors of a time dependent simulation.
+
+     The points are located once. Probes in the same element share one
+     integration rule, every Do evaluates all probes element by element
+     with SIMD rules and appends one row (time and all values) to the
+     sink: a csv file, a binary file or an HDF5 file.
+
+     The binary file starts with the number of probes and of values per
+     row (two int64), followed by the rows of doubles. HDF5 files hold
+     the datasets points, time and values, extended by every Do.
+
+     Probes outside the mesh get NaN. Under MPI every rank evaluates the
+     probes in its part of the mesh, rank 0 writes the sink.
+  */
+  class NGS_DLL_HEADER ProbeSet
+  {
+    shared_ptr<MeshAccess> ma;
+    Array<shared_ptr<CoefficientFunction>> coefs;
+    Array<string> names;
+    Array<Vec<3>> points;
+
+    /// elements containing probes, and the probes in each of them
+    Array<int> elnrs;
+    Table<int> element_probes;
+    Array<shared_ptr<IntegrationRule>> irs;
+    Array<shared_ptr<SIMD_IntegrationRule>> simd_irs;
+    /// number of ranks which found the probe
+    Array<int> found;
+
+    /// nprobes x (sum of cf dimensions)
+    Matrix<> values;
+    size_t rowsize = 0;
+
+    string filename;
+    string format;
+    ofstream out;
+    int64_t h5file = -1;
+    size_t nsteps = 0;
+
+  public:
+    ProbeSet (shared_ptr<MeshAccess> ama, const Array<Vec<3>> & apoints,
+              const Array<shared_ptr<CoefficientFunction>> & acoefs,
+              const Array<string> & anames, string afilename = "", string aformat = "csv");
+    ~ProbeSet ();
+
+    size_t Size () const { return points.Size(); }
+    bool Found (size_t i) const { return found[i] > 0; }
+    /// values of the last evaluation, one row per probe
+    const Matrix<> & GetValues () const { return values; }
+
+    /// evaluates all probes
+    void Evaluate (LocalHeap & lh);
+    /// evaluates and appends a row to the sink
+    void Do (double time, LocalHeap & lh);
+
+  private:
+    void OpenSink ();
+    void WriteRow (double time);
+  };
+
+}
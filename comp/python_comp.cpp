@@ -20,10 +20,9 @@ typedef GridFunction GF;
 
 
 
-/*
+// one heap per python thread, heavy calls run without the GIL
 static size_t global_heapsize = 1000000;
-static LocalHeap glh(global_heapsize, "python-comp lh", true);
-*/
+static thread_local LocalHeap glh(global_heapsize, "python-comp lh", true);
 
 /*
 template <> class cl_NonElement<ElementId>
@@ -234,15 +233,190 @@ auto ExportFESpace (py::module & m, string pyname)
 
 void ExportNgcompMesh (py::module &m);
 
+
+// integrates all components of cf in one element loop, rows of the result
+// are the regions (region_wise) or only one row. Every thread sums into its
+// own row with compensated (Kahan) summation, ranks are combined by one
+// allreduce.
+template <typename SCAL>
+static Matrix<SCAL> IntegrateComponents (const CoefficientFunction & cf, MeshAccess & ma,
+                                         VorB vb, int order, const BitArray & mask,
+                                         bool region_wise, LocalHeap & clh)
+{
+  static Timer t("Integrate many CFs"); RegionTimer reg(t);
+  size_t dim = cf.Dimension();
+  size_t nrows = region_wise ? ma.GetNRegions(vb) : 1;
+  size_t nthreads = task_manager ? TaskManager::GetNumThreads() : 1;
+  size_t width = (nrows*dim+7) & size_t(-8);   // no false sharing
+
+  Matrix<SCAL> tsum(nthreads, width), tcomp(nthreads, width);
+  tsum = SCAL(0.0);
+  tcomp = SCAL(0.0);
+  auto kahan_add = [] (SCAL & sum, SCAL & comp, SCAL val)
+    {
+      SCAL y = val - comp;
+      SCAL hsum = sum + y;
+      comp = (hsum - sum) - y;
+      sum = hsum;
+    };
+
+  atomic<bool> use_simd(true);
+  ma.IterateElements
+    (vb, clh, [&] (Ngs_Element el, LocalHeap & lh)
+     {
+       if (!mask.Test(el.GetIndex())) return;
+       auto & trafo = ma.GetTrafo (el, lh);
+       FlatVector<SCAL> hsum(dim, lh);
+       hsum = SCAL(0.0);
+
+       bool this_simd = use_simd;
+       if (this_simd)
+         {
+           try
+             {
+               SIMD_IntegrationRule ir(trafo.GetElementType(), order);
+               auto & mir = trafo(ir, lh);
+               FlatMatrix<SIMD<SCAL>> values(dim, ir.Size(), lh);
+               cf.Evaluate (mir, values);
+               for (size_t j = 0; j < dim; j++)
+                 {
+                   SIMD<SCAL> vsum = SCAL(0.0);
+                   for (size_t i = 0; i < values.Width(); i++)
+                     vsum += mir[i].GetWeight() * values(j,i);
+                   hsum(j) = HSum(vsum);
+                 }
+             }
+           catch (ExceptionNOSIMD e)
+             {
+               this_simd = false;
+               use_simd = false;
+               hsum = SCAL(0.0);
+             }
+         }
+       if (!this_simd)
+         {
+           IntegrationRule ir(trafo.GetElementType(), order);
+           BaseMappedIntegrationRule & mir = trafo(ir, lh);
+           FlatMatrix<SCAL> values(ir.Size(), dim, lh);
+           cf.Evaluate (mir, values);
+           for (size_t i = 0; i < values.Height(); i++)
+             hsum += mir[i].GetWeight() * values.Row(i);
+         }
+
+       size_t tid = TaskManager::GetThreadId();
+       size_t first = (region_wise ? el.GetIndex() : 0) * dim;
+       for (size_t j = 0; j < dim; j++)
+         kahan_add (tsum(tid, first+j), tcomp(tid, first+j), hsum(j));
+     });
+
+  Matrix<SCAL> result(nrows, dim);
+  for (size_t k = 0; k < nrows*dim; k++)
+    {
+      SCAL sum = 0.0, comp = 0.0;
+      for (size_t i = 0; i < nthreads; i++)
+        kahan_add (sum, comp, tsum(i,k));
+      result(k/dim, k%dim) = sum;
+    }
+
+#ifdef PARALLEL
+  MPI_Allreduce(MPI_IN_PLACE, &result(0,0), nrows*dim, MPI_Traits<SCAL>::MPIType(), MPI_SUM, ngs_comm);
+#endif
+  return result;
+}
+
+
+static INLINE double GetLane (SIMD<double> v, size_t l) { return v[l]; }
+static INLINE Complex GetLane (SIMD<Complex> v, size_t l)
+{ return Complex(v.real()[l], v.imag()[l]); }
+
+// evaluates cf at located points, rows of values are the points. The
+// points are grouped by element and evaluated in SIMD blocks per element,
+// values of points not found (elnr = -1) are left unchanged
+template <typename SCAL>
+static void EvaluateAtPoints (const CoefficientFunction & cf, const MeshAccess & ma,
+                              FlatArray<int> elnrs, FlatArray<IntegrationPoint> ips,
+                              SliceMatrix<SCAL> values)
+{
+  static Timer t("Evaluate CF at points"); RegionTimer reg(t);
+  size_t ne = ma.GetNE(VOL);
+  size_t dim = cf.Dimension();
+
+  Array<size_t> first(ne+1);
+  first = 0;
+  for (int el : elnrs)
+    if (el >= 0) first[el+1]++;
+  Array<int> active;
+  for (size_t el = 0; el < ne; el++)
+    {
+      if (first[el+1]) active.Append(el);
+      first[el+1] += first[el];
+    }
+  Array<int> sorted(first[ne]);
+  Array<size_t> pos(ne);
+  pos = first.Range(0, ne);
+  for (size_t i = 0; i < elnrs.Size(); i++)
+    if (elnrs[i] >= 0)
+      sorted[pos[elnrs[i]]++] = i;
+
+  constexpr size_t blocksize = 128;
+  atomic<bool> use_simd(true);
+  ParallelForRange (active.Size(), [&] (IntRange r)
+    {
+      LocalHeap lh(1000000, "EvaluateAtPoints");
+      for (size_t k : r)
+        {
+          HeapReset hre(lh);
+          int el = active[k];
+          auto & trafo = ma.GetTrafo (ElementId(VOL, el), lh);
+          FlatArray<int> elpts = sorted.Range(first[el], first[el+1]);
+          for (size_t b = 0; b < elpts.Size(); b += blocksize)
+            {
+              HeapReset hr(lh);
+              auto pts = elpts.Range(b, min2(b+blocksize, elpts.Size()));
+              IntegrationRule ir(pts.Size(), lh);
+              for (size_t j = 0; j < pts.Size(); j++)
+                ir[j] = ips[pts[j]];
+
+              bool this_simd = use_simd;
+              if (this_simd)
+                {
+                  try
+                    {
+                      SIMD_IntegrationRule simd_ir(ir, lh);
+                      auto & mir = trafo(simd_ir, lh);
+                      FlatMatrix<SIMD<SCAL>> vals(dim, simd_ir.Size(), lh);
+                      cf.Evaluate (mir, vals);
+                      constexpr size_t SW = SIMD<double>::Size();
+                      for (size_t j = 0; j < pts.Size(); j++)
+                        for (size_t c = 0; c < dim; c++)
+                          values(pts[j], c) = GetLane (vals(c, j/SW), j%SW);
+                    }
+                  catch (ExceptionNOSIMD e)
+                    {
+                      this_simd = false;
+                      use_simd = false;
+                    }
+                }
+              if (!this_simd)
+                {
+                  auto & mir = trafo(ir, lh);
+                  FlatMatrix<SCAL> vals(pts.Size(), dim, lh);
+                  cf.Evaluate (mir, vals);
+                  for (size_t j = 0; j < pts.Size(); j++)
+                    values.Row(pts[j]) = vals.Row(j);
+                }
+            }
+        }
+    });
+}
+
+
 void NGS_DLL_HEADER ExportNgcomp(py::module &m)
 {
 
   ExportNgcompMesh(m);
   //////////////////////////////////////////////////////////////////////////////////////////
 
-  static size_t global_heapsize = 1000000;
-  static LocalHeap glh(global_heapsize, "python-comp lh", true);
-
   
 
   //////////////////////////////////////////////////////////////////////////////////////////
@@ -798,7 +972,7 @@ kwargs : kwargs
          { 
            self->Update(glh);
            self->FinalizeUpdate(glh);
-         },
+         }, py::call_guard<py::gil_scoped_release>(),
          "update space after mesh-refinement")
      .def("UpdateDofTables", [](shared_ptr<FESpace> self)
          {
@@ -845,6 +1019,14 @@ kwargs : kwargs
     .def_property_readonly ("ndofglobal",
                             [](shared_ptr<FESpace> self) { return self->GetNDofGlobal(); },
                             "global number of dofs on MPI-distributed mesh")
+    .def("ElementWeights", [] (shared_ptr<FESpace> self)
+         {
+           Array<int> weights;
+           self->GetElementWeights (weights);
+           return weights;
+         }, "number of dofs of every volume element, as weights for partitioning")
+    .def("LoadImbalance", [] (shared_ptr<FESpace> self) { return self->GetLoadImbalance(); },
+         "maximal over average sum of element dofs of the MPI-partitions")
     .def("__str__", [] (shared_ptr<FESpace> self) { return ToString(*self); } )
     .def("__timing__", [] (shared_ptr<FESpace> self) { return py::cast(self->Timing()); })
     .def_property_readonly("lospace", [](shared_ptr<FESpace> self) -> shared_ptr<FESpace>
@@ -1183,7 +1365,15 @@ rho : ngsolve.fem.CoefficientFunction
 
   ExportFESpace<NumberFESpace> (m, "NumberSpace");
 
-  ExportFESpace<L2HighOrderFESpace> (m, "L2");
+  ExportFESpace<L2HighOrderFESpace> (m, "L2")
+    .def("MassInverse",
+         [] (shared_ptr<L2HighOrderFESpace> self, spCF rho) -> shared_ptr<BaseMatrix>
+         {
+           return make_shared<L2MassInverse> (self, rho, glh);
+         },
+         py::arg("rho")=nullptr,
+         "Returns the inverse of the L2 mass matrix weighted with rho as an operator")
+    ;
 
   ExportFESpace<HDivDivFESpace> (m, "HDivDiv");
   
@@ -1268,6 +1458,18 @@ used_idnrs : list of int = None
                     return perfes;
                   }), py::arg("fespace"), py::arg("phase")=DummyArgument(),
                   py::arg("use_idnrs")=py::list())
+    .def("SetPhase", [](PeriodicFESpace & self, py::list phase)
+         {
+           auto quasiper_fes = dynamic_cast<QuasiPeriodicFESpace*>(&self);
+           if (!quasiper_fes)
+             throw Exception("SetPhase needs a quasi-periodic space (created with phase)");
+           auto a_phase = make_shared<Array<Complex>>(py::len(phase));
+           for (auto i : Range(a_phase->Size()))
+             (*a_phase)[i] = py::extract<Complex>(phase[i])();
+           quasiper_fes->SetFactors(a_phase);
+         }, py::arg("phase"),
+         "Set new phase factors, keeps the dof map, the matrix graph and the coloring.\n"
+         "Matrices have to be assembled again.")
     .def(py::pickle([](const PeriodicFESpace* per_fes)
                     {
                       py::list idnrs;
@@ -1341,6 +1543,9 @@ active_dofs : BitArray or None
            self.SetActiveDofs(active_dofs);
          },
          py::arg("dofs"))
+    .def("Embedding", &CompressedFESpace::GetEmbedding,
+         "Operator mapping vectors of the compressed space into vectors of the base space,\n"
+         "its transpose restricts base vectors to the active dofs")
     .def(py::pickle([](const CompressedFESpace* compr_fes)
                     {
                       return py::make_tuple(compr_fes->GetBaseSpace(),compr_fes->GetActiveDofs());
@@ -1357,6 +1562,39 @@ active_dofs : BitArray or None
     ;
 
 
+  py::class_<ReorderedFESpace, shared_ptr<ReorderedFESpace>, CompressedFESpace>(m, "Reorder",
+	docu_string(R"delimiter(Wrapper Finite Element Space with renumbered dofs.
+The visible dofs of the fespace are numbered by reverse Cuthill-McKee,
+which reduces the bandwidth of the matrix graph and improves the cache
+locality of matrix-vector products and smoothers.
+
+Parameters:
+
+fespace : ngsolve.comp.FESpace
+    finite element space
+)delimiter"))
+    .def(py::init([] (shared_ptr<FESpace> & fes)
+                  {
+                    if (dynamic_pointer_cast<CompoundFESpace> (fes))
+                      throw py::type_error("cannot reorder a CompoundFESpace");
+                    auto ret = make_shared<ReorderedFESpace> (fes);
+                    ret->Update(glh);
+                    ret->FinalizeUpdate(glh);
+                    return ret;
+                  }), py::arg("fespace"))
+    .def(py::pickle([](const ReorderedFESpace* fes)
+                    {
+                      return py::make_tuple(fes->GetBaseSpace());
+                    },
+                    [] (py::tuple state) -> shared_ptr<ReorderedFESpace>
+                    {
+                      auto fes = make_shared<ReorderedFESpace>(state[0].cast<shared_ptr<FESpace>>());
+                      fes->Update(glh);
+                      fes->FinalizeUpdate(glh);
+                      return fes;
+                    }))
+    ;
+
    m.def("CompressCompound", [](shared_ptr<FESpace> & fes, py::object active_dofs) -> shared_ptr<FESpace>
             {
               shared_ptr<CompoundFESpace> compspace = dynamic_pointer_cast<CompoundFESpace> (fes);
@@ -1424,6 +1662,49 @@ active_dofs : BitArray or None
     ;
     
 
+  /////////////////////////////// QuadraturePointCoefficientFunction /////////
+
+  py::class_<QuadraturePointCoefficientFunction, shared_ptr<QuadraturePointCoefficientFunction>, CoefficientFunction>
+    (m, "QuadraturePointCF", docu_string(R"raw_string(
+Values stored in the integration points of the elements, e.g. history
+variables. Elements which have not been set evaluate to zero. The values
+must be evaluated with the integration rules used by Set.
+
+Parameters:
+
+mesh : ngsolve.Mesh
+  the mesh
+
+dim : int
+  dimension of the values
+
+vb : ngsolve.VorB
+  elements holding the values
+)raw_string"))
+    .def(py::init([] (shared_ptr<MeshAccess> ma, int dim, VorB vb)
+                  {
+                    return make_shared<QuadraturePointCoefficientFunction> (dim, ma->GetNE(vb), vb);
+                  }), py::arg("mesh"), py::arg("dim")=1, py::arg("vb")=VOL)
+    .def("Set", [] (shared_ptr<QuadraturePointCoefficientFunction> self, spCF cf,
+                    shared_ptr<MeshAccess> ma, int order)
+         {
+           if (cf->IsComplex() || cf->Dimension() != self->Dimension())
+             throw Exception ("QuadraturePointCF.Set: need real cf of dimension " + ToString(self->Dimension()));
+           ma->IterateElements
+             (self->VB(), glh, [&] (Ngs_Element el, LocalHeap & lh)
+              {
+                auto & trafo = ma->GetTrafo (el, lh);
+                SIMD_IntegrationRule ir(trafo.GetElementType(), order);
+                self->Set (trafo(ir, lh), *cf, lh);
+              });
+         }, py::arg("cf"), py::arg("mesh"), py::arg("order"), py::call_guard<py::gil_scoped_release>(),
+         docu_string(R"raw_string(
+Evaluates cf in the points of the integration rule of given order on every
+element and stores the values in place. cf may depend on this CF itself.
+)raw_string"))
+    ;
+
+
   ////////////////////////////////////// GridFunction //////////////////////////
   
   auto gf_class = py::class_<GF,shared_ptr<GF>, CoefficientFunction, NGS_Object>
@@ -1471,10 +1752,22 @@ active_dofs : BitArray or None
     .def_property_readonly("space", [](GF & self) { return self.GetFESpace(); },
                            "the finite element space")
     .def("Update", [](GF& self) { self.Update(); },
+         py::call_guard<py::gil_scoped_release>(),
          "update vector size to finite element space dimension after mesh refinement")
     
-    .def("Save", [](GF& self, string filename, bool parallel)
+    .def("Save", [](GF& self, string filename, bool parallel, bool collective, bool background)
          {
+           if (background && !collective)
+             {
+               self.SaveBackground(filename, parallel);
+               return;
+             }
+           self.WaitSave();
+           if (collective)
+             {
+               self.SaveCollective(filename);
+               return;
+             }
            ofstream out(filename, ios::binary);
            if (parallel)
              self.Save(out);
@@ -1482,7 +1775,9 @@ active_dofs : BitArray or None
              for (auto d : self.GetVector().FVDouble())
                SaveBin(out, d);
          },
-         py::arg("filename"), py::arg("parallel")=false, docu_string(R"raw_string(
+         py::arg("filename"), py::arg("parallel")=false, py::arg("collective")=false,
+         py::arg("background")=false, py::call_guard<py::gil_scoped_release>(),
+         docu_string(R"raw_string(
 Saves the gridfunction into a file.
 
 Parameters:
@@ -1493,9 +1788,26 @@ filename : string
 parallel : bool
   input parallel
 
+collective : bool
+  all ranks write the file with MPI-IO, the format of parallel=True.
+  The file can be loaded on a different number of ranks.
+
+background : bool
+  copy the vector and write the file on a background thread, the call
+  returns immediately. Use WaitSave before reading the file.
+
 )raw_string"))
-    .def("Load", [](GF& self, string filename, bool parallel)
+    .def("WaitSave", [](GF & self) { self.WaitSave(); },
+         py::call_guard<py::gil_scoped_release>(),
+         "waits until the file of Save(..., background=True) is written")
+    .def("Load", [](GF& self, string filename, bool parallel, bool collective)
          {
+           self.WaitSave();
+           if (collective)
+             {
+               self.LoadCollective(filename);
+               return;
+             }
            ifstream in(filename, ios::binary);
            if (parallel)
              self.Load(in);
@@ -1503,7 +1815,9 @@ parallel : bool
              for (auto & d : self.GetVector().FVDouble())
                LoadBin(in, d);
          },
-         py::arg("filename"), py::arg("parallel")=false, docu_string(R"raw_string(       
+         py::arg("filename"), py::arg("parallel")=false, py::arg("collective")=false,
+         py::arg("background")=false, py::call_guard<py::gil_scoped_release>(),
+         docu_string(R"raw_string(       
 Loads a gridfunction from a file.
 
 Parameters:
@@ -1514,6 +1828,9 @@ filename : string
 parallel : bool
   input parallel
 
+collective : bool
+  all ranks read the file with MPI-IO, see Save
+
 )raw_string"))
     .def("Set", 
          [](shared_ptr<GF> self, spCF cf,
@@ -1580,6 +1897,44 @@ definedon : object
                    },
                   "list of coefficient vectors for multi-dim gridfunction")
 
+    .def("ShareVector",
+         [](shared_ptr<GF> self, string name, bool create, int comp)
+         {
+           if (comp < 0 || comp >= self->GetMultiDim())
+             throw Exception ("ShareVector: component "+ToString(comp)+" out of range");
+           auto & old = self->GetVector(comp);
+           shared_ptr<BaseVector> v;
+           if (create)
+             {
+               int es = old.EntrySize() / (old.IsComplex() ? 2 : 1);
+               v = CreateSharedVector (name, old.Size(), old.IsComplex(), es);
+               *v = old;
+             }
+           else
+             v = AttachSharedVector (name);
+           self->SetVector (v, comp);
+           return v;
+         }, py::arg("name"), py::arg("create")=true, py::arg("comp")=0,
+         docu_string(R"raw_string(
+Moves the coefficient vector into the POSIX shared memory segment 'name',
+such that processes on the node work on the same values.
+
+Parameters:
+
+name : string
+  name of the segment
+
+create : bool
+  True: create the segment and copy the current values into it, the
+  segment is removed together with the vector.
+  False: attach to the segment created by another process, with a
+  GridFunction on the same space.
+
+comp : int
+  component of a multidim GridFunction
+
+)raw_string"))
+
     .def("Deriv",
          [](shared_ptr<GF> self) -> spCF
           {
@@ -1847,6 +2202,36 @@ space : ngsolve.FESpace
                      "  preconditioner with a changing bilinearform.",
 		     py::arg("nonsym_storage") = "bool = False\n"
 		     " The full matrix is stored, even if the symmetric flag is set.",
+                     py::arg("store_elmats") = "bool = False\n"
+                     "  Keep the volume element matrices, needed for ReassembleRegion.",
+                     py::arg("atomic_assembly") = "bool = False\n"
+                     "  Assemble without element coloring, adding element matrices\n"
+                     "  atomically. Chosen automatically if the coloring has only\n"
+                     "  few elements per color.",
+                     py::arg("linearization_plan") = "bool = False\n"
+                     "  Keep the element dofs and the matrix positions of the element\n"
+                     "  matrices between calls of AssembleLinearization, as needed\n"
+                     "  in Newton's method. Implies scattermap.",
+                     py::arg("pipeline_batch") = "int = 0\n"
+                     "  Number of element matrices every thread computes before\n"
+                     "  scattering them into the global matrix, ordered by rows.\n"
+                     "  Separates the compute and the memory bound phase of assembly.",
+                     py::arg("batch_condense") = "bool = False\n"
+                     "  Static condensation of symmetric forms by LDL^t factorization,\n"
+                     "  batched over elements with equal local dofs in SIMD lanes.\n"
+                     "  Meant for HDG methods with many small element matrices.",
+                     py::arg("scattermap") = "bool = False\n"
+                     "  Precompute the matrix positions of all volume element matrices.\n"
+                     "  Speeds up repeated assembly at the cost of one int per\n"
+                     "  element matrix entry.",
+                     py::arg("compress_condensed") = "bool = False\n"
+                     "  Rebuild the matrices of static condensation after assembly:\n"
+                     "  colored, and equal sized element matrices in SIMD lanes.",
+                     py::arg("compress_condensed_share") = "bool = False\n"
+                     "  As compress_condensed, equal element matrices (e.g. of\n"
+                     "  translated elements) are stored only once.",
+                     py::arg("compress_condensed_single") = "bool = False\n"
+                     "  As compress_condensed, the SIMD groups in float storage.",
                      py::arg("check_unused") = "bool = True\n"
 		     " If set prints warnings if not UNUSED_DOFS are not used."
                      );
@@ -1884,6 +2269,24 @@ Parameters:
 reallocate : bool
   input reallocate
 
+)raw_string"))
+
+    .def("ReassembleRegion", [](BF & self, Region region)
+         {
+           if (!region.IsVolume())
+             throw Exception ("ReassembleRegion needs a volume region");
+           self.ReassembleRegion(region.Mask(), glh);
+         }, py::call_guard<py::gil_scoped_release>(),
+         py::arg("region"), docu_string(R"raw_string(
+Recompute the element matrices in a volume region and replace their
+contributions in the assembled matrix. Other elements are not touched.
+Requires the flag store_elmats.
+
+Parameters:
+
+region : ngsolve.comp.Region
+  input volume region
+
 )raw_string"))
 
     .def_property_readonly("mat", [](BF & self)
@@ -2054,7 +2457,11 @@ flags : dict
                      "  This file must be set by ngsolve.SetTestoutFile. Use\n"
                      "  ngsolve.SetNumThreads(1) for serial output.",
                      py::arg("printelvec") = "bool\n"
-                     "  print element vectors to testout file"
+                     "  print element vectors to testout file",
+                     py::arg("atomic_assembly") = "bool = False\n"
+                     "  Assemble without element coloring, adding element vectors\n"
+                     "  atomically. Chosen automatically for scalar spaces if the\n"
+                     "  coloring has only few elements per color."
                      );
                 })
     .def("__str__",  [](LF & self ) { return ToString<LinearForm>(self); } )
@@ -2159,11 +2566,30 @@ integrator : ngsolve.fem.LFI
                   auto mg_flags = py::cast<py::dict>(prec_class.attr("__flags_doc__")());
                   mg_flags["updateall"] = "bool = False\n"
                     "  Update all smoothing levels when calling Update";
+                  mg_flags["fusedrestriction"] = "bool = False\n"
+                    "  Compute the coarse residual P^T (f - A u) in one pass over the\n"
+                    "  fine matrix, needs a scalar matrix with non-symmetric storage";
+                  mg_flags["additive"] = "bool = False\n"
+                    "  Additive cycle: the coarse levels run concurrently with the\n"
+                    "  smoothing, u = S f + P C R f on every level";
                   mg_flags["smoother"] = "string = 'point'\n"
                     "  Smoother between multigrid levels, available options are:\n"
                     "    'point': Gauss-Seidel-Smoother\n"
                     "    'line':  Anisotropic smoother\n"
-                    "    'block': Block smoother";
+                    "    'block': Block smoother\n"
+                    "    'chebyshev': Chebyshev polynomial smoother, parallel, needs an spd matrix";
+                  mg_flags["chebyshevdegree"] = "int = 3\n"
+                    "  Degree of the Chebyshev smoother, one matrix-vector product per degree";
+                  mg_flags["eigensteps"] = "int = 10\n"
+                    "  Lanczos steps estimating the largest eigenvalue for the Chebyshev smoother";
+                  mg_flags["chebyshevratio"] = "float = 30\n"
+                    "  The Chebyshev smoother damps [lmax/chebyshevratio, lmax]";
+                  mg_flags["gsorder"] = "string = 'multicolor'\n"
+                    "  Order of the point Gauss-Seidel sweeps, 'sequential' without threads.\n"
+                    "  Available options are:\n"
+                    "    'sequential': one row after the other\n"
+                    "    'multicolor': rows of one color of the matrix graph in parallel\n"
+                    "    'hybrid':     Jacobi between thread blocks, Gauss-Seidel within a block";
                   return mg_flags;
                 })
     ;
@@ -2387,6 +2813,90 @@ integrator : ngsolve.fem.LFI
     .def_property_readonly ("numprocs", [](shared_ptr<PDE> self) { return py::cast(self->GetNumProcTable()); })
     ;
   
+  m.def("Integrate",
+        [](py::list pycfs, shared_ptr<MeshAccess> ma,
+           VorB vb, int order, py::object definedon, bool region_wise)
+        {
+          Array<spCF> cfs;
+          for (auto c : pycfs)
+            cfs.Append (py::extract<spCF>(c)());
+          BitArray mask;
+          py::extract<Region> defon_region(definedon);
+          if (defon_region.check())
+            {
+              vb = VorB(defon_region());
+              mask = BitArray(defon_region().Mask());
+            }
+          else
+            {
+              mask = BitArray(ma->GetNRegions(vb));
+              mask.Set();
+            }
+
+          bool is_complex = false;
+          for (auto & cf : cfs)
+            is_complex |= cf->IsComplex();
+          auto allcf = MakeVectorialCoefficientFunction (Array<spCF>(cfs));
+
+          Matrix<double> rsum;
+          Matrix<Complex> csum;
+          {
+            py::gil_scoped_release release;
+            if (is_complex)
+              csum = IntegrateComponents<Complex> (*allcf, *ma, vb, order, mask, region_wise, glh);
+            else
+              rsum = IntegrateComponents<double> (*allcf, *ma, vb, order, mask, region_wise, glh);
+          }
+
+          // split the rows back into the functions
+          auto value = [&] (size_t row, size_t first, const CoefficientFunction & cf) -> py::object
+            {
+              size_t dim = cf.Dimension();
+              if (!is_complex)
+                {
+                  if (dim == 1) return py::cast(rsum(row, first));
+                  return py::cast(Vector<double>(rsum.Row(row).Range(first, first+dim)));
+                }
+              if (!cf.IsComplex())
+                {
+                  if (dim == 1) return py::cast(csum(row, first).real());
+                  Vector<double> v(dim);
+                  for (size_t j = 0; j < dim; j++)
+                    v(j) = csum(row, first+j).real();
+                  return py::cast(v);
+                }
+              if (dim == 1) return py::cast(csum(row, first));
+              return py::cast(Vector<Complex>(csum.Row(row).Range(first, first+dim)));
+            };
+
+          py::list result;
+          size_t first = 0;
+          for (auto & cf : cfs)
+            {
+              if (region_wise)
+                {
+                  py::list regions;
+                  for (size_t r = 0; r < ma->GetNRegions(vb); r++)
+                    regions.append (value(r, first, *cf));
+                  result.append (regions);
+                }
+              else
+                result.append (value(0, first, *cf));
+              first += cf->Dimension();
+            }
+          return result;
+        },
+        py::arg("cf"), py::arg("mesh"), py::arg("VOL_or_BND")=VOL,
+        py::arg("order")=5,
+        py::arg("definedon")=DummyArgument(),
+        py::arg("region_wise")=false,
+        docu_string(R"raw_string(
+Integrates a list of CoefficientFunctions in one loop over the elements,
+and returns the list of integrals. Scalar and vector valued functions
+can be mixed. With region_wise=True every integral is the list over the
+regions. Arguments as for Integrate of one CoefficientFunction.
+)raw_string"))
+
   m.def("Integrate", 
         [](spCF cf,
            shared_ptr<MeshAccess> ma, 
@@ -2471,6 +2981,7 @@ integrator : ngsolve.fem.LFI
                    if (element_wise)
                      element_sum(el.Nr()) = hsum(0);
                  });
+              py::gil_scoped_acquire aquire;
               py::object result;
               if (region_wise) {
 #ifdef PARALLEL
@@ -2557,6 +3068,7 @@ integrator : ngsolve.fem.LFI
                      element_sum(el.Nr()) = hsum(0);
                  });
               
+              py::gil_scoped_acquire aquire;
               py::object result;
               if (region_wise) {
 #ifdef PARALLEL
@@ -2622,6 +3134,185 @@ element_wise: bool = False
         py::call_guard<py::gil_scoped_release>())
     ;
   
+  m.def("EvaluateAtPoints",
+        [](spCF cf, shared_ptr<MeshAccess> ma,
+           py::array_t<double, py::array::c_style | py::array::forcecast> pypoints,
+           py::object pyhints) -> py::array
+        {
+          if (pypoints.ndim() != 2 || pypoints.shape(1) < 1 || pypoints.shape(1) > 3)
+            throw Exception ("EvaluateAtPoints: points must be an array of shape (n, dim)");
+          size_t np = pypoints.shape(0);
+          size_t sdim = pypoints.shape(1);
+          auto pts = pypoints.unchecked<2>();
+          Array<Vec<3>> points(np);
+          Array<int> elnrs(np);
+          elnrs = -1;
+          if (!pyhints.is_none())
+            {
+              auto hints = py::cast<py::array_t<int, py::array::c_style | py::array::forcecast>> (pyhints);
+              if (hints.ndim() != 1 || size_t(hints.shape(0)) != np)
+                throw Exception ("EvaluateAtPoints: need one hint per point");
+              auto h = hints.unchecked<1>();
+              for (size_t i = 0; i < np; i++)
+                elnrs[i] = h(i);
+            }
+          for (size_t i = 0; i < np; i++)
+            {
+              points[i] = 0.0;
+              for (size_t j = 0; j < sdim; j++)
+                points[i](j) = pts(i,j);
+            }
+
+          size_t dim = cf->Dimension();
+          if (np == 0)
+            return py::array_t<double>(vector<size_t>{0, dim});
+          Array<IntegrationPoint> ips(np);
+          auto evaluate = [&] (auto scal) -> py::array
+            {
+              typedef decltype(scal) SCAL;
+              Array<SCAL> vals(np*dim);
+              {
+                py::gil_scoped_release release;
+                ma->FindElementsOfPoints (points, elnrs, ips);
+                vals = SCAL(numeric_limits<double>::quiet_NaN());
+                EvaluateAtPoints<SCAL> (*cf, *ma, elnrs, ips,
+                                        FlatMatrix<SCAL>(np, dim, &vals[0]));
+              }
+              return MoveToNumpyArray(vals).attr("reshape")(np, dim);
+            };
+          if (cf->IsComplex())
+            return evaluate (Complex(0));
+          return evaluate (double(0));
+        },
+        py::arg("cf"), py::arg("mesh"), py::arg("points"), py::arg("hints")=py::none(),
+        docu_string(R"raw_string(
+Evaluates a CoefficientFunction at many points at once.
+
+The points are located in the volume elements, grouped by element and
+evaluated element by element with SIMD integration rules, in parallel.
+
+Parameters:
+
+cf : ngsolve.CoefficientFunction
+  function to evaluate, e.g. a GridFunction
+
+mesh : ngsolve.Mesh
+  the mesh to locate the points in
+
+points : numpy.ndarray
+  coordinates, shape (n, dim)
+
+hints : numpy.ndarray of int
+  elements tried first, e.g. the elements of the previous time step, or -1
+
+Returns an array of shape (n, cf.dim), NaN for points outside the mesh.
+)raw_string"))
+    ;
+
+  m.def("ZZErrorEstimator",
+        [](shared_ptr<GF> gfu, shared_ptr<GF> flux, shared_ptr<BilinearFormIntegrator> bfi,
+           int domain) -> py::array
+        {
+          auto ma = gfu->GetMeshAccess();
+          Array<double> err(ma->GetNE(bfi->VB()));
+          {
+            py::gil_scoped_release release;
+            err = 0.0;
+            CalcFluxProject (*gfu, *flux, bfi, true, domain, glh);
+            FlatVector<double> ferr(err.Size(), &err[0]);
+            CalcError (*gfu, *flux, bfi, ferr, domain, glh);
+          }
+          return MoveToNumpyArray(err);
+        },
+        py::arg("gf"), py::arg("flux"), py::arg("bfi"), py::arg("domain")=-1,
+        docu_string(R"raw_string(
+Zienkiewicz-Zhu type error estimator.
+
+Projects the flux of gf locally into the space of flux and averages it
+(CalcFluxProject), then integrates the energy norm of the difference
+between both fluxes on every element (CalcError). Both element loops run
+in parallel.
+
+Parameters:
+
+gf : ngsolve.GridFunction
+  the solution
+
+flux : ngsolve.GridFunction
+  receives the averaged flux, e.g. in a vector valued H1 space
+
+bfi : ngsolve.BFI
+  integrator defining flux and energy norm, e.g. BFI("laplace", coef=lam)
+
+domain : int
+  only elements of this domain, -1 for all
+
+Returns the element error indicators as numpy array.
+)raw_string"))
+    ;
+
+  m.def("ElementNorms",
+        [](py::list pycfs, shared_ptr<MeshAccess> ma,
+           VorB vb, int order, py::object definedon) -> py::array
+        {
+          Array<spCF> cfs;
+          for (auto c : pycfs)
+            cfs.Append (py::extract<spCF>(c)());
+          BitArray mask;
+          py::extract<Region> defon_region(definedon);
+          if (defon_region.check())
+            {
+              vb = VorB(defon_region());
+              mask = BitArray(defon_region().Mask());
+            }
+          else
+            {
+              mask = BitArray(ma->GetNRegions(vb));
+              mask.Set();
+            }
+
+          size_t ne = ma->GetNE(vb);
+          Array<double> err(ne*cfs.Size());
+          {
+            py::gil_scoped_release release;
+            err = 0.0;
+            CalcElementNorms (ma, cfs, vb, order, mask,
+                              FlatMatrix<double>(ne, cfs.Size(), &err[0]), glh);
+          }
+          return MoveToNumpyArray(err).attr("reshape")(ne, cfs.Size());
+        },
+        py::arg("cfs"), py::arg("mesh"), py::arg("VOL_or_BND")=VOL,
+        py::arg("order")=5,
+        py::arg("definedon")=DummyArgument(),
+        docu_string(R"raw_string(
+Squared L2 norms of several CoefficientFunctions on every element, e.g.
+the L2 and H1-seminorm errors of a solution in one loop over the mesh.
+All functions are evaluated on the same SIMD integration rule, elements
+are processed in parallel. Complex and vector valued functions are
+allowed, the norm is taken of the absolute values.
+
+Parameters:
+
+cfs : list of ngsolve.CoefficientFunction
+  functions to be measured, e.g. [u-uex, grad(u)-graduex]
+
+mesh : ngsolve.Mesh
+  the mesh
+
+VOL_or_BND : ngsolve.VorB = VOL
+  co-dimension of the elements
+
+order : int = 5
+  integration order
+
+definedon : ngsolve.Region
+  only elements of this region, overwrites VOL_or_BND
+
+Returns a numpy array of shape (ne, len(cfs)), entry (el,k) is the
+integral of |cfs[k]|^2 over element el.
+)raw_string"))
+    ;
+
   m.def("SymbolicLFI",
           [](spCF cf, VorB vb, bool element_boundary,
              bool skeleton, py::object definedon,
@@ -3163,7 +3854,8 @@ element_vb : ngsolve.fem.VorB
 
    py::class_<BaseVTKOutput, shared_ptr<BaseVTKOutput>>(m, "VTKOutput")
     .def(py::init([] (shared_ptr<MeshAccess> ma, py::list coefs_list,
-                      py::list names_list, string filename, int subdivision, int only_element)
+                      py::list names_list, string filename, int subdivision, int only_element,
+                      bool legacy, bool compress, bool background)
          -> shared_ptr<BaseVTKOutput>
          {
            Array<shared_ptr<CoefficientFunction> > coefs
@@ -3172,9 +3864,11 @@ element_vb : ngsolve.fem.VorB
              = makeCArray<string> (names_list);
            shared_ptr<BaseVTKOutput> ret;
            if (ma->GetDimension() == 2)
-             ret = make_shared<VTKOutput<2>> (ma, coefs, names, filename, subdivision, only_element);
+             ret = make_shared<VTKOutput<2>> (ma, coefs, names, filename, subdivision, only_element,
+                                              legacy, compress, background);
            else
-             ret = make_shared<VTKOutput<3>> (ma, coefs, names, filename, subdivision, only_element);
+             ret = make_shared<VTKOutput<3>> (ma, coefs, names, filename, subdivision, only_element,
+                                              legacy, compress, background);
            return ret;
          }),
          py::arg("ma"),
@@ -3182,7 +3876,13 @@ element_vb : ngsolve.fem.VorB
          py::arg("names") = py::list(),
          py::arg("filename") = "vtkout",
          py::arg("subdivision") = 0,
-         py::arg("only_element") = -1
+         py::arg("only_element") = -1,
+         py::arg("legacy") = true,
+         py::arg("compress") = false,
+         py::arg("background") = false,
+         "legacy: ASCII .vtk file, otherwise binary .vtu (and .pvtu for MPI runs)\n"
+         "compress: zlib compression of the binary arrays\n"
+         "background: Do evaluates the fields, the file is written by a background thread"
          )
      .def("Do", [](shared_ptr<BaseVTKOutput> self)
           { 
@@ -3195,8 +3895,309 @@ element_vb : ngsolve.fem.VorB
           },
           py::arg("drawelems"),
           py::call_guard<py::gil_scoped_release>())
+     .def("Do", [](shared_ptr<BaseVTKOutput> self, double time)
+          { 
+            self->SetTime(time);
+            self->Do(glh);
+          },
+          py::arg("time"),
+          py::call_guard<py::gil_scoped_release>())
+     .def("Wait", [](shared_ptr<BaseVTKOutput> self)
+          {
+            self->Wait();
+          },
+          py::call_guard<py::gil_scoped_release>(),
+          "waits until the output written in the background is finished")
      ;
 
+   m.def("XDMFOutput", [] (shared_ptr<MeshAccess> ma, py::list coefs_list,
+                           py::list names_list, string filename, int subdivision,
+                           int only_element, bool compress)
+         -> shared_ptr<BaseVTKOutput>
+         {
+           Array<shared_ptr<CoefficientFunction> > coefs
+             = makeCArraySharedPtr<shared_ptr<CoefficientFunction>> (coefs_list);
+           Array<string > names
+             = makeCArray<string> (names_list);
+           if (ma->GetDimension() == 2)
+             return make_shared<XDMFOutput<2>> (ma, coefs, names, filename, subdivision, only_element, compress);
+           else
+             return make_shared<XDMFOutput<3>> (ma, coefs, names, filename, subdivision, only_element, compress);
+         },
+         py::arg("ma"),
+         py::arg("coefs")= py::list(),
+         py::arg("names") = py::list(),
+         py::arg("filename") = "xdmfout",
+         py::arg("subdivision") = 0,
+         py::arg("only_element") = -1,
+         py::arg("compress") = true,
+         docu_string(R"raw_string(
+Time series output in XDMF format with the data in filename.h5.
+The mesh is stored once, every Do(time=t) adds the fields of one step.
+Requires ngsolve built with USE_HDF5, parallel HDF5 for MPI runs.
+
+compress : bool
+  chunked datasets with deflate compression
+
+)raw_string"));
+
+   m.def("TransferMatrix", [] (shared_ptr<FESpace> from, shared_ptr<FESpace> to) -> shared_ptr<BaseMatrix>
+         {
+           return CreateTransferMatrix (*from, *to, glh);
+         }, py::arg("from"), py::arg("to"), py::call_guard<py::gil_scoped_release>(),
+         docu_string(R"raw_string(
+Sparse interpolation matrix from space 'from' to space 'to' on a
+different, non-matching mesh (remeshing, multiphysics coupling).
+Each element of 'to' gets the local L2 projection of the source
+function, shared dofs are averaged. Points are located once, every
+transfer is one matrix-vector product:
+
+  gfto.vec.data = mat * gffrom.vec
+
+Both spaces must be real with values of equal dimension. Points of
+'to' outside of the source mesh contribute zero.
+)raw_string"));
+
+   py::class_<ProbeSet, shared_ptr<ProbeSet>>
+     (m, "ProbeSet", docu_string(R"raw_string(
+Evaluation of CoefficientFunctions in a fixed set of points (probes).
+The points are located once, every Do evaluates all probes in one
+batched call and appends a row (time and values) to the file.
+
+points : list of tuples
+  probe coordinates
+
+coefs : CoefficientFunction or list of CoefficientFunctions
+  real valued functions to evaluate
+
+names : list of str
+  column names of the functions in csv files
+
+filename : str
+  output file, no output if empty
+
+format : str
+  'csv', 'binary' (two int64 for the number of probes and of values
+  per probe, then rows of doubles) or 'hdf5' (datasets points, time
+  and values, requires ngsolve built with USE_HDF5)
+
+)raw_string"))
+    .def(py::init([] (shared_ptr<MeshAccess> ma, py::list pypoints, py::object pycoefs,
+                      py::list names_list, string filename, string format)
+                  {
+                    Array<Vec<3>> points;
+                    for (auto p : pypoints)
+                      {
+                        auto t = py::cast<py::tuple> (p);
+                        Vec<3> v = 0.0;
+                        for (size_t j = 0; j < min2 (py::len(t), size_t(3)); j++)
+                          v(j) = t[j].cast<double>();
+                        points.Append (v);
+                      }
+                    Array<shared_ptr<CoefficientFunction>> coefs;
+                    if (py::isinstance<py::list> (pycoefs))
+                      coefs = makeCArraySharedPtr<shared_ptr<CoefficientFunction>> (py::cast<py::list> (pycoefs));
+                    else
+                      coefs.Append (py::cast<shared_ptr<CoefficientFunction>> (pycoefs));
+                    Array<string> names = makeCArray<string> (names_list);
+                    return make_shared<ProbeSet> (ma, points, coefs, names, filename, format);
+                  }),
+         py::arg("mesh"), py::arg("points"), py::arg("coefs"), py::arg("names") = py::list(),
+         py::arg("filename") = "", py::arg("format") = "csv")
+    .def("Do", [] (shared_ptr<ProbeSet> self, double time)
+         {
+           self->Do (time, glh);
+         },
+         py::arg("time") = 0.0, py::call_guard<py::gil_scoped_release>(),
+         "evaluates all probes and appends a row to the file")
+    .def("Evaluate", [] (shared_ptr<ProbeSet> self)
+         {
+           {
+             py::gil_scoped_release release;
+             self->Evaluate (glh);
+           }
+           return Matrix<> (self->GetValues());
+         },
+         "values of all probes, one row per probe, NaN outside of the mesh")
+    .def("__len__", &ProbeSet::Size)
+    .def_property_readonly("found", [] (shared_ptr<ProbeSet> self)
+                           {
+                             py::list found;
+                             for (size_t i = 0; i < self->Size(); i++)
+                               found.append (py::bool_(self->Found(i)));
+                             return found;
+                           }, "probes inside the mesh")
+    ;
+
+   py::class_<ExplicitTimeStepper, shared_ptr<ExplicitTimeStepper>>
+     (m, "ExplicitTimeStepper", docu_string(R"raw_string(
+Explicit Runge-Kutta time stepping for  M du/dt = f - A(u), e.g. for
+DG methods. A is applied matrix-free by the element and facet loops
+of the bilinear-form, M^{-1} element by element by FESpace.SolveM.
+
+a : BilinearForm
+  the spatial operator A, does not need to be assembled
+
+f : LinearForm
+  optional right hand side, assembled by the caller
+
+scheme : str
+  'euler', 'ssprk3' (3rd order SSP) or 'lsrk45' (4th order low-storage)
+
+invmass : BaseMatrix
+  inverse mass matrix, instead of FESpace.SolveM
+
+rho : CoefficientFunction
+  density in the mass matrix of SolveM
+
+time : Parameter
+  set to the stage time before A is applied, the linear-form is then
+  re-assembled in every stage
+
+)raw_string"))
+    .def(py::init<shared_ptr<BilinearForm>, shared_ptr<LinearForm>, string,
+         shared_ptr<BaseMatrix>, shared_ptr<CoefficientFunction>,
+         shared_ptr<ParameterCoefficientFunction>>(),
+         py::arg("a"), py::arg("f") = nullptr, py::arg("scheme") = "lsrk45",
+         py::arg("invmass") = nullptr, py::arg("rho") = nullptr, py::arg("time") = nullptr)
+    .def("Step", [] (shared_ptr<ExplicitTimeStepper> self, BaseVector & u, double dt)
+         {
+           self->Step (u, dt, glh);
+         },
+         py::arg("u"), py::arg("dt"), py::call_guard<py::gil_scoped_release>(),
+         "one time step of size dt")
+    .def("Do", [] (shared_ptr<ExplicitTimeStepper> self, BaseVector & u, double tend, double dt)
+         {
+           self->Do (u, tend, dt, glh);
+         },
+         py::arg("u"), py::arg("tend"), py::arg("dt"), py::call_guard<py::gil_scoped_release>(),
+         "time steps of size dt until time tend")
+    .def("Evaluate", [] (shared_ptr<ExplicitTimeStepper> self, BaseVector & u, BaseVector & k)
+         {
+           self->Evaluate (self->GetTime(), u, k, glh);
+         },
+         py::arg("u"), py::arg("k"), py::call_guard<py::gil_scoped_release>(),
+         "k = M^{-1} (f - A(u)) at the current time")
+    .def_property("t", &ExplicitTimeStepper::GetTime, &ExplicitTimeStepper::SetTime, "current time")
+    .def_property_readonly("nsteps", &ExplicitTimeStepper::GetNSteps)
+    .def_property_readonly("nstages", &ExplicitTimeStepper::GetNStages)
+    .def_property_readonly("scheme", &ExplicitTimeStepper::GetScheme)
+    .def("SetLocalTimeStepping", &ExplicitTimeStepper::SetLocalTimeStepping, py::arg("nclasses"),
+         "local time stepping with nclasses classes by element size, the elements\n"
+         "of class c take steps dt/2^c. nclasses=1 turns it off")
+    .def("SetElementClasses", [] (shared_ptr<ExplicitTimeStepper> self, py::list classes)
+         {
+           self->SetElementClasses (makeCArray<int> (classes));
+         }, py::arg("classes"),
+         "local time stepping with a class for every element, class c takes steps dt/2^c")
+    .def_property_readonly("elementclasses", [] (shared_ptr<ExplicitTimeStepper> self)
+                           {
+                             py::list classes;
+                             for (int c : self->GetElementClasses())
+                               classes.append (py::int_(c));
+                             return classes;
+                           })
+    .def_property_readonly("nclasses", &ExplicitTimeStepper::GetNClasses)
+    ;
+
+   py::class_<NewtonSolver, shared_ptr<NewtonSolver>>
+     (m, "NewtonSolver", docu_string(R"raw_string(
+Newton's method for A(u) = 0, the loop of solvers.Newton in C++.
+
+a : BilinearForm
+  the non-linear form, does not need to be assembled
+
+freedofs : BitArray
+  dofs of the Newton step, default the free dofs of the space
+  (the condensed ones if a uses condense)
+
+maxit : int
+  maximal number of iterations
+
+maxerr : float
+  stop when sqrt|<w,A(u)>| of the step w is smaller
+
+inverse : str
+  sparse direct solver for the Jacobian
+
+dampfactor : float
+  step length min(1, it*dampfactor) if no line search is used
+
+linesearch : bool
+  Armijo backtracking line search
+
+energy : bool
+  the energy is the merit function of the line search (minimization
+  problems with SymbolicEnergy), otherwise the norm of A(u)
+
+jacobian_lag : int
+  re-assemble and refactor the Jacobian every jacobian_lag steps only
+
+jacobian_lag_rate : float
+  re-assemble also if the error did not decrease by this factor
+
+krylov : bool
+  inexact Newton: lagged steps solve with the current Jacobian by GMRES,
+  matrix-free, preconditioned by the lagged factorization
+
+krylov_tol : float
+  upper bound for the relative GMRES tolerance (Eisenstat-Walker)
+
+krylov_maxsteps : int
+  maximal number of GMRES steps per Newton step
+
+printing : bool
+  print the error of every iteration
+
+)raw_string"))
+    .def(py::init([] (shared_ptr<BilinearForm> a, shared_ptr<BitArray> freedofs,
+                      int maxit, double maxerr, string inverse, double dampfactor,
+                      bool linesearch, bool energy, int jacobian_lag, double jacobian_lag_rate,
+                      bool krylov, double krylov_tol, int krylov_maxsteps, bool printing)
+                  {
+                    Flags flags;
+                    flags.SetFlag ("maxit", maxit);
+                    flags.SetFlag ("maxerr", maxerr);
+                    flags.SetFlag ("inverse", inverse);
+                    flags.SetFlag ("dampfactor", dampfactor);
+                    if (linesearch) flags.SetFlag ("linesearch");
+                    if (energy) flags.SetFlag ("energy");
+                    flags.SetFlag ("jacobian_lag", jacobian_lag);
+                    flags.SetFlag ("jacobian_lag_rate", jacobian_lag_rate);
+                    if (krylov) flags.SetFlag ("krylov");
+                    flags.SetFlag ("krylov_tol", krylov_tol);
+                    flags.SetFlag ("krylov_maxsteps", krylov_maxsteps);
+                    if (printing) flags.SetFlag ("printing");
+                    return make_shared<NewtonSolver> (a, freedofs, flags);
+                  }),
+         py::arg("a"), py::arg("freedofs") = nullptr, py::arg("maxit") = 100,
+         py::arg("maxerr") = 1e-11, py::arg("inverse") = "", py::arg("dampfactor") = 1,
+         py::arg("linesearch") = false, py::arg("energy") = false,
+         py::arg("jacobian_lag") = 1, py::arg("jacobian_lag_rate") = 1,
+         py::arg("krylov") = false, py::arg("krylov_tol") = 0.1, py::arg("krylov_maxsteps") = 50,
+         py::arg("printing") = false)
+    .def("Solve", [] (shared_ptr<NewtonSolver> self, BaseVector & u)
+         {
+           int status = self->Solve (u, glh);
+           return py::make_tuple (status, self->GetNumIt());
+         },
+         py::arg("u"), py::call_guard<py::gil_scoped_release>(),
+         "Newton iteration from the initial guess u, returns (status, numit),\n"
+         "status is 0 if converged, -1 otherwise")
+    .def_property_readonly("numit", &NewtonSolver::GetNumIt)
+    .def_property_readonly("error", &NewtonSolver::GetError)
+    .def_property_readonly("nassemble", &NewtonSolver::GetNAssemble,
+                           "assemblies of the Jacobian in the last solve")
+    .def_property_readonly("nfactor", &NewtonSolver::GetNFactor,
+                           "new factorizations in the last solve")
+    .def_property_readonly("nupdate", &NewtonSolver::GetNUpdate,
+                           "refactorizations with the old ordering in the last solve")
+    .def_property_readonly("nkrylov", &NewtonSolver::GetNKrylov,
+                           "GMRES steps in the last solve")
+    .def_property_readonly("nlinesearch", &NewtonSolver::GetNLineSearch,
+                           "rejected line search steps in the last solve")
+    ;
+
   /////////////////////////////////////////////////////////////////////////////////////
 }
 
@@ -654,6 +654,51 @@ mesh (netgen.Mesh): a mesh generated from Netgen
          py::arg("order"),
          "Curve the mesh elements for geometry approximation of given order")
 
+    .def("PrecomputeAffineTrafos", &MeshAccess::PrecomputeAffineTrafos,
+         "Store Jacobians of non-curved volume elements in a mesh-wide table")
+
+    .def("FindElementsOfPoints",
+         [](shared_ptr<MeshAccess> ma, py::list pypoints, py::list pyhints)
+          {
+            size_t np = py::len(pypoints);
+            Array<Vec<3>> points(np);
+            for (size_t i = 0; i < np; i++)
+              {
+                auto t = py::cast<py::tuple> (pypoints[i]);
+                points[i] = 0.0;
+                for (size_t j = 0; j < min2 (py::len(t), size_t(3)); j++)
+                  points[i](j) = t[j].cast<double>();
+              }
+            Array<int> elnrs(np);
+            elnrs = -1;
+            if (py::len(pyhints))
+              {
+                if (py::len(pyhints) != np)
+                  throw Exception ("FindElementsOfPoints: need one hint per point");
+                for (size_t i = 0; i < np; i++)
+                  elnrs[i] = pyhints[i].cast<int>();
+              }
+            Array<IntegrationPoint> ips(np);
+            {
+              py::gil_scoped_release release;
+              ma->FindElementsOfPoints (points, elnrs, ips);
+            }
+            py::list mips;
+            for (size_t i = 0; i < np; i++)
+              mips.append (MeshPoint { ips[i](0), ips[i](1), ips[i](2), ma.get(), VOL, elnrs[i] });
+            return mips;
+          },
+         py::arg("points"), py::arg("hints") = py::list(),
+         docu_string(R"raw_string(
+Locates a list of points (tuples) in the volume elements, in parallel.
+Returns a list of MeshPoints, the element number nr is -1 for points
+outside of the mesh.
+
+hints : list of int
+  elements tried first, e.g. the elements of the last time step
+  of particles (nr of the previous MeshPoints), -1 for no hint
+)raw_string"))
+
     .def("Contains",
          [](MeshAccess & ma, double x, double y, double z) 
           {
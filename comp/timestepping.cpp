@@ -0,0 +1,430 @@
+/*********************************************************************/
+/* File:   timestepping.cpp                                          */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+#include <comp.hpp>
+
+namespace ngcomp
+{
+
+  // Carpenter, Kennedy: Fourth-order 2N-storage Runge-Kutta schemes, 1994
+  static const double lsrk45_a[5] =
+    { 0.0,
+      -567301805773.0/1357537059087.0,
+      -2404267990393.0/2016746695238.0,
+      -3550918686646.0/2091501179385.0,
+      -1275806237668.0/842570457699.0 };
+  static const double lsrk45_b[5] =
+    { 1432997174477.0/9575080441755.0,
+      5161836677717.0/13612068292357.0,
+      1720146321549.0/2090206949498.0,
+      3134564353537.0/4481467310338.0,
+      2277821191437.0/14882151754819.0 };
+  static const double lsrk45_c[5] =
+    { 0.0,
+      1432997174477.0/9575080441755.0,
+      2526269341429.0/6820363962896.0,
+      2006345519317.0/3224310063776.0,
+      2802321613138.0/2924317926251.0 };
+
+  // Shu-Osher form:  u = alpha u0 + (1-alpha) (u + c dt k)
+  static const double ssprk3_alpha[3] = { 0.0, 3.0/4.0, 1.0/3.0 };
+  static const double ssprk3_c[3] = { 0.0, 1.0, 0.5 };
+
+
+  ExplicitTimeStepper ::
+  ExplicitTimeStepper (shared_ptr<BilinearForm> abfa, shared_ptr<LinearForm> alff,
+                       string ascheme, shared_ptr<BaseMatrix> ainvmass,
+                       shared_ptr<CoefficientFunction> arho,
+                       shared_ptr<ParameterCoefficientFunction> atime)
+    : bfa(abfa), lff(alff), scheme(ascheme), invmass(ainvmass), rho(arho), time(atime)
+  {
+    if (scheme != "euler" && scheme != "ssprk3" && scheme != "lsrk45")
+      throw Exception ("ExplicitTimeStepper: unknown scheme '"+scheme+
+                       "', use 'euler', 'ssprk3' or 'lsrk45'");
+    if (bfa->MixedSpaces())
+      throw Exception ("ExplicitTimeStepper needs a bilinear-form on one space");
+  }
+
+  int ExplicitTimeStepper :: GetNStages () const
+  {
+    if (scheme == "ssprk3") return 3;
+    if (scheme == "lsrk45") return 5;
+    return 1;
+  }
+  
+
+  void ExplicitTimeStepper :: Evaluate (double at, const BaseVector & u, BaseVector & ku,
+                                        LocalHeap & lh)
+  {
+    static Timer tev("ExplicitTimeStepper::Evaluate"); RegionTimer reg(tev);
+    static Timer tm("ExplicitTimeStepper::Evaluate - invmass");
+
+    if (time)
+      {
+        time->SetValue (at);
+        if (lff) lff->Assemble (lh);
+      }
+
+    if (invmass && !hv) hv = u.CreateVector();
+    BaseVector & res = invmass ? *hv : ku;
+
+    // res = f - A(u)
+    bfa->ApplyMatrix (u, res, lh);
+    FlatVector<double> fres = res.FVDouble();
+    if (lff)
+      {
+        FlatVector<double> ff = lff->GetVector().FVDouble();
+        ParallelForRange (fres.Size(), [&] (IntRange r)
+                          { fres.Range(r) = ff.Range(r) - fres.Range(r); });
+      }
+    else
+      ParallelForRange (fres.Size(), [&] (IntRange r)
+                        { fres.Range(r) *= -1; });
+
+    RegionTimer regm(tm);
+    if (invmass)
+      invmass->Mult (res, ku);
+    else
+      bfa->GetFESpace()->SolveM (rho.get(), ku, lh);
+  }
+
+
+  void ExplicitTimeStepper :: Step (BaseVector & u, double dt, LocalHeap & lh)
+  {
+    static Timer tstep("ExplicitTimeStepper::Step"); RegionTimer reg(tstep);
+    static Timer tupdate("ExplicitTimeStepper::Step - update");
+
+    if (!k || k->Size() != u.Size() || k->EntrySize() != u.EntrySize())
+      {
+        k = u.CreateVector();
+        w = u.CreateVector();
+        hv = nullptr;
+      }
+
+    if (classes.Size() > 1)
+      {
+        if (!hv) hv = u.CreateVector();
+        StepClass (0, u, t, dt, lh);
+        // class c updates its dofs 2^c times
+        for (size_t c = 0; c < classes.Size(); c++)
+          tstep.AddFlops (double(GetNStages()) * (size_t(1) << c) * classes[c].idx.Size());
+        t += dt;
+        nsteps++;
+        if (time) time->SetValue (t);
+        return;
+      }
+
+    // the coefficients are real, complex vectors are updated as doubles
+    FlatVector<double> fu = u.FVDouble();
+    FlatVector<double> fk = k->FVDouble();
+    FlatVector<double> fw = w->FVDouble();
+
+    if (scheme == "euler")
+      {
+        Evaluate (t, u, *k, lh);
+        RegionTimer regu(tupdate);
+        ParallelForRange (fu.Size(), [&] (IntRange r)
+                          { fu.Range(r) += dt * fk.Range(r); });
+      }
+
+    else if (scheme == "ssprk3")
+      {
+        // w = u0,  u = alpha w + (1-alpha) (u + dt k)
+        ParallelForRange (fu.Size(), [&] (IntRange r)
+                          { fw.Range(r) = fu.Range(r); });
+        for (int s = 0; s < 3; s++)
+          {
+            Evaluate (t + ssprk3_c[s]*dt, u, *k, lh);
+            RegionTimer regu(tupdate);
+            double alpha = ssprk3_alpha[s];
+            ParallelForRange (fu.Size(), [&] (IntRange r)
+                              {
+                                for (auto i : r)
+                                  fu(i) = alpha * fw(i) + (1-alpha) * (fu(i) + dt * fk(i));
+                              });
+          }
+      }
+
+    else
+      {
+        // w = a w + dt k,  u += b w
+        for (int s = 0; s < 5; s++)
+          {
+            Evaluate (t + lsrk45_c[s]*dt, u, *k, lh);
+            RegionTimer regu(tupdate);
+            double a = lsrk45_a[s], b = lsrk45_b[s];
+            ParallelForRange (fu.Size(), [&] (IntRange r)
+                              {
+                                for (auto i : r)
+                                  {
+                                    double wi = dt * fk(i);
+                                    if (s > 0) wi += a * fw(i);
+                                    fw(i) = wi;
+                                    fu(i) += b * wi;
+                                  }
+                              });
+          }
+      }
+
+    tstep.AddFlops (double(GetNStages()) * u.Size() * u.EntrySize());
+    t += dt;
+    nsteps++;
+    if (time) time->SetValue (t);
+  }
+
+
+  void ExplicitTimeStepper :: SetLocalTimeStepping (int nclasses)
+  {
+    auto ma = bfa->GetFESpace()->GetMeshAccess();
+    size_t ne = ma->GetNE(VOL);
+    int dim = ma->GetDimension();
+    
+    if (nclasses <= 1)
+      {
+        elclass.SetSize0();
+        classes.SetSize0();
+        return;
+      }
+
+    // element with h = hmax/2^c needs steps dt/2^c
+    Array<double> h(ne);
+    ParallelFor (ne, [&] (size_t i)
+                 { h[i] = pow (ma->ElementVolume(i), 1.0/dim); });
+    double hmax = 0;
+    for (double hi : h) hmax = max2 (hmax, hi);
+
+    Array<int> cl(ne);
+    for (size_t i = 0; i < ne; i++)
+      {
+        int c = int (ceil (log2 (hmax/h[i]) - 1e-8));
+        cl[i] = max2 (0, min2 (c, nclasses-1));
+      }
+    SetElementClasses (cl);
+  }
+
+
+  void ExplicitTimeStepper :: SetElementClasses (FlatArray<int> aelclass)
+  {
+    auto fes = bfa->GetFESpace();
+    auto ma = fes->GetMeshAccess();
+    size_t ne = ma->GetNE(VOL);
+    if (aelclass.Size() != ne)
+      throw Exception ("SetElementClasses: need one class per element, got "+
+                       ToString(aelclass.Size())+" for "+ToString(ne)+" elements");
+    if (fes->GetParallelDofs())
+      throw Exception ("local time stepping is not available for distributed spaces");
+
+    int ncl = 0;
+    for (int c : aelclass)
+      {
+        if (c < 0) throw Exception ("SetElementClasses: negative class");
+        ncl = max2 (ncl, c+1);
+      }
+
+    elclass.SetSize (ne);
+    elclass = aelclass;
+    classes.SetSize (0);
+    classes.SetSize (ncl);
+
+    int es = fes->GetDimension() * (fes->IsComplex() ? 2 : 1);
+    Array<int> dofclass(fes->GetNDof());
+    dofclass = -1;
+    Array<shared_ptr<BitArray>> elements(ncl), facets(ncl);
+    for (int c : Range(ncl))
+      {
+        elements[c] = make_shared<BitArray> (ne);
+        elements[c]->Clear();
+        facets[c] = make_shared<BitArray> (ma->GetNFacets());
+        facets[c]->Clear();
+      }
+    
+    Array<DofId> dnums;
+    for (size_t i = 0; i < ne; i++)
+      {
+        ElementId ei(VOL, i);
+        int c = elclass[i];
+        elements[c]->Set(i);
+        for (auto f : ma->GetElFacets(ei))
+          facets[c]->Set(f);
+        fes->GetDofNrs (ei, dnums);
+        for (auto d : dnums)
+          {
+            if (!IsRegularDof(d)) continue;
+            if (dofclass[d] != -1 && dofclass[d] != c)
+              throw Exception ("local time stepping needs dofs local to the elements, e.g. L2");
+            if (dofclass[d] == c) continue;
+            dofclass[d] = c;
+            for (int j = 0; j < es; j++)
+              classes[c].idx.Append (size_t(d)*es+j);
+          }
+      }
+
+    // element masks for volume and element-boundary terms, facet
+    // masks for facet terms, combined with masks the integrators already have
+    for (int c : Range(ncl))
+      for (auto & bfi : bfa->Integrators())
+        {
+          shared_ptr<BitArray> mask;
+          if (bfi->VB() == VOL && !(bfi->SkeletonForm() && !bfi->GetDGFormulation().element_boundary))
+            mask = elements[c];
+          else if (bfi->SkeletonForm())
+            mask = facets[c];
+          if (mask && bfi->GetDefinedOnElements())
+            {
+              mask = make_shared<BitArray> (*mask);
+              mask->And (*bfi->GetDefinedOnElements());
+            }
+          classes[c].masks.Append (mask);
+        }
+    
+    for (auto & tc : classes)
+      {
+        tc.uold.SetSize (tc.idx.Size());
+        tc.unew.SetSize (tc.idx.Size());
+        tc.w.SetSize (tc.idx.Size());
+      }
+  }
+
+
+  BaseVector & ExplicitTimeStepper :: EvaluateClass (int cl, double at, const BaseVector & u,
+                                                     LocalHeap & lh)
+  {
+    static Timer tev("ExplicitTimeStepper::EvaluateClass"); RegionTimer reg(tev);
+
+    auto & tc = classes[cl];
+    FlatArray<size_t> idx = tc.idx;
+    
+    if (time)
+      {
+        time->SetValue (at);
+        if (lff) lff->Assemble (lh);
+      }
+
+    // restrict the integrators to the class, restore them also on exceptions
+    struct RestoreMasks
+    {
+      const Array<shared_ptr<BilinearFormIntegrator>> & parts;
+      Array<shared_ptr<BitArray>> saved;
+      ~RestoreMasks ()
+      {
+        for (size_t i = 0; i < parts.Size(); i++)
+          parts[i]->SetDefinedOnElements (saved[i]);
+      }
+    } restore { bfa->Integrators(), Array<shared_ptr<BitArray>>() };
+
+    for (size_t i = 0; i < bfa->Integrators().Size(); i++)
+      {
+        auto & bfi = bfa->Integrators()[i];
+        restore.saved.Append (bfi->GetDefinedOnElements());
+        if (tc.masks[i])
+          bfi->SetDefinedOnElements (tc.masks[i]);
+      }
+
+    // A(u) is correct on the class dofs only
+    bfa->ApplyMatrix (u, *hv, lh);
+    
+    FlatVector<double> fk = k->FVDouble();
+    FlatVector<double> fh = hv->FVDouble();
+    ParallelForRange (fk.Size(), [&] (IntRange r) { fk.Range(r) = 0.0; });
+    if (lff)
+      {
+        FlatVector<double> ff = lff->GetVector().FVDouble();
+        ParallelFor (idx.Size(), [&] (size_t i) { fk(idx[i]) = ff(idx[i]) - fh(idx[i]); });
+      }
+    else
+      ParallelFor (idx.Size(), [&] (size_t i) { fk(idx[i]) = -fh(idx[i]); });
+
+    if (invmass)
+      {
+        invmass->Mult (*k, *hv);
+        return *hv;
+      }
+    bfa->GetFESpace()->SolveM (rho.get(), *k, lh);
+    return *k;
+  }
+
+
+  void ExplicitTimeStepper :: InterpolateCoarse (int cl, double at, BaseVector & u)
+  {
+    FlatVector<double> fu = u.FVDouble();
+    for (int j = 0; j < cl; j++)
+      {
+        auto & tc = classes[j];
+        double theta = (at - tc.t0) / tc.dt;
+        ParallelFor (tc.idx.Size(), [&] (size_t i)
+                     { fu(tc.idx[i]) = (1-theta) * tc.uold[i] + theta * tc.unew[i]; });
+      }
+  }
+  
+
+  void ExplicitTimeStepper :: StepClass (int cl, BaseVector & u, double at, double dt,
+                                         LocalHeap & lh)
+  {
+    static Timer tupdate("ExplicitTimeStepper::StepClass - update");
+    auto & tc = classes[cl];
+    FlatArray<size_t> idx = tc.idx;
+    FlatVector<double> fu = u.FVDouble();
+    FlatArray<double> uold = tc.uold, w = tc.w;
+
+    ParallelFor (idx.Size(), [&] (size_t i) { uold[i] = fu(idx[i]); });
+    tc.t0 = at;
+    tc.dt = dt;
+
+    if (idx.Size())
+      for (int s = 0; s < GetNStages(); s++)
+        {
+          double c = (scheme == "ssprk3") ? ssprk3_c[s] : (scheme == "lsrk45") ? lsrk45_c[s] : 0;
+          InterpolateCoarse (cl, at + c*dt, u);
+          FlatVector<double> fk = EvaluateClass (cl, at + c*dt, u, lh).FVDouble();
+          
+          RegionTimer regu(tupdate);
+          if (scheme == "euler")
+            ParallelFor (idx.Size(), [&] (size_t i)
+                         { fu(idx[i]) += dt * fk(idx[i]); });
+          else if (scheme == "ssprk3")
+            {
+              double alpha = ssprk3_alpha[s];
+              ParallelFor (idx.Size(), [&] (size_t i)
+                           {
+                             size_t ii = idx[i];
+                             fu(ii) = alpha * uold[i] + (1-alpha) * (fu(ii) + dt * fk(ii));
+                           });
+            }
+          else
+            {
+              double a = lsrk45_a[s], b = lsrk45_b[s];
+              ParallelFor (idx.Size(), [&] (size_t i)
+                           {
+                             size_t ii = idx[i];
+                             double wi = dt * fk(ii);
+                             if (s > 0) wi += a * w[i];
+                             w[i] = wi;
+                             fu(ii) += b * wi;
+                           });
+            }
+        }
+
+    if (size_t(cl+1) < classes.Size())
+      {
+        FlatArray<double> unew = tc.unew;
+        ParallelFor (idx.Size(), [&] (size_t i) { unew[i] = fu(idx[i]); });
+        StepClass (cl+1, u, at, dt/2, lh);
+        StepClass (cl+1, u, at+dt/2, dt/2, lh);
+        // the finer classes have overwritten this class by interpolation
+        ParallelFor (idx.Size(), [&] (size_t i) { fu(idx[i]) = unew[i]; });
+      }
+  }
+
+
+  void ExplicitTimeStepper :: Do (BaseVector & u, double tend, double dt, LocalHeap & lh)
+  {
+    if (dt <= 0)
+      throw Exception ("ExplicitTimeStepper::Do needs dt > 0");
+    // avoid a tiny last step from rounding of t
+    while (t < tend - 1e-10*dt)
+      Step (u, min2 (dt, tend-t), lh);
+  }
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+/*********************************************************************/
+/* File:   timestepping.hpp                                          */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+namespace ngcomp
+{
+
+  /**
+     Explicit Runge-Kutta time stepping for  M du/dt = f - A(u),
+     e.g. DG discretizations of wave propagation.
+
+     A is never assembled, it is applied by the element and facet
+     loops of BilinearForm::AddMatrix. The inverse mass matrix is
+     applied element by element with FESpace::SolveM (L2-type spaces),
+     or by the matrix invmass.
+
+     Schemes:
+       "euler"   forward Euler
+       "ssprk3"  3rd order strong stability preserving RK (Shu-Osher)
+       "lsrk45"  4th order 5-stage low-storage RK (Carpenter-Kennedy)
+
+     Both RK schemes keep two vectors besides the solution, every
+     stage update is one fused loop over the vectors. If a time
+     parameter is given it is set to the stage time before A is
+     applied, and the linear-form is then re-assembled in every stage.
+
+     Local time stepping: elements are grouped into classes, class c
+     takes steps dt/2^c. Every class step is followed by two steps of
+     the next finer class, which see the coarser classes linearly
+     interpolated in time and the finer ones frozen. Evaluations of a
+     class restrict the integrators to its elements and facets by
+     their definedon-elements masks, so the bilinear-form must not be
+     used elsewhere during a step. Needs a space with dofs local to the
+     elements (L2), classes default to the element size.
+  */
+  class NGS_DLL_HEADER ExplicitTimeStepper
+  {
+    shared_ptr<BilinearForm> bfa;
+    shared_ptr<LinearForm> lff;
+    string scheme;
+    shared_ptr<BaseMatrix> invmass;
+    shared_ptr<CoefficientFunction> rho;
+    shared_ptr<ParameterCoefficientFunction> time;
+
+    /// stage vectors, and the right hand side for invmass
+    shared_ptr<BaseVector> k, w, hv;
+    double t = 0;
+    size_t nsteps = 0;
+
+    /// time class of every element, for local time stepping
+    Array<int> elclass;
+    struct TimeClass
+    {
+      /// indices of the class dofs in FVDouble
+      Array<size_t> idx;
+      /// per integrator: restricted definedon-elements, nullptr if unrestricted
+      Array<shared_ptr<BitArray>> masks;
+      /// values at t0 and t0+dt, and the stage registers
+      Array<double> uold, unew, w;
+      double t0 = 0, dt = 0;
+    };
+    Array<TimeClass> classes;
+
+  public:
+    ExplicitTimeStepper (shared_ptr<BilinearForm> abfa, shared_ptr<LinearForm> alff,
+                         string ascheme = "lsrk45",
+                         shared_ptr<BaseMatrix> ainvmass = nullptr,
+                         shared_ptr<CoefficientFunction> arho = nullptr,
+                         shared_ptr<ParameterCoefficientFunction> atime = nullptr);
+
+    /// k = M^{-1} (f - A(u)) at time at
+    void Evaluate (double at, const BaseVector & u, BaseVector & k, LocalHeap & lh);
+    /// one step from t to t+dt
+    void Step (BaseVector & u, double dt, LocalHeap & lh);
+    /// steps of size dt (the last one shortened) until tend
+    void Do (BaseVector & u, double tend, double dt, LocalHeap & lh);
+
+    double GetTime () const { return t; }
+    void SetTime (double at) { t = at; }
+    size_t GetNSteps () const { return nsteps; }
+    int GetNStages () const;
+    const string & GetScheme () const { return scheme; }
+
+    /// local time stepping with classes from the element sizes, 1 = off
+    void SetLocalTimeStepping (int nclasses);
+    /// local time stepping with given classes, 0 takes the full step
+    void SetElementClasses (FlatArray<int> aelclass);
+    FlatArray<int> GetElementClasses () const { return elclass; }
+    int GetNClasses () const { return max2 (classes.Size(), size_t(1)); }
+
+  private:
+    /// k = M^{-1} (f - A(u)) on the dofs of class cl, returns k or hv
+    BaseVector & EvaluateClass (int cl, double at, const BaseVector & u, LocalHeap & lh);
+    /// step of class cl, followed by the finer classes
+    void StepClass (int cl, BaseVector & u, double at, double dt, LocalHeap & lh);
+    /// coarser classes than cl interpolated to time at
+    void InterpolateCoarse (int cl, double at, BaseVector & u);
+  };
+
+}
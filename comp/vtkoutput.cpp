@@ -6,6 +6,10 @@
 
 #include <comp.hpp>
 
+#ifdef NGS_USE_ZLIB
+#include <zlib.h>
+#endif
+
 namespace ngcomp
 { 
 
@@ -19,7 +23,10 @@ namespace ngcomp
                 flags.GetStringListFlag ("fieldnames" ),
                 flags.GetStringFlag ("filename","output"),
                 (int) flags.GetNumFlag ( "subdivision", 0),
-                (int) flags.GetNumFlag ( "only_element", -1))
+                (int) flags.GetNumFlag ( "only_element", -1),
+                !flags.GetDefineFlag ("vtu"),
+                flags.GetDefineFlag ("compress"),
+                flags.GetDefineFlag ("background"))
   {;}
 
 
@@ -27,16 +34,37 @@ namespace ngcomp
   VTKOutput<D>::VTKOutput (shared_ptr<MeshAccess> ama,
                            const Array<shared_ptr<CoefficientFunction>> & a_coefs,
                            const Array<string> & a_field_names,
-                           string a_filename, int a_subdivision, int a_only_element)
+                           string a_filename, int a_subdivision, int a_only_element,
+                           bool alegacy, bool acompress, bool abackground)
     : ma(ama), coefs(a_coefs), fieldnames(a_field_names),
-      filename(a_filename), subdivision(a_subdivision), only_element(a_only_element)
+      filename(a_filename), subdivision(a_subdivision), only_element(a_only_element),
+      legacy(alegacy), compress(acompress), background(abackground)
   {
+#ifndef NGS_USE_ZLIB
+    if (compress && !legacy)
+      {
+        cout << "VTKOutput: compiled without zlib, writing uncompressed data" << endl;
+        compress = false;
+      }
+#endif
     value_field.SetSize(a_coefs.Size());
     for (int i = 0; i < a_coefs.Size(); i++)
       if (fieldnames.Size() > i)
         value_field[i] = make_shared<ValueField>(coefs[i]->Dimension(),fieldnames[i]);
       else 
         value_field[i] = make_shared<ValueField>(coefs[i]->Dimension(),"dummy" + to_string(i));
+
+    FillReferenceTet(ref_vertices[ET_TET],ref_elems[ET_TET]);
+    FillReferencePrism(ref_vertices[ET_PRISM],ref_elems[ET_PRISM]);
+    FillReferenceQuad(ref_vertices[ET_QUAD],ref_elems[ET_QUAD]);
+    FillReferenceTrig(ref_vertices[ET_TRIG],ref_elems[ET_TRIG]);
+    FillReferenceHex(ref_vertices[ET_HEX],ref_elems[ET_HEX]);
+    for (ELEMENT_TYPE et : { ET_TRIG, ET_QUAD, ET_TET, ET_PRISM, ET_HEX })
+      {
+        IntegrationRule ir(ref_vertices[et].Size(), &ref_vertices[et][0]);
+        ir.SetDim (ElementTopology::GetSpaceDim(et));
+        simd_ref_vertices[et] = make_shared<SIMD_IntegrationRule> (ir);
+      }
   }
 
 
@@ -46,6 +74,7 @@ namespace ngcomp
   {
     points.SetSize(0);
     cells.SetSize(0);
+    celltypes.SetSize(0);
     for (auto field : value_field)
       field->SetSize(0);
   }
@@ -347,42 +376,13 @@ namespace ngcomp
     }
   }
 
-  /// output of cell types (here only simplices)
+  /// output of cell types
   template <int D> 
   void VTKOutput<D>::PrintCellTypes()
   {
     *fileout << "CELL_TYPES " << cells.Size() << endl;
-    int factor = (1<<subdivision)*(1<<subdivision);
-    if (D==3)
-      factor *= (1<<subdivision);
-    for (auto e : ma->Elements(VOL))
-    {
-      switch(ma->GetElType(e))
-      {
-      case ET_TET:
-        for(int i=0; i<factor; i++)
-          *fileout << "10 " << endl; //(void)c;
-        break;
-      case ET_QUAD:
-        for(int i=0; i<factor; i++)
-          *fileout << "9 " << endl;
-        break;
-      case ET_TRIG:
-        for(int i=0; i<factor; i++)
-          *fileout << "5 " << endl;
-        break;
-      case ET_PRISM:
-        for(int i=0; i<factor; i++)
-          *fileout << "13 " << endl;
-        break;
-      case ET_HEX:
-        for(int i=0; i<factor; i++)
-          *fileout << "12 " << endl;
-        break;        
-      default:
-        cout << "VTKOutput Element Type " << ma->GetElType(e) << " not supported!" << endl;
-      }
-    }
+    for (auto t : celltypes)
+      *fileout << int(t) << " " << endl;
     *fileout << "CELL_DATA " << cells.Size() << endl;
     *fileout << "POINT_DATA " << points.Size() << endl;
   }
@@ -406,124 +406,423 @@ namespace ngcomp
   }
     
 
-  template <int D> 
-  void VTKOutput<D>::Do (LocalHeap & lh, const BitArray * drawelems)
+  /// VTK type of the sub-cells of an element
+  static unsigned char VTKCellType (ELEMENT_TYPE eltype)
   {
-    ostringstream filenamefinal;
-    filenamefinal << filename;
-    if (output_cnt > 0)
-      filenamefinal << "_" << output_cnt;
-    filenamefinal << ".vtk";
-    fileout = make_shared<ofstream>(filenamefinal.str());
-    cout << " Writing VTK-Output";
-    if (output_cnt > 0)
-      cout << " ( " << output_cnt << " )";
-    cout << ":" << flush;
-    
-    output_cnt++;
+    switch (eltype)
+      {
+      case ET_TRIG: return 5;
+      case ET_QUAD: return 9;
+      case ET_TET: return 10;
+      case ET_HEX: return 12;
+      case ET_PRISM: return 13;
+      default:
+        throw Exception("VTK output for element-type"+ToString(eltype)+"not supported");
+      }
+  }
 
-    ResetArrays();
 
-    Array<IntegrationPoint> ref_vertices_tet(0), ref_vertices_prism(0), ref_vertices_trig(0), ref_vertices_quad(0), ref_vertices_hex(0);
-    Array<INT<ELEMENT_MAXPOINTS+1>> ref_tets(0), ref_prisms(0), ref_trigs(0), ref_quads(0), ref_hexes(0);
-    FlatArray<IntegrationPoint> ref_vertices;
-    FlatArray<INT<ELEMENT_MAXPOINTS+1>> ref_elems;
-    /*
-    if (D==3)
-      FillReferenceData3D(ref_vertices,ref_tets);
-    else
-      FillReferenceData2D(ref_vertices,ref_tets);
-    */
-    FillReferenceTet(ref_vertices_tet,ref_tets);
-    FillReferencePrism(ref_vertices_prism,ref_prisms);
-    FillReferenceQuad(ref_vertices_quad,ref_quads);
-    FillReferenceTrig(ref_vertices_trig,ref_trigs);
-    FillReferenceHex(ref_vertices_hex,ref_hexes);
-      
-    // header:
-    *fileout << "# vtk DataFile Version 3.0" << endl;
-    *fileout << "vtk output" << endl;
-    *fileout << "ASCII" << endl;
-    *fileout << "DATASET UNSTRUCTURED_GRID" << endl;
+  template <int D>
+  void VTKOutput<D>::FillData (LocalHeap & lh, const BitArray * drawelems)
+  {
+    static Timer t("VTKOutput::FillData"); RegionTimer reg(t);
 
-    int ne = ma->GetNE();
+    ResetArrays();
 
+    int ne = ma->GetNE();
     IntRange range = only_element >= 0 ? IntRange(only_element,only_element+1) : IntRange(ne);
-    
-    for ( int elnr : range)
-    {
-      if (drawelems && !(drawelems->Test(elnr)))
-          continue;
-      
-      HeapReset hr(lh);
 
-      ElementId ei(VOL, elnr);
-      ElementTransformation & eltrans = ma->GetTrafo (ei, lh);
-      ELEMENT_TYPE eltype = ma->GetElType(ei);
+    Array<int> elnrs;
+    for (int elnr : range)
+      if (!drawelems || drawelems->Test(elnr))
+        elnrs.Append (elnr);
 
-      switch(eltype)
+    // first point and first cell of every element, the output ordering
+    // is the one of the sequential element loop
+    Array<size_t> firstpoint(elnrs.Size()+1), firstcell(elnrs.Size()+1);
+    firstpoint[0] = firstcell[0] = 0;
+    for (auto i : Range(elnrs))
       {
-      case ET_TRIG:
-        ref_vertices.Assign(ref_vertices_trig);
-        ref_elems.Assign(ref_trigs);
-        break;
-      case ET_QUAD:
-        ref_vertices.Assign(ref_vertices_quad);
-        ref_elems.Assign(ref_quads);
-        break;
-      case ET_TET:
-        ref_vertices.Assign(ref_vertices_tet);
-        ref_elems.Assign(ref_tets);
-        break;
-      case ET_HEX:
-        ref_vertices.Assign(ref_vertices_hex);
-        ref_elems.Assign(ref_hexes);
-        break;        
-      case ET_PRISM:
-        ref_vertices.Assign(ref_vertices_prism);
-        ref_elems.Assign(ref_prisms);
-        break;
-      default:
-        throw Exception("VTK output for element-type"+ToString(eltype)+"not supported");
+        ELEMENT_TYPE eltype = ma->GetElType(ElementId(VOL, elnrs[i]));
+        VTKCellType (eltype);
+        firstpoint[i+1] = firstpoint[i] + ref_vertices[eltype].Size();
+        firstcell[i+1] = firstcell[i] + ref_elems[eltype].Size();
       }
 
-      int offset = points.Size();
-      for ( auto ip : ref_vertices)
-      {
-        MappedIntegrationPoint<D,D> mip(ip, eltrans);
-        points.Append(mip.GetPoint());
-      }
-      
-      for (int i = 0; i < coefs.Size(); i++)
-      {
-        for ( auto ip : ref_vertices)
+    size_t npoints = firstpoint[elnrs.Size()];
+    points.SetSize (npoints);
+    cells.SetSize (firstcell[elnrs.Size()]);
+    celltypes.SetSize (cells.Size());
+    for (auto field : value_field)
+      field->SetSize (npoints * field->Dimension());
+
+    // all cfs are evaluated on the SIMD rules, the first cf without
+    // SIMD evaluation switches to the scalar path for all elements
+    atomic<bool> use_simd(true);
+    ParallelForRange
+      (elnrs.Size(), [&] (IntRange r)
+       {
+         LocalHeap slh = lh.Split();
+         for (auto i : r)
+           {
+             HeapReset hr(slh);
+             ElementId ei(VOL, elnrs[i]);
+             ElementTransformation & eltrans = ma->GetTrafo (ei, slh);
+             ELEMENT_TYPE eltype = ma->GetElType(ei);
+             FlatArray<IntegrationPoint> verts = ref_vertices[eltype];
+             FlatArray<INT<ELEMENT_MAXPOINTS+1>> elems = ref_elems[eltype];
+             size_t first = firstpoint[i];
+             size_t np = verts.Size();
+
+             bool done = false;
+             if (use_simd)
+               try
+                 {
+                   constexpr int SW = SIMD<double>::Size();
+                   auto & smir = eltrans (*simd_ref_vertices[eltype], slh);
+                   auto spoints = smir.GetPoints();
+                   for (size_t j = 0; j < np; j++)
+                     for (int l = 0; l < D; l++)
+                       points[first+j](l) = spoints(j/SW, l)[j%SW];
+
+                   for (auto k : Range(coefs))
+                     {
+                       int dim = coefs[k]->Dimension();
+                       FlatMatrix<SIMD<double>> svalues(dim, smir.Size(), slh);
+                       coefs[k]->Evaluate (smir, svalues);
+                       FlatMatrix<> values(np, dim, &(*value_field[k])[first*dim]);
+                       for (size_t j = 0; j < np; j++)
+                         for (int l = 0; l < dim; l++)
+                           values(j,l) = svalues(l, j/SW)[j%SW];
+                     }
+                   done = true;
+                 }
+               catch (ExceptionNOSIMD & e)
+                 {
+                   use_simd = false;
+                 }
+
+             if (!done)
+               {
+                 IntegrationRule ir(np, &verts[0]);
+                 MappedIntegrationRule<D,D> mir(ir, eltrans, slh);
+                 for (auto j : Range(ir))
+                   points[first+j] = mir[j].GetPoint();
+
+                 for (auto k : Range(coefs))
+                   {
+                     int dim = coefs[k]->Dimension();
+                     FlatMatrix<> values(np, dim, &(*value_field[k])[first*dim]);
+                     coefs[k]->Evaluate (mir, values);
+                   }
+               }
+
+             unsigned char celltype = VTKCellType (eltype);
+             for (auto j : Range(elems))
+               {
+                 INT<ELEMENT_MAXPOINTS+1> new_elem = elems[j];
+                 for (int l = 1; l <= new_elem[0]; ++l)
+                   new_elem[l] += first;
+                 cells[firstcell[i]+j] = new_elem;
+                 celltypes[firstcell[i]+j] = celltype;
+               }
+           }
+       });
+  }
+
+
+  /*
+    Loops of the writer. Output jobs on a background thread must not
+    use the task manager, they run sequentially.
+  */
+  template <typename TFUNC>
+  static void WriterFor (size_t n, bool parallel, TFUNC f)
+  {
+    if (parallel)
+      ParallelFor (n, f);
+    else
+      for (size_t i = 0; i < n; i++)
+        f(i);
+  }
+
+
+  /*
+    Binary arrays of the appended data section of a VTU file, offsets
+    count from the '_' marker. A raw array is preceded by its size in
+    bytes, a compressed one by the block table of the
+    vtkZLibDataCompressor: number of blocks, block size, size of the
+    last block and the compressed size of every block. Header entries
+    are UInt64.
+  */
+  class VTUAppendedData
+  {
+    struct DataArray
+    {
+      const char * data;
+      size_t nbytes;
+      Array<uint64_t> table;
+      Array<char> packed;
+    };
+
+    bool zlib;
+    bool parallel;
+    Array<shared_ptr<DataArray>> arrays;
+    size_t offset = 0;
+    static constexpr size_t blocksize = 1 << 20;
+
+  public:
+    VTUAppendedData (bool azlib, bool aparallel) : zlib(azlib), parallel(aparallel) { ; }
+
+    /// returns the DataArray tag, data must remain valid until Write
+    string Add (string type, string name, int ncomp, const void * data, size_t nbytes)
+    {
+      auto da = make_shared<DataArray>();
+      da->data = static_cast<const char*> (data);
+      da->nbytes = nbytes;
+      if (zlib)
+        Compress (*da);
+      else
+        da->table = { uint64_t(nbytes) };
+
+      ostringstream tag;
+      tag << "<DataArray type=\"" << type << "\"";
+      if (name.length()) tag << " Name=\"" << name << "\"";
+      tag << " NumberOfComponents=\"" << ncomp << "\" format=\"appended\" offset=\"" << offset << "\"/>";
+
+      offset += sizeof(uint64_t) * da->table.Size() + (zlib ? da->packed.Size() : nbytes);
+      arrays.Append (da);
+      return tag.str();
+    }
+
+    void Write (ostream & out) const
+    {
+      out << "  <AppendedData encoding=\"raw\">" << endl << "   _";
+      for (auto & da : arrays)
+        {
+          out.write (reinterpret_cast<const char*> (&da->table[0]), sizeof(uint64_t) * da->table.Size());
+          if (zlib)
+            out.write (da->packed.Size() ? &da->packed[0] : nullptr, da->packed.Size());
+          else
+            out.write (da->data, da->nbytes);
+        }
+      out << endl << "  </AppendedData>" << endl;
+    }
+
+  private:
+    void Compress (DataArray & da)
+    {
+#ifdef NGS_USE_ZLIB
+      size_t nblocks = (da.nbytes + blocksize - 1) / blocksize;
+      size_t bound = compressBound (blocksize);
+      da.table.SetSize (3+nblocks);
+      da.table[0] = nblocks;
+      da.table[1] = blocksize;
+      da.table[2] = nblocks ? da.nbytes - (nblocks-1) * blocksize : 0;
+
+      // blocks are compressed independently, in parallel
+      Array<char> tmp(nblocks * bound);
+      WriterFor (nblocks, parallel, [&] (size_t i)
+                 {
+                   size_t n = min2 (blocksize, da.nbytes - i * blocksize);
+                   uLongf len = bound;
+                   if (compress2 (reinterpret_cast<Bytef*> (&tmp[i*bound]), &len,
+                                  reinterpret_cast<const Bytef*> (da.data + i*blocksize), n,
+                                  Z_BEST_SPEED) != Z_OK)
+                     throw Exception ("VTKOutput: zlib compression failed");
+                   da.table[3+i] = len;
+                 });
+
+      size_t total = 0;
+      for (size_t i = 0; i < nblocks; i++)
+        total += da.table[3+i];
+      da.packed.SetSize (total);
+      total = 0;
+      for (size_t i = 0; i < nblocks; i++)
         {
-          MappedIntegrationPoint<D,D> mip(ip, eltrans);
-          const int dim = coefs[i]->Dimension();
-          FlatVector<> tmp(dim,lh);
-          coefs[i]->Evaluate(mip,tmp);
-          for (int d = 0; d < dim; ++d)
-            value_field[i]->Append(tmp(d));
+          memcpy (&da.packed[total], &tmp[i*bound], da.table[3+i]);
+          total += da.table[3+i];
         }
+#else
+      throw Exception ("VTKOutput: compiled without zlib");
+#endif
+    }
+  };
+
+
+  template <int D>
+  void VTKOutput<D>::WriteVTU (const string & basename, bool parallel)
+  {
+    auto ptr = [] (auto & a) { return a.Size() ? (const void*)&a[0] : nullptr; };
+
+    MPI_Comm comm = ma->GetCommunicator();
+    int ntasks = MyMPI_GetNTasks (comm);
+    int id = MyMPI_GetId (comm);
+
+    // vtk points are always 3D
+    Array<Vec<3>> points3;
+    if (D != 3)
+      {
+        points3.SetSize (points.Size());
+        WriterFor (points.Size(), parallel, [&] (size_t i)
+                   {
+                     points3[i] = 0.0;
+                     for (int j = 0; j < D; j++)
+                       points3[i](j) = points[i](j);
+                   });
       }
-      
-      for ( auto elem : ref_elems)
+
+    Array<int> offsets(cells.Size());
+    size_t nconn = 0;
+    for (auto i : Range(cells))
+      offsets[i] = nconn += cells[i][0];
+    Array<int> connectivity(nconn);
+    WriterFor (cells.Size(), parallel, [&] (size_t i)
+               {
+                 int first = offsets[i] - cells[i][0];
+                 for (int j = 0; j < cells[i][0]; j++)
+                   connectivity[first+j] = cells[i][j+1];
+               });
+
+    VTUAppendedData appended(compress, parallel);
+    Array<string> fieldtags;
+    for (auto field : value_field)
+      fieldtags.Append (appended.Add ("Float64", field->Name(), field->Dimension(),
+                                      ptr(*field), sizeof(double) * field->Size()));
+    string pointtag = (D == 3) ?
+      appended.Add ("Float64", "", 3, ptr(points), sizeof(Vec<3>) * points.Size()) :
+      appended.Add ("Float64", "", 3, ptr(points3), sizeof(Vec<3>) * points3.Size());
+    string conntag = appended.Add ("Int32", "connectivity", 1, ptr(connectivity), sizeof(int) * nconn);
+    string offsettag = appended.Add ("Int32", "offsets", 1, ptr(offsets), sizeof(int) * offsets.Size());
+    string typetag = appended.Add ("UInt8", "types", 1, ptr(celltypes), celltypes.Size());
+
+    string header = string("<VTKFile type=\"%s\" version=\"1.0\" byte_order=\"LittleEndian\" header_type=\"UInt64\"")
+      + (compress ? " compressor=\"vtkZLibDataCompressor\"" : "") + ">";
+    auto vtkfile = [header] (string type)
       {
-        INT<ELEMENT_MAXPOINTS+1> new_elem = elem;
-        for (int i = 1; i <= new_elem[0]; ++i)
-          new_elem[i] += offset;
-        cells.Append(new_elem);
+        string h = header;
+        return h.replace (h.find("%s"), 2, type);
+      };
+
+    // one piece per rank, numbered by rank
+    string piecename = basename;
+    if (ntasks > 1)
+      piecename += "_" + ToString(id);
+
+    ofstream out(piecename + ".vtu", ios::binary);
+    out << "<?xml version=\"1.0\"?>" << endl
+        << vtkfile("UnstructuredGrid") << endl
+        << " <UnstructuredGrid>" << endl
+        << "  <Piece NumberOfPoints=\"" << points.Size() << "\" NumberOfCells=\"" << cells.Size() << "\">" << endl
+        << "   <PointData>" << endl;
+    for (auto & tag : fieldtags)
+      out << "    " << tag << endl;
+    out << "   </PointData>" << endl
+        << "   <Points>" << endl
+        << "    " << pointtag << endl
+        << "   </Points>" << endl
+        << "   <Cells>" << endl
+        << "    " << conntag << endl
+        << "    " << offsettag << endl
+        << "    " << typetag << endl
+        << "   </Cells>" << endl
+        << "  </Piece>" << endl
+        << " </UnstructuredGrid>" << endl;
+    appended.Write (out);
+    out << "</VTKFile>" << endl;
+
+    if (ntasks == 1 || id != 0) return;
+
+    // pieces are referenced relative to the master file
+    string source = basename.substr (basename.find_last_of('/')+1);
+    ofstream pout(basename + ".pvtu");
+    pout << "<?xml version=\"1.0\"?>" << endl
+         << vtkfile("PUnstructuredGrid") << endl
+         << " <PUnstructuredGrid GhostLevel=\"0\">" << endl
+         << "  <PPointData>" << endl;
+    for (auto field : value_field)
+      pout << "   <PDataArray type=\"Float64\" Name=\"" << field->Name()
+           << "\" NumberOfComponents=\"" << field->Dimension() << "\"/>" << endl;
+    pout << "  </PPointData>" << endl
+         << "  <PPoints>" << endl
+         << "   <PDataArray type=\"Float64\" NumberOfComponents=\"3\"/>" << endl
+         << "  </PPoints>" << endl
+         << "  <PCells>" << endl
+         << "   <PDataArray type=\"Int32\" Name=\"connectivity\" NumberOfComponents=\"1\"/>" << endl
+         << "   <PDataArray type=\"Int32\" Name=\"offsets\" NumberOfComponents=\"1\"/>" << endl
+         << "   <PDataArray type=\"UInt8\" Name=\"types\" NumberOfComponents=\"1\"/>" << endl
+         << "  </PCells>" << endl;
+    for (int i = 0; i < ntasks; i++)
+      pout << "  <Piece Source=\"" << source << "_" << i << ".vtu\"/>" << endl;
+    pout << " </PUnstructuredGrid>" << endl
+         << "</VTKFile>" << endl;
+  }
+
+
+  template <int D>
+  void VTKOutput<D>::Write (const string & basename, bool parallel)
+  {
+    if (!legacy)
+      {
+        WriteVTU (basename, parallel);
+        return;
       }
 
-    }
+    fileout = make_shared<ofstream>(basename + ".vtk");
+
+    // header:
+    *fileout << "# vtk DataFile Version 3.0" << endl;
+    *fileout << "vtk output" << endl;
+    *fileout << "ASCII" << endl;
+    *fileout << "DATASET UNSTRUCTURED_GRID" << endl;
 
     PrintPoints();
     PrintCells();
     PrintCellTypes();
     PrintFieldData();
-      
-    cout << " Done." << endl;
-  }    
+    fileout = nullptr;
+  }
+
+
+  template <int D>
+  void VTKOutput<D>::Do (LocalHeap & lh, const BitArray * drawelems)
+  {
+    static Timer t("VTKOutput::Write");
+    ostringstream filenamefinal;
+    filenamefinal << filename;
+    if (output_cnt > 0)
+      filenamefinal << "_" << output_cnt;
+    cout << " Writing VTK-Output";
+    if (output_cnt > 0)
+      cout << " ( " << output_cnt << " )";
+    cout << ":" << flush;
+
+    output_cnt++;
+
+    FillData (lh, drawelems);
+
+    if (!background)
+      {
+        RegionTimer reg(t);
+        Write (filenamefinal.str(), true);
+        cout << " Done." << endl;
+        return;
+      }
+
+    // double buffering: the buffer is free once the previous output is written
+    writer.Wait();
+    if (!buffer)
+      buffer = make_shared<VTKOutput<D>> (ma, coefs, fieldnames, filename,
+                                          subdivision, only_element, legacy, compress);
+    points.Swap (buffer->points);
+    cells.Swap (buffer->cells);
+    celltypes.Swap (buffer->celltypes);
+    value_field.Swap (buffer->value_field);
+
+    auto buf = buffer;
+    string basename = filenamefinal.str();
+    writer.Submit ([buf, basename] () { buf->Write (basename, false); });
+    cout << " Started." << endl;
+  }
 
   NumProcVTKOutput::NumProcVTKOutput (shared_ptr<PDE> apde, const Flags & flags)
     : NumProc (apde)
@@ -31,6 +31,10 @@ namespace ngcomp
   public:
     virtual ~BaseVTKOutput() { ; }
     virtual void Do (LocalHeap & lh, const BitArray * drawelems = 0) = 0;
+    /// waits until output written in the background is finished
+    virtual void Wait () { ; }
+    /// time of the next output, used by time-series formats
+    virtual void SetTime (double atime) { ; }
   };
   
   template <int D> 
@@ -44,22 +48,39 @@ namespace ngcomp
     string filename;
     int subdivision;
     int only_element = -1;
+    /// legacy ASCII .vtk, or XML .vtu with appended binary data
+    bool legacy = true;
+    /// zlib compression of the binary arrays (vtu only)
+    bool compress = false;
+    /// formatting and writing on a background thread
+    bool background = false;
 
     Array<shared_ptr<ValueField>> value_field;
     Array<Vec<D>> points;
     Array<INT<ELEMENT_MAXPOINTS+1>> cells;
+    Array<unsigned char> celltypes;
+
+    /// subdivided reference elements by element type, points also as SIMD rule
+    Array<IntegrationPoint> ref_vertices[ET_HEX+1];
+    Array<INT<ELEMENT_MAXPOINTS+1>> ref_elems[ET_HEX+1];
+    shared_ptr<SIMD_IntegrationRule> simd_ref_vertices[ET_HEX+1];
 
     int output_cnt = 0;
     
     shared_ptr<ofstream> fileout;
-    
+
+    /// second set of arrays, written by the background thread
+    shared_ptr<VTKOutput<D>> buffer;
+    AsyncWriter writer;
+
   public:
 
     VTKOutput (const Array<shared_ptr<CoefficientFunction>> &,
                const Flags &,shared_ptr<MeshAccess>);
 
     VTKOutput (shared_ptr<MeshAccess>, const Array<shared_ptr<CoefficientFunction>> &,
-               const Array<string> &, string, int, int);
+               const Array<string> &, string, int, int,
+               bool alegacy = true, bool acompress = false, bool abackground = false);
     virtual ~VTKOutput() { ; }
     
     void ResetArrays();
@@ -75,7 +96,15 @@ namespace ngcomp
     void PrintCellTypes();
     void PrintFieldData();    
 
+    /// points, cells and field values of all drawn elements, thread-parallel
+    void FillData (LocalHeap & lh, const BitArray * drawelems);
+    /// legacy or vtu output of the current arrays, parallel = false on the background thread
+    void Write (const string & basename, bool parallel);
+    /// writes basename.vtu, or one piece per rank and basename.pvtu
+    void WriteVTU (const string & basename, bool parallel);
+
     virtual void Do (LocalHeap & lh, const BitArray * drawelems = 0);
+    virtual void Wait () { writer.Wait(); }
   };
 
 
@@ -0,0 +1,281 @@
+/*********************************************************************/
+/* File:   xdmfoutput.cpp                                            */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+#include <comp.hpp>
+
+#ifdef NGS_HDF5
+#include <hdf5.h>
+#endif
+
+namespace ngcomp
+{
+
+  template <int D>
+  XDMFOutput<D>::XDMFOutput (shared_ptr<MeshAccess> ama,
+                             const Array<shared_ptr<CoefficientFunction>> & a_coefs,
+                             const Array<string> & a_field_names,
+                             string a_filename, int a_subdivision, int a_only_element,
+                             bool adeflate)
+    : VTKOutput<D> (ama, a_coefs, a_field_names, a_filename, a_subdivision, a_only_element),
+      deflate(adeflate)
+  {
+#ifndef NGS_HDF5
+    throw Exception ("XDMFOutput: ngsolve was compiled without HDF5 (USE_HDF5)");
+#endif
+  }
+
+
+#ifdef NGS_HDF5
+
+  /// XDMF type of a sub-cell, from its VTK type
+  static int64_t XDMFCellType (unsigned char vtktype)
+  {
+    switch (vtktype)
+      {
+      case 5: return 4;    // triangle
+      case 9: return 5;    // quadrilateral
+      case 10: return 6;   // tetrahedron
+      case 12: return 9;   // hexahedron
+      case 13: return 8;   // wedge
+      default:
+        throw Exception ("XDMFOutput: cell type " + ToString(int(vtktype)) + " not supported");
+      }
+  }
+
+  /// opens the HDF5 file, with the MPI-IO driver for distributed meshes
+  static hid_t OpenH5File (const string & h5name, bool create, MPI_Comm comm)
+  {
+    hid_t fapl = H5Pcreate (H5P_FILE_ACCESS);
+    if (MyMPI_GetNTasks (comm) > 1)
+      {
+#if defined(PARALLEL) && defined(H5_HAVE_PARALLEL)
+        H5Pset_fapl_mpio (fapl, comm, MPI_INFO_NULL);
+#else
+        H5Pclose (fapl);
+        throw Exception ("XDMFOutput: HDF5 without MPI support, no parallel output");
+#endif
+      }
+    hid_t file = create ?
+      H5Fcreate (h5name.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, fapl) :
+      H5Fopen (h5name.c_str(), H5F_ACC_RDWR, fapl);
+    H5Pclose (fapl);
+    if (file < 0)
+      throw Exception ("XDMFOutput: cannot open " + h5name);
+    return file;
+  }
+
+  /*
+    Creates the dataset name of size total x ncomp and writes the rows
+    [first, first+n) of this rank. Parallel files are written
+    collectively, all ranks have to call it.
+  */
+  static void WriteH5Dataset (hid_t file, const string & name, hid_t type,
+                              const void * data, size_t n, size_t ncomp,
+                              size_t first, size_t total, bool deflate, bool collective)
+  {
+    hsize_t dims[2] = { total, ncomp };
+    hid_t filespace = H5Screate_simple (2, dims, nullptr);
+
+    hid_t lcpl = H5Pcreate (H5P_LINK_CREATE);
+    H5Pset_create_intermediate_group (lcpl, 1);
+    hid_t dcpl = H5Pcreate (H5P_DATASET_CREATE);
+    if (deflate && total > 0)
+      {
+        hsize_t chunk[2] = { min2 (hsize_t(total), hsize_t(1) << 16), ncomp };
+        H5Pset_chunk (dcpl, 2, chunk);
+        H5Pset_deflate (dcpl, 1);
+      }
+    hid_t dset = H5Dcreate2 (file, name.c_str(), type, filespace, lcpl, dcpl, H5P_DEFAULT);
+    H5Pclose (dcpl);
+    H5Pclose (lcpl);
+    if (dset < 0)
+      {
+        H5Sclose (filespace);
+        throw Exception ("XDMFOutput: cannot create dataset " + name);
+      }
+
+    hsize_t start[2] = { first, 0 };
+    hsize_t count[2] = { n, ncomp };
+    hid_t memspace = H5Screate_simple (2, count, nullptr);
+    if (n > 0)
+      H5Sselect_hyperslab (filespace, H5S_SELECT_SET, start, nullptr, count, nullptr);
+    else
+      {
+        H5Sselect_none (filespace);
+        H5Sselect_none (memspace);
+      }
+
+    hid_t dxpl = H5Pcreate (H5P_DATASET_XFER);
+#ifdef H5_HAVE_PARALLEL
+    if (collective)
+      H5Pset_dxpl_mpio (dxpl, H5FD_MPIO_COLLECTIVE);
+#endif
+    // ranks without data still need a buffer
+    double dummy = 0;
+    herr_t err = H5Dwrite (dset, type, memspace, filespace, dxpl, n ? data : &dummy);
+
+    H5Pclose (dxpl);
+    H5Sclose (memspace);
+    H5Sclose (filespace);
+    H5Dclose (dset);
+    if (err < 0)
+      throw Exception ("XDMFOutput: cannot write dataset " + name);
+  }
+
+#endif
+
+
+  template <int D>
+  void XDMFOutput<D>::Do (LocalHeap & lh, const BitArray * drawelems)
+  {
+#ifdef NGS_HDF5
+    static Timer t("XDMFOutput::Do"); RegionTimer reg(t);
+
+    auto ptr = [] (auto & a) { return a.Size() ? (const void*)&a[0] : nullptr; };
+
+    MPI_Comm comm = ma->GetCommunicator();
+    int ntasks = MyMPI_GetNTasks (comm);
+    bool collective = ntasks > 1;
+    int step = times.Size();
+
+    cout << " Writing XDMF-Output ( " << step << " ):" << flush;
+
+    this->FillData (lh, drawelems);
+
+    size_t ntopo = 0;
+    for (auto & c : cells)
+      ntopo += c[0]+1;
+
+    // the points and cells of a rank follow the ones of lower ranks
+    size_t local[3] = { points.Size(), cells.Size(), ntopo };
+    size_t first[3] = { 0, 0, 0 };
+    size_t total[3] = { local[0], local[1], local[2] };
+#ifdef PARALLEL
+    if (collective)
+      {
+        MPI_Exscan (local, first, 3, MyGetMPIType<size_t>(), MPI_SUM, comm);
+        if (MyMPI_GetId (comm) == 0)
+          first[0] = first[1] = first[2] = 0;
+        MPI_Allreduce (local, total, 3, MyGetMPIType<size_t>(), MPI_SUM, comm);
+      }
+#endif
+
+    bool newmesh = !mesh_sizes.Size() || ma->GetTimeStamp() != mesh_timestamp ||
+      written_points != local[0] || written_cells != local[1];
+    if (collective)
+      newmesh = MyMPI_AllReduce (int(newmesh), MPI_MAX, comm);
+
+    hid_t file = OpenH5File (filename + ".h5", step == 0, comm);
+    try
+      {
+        if (newmesh)
+          {
+            string group = "/mesh" + ToString(mesh_sizes.Size());
+
+            // xdmf points are always 3D
+            Array<Vec<3>> points3(points.Size());
+            ParallelFor (points.Size(), [&] (size_t i)
+                         {
+                           points3[i] = 0.0;
+                           for (int j = 0; j < D; j++)
+                             points3[i](j) = points[i](j);
+                         });
+            WriteH5Dataset (file, group+"/points", H5T_NATIVE_DOUBLE, ptr(points3),
+                            local[0], 3, first[0], total[0], deflate, collective);
+
+            // mixed topology: cell type followed by global point numbers
+            Array<int64_t> topology(ntopo);
+            size_t pos = 0;
+            for (auto i : Range(cells))
+              {
+                topology[pos++] = XDMFCellType (celltypes[i]);
+                for (int j = 1; j <= cells[i][0]; j++)
+                  topology[pos++] = first[0] + cells[i][j];
+              }
+            WriteH5Dataset (file, group+"/topology", H5T_NATIVE_INT64, ptr(topology),
+                            local[2], 1, first[2], total[2], deflate, collective);
+
+            mesh_sizes.Append (INT<3,size_t> (total[0], total[1], total[2]));
+            mesh_timestamp = ma->GetTimeStamp();
+            written_points = local[0];
+            written_cells = local[1];
+          }
+
+        for (auto field : value_field)
+          WriteH5Dataset (file, "/step" + ToString(step) + "/" + field->Name(),
+                          H5T_NATIVE_DOUBLE, ptr(*field), local[0], field->Dimension(),
+                          first[0], total[0], deflate, collective);
+      }
+    catch (...)
+      {
+        H5Fclose (file);
+        throw;
+      }
+    H5Fclose (file);
+
+    times.Append (time_set ? time : step);
+    step_mesh.Append (mesh_sizes.Size()-1);
+    time_set = false;
+    if (MyMPI_GetId (comm) == 0)
+      WriteXDMF();
+
+    cout << " Done." << endl;
+#endif
+  }
+
+
+  template <int D>
+  void XDMFOutput<D>::WriteXDMF () const
+  {
+    // datasets are referenced relative to the xml file
+    string h5name = filename.substr (filename.find_last_of('/')+1) + ".h5";
+
+    ofstream out(filename + ".xdmf");
+    out.precision (16);
+    out << "<?xml version=\"1.0\"?>" << endl
+        << "<Xdmf Version=\"3.0\">" << endl
+        << " <Domain>" << endl
+        << "  <Grid Name=\"TimeSeries\" GridType=\"Collection\" CollectionType=\"Temporal\">" << endl;
+
+    for (auto step : Range(times))
+      {
+        int version = step_mesh[step];
+        auto sizes = mesh_sizes[version];
+        string mesh = h5name + ":/mesh" + ToString(version);
+
+        out << "   <Grid Name=\"step" << step << "\" GridType=\"Uniform\">" << endl
+            << "    <Time Value=\"" << times[step] << "\"/>" << endl
+            << "    <Topology TopologyType=\"Mixed\" NumberOfElements=\"" << sizes[1] << "\">" << endl
+            << "     <DataItem Dimensions=\"" << sizes[2] << "\" NumberType=\"Int\" Precision=\"8\" Format=\"HDF\">"
+            << mesh << "/topology</DataItem>" << endl
+            << "    </Topology>" << endl
+            << "    <Geometry GeometryType=\"XYZ\">" << endl
+            << "     <DataItem Dimensions=\"" << sizes[0] << " 3\" NumberType=\"Float\" Precision=\"8\" Format=\"HDF\">"
+            << mesh << "/points</DataItem>" << endl
+            << "    </Geometry>" << endl;
+
+        for (auto field : value_field)
+          {
+            int dim = field->Dimension();
+            string type = (dim == 1) ? "Scalar" : (dim == 3) ? "Vector" : (dim == 9) ? "Tensor" : "Matrix";
+            out << "    <Attribute Name=\"" << field->Name() << "\" AttributeType=\"" << type
+                << "\" Center=\"Node\">" << endl
+                << "     <DataItem Dimensions=\"" << sizes[0] << " " << dim
+                << "\" NumberType=\"Float\" Precision=\"8\" Format=\"HDF\">"
+                << h5name << ":/step" << step << "/" << field->Name() << "</DataItem>" << endl
+                << "    </Attribute>" << endl;
+          }
+        out << "   </Grid>" << endl;
+      }
+
+    out << "  </Grid>" << endl
+        << " </Domain>" << endl
+        << "</Xdmf>" << endl;
+  }
+
+
+  template class XDMFOutput<2>;
+  template class XDMFOutput<3>;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+/*********************************************************************/
+/* File:   xdmfoutput.hpp                                            */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+namespace ngcomp
+{
+
+  /**
+     Time series in XDMF format, the heavy data is stored in one HDF5
+     file. Points and subdivided cells are written once per mesh (again
+     only if the mesh or the drawn elements change), every Do appends
+     the field values of one step as chunked, deflate-compressed
+     datasets. Under MPI all ranks write their part of the global
+     datasets with parallel HDF5.
+  */
+  template <int D>
+  class XDMFOutput : public VTKOutput<D>
+  {
+  protected:
+    using VTKOutput<D>::ma;
+    using VTKOutput<D>::filename;
+    using VTKOutput<D>::value_field;
+    using VTKOutput<D>::points;
+    using VTKOutput<D>::cells;
+    using VTKOutput<D>::celltypes;
+
+    bool deflate;
+    double time = 0;
+    bool time_set = false;
+
+    Array<double> times;
+    /// mesh version of every step
+    Array<int> step_mesh;
+    /// global number of points, cells and topology entries per mesh version
+    Array<INT<3,size_t>> mesh_sizes;
+    /// local sizes and mesh timestamp of the last mesh version
+    size_t mesh_timestamp = 0;
+    size_t written_points = 0, written_cells = 0;
+
+  public:
+    XDMFOutput (shared_ptr<MeshAccess>, const Array<shared_ptr<CoefficientFunction>> &,
+                const Array<string> &, string, int, int, bool adeflate = true);
+
+    /// time of the next step, the step number if not set
+    virtual void SetTime (double atime) override { time = atime; time_set = true; }
+
+    virtual void Do (LocalHeap & lh, const BitArray * drawelems = 0) override;
+
+  protected:
+    /// the xml file, rewritten after every step
+    void WriteXDMF () const;
+  };
+
+}
@@ -26,7 +26,47 @@ namespace ngfem
       BO
     };
   }
-  
+
+
+  /*
+    SIMD version of the B-matrix of one element side: normal derivatives
+    and values of the shape functions in the points of the facet rule.
+    ComputeNormalsAndMeasure must have been called for mir.
+  */
+  template <int D>
+  static void CalcSIMDFacetBMat (const ScalarFiniteElement<D> & fel,
+                                 const SIMD_MappedIntegrationRule<D,D> & mir,
+                                 SliceMatrix<SIMD<double>> dudn,
+                                 SliceMatrix<SIMD<double>> shape,
+                                 LocalHeap & lh)
+  {
+    HeapReset hr(lh);
+    size_t nd = fel.GetNDof();
+    FlatMatrix<SIMD<double>> dshape(D*nd, mir.Size(), lh);
+    fel.CalcShape (mir.IR(), shape);
+    fel.CalcMappedDShape (mir, dshape);
+    for (size_t i = 0; i < nd; i++)
+      for (size_t j = 0; j < mir.Size(); j++)
+        {
+          Vec<D,SIMD<double>> nv = mir[j].GetNV();
+          SIMD<double> sum = 0.0;
+          for (int k = 0; k < D; k++)
+            sum += dshape(D*i+k, j) * nv(k);
+          dudn(i,j) = sum;
+        }
+  }
+
+  /// normal derivative of the function given by the gradient
+  template <int D>
+  INLINE SIMD<double> SIMDNormalDerivative (FlatMatrix<SIMD<double>> grad, size_t j,
+                                            const SIMD<MappedIntegrationPoint<D,D>> & mip)
+  {
+    SIMD<double> sum = 0.0;
+    for (int k = 0; k < D; k++)
+      sum += grad(k,j) * mip.GetNV()(k);
+    return sum;
+  }
+
   template <int D, DG_FORMULATIONS::DGTYPE dgtype>
   class DGInnerFacet_LaplaceIntegrator : public FacetBilinearFormIntegrator
   {
@@ -73,6 +113,22 @@ namespace ngfem
       if (LocalFacetNr2==-1) throw Exception("DGFacetLaplaceIntegrator: LocalFacetNr2==1");
 
       NgProfiler::RegionTimer reg (timer);
+
+      if (simd_evaluate)
+        try
+          {
+            CalcFacetMatrixSIMD (volumefel1, LocalFacetNr1, eltrans1, ElVertices1,
+                                 volumefel2, LocalFacetNr2, eltrans2, ElVertices2,
+                                 elmat, lh);
+            return;
+          }
+        catch (ExceptionNOSIMD e)
+          {
+            cout << IM(6) << "caught in DGInnerFacet_LaplaceIntegrator: " << endl
+                 << e.What() << endl;
+            simd_evaluate = false;
+          }
+
       const ScalarFiniteElement<D> * fel1_l2 = 
         dynamic_cast<const ScalarFiniteElement<D>*> (&volumefel1);
       ELEMENT_TYPE eltype1 = volumefel1.ElementType();
@@ -188,6 +244,182 @@ namespace ngfem
 	}
 	if (LocalFacetNr2==-1) elmat=0.0;
       }
+
+    virtual void ApplyFacetMatrix (const FiniteElement & volumefel1, int LocalFacetNr1,
+                                   const ElementTransformation & eltrans1, FlatArray<int> & ElVertices1,
+                                   const FiniteElement & volumefel2, int LocalFacetNr2,
+                                   const ElementTransformation & eltrans2, FlatArray<int> & ElVertices2,
+                                   FlatVector<double> elx, FlatVector<double> ely,
+                                   LocalHeap & lh) const
+    {
+      static Timer t("DGInnerFacet_LaplaceIntegrator::Apply", 2);
+      RegionTimer reg(t);
+
+      if (simd_evaluate)
+        try
+          {
+            ApplyFacetMatrixSIMD (volumefel1, LocalFacetNr1, eltrans1, ElVertices1,
+                                  volumefel2, LocalFacetNr2, eltrans2, ElVertices2,
+                                  elx, ely, lh);
+            return;
+          }
+        catch (ExceptionNOSIMD e)
+          {
+            cout << IM(6) << "caught in DGInnerFacet_LaplaceIntegrator::Apply: " << endl
+                 << e.What() << endl;
+            simd_evaluate = false;
+          }
+
+      HeapReset hr(lh);
+      FlatMatrix<> elmat(elx.Size(), lh);
+      CalcFacetMatrix (volumefel1, LocalFacetNr1, eltrans1, ElVertices1,
+                       volumefel2, LocalFacetNr2, eltrans2, ElVertices2,
+                       elmat, lh);
+      ely = elmat * elx;
+    }
+
+  protected:
+    // coefficients of the D-matrix, dmat(1,1) is pen*len/det
+    double Penalty (int maxorder) const
+    {
+      if (dgtype == DG_FORMULATIONS::BO) return 0;
+      return alpha * (maxorder+1.0)*(maxorder+D)/D;
+    }
+
+    void CalcFacetMatrixSIMD (const FiniteElement & volumefel1, int LocalFacetNr1,
+                              const ElementTransformation & eltrans1, FlatArray<int> & ElVertices1,
+                              const FiniteElement & volumefel2, int LocalFacetNr2,
+                              const ElementTransformation & eltrans2, FlatArray<int> & ElVertices2,
+                              FlatMatrix<double> elmat,
+                              LocalHeap & lh) const
+    {
+      HeapReset hr(lh);
+      auto & fel1 = static_cast<const ScalarFiniteElement<D>&> (volumefel1);
+      auto & fel2 = static_cast<const ScalarFiniteElement<D>&> (volumefel2);
+      ELEMENT_TYPE eltype1 = volumefel1.ElementType();
+      ELEMENT_TYPE eltype2 = volumefel2.ElementType();
+      int nd1 = fel1.GetNDof();
+      int nd2 = fel2.GetNDof();
+      int maxorder = max2(fel1.Order(), fel2.Order());
+      ELEMENT_TYPE etfacet = ElementTopology::GetFacetType (eltype1, LocalFacetNr1);
+
+      const SIMD_IntegrationRule & simd_ir_facet = GetSIMDIntegrationRule (etfacet, 2*maxorder);
+      if (maxorder==0) maxorder=1;
+      double pen = Penalty (maxorder);
+      double d01 = (dgtype == DG_FORMULATIONS::IP) ? -1 : 1;
+
+      Facet2ElementTrafo transform1(eltype1, ElVertices1); 
+      Facet2ElementTrafo transform2(eltype2, ElVertices2); 
+      auto & simd_mir1 = static_cast<SIMD_MappedIntegrationRule<D,D>&>
+        (eltrans1(transform1(LocalFacetNr1, simd_ir_facet, lh), lh));
+      auto & simd_mir2 = static_cast<SIMD_MappedIntegrationRule<D,D>&>
+        (eltrans2(transform2(LocalFacetNr2, simd_ir_facet, lh), lh));
+      simd_mir1.ComputeNormalsAndMeasure (eltype1, LocalFacetNr1);
+      simd_mir2.ComputeNormalsAndMeasure (eltype2, LocalFacetNr2);
+
+      size_t nip = simd_ir_facet.Size();
+      FlatMatrix<SIMD<double>> lam(1, nip, lh);
+      coef_lam -> Evaluate (simd_mir1, lam);
+
+      // rows of the B-matrix: average normal derivative and jump
+      FlatMatrix<SIMD<double>> bmat0(nd1+nd2, nip, lh), bmat1(nd1+nd2, nip, lh);
+      FlatMatrix<SIMD<double>> dbmat0(nd1+nd2, nip, lh), dbmat1(nd1+nd2, nip, lh);
+      CalcSIMDFacetBMat (fel1, simd_mir1, bmat0.Rows(0, nd1), bmat1.Rows(0, nd1), lh);
+      CalcSIMDFacetBMat (fel2, simd_mir2, bmat0.Rows(nd1, nd1+nd2), bmat1.Rows(nd1, nd1+nd2), lh);
+
+      for (size_t j = 0; j < nip; j++)
+        {
+          SIMD<double> len = simd_mir1[j].GetMeasure();
+          SIMD<double> fac = lam(0,j) * len * simd_ir_facet[j].Weight();
+          SIMD<double> d11 = pen * len / simd_mir1[j].GetJacobiDet();
+          for (int i = 0; i < nd1; i++)
+            bmat0(i,j) *= 0.5;
+          for (int i = nd1; i < nd1+nd2; i++)
+            {
+              bmat0(i,j) *= -0.5;
+              bmat1(i,j) = -bmat1(i,j);
+            }
+          for (int i = 0; i < nd1+nd2; i++)
+            {
+              dbmat0(i,j) = fac * (d01 * bmat1(i,j));
+              dbmat1(i,j) = fac * (d11 * bmat1(i,j) - bmat0(i,j));
+            }
+        }
+
+      elmat = 0.0;
+      AddABt (bmat0, dbmat0, elmat);
+      AddABt (bmat1, dbmat1, elmat);
+    }
+
+    void ApplyFacetMatrixSIMD (const FiniteElement & volumefel1, int LocalFacetNr1,
+                               const ElementTransformation & eltrans1, FlatArray<int> & ElVertices1,
+                               const FiniteElement & volumefel2, int LocalFacetNr2,
+                               const ElementTransformation & eltrans2, FlatArray<int> & ElVertices2,
+                               FlatVector<double> elx, FlatVector<double> ely,
+                               LocalHeap & lh) const
+    {
+      HeapReset hr(lh);
+      auto & fel1 = static_cast<const ScalarFiniteElement<D>&> (volumefel1);
+      auto & fel2 = static_cast<const ScalarFiniteElement<D>&> (volumefel2);
+      ELEMENT_TYPE eltype1 = volumefel1.ElementType();
+      ELEMENT_TYPE eltype2 = volumefel2.ElementType();
+      int nd1 = fel1.GetNDof();
+      int nd2 = fel2.GetNDof();
+      int maxorder = max2(fel1.Order(), fel2.Order());
+      ELEMENT_TYPE etfacet = ElementTopology::GetFacetType (eltype1, LocalFacetNr1);
+
+      const SIMD_IntegrationRule & simd_ir_facet = GetSIMDIntegrationRule (etfacet, 2*maxorder);
+      if (maxorder==0) maxorder=1;
+      double pen = Penalty (maxorder);
+      double d01 = (dgtype == DG_FORMULATIONS::IP) ? -1 : 1;
+
+      Facet2ElementTrafo transform1(eltype1, ElVertices1); 
+      Facet2ElementTrafo transform2(eltype2, ElVertices2); 
+      auto & simd_mir1 = static_cast<SIMD_MappedIntegrationRule<D,D>&>
+        (eltrans1(transform1(LocalFacetNr1, simd_ir_facet, lh), lh));
+      auto & simd_mir2 = static_cast<SIMD_MappedIntegrationRule<D,D>&>
+        (eltrans2(transform2(LocalFacetNr2, simd_ir_facet, lh), lh));
+      simd_mir1.ComputeNormalsAndMeasure (eltype1, LocalFacetNr1);
+      simd_mir2.ComputeNormalsAndMeasure (eltype2, LocalFacetNr2);
+
+      size_t nip = simd_ir_facet.Size();
+      FlatMatrix<SIMD<double>> lam(1, nip, lh);
+      coef_lam -> Evaluate (simd_mir1, lam);
+
+      FlatVector<SIMD<double>> u1(nip, lh), u2(nip, lh);
+      FlatMatrix<SIMD<double>> grad1(D, nip, lh), grad2(D, nip, lh);
+      fel1.Evaluate (simd_mir1.IR(), elx.Range(0, nd1), u1);
+      fel2.Evaluate (simd_mir2.IR(), elx.Range(nd1, nd1+nd2), u2);
+      fel1.EvaluateGrad (simd_mir1, elx.Range(0, nd1), grad1);
+      fel2.EvaluateGrad (simd_mir2, elx.Range(nd1, nd1+nd2), grad2);
+
+      for (size_t j = 0; j < nip; j++)
+        {
+          SIMD<double> len = simd_mir1[j].GetMeasure();
+          SIMD<double> fac = lam(0,j) * len * simd_ir_facet[j].Weight();
+          SIMD<double> d11 = pen * len / simd_mir1[j].GetJacobiDet();
+
+          SIMD<double> b0 = 0.5 * (SIMDNormalDerivative (grad1, j, simd_mir1[j])
+                                   - SIMDNormalDerivative (grad2, j, simd_mir2[j]));
+          SIMD<double> b1 = u1(j) - u2(j);
+          SIMD<double> db0 = fac * (d01 * b1);
+          SIMD<double> db1 = fac * (d11 * b1 - b0);
+
+          u1(j) = db1;
+          u2(j) = -db1;
+          for (int k = 0; k < D; k++)
+            {
+              grad1(k,j) = 0.5 * db0 * simd_mir1[j].GetNV()(k);
+              grad2(k,j) = -0.5 * db0 * simd_mir2[j].GetNV()(k);
+            }
+        }
+
+      ely = 0.0;
+      fel1.AddTrans (simd_mir1.IR(), u1, ely.Range(0, nd1));
+      fel2.AddTrans (simd_mir2.IR(), u2, ely.Range(nd1, nd1+nd2));
+      fel1.AddGradTrans (simd_mir1, grad1, ely.Range(0, nd1));
+      fel2.AddGradTrans (simd_mir2, grad2, ely.Range(nd1, nd1+nd2));
+    }
   };
 
 
@@ -554,6 +786,20 @@ namespace ngfem
     {
       static int timer = NgProfiler::CreateTimer ("DGBoundaryFacet_LaplaceIntegrator boundary");
       NgProfiler::RegionTimer reg (timer);
+
+      if (simd_evaluate)
+        try
+          {
+            CalcFacetMatrixSIMD (volumefel, LocalFacetNr, eltrans, ElVertices, elmat, lh);
+            return;
+          }
+        catch (ExceptionNOSIMD e)
+          {
+            cout << IM(6) << "caught in DGBoundaryFacet_LaplaceIntegrator: " << endl
+                 << e.What() << endl;
+            simd_evaluate = false;
+          }
+
       const ScalarFiniteElement<D> * fel1_l2 = 
         dynamic_cast<const ScalarFiniteElement<D>*> (&volumefel);
       ELEMENT_TYPE eltype1 = volumefel.ElementType();
@@ -641,6 +887,140 @@ namespace ngfem
 	  elmat += Trans (bmat) * dbmat;
 	}
       }
+
+    virtual void ApplyFacetMatrix (const FiniteElement & volumefel, int LocalFacetNr,
+                                   const ElementTransformation & eltrans, FlatArray<int> & ElVertices,
+                                   const ElementTransformation & seltrans, FlatArray<int> & SElVertices,
+                                   FlatVector<double> elx, FlatVector<double> ely,
+                                   LocalHeap & lh) const
+    {
+      static Timer t("DGBoundaryFacet_LaplaceIntegrator::Apply", 2);
+      RegionTimer reg(t);
+
+      if (simd_evaluate)
+        try
+          {
+            ApplyFacetMatrixSIMD (volumefel, LocalFacetNr, eltrans, ElVertices, elx, ely, lh);
+            return;
+          }
+        catch (ExceptionNOSIMD e)
+          {
+            cout << IM(6) << "caught in DGBoundaryFacet_LaplaceIntegrator::Apply: " << endl
+                 << e.What() << endl;
+            simd_evaluate = false;
+          }
+
+      HeapReset hr(lh);
+      FlatMatrix<> elmat(elx.Size(), lh);
+      CalcFacetMatrix (volumefel, LocalFacetNr, eltrans, ElVertices,
+                       seltrans, SElVertices, elmat, lh);
+      ely = elmat * elx;
+    }
+
+  protected:
+    // coefficients of the D-matrix, dmat(1,1) is pen*len/det
+    double Penalty (int maxorder) const
+    {
+      if (dgtype == DG_FORMULATIONS::BO) return 0;
+      return alpha * (maxorder+1.0)*(maxorder+D)/D;
+    }
+
+    void CalcFacetMatrixSIMD (const FiniteElement & volumefel, int LocalFacetNr,
+                              const ElementTransformation & eltrans, FlatArray<int> & ElVertices,
+                              FlatMatrix<double> elmat,
+                              LocalHeap & lh) const
+    {
+      HeapReset hr(lh);
+      auto & fel = static_cast<const ScalarFiniteElement<D>&> (volumefel);
+      ELEMENT_TYPE eltype = volumefel.ElementType();
+      int nd = fel.GetNDof();
+      int maxorder = fel.Order();
+      ELEMENT_TYPE etfacet = ElementTopology::GetFacetType (eltype, LocalFacetNr);
+
+      const SIMD_IntegrationRule & simd_ir_facet = GetSIMDIntegrationRule (etfacet, 2*maxorder);
+      if (maxorder==0) maxorder=1;
+      double pen = Penalty (maxorder);
+      double d01 = (dgtype == DG_FORMULATIONS::IP) ? -1 : 1;
+
+      Facet2ElementTrafo transform(eltype, ElVertices); 
+      auto & simd_mir = static_cast<SIMD_MappedIntegrationRule<D,D>&>
+        (eltrans(transform(LocalFacetNr, simd_ir_facet, lh), lh));
+      simd_mir.ComputeNormalsAndMeasure (eltype, LocalFacetNr);
+
+      size_t nip = simd_ir_facet.Size();
+      FlatMatrix<SIMD<double>> lam(1, nip, lh);
+      coef_lam -> Evaluate (simd_mir, lam);
+
+      FlatMatrix<SIMD<double>> bmat0(nd, nip, lh), bmat1(nd, nip, lh);
+      FlatMatrix<SIMD<double>> dbmat0(nd, nip, lh), dbmat1(nd, nip, lh);
+      CalcSIMDFacetBMat (fel, simd_mir, bmat0, bmat1, lh);
+
+      for (size_t j = 0; j < nip; j++)
+        {
+          SIMD<double> len = simd_mir[j].GetMeasure();
+          SIMD<double> fac = lam(0,j) * len * simd_ir_facet[j].Weight();
+          SIMD<double> d11 = pen * len / simd_mir[j].GetJacobiDet();
+          for (int i = 0; i < nd; i++)
+            {
+              dbmat0(i,j) = fac * (d01 * bmat1(i,j));
+              dbmat1(i,j) = fac * (d11 * bmat1(i,j) - bmat0(i,j));
+            }
+        }
+
+      elmat = 0.0;
+      AddABt (bmat0, dbmat0, elmat);
+      AddABt (bmat1, dbmat1, elmat);
+    }
+
+    void ApplyFacetMatrixSIMD (const FiniteElement & volumefel, int LocalFacetNr,
+                               const ElementTransformation & eltrans, FlatArray<int> & ElVertices,
+                               FlatVector<double> elx, FlatVector<double> ely,
+                               LocalHeap & lh) const
+    {
+      HeapReset hr(lh);
+      auto & fel = static_cast<const ScalarFiniteElement<D>&> (volumefel);
+      ELEMENT_TYPE eltype = volumefel.ElementType();
+      int maxorder = fel.Order();
+      ELEMENT_TYPE etfacet = ElementTopology::GetFacetType (eltype, LocalFacetNr);
+
+      const SIMD_IntegrationRule & simd_ir_facet = GetSIMDIntegrationRule (etfacet, 2*maxorder);
+      if (maxorder==0) maxorder=1;
+      double pen = Penalty (maxorder);
+      double d01 = (dgtype == DG_FORMULATIONS::IP) ? -1 : 1;
+
+      Facet2ElementTrafo transform(eltype, ElVertices); 
+      auto & simd_mir = static_cast<SIMD_MappedIntegrationRule<D,D>&>
+        (eltrans(transform(LocalFacetNr, simd_ir_facet, lh), lh));
+      simd_mir.ComputeNormalsAndMeasure (eltype, LocalFacetNr);
+
+      size_t nip = simd_ir_facet.Size();
+      FlatMatrix<SIMD<double>> lam(1, nip, lh);
+      coef_lam -> Evaluate (simd_mir, lam);
+
+      FlatVector<SIMD<double>> u(nip, lh);
+      FlatMatrix<SIMD<double>> grad(D, nip, lh);
+      fel.Evaluate (simd_mir.IR(), elx, u);
+      fel.EvaluateGrad (simd_mir, elx, grad);
+
+      for (size_t j = 0; j < nip; j++)
+        {
+          SIMD<double> len = simd_mir[j].GetMeasure();
+          SIMD<double> fac = lam(0,j) * len * simd_ir_facet[j].Weight();
+          SIMD<double> d11 = pen * len / simd_mir[j].GetJacobiDet();
+
+          SIMD<double> b0 = SIMDNormalDerivative (grad, j, simd_mir[j]);
+          SIMD<double> db0 = fac * (d01 * u(j));
+          SIMD<double> db1 = fac * (d11 * u(j) - b0);
+
+          u(j) = db1;
+          for (int k = 0; k < D; k++)
+            grad(k,j) = db0 * simd_mir[j].GetNV()(k);
+        }
+
+      ely = 0.0;
+      fel.AddTrans (simd_mir.IR(), u, ely);
+      fel.AddGradTrans (simd_mir, grad, ely);
+    }
   };
   
   
@@ -3,11 +3,19 @@
 #include<l2hofe_impl.hpp>
 #include<l2hofefo.hpp>
 #include<regex>
+#include<set>
+#include<thread>
+#include<atomic>
+#include<sys/stat.h>
+#ifdef WIN32
+#include<direct.h>
+#include<process.h>
+#else
+#include<unistd.h>
+#endif
 
 namespace ngfem
 {
-    atomic<unsigned> Code::id_counter{0};
-
     void Code::AddLinkFlag(string flag)
     {
         if(std::find(std::begin(link_flags), std::end(link_flags), flag) == std::end(link_flags))
@@ -16,64 +24,282 @@ namespace ngfem
 
     string Code::AddPointer(const void *p)
     {
-        string name = "compiled_code_pointer" + ToString(id_counter++); 
-        top += "extern \"C\" void* " + name + ";\n";
-        stringstream s_ptr;
+        // names only depend on the position in the code, so the same
+        // expression gives the same code (and cache key) in every run
+        string name = "compiled_code_pointer" + prefix + ToString(deriv) + (is_simd ? "_simd_" : "_")
+          + ToString(pointers.size());
 #ifdef WIN32
-        s_ptr << "0x";
+        top += "__declspec(dllexport) ";
 #endif
-        s_ptr << std::hex << p;
-        pointer += "void *" + name + " = reinterpret_cast<void*>(" + s_ptr.str() + ");\n";
+        top += "void* " + name + " = nullptr;\n";
+        pointers.emplace_back(name, p);
         return name;
     }
 
+    void SetPointers (SharedLibrary & library, const std::vector<std::pair<string,const void*>> & pointers)
+    {
+      for (auto & p : pointers)
+        *library.GetFunction<const void**>(p.first) = p.second;
+    }
+
+    namespace
+    {
+      // FNV-1a, std::hash is not guaranteed to be stable between runs
+      string HashString (const string & str)
+      {
+        uint64_t hash = 14695981039346656037ull;
+        for (unsigned char c : str)
+          {
+            hash ^= c;
+            hash *= 1099511628211ull;
+          }
+        stringstream ss;
+        ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+        return ss.str();
+      }
+
+      bool FileExists (const string & filename)
+      {
+        ifstream f(filename);
+        return f.good();
+      }
+
+      bool MakeDirectories (const string & path)
+      {
+        for (size_t pos = path.find_first_of("/\\", 1); ; pos = path.find_first_of("/\\", pos+1))
+          {
+            string dir = path.substr(0, pos);
+#ifdef WIN32
+            _mkdir(dir.c_str());
+#else
+            mkdir(dir.c_str(), 0755);
+#endif
+            if (pos == string::npos) break;
+          }
+        struct stat info;
+        return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFDIR);
+      }
+
+      string GetCompileCacheDir ()
+      {
+        if (getenv("NGSOLVE_NO_COMPILE_CACHE"))
+          return "";
+        string dir;
+        if (const char * env = getenv("NGSOLVE_CACHE_DIR"))
+          dir = env;
+#ifdef WIN32
+        else if (const char * env = getenv("LOCALAPPDATA"))
+          dir = string(env) + "\\ngsolve\\compiled_cf";
+#else
+        else if (const char * env = getenv("XDG_CACHE_HOME"))
+          dir = string(env) + "/ngsolve/compiled_cf";
+        else if (const char * env = getenv("HOME"))
+          dir = string(env) + "/.cache/ngsolve/compiled_cf";
+#endif
+        if (dir.empty() || !MakeDirectories(dir))
+          return "";
+        return dir;
+      }
+
+      bool CompilerAvailable ()
+      {
+#ifdef WIN32
+        static bool available = system("cmd /C \"where ngscxx.bat > NUL 2>&1\"") == 0;
+#else
+        static bool available = system("ngscxx --version > /dev/null 2>&1") == 0;
+#endif
+        return available;
+      }
+
+      int GetProcessId ()
+      {
+#ifdef WIN32
+        return _getpid();
+#else
+        return getpid();
+#endif
+      }
+
+      // the same library must not be loaded twice into a process, since
+      // the runtime pointers live in its data segment
+      unique_ptr<SharedLibrary> LoadCompiledLibrary (const string & lib_name)
+      {
+        static std::mutex loaded_mutex;
+        static std::set<string> loaded;
+        static int copy_counter = 0;
+
+        string load_name = lib_name;
+        {
+          lock_guard<mutex> guard(loaded_mutex);
+          if (loaded.count(lib_name))
+            load_name = lib_name + "." + ToString(GetProcessId()) + "_" + ToString(copy_counter++);
+          else
+            loaded.insert(lib_name);
+        }
+
+        auto library = make_unique<SharedLibrary>();
+        if (load_name == lib_name)
+          library->Load(lib_name);
+        else
+          {
+            {
+              ifstream src(lib_name, std::ios::binary);
+              ofstream dst(load_name, std::ios::binary);
+              dst << src.rdbuf();
+            }
+            library->Load(load_name);
+#ifndef WIN32
+            std::remove(load_name.c_str());
+#endif
+          }
+        return library;
+      }
+    }
+
     unique_ptr<SharedLibrary> CompileCode(const std::vector<string> &codes, const std::vector<string> &link_flags )
     {
       static int counter = 0;
       static ngstd::Timer tcompile("CompiledCF::Compile");
       static ngstd::Timer tlink("CompiledCF::Link");
-      string object_files;
-      int i = 0;
+
+      // a rebuilt NGSolve may change flags, headers and class layouts
+      stringstream build_key;
+      build_key << "simd=" << SIMD<double>::Size() << '\0';
+#ifdef _MSC_FULL_VER
+      build_key << "msc=" << _MSC_FULL_VER << '\0';
+#else
+      build_key << "compiler=" << __VERSION__ << '\0';
+#endif
+      build_key << "build=" << __DATE__ << " " << __TIME__ << '\0';
+
+      string cache_dir = GetCompileCacheDir();
+      string lib_name;
+      if (cache_dir.size())
+        {
+          stringstream key;
+          for (auto & code : codes)
+            key << code << '\0';
+          for (auto & flag : link_flags)
+            key << flag << '\0';
+          key << build_key.str();
+#ifdef WIN32
+          lib_name = cache_dir + "\\cf_" + HashString(key.str()) + ".dll";
+#else
+          lib_name = cache_dir + "/cf_" + HashString(key.str()) + ".so";
+#endif
+          if (FileExists(lib_name))
+            {
+              cout << IM(3) << "loading cached library " << lib_name << endl;
+              return LoadCompiledLibrary(lib_name);
+            }
+        }
+
+      if (!CompilerAvailable())
+        {
+          cout << IM(1) << "WARNING: no compiler (ngscxx) available and library not cached, "
+               << "CoefficientFunction is not compiled" << endl;
+          return nullptr;
+        }
+
       string prefix = "code" + ToString(counter++);
-      for(string code : codes) {
-        string file_prefix = prefix+"_"+ToString(i++);
-        ofstream codefile(file_prefix+".cpp");
-        codefile << code;
-        codefile.close();
-        cout << IM(3) << "compiling..." << endl;
-        tcompile.Start();
+#ifndef WIN32
+      // unique build files, many processes may share the cache
+      if (cache_dir.size())
+        prefix = lib_name + "_" + ToString(GetProcessId()) + "_" + prefix;
+#endif
+
+      // object files of unchanged codes are reused from the cache (not on
+      // Windows, where ngscxx.bat chooses the object name)
+      std::vector<string> object_names(codes.size());
+      std::vector<bool> cached_object(codes.size(), false);
+      for (auto i : Range(codes.size()))
+        {
+          string file_prefix = prefix+"_"+ToString(i);
+#ifdef WIN32
+          object_names[i] = file_prefix+".obj";
+#else
+          object_names[i] = file_prefix+".o";
+          if (cache_dir.size())
+            {
+              string obj_name = cache_dir + "/obj_" + HashString(codes[i] + '\0' + build_key.str()) + ".o";
+              if (FileExists(obj_name))
+                {
+                  object_names[i] = obj_name;
+                  cached_object[i] = true;
+                }
+            }
+#endif
+        }
+
+      // the translation units are independent, compile them in parallel
+      cout << IM(3) << "compiling..." << endl;
+      tcompile.Start();
+      std::atomic<size_t> next(0);
+      std::atomic<bool> failed(false);
+      auto compile_units = [&] ()
+        {
+          for (size_t i = next++; i < codes.size(); i = next++)
+            {
+              if (cached_object[i]) continue;
+              string file_prefix = prefix+"_"+ToString(i);
+              {
+                ofstream codefile(file_prefix+".cpp");
+                codefile << codes[i];
+              }
 #ifdef WIN32
-        string scompile = "cmd /C \"ngscxx.bat " + file_prefix + ".cpp\"";
-        object_files += file_prefix+".obj ";
+              string scompile = "cmd /C \"ngscxx.bat " + file_prefix + ".cpp\"";
 #else
-        string scompile = "ngscxx -c " + file_prefix + ".cpp -o " + file_prefix + ".o";
-        object_files += file_prefix+".o ";
+              string scompile = "ngscxx -c " + file_prefix + ".cpp -o " + file_prefix + ".o";
 #endif
-        int err = system(scompile.c_str());
-        if (err) throw Exception ("problem calling compiler");
-        tcompile.Stop();
-      }
+              if (system(scompile.c_str()))
+                failed = true;
+#ifndef WIN32
+              else if (cache_dir.size())
+                {
+                  string obj_name = cache_dir + "/obj_" + HashString(codes[i] + '\0' + build_key.str()) + ".o";
+                  if (std::rename(object_names[i].c_str(), obj_name.c_str()) == 0)
+                    object_names[i] = obj_name;
+                }
+#endif
+            }
+        };
+      size_t nthreads = min(codes.size(), size_t(max(1u, std::thread::hardware_concurrency())));
+      std::vector<std::thread> threads;
+      for (size_t i = 1; i < nthreads; i++)
+        threads.emplace_back(compile_units);
+      compile_units();
+      for (auto & t : threads)
+        t.join();
+      tcompile.Stop();
+      if (failed) throw Exception ("problem calling compiler");
+
+      string object_files;
+      for (auto & name : object_names)
+        object_files += name + " ";
 
       cout << IM(3) << "linking..." << endl;
       tlink.Start();
 #ifdef WIN32
         string slink = "cmd /C \"ngsld.bat /OUT:" + prefix+".dll " + object_files + "\"";
+        string built_name = prefix+".dll";
 #else
         string slink = "ngsld -shared " + object_files + " -o " + prefix + ".so -lngstd -lngbla -lngfem";
         for (auto flag : link_flags)
             slink += " "+flag;
+        string built_name = (cache_dir.size() ? "" : "./") + prefix + ".so";
 #endif
       int err = system(slink.c_str());
       if (err) throw Exception ("problem calling linker");      
       tlink.Stop();
       cout << IM(3) << "done" << endl;
-      auto library = make_unique<SharedLibrary>();
-#ifdef WIN32
-      library->Load(prefix+".dll");
-#else
-      library->Load("./"+prefix+".so");
-#endif
-      return library;
+
+      if (cache_dir.size())
+        {
+          // rename is atomic, concurrent processes never see a partial library
+          if (std::rename(built_name.c_str(), lib_name.c_str()) == 0)
+            return LoadCompiledLibrary(lib_name);
+        }
+      return LoadCompiledLibrary(built_name);
     }
 
     namespace detail {
@@ -43,15 +43,18 @@ namespace ngfem
     string body;
     bool is_simd;
     int deriv;
+    // distinguishes the global names of several functions in one library
+    string prefix;
     std::vector<string> link_flags;
 
-    string pointer;
+    // runtime pointers used by the generated code, they are
+    // assigned after loading the library (see SetPointers)
+    std::vector<std::pair<string,const void*>> pointers;
 
     string AddPointer(const void *p );
 
     void AddLinkFlag(string flag);
 
-    static atomic<unsigned> id_counter;
     static string Map( string code, std::map<string,string> variables ) {
       for ( auto mapping : variables ) {
         string oldStr = '{'+mapping.first+'}';
@@ -174,7 +177,20 @@ namespace ngfem
     }
   }
 
+  /*
+    Compiles and links the codes to a shared library. The codes are
+    independent translation units, compiled in parallel. Libraries are cached
+    in a user cache directory ($NGSOLVE_CACHE_DIR, $XDG_CACHE_HOME/ngsolve
+    or ~/.cache/ngsolve), keyed by a hash of the codes, link flags, SIMD
+    width and NGSolve build. On a cache hit the library is loaded without
+    calling the compiler, object files of unchanged codes are reused as well.
+    Set NGSOLVE_NO_COMPILE_CACHE to disable the cache.
+    Returns nullptr if the library is not cached and no compiler is
+    available, e.g. on compute nodes using a cache filled on a login node.
+   */
   unique_ptr<SharedLibrary> CompileCode(const std::vector<string> &codes, const std::vector<string> &libraries );
+  /// assign the runtime pointers of the generated code
+  void SetPointers (SharedLibrary & library, const std::vector<std::pair<string,const void*>> & pointers);
   namespace detail {
       string GenerateL2ElementCode(int order);
   }
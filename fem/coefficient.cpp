@@ -273,7 +273,9 @@ namespace ngfem
 
   void ConstantCoefficientFunctionC :: GenerateCode(Code &code, FlatArray<int> inputs, int index) const
   {
-    code.body += Var(index).Assign(Var(val));
+    string type = code.is_simd ? "SIMD<Complex>" : "Complex";
+    code.body += Var(index).Declare(type);
+    code.body += Var(index).Assign(Var(val), false);
   }
 
 
@@ -379,6 +381,113 @@ namespace ngfem
   ~DomainConstantCoefficientFunction ()
   { ; }
 
+
+
+  QuadraturePointCoefficientFunction ::
+  QuadraturePointCoefficientFunction (int adim, size_t nelements, VorB avb)
+    : CoefficientFunctionNoDerivative(adim, false), vb(avb), data(nelements), nips(nelements)
+  {
+    nips = 0;
+  }
+
+  FlatMatrix<SIMD<double>> QuadraturePointCoefficientFunction ::
+  GetValues (ElementId ei, size_t nip)
+  {
+    if (ei.VB() != vb || ei.Nr() >= data.Size())
+      throw Exception ("QuadraturePointCF: element " + ToString(ei) + " out of range");
+    size_t nsimd = (nip+SIMD<double>::Size()-1) / SIMD<double>::Size();
+    auto & vals = data[ei.Nr()];
+    if (nips[ei.Nr()] != nip)
+      {
+        vals.SetSize (Dimension()*nsimd);
+        vals = SIMD<double>(0.0);
+        nips[ei.Nr()] = nip;
+      }
+    return FlatMatrix<SIMD<double>> (Dimension(), nsimd, vals.Addr(0));
+  }
+
+  void QuadraturePointCoefficientFunction ::
+  Set (const SIMD_BaseMappedIntegrationRule & mir, const CoefficientFunction & cf, LocalHeap & lh)
+  {
+    HeapReset hr(lh);
+    auto & trafo = mir.GetTransformation();
+    // evaluate first, cf may read the old values
+    FlatMatrix<SIMD<double>> newvals(Dimension(), mir.Size(), lh);
+    cf.Evaluate (mir, newvals);
+    GetValues (ElementId(trafo.VB(), trafo.GetElementNr()), mir.IR().GetNIP()) = newvals;
+  }
+
+  FlatMatrix<SIMD<double>> QuadraturePointCoefficientFunction ::
+  ElementValues (const ElementTransformation & trafo, size_t nip) const
+  {
+    size_t elnr = trafo.GetElementNr();
+    if (trafo.VB() != vb || elnr >= data.Size() || nips[elnr] == 0)
+      return FlatMatrix<SIMD<double>> (0, 0, nullptr);
+    if (nips[elnr] != nip)
+      throw Exception ("QuadraturePointCF: integration rule does not match the stored values, "
+                       "nip = " + ToString(nip) + ", stored = " + ToString(nips[elnr]));
+    return FlatMatrix<SIMD<double>> (Dimension(), data[elnr].Size()/Dimension(),
+                                     const_cast<SIMD<double>*>(&data[elnr][0]));
+  }
+
+  double QuadraturePointCoefficientFunction ::
+  Evaluate (const BaseMappedIntegrationPoint & ip) const
+  {
+    Vector<> res(Dimension());
+    Evaluate (ip, res);
+    return res(0);
+  }
+
+  void QuadraturePointCoefficientFunction ::
+  Evaluate (const BaseMappedIntegrationPoint & ip, FlatVector<> result) const
+  {
+    // the point does not know the size of its rule, only its number
+    auto & trafo = ip.GetTransformation();
+    size_t elnr = trafo.GetElementNr();
+    size_t nr = ip.IP().Nr();
+    if (trafo.VB() != vb || elnr >= nips.Size() || nips[elnr] == 0)
+      {
+        result = 0.0;
+        return;
+      }
+    if (nr >= nips[elnr])
+      throw Exception ("QuadraturePointCF: point number out of range");
+    auto vals = ElementValues (trafo, nips[elnr]);
+    constexpr size_t SW = SIMD<double>::Size();
+    for (size_t k = 0; k < Dimension(); k++)
+      result(k) = vals(k, nr/SW)[nr%SW];
+  }
+
+  void QuadraturePointCoefficientFunction ::
+  Evaluate (const BaseMappedIntegrationRule & ir, BareSliceMatrix<double> values) const
+  {
+    auto vals = ElementValues (ir.GetTransformation(), ir.Size());
+    if (vals.Height() == 0)
+      {
+        values.AddSize(ir.Size(), Dimension()) = 0.0;
+        return;
+      }
+    constexpr size_t SW = SIMD<double>::Size();
+    for (size_t i = 0; i < ir.Size(); i++)
+      for (size_t k = 0; k < Dimension(); k++)
+        values(i,k) = vals(k, i/SW)[i%SW];
+  }
+
+  void QuadraturePointCoefficientFunction ::
+  Evaluate (const SIMD_BaseMappedIntegrationRule & ir, BareSliceMatrix<SIMD<double>> values) const
+  {
+    auto vals = ElementValues (ir.GetTransformation(), ir.IR().GetNIP());
+    if (vals.Height() == 0)
+      values.AddSize(Dimension(), ir.Size()) = SIMD<double>(0.0);
+    else
+      values.AddSize(Dimension(), ir.Size()) = vals;
+  }
+
+  void QuadraturePointCoefficientFunction :: PrintReport (ostream & ost) const
+  {
+    ost << "QuadraturePointCF, dim = " << Dimension() << ", elements = " << data.Size() << endl;
+  }
+
   DomainVariableCoefficientFunction ::
   DomainVariableCoefficientFunction (const EvalFunction & afun)
     : CoefficientFunction(afun.Dimension(), afun.IsResultComplex()), fun(1)
@@ -639,6 +748,322 @@ void DomainVariableCoefficientFunction :: GenerateCode(Code &code, FlatArray<int
   code.body += "// DomainVariableCoefficientFunction: not implemented";
 }
 
+void DomainVariableCoefficientFunction ::
+Evaluate (const SIMD_BaseMappedIntegrationRule & ir, BareSliceMatrix<SIMD<double>> values) const
+{
+  size_t nip = ir.Size();
+  if (nip == 0) return;
+  int elind = ir.GetTransformation().GetElementIndex();
+  if (fun.Size() == 1) elind = 0;
+  if (fun[elind]->IsComplex())
+    throw ExceptionNOSIMD ("DomainVariableCoefficientFunction: no SIMD evaluation for complex functions");
+
+  // arguments of one point batch are contiguous: x, y, z, depends_on ...
+  STACK_ARRAY(SIMD<double>, mem, nip*numarg);
+  FlatMatrix<SIMD<double>> args(nip, numarg, &mem[0]);
+  args = SIMD<double>(0.0);
+
+  int dim = ir.DimSpace();
+  auto points = ir.GetPoints();
+  for (size_t i = 0; i < nip; i++)
+    for (int j = 0; j < dim; j++)
+      args(i,j) = points(i,j);
+
+  for (int i = 0, an = 3; i < depends_on.Size(); i++)
+    {
+      int dim = depends_on[i]->Dimension();
+      STACK_ARRAY(SIMD<double>, hmem, dim*nip);
+      FlatMatrix<SIMD<double>> hmat(dim, nip, &hmem[0]);
+      depends_on[i] -> Evaluate (ir, hmat);
+      args.Cols(an,an+dim) = Trans(hmat);
+      an += dim;
+    }
+
+  int rdim = Dimension();
+  STACK_ARRAY(SIMD<double>, hres, rdim);
+  for (size_t i = 0; i < nip; i++)
+    {
+      fun[elind]->Eval (&args(i,0), hres, rdim);
+      for (int j = 0; j < rdim; j++)
+        values(j,i) = hres[j];
+    }
+}
+
+shared_ptr<CoefficientFunction> DomainVariableCoefficientFunction :: GetCoefficientFunction () const
+{
+  Array<shared_ptr<CoefficientFunction>> args;
+  for (int i = 0; i < 3; i++)
+    args.Append (MakeCoordinateCoefficientFunction(i));
+  for (auto & cf : depends_on)
+    for (int j = 0; j < cf->Dimension(); j++)
+      args.Append (cf->Dimension() == 1 ? cf : MakeComponentCoefficientFunction(cf, j));
+
+  Array<shared_ptr<CoefficientFunction>> cfs(fun.Size());
+  for (int i = 0; i < fun.Size(); i++)
+    {
+      cfs[i] = EvalFunctionToCF (*fun[i], args);
+      if (!cfs[i]) return nullptr;
+    }
+  if (fun.Size() == 1) return cfs[0];
+  return MakeDomainWiseCoefficientFunction (move(cfs));
+}
+
+
+namespace evalfunc_cf
+{
+  /// reads a global (PDE-) variable at evaluation time
+  class GlobalVariableCoefficientFunction : public CoefficientFunctionNoDerivative
+  {
+    const double * val;
+  public:
+    GlobalVariableCoefficientFunction (const double * aval)
+      : CoefficientFunctionNoDerivative(1, false), val(aval) { ; }
+
+    using CoefficientFunction::Evaluate;
+    virtual double Evaluate (const BaseMappedIntegrationPoint & ip) const override
+    { return *val; }
+    virtual void Evaluate (const BaseMappedIntegrationRule & ir, BareSliceMatrix<double> values) const override
+    { values.AddSize(ir.Size(), 1) = *val; }
+    virtual void Evaluate (const SIMD_BaseMappedIntegrationRule & ir, BareSliceMatrix<SIMD<double>> values) const override
+    { values.AddSize(Dimension(), ir.Size()) = *val; }
+    virtual void PrintReport (ostream & ost) const override
+    { ost << "GlobalVariableCF, val = " << *val << endl; }
+
+    virtual void GenerateCode(Code &code, FlatArray<int> inputs, int index) const override
+    {
+      string type = "double";
+      if(code.is_simd) type = "SIMD<double>";
+      if(code.deriv==1) type = "AutoDiff<1,"+type+">";
+      if(code.deriv==2) type = "AutoDiffDiff<1,"+type+">";
+      stringstream s;
+      s << "*reinterpret_cast<const double*>(" << code.AddPointer(val) << ")";
+      code.body += Var(index).Declare(type);
+      code.body += Var(index).Assign(s.str(), false);
+    }
+  };
+
+  struct EvalSin {
+    template <typename T> T operator() (T x) const { return sin(x); }
+  };
+  struct EvalCos {
+    template <typename T> T operator() (T x) const { return cos(x); }
+  };
+  struct EvalTan {
+    template <typename T> T operator() (T x) const { return tan(x); }
+  };
+  struct EvalATan {
+    template <typename T> T operator() (T x) const { return atan(x); }
+  };
+  struct EvalExp {
+    template <typename T> T operator() (T x) const { return exp(x); }
+  };
+  struct EvalLog {
+    template <typename T> T operator() (T x) const { return log(x); }
+  };
+  struct EvalSqrt {
+    template <typename T> T operator() (T x) const { return sqrt(x); }
+  };
+}
+
+shared_ptr<CoefficientFunction>
+EvalFunctionToCF (const EvalFunction & fun, FlatArray<shared_ptr<CoefficientFunction>> args)
+{
+  using namespace evalfunc_cf;
+  typedef shared_ptr<CoefficientFunction> SPCF;
+  typedef EvalFunction EF;
+
+  auto C = [] (double val) -> SPCF { return make_shared<ConstantCoefficientFunction> (val); };
+  // truth values are 0 and 1, as in EvalFunction::Eval
+  double eps = 1e-14;
+  auto True = [&] (SPCF a) { return IfPos (a-C(eps), C(1), C(0)); };
+  auto Abs = [&] (SPCF a) { return IfPos (a, a, -1.0*a); };
+
+  auto program = fun.GetProgram();
+  size_t maxstack = 0;
+  for (auto & step : program)
+    maxstack += (step.op == EF::VARIABLE) ? step.vecdim : 1;
+  Array<SPCF> stack(maxstack);
+
+  int stacksize = -1;
+  for (int i = 0; i < program.Size(); i++)
+    {
+      auto & step = program[i];
+      switch (step.op)
+        {
+        case EF::ADD:
+          stack[stacksize-1] = stack[stacksize-1] + stack[stacksize];
+          stacksize--;
+          break;
+        case EF::SUB:
+          stack[stacksize-1] = stack[stacksize-1] - stack[stacksize];
+          stacksize--;
+          break;
+        case EF::MULT:
+          stack[stacksize-1] = stack[stacksize-1] * stack[stacksize];
+          stacksize--;
+          break;
+        case EF::DIV:
+          stack[stacksize-1] = stack[stacksize-1] / stack[stacksize];
+          stacksize--;
+          break;
+
+        case EF::VEC_ADD:
+          {
+            int dim = step.vecdim;
+            for (int j = 0; j < dim; j++)
+              stack[stacksize-2*dim+j+1] = stack[stacksize-2*dim+j+1] + stack[stacksize-dim+j+1];
+            stacksize -= dim;
+            break;
+          }
+        case EF::VEC_SUB:
+          {
+            int dim = step.vecdim;
+            for (int j = 0; j < dim; j++)
+              stack[stacksize-2*dim+j+1] = stack[stacksize-2*dim+j+1] - stack[stacksize-dim+j+1];
+            stacksize -= dim;
+            break;
+          }
+        case EF::SCAL_VEC_MULT:
+          {
+            int dim = step.vecdim;
+            SPCF scal = stack[stacksize-dim];
+            for (int j = 0; j < dim; j++)
+              stack[stacksize-dim+j] = scal * stack[stacksize-dim+j+1];
+            stacksize--;
+            break;
+          }
+        case EF::VEC_VEC_MULT:
+          {
+            int dim = step.vecdim;
+            SPCF scal = stack[stacksize-2*dim+1] * stack[stacksize-dim+1];
+            for (int j = 1; j < dim; j++)
+              scal = scal + stack[stacksize-2*dim+j+1] * stack[stacksize-dim+j+1];
+            stacksize -= 2*dim-1;
+            stack[stacksize] = scal;
+            break;
+          }
+        case EF::VEC_DIM:
+          {
+            int dim = program[i-1].vecdim;
+            stacksize -= dim-1;
+            stack[stacksize] = C(dim);
+            break;
+          }
+
+        case EF::NEG:
+          stack[stacksize] = -1.0 * stack[stacksize];
+          break;
+
+        case EF::AND:
+          stack[stacksize-1] = True(stack[stacksize-1]) * True(stack[stacksize]);
+          stacksize--;
+          break;
+        case EF::OR:
+          stack[stacksize-1] = IfPos (stack[stacksize-1]-C(eps), C(1), True(stack[stacksize]));
+          stacksize--;
+          break;
+        case EF::NOT:
+          stack[stacksize] = C(1) - True(stack[stacksize]);
+          break;
+        case EF::GREATER:
+          stack[stacksize-1] = IfPos (stack[stacksize-1]-stack[stacksize], C(1), C(0));
+          stacksize--;
+          break;
+        case EF::GREATEREQUAL:
+          stack[stacksize-1] = IfPos (stack[stacksize]-stack[stacksize-1], C(0), C(1));
+          stacksize--;
+          break;
+        case EF::EQUAL:
+          stack[stacksize-1] = IfPos (C(eps)-Abs(stack[stacksize-1]-stack[stacksize]), C(1), C(0));
+          stacksize--;
+          break;
+        case EF::LESSEQUAL:
+          stack[stacksize-1] = IfPos (stack[stacksize-1]-stack[stacksize], C(0), C(1));
+          stacksize--;
+          break;
+        case EF::LESS:
+          stack[stacksize-1] = IfPos (stack[stacksize]-stack[stacksize-1], C(1), C(0));
+          stacksize--;
+          break;
+
+        case EF::CONSTANT:
+          stack[++stacksize] = C(step.operand.val);
+          break;
+        case EF::VARIABLE:
+          for (int j = 0; j < step.vecdim; j++)
+            {
+              int nr = step.operand.varnum+j;
+              if (nr >= args.Size()) return nullptr;
+              stack[++stacksize] = args[nr];
+            }
+          break;
+        case EF::GLOBVAR:
+          stack[++stacksize] = make_shared<GlobalVariableCoefficientFunction> (step.operand.globvar);
+          break;
+        case EF::IMAG:
+          stack[++stacksize] = make_shared<ConstantCoefficientFunctionC> (Complex(0,1));
+          break;
+
+        case EF::SIN:
+          stack[stacksize] = UnaryOpCF (stack[stacksize], EvalSin(), "sin");
+          break;
+        case EF::COS:
+          stack[stacksize] = UnaryOpCF (stack[stacksize], EvalCos(), "cos");
+          break;
+        case EF::TAN:
+          stack[stacksize] = UnaryOpCF (stack[stacksize], EvalTan(), "tan");
+          break;
+        case EF::ATAN:
+          stack[stacksize] = UnaryOpCF (stack[stacksize], EvalATan(), "atan");
+          break;
+        case EF::EXP:
+          stack[stacksize] = UnaryOpCF (stack[stacksize], EvalExp(), "exp");
+          break;
+        case EF::LOG:
+          stack[stacksize] = UnaryOpCF (stack[stacksize], EvalLog(), "log");
+          break;
+        case EF::SQRT:
+          stack[stacksize] = UnaryOpCF (stack[stacksize], EvalSqrt(), "sqrt");
+          break;
+        case EF::ABS:
+          {
+            int dim = step.vecdim;
+            if (dim == 1)
+              stack[stacksize] = Abs (stack[stacksize]);
+            else
+              {
+                SPCF sum = stack[stacksize] * stack[stacksize];
+                for (int j = 1; j < dim; j++)
+                  sum = sum + stack[stacksize-j] * stack[stacksize-j];
+                stacksize -= dim-1;
+                stack[stacksize] = UnaryOpCF (sum, EvalSqrt(), "sqrt");
+              }
+            break;
+          }
+        case EF::SIGN:
+          stack[stacksize] = IfPos (stack[stacksize], C(1), IfPos (-1.0*stack[stacksize], C(-1), C(0)));
+          break;
+        case EF::STEP:
+          stack[stacksize] = IfPos (-1.0*stack[stacksize], C(0), C(1));
+          break;
+
+        case EF::COMMA:
+          break;
+
+        default:
+          // function pointers, atan2, Bessel functions, vector elements, generic variables
+          return nullptr;
+        }
+    }
+
+  if (fun.Dimension() == 1)
+    return stack[0];
+  Array<SPCF> comps(fun.Dimension());
+  for (int j = 0; j < comps.Size(); j++)
+    comps[j] = stack[j];
+  return MakeVectorialCoefficientFunction (move(comps));
+}
+
 /*
   template class DomainVariableCoefficientFunction<1>;
   template class DomainVariableCoefficientFunction<2>;
@@ -2796,6 +3221,78 @@ public:
 
 
 
+// per-domain values of a region-constant subtree, see SimplifySteps
+class DomainTableCoefficientFunction
+  : public T_CoefficientFunction<DomainTableCoefficientFunction, CoefficientFunctionNoDerivative>
+{
+  Array<double> val;
+  bool has_outside;   // value for domains beyond the table, as DomainWiseCF gives
+  double outside;
+  typedef T_CoefficientFunction<DomainTableCoefficientFunction, CoefficientFunctionNoDerivative> BASE;
+public:
+  DomainTableCoefficientFunction (const Array<double> & aval, bool ahas_outside, double aoutside)
+    : BASE(1, false), val(aval), has_outside(ahas_outside), outside(aoutside) { ; }
+
+  virtual int NumRegions () override { return val.Size(); }
+  virtual CF_Type GetType() const override { return CF_Type_domainconst; }
+
+  double Value (int elind) const
+  {
+    if (elind >= 0 && elind < val.Size())
+      return val[elind];
+    if (has_outside)
+      return outside;
+    throw Exception ("DomainTableCF: element index " + ToString(elind) +
+                     " out of range 0 - " + ToString(val.Size()-1));
+  }
+
+  using BASE::Evaluate;
+  virtual double Evaluate (const BaseMappedIntegrationPoint & ip) const override
+  { return Value (ip.GetTransformation().GetElementIndex()); }
+
+  template <typename MIR, typename T, ORDERING ORD>
+  void T_Evaluate (const MIR & ir, BareSliceMatrix<T,ORD> values) const
+  {
+    double v = Value (ir.GetTransformation().GetElementIndex());
+    size_t np = ir.Size();
+    for (size_t i = 0; i < np; i++)
+      values(0,i) = v;
+  }
+
+  template <typename MIR, typename T, ORDERING ORD>
+  void T_Evaluate (const MIR & ir,
+                   FlatArray<BareSliceMatrix<T,ORD>> input,
+                   BareSliceMatrix<T,ORD> values) const
+  { T_Evaluate (ir, values); }
+
+  virtual void GenerateCode(Code &code, FlatArray<int> inputs, int index) const override
+  {
+    string table = "tmp_" + ToLiteral(index);
+    code.header += "const double " + table + "["+ToLiteral(val.Size())+"] = {";
+    for (auto i : Range(val))
+      {
+        code.header += ToLiteral(val[i]);
+        if(i<val.Size()-1)
+          code.header += ", ";
+      }
+    code.header += "};\n";
+    string dom = table + "_domain";
+    string lookup = table + "[" + dom + "]";
+    if (has_outside)
+      lookup = "(" + dom + " >= 0 && " + dom + " < " + ToLiteral(int(val.Size())) + ") ? "
+        + lookup + " : " + ToLiteral(outside);
+    code.header += "int " + dom + " = mir.GetTransformation().GetElementIndex();\n";
+    code.header += Var(index).Assign(lookup);
+  }
+
+  virtual void PrintReport (ostream & ost) const override
+  {
+    ost << "DomainTableCF, val = " << val << endl;
+  }
+};
+
+
+
 
 
 
@@ -3099,8 +3596,10 @@ class IfPosCoefficientFunction : public T_CoefficientFunction<IfPosCoefficientFu
     void GenerateCode(Code &code, FlatArray<int> inputs, int index) const override
     {
       auto var_if = Var(inputs[0]);
+      // a complex branch makes the result complex
+      string type = "decltype(decltype("+Var(inputs[1]).S()+")()+decltype("+Var(inputs[2]).S()+")())";
       TraverseDimensions( cf_then->Dimensions(), [&](int ind, int i, int j) {
-          code.body += Var(index,i,j).Declare("decltype("+Var(inputs[1]).S()+")");
+          code.body += Var(index,i,j).Declare(type);
       });
       if(code.is_simd) {
         TraverseDimensions( cf_then->Dimensions(), [&](int ind, int i, int j) {
@@ -3624,6 +4123,119 @@ shared_ptr<CoefficientFunction> MakeCoordinateCoefficientFunction (int comp)
 }
 
 
+// ////////////////////////// BSpline CF ////////////////////////
+
+  class BSplineCoefficientFunction
+    : public T_CoefficientFunction<BSplineCoefficientFunction>
+  {
+    shared_ptr<BSpline> sp;
+    shared_ptr<CoefficientFunction> c1;
+    typedef T_CoefficientFunction<BSplineCoefficientFunction> BASE;
+
+    template <typename T>
+    T Apply (T x) const { return (*sp)(x); }
+    SIMD<Complex> Apply (SIMD<Complex> x) const
+    { throw Exception ("BSplineCF: complex arguments not supported"); }
+  public:
+    BSplineCoefficientFunction (shared_ptr<BSpline> asp, shared_ptr<CoefficientFunction> ac1)
+      : BASE(ac1->Dimension(), false), sp(asp), c1(ac1)
+    {
+      SetDimensions (c1->Dimensions());
+    }
+
+    virtual string GetDescription () const override
+    {
+      return "bspline";
+    }
+
+    virtual void TraverseTree (const function<void(CoefficientFunction&)> & func) override
+    {
+      c1->TraverseTree (func);
+      func(*this);
+    }
+
+    virtual Array<shared_ptr<CoefficientFunction>> InputCoefficientFunctions() const override
+    { return Array<shared_ptr<CoefficientFunction>>({ c1 }); }
+
+    virtual void GenerateCode(Code &code, FlatArray<int> inputs, int index) const override
+    {
+      // the B-spline is called through its pointer, for all the
+      // (SIMD-, AutoDiff-) types of the generated code
+      string spline = "(*reinterpret_cast<const ngstd::BSpline*>(" + code.AddPointer(sp.get()) + "))";
+      TraverseDimensions( Dimensions(), [&](int ind, int i, int j) {
+          int i1, j1;
+          GetIndex( c1->Dimensions(), ind, i1, j1 );
+          code.body += Var(index,i,j).Assign( CodeExpr(spline + "(" + Var(inputs[0],i1,j1).S() + ")") );
+        });
+    }
+
+    using BASE::Evaluate;
+    virtual double Evaluate (const BaseMappedIntegrationPoint & ip) const override
+    {
+      return (*sp)(c1->Evaluate(ip));
+    }
+
+    template <typename MIR, typename T, ORDERING ORD>
+    void T_Evaluate (const MIR & ir, BareSliceMatrix<T,ORD> values) const
+    {
+      c1->Evaluate (ir, values);
+      size_t dim = Dimension();
+      size_t np = ir.Size();
+      for (size_t i = 0; i < dim; i++)
+        for (size_t j = 0; j < np; j++)
+          values(i,j) = Apply (values(i,j));
+    }
+
+    template <typename MIR, typename T, ORDERING ORD>
+    void T_Evaluate (const MIR & ir,
+                     FlatArray<BareSliceMatrix<T,ORD>> input,                       
+                     BareSliceMatrix<T,ORD> values) const
+    {
+      auto in0 = input[0];
+      size_t dim = Dimension();
+      size_t np = ir.Size();
+      for (size_t i = 0; i < dim; i++)
+        for (size_t j = 0; j < np; j++)
+          values(i,j) = Apply (in0(i,j));
+    }
+
+    virtual void NonZeroPattern (const class ProxyUserData & ud,
+                                 FlatVector<bool> nonzero,
+                                 FlatVector<bool> nonzero_deriv,
+                                 FlatVector<bool> nonzero_dderiv) const override
+    {
+      size_t dim = Dimension();
+      Vector<bool> v1(dim), d1(dim), dd1(dim);
+      c1->NonZeroPattern(ud, v1, d1, dd1);
+      for (size_t i = 0; i < dim; i++)
+        {
+          nonzero(i) = v1(i);
+          nonzero_deriv(i) = d1(i);
+          nonzero_dderiv(i) = d1(i) || dd1(i);
+        }
+    }
+
+    virtual void NonZeroPattern (const class ProxyUserData & ud,
+                                 FlatArray<FlatVector<AutoDiffDiff<1,bool>>> input,
+                                 FlatVector<AutoDiffDiff<1,bool>> values) const override
+    {
+      auto v1 = input[0];
+      for (size_t i = 0; i < values.Size(); i++)
+        {
+          values[i].Value() = v1[i].Value();
+          values[i].DValue(0) = v1[i].DValue(0);
+          values[i].DDValue(0) = v1[i].DValue(0) || v1[i].DDValue(0);
+        }
+    }
+  };
+
+shared_ptr<CoefficientFunction>
+MakeBSplineCoefficientFunction (shared_ptr<BSpline> sp, shared_ptr<CoefficientFunction> c1)
+{
+  return make_shared<BSplineCoefficientFunction> (sp, c1);
+}
+
+
   // ///////////////////////////// Compiled CF /////////////////////////
   class CompiledCoefficientFunction : public CoefficientFunction, public std::enable_shared_from_this<CompiledCoefficientFunction>
   {
@@ -3644,8 +4256,13 @@ shared_ptr<CoefficientFunction> MakeCoordinateCoefficientFunction (int comp)
     Array<int> dim;
     int totdim;
     Array<bool> is_complex;
+    // constants created by SimplifySteps
+    Array<shared_ptr<CoefficientFunction>> folded_cfs;
+    // fused s*v+b steps (inputs s, v, b), see FuseSteps
+    Array<INT<3>> muladd;
+    Array<bool> fused_away;
     // Array<Timer*> timers;
-    unique_ptr<SharedLibrary> library;
+    shared_ptr<SharedLibrary> library;
     lib_function compiled_function = nullptr;
     lib_function_simd compiled_function_simd = nullptr;
     lib_function_deriv compiled_function_deriv = nullptr;
@@ -3695,37 +4312,385 @@ shared_ptr<CoefficientFunction> MakeCoordinateCoefficientFunction (int comp)
                  inputs.Add (mypos, steps.Pos(incf.get()));
              }
          });
+      SimplifySteps();
+      FuseSteps();
       cout << IM(3) << "inputs = " << endl << inputs << endl;
 
     }
 
+    /*
+      Detects x = s*v + b with scalar s, where the product is used
+      only by the sum. The interpreted evaluation then computes x in
+      one loop and skips the product and its temporary.
+    */
+    void FuseSteps()
+    {
+      muladd.SetSize(steps.Size());
+      muladd = INT<3>(-1);
+      fused_away.SetSize(steps.Size());
+      fused_away = false;
+
+      Array<int> uses(steps.Size());
+      uses = 0;
+      for (size_t i = 0; i < steps.Size(); i++)
+        for (int j : inputs[i])
+          uses[j]++;
+
+      auto is_scalar = [&] (int j)
+        { return !steps[j]->IsComplex() && steps[j]->Dimensions().Size() == 0; };
+      
+      for (size_t i = 0; i < steps.Size(); i++)
+        {
+          if (steps[i]->GetType() != CF_Type_add || steps[i]->IsComplex()) continue;
+          auto in = inputs[i];
+          if (in.Size() != 2) continue;
+          for (int k = 0; k < 2; k++)
+            {
+              int a = in[k], b = in[1-k];
+              if (steps[a]->GetType() != CF_Type_mult || uses[a] != 1 || fused_away[a]) continue;
+              if (inputs[a].Size() != 2 || !is_scalar(inputs[a][0])) continue;
+              int v = inputs[a][1];
+              auto dims = steps[i]->Dimensions();
+              if (steps[v]->IsComplex() || steps[b]->IsComplex() ||
+                  !(steps[a]->Dimensions() == dims) || !(steps[v]->Dimensions() == dims) ||
+                  !(steps[b]->Dimensions() == dims))
+                continue;
+              muladd[i] = INT<3> (inputs[a][0], v, b);
+              fused_away[a] = true;
+              break;
+            }
+        }
+    }
+
+    /*
+      Rewrites the step graph:
+      - constant scalar subtrees of arithmetic operations are folded
+        into ConstantCoefficientFunctions
+      - x+0, x-0, 1*x and x*1 are replaced by x, 0*x by 0
+      - identical steps are merged (hash-consing). Steps are compared by
+        the code they generate with canonical inputs, so steps holding
+        runtime data (pointers) are only merged with themselves.
+    */
+    void SimplifySteps()
+    {
+      auto is_const = [&] (int i, double val)
+        {
+          return steps[i]->GetType() == CF_Type_constant && steps[i]->EvaluateConst() == val;
+        };
+      auto is_arithmetic = [] (CF_Type type)
+        {
+          switch (type)
+            {
+            case CF_Type_add: case CF_Type_sub: case CF_Type_mult: case CF_Type_div:
+            case CF_Type_scale: case CF_Type_unary_op: case CF_Type_binary_op:
+              return true;
+            default:
+              return false;
+            }
+        };
+      auto same_shape = [&] (int i, int j)
+        {
+          return steps[i]->IsComplex() == steps[j]->IsComplex() && 
+            steps[i]->Dimensions() == steps[j]->Dimensions();
+        };
+      
+      IntegrationPoint ip(0,0,0,0);
+      FE_ElementTransformation<1,1> trafo(ET_SEGM);
+      MappedIntegrationPoint<1,1> mip(ip, trafo);
+
+      // reference trafo of a given domain, for evaluating per-domain tables
+      struct DomainTrafo : public FE_ElementTransformation<1,1>
+      {
+        DomainTrafo () : FE_ElementTransformation<1,1>(ET_SEGM) { ; }
+        void SetDomain (int domain) { elindex = domain; }
+      };
+      DomainTrafo domain_trafo;
+      MappedIntegrationPoint<1,1> domain_mip(ip, domain_trafo);
+
+      // number of domains a step is constant on: -1 not region-constant,
+      // 0 constant everywhere, >0 a per-domain table
+      Array<int> regions(steps.Size());
+      
+      Array<int> rep(steps.Size());
+      Array<Array<int>> newinputs(steps.Size());
+      std::map<string,int> keys;
+      for (size_t i = 0; i < steps.Size(); i++)
+        {
+          rep[i] = i;
+          for (int j : inputs[i])
+            newinputs[i].Append (rep[j]);
+          FlatArray<int> in = newinputs[i];
+          CF_Type type = steps[i]->GetType();
+
+          // hoist region-constant subtrees, e.g. arithmetic on
+          // CoefficientFunction([1,2,3]), into one lookup table
+          regions[i] = -1;
+          bool real_scalar = !steps[i]->IsComplex() && steps[i]->Dimension() == 1;
+          if (type == CF_Type_constant && real_scalar)
+            regions[i] = 0;
+          else if (type == CF_Type_domainconst)
+            regions[i] = steps[i]->NumRegions();
+          else if ((is_arithmetic(type) || type == CF_Type_domainwise) && in.Size() && real_scalar &&
+                   (type != CF_Type_domainwise || steps[i]->InputCoefficientFunctions().Size() == in.Size()))
+            {
+              int nr = (type == CF_Type_domainwise) ? in.Size() : 0;
+              for (int j : in)
+                nr = (nr == -1 || regions[j] == -1) ? -1 : max(nr, regions[j]);
+              if (nr > 0)
+                try
+                  {
+                    Array<double> table(nr);
+                    for (int d : Range(nr))
+                      {
+                        domain_trafo.SetDomain(d);
+                        table[d] = steps[i]->Evaluate(domain_mip);
+                      }
+                    // DomainWiseCF is zero beyond its list, DomainConstantCF throws
+                    bool has_outside = true;
+                    double outside = 0;
+                    try
+                      {
+                        domain_trafo.SetDomain(nr);
+                        outside = steps[i]->Evaluate(domain_mip);
+                      }
+                    catch (Exception & e)
+                      { has_outside = false; }
+                    folded_cfs.Append (make_shared<DomainTableCoefficientFunction> (table, has_outside, outside));
+                    steps[i] = folded_cfs.Last().get();
+                    newinputs[i].SetSize0();
+                    type = CF_Type_domainconst;
+                    regions[i] = nr;
+                  }
+                catch (Exception & e)
+                  { ; }   // e.g. a table shorter than nr, keep the step
+            }
+
+          if (is_arithmetic(type) && in.Size() && !steps[i]->IsComplex() && steps[i]->Dimension() == 1)
+            {
+              bool allconst = true;
+              for (int j : in)
+                allconst &= steps[j]->GetType() == CF_Type_constant;
+              if (allconst)
+                {
+                  folded_cfs.Append (make_shared<ConstantCoefficientFunction> (steps[i]->Evaluate(mip)));
+                  steps[i] = folded_cfs.Last().get();
+                  newinputs[i].SetSize0();
+                  type = CF_Type_constant;
+                }
+            }
+
+          if (in.Size() == 2)
+            {
+              int other = -1;
+              if (type == CF_Type_add)
+                {
+                  if (is_const(in[0],0)) other = in[1];
+                  else if (is_const(in[1],0)) other = in[0];
+                }
+              if (type == CF_Type_sub && is_const(in[1],0))
+                other = in[0];
+              if (type == CF_Type_mult)
+                {
+                  if (is_const(in[0],1)) other = in[1];
+                  else if (is_const(in[1],1)) other = in[0];
+                  else if ((is_const(in[0],0) || is_const(in[1],0)) && 
+                           !steps[i]->IsComplex() && steps[i]->Dimension() == 1 && steps[i]->Dimensions().Size() == 0)
+                    {
+                      folded_cfs.Append (make_shared<ConstantCoefficientFunction> (0));
+                      steps[i] = folded_cfs.Last().get();
+                      newinputs[i].SetSize0();
+                    }
+                }
+              if (other != -1 && same_shape(i, other))
+                {
+                  rep[i] = other;
+                  continue;
+                }
+            }
+
+          string key;
+          try
+            {
+              Code code;
+              code.is_simd = false;
+              code.deriv = 0;
+              steps[i]->GenerateCode(code, newinputs[i], 0);
+              stringstream str;
+              str << typeid(*steps[i]).name() << ' ' << steps[i]->IsComplex() << ' '
+                  << steps[i]->Dimensions() << '\n' << code.top << code.header << code.body;
+              for (auto & p : code.pointers)
+                str << p.second << ' ';
+              key = str.str();
+            }
+          catch (Exception & e)
+            {
+              continue;   // no code, keep the step
+            }
+          auto pos = keys.find(key);
+          if (pos != keys.end())
+            rep[i] = pos->second;
+          else
+            keys[key] = i;
+        }
+
+      // keep the steps needed by the root, in topological order
+      Array<bool> needed(steps.Size());
+      needed = false;
+      needed[rep.Last()] = true;
+      for (int i = steps.Size()-1; i >= 0; i--)
+        if (needed[i])
+          for (int j : newinputs[i])
+            needed[j] = true;
+      
+      Array<int> newnr(steps.Size());
+      Array<CoefficientFunction*> newsteps;
+      for (size_t i = 0; i < steps.Size(); i++)
+        if (needed[i])
+          {
+            newnr[i] = newsteps.Size();
+            newsteps.Append (steps[i]);
+          }
+      if (newsteps.Size() < steps.Size())
+        cout << IM(3) << "simplified CF from " << steps.Size() << " to " << newsteps.Size() << " steps" << endl;
+
+      inputs = DynamicTable<int> (newsteps.Size());
+      dim.SetSize0();
+      is_complex.SetSize0();
+      max_inputsize = 0;
+      for (size_t i = 0; i < steps.Size(); i++)
+        if (needed[i])
+          {
+            for (int j : newinputs[i])
+              inputs.Add (newnr[i], newnr[j]);
+            max_inputsize = max2(newinputs[i].Size(), max_inputsize);
+            dim.Append (steps[i]->Dimension());
+            is_complex.Append (steps[i]->IsComplex());
+          }
+      steps = std::move(newsteps);
+      totdim = 0;
+      for (int d : dim) totdim += d;
+    }
+
     void RealCompile(int maxderiv, bool wait)
     {
-        std::vector<string> link_flags;
+      Array<shared_ptr<CompiledCoefficientFunction>> cfs;
+      cfs.Append (dynamic_pointer_cast<CompiledCoefficientFunction> (shared_from_this()));
+      RealCompile (cfs, maxderiv, wait);
+    }
+
+    // compiles all cfs into one library, a few functions per translation unit
+    static void RealCompile (FlatArray<shared_ptr<CompiledCoefficientFunction>> cfs,
+                             int maxderiv, bool wait)
+    {
+      constexpr size_t cfs_per_unit = 4;
+      std::vector<string> codes;
+      std::vector<string> link_flags;
+      std::vector<std::pair<string,const void*>> pointers;
+      std::vector<string> suffixes;
+      for (size_t first = 0; first < cfs.Size(); first += cfs_per_unit)
+        {
+          string top_code = ""
+            "#include<fem.hpp>\n"
+            "using namespace ngfem;\n"
+            "extern \"C\" {\n"
+            ;
+          stringstream s;
+          for (size_t k = first; k < min(first+cfs_per_unit, cfs.Size()); k++)
+            {
+              string suffix = cfs.Size() > 1 ? "_cf" + ToString(k) + "_" : "";
+              suffixes.push_back (suffix);
+              cfs[k]->GenerateFunctionCode (maxderiv, suffix, top_code, s, pointers, link_flags);
+            }
+          s << "}" << endl;
+          codes.push_back(top_code + s.str());
+        }
+
+      std::vector<shared_ptr<CompiledCoefficientFunction>> hcfs;
+      for (auto & c : cfs)
+        hcfs.push_back(c);
+      auto compile_func = [hcfs, suffixes, codes, link_flags, pointers, maxderiv] () {
+              shared_ptr<SharedLibrary> library = CompileCode( codes, link_flags );
+              if (!library) return;   // keep interpreted evaluation
+              SetPointers (*library, pointers);
+              for (auto k : Range(hcfs.size()))
+                hcfs[k]->LoadFunctions (library, suffixes[k], maxderiv);
+              cout << IM(7) << "Compilation done" << endl;
+        };
+        if(wait)
+            compile_func();
+        else
+        {
+          try {
+            std::thread( compile_func ).detach();
+          } catch (const std::exception &e) {
+              cerr << IM(3) << "Compilation of CoefficientFunction failed: " << e.what() << endl;
+          }
+        }
+    }
+
+    // appends the functions CompiledEvaluate<suffix>[D][Deriv][SIMD] to s
+    void GenerateFunctionCode (int maxderiv, const string & suffix, string & top_code, stringstream & s,
+                               std::vector<std::pair<string,const void*>> & pointers,
+                               std::vector<string> & link_flags)
+    {
         if(cf->IsComplex())
             maxderiv = 0;
-        stringstream s;
-        string pointer_code;
-        string top_code = ""
-             "#include<fem.hpp>\n"
-             "using namespace ngfem;\n"
-             "extern \"C\" {\n"
-             ;
-
         string parameters[3] = {"results", "deriv", "dderiv"};
 
+        // the derivatives of steps not depending on a proxy vanish, in the
+        // derivative code they are computed in plain arithmetic (into the
+        // variables of step steps.Size()+1+i) and promoted to AutoDiff only
+        // where a proxy dependent step uses them
+        Array<bool> plain(steps.Size()), promote(steps.Size());
+        promote = false;
+        for (auto i : Range(steps))
+          {
+            plain[i] = !is_complex[i] && !dynamic_cast<ProxyFunction*> (steps[i]);
+            for (int j : inputs[i])
+              plain[i] = plain[i] && plain[j];
+            if (!plain[i])
+              for (int j : inputs[i])
+                if (plain[j]) promote[j] = true;
+          }
+        promote.Last() = plain.Last();
+
         for (int deriv : Range(maxderiv+1))
         for (auto simd : {false,true}) {
             cout << IM(3) << "Compiled CF:" << endl;
             Code code;
             code.is_simd = simd;
             code.deriv = deriv;
+            code.prefix = suffix;
+            string ad_type = simd ? "SIMD<double>" : "double";
+            if(deriv==1) ad_type = "AutoDiff<1," + ad_type + ">";
+            if(deriv==2) ad_type = "AutoDiffDiff<1," + ad_type + ">";
             for (auto i : Range(steps)) {
               cout << IM(3) << "step " << i << ": " << typeid(*steps[i]).name() << endl;
-              steps[i]->GenerateCode(code, inputs[i],i);
+              if (deriv == 0 || !plain[i])
+                {
+                  steps[i]->GenerateCode(code, inputs[i],i);
+                  continue;
+                }
+
+              int plain_index = steps.Size()+1+i;
+              ArrayMem<int,10> plain_inputs;
+              for (int j : inputs[i])
+                plain_inputs.Append (steps.Size()+1+j);
+              // pointer names must not collide with the ones of the deriv=0 code
+              code.deriv = 0;
+              code.prefix = suffix + "p" + ToString(deriv) + "_";
+              steps[i]->GenerateCode(code, plain_inputs, plain_index);
+              code.deriv = deriv;
+              code.prefix = suffix;
+
+              if (promote[i])
+                TraverseDimensions( steps[i]->Dimensions(), [&](int ind, int j, int k) {
+                    code.body += Var(i,j,k).Declare(ad_type);
+                    code.body += Var(i,j,k).Assign(Var(plain_index,j,k),false);
+                  });
             }
 
-            pointer_code += code.pointer;
+            pointers.insert(pointers.end(), code.pointers.begin(), code.pointers.end());
             top_code += code.top;
 
             // set results
@@ -3771,7 +4736,7 @@ shared_ptr<CoefficientFunction> MakeCoordinateCoefficientFunction (int comp)
 #ifdef WIN32
             s << "__declspec(dllexport) ";
 #endif
-            s << "void CompiledEvaluate";
+            s << "void CompiledEvaluate" << suffix;
             if(deriv==2) s << "D";
             if(deriv>=1) s << "Deriv";
             if(simd) s << "SIMD";
@@ -3806,50 +4771,31 @@ shared_ptr<CoefficientFunction> MakeCoordinateCoefficientFunction (int comp)
                     link_flags.push_back(lib);
 
         }
-        s << "}" << endl;
-        string file_code = top_code + s.str();
-        std::vector<string> codes;
-        codes.push_back(file_code);
-        if(pointer_code.size()) {
-          pointer_code = "extern \"C\" {\n" + pointer_code;
-          pointer_code += "}\n";
-          codes.push_back(pointer_code);
-        }
+    }
 
-        auto self = shared_from_this();
-        auto compile_func = [self, codes, link_flags, maxderiv] () {
-              self->library = CompileCode( codes, link_flags );
-              if(self->cf->IsComplex())
-              {
-                  self->compiled_function_simd_complex = self->library->GetFunction<lib_function_simd_complex>("CompiledEvaluateSIMD");
-                  self->compiled_function_complex = self->library->GetFunction<lib_function_complex>("CompiledEvaluate");
-              }
-              else
-              {
-                  self->compiled_function_simd = self->library->GetFunction<lib_function_simd>("CompiledEvaluateSIMD");
-                  self->compiled_function = self->library->GetFunction<lib_function>("CompiledEvaluate");
-                  if(maxderiv>0)
-                  {
-                      self->compiled_function_simd_deriv = self->library->GetFunction<lib_function_simd_deriv>("CompiledEvaluateDerivSIMD");
-                      self->compiled_function_deriv = self->library->GetFunction<lib_function_deriv>("CompiledEvaluateDeriv");
-                  }
-                  if(maxderiv>1)
-                  {
-                      self->compiled_function_simd_dderiv = self->library->GetFunction<lib_function_simd_dderiv>("CompiledEvaluateDDerivSIMD");
-                      self->compiled_function_dderiv = self->library->GetFunction<lib_function_dderiv>("CompiledEvaluateDDeriv");
-                  }
-              }
-              cout << IM(7) << "Compilation done" << endl;
-        };
-        if(wait)
-            compile_func();
-        else
+    void LoadFunctions (shared_ptr<SharedLibrary> alibrary, const string & suffix, int maxderiv)
+    {
+      library = alibrary;
+      string name = "CompiledEvaluate" + suffix;
+      if(cf->IsComplex())
         {
-          try {
-            std::thread( compile_func ).detach();
-          } catch (const std::exception &e) {
-              cerr << IM(3) << "Compilation of CoefficientFunction failed: " << e.what() << endl;
-          }
+          compiled_function_simd_complex = library->GetFunction<lib_function_simd_complex>(name+"SIMD");
+          compiled_function_complex = library->GetFunction<lib_function_complex>(name);
+        }
+      else
+        {
+          compiled_function_simd = library->GetFunction<lib_function_simd>(name+"SIMD");
+          compiled_function = library->GetFunction<lib_function>(name);
+          if(maxderiv>0)
+            {
+              compiled_function_simd_deriv = library->GetFunction<lib_function_simd_deriv>(name+"DerivSIMD");
+              compiled_function_deriv = library->GetFunction<lib_function_deriv>(name+"Deriv");
+            }
+          if(maxderiv>1)
+            {
+              compiled_function_simd_dderiv = library->GetFunction<lib_function_simd_dderiv>(name+"DDerivSIMD");
+              compiled_function_dderiv = library->GetFunction<lib_function_dderiv>(name+"DDeriv");
+            }
         }
     }
 
@@ -3898,6 +4844,7 @@ shared_ptr<CoefficientFunction> MakeCoordinateCoefficientFunction (int comp)
       ArrayMem<BareSliceMatrix<T,ORD>, 100> in(max_inputsize);
       for (size_t i = 0; i < steps.Size()-1; i++)
         {
+          if (fused_away[i]) continue;
           new (&temp[i]) BareSliceMatrix<T,ORD> (FlatMatrix<T,ORD> (dim[i], ir.Size(), &hmem[mem_ptr]));
           mem_ptr += ir.Size()*dim[i];
         }
@@ -3906,6 +4853,19 @@ shared_ptr<CoefficientFunction> MakeCoordinateCoefficientFunction (int comp)
 
       for (size_t i = 0; i < steps.Size(); i++)
         {
+          if (fused_away[i]) continue;
+          if (muladd[i][0] != -1)
+            {
+              // res = s*v + b, without the temporary for s*v
+              auto s = temp[muladd[i][0]];
+              auto v = temp[muladd[i][1]];
+              auto b = temp[muladd[i][2]];
+              auto res = temp[i];
+              for (size_t k = 0; k < dim[i]; k++)
+                for (size_t j = 0; j < ir.Size(); j++)
+                  res(k,j) = s(0,j) * v(k,j) + b(k,j);
+              continue;
+            }
           auto inputi = inputs[i];
           for (int nr : Range(inputi))
             new (&in[nr]) BareSliceMatrix<T,ORD> (temp[inputi[nr]]);
@@ -4618,6 +5578,20 @@ class RealCF : public CoefficientFunctionNoDerivative
     return cf;
   }
 
+  Array<shared_ptr<CoefficientFunction>> Compile (FlatArray<shared_ptr<CoefficientFunction>> cfs, bool realcompile, int maxderiv, bool wait)
+  {
+    Array<shared_ptr<CompiledCoefficientFunction>> compiled;
+    for (auto c : cfs)
+      compiled.Append (make_shared<CompiledCoefficientFunction> (c));
+    if(realcompile && compiled.Size())
+      CompiledCoefficientFunction::RealCompile(compiled, maxderiv, wait);
+
+    Array<shared_ptr<CoefficientFunction>> res;
+    for (auto c : compiled)
+      res.Append (c);
+    return res;
+  }
+
   
 }
 
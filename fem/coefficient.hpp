@@ -763,6 +763,7 @@ namespace ngfem
                            AFlatMatrix<double> values) const
     { values = val; }
     */
+    virtual double EvaluateConst () const override { return val; }
     virtual void SetValue (double in) { val = in; }
     virtual double GetValue () { return val; }
     virtual void PrintReport (ostream & ost) const override;
@@ -833,6 +834,39 @@ namespace ngfem
 
 
   ///
+  /*
+    Values stored in the integration points of every element, e.g. history
+    variables of plasticity models. Per element the values are a
+    Dimension() x nip matrix of SIMD<double>, points in the order of the
+    SIMD_IntegrationRule. Elements never set evaluate to zero.
+   */
+  class NGS_DLL_HEADER QuadraturePointCoefficientFunction : public CoefficientFunctionNoDerivative
+  {
+    VorB vb;
+    Array<Array<SIMD<double>>> data;   // per element number
+    Array<size_t> nips;
+  public:
+    QuadraturePointCoefficientFunction (int adim, size_t nelements, VorB avb = VOL);
+    VorB VB() const { return vb; }
+
+    /// storage of the values of an element, allocated at first use; the
+    /// element is owned by the calling thread, other elements are not touched
+    FlatMatrix<SIMD<double>> GetValues (ElementId ei, size_t nip);
+    /// evaluates the cf in the points of mir, cf may depend on this
+    void Set (const SIMD_BaseMappedIntegrationRule & mir, const CoefficientFunction & cf, LocalHeap & lh);
+
+    using CoefficientFunctionNoDerivative::Evaluate;
+    virtual double Evaluate (const BaseMappedIntegrationPoint & ip) const override;
+    virtual void Evaluate (const BaseMappedIntegrationPoint & ip, FlatVector<> result) const override;
+    virtual void Evaluate (const BaseMappedIntegrationRule & ir, BareSliceMatrix<double> values) const override;
+    virtual void Evaluate (const SIMD_BaseMappedIntegrationRule & ir, BareSliceMatrix<SIMD<double>> values) const override;
+    virtual void PrintReport (ostream & ost) const override;
+  private:
+    // values of the element in the points of the rule, or an empty matrix
+    FlatMatrix<SIMD<double>> ElementValues (const ElementTransformation & trafo, size_t nip) const;
+  };
+
+
   // template <int DIM>
   class NGS_DLL_HEADER DomainVariableCoefficientFunction : public CoefficientFunction
   {
@@ -882,11 +916,29 @@ namespace ngfem
     virtual void Evaluate (const BaseMappedIntegrationRule & ir, 
 			   BareSliceMatrix<double> values) const;
 
+    /// the bytecode runs on SIMD point batches, real functions only
+    virtual void Evaluate (const SIMD_BaseMappedIntegrationRule & ir,
+                           BareSliceMatrix<SIMD<double>> values) const;
+
     virtual void PrintReport (ostream & ost) const;
 
     virtual void GenerateCode(Code &code, FlatArray<int> inputs, int index) const;
+
+    /// the same function as tree of coefficient functions, which can be
+    /// compiled. nullptr if it uses operations without counterpart
+    shared_ptr<CoefficientFunction> GetCoefficientFunction () const;
   };
 
+  /**
+     Translates the bytecode of an EvalFunction into a coefficient
+     function tree. args are the scalar arguments x[0], x[1], ...
+     Global variables are read through their pointers, so they keep
+     their meaning. Returns nullptr for user functions, Bessel functions,
+     atan2, vector element access and generic (possibly complex) variables.
+  */
+  NGS_DLL_HEADER shared_ptr<CoefficientFunction>
+  EvalFunctionToCF (const EvalFunction & fun, FlatArray<shared_ptr<CoefficientFunction>> args);
+
   ///
   template <int DIM>
   class NGS_DLL_HEADER DomainInternalCoefficientFunction : public CoefficientFunction
@@ -1358,10 +1410,14 @@ public:
     TraverseDimensions( c1->Dimensions(), [&](int ind, int i, int j) {
         int i2,j2;
         GetIndex(c2->Dimensions(), ind, i2, j2);
-        code.body += Var(index,i,j).Assign(   Var(inputs[0],i,j).S()
-                                            + opname
-                                            + Var(inputs[1],i2,j2).S()
-                                          );
+        if (isalpha(opname[0]))   // pow, atan2, ...
+          code.body += Var(index,i,j).Assign( opname + "(" + Var(inputs[0],i,j).S()
+                                              + "," + Var(inputs[1],i2,j2).S() + ")" );
+        else
+          code.body += Var(index,i,j).Assign(   Var(inputs[0],i,j).S()
+                                              + opname
+                                              + Var(inputs[1],i2,j2).S()
+                                            );
     });
   }
 
@@ -1604,6 +1660,10 @@ INLINE shared_ptr<CoefficientFunction> BinaryOpCF(shared_ptr<CoefficientFunction
   
   NGS_DLL_HEADER shared_ptr<CoefficientFunction>
   MakeDomainWiseCoefficientFunction (Array<shared_ptr<CoefficientFunction>> aci);
+
+  /// sp(c1) componentwise, SIMD evaluation and derivatives by the B-spline
+  NGS_DLL_HEADER shared_ptr<CoefficientFunction>
+  MakeBSplineCoefficientFunction (shared_ptr<BSpline> sp, shared_ptr<CoefficientFunction> c1);
   
 
 
@@ -1653,6 +1713,9 @@ INLINE shared_ptr<CoefficientFunction> BinaryOpCF(shared_ptr<CoefficientFunction
   
   NGS_DLL_HEADER
   shared_ptr<CoefficientFunction> Compile (shared_ptr<CoefficientFunction> c, bool realcompile=false, int maxderiv=2, bool wait=false);
+  /// compiles all cfs into one shared library
+  NGS_DLL_HEADER
+  Array<shared_ptr<CoefficientFunction>> Compile (FlatArray<shared_ptr<CoefficientFunction>> cfs, bool realcompile=false, int maxderiv=2, bool wait=false);
 }
 
 
@@ -139,6 +139,16 @@ namespace ngfem
       return iscurved;
     }
 
+    /**
+       Reference point 0, constant Jacobian, its (pseudo-)inverse and
+       the determinant (the measure for boundary elements) of a
+       non-curved element.  Returns false if the Jacobian is not
+       constant.
+    */
+    virtual bool GetAffineJacobian (FlatVector<> p0, FlatMatrix<> jac,
+                                    FlatMatrix<> ijac, double & det) const
+    { return false; }
+
     bool IsComplex() const { return is_complex; }
     
     virtual void GetSort (FlatArray<int> sort) const
@@ -67,3 +67,66 @@ public:
 
 
 // InitFemKernels ifc;
+
+
+
+
+/*
+  Kernels of the matrix-free operator. Element vectors of a block are
+  stored interleaved, entry i of element e is at i*nel+e, such that
+  neighbouring threads access neighbouring addresses. The geometric
+  factors g are D x D matrices per element and point, stored contiguous
+  at (e*nip+p)*D*D.
+*/
+__global__ void DevGeomFactorsKernel (int nel, int nip, int D, const double * g,
+                                      const double * u, double * v)
+{
+  int tid = blockIdx.x*blockDim.x+threadIdx.x;
+  for (int i = tid; i < nel*nip; i += blockDim.x*gridDim.x)
+    {
+      int p = i / nel, e = i % nel;
+      const double * ge = g + size_t(e*nip+p)*D*D;
+      for (int k = 0; k < D; k++)
+        {
+          double sum = 0;
+          for (int l = 0; l < D; l++)
+            sum += ge[k*D+l] * u[(p*D+l)*nel+e];
+          v[(p*D+k)*nel+e] = sum;
+        }
+    }
+}
+
+// v_ep = g_ep u_ep for all elements e and points p
+void DevGeomFactors (int nel, int nip, int D, const double * g, const double * u, double * v)
+{
+  DevGeomFactorsKernel<<<512,256>>> (nel, nip, D, g, u, v);
+}
+
+__global__ void DevElementDiagonalKernel (int nel, int nip, int D, int ndof,
+                                          const double * b, const double * g, double * diag)
+{
+  int tid = blockIdx.x*blockDim.x+threadIdx.x;
+  for (int j = tid; j < nel*ndof; j += blockDim.x*gridDim.x)
+    {
+      int i = j / nel, e = j % nel;
+      double sum = 0;
+      for (int p = 0; p < nip; p++)
+        {
+          const double * ge = g + size_t(e*nip+p)*D*D;
+          for (int k = 0; k < D; k++)
+            for (int l = 0; l < D; l++)
+              sum += b[(p*D+k)*ndof+i] * ge[k*D+l] * b[(p*D+l)*ndof+i];
+        }
+      diag[j] = sum;
+    }
+}
+
+/*
+  diagonals of the element matrices Trans(b) g_e b, b is the row-major
+  nip*D x ndof reference table, diag is interleaved as element vectors
+*/
+void DevElementDiagonal (int nel, int nip, int D, int ndof,
+                         const double * b, const double * g, double * diag)
+{
+  DevElementDiagonalKernel<<<512,256>>> (nel, nip, D, ndof, b, g, diag);
+}
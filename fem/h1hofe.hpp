@@ -131,6 +131,51 @@ namespace ngfem
       order = ho;
     }
 
+    /**
+       Element type, vertex ordering and orders, padded with zeros.
+       The shape functions depend on the vertex numbers only via
+       their ordering, so elements with equal keys have equal shapes.
+    */
+    std::array<unsigned char,5*sizeof(size_t)> ClassKey () const
+    {
+      std::array<unsigned char,5*sizeof(size_t)> bytes;
+      bytes.fill(0);
+      size_t pos = 0;
+      bytes[pos++] = ET;
+      bytes[pos++] = nodalp2;
+      for (int i = 0; i < N_VERTEX; i++)
+        {
+          int rank = 0;
+          for (int j = 0; j < N_VERTEX; j++)
+            if (this->vnums[j] < this->vnums[i]) rank++;
+          bytes[pos++] = rank;
+        }
+      for (int i = 0; i < N_EDGE; i++)
+        bytes[pos++] = order_edge[i];
+      for (int i = 0; i < N_FACE; i++)
+        for (int k = 0; k < 2; k++)
+          bytes[pos++] = order_face[i][k];
+      for (int i = 0; i < N_CELL; i++)
+        for (int k = 0; k < 3; k++)
+          bytes[pos++] = order_cell[i][k];
+      return bytes;
+    }
+
+#ifndef FASTCOMPILE
+    using BASE::CalcShape;
+    using BASE::CalcMappedDShape;
+
+    /// reference shapes come from the ReferenceShapeCache for global integration rules
+    virtual void CalcShape (const SIMD_IntegrationRule & ir, 
+                            BareSliceMatrix<SIMD<double>> shape) const override;
+
+    virtual void CalcMappedDShape (const SIMD_BaseMappedIntegrationRule & mir, 
+                                   BareSliceMatrix<SIMD<double>> dshapes) const override;
+
+  protected:
+    /// nullptr if the rule is not persistent, or the cache is full
+    const ReferenceShapeCache::Entry * GetCachedShapes (const SIMD_IntegrationRule & ir) const;
+#endif
 
   };
 
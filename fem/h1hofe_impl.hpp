@@ -656,6 +656,95 @@ namespace ngfem
       }
   }
 
+
+
+#ifndef FASTCOMPILE
+
+  template <ELEMENT_TYPE ET, class SHAPES, class BASE>
+  const ReferenceShapeCache::Entry * H1HighOrderFE<ET,SHAPES,BASE> ::
+  GetCachedShapes (const SIMD_IntegrationRule & ir) const
+  {
+    if (!is_same<SHAPES,H1HighOrderFE_Shape<ET>>::value || DIM == 0 ||
+        !ir.IsPersistent() || ir.Size() == 0)
+      return nullptr;
+
+    auto bytes = ClassKey();
+
+    ReferenceShapeCache::Key key;
+    key[0] = size_t(&ir[0]);
+    memcpy (&key[1], &bytes[0], bytes.size());
+
+    if (auto cached = ReferenceShapeCache::Get (key))
+      return cached;
+
+    auto entry = make_unique<ReferenceShapeCache::Entry>();
+    auto & shape = entry->shape;
+    auto & dshape = entry->dshape;
+    shape.SetSize (ndof, ir.Size());
+    dshape.SetSize (DIM*ndof, ir.Size());
+
+    BASE::CalcShape (ir, shape);
+    for (size_t i = 0; i < ir.Size(); i++)
+      {
+        Vec<DIM,AutoDiffRec<DIM,SIMD<double>>> adp;
+        for (int k = 0; k < DIM; k++)
+          adp(k) = AutoDiffRec<DIM,SIMD<double>> (ir[i](k), k);
+        this->T_CalcShape (TIP<DIM,AutoDiffRec<DIM,SIMD<double>>> (adp),
+                           SBLambda ([&] (size_t j, AutoDiffRec<DIM,SIMD<double>> s)
+                                     {
+                                       for (int k = 0; k < DIM; k++)
+                                         dshape(j*DIM+k, i) = s.DValue(k);
+                                     }));
+      }
+    return ReferenceShapeCache::Insert (key, move(entry));
+  }
+
+  template <ELEMENT_TYPE ET, class SHAPES, class BASE>
+  void H1HighOrderFE<ET,SHAPES,BASE> ::
+  CalcShape (const SIMD_IntegrationRule & ir, BareSliceMatrix<SIMD<double>> shape) const
+  {
+    if (auto cached = GetCachedShapes (ir))
+      shape.AddSize(ndof, ir.Size()) = cached->shape;
+    else
+      BASE::CalcShape (ir, shape);
+  }
+
+  template <ELEMENT_TYPE ET, class SHAPES, class BASE>
+  void H1HighOrderFE<ET,SHAPES,BASE> ::
+  CalcMappedDShape (const SIMD_BaseMappedIntegrationRule & bmir, 
+                    BareSliceMatrix<SIMD<double>> dshapes) const
+  {
+    auto cached = (bmir.DimSpace() == DIM) ? GetCachedShapes (bmir.IR()) : nullptr;
+    if (!cached)
+      {
+        BASE::CalcMappedDShape (bmir, dshapes);
+        return;
+      }
+
+    // grad u = J^{-T} grad_ref u
+    auto & mir = static_cast<const SIMD_MappedIntegrationRule<DIM,DIM>&> (bmir);
+    auto & refdshape = cached->dshape;
+    for (size_t i = 0; i < mir.Size(); i++)
+      {
+        Mat<DIM,DIM,SIMD<double>> ijac = mir[i].GetJacobianInverse();
+        for (size_t j = 0; j < ndof; j++)
+          {
+            Vec<DIM,SIMD<double>> gref;
+            for (int k = 0; k < DIM; k++)
+              gref(k) = refdshape(j*DIM+k, i);
+            for (int l = 0; l < DIM; l++)
+              {
+                SIMD<double> sum = 0.0;
+                for (int k = 0; k < DIM; k++)
+                  sum += gref(k) * ijac(k,l);
+                dshapes(j*DIM+l, i) = sum;
+              }
+          }
+      }
+  }
+
+#endif
+
 }
 
 #endif
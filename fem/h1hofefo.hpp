@@ -17,6 +17,46 @@ namespace ngfem
 
   template <ELEMENT_TYPE ET, int ORDER> class H1HighOrderFEFO;
 
+  /// maximal order of the fixed order elements instantiated in the library
+  constexpr int H1_MAX_FIXED_ORDER = 6;
+
+  /**
+     High order segment finite element
+  */
+  template <int ORDER>
+  class H1HighOrderFEFO<ET_SEGM, ORDER> : 
+    public T_ScalarFiniteElement< H1HighOrderFEFO<ET_SEGM,ORDER>, ET_SEGM >,
+    public ET_trait<ET_SEGM> 
+  {
+    using ScalarFiniteElement<1>::ndof;
+    using ScalarFiniteElement<1>::order;    
+
+    using ET_trait<ET_SEGM> :: N_VERTEX;
+
+    int vnums[N_VERTEX];
+
+  public:
+    enum { NDOF = ORDER+1 };
+
+    INLINE H1HighOrderFEFO () 
+    {
+      order = ORDER;
+      ndof = NDOF; 
+      for (int i = 0; i < N_VERTEX; i++) vnums[i] = i;
+    }
+
+    template <typename TA> 
+    INLINE H1HighOrderFEFO<ET_SEGM, ORDER> * SetVertexNumbers (const TA & avnums)
+    { 
+      for (int i = 0; i < N_VERTEX; i++) vnums[i] = avnums[i]; 
+      return this;
+    }
+
+    template<typename Tx, typename TFA>  
+    INLINE void T_CalcShape (TIP<1,Tx> ip, TFA & shape) const; 
+  };
+
+
   /**
      High order triangular finite element
   */
@@ -111,6 +151,13 @@ namespace ngfem
 namespace ngfem
 {
 
+  H1HOFEFO_EXTERN template class T_ScalarFiniteElement<H1HighOrderFEFO<ET_SEGM,1>, ET_SEGM>;
+  H1HOFEFO_EXTERN template class T_ScalarFiniteElement<H1HighOrderFEFO<ET_SEGM,2>, ET_SEGM>;
+  H1HOFEFO_EXTERN template class T_ScalarFiniteElement<H1HighOrderFEFO<ET_SEGM,3>, ET_SEGM>;
+  H1HOFEFO_EXTERN template class T_ScalarFiniteElement<H1HighOrderFEFO<ET_SEGM,4>, ET_SEGM>;
+  H1HOFEFO_EXTERN template class T_ScalarFiniteElement<H1HighOrderFEFO<ET_SEGM,5>, ET_SEGM>;
+  H1HOFEFO_EXTERN template class T_ScalarFiniteElement<H1HighOrderFEFO<ET_SEGM,6>, ET_SEGM>;
+
   H1HOFEFO_EXTERN template class T_ScalarFiniteElement<H1HighOrderFEFO<ET_TRIG,1>, ET_TRIG>;
   H1HOFEFO_EXTERN template class T_ScalarFiniteElement<H1HighOrderFEFO<ET_TRIG,2>, ET_TRIG>;
   H1HOFEFO_EXTERN template class T_ScalarFiniteElement<H1HighOrderFEFO<ET_TRIG,3>, ET_TRIG>;
@@ -125,6 +172,13 @@ namespace ngfem
   H1HOFEFO_EXTERN template class T_ScalarFiniteElement<H1HighOrderFEFO<ET_TET,5>, ET_TET>;
   H1HOFEFO_EXTERN template class T_ScalarFiniteElement<H1HighOrderFEFO<ET_TET,6>, ET_TET>;
 
+  H1HOFEFO_EXTERN template class H1HighOrderFEFO<ET_SEGM,1>;
+  H1HOFEFO_EXTERN template class H1HighOrderFEFO<ET_SEGM,2>;
+  H1HOFEFO_EXTERN template class H1HighOrderFEFO<ET_SEGM,3>;
+  H1HOFEFO_EXTERN template class H1HighOrderFEFO<ET_SEGM,4>;
+  H1HOFEFO_EXTERN template class H1HighOrderFEFO<ET_SEGM,5>;
+  H1HOFEFO_EXTERN template class H1HighOrderFEFO<ET_SEGM,6>;
+
   H1HOFEFO_EXTERN template class H1HighOrderFEFO<ET_TRIG,1>;
   H1HOFEFO_EXTERN template class H1HighOrderFEFO<ET_TRIG,2>;
   H1HOFEFO_EXTERN template class H1HighOrderFEFO<ET_TRIG,3>;
@@ -41,6 +41,26 @@ namespace ngfem
   
 
 
+  /*
+    The fixed order elements use the same basis as H1HighOrderFE,
+    i.e. edge shapes are integrated Legendre polynomials, so they can
+    be mixed with variable order elements of the same order.
+  */
+
+  template <int ORDER>   template<typename Tx, typename TFA>  
+  void H1HighOrderFEFO<ET_SEGM, ORDER> :: T_CalcShape (TIP<1,Tx> ip, TFA & shape) const
+  {
+    Tx lam[2] = { ip.x, 1-ip.x };
+
+    shape[0] = lam[0];
+    shape[1] = lam[1];
+
+    INT<2> e = GetEdgeSort (0, vnums);
+    IntLegNoBubble::
+      EvalMultFO<ORDER-2> (lam[e[1]]-lam[e[0]], lam[e[0]]*lam[e[1]], shape+2);
+  }
+
+
   template <int ORDER>   template<typename Tx, typename TFA>  
   void H1HighOrderFEFO<ET_TRIG, ORDER> :: T_CalcShape (TIP<2,Tx> ip, TFA & shape) const
   {
@@ -53,9 +73,9 @@ namespace ngfem
     for (int i = 0; i < 3; i++)
       { 
         INT<2> e = GetEdgeSort (i, vnums);
-	LegendrePolynomial::EvalScaledMult (ORDER-2, 
-					    lam[e[1]]-lam[e[0]], lam[e[0]]+lam[e[1]], 
-					    lam[e[0]]*lam[e[1]], shape.Addr(ii));
+        IntLegNoBubble::
+          EvalScaledMultFO<ORDER-2> (lam[e[1]]-lam[e[0]], lam[e[0]]+lam[e[1]], 
+                                     lam[e[0]]*lam[e[1]], shape+ii);
 	ii += ORDER-1;
       }
 
@@ -79,7 +99,7 @@ namespace ngfem
     for (int i = 0; i < 3; i++)
       { 
         INT<2> e = GetEdge (i);
-        shape[ii] = lam[e[0]] * lam[e[1]];
+        shape[ii] = -0.5 * lam[e[0]] * lam[e[1]];
         ii++;
       }
   }
@@ -109,7 +129,7 @@ namespace ngfem
     for (int i = 0; i < 6; i++)
       { 
         INT<2> e = GetEdgeSort (i, vnums);
-        LegendrePolynomial::
+        IntLegNoBubble::
           EvalScaledMultFO<ORDER-2> (lam[e[1]]-lam[e[0]], lam[e[0]]+lam[e[1]], 
                                      lam[e[0]]*lam[e[1]], shape+ii);
         ii += ORDER-1;
@@ -148,7 +168,7 @@ namespace ngfem
     for (int i = 0; i < 6; i++)
       { 
         INT<2> e = GetEdge (i);
-        shape[ii] = lam[e[0]] * lam[e[1]];
+        shape[ii] = -0.5 * lam[e[0]] * lam[e[1]];
         ii++;
       }
   }
@@ -167,8 +187,8 @@ namespace ngfem
       { 
         INT<2> e = GetEdgeSort (i, vnums);
         Tx bub = lam[e[0]]*lam[e[1]];
-        shape[ii] = bub;
-        shape[ii+1] = bub * (lam[e[1]]-lam[e[0]]);
+        shape[ii] = -0.5 * bub;
+        shape[ii+1] = -0.5 * bub * (lam[e[1]]-lam[e[0]]);
         ii += 2;
       }
 
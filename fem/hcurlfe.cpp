@@ -146,12 +146,44 @@ namespace ngfem
       CalcMappedShape (mir[i], shape.Cols(i*D, (i+1)*D));
   }
   
+  /*
+    Default SIMD versions for elements which only provide the scalar 
+    CalcShape and CalcCurlShape: evaluate the reference shapes lane by
+    lane and apply the Piola mapping.  Integrators and Evaluate/AddTrans
+    stay in the SIMD path for such elements.
+  */
   template <int D>
   void HCurlFiniteElement<D> ::
-  CalcMappedShape (const SIMD_BaseMappedIntegrationRule & mir, 
-                   BareSliceMatrix<SIMD<double>> dshapes) const
+  CalcMappedShape (const SIMD_BaseMappedIntegrationRule & bmir, 
+                   BareSliceMatrix<SIMD<double>> shapes) const
   {
-    throw ExceptionNOSIMD("SIMD - HCurlFE::CalcShape not overloaded");
+    if (bmir.DimSpace() != D)
+      throw ExceptionNOSIMD("SIMD - HCurlFE::CalcShape not overloaded for codim > 0");
+
+    auto & mir = static_cast<const SIMD_MappedIntegrationRule<D,D>&> (bmir);
+    constexpr size_t SW = SIMD<double>::Size();
+    auto lane = [] (SIMD<double> & x, size_t l) -> double& { return ((double*)&x)[l]; };
+
+    STACK_ARRAY(double, mem, ndof*D);
+    FlatMatrixFixWidth<D> shape(ndof, &mem[0]);
+    for (size_t i = 0; i < mir.Size(); i++)
+      {
+        Mat<D,D,SIMD<double>> jacinv = mir[i].GetJacobianInverse();
+        for (size_t l = 0; l < SW; l++)
+          {
+            CalcShape (mir[i].IP()[l], shape);
+            Mat<D> trans;
+            for (int k = 0; k < D; k++)
+              for (int m = 0; m < D; m++)
+                trans(k,m) = jacinv(m,k)[l];
+            for (int j = 0; j < ndof; j++)
+              {
+                Vec<D> hs = trans * Vec<D> (shape.Row(j));
+                for (int k = 0; k < D; k++)
+                  lane(shapes(j*D+k, i), l) = hs(k);
+              }
+          }
+      }
   }
   
 
@@ -189,10 +221,128 @@ namespace ngfem
   
   template <int D>
   void HCurlFiniteElement<D> ::
-  CalcMappedCurlShape (const SIMD_BaseMappedIntegrationRule & mir, 
-                       BareSliceMatrix<SIMD<double>> dshapes) const
+  CalcMappedCurlShape (const SIMD_BaseMappedIntegrationRule & bmir, 
+                       BareSliceMatrix<SIMD<double>> curlshapes) const
+  {
+    if (bmir.DimSpace() != D)
+      throw ExceptionNOSIMD("SIMD - HCurlFE::CalcMappedCurlShape not overloaded for codim > 0");
+
+    constexpr int DIM_CURL = DIM_CURL_(D);
+    auto & mir = static_cast<const SIMD_MappedIntegrationRule<D,D>&> (bmir);
+    constexpr size_t SW = SIMD<double>::Size();
+    auto lane = [] (SIMD<double> & x, size_t l) -> double& { return ((double*)&x)[l]; };
+
+    STACK_ARRAY(double, mem, ndof*DIM_CURL);
+    FlatMatrixFixWidth<DIM_CURL> curlshape(ndof, &mem[0]);
+    for (size_t i = 0; i < mir.Size(); i++)
+      {
+        Mat<D,D,SIMD<double>> jac = mir[i].GetJacobian();
+        SIMD<double> det = mir[i].GetJacobiDet();
+        for (size_t l = 0; l < SW; l++)
+          {
+            CalcCurlShape (mir[i].IP()[l], curlshape);
+            if (D == 2)
+              {
+                for (int j = 0; j < ndof; j++)
+                  lane(curlshapes(j,i), l) = curlshape(j,0) / det[l];
+              }
+            else
+              {
+                Mat<DIM_CURL> trans;
+                for (int k = 0; k < DIM_CURL; k++)
+                  for (int m = 0; m < DIM_CURL; m++)
+                    trans(k,m) = jac(k,m)[l] / det[l];
+                for (int j = 0; j < ndof; j++)
+                  {
+                    Vec<DIM_CURL> hs = trans * Vec<DIM_CURL> (curlshape.Row(j));
+                    for (int k = 0; k < DIM_CURL; k++)
+                      lane(curlshapes(j*DIM_CURL+k, i), l) = hs(k);
+                  }
+              }
+          }
+      }
+  }
+
+  template <int D>
+  void HCurlFiniteElement<D> ::
+  Evaluate (const SIMD_BaseMappedIntegrationRule & mir, BareSliceVector<> coefs,
+            BareSliceMatrix<SIMD<double>> values) const
   {
-    throw ExceptionNOSIMD("SIMD - HCurlFE::CalcMappedCurlShape not overloaded");
+    if (mir.DimSpace() != D)
+      throw ExceptionNOSIMD(string("HCurlFE - simd eval not overloaded, eltype = ")+typeid(*this).name());
+    STACK_ARRAY(SIMD<double>, mem, ndof*D*mir.Size());
+    FlatMatrix<SIMD<double>> shapes(ndof*D, mir.Size(), &mem[0]);
+    CalcMappedShape (mir, shapes);
+    for (size_t i = 0; i < mir.Size(); i++)
+      for (int k = 0; k < D; k++)
+        {
+          SIMD<double> sum = 0.0;
+          for (int j = 0; j < ndof; j++)
+            sum += coefs(j) * shapes(j*D+k, i);
+          values(k,i) = sum;
+        }
+  }
+
+  template <int D>
+  void HCurlFiniteElement<D> ::
+  EvaluateCurl (const SIMD_BaseMappedIntegrationRule & mir, BareSliceVector<> coefs,
+                BareSliceMatrix<SIMD<double>> values) const
+  {
+    if (mir.DimSpace() != D)
+      throw ExceptionNOSIMD(string("HCurlFE - simd evalcurl not overloaded")+typeid(*this).name());
+    constexpr int DIM_CURL = DIM_CURL_(D);
+    STACK_ARRAY(SIMD<double>, mem, ndof*DIM_CURL*mir.Size());
+    FlatMatrix<SIMD<double>> curlshapes(ndof*DIM_CURL, mir.Size(), &mem[0]);
+    CalcMappedCurlShape (mir, curlshapes);
+    for (size_t i = 0; i < mir.Size(); i++)
+      for (int k = 0; k < DIM_CURL; k++)
+        {
+          SIMD<double> sum = 0.0;
+          for (int j = 0; j < ndof; j++)
+            sum += coefs(j) * curlshapes(j*DIM_CURL+k, i);
+          values(k,i) = sum;
+        }
+  }
+
+  template <int D>
+  void HCurlFiniteElement<D> ::
+  AddTrans (const SIMD_BaseMappedIntegrationRule & mir, BareSliceMatrix<SIMD<double>> values,
+            BareSliceVector<> coefs) const
+  {
+    if (mir.DimSpace() != D)
+      throw ExceptionNOSIMD(string("HCurlFE - simd addtrans not overloaded")+typeid(*this).name());
+    STACK_ARRAY(SIMD<double>, mem, ndof*D*mir.Size());
+    FlatMatrix<SIMD<double>> shapes(ndof*D, mir.Size(), &mem[0]);
+    CalcMappedShape (mir, shapes);
+    for (int j = 0; j < ndof; j++)
+      {
+        SIMD<double> sum = 0.0;
+        for (size_t i = 0; i < mir.Size(); i++)
+          for (int k = 0; k < D; k++)
+            sum += shapes(j*D+k, i) * values(k,i);
+        coefs(j) += HSum(sum);
+      }
+  }
+
+  template <int D>
+  void HCurlFiniteElement<D> ::
+  AddCurlTrans (const SIMD_BaseMappedIntegrationRule & mir, BareSliceMatrix<SIMD<double>> values,
+                BareSliceVector<> coefs) const
+  {
+    if (mir.DimSpace() != D)
+      throw ExceptionNOSIMD(string("HCurlFE - simd addcurltrans not overloaded")+typeid(*this).name());
+    constexpr int DIM_CURL = DIM_CURL_(D);
+    STACK_ARRAY(SIMD<double>, mem, ndof*DIM_CURL*mir.Size());
+    FlatMatrix<SIMD<double>> curlshapes(ndof*DIM_CURL, mir.Size(), &mem[0]);
+    CalcMappedCurlShape (mir, curlshapes);
+    for (int j = 0; j < ndof; j++)
+      {
+        SIMD<double> sum = 0.0;
+        for (size_t i = 0; i < mir.Size(); i++)
+          for (int k = 0; k < DIM_CURL; k++)
+            sum += curlshapes(j*DIM_CURL+k, i) * values(k,i);
+        coefs(j) += HSum(sum);
+      }
   }
   
   
@@ -92,6 +92,19 @@ namespace ngfem
 	elmat.Cols(l2_dofs).Rows(l2_dofs) = Trans(dbmats) * bmats  | Lapack;
       }
   
+      if (simd_evaluate)
+        try
+          {
+            RegionTimer reg2 (timer2);
+            AddFacetMatricesSIMD (fel_l2, fel_facet, eltrans, l2_dofs, facet_dofs, elmat, lh);
+            return;
+          }
+        catch (ExceptionNOSIMD e)
+          {
+            cout << IM(6) << "caught in HDG_LaplaceIntegrator: " << endl
+                 << e.What() << endl;
+            simd_evaluate = false;
+          }
 
       // The facet contribution
       {
@@ -187,6 +200,19 @@ namespace ngfem
 
       RegionTimer reg (timer);
 
+      if (simd_evaluate)
+        try
+          {
+            ApplyElementMatrixSIMD (fel, eltrans, elx, ely, lh);
+            return;
+          }
+        catch (ExceptionNOSIMD e)
+          {
+            cout << IM(6) << "caught in HDG_LaplaceIntegrator::Apply: " << endl
+                 << e.What() << endl;
+            simd_evaluate = false;
+          }
+
 
       const CompoundFiniteElement & cfel = 
         dynamic_cast<const CompoundFiniteElement&> (fel);
@@ -199,7 +225,6 @@ namespace ngfem
       ELEMENT_TYPE eltype = cfel.ElementType();
       
       int nd_l2 = fel_l2.GetNDof();
-      int nd_facet = fel_facet.GetNDof();
       // int nd = cfel.GetNDof();  
 
       int base_l2 = 0;
@@ -292,7 +317,8 @@ namespace ngfem
 
 	    fel_l2.Evaluate (ir_vol, elx.Range(base_l2, base_l2+nd_l2), shapes_l2);
 	    fel_l2.EvaluateGrad (ir_vol, elx.Range(base_l2, base_l2+nd_l2), grad_l2);
-	    fel_facet.Facet(k).Evaluate (ir_vol, elx.Range(base_facet, base_facet+nd_facet), shapes_facet);
+	    IntRange fdofs = fel_facet.GetFacetDofs(k) + base_facet;
+	    fel_facet.Facet(k).Evaluate (ir_vol, elx.Range(fdofs), shapes_facet);
 
 	    for (int l = 0; l < ir_vol.GetNIP(); l++)
 	      {
@@ -333,9 +359,9 @@ namespace ngfem
 	    fel_l2.EvaluateGradTrans (ir_vol, grad_l2, hely);
 	    ely.Range (base_l2, base_l2+nd_l2) += hely;
 
-	    FlatVector<> hely_facet(nd_facet, lh);
+	    FlatVector<> hely_facet(fdofs.Size(), lh);
 	    fel_facet.Facet(k).EvaluateTrans (ir_vol, shapes_facet, hely_facet);
-	    ely.Range (base_facet, base_facet+nd_facet) += hely_facet;
+	    ely.Range (fdofs) += hely_facet;
 	  }
       }
     }
@@ -503,6 +529,162 @@ namespace ngfem
       timer_solve.Stop();
     }
 
+
+  protected:
+    // facet terms of CalcElementMatrix, evaluated with SIMD integration rules
+    void AddFacetMatricesSIMD (const ScalarFiniteElement<D> & fel_l2,
+                               const FacetVolumeFiniteElement<D> & fel_facet,
+                               const ElementTransformation & eltrans,
+                               IntRange l2_dofs, IntRange facet_dofs,
+                               FlatMatrix<double> elmat, LocalHeap & lh) const
+    {
+      ELEMENT_TYPE eltype = fel_l2.ElementType();
+      int nfacet = ElementTopology::GetNFacets(eltype);
+      int nd_l2 = fel_l2.GetNDof();
+      double pen = alpha * sqr (fel_l2.Order()+1);
+
+      Facet2ElementTrafo transform(eltype); 
+
+      for (int k = 0; k < nfacet; k++)
+        {
+          HeapReset hr(lh);
+          ELEMENT_TYPE etfacet = ElementTopology::GetFacetType (eltype, k);
+          const SIMD_IntegrationRule & ir_facet = GetSIMDIntegrationRule (etfacet, 2*fel_l2.Order());
+          auto & mir = static_cast<SIMD_MappedIntegrationRule<D,D>&> (eltrans(transform(k, ir_facet, lh), lh));
+          mir.ComputeNormalsAndMeasure (eltype, k);
+          size_t nip = ir_facet.Size();
+
+          Array<int> facetdofs;
+          facetdofs = l2_dofs;
+          facetdofs += fel_facet.GetFacetDofs(k) + facet_dofs.First();
+          int nd = facetdofs.Size();
+
+          FlatMatrix<SIMD<double>> lam(1, nip, lh);
+          coef_lam -> Evaluate (mir, lam);
+
+          // rows of the B-matrix: du/dn and u - u_facet
+          FlatMatrix<SIMD<double>> bmat0(nd, nip, lh), bmat1(nd, nip, lh);
+          FlatMatrix<SIMD<double>> dbmat0(nd, nip, lh), dbmat1(nd, nip, lh);
+          FlatMatrix<SIMD<double>> dshape(D*nd_l2, nip, lh);
+          fel_l2.CalcShape (mir.IR(), bmat1.Rows(0, nd_l2));
+          fel_facet.Facet(k).CalcShape (mir.IR(), bmat1.Rows(nd_l2, nd));
+          fel_l2.CalcMappedDShape (mir, dshape);
+
+          for (size_t j = 0; j < nip; j++)
+            {
+              Vec<D,SIMD<double>> nv = mir[j].GetNV();
+              for (int i = 0; i < nd_l2; i++)
+                {
+                  SIMD<double> sum = 0.0;
+                  for (int l = 0; l < D; l++)
+                    sum += dshape(D*i+l, j) * nv(l);
+                  bmat0(i,j) = sum;
+                }
+              for (int i = nd_l2; i < nd; i++)
+                {
+                  bmat0(i,j) = 0.0;
+                  bmat1(i,j) = -bmat1(i,j);
+                }
+
+              SIMD<double> len = mir[j].GetMeasure();
+              SIMD<double> fac = lam(0,j) * len * ir_facet[j].Weight();
+              SIMD<double> d11 = pen * len / mir[j].GetJacobiDet();
+              for (int i = 0; i < nd; i++)
+                {
+                  dbmat0(i,j) = -fac * bmat1(i,j);
+                  dbmat1(i,j) = fac * (d11 * bmat1(i,j) - bmat0(i,j));
+                }
+            }
+
+          FlatMatrix<> comp_elmat(nd, nd, lh);
+          comp_elmat = 0.0;
+          AddABt (bmat0, dbmat0, comp_elmat);
+          AddABt (bmat1, dbmat1, comp_elmat);
+          elmat.Rows(facetdofs).Cols(facetdofs) += comp_elmat;
+        }
+    }
+
+    void ApplyElementMatrixSIMD (const FiniteElement & fel,
+                                 const ElementTransformation & eltrans, 
+                                 FlatVector<double> elx, FlatVector<double> ely,
+                                 LocalHeap & lh) const
+    {
+      HeapReset hr(lh);
+      auto & cfel      = static_cast<const CompoundFiniteElement&> (fel);
+      auto & fel_l2    = static_cast<const ScalarFiniteElement<D>&> (cfel[0]);
+      auto & fel_facet = static_cast<const FacetVolumeFiniteElement<D> &> (cfel[1]);
+      ELEMENT_TYPE eltype = cfel.ElementType();
+      IntRange l2_dofs    = cfel.GetRange (0);
+      IntRange facet_dofs = cfel.GetRange (1);
+      int order = fel_l2.Order();
+
+      ely = 0.0;
+
+      {
+        HeapReset hr(lh);
+        const SIMD_IntegrationRule & ir_vol = GetSIMDIntegrationRule (eltype, 2*order);
+        auto & mir_vol = static_cast<SIMD_MappedIntegrationRule<D,D>&> (eltrans(ir_vol, lh));
+
+        FlatMatrix<SIMD<double>> lam(1, ir_vol.Size(), lh);
+        FlatMatrix<SIMD<double>> grad(D, ir_vol.Size(), lh);
+        coef_lam -> Evaluate (mir_vol, lam);
+        fel_l2.EvaluateGrad (mir_vol, elx.Range(l2_dofs), grad);
+        for (size_t j = 0; j < ir_vol.Size(); j++)
+          {
+            SIMD<double> fac = lam(0,j) * mir_vol[j].GetWeight();
+            for (int l = 0; l < D; l++)
+              grad(l,j) *= fac;
+          }
+        fel_l2.AddGradTrans (mir_vol, grad, ely.Range(l2_dofs));
+      }
+
+      int nfacet = ElementTopology::GetNFacets(eltype);
+      double pen = alpha * ((order+1)*(order+D)/D);
+      Facet2ElementTrafo transform(eltype); 
+
+      for (int k = 0; k < nfacet; k++)
+        {
+          HeapReset hr(lh);
+          ELEMENT_TYPE etfacet = ElementTopology::GetFacetType (eltype, k);
+          const SIMD_IntegrationRule & ir_facet = GetSIMDIntegrationRule (etfacet, 2*order);
+          auto & mir = static_cast<SIMD_MappedIntegrationRule<D,D>&> (eltrans(transform(k, ir_facet, lh), lh));
+          mir.ComputeNormalsAndMeasure (eltype, k);
+          size_t nip = ir_facet.Size();
+          IntRange fdofs = fel_facet.GetFacetDofs(k) + facet_dofs.First();
+
+          FlatMatrix<SIMD<double>> lam(1, nip, lh);
+          FlatVector<SIMD<double>> u(nip, lh), ufacet(nip, lh);
+          FlatMatrix<SIMD<double>> grad(D, nip, lh);
+          coef_lam -> Evaluate (mir, lam);
+          fel_l2.Evaluate (mir.IR(), elx.Range(l2_dofs), u);
+          fel_l2.EvaluateGrad (mir, elx.Range(l2_dofs), grad);
+          fel_facet.Facet(k).Evaluate (mir.IR(), elx.Range(fdofs), ufacet);
+
+          for (size_t j = 0; j < nip; j++)
+            {
+              Vec<D,SIMD<double>> nv = mir[j].GetNV();
+              SIMD<double> dudn = 0.0;
+              for (int l = 0; l < D; l++)
+                dudn += grad(l,j) * nv(l);
+
+              SIMD<double> len = mir[j].GetMeasure();
+              SIMD<double> fac = lam(0,j) * len * ir_facet[j].Weight();
+              SIMD<double> d11 = pen * len / mir[j].GetJacobiDet();
+              SIMD<double> jump = u(j) - ufacet(j);
+              SIMD<double> db0 = -fac * jump;
+              SIMD<double> db1 = fac * (d11 * jump - dudn);
+
+              u(j) = db1;
+              ufacet(j) = -db1;
+              for (int l = 0; l < D; l++)
+                grad(l,j) = db0 * nv(l);
+            }
+
+          fel_l2.AddTrans (mir.IR(), u, ely.Range(l2_dofs));
+          fel_l2.AddGradTrans (mir, grad, ely.Range(l2_dofs));
+          fel_facet.Facet(k).AddTrans (mir.IR(), ufacet, ely.Range(fdofs));
+        }
+    }
   };
 
 
@@ -209,6 +209,19 @@ namespace ngfem
     elmat += helmat;
   }
   
+  void BilinearFormIntegrator ::
+  CalcElementMatrixBatch (FlatArray<const FiniteElement*> fels,
+                          FlatArray<const ElementTransformation*> trafos,
+                          FlatArray<FlatMatrix<double>> elmats,
+                          LocalHeap & lh) const
+  {
+    for (size_t i : Range(fels))
+      {
+        HeapReset hr(lh);
+        CalcElementMatrix (*fels[i], *trafos[i], elmats[i], lh);
+      }
+  }
+
 
 
   
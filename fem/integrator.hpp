@@ -276,6 +276,11 @@ namespace ngfem
     // evaluate something, e.g. energy, ...
     SymbolTable<shared_ptr<DifferentialOperator>> evaluators;
 
+    /// the bilinear-form keeps the element matrices and reuses them
+    bool cache_elmats = false;
+    /// constant factor applied to the cached element matrices
+    shared_ptr<CoefficientFunction> cache_factor;
+
   public:
     // typedef double TSCAL;
     ///
@@ -283,6 +288,16 @@ namespace ngfem
     ///
     virtual ~BilinearFormIntegrator ();
 
+    /// element matrices are computed once and scaled by factor at every assembly.
+    /// the matrices must not depend on anything else that changes
+    void SetCacheElementMatrices (bool cache, shared_ptr<CoefficientFunction> factor = nullptr)
+    {
+      cache_elmats = cache;
+      cache_factor = factor;
+    }
+    bool CacheElementMatrices () const { return cache_elmats; }
+    double CacheFactor () const { return cache_factor ? cache_factor->EvaluateConst() : 1.0; }
+
     /// generates symmetric matrix ? 
     virtual xbool IsSymmetric () const = 0;
 
@@ -328,6 +343,17 @@ namespace ngfem
                             const ElementTransformation & eltrans, 
                             FlatMatrix<Complex> elmat,
                             LocalHeap & lh) const;
+
+    /**
+       Computes the element matrices of several elements at once.
+       Integrators may process the batch in one kernel,
+       the default loops over the elements.
+    */
+    virtual void
+      CalcElementMatrixBatch (FlatArray<const FiniteElement*> fels,
+                              FlatArray<const ElementTransformation*> trafos,
+                              FlatArray<FlatMatrix<double>> elmats,
+                              LocalHeap & lh) const;
     
 
     
@@ -2211,6 +2211,11 @@ namespace ngfem
     Array<SIMD_IntegrationRule*> simd_prismrules;
     Array<SIMD_IntegrationRule*> simd_pyramidrules;
     Array<SIMD_IntegrationRule*> simd_hexrules;
+    // collapsed tensor product rules
+    Array<SIMD_IntegrationRule*> simd_tp_trigrules;
+    Array<SIMD_IntegrationRule*> simd_tp_tetrules;
+    Array<SIMD_IntegrationRule*> simd_tp_prismrules;
+    Array<SIMD_IntegrationRule*> simd_tp_pyramidrules;
     
     Array<IntegrationRule*> jacobirules10;
     Array<IntegrationRule*> jacobirules20;
@@ -2230,6 +2235,7 @@ namespace ngfem
     ///
     const IntegrationRule & SelectIntegrationRuleJacobi20 (int order) const;
     const SIMD_IntegrationRule & SIMD_SelectIntegrationRule (ELEMENT_TYPE eltyp, int order);
+    const SIMD_IntegrationRule & SIMD_SelectIntegrationRuleTP (ELEMENT_TYPE eltyp, int order);
     ///
     const IntegrationRule & GenerateIntegrationRule (ELEMENT_TYPE eltyp, int order);
     const IntegrationRule & GenerateIntegrationRuleJacobi10 (int order);
@@ -2246,6 +2252,22 @@ namespace ngfem
 
   IntegrationRules :: IntegrationRules ()
   {
+    // only the tabulated rules are set up here, all others are generated
+    // on first use. The tables get empty entries up front, then generating
+    // a rule (under a mutex) does not reallocate a table other threads read
+    auto presize = [] (auto & table)
+      {
+        table.SetSize (64);
+        table = nullptr;
+      };
+    for (auto table : { &segmentrules, &segmentrules_inv, &trigrules, &quadrules,
+          &tetrules, &prismrules, &pyramidrules, &hexrules, &jacobirules10, &jacobirules20 })
+      presize (*table);
+    for (auto table : { &simd_segmentrules, &simd_segmentrules_inv, &simd_trigrules,
+          &simd_quadrules, &simd_tetrules, &simd_prismrules, &simd_pyramidrules, &simd_hexrules,
+          &simd_tp_trigrules, &simd_tp_tetrules, &simd_tp_prismrules, &simd_tp_pyramidrules })
+      presize (*table);
+
     // ************************************
     // ** left/right points
     // ************************************
@@ -2264,22 +2286,11 @@ namespace ngfem
     simd_pointrule = SIMD_IntegrationRule (pointrule);
     // cout << "simd_pointrule: " << simd_pointrule << endl;
     
-    // ************************************
-    // ** Segment integration rules
-    // ************************************
-
-    for (int p = 0; p < 20; p++)
-      {
-        GenerateIntegrationRule (ET_SEGM, p);
-        SIMD_SelectIntegrationRule (ET_SEGM, p);
-      }
-
     // ************************************
     // ** Triangle integration rules
     // ************************************
 
 
-    trigrules.SetSize (7);
 
     static double qf_trig_order1_points[][3] = 
       {
@@ -2363,21 +2374,6 @@ namespace ngfem
     trigrules[6] = new IntegrationRule (12, qf_trig_order6_points, qf_trig_order6_weights);
 
 
-    for (int p = 7; p <= 10; p++)
-      GenerateIntegrationRule (ET_TRIG, p);
-    for (int p = 0; p <= 10; p++)    
-      SIMD_SelectIntegrationRule (ET_TRIG, p);
-
-
-    // ************************************
-    // ** Quadrilateral integration rules
-    // ************************************
-    
-    for (int p = 0; p <= 10; p++)
-      {
-        GenerateIntegrationRule (ET_QUAD, p);
-        SIMD_SelectIntegrationRule (ET_QUAD, p);
-      }
 
 
     // ************************************
@@ -2385,7 +2381,6 @@ namespace ngfem
     // ************************************
 
 
-    tetrules.SetSize(6);
 
     static double qf_tetra_order1_points[][3] = 
       { 
@@ -2447,55 +2442,22 @@ namespace ngfem
     tetrules[5] = new IntegrationRule (14, qf_tetra_order5_points, qf_tetra_order5_weights);    
 
 
-    for (int p = 6; p <= 10; p++)
-      GenerateIntegrationRule (ET_TET, p);
-    for (int p = 0; p <= 10; p++)
-      SIMD_SelectIntegrationRule (ET_TET, p);
     
 
-    // ************************************
-    // ** Prismatic integration rules
-    // ************************************
-
-    for (int p = 0; p <= 6; p++)
-      {
-        GenerateIntegrationRule (ET_PRISM, p);
-        SIMD_SelectIntegrationRule (ET_PRISM, p);
-      }
-
-
-    // ************************************
-    // ** Pyramid integration rules
-    // ************************************
-
-    for (int p = 0; p <= 6; p++)
-      {
-        GenerateIntegrationRule (ET_PYRAMID, p);
-        SIMD_SelectIntegrationRule (ET_PYRAMID, p);
-      }
-    
-    // ************************************
-    // ** Hexaeder integration rules
-    // ************************************
 
-    for (int p = 0; p <= 6; p++)
-      {
-        GenerateIntegrationRule (ET_HEX, p);
-        SIMD_SelectIntegrationRule (ET_HEX, p);
-      }
-    
 
 
 
 
 
+#ifdef DEBUG
     // cout << "Check trig intrule:";
     for (int order = 0; order < 6; order++)
       {
 	// cout << "order = " << order << endl;
 
 	const IntegrationRule & rule = *trigrules[order];
-	const IntegrationRule & rule2 = *trigrules[10];
+	const IntegrationRule & rule2 = SelectIntegrationRule (ET_TRIG, 10);
 
 	for (int ox = 0; ox <= order+2; ox++)
 	  for (int oy = 0; ox+oy <= order; oy++)
@@ -2524,7 +2486,7 @@ namespace ngfem
 	// cout << "order = " << order << endl;
 
 	const IntegrationRule & rule = *tetrules[order];
-	const IntegrationRule & rule2 = *tetrules[10];
+	const IntegrationRule & rule2 = SelectIntegrationRule (ET_TET, 10);
 
 	for (int ox = 0; ox <= order+2; ox++)
 	  for (int oy = 0; ox+oy <= order+2; oy++)
@@ -2547,15 +2509,7 @@ namespace ngfem
 		  cout << "ERROR, tet rule: \\int x^" << ox << " y^" << oy << " z^" << oz <<  " = " << sum << ", diff = " << sum-sum2 << endl;
 	      }
       }
-    
-
-
-
-    for (int i = 0; i < 50; i++)
-      {
-	GenerateIntegrationRuleJacobi10 (i);
-	GenerateIntegrationRuleJacobi20 (i);
-      }
+#endif
   }
 
 
@@ -3167,6 +3121,7 @@ namespace ngfem
               default:
                 ;
               }
+            tmp->SetPersistent();
             (*ira)[order] = tmp;
           }
       }
@@ -3174,6 +3129,97 @@ namespace ngfem
     return *((*ira)[order]);
   }
 
+  const SIMD_IntegrationRule & IntegrationRules :: SIMD_SelectIntegrationRuleTP (ELEMENT_TYPE eltype, int order)
+  {
+    Array<SIMD_IntegrationRule*> * ira;
+
+    switch (eltype)
+      {
+      case ET_SEGM: case ET_QUAD: case ET_HEX:
+        return SIMD_SelectIntegrationRule (eltype, order);
+      case ET_TRIG:
+	ira = &simd_tp_trigrules; break;
+      case ET_TET:
+	ira = &simd_tp_tetrules; break;
+      case ET_PYRAMID:
+	ira = &simd_tp_pyramidrules; break;
+      case ET_PRISM:
+	ira = &simd_tp_prismrules; break;
+      default:
+	{
+	  stringstream str;
+	  str << "no tensor product simd-integration rules for element " << int(eltype) << endl;
+	  throw Exception (str.str());
+	}
+      }
+
+    if (order < 0) 
+      { order = 0; }
+
+    // 1D rules in the collapsed coordinates, before locking
+    const IntegrationRule & gauss = SelectIntegrationRule (ET_SEGM, order);
+    const IntegrationRule & jacobi10 = SelectIntegrationRuleJacobi10 (order);
+    const IntegrationRule & jacobi20 = SelectIntegrationRuleJacobi20 (order);
+    const SIMD_IntegrationRule & simd_gauss = SIMD_SelectIntegrationRule (ET_SEGM, order);
+
+    lock_guard<mutex> guard(simd_genintrule_mutex[eltype]);
+
+    if (order >= ira->Size())
+      {
+        int oldsize = ira->Size();
+        ira->SetSize(order+2);
+        for (int i = oldsize; i < order+2; i++)
+          (*ira)[i] = nullptr;
+      }
+    if ((*ira)[order]) return *(*ira)[order];
+
+    const IntegrationRule *ir1d[3];
+    switch (eltype)
+      {
+      case ET_TRIG:    ir1d[0] = &jacobi10; ir1d[1] = &gauss; ir1d[2] = nullptr; break;
+      case ET_TET:     ir1d[0] = &jacobi20; ir1d[1] = &jacobi10; ir1d[2] = &gauss; break;
+      case ET_PRISM:   ir1d[0] = &jacobi10; ir1d[1] = &gauss; ir1d[2] = &gauss; break;
+      case ET_PYRAMID: ir1d[0] = &gauss; ir1d[1] = &gauss; ir1d[2] = &jacobi20; break;
+      default: ;
+      }
+    int nz = ir1d[2] ? ir1d[2]->Size() : 1;
+
+    IntegrationRule ir;
+    for (auto & ipx : *ir1d[0])
+      for (auto & ipy : *ir1d[1])
+        for (int iz = 0; iz < nz; iz++)
+          {
+            double x = ipx(0), y = ipy(0), z = ir1d[2] ? (*ir1d[2])[iz](0) : 0;
+            double w = ipx.Weight() * ipy.Weight() * (ir1d[2] ? (*ir1d[2])[iz].Weight() : 1);
+            switch (eltype)
+              {
+              case ET_TRIG:
+                ir.Append (IntegrationPoint (x, y*(1-x), 0, w*(1-x))); break;
+              case ET_TET:
+                ir.Append (IntegrationPoint (x, y*(1-x), z*(1-x)*(1-y),
+                                             w*sqr(1-x)*(1-y))); break;
+              case ET_PRISM:
+                ir.Append (IntegrationPoint (x, y*(1-x), z, w*(1-x))); break;
+              case ET_PYRAMID:
+                ir.Append (IntegrationPoint (x*(1-z), y*(1-z), z, w*sqr(1-z))); break;
+              default: ;
+              }
+          }
+    ir.SetDim (ElementTopology::GetSpaceDim(eltype));
+
+    auto tmp = new SIMD_IntegrationRule(ir);
+    const SIMD_IntegrationRule * simd_ir1d[3];
+    for (int d = 0; d < 3; d++)
+      simd_ir1d[d] = (ir1d[d] == &gauss) ? &simd_gauss :
+        (ir1d[d] ? new SIMD_IntegrationRule(*ir1d[d]) : nullptr);
+    tmp->SetIRX (simd_ir1d[0]);
+    tmp->SetIRY (simd_ir1d[1]);
+    tmp->SetIRZ (simd_ir1d[2]);
+    tmp->SetPersistent();
+    (*ira)[order] = tmp;
+    return *tmp;
+  }
+
   SIMD_IntegrationRule::SIMD_IntegrationRule (const IntegrationRule & ir)
     : Array<SIMD<IntegrationPoint>> (0, nullptr)
   {
@@ -3379,6 +3425,13 @@ namespace ngfem
     return intrules;
   }
 
+  // reversed segment rule, generated together with the segment rule
+  static const SIMD_IntegrationRule * SIMD_SegmentRuleInv (int order)
+  {
+    intrules.SIMD_SelectIntegrationRule (ET_SEGM, order);
+    return intrules.simd_segmentrules_inv[order];
+  }
+
 
   const IntegrationRule & SelectIntegrationRule (ELEMENT_TYPE eltype, int order)
   {
@@ -3400,6 +3453,11 @@ namespace ngfem
     return const_cast<IntegrationRules&>(GetIntegrationRules()).SIMD_SelectIntegrationRule (eltype, order);
   }
 
+  const SIMD_IntegrationRule & SIMD_SelectIntegrationRuleTP (ELEMENT_TYPE eltype, int order)
+  {
+    return const_cast<IntegrationRules&>(GetIntegrationRules()).SIMD_SelectIntegrationRuleTP (eltype, order);
+  }
+
 
 
 
@@ -3409,8 +3467,61 @@ namespace ngfem
 
   SIMD_IntegrationRule & Facet2ElementTrafo :: operator() (int fnr, const SIMD_IntegrationRule & irfacet, LocalHeap & lh)
   {
+    if (irfacet.IsPersistent())
+      return const_cast<SIMD_IntegrationRule&> (GetCachedSIMDRule (fnr, irfacet));
+
     SIMD_IntegrationRule & irvol = *new (lh) SIMD_IntegrationRule (irfacet.GetNIP(), lh);
+    MapSIMDRule (fnr, irfacet, irvol);
+    return irvol;
+  }
 
+
+  typedef std::array<size_t,3> T_FacetRuleKey;
+  static mutex facetrule_mutex;
+  static std::map<T_FacetRuleKey, const SIMD_IntegrationRule*> facetrule_table;
+  
+  const SIMD_IntegrationRule & Facet2ElementTrafo ::
+  GetCachedSIMDRule (int fnr, const SIMD_IntegrationRule & irfacet) const
+  {
+    // the map depends on the vertices of the facet in their sorted order
+    size_t verts = 0;
+    switch (FacetType(fnr))
+      {
+      case ET_POINT: break;
+      case ET_SEGM:
+        verts = size_t(edges[fnr][0]) | (size_t(edges[fnr][1]) << 8); break;
+      default:
+        for (int j = 0; j < 4; j++)
+          verts |= (size_t(faces[fnr][j]) & 255) << (8*j);
+      }
+    T_FacetRuleKey key = { size_t(&irfacet[0]),
+                           size_t(eltype) | (size_t(vb) << 8) | (size_t(fnr) << 16) | (size_t(swapped) << 32),
+                           verts };
+
+    static thread_local std::map<T_FacetRuleKey, const SIMD_IntegrationRule*> local;
+    auto pos = local.find(key);
+    if (pos != local.end()) return *pos->second;
+
+    lock_guard<mutex> guard(facetrule_mutex);
+    auto gpos = facetrule_table.find(key);
+    if (gpos == facetrule_table.end())
+      {
+        size_t size = irfacet.Size();
+        auto pts = (SIMD<IntegrationPoint>*) _mm_malloc(size*sizeof(SIMD<IntegrationPoint>),
+                                                        SIMD<double>::Size()*sizeof(double));
+        auto irvol = new SIMD_IntegrationRule (size, pts);
+        irvol->SetNIP (irfacet.GetNIP());
+        MapSIMDRule (fnr, irfacet, *irvol);
+        irvol->SetPersistent();
+        gpos = facetrule_table.emplace (key, irvol).first;
+      }
+    local[key] = gpos->second;
+    return *gpos->second;
+  }
+
+
+  void Facet2ElementTrafo :: MapSIMDRule (int fnr, const SIMD_IntegrationRule & irfacet, SIMD_IntegrationRule & irvol) const
+  {
     FlatArray<SIMD<IntegrationPoint>> hirfacet = irfacet;
     FlatArray<SIMD<IntegrationPoint>> hirvol = irvol;
     
@@ -3509,7 +3620,7 @@ namespace ngfem
                 else
                   {
                     int order = 2*irfacet.GetIRY().GetNIP()-1;
-                    irvol.SetIRZ (intrules.simd_segmentrules_inv[order]);
+                    irvol.SetIRZ (SIMD_SegmentRuleInv (order));
                   }
                 break;
               }
@@ -3522,7 +3633,7 @@ namespace ngfem
                 else
                   {
                     int order = 2*irfacet.GetIRY().GetNIP()-1;
-                    irvol.SetIRZ (intrules.simd_segmentrules_inv[order]);
+                    irvol.SetIRZ (SIMD_SegmentRuleInv (order));
                   }
                 break;
               }
@@ -3570,7 +3681,7 @@ namespace ngfem
                     else
                       {
                         int order = 2*irfacet.GetIRX().GetNIP()-1;
-                        ir1d = intrules.simd_segmentrules_inv[order];
+                        ir1d = SIMD_SegmentRuleInv (order);
                       }
                   }
                 switch (dir)
@@ -3593,8 +3704,6 @@ namespace ngfem
       default:
         ;
       }
-    
-    return irvol;
   }
 
 
@@ -502,6 +502,17 @@ namespace ngfem
 	}
       this->measure = fabs (det);
     }
+
+    /// take Jacobian, determinant and normals from a point of the
+    /// same affine element, instead of calling Compute
+    INLINE void SetAffineData (const MappedIntegrationPoint & mip)
+    {
+      dxdxi = mip.dxdxi;
+      det = mip.det;
+      normalvec = mip.normalvec;
+      tangentialvec = mip.tangentialvec;
+      this->measure = mip.measure;
+    }
   
     ///
     INLINE const Mat<DIMR,DIMS,SCAL> & GetJacobian() const { return dxdxi; }
@@ -1117,8 +1128,17 @@ namespace ngfem
     }
 
 
+    /**
+       Maps the facet rule to the element.  If irfacet is persistent, the
+       result is taken from a global cache keyed by the facet rule, the
+       facet number and the facet vertex orientation, it is persistent
+       itself and must not be modified.
+    */
     class SIMD_IntegrationRule & operator() (int fnr, const class SIMD_IntegrationRule & irfacet, LocalHeap & lh);
 
+  private:
+    void MapSIMDRule (int fnr, const class SIMD_IntegrationRule & irfacet, class SIMD_IntegrationRule & irvol) const;
+    const class SIMD_IntegrationRule & GetCachedSIMDRule (int fnr, const class SIMD_IntegrationRule & irfacet) const;
   };
 
 
@@ -1734,6 +1754,21 @@ namespace ngstd
 	}
       measure = fabs (det);
     }
+
+    /// broadcast Jacobian, determinant and normals of an affine element
+    INLINE void SetAffineData (const ngfem::MappedIntegrationPoint<DIMS,DIMR> & mip)
+    {
+      for (int i = 0; i < DIMR; i++)
+        for (int j = 0; j < DIMS; j++)
+          dxdxi(i,j) = mip.GetJacobian()(i,j);
+      for (int i = 0; i < DIMR; i++)
+        {
+          normalvec(i) = mip.GetNV()(i);
+          tangentialvec(i) = mip.GetTV()(i);
+        }
+      det = mip.GetJacobiDet();
+      measure = mip.GetMeasure();
+    }
   
     // SIMD<double> GetJacobiDet() const { return det; }
     ///
@@ -1963,6 +1998,7 @@ namespace ngfem
     int dimension = -1;
     size_t nip = -47;
     const SIMD_IntegrationRule *irx = nullptr, *iry = nullptr, *irz = nullptr; // for tensor product IR
+    bool persistent = false;  // points live until program end (global rules)
   public:
     SIMD_IntegrationRule () = default;
     inline SIMD_IntegrationRule (ELEMENT_TYPE eltype, int order);
@@ -1994,9 +2030,14 @@ namespace ngfem
       ir2.irx = irx;
       ir2.iry = iry;
       ir2.irz = irz;
+      ir2.persistent = persistent;
       return ir2;
     }
 
+    /// the point array is never freed, its address can be used as a cache key
+    bool IsPersistent() const { return persistent; }
+    void SetPersistent() { persistent = true; }
+
 
     
     bool IsTP() const { return irx != nullptr; } 
@@ -2010,6 +2051,17 @@ namespace ngfem
 
   extern NGS_DLL_HEADER const SIMD_IntegrationRule & SIMD_SelectIntegrationRule (ELEMENT_TYPE eltype, int order);
 
+  /**
+     Collapsed coordinate (Duffy) rules with 1D factors GetIRX/Y/Z for
+     trigs, tets, prisms and pyramids, points ordered as
+     (ix*ny+iy)*nz+iz.  The factors integrate in the collapsed
+     coordinates (x,y,z) -> trig (x, y(1-x)), tet (x, y(1-x), z(1-x)(1-y)),
+     prism (x, y(1-x), z), pyramid (x(1-z), y(1-z), z), the weights of
+     the rule include the Duffy determinant.  Segments, quads and hexes
+     get the standard rules.
+  */
+  extern NGS_DLL_HEADER const SIMD_IntegrationRule & SIMD_SelectIntegrationRuleTP (ELEMENT_TYPE eltype, int order);
+
   inline SIMD_IntegrationRule :: SIMD_IntegrationRule (ELEMENT_TYPE eltype, int order)
   { 
     const SIMD_IntegrationRule & ir = SIMD_SelectIntegrationRule (eltype, order);
@@ -2021,6 +2073,7 @@ namespace ngfem
     irx = ir.irx;
     iry = ir.iry;
     irz = ir.irz;
+    persistent = ir.persistent;
   }
 
 
@@ -2049,6 +2102,7 @@ namespace ngfem
       ir.SetIRY(&air.GetIRY());
       ir.SetIRZ(&air.GetIRZ());
       ir.SetNIP(air.GetNIP());
+      if (air.IsPersistent()) ir.SetPersistent();
     }
     ~SIMD_BaseMappedIntegrationRule ()
       { ir.NothingToDelete(); }
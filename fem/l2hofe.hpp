@@ -113,6 +113,14 @@ namespace ngfem
     HD NGS_DLL_HEADER virtual void Evaluate (const IntegrationRule & ir, BareSliceVector<double> coefs, FlatVector<double> vals) const;
     HD NGS_DLL_HEADER virtual void EvaluateTrans (const IntegrationRule & ir, FlatVector<> values, BareSliceVector<> coefs) const;
 
+    // sum factorization for tensor product rules on quads and hexes
+    HD NGS_DLL_HEADER virtual void Evaluate (const SIMD_IntegrationRule & ir, BareSliceVector<> coefs, BareVector<SIMD<double>> values) const override;
+    using BASE::AddTrans;
+    HD NGS_DLL_HEADER virtual void AddTrans (const SIMD_IntegrationRule & ir, BareVector<SIMD<double>> values, BareSliceVector<> coefs) const override;
+    HD NGS_DLL_HEADER virtual void EvaluateGrad (const SIMD_BaseMappedIntegrationRule & ir, BareSliceVector<> coefs, BareSliceMatrix<SIMD<double>> values) const override;
+    using BASE::AddGradTrans;
+    HD NGS_DLL_HEADER virtual void AddGradTrans (const SIMD_BaseMappedIntegrationRule & ir, BareSliceMatrix<SIMD<double>> values, BareSliceVector<> coefs) const override;
+
     using BASE::EvaluateGrad;    
     HD NGS_DLL_HEADER virtual void EvaluateGrad (const IntegrationRule & ir, BareSliceVector<> coefs, FlatMatrixFixWidth<DIM> values) const;
 
@@ -180,6 +188,454 @@ namespace ngfem
   }
 
 
+  // sum factorization needs points ordered as (ix*ny+iy)*nz+iz on hexes and
+  // ix*ny+iy on quads, which is not guaranteed for every rule carrying tp factors
+  template <int D>
+  inline bool IsTPRule (const SIMD_IntegrationRule & ir)
+  {
+    if (!ir.IsTP()) return false;
+    const SIMD_IntegrationRule * ir1d[3] = { &ir.GetIRX(), &ir.GetIRY(),
+                                             (D == 3) ? &ir.GetIRZ() : nullptr };
+    size_t n[3] = { 1, 1, 1 };
+    size_t nip = 1;
+    for (int d = 0; d < D; d++)
+      {
+        n[d] = ir1d[d]->GetNIP();
+        nip *= n[d];
+      }
+    if (nip != ir.GetNIP()) return false;
+
+    constexpr size_t SW = SIMD<double>::Size();
+    for (size_t ii = 0; ii < nip; ii++)
+      {
+        size_t rest = ii;
+        for (int d = D-1; d >= 0; d--)
+          {
+            size_t id = rest % n[d];
+            rest /= n[d];
+            if (ir[ii/SW](d)[ii%SW] != (*ir1d[d])[id/SW](0)[id%SW])
+              return false;
+          }
+      }
+    return true;
+  }
+
+  // fac(i,k) = L_i(s (2 x_k - 1)) for the points of the 1D rule,
+  // if dmem is given, it gets the derivatives with respect to x
+  inline SliceMatrix<> CalcLegendreFactors (int p, const SIMD_IntegrationRule & ir1d,
+                                            SIMD<double> * mem, double s = 1,
+                                            SIMD<double> * dmem = nullptr)
+  {
+    FlatMatrix<SIMD<double>> simd_fac(p+1, ir1d.Size(), mem);
+    FlatMatrix<SIMD<double>> simd_dfac(p+1, ir1d.Size(), dmem);
+    if (!dmem)
+      {
+        STACK_ARRAY(SIMD<double>, memx, ir1d.Size());
+        FlatVector<SIMD<double>> x(ir1d.Size(), &memx[0]);
+        for (size_t k = 0; k < ir1d.Size(); k++)
+          x(k) = s*(2*ir1d[k](0)-1.0);
+        LegendrePolynomial::EvalBatch (p, x, simd_fac);
+      }
+    else
+      for (size_t k = 0; k < ir1d.Size(); k++)
+        {
+          AutoDiff<1,SIMD<double>> x(ir1d[k](0), 0);
+          LegendrePolynomial::Eval (p, s*(2*x-1.0),
+                                    SBLambda([&] (size_t i, AutoDiff<1,SIMD<double>> val)
+                                             {
+                                               simd_fac(i,k) = val.Value();
+                                               simd_dfac(i,k) = val.DValue(0);
+                                             }));
+        }
+    return SliceMatrix<> (p+1, ir1d.GetNIP(), ir1d.Size()*SIMD<double>::Size(), &simd_fac(0,0)[0]);
+  }
+
+  inline SliceMatrix<> FactorMatrix (int p, const SIMD_IntegrationRule & ir1d, SIMD<double> * mem)
+  {
+    return SliceMatrix<> (p+1, ir1d.GetNIP(), ir1d.Size()*SIMD<double>::Size(), &mem[0][0]);
+  }
+
+
+  /*
+    Gradients from reference gradients, refgrad(k, i) is the derivative
+    in reference direction k at point i.  Rows of refgrad are padded to
+    full SIMD blocks.
+  */
+  template <int D>
+  inline void MapTPGradients (const SIMD_BaseMappedIntegrationRule & bmir,
+                              FlatMatrix<> refgrad, BareSliceMatrix<SIMD<double>> values)
+  {
+    constexpr size_t SW = SIMD<double>::Size();
+    auto & mir = static_cast<const SIMD_MappedIntegrationRule<D,D>&> (bmir);
+    for (size_t i = 0; i < mir.Size(); i++)
+      {
+        Mat<D,D,SIMD<double>> ijac = mir[i].GetJacobianInverse();
+        Vec<D,SIMD<double>> g;
+        for (int k = 0; k < D; k++)
+          g(k) = SIMD<double> (&refgrad(k,i*SW));
+        for (int l = 0; l < D; l++)
+          {
+            SIMD<double> sum = 0.0;
+            for (int k = 0; k < D; k++)
+              sum += ijac(k,l) * g(k);
+            values(l,i) = sum;
+          }
+      }
+  }
+
+  template <int D>
+  inline void MapTPGradientsTrans (const SIMD_BaseMappedIntegrationRule & bmir,
+                                   BareSliceMatrix<SIMD<double>> values, FlatMatrix<> refgrad)
+  {
+    constexpr size_t SW = SIMD<double>::Size();
+    auto & mir = static_cast<const SIMD_MappedIntegrationRule<D,D>&> (bmir);
+    for (size_t i = 0; i < mir.Size(); i++)
+      {
+        Mat<D,D,SIMD<double>> ijac = mir[i].GetJacobianInverse();
+        for (int k = 0; k < D; k++)
+          {
+            SIMD<double> sum = 0.0;
+            for (int l = 0; l < D; l++)
+              sum += ijac(k,l) * values(l,i);
+            sum.Store (&refgrad(k,i*SW));
+          }
+      }
+  }
+
+  
+  template <> inline void L2HighOrderFE<ET_HEX> ::
+  Evaluate (const SIMD_IntegrationRule & ir, BareSliceVector<> coefs, BareVector<SIMD<double>> values) const
+  {
+    if (!IsTPRule<3>(ir))
+      {
+        T_IMPL::Evaluate (ir, coefs, values);
+        return;
+      }
+    
+    auto & irx = ir.GetIRX();
+    auto & iry = ir.GetIRY();
+    auto & irz = ir.GetIRZ();
+    STACK_ARRAY(SIMD<double>, memx, (order_inner[0]+1)*irx.Size());
+    STACK_ARRAY(SIMD<double>, memy, (order_inner[1]+1)*iry.Size());
+    STACK_ARRAY(SIMD<double>, memz, (order_inner[2]+1)*irz.Size());
+    SliceMatrix<> facs[3] = { CalcLegendreFactors (order_inner[0], irx, memx),
+                              CalcLegendreFactors (order_inner[1], iry, memy),
+                              CalcLegendreFactors (order_inner[2], irz, memz) };
+
+    STACK_ARRAY(double, memc, ndof);
+    FlatVector<> hcoefs(ndof, &memc[0]);
+    for (int i = 0; i < ndof; i++)
+      hcoefs(i) = coefs(i);
+    FlatVector<> hvalues(ir.GetNIP(), &values(0)[0]);
+    ApplyTensorProductTrans (FlatArray<SliceMatrix<>> (3, facs), hcoefs, hvalues);
+  }
+
+  template <> inline void L2HighOrderFE<ET_HEX> ::
+  AddTrans (const SIMD_IntegrationRule & ir, BareVector<SIMD<double>> values, BareSliceVector<> coefs) const
+  {
+    if (!IsTPRule<3>(ir))
+      {
+        T_IMPL::AddTrans (ir, values, coefs);
+        return;
+      }
+    
+    auto & irx = ir.GetIRX();
+    auto & iry = ir.GetIRY();
+    auto & irz = ir.GetIRZ();
+    STACK_ARRAY(SIMD<double>, memx, (order_inner[0]+1)*irx.Size());
+    STACK_ARRAY(SIMD<double>, memy, (order_inner[1]+1)*iry.Size());
+    STACK_ARRAY(SIMD<double>, memz, (order_inner[2]+1)*irz.Size());
+    SliceMatrix<> facs[3] = { CalcLegendreFactors (order_inner[0], irx, memx),
+                              CalcLegendreFactors (order_inner[1], iry, memy),
+                              CalcLegendreFactors (order_inner[2], irz, memz) };
+
+    STACK_ARRAY(double, memc, ndof);
+    FlatVector<> hcoefs(ndof, &memc[0]);
+    FlatVector<> hvalues(ir.GetNIP(), &values(0)[0]);
+    ApplyTensorProduct (FlatArray<SliceMatrix<>> (3, facs), hvalues, hcoefs);
+    for (int i = 0; i < ndof; i++)
+      coefs(i) += hcoefs(i);
+  }
+
+  template <> inline void L2HighOrderFE<ET_HEX> ::
+  EvaluateGrad (const SIMD_BaseMappedIntegrationRule & bmir, BareSliceVector<> coefs,
+                BareSliceMatrix<SIMD<double>> values) const
+  {
+    auto & ir = bmir.IR();
+    if (bmir.DimSpace() != 3 || !IsTPRule<3>(ir))
+      {
+        T_IMPL::EvaluateGrad (bmir, coefs, values);
+        return;
+      }
+
+    const SIMD_IntegrationRule * ir1d[3] = { &ir.GetIRX(), &ir.GetIRY(), &ir.GetIRZ() };
+    size_t n[3];
+    for (int d = 0; d < 3; d++)
+      n[d] = (order_inner[d]+1)*ir1d[d]->Size();
+    STACK_ARRAY(SIMD<double>, mem, 2*(n[0]+n[1]+n[2]));
+    SIMD<double> * pmem[3] = { &mem[0], &mem[2*n[0]], &mem[2*(n[0]+n[1])] };
+    SliceMatrix<> facs[3] =
+      { CalcLegendreFactors (order_inner[0], *ir1d[0], pmem[0], 1, pmem[0]+n[0]),
+        CalcLegendreFactors (order_inner[1], *ir1d[1], pmem[1], 1, pmem[1]+n[1]),
+        CalcLegendreFactors (order_inner[2], *ir1d[2], pmem[2], 1, pmem[2]+n[2]) };
+    SliceMatrix<> dfacs[3] =
+      { FactorMatrix (order_inner[0], *ir1d[0], pmem[0]+n[0]),
+        FactorMatrix (order_inner[1], *ir1d[1], pmem[1]+n[1]),
+        FactorMatrix (order_inner[2], *ir1d[2], pmem[2]+n[2]) };
+
+    STACK_ARRAY(double, memc, ndof);
+    FlatVector<> hcoefs(ndof, &memc[0]);
+    for (int i = 0; i < ndof; i++)
+      hcoefs(i) = coefs(i);
+
+    constexpr size_t SW = SIMD<double>::Size();
+    STACK_ARRAY(double, memg, 3*ir.Size()*SW);
+    FlatMatrix<> refgrad(3, ir.Size()*SW, &memg[0]);
+    for (int k = 0; k < 3; k++)
+      {
+        SliceMatrix<> mats[3] = { (k == 0) ? dfacs[0] : facs[0],
+                                  (k == 1) ? dfacs[1] : facs[1],
+                                  (k == 2) ? dfacs[2] : facs[2] };
+        FlatVector<> gk(ir.GetNIP(), &refgrad(k,0));
+        ApplyTensorProductTrans (FlatArray<SliceMatrix<>> (3, mats), hcoefs, gk);
+      }
+    MapTPGradients<3> (bmir, refgrad, values);
+  }
+
+  template <> inline void L2HighOrderFE<ET_HEX> ::
+  AddGradTrans (const SIMD_BaseMappedIntegrationRule & bmir, BareSliceMatrix<SIMD<double>> values,
+                BareSliceVector<> coefs) const
+  {
+    auto & ir = bmir.IR();
+    if (bmir.DimSpace() != 3 || !IsTPRule<3>(ir))
+      {
+        T_IMPL::AddGradTrans (bmir, values, coefs);
+        return;
+      }
+
+    const SIMD_IntegrationRule * ir1d[3] = { &ir.GetIRX(), &ir.GetIRY(), &ir.GetIRZ() };
+    size_t n[3];
+    for (int d = 0; d < 3; d++)
+      n[d] = (order_inner[d]+1)*ir1d[d]->Size();
+    STACK_ARRAY(SIMD<double>, mem, 2*(n[0]+n[1]+n[2]));
+    SIMD<double> * pmem[3] = { &mem[0], &mem[2*n[0]], &mem[2*(n[0]+n[1])] };
+    SliceMatrix<> facs[3] =
+      { CalcLegendreFactors (order_inner[0], *ir1d[0], pmem[0], 1, pmem[0]+n[0]),
+        CalcLegendreFactors (order_inner[1], *ir1d[1], pmem[1], 1, pmem[1]+n[1]),
+        CalcLegendreFactors (order_inner[2], *ir1d[2], pmem[2], 1, pmem[2]+n[2]) };
+    SliceMatrix<> dfacs[3] =
+      { FactorMatrix (order_inner[0], *ir1d[0], pmem[0]+n[0]),
+        FactorMatrix (order_inner[1], *ir1d[1], pmem[1]+n[1]),
+        FactorMatrix (order_inner[2], *ir1d[2], pmem[2]+n[2]) };
+
+    constexpr size_t SW = SIMD<double>::Size();
+    STACK_ARRAY(double, memg, 3*ir.Size()*SW);
+    FlatMatrix<> refgrad(3, ir.Size()*SW, &memg[0]);
+    MapTPGradientsTrans<3> (bmir, values, refgrad);
+
+    STACK_ARRAY(double, memc, 2*ndof);
+    FlatVector<> hcoefs(ndof, &memc[0]), sum(ndof, &memc[ndof]);
+    sum = 0.0;
+    for (int k = 0; k < 3; k++)
+      {
+        SliceMatrix<> mats[3] = { (k == 0) ? dfacs[0] : facs[0],
+                                  (k == 1) ? dfacs[1] : facs[1],
+                                  (k == 2) ? dfacs[2] : facs[2] };
+        FlatVector<> gk(ir.GetNIP(), &refgrad(k,0));
+        ApplyTensorProduct (FlatArray<SliceMatrix<>> (3, mats), gk, hcoefs);
+        sum += hcoefs;
+      }
+    for (int i = 0; i < ndof; i++)
+      coefs(i) += sum(i);
+  }
+
+
+
+  /*
+    The quad basis is L_i(xi) L_j(eta) with xi, eta from the vertex
+    ordering.  xi = s0 (2 t_d0 - 1) and eta = s1 (2 t_d1 - 1) for point
+    coordinates t, d1 = 1-d0.  If d0 == 1, the coefficient tensor is
+    transposed into point order.
+  */
+  inline void GetQuadTPOrientation (INT<4> f, int & d0, double & s0, double & s1)
+  {
+    int dsx[4] = { -1, 1, 1, -1 };
+    int dsy[4] = { -1, -1, 1, 1 };
+    int ax = dsx[f[0]]-dsx[f[1]], ay = dsy[f[0]]-dsy[f[1]];
+    int bx = dsx[f[0]]-dsx[f[3]], by = dsy[f[0]]-dsy[f[3]];
+    d0 = (ax != 0) ? 0 : 1;
+    s0 = 0.5 * (ax+ay);
+    s1 = 0.5 * (bx+by);
+  }
+
+  /*
+    Factor matrices in point coordinate order for L2 quads, facs[d] and
+    dfacs[d] belong to point coordinate d.  The memory must hold
+    2*(order+1)*(irx.Size()+iry.Size()) SIMDs.
+  */
+  class QuadTPFactors
+  {
+    SIMD<double> * mem;
+    size_t n[2];
+    double s[2];
+    int p[2];
+    bool grad;
+  public:
+    int d0;
+    
+    QuadTPFactors (INT<2> order_inner, INT<4> f, const SIMD_IntegrationRule & ir,
+                   SIMD<double> * amem, bool agrad)
+      : mem(amem), grad(agrad)
+    {
+      GetQuadTPOrientation (f, d0, s[0], s[1]);
+      // p[d], s[d] for point coordinate d
+      if (d0 == 1) swap (s[0], s[1]);
+      p[0] = order_inner[d0];
+      p[1] = order_inner[1-d0];
+      n[0] = (p[0]+1)*ir.GetIRX().Size();
+      n[1] = (p[1]+1)*ir.GetIRY().Size();
+    }
+
+    SliceMatrix<> Fac (const SIMD_IntegrationRule & ir1d, int d) const
+    {
+      SIMD<double> * pmem = mem + (d == 0 ? 0 : 2*n[0]);
+      return CalcLegendreFactors (p[d], ir1d, pmem, s[d], grad ? pmem+n[d] : nullptr);
+    }
+    SliceMatrix<> DFac (const SIMD_IntegrationRule & ir1d, int d) const
+    {
+      SIMD<double> * pmem = mem + (d == 0 ? 0 : 2*n[0]);
+      return FactorMatrix (p[d], ir1d, pmem+n[d]);
+    }
+  };
+
+  // copies coefficients (i,j) to point order, i.e. (j,i) if d0 == 1
+  inline void QuadCoefsToPointOrder (int d0, INT<2> p, BareSliceVector<> coefs, FlatVector<> hcoefs)
+  {
+    for (int i = 0, ii = 0; i <= p[0]; i++)
+      for (int j = 0; j <= p[1]; j++, ii++)
+        hcoefs(d0 == 0 ? ii : j*(p[0]+1)+i) = coefs(ii);
+  }
+
+  inline void QuadCoefsAddFromPointOrder (int d0, INT<2> p, FlatVector<> hcoefs, BareSliceVector<> coefs)
+  {
+    for (int i = 0, ii = 0; i <= p[0]; i++)
+      for (int j = 0; j <= p[1]; j++, ii++)
+        coefs(ii) += hcoefs(d0 == 0 ? ii : j*(p[0]+1)+i);
+  }
+
+  
+  template <> inline void L2HighOrderFE<ET_QUAD> ::
+  Evaluate (const SIMD_IntegrationRule & ir, BareSliceVector<> coefs, BareVector<SIMD<double>> values) const
+  {
+    if (!IsTPRule<2>(ir))
+      {
+        T_IMPL::Evaluate (ir, coefs, values);
+        return;
+      }
+
+    STACK_ARRAY(SIMD<double>, mem, 2*(order+1)*(ir.GetIRX().Size()+ir.GetIRY().Size()));
+    QuadTPFactors tpf(order_inner, GetFaceSort (0, vnums), ir, &mem[0], false);
+    int d0 = tpf.d0;
+    SliceMatrix<> facs[2] = { tpf.Fac (ir.GetIRX(), 0), tpf.Fac (ir.GetIRY(), 1) };
+
+    STACK_ARRAY(double, memc, ndof);
+    FlatVector<> hcoefs(ndof, &memc[0]);
+    QuadCoefsToPointOrder (d0, order_inner, coefs, hcoefs);
+    FlatVector<> hvalues(ir.GetNIP(), &values(0)[0]);
+    ApplyTensorProductTrans (FlatArray<SliceMatrix<>> (2, facs), hcoefs, hvalues);
+  }
+
+  template <> inline void L2HighOrderFE<ET_QUAD> ::
+  AddTrans (const SIMD_IntegrationRule & ir, BareVector<SIMD<double>> values, BareSliceVector<> coefs) const
+  {
+    if (!IsTPRule<2>(ir))
+      {
+        T_IMPL::AddTrans (ir, values, coefs);
+        return;
+      }
+
+    STACK_ARRAY(SIMD<double>, mem, 2*(order+1)*(ir.GetIRX().Size()+ir.GetIRY().Size()));
+    QuadTPFactors tpf(order_inner, GetFaceSort (0, vnums), ir, &mem[0], false);
+    int d0 = tpf.d0;
+    SliceMatrix<> facs[2] = { tpf.Fac (ir.GetIRX(), 0), tpf.Fac (ir.GetIRY(), 1) };
+
+    STACK_ARRAY(double, memc, ndof);
+    FlatVector<> hcoefs(ndof, &memc[0]);
+    FlatVector<> hvalues(ir.GetNIP(), &values(0)[0]);
+    ApplyTensorProduct (FlatArray<SliceMatrix<>> (2, facs), hvalues, hcoefs);
+    QuadCoefsAddFromPointOrder (d0, order_inner, hcoefs, coefs);
+  }
+
+  template <> inline void L2HighOrderFE<ET_QUAD> ::
+  EvaluateGrad (const SIMD_BaseMappedIntegrationRule & bmir, BareSliceVector<> coefs,
+                BareSliceMatrix<SIMD<double>> values) const
+  {
+    auto & ir = bmir.IR();
+    if (bmir.DimSpace() != 2 || !IsTPRule<2>(ir))
+      {
+        T_IMPL::EvaluateGrad (bmir, coefs, values);
+        return;
+      }
+
+    STACK_ARRAY(SIMD<double>, mem, 2*(order+1)*(ir.GetIRX().Size()+ir.GetIRY().Size()));
+    QuadTPFactors tpf(order_inner, GetFaceSort (0, vnums), ir, &mem[0], true);
+    int d0 = tpf.d0;
+    SliceMatrix<> facs[2] = { tpf.Fac (ir.GetIRX(), 0), tpf.Fac (ir.GetIRY(), 1) };
+    SliceMatrix<> dfacs[2] = { tpf.DFac (ir.GetIRX(), 0), tpf.DFac (ir.GetIRY(), 1) };
+
+    STACK_ARRAY(double, memc, ndof);
+    FlatVector<> hcoefs(ndof, &memc[0]);
+    QuadCoefsToPointOrder (d0, order_inner, coefs, hcoefs);
+
+    constexpr size_t SW = SIMD<double>::Size();
+    STACK_ARRAY(double, memg, 2*ir.Size()*SW);
+    FlatMatrix<> refgrad(2, ir.Size()*SW, &memg[0]);
+    for (int k = 0; k < 2; k++)
+      {
+        SliceMatrix<> mats[2] = { (k == 0) ? dfacs[0] : facs[0],
+                                  (k == 1) ? dfacs[1] : facs[1] };
+        FlatVector<> gk(ir.GetNIP(), &refgrad(k,0));
+        ApplyTensorProductTrans (FlatArray<SliceMatrix<>> (2, mats), hcoefs, gk);
+      }
+    MapTPGradients<2> (bmir, refgrad, values);
+  }
+
+  template <> inline void L2HighOrderFE<ET_QUAD> ::
+  AddGradTrans (const SIMD_BaseMappedIntegrationRule & bmir, BareSliceMatrix<SIMD<double>> values,
+                BareSliceVector<> coefs) const
+  {
+    auto & ir = bmir.IR();
+    if (bmir.DimSpace() != 2 || !IsTPRule<2>(ir))
+      {
+        T_IMPL::AddGradTrans (bmir, values, coefs);
+        return;
+      }
+
+    STACK_ARRAY(SIMD<double>, mem, 2*(order+1)*(ir.GetIRX().Size()+ir.GetIRY().Size()));
+    QuadTPFactors tpf(order_inner, GetFaceSort (0, vnums), ir, &mem[0], true);
+    int d0 = tpf.d0;
+    SliceMatrix<> facs[2] = { tpf.Fac (ir.GetIRX(), 0), tpf.Fac (ir.GetIRY(), 1) };
+    SliceMatrix<> dfacs[2] = { tpf.DFac (ir.GetIRX(), 0), tpf.DFac (ir.GetIRY(), 1) };
+
+    constexpr size_t SW = SIMD<double>::Size();
+    STACK_ARRAY(double, memg, 2*ir.Size()*SW);
+    FlatMatrix<> refgrad(2, ir.Size()*SW, &memg[0]);
+    MapTPGradientsTrans<2> (bmir, values, refgrad);
+
+    STACK_ARRAY(double, memc, 2*ndof);
+    FlatVector<> hcoefs(ndof, &memc[0]), sum(ndof, &memc[ndof]);
+    sum = 0.0;
+    for (int k = 0; k < 2; k++)
+      {
+        SliceMatrix<> mats[2] = { (k == 0) ? dfacs[0] : facs[0],
+                                  (k == 1) ? dfacs[1] : facs[1] };
+        FlatVector<> gk(ir.GetNIP(), &refgrad(k,0));
+        ApplyTensorProduct (FlatArray<SliceMatrix<>> (2, mats), gk, hcoefs);
+        sum += hcoefs;
+      }
+    QuadCoefsAddFromPointOrder (d0, order_inner, sum, coefs);
+  }
+
 }
 
 #else
@@ -254,6 +254,35 @@ namespace ngfem
   }
 
 
+  template <ELEMENT_TYPE ET, class SHAPES, class BASE>
+  void L2HighOrderFE<ET,SHAPES,BASE> :: 
+  Evaluate (const SIMD_IntegrationRule & ir, BareSliceVector<> coefs, BareVector<SIMD<double>> values) const
+  {
+    BASE::Evaluate (ir, coefs, values);
+  }
+
+  template <ELEMENT_TYPE ET, class SHAPES, class BASE>
+  void L2HighOrderFE<ET,SHAPES,BASE> :: 
+  AddTrans (const SIMD_IntegrationRule & ir, BareVector<SIMD<double>> values, BareSliceVector<> coefs) const
+  {
+    BASE::AddTrans (ir, values, coefs);
+  }
+
+  template <ELEMENT_TYPE ET, class SHAPES, class BASE>
+  void L2HighOrderFE<ET,SHAPES,BASE> :: 
+  EvaluateGrad (const SIMD_BaseMappedIntegrationRule & ir, BareSliceVector<> coefs, BareSliceMatrix<SIMD<double>> values) const
+  {
+    BASE::EvaluateGrad (ir, coefs, values);
+  }
+
+  template <ELEMENT_TYPE ET, class SHAPES, class BASE>
+  void L2HighOrderFE<ET,SHAPES,BASE> :: 
+  AddGradTrans (const SIMD_BaseMappedIntegrationRule & ir, BareSliceMatrix<SIMD<double>> values, BareSliceVector<> coefs) const
+  {
+    BASE::AddGradTrans (ir, values, coefs);
+  }
+
+
   
 
 
@@ -19,6 +19,8 @@ namespace ngfem
 
 
 
+  constexpr int MAX_FO_TET = 6;
+
   template<>
   ScalarFiniteElement<3> * CreateL2HighOrderFE<ET_TET> (int order, FlatArray<int> vnums, Allocator & lh)
   {
@@ -27,27 +29,17 @@ namespace ngfem
     // if (false)
       { // new standard orientation
         if (vnums[2] < vnums[3])
-          {
-            switch (order)
-              {
-              case 0: hofe = new (lh)  L2HighOrderFEFO<ET_TET,0, FixedOrientation<0,1,2,3>> (); break;
-              case 1: hofe = new (lh)  L2HighOrderFEFO<ET_TET,1, FixedOrientation<0,1,2,3>> (); break;
-              case 2: hofe = new (lh)  L2HighOrderFEFO<ET_TET,2, FixedOrientation<0,1,2,3>> (); break;
-                // case 3: return new (lh)  L2HighOrderFEFO<ET_TET,3, FixedOrientation<0,1,2,3>> (); break;
-              default: ; 
-              }
-          }
+          Iterate<MAX_FO_TET+1> ([&hofe,&lh,order] (auto nr)
+                                 {
+                                   if (nr.value == order)
+                                     hofe = new (lh)  L2HighOrderFEFO<ET_TET,nr.value, FixedOrientation<0,1,2,3>> ();
+                                 });
         else
-          {
-            switch (order)
-              {
-              case 0: hofe = new (lh)  L2HighOrderFEFO<ET_TET,0, FixedOrientation<0,1,3,2>> (); break;
-              case 1: hofe = new (lh)  L2HighOrderFEFO<ET_TET,1, FixedOrientation<0,1,3,2>> (); break;
-              case 2: hofe = new (lh)  L2HighOrderFEFO<ET_TET,2, FixedOrientation<0,1,3,2>> (); break;
-                // case 3: return new (lh)  L2HighOrderFEFO<ET_TET,3, FixedOrientation<0,1,3,2>> (); break;                
-              default: ; 
-              }
-          }
+          Iterate<MAX_FO_TET+1> ([&hofe,&lh,order] (auto nr)
+                                 {
+                                   if (nr.value == order)
+                                     hofe = new (lh)  L2HighOrderFEFO<ET_TET,nr.value, FixedOrientation<0,1,3,2>> ();
+                                 });
       }
 
     if (!hofe)
@@ -197,12 +197,8 @@ struct GenericBSpline {
   GenericBSpline( shared_ptr<BSpline> asp ) : sp(asp) {;}
   template <typename T> T operator() (T x) const { return (*sp)(x); }
   Complex operator() (Complex x) const { return (*sp)(x.real()); }
-  SIMD<double> operator() (SIMD<double> x) const
-  { return SIMD<double>([&](int i)->double { return (*sp)(x[i]); } );}
   SIMD<Complex> operator() (SIMD<Complex> x) const
-  { return SIMD<double>([&](int i)->double { return (*sp)(x.real()[i]); } );}
-  AutoDiff<1,SIMD<double>> operator() (AutoDiff<1,SIMD<double>> x) const { throw ExceptionNOSIMD ("AutoDiff for bspline not supported"); }
-  AutoDiffDiff<1,SIMD<double>> operator() (AutoDiffDiff<1,SIMD<double>> x) const { throw ExceptionNOSIMD ("AutoDiffDiff for bspline not supported"); }  
+  { return (*sp)(x.real()); }
 };
 struct GenericSin {
   template <typename T> T operator() (T x) const { return sin(x); }
@@ -510,6 +506,41 @@ else_obj : object
 )raw_string"))
     ;
   
+  m.def ("Compile", [] (py::list cfs, bool realcompile, int maxderiv, bool wait)
+         {
+           auto ccfs = makeCArraySharedPtr<shared_ptr<CF>> (cfs);
+           py::list compiled;
+           {
+             py::gil_scoped_release release;
+             ccfs = Compile (ccfs, realcompile, maxderiv, wait);
+           }
+           for (auto cf : ccfs)
+             compiled.append (py::cast(cf));
+           return compiled;
+         },
+         py::arg("cfs"), py::arg("realcompile")=false,
+         py::arg("maxderiv")=2, py::arg("wait")=false, docu_string(R"raw_string(
+Compile a list of CoefficientFunctions, e.g. all CFs used by the integrators
+of a BilinearForm. With realcompile=True all of them are compiled into one
+shared library, a few CFs share one translation unit and the units are
+compiled in parallel. Returns the list of compiled CFs.
+
+Parameters:
+
+cfs : list
+  CoefficientFunctions to compile
+
+realcompile : bool
+  True -> Compile to C++ code, see CoefficientFunction.Compile
+
+maxderiv : int
+  input maximal derivative
+
+wait : bool
+  True -> Waits until the compilation is finished
+
+)raw_string"));
+  
   m.def("CoordCF", 
         [] (int direction)
         { return MakeCoordinateCoefficientFunction(direction); }, py::arg("direction"),
@@ -987,7 +1018,10 @@ Compile list of individual steps, experimental improvement for deep trees
 Parameters:
 
 realcompile : bool
-  True -> Compile to C++ code
+  True -> Compile to C++ code. The shared libraries are cached in
+  $NGSOLVE_CACHE_DIR (default ~/.cache/ngsolve/compiled_cf), set
+  NGSOLVE_NO_COMPILE_CACHE to always recompile. Without a compiler only
+  cached libraries are used, otherwise the CF is evaluated interpreted.
 
 maxderiv : int
   input maximal derivative
@@ -1245,7 +1279,9 @@ vals : list
     .def("__call__", &BSpline::Evaluate)
     .def("__call__", [](shared_ptr<BSpline> sp, shared_ptr<CF> coef)
           {
-            return UnaryOpCF (coef, GenericBSpline(sp) /* , GenericBSpline(sp) */);
+            if (coef->IsComplex())
+              return UnaryOpCF (coef, GenericBSpline(sp) /* , GenericBSpline(sp) */);
+            return MakeBSplineCoefficientFunction (sp, coef);
           }, py::arg("cf"))
     .def("Integrate", 
          [](const BSpline & sp) { return make_shared<BSpline>(sp.Integrate()); }, "Integrate the BSpline")
@@ -1971,6 +2007,22 @@ Parameters:
 bitarray : ngsolve.ngstd.BitArray
   input bitarray
 
+)raw_string") )
+    .def("CacheElementMatrices", [] (shared_ptr<BFI> self, shared_ptr<CoefficientFunction> factor)
+         {
+           self->SetCacheElementMatrices (true, factor);
+           return self;
+         }, py::arg("factor")=nullptr, docu_string(R"raw_string(
+Store the element matrices of this integrator at the first assembly and
+reuse them in later assemblies. Only valid if the integrand does not change
+between assemblies, up to a constant scalar factor.
+
+Parameters:
+
+factor : ngsolve.fem.CoefficientFunction
+  input constant coefficient function (e.g. a Parameter) multiplied onto the
+  cached element matrices at every assembly
+
 )raw_string") )
     .def("SetIntegrationRule", [] (shared_ptr<BFI> self, ELEMENT_TYPE et, IntegrationRule ir)
          {
@@ -526,6 +526,50 @@ namespace ngfem
     }
 
 
+    /*
+      Batch evaluation in many points, values(i,k) = P_i(x(k)).
+      The recursion runs level by level, so the coefficients of a level
+      are loaded once and the loop over the points vectorizes.
+    */
+    template <class TX, class TV>
+    static void EvalBatch (int n, const TX & x, TV && values)
+    {
+      typedef typename std::decay<decltype(x(0))>::type S;
+      size_t np = x.Size();
+      if (n < 0) return;
+      for (size_t k = 0; k < np; k++)
+        values(0,k) = REC::P0(x(k));
+      if (n < 1) return;
+      for (size_t k = 0; k < np; k++)
+        values(1,k) = REC::P1(x(k));
+      for (int i = 2; i <= n; i++)
+        {
+          double a = REC::A(i), b = REC::B(i), c = REC::C(i);
+          for (size_t k = 0; k < np; k++)
+            values(i,k) = FMA(FMA(S(a), x(k), S(b)), values(i-1,k), c*values(i-2,k));
+        }
+    }
+
+    /// values(i,k) = y(k)^i P_i(x(k)/y(k))
+    template <class TX, class TV>
+    static void EvalScaledBatch (int n, const TX & x, const TX & y, TV && values)
+    {
+      typedef typename std::decay<decltype(x(0))>::type S;
+      size_t np = x.Size();
+      if (n < 0) return;
+      for (size_t k = 0; k < np; k++)
+        values(0,k) = REC::P0(x(k));
+      if (n < 1) return;
+      for (size_t k = 0; k < np; k++)
+        values(1,k) = REC::P1(x(k),y(k));
+      for (int i = 2; i <= n; i++)
+        {
+          double a = REC::A(i), b = REC::B(i), c = REC::C(i);
+          for (size_t k = 0; k < np; k++)
+            values(i,k) = FMA(FMA(S(a), x(k), b*y(k)), values(i-1,k), c*(y(k)*y(k))*values(i-2,k));
+        }
+    }
+
     template <int N, class S, class Sc, class T>
     INLINE static void EvalMult (IC<N> n, S x, Sc c, T && values) 
     {
@@ -1081,6 +1125,46 @@ namespace ngfem
       */
     }
 
+    /// batch evaluation in many points, values(i,k) = P_i(x(k)), see RecursivePolynomial
+    template <class TX, class TV>
+    void EvalBatch (int n, const TX & x, TV && values) const
+    {
+      typedef typename std::decay<decltype(x(0))>::type S;
+      size_t np = x.Size();
+      if (n < 0) return;
+      for (size_t k = 0; k < np; k++)
+        values(0,k) = Cast().P0(x(k));
+      if (n < 1) return;
+      for (size_t k = 0; k < np; k++)
+        values(1,k) = Cast().P1(x(k));
+      for (int i = 2; i <= n; i++)
+        {
+          double a = Cast().A(i), b = Cast().B(i), c = Cast().C(i);
+          for (size_t k = 0; k < np; k++)
+            values(i,k) = FMA(FMA(S(a), x(k), S(b)), values(i-1,k), c*values(i-2,k));
+        }
+    }
+
+    /// values(i,k) = y(k)^i P_i(x(k)/y(k))
+    template <class TX, class TV>
+    void EvalScaledBatch (int n, const TX & x, const TX & y, TV && values) const
+    {
+      typedef typename std::decay<decltype(x(0))>::type S;
+      size_t np = x.Size();
+      if (n < 0) return;
+      for (size_t k = 0; k < np; k++)
+        values(0,k) = Cast().P0(x(k));
+      if (n < 1) return;
+      for (size_t k = 0; k < np; k++)
+        values(1,k) = Cast().P1(x(k),y(k));
+      for (int i = 2; i <= n; i++)
+        {
+          double a = Cast().A(i), b = Cast().B(i), c = Cast().C(i);
+          for (size_t k = 0; k < np; k++)
+            values(i,k) = FMA(FMA(S(a), x(k), b*y(k)), values(i-1,k), c*(y(k)*y(k))*values(i-2,k));
+        }
+    }
+
     template <int N, class S, class Sc, class T>
     INLINE void EvalMult (IC<N> n, S x, Sc c, T && values) const
     {
@@ -1465,18 +1549,48 @@ namespace ngfem
     // static INLINE S P1(S x, S y) { return 0.5 * (2*(al+1)*y+(al+be+2)*(x-y)); }
     static INLINE S P1(S x, S y) { return 0.5*(al+be+2)*x+0.5*(al-be)*y; }
       
-    static INLINE double CalcA (int i) 
+    static constexpr INLINE double CalcA (int i) 
     { i--; return (2.0*i+al+be)*(2*i+al+be+1)*(2*i+al+be+2) / ( 2 * (i+1) * (i+al+be+1) * (2*i+al+be)); }
-    static INLINE double CalcB (int i)
+    static constexpr INLINE double CalcB (int i)
     { i--; return (2.0*i+al+be+1)*(al*al-be*be) / ( 2 * (i+1) * (i+al+be+1) * (2*i+al+be)); }
-    static INLINE double CalcC (int i) 
+    static constexpr INLINE double CalcC (int i) 
     { i--; return -2.0*(i+al)*(i+be) * (2*i+al+be+2) / ( 2 * (i+1) * (i+al+be+1) * (2*i+al+be)); }
 
+#ifndef __CUDA_ARCH__
+    // recursion coefficients tabulated at compile time, A(i) for i < MAXN
+    // is a load instead of the rational expression
+    static constexpr int MAXN = 32;
+    struct T_Coefs { double a[MAXN], b[MAXN], c[MAXN]; };
+
+    static constexpr T_Coefs MakeCoefs ()
+    {
+      T_Coefs tab { };
+      // A(0), A(1) are not used by the recursion
+      for (int i = 2; i < MAXN; i++)
+        {
+          tab.a[i] = CalcA(i);
+          tab.b[i] = CalcB(i);
+          tab.c[i] = CalcC(i);
+        }
+      return tab;
+    }
+    static constexpr T_Coefs coefs = MakeCoefs();
+
+    static INLINE double A (int i) { return (i < MAXN) ? coefs.a[i] : CalcA (i); }
+    static INLINE double B (int i) { return (i < MAXN) ? coefs.b[i] : CalcB (i); }
+    static INLINE double C (int i) { return (i < MAXN) ? coefs.c[i] : CalcC (i); }
+#else
     static INLINE double A (int i) { return CalcA (i); }
     static INLINE double B (int i) { return CalcB (i); }
     static INLINE double C (int i) { return CalcC (i); }
+#endif
   };
 
+#ifndef __CUDA_ARCH__
+  template <int al, int be>
+  constexpr typename JacobiPolynomialFix<al,be>::T_Coefs JacobiPolynomialFix<al,be>::coefs;
+#endif
+
 
 
   class JacobiPolynomial2 : public RecursivePolynomialNonStatic<JacobiPolynomial2>
@@ -0,0 +1,78 @@
+/*********************************************************************/
+/* File:   shapecache.cpp                                            */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+#include <fem.hpp>
+#include <unordered_map>
+
+namespace ngfem
+{
+
+  struct ShapeCacheKeyHash
+  {
+    size_t operator() (const ReferenceShapeCache::Key & key) const
+    {
+      size_t h = 0;
+      for (auto k : key)
+        h = h * 0x9e3779b97f4a7c15ull + (k ^ (k >> 29));
+      return h;
+    }
+  };
+
+  typedef std::unordered_map<ReferenceShapeCache::Key,
+                             const ReferenceShapeCache::Entry*,
+                             ShapeCacheKeyHash> T_ShapeCacheTable;
+
+  static mutex shapecache_mutex;
+  static std::unordered_map<ReferenceShapeCache::Key,
+                            unique_ptr<ReferenceShapeCache::Entry>,
+                            ShapeCacheKeyHash> shapecache_table;
+  static size_t shapecache_mem = 0;
+  // stop inserting if the cache exceeds this size (in bytes)
+  static constexpr size_t shapecache_max_mem = size_t(256) << 20;
+
+  static T_ShapeCacheTable & LocalShapeCache ()
+  {
+    static thread_local T_ShapeCacheTable local;
+    return local;
+  }
+
+  const ReferenceShapeCache::Entry * ReferenceShapeCache :: Get (const Key & key)
+  {
+    auto & local = LocalShapeCache();
+    auto pos = local.find(key);
+    if (pos != local.end()) return pos->second;
+
+    lock_guard<mutex> guard(shapecache_mutex);
+    auto gpos = shapecache_table.find(key);
+    if (gpos == shapecache_table.end()) return nullptr;
+    local[key] = gpos->second.get();
+    return gpos->second.get();
+  }
+
+  const ReferenceShapeCache::Entry * ReferenceShapeCache ::
+  Insert (const Key & key, unique_ptr<Entry> entry)
+  {
+    size_t mem = sizeof(SIMD<double>) *
+      (entry->shape.Height()*entry->shape.Width() + entry->dshape.Height()*entry->dshape.Width());
+
+    const Entry * stored;
+    {
+      lock_guard<mutex> guard(shapecache_mutex);
+      auto pos = shapecache_table.find(key);
+      if (pos != shapecache_table.end())
+        stored = pos->second.get();
+      else
+        {
+          if (shapecache_mem + mem > shapecache_max_mem) return nullptr;
+          shapecache_mem += mem;
+          stored = entry.get();
+          shapecache_table[key] = move(entry);
+        }
+    }
+    LocalShapeCache()[key] = stored;
+    return stored;
+  }
+
+}
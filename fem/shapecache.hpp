@@ -0,0 +1,49 @@
+#ifndef FILE_SHAPECACHE
+#define FILE_SHAPECACHE
+
+/*********************************************************************/
+/* File:   shapecache.hpp                                            */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+namespace ngfem
+{
+
+  /**
+     Global cache of reference shape functions and reference gradients
+     on persistent SIMD integration rules.
+
+     The key describes everything the shape functions depend on
+     (element class, element type, orders, vertex orientation), the
+     last component is the address of the integration point array.
+     Entries are never removed, so pointers to them stay valid.
+     Lookups go to a thread-local table first, only misses lock the
+     global table.
+  */
+  class NGS_DLL_HEADER ReferenceShapeCache
+  {
+  public:
+    typedef std::array<size_t,6> Key;
+
+    struct Entry
+    {
+      /// shape functions, ndof x ir.Size()
+      Matrix<SIMD<double>> shape;
+      /// reference gradients, row DIM*i+k is d shape_i / d x_k
+      Matrix<SIMD<double>> dshape;
+    };
+
+    /// nullptr if not cached
+    static const Entry * Get (const Key & key);
+
+    /**
+        Stores a new entry, returns the entry in the cache, which is
+        the one from another thread if it came first.  Returns nullptr
+        if the cache is full.
+    */
+    static const Entry * Insert (const Key & key, unique_ptr<Entry> entry);
+  };
+
+}
+
+#endif
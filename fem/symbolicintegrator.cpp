@@ -11,6 +11,12 @@
 
 namespace ngfem
 {
+
+  size_t ProxyUserData :: NewStamp()
+  {
+    static atomic<size_t> counter{0};
+    return ++counter;
+  }
   
   ProxyFunction ::
   ProxyFunction (shared_ptr<ngcomp::FESpace> afes,
@@ -1285,6 +1291,9 @@ namespace ngfem
                             NgProfiler::AddThreadFlops(timer_SymbBFImultsym, TaskManager::GetThreadId(),
                             SIMD<double>::Size()*2*r2.Size()*(r1.Size()+1)*hbbmat2.Width() / 2);
                           */
+                          NgProfiler::AddThreadFlops (t, TaskManager::GetThreadId(),
+                                                      sqr(sizeof(SCAL)/sizeof(double)) * SIMD<double>::Size()
+                                                      * r2.Size()*(r1.Size()+1)*hbbmat2.Width());
                           AddABtSym (hbbmat2.Rows(r2), hbdbmat1.Rows(r1), part_elmat);
                         }
                       else
@@ -1294,6 +1303,9 @@ namespace ngfem
                           NgProfiler::AddThreadFlops(timer_SymbBFImult, TaskManager::GetThreadId(),
                                                      SIMD<double>::Size()*2*r2.Size()*r1.Size()*hbbmat2.Width());
                           */
+                          NgProfiler::AddThreadFlops (t, TaskManager::GetThreadId(),
+                                                      sqr(sizeof(SCAL)/sizeof(double)) * SIMD<double>::Size()
+                                                      * 2*r2.Size()*r1.Size()*hbbmat2.Width());
                           AddABt (hbbmat2.Rows(r2), hbdbmat1.Rows(r1), part_elmat);
                         }
                       }
@@ -1589,6 +1601,205 @@ namespace ngfem
   }
 
 
+  void
+  SymbolicBilinearFormIntegrator ::
+  CalcElementMatrixBatch (FlatArray<const FiniteElement*> fels,
+                          FlatArray<const ElementTransformation*> trafos,
+                          FlatArray<FlatMatrix<double>> elmats,
+                          LocalHeap & lh) const
+  {
+    constexpr size_t SW = SIMD<double>::Size();
+    size_t nb = fels.Size();
+
+    // one element per SIMD lane, needs elements of the same type and order
+    bool batchable = simd_evaluate && element_vb == VOL && !cf->IsComplex()
+      && nb > 1 && nb <= SW;
+    if (batchable)
+      for (size_t e : Range(nb))
+        {
+          const FiniteElement & fel = *fels[e];
+          if (typeid(fel) != typeid(*fels[0]) || typeid(fel) == typeid(const MixedFiniteElement&) ||
+              fel.GetNDof() != fels[0]->GetNDof() || fel.Order() != fels[0]->Order() ||
+              fel.ComplexShapes() || trafos[e]->IsComplex() ||
+              elmats[e].Height() != elmats[0].Height() || elmats[e].Width() != elmats[0].Width())
+            batchable = false;
+        }
+    if (!batchable)
+      {
+        BilinearFormIntegrator::CalcElementMatrixBatch (fels, trafos, elmats, lh);
+        return;
+      }
+
+    static Timer t("SymbolicBFI::CalcElementMatrixBatch", 2);
+    ThreadRegionTimer reg(t, TaskManager::GetThreadId());
+    
+    try
+      {
+        HeapReset hr(lh);
+        const FiniteElement & fel = *fels[0];
+        const SIMD_IntegrationRule & ir = Get_SIMD_IntegrationRule (fel, lh);
+        size_t np = ir.Size()*SW;
+        auto lane = [] (SIMD<double> & x, size_t e) -> double& { return ((double*)&x)[e]; };
+        
+        FlatArray<SIMD_BaseMappedIntegrationRule*> mirs(nb, lh);
+        for (size_t e : Range(nb))
+          mirs[e] = &(*trafos[e])(ir, lh);
+
+        FlatMatrix<SIMD<double>> batch_elmat(elmats[0].Height(), elmats[0].Width(), lh);
+        batch_elmat = SIMD<double>(0.0);
+
+        int k1 = 0, k1nr = 0;
+        for (auto proxy1 : trial_proxies)
+          {
+            int l1 = 0, l1nr = 0;
+            for (auto proxy2 : test_proxies)
+              {
+                size_t dim_proxy1 = proxy1->Dimension();
+                size_t dim_proxy2 = proxy2->Dimension();
+                size_t tt_pair = l1nr*trial_proxies.Size()+k1nr;
+
+                if (nonzeros_proxies(tt_pair))
+                  {
+                    HeapReset hr(lh);
+                    bool is_diagonal = diagonal_proxies(tt_pair);
+                    bool samediffop = same_diffops(tt_pair);
+
+                    size_t w = batch_elmat.Width(), h = batch_elmat.Height();
+                    FlatMatrix<SIMD<double>> dvals(np, dim_proxy1*dim_proxy2, lh);
+                    FlatMatrix<SIMD<double>> bmat1(np*dim_proxy1, w, lh);
+                    FlatMatrix<SIMD<double>> bmat2(np*dim_proxy2, h, lh);
+                    dvals = SIMD<double>(0.0);
+                    bmat1 = SIMD<double>(0.0);
+                    bmat2 = SIMD<double>(0.0);
+
+                    for (size_t e : Range(nb))
+                      {
+                        HeapReset hr(lh);
+                        SIMD_BaseMappedIntegrationRule & mir = *mirs[e];
+                        ProxyUserData ud;
+                        const_cast<ElementTransformation&>(*trafos[e]).userdata = &ud;
+                        ud.trialfunction = proxy1;
+                        ud.testfunction = proxy2;
+
+                        FlatMatrix<SIMD<double>> proxyvalues(dim_proxy1*dim_proxy2, ir.Size(), lh);
+                        proxyvalues = SIMD<double>(0.0);
+                        for (size_t k = 0, kk = 0; k < dim_proxy1; k++)
+                          for (size_t l = 0; l < dim_proxy2; l++, kk++)
+                            if (is_diagonal ? k == l : nonzeros(l1+l, k1+k))
+                              {
+                                ud.trial_comp = k;
+                                ud.test_comp = l;
+                                cf -> Evaluate (mir, proxyvalues.Rows(kk,kk+1));
+                              }
+                        for (size_t i = 0; i < ir.Size(); i++)
+                          proxyvalues.Col(i) *= mir[i].GetWeight();
+
+                        FlatMatrix<SIMD<double>> bbmat1(w*dim_proxy1, ir.Size(), lh);
+                        FlatMatrix<SIMD<double>> bbmat2 = samediffop ?
+                          bbmat1 : FlatMatrix<SIMD<double>>(h*dim_proxy2, ir.Size(), lh);
+                        proxy1->Evaluator()->CalcMatrix(fel, mir, bbmat1);
+                        if (!samediffop)
+                          proxy2->Evaluator()->CalcMatrix(fel, mir, bbmat2);
+
+                        // transpose to point-major layout, element e goes to lane e
+                        for (size_t p = 0; p < np; p++)
+                          {
+                            size_t q = p / SW, lq = p % SW;
+                            for (size_t kk = 0; kk < dim_proxy1*dim_proxy2; kk++)
+                              lane(dvals(p,kk), e) = proxyvalues(kk,q)[lq];
+                            for (size_t i = 0; i < w; i++)
+                              for (size_t k = 0; k < dim_proxy1; k++)
+                                lane(bmat1(p*dim_proxy1+k, i), e) = bbmat1(i*dim_proxy1+k, q)[lq];
+                            for (size_t i = 0; i < h; i++)
+                              for (size_t l = 0; l < dim_proxy2; l++)
+                                lane(bmat2(p*dim_proxy2+l, i), e) = bbmat2(i*dim_proxy2+l, q)[lq];
+                          }
+                      }
+
+                    IntRange r1 = proxy1->Evaluator()->UsedDofs(fel);
+                    IntRange r2 = proxy2->Evaluator()->UsedDofs(fel);
+                    AddBtDB_Batch (bmat1.Cols(r1), dvals, bmat2.Cols(r2),
+                                   batch_elmat.Rows(r2).Cols(r1), lh);
+                  }
+                l1 += proxy2->Dimension();
+                l1nr++;
+              }
+            k1 += proxy1->Dimension();
+            k1nr++;
+          }
+
+        for (size_t e : Range(nb))
+          for (size_t i = 0; i < batch_elmat.Height(); i++)
+            for (size_t j = 0; j < batch_elmat.Width(); j++)
+              elmats[e](i,j) = lane(batch_elmat(i,j), e);
+      }
+    catch (ExceptionNOSIMD e)
+      {
+        cout << IM(6) << e.What() << endl
+             << "switching to scalar evaluation" << endl;
+        simd_evaluate = false;
+        BilinearFormIntegrator::CalcElementMatrixBatch (fels, trafos, elmats, lh);
+      }
+  }
+
+
+  bool SymbolicBilinearFormIntegrator :: HasDiagonalFactorization () const
+  {
+    return element_vb == VOL && !cf->IsComplex() &&
+      trial_proxies.Size() == 1 && test_proxies.Size() == 1 &&
+      nonzeros_proxies(0,0) && diagonal_proxies(0,0);
+  }
+
+  void SymbolicBilinearFormIntegrator ::
+  CalcFactorizationB (const FiniteElement & fel,
+                      const BaseMappedIntegrationRule & mir,
+                      FlatMatrix<double> btrial,
+                      FlatMatrix<double> btest,
+                      LocalHeap & lh) const
+  {
+    HeapReset hr(lh);
+    bool is_mixedfe = typeid(fel) == typeid(const MixedFiniteElement&);
+    const MixedFiniteElement * mixedfe = static_cast<const MixedFiniteElement*> (&fel);
+    const FiniteElement & fel_trial = is_mixedfe ? mixedfe->FETrial() : fel;
+    const FiniteElement & fel_test = is_mixedfe ? mixedfe->FETest() : fel;
+
+    FlatMatrix<double> bbmat1(btrial.Width(), btrial.Height(), lh);
+    FlatMatrix<double> bbmat2(btest.Width(), btest.Height(), lh);
+    bbmat1 = 0.0;
+    bbmat2 = 0.0;
+    trial_proxies[0]->Evaluator()->CalcMatrix (fel_trial, mir, Trans(bbmat1), lh);
+    test_proxies[0]->Evaluator()->CalcMatrix (fel_test, mir, Trans(bbmat2), lh);
+    btrial = Trans(bbmat1);
+    btest = Trans(bbmat2);
+  }
+
+  void SymbolicBilinearFormIntegrator ::
+  CalcFactorizationD (const BaseMappedIntegrationRule & mir,
+                      FlatVector<double> d,
+                      LocalHeap & lh) const
+  {
+    HeapReset hr(lh);
+    auto proxy1 = trial_proxies[0];
+    auto proxy2 = test_proxies[0];
+    size_t dim = proxy1->Dimension();
+
+    ProxyUserData ud;
+    const_cast<ElementTransformation&>(mir.GetTransformation()).userdata = &ud;
+
+    FlatMatrix<double> val(mir.Size(), 1, lh);
+    for (size_t k = 0; k < dim; k++)
+      {
+        ud.trialfunction = proxy1;
+        ud.trial_comp = k;
+        ud.testfunction = proxy2;
+        ud.test_comp = k;
+        cf -> Evaluate (mir, val);
+        for (size_t i = 0; i < mir.Size(); i++)
+          d(i*dim+k) = mir[i].GetWeight() * val(i,0);
+      }
+  }
+
+
   
 
   template <typename SCAL, typename SCAL_SHAPES, typename SCAL_RES>
@@ -2486,6 +2697,109 @@ namespace ngfem
   }
 
 
+  void
+  SymbolicBilinearFormIntegrator :: ApplyElementMatrix (const FiniteElement & fel, 
+                                                        const ElementTransformation & trafo, 
+                                                        const FlatVector<Complex> elx, 
+                                                        FlatVector<Complex> ely,
+                                                        void * precomputed,
+                                                        LocalHeap & lh) const
+  {
+    // the form is linear in the trial function, so real and imaginary
+    // part of elx are applied separately, without the element matrix
+    if (element_vb != VOL || !simd_evaluate)
+      {
+        BilinearFormIntegrator::ApplyElementMatrix (fel, trafo, elx, ely, precomputed, lh);
+        return;
+      }
+
+    HeapReset hr(lh);
+    FlatVector<> elxpart(elx.Size(), lh);
+    FlatVector<> elyre(ely.Size(), lh);
+    FlatVector<> elyim(ely.Size(), lh);
+    
+    if (!cf->IsComplex())
+      {
+        elxpart = Real(elx);
+        ApplyElementMatrix (fel, trafo, elxpart, elyre, precomputed, lh);
+        elxpart = Imag(elx);
+        ApplyElementMatrix (fel, trafo, elxpart, elyim, precomputed, lh);
+        for (size_t i = 0; i < ely.Size(); i++)
+          ely(i) = Complex(elyre(i), elyim(i));
+        return;
+      }
+
+    try
+      {
+        bool is_mixed = typeid(fel) == typeid(const MixedFiniteElement&);
+        const MixedFiniteElement * mixedfe = static_cast<const MixedFiniteElement*> (&fel);    
+        const FiniteElement & fel_trial = is_mixed ? mixedfe->FETrial() : fel;
+        const FiniteElement & fel_test = is_mixed ? mixedfe->FETest() : fel;
+
+        const SIMD_IntegrationRule& simd_ir = Get_SIMD_IntegrationRule (fel, lh);
+        auto & simd_mir = trafo(simd_ir, lh);
+          
+        ProxyUserData ud(trial_proxies.Size(), gridfunction_cfs.Size(), lh);
+        const_cast<ElementTransformation&>(trafo).userdata = &ud;
+        ud.fel = &fel;
+        for (ProxyFunction * proxy : trial_proxies)
+          ud.AssignMemory (proxy, simd_ir.GetNIP(), proxy->Dimension(), lh);
+        for (CoefficientFunction * cf : gridfunction_cfs)
+          ud.AssignMemory (cf, simd_ir.GetNIP(), cf->Dimension(), lh);
+
+        elyre = 0;
+        elyim = 0;
+        for (int part = 0; part < 2; part++)
+          {
+            if (part == 0)
+              elxpart = Real(elx);
+            else
+              elxpart = Imag(elx);
+            Complex fac = (part == 0) ? Complex(1) : Complex(0,1);
+            
+            for (ProxyFunction * proxy : trial_proxies)
+              proxy->Evaluator()->Apply(fel_trial, simd_mir, elxpart, ud.GetAMemory(proxy)); 
+          
+            for (auto proxy : test_proxies)
+              {
+                HeapReset hr(lh);
+                FlatMatrix<SIMD<Complex>> simd_proxyvalues(proxy->Dimension(), simd_ir.Size(), lh);
+                for (int k = 0; k < proxy->Dimension(); k++)
+                  {
+                    ud.testfunction = proxy;
+                    ud.test_comp = k;
+                    cf -> Evaluate (simd_mir, simd_proxyvalues.Rows(k,k+1));
+                  }
+
+                FlatMatrix<SIMD<double>> valre(proxy->Dimension(), simd_ir.Size(), lh);
+                FlatMatrix<SIMD<double>> valim(proxy->Dimension(), simd_ir.Size(), lh);
+                for (size_t i = 0; i < simd_proxyvalues.Height(); i++)
+                  for (size_t j = 0; j < simd_proxyvalues.Width(); j++)
+                    {
+                      SIMD<Complex> val = simd_proxyvalues(i,j);
+                      val *= fac;
+                      val *= simd_mir[j].GetWeight();
+                      valre(i,j) = val.real();
+                      valim(i,j) = val.imag();
+                    }
+                proxy->Evaluator()->AddTrans(fel_test, simd_mir, valre, elyre);
+                proxy->Evaluator()->AddTrans(fel_test, simd_mir, valim, elyim);
+              }
+          }
+
+        for (size_t i = 0; i < ely.Size(); i++)
+          ely(i) = Complex(elyre(i), elyim(i));
+      }
+    catch (ExceptionNOSIMD e)
+      {
+        cout << IM(6) << e.What() << endl
+             << "switching to scalar evaluation" << endl;
+        simd_evaluate = false;
+        ApplyElementMatrix (fel, trafo, elx, ely, precomputed, lh);
+      }
+  }
+
+
  
   
   
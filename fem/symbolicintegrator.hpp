@@ -256,6 +256,9 @@ public:
   const FiniteElement * fel = nullptr;
   // const FlatVector<double> * elx;
   // LocalHeap * lh;
+  /// unique id, identifies the element evaluation using this userdata
+  size_t stamp = NewStamp();
+  NGS_DLL_HEADER static size_t NewStamp();
 
   ProxyUserData ()
     : remember_first(0,nullptr), remember_second(0,nullptr), remember_asecond(0,nullptr),
@@ -631,6 +634,32 @@ public:
                           FlatMatrix<Complex> elmat,
                           LocalHeap & lh) const override;    
 
+    /// elements of the batch are interleaved across SIMD lanes
+    virtual void
+    CalcElementMatrixBatch (FlatArray<const FiniteElement*> fels,
+                            FlatArray<const ElementTransformation*> trafos,
+                            FlatArray<FlatMatrix<double>> elmats,
+                            LocalHeap & lh) const override;
+
+    /*
+      Factorization elmat = Trans(B_test) diag(D) B_trial for device assembly.
+      Available for real volume forms with one trial and one test proxy
+      coupling diagonally. B does not change with the coefficient, only D
+      has to be recomputed for re-assembly.
+    */
+    NGS_DLL_HEADER bool HasDiagonalFactorization () const;
+    /// components of the proxy per integration point
+    int FactorizationDim () const { return trial_proxies[0]->Dimension(); }
+    /// row p*dim+k is component k in point p, the matrices are npts*dim x ndof
+    NGS_DLL_HEADER void CalcFactorizationB (const FiniteElement & fel,
+                                            const BaseMappedIntegrationRule & mir,
+                                            FlatMatrix<double> btrial,
+                                            FlatMatrix<double> btest,
+                                            LocalHeap & lh) const;
+    /// coefficient times integration weight, npts*dim values
+    NGS_DLL_HEADER void CalcFactorizationD (const BaseMappedIntegrationRule & mir,
+                                            FlatVector<double> d,
+                                            LocalHeap & lh) const;
     
     template <typename SCAL, typename SCAL_SHAPES, typename SCAL_RES>
     void T_CalcElementMatrixAdd (const FiniteElement & fel,
@@ -666,6 +695,14 @@ public:
 			void * precomputed,
 			LocalHeap & lh) const override;
 
+    virtual void 
+    ApplyElementMatrix (const FiniteElement & fel, 
+			const ElementTransformation & trafo, 
+			const FlatVector<Complex> elx, 
+			FlatVector<Complex> ely,
+			void * precomputed,
+			LocalHeap & lh) const override;
+
     template <typename SCAL, typename SCAL_SHAPES>
     void T_ApplyElementMatrixEB (const FiniteElement & fel, 
                                  const ElementTransformation & trafo, 
@@ -125,7 +125,22 @@
 #endif
 
 
+#if defined(__aarch64__)
+#include <arm_neon.h>
+// replacements for the few x86 intrinsics used outside of the SIMD classes
+inline void _mm_pause () { __asm__ __volatile__ ("yield"); }
+inline void * _mm_malloc (size_t size, size_t align)
+{
+  void * p = nullptr;
+  if (posix_memalign (&p, align < sizeof(void*) ? sizeof(void*) : align, size)) return nullptr;
+  return p;
+}
+inline void _mm_free (void * p) { free (p); }
+#define _MM_HINT_T2 1
+#define _mm_prefetch(p, hint) __builtin_prefetch((p), 0, (hint))
+#else
 #include <immintrin.h>
+#endif
 
 
 #ifndef __assume
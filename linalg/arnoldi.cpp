@@ -161,8 +161,220 @@ namespace ngla
   } 
 	
 
+  template <typename SCAL>
+  void ShiftInvertArnoldi<SCAL>::SetShift (SCAL ashift)
+  {
+    static Timer t("shift-invert arnoldi - factor");
+    RegionTimer reg(t);
+    shift = ashift;
+
+    if (!mat_shift)
+      mat_shift = a.CreateMatrix();
+    mat_shift->AsVector() = a.AsVector() - shift*b.AsVector();
+
+    auto fact = dynamic_pointer_cast<SparseFactorization> (inv);
+    if (fact && fact->SupportsUpdate())
+      {
+        fact->Update();
+        nupdate++;
+        return;
+      }
+    if (inversetype != "")
+      mat_shift->SetInverseType (inversetype);
+    inv = mat_shift->InverseMatrix (freedofs);
+    nfactor++;
+  }
+
+
+  // y_j = inv * b * x_j  for the vectors of the block
+  static void ApplyBlock (const BaseMatrix & inv, const BaseMatrix & b,
+                          FlatArray<shared_ptr<BaseVector>> x,
+                          FlatArray<shared_ptr<BaseVector>> y,
+                          BaseVector & hv, double)
+  {
+    if (x.Size() == 1 || hv.EntrySize() != 1)
+      {
+        for (size_t j = 0; j < x.Size(); j++)
+          {
+            hv = b * *x[j];
+            *y[j] = inv * hv;
+          }
+        return;
+      }
+
+    // one solve with all right hand sides
+    MultiVector bx(hv.Size(), x.Size()), ix(hv.Size(), x.Size());
+    for (size_t j = 0; j < x.Size(); j++)
+      {
+        hv = b * *x[j];
+        bx.SetVector (j, hv);
+      }
+    inv.MultAdd (1, bx, ix);
+    for (size_t j = 0; j < x.Size(); j++)
+      {
+        ix.GetVector (j, *y[j]);
+        y[j]->SetParallelStatus (DISTRIBUTED);
+        y[j]->Cumulate();
+      }
+  }
+
+  static void ApplyBlock (const BaseMatrix & inv, const BaseMatrix & b,
+                          FlatArray<shared_ptr<BaseVector>> x,
+                          FlatArray<shared_ptr<BaseVector>> y,
+                          BaseVector & hv, Complex)
+  {
+    for (size_t j = 0; j < x.Size(); j++)
+      {
+        hv = b * *x[j];
+        *y[j] = inv * hv;
+      }
+  }
+  
+  
+  template <typename SCAL>
+  int ShiftInvertArnoldi<SCAL>::Calc (int maxdim, int nev, Array<Complex> & lam,
+                                      Array<shared_ptr<BaseVector>> & hevecs,
+                                      function<void(FlatArray<Complex>)> callback) const
+  {
+    static Timer t("shift-invert arnoldi");
+    static Timer tsolve("shift-invert arnoldi - solve");
+    static Timer torth("shift-invert arnoldi - orthogonalize");
+    static Timer tritz("shift-invert arnoldi - ritz values");
+    RegionTimer reg(t);
+
+    if (!inv)
+      throw Exception ("ShiftInvertArnoldi: call SetShift before Calc");
+
+    auto hv = a.CreateVector();
+    int n = hv.template FV<SCAL>().Size();
+    int bs = min2 (blocksize, n);
+    int m = max2 (bs, (min2 (maxdim, n) / bs) * bs);
+    nev = min2 (nev, m);
+
+    Array<shared_ptr<BaseVector>> v(m+bs);
+    for (auto & vi : v)
+      vi = a.CreateVector();
+    Matrix<SCAL> matH(m+bs, m);
+    matH = SCAL(0.0);
+
+    // w orthogonal to v_0 ... v_{nprev-1}, twice for stability.
+    // returns the length of w, the coefficients are added to h
+    auto orthogonalize = [&] (BaseVector & w, int nprev, SliceVector<SCAL> h)
+      {
+        for (int pass = 0; pass < 2; pass++)
+          for (int j = 0; j < nprev; j++)
+            {
+              SCAL ip = S_InnerProduct<SCAL> (w, *v[j]);
+              h(j) += ip;
+              w -= ip * *v[j];
+            }
+        return sqrt (S_InnerProduct<SCAL> (w, w));
+      };
+
+    Vector<SCAL> dummy(bs);
+    for (int l = 0; l < bs; l++)
+      {
+        BaseVector & vl = *v[l];
+        vl.SetRandom();
+        vl.SetParallelStatus (CUMULATED);
+        FlatVector<SCAL> fv = vl.template FV<SCAL>();
+        if (freedofs)
+          for (int i = 0; i < vl.Size(); i++)
+            if (! (*freedofs)[i] ) fv(i) = 0;
+        dummy = SCAL(0.0);
+        vl /= orthogonalize (vl, l, dummy);
+      }
+
+    int dim = 0, nconv = 0;
+    Vector<Complex> theta;
+    Matrix<Complex> ritz;
+    Array<int> order;
+    
+    for (int i = 0; i < m; i += bs)
+      {
+        {
+          RegionTimer reg(tsolve);
+          ApplyBlock (*inv, b, v.Range(i, i+bs), v.Range(i+bs, i+2*bs), *hv, SCAL(0.0));
+        }
+        
+        bool breakdown = false;
+        {
+          RegionTimer reg(torth);
+          for (int l = 0; l < bs; l++)
+            {
+              int c = i+l;
+              BaseVector & w = *v[c+bs];
+              SCAL len = orthogonalize (w, c+bs, matH.Col(c).Range(0, c+bs));
+              matH(c+bs, c) = len;
+              if (abs (len) < 1e-14 * L2Norm (matH.Col(c)))
+                breakdown = true;
+              else
+                w /= len;
+            }
+        }
+        dim = i+bs;
+
+        // Ritz values of the inverse, largest first
+        RegionTimer reg(tritz);
+        Matrix<Complex> ht(dim);
+        ht = Trans (matH.Rows(0, dim).Cols(0, dim));
+        theta.SetSize (dim);
+        ritz.SetSize (dim, dim);
+        LapackEigenValues (ht, theta, ritz);
+        order.SetSize (dim);
+        for (int k = 0; k < dim; k++) order[k] = k;
+        QuickSort (order, [&] (int k1, int k2) { return abs(theta(k1)) > abs(theta(k2)); });
+
+        // the residual of Ritz vector y is  H(dim:dim+bs, dim-bs:dim) y(dim-bs:dim)
+        int newconv = 0;
+        for (int k = 0; k < min2 (nev, dim); k++)
+          {
+            int ik = order[k];
+            Vector<Complex> res = matH.Rows(dim, dim+bs).Cols(dim-bs, dim)
+              * ritz.Row(ik).Range(dim-bs, dim);
+            if (!(L2Norm (res) <= tol * abs(theta(ik)) * L2Norm (ritz.Row(ik))))
+              break;
+            newconv++;
+          }
+        if (newconv > nconv)
+          {
+            nconv = newconv;
+            if (callback)
+              {
+                Array<Complex> conv(nconv);
+                for (int k = 0; k < nconv; k++)
+                  conv[k] = shift + 1.0 / theta(order[k]);
+                callback (conv);
+              }
+          }
+        cout << IM(3) << "dim = " << dim << ", converged " << nconv << "/" << nev << endl;
+        if (nconv >= nev || breakdown) break;
+      }
+
+    int nout = min2 (nev, dim);
+    lam.SetSize (nout);
+    for (int k = 0; k < nout; k++)
+      lam[k] = shift + 1.0 / theta(order[k]);
+
+    hevecs.SetSize (nout);
+    for (int k = 0; k < nout; k++)
+      {
+        if (a.IsComplex())
+          hevecs[k] = a.CreateVector();
+        else // real biform and system-vecors not yet supported
+          hevecs[k] = make_shared<VVector<Complex>> (a.Height());
+        *hevecs[k] = 0;
+        for (int j = 0; j < dim; j++)
+          *hevecs[k] += ritz(order[k], j) * *v[j];
+      }
+    return nconv;
+  }
+  
+
   template class Arnoldi<double>;
   template class Arnoldi<Complex>;
+  template class ShiftInvertArnoldi<double>;
+  template class ShiftInvertArnoldi<Complex>;
 
 
 }
@@ -45,6 +45,64 @@ namespace ngla
                Array<shared_ptr<BaseVector>> & evecs, 
                const BaseMatrix * pre = NULL) const;
   };
+
+
+
+  /**
+     Shift-and-invert Arnoldi for a sequence of shifts.
+
+     The shifted matrix A - shift B is kept. A new shift only
+     recomputes its values and refactors them by
+     SparseFactorization::Update, which reuses the ordering and the
+     symbolic factorization. Inverses without Update are recomputed.
+
+     The Krylov space is built in blocks of blocksize vectors. The
+     inverse is applied to the whole block, for real problems as one
+     MultiVector solve. Ritz values are checked after every block, and
+     the iteration stops as soon as the nev eigenvalues closest to the
+     shift are converged.
+   */
+  template <typename SCAL>
+  class NGS_DLL_HEADER ShiftInvertArnoldi
+  {
+    const BaseMatrix & a;
+    const BaseMatrix & b;
+    shared_ptr<BitArray> freedofs;
+    string inversetype;
+    shared_ptr<BaseMatrix> mat_shift;
+    shared_ptr<BaseMatrix> inv;
+    SCAL shift = 0.0;
+    int blocksize = 1;
+    double tol = 1e-8;
+    int nfactor = 0, nupdate = 0;
+
+  public:
+    ShiftInvertArnoldi (const BaseMatrix & aa, const BaseMatrix & ab,
+                        shared_ptr<BitArray> afreedofs = nullptr, string ainversetype = "")
+      : a(aa), b(ab), freedofs(afreedofs), inversetype(ainversetype) { ; }
+
+    /// factors A - shift B, or updates the factorization
+    void SetShift (SCAL ashift);
+    SCAL GetShift () const { return shift; }
+
+    void SetBlockSize (int ablocksize) { blocksize = max2 (1, ablocksize); }
+    /// relative residual of the Ritz pairs of the inverse
+    void SetTolerance (double atol) { tol = atol; }
+
+    /// number of full factorizations, and of values-only updates
+    int NumFactorizations () const { return nfactor; }
+    int NumUpdates () const { return nupdate; }
+
+    /**
+       Krylov space up to dimension maxdim. Returns the number of
+       converged eigenvalues, lam and evecs are sorted by distance to
+       the shift. The callback gets the converged eigenvalues whenever
+       their number grows.
+     */
+    int Calc (int maxdim, int nev, Array<Complex> & lam,
+              Array<shared_ptr<BaseVector>> & evecs,
+              function<void(FlatArray<Complex>)> callback = nullptr) const;
+  };
 }
 
 #endif
@@ -105,6 +105,38 @@ namespace ngla
     y += s * *temp;
   }
 
+  void BaseMatrix :: MultAdd (double s, const MultiVector & x, MultiVector & y) const
+  {
+    if (IsComplex())
+      throw Exception ("BaseMatrix::MultAdd (MultiVector) called for complex matrix, type = "
+                       + string(typeid(*this).name()));
+    auto hx = CreateRowVector();
+    auto hy = CreateColVector();
+    for (size_t j = 0; j < x.NumVectors(); j++)
+      {
+        x.GetVector (j, hx);
+        y.GetVector (j, hy);
+        MultAdd (s, hx, hy);
+        y.SetVector (j, hy);
+      }
+  }
+
+  void BaseMatrix :: MultTransAdd (double s, const MultiVector & x, MultiVector & y) const
+  {
+    if (IsComplex())
+      throw Exception ("BaseMatrix::MultTransAdd (MultiVector) called for complex matrix, type = "
+                       + string(typeid(*this).name()));
+    auto hx = CreateColVector();
+    auto hy = CreateRowVector();
+    for (size_t j = 0; j < x.NumVectors(); j++)
+      {
+        x.GetVector (j, hx);
+        y.GetVector (j, hy);
+        MultTransAdd (s, hx, hy);
+        y.SetVector (j, hy);
+      }
+  }
+
   void BaseMatrix :: MultAdd (Complex s, const BaseVector & x, BaseVector & y) const 
   {
     stringstream err;
@@ -264,6 +296,8 @@ namespace ngla
       case MUMPS:           return "mumps";
       case MASTERINVERSE:   return "masterinverse";
       case UMFPACK:         return "umfpack";
+      case SPARSECHOLESKY_ND: return "sparsecholesky_nd";
+      case SPARSECHOLESKY_MIXED: return "sparsecholesky_mixed";
       }
     return "";
   }
@@ -13,7 +13,7 @@ namespace ngla
 
 
   // sets the solver which is used for InverseMatrix
-  enum INVERSETYPE { PARDISO, PARDISOSPD, SPARSECHOLESKY, SUPERLU, SUPERLU_DIST, MUMPS, MASTERINVERSE, UMFPACK };
+  enum INVERSETYPE { PARDISO, PARDISOSPD, SPARSECHOLESKY, SUPERLU, SUPERLU_DIST, MUMPS, MASTERINVERSE, UMFPACK, SPARSECHOLESKY_ND, SPARSECHOLESKY_MIXED };
   extern string GetInverseName (INVERSETYPE type);
 
   /**
@@ -98,11 +98,16 @@ namespace ngla
     virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const;
     /// y += s matrix * x
     virtual void MultAdd (Complex s, const BaseVector & x, BaseVector & y) const;
+    /// y += s matrix * x for all vectors of the multivector, real matrices only.
+    /// The default multiplies the vectors one by one
+    virtual void MultAdd (double s, const MultiVector & x, MultiVector & y) const;
   
     /// y += s Trans(matrix) * x
     virtual void MultTransAdd (double s, const BaseVector & x, BaseVector & y) const;
     /// y += s Trans(matrix) * x
     virtual void MultTransAdd (Complex s, const BaseVector & x, BaseVector & y) const;
+    /// y += s Trans(matrix) * x for all vectors of the multivector, real matrices only
+    virtual void MultTransAdd (double s, const MultiVector & x, MultiVector & y) const;
 
 
 
@@ -221,6 +226,12 @@ namespace ngla
       m.MultAdd (s, x, v);
     }
 
+    template <class TS>
+    void CollectTerms (TS s, VLinearCombination & lc) const
+    {
+      lc.AppendOther();
+    }
+
     NGS_DLL_HEADER void CheckSize (BaseVector & dest_vec) const;
   };
 
@@ -289,22 +300,28 @@ namespace ngla
 
   /* ************************** Product ************************* */
 
-  /// action of product of two matrices 
+  /// action of product of two matrices, the intermediate vector is
+  /// allocated on first use and kept for all further applications
   class ProductMatrix : public BaseMatrix
   {
     const BaseMatrix & bma;
     const BaseMatrix & bmb;
     shared_ptr<BaseMatrix> spbma;
     shared_ptr<BaseMatrix> spbmb;
-    mutable AutoVector tempvec;
+    mutable shared_ptr<BaseVector> tempvec;
+
+    BaseVector & Temp () const
+    {
+      if (!tempvec) tempvec = bmb.CreateColVector();
+      return *tempvec;
+    }
   public:
     ///
     ProductMatrix (const BaseMatrix & abma, const BaseMatrix & abmb)
-      : bma(abma), bmb(abmb), tempvec(abmb.CreateColVector())
+      : bma(abma), bmb(abmb)
     { ; }
     ProductMatrix (shared_ptr<BaseMatrix> aspbma, shared_ptr<BaseMatrix> aspbmb)
-      : bma(*aspbma), bmb(*aspbmb), spbma(aspbma), spbmb(aspbmb),
-        tempvec(aspbmb->CreateColVector())
+      : bma(*aspbma), bmb(*aspbmb), spbma(aspbma), spbmb(aspbmb)
     { ; }
     ///
     virtual bool IsComplex() const override { return bma.IsComplex() || bmb.IsComplex(); }
@@ -312,31 +329,42 @@ namespace ngla
     virtual AutoVector CreateRowVector () const override { return bmb.CreateRowVector(); }
     virtual AutoVector CreateColVector () const override { return bma.CreateColVector(); }
     
+    ///
+    virtual void Mult (const BaseVector & x, BaseVector & y) const override
+    {
+      BaseVector & temp = Temp();
+      bmb.Mult (x, temp);
+      bma.Mult (temp, y);
+    }
     ///
     virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const override
     {
-      bmb.Mult (x, tempvec);
-      bma.MultAdd (s, tempvec, y);
+      BaseVector & temp = Temp();
+      bmb.Mult (x, temp);
+      bma.MultAdd (s, temp, y);
     }
     ///
     virtual void MultAdd (Complex s, const BaseVector & x, BaseVector & y) const override
     {
-      bmb.Mult (x, tempvec);
-      bma.MultAdd (s, tempvec, y);
+      BaseVector & temp = Temp();
+      bmb.Mult (x, temp);
+      bma.MultAdd (s, temp, y);
     }
     ///
     virtual void MultTransAdd (double s, const BaseVector & x, BaseVector & y) const override
     {
-      tempvec = 0.0;
-      bma.MultTransAdd (1, x, tempvec);
-      bmb.MultTransAdd (s, tempvec, y);
+      BaseVector & temp = Temp();
+      temp = 0.0;
+      bma.MultTransAdd (1, x, temp);
+      bmb.MultTransAdd (s, temp, y);
     }
     ///
     virtual void MultTransAdd (Complex s, const BaseVector & x, BaseVector & y) const override
     {
-      tempvec = 0.0;      
-      bma.MultTransAdd (1, x, tempvec);
-      bmb.MultTransAdd (s, tempvec, y);
+      BaseVector & temp = Temp();
+      temp = 0.0;
+      bma.MultTransAdd (1, x, temp);
+      bmb.MultTransAdd (s, temp, y);
     }  
 
     virtual int VHeight() const override { return bma.VHeight(); }
@@ -398,6 +426,17 @@ namespace ngla
         }
     }
     
+    /// the first term overwrites y, no extra pass for zeroing
+    virtual void Mult (const BaseVector & x, BaseVector & y) const override
+    {
+      if (a != 1.0)
+        {
+          BaseMatrix::Mult (x, y);
+          return;
+        }
+      bma.Mult (x, y);
+      bmb.MultAdd (b, x, y);
+    }
     ///
     virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const override
     {
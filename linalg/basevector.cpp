@@ -97,6 +97,43 @@ namespace ngla
     return *this;
   }
 
+  BaseVector & BaseVector :: Mask (const BitArray & mask, bool keep_values)
+  {
+    static Timer t("BaseVector::Mask");
+    RegionTimer reg(t);
+
+    auto fv = FVDouble();
+    size_t es = EntrySize();
+    size_t n = min(Size(), mask.Size());
+
+    // 64 entries per mask word, only words with cleared bits are touched
+    ParallelForRange (mask.NumWords(), [&] (IntRange r)
+                      {
+                        for (size_t w : r)
+                          {
+                            uint64_t keep = mask.GetWord(w);
+                            if (!keep_values) keep = ~keep;
+                            size_t first = 64*w;
+                            size_t next = min(first+64, n);
+                            if (keep == ~uint64_t(0) || first >= next) continue;
+                            if (keep == 0)
+                              {
+                                for (size_t j = es*first; j < es*next; j++)
+                                  fv(j) = 0.0;
+                                continue;
+                              }
+                            for (uint64_t zero = ~keep; zero; zero &= zero-1)
+                              {
+                                size_t i = first + TrailingZeros(zero);
+                                if (i >= next) break;
+                                for (size_t k = 0; k < es; k++)
+                                  fv(es*i+k) = 0.0;
+                              }
+                          }
+                      });
+    return *this;
+  }
+
   BaseVector & BaseVector :: Set (double scal, const BaseVector & v)
   {
     static Timer t("BaseVector::Set");
@@ -168,6 +205,220 @@ namespace ngla
   }
 
 
+  // real vectors with contiguous memory and no parallel status to take care of
+  static const BaseVector * FusableVector (const BaseVector & v)
+  {
+    const BaseVector * pv = &v;
+    if (auto av = dynamic_cast<const AutoVector*> (pv))
+      pv = &**av;
+    if (pv->IsComplex() || pv->GetParallelStatus() != NOT_PARALLEL ||
+        !dynamic_cast<const S_BaseVectorPtr<double>*> (pv))
+      return nullptr;
+    return pv;
+  }
+  
+  bool BaseVector :: FusedUpdate (double sme, const VLinearCombination & lc,
+                                  const BaseVector * ipvec, double * ip)
+  {
+    static Timer t("BaseVector::FusedUpdate");
+    
+    if (!FusableVector(*this)) return false;
+    if (ipvec && !FusableVector(*ipvec)) return false;
+    for (int k = 0; k < lc.nterms; k++)
+      if (!FusableVector(*lc.vecs[k])) return false;
+
+    auto me = FVDouble();
+    size_t n = me.Size();
+    double * pme = me.Data();
+    
+    int nterms = lc.nterms;
+    double scal[VLinearCombination::MAXTERMS];
+    double * pv[VLinearCombination::MAXTERMS];
+    for (int k = 0; k < nterms; k++)
+      {
+        auto fv = lc.vecs[k]->FVDouble();
+        if (fv.Size() != n) return false;
+        scal[k] = lc.scal[k];
+        pv[k] = fv.Data();
+      }
+    double * pw = nullptr;
+    if (ipvec)
+      {
+        auto fw = ipvec->FVDouble();
+        if (fw.Size() != n) return false;
+        pw = fw.Data();
+      }
+
+    RegionTimer reg(t);
+    t.AddFlops ((nterms + (ipvec ? 1 : 0)) * n);
+
+    // every entry reads only entries of the same index, so the target
+    // may appear in the expression
+    auto kernel = [&] (IntRange r) -> double
+      {
+        constexpr size_t SW = SIMD<double>::Size();
+        SIMD<double> ipsum = 0.0;
+        size_t i = r.First();
+        for ( ; i+SW <= r.Next(); i += SW)
+          {
+            SIMD<double> sum = 0.0;
+            if (sme != 0.0)
+              sum = sme * SIMD<double>(pme+i);
+            for (int k = 0; k < nterms; k++)
+              sum = FMA (SIMD<double>(scal[k]), SIMD<double>(pv[k]+i), sum);
+            sum.Store (pme+i);
+            if (pw)
+              ipsum = FMA (sum, SIMD<double>(pw+i), ipsum);
+          }
+        double ipscal = HSum(ipsum);
+        for ( ; i < r.Next(); i++)
+          {
+            double sum = (sme != 0.0) ? sme * pme[i] : 0.0;
+            for (int k = 0; k < nterms; k++)
+              sum += scal[k] * pv[k][i];
+            pme[i] = sum;
+            if (pw)
+              ipscal += sum * pw[i];
+          }
+        return ipscal;
+      };
+
+    if (n < 1024)
+      {
+        double sum = kernel (IntRange(n));
+        if (ip) *ip = sum;
+        return true;
+      }
+
+    double parts[16];
+    ParallelJob ([&] (TaskInfo ti)
+                 {
+                   auto r = ::Range(n).Split (ti.task_nr, ti.ntasks);
+                   parts[ti.task_nr] = kernel (r);
+                 }, 16);
+    
+    if (ip)
+      {
+        *ip = 0;
+        for (double part : parts) *ip += part;
+      }
+    return true;
+  }
+
+
+  bool FusedUpdate (BaseVector & x, double sx, const VLinearCombination & lx,
+                    BaseVector & y, double sy, const VLinearCombination & ly,
+                    FlatArray<const BaseVector*> ipvecs, FlatArray<double> ips)
+  {
+    static Timer t("FusedUpdate (two vectors)");
+    constexpr int MAXIPS = 4;
+    
+    if (!FusableVector(x) || !FusableVector(y)) return false;
+    if (ipvecs.Size() > MAXIPS) return false;
+    for (auto w : ipvecs)
+      if (!FusableVector(*w)) return false;
+    for (int k = 0; k < lx.nterms; k++)
+      if (!FusableVector(*lx.vecs[k])) return false;
+    for (int k = 0; k < ly.nterms; k++)
+      if (!FusableVector(*ly.vecs[k])) return false;
+
+    size_t n = x.FVDouble().Size();
+    double * px = x.FVDouble().Data();
+    double * py = y.FVDouble().Data();
+    if (y.FVDouble().Size() != n) return false;
+
+    int nx = lx.nterms, ny = ly.nterms, nips = ipvecs.Size();
+    double scalx[VLinearCombination::MAXTERMS], scaly[VLinearCombination::MAXTERMS];
+    double * pvx[VLinearCombination::MAXTERMS];
+    double * pvy[VLinearCombination::MAXTERMS];
+    double * pw[MAXIPS];
+    for (int k = 0; k < nx; k++)
+      {
+        auto fv = lx.vecs[k]->FVDouble();
+        if (fv.Size() != n) return false;
+        scalx[k] = lx.scal[k];
+        pvx[k] = fv.Data();
+      }
+    for (int k = 0; k < ny; k++)
+      {
+        auto fv = ly.vecs[k]->FVDouble();
+        if (fv.Size() != n) return false;
+        scaly[k] = ly.scal[k];
+        pvy[k] = fv.Data();
+      }
+    for (int k = 0; k < nips; k++)
+      {
+        auto fw = ipvecs[k]->FVDouble();
+        if (fw.Size() != n) return false;
+        pw[k] = fw.Data();
+      }
+
+    RegionTimer reg(t);
+    t.AddFlops ((nx + ny + nips) * n);
+
+    auto kernel = [&] (IntRange r, double * ipvals)
+      {
+        constexpr size_t SW = SIMD<double>::Size();
+        SIMD<double> ipsum[MAXIPS];
+        for (int k = 0; k < nips; k++) ipsum[k] = 0.0;
+        size_t i = r.First();
+        for ( ; i+SW <= r.Next(); i += SW)
+          {
+            SIMD<double> sumx = 0.0, sumy = 0.0;
+            if (sx != 0.0) sumx = sx * SIMD<double>(px+i);
+            if (sy != 0.0) sumy = sy * SIMD<double>(py+i);
+            for (int k = 0; k < nx; k++)
+              sumx = FMA (SIMD<double>(scalx[k]), SIMD<double>(pvx[k]+i), sumx);
+            for (int k = 0; k < ny; k++)
+              sumy = FMA (SIMD<double>(scaly[k]), SIMD<double>(pvy[k]+i), sumy);
+            sumx.Store (px+i);
+            sumy.Store (py+i);
+            for (int k = 0; k < nips; k++)
+              ipsum[k] = FMA (sumy, SIMD<double>(pw[k]+i), ipsum[k]);
+          }
+        for (int k = 0; k < nips; k++)
+          ipvals[k] = HSum(ipsum[k]);
+        for ( ; i < r.Next(); i++)
+          {
+            double sumx = (sx != 0.0) ? sx * px[i] : 0.0;
+            double sumy = (sy != 0.0) ? sy * py[i] : 0.0;
+            for (int k = 0; k < nx; k++)
+              sumx += scalx[k] * pvx[k][i];
+            for (int k = 0; k < ny; k++)
+              sumy += scaly[k] * pvy[k][i];
+            px[i] = sumx;
+            py[i] = sumy;
+            for (int k = 0; k < nips; k++)
+              ipvals[k] += sumy * pw[k][i];
+          }
+      };
+
+    if (n < 1024)
+      {
+        double ipvals[MAXIPS];
+        kernel (IntRange(n), ipvals);
+        for (int k = 0; k < nips; k++)
+          ips[k] = ipvals[k];
+        return true;
+      }
+
+    double parts[16][MAXIPS];
+    ParallelJob ([&] (TaskInfo ti)
+                 {
+                   auto r = ::Range(n).Split (ti.task_nr, ti.ntasks);
+                   kernel (r, parts[ti.task_nr]);
+                 }, 16);
+    
+    for (int k = 0; k < nips; k++)
+      {
+        ips[k] = 0;
+        for (int j = 0; j < 16; j++)
+          ips[k] += parts[j][k];
+      }
+    return true;
+  }
+
+
   double BaseVector :: InnerProductD (const BaseVector & v2) const
   {
     return dynamic_cast<const S_BaseVector<double>&> (*this) . 
@@ -826,7 +1077,11 @@ namespace ngla
   template <typename TSCAL>
   S_BaseVectorPtr<TSCAL> :: ~S_BaseVectorPtr ()
   {
-    if (ownmem) delete [] pdata;
+    if (ownmem)
+      {
+        MemoryPool::Free (pdata, this->size*es);
+        MemoryRegistry::Free (MemoryRegistry::VECTORS, this->size*es*sizeof(TSCAL));
+      }
   }
 
   template <typename TSCAL>
@@ -885,4 +1140,91 @@ namespace ngla
 
   template class VVector<double>;
   template class VVector<Complex>;
+
+
+
+  namespace
+  {
+    // local vector and local inner product of the inner product types
+    template <class IPTYPE> struct FusedIP;
+    template <> struct FusedIP<double>
+    {
+      static FlatVector<double> FV (const BaseVector & v) { return v.FVDouble(); }
+      static double IP (FlatVector<double> x, FlatVector<double> y) { return InnerProduct (x, y); }
+    };
+    template <> struct FusedIP<Complex>
+    {
+      static FlatVector<Complex> FV (const BaseVector & v) { return v.FVComplex(); }
+      static Complex IP (FlatVector<Complex> x, FlatVector<Complex> y) { return InnerProduct (x, y); }
+    };
+    template <> struct FusedIP<ComplexConjugate> : FusedIP<Complex>
+    {
+      static Complex IP (FlatVector<Complex> x, FlatVector<Complex> y) { return InnerProduct (x, Conj(y)); }
+    };
+    template <> struct FusedIP<ComplexConjugate2> : FusedIP<Complex>
+    {
+      static Complex IP (FlatVector<Complex> x, FlatVector<Complex> y) { return InnerProduct (y, Conj(x)); }
+    };
+  }
+
+  template <class IPTYPE>
+  void FusedInnerProducts<IPTYPE> :: Start (FlatArray<const BaseVector*> x, FlatArray<const BaseVector*> y)
+  {
+    static Timer t("FusedInnerProducts - local");
+    RegionTimer reg(t);
+
+    Wait();
+    values.SetSize (x.Size());
+    parallel = false;
+    for (size_t i : Range(x))
+      {
+        // as in InnerProduct, one vector distributed and one cumulated
+        auto stat = x[i]->GetParallelStatus();
+        if (stat != NOT_PARALLEL || y[i]->GetParallelStatus() != NOT_PARALLEL)
+          parallel = true;
+        if (stat == y[i]->GetParallelStatus() && stat == DISTRIBUTED)
+          x[i]->Cumulate();
+        else if (stat == y[i]->GetParallelStatus() && stat == CUMULATED)
+          x[i]->Distribute();
+        
+        auto fx = FusedIP<IPTYPE>::FV (*x[i]);
+        auto fy = FusedIP<IPTYPE>::FV (*y[i]);
+        SCAL parts[16];
+        ParallelJob ([fx,fy,&parts] (TaskInfo ti)
+                     {
+                       auto r = ::Range(fx).Split (ti.task_nr, ti.ntasks);
+                       parts[ti.task_nr] = FusedIP<IPTYPE>::IP (fx.Range(r), fy.Range(r));
+                     }, 16);
+        values[i] = 0.0;
+        for (SCAL part : parts) values[i] += part;
+      }
+#ifdef PARALLEL
+    if (parallel && values.Size())
+      {
+        request = MyMPI_IAllReduce (FlatArray<double> (values.Size()*sizeof(SCAL)/sizeof(double),
+                                                       reinterpret_cast<double*> (&values[0])));
+        pending = true;
+      }
+#endif
+  }
+
+  template <class IPTYPE>
+  FlatArray<typename SCAL_TRAIT<IPTYPE>::SCAL> FusedInnerProducts<IPTYPE> :: Wait ()
+  {
+#ifdef PARALLEL
+    if (pending)
+      {
+        static Timer t("FusedInnerProducts - wait");
+        RegionTimer reg(t);
+        MPI_Wait (&request, MPI_STATUS_IGNORE);
+        pending = false;
+      }
+#endif
+    return values;
+  }
+
+  template class FusedInnerProducts<double>;
+  template class FusedInnerProducts<Complex>;
+  template class FusedInnerProducts<ComplexConjugate>;
+  template class FusedInnerProducts<ComplexConjugate2>;
 }
@@ -66,11 +66,44 @@ namespace ngla
     /// add s * vector-expression data to v
     template <class TS>
     void AddTo (TS s, BaseVector & v) const { data.AddTo(s, v); }
+
+    /// collect the terms of s * vector-expression for single pass evaluation
+    template <class TS>
+    void CollectTerms (TS s, class VLinearCombination & lc) const { data.CollectTerms(s, lc); }
+  };
+
+
+  /**
+     Flattened vector expression s_0 v_0 + s_1 v_1 + ...
+     Real expressions of plain vectors are evaluated in one pass.
+  */
+  class VLinearCombination
+  {
+  public:
+    enum { MAXTERMS = 8 };
+    int nterms = 0;
+    bool fusable = true;
+    double scal[MAXTERMS];
+    const BaseVector * vecs[MAXTERMS];
+
+    void Append (double s, const BaseVector & v)
+    {
+      if (nterms == MAXTERMS) { fusable = false; return; }
+      scal[nterms] = s;
+      vecs[nterms] = &v;
+      nterms++;
+    }
+    void Append (Complex s, const BaseVector & v) { fusable = false; }
+    /// a term which is not a scaled vector, e.g. a matrix-vector product
+    void AppendOther () { fusable = false; }
   };
 
 
   enum PARALLEL_STATUS { DISTRIBUTED, CUMULATED, NOT_PARALLEL };
 
+  /// memory holding valid values of a vector, device vectors migrate lazily
+  enum class VectorResidency { HOST, DEVICE, BOTH };
+
 
 
   /**
@@ -97,7 +130,10 @@ namespace ngla
     template <typename T> 
     BaseVector & operator= (const VVecExpr<T> & v)
     {
-      v.AssignTo (1.0, *this);
+      VLinearCombination lc;
+      v.CollectTerms (1.0, lc);
+      if (!lc.fusable || !FusedUpdate (0.0, lc))
+        v.AssignTo (1.0, *this);
       return *this;
     }
 
@@ -124,7 +160,10 @@ namespace ngla
     template <typename T>
     BaseVector & operator+= (const VVecExpr<T> & v)
     {
-      v.AddTo (1.0, *this);
+      VLinearCombination lc;
+      v.CollectTerms (1.0, lc);
+      if (!lc.fusable || !FusedUpdate (1.0, lc))
+        v.AddTo (1.0, *this);
       return *this;
     }
 
@@ -139,10 +178,34 @@ namespace ngla
     template <typename T>
     BaseVector & operator-= (const VVecExpr<T> & v)
     {
-      v.AddTo (-1.0, *this);
+      VLinearCombination lc;
+      v.CollectTerms (-1.0, lc);
+      if (!lc.fusable || !FusedUpdate (1.0, lc))
+        v.AddTo (-1.0, *this);
       return *this;
     }
 
+    /// *this += v and returns InnerProduct (*this, w), in one pass if possible
+    template <typename T>
+    double AddAndInnerProduct (const VVecExpr<T> & v, const BaseVector & w)
+    {
+      VLinearCombination lc;
+      v.CollectTerms (1.0, lc);
+      double ip;
+      if (lc.fusable && FusedUpdate (1.0, lc, &w, &ip))
+        return ip;
+      v.AddTo (1.0, *this);
+      return InnerProductD (w);
+    }
+
+    /**
+       *this = sme * *this + lc, optionally ip = InnerProduct(*this, *ipvec)
+       computed in the same pass. Returns false if some vector is not a
+       plain real vector, the caller has to fall back to Set/Add.
+    */
+    bool FusedUpdate (double sme, const VLinearCombination & lc,
+                      const BaseVector * ipvec = nullptr, double * ip = nullptr);
+
     ///
     BaseVector & operator-= (const BaseVector & v)
     {
@@ -196,6 +259,8 @@ namespace ngla
     virtual void * Memory () const = 0;
     virtual FlatVector<double> FVDouble () const = 0;
     virtual FlatVector<Complex> FVComplex () const = 0;
+    /// plain vectors live on the host, Memory and FVDouble give host values
+    virtual VectorResidency Residency () const { return VectorResidency::HOST; }
 
     template <typename SCAL = double>
     FlatSysVector<SCAL> SV () const
@@ -227,6 +292,9 @@ namespace ngla
     virtual BaseVector & SetScalar (double scal);
     virtual BaseVector & SetScalar (Complex scal);
 
+    /// zero all entries i with mask[i] != keep_values
+    virtual BaseVector & Mask (const BitArray & mask, bool keep_values = true);
+
     virtual BaseVector & Set (double scal, const BaseVector & v);
     virtual BaseVector & Set (Complex scal, const BaseVector & v);
 
@@ -368,7 +436,7 @@ namespace ngla
     template <typename T> 
     BaseVector & operator= (const VVecExpr<T> & v)
     {
-      v.AssignTo (1.0, *vec);
+      *vec = v;
       return *this;
     }
 
@@ -423,6 +491,10 @@ namespace ngla
     {
       return vec->FVDouble();
     }
+    virtual VectorResidency Residency () const
+    {
+      return vec->Residency();
+    }
     virtual FlatVector<Complex> FVComplex () const
     {
       return vec->FVComplex();
@@ -728,6 +800,8 @@ namespace ngla
     void AssignTo (TS s, BaseVector & v2) const { v2.Set (s, v); }
     template <class TS>
     void AddTo (TS s, BaseVector & v2) const { v2.Add (s,  v); }
+    template <class TS>
+    void CollectTerms (TS s, VLinearCombination & lc) const { lc.Append (s, v); }
   };
 
 
@@ -756,6 +830,12 @@ namespace ngla
       a.AddTo (s, v);
       b.AddTo (s, v);
     }
+    template <class TS>
+    void CollectTerms (TS s, VLinearCombination & lc) const
+    {
+      a.CollectTerms (s, lc);
+      b.CollectTerms (s, lc);
+    }
   };
 
 
@@ -823,6 +903,12 @@ namespace ngla
       a.AddTo (s, v);
       b.AddTo (-s, v);
     }
+    template <class TS>
+    void CollectTerms (TS s, VLinearCombination & lc) const
+    {
+      a.CollectTerms (s, lc);
+      b.CollectTerms (-s, lc);
+    }
   };
 
 
@@ -886,6 +972,11 @@ namespace ngla
     { 
       a.AddTo (scal * s, v);
     }
+    template <class TS>
+    void CollectTerms (TS s, VLinearCombination & lc) const
+    {
+      a.CollectTerms (scal * s, lc);
+    }
   };
 
 
@@ -977,6 +1068,18 @@ namespace ngla
     return v.Print(ost);
   }
 
+  /**
+     x = sx * x + lx and y = sy * y + ly in one pass, together with the
+     inner products ips[k] = InnerProduct (y, *ipvecs[k]) of the updated y 
+     (at most 4). Both combinations see the old values of x and y.
+     Returns false if some vector is not a plain real vector, the caller 
+     has to fall back to separate updates.
+  */
+  NGS_DLL_HEADER bool FusedUpdate (BaseVector & x, double sx, const VLinearCombination & lx,
+                                   BaseVector & y, double sy, const VLinearCombination & ly,
+                                   FlatArray<const BaseVector*> ipvecs = FlatArray<const BaseVector*>(),
+                                   FlatArray<double> ips = FlatArray<double>());
+
   ///
   inline double InnerProduct (const BaseVector & v1, const BaseVector & v2)
   {
@@ -1022,6 +1125,43 @@ namespace ngla
     return v.L2Norm();
   }
 
+
+  /**
+     Several inner products with one global reduction. Start computes
+     the local parts and starts a non-blocking reduction, the caller
+     overlaps it with work not depending on the values until Wait.
+     As for InnerProduct, Start may cumulate or distribute x.
+  */
+  template <class IPTYPE>
+  class NGS_DLL_HEADER FusedInnerProducts
+  {
+    typedef typename SCAL_TRAIT<IPTYPE>::SCAL SCAL;
+    Array<SCAL> values;
+    bool parallel = false;
+    bool pending = false;
+#ifdef PARALLEL
+    MPI_Request request;
+#endif
+  public:
+    FusedInnerProducts () = default;
+    /// the reduction writes into values, the handle must not be copied
+    FusedInnerProducts (const FusedInnerProducts &) = delete;
+    ~FusedInnerProducts () { Wait(); }
+
+    void Start (FlatArray<const BaseVector*> x, FlatArray<const BaseVector*> y);
+    FlatArray<SCAL> Wait ();
+  };
+
+  /// InnerProduct (x, y) in flight, the value is returned by Wait
+  inline shared_ptr<FusedInnerProducts<double>> 
+  InnerProductAsync (const BaseVector & x, const BaseVector & y)
+  {
+    auto ip = make_shared<FusedInnerProducts<double>> ();
+    const BaseVector * px = &x, * py = &y;
+    ip->Start (FlatArray<const BaseVector*> (1, &px), FlatArray<const BaseVector*> (1, &py));
+    return ip;
+  }
+
 }
 
 #endif
@@ -0,0 +1,175 @@
+/*********************************************************************/
+/* File:   blockedsparsematrix.cpp                                   */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+/* 
+   Block-CSR copy of a real sparse matrix of a vector valued space
+*/
+
+#include <la.hpp>
+namespace ngla
+{
+
+  /// sorted block columns of every block row
+  static Table<int> BlockGraph (const SparseMatrixTM<double> & mat, FlatArray<int> blocknr,
+                                size_t nb, bool symmetric)
+  {
+    Array<int> cnt(nb);
+    cnt = 0;
+    for (size_t i = 0; i < mat.Height(); i++)
+      for (auto j : mat.GetRowIndices(i))
+        {
+          cnt[blocknr[i]]++;
+          if (symmetric && j != i) cnt[blocknr[j]]++;
+        }
+
+    Table<int> entries(cnt);
+    cnt = 0;
+    for (size_t i = 0; i < mat.Height(); i++)
+      for (auto j : mat.GetRowIndices(i))
+        {
+          entries[blocknr[i]][cnt[blocknr[i]]++] = blocknr[j];
+          if (symmetric && j != i)
+            entries[blocknr[j]][cnt[blocknr[j]]++] = blocknr[i];
+        }
+
+    for (size_t i = 0; i < nb; i++)
+      {
+        FlatArray<int> row = entries[i];
+        QuickSort (row);
+        int n = 0;
+        for (size_t k = 0; k < row.Size(); k++)
+          if (k == 0 || row[k] != row[n-1])
+            row[n++] = row[k];
+        cnt[i] = n;
+      }
+
+    Table<int> graph(cnt);
+    for (size_t i = 0; i < nb; i++)
+      graph[i] = entries[i].Range(0, cnt[i]);
+    return graph;
+  }
+
+  
+  template <int N>
+  BlockedSparseMatrix<N> :: BlockedSparseMatrix (const SparseMatrixTM<double> & mat, FlatArray<int> adofnr)
+    : dofnr(adofnr), height(mat.Height())
+  {
+    static Timer t("BlockedSparseMatrix - ctor"); RegionTimer reg(t);
+    
+    bool symmetric = dynamic_cast<const SparseMatrixSymmetric<double>*> (&mat) != nullptr;
+    size_t nb = dofnr.Size() / N;
+
+    Array<int> blocknr(height), compnr(height);
+    for (size_t i = 0; i < dofnr.Size(); i++)
+      {
+        blocknr[dofnr[i]] = i / N;
+        compnr[dofnr[i]] = i % N;
+      }
+
+    Table<int> graph = BlockGraph (mat, blocknr, nb, symmetric);
+    Array<int> elsperrow(nb);
+    for (size_t i = 0; i < nb; i++)
+      elsperrow[i] = graph[i].Size();
+    
+    blockmat = make_shared<SparseMatrix<Mat<N,N,double>>> (elsperrow, nb);
+    SparseMatrix<Mat<N,N,double>> & bm = *blockmat;
+    for (size_t i = 0; i < nb; i++)
+      for (auto j : graph[i])
+        bm.CreatePosition (i, j);
+    bm.AsVector() = 0.0;
+
+    for (size_t i = 0; i < height; i++)
+      {
+        FlatArray<int> cols = mat.GetRowIndices(i);
+        FlatVector<double> vals = mat.GetRowValues(i);
+        for (size_t k = 0; k < cols.Size(); k++)
+          {
+            int j = cols[k];
+            bm(blocknr[i], blocknr[j])(compnr[i], compnr[j]) += vals(k);
+            if (symmetric && j != i)
+              bm(blocknr[j], blocknr[i])(compnr[j], compnr[i]) += vals(k);
+          }
+      }
+  }
+
+  
+  template <int N>
+  void BlockedSparseMatrix<N> :: MultAdd (double s, const BaseVector & x, BaseVector & y) const
+  {
+    static Timer t("BlockedSparseMatrix::MultAdd"); RegionTimer reg(t);
+
+    size_t nb = dofnr.Size() / N;
+    VVector<Vec<N,double>> bx(nb), by(nb);
+    FlatVector<double> fx = x.FV<double>();
+    FlatVector<double> fy = y.FV<double>();
+    FlatVector<Vec<N,double>> fbx = bx.FV(), fby = by.FV();
+
+    ParallelFor (nb, [&] (size_t i)
+                 {
+                   for (int k = 0; k < N; k++)
+                     fbx(i)(k) = fx(dofnr[N*i+k]);
+                 });
+    by = 0.0;
+    blockmat->MultAdd (s, bx, by);
+    ParallelFor (nb, [&] (size_t i)
+                 {
+                   for (int k = 0; k < N; k++)
+                     fy(dofnr[N*i+k]) += fby(i)(k);
+                 });
+  }
+
+
+  template <int N>
+  static shared_ptr<BaseMatrix> CreateBlockedSparseMatrixN (const SparseMatrixTM<double> & mat)
+  {
+    size_t h = mat.Height();
+    if (h % N != 0 || mat.Width() != h) return nullptr;
+    bool symmetric = dynamic_cast<const SparseMatrixSymmetric<double>*> (&mat) != nullptr;
+    size_t nze = symmetric ? 2*mat.NZE()-h : mat.NZE();
+
+    Array<int> interleaved(h), componentwise(h);
+    for (size_t i = 0; i < h/N; i++)
+      for (int k = 0; k < N; k++)
+        {
+          interleaved[N*i+k] = N*i+k;
+          componentwise[N*i+k] = i + k*(h/N);
+        }
+
+    for (FlatArray<int> dofnr : { FlatArray<int>(interleaved), FlatArray<int>(componentwise) })
+      {
+        Array<int> blocknr(h);
+        for (size_t i = 0; i < h; i++)
+          blocknr[dofnr[i]] = i / N;
+        
+        // accept little fill-in by the dense blocks only 
+        size_t nblocks = BlockGraph (mat, blocknr, h/N, symmetric).AsArray().Size();
+        if (N*N*nblocks <= 1.25 * nze)
+          return make_shared<BlockedSparseMatrix<N>> (mat, dofnr);
+      }
+    return nullptr;
+  }
+  
+  shared_ptr<BaseMatrix> CreateBlockedSparseMatrix (const SparseMatrixTM<double> & mat, int blocksize)
+  {
+    switch (blocksize)
+      {
+#if MAX_SYS_DIM >= 2
+      case 2: return CreateBlockedSparseMatrixN<2> (mat);
+#endif
+#if MAX_SYS_DIM >= 3
+      case 3: return CreateBlockedSparseMatrixN<3> (mat);
+#endif
+      default:
+        throw Exception ("CreateBlockedSparseMatrix: blocksize "+ToString(blocksize)+" not available");
+      }
+  }
+
+#if MAX_SYS_DIM >= 2
+  template class BlockedSparseMatrix<2>;
+#endif
+#if MAX_SYS_DIM >= 3
+  template class BlockedSparseMatrix<3>;
+#endif
+}
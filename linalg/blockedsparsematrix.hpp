@@ -0,0 +1,64 @@
+#ifndef FILE_NGS_BLOCKEDSPARSEMATRIX
+#define FILE_NGS_BLOCKEDSPARSEMATRIX
+
+/* ************************************************************************/
+/* File:   blockedsparsematrix.hpp                                        */
+/* Date:   Oct. 2026                                                      */
+/* ************************************************************************/
+
+/*
+   Block-CSR copy of a real sparse matrix of a vector valued space
+*/
+
+namespace ngla
+{
+
+  /**
+     A real sparse matrix stored with N x N blocks. Only one column
+     index is kept per block. dofnr[N*i+k] is the dof of the original
+     matrix belonging to component k of block i.
+   */
+  template <int N>
+  class NGS_DLL_HEADER BlockedSparseMatrix : public BaseMatrix
+  {
+    shared_ptr<SparseMatrix<Mat<N,N,double>>> blockmat;
+    Array<int> dofnr;
+    size_t height;
+    
+  public:
+    /// copies the matrix, symmetric matrices are stored in full
+    BlockedSparseMatrix (const SparseMatrixTM<double> & mat, FlatArray<int> adofnr);
+
+    shared_ptr<SparseMatrix<Mat<N,N,double>>> GetBlockMatrix () const { return blockmat; }
+    FlatArray<int> GetDofNrs () const { return dofnr; }
+    
+    virtual bool IsComplex() const override { return false; }
+    virtual int VHeight() const override { return height; }
+    virtual int VWidth() const override { return height; }
+    virtual size_t NZE () const override { return N*N*blockmat->NZE(); }
+
+    virtual AutoVector CreateVector () const override
+    { return make_shared<VVector<double>> (height); }
+    virtual AutoVector CreateRowVector () const override
+    { return make_shared<VVector<double>> (height); }
+    virtual AutoVector CreateColVector () const override
+    { return make_shared<VVector<double>> (height); }
+
+    virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const override;
+
+    virtual Array<MemoryUsage> GetMemoryUsage () const override
+    { return blockmat->GetMemoryUsage(); }
+  };
+
+
+  /**
+     Looks for N x N blocks in a real square sparse matrix. Checks
+     interleaved dofs (N*i+k) and dofs numbered component by component
+     (i+k*ndof/N). Returns nullptr if no numbering gives blocks with
+     little fill-in.
+   */
+  NGS_DLL_HEADER shared_ptr<BaseMatrix>
+  CreateBlockedSparseMatrix (const SparseMatrixTM<double> & mat, int blocksize);
+}
+
+#endif
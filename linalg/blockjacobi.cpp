@@ -13,6 +13,29 @@ namespace ngla
   
   static mutex buildingblockupdate_mutex;
 
+  /*
+    Flops and bytes of applying the dense block inverses, counted in t
+    for the roofline report. Smoothers add the matnze entries of the
+    matrix rows read for the residual, and count all steps.
+   */
+  template <class TM, class TV>
+  static void AddBlockTraffic (Timer & t, const Table<int> & blocktable,
+                               double matnze = 0, int steps = 1)
+  {
+    double entries = 0, dofs = 0;
+    for (auto block : blocktable)
+      {
+        entries += sqr(double(block.Size()));
+        dofs += block.Size();
+      }
+    constexpr double sc = sizeof(typename mat_traits<TM>::TSCAL) / sizeof(double);
+    constexpr double fma = 2 * sc * sc * mat_traits<TM>::HEIGHT * mat_traits<TM>::WIDTH;
+    t.AddFlops (steps * fma * (entries + matnze));
+    t.AddLoads (steps * ((entries + matnze) * sizeof(TM) + matnze * sizeof(int)
+                         + dofs * (2 * sizeof(TV) + sizeof(int))));
+    t.AddStores (steps * dofs * sizeof(TV));
+  }
+
 
   BaseBlockJacobiPrecond :: 
   BaseBlockJacobiPrecond (shared_ptr<Table<int>> ablocktable)
@@ -319,7 +342,6 @@ namespace ngla
     static Timer t("BlockJacobiPrecond ctor"); RegionTimer reg(t);
     static Timer tinv("BlockJacobiPrecond ctor inv");
     static Timer tget("BlockJacobiPrecond ctor get");
-    static Timer tprep("BlockJacobiPrecond ctor prep");
     static Timer tpar("BlockJacobiPrecond ctor par");
     cout << IM(3) << "BlockJacobi Preconditioner, constructor called, #blocks = " << blocktable->Size() << endl;
 
@@ -346,69 +368,12 @@ namespace ngla
                       [] (size_t a, size_t b) { return a+b; },
                       size_t(0));
 
-    /*
-    size_t totmem = 0;
-    for (auto i : Range (*blocktable))
-      totmem += sqr ((*blocktable)[i].Size());
-    */
-    size_t totmem = 
-      ParallelReduce (blocktable->Size(),
-                      [&] (size_t i) { return sqr ((*blocktable)[i].Size()); },
-                      [] (size_t a, size_t b) { return a+b; },
-                      size_t(0));
-
-    bigmem.SetSize(totmem);
-    
-    totmem = 0;
-    for (auto i : Range (*blocktable))
-      {
-        size_t bs = (*blocktable)[i].Size();
-        new ( & invdiag[i] ) FlatMatrix<TM> (bs, bs, bigmem.Addr(totmem));
-        totmem += sqr (bs);
-      }
-
-
-    // atomic<int> cnt(0);
-    SharedLoop2 sl(blocktable->Size());
-
-    /*
-    ParallelFor 
-      (Range(*blocktable), [&] (int i)
-    */
-    ParallelJob
-      ([&] (const TaskInfo & ti)
-       {
-         NgProfiler::StartThreadTimer (tpar, TaskManager::GetThreadId());         
-         for (int i : sl)
-       {
-         NgProfiler::StartThreadTimer (tprep, TaskManager::GetThreadId());
+    ParallelFor (Range(*blocktable), [&] (size_t i)
+                 {
+                   auto blocki = (*blocktable)[i];
+                   QuickSort (blocki);
+                 });
 
-        auto blocki = (*blocktable)[i];
-        QuickSort (blocki);
-	if (!blocki.Size()) 
-	  {
-            NgProfiler::StopThreadTimer (tprep, TaskManager::GetThreadId());                             
-	    invdiag[i] = 0;
-	    // return;
-            continue;
-	  }
-	
-        FlatMatrix<TM> & blockmat = invdiag[i];
-        NgProfiler::StopThreadTimer (tprep, TaskManager::GetThreadId());                 
-        NgProfiler::StartThreadTimer (tget, TaskManager::GetThreadId());
-	for (size_t j = 0; j < blocki.Size(); j++)
-	  for (size_t k = 0; k < blocki.Size(); k++)
-	    blockmat(j,k) = mat(blocki[j], blocki[k]);
-        NgProfiler::StopThreadTimer (tget, TaskManager::GetThreadId());                         
-        NgProfiler::StartThreadTimer (tinv, TaskManager::GetThreadId());
-	CalcInverse (blockmat);
-        NgProfiler::StopThreadTimer (tinv, TaskManager::GetThreadId());        
-        // }, TasksPerThread(10));
-       }
-         NgProfiler::StopThreadTimer (tpar, TaskManager::GetThreadId());                  
-       } );
-    
-    cout << IM(3) << "\rBuilding block " << blocktable->Size() << "/" << blocktable->Size() << flush;
     *testout << "block coloring";
 
     static Timer tcol("BlockJacobi-coloring");
@@ -465,22 +430,102 @@ namespace ngla
           creator.Add (coloring[i], i);
     block_coloring = creator.MoveTable();
 
-    cout << IM(4) << " using " << maxcolor+1 << " colors" << endl;
+    // equal sized blocks of one color are inverted and applied in SIMD lanes
+    ComputeSIMDInverses ();
+    if (simd_firstgroup.Size() == 0)
+      {
+        simd_firstgroup.SetSize (block_coloring.Size()+1);
+        simd_firstgroup = 0;
+      }
+    mem_blocks.Set (BlockJacobiPrecond::GetMemoryUsage());
+
+    Array<bool> ingroup(nblocks);
+    ingroup = false;
+    for (int i : simd_blocks)
+      ingroup[i] = true;
+
+    TableCreator<int> nonsimd_creator(block_coloring.Size());
+    for ( ; !nonsimd_creator.Done(); nonsimd_creator++)
+      for (int c : Range(block_coloring))
+        for (int i : block_coloring[c])
+          if (!ingroup[i])
+            nonsimd_creator.Add (c, i);
+    nonsimd_coloring = nonsimd_creator.MoveTable();
+
+    // the remaining blocks are inverted one by one, the large ones first
+    size_t totmem = 0;
+    for (auto i : Range (*blocktable))
+      if (!ingroup[i])
+        totmem += sqr ((*blocktable)[i].Size());
 
-    // calc balancing:
+    bigmem.SetSize(totmem);
+    
+    totmem = 0;
+    Array<int> order;
+    for (auto i : Range (*blocktable))
+      if (!ingroup[i])
+        {
+          size_t bs = (*blocktable)[i].Size();
+          new ( & invdiag[i] ) FlatMatrix<TM> (bs, bs, bigmem.Addr(totmem));
+          totmem += sqr (bs);
+          if (bs) order.Append (i);
+        }
+    QuickSort (order, [&] (int a, int b)
+               { return (*blocktable)[a].Size() > (*blocktable)[b].Size(); });
+    
+    SharedLoop2 sl(order.Size());
+
+    ParallelJob
+      ([&] (const TaskInfo & ti)
+       {
+         NgProfiler::StartThreadTimer (tpar, TaskManager::GetThreadId());         
+         for (size_t nr : sl)
+           {
+             int i = order[nr];
+             auto blocki = (*blocktable)[i];
+             FlatMatrix<TM> & blockmat = invdiag[i];
+
+             NgProfiler::StartThreadTimer (tget, TaskManager::GetThreadId());
+             for (size_t j = 0; j < blocki.Size(); j++)
+               for (size_t k = 0; k < blocki.Size(); k++)
+                 blockmat(j,k) = mat(blocki[j], blocki[k]);
+             NgProfiler::StopThreadTimer (tget, TaskManager::GetThreadId());                         
+             NgProfiler::StartThreadTimer (tinv, TaskManager::GetThreadId());
+             CalcInverse (blockmat);
+             NgProfiler::StopThreadTimer (tinv, TaskManager::GetThreadId());        
+           }
+         NgProfiler::StopThreadTimer (tpar, TaskManager::GetThreadId());                  
+       } );
+    
+    cout << IM(3) << "\rBuilding block " << blocktable->Size() << "/" << blocktable->Size() << flush;
+    cout << IM(4) << " using " << maxcolor+1 << " colors, "
+         << simd_blocks.Size() << " blocks in SIMD groups" << endl;
+
+    // calc balancing, the work items of a color are its SIMD groups and its remaining blocks
 
     color_balance.SetSize (block_coloring.Size());
 
+    auto blockcosts = [&] (size_t blocknr)
+      {
+        size_t costs = 0;
+        for (auto d : (*blocktable)[blocknr])
+          costs += mat.GetRowIndices(d).Size();
+        return costs;
+      };
+
     for (auto c : Range (block_coloring))
       {
-        color_balance[c].Calc (block_coloring[c].Size(),
-                               [&] (size_t bi)
+        size_t ng = simd_firstgroup[c+1] - simd_firstgroup[c];
+        color_balance[c].Calc (ng + nonsimd_coloring[c].Size(),
+                               [&] (size_t item)
                                {
-                                 int costs = 0;
-                                 size_t blocknr = block_coloring[c][bi];
-
-                                 for (auto d : (*blocktable)[blocknr])
-                                   costs += mat.GetRowIndices(d).Size();
+                                 if (item >= ng)
+                                   return blockcosts (nonsimd_coloring[c][item-ng]);
+                                 constexpr int SW = SIMD<double>::Size();
+                                 size_t g = simd_firstgroup[c] + item;
+                                 size_t costs = 0;
+                                 for (int l = 0; l < SW; l++)
+                                   costs += blockcosts (simd_blocks[g*SW+l]);
                                  return costs;
                                });
 
@@ -498,6 +543,248 @@ namespace ngla
   }
 
 
+  template <class TM, class TV_ROW, class TV_COL>
+  void BlockJacobiPrecond<TM, TV_ROW, TV_COL> ::
+  ComputeSIMDInverses ()
+  { ; }
+
+  template <class TM, class TV_ROW, class TV_COL>
+  void BlockJacobiPrecond<TM, TV_ROW, TV_COL> ::
+  MultAddSIMD (size_t g, TSCAL s, FlatVector<TVX> fx, FlatVector<TVX> fy, bool trans,
+               FlatVector<SIMD<double>> hx, FlatVector<SIMD<double>> hy) const
+  { ; }
+
+  template <class TM, class TV_ROW, class TV_COL>
+  void BlockJacobiPrecond<TM, TV_ROW, TV_COL> ::
+  SmoothSIMD (size_t g, FlatVector<TVX> fx, FlatVector<TVX> fb,
+              FlatVector<SIMD<double>> hx, FlatVector<SIMD<double>> hy) const
+  { ; }
+
+  template <class TM, class TV_ROW, class TV_COL>
+  void BlockJacobiPrecond<TM, TV_ROW, TV_COL> ::
+  SetSinglePrecision (double tol)
+  { ; }
+
+
+  // hy = Inv hx, or Inv^T hx, with the interleaved inverses of one SIMD group
+  template <typename TSIMD>
+  INLINE void SIMDGroupMult (const TSIMD * inv, size_t bs, bool trans,
+                             FlatVector<SIMD<double>> hx, FlatVector<SIMD<double>> hy)
+  {
+    if (!trans)
+      for (size_t j = 0; j < bs; j++)
+        {
+          SIMD<double> sum(0.0);
+          for (size_t k = 0; k < bs; k++)
+            sum += SIMD<double>(inv[j*bs+k]) * hx(k);
+          hy(j) = sum;
+        }
+    else
+      {
+        hy = SIMD<double>(0.0);
+        for (size_t k = 0; k < bs; k++)
+          for (size_t j = 0; j < bs; j++)
+            hy(j) += SIMD<double>(inv[k*bs+j]) * hx(k);
+      }
+  }
+
+  template <>
+  void BlockJacobiPrecond<double,double,double> ::
+  ComputeSIMDInverses ()
+  {
+    static Timer t("BlockJacobiPrecond::ComputeSIMDInverses"); RegionTimer reg(t);
+    constexpr int SW = SIMD<double>::Size();
+
+    // sort each color by block size, full groups of SW blocks go into SIMD lanes
+    simd_blocks.SetSize0();
+    simd_firstgroup.SetSize (block_coloring.Size()+1);
+    simd_firstgroup[0] = 0;
+    for (int c : Range(block_coloring))
+      {
+        Array<int> order;
+        for (int i : block_coloring[c])
+          if ((*blocktable)[i].Size())
+            order.Append (i);
+        QuickSort (order, [&] (int a, int b)
+                   { return (*blocktable)[a].Size() < (*blocktable)[b].Size(); });
+
+        for (size_t i = 0; i < order.Size(); )
+          {
+            size_t bs = (*blocktable)[order[i]].Size();
+            size_t j = i;
+            while (j < order.Size() && (*blocktable)[order[j]].Size() == bs)
+              j++;
+            for ( ; i+SW <= j; i += SW)
+              for (int l = 0; l < SW; l++)
+                simd_blocks.Append (order[i+l]);
+            i = j;
+          }
+        simd_firstgroup[c+1] = simd_blocks.Size() / SW;
+      }
+
+    size_t ngroups = simd_blocks.Size() / SW;
+    simd_start.SetSize (ngroups+1);
+    simd_start[0] = 0;
+    for (size_t g = 0; g < ngroups; g++)
+      simd_start[g+1] = simd_start[g] + sqr ((*blocktable)[simd_blocks[g*SW]].Size());
+    simd_inv.SetSize (simd_start[ngroups]);
+    simd_single.SetSize (ngroups);
+    simd_single = false;
+
+    ParallelFor (Range(ngroups), [&] (size_t g)
+                 {
+                   FlatArray<int> blocks = simd_blocks.Range (g*SW, (g+1)*SW);
+                   size_t bs = (*blocktable)[blocks[0]].Size();
+                   FlatMatrix<SIMD<double>> inv(bs, bs, &simd_inv[simd_start[g]]);
+                   Matrix<> blockmat(bs, bs);
+
+                   for (int lane = 0; lane < SW; lane++)
+                     {
+                       auto block = (*blocktable)[blocks[lane]];
+                       for (size_t j = 0; j < bs; j++)
+                         for (size_t k = 0; k < bs; k++)
+                           blockmat(j,k) = mat(block[j], block[k]);
+                       CalcInverse (blockmat);
+                       for (size_t j = 0; j < bs; j++)
+                         for (size_t k = 0; k < bs; k++)
+                           inv(j,k)[lane] = blockmat(j,k);
+                     }
+                 }, TasksPerThread(4));
+  }
+
+  template <>
+  void BlockJacobiPrecond<double,double,double> ::
+  MultAddSIMD (size_t g, double s, FlatVector<double> fx, FlatVector<double> fy, bool trans,
+               FlatVector<SIMD<double>> hx, FlatVector<SIMD<double>> hy) const
+  {
+    constexpr int SW = SIMD<double>::Size();
+    FlatArray<int> blocks = simd_blocks.Range (g*SW, (g+1)*SW);
+    size_t bs = (*blocktable)[blocks[0]].Size();
+
+    for (size_t j = 0; j < bs; j++)
+      hx(j) = SIMD<double> ([&] (int lane) { return fx((*blocktable)[blocks[lane]][j]); });
+
+    if (simd_single[g])
+      SIMDGroupMult (&simd_inv_single[simd_start[g]], bs, trans, hx, hy);
+    else
+      SIMDGroupMult (&simd_inv[simd_start[g]], bs, trans, hx, hy);
+
+    for (size_t j = 0; j < bs; j++)
+      for (int lane = 0; lane < SW; lane++)
+        fy((*blocktable)[blocks[lane]][j]) += s * hy(j)[lane];
+  }
+
+  template <>
+  void BlockJacobiPrecond<double,double,double> ::
+  SmoothSIMD (size_t g, FlatVector<double> fx, FlatVector<double> fb,
+              FlatVector<SIMD<double>> hx, FlatVector<SIMD<double>> hy) const
+  {
+    constexpr int SW = SIMD<double>::Size();
+    FlatArray<int> blocks = simd_blocks.Range (g*SW, (g+1)*SW);
+    size_t bs = (*blocktable)[blocks[0]].Size();
+
+    for (size_t j = 0; j < bs; j++)
+      hx(j) = SIMD<double> ([&] (int lane)
+                            {
+                              int jj = (*blocktable)[blocks[lane]][j];
+                              return fb(jj) - mat.RowTimesVector (jj, fx);
+                            });
+
+    if (simd_single[g])
+      SIMDGroupMult (&simd_inv_single[simd_start[g]], bs, false, hx, hy);
+    else
+      SIMDGroupMult (&simd_inv[simd_start[g]], bs, false, hx, hy);
+
+    for (size_t j = 0; j < bs; j++)
+      for (int lane = 0; lane < SW; lane++)
+        fx((*blocktable)[blocks[lane]][j]) += hy(j)[lane];
+  }
+
+  template <>
+  void BlockJacobiPrecond<double,double,double> ::
+  SetSinglePrecision (double tol)
+  {
+    static Timer t("BlockJacobiPrecond::SetSinglePrecision"); RegionTimer reg(t);
+    constexpr int SW = SIMD<double>::Size();
+    size_t ngroups = simd_single.Size();
+
+    // a group goes to float if all its rounded inverses satisfy |I - A_i Inv_i| < tol
+    Array<bool> single(ngroups);
+    ParallelFor (Range(ngroups), [&] (size_t g)
+                 {
+                   single[g] = simd_single[g];
+                   if (single[g]) return;
+
+                   FlatArray<int> blocks = simd_blocks.Range (g*SW, (g+1)*SW);
+                   size_t bs = (*blocktable)[blocks[0]].Size();
+                   FlatMatrix<SIMD<double>> inv(bs, bs, &simd_inv[simd_start[g]]);
+                   Matrix<> blockmat(bs, bs), rounded(bs, bs);
+
+                   double err = 0;
+                   for (int lane = 0; lane < SW; lane++)
+                     {
+                       auto block = (*blocktable)[blocks[lane]];
+                       for (size_t j = 0; j < bs; j++)
+                         for (size_t k = 0; k < bs; k++)
+                           {
+                             blockmat(j,k) = mat(block[j], block[k]);
+                             rounded(j,k) = float(inv(j,k)[lane]);
+                           }
+                       for (size_t j = 0; j < bs; j++)
+                         for (size_t k = 0; k < bs; k++)
+                           {
+                             double sum = (j == k) ? -1.0 : 0.0;
+                             for (size_t l = 0; l < bs; l++)
+                               sum += blockmat(j,l) * rounded(l,k);
+                             err = max2 (err, fabs(sum));
+                           }
+                     }
+                   single[g] = err < tol;
+                 }, TasksPerThread(4));
+
+    Array<size_t> start(ngroups+1);
+    size_t ndouble = 0, nsingle = 0, groups_single = 0;
+    for (size_t g = 0; g < ngroups; g++)
+      {
+        size_t size = sqr ((*blocktable)[simd_blocks[g*SW]].Size());
+        if (single[g])
+          {
+            start[g] = nsingle;
+            nsingle += size;
+            groups_single++;
+          }
+        else
+          {
+            start[g] = ndouble;
+            ndouble += size;
+          }
+      }
+    start[ngroups] = ndouble;
+
+    Array<SIMD<double>> newinv(ndouble);
+    Array<SIMD<float>> newinv_single(nsingle);
+    ParallelFor (Range(ngroups), [&] (size_t g)
+                 {
+                   size_t size = sqr ((*blocktable)[simd_blocks[g*SW]].Size());
+                   for (size_t l = 0; l < size; l++)
+                     if (simd_single[g])
+                       newinv_single[start[g]+l] = simd_inv_single[simd_start[g]+l];
+                     else if (single[g])
+                       newinv_single[start[g]+l] = SIMD<float> (simd_inv[simd_start[g]+l]);
+                     else
+                       newinv[start[g]+l] = simd_inv[simd_start[g]+l];
+                 });
+
+    simd_inv = move(newinv);
+    simd_inv_single = move(newinv_single);
+    simd_start = move(start);
+    simd_single = move(single);
+    mem_blocks.Set (BlockJacobiPrecond::GetMemoryUsage());
+
+    cout << IM(3) << groups_single << " of " << ngroups << " SIMD groups in single precision" << endl;
+  }
+
+
   
   template <class TM, class TV_ROW, class TV_COL>
   void BlockJacobiPrecond<TM, TV_ROW, TV_COL> ::
@@ -505,6 +792,7 @@ namespace ngla
   {
     static Timer timer("BlockJacobi::MultAdd");
     RegionTimer reg (timer);
+    AddBlockTraffic<TM,TVX> (timer, *blocktable);
     
     FlatVector<TVX> fx = x.FV<TVX> ();
     FlatVector<TVX> fy = y.FV<TVX> ();
@@ -512,14 +800,26 @@ namespace ngla
 
     for (int c : Range(block_coloring))        
       {
+        size_t firstgroup = simd_firstgroup[c];
+        size_t ng = simd_firstgroup[c+1] - firstgroup;
+
         ParallelForRange
           (color_balance[c],  [&] (IntRange r) 
            {
              Vector<TVX> hxmax(maxbs);
              Vector<TVX> hymax(maxbs);
+             Vector<SIMD<double>> hxsimd(ng ? maxbs : 0);
+             Vector<SIMD<double>> hysimd(ng ? maxbs : 0);
              
-             for (int i : block_coloring[c].Range(r))
+             for (size_t item : r)
                {
+                 if (item < ng)
+                   {
+                     MultAddSIMD (firstgroup+item, s, fx, fy, false, hxsimd, hysimd);
+                     continue;
+                   }
+
+                 int i = nonsimd_coloring[c][item-ng];
                  int bs = (*blocktable)[i].Size();
                  if (!bs) continue;
                  
@@ -551,16 +851,27 @@ namespace ngla
 
     for (int c = 0; c < block_coloring.Size(); c++)
       {
+        size_t firstgroup = simd_firstgroup[c];
+        size_t ng = simd_firstgroup[c+1] - firstgroup;
+
         ParallelForRange
           (color_balance[c], [&] (IntRange r) 
            {
              Vector<TVX> hxmax(maxbs);
              Vector<TVX> hymax(maxbs);
+             Vector<SIMD<double>> hxsimd(ng ? maxbs : 0);
+             Vector<SIMD<double>> hysimd(ng ? maxbs : 0);
              
-             FlatArray<int> blocks = block_coloring[c];
+             FlatArray<int> blocks = nonsimd_coloring[c];
              for (auto ii : r) 
                {
-                 size_t i = blocks[ii];
+                 if (ii < ng)
+                   {
+                     MultAddSIMD (firstgroup+ii, s, fx, fy, true, hxsimd, hysimd);
+                     continue;
+                   }
+
+                 size_t i = blocks[ii-ng];
                  auto block = (*blocktable)[i];
                  size_t bs = block.Size();
                  if (!bs) continue;
@@ -589,98 +900,44 @@ namespace ngla
   {
     static Timer timer ("BlockJacobiPrecond::GSSmooth");
     RegionTimer reg(timer);
-    timer.AddFlops (nze);
+    AddBlockTraffic<TM,TVX> (timer, *blocktable, nze, steps);
     
     FlatVector<TVX> fb = b.FV<TVX> (); 
     FlatVector<TVX> fx = x.FV<TVX> ();
 
-#ifdef OLD
-    for (int k = 0; k < steps; k++)
-      for (int c : Range(block_coloring))              
-        {
-          /*
-          ParallelForRange
-            (color_balance[c], [&] (IntRange r)
-             {
-               VectorMem<100,TVX> hxmax(maxbs);
-               VectorMem<100,TVX> hymax(maxbs);
-               
-               for (size_t i : block_coloring[c].Range(r))
-                 {
-                   FlatArray<int> block = (*blocktable)[i];
-                   size_t bs = block.Size();
-                   if (!bs) continue;
-                   
-                   FlatVector<TVX> hx = hxmax.Range(0,bs);
-                   FlatVector<TVX> hy = hymax.Range(0,bs);
-                   
-                   for (size_t j = 0; j < bs; j++)
-                     {
-                       auto jj = block[j];
-                       hx(j) = fb(jj) - mat.RowTimesVector (jj, fx);
-                     }
-                   
-                   hy = (invdiag[i]) * hx;
-                   fx(block) += hy;
-                 }
-               
-             });
-          */
-
-          auto col = block_coloring[c];
-          SharedLoop2 sl(col.Range());
-          
-          task_manager -> CreateJob
-              ( [&] (const TaskInfo & ti) 
-                {
-                  VectorMem<100,TVX> hxmax(maxbs);
-                  VectorMem<100,TVX> hymax(maxbs);
-
-                  for (auto mynr : sl)
-                    {
-                      size_t i = col[mynr];
-                      FlatArray<int> block = (*blocktable)[i];
-                      size_t bs = block.Size();
-                      if (!bs) continue;
-                      
-                      FlatVector<TVX> hx = hxmax.Range(0,bs);
-                      FlatVector<TVX> hy = hymax.Range(0,bs);
-                      
-                      for (size_t j = 0; j < bs; j++)
-                        {
-                          auto jj = block[j];
-                          hx(j) = fb(jj) - mat.RowTimesVector (jj, fx);
-                        }
-                      
-                      hy = (invdiag[i]) * hx;
-                      fx(block) += hy;
-                    }
-                });
-            
-        }
-#endif
-
     Array<SharedLoop2> loops(block_coloring.Size());
     
     for (int k = 0; k < steps; k++)
       {
         for (int c : Range(block_coloring))
-          loops[c].Reset (block_coloring[c].Range());
+          loops[c].Reset (IntRange(simd_firstgroup[c+1]-simd_firstgroup[c]
+                                   + nonsimd_coloring[c].Size()));
 
-        task_manager -> CreateJob
+        // the shared loop of a color is finished only when all its
+        // blocks are done, so the colors are processed one after the other
+        ParallelJob
           ( [&] (const TaskInfo & ti) 
             {
               VectorMem<100,TVX> hxmax(maxbs);
               VectorMem<100,TVX> hymax(maxbs);
+              Vector<SIMD<double>> hxsimd(simd_blocks.Size() ? maxbs : 0);
+              Vector<SIMD<double>> hysimd(simd_blocks.Size() ? maxbs : 0);
               
               for (int c : Range(block_coloring))              
                 {
-                  auto col = block_coloring[c];
-                  // SharedLoop2 sl(col.Range());
+                  auto col = nonsimd_coloring[c];
+                  size_t firstgroup = simd_firstgroup[c];
+                  size_t ng = simd_firstgroup[c+1] - firstgroup;
 
                   for (auto mynr : loops[c])
                     {
-                      size_t i = col[mynr];
+                      if (mynr < ng)
+                        {
+                          SmoothSIMD (firstgroup+mynr, fx, fb, hxsimd, hysimd);
+                          continue;
+                        }
+
+                      size_t i = col[mynr-ng];
                       FlatArray<int> block = (*blocktable)[i];
                       size_t bs = block.Size();
                       if (!bs) continue;
@@ -712,7 +969,7 @@ namespace ngla
   {
     static Timer timer ("BlockJacobiPrecond::GSSmoothBack");
     RegionTimer reg(timer);
-    timer.AddFlops (nze);
+    AddBlockTraffic<TM,TVX> (timer, *blocktable, nze, steps);
 
     const FlatVector<TVX> fb = b.FV<TVX> (); 
     FlatVector<TVX> fx = x.FV<TVX> ();
@@ -720,14 +977,26 @@ namespace ngla
     for (int k = 0; k < steps; k++)
       for (int c = block_coloring.Size()-1; c >=0; c--) 
         {
+          size_t firstgroup = simd_firstgroup[c];
+          size_t ng = simd_firstgroup[c+1] - firstgroup;
+
           ParallelForRange
             (color_balance[c], [&] (IntRange r)
              {
                VectorMem<100,TVX> hxmax(maxbs);
                VectorMem<100,TVX> hymax(maxbs);
+               Vector<SIMD<double>> hxsimd(ng ? maxbs : 0);
+               Vector<SIMD<double>> hysimd(ng ? maxbs : 0);
                
-               for (size_t i : block_coloring[c].Range(r))
+               for (size_t item : r)
                  {
+                   if (item < ng)
+                     {
+                       SmoothSIMD (firstgroup+item, fx, fb, hxsimd, hysimd);
+                       continue;
+                     }
+
+                   size_t i = nonsimd_coloring[c][item-ng];
                    FlatArray<int> block = (*blocktable)[i];
                    size_t bs = block.Size();
                    if (!bs) continue;
@@ -848,7 +1117,14 @@ namespace ngla
                             throw;
                           }
                       });
+
+        ComputeSIMDBlockFactors ();
       }
+
+    size_t factor_bytes = simd_data.OwnedBytes();
+    for (auto & d : data)
+      factor_bytes += d.OwnedBytes();
+    mem_blocks.Set (factor_bytes);
         
     cout << IM(3) << "\rBuilding block " << blocktable->Size() << "/" << blocktable->Size() << endl;
     // cout << "\rBuilt symmetric BlockJacobi Preconditioner" << endl;
@@ -975,6 +1251,70 @@ namespace ngla
   } 
 
 
+  template <class TM, class TV>
+  void BlockJacobiPrecondSymmetric<TM,TV> :: 
+  ComputeSIMDBlockFactors ()
+  { ; }
+
+  template <>
+  void BlockJacobiPrecondSymmetric<double,double> :: 
+  ComputeSIMDBlockFactors ()
+  {
+    constexpr int SW = SIMD<double>::Size();
+
+    // sort by (size, bandwidth), full groups of SW blocks go into SIMD lanes
+    Array<int> order;
+    for (int i = 0; i < blocktable->Size(); i++)
+      if ((*blocktable)[i].Size())
+        order.Append (i);
+    QuickSort (order, [&] (int a, int b)
+               {
+                 if (blocksize[a] != blocksize[b]) return blocksize[a] < blocksize[b];
+                 return blockbw[a] < blockbw[b];
+               });
+
+    simd_blocks.SetSize0();
+    nonsimd_blocks.SetSize0();
+    for (int i = 0; i < order.Size(); )
+      {
+        int j = i;
+        while (j < order.Size() && blocksize[order[j]] == blocksize[order[i]]
+               && blockbw[order[j]] == blockbw[order[i]])
+          j++;
+        int k = i;
+        for ( ; k+SW <= j; k++)
+          simd_blocks.Append (order[k]);
+        for ( ; k < j; k++)
+          nonsimd_blocks.Append (order[k]);
+        i = j;
+      }
+
+    int ngroups = simd_blocks.Size() / SW;
+    simd_start.SetSize (ngroups+1);
+    simd_start[0] = 0;
+    for (int g = 0; g < ngroups; g++)
+      {
+        int bnr = simd_blocks[g*SW];
+        simd_start[g+1] = simd_start[g] + FlatBandCholeskyFactors<>::RequiredMem (blocksize[bnr], blockbw[bnr]);
+      }
+    simd_data.SetSize (simd_start[ngroups]);
+
+    // the factors have the same layout, copy them lane by lane
+    ParallelFor (Range(ngroups), [&] (int g)
+                 {
+                   FlatArray<int> blocks = simd_blocks.Range (g*SW, (g+1)*SW);
+                   for (int l = 0; l < simd_start[g+1]-simd_start[g]; l++)
+                     simd_data[simd_start[g]+l] =
+                       SIMD<double> ([&] (int lane)
+                                     {
+                                       int bnr = blocks[lane];
+                                       return data[bnr%NBLOCKS][blockstart[bnr]+l];
+                                     });
+                 });
+  }
+
+
+
 
 
 
@@ -984,6 +1324,7 @@ namespace ngla
   {
     static Timer timer("BlockJacobiSymmetric::MultAdd");
     RegionTimer reg (timer);
+    AddBlockTraffic<TM,TVX> (timer, *blocktable);
 
     FlatVector<TVX> fx = x.FV<TVX> ();
     FlatVector<TVX> fy       = y.FV<TVX> ();
@@ -1010,6 +1351,60 @@ namespace ngla
   }
 
 
+  template <>
+  void BlockJacobiPrecondSymmetric<double,double> :: 
+  MultAdd (double s, const BaseVector & x, BaseVector & y) const 
+  {
+    static Timer timer("BlockJacobiSymmetric::MultAdd, SIMD");
+    RegionTimer reg (timer);
+    AddBlockTraffic<double,double> (timer, *blocktable);
+    constexpr int SW = SIMD<double>::Size();
+
+    FlatVector<> fx = x.FV<double> ();
+    FlatVector<> fy = y.FV<double> ();
+
+    Vector<SIMD<double>> hxsimd(maxbs);
+    Vector<SIMD<double>> hysimd(maxbs);
+
+    for (int g = 0; g+1 < simd_start.Size(); g++)
+      {
+        FlatArray<int> blocks = simd_blocks.Range (g*SW, (g+1)*SW);
+        int bs = blocksize[blocks[0]];
+        FlatVector<SIMD<double>> hx = hxsimd.Range (0, bs);
+        FlatVector<SIMD<double>> hy = hysimd.Range (0, bs);
+
+        for (int j = 0; j < bs; j++)
+          hx(j) = SIMD<double> ([&] (int lane) { return fx((*blocktable)[blocks[lane]][j]); });
+
+        FlatBandCholeskyFactors<SIMD<double>> inv (bs, blockbw[blocks[0]],
+                                                   const_cast<SIMD<double>*>(&simd_data[simd_start[g]]));
+        inv.Mult (hx, hy);
+        
+        for (int j = 0; j < bs; j++)
+          for (int lane = 0; lane < SW; lane++)
+            fy((*blocktable)[blocks[lane]][j]) += s * hy(j)[lane];
+      }
+
+    Vector<> hxmax(maxbs);
+    Vector<> hymax(maxbs);
+
+    for (int i : nonsimd_blocks)
+      {
+	int bs = (*blocktable)[i].Size();
+	FlatVector<> hx = hxmax.Range (0, bs); 
+	FlatVector<> hy = hymax.Range (0, bs); 
+
+	for (int j = 0; j < bs; j++)
+	  hx(j) = fx((*blocktable)[i][j]);
+	
+	InvDiag(i).Mult (hx, hy);
+
+	for (int j = 0; j < bs; j++)
+	  fy((*blocktable)[i][j]) += s * hy(j);
+      }
+  }
+
+
   template <class TM, class TV>
   void BlockJacobiPrecondSymmetric<TM,TV> :: 
   MultTransAdd (TSCAL s, const BaseVector & x, BaseVector & y) const 
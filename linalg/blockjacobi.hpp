@@ -30,6 +30,9 @@ namespace ngla
     Array<Partitioning> color_balance;
 
     size_t nze;
+
+    /// registers the inverses or factors of the blocks, see MemoryRegistry
+    MemoryTracker mem_blocks { MemoryRegistry::PRECONDITIONER };
   public:
     /// the blocktable define the blocks. ATTENTION: entries will be reordered !
     BaseBlockJacobiPrecond (shared_ptr<Table<int>> ablocktable);
@@ -61,6 +64,9 @@ namespace ngla
       GSSmoothBack (x, b, 1);
     }
 
+    /// store block inverses in float where the rounding error max |I - A_i Inv_i| is below tol
+    virtual void SetSinglePrecision (double tol) { ; }
+
 
     /// reorders block entries for band-width minimization
     int Reorder (FlatArray<int> block, const MatrixGraph & graph,
@@ -112,6 +118,11 @@ namespace ngla
   class  NGS_DLL_HEADER BlockJacobiPrecond : virtual public BaseBlockJacobiPrecond,
                                          virtual public S_BaseMatrix<typename mat_traits<TM>::TSCAL>
   {
+  public:
+    // typedef typename mat_traits<TM>::TV_ROW TVX;
+    typedef TV_ROW TVX;
+    typedef typename mat_traits<TM>::TSCAL TSCAL;
+
   protected:
     /// a reference to the matrix
     const SparseMatrix<TM,TV_ROW,TV_COL> & mat;
@@ -120,11 +131,30 @@ namespace ngla
     /// the data for the inverses
     Array<TM> bigmem;
 
-  public:
-    // typedef typename mat_traits<TM>::TV_ROW TVX;
-    typedef TV_ROW TVX;
-    typedef typename mat_traits<TM>::TSCAL TSCAL;
+    // blocks of equal size within one color, inverted together and
+    // stored interleaved in SIMD lanes (TM = double only).
+    // the groups of color c are [simd_firstgroup[c], simd_firstgroup[c+1])
+    Array<int> simd_blocks;       // SIMD<double>::Size() consecutive entries per group
+    Array<size_t> simd_firstgroup;
+    Array<size_t> simd_start;     // offset of group g in simd_inv or simd_inv_single
+    Array<bool> simd_single;
+    Array<SIMD<double>> simd_inv;
+    Array<SIMD<float>> simd_inv_single;
+    /// blocks of color c not in a SIMD group
+    Table<int> nonsimd_coloring;
+
+    /// groups and inverts blocks of equal size, if supported for TM
+    void ComputeSIMDInverses ();
+
+    /// fy += s Inv fx for the blocks of group g
+    void MultAddSIMD (size_t g, TSCAL s, FlatVector<TVX> fx, FlatVector<TVX> fy, bool trans,
+                      FlatVector<SIMD<double>> hx, FlatVector<SIMD<double>> hy) const;
+
+    /// block Gauss-Seidel step for the blocks of group g
+    void SmoothSIMD (size_t g, FlatVector<TVX> fx, FlatVector<TVX> fb,
+                     FlatVector<SIMD<double>> hx, FlatVector<SIMD<double>> hy) const;
 
+  public:
     ///
     BlockJacobiPrecond (const SparseMatrix<TM,TV_ROW,TV_COL> & amat, 
 			shared_ptr<Table<int>> ablocktable);
@@ -172,15 +202,12 @@ namespace ngla
       ;
     }
 
+    virtual void SetSinglePrecision (double tol);
+
     virtual Array<MemoryUsage> GetMemoryUsage () const
     {
-      int nels = 0;
-      for (int i = 0; i < blocktable->Size(); i++)
-	{
-	  int bs = (*blocktable)[i].Size();
-	  nels += bs*bs;
-	}
-      return { MemoryUsage ("BlockJac", nels*sizeof(TM), blocktable->Size()) };
+      return { MemoryUsage ("BlockJac", bigmem.Size()*sizeof(TM) + simd_inv.Size()*sizeof(SIMD<double>)
+                            + simd_inv_single.Size()*sizeof(SIMD<float>), blocktable->Size()) };
     }
 
 
@@ -210,6 +237,12 @@ namespace ngla
     Array<int> blockstart, blocksize, blockbw;
     Array<TM> data[NBLOCKS];
 
+    // blocks of equal size and bandwidth, factored together in
+    // SIMD lanes for MultAdd (TM = double only)
+    Array<int> simd_blocks;       // SIMD<double>::Size() consecutive entries per group
+    Array<int> simd_start;
+    Array<SIMD<double>> simd_data;
+    Array<int> nonsimd_blocks;
 
     bool lowmem;
   public:
@@ -237,6 +270,9 @@ namespace ngla
     }
 
     void ComputeBlockFactor (FlatArray<int> block, int bw, FlatBandCholeskyFactors<TM> & inv) const;
+
+    /// group blocks for the SIMD-batched band solver, if supported for TM
+    void ComputeSIMDBlockFactors ();
   
     ///
     virtual void MultAdd (TSCAL s, const BaseVector & x, BaseVector & y) const;
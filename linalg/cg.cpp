@@ -1,1340 +1,2053 @@
-/**************************************************************************/
-/* File:   cg.cpp                                                         */
-/* Author: Joachim Schoeberl                                              */
-/* Date:   5. Jul. 96                                                     */
-/**************************************************************************/
-
-/* 
-
-  Conjugate Gradient Soler
-  
-*/ 
-
-#include <la.hpp>
-
-namespace ngla
-{
-  inline double Abs (const double & v)
-  {
-    return fabs (v);
-  }
-
-  inline double Abs (const Complex & v)
-  {
-    return std::abs (v);
-  }
-
-
-  KrylovSpaceSolver :: KrylovSpaceSolver ()
-  {
-    //      SetSymmetric();
-    
-    a = 0;  
-    c = 0;
-    SetPrecision (1e-10);
-    SetMaxSteps (200); 
-    SetInitialize (1);
-    printrates = 0;
-    sh = NULL;
-    useseed = false;
-  }
-  
-
-  KrylovSpaceSolver :: KrylovSpaceSolver (const BaseMatrix & aa)
-  {
-    //  SetSymmetric();
-    
-    SetMatrix (aa);
-    c = NULL;
-    SetPrecision (1e-10);
-    SetMaxSteps (200);
-    SetInitialize (1);
-    printrates = 0;
-    sh = NULL;
-    useseed = false;
-  }
-
-
-
-  KrylovSpaceSolver :: KrylovSpaceSolver (const BaseMatrix & aa, const BaseMatrix & ac)
-  {
-    //  SetSymmetric();
-    
-    SetMatrix (aa);
-    SetPrecond (ac);
-    SetPrecision (1e-8);
-    SetMaxSteps (200);
-    SetInitialize (1);
-    printrates = 0;
-    sh = NULL;
-    useseed = false;
-  }
-
- 
-  AutoVector KrylovSpaceSolver :: CreateVector () const
-  {
-    return a->CreateVector();
-  }
-
-
-  template <class SCAL>
-  void BruteInnerProduct(const BaseVector & a, const BaseVector & b, Vector<SCAL> & result, const int start = 0)
-  {
-    const SCAL * pa;
-    const SCAL * pb;
-    int i;
-
-    for(int i=start; i<result.Size(); i++)
-      result[i] = 0;
-
-    
-    if(start == 0)
-      for(i=0, pa = (SCAL*)(a.Memory()), pb = (SCAL*)(b.Memory()); i<a.Size()*result.Size(); i++,pa++,pb++)
-	result[i%result.Size()] += (*pa)*(*pb);
-    else
-      {
-	pa = (SCAL*)(a.Memory());
-	pb = (SCAL*)(b.Memory());
-	for(i=0; i<a.Size();i++)
-	  {
-	    pa += start;
-	    pb += start;
-	
-	    for(int j=start; j<result.Size(); j++)
-	      {
-		result[j] += (*pa)*(*pb);
-		pa++;
-		pb++;
-	      }
-	  }
-      }
-
-  }
-
-
-  template <class SCAL>
-  void BruteInnerProduct2(const BaseVector & a, const BaseVector & b, Vector<SCAL> & result, const int start)
-  {
-    const SCAL * pa;
-    const SCAL * pb;
-    int i;
-
-    for(int i=start; i<result.Size(); i++)
-      result[i] = 0;
-
-    pa = (SCAL*)(a.Memory());
-    pb = (SCAL*)(b.Memory());
-    for(i=0; i<a.Size();i++)
-      {
-	pb += start;
-
-	for(int j=start; j<result.Size(); j++)
-	  {
-	    result[j] += (*pa)*(*pb);
-	    pb++;
-	  }
-	pa++;
-      }
-      
-  }
-
-  template <class IPTYPE>
-  void CGSolver<IPTYPE> :: MultiMult (const BaseVector & f, BaseVector & u, const int dim) const
-  {
-    try
-      {
-	// Solve A u = f
-	if(sh)
-	  sh->SetThreadPercentage(0);
-
-	auto d = f.CreateVector();
-	auto w = f.CreateVector();
-	auto s = f.CreateVector();
-
-	int n = 0;
-	Vector<SCAL> al(dim), be(dim), wd(dim), wdn(dim), kss(dim);
-	double err;
-
-	if (initialize)
-	  {
-	    u = 0.0;
-	    d = f;
-	  }
-	else
-	  {
-	    d = f - (*a) * u;
-	  }
-	if (c)
-	  w = (*c) * d;
-	else
-	  w = d;
-
-	s = w;
-	
-	BruteInnerProduct(w,d,wdn);	 
-
-	if (printrates) cout << IM(1) << "0 " << sqrt(L2Norm(wdn)) << endl;
-	if (L2Norm(wdn) == 0.0) wdn = 1;	
-
-	if(stop_absolute)
-	  err = prec * prec;
-	else
-	  err = prec * prec * L2Norm (wdn);
-	
-	double lwstart = log(L2Norm(wdn));
-	double lerr = log(err);
-	
-
-	while (n++ < maxsteps && L2Norm(wdn) > err && !(sh && sh->ShouldTerminate()))
-	  {
-	    w = (*a) * s;
-
-	    wd = wdn;
-
-	    BruteInnerProduct(s,w,kss);
-	   
-	    //(*testout) << "INNERPROD kss " <<kss << endl;
-	    if (L2Norm(kss) == 0.0) break;
-	    
-	    for(int i = 0; i<dim; i++)
-	      al[i] = wd[i] / kss[i];
-	    
-	    SCAL * pl;
-	    const SCAL * pr;
-
-	    int i;
-
-	    for(pl = (SCAL*)(u.Memory()), pr = (SCAL*)(s.Memory()), i=0; i<dim*u.Size(); i++,pl++,pr++)
-	      *pl += al[i%dim]*(*pr);
-	      
-	    for(pl = (SCAL*)(d.Memory()), pr = (SCAL*)(w.Memory()), i=0; i<dim*u.Size(); i++,pl++,pr++)
-	      *pl -= al[i%dim]*(*pr);
-	      
-
-	    //u += al * s;
-	    //d -= al * w;
-
-	    if (c)
-	      w = (*c) * d;
-	    else
-	      w = d;
-
-	    BruteInnerProduct(w,d,wdn);
-
-	    //(*testout) << "wdn " << wdn << endl;
-	    
-	    for(int i = 0; i<dim; i++)
-	      be[i] = wdn[i] / wd[i];
-	    
-	    for(pl = (SCAL*)(s.Memory()), pr = (SCAL*)(w.Memory()), i=0; i<dim*s.Size(); i++,pl++,pr++)
-	      *pl = (*pl)*be[i%dim] + *pr;
-
-	    //s *= be;
-	    //s += w;
-
-	    if (printrates ) cout << IM(1) << n << " " << sqrt(L2Norm (wdn)) << endl;
-	    if(sh)
-	      sh->SetThreadPercentage(100.*max2(double(n)/double(maxsteps),
-						(lwstart-log(L2Norm(wdn)))/(lwstart-lerr)));
-	  } 
-	
-	const_cast<int&> (steps) = n;
-	
-        /*
-	delete &d;
-	delete &w;
-	delete &s;
-        */
-      }
-
-    catch (Exception & e)
-      {
-	e.Append ("in caught in CGSolver::Mult\n");
-	throw;
-      }
-    catch (exception & e)
-      {
-	throw Exception(e.what() +
-			string ("\ncaught in CGSolver::Mult\n"));
-      }
-  }
-
-
-  template <class IPTYPE>
-  void CGSolver<IPTYPE> :: MultiMultSeed (const BaseVector & f, BaseVector & u, const int dim) const
-  {
-    try
-      {
-	// Solve A u = f
-	if(sh)
-	  sh->SetThreadPercentage(0);
- 
-	SCAL * pl;
-	const SCAL * pr;
-	int i;
-
-	auto d = f.CreateVector();
-
-	BaseMatrix * smalla;
-        /*
-	if(dynamic_cast< const SparseMatrixSymmetricTM<SCAL> *>(a))
-	  smalla = new SparseMatrixSymmetric<SCAL,SCAL>(*dynamic_cast< const SparseMatrixSymmetricTM<SCAL> *>(a));
-	else
-        */
-        if (dynamic_cast< const SparseMatrixTM<SCAL> *>(a))
-	  smalla = new SparseMatrix<SCAL,SCAL>(*dynamic_cast< const SparseMatrixTM<SCAL> *>(a));
-	else
-	  throw Exception("Assumption about bilinearform wrong.");
-
-
-	//BaseVector & aux1 = (smalla) ? d : *f.CreateVector();
-	//BaseVector & aux2 = (smalla) ? d : *f.CreateVector();
-	
-
-	VVector<SCAL> w(f.Size());
-	VVector<SCAL> d_reduced(f.Size());
-	VVector<SCAL> s(f.Size());
-
-	int n = 0;
-
-	SCAL be,wd,wdn,kss;
-	Vector<SCAL> al(dim);
-	Array<double> err(dim);
-
-	if (initialize)
-	  {
-	    u = 0.0;
-	    d = f;
-	  }
-	else
-	  {
-	    d = f - (*a) * u;
-	  }
-
-		
-	double lwstart;
-	double lerr;
-	
-
-
-	for(int seed = dim-1; seed >= 0; seed--)
-	  {
-	    
-	    pr = (SCAL*)(d.Memory());
-	    pr += seed;
-
-	    for(i=0, pl = (SCAL*)(d_reduced.Memory()); i<d.Size(); i++, pl++)
-	      {
-		(*pl) = (*pr);
-		pr += dim;
-	      }
-	    
-	    
-	   
-	    if (c)
-	      w = (*c) * d_reduced;
-	    else
-	      w = d_reduced;
-
-	    if(stop_absolute)
-	      err[seed] = prec * prec;
-	    else
-	      err[seed] = prec * prec * Abs (S_InnerProduct<SCAL>(w,d_reduced));
-	  }
-
-
-	for(int seed = 0; seed < dim; seed++)
-	  {
-	    (*testout) << "seed " << seed << endl;
-
-	    if(seed > 0)
-	      {
-		pr = (SCAL*)(d.Memory());
-		pr += seed;
-
-		for(i=0, pl = (SCAL*)(d_reduced.Memory()); i<d.Size(); i++, pl++)
-		  {
-		    (*pl) = (*pr);
-		    pr += dim;
-		  }
-		
-		
-		
-		if (c)
-		  w = (*c) * d_reduced;
-		else
-		  w = d_reduced;
-	      }
-	    
-	    s = w;	    
-	    
-	    wdn = S_InnerProduct<SCAL>(w,d_reduced);
-	    
-	    
-	    if (printrates ) cout << IM(1) << n << " (block " << seed+1 << ") " << sqrt (Abs (wdn)) << endl;
-	    if(Abs(wdn) == 0.0) wdn = 1;
-
-	    lwstart = log(Abs(wdn));
-	    lerr = log(err[seed]);
-	    
-
-
-	    while (n++ < maxsteps && Abs(wdn) > err[seed] && !(sh && sh->ShouldTerminate()))
-	      {
-		//if(smalla)
-		w = (*smalla)  * s;
-		/*
-		else
-		  {
-		    pl = (SCAL*)(aux1.Memory());
-		    pr = (SCAL*)(s.Memory());
-		    for(i=0; i<s.Size(); i++)
-		      {
-			for(int j=0; j<dim; j++)
-			  {
-			    *pl = *pr;
-			    pl++;
-			  }
-			pr++;
-		      }
-		    aux2 = (*a) * aux1;
-		    pl = (SCAL*)(w.Memory());
-		    pr = (SCAL*)(aux2.Memory());
-		    for(i=0; i<s.Size(); i++)
-		      {
-			*pl = *pr;
-			pl++;
-			pr += dim;
-		      }
-		  }
-		*/
-
-		//w = (*a) * s;
-		
-		wd = wdn;
-		
-		kss = S_InnerProduct<IPTYPE> (s, w);
-		if (kss == 0.0) break;
-		
-
-		BruteInnerProduct2(s,d,al,seed+1);
-		al[seed] = wd;
-		
-		for(i=seed; i<dim; i++)
-		  al[i] /= kss;
-
-		
-		
-		//(*testout) << "al " << al << endl;
-		
-		pl = (SCAL*)(u.Memory());
-		pr = (SCAL*)(s.Memory());
-		for(i=0; i<u.Size(); i++)
-		  {
-		    pl += seed;
-
-		    for(int j=seed; j<dim; j++)
-		      {
-			*pl += al[j]*(*pr);
-			pl++;
-		      }
-		    pr++;
-		  }
-		
-		pl = (SCAL*)(d.Memory());
-		pr = (SCAL*)(w.Memory());
-		for(i=0; i<d.Size(); i++)
-		  {
-		    pl += seed;
-
-		    for(int j=seed; j<dim; j++)
-		      {
-			*pl -= al[j]*(*pr);
-			pl++;
-		      }
-		    pr++;
-		  }
-				
-		//u += al * s;
-		//d -= al * w;
-
-
-		
-		pr = (SCAL*)(d.Memory());
-		pr += seed;
-
-		for(i=0, pl = (SCAL*)(d_reduced.Memory()); i<d.Size(); i++, pl++)
-		  {
-		    *pl = *pr;
-		    pr += dim;
-		  }
-
-		
-		if (c)
-		  w = (*c) * d_reduced;
-		else
-		  w = d_reduced;
-
-		wdn = S_InnerProduct<IPTYPE> (d_reduced, w);
-
-		be = wdn/wd;
-		
-		s *= be;
-		s += w;
-
-		if (printrates ) cout << IM(1) << n << " (block " << seed+1 << ") " << sqrt (Abs (wdn)) << endl;
-		if(sh)
-		  sh->SetThreadPercentage(100.*max2(double(n)/double(maxsteps),
-						    (lwstart-log(Abs(wdn)))/(lwstart-lerr)));
-	      } 
-	  }
-	const_cast<int&> (steps) = n;
-	
-	/*
-	if(!smalla)
-	  {
-	    delete &aux1;
-	    delete &aux2;
-	  }
-	*/
-	delete smalla;
-      }
-
-    catch (Exception & e)
-      {
-	e.Append ("in caught in CGSolver::Mult\n");
-	throw;
-      }
-    catch (exception & e)
-      {
-	throw Exception(e.what() +
-			string ("\ncaught in CGSolver::Mult\n"));
-      }
-  }
-
-
-  template <class IPTYPE>
-  void CGSolver<IPTYPE> :: Mult (const BaseVector & f, BaseVector & u) const
-  {
-    static Timer timer ("CG solver");
-    RegionTimer reg (timer);
-
-    int dim = 1;
-
-    if(dynamic_cast<VVector< Vec<2, SCAL> >* >(&u))
-      dim = 2;
-    else if(dynamic_cast<VVector< Vec<3, SCAL> >* >(&u))
-      dim = 3;
-    else if(dynamic_cast<VVector< Vec<4, SCAL> >* >(&u))
-      dim = 4;
-    else if(dynamic_cast<VVector< Vec<5, SCAL> >* >(&u))
-      dim = 5;
-    else if(dynamic_cast<VVector< Vec<6, SCAL> >* >(&u))
-      dim = 6;
-    else if(dynamic_cast<VVector< Vec<7, SCAL> >* >(&u))
-      dim = 7;
-    else if(dynamic_cast<VVector< Vec<8, SCAL> >* >(&u))
-      dim = 8;
-    /*
-    else if(dynamic_cast<VVector< Vec<9, SCAL> >* >(&u))
-      dim = 9;
-    else if(dynamic_cast<VVector< Vec<10, SCAL> >* >(&u))
-      dim = 10;
-    else if(dynamic_cast<VVector< Vec<11, SCAL> >* >(&u))
-      dim = 11;
-    else if(dynamic_cast<VVector< Vec<12, SCAL> >* >(&u))
-      dim = 12;
-    else if(dynamic_cast<VVector< Vec<13, SCAL> >* >(&u))
-      dim = 13;
-    else if(dynamic_cast<VVector< Vec<14, SCAL> >* >(&u))
-      dim = 14;
-    else if(dynamic_cast<VVector< Vec<15, SCAL> >* >(&u))
-      dim = 15;
-    */
-    //cout << "useseed: " << useseed << " dim: " << dim << endl;
-
-    if(useseed && dim != 1)
-      {
-	MultiMultSeed(f,u,dim);
-	//MultiMult(f,u,dim);
-	return;
-      }
- 
-    
-    try
-      {
-	// Solve A u = f
-	if(sh)
-	  sh->SetThreadPercentage(0);
- 
-        auto d = f.CreateVector();
-        auto w = f.CreateVector();
-        auto s = f.CreateVector();
-
-	int n = 0;
-	SCAL al, be, wd, wdn, kss;
-	double err;
-	if (initialize)
-	  {
-	    u = 0.0;
-	    d = f;
-	  }
-	else
-	  {
-	    d = f - (*a) * u;
-	  }
-
-	if (c)
-	  w = (*c) * d;
-	else
-	  w = d;
-
-	s = w;
-	wdn = S_InnerProduct<IPTYPE> (w,d);
-
-	if (printrates) cout << IM(1) << "0 " << sqrt(Abs(wdn)) << endl;
-	if (wdn == 0.0) wdn = 1;	
-
-	if(stop_absolute)
-	  err = prec * prec;
-	else
-	  err = prec * prec * Abs (wdn);
-	
-	double lwstart = log(Abs(wdn));
-	double lerr = log(err);
-	
-	while (n++ < maxsteps && Abs(wdn) > err && !(sh && sh->ShouldTerminate()))
-	  {
-	    w = (*a) * s;
-	    wd = wdn;
-	    kss = S_InnerProduct<IPTYPE> (s, w);
-	    if (kss == 0.0) break;
-	    
-	    al = wd / kss;
-	    u += al * s;
-	    d -= al * w;
-
-	    if (c)
-	      w = (*c) * d;
-	    else
-	      w = d;
-	    wdn = S_InnerProduct<IPTYPE> (d, w);
-
-	    be = wdn / wd;
-	    
-	    s *= be;
-	    s += w;
-
-	    if (printrates ) cout << IM(1) << n << " " << sqrt (Abs (wdn)) << endl;
-	    if ( sh )
-	      sh->SetThreadPercentage(100.*max2(double(n)/double(maxsteps),
-						(lwstart-log(Abs(wdn)))/(lwstart-lerr)));
-	  } 
-	
-	const_cast<int&> (steps) = n;
-      }
-
-    catch (Exception & e)
-      {
-	e.Append ("in caught in CGSolver::Mult\n");
-	throw;
-      }
-    catch (exception & e)
-      {
-	throw Exception(e.what() +
-			string ("\ncaught in CGSolver::Mult\n"));
-      }
-  }
-
-
-
-
-
-  template <class IPTYPE>
-  void BiCGStabSolver<IPTYPE> :: Mult (const BaseVector & f, BaseVector & u) const
-  {
-    
-    try
-      {
-	// Solve A u = f
-	if(sh)
-	  sh->SetThreadPercentage(0);
- 
-	auto r = f.CreateVector();
-	auto r_tilde = f.CreateVector();
-	auto p = f.CreateVector();
-	auto p_tilde = f.CreateVector();
-	auto s = f.CreateVector();
-	auto s_tilde = f.CreateVector();
-	auto t = f.CreateVector();
-	auto v = f.CreateVector();
-
-	int n = 0;
-	SCAL rho_old, rho_new, beta, alpha, omega;
-	double err, err_i;
-
-	if (initialize)
-	  {
-	    u = 0.0;
-	    r = f;
-	  }
-	else
-	  {
-	    r = f - (*a) * u;
-	  }
-	r_tilde = r;
-
-	rho_new = S_InnerProduct<IPTYPE>(r_tilde, r);
-	p = r;
-	if (c)
-	  p_tilde = (*c) * p;
-	else
-	  p_tilde = p;
-
-	v = (*a) * p_tilde;
-	alpha = rho_new / S_InnerProduct<IPTYPE> (r_tilde, v);
-	s = r - alpha * v;
-
-	err_i = L2Norm(s);
-	if (c)
-	  s_tilde = (*c) * s;
-	else
-	  s_tilde = s;
-
-	t = (*a) * s_tilde;
-
-	omega = S_InnerProduct<IPTYPE> (t, s) / S_InnerProduct<IPTYPE> (t, t);
-	u += alpha * p_tilde + omega * s_tilde;
-	r = s - omega * t;
-
-	err_i = L2Norm(r);
-	if (printrates) cout << IM(1) << "0 " << err_i << endl;
-
-
-	if(stop_absolute)
-	  err = prec * prec;
-	else
-	  err = prec * prec * err_i;
-	
-	double lwstart = log(err_i);
-	double lerr = log(err);
-	
-
-	while (n++ < maxsteps && err_i > err && !(sh && sh->ShouldTerminate()))
-	  {
-	    rho_old = rho_new;
-	    rho_new = S_InnerProduct<IPTYPE>(r_tilde, r);
-	    beta = (rho_new / rho_old ) * ( alpha / omega );
-	    p = r + beta * ( p - omega * v );
-
-	    if (c)
-	      p_tilde = (*c) * p;
-	    else
-	      p_tilde = p;
-	    
-	    v = (*a) * p_tilde;
-	    alpha = rho_new / S_InnerProduct<IPTYPE> (r_tilde, v);
-	    s = r - alpha * v;
-
-	    err_i = L2Norm(s);
-	    u += alpha * p_tilde;
-	    
-	    if ( err_i < err )
-	      {
-		break;
-	      }
-
-	    if (c)
-	      s_tilde = (*c) * s;
-	    else
-	      s_tilde = s;
-
-	    t = (*a) * s_tilde;
-	    
-	    omega = S_InnerProduct<IPTYPE> (t, s) / S_InnerProduct<IPTYPE> (t, t);
-	    u +=  omega * s_tilde;
-	    r = s - omega * t;
-
-	    err_i = L2Norm(r);
-
-	    if (printrates ) cout << IM(1) << n << " " << err_i << endl;
-	    if(sh)
-	      sh->SetThreadPercentage(100.*max2(double(n)/double(maxsteps),
-						(lwstart-log(err_i))/(lwstart-lerr)));
-	  } 
-	
-	const_cast<int&> (steps) = n;
-      }
-
-    catch (Exception & e)
-      {
-	e.Append ("in caught in BiCGStabSolver::Mult\n");
-	throw;
-      }
-    catch (exception & e)
-      {
-	throw Exception(e.what() +
-			string ("\ncaught in BiCGStabSolver::Mult\n"));
-      }
-  }
-
-
-
-
-  template <class IPTYPE>
-  void SimpleIterationSolver<IPTYPE> :: Mult (const BaseVector & f, BaseVector & u) const
-  {
-
-  try
-      {
-	// Solve A u = f
-	if(sh)
-	  sh->SetThreadPercentage(0);
- 
-	auto d = f.CreateVector();
-	auto w = f.CreateVector();
-
-	int n = 0;
-	double err, err0;
-
-	if (initialize)
-	  {
-	    u = 0.0;
-	    d = f;
-	  }
-	else
-	  {
-	    d = f - (*a) * u;
-	  }
-
-
-        err = err0 = 1;
-
-	while (n++ < maxsteps && err > prec * err0)
-          {
-            d = f - (*a) * u;
-
-            if (c)
-              w = (*c) * d;
-            else
-              w = d;
-
-            u += tau * w;
-
-            err = Abs (S_InnerProduct<IPTYPE> (w, d));
-            if (n == 1) err0 = err;
-
-	    if (printrates ) cout << IM(1) << n << " " << sqrt (err) << endl;
-          }
-
-	const_cast<int&> (steps) = n;
-      }
-
-    catch (Exception & e)
-      {
-	e.Append ("in caught in SimpleIterationSolver::Mult\n");
-	throw;
-      }
-    catch (exception & e)
-      {
-	throw Exception(e.what() +
-			string ("\ncaught in SimpleIterationSolver::Mult\n"));
-      }
-  }
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-  template <class IPTYPE>
-  void GMRESSolver<IPTYPE> :: Mult (const BaseVector & f, BaseVector & x) const
-  {
-    // from Wikipedia
-
-    try
-      {
-	// Solve A u = f
-
-	auto v = f.CreateVector();
-	auto av = f.CreateVector();
-	auto r = f.CreateVector();
-	auto w = f.CreateVector();
-	auto hv = f.CreateVector();
-
-        Array<AutoVector> vi(maxsteps);
-        Matrix<SCAL> h(maxsteps+1, maxsteps);
-        Matrix<SCAL> h2(maxsteps+1, maxsteps);
-        Vector<SCAL> gammai(maxsteps), ci(maxsteps), si(maxsteps);
-
-
-        h = SCAL(0.0);
-        h2 = SCAL(0.0);
-
-	if (initialize)
-	  {
-	    x = 0.0;
-	    r = f;
-	  }
-	else
-	  {
-	    r = f - (*a) * x;
-	  }
-
-	if (c)
-          {
-            hv = (*c) * r;
-            r = hv;
-          }
-
-
-        double norm = r.L2Norm();
-        v = (1.0/sqrt(S_InnerProduct<IPTYPE>(r,r))) * r;
-
-        gammai(0) = norm;
-
-	if (printrates) cout << IM(1) << "0 " << norm << endl;
-	
-	double err;
-	if(stop_absolute)
-	  err = prec;
-	else
-	  err = prec * Abs (norm);
-	
-	int j = -1;
-	while (j++ < maxsteps-2 && norm > err)
-	  {
-            vi[j].AssignPointer (f.CreateVector());
-            vi[j] = v;
-
-            av = (*a) * v;
-            if (c)
-              {
-                hv = (*c) * av;
-                av = hv;
-              }
-
-            for (int i = 0; i <= j; i++)
-              h2(i,j) = h(i,j) = S_InnerProduct<IPTYPE> (*vi[i], av);
-
-            w = av;
-            for (int i = 0; i <= j; i++)
-              w -= h(i,j) * (*vi[i]);
-
-            v = (1.0 / sqrt (S_InnerProduct<IPTYPE> (w, w))) * w;
-            h2(j+1,j) = h(j+1,j) = S_InnerProduct<IPTYPE> (v, av);
-
-            for (int i = 0; i < j; i++)
-              {
-                SCAL hi = h(i,j), hip = h(i+1, j);
-                h(i,j)   = ci(i+1) * hi + si(i+1) * hip;
-                h(i+1,j) = si(i+1) * hi - ci(i+1) * hip;
-              }
-            SCAL beta = sqrt ( sqr(h(j,j)) + sqr(h(j+1,j)));
-            si(j+1) = h(j+1,j) / beta;
-            ci(j+1) = h(j,j) / beta;
-            h(j,j) = beta;
-            gammai(j+1) = si(j+1) * gammai(j);
-            gammai(j) = ci(j+1) * gammai(j);
-            
-	    if (printrates ) cout << IM(1) << j 
-                                  << " ci = " << ci(j+1) 
-                                  << " si = " << si(j+1) 
-                                  << " gammi = " << gammai(j) << endl;
-
-
-            norm = fabs (gammai(j));
-          }
-        
-        j--;
-        cout << IM(5) << "gmres - Triangular matrix" << endl << h.Rows(0,j+2).Cols(0,j+2) << endl;
-        Vector<SCAL> y(maxsteps);
-        for (int i = j; i >= 0; i--)
-          {
-            SCAL sum = gammai(i);
-            for (int k = i+1; k <= j; k++)
-              sum -= h(i,k) * y(k);
-            y(i) = sum / h(i,i);
-          }
-
-        for (int i = 0; i <= j; i++)
-          x += y(i) * *vi[i];
-
-	const_cast<int&> (steps) = j;
-	
-        /*
-        *testout << "h2 = " << endl << h2 << endl;
-
-        for (int k = 0; k < 10; k++)
-          for (int l = 0; l < 10; l++)
-            *testout << "< v(" << k << ") , v(" << l << ") > = " 
-                     << S_InnerProduct<IPTYPE> (*vi[k], *vi[l]) << endl;
-        
-        for (int k = 0; k < 10; k++)
-          {
-            hv = (*a) * (*vi[k]);
-            av = (*c) * hv;
-            for (int l = 0; l < 10; l++)
-              *testout << "< Av(" << k << ") , v(" << l << ") > = " 
-                       << S_InnerProduct<IPTYPE> (av, *vi[l]) << endl;
-          }
-
-
-        Matrix<SCAL> hs(j+1,j+1), hsinv(j+1,j+1);
-        Vector<SCAL> rs(j+1), us(j+1);
-        for (int i = 0; i <= j; i++)
-          for (int k = 0; k <= j; k++)
-            hs(i,k) = h2(i,k);
-
-        CalcInverse (hs, hsinv);
-        rs = SCAL(0.0);
-        rs(0) = 1.0;
-        us = hsinv * rs;
-        
-        x = 0.0;
-        for (int i = 0; i <= j; i++)
-          x += us(i) * *vi[i];
-        */
-      }
-
-    catch (Exception & e)
-      {
-	e.Append ("in caught in GMRESSolver::Mult\n");
-	throw;
-      }
-    catch (exception & e)
-      {
-	throw Exception(e.what() +
-			string ("\ncaught in GMRESSolver::Mult\n"));
-      }
-  }
-
-
-
-
-
-
-
-
-
-//*****************************************************************
-// Iterative template routine -- QMR
-//
-// QMR.h solves the unsymmetric linear system Ax = b using the
-// Quasi-Minimal Residual method following the algorithm as described
-// on p. 24 in the SIAM Templates book.
-//
-//   -------------------------------------------------------------
-//   return value     indicates
-//   ------------     ---------------------
-//        0           convergence within max_iter iterations
-//        1           no convergence after max_iter iterations
-//                    breakdown in:
-//        2             rho
-//        3             beta
-//        4             gamma
-//        5             delta
-//        6             ep
-//        7             xi
-//   -------------------------------------------------------------
-//   
-// Upon successful return, output arguments have the following values:
-//
-//        x  --  approximate solution to Ax=b
-// max_iter  --  the number of iterations performed before the
-//               tolerance was reached
-//      tol  --  the residual after the final iteration
-//
-//*****************************************************************
-
-
-
-template <class SCAL>
-void QMRSolver<SCAL> :: Mult (const BaseVector & b, BaseVector & x) const
-{
-  try
-    {
-      cout << IM(1) << "QMR called" << endl;
-      double resid;
-      SCAL rho, rho_1, xi, gamma, gamma_1, theta, theta_1, eta, delta, ep=1.0, beta;
-      
-
-      auto r = b.CreateVector();
-      auto v_tld = b.CreateVector();
-      auto y = b.CreateVector();
-      auto w_tld = b.CreateVector();
-      auto z = b.CreateVector();
-      auto v = b.CreateVector();
-      auto w = b.CreateVector();
-      auto y_tld = b.CreateVector();
-      auto z_tld = b.CreateVector();
-      auto p = b.CreateVector();
-      auto q = b.CreateVector();
-      auto p_tld = b.CreateVector();
-      auto d = b.CreateVector();
-      auto s = b.CreateVector();
-
-      double normb = b.L2Norm();
-
-
-      if (initialize)
-	x = 0;
-
-
-      r = b - (*a) * x;
-
-      if (normb == 0.0)
-	normb = 1;
-      
-      cout.precision(12);
-      
-      // 
-      double tol = prec;
-      int max_iter = maxsteps;
-      
-      if ((resid = r.L2Norm() / normb) <= tol) {
-	tol = resid;
-	max_iter = 0;
-	((int&)status) = 0;
-	return;
-      }
-  
-      v_tld = r;
-
-      // use preconditioner c1
-      if (c)
-	y = (*c) * v_tld;
-      else
-	y = v_tld;
-
-      rho = y.L2Norm();
-      
-      w_tld = r;
-
-      if (c2) 
-	z = Transpose (*c2) * w_tld; 
-      // z = (*c2) * w_tld; 
-      else
-	z = w_tld;
-      
-      xi = z.L2Norm();
-
-      gamma = 1.0;
-      eta = -1.0;
-      theta = 0.0;
-      ((int&)steps) = 0;
-
-
-      for (int i = 1; i <= max_iter; i++) 
-	{
-
-	  ((int&)steps) = i;  
-	  
-	  if (rho == 0.0)
-	    {
-	      (*testout) << "QMR: breakdown in rho" << endl;
-	      ((int&)status) = 2;
-	      return;                        // return on breakdown
-	    }
-	  
-	  if (xi == 0.0)
-	    {
-	      (*testout) << "QMR: breakdown in xi" << endl;
-	      ((int&)status) = 7;
-	      return;                        // return on breakdown
-	    }
-
-	  v = (1.0/rho) * v_tld;
-	  y /= rho;
-
-	  w = (1.0/xi) * w_tld;
-	  z /= xi;
-
-
-	  delta = S_InnerProduct<SCAL> (z, y);
-	  if (delta == 0.0)
-	    {
-	      (*testout) << "QMR: breakdown in delta" << endl;
-	      ((int&)status) = 5;
-	      return;                        // return on breakdown
-	    }
-
-	  
-	  if (c2) 
-	    y_tld = (*c2) * y;
-	  else
-	    y_tld = y;
-
-	  
-	  if (c)
-	    z_tld = Transpose (*c) * z;
-	  // z_tld = (*c) * z;
-	  else
-	    z_tld = z;
-
-	  if (i > 1) 
-	    {
-	      //  p = y_tld - (xi(0) * delta(0) / ep(0)) * p;
-	      //  q = z_tld - (rho(0) * delta(0) / ep(0)) * q;
-	      p *= (-xi * delta / ep);
-	      p += y_tld;
-	      q *= (-rho * delta / ep);
-	      q += z_tld;
-	    } 
-	  else 
-	    {
-	      p = y_tld;
-	      q = z_tld;
-	    }
-	  
-	  p_tld = (*a) * p;
-	  ep = S_InnerProduct<SCAL> (q, p_tld);
-
-	  if (ep == 0.0)
-	    {
-	      (*testout) << "QMR: breakdown in ep" << endl;
-	      ((int&)status) = 6;
-	      return;                        // return on breakdown
-	    }
-
-	  beta = ep / delta;
-	  if (beta == 0.0)
-	    {
-	      (*testout) << "QMR: breakdown in beta" << endl;
-	      ((int&)status) = 3;
-	      return;                        // return on breakdown
-	    }
-
-	  v_tld = p_tld;
-	  v_tld -= beta * v;
-
-	  if (c)
-	    y = (*c) * v_tld;
-	  else
-	    y = v_tld;
-
-
-	  rho_1 = rho;
-	  rho = y.L2Norm();
-
-	  w_tld = Transpose(*a) * q;
-	  w_tld -= beta * w;
-	  
-	  if (c2) 
-	    z = Transpose (*c2) * w_tld;
-	  // z = (*c2) * w_tld;
-	  else
-	    z = w_tld;
-	  
-	  xi = z.L2Norm();
-	  
-	  gamma_1 = gamma;
-	  theta_1 = theta;
-	  
-	  theta = rho / (gamma_1 * Abs(beta));    // abs (beta) ???
-	  gamma = 1.0 / sqrt(1.0 + theta * theta);
-	  
-	  if (gamma == 0.0)
-	    {
-	      (*testout) << "QMR: breakdown in gamma" << endl;
-	      ((int&)status) = 4;
-	      return;                        // return on breakdown
-	    }
-	  
-	  eta = -eta * rho_1 * gamma * gamma / 
-	    (beta * gamma_1 * gamma_1);
-
-	  if (i > 1) 
-	    {
-	      // d = eta(0) * p + (theta_1(0) * theta_1(0) * gamma(0) * gamma(0)) * d;
-	      // s = eta(0) * p_tld + (theta_1(0) * theta_1(0) * gamma(0) * gamma(0)) * s;
-	      d *= (theta_1 * theta_1 * gamma * gamma);
-	      d += eta * p;
-	      s *= (theta_1 * theta_1 * gamma * gamma);
-	      s += eta * p_tld;
-	    } 
-	  else 
-	    {
-	      d = eta * p;
-	      s = eta * p_tld;
-	    }
-	  
-	  x += d;
-	  r -= s;
-
-	  if ( printrates ) cout << IM(1) << i << " " << r.L2Norm() << endl;
-	  
-	  if ((resid = r.L2Norm() / normb) <= tol) {
-	    tol = resid;
-	    max_iter = i;
-	    ((int&)status) = 0;
-	    return;
-	  }
-	}
-      
-      /*
-      (*testout) << "no convergence" << endl;
-
-      (*testout) << "res = " << endl << r << endl;
-      (*testout) << "x = " << endl << x << endl;
-      (*testout) << "b = " << endl << b << endl;
-      */
-      tol = resid;
-      ((int&)status) = 1;
-      return;                            // no convergence
-    }
-
-  
-
-  catch (Exception & e)
-    {
-      e.Append ("in caught in QMRSolver::Mult\n"); 
-      throw;
-    }
-  catch (exception & e)
-    {
-      throw Exception(e.what() +
-		      string ("\ncaught in QMRSolver::Mult\n"));
-    }
-}
-  
- 
-  
-  template class CGSolver<double>;
-  template class CGSolver<Complex>;
-  template class CGSolver<ComplexConjugate>;
-  template class CGSolver<ComplexConjugate2>;
-  template class BiCGStabSolver<double>;
-  template class BiCGStabSolver<Complex>;
-  template class BiCGStabSolver<ComplexConjugate>;
-  template class BiCGStabSolver<ComplexConjugate2>;
-  template class SimpleIterationSolver<double>;
-  template class SimpleIterationSolver<Complex>;
-  template class SimpleIterationSolver<ComplexConjugate>;
-  template class SimpleIterationSolver<ComplexConjugate2>;
-  template class QMRSolver<double>;
-  template class QMRSolver<Complex>;
-  template class QMRSolver<ComplexConjugate>;
-  template class QMRSolver<ComplexConjugate2>;
-  template class GMRESSolver<double>;
-  template class GMRESSolver<Complex>;
-  template class GMRESSolver<ComplexConjugate>;
-  template class GMRESSolver<ComplexConjugate2>;
-
-
-}
+/**************************************************************************/
+/* File:   cg.cpp                                                         */
+/* Author: Joachim Schoeberl                                              */
+/* Date:   5. Jul. 96                                                     */
+/**************************************************************************/
+
+/* 
+
+  Conjugate Gradient Soler
+  
+*/ 
+
+#include <la.hpp>
+
+namespace ngla
+{
+  inline double Abs (const double & v)
+  {
+    return fabs (v);
+  }
+
+  inline double Abs (const Complex & v)
+  {
+    return std::abs (v);
+  }
+
+
+  KrylovSpaceSolver :: KrylovSpaceSolver ()
+  {
+    //      SetSymmetric();
+    
+    a = 0;  
+    c = 0;
+    SetPrecision (1e-10);
+    SetMaxSteps (200); 
+    SetInitialize (1);
+    printrates = 0;
+    sh = NULL;
+    useseed = false;
+  }
+  
+
+  KrylovSpaceSolver :: KrylovSpaceSolver (const BaseMatrix & aa)
+  {
+    //  SetSymmetric();
+    
+    SetMatrix (aa);
+    c = NULL;
+    SetPrecision (1e-10);
+    SetMaxSteps (200);
+    SetInitialize (1);
+    printrates = 0;
+    sh = NULL;
+    useseed = false;
+  }
+
+
+
+  KrylovSpaceSolver :: KrylovSpaceSolver (const BaseMatrix & aa, const BaseMatrix & ac)
+  {
+    //  SetSymmetric();
+    
+    SetMatrix (aa);
+    SetPrecond (ac);
+    SetPrecision (1e-8);
+    SetMaxSteps (200);
+    SetInitialize (1);
+    printrates = 0;
+    sh = NULL;
+    useseed = false;
+  }
+
+ 
+  AutoVector KrylovSpaceSolver :: CreateVector () const
+  {
+    return a->CreateVector();
+  }
+
+  void KrylovSpaceSolver :: MultAdd (double s, const BaseVector & x, BaseVector & y) const
+  {
+    WorkVectors temp(*this, y, 1);
+    if (!initialize)
+      temp[0] = 0.0;
+    Mult (x, temp[0]);
+    y += s * temp[0];
+  }
+
+
+  KrylovSpaceSolver :: WorkVectors :: 
+  WorkVectors (const KrylovSpaceSolver & asolver, const BaseVector & model, int n)
+    : solver(asolver)
+  {
+    bool reuse = model.GetParallelStatus() == NOT_PARALLEL;
+    lock_guard<mutex> guard(solver.workspace_mutex);
+    auto & workspace = solver.workspace;
+    for (int i = 0; i < n; i++)
+      {
+        int slot = -1;
+        if (reuse)
+          for (int j = 0; j < workspace.Size(); j++)
+            {
+              auto & wv = workspace[j];
+              if (!wv.busy && wv.vec->Size() == model.Size() && 
+                  wv.vec->EntrySize() == model.EntrySize() &&
+                  wv.vec->IsComplex() == model.IsComplex())
+                {
+                  slot = j;
+                  break;
+                }
+            }
+
+        if (slot == -1)
+          {
+            shared_ptr<BaseVector> vec = model.CreateVector();
+            if (reuse)
+              {
+                workspace.Append (WorkVector { vec, false });
+                slot = workspace.Size()-1;
+              }
+            else
+              vecs.Append (vec);
+          }
+
+        if (slot != -1)
+          {
+            workspace[slot].busy = true;
+            vecs.Append (workspace[slot].vec);
+          }
+        slots.Append (slot);
+      }
+  }
+
+  KrylovSpaceSolver :: WorkVectors :: ~WorkVectors ()
+  {
+    lock_guard<mutex> guard(solver.workspace_mutex);
+    for (int slot : slots)
+      if (slot != -1)
+        solver.workspace[slot].busy = false;
+  }
+
+
+  KrylovSpaceSolver :: SolverLog :: SolverLog (const KrylovSpaceSolver & asolver, const string & aname)
+    : solver(asolver), log(EventLog::Active()), name(aname), starttime(WallTime())
+  { ; }
+
+  KrylovSpaceSolver :: SolverLog :: ~SolverLog ()
+  {
+    if (!log) return;
+    auto bytes = [] (const BaseMatrix * mat)
+      {
+        size_t sum = 0;
+        if (mat)
+          for (auto & mu : mat->GetMemoryUsage())
+            sum += mu.NBytes();
+        return sum;
+      };
+    log->Event("solve")("solver", name)("steps", it)("res", res)
+      ("time", WallTime()-starttime)
+      ("matrix_bytes", bytes(solver.a))("precond_bytes", bytes(solver.c));
+  }
+
+
+  template <class SCAL>
+  void BruteInnerProduct(const BaseVector & a, const BaseVector & b, Vector<SCAL> & result, const int start = 0)
+  {
+    const SCAL * pa;
+    const SCAL * pb;
+    int i;
+
+    for(int i=start; i<result.Size(); i++)
+      result[i] = 0;
+
+    
+    if(start == 0)
+      for(i=0, pa = (SCAL*)(a.Memory()), pb = (SCAL*)(b.Memory()); i<a.Size()*result.Size(); i++,pa++,pb++)
+	result[i%result.Size()] += (*pa)*(*pb);
+    else
+      {
+	pa = (SCAL*)(a.Memory());
+	pb = (SCAL*)(b.Memory());
+	for(i=0; i<a.Size();i++)
+	  {
+	    pa += start;
+	    pb += start;
+	
+	    for(int j=start; j<result.Size(); j++)
+	      {
+		result[j] += (*pa)*(*pb);
+		pa++;
+		pb++;
+	      }
+	  }
+      }
+
+  }
+
+
+  template <class SCAL>
+  void BruteInnerProduct2(const BaseVector & a, const BaseVector & b, Vector<SCAL> & result, const int start)
+  {
+    const SCAL * pa;
+    const SCAL * pb;
+    int i;
+
+    for(int i=start; i<result.Size(); i++)
+      result[i] = 0;
+
+    pa = (SCAL*)(a.Memory());
+    pb = (SCAL*)(b.Memory());
+    for(i=0; i<a.Size();i++)
+      {
+	pb += start;
+
+	for(int j=start; j<result.Size(); j++)
+	  {
+	    result[j] += (*pa)*(*pb);
+	    pb++;
+	  }
+	pa++;
+      }
+      
+  }
+
+  // u += al * s and d -= al * w, returns (d,d) if calc_ip is set
+  template <class IPTYPE, class SCAL>
+  inline SCAL CGUpdate (BaseVector & u, BaseVector & d, SCAL al, 
+                        const BaseVector & s, const BaseVector & w, bool calc_ip)
+  {
+    u += al * s;
+    d -= al * w;
+    return calc_ip ? S_InnerProduct<IPTYPE> (d, d) : SCAL(0.0);
+  }
+
+  // real case: both updates and the inner product in one pass
+  template <>
+  inline double CGUpdate<double,double> (BaseVector & u, BaseVector & d, double al, 
+                                         const BaseVector & s, const BaseVector & w, bool calc_ip)
+  {
+    VLinearCombination lu, ld;
+    lu.Append (al, s);
+    ld.Append (-al, w);
+    const BaseVector * pd = &d;
+    double ip = 0;
+    if (FusedUpdate (u, 1.0, lu, d, 1.0, ld, 
+                     FlatArray<const BaseVector*> (calc_ip ? 1 : 0, &pd), FlatArray<double> (1, &ip)))
+      return ip;
+    u += al * s;
+    d -= al * w;
+    return calc_ip ? InnerProduct (d, d) : 0.0;
+  }
+
+  // y = x - al * v, returns L2Norm(y)
+  template <class SCAL>
+  inline double SubAndNorm (BaseVector & y, const BaseVector & x, SCAL al, const BaseVector & v)
+  {
+    y = x - al * v;
+    return L2Norm (y);
+  }
+
+  template <>
+  inline double SubAndNorm<double> (BaseVector & y, const BaseVector & x, double al, const BaseVector & v)
+  {
+    VLinearCombination lc;
+    lc.Append (1.0, x);
+    lc.Append (-al, v);
+    double ip;
+    if (y.FusedUpdate (0.0, lc, &y, &ip))
+      return sqrt (ip);
+    y = x - al * v;
+    return L2Norm (y);
+  }
+
+  // u += alpha * pt + omega * st, r = s - omega * t,
+  // returns err = L2Norm(r) and rho = (rt, r)
+  template <class IPTYPE, class SCAL>
+  inline void BiCGStabUpdate (BaseVector & u, BaseVector & r, 
+                              SCAL alpha, const BaseVector & pt, SCAL omega, const BaseVector & st,
+                              const BaseVector & s, const BaseVector & t, const BaseVector & rt,
+                              double & err, SCAL & rho)
+  {
+    u += alpha * pt + omega * st;
+    r = s - omega * t;
+    err = L2Norm (r);
+    rho = S_InnerProduct<IPTYPE> (rt, r);
+  }
+
+  // real case: in one pass
+  template <>
+  inline void BiCGStabUpdate<double,double> (BaseVector & u, BaseVector & r, 
+                                             double alpha, const BaseVector & pt, double omega, const BaseVector & st,
+                                             const BaseVector & s, const BaseVector & t, const BaseVector & rt,
+                                             double & err, double & rho)
+  {
+    VLinearCombination lu, lr;
+    lu.Append (alpha, pt);
+    lu.Append (omega, st);
+    lr.Append (1.0, s);
+    lr.Append (-omega, t);
+    const BaseVector * ipvecs[2] = { &r, &rt };
+    double ips[2];
+    if (FusedUpdate (u, 1.0, lu, r, 0.0, lr, FlatArray<const BaseVector*> (2, ipvecs), FlatArray<double> (2, ips)))
+      {
+        err = sqrt (ips[0]);
+        rho = ips[1];
+        return;
+      }
+    u += alpha * pt + omega * st;
+    r = s - omega * t;
+    err = L2Norm (r);
+    rho = InnerProduct (rt, r);
+  }
+
+  template <class IPTYPE>
+  void CGSolver<IPTYPE> :: MultiMult (const BaseVector & f, BaseVector & u, const int dim) const
+  {
+    try
+      {
+	// Solve A u = f
+	if(sh)
+	  sh->SetThreadPercentage(0);
+
+	auto d = f.CreateVector();
+	auto w = f.CreateVector();
+	auto s = f.CreateVector();
+
+	int n = 0;
+	Vector<SCAL> al(dim), be(dim), wd(dim), wdn(dim), kss(dim);
+	double err;
+
+	if (initialize)
+	  {
+	    u = 0.0;
+	    d = f;
+	  }
+	else
+	  {
+	    d = f - (*a) * u;
+	  }
+	if (c)
+	  w = (*c) * d;
+	else
+	  w = d;
+
+	s = w;
+	
+	BruteInnerProduct(w,d,wdn);	 
+
+	if (printrates) cout << IM(1) << "0 " << sqrt(L2Norm(wdn)) << endl;
+	if (L2Norm(wdn) == 0.0) wdn = 1;	
+
+	if(stop_absolute)
+	  err = prec * prec;
+	else
+	  err = prec * prec * L2Norm (wdn);
+	
+	double lwstart = log(L2Norm(wdn));
+	double lerr = log(err);
+	
+
+	while (n++ < maxsteps && L2Norm(wdn) > err && !(sh && sh->ShouldTerminate()))
+	  {
+	    w = (*a) * s;
+
+	    wd = wdn;
+
+	    BruteInnerProduct(s,w,kss);
+	   
+	    //(*testout) << "INNERPROD kss " <<kss << endl;
+	    if (L2Norm(kss) == 0.0) break;
+	    
+	    for(int i = 0; i<dim; i++)
+	      al[i] = wd[i] / kss[i];
+	    
+	    SCAL * pl;
+	    const SCAL * pr;
+
+	    int i;
+
+	    for(pl = (SCAL*)(u.Memory()), pr = (SCAL*)(s.Memory()), i=0; i<dim*u.Size(); i++,pl++,pr++)
+	      *pl += al[i%dim]*(*pr);
+	      
+	    for(pl = (SCAL*)(d.Memory()), pr = (SCAL*)(w.Memory()), i=0; i<dim*u.Size(); i++,pl++,pr++)
+	      *pl -= al[i%dim]*(*pr);
+	      
+
+	    //u += al * s;
+	    //d -= al * w;
+
+	    if (c)
+	      w = (*c) * d;
+	    else
+	      w = d;
+
+	    BruteInnerProduct(w,d,wdn);
+
+	    //(*testout) << "wdn " << wdn << endl;
+	    
+	    for(int i = 0; i<dim; i++)
+	      be[i] = wdn[i] / wd[i];
+	    
+	    for(pl = (SCAL*)(s.Memory()), pr = (SCAL*)(w.Memory()), i=0; i<dim*s.Size(); i++,pl++,pr++)
+	      *pl = (*pl)*be[i%dim] + *pr;
+
+	    //s *= be;
+	    //s += w;
+
+	    if (printrates ) cout << IM(1) << n << " " << sqrt(L2Norm (wdn)) << endl;
+	    if(sh)
+	      sh->SetThreadPercentage(100.*max2(double(n)/double(maxsteps),
+						(lwstart-log(L2Norm(wdn)))/(lwstart-lerr)));
+	  } 
+	
+	const_cast<int&> (steps) = n;
+	
+        /*
+	delete &d;
+	delete &w;
+	delete &s;
+        */
+      }
+
+    catch (Exception & e)
+      {
+	e.Append ("in caught in CGSolver::Mult\n");
+	throw;
+      }
+    catch (exception & e)
+      {
+	throw Exception(e.what() +
+			string ("\ncaught in CGSolver::Mult\n"));
+      }
+  }
+
+
+  template <class IPTYPE>
+  void CGSolver<IPTYPE> :: MultiMultSeed (const BaseVector & f, BaseVector & u, const int dim) const
+  {
+    try
+      {
+	// Solve A u = f
+	if(sh)
+	  sh->SetThreadPercentage(0);
+ 
+	SCAL * pl;
+	const SCAL * pr;
+	int i;
+
+	auto d = f.CreateVector();
+
+	BaseMatrix * smalla;
+        /*
+	if(dynamic_cast< const SparseMatrixSymmetricTM<SCAL> *>(a))
+	  smalla = new SparseMatrixSymmetric<SCAL,SCAL>(*dynamic_cast< const SparseMatrixSymmetricTM<SCAL> *>(a));
+	else
+        */
+        if (dynamic_cast< const SparseMatrixTM<SCAL> *>(a))
+	  smalla = new SparseMatrix<SCAL,SCAL>(*dynamic_cast< const SparseMatrixTM<SCAL> *>(a));
+	else
+	  throw Exception("Assumption about bilinearform wrong.");
+
+
+	//BaseVector & aux1 = (smalla) ? d : *f.CreateVector();
+	//BaseVector & aux2 = (smalla) ? d : *f.CreateVector();
+	
+
+	VVector<SCAL> w(f.Size());
+	VVector<SCAL> d_reduced(f.Size());
+	VVector<SCAL> s(f.Size());
+
+	int n = 0;
+
+	SCAL be,wd,wdn,kss;
+	Vector<SCAL> al(dim);
+	Array<double> err(dim);
+
+	if (initialize)
+	  {
+	    u = 0.0;
+	    d = f;
+	  }
+	else
+	  {
+	    d = f - (*a) * u;
+	  }
+
+		
+	double lwstart;
+	double lerr;
+	
+
+
+	for(int seed = dim-1; seed >= 0; seed--)
+	  {
+	    
+	    pr = (SCAL*)(d.Memory());
+	    pr += seed;
+
+	    for(i=0, pl = (SCAL*)(d_reduced.Memory()); i<d.Size(); i++, pl++)
+	      {
+		(*pl) = (*pr);
+		pr += dim;
+	      }
+	    
+	    
+	   
+	    if (c)
+	      w = (*c) * d_reduced;
+	    else
+	      w = d_reduced;
+
+	    if(stop_absolute)
+	      err[seed] = prec * prec;
+	    else
+	      err[seed] = prec * prec * Abs (S_InnerProduct<SCAL>(w,d_reduced));
+	  }
+
+
+	for(int seed = 0; seed < dim; seed++)
+	  {
+	    (*testout) << "seed " << seed << endl;
+
+	    if(seed > 0)
+	      {
+		pr = (SCAL*)(d.Memory());
+		pr += seed;
+
+		for(i=0, pl = (SCAL*)(d_reduced.Memory()); i<d.Size(); i++, pl++)
+		  {
+		    (*pl) = (*pr);
+		    pr += dim;
+		  }
+		
+		
+		
+		if (c)
+		  w = (*c) * d_reduced;
+		else
+		  w = d_reduced;
+	      }
+	    
+	    s = w;	    
+	    
+	    wdn = S_InnerProduct<SCAL>(w,d_reduced);
+	    
+	    
+	    if (printrates ) cout << IM(1) << n << " (block " << seed+1 << ") " << sqrt (Abs (wdn)) << endl;
+	    if(Abs(wdn) == 0.0) wdn = 1;
+
+	    lwstart = log(Abs(wdn));
+	    lerr = log(err[seed]);
+	    
+
+
+	    while (n++ < maxsteps && Abs(wdn) > err[seed] && !(sh && sh->ShouldTerminate()))
+	      {
+		//if(smalla)
+		w = (*smalla)  * s;
+		/*
+		else
+		  {
+		    pl = (SCAL*)(aux1.Memory());
+		    pr = (SCAL*)(s.Memory());
+		    for(i=0; i<s.Size(); i++)
+		      {
+			for(int j=0; j<dim; j++)
+			  {
+			    *pl = *pr;
+			    pl++;
+			  }
+			pr++;
+		      }
+		    aux2 = (*a) * aux1;
+		    pl = (SCAL*)(w.Memory());
+		    pr = (SCAL*)(aux2.Memory());
+		    for(i=0; i<s.Size(); i++)
+		      {
+			*pl = *pr;
+			pl++;
+			pr += dim;
+		      }
+		  }
+		*/
+
+		//w = (*a) * s;
+		
+		wd = wdn;
+		
+		kss = S_InnerProduct<IPTYPE> (s, w);
+		if (kss == 0.0) break;
+		
+
+		BruteInnerProduct2(s,d,al,seed+1);
+		al[seed] = wd;
+		
+		for(i=seed; i<dim; i++)
+		  al[i] /= kss;
+
+		
+		
+		//(*testout) << "al " << al << endl;
+		
+		pl = (SCAL*)(u.Memory());
+		pr = (SCAL*)(s.Memory());
+		for(i=0; i<u.Size(); i++)
+		  {
+		    pl += seed;
+
+		    for(int j=seed; j<dim; j++)
+		      {
+			*pl += al[j]*(*pr);
+			pl++;
+		      }
+		    pr++;
+		  }
+		
+		pl = (SCAL*)(d.Memory());
+		pr = (SCAL*)(w.Memory());
+		for(i=0; i<d.Size(); i++)
+		  {
+		    pl += seed;
+
+		    for(int j=seed; j<dim; j++)
+		      {
+			*pl -= al[j]*(*pr);
+			pl++;
+		      }
+		    pr++;
+		  }
+				
+		//u += al * s;
+		//d -= al * w;
+
+
+		
+		pr = (SCAL*)(d.Memory());
+		pr += seed;
+
+		for(i=0, pl = (SCAL*)(d_reduced.Memory()); i<d.Size(); i++, pl++)
+		  {
+		    *pl = *pr;
+		    pr += dim;
+		  }
+
+		
+		if (c)
+		  w = (*c) * d_reduced;
+		else
+		  w = d_reduced;
+
+		wdn = S_InnerProduct<IPTYPE> (d_reduced, w);
+
+		be = wdn/wd;
+		
+		s *= be;
+		s += w;
+
+		if (printrates ) cout << IM(1) << n << " (block " << seed+1 << ") " << sqrt (Abs (wdn)) << endl;
+		if(sh)
+		  sh->SetThreadPercentage(100.*max2(double(n)/double(maxsteps),
+						    (lwstart-log(Abs(wdn)))/(lwstart-lerr)));
+	      } 
+	  }
+	const_cast<int&> (steps) = n;
+	
+	/*
+	if(!smalla)
+	  {
+	    delete &aux1;
+	    delete &aux2;
+	  }
+	*/
+	delete smalla;
+      }
+
+    catch (Exception & e)
+      {
+	e.Append ("in caught in CGSolver::Mult\n");
+	throw;
+      }
+    catch (exception & e)
+      {
+	throw Exception(e.what() +
+			string ("\ncaught in CGSolver::Mult\n"));
+      }
+  }
+
+
+  template <class IPTYPE>
+  void CGSolver<IPTYPE> :: Mult (const BaseVector & f, BaseVector & u) const
+  {
+    static Timer timer ("CG solver");
+    RegionTimer reg (timer);
+
+    int dim = 1;
+
+    if(dynamic_cast<VVector< Vec<2, SCAL> >* >(&u))
+      dim = 2;
+    else if(dynamic_cast<VVector< Vec<3, SCAL> >* >(&u))
+      dim = 3;
+    else if(dynamic_cast<VVector< Vec<4, SCAL> >* >(&u))
+      dim = 4;
+    else if(dynamic_cast<VVector< Vec<5, SCAL> >* >(&u))
+      dim = 5;
+    else if(dynamic_cast<VVector< Vec<6, SCAL> >* >(&u))
+      dim = 6;
+    else if(dynamic_cast<VVector< Vec<7, SCAL> >* >(&u))
+      dim = 7;
+    else if(dynamic_cast<VVector< Vec<8, SCAL> >* >(&u))
+      dim = 8;
+    /*
+    else if(dynamic_cast<VVector< Vec<9, SCAL> >* >(&u))
+      dim = 9;
+    else if(dynamic_cast<VVector< Vec<10, SCAL> >* >(&u))
+      dim = 10;
+    else if(dynamic_cast<VVector< Vec<11, SCAL> >* >(&u))
+      dim = 11;
+    else if(dynamic_cast<VVector< Vec<12, SCAL> >* >(&u))
+      dim = 12;
+    else if(dynamic_cast<VVector< Vec<13, SCAL> >* >(&u))
+      dim = 13;
+    else if(dynamic_cast<VVector< Vec<14, SCAL> >* >(&u))
+      dim = 14;
+    else if(dynamic_cast<VVector< Vec<15, SCAL> >* >(&u))
+      dim = 15;
+    */
+    //cout << "useseed: " << useseed << " dim: " << dim << endl;
+
+    if(useseed && dim != 1)
+      {
+	MultiMultSeed(f,u,dim);
+	//MultiMult(f,u,dim);
+	return;
+      }
+ 
+    SolverLog slog(*this, "CG");
+    
+    try
+      {
+	// Solve A u = f
+	if(sh)
+	  sh->SetThreadPercentage(0);
+ 
+        WorkVectors work(*this, f, 3);
+        BaseVector & d = work[0];
+        BaseVector & w = work[1];
+        BaseVector & s = work[2];
+
+	int n = 0;
+	SCAL al, be, wd, wdn, kss;
+	double err;
+	if (initialize)
+	  {
+	    u = 0.0;
+	    d = f;
+	  }
+	else
+	  {
+	    d = f - (*a) * u;
+	  }
+
+	if (c)
+	  w = (*c) * d;
+	else
+	  w = d;
+
+	s = w;
+	wdn = S_InnerProduct<IPTYPE> (w,d);
+
+	if (printrates) cout << IM(1) << "0 " << sqrt(Abs(wdn)) << endl;
+	slog.Iteration (0, sqrt(Abs(wdn)));
+	if (wdn == 0.0) wdn = 1;	
+
+	if(stop_absolute)
+	  err = prec * prec;
+	else
+	  err = prec * prec * Abs (wdn);
+	
+	double lwstart = log(Abs(wdn));
+	double lerr = log(err);
+	
+	while (n++ < maxsteps && Abs(wdn) > err && !(sh && sh->ShouldTerminate()))
+	  {
+	    w = (*a) * s;
+	    wd = wdn;
+	    kss = S_InnerProduct<IPTYPE> (s, w);
+	    if (kss == 0.0) break;
+	    
+	    al = wd / kss;
+
+	    if (c)
+	      {
+		CGUpdate<IPTYPE> (u, d, al, s, w, false);
+		w = (*c) * d;
+		wdn = S_InnerProduct<IPTYPE> (d, w);
+	      }
+	    else
+	      wdn = CGUpdate<IPTYPE> (u, d, al, s, w, true);
+
+	    be = wdn / wd;
+	    
+	    s = be * s + (c ? w : d);
+
+	    if (printrates ) cout << IM(1) << n << " " << sqrt (Abs (wdn)) << endl;
+	    slog.Iteration (n, sqrt (Abs (wdn)));
+	    if ( sh )
+	      sh->SetThreadPercentage(100.*max2(double(n)/double(maxsteps),
+						(lwstart-log(Abs(wdn)))/(lwstart-lerr)));
+	  } 
+	
+	const_cast<int&> (steps) = n;
+      }
+
+    catch (Exception & e)
+      {
+	e.Append ("in caught in CGSolver::Mult\n");
+	throw;
+      }
+    catch (exception & e)
+      {
+	throw Exception(e.what() +
+			string ("\ncaught in CGSolver::Mult\n"));
+      }
+  }
+
+
+
+
+
+  template <class SCAL> FlatVector<SCAL> FVScalar (const BaseVector & v);
+  template <> FlatVector<double> FVScalar<double> (const BaseVector & v) { return v.FVDouble(); }
+  template <> FlatVector<Complex> FVScalar<Complex> (const BaseVector & v) { return v.FVComplex(); }
+
+  template <class IPTYPE, class SCAL>
+  SCAL LocalIP (FlatVector<SCAL> x, FlatVector<SCAL> y) { return ngbla::InnerProduct (x, y); }
+  template <>
+  Complex LocalIP<ComplexConjugate> (FlatVector<Complex> x, FlatVector<Complex> y)
+  { return ngbla::InnerProduct (x, Conj(y)); }
+  template <>
+  Complex LocalIP<ComplexConjugate2> (FlatVector<Complex> x, FlatVector<Complex> y)
+  { return ngbla::InnerProduct (y, Conj(x)); }
+
+  template <class IPTYPE>
+  void PipelinedCGSolver<IPTYPE> :: Mult (const BaseVector & f, BaseVector & x) const
+  {
+    static Timer timer ("pipelined CG solver");
+    RegionTimer reg (timer);
+    SolverLog slog(*this, "PipelinedCG");
+
+    try
+      {
+	// Solve A x = f
+	if(sh)
+	  sh->SetThreadPercentage(0);
+
+        // r residual, u = C r, w = A u, m = C w, an = A m, and the directions
+        auto r = f.CreateVector();
+        auto u = f.CreateVector();
+        auto w = f.CreateVector();
+        auto m = f.CreateVector();
+        auto an = f.CreateVector();
+        auto z = f.CreateVector();
+        auto q = f.CreateVector();
+        auto s = f.CreateVector();
+        auto p = f.CreateVector();
+
+	if (initialize)
+	  {
+	    x = 0.0;
+	    r = f;
+	  }
+	else
+	  r = f - (*a) * x;
+
+        if (c)
+          u = (*c) * r;
+        else
+          u = r;
+        w = (*a) * u;
+
+        FusedInnerProducts<IPTYPE> ips;
+        Array<const BaseVector*> ipx { &r, &w }, ipy { &u, &u };
+
+        SCAL gamma, delta, alpha = 1, gamma_old = 1, alpha_old = 1, beta;
+        double err = 0, lwstart = 0, lerr = 0;
+        int n = 0;
+        while (true)
+          {
+            ips.Start (ipx, ipy);
+            if (c)
+              m = (*c) * w;
+            else
+              m = w;
+            an = (*a) * m;
+            auto vals = ips.Wait();
+            gamma = vals[0];
+            delta = vals[1];
+
+            if (printrates) cout << IM(1) << n << " " << sqrt(Abs(gamma)) << endl;
+            slog.Iteration (n, sqrt(Abs(gamma)));
+            if (n == 0)
+              {
+                if (gamma == 0.0) break;
+                err = stop_absolute ? prec * prec : prec * prec * Abs (gamma);
+                lwstart = log(Abs(gamma));
+                lerr = log(err);
+              }
+            else if ( sh )
+              sh->SetThreadPercentage(100.*max2(double(n)/double(maxsteps),
+						(lwstart-log(Abs(gamma)))/(lwstart-lerr)));
+
+            if (n >= maxsteps || Abs(gamma) <= err || (sh && sh->ShouldTerminate()))
+              break;
+
+            if (n == 0)
+              {
+                if (delta == 0.0) break;
+                alpha = gamma / delta;
+                z = an;
+                q = m;
+                s = w;
+                p = u;
+              }
+            else
+              {
+                beta = gamma / gamma_old;
+                SCAL denom = delta - beta * gamma / alpha_old;
+                if (denom == 0.0) break;
+                alpha = gamma / denom;
+                z = beta * z + an;
+                q = beta * q + m;
+                s = beta * s + w;
+                p = beta * p + u;
+              }
+
+            x += alpha * p;
+            r -= alpha * s;
+            u -= alpha * q;
+            w -= alpha * z;
+
+            gamma_old = gamma;
+            alpha_old = alpha;
+            n++;
+          }
+
+	const_cast<int&> (steps) = n;
+      }
+
+    catch (Exception & e)
+      {
+	e.Append ("in caught in PipelinedCGSolver::Mult\n");
+	throw;
+      }
+    catch (exception & e)
+      {
+	throw Exception(e.what() +
+			string ("\ncaught in PipelinedCGSolver::Mult\n"));
+      }
+  }
+
+
+
+
+  template <class IPTYPE>
+  void BiCGStabSolver<IPTYPE> :: Mult (const BaseVector & f, BaseVector & u) const
+  {
+    SolverLog slog(*this, "BiCGStab");
+    
+    try
+      {
+	// Solve A u = f
+	if(sh)
+	  sh->SetThreadPercentage(0);
+ 
+        WorkVectors work(*this, f, c ? 8 : 6);
+	BaseVector & r = work[0];
+	BaseVector & r_tilde = work[1];
+	BaseVector & p = work[2];
+	BaseVector & s = work[3];
+	BaseVector & t = work[4];
+	BaseVector & v = work[5];
+        // without preconditioner they are p and s
+	BaseVector & p_tilde = c ? work[6] : p;
+	BaseVector & s_tilde = c ? work[7] : s;
+
+	int n = 0;
+	SCAL rho_old, rho_new, rho_next, beta, alpha, omega;
+	double err, err_i;
+
+	if (initialize)
+	  {
+	    u = 0.0;
+	    r = f;
+	  }
+	else
+	  {
+	    r = f - (*a) * u;
+	  }
+	r_tilde = r;
+
+	rho_new = S_InnerProduct<IPTYPE>(r_tilde, r);
+	p = r;
+	if (c)
+	  p_tilde = (*c) * p;
+
+	v = (*a) * p_tilde;
+	alpha = rho_new / S_InnerProduct<IPTYPE> (r_tilde, v);
+	err_i = SubAndNorm (s, r, alpha, v);
+
+	if (c)
+	  s_tilde = (*c) * s;
+
+	t = (*a) * s_tilde;
+
+	omega = S_InnerProduct<IPTYPE> (t, s) / S_InnerProduct<IPTYPE> (t, t);
+        BiCGStabUpdate<IPTYPE> (u, r, alpha, p_tilde, omega, s_tilde, s, t, r_tilde, err_i, rho_next);
+
+	if (printrates) cout << IM(1) << "0 " << err_i << endl;
+	slog.Iteration (0, err_i);
+
+
+	if(stop_absolute)
+	  err = prec * prec;
+	else
+	  err = prec * prec * err_i;
+	
+	double lwstart = log(err_i);
+	double lerr = log(err);
+	
+
+	while (n++ < maxsteps && err_i > err && !(sh && sh->ShouldTerminate()))
+	  {
+	    rho_old = rho_new;
+	    rho_new = rho_next;
+	    beta = (rho_new / rho_old ) * ( alpha / omega );
+	    p = r + beta * ( p - omega * v );
+
+	    if (c)
+	      p_tilde = (*c) * p;
+	    
+	    v = (*a) * p_tilde;
+	    alpha = rho_new / S_InnerProduct<IPTYPE> (r_tilde, v);
+	    err_i = SubAndNorm (s, r, alpha, v);
+
+	    if ( err_i < err )
+	      {
+                u += alpha * p_tilde;
+		break;
+	      }
+
+	    if (c)
+	      s_tilde = (*c) * s;
+
+	    t = (*a) * s_tilde;
+	    
+	    omega = S_InnerProduct<IPTYPE> (t, s) / S_InnerProduct<IPTYPE> (t, t);
+            BiCGStabUpdate<IPTYPE> (u, r, alpha, p_tilde, omega, s_tilde, s, t, r_tilde, err_i, rho_next);
+
+	    if (printrates ) cout << IM(1) << n << " " << err_i << endl;
+	    slog.Iteration (n, err_i);
+	    if(sh)
+	      sh->SetThreadPercentage(100.*max2(double(n)/double(maxsteps),
+						(lwstart-log(err_i))/(lwstart-lerr)));
+	  } 
+	
+	const_cast<int&> (steps) = n;
+      }
+
+    catch (Exception & e)
+      {
+	e.Append ("in caught in BiCGStabSolver::Mult\n");
+	throw;
+      }
+    catch (exception & e)
+      {
+	throw Exception(e.what() +
+			string ("\ncaught in BiCGStabSolver::Mult\n"));
+      }
+  }
+
+
+
+
+  template <class IPTYPE>
+  void SimpleIterationSolver<IPTYPE> :: Mult (const BaseVector & f, BaseVector & u) const
+  {
+  SolverLog slog(*this, "SimpleIteration");
+
+  try
+      {
+	// Solve A u = f
+	if(sh)
+	  sh->SetThreadPercentage(0);
+ 
+	auto d = f.CreateVector();
+	auto w = f.CreateVector();
+
+	int n = 0;
+	double err, err0;
+
+	if (initialize)
+	  {
+	    u = 0.0;
+	    d = f;
+	  }
+	else
+	  {
+	    d = f - (*a) * u;
+	  }
+
+
+        err = err0 = 1;
+
+	while (n++ < maxsteps && err > prec * err0)
+          {
+            d = f - (*a) * u;
+
+            if (c)
+              w = (*c) * d;
+            else
+              w = d;
+
+            u += tau * w;
+
+            err = Abs (S_InnerProduct<IPTYPE> (w, d));
+            if (n == 1) err0 = err;
+
+	    if (printrates ) cout << IM(1) << n << " " << sqrt (err) << endl;
+	    slog.Iteration (n, sqrt (err));
+          }
+
+	const_cast<int&> (steps) = n;
+      }
+
+    catch (Exception & e)
+      {
+	e.Append ("in caught in SimpleIterationSolver::Mult\n");
+	throw;
+      }
+    catch (exception & e)
+      {
+	throw Exception(e.what() +
+			string ("\ncaught in SimpleIterationSolver::Mult\n"));
+      }
+  }
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+  // local parts of h_i = (v_i, w) for the rows v_i of basis, 
+  // with the semantics of S_InnerProduct
+  template <class IPTYPE, class SCAL>
+  void BasisIPs (SliceMatrix<SCAL> basis, FlatVector<SCAL> w, FlatVector<SCAL> h)
+  { h = basis * w; }
+  template <>
+  void BasisIPs<ComplexConjugate> (SliceMatrix<Complex> basis, FlatVector<Complex> w, FlatVector<Complex> h)
+  {
+    Vector<Complex> cw = Conj(w);
+    h = basis * cw;
+  }
+  template <>
+  void BasisIPs<ComplexConjugate2> (SliceMatrix<Complex> basis, FlatVector<Complex> w, FlatVector<Complex> h)
+  {
+    Vector<Complex> cw = Conj(w);
+    h = basis * cw;
+    h = Conj(h);
+  }
+
+  // (w,v) from (v,w)
+  template <class IPTYPE, class SCAL> SCAL SwapIP (SCAL ip) { return ip; }
+  template <> Complex SwapIP<ComplexConjugate> (Complex ip) { return conj(ip); }
+  template <> Complex SwapIP<ComplexConjugate2> (Complex ip) { return conj(ip); }
+
+  /*
+    Classical Gram-Schmidt against a contiguous basis, one row per basis
+    vector. It computes the local inner products of the basis with w and 
+    of w with itself as dense matrix-vector products, and sums them over
+    all ranks with one reduction.
+   */
+  template <class IPTYPE>
+  class BasisGramSchmidt
+  {
+    typedef typename SCAL_TRAIT<IPTYPE>::SCAL SCAL;
+  public:
+    // ips(i) = (v_i, wd) for i < basis.Height(), and ips(last) = (wc, wd)
+    static void InnerProducts (SliceMatrix<SCAL> basis, const BaseVector & wc,
+                               const BaseVector & wd, FlatVector<SCAL> ips)
+    {
+      static Timer t("GMRES - basis inner products"); RegionTimer reg(t);
+      auto fc = FVScalar<SCAL> (wc);
+      auto fd = FVScalar<SCAL> (wd);
+      size_t m = basis.Height();
+      Matrix<SCAL> parts(16, m+1);
+      ParallelJob ([&] (TaskInfo ti)
+                   {
+                     auto r = ::Range(fd).Split (ti.task_nr, ti.ntasks);
+                     BasisIPs<IPTYPE> (basis.Cols(r), fd.Range(r), parts.Row(ti.task_nr).Range(0,m));
+                     parts(ti.task_nr, m) = LocalIP<IPTYPE> (fc.Range(r), fd.Range(r));
+                   }, 16);
+      ips = SCAL(0.0);
+      for (size_t i = 0; i < 16; i++)
+        ips += parts.Row(i);
+#ifdef PARALLEL
+      if (wd.GetParallelStatus() != NOT_PARALLEL)
+        {
+          MPI_Request request = 
+            MyMPI_IAllReduce (FlatArray<double> (ips.Size()*sizeof(SCAL)/sizeof(double),
+                                                 reinterpret_cast<double*> (&ips(0))));
+          MPI_Wait (&request, MPI_STATUS_IGNORE);
+        }
+#endif
+    }
+
+    // w -= sum_i h_i v_i
+    static void Project (SliceMatrix<SCAL> basis, FlatVector<SCAL> h, const BaseVector & w)
+    {
+      static Timer t("GMRES - basis update"); RegionTimer reg(t);
+      auto fw = FVScalar<SCAL> (w);
+      ParallelJob ([&] (TaskInfo ti)
+                   {
+                     auto r = ::Range(fw).Split (ti.task_nr, ti.ntasks);
+                     fw.Range(r) -= Trans(basis.Cols(r)) * h;
+                   }, 16);
+    }
+  };
+
+
+  template <class IPTYPE>
+  void GMRESSolver<IPTYPE> :: Mult (const BaseVector & f, BaseVector & x) const
+  {
+    // from Wikipedia
+    SolverLog slog(*this, "GMRES");
+
+    try
+      {
+	// Solve A u = f
+
+	auto v = f.CreateVector();
+	auto av = f.CreateVector();
+	auto r = f.CreateVector();
+	auto w = f.CreateVector();
+	auto hv = f.CreateVector();
+
+        // the Krylov basis, cumulated, one row per vector
+        Matrix<SCAL> basis(maxsteps, FVScalar<SCAL>(f).Size());
+        Matrix<SCAL> h(maxsteps+1, maxsteps);
+        Vector<SCAL> gammai(maxsteps), ci(maxsteps), si(maxsteps);
+        Vector<SCAL> ips(maxsteps+1);
+
+        h = SCAL(0.0);
+
+	if (initialize)
+	  {
+	    x = 0.0;
+	    r = f;
+	  }
+	else
+	  {
+	    r = f - (*a) * x;
+	  }
+
+	if (c)
+          {
+            hv = (*c) * r;
+            r = hv;
+          }
+
+
+        double norm = r.L2Norm();
+        v = (1.0/sqrt(S_InnerProduct<IPTYPE>(r,r))) * r;
+        v.Cumulate();
+
+        gammai(0) = norm;
+
+	if (printrates) cout << IM(1) << "0 " << norm << endl;
+	slog.Iteration (0, norm);
+	
+	double err;
+	if(stop_absolute)
+	  err = prec;
+	else
+	  err = prec * Abs (norm);
+	
+	int j = -1;
+	while (j++ < maxsteps-2 && norm > err)
+	  {
+            basis.Row(j) = FVScalar<SCAL> (v);
+
+            av = (*a) * v;
+            if (c)
+              {
+                hv = (*c) * av;
+                av = hv;
+              }
+
+            // classical Gram-Schmidt, the norm of the projected vector 
+            // follows from Pythagoras: one global reduction per step
+            auto bj = basis.Rows(0, j+1);
+            av.Distribute();
+            w = av;
+            w.Cumulate();
+            BasisGramSchmidt<IPTYPE>::InnerProducts (bj, w, av, ips.Range(0, j+2));
+            SCAL ww = ips(j+1);
+            SCAL proj = 0.0;
+            for (int i = 0; i <= j; i++)
+              {
+                h(i,j) = ips(i);
+                proj += ips(i) * SwapIP<IPTYPE> (ips(i));
+              }
+            BasisGramSchmidt<IPTYPE>::Project (bj, ips.Range(0, j+1), w);
+            double nw2 = Abs (ww - proj);
+
+            // cancellation, reorthogonalize and compute the norm explicitly
+            if (nw2 < 0.5 * Abs (ww))
+              {
+                av = w;
+                av.Distribute();
+                BasisGramSchmidt<IPTYPE>::InnerProducts (bj, w, av, ips.Range(0, j+2));
+                for (int i = 0; i <= j; i++)
+                  h(i,j) += ips(i);
+                BasisGramSchmidt<IPTYPE>::Project (bj, ips.Range(0, j+1), w);
+                proj = 0.0;
+                for (int i = 0; i <= j; i++)
+                  proj += ips(i) * SwapIP<IPTYPE> (ips(i));
+                nw2 = Abs (ips(j+1) - proj);
+              }
+
+            h(j+1,j) = sqrt (nw2);
+            if (nw2 > 0)
+              v = (1.0 / sqrt (nw2)) * w;
+            else
+              v = 0.0;
+            v.Cumulate();
+
+            for (int i = 0; i < j; i++)
+              {
+                SCAL hi = h(i,j), hip = h(i+1, j);
+                h(i,j)   = ci(i+1) * hi + si(i+1) * hip;
+                h(i+1,j) = si(i+1) * hi - ci(i+1) * hip;
+              }
+            SCAL beta = sqrt ( sqr(h(j,j)) + sqr(h(j+1,j)));
+            si(j+1) = h(j+1,j) / beta;
+            ci(j+1) = h(j,j) / beta;
+            h(j,j) = beta;
+            gammai(j+1) = si(j+1) * gammai(j);
+            gammai(j) = ci(j+1) * gammai(j);
+            
+	    if (printrates ) cout << IM(1) << j 
+                                  << " ci = " << ci(j+1) 
+                                  << " si = " << si(j+1) 
+                                  << " gammi = " << gammai(j) << endl;
+
+
+            norm = fabs (gammai(j));
+            slog.Iteration (j+1, norm);
+          }
+        
+        j--;
+        cout << IM(5) << "gmres - Triangular matrix" << endl << h.Rows(0,j+2).Cols(0,j+2) << endl;
+        Vector<SCAL> y(maxsteps);
+        for (int i = j; i >= 0; i--)
+          {
+            SCAL sum = gammai(i);
+            for (int k = i+1; k <= j; k++)
+              sum -= h(i,k) * y(k);
+            y(i) = sum / h(i,i);
+          }
+
+        // x += sum_i y_i v_i
+        x.Cumulate();
+        y.Range(0, j+1) *= -1.0;
+        BasisGramSchmidt<IPTYPE>::Project (basis.Rows(0, j+1), y.Range(0, j+1), x);
+
+	const_cast<int&> (steps) = j;
+      }
+
+    catch (Exception & e)
+      {
+	e.Append ("in caught in GMRESSolver::Mult\n");
+	throw;
+      }
+    catch (exception & e)
+      {
+	throw Exception(e.what() +
+			string ("\ncaught in GMRESSolver::Mult\n"));
+      }
+  }
+
+
+
+
+
+
+
+
+
+//*****************************************************************
+// Iterative template routine -- QMR
+//
+// QMR.h solves the unsymmetric linear system Ax = b using the
+// Quasi-Minimal Residual method following the algorithm as described
+// on p. 24 in the SIAM Templates book.
+//
+//   -------------------------------------------------------------
+//   return value     indicates
+//   ------------     ---------------------
+//        0           convergence within max_iter iterations
+//        1           no convergence after max_iter iterations
+//                    breakdown in:
+//        2             rho
+//        3             beta
+//        4             gamma
+//        5             delta
+//        6             ep
+//        7             xi
+//   -------------------------------------------------------------
+//   
+// Upon successful return, output arguments have the following values:
+//
+//        x  --  approximate solution to Ax=b
+// max_iter  --  the number of iterations performed before the
+//               tolerance was reached
+//      tol  --  the residual after the final iteration
+//
+//*****************************************************************
+
+
+
+template <class SCAL>
+void QMRSolver<SCAL> :: Mult (const BaseVector & b, BaseVector & x) const
+{
+  try
+    {
+      cout << IM(1) << "QMR called" << endl;
+      double resid;
+      SCAL rho, rho_1, xi, gamma, gamma_1, theta, theta_1, eta, delta, ep=1.0, beta;
+      
+
+      auto r = b.CreateVector();
+      auto v_tld = b.CreateVector();
+      auto y = b.CreateVector();
+      auto w_tld = b.CreateVector();
+      auto z = b.CreateVector();
+      auto v = b.CreateVector();
+      auto w = b.CreateVector();
+      auto y_tld = b.CreateVector();
+      auto z_tld = b.CreateVector();
+      auto p = b.CreateVector();
+      auto q = b.CreateVector();
+      auto p_tld = b.CreateVector();
+      auto d = b.CreateVector();
+      auto s = b.CreateVector();
+
+      double normb = b.L2Norm();
+
+
+      if (initialize)
+	x = 0;
+
+
+      r = b - (*a) * x;
+
+      if (normb == 0.0)
+	normb = 1;
+      
+      cout.precision(12);
+      
+      // 
+      double tol = prec;
+      int max_iter = maxsteps;
+      
+      if ((resid = r.L2Norm() / normb) <= tol) {
+	tol = resid;
+	max_iter = 0;
+	((int&)status) = 0;
+	return;
+      }
+  
+      v_tld = r;
+
+      // use preconditioner c1
+      if (c)
+	y = (*c) * v_tld;
+      else
+	y = v_tld;
+
+      rho = y.L2Norm();
+      
+      w_tld = r;
+
+      if (c2) 
+	z = Transpose (*c2) * w_tld; 
+      // z = (*c2) * w_tld; 
+      else
+	z = w_tld;
+      
+      xi = z.L2Norm();
+
+      gamma = 1.0;
+      eta = -1.0;
+      theta = 0.0;
+      ((int&)steps) = 0;
+
+
+      for (int i = 1; i <= max_iter; i++) 
+	{
+
+	  ((int&)steps) = i;  
+	  
+	  if (rho == 0.0)
+	    {
+	      (*testout) << "QMR: breakdown in rho" << endl;
+	      ((int&)status) = 2;
+	      return;                        // return on breakdown
+	    }
+	  
+	  if (xi == 0.0)
+	    {
+	      (*testout) << "QMR: breakdown in xi" << endl;
+	      ((int&)status) = 7;
+	      return;                        // return on breakdown
+	    }
+
+	  v = (1.0/rho) * v_tld;
+	  y /= rho;
+
+	  w = (1.0/xi) * w_tld;
+	  z /= xi;
+
+
+	  delta = S_InnerProduct<SCAL> (z, y);
+	  if (delta == 0.0)
+	    {
+	      (*testout) << "QMR: breakdown in delta" << endl;
+	      ((int&)status) = 5;
+	      return;                        // return on breakdown
+	    }
+
+	  
+	  if (c2) 
+	    y_tld = (*c2) * y;
+	  else
+	    y_tld = y;
+
+	  
+	  if (c)
+	    z_tld = Transpose (*c) * z;
+	  // z_tld = (*c) * z;
+	  else
+	    z_tld = z;
+
+	  if (i > 1) 
+	    {
+	      //  p = y_tld - (xi(0) * delta(0) / ep(0)) * p;
+	      //  q = z_tld - (rho(0) * delta(0) / ep(0)) * q;
+	      p *= (-xi * delta / ep);
+	      p += y_tld;
+	      q *= (-rho * delta / ep);
+	      q += z_tld;
+	    } 
+	  else 
+	    {
+	      p = y_tld;
+	      q = z_tld;
+	    }
+	  
+	  p_tld = (*a) * p;
+	  ep = S_InnerProduct<SCAL> (q, p_tld);
+
+	  if (ep == 0.0)
+	    {
+	      (*testout) << "QMR: breakdown in ep" << endl;
+	      ((int&)status) = 6;
+	      return;                        // return on breakdown
+	    }
+
+	  beta = ep / delta;
+	  if (beta == 0.0)
+	    {
+	      (*testout) << "QMR: breakdown in beta" << endl;
+	      ((int&)status) = 3;
+	      return;                        // return on breakdown
+	    }
+
+	  v_tld = p_tld;
+	  v_tld -= beta * v;
+
+	  if (c)
+	    y = (*c) * v_tld;
+	  else
+	    y = v_tld;
+
+
+	  rho_1 = rho;
+	  rho = y.L2Norm();
+
+	  w_tld = Transpose(*a) * q;
+	  w_tld -= beta * w;
+	  
+	  if (c2) 
+	    z = Transpose (*c2) * w_tld;
+	  // z = (*c2) * w_tld;
+	  else
+	    z = w_tld;
+	  
+	  xi = z.L2Norm();
+	  
+	  gamma_1 = gamma;
+	  theta_1 = theta;
+	  
+	  theta = rho / (gamma_1 * Abs(beta));    // abs (beta) ???
+	  gamma = 1.0 / sqrt(1.0 + theta * theta);
+	  
+	  if (gamma == 0.0)
+	    {
+	      (*testout) << "QMR: breakdown in gamma" << endl;
+	      ((int&)status) = 4;
+	      return;                        // return on breakdown
+	    }
+	  
+	  eta = -eta * rho_1 * gamma * gamma / 
+	    (beta * gamma_1 * gamma_1);
+
+	  if (i > 1) 
+	    {
+	      // d = eta(0) * p + (theta_1(0) * theta_1(0) * gamma(0) * gamma(0)) * d;
+	      // s = eta(0) * p_tld + (theta_1(0) * theta_1(0) * gamma(0) * gamma(0)) * s;
+	      d *= (theta_1 * theta_1 * gamma * gamma);
+	      d += eta * p;
+	      s *= (theta_1 * theta_1 * gamma * gamma);
+	      s += eta * p_tld;
+	    } 
+	  else 
+	    {
+	      d = eta * p;
+	      s = eta * p_tld;
+	    }
+	  
+	  x += d;
+	  r -= s;
+
+	  if ( printrates ) cout << IM(1) << i << " " << r.L2Norm() << endl;
+	  
+	  if ((resid = r.L2Norm() / normb) <= tol) {
+	    tol = resid;
+	    max_iter = i;
+	    ((int&)status) = 0;
+	    return;
+	  }
+	}
+      
+      /*
+      (*testout) << "no convergence" << endl;
+
+      (*testout) << "res = " << endl << r << endl;
+      (*testout) << "x = " << endl << x << endl;
+      (*testout) << "b = " << endl << b << endl;
+      */
+      tol = resid;
+      ((int&)status) = 1;
+      return;                            // no convergence
+    }
+
+  
+
+  catch (Exception & e)
+    {
+      e.Append ("in caught in QMRSolver::Mult\n"); 
+      throw;
+    }
+  catch (exception & e)
+    {
+      throw Exception(e.what() +
+		      string ("\ncaught in QMRSolver::Mult\n"));
+    }
+}
+  
+ 
+
+
+
+  void BlockKrylovSpaceSolver :: MultAdd (double s, const MultiVector & x, MultiVector & y) const
+  {
+    if (a->IsComplex())
+      throw Exception ("BlockKrylovSpaceSolver: only real matrices are supported");
+    MultiVector u(x.Size(), x.NumVectors());
+    Solve (x, u);
+    FlatMatrix<double> fy = y.FM();
+    fy += s * u.FM();
+  }
+
+  void BlockKrylovSpaceSolver :: Mult (const BaseVector & v, BaseVector & prod) const
+  {
+    MultiVector f(v.Size(), 1), u(prod.Size(), 1);
+    f.SetVector (0, v);
+    if (!initialize)
+      u.SetVector (0, prod);
+    Solve (f, u);
+    u.GetVector (0, prod);
+  }
+
+
+  // computes trafo such that Trans(trafo) * g * trafo has only ones and zeros
+  // on the diagonal, columns which are (almost) linear dependent on the 
+  // previous ones are dropped.
+  void GramSchmidtTrafo (FlatMatrix<double> g, FlatMatrix<double> trafo, double tol)
+  {
+    size_t k = g.Height();
+    Vector<double> t(k), gt(k), ip(k);
+    trafo = 0.0;
+    for (size_t j = 0; j < k; j++)
+      {
+        if (g(j,j) <= 0) continue;
+        t = 0.0;
+        t(j) = 1;
+        for (int pass = 0; pass < 2; pass++)
+          {
+            gt = g * t;
+            for (size_t i = 0; i < j; i++)
+              ip(i) = InnerProduct (trafo.Col(i), gt);
+            for (size_t i = 0; i < j; i++)
+              t -= ip(i) * trafo.Col(i);
+          }
+        gt = g * t;
+        double norm2 = InnerProduct (t, gt);
+        if (norm2 > tol * g(j,j))
+          trafo.Col(j) = (1.0/sqrt(norm2)) * t;
+      }
+  }
+
+  // orthonormalizes the columns of w in place, w_old = w_new * s.
+  // (almost) linear dependent columns are set to zero.
+  static void BlockQR (FlatMatrix<double> w, SliceMatrix<double> s)
+  {
+    size_t k = w.Width();
+    s = 0.0;
+    for (size_t j = 0; j < k; j++)
+      {
+        double norm0 = L2Norm (w.Col(j));
+        for (int pass = 0; pass < 2; pass++)
+          for (size_t i = 0; i < j; i++)
+            {
+              double ip = InnerProduct (w.Col(i), w.Col(j));
+              s(i,j) += ip;
+              w.Col(j) -= ip * w.Col(i);
+            }
+        double norm = L2Norm (w.Col(j));
+        if (norm > 1e-12 * norm0)
+          {
+            s(j,j) = norm;
+            w.Col(j) *= 1.0/norm;
+          }
+        else
+          w.Col(j) = 0.0;
+      }
+  }
+
+
+  void BlockCGSolver :: Solve (const MultiVector & f, MultiVector & u) const
+  {
+    static Timer t("BlockCGSolver::Solve"); RegionTimer reg(t);
+    try
+      {
+        size_t n = f.Size(), k = f.NumVectors();
+        MultiVector r(n, k), z(n, k), w(n, k), aw(n, k), p(n, k), q(n, k);
+        FlatMatrix<double> fu = u.FM(), fr = r.FM(), fz = z.FM(), fw = w.FM();
+        FlatMatrix<double> faw = aw.FM(), fp = p.FM(), fq = q.FM();
+
+        fr = f.FM();
+        if (initialize)
+          u.SetZero();
+        else
+          a->MultAdd (-1, u, r);
+
+        auto precond = [&] ()
+          {
+            if (c)
+              {
+                z.SetZero();
+                c->MultAdd (1, r, z);
+              }
+            else
+              fz = fr;
+          };
+
+        Vector<double> err0(k), err(k);
+        auto calc_err = [&] (FlatVector<double> e)
+          {
+            for (size_t j = 0; j < k; j++)
+              e(j) = sqrt (fabs (InnerProduct (fr.Col(j), fz.Col(j))));
+          };
+        auto converged = [&] ()
+          {
+            for (size_t j = 0; j < k; j++)
+              if (err(j) > (stop_absolute ? prec : prec * err0(j)))
+                return false;
+            return true;
+          };
+
+        precond();
+        calc_err (err0);
+        err = err0;
+	if (printrates) cout << IM(1) << "0 " << L2Norm(err) << endl;
+
+        Matrix<double> beta(k, k), g(k, k), trafo(k, k), alpha(k, k);
+        int it = 0;
+        while (it < maxsteps && !converged())
+          {
+            // new search directions are a-orthogonal to the previous ones
+            fw = fz;
+            if (it > 0)
+              {
+                beta = Trans(fq) * fz;
+                fw -= fp * beta;
+              }
+            aw.SetZero();
+            a->MultAdd (1, w, aw);
+
+            g = Trans(fw) * faw;
+            GramSchmidtTrafo (g, trafo, 1e-16);
+            fp = fw * trafo;
+            fq = faw * trafo;
+
+            alpha = Trans(fp) * fr;
+            fu += fp * alpha;
+            fr -= fq * alpha;
+
+            precond();
+            calc_err (err);
+            it++;
+	    if (printrates) cout << IM(1) << it << " " << L2Norm(err) << endl;
+          }
+	const_cast<int&> (steps) = it;
+      }
+    catch (Exception & e)
+      {
+        e.Append ("in caught in BlockCGSolver::Solve\n"); 
+        throw;
+      }
+  }
+
+
+  void BlockGMRESSolver :: Solve (const MultiVector & f, MultiVector & u) const
+  {
+    static Timer t("BlockGMRESSolver::Solve"); RegionTimer reg(t);
+    try
+      {
+        size_t n = f.Size(), k = f.NumVectors();
+        size_t m = maxsteps;
+        MultiVector r(n, k), w(n, k), hw(n, k);
+        FlatMatrix<double> fu = u.FM(), fr = r.FM(), fw = w.FM();
+
+        auto precond = [&] (MultiVector & x)
+          {
+            if (!c) return;
+            hw.SetZero();
+            c->MultAdd (1, x, hw);
+            x.FM() = hw.FM();
+          };
+
+        fr = f.FM();
+        if (initialize)
+          u.SetZero();
+        else
+          a->MultAdd (-1, u, r);
+        precond (r);
+
+        // block Hessenberg matrix stored by block columns, block column j 
+        // has (j+2)*k rows. rotated right hand side and Givens rotations
+        Array<shared_ptr<Matrix<double>>> hcol;
+        auto h = [&] (size_t row, size_t col) -> double &
+          { return (*hcol[col/k])(row, col%k); };
+        Matrix<double> g((m+1)*k, k);
+        Matrix<double> cs(m*k, k), sn(m*k, k);
+        g = 0.0;
+
+        // QR of the block v[j], linearly dependent columns are replaced by
+        // pseudo-random vectors orthogonal to the whole basis, such that the 
+        // block size stays constant and the residual is found in the last block row
+        Array<shared_ptr<MultiVector>> v;
+        auto orthonormalize = [&] (size_t j, SliceMatrix<double> s)
+          {
+            FlatMatrix<double> fvj = v[j]->FM();
+            BlockQR (fvj, s);
+            for (size_t l = 0; l < k; l++)
+              {
+                if (s(l,l) != 0) continue;
+                auto col = fvj.Col(l);
+                for (size_t i = 0; i < n; i++)
+                  col(i) = sin (0.7*(i+1)*(l+1) + j);
+                for (int pass = 0; pass < 2; pass++)
+                  {
+                    for (size_t i = 0; i < j; i++)
+                      {
+                        FlatMatrix<double> fvi = v[i]->FM();
+                        for (size_t m = 0; m < k; m++)
+                          col -= InnerProduct (fvi.Col(m), col) * fvi.Col(m);
+                      }
+                    for (size_t m = 0; m < k; m++)
+                      if (m != l)
+                        col -= InnerProduct (fvj.Col(m), col) * fvj.Col(m);
+                  }
+                col *= 1.0 / L2Norm (col);
+              }
+          };
+
+        v.Append (make_shared<MultiVector> (n, k));
+        FlatMatrix<double> fv0 = v[0]->FM();
+        fv0 = fr;
+        orthonormalize (0, g.Rows(0, k));
+
+        Vector<double> err0(k), err(k);
+        for (size_t l = 0; l < k; l++)
+          err0(l) = L2Norm (g.Col(l));
+        err = err0;
+        auto converged = [&] ()
+          {
+            for (size_t l = 0; l < k; l++)
+              if (err(l) > (stop_absolute ? prec : prec * err0(l)))
+                return false;
+            return true;
+          };
+        auto rotate = [] (double c, double s, double & x, double & y)
+          {
+            double hx = x;
+            x = c * hx + s * y;
+            y = -s * hx + c * y;
+          };
+
+	if (printrates) cout << IM(1) << "0 " << L2Norm(err) << endl;
+
+        size_t j = 0;
+        while (j < m && !converged())
+          {
+            w.SetZero();
+            a->MultAdd (1, *v[j], w);
+            precond (w);
+
+            // block Arnoldi, classical Gram-Schmidt with reorthogonalization
+            hcol.Append (make_shared<Matrix<double>> ((j+2)*k, k));
+            FlatMatrix<double> hj = *hcol[j];
+            hj = 0.0;
+            Matrix<double> hij(k, k);
+            for (int pass = 0; pass < 2; pass++)
+              for (size_t i = 0; i <= j; i++)
+                {
+                  FlatMatrix<double> fvi = v[i]->FM();
+                  hij = Trans(fvi) * fw;
+                  hj.Rows(i*k, (i+1)*k) += hij;
+                  fw -= fvi * hij;
+                }
+            v.Append (make_shared<MultiVector> (n, k));
+            FlatMatrix<double> fvj = v[j+1]->FM();
+            fvj = fw;
+            orthonormalize (j+1, hj.Rows((j+1)*k, (j+2)*k));
+
+            // column col has non-zeros up to row col+k
+            for (size_t col = j*k; col < (j+1)*k; col++)
+              {
+                for (size_t pc = 0; pc < col; pc++)
+                  for (size_t t = 0; t < k; t++)
+                    {
+                      size_t row = pc+k-t;
+                      rotate (cs(pc,t), sn(pc,t), h(row-1,col), h(row,col));
+                    }
+
+                for (size_t t = 0; t < k; t++)
+                  {
+                    size_t row = col+k-t;
+                    double hi = h(row-1,col), hip = h(row,col);
+                    double rho = sqrt (sqr(hi) + sqr(hip));
+                    cs(col,t) = (rho != 0) ? hi / rho : 1;
+                    sn(col,t) = (rho != 0) ? hip / rho : 0;
+                    h(row-1,col) = rho;
+                    h(row,col) = 0;
+                    for (size_t l = 0; l < k; l++)
+                      rotate (cs(col,t), sn(col,t), g(row-1,l), g(row,l));
+                  }
+              }
+
+            j++;
+            for (size_t l = 0; l < k; l++)
+              err(l) = L2Norm (g.Rows(j*k, (j+1)*k).Col(l));
+	    if (printrates) cout << IM(1) << j << " " << L2Norm(err) << endl;
+          }
+
+        // solve the triangular system and update the solution
+        size_t dim = j*k;
+        Matrix<double> y(dim, k);
+        for (int i = int(dim)-1; i >= 0; i--)
+          for (size_t l = 0; l < k; l++)
+            {
+              double sum = g(i,l);
+              for (size_t col = i+1; col < dim; col++)
+                sum -= h(i,col) * y(col,l);
+              y(i,l) = (h(i,i) != 0) ? sum / h(i,i) : 0;
+            }
+        for (size_t i = 0; i < j; i++)
+          fu += v[i]->FM() * y.Rows(i*k, (i+1)*k);
+
+	const_cast<int&> (steps) = j;
+      }
+    catch (Exception & e)
+      {
+        e.Append ("in caught in BlockGMRESSolver::Solve\n"); 
+        throw;
+      }
+  }
+
+  
+  template class CGSolver<double>;
+  template class CGSolver<Complex>;
+  template class CGSolver<ComplexConjugate>;
+  template class CGSolver<ComplexConjugate2>;
+  template class PipelinedCGSolver<double>;
+  template class PipelinedCGSolver<Complex>;
+  template class PipelinedCGSolver<ComplexConjugate>;
+  template class PipelinedCGSolver<ComplexConjugate2>;
+  template class BiCGStabSolver<double>;
+  template class BiCGStabSolver<Complex>;
+  template class BiCGStabSolver<ComplexConjugate>;
+  template class BiCGStabSolver<ComplexConjugate2>;
+  template class SimpleIterationSolver<double>;
+  template class SimpleIterationSolver<Complex>;
+  template class SimpleIterationSolver<ComplexConjugate>;
+  template class SimpleIterationSolver<ComplexConjugate2>;
+  template class QMRSolver<double>;
+  template class QMRSolver<Complex>;
+  template class QMRSolver<ComplexConjugate>;
+  template class QMRSolver<ComplexConjugate2>;
+  template class GMRESSolver<double>;
+  template class GMRESSolver<Complex>;
+  template class GMRESSolver<ComplexConjugate>;
+  template class GMRESSolver<ComplexConjugate2>;
+
+
+}
@@ -20,6 +20,8 @@ namespace ngla
   protected:
     ///
     const BaseMatrix *a, *c;
+    /// keeps a preconditioner alive which is owned by the solver only
+    shared_ptr<BaseMatrix> own_c;
     ///
     double prec;
     ///
@@ -40,7 +42,57 @@ namespace ngla
     ///
     const BaseStatusHandler * sh;
 
+    struct WorkVector
+    {
+      shared_ptr<BaseVector> vec;
+      bool busy;
+    };
+    /// persistent work vectors, reused by consecutive solves
+    mutable Array<WorkVector> workspace;
+    mutable mutex workspace_mutex;
+
   public:
+    /**
+       n work vectors like model, taken from the solver's workspace if 
+       they fit and are not in use by another solve. They are given 
+       back at destruction. Vectors with parallel status are always 
+       created new.
+    */
+    class NGS_DLL_HEADER WorkVectors
+    {
+      const KrylovSpaceSolver & solver;
+      Array<int> slots;
+      Array<shared_ptr<BaseVector>> vecs;
+    public:
+      WorkVectors (const KrylovSpaceSolver & asolver, const BaseVector & model, int n);
+      ~WorkVectors ();
+      BaseVector & operator[] (int i) const { return *vecs[i]; }
+    };
+
+    /**
+       Writes the iterations of one solve to the active EventLog, and at
+       destruction a summary with steps, last residual, time and the
+       memory of matrix and preconditioner. Does nothing without log.
+    */
+    class NGS_DLL_HEADER SolverLog
+    {
+      const KrylovSpaceSolver & solver;
+      EventLog * log;
+      string name;
+      double starttime;
+      int it = 0;
+      double res = 0;
+    public:
+      SolverLog (const KrylovSpaceSolver & asolver, const string & aname);
+      ~SolverLog ();
+      void Iteration (int ait, double ares)
+      {
+        if (!log) return;
+        it = ait; res = ares;
+        log->Iteration (name, it, res);
+      }
+    };
+
     ///
     NGS_DLL_HEADER KrylovSpaceSolver();
     ///
@@ -54,6 +106,9 @@ namespace ngla
     void SetPrecond (const BaseMatrix & ac)
     { c = &ac; }
     ///
+    void SetPrecond (shared_ptr<BaseMatrix> ac)
+    { own_c = ac; c = ac.get(); }
+    ///
 
     virtual bool IsComplex() const { return a->IsComplex(); }
     /// 
@@ -89,6 +144,9 @@ namespace ngla
     { return steps; }
     ///
     NGS_DLL_HEADER virtual void Mult (const BaseVector & v, BaseVector & prod) const = 0;
+    /// the temporary result vector is taken from the workspace
+    NGS_DLL_HEADER virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const;
+    using BaseMatrix::MultAdd;
     ///
     NGS_DLL_HEADER virtual AutoVector CreateVector() const;
 
@@ -125,6 +183,32 @@ namespace ngla
   };
 
 
+  /**
+     The pipelined conjugate gradient method (Ghysels, Vanroose).
+     Both inner products of an iteration go into one global reduction,
+     which runs while the preconditioner and the matrix are applied.
+  */
+  template <class IPTYPE>
+  class NGS_DLL_HEADER PipelinedCGSolver : public KrylovSpaceSolver
+  {
+  public:
+    typedef typename SCAL_TRAIT<IPTYPE>::SCAL SCAL;
+    ///
+    PipelinedCGSolver () 
+      : KrylovSpaceSolver () { ; }
+    ///
+    PipelinedCGSolver (const BaseMatrix & aa)
+      : KrylovSpaceSolver (aa) { ; }
+
+    ///
+    PipelinedCGSolver (const BaseMatrix & aa, const BaseMatrix & ac)
+      : KrylovSpaceSolver (aa, ac) { ; }
+
+    ///
+    virtual void Mult (const BaseVector & v, BaseVector & prod) const;
+  };
+
+
   /// The BiCGStab solver
   template <class IPTYPE>
   class NGS_DLL_HEADER BiCGStabSolver : public KrylovSpaceSolver
@@ -223,6 +307,85 @@ namespace ngla
     ///
     virtual void Mult (const BaseVector & v, BaseVector & prod) const;
   };
+
+
+
+  /// trafo such that Trans(trafo) * g * trafo has only ones and zeros on
+  /// the diagonal, (almost) linear dependent columns are dropped.
+  NGS_DLL_HEADER void GramSchmidtTrafo (FlatMatrix<double> g, FlatMatrix<double> trafo, double tol);
+
+
+  /**
+     Krylov space solver for a block of real right hand sides. Matrix
+     and preconditioner are applied to all vectors of the block at once,
+     and all right hand sides share one Krylov space.
+  */
+  class NGS_DLL_HEADER BlockKrylovSpaceSolver : public KrylovSpaceSolver
+  {
+  public:
+    ///
+    BlockKrylovSpaceSolver () 
+      : KrylovSpaceSolver () { ; }
+    ///
+    BlockKrylovSpaceSolver (const BaseMatrix & aa)
+      : KrylovSpaceSolver (aa) { ; }
+    ///
+    BlockKrylovSpaceSolver (const BaseMatrix & aa, const BaseMatrix & ac)
+      : KrylovSpaceSolver (aa, ac) { ; }
+
+    /// solves a u = f, u is the initial guess if initialize is not set
+    virtual void Solve (const MultiVector & f, MultiVector & u) const = 0;
+
+    using KrylovSpaceSolver::MultAdd;
+    /// y += s * a^{-1} x, starting from zero
+    virtual void MultAdd (double s, const MultiVector & x, MultiVector & y) const override;
+    /// solves for a single right hand side
+    virtual void Mult (const BaseVector & v, BaseVector & prod) const override;
+  };
+
+
+  /**
+     Block preconditioned conjugate gradient method (O'Leary).
+     The search directions are a-orthonormalized in every step, 
+     linearly dependent directions (e.g. of converged right hand sides) 
+     are dropped.
+  */
+  class NGS_DLL_HEADER BlockCGSolver : public BlockKrylovSpaceSolver
+  {
+  public:
+    ///
+    BlockCGSolver () 
+      : BlockKrylovSpaceSolver () { ; }
+    ///
+    BlockCGSolver (const BaseMatrix & aa)
+      : BlockKrylovSpaceSolver (aa) { ; }
+    ///
+    BlockCGSolver (const BaseMatrix & aa, const BaseMatrix & ac)
+      : BlockKrylovSpaceSolver (aa, ac) { ; }
+
+    virtual void Solve (const MultiVector & f, MultiVector & u) const override;
+  };
+
+
+  /**
+     Block GMRES method, left preconditioned, without restart.
+     The block Hessenberg matrix is reduced by Givens rotations.
+  */
+  class NGS_DLL_HEADER BlockGMRESSolver : public BlockKrylovSpaceSolver
+  {
+  public:
+    ///
+    BlockGMRESSolver () 
+      : BlockKrylovSpaceSolver () { ; }
+    ///
+    BlockGMRESSolver (const BaseMatrix & aa)
+      : BlockKrylovSpaceSolver (aa) { ; }
+    ///
+    BlockGMRESSolver (const BaseMatrix & aa, const BaseMatrix & ac)
+      : BlockKrylovSpaceSolver (aa, ac) { ; }
+
+    virtual void Solve (const MultiVector & f, MultiVector & u) const override;
+  };
   
 
 
@@ -85,4 +85,138 @@ namespace ngla
   }
 
 
+
+  /// x -> D^{-1} x, preconditioner for the Lanczos estimate
+  class ChebyshevDiagonal : public BaseMatrix
+  {
+    FlatArray<double> diaginv;
+  public:
+    ChebyshevDiagonal (FlatArray<double> adiaginv) : diaginv(adiaginv) { ; }
+    virtual bool IsComplex() const override { return false; } 
+    virtual int VHeight() const override { return diaginv.Size(); }
+    virtual int VWidth() const override { return diaginv.Size(); }
+    virtual AutoVector CreateVector () const override
+    { return make_shared<VVector<double>> (diaginv.Size()); }
+    virtual void Mult (const BaseVector & x, BaseVector & y) const override
+    {
+      auto fx = x.FV<double>();
+      auto fy = y.FV<double>();
+      ParallelFor (diaginv.Size(), [&] (size_t i) { fy(i) = diaginv[i] * fx(i); });
+    }
+    virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const override
+    {
+      auto fx = x.FV<double>();
+      auto fy = y.FV<double>();
+      ParallelFor (diaginv.Size(), [&] (size_t i) { fy(i) += s * diaginv[i] * fx(i); });
+    }
+  };
+
+
+  ChebyshevPrecond :: 
+  ChebyshevPrecond (const SparseMatrixTM<double> & amat, 
+                    shared_ptr<BitArray> freedofs,
+                    int adegree, int eigsteps, double ratio)
+    : mat(amat), degree(adegree), opflops(amat.NZE())
+  {
+    static Timer t("ChebyshevPrecond setup"); RegionTimer reg(t);
+
+    diaginv.SetSize (amat.Height());
+    ParallelFor (diaginv.Size(), [&] (size_t i)
+                 {
+                   if (freedofs && !freedofs->Test(i))
+                     diaginv[i] = 0;
+                   else
+                     diaginv[i] = 1.0 / amat(i,i);
+                 });
+    EstimateBounds (eigsteps, ratio);
+  }
+
+  ChebyshevPrecond :: 
+  ChebyshevPrecond (const BaseMatrix & aop, FlatArray<double> diag,
+                    shared_ptr<BitArray> freedofs,
+                    int adegree, int eigsteps, double ratio)
+    : mat(aop), degree(adegree), opflops(0)
+  {
+    static Timer t("ChebyshevPrecond setup"); RegionTimer reg(t);
+
+    if (diag.Size() != size_t(aop.VHeight()))
+      throw Exception ("ChebyshevPrecond: diagonal does not match operator");
+    diaginv.SetSize (diag.Size());
+    ParallelFor (diaginv.Size(), [&] (size_t i)
+                 {
+                   if ((freedofs && !freedofs->Test(i)) || diag[i] == 0)
+                     diaginv[i] = 0;
+                   else
+                     diaginv[i] = 1.0 / diag[i];
+                 });
+    EstimateBounds (eigsteps, ratio);
+  }
+
+  void ChebyshevPrecond :: EstimateBounds (int eigsteps, double ratio)
+  {
+    // Lanczos for diag(A)^{-1} A, non-free dofs are projected out by diaginv = 0
+    ChebyshevDiagonal jac(diaginv);
+    EigenSystem eigen(mat, jac);
+    eigen.SetMaxSteps (eigsteps);
+    eigen.Calc();
+    double lam = eigen.MaxEigenValue();
+    // Lanczos approximates lmax from below
+    SetBounds (1.1*lam/ratio, 1.1*lam);
+    cout << IM(3) << "Chebyshev smoother, degree " << degree 
+         << ", estimated lmax = " << lam << endl;
+  }
+
+
+  void ChebyshevPrecond :: 
+  Apply (BaseVector & x, const BaseVector & b, bool xzero) const
+  {
+    static Timer t("ChebyshevPrecond::Apply"); RegionTimer reg(t);
+    t.AddFlops (degree * (opflops+4*diaginv.Size()));
+
+    auto r = mat.CreateColVector();
+    auto d = mat.CreateColVector();
+
+    double theta = 0.5 * (lmax+lmin);
+    double delta = 0.5 * (lmax-lmin);
+    double sigma = theta / delta;
+    double rho = 1 / sigma;
+
+    if (xzero)
+      {
+        x = 0.0;
+        r = b;
+      }
+    else
+      r = b - mat * x;
+
+    auto fx = x.FV<double>();
+    auto fr = r.FV<double>();
+    auto fd = d.FV<double>();
+
+    // d = c1 d + c2 D^{-1} r,  x += d  in one pass
+    auto update = [&] (double c1, double c2)
+      {
+        ParallelForRange (fx.Size(), [&] (IntRange myrange)
+                          {
+                            for (auto i : myrange)
+                              {
+                                double di = c2 * diaginv[i] * fr(i);
+                                if (c1 != 0) di += c1 * fd(i);
+                                fd(i) = di;
+                                fx(i) += di;
+                              }
+                          });
+      };
+
+    update (0, 1/theta);
+    for (int k = 1; k < degree; k++)
+      {
+        mat.MultAdd (-1, d, r);
+        double rhonew = 1 / (2*sigma - rho);
+        update (rhonew * rho, 2 * rhonew / delta);
+        rho = rhonew;
+      }
+  }
+
+
 }
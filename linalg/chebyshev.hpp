@@ -35,6 +35,57 @@ namespace ngla
     virtual AutoVector CreateVector () const;
   };
 
+
+  /**
+     Chebyshev polynomial smoother for a real sparse matrix, or for a
+     matrix-free operator with given diagonal.
+     The largest eigenvalue of diag(A)^{-1} A is estimated by a few
+     Lanczos steps at setup. A sweep damps the interval 
+     [lmax/ratio, 1.1 lmax] with a polynomial of given degree, every 
+     step is one (parallel) matrix-vector product and one fused 
+     vector update.
+  */
+  class NGS_DLL_HEADER ChebyshevPrecond : public BaseMatrix
+  {
+    const BaseMatrix & mat;
+    /// inverse diagonal, 0 for non-free dofs
+    Array<double> diaginv;
+    int degree;
+    double lmin, lmax;
+    /// flops of one operator application, 0 if unknown
+    size_t opflops;
+
+    void EstimateBounds (int eigsteps, double ratio);
+    void Apply (BaseVector & x, const BaseVector & b, bool xzero) const;
+  public:
+    ChebyshevPrecond (const SparseMatrixTM<double> & amat, 
+                      shared_ptr<BitArray> freedofs,
+                      int adegree = 3, int eigsteps = 10, double ratio = 30);
+
+    /// smoother for the operator aop, which is never assembled
+    ChebyshevPrecond (const BaseMatrix & aop, FlatArray<double> diag,
+                      shared_ptr<BitArray> freedofs,
+                      int adegree = 3, int eigsteps = 10, double ratio = 30);
+
+    /// the polynomial of degree steps damps [almin, almax]
+    void SetBounds (double almin, double almax) { lmin = almin; lmax = almax; }
+    void GetBounds (double & almin, double & almax) const { almin = lmin; almax = lmax; }
+    double GetMaxEigenValue () const { return lmax / 1.1; }
+    int GetDegree () const { return degree; }
+    FlatArray<double> GetInverseDiagonal () const { return diaginv; }
+
+    /// one smoothing sweep for A x = b
+    void Smooth (BaseVector & x, const BaseVector & b) const { Apply (x, b, false); }
+
+    virtual bool IsComplex() const override { return false; } 
+    virtual int VHeight() const override { return mat.VHeight(); }
+    virtual int VWidth() const override { return mat.VWidth(); }
+    virtual void Mult (const BaseVector & b, BaseVector & x) const override { Apply (x, b, true); }
+    virtual AutoVector CreateVector () const override { return mat.CreateVector(); }
+    virtual AutoVector CreateRowVector () const override { return mat.CreateRowVector(); }
+    virtual AutoVector CreateColVector () const override { return mat.CreateColVector(); }
+  };
+
 }
 
 #endif
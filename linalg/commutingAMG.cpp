@@ -10,18 +10,239 @@
 namespace ngla
 {
   
+  /*
+    Vertex to edge table, unused edges (first vertex -1) are skipped.
+    The edges of a vertex are in ascending order.
+  */
+  static Table<int> Vertex2Edge (FlatArray<INT<2> > e2v, size_t nv)
+  {
+    return ParallelCreateTable<int>
+      (e2v.Size(), [e2v] (auto & creator, size_t i)
+       {
+         if (e2v[i][0] != -1)
+           for (int j = 0; j < 2; j++)
+             creator.Add (e2v[i][j], i);
+       }, nv);
+  }
+
+
+  /*
+    Parallel matching of vertices by rounds of locally dominant edges:
+    an admissible edge between two unmatched vertices is collapsed if
+    it has the largest weight (a fixed order on ties) of all
+    admissible edges at both of its vertices. With distance2 it must
+    also dominate the edges at the neighbour vertices. Then no two edges
+    collapsed in one round are neighbours, and admissible(edge, v2edge)
+    may look at the collapses of the previous rounds.
+    Returns the collapsed edge of every vertex, or -1.
+  */
+  template <typename FUNC>
+  static Array<int> CollapseEdges (FlatArray<INT<2> > e2v, const Table<int> & v2e,
+                                   FlatArray<double> weight, bool distance2,
+                                   FUNC admissible)
+  {
+    static Timer t("AMG - collapse edges");
+    RegionTimer reg(t);
+
+    size_t ne = e2v.Size();
+    size_t nv = v2e.Size();
+    Array<int> v2edge(nv), vbest(nv), vbest2(nv);
+    Array<bool> candidate(ne);
+    v2edge = -1;
+
+    // ties are broken by a scrambled edge number, ascending numbers
+    // along lines of equal weights would collapse one edge per round
+    auto scramble = [] (unsigned e) { return e * 2654435761u; };
+    auto better = [weight, scramble] (int e1, int e2)
+      {
+        return e2 == -1 || weight[e1] > weight[e2] ||
+          (weight[e1] == weight[e2] && scramble(e1) < scramble(e2));
+      };
+
+    int rounds = 0;
+    size_t collapsed;
+    do
+      {
+        rounds++;
+        ParallelFor (ne, [&] (size_t i)
+                     {
+                       candidate[i] = e2v[i][0] != -1 &&
+                         v2edge[e2v[i][0]] == -1 && v2edge[e2v[i][1]] == -1 &&
+                         admissible (i, v2edge);
+                     });
+
+        ParallelFor (nv, [&] (size_t v)
+                     {
+                       int best = -1;
+                       for (int e : v2e[v])
+                         if (candidate[e] && better (e, best))
+                           best = e;
+                       vbest[v] = best;
+                     });
+
+        FlatArray<int> best = vbest;
+        if (distance2)
+          {
+            ParallelFor (nv, [&] (size_t v)
+                         {
+                           int hbest = vbest[v];
+                           for (int e : v2e[v])
+                             {
+                               int e2 = vbest[e2v[e][0]+e2v[e][1]-v];
+                               if (e2 != -1 && better (e2, hbest))
+                                 hbest = e2;
+                             }
+                           vbest2[v] = hbest;
+                         });
+            best.Assign (vbest2);
+          }
+
+        // every vertex is written by its dominant edge only
+        collapsed = ParallelReduce
+          (ne, [&] (size_t i) -> size_t
+           {
+             if (!candidate[i]) return 0;
+             int v1 = e2v[i][0], v2 = e2v[i][1];
+             if (best[v1] != int(i) || best[v2] != int(i)) return 0;
+             v2edge[v1] = i;
+             v2edge[v2] = i;
+             return 1;
+           },
+           [] (size_t a, size_t b) { return a+b; }, size_t(0));
+      }
+    while (collapsed);
+
+    cout << IM(5) << "collapse edges: " << rounds << " rounds" << endl;
+    return v2edge;
+  }
+
+
+  /*
+    Coarse edges from the fine vertex to coarse vertex map. The coarse
+    edges of a coarse vertex are its larger coarse neighbours in
+    ascending order. Fine edges within one coarse vertex get ecoarse = -1,
+    ecoarsesign is -1 if the fine edge is oriented against its coarse
+    edge. Coarse weights are summed in the order of the fine edges.
+  */
+  static void CoarsenEdges (FlatArray<INT<2> > e2v, FlatArray<double> weighte,
+                            FlatArray<int> vcoarse, size_t ncv,
+                            Array<INT<2> > & ce2v, Array<double> & cweighte,
+                            Array<int> & ecoarse, Array<short> & ecoarsesign)
+  {
+    static Timer t("AMG - coarsen edges");
+    RegionTimer reg(t);
+
+    size_t ne = e2v.Size();
+    auto cv2e = ParallelCreateTable<int>
+      (ne, [e2v, vcoarse] (auto & creator, size_t i)
+       {
+         if (e2v[i][0] == -1) return;
+         int c0 = vcoarse[e2v[i][0]];
+         int c1 = vcoarse[e2v[i][1]];
+         if (c0 != c1)
+           creator.Add (min2 (c0, c1), i);
+       }, ncv);
+
+    auto other = [e2v, vcoarse] (int cv, int e)
+      {
+        int c0 = vcoarse[e2v[e][0]];
+        return (c0 == cv) ? vcoarse[e2v[e][1]] : c0;
+      };
+    auto neighbours = [&] (int cv, Array<int> & nbs)
+      {
+        nbs.SetSize0();
+        for (int e : cv2e[cv])
+          nbs.Append (other (cv, e));
+        QuickSort (nbs);
+        int n = 0;
+        for (int i = 0; i < nbs.Size(); i++)
+          if (i == 0 || nbs[i] != nbs[i-1])
+            nbs[n++] = nbs[i];
+        nbs.SetSize (n);
+      };
+
+    Array<int> first(ncv+1);
+    ParallelForRange (ncv, [&] (IntRange r)
+                      {
+                        Array<int> nbs;
+                        for (auto cv : r)
+                          {
+                            neighbours (cv, nbs);
+                            first[cv+1] = nbs.Size();
+                          }
+                      });
+    first[0] = 0;
+    for (size_t cv = 0; cv < ncv; cv++)
+      first[cv+1] += first[cv];
+
+    ce2v.SetSize (first[ncv]);
+    cweighte.SetSize (first[ncv]);
+    ecoarse.SetSize (ne);
+    ecoarsesign.SetSize (ne);
+
+    // fine edges not listed in cv2e are unused or collapsed
+    ParallelFor (ne, [&] (size_t i)
+                 {
+                   ecoarse[i] = -1;
+                   ecoarsesign[i] = 0;
+                 });
+
+    ParallelForRange (ncv, [&] (IntRange r)
+                      {
+                        Array<int> nbs;
+                        for (auto cv : r)
+                          {
+                            neighbours (cv, nbs);
+                            for (int k = 0; k < nbs.Size(); k++)
+                              {
+                                ce2v[first[cv]+k] = INT<2> (cv, nbs[k]);
+                                cweighte[first[cv]+k] = 0;
+                              }
+                            for (int e : cv2e[cv])
+                              {
+                                int ce = first[cv] + nbs.Pos (other (cv, e));
+                                ecoarse[e] = ce;
+                                ecoarsesign[e] = (vcoarse[e2v[e][0]] == cv) ? 1 : -1;
+                                cweighte[ce] += weighte[e];
+                              }
+                          }
+                      });
+  }
+
+
+  /*
+    Numbers the coarse vertices: the vertices with connected[i] == i
+    get consecutive numbers, all others the number of connected[i].
+  */
+  static size_t NumberCoarseVertices (FlatArray<int> connected, FlatArray<int> vcoarse)
+  {
+    size_t ncv = 0;
+    for (size_t i = 0; i < connected.Size(); i++)
+      if (connected[i] == int(i))
+        vcoarse[i] = ncv++;
+
+    ParallelFor (connected.Size(), [&] (size_t i)
+                 {
+                   if (connected[i] != int(i))
+                     vcoarse[i] = vcoarse[connected[i]];
+                 });
+    return ncv;
+  }
+
+
+  
   AMG_H1 :: AMG_H1 (const BaseMatrix & sysmat,
 		    Array<INT<2> > & e2v,
 		    Array<double> & weighte,
 		    int levels)
   {
+    static Timer t("AMG_H1 - setup");
+    RegionTimer reg(t);
+
     // find number of vertices
     int ne = e2v.Size();
-    int nv = 0;
-    for (int i = 0; i < ne; i++)
-      for (int j = 0; j < 2; j++)
-	nv = max2 (nv, e2v[i][j]);
-    nv++;
+    int nv = 1 + ParallelReduce (ne, [&] (size_t i) { return max2 (e2v[i][0], e2v[i][1]); },
+                                 [] (int a, int b) { return max2 (a, b); }, 0);
 
     cout << "ne = " << ne << ", nv = " << nv << endl;
 
@@ -36,19 +257,7 @@ namespace ngla
 	return;
       }
 
-    Array<int> vcoarse(nv), connected(nv);
-    Array<bool> edge_collapse(ne);
-    Array<double> edge_collapse_weight(ne);
-    edge_collapse = 0;
-    Array<int> v2edge(nv);
-    
-    /*
-    for (int i = 0; i < weighte.Size(); i++)
-      for (int j = 0; j < 2; j++)
-	if (e2v[i][j] == -1)
-	  cout << "unused edge" << endl;
-    */
-
+    Table<int> v2e = Vertex2Edge (e2v, nv);
 
     /*
     // compute weight to collapse edge
@@ -66,142 +275,52 @@ namespace ngla
 	*/
     // compute weight to collapse edge
     Array<double> vstrength(nv);
-    vstrength = 0.0;
-    for (int i = 0; i < weighte.Size(); i++)
-      if (e2v[i][0] != -1)
-	for (int j = 0; j < 2; j++)
-	  vstrength[e2v[i][j]] += weighte[i];
+    ParallelFor (nv, [&] (size_t v)
+                 {
+                   double sum = 0;
+                   for (int e : v2e[v])
+                     sum += weighte[e];
+                   vstrength[v] = sum;
+                 });
     
-    for (int i = 0; i < ne; i++)
-      if (e2v[i][0] != -1)
-	{
-	  double vstr1 = vstrength[e2v[i][0]];
-	  double vstr2 = vstrength[e2v[i][1]];
-	  edge_collapse_weight[i] = 
-	    weighte[i] * (vstr1+vstr2) / (vstr1 * vstr2);
-	}
+    Array<double> edge_collapse_weight(ne);
+    ParallelFor (ne, [&] (size_t i)
+                 {
+                   if (e2v[i][0] == -1) return;
+                   double vstr1 = vstrength[e2v[i][0]];
+                   double vstr2 = vstrength[e2v[i][1]];
+                   edge_collapse_weight[i] = 
+                     weighte[i] * (vstr1+vstr2) / (vstr1 * vstr2);
+                 });
 
     
-    // figure out best edges to collapse (iterative improvement)
-    v2edge = -1;
-    edge_collapse = false;
-    bool changed;
-    do
-      {
-	changed = 0;
-	for (int i = 0; i < ne; i++)
-	  if (e2v[i][0] != -1 && edge_collapse_weight[i] > 0.1)
-	    {
-	      if (v2edge[e2v[i][0]] == -1 && v2edge[e2v[i][1]] == -1)
-		
-		{
-		  edge_collapse[i] = true;
-		  v2edge[e2v[i][0]] = i;
-		  v2edge[e2v[i][1]] = i;
-		  changed = 1;
-		}	    
-	      
-	      else
-		
-		{
-		  for (int j = 0; j < 2; j++)
-		    {
-		      int pi1 = e2v[i][j];
-		      int pi2 = e2v[i][1-j];
-		      
-		      if (v2edge[pi1] != -1 && v2edge[pi2] == -1 &&
-			  edge_collapse_weight[i] > 
-			  edge_collapse_weight[v2edge[pi1]])
-			{
-			  int remove = v2edge[pi1];
-			  edge_collapse[i] = true;
-			  edge_collapse[remove] = false;
-			  v2edge[e2v[remove][0]] = -1;
-			  v2edge[e2v[remove][1]] = -1;
-			  v2edge[pi1] = i;
-			  v2edge[pi2] = i;
-			  changed = 1;
-			  break;
-			}
-		    }
-		}
-	    }
-      }
-    while (changed);
+    // figure out best edges to collapse
+    Array<int> v2edge = CollapseEdges
+      (e2v, v2e, edge_collapse_weight, false,
+       [&] (int i, FlatArray<int>) { return edge_collapse_weight[i] > 0.1; });
 
     // compute fine vertex to coarse vertex map (vcoarse)
-    for (int i = 0; i < nv; i++)
-      connected[i] = i;
-
-    for (int i = 0; i < ne; i++)
-      if (e2v[i][0] != -1)
-      if (edge_collapse[i])
-	{
-	  int pi1 = e2v[i][0], pi2 = e2v[i][1];
-	  if (vstrength[pi1] > vstrength[pi2])
-	    connected[pi2] = pi1;
-	  else
-	    connected[pi1] = pi2;
-	}
-
-    int ncv = 0;
-    for (int i = 0; i < nv; i++)
-      if (connected[i] == i)
-	vcoarse[i] = ncv++;
-
-    for (int i = 0; i < nv; i++)
-      if (connected[i] != i)
-	vcoarse[i] = vcoarse[connected[i]];
-
-
-
-
-    // compute fine edge to coarse edge map (ecoarse)
-    HashTable<INT<2>, int> ht_ecoarse(e2v.Size());
-    for (int i = 0; i < e2v.Size(); i++)
-      if (e2v[i][0] != -1)
-      {
-	INT<2> ce;
-	for (int j = 0; j < 2; j++)
-	  ce[j] = vcoarse[e2v[i][j]];
-	ce.Sort();
-	if (ce[0] != ce[1])
-	  ht_ecoarse.Set (ce, -1);
-      }
-    
+    Array<int> vcoarse(nv), connected(nv);
+    ParallelFor (nv, [&] (size_t i)
+                 {
+                   connected[i] = i;
+                   int e = v2edge[i];
+                   if (e == -1) return;
+                   int other = e2v[e][0]+e2v[e][1]-i;
+                   // the vertex with smaller strength is connected to the other
+                   if (int(i) == e2v[e][0] ? vstrength[other] >= vstrength[i]
+                                           : vstrength[other] > vstrength[i])
+                     connected[i] = other;
+                 });
+    int ncv = NumberCoarseVertices (connected, vcoarse);
+
+
+    // compute fine edge to coarse edge map (ecoarse) and coarse edge weights
     Array<INT<2> > ce2v;
-    for (int i = 0; i < ht_ecoarse.Size(); i++)
-      for (int j = 0; j < ht_ecoarse.EntrySize(i); j++)
-	{
-	  INT<2> ce;
-	  int efi;
-	  ht_ecoarse.GetData (i, j, ce, efi);
-	  efi = ce2v.Size();
-	  ce2v.Append (ce);
-	  ht_ecoarse.SetData (i, j, ce, efi);
-	}
-
-    Array<int> ecoarse(ne);
-    for (int i = 0; i < e2v.Size(); i++)
-      if (e2v[i][0] != -1)
-      {
-	INT<2> ce;
-	for (int j = 0; j < 2; j++)
-	  ce[j] = vcoarse[e2v[i][j]];
-	ce.Sort();
-	if (ce[0] != ce[1])
-	  ecoarse[i] = ht_ecoarse.Get(ce);
-	else
-	  ecoarse[i] = -1;
-      }
-
-    // coarse edge weights:
-    Array<double> cweighte(ce2v.Size());
-    cweighte = 0;
-    for (int i = 0; i < e2v.Size(); i++)
-      if (e2v[i][0] != -1)
-	if (ecoarse[i] != -1)
-	  cweighte[ecoarse[i]] += weighte[i];
+    Array<double> cweighte;
+    Array<int> ecoarse;
+    Array<short> ecoarsesign;
+    CoarsenEdges (e2v, weighte, vcoarse, ncv, ce2v, cweighte, ecoarse, ecoarsesign);
     
 
     // compute prolongation matrix 
@@ -212,11 +331,15 @@ namespace ngla
     nne = 1;
 
     prol = new SparseMatrix<double> (nne, ncv);
-    for (int i = 0; i < nv; i++)
-      (*prol)(i, vcoarse[i]) = 1;
+    ParallelFor (nv, [&] (size_t i)
+                 {
+                   prol->GetRowIndices(i)[0] = vcoarse[i];
+                   prol->GetRowValues(i)[0] = 1;
+                 });
 
     recAMG = new AMG_H1 (sysmat, ce2v, cweighte, levels-1);
   }
+
   
 
   AMG_H1 :: ~AMG_H1 ()
@@ -410,18 +533,12 @@ namespace ngla
     // find number of vertices
     int ne = e2v.Size();
     int nf = f2v.Size();
-    int nv = 0;
-    for (int i = 0; i < ne; i++)
-      for (int j = 0; j < 2; j++)
-	if (e2v[i][j] > nv)
-	  nv = e2v[i][j];
-    nv++;
+    int nv = 1 + ParallelReduce (ne, [&] (size_t i) { return max2 (e2v[i][0], e2v[i][1]); },
+                                 [] (int a, int b) { return max2 (a, b); }, 0);
 
     cout << "nfa = " << nf << ", ned = " << ne << ", nv = " << nv << endl;
 
-    Array<bool> edge_collapse(ne);
     Array<double> edge_collapse_weight(ne);
-    edge_collapse = 0;
 
 
     // find loops of 3 edges without face
@@ -447,20 +564,7 @@ namespace ngla
 	  }
       }
 
-    Array<int> cnt_v2e(nv);
-    cnt_v2e = 0;
-    for (int i = 0; i < ne; i++)
-      {
-        cnt_v2e[e2v[i][0]]++;
-        cnt_v2e[e2v[i][1]]++;
-      }
-    Table<int> v2e(cnt_v2e);
-    cnt_v2e = 0;
-    for (int i = 0; i < ne; i++)
-      {
-        v2e[e2v[i][0]][cnt_v2e[e2v[i][0]]++] = i;
-        v2e[e2v[i][1]][cnt_v2e[e2v[i][1]]++] = i;
-      }
+    Table<int> v2e = Vertex2Edge (e2v, nv);
 
     NgProfiler::StopTimer (timer1);
     
@@ -568,65 +672,68 @@ namespace ngla
 
 
     // compute face 2 edge table
-    HashTable<INT<2>, int> ht_edge(e2v.Size());
+    ParallelClosedHashTable<INT<2>, int> ht_edge(2*e2v.Size()+10);
     Array<INT<4> > f2e(nf);
 
-    for (int i = 0; i < ne; i++)
-      if (e2v[i][0] != -1)
-	{
-	  INT<2> ce = e2v[i];
-	  ce.Sort();
-	  ht_edge.Set (ce, i);
-	}
+    ParallelFor (ne, [&] (size_t i)
+      {
+        if (e2v[i][0] != -1)
+          {
+            INT<2> ce = e2v[i];
+            ce.Sort();
+            ht_edge.Set (ce, i);
+          }
+      });
 
-    for (int i = 0; i < f2v.Size(); i++)
-      if (f2v[i][0] != -1)
-	{
-	  int nfv = (f2v[i][3] == -1) ? 3 : 4;
-	  f2e[i][3] = -1;
-	  for (int j = 0; j < nfv; j++)
-	    {
-	      INT<2> ce;
-	      ce[0] = f2v[i][j];
-	      ce[1] = f2v[i][(j+1)%nfv];
-	      ce.Sort();
-	      if (!ht_edge.Used (ce))
-		{
-		  /*
-		    cout << "Err: unused edge, " 
-		    << "face = " << f2v[i] << endl;
-		*/
-		  (*testout) << "Err: unused edge, " 
-			     << "face = " << f2v[i] << endl;
-		  cout << "Err: unused edge, " 
-                       << "face = " << f2v[i] << endl;
-		  f2e[i][j] = -1;
-		}
-	      else
-		f2e[i][j] = ht_edge.Get(ce);
-	    }
-	}
-      else
-	for (int j = 0; j < 4; j++)
-	  f2e[i][j] = -1;
+    // the hash tables are complete, from here on they are only read
+    ParallelFor (f2v.Size(), [&] (size_t i)
+      {
+        for (int j = 0; j < 4; j++)
+          f2e[i][j] = -1;
+        if (f2v[i][0] == -1) return;
+
+        int nfv = (f2v[i][3] == -1) ? 3 : 4;
+        for (int j = 0; j < nfv; j++)
+          {
+            INT<2> ce;
+            ce[0] = f2v[i][j];
+            ce[1] = f2v[i][(j+1)%nfv];
+            ce.Sort();
+            if (!ht_edge.Used (ce))
+              {
+                cout << "Err: unused edge, " 
+                     << "face = " << f2v[i] << endl;
+                f2e[i][j] = -1;
+              }
+            else
+              f2e[i][j] = ht_edge.Get(ce);
+          }
+      });
 	  
     
     //    (*testout) << "weightf = " << weightf << endl;
     
 
+    Table<int> e2f = ParallelCreateTable<int>
+      (nf, [&] (auto & creator, size_t i)
+       {
+         for (int j = 0; j < 4; j++)
+           if (f2e[i][j] != -1)
+             creator.Add (f2e[i][j], i);
+       }, ne);
 
     Array<double> sume(ne);
-    sume = 0;
-    for (int i = 0; i < nf; i++)
-      for (int j = 0; j < 4; j++)
-        if (f2e[i][j] != -1)
-          sume[f2e[i][j]] += sqr (weightf[i]);
-
-
+    ParallelFor (ne, [&] (size_t i)
+                 {
+                   double sum = 0;
+                   for (int f : e2f[i])
+                     sum += sqr (weightf[f]);
+                   sume[i] = sum;
+                 });
 
 
     Array<double> face_collapse_weight(nf);
-    for (int i = 0; i < nf; i++)
+    ParallelFor (nf, [&] (size_t i)
       {
         double mine = 1e99;
         for (int j = 0; j < 4; j++)
@@ -639,62 +746,24 @@ namespace ngla
         //       if (f2e[i][j] != -1)
         //       maxe = max2 (maxe, sume[f2e[i][j]]);
         //       face_collapse_weight[i] = sqr (weightf[i]) / maxe;
+      });
 
-      }
-
-    /*
-    edge_collapse_weight = 1e99;
-    for (i = 0; i < nf; i++)
-      for (j = 0; j < 4; j++)
-        if (f2e[i][j] != -1)
-          edge_collapse_weight[f2e[i][j]] = 
-            min2 (edge_collapse_weight[f2e[i][j]],
-                  face_collapse_weight[i]);
-    */
-
-    Array<int> cnt_e2f(ne);
-    cnt_e2f = 0;
-    for (int i = 0; i < nf; i++)
-      for (int j = 0; j < 4; j++)
-        if (f2e[i][j] != -1)
-          cnt_e2f[f2e[i][j]]++;
-
-    Table<int> e2f(cnt_e2f);
-    cnt_e2f = 0;
-    for (int i = 0; i < nf; i++)
-      for (int j = 0; j < 4; j++)
-        if (f2e[i][j] != -1)
-          e2f[f2e[i][j]][cnt_e2f[f2e[i][j]]++] = i;
-  
-
-    for (int i = 0; i < ne; i++)
+    ParallelFor (ne, [&] (size_t i)
       {
         double mine = 1e99;
-        for (int j = 0; j < e2f[i].Size(); j++)
+        for (int fnr : e2f[i])
           {
-            int fnr = e2f[i][j];
             double maxf = 0;
             for (int k = 0; k < 4; k++)
               {
                 int enr = f2e[fnr][k];
-                if (enr != -1  && enr != i)
+                if (enr != -1  && enr != int(i))
                   maxf = max2 (maxf, sqr(weightf[fnr])/sume[enr]);
               }
             mine = min2(mine, maxf);
           }
         edge_collapse_weight[i] = mine;
-      }
-
-
-    /*
-    for (double fac = 1; fac > 1e-10; fac *= 0.1)
-      {
-        int cnt = 0;
-        for (int i = 0; i < ne; i++)
-          if (edge_collapse_weight[i] < fac) cnt++;
-        cout << cnt << " edges have weight < " << fac << endl;
-      }
-    */
+      });
 
 
     NgProfiler::StopTimer (timer2b);
@@ -702,141 +771,60 @@ namespace ngla
 
 
 
-    // figure out best edges to collapse (iterative improvement)
-    Array<int> v2edge(nv);
-    v2edge = -1;
-    edge_collapse = 0;
-
-    for (int cnt = 0, changed = 1; cnt < 3 && changed; cnt++)
+    // figure out best edges to collapse. The check looks at collapsed
+    // neighbour edges, it needs the distance-2 matching
+    auto admissible = [&] (int i, FlatArray<int> v2edge)
       {
-        changed = 0;
-
-	for (int i = 0; i < ne; i++)
-          {
-            if (e2v[i][0] == -1) continue;
-            if (edge_collapse_weight[i] < 0.05) continue;
-       
-       
-            bool ok = true;
-            int vi1 = e2v[i][0];
-            int vi2 = e2v[i][1];
-
-            // check, whether weak holes will collapse:
-            for (int j = 0; j < v2e[vi1].Size(); j++)
-              {
-                int e2 = v2e[vi1][j];
-                if (e2 == i) continue;
-                int vi3 = e2v[e2][0]+e2v[e2][1]-vi1;
+        if (edge_collapse_weight[i] < 0.05) return false;
 
+        int vi1 = e2v[i][0];
+        int vi2 = e2v[i][1];
 
-                // check whether weak faces will be closed
-                INT<2> ep2(vi2, vi3);
-                ep2.Sort();
-                if (ht_edge.Used (ep2))
-                  {
-                    INT<3> face(vi1, vi2, vi3);
-                    face.Sort();
-                    
-                    double val = (faceht.Used(face)) ? face_collapse_weight[faceht.Get(face)] : 0;
-                    if (val < 0.01) { ok = false; break; }
-		  }
-		else
-		  {
-// 		    bool foundquad = false;
-// 		    for(int k=0; ok && k < v2e[vi2].Size(); k++)
-// 		      {
-// 			int e3 = v2e[vi2][k];
-// 			if(e3 == i) continue;
-// 			int vi4 = e2v[e3][0]+e2v[e3][1]-vi2;
-			
-// 			INT<2> ep2(vi3,vi4);
-// 			ep2.Sort();
-// 			if (ht_edge.Used (ep2))
-// 			  {
-// 			    INT<4> face(vi1,vi2,vi3,vi4);
-// 			    face.Sort();
-
-// 			    if(qfaceht.Used(face))
-// 			      {
-// 				foundquad = true;
-// 				if(face_collapse_weight[qfaceht.Get(face)] < 0.01)
-// 				  ok = false;
-// 			      }
-// 			  }
-// 		      }
-// 		    if(!foundquad && v2edge[vi3] != -1)
-		    if(v2edge[vi3] != -1)
-		      {
-			int eop = v2edge[vi3];
-			int vi4 = e2v[eop][0]+e2v[eop][1]-vi3;
-			if(vi4 == vi1 || vi4 == vi2) continue; // sensible?
-			
-			INT<2> epair(vi2, vi4);
-			epair.Sort();
-			if (ht_edge.Used (epair))
-			  {
-			    INT<4> f1234(vi1,vi2,vi3,vi4);  // sensible?
-			    f1234.Sort();
-			    double v1234 = (qfaceht.Used(f1234)) ? face_collapse_weight[qfaceht.Get(f1234)] : 0;
-			    if (v1234 > 0.01) continue;	
-			    
+        // check, whether weak holes will collapse:
+        for (int e2 : v2e[vi1])
+          {
+            if (e2 == i) continue;
+            int vi3 = e2v[e2][0]+e2v[e2][1]-vi1;
 
-			    // not possible
-			    //INT<3> f123(vi1, vi2, vi3);
-			    //f123.Sort();
-			    //if(faceht.Used(f123))
-			    //  cout << endl << "POSSIBLE!!" << endl;
-			    //double v123 = (faceht.Used(f123)) ? face_collapse_weight[faceht.Get(f123)] : 0;
-			    //if (v123 > 0.01) continue;
-			    
-			    INT<3> f124(vi1, vi2, vi4);
-			    f124.Sort();
-			    double v124 = (faceht.Used(f124)) ? face_collapse_weight[faceht.Get(f124)] : 0;
-			    if (v124 > 0.01) continue;
-			    
-			    ok = false; 
-			    break;
-			  }
-		      }
-		  }
+            // check whether weak faces will be closed
+            INT<2> ep2(vi2, vi3);
+            ep2.Sort();
+            if (ht_edge.Used (ep2))
+              {
+                INT<3> face(vi1, vi2, vi3);
+                face.Sort();
+                
+                double val = (faceht.Used(face)) ? face_collapse_weight[faceht.Get(face)] : 0;
+                if (val < 0.01) return false;
               }
-
-
-            if (!ok) continue;
-
-            if (v2edge[e2v[i][0]] == -1 && v2edge[e2v[i][1]] == -1)
-              
+            else if (v2edge[vi3] != -1)
               {
-                edge_collapse[i] = 1;
-                v2edge[e2v[i][0]] = i;
-                v2edge[e2v[i][1]] = i;
-                changed = 1;
-              }	    
-            else
-              {  // iterative improvement (really improving ?)
-                for (int j = 0; j < 2; j++)
+                int eop = v2edge[vi3];
+                int vi4 = e2v[eop][0]+e2v[eop][1]-vi3;
+                if(vi4 == vi1 || vi4 == vi2) continue; // sensible?
+                
+                INT<2> epair(vi2, vi4);
+                epair.Sort();
+                if (ht_edge.Used (epair))
                   {
-                    int pi1 = e2v[i][j];
-                    int pi2 = e2v[i][1-j];
-		    
-                    if (v2edge[pi1] != -1 && v2edge[pi2] == -1 &&
-                        edge_collapse_weight[i] > 
-                        edge_collapse_weight[v2edge[pi1]])
-                      {
-                        int remove = v2edge[pi1];
-                        edge_collapse[i] = 1;
-                        edge_collapse[remove] = 0;
-                        v2edge[e2v[remove][0]] = -1;
-                        v2edge[e2v[remove][1]] = -1;
-                        v2edge[pi1] = i;
-                        v2edge[pi2] = i;
-                        changed = 1;
-                        break;
-                      }
+                    INT<4> f1234(vi1,vi2,vi3,vi4);  // sensible?
+                    f1234.Sort();
+                    double v1234 = (qfaceht.Used(f1234)) ? face_collapse_weight[qfaceht.Get(f1234)] : 0;
+                    if (v1234 > 0.01) continue;	
+                    
+                    INT<3> f124(vi1, vi2, vi4);
+                    f124.Sort();
+                    double v124 = (faceht.Used(f124)) ? face_collapse_weight[faceht.Get(f124)] : 0;
+                    if (v124 > 0.01) continue;
+                    
+                    return false;
                   }
               }
           }
-      }
+        return true;
+      };
+
+    Array<int> v2edge = CollapseEdges (e2v, v2e, edge_collapse_weight, true, admissible);
 
     NgProfiler::StopTimer (timer3);
     NgProfiler::StartTimer (timer4);
@@ -846,28 +834,12 @@ namespace ngla
 
     // compute fine vertex to coarse vertex map (vcoarse)
     Array<int> vcoarse(nv), connected(nv);
-    for (int i = 0; i < nv; i++)
-      connected[i] = i;
-
-    for (int i = 0; i < ne; i++)
-      if (edge_collapse[i])
-	{
-	  int pi1 = e2v[i][0];
-	  int pi2 = e2v[i][1];
-	  int mini = min2(pi1, pi2);
-	  connected[pi1] = mini;
-	  connected[pi2] = mini;
-	}
-
-    int ncv = 0;
-    for (int i = 0; i < nv; i++)
-      if (connected[i] == i)
-	{
-	  vcoarse[i] = ncv;
-	  ncv++;
-	}
-      else
-	vcoarse[i] = vcoarse[connected[i]];
+    ParallelFor (nv, [&] (size_t i)
+                 {
+                   int e = v2edge[i];
+                   connected[i] = (e == -1) ? int(i) : min2 (e2v[e][0], e2v[e][1]);
+                 });
+    int ncv = NumberCoarseVertices (connected, vcoarse);
 
 
     Array<Vec<3> > cvertices;
@@ -881,91 +853,25 @@ namespace ngla
 
 
 
-
-    // compute fine edge to coarse edge map (ecoarse)
-    HashTable<INT<2>, int> ht_ecoarse(ne);
-    for (int i = 0; i < ne; i++)
-      if (e2v[i][0] != -1)
-	{
-	  INT<2> ce;
-	  for (int j = 0; j < 2; j++)
-	    ce[j] = vcoarse[e2v[i][j]];
-	  if (ce[0] != ce[1])
-	    {
-	      if (ce[0] > ce[1]) Swap (ce[0], ce[1]);
-	      ht_ecoarse.Set (ce, -1);
-	    }
-	}
-    
+    // compute fine edge to coarse edge map (ecoarse) and coarse edge weights
     Array<INT<2> > ce2v;
-    for (int i = 0; i < ht_ecoarse.Size(); i++)
-      for (int j = 0; j < ht_ecoarse.EntrySize(i); j++)
-	{
-	  INT<2> ce;
-	  int efi;
-	  ht_ecoarse.GetData (i, j, ce, efi);
-	  efi = ce2v.Size();
-	  ce2v.Append (ce);
-	  ht_ecoarse.SetData (i, j, ce, efi);
-	}
-
-    Array<int> ecoarse(ne);
-    Array<short> ecoarsesign(ne);
-    ecoarsesign = 1;
-    for (int i = 0; i < ne; i++)
-      {
-	if (e2v[i][0] == -1)
-	  {
-	    ecoarsesign[i] = 0;
-	    ecoarse[i] = -1;
-	    continue;
-	  }
-
-	INT<2> ce;
-	for (int j = 0; j < 2; j++)
-	  ce[j] = vcoarse[e2v[i][j]];
-	
-	if (ce[0] == ce[1])
-	  {
-	    ecoarsesign[i] = 0;
-	    ecoarse[i] = -1;
-	  }
-	else 
-	  {
-	    if (ce[0] > ce[1]) 
-	      {
-		Swap (ce[0], ce[1]);
-		ecoarsesign[i] = -1;
-	      }
-	    ecoarse[i] = ht_ecoarse.Get(ce);
-	  }
-      }
-
-    // coarse edge weights:
-    Array<double> cweighte(ce2v.Size());
-    cweighte = 0;
-    for (int i = 0; i < e2v.Size(); i++)
-      if (ecoarse[i] != -1)
-	cweighte[ecoarse[i]] += weighte[i];
-
-
+    Array<double> cweighte;
+    Array<int> ecoarse;
+    Array<short> ecoarsesign;
+    CoarsenEdges (e2v, weighte, vcoarse, ncv, ce2v, cweighte, ecoarse, ecoarsesign);
 
 
 
 
     // compute fine face to coarse face map (fcoarse)
-    HashTable<INT<4>, int> ht_fcoarse(nf);
-    for (int i = 0; i < nf; i++)
+    Array<INT<4> > cfaces(nf);
+    Array<bool> cface_used(nf);
+    ParallelFor (nf, [&] (size_t i)
       {
-	bool valid = true;
+        cface_used[i] = false;
 	for (int j = 0; j < 3; j++)
 	  if (f2e[i][j] == -1)
-	    valid = false;
-	if(!valid)
-	  {
-	    cout << "not valid" << endl;
-	    continue;
-	  }
+	    return;
 
 	INT<4> cf;
 	for (int j = 0; j < 4; j++)
@@ -979,10 +885,14 @@ namespace ngla
 	  for (int k = j+1; k < 4; k++)
 	    if (cf[j] == cf[k])
 	      degenerated = 1;
-	//	if (cf[0] != cf[1] && cf[1] != cf[2] && cf[2] != cf[3] && cf[3] != cf[0])
-	if (!degenerated)
-	  ht_fcoarse.Set (cf, -1);
-      }
+	cfaces[i] = cf;
+	cface_used[i] = !degenerated;
+      });
+
+    HashTable<INT<4>, int> ht_fcoarse(nf);
+    for (int i = 0; i < nf; i++)
+      if (cface_used[i])
+        ht_fcoarse.Set (cfaces[i], -1);
     
     Array<INT<4> > cf2v;
     for (int i = 0; i < ht_fcoarse.Size(); i++)
@@ -997,35 +907,10 @@ namespace ngla
 	}
 
     Array<int> fcoarse(nf);
-    fcoarse = -1;
-    for (int i = 0; i < nf; i++)
-      {
-	bool valid = 1;
-	for (int j = 0; j < 3; j++)
-	  if (f2e[i][j] == -1)
-	    valid = 0;
-	if(!valid)
-	  {
-	    cout << "not valid" << endl;
-	    continue;
-	  }
-
-	INT<4> cf;
-	for (int j = 0; j < 4; j++)
-	  if (f2v[i][j] != -1)
-	    cf[j] = vcoarse[f2v[i][j]];
-	  else
-	    cf[j] = -1;
-	SortFace(cf);
-	bool degenerated = 0;
-	for (int j = 0; j < 3; j++)
-	  for (int k = j+1; k < 4; k++)
-	    if (cf[j] == cf[k])
-	      degenerated = 1;
-	// if (cf[0] != cf[1] && cf[1] != cf[2] && cf[2] != cf[3] && cf[3] != cf[0])
-	if (!degenerated)
-	  fcoarse[i] = ht_fcoarse.Get(cf);
-      }
+    ParallelFor (nf, [&] (size_t i)
+                 {
+                   fcoarse[i] = cface_used[i] ? ht_fcoarse.Get(cfaces[i]) : -1;
+                 });
 
     // coarse face weights:
     Array<double> cweightf(cf2v.Size());
@@ -1037,45 +922,50 @@ namespace ngla
 
     // compute prolongation matrix
     Array<int> nne(ne);
-    nne = 0;
-    for (int i = 0; i < ne; i++)
-      if (ecoarse[i] != -1)
-	nne[i] = 1;
+    ParallelFor (ne, [&] (size_t i) { nne[i] = (ecoarse[i] != -1) ? 1 : 0; });
 
-    prol = new SparseMatrix<double> (nne);
+    prol = new SparseMatrix<double> (nne, ce2v.Size());
     // prol = dynamic_cast< SparseMatrixTM<double>* >(sysmat.CreateMatrix(nne));
-    for (int i = 0; i < ne; i++)
-      if (ecoarse[i] != -1)
-	{
-	  prol->CreatePosition (i, ecoarse[i]);
-	  (*prol)(i, ecoarse[i]) = ecoarsesign[i];
-	}
+    ParallelFor (ne, [&] (size_t i)
+                 {
+                   if (ecoarse[i] == -1) return;
+                   prol->GetRowIndices(i)[0] = ecoarse[i];
+                   prol->GetRowValues(i)[0] = ecoarsesign[i];
+                 });
 
     // compute gradient matrix:
-    for (int i = 0; i < ne; i++)
-      if (e2v[i][0] == -1)
-	nne[i] = 0;
-      else
-	nne[i] = 2;
+    ParallelFor (ne, [&] (size_t i) { nne[i] = (e2v[i][0] == -1) ? 0 : 2; });
 
-    grad = new SparseMatrix<double> (nne);
+    grad = new SparseMatrix<double> (nne, nv);
     // grad = dynamic_cast< SparseMatrixTM<double>* >(sysmat.CreateMatrix(nne));
-    for (int i = 0; i < ne; i++)
-      if (e2v[i][0] != -1)
-      {
-	grad->CreatePosition (i, e2v[i][0]);
-	grad->CreatePosition (i, e2v[i][1]);
-	(*grad)(i, e2v[i][0]) = 1;
-	(*grad)(i, e2v[i][1]) = -1;
-      }
+    ParallelFor (ne, [&] (size_t i)
+                 {
+                   if (e2v[i][0] == -1) return;
+                   // column indices of a row are sorted
+                   int first = (e2v[i][0] < e2v[i][1]) ? 0 : 1;
+                   auto cols = grad->GetRowIndices(i);
+                   auto vals = grad->GetRowValues(i);
+                   cols[0] = e2v[i][first];
+                   cols[1] = e2v[i][1-first];
+                   vals[0] = (first == 0) ? 1 : -1;
+                   vals[1] = -vals[0];
+                 });
 
     NgProfiler::StopTimer (timer4);
 
     cout << "nv = " << nv << ", ncv = " << ncv << endl;
     if (nv > 50 && ncv < 0.9*nv && levels != 0)
       {
-	recAMG = new AMG_HCurl (sysmat, cvertices, ce2v, cf2v, cweighte, cweightf, levels-1);
-        h1AMG = new AMG_H1 (sysmat, e2v, weighte, levels);
+        // the coarse H(curl) level and the H1 potential space are independent
+        recAMG = 0;
+        h1AMG = 0;
+        ParallelJob ([&] (TaskInfo & ti)
+                     {
+                       if (ti.task_nr == 0)
+                         recAMG = new AMG_HCurl (sysmat, cvertices, ce2v, cf2v, cweighte, cweightf, levels-1);
+                       else
+                         h1AMG = new AMG_H1 (sysmat, e2v, weighte, levels);
+                     }, 2);
         // h1AMG = new AMG_H1 (e2v, weighte, 0);
       }
     else
@@ -1100,12 +990,21 @@ namespace ngla
     cout << "compute HCurl matrices" << endl;
 
     pmat = &mat;
-    coarsemat = shared_ptr<BaseSparseMatrix>(mat.Restrict (*prol));
     jacobi = mat.CreateJacobiPrecond ();
 
-    h1mat = mat.Restrict (*grad);
-    //    dynamic_cast<SparseMatrixSymmetric<Mat<1,1> >&> (*h1mat) (0,0) += 1;
-    dynamic_cast<SparseMatrixTM<double>&> (*h1mat)(0,0) += 1;
+    // the two Galerkin products are computed by concurrent tasks. The
+    // coarser levels are not, the coarsest inverse pauses the task manager
+    ParallelJob ([&] (TaskInfo & ti)
+                 {
+                   if (ti.task_nr == 0)
+                     coarsemat = shared_ptr<BaseSparseMatrix>(mat.Restrict (*prol));
+                   else
+                     {
+                       h1mat = mat.Restrict (*grad);
+                       //    dynamic_cast<SparseMatrixSymmetric<Mat<1,1> >&> (*h1mat) (0,0) += 1;
+                       dynamic_cast<SparseMatrixTM<double>&> (*h1mat)(0,0) += 1;
+                     }
+                 }, 2);
 
     if (recAMG)
       {
@@ -11,7 +11,27 @@
 #include <cublas_v2.h>
 #include <cusparse.h>
 
+#ifdef PARALLEL
+#include <parallelngs.hpp>
+#if defined(OPEN_MPI) && OPEN_MPI
+#include <mpi-ext.h>
+#endif
+#endif
+
 extern void SetScalar (double val, int n, double * dev_ptr);
+extern void ScaleRows (int nrows, int w, const double * d, const double * b, double * db);
+extern void Axpby (int n, double a, const double * x, double b, double * y);
+extern void DiagMult (int n, double s, const double * d, const double * x, double * y, bool add);
+extern void DevDot (int n, const double * x, const double * y, double * res, double * work);
+extern void CGUpdate (int n, const double * num, const double * den,
+                      const double * s, const double * as, double * u, double * r);
+extern void CGDirection (int n, const double * num, const double * den,
+                         const double * w, double * s);
+extern void DevScatterAdd (int n, double s, const int * pos, const double * elvals, double * vals);
+extern void DevGather (int n, const int * pos, const double * vals, double * elvals);
+extern void DevSetIndirect (int n, const int * pos, double val, double * vals);
+extern void ChebyshevUpdate (int n, double c1, double c2, const double * diaginv,
+                             const double * r, double * d, double * x);
 
 
 
@@ -92,22 +112,96 @@ namespace ngla
   // cusparseHandle_t cusparseHandle;
 
 
+  /*
+    Free blocks are kept by size, rounded to 512 bytes. The vectors of
+    one solver have the same size and share the blocks. A mutex protects
+    the free lists, allocations happen also in parallel setup.
+  */
+  class DevMemoryPool
+  {
+    mutex mtx;
+    std::map<size_t, Array<void*>> free_blocks;
+
+    static size_t RoundSize (size_t bytes) { return max2 ((bytes+511) / 512, size_t(1)) * 512; }
+
+  public:
+    void * Allocate (size_t bytes)
+    {
+      size_t rsize = RoundSize (bytes);
+      {
+        lock_guard<mutex> guard(mtx);
+        auto & blocks = free_blocks[rsize];
+        if (blocks.Size())
+          {
+            void * ptr = blocks.Last();
+            blocks.DeleteLast();
+            return ptr;
+          }
+      }
+      void * ptr;
+      if (cudaMalloc (&ptr, rsize) != cudaSuccess)
+        {
+          // the cached blocks may fragment the device memory
+          Release();
+          if (cudaMalloc (&ptr, rsize) != cudaSuccess)
+            throw Exception ("DevAllocate: out of device memory");
+        }
+      return ptr;
+    }
+
+    void Deallocate (void * ptr, size_t bytes)
+    {
+      if (!ptr) return;
+      lock_guard<mutex> guard(mtx);
+      free_blocks[RoundSize (bytes)].Append (ptr);
+    }
+
+    void Release ()
+    {
+      lock_guard<mutex> guard(mtx);
+      for (auto & blocks : free_blocks)
+        for (auto ptr : blocks.second)
+          cudaFree (ptr);
+      free_blocks.clear();
+    }
+  };
+
+  // never destroyed, the CUDA context may be gone at program exit
+  static DevMemoryPool & GetDevMemoryPool ()
+  {
+    static DevMemoryPool * pool = new DevMemoryPool;
+    return *pool;
+  }
+
+  void * DevAllocate (size_t bytes) { return GetDevMemoryPool().Allocate (bytes); }
+  void DevDeallocate (void * ptr, size_t bytes) { GetDevMemoryPool().Deallocate (ptr, bytes); }
+  void DevReleasePool () { GetDevMemoryPool().Release(); }
+
+
+
   UnifiedVector :: UnifiedVector (int asize)
   {
     size = asize;
-    host_data = new double[asize];
-    cudaMalloc(&dev_data, size*sizeof(double));
+    // the host copy is allocated on first use
+    host_data = nullptr;
+    dev_data = (double*) DevAllocate (size*sizeof(double));
     host_uptodate = false;
     dev_uptodate = false;
 
     (*this) = 0.0;
   }
 
+  UnifiedVector :: ~UnifiedVector ()
+  {
+    DevDeallocate (dev_data, size*sizeof(double));
+    delete [] host_data;
+  }
+
   BaseVector & UnifiedVector :: operator= (double d)
   {
-    for (int i = 0; i < size; i++) host_data[i] = d;
+    // set on the device only, the host copy follows on demand
     ::SetScalar (d, size, dev_data);
-    host_uptodate = true;
+    host_uptodate = false;
     dev_uptodate = true;
     
     return *this;
@@ -132,10 +226,8 @@ namespace ngla
           }
         else if (uv2->host_uptodate)
           {
-            VFlatVector<double> fv(size, host_data);
-            fv = 1.0*v2;
+            FlatVector<> (size, HostDataWrite()) = FlatVector<> (size, uv2->host_data);
             host_uptodate = true;
-            dev_uptodate = false;
           }
         else
           {
@@ -144,11 +236,8 @@ namespace ngla
         return *this;
       }
 
-    VFlatVector<double> fv(size, host_data);
-    fv = 1.0*v2;
-
+    FlatVector<> (size, HostDataWrite()) = v2.FVDouble();
     host_uptodate = true;
-    dev_uptodate = false;
     return *this;
   }
 
@@ -157,7 +246,11 @@ namespace ngla
   
   BaseVector & UnifiedVector :: Scale (double scal)
   {
-    UpdateDevice();
+    if (!dev_uptodate)
+      {
+        FlatVector<> (size, HostDataWrite()) *= scal;
+        return *this;
+      }
     cublasDscal (Get_CuBlas_Handle(), size, &scal, dev_data, 1);
     host_uptodate = false;
     return *this;
@@ -171,8 +264,17 @@ namespace ngla
   
   BaseVector & UnifiedVector :: Set (double scal, const BaseVector & v)
   {
-    (*this) = 0.0;
-    Add (scal, v);
+    const UnifiedVector * v2 = dynamic_cast_UnifiedVector (&v);
+    if (v2)
+      {
+        ::Axpby (size, scal, v2->DevData(), 0, DevDataOverwrite());
+        return *this;
+      }
+    // a host vector, the values are written on the host
+    if (!host_data) host_data = new double[size];
+    FlatVector<> (size, host_data) = scal * v.FVDouble();
+    host_uptodate = true;
+    dev_uptodate = false;
     return *this;
   }
   
@@ -189,11 +291,16 @@ namespace ngla
                      size, &scal, v2->dev_data, 1, dev_data, 1);
 	host_uptodate = false;
       }
+    else if (host_uptodate)
+      FlatVector<> (size, HostDataWrite()) += scal * v.FVDouble();
     else
       {
-	UpdateHost();
-	VFlatVector<> (size, host_data) += scal * v;
-	dev_uptodate = false;
+        // the vector stays on the device, the host vector is uploaded
+        FlatVector<double> fv = v.FVDouble();
+        double * tmp = (double*) DevAllocate (size*sizeof(double));
+        cudaMemcpy (tmp, fv.Data(), size*sizeof(double), cudaMemcpyHostToDevice);
+	cublasDaxpy (Get_CuBlas_Handle(), size, &scal, tmp, 1, dev_data, 1);
+        DevDeallocate (tmp, size*sizeof(double));
       }
     return *this;
   }
@@ -214,7 +321,7 @@ namespace ngla
 	return res;
       }
 
-    FlatVector<> fv = FVDouble();
+    FlatVector<> fv (size, const_cast<double*> (HostData()));
     FlatVector<> fv2 = v2.FVDouble();
     return ngbla::InnerProduct (fv, fv2);
   }
@@ -223,14 +330,16 @@ namespace ngla
   ostream & UnifiedVector :: Print (ostream & ost) const
   {
     cout << "output unified vector, host = " << host_uptodate << ", dev = " << dev_uptodate << endl;
-    ost << FVDouble();
+    ost << FlatVector<> (size, const_cast<double*> (HostData()));
     return ost;
   }
   
   void UnifiedVector :: UpdateHost () const
   {
+    if (!host_data) host_data = new double[size];
     if (host_uptodate) return;
     if (!dev_uptodate) cout << "ERROR UnifiedVector::UpdateHost non is uptodate" << endl;
+    static Timer t("UnifiedVector::UpdateHost"); RegionTimer reg(t);
     cudaMemcpy (host_data, dev_data, sizeof(double)*size, cudaMemcpyDeviceToHost);    
     host_uptodate = true;
   }
@@ -239,7 +348,7 @@ namespace ngla
   {
     if (dev_uptodate) return;
     if (!host_uptodate) cout << "ERROR UnifiedVector::UpdateDevice non is uptodate" << endl;
-    cout << "Host2Device copy !!!!!!!!!!!!!!" << endl;
+    static Timer t("UnifiedVector::UpdateDevice"); RegionTimer reg(t);
     cudaMemcpy (dev_data, host_data, sizeof(double)*size, cudaMemcpyHostToDevice);
     dev_uptodate = true;
   }
@@ -248,6 +357,7 @@ namespace ngla
   FlatVector<double> UnifiedVector :: FVDouble () const
   {
     UpdateHost();
+    dev_uptodate = false;
     return FlatVector<> (size, host_data);
   }
   
@@ -259,6 +369,7 @@ namespace ngla
   void * UnifiedVector :: Memory() const throw()
   { 
     UpdateHost(); 
+    dev_uptodate = false;
     return host_data;
   }
 
@@ -286,6 +397,302 @@ namespace ngla
 
 
 
+#ifdef PARALLEL
+
+  bool CudaAwareMPI ()
+  {
+    static bool aware = [] ()
+      {
+        if (const char * env = getenv ("NGS_CUDA_AWARE_MPI"))
+          return atoi (env) != 0;
+#if defined(MPIX_CUDA_AWARE_SUPPORT) && MPIX_CUDA_AWARE_SUPPORT
+        return MPIX_Query_cuda_support() == 1;
+#else
+        return false;
+#endif
+      } ();
+    return aware;
+  }
+
+
+  /*
+    Device copy of the exchange pattern of a ParallelDofs. The exchange
+    dofs of all procs are concatenated, the values for proc p are at
+    offsets[i] ... offsets[i+1] of the packed buffers, with p = procs[i].
+    Shared by all vectors of the same ParallelDofs.
+  */
+  class DevParallelDofs
+  {
+  public:
+    Array<int> procs;
+    Array<int> offsets;
+    int nexdofs, nslave;
+    /// exchange dofs, slave dofs (set to 0 by Distribute)
+    int * dev_exdofs;
+    int * dev_slavedofs;
+    /// 1 for master dofs, 0 otherwise
+    double * dev_mastermask;
+    size_t ndof;
+
+    DevParallelDofs (const ParallelDofs & pardofs)
+    {
+      ndof = pardofs.GetNDofLocal();
+      offsets.Append (0);
+      for (int p = 0; p < pardofs.GetNTasks(); p++)
+        if (pardofs.GetExchangeDofs(p).Size())
+          {
+            procs.Append (p);
+            offsets.Append (offsets.Last() + pardofs.GetExchangeDofs(p).Size());
+          }
+
+      // the concatenation skips procs without exchange dofs
+      FlatArray<int> exdofs = pardofs.GetAllExchangeDofs();
+      nexdofs = exdofs.Size();
+      dev_exdofs = (int*) DevAllocate (max(nexdofs,1)*sizeof(int));
+      if (nexdofs)
+        cudaMemcpy (dev_exdofs, &exdofs[0], nexdofs*sizeof(int), cudaMemcpyHostToDevice);
+
+      Array<int> slavedofs;
+      Array<double> mask(ndof);
+      for (size_t i = 0; i < ndof; i++)
+        {
+          mask[i] = pardofs.IsMasterDof(i) ? 1 : 0;
+          if (!pardofs.IsMasterDof(i)) slavedofs.Append(i);
+        }
+      nslave = slavedofs.Size();
+      dev_slavedofs = (int*) DevAllocate (max(nslave,1)*sizeof(int));
+      if (nslave)
+        cudaMemcpy (dev_slavedofs, &slavedofs[0], nslave*sizeof(int), cudaMemcpyHostToDevice);
+      dev_mastermask = (double*) DevAllocate (max(ndof,size_t(1))*sizeof(double));
+      if (ndof)
+        cudaMemcpy (dev_mastermask, &mask[0], ndof*sizeof(double), cudaMemcpyHostToDevice);
+    }
+
+    ~DevParallelDofs ()
+    {
+      DevDeallocate (dev_exdofs, max(nexdofs,1)*sizeof(int));
+      DevDeallocate (dev_slavedofs, max(nslave,1)*sizeof(int));
+      DevDeallocate (dev_mastermask, max(ndof,size_t(1))*sizeof(double));
+    }
+  };
+
+  static shared_ptr<DevParallelDofs> GetDevParallelDofs (shared_ptr<ParallelDofs> pardofs)
+  {
+    // the owner is checked, a new ParallelDofs may get a recycled address
+    static std::map<const ParallelDofs*,
+                    tuple<weak_ptr<ParallelDofs>, weak_ptr<DevParallelDofs>>> cache;
+    auto & entry = cache[pardofs.get()];
+    if (get<0>(entry).lock() == pardofs)
+      if (auto dp = get<1>(entry).lock()) return dp;
+    auto dp = make_shared<DevParallelDofs> (*pardofs);
+    entry = make_tuple (weak_ptr<ParallelDofs>(pardofs), weak_ptr<DevParallelDofs>(dp));
+    return dp;
+  }
+
+
+
+  ParallelUnifiedVector :: ParallelUnifiedVector (shared_ptr<ParallelDofs> aparalleldofs,
+                                                  PARALLEL_STATUS astatus)
+    : UnifiedVector (aparalleldofs->GetNDofLocal())
+  {
+    SetParallelDofs (aparalleldofs);
+    status = astatus;
+  }
+
+  ParallelUnifiedVector :: ~ParallelUnifiedVector ()
+  {
+    SetParallelDofs (nullptr);
+  }
+
+  void ParallelUnifiedVector :: SetParallelDofs (shared_ptr<ParallelDofs> aparalleldofs, 
+                                                 const Array<int> * procs)
+  {
+    if (aparalleldofs == paralleldofs && devdofs) return;
+    if (devdofs)
+      {
+        size_t bytes = max(devdofs->nexdofs,1)*sizeof(double);
+        DevDeallocate (dev_sendbuf, bytes);
+        DevDeallocate (dev_recvbuf, bytes);
+        dev_sendbuf = dev_recvbuf = nullptr;
+        devdofs = nullptr;
+      }
+
+    paralleldofs = aparalleldofs;
+    if (!paralleldofs) return;
+    if (paralleldofs->GetNDofLocal() != size_t(size))
+      throw Exception ("ParallelUnifiedVector: parallel dofs do not fit the vector size");
+
+    devdofs = GetDevParallelDofs (paralleldofs);
+    size_t bytes = max(devdofs->nexdofs,1)*sizeof(double);
+    dev_sendbuf = (double*) DevAllocate (bytes);
+    dev_recvbuf = (double*) DevAllocate (bytes);
+  }
+
+
+  BaseVector & ParallelUnifiedVector :: SetScalar (double scal)
+  {
+    UnifiedVector::SetScalar (scal);
+    SetStatus (IsParallelVector() ? CUMULATED : NOT_PARALLEL);
+    return *this;
+  }
+
+  BaseVector & ParallelUnifiedVector :: Set (double scal, const BaseVector & v)
+  {
+    UnifiedVector::Set (scal, v);
+    const ParallelBaseVector * parv = dynamic_cast_ParallelBaseVector (&v);
+    if (parv && parv->IsParallelVector())
+      {
+        SetParallelDofs (parv->GetParallelDofs());
+        SetStatus (parv->Status());
+      }
+    else
+      SetStatus (NOT_PARALLEL);
+    return *this;
+  }
+
+  BaseVector & ParallelUnifiedVector :: Add (double scal, const BaseVector & v)
+  {
+    const ParallelBaseVector * parv = dynamic_cast_ParallelBaseVector (&v);
+    if (parv && Status() != parv->Status())
+      {
+        if (Status() == DISTRIBUTED)
+          Cumulate();
+        else
+          parv->Cumulate();
+      }
+    return UnifiedVector::Add (scal, v);
+  }
+
+  double ParallelUnifiedVector :: InnerProduct (const BaseVector & v2) const
+  {
+    const ParallelBaseVector * parv2 = dynamic_cast_ParallelBaseVector (&v2);
+    if (!parv2 || (Status() == NOT_PARALLEL && parv2->Status() == NOT_PARALLEL))
+      return UnifiedVector::InnerProduct (v2);
+
+    // one of the factors must be distributed
+    if (Status() == parv2->Status() && Status() == DISTRIBUTED)
+      Cumulate();
+    else if (Status() == parv2->Status() && Status() == CUMULATED)
+      Distribute();
+
+    double localsum = UnifiedVector::InnerProduct (v2);
+    return MyMPI_AllReduce (localsum, MPI_SUM, paralleldofs->GetCommunicator());
+  }
+
+  double ParallelUnifiedVector :: L2Norm () const
+  {
+    if (Status() == NOT_PARALLEL)
+      return UnifiedVector::L2Norm();
+    Cumulate();
+
+    // masked copy, the vector itself remains cumulated
+    double * tmp = (double*) DevAllocate (size*sizeof(double));
+    ::DiagMult (size, 1, devdofs->dev_mastermask, DevData(), tmp, false);
+    double sum;
+    cublasDdot (Get_CuBlas_Handle(), size, DevData(), 1, tmp, 1, &sum);
+    DevDeallocate (tmp, size*sizeof(double));
+    return sqrt (MyMPI_AllReduce (sum, MPI_SUM, paralleldofs->GetCommunicator()));
+  }
+
+
+  void ParallelUnifiedVector :: Distribute() const
+  {
+    if (status != CUMULATED) return;
+    auto self = const_cast<ParallelUnifiedVector*> (this);
+    if (devdofs->nslave)
+      ::DevSetIndirect (devdofs->nslave, devdofs->dev_slavedofs, 0.0, self->DevDataWrite());
+    status = DISTRIBUTED;
+  }
+
+  void ParallelUnifiedVector :: StartCumulate (CumulateRequest & req) const
+  {
+    static Timer t("ParallelUnifiedVector::StartCumulate"); RegionTimer reg(t);
+    req.active = false;
+    if (status != DISTRIBUTED) return;
+
+    int n = devdofs->nexdofs;
+    if (n) ::DevGather (n, devdofs->dev_exdofs, DevData(), dev_sendbuf);
+
+    double * sendbuf = dev_sendbuf;
+    double * recvbuf = dev_recvbuf;
+    if (CudaAwareMPI())
+      // MPI does not wait for the gather kernel
+      cudaDeviceSynchronize();
+    else
+      {
+        host_sendbuf.SetSize (max(n,1));
+        host_recvbuf.SetSize (max(n,1));
+        cudaMemcpy (&host_sendbuf[0], dev_sendbuf, n*sizeof(double), cudaMemcpyDeviceToHost);
+        sendbuf = &host_sendbuf[0];
+        recvbuf = &host_recvbuf[0];
+      }
+
+    MPI_Comm comm = paralleldofs->GetCommunicator();
+    auto & procs = devdofs->procs;
+    auto & offsets = devdofs->offsets;
+    req.exprocs = procs;
+    req.sendrequest.SetSize (procs.Size());
+    req.recvrequest.SetSize (procs.Size());
+    for (int i : ngstd::Range(procs))
+      {
+        int cnt = offsets[i+1]-offsets[i];
+        MPI_Irecv (recvbuf+offsets[i], cnt, MPI_DOUBLE, procs[i], MPI_TAG_SOLVE,
+                   comm, &req.recvrequest[i]);
+        MPI_Isend (sendbuf+offsets[i], cnt, MPI_DOUBLE, procs[i], MPI_TAG_SOLVE,
+                   comm, &req.sendrequest[i]);
+      }
+    req.active = true;
+  }
+
+  void ParallelUnifiedVector :: FinishCumulate (CumulateRequest & req) const
+  {
+    static Timer t("ParallelUnifiedVector::FinishCumulate"); RegionTimer reg(t);
+    if (!req.active) return;
+
+    int n = devdofs->nexdofs;
+    MyMPI_WaitAll (req.recvrequest);
+    if (!CudaAwareMPI())
+      cudaMemcpy (dev_recvbuf, &host_recvbuf[0], n*sizeof(double), cudaMemcpyHostToDevice);
+
+    // a dof shared with several procs receives several values, the adds are atomic
+    auto self = const_cast<ParallelUnifiedVector*> (this);
+    if (n) ::DevScatterAdd (n, 1.0, devdofs->dev_exdofs, dev_recvbuf, self->DevDataWrite());
+    MyMPI_WaitAll (req.sendrequest);
+
+    req.active = false;
+    status = CUMULATED;
+  }
+
+  void ParallelUnifiedVector :: IRecvVec (int dest, MPI_Request & request)
+  {
+    // host path of the generic exchange, Cumulate uses the packed buffers
+    int i = devdofs->procs.Pos (dest);
+    host_recvbuf.SetSize (max(devdofs->nexdofs,1));
+    int cnt = devdofs->offsets[i+1]-devdofs->offsets[i];
+    MPI_Irecv (&host_recvbuf[devdofs->offsets[i]], cnt, MPI_DOUBLE, dest, 
+               MPI_TAG_SOLVE, paralleldofs->GetCommunicator(), &request);
+  }
+
+  void ParallelUnifiedVector :: AddRecvValues (int sender)
+  {
+    int i = devdofs->procs.Pos (sender);
+    FlatArray<int> exdofs = paralleldofs->GetExchangeDofs (sender);
+    double * hv = HostDataWrite();
+    for (int j : ngstd::Range(exdofs))
+      hv[exdofs[j]] += host_recvbuf[devdofs->offsets[i]+j];
+  }
+
+  AutoVector ParallelUnifiedVector :: CreateVector () const
+  {
+    return make_shared<ParallelUnifiedVector> (paralleldofs, status);
+  }
+
+#endif
+
+
+
+
+
   DevSparseMatrix :: DevSparseMatrix (const SparseMatrix<double> & mat)
   {
     height = mat.Height();
@@ -298,6 +705,64 @@ namespace ngla
     cusparseSetMatType(*descr, CUSPARSE_MATRIX_TYPE_GENERAL);
     cusparseSetMatIndexBase(*descr, CUSPARSE_INDEX_BASE_ZERO);
 
+    if (dynamic_cast<const SparseMatrixSymmetric<double>*> (&mat))
+      {
+        /*
+          the symmetric matrix stores the lower triangle. Row i of the
+          full matrix is row i of the lower triangle followed by column i
+          below the diagonal, the columns stay sorted.
+        */
+        Array<int> cnt(height);
+        cnt = 0;
+        for (int i = 0; i < height; i++)
+          for (auto j : mat.GetRowIndices(i))
+            {
+              cnt[i]++;
+              if (j != i) cnt[j]++;
+            }
+        Array<int> temp_ind(height+1);
+        temp_ind[0] = 0;
+        for (int i = 0; i < height; i++)
+          temp_ind[i+1] = temp_ind[i] + cnt[i];
+        nze = temp_ind[height];
+
+        Array<int> temp_col(nze);
+        Array<double> temp_val(nze);
+        for (int i = 0; i < height; i++)
+          cnt[i] = temp_ind[i];
+        for (int i = 0; i < height; i++)
+          {
+            auto cols = mat.GetRowIndices(i);
+            auto vals = mat.GetRowValues(i);
+            for (auto k : Range(cols))
+              {
+                temp_col[cnt[i]] = cols[k];
+                temp_val[cnt[i]++] = vals(k);
+              }
+          }
+        for (int i = 0; i < height; i++)
+          {
+            auto cols = mat.GetRowIndices(i);
+            auto vals = mat.GetRowValues(i);
+            for (auto k : Range(cols))
+              if (cols[k] != i)
+                {
+                  int j = cols[k];
+                  temp_col[cnt[j]] = i;
+                  temp_val[cnt[j]++] = vals(k);
+                }
+          }
+
+        cudaMalloc ((void**)&dev_ind, (height+1) * sizeof(int));
+        cudaMalloc ((void**)&dev_col, nze * sizeof(int));
+        cudaMalloc ((void**)&dev_val, nze * sizeof(double));
+        cudaMemcpy (dev_ind, &temp_ind[0], (height+1)*sizeof(int), cudaMemcpyHostToDevice);
+        cudaMemcpy (dev_col, &temp_col[0], nze*sizeof(int), cudaMemcpyHostToDevice);
+        cudaMemcpy (dev_val, &temp_val[0], nze*sizeof(double), cudaMemcpyHostToDevice);
+        cout << IM(3) << "create device sparse matrix from symmetric, n = " << height << ", nze = " << nze << endl;
+        return;
+      }
+
     cout << "create device sparse matrix, n = " << height << ", nze = " << nze << endl;
     
     Array<int> temp_ind (mat.Height()+1); 
@@ -318,9 +783,9 @@ namespace ngla
     const UnifiedVector & ux = dynamic_cast_UnifiedVector (x);
     UnifiedVector & uy = dynamic_cast_UnifiedVector (y);
 
-    ux.UpdateDevice();
-    uy = 0.0;
-    uy.UpdateDevice();
+    // y is overwritten (beta = 0), it is neither zeroed nor copied
+    const double * xdata = ux.DevData();
+    double * ydata = uy.DevDataOverwrite();
 
     double alpha= 1;
     double beta = 0;
@@ -328,9 +793,7 @@ namespace ngla
                     CUSPARSE_OPERATION_NON_TRANSPOSE, height, width, nze, 
 		    &alpha, *descr, 
 		    dev_val, dev_ind, dev_col, 
-		    ux.dev_data, &beta, uy.dev_data);
-
-    uy.host_uptodate = false;
+		    xdata, &beta, ydata);
     // cout << "mult complete" << endl;
   }
 
@@ -341,18 +804,16 @@ namespace ngla
     const UnifiedVector & ux = dynamic_cast_UnifiedVector (x);
     UnifiedVector & uy = dynamic_cast_UnifiedVector (y);
 
-    ux.UpdateDevice();
-    uy.UpdateDevice();
+    const double * xdata = ux.DevData();
+    double * ydata = uy.DevDataWrite();
 
-    double alpha= 1;
+    double alpha= s;
     double beta = 1;
     cusparseDcsrmv (Get_CuSparse_Handle(), 
                     CUSPARSE_OPERATION_NON_TRANSPOSE, height, width, nze, 
 		    &alpha, *descr, 
 		    dev_val, dev_ind, dev_col, 
-		    ux.dev_data, &beta, uy.dev_data);
-
-    uy.host_uptodate = false;
+		    xdata, &beta, ydata);
 
     // cout << "mult complete" << endl;
   }
@@ -367,101 +828,590 @@ namespace ngla
   DevJacobiPreconditioner :: DevJacobiPreconditioner (const SparseMatrix<double> & mat,
 						      const BitArray & freedofs)
   {
-    height = mat.Height();
-    width = mat.Height();
-    nze = mat.Height();
-
-    descr = new cusparseMatDescr_t;
-    cusparseCreateMatDescr (descr);
-
-    cusparseSetMatType(*descr, CUSPARSE_MATRIX_TYPE_GENERAL);
-    cusparseSetMatIndexBase(*descr, CUSPARSE_INDEX_BASE_ZERO);
+    size = mat.Height();
 
     cout << "create Jacobi preconditioner" << endl;
     
-    Array<int> temp_ind (height+1); 
-    Array<int> temp_cols (height);
-    Array<double> temp_vals (height);
+    Array<double> temp_diag (size);
+    for (int i = 0; i < size; i++)
+      if (freedofs.Test(i))
+        temp_diag[i] = 1.0 / mat(i,i);
+      else
+        temp_diag[i] = 0.0;
+
+    cudaMalloc ((void**)&dev_diag, size * sizeof(double));
+    cudaMemcpy (dev_diag, &temp_diag[0], size*sizeof(double), cudaMemcpyHostToDevice);
+  }
+  
+  DevJacobiPreconditioner :: DevJacobiPreconditioner (const UnifiedVector & diag,
+						      const BitArray & freedofs)
+  {
+    size = diag.Size();
+
+    FlatVector<double> fdiag = diag.FVDouble();
+    Array<double> temp_diag (size);
+    for (int i = 0; i < size; i++)
+      if (freedofs.Test(i) && fdiag(i) != 0)
+        temp_diag[i] = 1.0 / fdiag(i);
+      else
+        temp_diag[i] = 0.0;
+
+    cudaMalloc ((void**)&dev_diag, size * sizeof(double));
+    cudaMemcpy (dev_diag, &temp_diag[0], size*sizeof(double), cudaMemcpyHostToDevice);
+  }
+  
+  void DevJacobiPreconditioner :: Mult (const BaseVector & x, BaseVector & y) const
+  {
+    const UnifiedVector & ux = dynamic_cast_UnifiedVector (x);
+    UnifiedVector & uy = dynamic_cast_UnifiedVector (y);
+
+    ::DiagMult (size, 1, dev_diag, ux.DevData(), uy.DevDataOverwrite(), false);
+  }
+
+
+  void DevJacobiPreconditioner :: MultAdd (double s, const BaseVector & x, BaseVector & y) const
+  {
+    const UnifiedVector & ux = dynamic_cast_UnifiedVector(x);
+    UnifiedVector & uy = dynamic_cast_UnifiedVector(y);
+
+    ::DiagMult (size, s, dev_diag, ux.DevData(), uy.DevDataWrite(), true);
+  }
+  
+
+
+
+  /// device memory for the duration of a solve, taken from the pool
+  class DevArray
+  {
+    double * ptr;
+    size_t size;
+  public:
+    DevArray (size_t n) : size(max2 (n, size_t(1)) * sizeof(double))
+    { ptr = (double*) DevAllocate (size); }
+    ~DevArray () { DevDeallocate (ptr, size); }
+    operator double* () const { return ptr; }
+  };
+
+  // partial sums of DevDot, one per block of linalg_kernels.cu
+  constexpr int dot_work = 512;
+
+  static void DevCopy (const UnifiedVector & x, UnifiedVector & y)
+  {
+    cudaMemcpy (y.DevDataOverwrite(), x.DevData(), x.Size()*sizeof(double),
+                cudaMemcpyDeviceToDevice);
+  }
+
+
+  void DevCGSolver :: Mult (const BaseVector & f, BaseVector & u) const
+  {
+    static Timer t("DevCGSolver::Mult"); RegionTimer reg(t);
+    try
+      {
+        const UnifiedVector & uf = dynamic_cast_UnifiedVector (f);
+        UnifiedVector & uu = dynamic_cast_UnifiedVector (u);
+        int n = uf.Size();
+
+        WorkVectors work(*this, f, 3);
+        UnifiedVector & d = dynamic_cast_UnifiedVector (work[0]);
+        UnifiedVector & w = dynamic_cast_UnifiedVector (work[1]);
+        UnifiedVector & s = dynamic_cast_UnifiedVector (work[2]);
+
+        // the inner products (w,d) of the last two steps and (s,As)
+        DevArray scal(3+dot_work);
+        double * wd = scal;
+        double * wdn = scal+1;
+        double * kss = scal+2;
+        double * dotwork = scal+3;
+
+        if (initialize)
+          {
+            uu = 0.0;
+            DevCopy (uf, d);
+          }
+        else
+          {
+            a->Mult (u, d);
+            ::Axpby (n, 1, uf.DevData(), -1, d.DevDataWrite());
+          }
+        if (c)
+          c->Mult (d, w);
+        else
+          DevCopy (d, w);
+        DevCopy (w, s);
+
+        ::DevDot (n, w.DevData(), d.DevData(), wdn, dotwork);
+        double hwdn;
+        cudaMemcpy (&hwdn, wdn, sizeof(double), cudaMemcpyDeviceToHost);
+
+        if (printrates) cout << IM(1) << "0 " << sqrt(fabs(hwdn)) << endl;
+        double err = stop_absolute ? prec * prec : prec * prec * fabs(hwdn);
 
-    for (int i = 0; i <= height; i++) temp_ind[i] = i; 
+        int it = 0;
+        while (it++ < maxsteps && fabs(hwdn) > err && !(sh && sh->ShouldTerminate()))
+          {
+            a->Mult (s, w);
+            ::DevDot (n, s.DevData(), w.DevData(), kss, dotwork);
+            ::CGUpdate (n, wdn, kss, s.DevData(), w.DevData(), uu.DevDataWrite(), d.DevDataWrite());
+            cudaMemcpy (wd, wdn, sizeof(double), cudaMemcpyDeviceToDevice);
+
+            if (c)
+              c->Mult (d, w);
+            else
+              DevCopy (d, w);
+
+            ::DevDot (n, w.DevData(), d.DevData(), wdn, dotwork);
+            ::CGDirection (n, wdn, wd, w.DevData(), s.DevDataWrite());
+
+            // the only synchronization of the iteration
+            cudaMemcpy (&hwdn, wdn, sizeof(double), cudaMemcpyDeviceToHost);
+            if (printrates) cout << IM(1) << it << " " << sqrt(fabs(hwdn)) << endl;
+          }
 
-    for (int i = 0; i < height; i++)
+        const_cast<int&> (steps) = it;
+      }
+
+    catch (Exception & e)
+      {
+	e.Append ("in caught in DevCGSolver::Mult\n");
+	throw;
+      }
+    catch (exception & e)
       {
-	temp_cols[i] = i;
-	if (freedofs.Test(i))
-	  temp_vals[i] = 1.0 / mat(i,i);
+	throw Exception(e.what() +
+			string ("\ncaught in DevCGSolver::Mult\n"));
+      }
+  }
+
+
+
+  void DevGMRESSolver :: Mult (const BaseVector & f, BaseVector & x) const
+  {
+    static Timer t("DevGMRESSolver::Mult"); RegionTimer reg(t);
+    try
+      {
+        const UnifiedVector & uf = dynamic_cast_UnifiedVector (f);
+        UnifiedVector & ux = dynamic_cast_UnifiedVector (x);
+        int n = uf.Size();
+        cublasHandle_t handle = Get_CuBlas_Handle();
+        double one = 1, zero = 0, minusone = -1;
+
+        WorkVectors work(*this, f, 3);
+        UnifiedVector & v = dynamic_cast_UnifiedVector (work[0]);
+        UnifiedVector & av = dynamic_cast_UnifiedVector (work[1]);
+        UnifiedVector & w = dynamic_cast_UnifiedVector (work[2]);
+
+        // the Krylov basis, one column per vector
+        DevArray basis(size_t(maxsteps) * n);
+        DevArray devips(maxsteps+1+dot_work);
+        double * dotwork = devips + (maxsteps+1);
+
+        Matrix<> h(maxsteps+1, maxsteps);
+        Vector<> gammai(maxsteps), ci(maxsteps), si(maxsteps);
+        Vector<> ips(maxsteps+1);
+        h = 0.0;
+
+        // ips(i) = (v_i, w) for i <= j, ips(j+1) = (w, w), one synchronization
+        auto inner_products = [&] (int j)
+          {
+            cublasDgemv (handle, CUBLAS_OP_T, n, j+1, &one, basis, n,
+                         w.DevData(), 1, &zero, devips, 1);
+            ::DevDot (n, w.DevData(), w.DevData(), devips+(j+1), dotwork);
+            cudaMemcpy (&ips(0), devips, (j+2)*sizeof(double), cudaMemcpyDeviceToHost);
+          };
+        // w -= sum_i ips(i) v_i, with the inner products still on the device
+        auto project = [&] (int j)
+          {
+            cublasDgemv (handle, CUBLAS_OP_N, n, j+1, &minusone, basis, n,
+                         devips, 1, &one, w.DevDataWrite(), 1);
+          };
+
+	if (initialize)
+	  {
+	    ux = 0.0;
+            DevCopy (uf, av);
+	  }
 	else
-	  temp_vals[i] = 0.0;
+	  {
+            a->Mult (x, av);
+            ::Axpby (n, 1, uf.DevData(), -1, av.DevDataWrite());
+	  }
+	if (c)
+          c->Mult (av, w);
+        else
+          DevCopy (av, w);
+
+        ::DevDot (n, w.DevData(), w.DevData(), devips, dotwork);
+        double norm2;
+        cudaMemcpy (&norm2, devips, sizeof(double), cudaMemcpyDeviceToHost);
+        double norm = sqrt (norm2);
+        ::Axpby (n, (norm > 0) ? 1.0/norm : 0.0, w.DevData(), 0, v.DevDataOverwrite());
+
+        gammai(0) = norm;
+
+	if (printrates) cout << IM(1) << "0 " << norm << endl;
+	
+	double err;
+	if(stop_absolute)
+	  err = prec;
+	else
+	  err = prec * norm;
+	
+	int j = -1;
+	while (j++ < maxsteps-2 && norm > err)
+	  {
+            cudaMemcpy (basis + size_t(j)*n, v.DevData(), n*sizeof(double),
+                        cudaMemcpyDeviceToDevice);
+
+            a->Mult (v, av);
+            if (c)
+              c->Mult (av, w);
+            else
+              DevCopy (av, w);
+
+            // classical Gram-Schmidt, the norm of the projected vector 
+            // follows from Pythagoras
+            inner_products (j);
+            double ww = ips(j+1);
+            double proj = 0.0;
+            for (int i = 0; i <= j; i++)
+              {
+                h(i,j) = ips(i);
+                proj += sqr (ips(i));
+              }
+            project (j);
+            double nw2 = fabs (ww - proj);
+
+            // cancellation, reorthogonalize and compute the norm explicitly
+            if (nw2 < 0.5 * fabs (ww))
+              {
+                inner_products (j);
+                proj = 0.0;
+                for (int i = 0; i <= j; i++)
+                  {
+                    h(i,j) += ips(i);
+                    proj += sqr (ips(i));
+                  }
+                project (j);
+                nw2 = fabs (ips(j+1) - proj);
+              }
+
+            h(j+1,j) = sqrt (nw2);
+            ::Axpby (n, (nw2 > 0) ? 1.0/sqrt(nw2) : 0.0, w.DevData(), 0, v.DevDataOverwrite());
+
+            for (int i = 0; i < j; i++)
+              {
+                double hi = h(i,j), hip = h(i+1, j);
+                h(i,j)   = ci(i+1) * hi + si(i+1) * hip;
+                h(i+1,j) = si(i+1) * hi - ci(i+1) * hip;
+              }
+            double beta = sqrt ( sqr(h(j,j)) + sqr(h(j+1,j)));
+            si(j+1) = h(j+1,j) / beta;
+            ci(j+1) = h(j,j) / beta;
+            h(j,j) = beta;
+            gammai(j+1) = si(j+1) * gammai(j);
+            gammai(j) = ci(j+1) * gammai(j);
+            
+	    if (printrates ) cout << IM(1) << j 
+                                  << " ci = " << ci(j+1) 
+                                  << " si = " << si(j+1) 
+                                  << " gammi = " << gammai(j) << endl;
+
+            norm = fabs (gammai(j));
+          }
+        
+        j--;
+        Vector<> y(maxsteps);
+        for (int i = j; i >= 0; i--)
+          {
+            double sum = gammai(i);
+            for (int k = i+1; k <= j; k++)
+              sum -= h(i,k) * y(k);
+            y(i) = sum / h(i,i);
+          }
+
+        // x += sum_i y_i v_i
+        if (j >= 0)
+          {
+            cudaMemcpy (devips, &y(0), (j+1)*sizeof(double), cudaMemcpyHostToDevice);
+            cublasDgemv (handle, CUBLAS_OP_N, n, j+1, &one, basis, n,
+                         devips, 1, &one, ux.DevDataWrite(), 1);
+          }
+
+	const_cast<int&> (steps) = j;
+      }
+
+    catch (Exception & e)
+      {
+	e.Append ("in caught in DevGMRESSolver::Mult\n");
+	throw;
+      }
+    catch (exception & e)
+      {
+	throw Exception(e.what() +
+			string ("\ncaught in DevGMRESSolver::Mult\n"));
+      }
+  }
+
+
+
+
+  DevChebyshevPrecond :: DevChebyshevPrecond (shared_ptr<BaseMatrix> aop,
+                                              const ChebyshevPrecond & host)
+    : op(aop), size(aop->VHeight()), degree(host.GetDegree())
+  {
+    host.GetBounds (lmin, lmax);
+    FlatArray<double> diaginv = host.GetInverseDiagonal();
+    if (diaginv.Size() != size_t(size))
+      throw Exception ("DevChebyshevPrecond: smoother does not match operator");
+    cudaMalloc ((void**)&dev_diaginv, size * sizeof(double));
+    cudaMemcpy (dev_diaginv, &diaginv[0], size*sizeof(double), cudaMemcpyHostToDevice);
+  }
+
+  DevChebyshevPrecond :: ~DevChebyshevPrecond ()
+  {
+    cudaFree (dev_diaginv);
+  }
+
+  void DevChebyshevPrecond :: Apply (UnifiedVector & x, const UnifiedVector & b, bool xzero) const
+  {
+    static Timer t("DevChebyshevPrecond::Apply"); RegionTimer reg(t);
+
+    UnifiedVector r(size), d(size);
+
+    double theta = 0.5 * (lmax+lmin);
+    double delta = 0.5 * (lmax-lmin);
+    double sigma = theta / delta;
+    double rho = 1 / sigma;
+
+    if (xzero)
+      {
+        x = 0.0;
+        DevCopy (b, r);
+      }
+    else
+      {
+        DevCopy (b, r);
+        op->MultAdd (-1, x, r);
       }
 
-    cudaMalloc ((void**)&dev_ind, (height+1) * sizeof(int));
-    cudaMalloc ((void**)&dev_col, (height) * sizeof(int));
-    cudaMalloc ((void**)&dev_val, (height) * sizeof(double));
+    ::ChebyshevUpdate (size, 0, 1/theta, dev_diaginv, r.DevData(), d.DevDataOverwrite(), x.DevDataWrite());
+    for (int k = 1; k < degree; k++)
+      {
+        op->MultAdd (-1, d, r);
+        double rhonew = 1 / (2*sigma - rho);
+        ::ChebyshevUpdate (size, rhonew * rho, 2 * rhonew / delta, dev_diaginv,
+                           r.DevData(), d.DevDataWrite(), x.DevDataWrite());
+        rho = rhonew;
+      }
+  }
 
-    cudaMemcpy (dev_ind, &temp_ind[0], (height+1)*sizeof(int), cudaMemcpyHostToDevice);
-    cudaMemcpy (dev_col, &temp_cols[0], height*sizeof(int), cudaMemcpyHostToDevice);
-    cudaMemcpy (dev_val, &temp_vals[0], height*sizeof(double), cudaMemcpyHostToDevice);
+  void DevChebyshevPrecond :: Smooth (BaseVector & x, const BaseVector & b) const
+  {
+    Apply (dynamic_cast_UnifiedVector (x), dynamic_cast_UnifiedVector (b), false);
   }
-  
-  void DevJacobiPreconditioner :: Mult (const BaseVector & x, BaseVector & y) const
+
+  void DevChebyshevPrecond :: Mult (const BaseVector & b, BaseVector & x) const
   {
-    // cout << "device mult precond" << endl;
+    Apply (dynamic_cast_UnifiedVector (x), dynamic_cast_UnifiedVector (b), true);
+  }
 
-    const UnifiedVector & ux = dynamic_cast_UnifiedVector (x);
-    UnifiedVector & uy = dynamic_cast_UnifiedVector (y);
 
-    ux.UpdateDevice();
-    uy = 0.0;
-    uy.UpdateDevice();
 
-    double alpha= 1;
-    double beta = 0;
-    cusparseDcsrmv (Get_CuSparse_Handle (), 
-                    CUSPARSE_OPERATION_NON_TRANSPOSE, height, width, nze, 
-		    &alpha, *descr, 
-		    dev_val, dev_ind, dev_col, 
-		    ux.dev_data, &beta, uy.dev_data);
 
-    uy.host_uptodate = false;
+  DevBlockJacobiPrecond :: DevBlockJacobiPrecond (const SparseMatrix<double> & mat,
+                                                  const Table<int> & blocks,
+                                                  double damping)
+    : size(mat.Height())
+  {
+    static Timer t("DevBlockJacobiPrecond"); RegionTimer reg(t);
+    bool symmetric = dynamic_cast<const SparseMatrixSymmetric<double>*> (&mat) != nullptr;
 
-    // cout << "mult complete" << endl;
+    int maxbs = 0;
+    for (auto i : Range(blocks))
+      maxbs = max2 (maxbs, int(blocks[i].Size()));
+
+    for (int bs = 1; bs <= maxbs; bs++)
+      {
+        Array<int> blocknrs;
+        for (auto i : Range(blocks))
+          if (blocks[i].Size() == size_t(bs))
+            blocknrs.Append (i);
+        if (!blocknrs.Size()) continue;
+        int nb = blocknrs.Size();
+
+        Array<double> inv(size_t(nb)*bs*bs);
+        Array<int> ind(nb*bs);
+        ParallelFor (nb, [&] (size_t k)
+                     {
+                       FlatArray<int> block = blocks[blocknrs[k]];
+                       FlatMatrix<double> blockmat(bs, bs, &inv[k*bs*bs]);
+                       for (int j = 0; j < bs; j++)
+                         {
+                           ind[k*bs+j] = block[j];
+                           for (int l = 0; l < bs; l++)
+                             blockmat(j,l) = (symmetric && block[j] < block[l]) ?
+                               mat(block[l], block[j]) : mat(block[j], block[l]);
+                         }
+                       CalcInverse (blockmat);
+                       blockmat *= damping;
+                     });
+
+        Batch batch;
+        batch.nblocks = nb;
+        batch.bs = bs;
+        cudaMalloc ((void**)&batch.dev_inv, inv.Size() * sizeof(double));
+        cudaMalloc ((void**)&batch.dev_ind, ind.Size() * sizeof(int));
+        cudaMalloc ((void**)&batch.dev_x, ind.Size() * sizeof(double));
+        cudaMalloc ((void**)&batch.dev_y, ind.Size() * sizeof(double));
+        cudaMemcpy (batch.dev_inv, &inv[0], inv.Size()*sizeof(double), cudaMemcpyHostToDevice);
+        cudaMemcpy (batch.dev_ind, &ind[0], ind.Size()*sizeof(int), cudaMemcpyHostToDevice);
+        batches.Append (batch);
+      }
+    cout << IM(3) << "device block Jacobi, " << blocks.Size() << " blocks in "
+         << batches.Size() << " batches" << endl;
   }
 
+  DevBlockJacobiPrecond :: ~DevBlockJacobiPrecond ()
+  {
+    for (auto & batch : batches)
+      {
+        cudaFree (batch.dev_inv);
+        cudaFree (batch.dev_ind);
+        cudaFree (batch.dev_x);
+        cudaFree (batch.dev_y);
+      }
+  }
 
-  void DevJacobiPreconditioner :: MultAdd (double s, const BaseVector & x, BaseVector & y) const
+  void DevBlockJacobiPrecond :: Mult (const BaseVector & x, BaseVector & y) const
   {
-    cout << "device multadd precond" << endl;
+    UnifiedVector & uy = dynamic_cast_UnifiedVector (y);
+    ::SetScalar (0, size, uy.DevDataOverwrite());
+    MultAdd (1, x, y);
+  }
 
-    const UnifiedVector & ux = dynamic_cast_UnifiedVector(x);
-    UnifiedVector & uy = dynamic_cast_UnifiedVector(y);
+  void DevBlockJacobiPrecond :: MultAdd (double s, const BaseVector & x, BaseVector & y) const
+  {
+    static Timer t("DevBlockJacobiPrecond::MultAdd"); RegionTimer reg(t);
+    const UnifiedVector & ux = dynamic_cast_UnifiedVector (x);
+    UnifiedVector & uy = dynamic_cast_UnifiedVector (y);
+
+    const double * xdata = ux.DevData();
+    double * ydata = uy.DevDataWrite();
+    for (auto & batch : batches)
+      {
+        int n = batch.nblocks * batch.bs;
+        ::DevGather (n, batch.dev_ind, xdata, batch.dev_x);
+        ngs_cuda::MultBatched (batch.nblocks, batch.bs, 1, batch.bs,
+                               batch.dev_inv, batch.dev_x, batch.dev_y);
+        ::DevScatterAdd (n, s, batch.dev_ind, batch.dev_y, ydata);
+      }
+  }
 
-    ux.UpdateDevice();
-    uy.UpdateDevice();
 
-    double alpha= 1;
-    double beta = 1;
-    cusparseDcsrmv (Get_CuSparse_Handle (), 
-                    CUSPARSE_OPERATION_NON_TRANSPOSE, height, width, nze, 
-		    &alpha, *descr, 
-		    dev_val, dev_ind, dev_col, 
-		    ux.dev_data, &beta, uy.dev_data);
 
-    uy.host_uptodate = false;
-    cout << "mult complete" << endl;
+
+  void DevMultiLevelMatrix :: AddLevel (shared_ptr<BaseMatrix> mat, shared_ptr<BaseMatrix> smoother,
+                                        shared_ptr<BaseMatrix> prol, shared_ptr<BaseMatrix> rest)
+  {
+    levels.Append (Level { mat, smoother, prol, rest });
   }
-  
 
+  int DevMultiLevelMatrix :: VHeight() const
+  {
+    return levels.Size() ? levels[0].mat->VHeight() : coarse->VHeight();
+  }
 
+  void DevMultiLevelMatrix :: Mult (const BaseVector & b, BaseVector & x) const
+  {
+    static Timer t("DevMultiLevelMatrix::Mult"); RegionTimer reg(t);
+    MultLevel (0, b, x);
+  }
+
+  void DevMultiLevelMatrix :: MultLevel (int level, const BaseVector & b, BaseVector & x) const
+  {
+    if (level == levels.Size())
+      {
+        // the only host <-> device copies of the cycle
+        static Timer t("DevMultiLevelMatrix::Mult - host coarse"); RegionTimer reg(t);
+        auto hb = coarse->CreateColVector();
+        auto hx = coarse->CreateRowVector();
+        hb = b;
+        coarse->Mult (hb, hx);
+        // host values, the device copy follows on demand
+        dynamic_cast_UnifiedVector (x) = *hx;
+        return;
+      }
+
+    auto & L = levels[level];
+    UnifiedVector r(L.mat->VHeight());
+    UnifiedVector cb(L.rest->VHeight()), cx(L.rest->VHeight());
 
+    // pre-smoothing from x = 0
+    L.smoother->Mult (b, x);
+    r.Set (1, b);
+    L.mat->MultAdd (-1, x, r);
 
+    L.rest->Mult (r, cb);
+    MultLevel (level+1, cb, cx);
+    L.prol->MultAdd (1, cx, x);
 
+    // post-smoothing with the same symmetric smoother
+    r.Set (1, b);
+    L.mat->MultAdd (-1, x, r);
+    L.smoother->MultAdd (1, r, x);
+  }
 
 
 
 
+}
+
 
 
+namespace ngs_cuda
+{
+  using ngla::Get_CuBlas_Handle;
+  
+  /*
+    cuBLAS is column-major, a row-major matrix is its transpose.
+    Row-major c = a * b is column-major c^T = b^T a^T 
+  */
+  void MultBatched (int batch, int h, int w, int k,
+                    const double * a, const double * b, double * c,
+                    bool add)
+  {
+    static Timer t("CUDA MultBatched"); RegionTimer reg(t);
+    t.AddFlops (double(batch)*h*w*k);
+    
+    double alpha = 1;
+    double beta = add ? 1 : 0;
+    cublasDgemmStridedBatched (Get_CuBlas_Handle(), CUBLAS_OP_N, CUBLAS_OP_N,
+                               w, h, k, &alpha,
+                               b, w, size_t(k)*w,
+                               a, k, size_t(h)*k,
+                               &beta, c, w, size_t(h)*w, batch);
+  }
 
+  void AddAtDBBatched (int batch, int npts, int n, int m,
+                       const double * a, const double * d, const double * b, double * c)
+  {
+    static Timer t("CUDA AddAtDBBatched"); RegionTimer reg(t);
+    t.AddFlops (double(batch)*npts*n*m);
+
+    size_t dbsize = sizeof(double)*batch*npts*m;
+    double * db = (double*) ngla::DevAllocate (dbsize);
+    ::ScaleRows (batch*npts, m, d, b, db);
+
+    // row-major c = a^T (db) is column-major c^T = (db)^T a
+    double alpha = 1, beta = 1;
+    cublasDgemmStridedBatched (Get_CuBlas_Handle(), CUBLAS_OP_N, CUBLAS_OP_T,
+                               m, n, npts, &alpha,
+                               db, m, size_t(npts)*m,
+                               a, n, size_t(npts)*n,
+                               &beta, c, m, size_t(n)*m, batch);
+    ngla::DevDeallocate (db, dbsize);
+  }
+  
 
 
 
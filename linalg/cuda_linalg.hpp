@@ -6,16 +6,35 @@
 namespace ngla
 {
 
+  /*
+    Device memory from a pool. Freed blocks are kept per size class and
+    reused, temporaries of device pipelines do not call cudaMalloc and
+    cudaFree (which synchronize the device) in every iteration.
+  */
+  void * DevAllocate (size_t bytes);
+  void DevDeallocate (void * ptr, size_t bytes);
+  /// returns all cached blocks to the device
+  void DevReleasePool ();
+
+
+  /**
+     Vector with a host and a device copy. Operations run where the
+     values are valid, the other copy is updated on demand. Host memory
+     is only allocated when the host copy is needed, vectors created by
+     CreateVector stay on the device.
+   */
   class UnifiedVector : public S_BaseVector<double>
   {
     // using int size;
-    double * host_data;
+    mutable double * host_data;
     double * dev_data;
     mutable bool host_uptodate;
     mutable bool dev_uptodate;
     
   public:
     UnifiedVector (int asize);
+    UnifiedVector (const UnifiedVector &) = delete;
+    virtual ~UnifiedVector ();
     
     BaseVector & operator= (double d);
     BaseVector & operator= (BaseVector & v2);
@@ -39,10 +58,44 @@ namespace ngla
     void UpdateHost () const;
     void UpdateDevice () const;
 
+    virtual VectorResidency Residency () const
+    {
+      if (host_uptodate && dev_uptodate) return VectorResidency::BOTH;
+      return dev_uptodate ? VectorResidency::DEVICE : VectorResidency::HOST;
+    }
+
+    /// host pointer for reading, copies to the host if necessary
+    const double * HostData () const { UpdateHost(); return host_data; }
+    /// host pointer for writing, the device copy becomes invalid
+    double * HostDataWrite ()
+    {
+      UpdateHost();
+      dev_uptodate = false;
+      return host_data;
+    }
+
+    /// device pointer for reading, copies to the device if necessary
+    const double * DevData () const { UpdateDevice(); return dev_data; }
+    /// device pointer for writing, the host copy becomes invalid
+    double * DevDataWrite ()
+    {
+      UpdateDevice();
+      host_uptodate = false;
+      return dev_data;
+    }
+    /// device pointer for overwriting, no copy, the host copy becomes invalid
+    double * DevDataOverwrite ()
+    {
+      dev_uptodate = true;
+      host_uptodate = false;
+      return dev_data;
+    }
+
 
     virtual ostream & Print (ostream & ost) const;    
     virtual AutoVector CreateVector () const;
 
+    /// host values, they may be modified, so the device copy becomes invalid
     virtual FlatVector<double> FVDouble () const;
     virtual FlatVector<Complex> FVComplex () const;
     virtual void * Memory() const throw ();
@@ -58,6 +111,28 @@ namespace ngla
     friend class DevJacobiPreconditioner;
   };
 
+  /// also unwraps AutoVectors
+  UnifiedVector & dynamic_cast_UnifiedVector (BaseVector & x);
+  const UnifiedVector & dynamic_cast_UnifiedVector (const BaseVector & x);
+
+  /*
+    Batched kernels of cuda_bla.hpp acting on unified vectors,
+    the vectors keep track of host/device residency.
+  */
+  inline void MultBatched (int batch, int h, int w, int k,
+                           const UnifiedVector & a, const UnifiedVector & b,
+                           UnifiedVector & c, bool add = false)
+  {
+    ngs_cuda::MultBatched (batch, h, w, k, a.DevData(), b.DevData(), c.DevDataWrite(), add);
+  }
+
+  inline void AddAtDBBatched (int batch, int npts, int n, int m,
+                              const UnifiedVector & a, const UnifiedVector & d,
+                              const UnifiedVector & b, UnifiedVector & c)
+  {
+    ngs_cuda::AddAtDBBatched (batch, npts, n, m, a.DevData(), d.DevData(), b.DevData(), c.DevDataWrite());
+  }
+
   class DevSparseMatrix : public BaseMatrix
   {
     cusparseMatDescr_t * descr;
@@ -66,32 +141,175 @@ namespace ngla
     double * dev_val;
     int height, width, nze;
   public:
+    /// symmetric matrices are stored in full
     DevSparseMatrix (const SparseMatrix<double> & mat);
+    virtual bool IsComplex() const { return false; }
+    virtual int VHeight() const { return height; }
+    virtual int VWidth() const { return width; }
+    virtual size_t NZE () const { return nze; }
+    virtual AutoVector CreateVector () const { return make_shared<UnifiedVector> (height); }
     virtual void Mult (const BaseVector & x, BaseVector & y) const;
     virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const;
+
+    /// values in the order of a non-symmetric host matrix, for assembly on the device
+    double * DevValues () const { return dev_val; }
   };
 
 
   class DevJacobiPreconditioner : public BaseMatrix
   {
-    // should be like this:
-    // double * dev_diag;
-    // int size;
-
-    // stored as sparse matrix ...
-    cusparseMatDescr_t * descr;
-    int * dev_ind;
-    int * dev_col;
-    double * dev_val;
-    int height, width, nze;
-    
+    /// inverse diagonal, 0 for non-free dofs
+    double * dev_diag;
+    int size;
 
   public:
     DevJacobiPreconditioner (const SparseMatrix<double> & mat, const BitArray & freedofs);
+    /// from the diagonal of a matrix-free operator
+    DevJacobiPreconditioner (const UnifiedVector & diag, const BitArray & freedofs);
+    virtual bool IsComplex() const { return false; }
+    virtual int VHeight() const { return size; }
+    virtual int VWidth() const { return size; }
+    virtual AutoVector CreateVector () const { return make_shared<UnifiedVector> (size); }
+    virtual void Mult (const BaseVector & x, BaseVector & y) const;
+    virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const;
+  };
+
+
+  /**
+     Chebyshev smoother on the device. Polynomial, bounds and diagonal
+     are taken from a host ChebyshevPrecond, the operator must act on
+     UnifiedVectors (e.g. DevSparseMatrix or a matrix-free operator).
+  */
+  class DevChebyshevPrecond : public BaseMatrix
+  {
+    shared_ptr<BaseMatrix> op;
+    double * dev_diaginv;
+    int size, degree;
+    double lmin, lmax;
+
+    void Apply (UnifiedVector & x, const UnifiedVector & b, bool xzero) const;
+  public:
+    DevChebyshevPrecond (shared_ptr<BaseMatrix> aop, const ChebyshevPrecond & host);
+    ~DevChebyshevPrecond ();
+
+    /// one smoothing sweep for A x = b
+    void Smooth (BaseVector & x, const BaseVector & b) const;
+
+    virtual bool IsComplex() const { return false; }
+    virtual int VHeight() const { return size; }
+    virtual int VWidth() const { return size; }
+    virtual AutoVector CreateVector () const { return make_shared<UnifiedVector> (size); }
+    virtual void Mult (const BaseVector & b, BaseVector & x) const;
+  };
+
+
+  /**
+     Block Jacobi preconditioner on the device. The inverses of the
+     diagonal blocks are computed on the host, blocks of equal size
+     form a batch which is applied by one batched product. Blocks may
+     overlap, the results are added with atomics. Used as a smoother
+     the additive block Jacobi needs damping.
+  */
+  class DevBlockJacobiPrecond : public BaseMatrix
+  {
+    struct Batch
+    {
+      int nblocks, bs;
+      /// inverses, bs x bs per block, and the dofs of the blocks
+      double * dev_inv;
+      int * dev_ind;
+      /// block vectors of one application
+      double * dev_x, * dev_y;
+    };
+    Array<Batch> batches;
+    int size;
+
+  public:
+    DevBlockJacobiPrecond (const SparseMatrix<double> & mat, const Table<int> & blocks,
+                           double damping = 1);
+    ~DevBlockJacobiPrecond ();
+
+    virtual bool IsComplex() const { return false; }
+    virtual int VHeight() const { return size; }
+    virtual int VWidth() const { return size; }
+    virtual AutoVector CreateVector () const { return make_shared<UnifiedVector> (size); }
     virtual void Mult (const BaseVector & x, BaseVector & y) const;
     virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const;
   };
 
+
+  /**
+     Symmetric V-cycle with the levels on the device. A level consists
+     of the matrix, a symmetric smoother M used as x += M (b - A x),
+     and the prolongation and restriction to the next level. The
+     coarsest problem is solved with a host matrix, vectors are copied
+     between device and host at this level only.
+  */
+  class DevMultiLevelMatrix : public BaseMatrix
+  {
+    struct Level
+    {
+      shared_ptr<BaseMatrix> mat, smoother, prol, rest;
+    };
+    Array<Level> levels;
+    shared_ptr<BaseMatrix> coarse;
+
+    void MultLevel (int level, const BaseVector & b, BaseVector & x) const;
+  public:
+    DevMultiLevelMatrix () { ; }
+
+    /// adds the next coarser level, the first level is the finest
+    void AddLevel (shared_ptr<BaseMatrix> mat, shared_ptr<BaseMatrix> smoother,
+                   shared_ptr<BaseMatrix> prol, shared_ptr<BaseMatrix> rest);
+    /// host matrix for the coarsest problem, acting on host vectors
+    void SetCoarseMatrix (shared_ptr<BaseMatrix> acoarse) { coarse = acoarse; }
+
+    int NumLevels () const { return levels.Size(); }
+
+    virtual bool IsComplex() const { return false; }
+    virtual int VHeight() const;
+    virtual int VWidth() const { return VHeight(); }
+    virtual AutoVector CreateVector () const { return make_shared<UnifiedVector> (VHeight()); }
+    virtual void Mult (const BaseVector & b, BaseVector & x) const;
+  };
+
+
+  /**
+     Conjugate gradients with all vectors and step sizes on the device.
+     Vectors are UnifiedVectors, matrix and preconditioner should act on
+     the device data (DevSparseMatrix, DevJacobiPreconditioner). The only
+     synchronization with the host per iteration reads the residual for
+     the convergence check.
+  */
+  class DevCGSolver : public KrylovSpaceSolver
+  {
+  public:
+    DevCGSolver (const BaseMatrix & aa)
+      : KrylovSpaceSolver (aa) { ; }
+    DevCGSolver (const BaseMatrix & aa, const BaseMatrix & ac)
+      : KrylovSpaceSolver (aa, ac) { ; }
+
+    virtual void Mult (const BaseVector & f, BaseVector & u) const;
+  };
+
+
+  /**
+     GMRES as GMRESSolver (left preconditioned, no restart) with the
+     Krylov basis on the device. The inner products of an iteration are
+     computed on the device and read by one synchronization, the host
+     keeps the small Hessenberg matrix only.
+  */
+  class DevGMRESSolver : public KrylovSpaceSolver
+  {
+  public:
+    DevGMRESSolver (const BaseMatrix & aa)
+      : KrylovSpaceSolver (aa) { ; }
+    DevGMRESSolver (const BaseMatrix & aa, const BaseMatrix & ac)
+      : KrylovSpaceSolver (aa, ac) { ; }
+
+    virtual void Mult (const BaseVector & f, BaseVector & x) const;
+  };
+
 }
 
 #endif
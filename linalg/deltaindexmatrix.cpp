@@ -0,0 +1,153 @@
+/*********************************************************************/
+/* File:   deltaindexmatrix.cpp                                      */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+/* 
+   Sparse matrix with compressed column indices
+*/
+
+#include <la.hpp>
+namespace ngla
+{
+
+  DeltaIndexSparseMatrix :: DeltaIndexSparseMatrix (const SparseMatrixTM<double> & mat)
+    : height(mat.Height()), width(mat.Width())
+  {
+    static Timer t("DeltaIndexSparseMatrix - ctor"); RegionTimer reg(t);
+
+    // the symmetric matrix stores only the lower triangle
+    bool symmetric = dynamic_cast<const SparseMatrixSymmetric<double>*> (&mat) != nullptr;
+
+    Array<int> rowlen(height);
+    rowlen = 0;
+    for (size_t i = 0; i < height; i++)
+      for (auto j : mat.GetRowIndices(i))
+        {
+          rowlen[i]++;
+          if (symmetric && j != i) rowlen[j]++;
+        }
+
+    Table<int> rowcols(rowlen);
+    Table<double> rowvals(rowlen);
+    rowlen = 0;
+    for (size_t i = 0; i < height; i++)
+      {
+        FlatArray<int> cols = mat.GetRowIndices(i);
+        FlatVector<double> vals = mat.GetRowValues(i);
+        for (size_t k = 0; k < cols.Size(); k++)
+          {
+            int j = cols[k];
+            rowcols[i][rowlen[i]] = j;
+            rowvals[i][rowlen[i]++] = vals(k);
+            if (symmetric && j != i)
+              {
+                rowcols[j][rowlen[j]] = i;
+                rowvals[j][rowlen[j]++] = vals(k);
+              }
+          }
+      }
+
+    // rows are filled in order of their columns, except for the 
+    // transposed entries of the symmetric matrix
+    rowbase.SetSize (height);
+    firsti.SetSize (height+1);
+    firstwide.SetSize (height+1);
+    firsti[0] = 0;
+    firstwide[0] = 0;
+    for (size_t i = 0; i < height; i++)
+      {
+        auto cols = rowcols[i];
+        int mincol = 0, maxcol = 0;
+        if (cols.Size())
+          {
+            mincol = maxcol = cols[0];
+            for (auto c : cols)
+              {
+                mincol = min2 (mincol, c);
+                maxcol = max2 (maxcol, c);
+              }
+          }
+        rowbase[i] = mincol;
+        firsti[i+1] = firsti[i] + cols.Size();
+        firstwide[i+1] = firstwide[i] + ((maxcol-mincol > 65535) ? cols.Size() : 0);
+      }
+
+    values.SetSize (firsti[height]);
+    widecol.SetSize (firstwide[height]);
+    delta.SetSize (firsti[height]-firstwide[height]);
+    ParallelFor (height, [&] (size_t i)
+      {
+        size_t first = firsti[i];
+        size_t fw = firstwide[i];
+        bool wide = firstwide[i+1] > fw;
+        for (size_t k = 0; k < rowcols[i].Size(); k++)
+          {
+            values[first+k] = rowvals[i][k];
+            if (wide)
+              widecol[fw+k] = rowcols[i][k];
+            else
+              delta[first-fw+k] = rowcols[i][k] - rowbase[i];
+          }
+      });
+  }
+
+  size_t DeltaIndexSparseMatrix :: NumWideRows () const
+  {
+    size_t cnt = 0;
+    for (size_t i = 0; i < height; i++)
+      if (firstwide[i+1] > firstwide[i]) cnt++;
+    return cnt;
+  }
+  
+  void DeltaIndexSparseMatrix :: MultAdd (double s, const BaseVector & x, BaseVector & y) const
+  {
+    static Timer t("DeltaIndexSparseMatrix::MultAdd"); RegionTimer reg(t);
+    t.AddFlops (values.Size());
+    
+    FlatVector<double> fx = x.FV<double>();
+    FlatVector<double> fy = y.FV<double>();
+
+    ParallelForRange
+      (height, [&] (IntRange r)
+       {
+         for (size_t i : r)
+           {
+             size_t first = firsti[i];
+             size_t n = firsti[i+1]-first;
+             const double * pval = &values[first];
+             double sum = 0;
+             
+             if (firstwide[i+1] > firstwide[i])
+               {
+                 const int * pcol = &widecol[firstwide[i]];
+                 for (size_t j = 0; j < n; j++)
+                   sum += pval[j] * fx(pcol[j]);
+               }
+             else if (n)
+               {
+                 const double * px = &fx(rowbase[i]);
+                 const uint16_t * pd = &delta[first-firstwide[i]];
+                 SIMD<double> ssum(0.0);
+                 size_t j = 0;
+                 for ( ; j+C <= n; j += C)
+                   ssum += SIMD<double> (pval+j) *
+                     SIMD<double> ([px,pd,j] (int k) { return px[pd[j+k]]; });
+                 sum = HSum(ssum);
+                 for ( ; j < n; j++)
+                   sum += pval[j] * px[pd[j]];
+               }
+             fy(i) += s * sum;
+           }
+       });
+  }
+
+  
+  Array<MemoryUsage> DeltaIndexSparseMatrix :: GetMemoryUsage () const
+  {
+    return { { "DeltaIndexSparseMatrix", values.Size()*sizeof(double) +
+          delta.Size()*sizeof(uint16_t) + widecol.Size()*sizeof(int) +
+          (firsti.Size()+firstwide.Size())*sizeof(size_t) + rowbase.Size()*sizeof(int), 1 } };
+  }
+  
+}
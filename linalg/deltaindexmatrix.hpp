@@ -0,0 +1,67 @@
+#ifndef FILE_NGS_DELTAINDEXMATRIX
+#define FILE_NGS_DELTAINDEXMATRIX
+
+/* ************************************************************************/
+/* File:   deltaindexmatrix.hpp                                           */
+/* Date:   Oct. 2026                                                      */
+/* ************************************************************************/
+
+/*
+   Sparse matrix with compressed column indices
+*/
+
+namespace ngla
+{
+
+  /**
+     A copy of a real sparse matrix with 16-bit column indices.
+     Every row stores its first column, and the columns of the row as
+     16-bit offsets to it. Rows reaching further than 65535 columns
+     keep 32-bit column numbers. After a bandwidth reducing renumbering
+     almost all rows are short-range, and the index traffic of the
+     matrix-vector product is halved.
+   */
+  class NGS_DLL_HEADER DeltaIndexSparseMatrix : public BaseMatrix
+  {
+    static constexpr int C = SIMD<double>::Size();
+
+    size_t height, width;
+    /// first entry of the row in values, height+1 entries
+    Array<size_t> firsti;
+    /// number of entries of long-range rows before the row, height+1 entries
+    Array<size_t> firstwide;
+    /// first column of every row
+    Array<int> rowbase;
+    /// offsets to rowbase for short-range rows
+    Array<uint16_t> delta;
+    /// column numbers for long-range rows
+    Array<int> widecol;
+    Array<double> values;
+
+  public:
+    /// copies the matrix, symmetric matrices are stored in full
+    DeltaIndexSparseMatrix (const SparseMatrixTM<double> & mat);
+
+    virtual bool IsComplex() const override { return false; }
+    virtual int VHeight() const override { return height; }
+    virtual int VWidth() const override { return width; }
+    virtual size_t NZE () const override { return values.Size(); }
+
+    /// number of rows which need 32-bit column numbers
+    size_t NumWideRows () const;
+    
+    virtual AutoVector CreateVector () const override
+    { return make_shared<VVector<double>> (height); }
+    virtual AutoVector CreateRowVector () const override
+    { return make_shared<VVector<double>> (width); }
+    virtual AutoVector CreateColVector () const override
+    { return make_shared<VVector<double>> (height); }
+
+    virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const override;
+
+    virtual Array<MemoryUsage> GetMemoryUsage () const override;
+  };
+
+}
+
+#endif
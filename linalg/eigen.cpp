@@ -293,3 +293,234 @@ namespace ngla
   }
 
 }
+
+
+
+namespace ngla
+{
+
+  // g = Trans(x) * y, the row blocks in parallel
+  static void ParallelGram (FlatMatrix<double> x, FlatMatrix<double> y, FlatMatrix<double> g)
+  {
+    size_t n = x.Height();
+    size_t nblocks = max2 (size_t(1), min2 (size_t(TaskManager::GetNumThreads()), n/1024));
+    Matrix<double> partial(nblocks*g.Height(), g.Width());
+    ParallelFor (nblocks, [&] (size_t b)
+                 {
+                   IntRange r = IntRange(0, n).Split (b, nblocks);
+                   NgGEMM<false,true> (make_SliceMatrix (Trans(x.Rows(r))),
+                                       make_SliceMatrix (y.Rows(r)),
+                                       make_SliceMatrix (partial.Rows(b*g.Height(), (b+1)*g.Height())));
+                 });
+    g = 0.0;
+    for (size_t b = 0; b < nblocks; b++)
+      g += partial.Rows(b*g.Height(), (b+1)*g.Height());
+  }
+
+  
+  // y -= x * c, the row blocks in parallel
+  static void ParallelSubMult (FlatMatrix<double> x, FlatMatrix<double> c, FlatMatrix<double> y)
+  {
+    ParallelForRange (x.Height(), [&] (IntRange r)
+                      { y.Rows(r) -= x.Rows(r) * c; });
+  }
+
+  
+  void LOBPCGSolver :: Solve (MultiVector & x, FlatVector<double> lam)
+  {
+    static Timer t("LOBPCG"); RegionTimer reg(t);
+    static Timer tmult("LOBPCG - mult");
+    static Timer tgram("LOBPCG - gram");
+    static Timer tupdate("LOBPCG - update");
+    
+    size_t n = x.Size(), k = x.NumVectors();
+    if (lam.Size() != k)
+      throw Exception ("LOBPCG: need one eigenvalue per vector");
+
+    MultiVector ax(n, k), mx(n, k), w(n, k), aw(n, k), mw(n, k), p(n, k), ap(n, k), mp(n, k);
+    MultiVector hw(c ? n : 0, k);
+
+    auto project = [&] (MultiVector & v)
+      {
+        if (!freedofs) return;
+        FlatMatrix<double> fv = v.FM();
+        ParallelFor (n, [&] (size_t i)
+                     { if (!freedofs->Test(i)) fv.Row(i) = 0.0; });
+      };
+    auto mult = [&] (const BaseMatrix & mat, const MultiVector & v, MultiVector & prod)
+      {
+        RegionTimer reg(tmult);
+        prod.SetZero();
+        mat.MultAdd (1, v, prod);
+      };
+
+    // blocks of the basis, and their products with A and M
+    FlatMatrix<double> s[3]  = { x.FM(), w.FM(), p.FM() };
+    FlatMatrix<double> as[3] = { ax.FM(), aw.FM(), ap.FM() };
+    FlatMatrix<double> ms[3] = { mx.FM(), mw.FM(), mp.FM() };
+    
+    // v, av, mv  M-orthogonal to x and with columns of norm 1, this keeps
+    // the Gram matrices well conditioned when x has converged
+    auto orthogonalize = [&] (MultiVector & v, MultiVector & av, MultiVector & mv)
+      {
+        RegionTimer reg(tupdate);
+        Matrix<double> hg(k, k);
+        ParallelGram (mx.FM(), v.FM(), hg);
+        ParallelSubMult (x.FM(), hg, v.FM());
+        ParallelSubMult (ax.FM(), hg, av.FM());
+        ParallelSubMult (mx.FM(), hg, mv.FM());
+        
+        ParallelGram (v.FM(), mv.FM(), hg);
+        Vector<double> scale(k);
+        for (size_t j = 0; j < k; j++)
+          scale(j) = (hg(j,j) > 0) ? 1/sqrt(hg(j,j)) : 0.0;
+        for (MultiVector * mvec : { &v, &av, &mv })
+          {
+            FlatMatrix<double> fm = mvec->FM();
+            ParallelFor (n, [&] (size_t i)
+                         {
+                           for (size_t j = 0; j < k; j++)
+                             fm(i,j) *= scale(j);
+                         });
+          }
+      };
+    
+    // Rayleigh-Ritz in the first nb blocks, the new x and p
+    auto rayleigh_ritz = [&] (int nb)
+      {
+        size_t mdim = nb*k;
+        Matrix<double> ga(mdim, mdim), gm(mdim, mdim), hg(k, k);
+        {
+          RegionTimer reg(tgram);
+          for (int i = 0; i < nb; i++)
+            for (int j = i; j < nb; j++)
+              {
+                ParallelGram (s[i], as[j], hg);
+                ga.Rows(i*k, (i+1)*k).Cols(j*k, (j+1)*k) = hg;
+                ga.Rows(j*k, (j+1)*k).Cols(i*k, (i+1)*k) = Trans(hg);
+                ParallelGram (s[i], ms[j], hg);
+                gm.Rows(i*k, (i+1)*k).Cols(j*k, (j+1)*k) = hg;
+                gm.Rows(j*k, (j+1)*k).Cols(i*k, (i+1)*k) = Trans(hg);
+              }
+        }
+
+        // M-orthonormal basis of the span, without dependent columns
+        Matrix<double> trafo(mdim, mdim);
+        GramSchmidtTrafo (gm, trafo, 1e-8);
+        Array<int> cols;
+        for (size_t j = 0; j < mdim; j++)
+          if (L2Norm (trafo.Col(j)) > 0) cols.Append (j);
+        size_t r = cols.Size();
+        if (r < k)
+          throw Exception ("LOBPCG: the basis has rank "+ToString(r)+" < "+ToString(k)+
+                           ", choose independent initial vectors");
+        Matrix<double> tr(mdim, r);
+        for (size_t j = 0; j < r; j++)
+          tr.Col(j) = trafo.Col(cols[j]);
+
+        Matrix<double> h = Trans(tr) * ga * tr;
+        Matrix<double> evecs(r, r);
+        Vector<double> ev(r);
+        LapackEigenValuesSymmetric (h, ev, evecs);
+        // rows of evecs are the eigenvectors, in ascending order
+        Matrix<double> coefs = tr * Trans(evecs.Rows(0, k));
+        lam = ev.Range(0, k);
+        
+        RegionTimer reg(tupdate);
+        ParallelForRange (n, [&] (IntRange rows)
+          {
+            for (int comp = 0; comp < 3; comp++)
+              {
+                FlatMatrix<double> * blocks = (comp == 0) ? s : (comp == 1) ? as : ms;
+                // p = w cw + p cp,  x = x cx + p
+                Matrix<double> xn = blocks[0].Rows(rows) * coefs.Rows(0, k);
+                if (nb > 1)
+                  {
+                    Matrix<double> pn = blocks[1].Rows(rows) * coefs.Rows(k, 2*k);
+                    if (nb > 2)
+                      pn += blocks[2].Rows(rows) * coefs.Rows(2*k, 3*k);
+                    xn += pn;
+                    blocks[2].Rows(rows) = pn;
+                  }
+                blocks[0].Rows(rows) = xn;
+              }
+          });
+
+        if (nb > 1)
+          orthogonalize (p, ap, mp);
+      };
+
+    project (x);
+    mult (a, x, ax);
+    mult (m, x, mx);
+    lam = 0;
+    rayleigh_ritz (1);
+
+    Vector<double> err(k);
+    Array<bool> locked(k);
+    locked = false;
+    steps = 0;
+    for (int it = 0; it < maxsteps; it++)
+      {
+        // the products are updated with the small coefficients, which
+        // accumulates round-off. recompute them from time to time
+        if (it > 0 && it % 10 == 0)
+          {
+            mult (a, x, ax); mult (m, x, mx);
+            mult (a, p, ap); mult (m, p, mp);
+          }
+        // residuals r = a x - lam m x in w
+        FlatMatrix<double> fw = w.FM(), fax = ax.FM(), fmx = mx.FM();
+        ParallelFor (n, [&] (size_t i)
+                     {
+                       for (size_t j = 0; j < k; j++)
+                         fw(i,j) = fax(i,j) - lam(j) * fmx(i,j);
+                     });
+        project (w);
+
+        Vector<double> nr(k), nax(k), nmx(k);
+        nr = 0.0; nax = 0.0; nmx = 0.0;
+        for (size_t i = 0; i < n; i++)
+          for (size_t j = 0; j < k; j++)
+            {
+              nr(j) += sqr (fw(i,j));
+              nax(j) += sqr (fax(i,j));
+              nmx(j) += sqr (fmx(i,j));
+            }
+        size_t nconv = 0;
+        double maxerr = 0;
+        for (size_t j = 0; j < k; j++)
+          {
+            double scale = sqrt(nax(j)) + fabs(lam(j)) * sqrt(nmx(j));
+            err(j) = (scale > 0) ? sqrt(nr(j)) / scale : 0;
+            if (err(j) < prec || locked[j]) nconv++;
+            maxerr = max2 (maxerr, err(j));
+          }
+        steps = it;
+        if (printrates)
+          cout << IM(1) << it << ": converged " << nconv << "/" << k
+               << ", max residual " << maxerr << endl;
+        if (nconv == k) break;
+
+        if (c)
+          {
+            mult (*c, w, hw);
+            fw = hw.FM();
+            project (w);
+          }
+        // soft locking: no new directions for converged vectors
+        for (size_t j = 0; j < k; j++)
+          {
+            if (err(j) < prec) locked[j] = true;
+            if (locked[j]) fw.Col(j) = 0.0;
+          }
+        
+        mult (a, w, aw);
+        mult (m, w, mw);
+        orthogonalize (w, aw, mw);
+        rayleigh_ritz (it == 0 ? 2 : 3);
+        steps = it+1;
+      }
+  }
+
+}
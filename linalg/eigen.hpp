@@ -52,6 +52,45 @@ namespace ngla
     void PrintEigenValues (ostream & ost) const;
   };
 
+
+  /**
+     Locally optimal block preconditioned conjugate gradient method
+     (Knyazev) for the smallest eigenvalues of  A u = lam M u,
+     A symmetric, M symmetric positive definite.
+
+     The basis of the Rayleigh-Ritz step is [X, W, P], the eigenvector
+     approximations, the preconditioned residuals and the previous
+     search directions. Matrices and preconditioner are applied to
+     whole MultiVectors, the Gram matrices are computed by NgGEMM on
+     row blocks in parallel, and the small problem is M-orthonormalized
+     and solved by LAPACK. Converged eigenvectors get no new search
+     direction in W (soft locking), they stay in the Rayleigh-Ritz step.
+
+     Dofs outside of freedofs are kept zero.
+  */
+  class NGS_DLL_HEADER LOBPCGSolver
+  {
+    const BaseMatrix & a, & m;
+    const BaseMatrix * c;
+    shared_ptr<BitArray> freedofs;
+    double prec = 1e-8;
+    int maxsteps = 100;
+    bool printrates = false;
+    int steps = 0;
+  public:
+    LOBPCGSolver (const BaseMatrix & aa, const BaseMatrix & am, const BaseMatrix * ac = nullptr,
+                  shared_ptr<BitArray> afreedofs = nullptr)
+      : a(aa), m(am), c(ac), freedofs(afreedofs) { ; }
+
+    void SetPrecision (double aprec) { prec = aprec; }
+    void SetMaxSteps (int amaxsteps) { maxsteps = amaxsteps; }
+    void SetPrintRates (bool aprintrates) { printrates = aprintrates; }
+    int GetSteps () const { return steps; }
+
+    /// x is the initial guess, and the M-orthonormal eigenvectors on return
+    void Solve (MultiVector & x, FlatVector<double> lam);
+  };
+
 }
 
 #endif
@@ -159,10 +159,12 @@ namespace ngla
     if (allvalues.Size())
       return;  // all memory in unique_ptrs 
     
+    // after Compress the values are in compressed storage, the dnums are still ours
     for (int i = 0; i < ne; i++)
-      if (!clone.Test(i))
+      if (!clone.Test(i) || compressed)
 	{
-	  delete [] &(elmats[i](0,0));
+          if (!compressed)
+            delete [] &(elmats[i](0,0));
 	  if (rowdnums[i].Size() > 0)
 	    delete [] &(rowdnums[i])[0];
 	  if (coldnums[i].Size() > 0)
@@ -175,6 +177,11 @@ namespace ngla
   {
     static Timer timer("EBE-matrix::MultAdd");
     RegionTimer reg (timer);
+    if (compressed)
+      {
+        MultAddCompressed (s, x, y, false);
+        return;
+      }
 
     size_t maxs = 0;
     for (size_t i = 0; i < coldnums.Size(); i++)
@@ -240,6 +247,11 @@ namespace ngla
   {
     static Timer timer("EBE-matrix::MultAdd");
     RegionTimer reg (timer);
+    if (compressed)
+      {
+        MultAddCompressed (s, x, y, false);
+        return;
+      }
 
     size_t maxs = 0;
     for (size_t i = 0; i < coldnums.Size(); i++)
@@ -323,6 +335,11 @@ namespace ngla
 //     cout << " ElementByElementMatrix<SCAL> :: MultTansAdd here " << endl << flush;
     static Timer timer("EBE-matrix::MultTransAdd");
     RegionTimer reg (timer);
+    if (compressed)
+      {
+        MultAddCompressed (s, x, y, true);
+        return;
+      }
     size_t maxs = 0;
     for (size_t i = 0; i < rowdnums.Size(); i++)
       maxs = max2 (maxs, rowdnums[i].Size());
@@ -386,6 +403,11 @@ namespace ngla
   {
     static Timer timer("EBE-matrix<double>::MultTransAdd");
     RegionTimer reg (timer);
+    if (compressed)
+      {
+        MultAddCompressed (s, x, y, true);
+        return;
+      }
     size_t maxs = 0;
     for (size_t i = 0; i < rowdnums.Size(); i++)
       maxs = max2 (maxs, rowdnums[i].Size());
@@ -491,6 +513,523 @@ namespace ngla
 
 
 
+  template <class SCAL>
+  void ElementByElementMatrix<SCAL> :: Compress (bool share_identical, bool single)
+  {
+    static Timer t("EBE-matrix::Compress"); RegionTimer reg(t);
+    if (compressed) return;
+
+    auto used = [&] (size_t i)
+      {
+        return rowdnums[i].Size() && coldnums[i].Size() &&
+          rowdnums[i][0] != -1 && coldnums[i][0] != -1;
+      };
+    auto same_size = [&] (int a, int b)
+      {
+        return elmats[a].Height() == elmats[b].Height() && elmats[a].Width() == elmats[b].Width();
+      };
+
+    Array<int> elements;
+    for (int i = 0; i < ne; i++)
+      if (used(i)) elements.Append (i);
+
+    // the element with the stored matrix
+    Array<int> rep(ne);
+    for (int i = 0; i < ne; i++)
+      rep[i] = i;
+    
+    if (share_identical)
+      {
+        // candidates are found by sorting a weighted sum of the entries,
+        // then compared entry by entry
+        Array<double> key(ne);
+        ParallelFor (elements.Size(), [&] (size_t ii)
+                     {
+                       int i = elements[ii];
+                       FlatMatrix<SCAL> m = elmats[i];
+                       double sum = 0;
+                       for (size_t j = 0; j < m.Height(); j++)
+                         for (size_t k = 0; k < m.Width(); k++)
+                           sum += std::abs(m(j,k)) * (1 + (7*j+13*k) % 17);
+                       key[i] = sum;
+                     });
+
+        Array<int> order(elements.Size());
+        for (size_t i = 0; i < elements.Size(); i++)
+          order[i] = elements[i];
+        QuickSort (order, [&] (int a, int b)
+                   {
+                     if (elmats[a].Height() != elmats[b].Height()) return elmats[a].Height() < elmats[b].Height();
+                     if (elmats[a].Width() != elmats[b].Width()) return elmats[a].Width() < elmats[b].Width();
+                     return key[a] < key[b];
+                   });
+
+        auto equal = [&] (int a, int b)
+          {
+            FlatMatrix<SCAL> ma = elmats[a], mb = elmats[b];
+            double norm = 0, diff = 0;
+            for (size_t j = 0; j < ma.Height(); j++)
+              for (size_t k = 0; k < ma.Width(); k++)
+                {
+                  norm = max2 (norm, double(std::abs(ma(j,k))));
+                  diff = max2 (diff, double(std::abs(ma(j,k)-mb(j,k))));
+                }
+            return diff <= 1e-12 * norm;
+          };
+
+        for (size_t i = 0; i < order.Size(); )
+          {
+            size_t j = i+1;
+            while (j < order.Size() && same_size (order[i], order[j]) &&
+                   key[order[j]]-key[order[i]] <= 1e-10 * key[order[i]])
+              j++;
+
+            ArrayMem<int,16> reps;
+            for (size_t k = i; k < j; k++)
+              {
+                int e = order[k];
+                for (int r : reps)
+                  if (equal (r, e))
+                    {
+                      rep[e] = r;
+                      break;
+                    }
+                if (rep[e] == e && reps.Size() < 16)
+                  reps.Append (e);
+              }
+            i = j;
+          }
+      }
+
+    Array<int> nuse(ne);
+    nuse = 0;
+    for (int i : elements)
+      nuse[rep[i]]++;
+
+    // greedy coloring, elements of one color share neither a row nor a column
+    Array<int> coloring(ne);
+    coloring = -1;
+    int maxcolor = -1;
+    int basecol = 0;
+    Array<unsigned int> rowmask(height), colmask(width);
+    size_t found = 0;
+
+    while (found < elements.Size())
+      {
+        rowmask = 0;
+        colmask = 0;
+        for (int i : elements)
+          {
+            if (coloring[i] >= 0) continue;
+
+            unsigned check = 0;
+            for (int d : rowdnums[i]) check |= rowmask[d];
+            for (int d : coldnums[i]) check |= colmask[d];
+
+            if (check != UINT_MAX)
+              {
+                found++;
+                unsigned checkbit = 1;
+                int color = basecol;
+                while (check & checkbit)
+                  {
+                    color++;
+                    checkbit *= 2;
+                  }
+                coloring[i] = color;
+                maxcolor = max2 (maxcolor, color);
+                for (int d : rowdnums[i]) rowmask[d] |= checkbit;
+                for (int d : coldnums[i]) colmask[d] |= checkbit;
+              }
+          }
+        basecol += 8*sizeof(unsigned int);
+      }
+    size_t ncolors = maxcolor+1;
+
+    TableCreator<int> creator(ncolors);
+    for ( ; !creator.Done(); creator++)
+      for (int i : elements)
+        creator.Add (coloring[i], i);
+    element_coloring = creator.MoveTable();
+
+    // elements of a shared matrix go into batches, the others are candidates for SIMD groups
+    Array<int> batch_elements;
+    Array<int> batch_size;
+    Array<int> ncandidates(ncolors);
+    shared_firstbatch.SetSize (ncolors+1);
+    shared_firstbatch[0] = 0;
+    for (size_t c = 0; c < ncolors; c++)
+      {
+        Array<int> shared;
+        ncandidates[c] = 0;
+        for (int i : element_coloring[c])
+          if (nuse[rep[i]] > 1)
+            shared.Append (i);
+          else
+            ncandidates[c]++;
+        QuickSort (shared, [&] (int a, int b)
+                   { return rep[a] < rep[b] || (rep[a] == rep[b] && a < b); });
+
+        for (size_t i = 0; i < shared.Size(); )
+          {
+            size_t j = i;
+            while (j < shared.Size() && j < i + max_batch && rep[shared[j]] == rep[shared[i]])
+              batch_elements.Append (shared[j++]);
+            batch_size.Append (j-i);
+            i = j;
+          }
+        shared_firstbatch[c+1] = batch_size.Size();
+      }
+
+    shared_batches = Table<int> (batch_size);
+    for (size_t b = 0, cnt = 0; b < batch_size.Size(); b++)
+      for (int & e : shared_batches[b])
+        e = batch_elements[cnt++];
+
+    Table<int> candidates(ncandidates);
+    for (size_t c = 0; c < ncolors; c++)
+      {
+        size_t cnt = 0;
+        for (int i : element_coloring[c])
+          if (nuse[rep[i]] <= 1)
+            candidates[c][cnt++] = i;
+      }
+
+    simd_index.SetSize (ne);
+    simd_index = -1;
+    ComputeSIMDGroups (candidates, single);
+
+    // new storage for the shared and the single element matrices
+    size_t totmem = 0;
+    for (int i : elements)
+      if (simd_index[i] < 0 && rep[i] == i)
+        totmem += elmats[i].Height() * elmats[i].Width();
+    compressed_values.SetSize (totmem);
+
+    Array<SCAL*> oldvalues(ne);
+    for (int i = 0; i < ne; i++)
+      oldvalues[i] = elmats[i].Height()*elmats[i].Width() ? &elmats[i](0,0) : nullptr;
+
+    Array<FlatMatrix<SCAL>> newmats(ne);
+    totmem = 0;
+    for (int i : elements)
+      if (simd_index[i] < 0 && rep[i] == i)
+        {
+          size_t h = elmats[i].Height(), w = elmats[i].Width();
+          newmats[i].AssignMemory (h, w, compressed_values.Addr(totmem));
+          newmats[i] = elmats[i];
+          totmem += h*w;
+        }
+    for (int i = 0; i < ne; i++)
+      {
+        if (!used(i))
+          elmats[i].AssignMemory (0, 0, nullptr);
+        else if (simd_index[i] >= 0)
+          elmats[i].AssignMemory (elmats[i].Height(), elmats[i].Width(), nullptr);
+        else
+          elmats[i].AssignMemory (elmats[i].Height(), elmats[i].Width(), &newmats[rep[i]](0,0));
+      }
+
+    if (allvalues.Size())
+      allvalues = Array<SCAL> (1);  // still marks the array-version
+    else
+      for (int i = 0; i < ne; i++)
+        if (!clone.Test(i))
+          delete [] oldvalues[i];
+    
+    compressed = true;
+    compressed_nze = compressed_values.Size() +
+      SIMD<double>::Size() * (simd_single ? simd_values_single.Size() : simd_values.Size());
+
+    // balancing, the work items of a color are its SIMD groups, batches and single elements
+    constexpr int SW = SIMD<double>::Size();
+    color_balance.SetSize (ncolors);
+    for (size_t c = 0; c < ncolors; c++)
+      {
+        size_t ng = simd_firstgroup[c+1] - simd_firstgroup[c];
+        size_t nb = shared_firstbatch[c+1] - shared_firstbatch[c];
+        color_balance[c].Calc (ng + nb + single_coloring[c].Size(),
+                               [&] (size_t item)
+                               {
+                                 int e;
+                                 size_t mult = 1;
+                                 if (item < ng)
+                                   {
+                                     e = simd_elements[(simd_firstgroup[c]+item)*SW];
+                                     mult = SW;
+                                   }
+                                 else if (item < ng+nb)
+                                   {
+                                     auto batch = shared_batches[shared_firstbatch[c]+item-ng];
+                                     e = batch[0];
+                                     mult = batch.Size();
+                                   }
+                                 else
+                                   e = single_coloring[c][item-ng-nb];
+                                 return mult * rowdnums[e].Size() * coldnums[e].Size();
+                               });
+      }
+
+    cout << IM(4) << "compressed ebe-matrix: " << ncolors << " colors, "
+         << simd_elements.Size() << " elements in SIMD lanes, "
+         << batch_elements.Size() << " elements with shared matrices, "
+         << "nze = " << compressed_nze << endl;
+  }
+
+
+  template <class SCAL>
+  void ElementByElementMatrix<SCAL> :: ComputeSIMDGroups (const Table<int> & candidates, bool single)
+  {
+    simd_firstgroup.SetSize (candidates.Size()+1);
+    simd_firstgroup = 0;
+    single_coloring = Table<int> (candidates);
+  }
+
+  template <class SCAL>
+  void ElementByElementMatrix<SCAL> ::
+  MultAddSIMD (size_t g, SCAL s, FlatVector<SCAL> fx, FlatVector<SCAL> fy, bool trans,
+               FlatVector<SIMD<double>> hx, FlatVector<SIMD<double>> hy) const
+  { ; }
+
+
+  // hy = A hx, or A^T hx, with the interleaved matrices of one SIMD group
+  template <typename TSIMD>
+  INLINE void EBESIMDMult (const TSIMD * mat, size_t h, size_t w, bool trans,
+                           FlatVector<SIMD<double>> hx, FlatVector<SIMD<double>> hy)
+  {
+    if (!trans)
+      for (size_t j = 0; j < h; j++)
+        {
+          SIMD<double> sum(0.0);
+          for (size_t k = 0; k < w; k++)
+            sum += SIMD<double>(mat[j*w+k]) * hx(k);
+          hy(j) = sum;
+        }
+    else
+      {
+        hy.Range(0,w) = SIMD<double>(0.0);
+        for (size_t k = 0; k < h; k++)
+          for (size_t j = 0; j < w; j++)
+            hy(j) += SIMD<double>(mat[k*w+j]) * hx(k);
+      }
+  }
+
+  template <>
+  void ElementByElementMatrix<double> :: ComputeSIMDGroups (const Table<int> & candidates, bool single)
+  {
+    static Timer t("EBE-matrix::ComputeSIMDGroups"); RegionTimer reg(t);
+    constexpr int SW = SIMD<double>::Size();
+
+    // sort each color by element size, full groups of SW elements go into SIMD lanes
+    simd_elements.SetSize0();
+    simd_firstgroup.SetSize (candidates.Size()+1);
+    simd_firstgroup[0] = 0;
+    Array<int> rest;
+    Array<int> nrest(candidates.Size());
+    for (size_t c = 0; c < candidates.Size(); c++)
+      {
+        Array<int> order;
+        for (int i : candidates[c])
+          order.Append (i);
+        QuickSort (order, [&] (int a, int b)
+                   {
+                     if (elmats[a].Height() != elmats[b].Height()) return elmats[a].Height() < elmats[b].Height();
+                     return elmats[a].Width() < elmats[b].Width();
+                   });
+
+        size_t nrest0 = rest.Size();
+        for (size_t i = 0; i < order.Size(); )
+          {
+            size_t j = i;
+            while (j < order.Size() && elmats[order[j]].Height() == elmats[order[i]].Height()
+                   && elmats[order[j]].Width() == elmats[order[i]].Width())
+              j++;
+            for ( ; i+SW <= j; i += SW)
+              for (int l = 0; l < SW; l++)
+                simd_elements.Append (order[i+l]);
+            for ( ; i < j; i++)
+              rest.Append (order[i]);
+          }
+        nrest[c] = rest.Size()-nrest0;
+        simd_firstgroup[c+1] = simd_elements.Size() / SW;
+      }
+
+    single_coloring = Table<int> (nrest);
+    for (size_t c = 0, cnt = 0; c < nrest.Size(); c++)
+      for (int & e : single_coloring[c])
+        e = rest[cnt++];
+
+    size_t ngroups = simd_elements.Size() / SW;
+    simd_start.SetSize (ngroups+1);
+    simd_start[0] = 0;
+    for (size_t g = 0; g < ngroups; g++)
+      {
+        int e = simd_elements[g*SW];
+        simd_start[g+1] = simd_start[g] + elmats[e].Height()*elmats[e].Width();
+      }
+    for (size_t i = 0; i < simd_elements.Size(); i++)
+      simd_index[simd_elements[i]] = i;
+
+    simd_single = single;
+    if (single)
+      simd_values_single.SetSize (simd_start[ngroups]);
+    else
+      simd_values.SetSize (simd_start[ngroups]);
+
+    ParallelFor (Range(ngroups), [&] (size_t g)
+                 {
+                   FlatArray<int> els = simd_elements.Range (g*SW, (g+1)*SW);
+                   size_t h = elmats[els[0]].Height(), w = elmats[els[0]].Width();
+                   for (size_t j = 0; j < h; j++)
+                     for (size_t k = 0; k < w; k++)
+                       {
+                         SIMD<double> val ([&] (int lane) { return elmats[els[lane]](j,k); });
+                         if (single)
+                           simd_values_single[simd_start[g]+j*w+k] = SIMD<float> (val);
+                         else
+                           simd_values[simd_start[g]+j*w+k] = val;
+                       }
+                 }, TasksPerThread(4));
+  }
+
+  template <>
+  void ElementByElementMatrix<double> ::
+  MultAddSIMD (size_t g, double s, FlatVector<double> fx, FlatVector<double> fy, bool trans,
+               FlatVector<SIMD<double>> hx, FlatVector<SIMD<double>> hy) const
+  {
+    constexpr int SW = SIMD<double>::Size();
+    FlatArray<int> els = simd_elements.Range (g*SW, (g+1)*SW);
+    size_t h = rowdnums[els[0]].Size(), w = coldnums[els[0]].Size();
+    auto & in = trans ? rowdnums : coldnums;
+    auto & out = trans ? coldnums : rowdnums;
+    size_t nin = trans ? h : w, nout = trans ? w : h;
+
+    for (size_t j = 0; j < nin; j++)
+      hx(j) = SIMD<double> ([&] (int lane) { return fx(in[els[lane]][j]); });
+
+    if (simd_single)
+      EBESIMDMult (&simd_values_single[simd_start[g]], h, w, trans, hx, hy);
+    else
+      EBESIMDMult (&simd_values[simd_start[g]], h, w, trans, hx, hy);
+
+    for (size_t j = 0; j < nout; j++)
+      for (int lane = 0; lane < SW; lane++)
+        fy(out[els[lane]][j]) += s * hy(j)[lane];
+  }
+
+
+  template <class SCAL>
+  void ElementByElementMatrix<SCAL> :: MultAddCompressed (double s, const BaseVector & x, BaseVector & y, bool trans) const
+  {
+    static Timer timer("EBE-matrix::MultAdd compressed");
+    RegionTimer reg (timer);
+    timer.AddFlops (compressed_nze);
+    
+    FlatVector<SCAL> vx = x.FV<SCAL>();
+    FlatVector<SCAL> vy = y.FV<SCAL>();
+    size_t maxs = max2 (max_row_size, max_col_size);
+
+    // the elements of one color are independent
+    for (size_t c = 0; c < element_coloring.Size(); c++)
+      {
+        size_t firstgroup = simd_firstgroup[c];
+        size_t ng = simd_firstgroup[c+1] - firstgroup;
+        size_t firstbatch = shared_firstbatch[c];
+        size_t nb = shared_firstbatch[c+1] - firstbatch;
+        
+        ParallelForRange
+          (color_balance[c], [&] (IntRange r)
+           {
+             Vector<SIMD<double>> hxsimd(ng ? maxs : 0);
+             Vector<SIMD<double>> hysimd(ng ? maxs : 0);
+             Vector<SCAL> memx(maxs * (nb ? max_batch : 1));
+             Vector<SCAL> memy(maxs * (nb ? max_batch : 1));
+             
+             for (size_t item : r)
+               {
+                 if (item < ng)
+                   {
+                     MultAddSIMD (firstgroup+item, s, vx, vy, trans, hxsimd, hysimd);
+                     continue;
+                   }
+                 
+                 if (item < ng+nb)
+                   {
+                     // the elements of a batch share the matrix: Y = A X
+                     FlatArray<int> batch = shared_batches[firstbatch+item-ng];
+                     FlatMatrix<SCAL> mat = elmats[batch[0]];
+                     size_t nin = trans ? mat.Height() : mat.Width();
+                     size_t nout = trans ? mat.Width() : mat.Height();
+                     FlatMatrix<SCAL> hx(nin, batch.Size(), memx.Data());
+                     FlatMatrix<SCAL> hy(nout, batch.Size(), memy.Data());
+                     for (size_t l = 0; l < batch.Size(); l++)
+                       {
+                         FlatArray<int> in = trans ? rowdnums[batch[l]] : coldnums[batch[l]];
+                         for (size_t j = 0; j < nin; j++)
+                           hx(j,l) = vx(in[j]);
+                       }
+                     if (trans)
+                       hy = Trans(mat) * hx;
+                     else
+                       hy = mat * hx;
+                     for (size_t l = 0; l < batch.Size(); l++)
+                       {
+                         FlatArray<int> out = trans ? coldnums[batch[l]] : rowdnums[batch[l]];
+                         for (size_t j = 0; j < nout; j++)
+                           vy(out[j]) += s * hy(j,l);
+                       }
+                     continue;
+                   }
+
+                 int i = single_coloring[c][item-ng-nb];
+                 FlatArray<int> rdi = rowdnums[i];
+                 FlatArray<int> cdi = coldnums[i];
+                 if (trans)
+                   {
+                     FlatVector<SCAL> hv(rdi.Size(), memx.Data());
+                     hv = vx(rdi);
+                     vy(cdi) += s * Trans(elmats[i]) * hv;
+                   }
+                 else
+                   {
+                     FlatVector<SCAL> hv(cdi.Size(), memx.Data());
+                     hv = vx(cdi);
+                     vy(rdi) += s * elmats[i] * hv;
+                   }
+               }
+           });
+      }
+  }
+
+
+  template <class SCAL>
+  void ElementByElementMatrix<SCAL> :: MultAddElement (int elnr, SCAL s, FlatVector<SCAL> x, FlatVector<SCAL> y) const
+  {
+    if (!compressed || simd_index[elnr] < 0)
+      {
+        y += s * elmats[elnr] * x;
+        return;
+      }
+
+    constexpr int SW = SIMD<double>::Size();
+    size_t g = simd_index[elnr] / SW;
+    int lane = simd_index[elnr] % SW;
+    size_t h = elmats[elnr].Height(), w = elmats[elnr].Width();
+    for (size_t j = 0; j < h; j++)
+      {
+        SCAL sum = 0.0;
+        for (size_t k = 0; k < w; k++)
+          {
+            double val = simd_single ?
+              double(simd_values_single[simd_start[g]+j*w+k][lane]) :
+              simd_values[simd_start[g]+j*w+k][lane];
+            sum += val * x(k);
+          }
+        y(j) += s * sum;
+      }
+  }
+
+
   template <class SCAL>
   shared_ptr<BaseMatrix> ElementByElementMatrix<SCAL> :: InverseMatrix ( BitArray * subset ) const
   {
@@ -531,6 +1070,8 @@ namespace ngla
   {
     if (elnr > elmats.Size())
       throw Exception ("EBEMatrix::AddElementMatrix, illegal elnr");
+    if (compressed)
+      throw Exception ("EBEMatrix::AddElementMatrix, matrix is compressed");
     
     
     ArrayMem<int,50> usedrows;
@@ -600,6 +1141,8 @@ namespace ngla
   {
     if (allvalues.Size())
       throw Exception ("AddClone + allvalues not ready");
+    if (compressed)
+      throw Exception ("EBEMatrix::AddCloneElementMatrix, matrix is compressed");
 
     ArrayMem<int,50> usedrows;
     for (int i = 0; i < rowdnums_in.Size(); i++)
@@ -660,7 +1203,10 @@ namespace ngla
 	  ost << "block " << i << endl;
 	  ost << "rows = " << rowdnums[i] << endl;
 	  ost << "cols = " << coldnums[i] << endl;
-	  ost << "matrix = " << elmats[i] << endl;
+	  if (compressed && simd_index[i] >= 0)
+	    ost << "matrix in SIMD lanes" << endl;
+	  else
+	    ost << "matrix = " << elmats[i] << endl;
 	}
       return ost;
     }
@@ -33,6 +33,42 @@ namespace ngla
 
     Array<int> allrow, allcol;
     Array<SCAL> allvalues;
+
+    // compressed storage, built by Compress:
+    bool compressed = false;
+    /// elements of one color share neither rows nor columns
+    Table<int> element_coloring;
+    // elements of one color with equal sizes in groups of SIMD<double>::Size(),
+    // their matrices are stored interleaved in SIMD lanes (SCAL = double only).
+    // the groups of color c are [simd_firstgroup[c], simd_firstgroup[c+1])
+    Array<int> simd_elements;
+    Array<size_t> simd_firstgroup;
+    Array<size_t> simd_start;    // offset of group g in simd_values or simd_values_single
+    Array<SIMD<double>> simd_values;
+    Array<SIMD<float>> simd_values_single;
+    bool simd_single = false;
+    /// position of the element in simd_elements, or -1
+    Array<int> simd_index;
+    // elements of one color with the same stored matrix, applied as one
+    // matrix-matrix product. the batches of color c are
+    // [shared_firstbatch[c], shared_firstbatch[c+1])
+    Table<int> shared_batches;
+    static constexpr size_t max_batch = 32;
+    Array<size_t> shared_firstbatch;
+    /// the remaining elements of color c
+    Table<int> single_coloring;
+    /// work items of color c: its SIMD groups, shared batches and single elements
+    Array<Partitioning> color_balance;
+    /// matrices of the shared and the single elements
+    Array<SCAL> compressed_values;
+    size_t compressed_nze = 0;
+
+    /// groups elements of equal size of each color, the others go to single_coloring
+    void ComputeSIMDGroups (const Table<int> & candidates, bool single);
+    /// fy += s A fx for the elements of group g, or A^T for trans
+    void MultAddSIMD (size_t g, SCAL s, FlatVector<SCAL> fx, FlatVector<SCAL> fy, bool trans,
+                      FlatVector<SIMD<double>> hx, FlatVector<SIMD<double>> hy) const;
+    void MultAddCompressed (double s, const BaseVector & x, BaseVector & y, bool trans) const;
   public:
     ElementByElementMatrix (int h, int ane, bool isymmetric=false);
     ElementByElementMatrix (int h, int w, int ane, bool isymmetric=false);
@@ -71,6 +107,22 @@ namespace ngla
 			   const FlatArray<int> & dnums2,
 			   int refelnr);
 
+    /**
+       Rebuilds the storage for fast application, after all element
+       matrices are added. Elements are colored such that the elements of
+       one color share neither rows nor columns, MultAdd and MultTransAdd
+       then run without atomics. Equal sized element matrices of one color
+       are stored interleaved in SIMD lanes, in float if single is set.
+       With share_identical, elements with the same matrix (up to rounding,
+       e.g. translated elements) store it only once.
+       Elements in SIMD lanes have no GetElementMatrix, use MultAddElement.
+     */
+    void Compress (bool share_identical = false, bool single = false);
+    bool IsCompressed () const { return compressed; }
+
+    /// y += s A_elnr x, with the local vectors of the element
+    void MultAddElement (int elnr, SCAL s, FlatVector<SCAL> x, FlatVector<SCAL> y) const;
+
     virtual BaseVector & AsVector() 
     {
       throw Exception ("Cannot access ebe-matrix AsVector");
@@ -79,6 +131,8 @@ namespace ngla
 
     const FlatMatrix<SCAL> GetElementMatrix( int elnum ) const
     {
+      if (compressed && simd_index[elnum] >= 0)
+        throw Exception ("ebe-matrix: element matrix is stored in SIMD lanes, use MultAddElement");
       return elmats[elnum];
     }
 
@@ -110,6 +164,7 @@ namespace ngla
 
     size_t GetNZE () const
     {
+      if (compressed) return compressed_nze;
       size_t nze = 0;
       for (size_t i = 0; i < elmats.Size(); i++)
 	if (!clone.Test(i))
@@ -0,0 +1,146 @@
+/*********************************************************************/
+/* File:   floatmatrix.cpp                                           */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+/* 
+   Sparse matrix with single precision values
+*/
+
+#include <la.hpp>
+namespace ngla
+{
+
+  FloatSparseMatrix :: FloatSparseMatrix (const SparseMatrixTM<double> & mat)
+    : height(mat.Height()), width(mat.Width())
+  {
+    static Timer t("FloatSparseMatrix - ctor"); RegionTimer reg(t);
+
+    // the symmetric matrix stores only the lower triangle
+    bool symmetric = dynamic_cast<const SparseMatrixSymmetric<double>*> (&mat) != nullptr;
+
+    Array<int> rowlen(height);
+    rowlen = 0;
+    for (size_t i = 0; i < height; i++)
+      for (auto j : mat.GetRowIndices(i))
+        {
+          rowlen[i]++;
+          if (symmetric && j != i) rowlen[j]++;
+        }
+
+    firsti.SetSize (height+1);
+    firsti[0] = 0;
+    for (size_t i = 0; i < height; i++)
+      firsti[i+1] = firsti[i] + rowlen[i];
+    colnr.SetSize (firsti[height]);
+    values.SetSize (firsti[height]);
+
+    // row j gets its lower triangle when i = j, and the transposed
+    // entries from rows i > j later, so the columns stay sorted
+    rowlen = 0;
+    for (size_t i = 0; i < height; i++)
+      {
+        FlatArray<int> cols = mat.GetRowIndices(i);
+        FlatVector<double> vals = mat.GetRowValues(i);
+        for (size_t k = 0; k < cols.Size(); k++)
+          {
+            size_t j = cols[k];
+            size_t pos = firsti[i] + rowlen[i]++;
+            colnr[pos] = j;
+            values[pos] = vals(k);
+            if (symmetric && j != i)
+              {
+                size_t posj = firsti[j] + rowlen[j]++;
+                colnr[posj] = i;
+                values[posj] = vals(k);
+              }
+          }
+      }
+
+    diagpos.SetSize (height);
+    ParallelFor (height, [&] (size_t i)
+      {
+        diagpos[i] = size_t(-1);
+        for (size_t j = firsti[i]; j < firsti[i+1]; j++)
+          if (colnr[j] == int(i))
+            diagpos[i] = j;
+      });
+  }
+
+  
+  void FloatSparseMatrix :: MultAdd (double s, const BaseVector & x, BaseVector & y) const
+  {
+    static Timer t("FloatSparseMatrix::MultAdd"); RegionTimer reg(t);
+    t.AddFlops (values.Size());
+    
+    FlatVector<double> fx = x.FV<double>();
+    FlatVector<double> fy = y.FV<double>();
+
+    ParallelForRange
+      (height, [&] (IntRange r)
+       {
+         for (size_t i : r)
+           fy(i) += s * RowTimesVector (i, fx);
+       });
+  }
+
+  shared_ptr<BaseJacobiPrecond> FloatSparseMatrix :: CreateJacobiPrecond (shared_ptr<BitArray> inner) const
+  {
+    return make_shared<FloatJacobiPrecond> (*this, inner);
+  }
+  
+  Array<MemoryUsage> FloatSparseMatrix :: GetMemoryUsage () const
+  {
+    return { { "FloatSparseMatrix", values.Size()*(sizeof(float)+sizeof(int)) +
+          (firsti.Size()+diagpos.Size())*sizeof(size_t), 1 } };
+  }
+
+  shared_ptr<FloatSparseMatrix> ToFloat (const SparseMatrixTM<double> & mat)
+  {
+    return make_shared<FloatSparseMatrix> (mat);
+  }
+
+
+
+  FloatJacobiPrecond :: FloatJacobiPrecond (const FloatSparseMatrix & amat, shared_ptr<BitArray> ainner)
+    : mat(amat), inner(ainner), invdiag(amat.Height())
+  {
+    ParallelFor (invdiag.Size(), [&] (size_t i)
+      {
+        double d = mat.Diag(i);
+        invdiag[i] = (d != 0 && (!inner || inner->Test(i))) ? 1.0/d : 0.0;
+      });
+  }
+
+  void FloatJacobiPrecond :: MultAdd (double s, const BaseVector & x, BaseVector & y) const
+  {
+    static Timer t("FloatJacobiPrecond::MultAdd"); RegionTimer reg(t);
+    FlatVector<double> fx = x.FV<double>();
+    FlatVector<double> fy = y.FV<double>();
+    ParallelFor (invdiag.Size(), [&] (size_t i)
+      {
+        fy(i) += s * invdiag[i] * fx(i);
+      });
+  }
+  
+  void FloatJacobiPrecond :: GSSmooth (BaseVector & x, const BaseVector & b) const
+  {
+    static Timer t("FloatJacobiPrecond::GSSmooth"); RegionTimer reg(t);
+    FlatVector<double> fx = x.FV<double>();
+    FlatVector<double> fb = b.FV<double>();
+    for (size_t i = 0; i < invdiag.Size(); i++)
+      if (invdiag[i] != 0)
+        fx(i) += invdiag[i] * (fb(i) - mat.RowTimesVector (i, fx));
+  }
+
+  void FloatJacobiPrecond :: GSSmoothBack (BaseVector & x, const BaseVector & b) const
+  {
+    static Timer t("FloatJacobiPrecond::GSSmoothBack"); RegionTimer reg(t);
+    FlatVector<double> fx = x.FV<double>();
+    FlatVector<double> fb = b.FV<double>();
+    for (size_t i = invdiag.Size(); i-- > 0; )
+      if (invdiag[i] != 0)
+        fx(i) += invdiag[i] * (fb(i) - mat.RowTimesVector (i, fx));
+  }
+  
+}
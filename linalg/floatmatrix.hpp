@@ -0,0 +1,104 @@
+#ifndef FILE_NGS_FLOATMATRIX
+#define FILE_NGS_FLOATMATRIX
+
+/* ************************************************************************/
+/* File:   floatmatrix.hpp                                                */
+/* Date:   Oct. 2026                                                      */
+/* ************************************************************************/
+
+/*
+   Sparse matrix with single precision values
+*/
+
+namespace ngla
+{
+
+  /**
+     A copy of a real sparse matrix with entries stored in single precision.
+     Vectors stay double, products are accumulated in double. Intended for
+     preconditioner operators, where the precision is not needed but the
+     memory traffic of the matrix entries is.
+   */
+  class NGS_DLL_HEADER FloatSparseMatrix : public BaseMatrix
+  {
+    size_t height, width;
+    Array<size_t> firsti;
+    Array<int> colnr;
+    Array<float> values;
+    /// position of the diagonal entry in every row, -1 if there is none
+    Array<size_t> diagpos;
+
+  public:
+    /// copies the matrix, symmetric matrices are stored in full
+    FloatSparseMatrix (const SparseMatrixTM<double> & mat);
+
+    virtual bool IsComplex() const override { return false; }
+    virtual int VHeight() const override { return height; }
+    virtual int VWidth() const override { return width; }
+    virtual size_t NZE () const override { return values.Size(); }
+
+    FlatArray<int> GetRowIndices (size_t i) const
+    { return colnr.Range (firsti[i], firsti[i+1]); }
+    FlatArray<float> GetRowValues (size_t i) const
+    { return values.Range (firsti[i], firsti[i+1]); }
+    /// the diagonal entry of row i, 0 if not stored
+    double Diag (size_t i) const
+    { return (diagpos[i] != size_t(-1)) ? values[diagpos[i]] : 0.0; }
+    
+    /// row i times vector x
+    double RowTimesVector (size_t i, FlatVector<double> fx) const
+    {
+      double sum = 0;
+      for (size_t j = firsti[i]; j < firsti[i+1]; j++)
+        sum += double(values[j]) * fx(colnr[j]);
+      return sum;
+    }
+    
+    virtual AutoVector CreateVector () const override
+    { return make_shared<VVector<double>> (height); }
+    virtual AutoVector CreateRowVector () const override
+    { return make_shared<VVector<double>> (width); }
+    virtual AutoVector CreateColVector () const override
+    { return make_shared<VVector<double>> (height); }
+
+    virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const override;
+
+    /// Jacobi / Gauss-Seidel smoother reading the float entries
+    shared_ptr<BaseJacobiPrecond> CreateJacobiPrecond (shared_ptr<BitArray> inner = nullptr) const;
+
+    virtual Array<MemoryUsage> GetMemoryUsage () const override;
+  };
+
+
+  /**
+     Jacobi preconditioner and Gauss-Seidel smoother of a FloatSparseMatrix.
+   */
+  class NGS_DLL_HEADER FloatJacobiPrecond : public BaseJacobiPrecond
+  {
+    const FloatSparseMatrix & mat;
+    shared_ptr<BitArray> inner;
+    Array<double> invdiag;
+  public:
+    FloatJacobiPrecond (const FloatSparseMatrix & amat, shared_ptr<BitArray> ainner = nullptr);
+
+    virtual bool IsComplex() const override { return false; }
+    virtual int VHeight() const override { return invdiag.Size(); }
+    virtual int VWidth() const override { return invdiag.Size(); }
+    virtual AutoVector CreateVector () const override
+    { return make_shared<VVector<double>> (invdiag.Size()); }
+    
+    virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const override;
+    virtual void MultTransAdd (double s, const BaseVector & x, BaseVector & y) const override
+    { MultAdd (s, x, y); }
+
+    virtual void GSSmooth (BaseVector & x, const BaseVector & b) const override;
+    virtual void GSSmooth (BaseVector & x, const BaseVector & b, BaseVector & y) const override
+    { GSSmooth (x, b); }
+    virtual void GSSmoothBack (BaseVector & x, const BaseVector & b) const override;
+  };
+
+  /// single precision copy of a real sparse matrix
+  NGS_DLL_HEADER shared_ptr<FloatSparseMatrix> ToFloat (const SparseMatrixTM<double> & mat);
+}
+
+#endif
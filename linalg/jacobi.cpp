@@ -20,6 +20,7 @@ namespace ngla
 
     height = mat.Height();
     invdiag.SetSize (height); 
+    mem_invdiag.Set (invdiag.OwnedBytes());
 
     ParallelFor (height, [&](size_t i)
 		 {
@@ -78,18 +79,186 @@ namespace ngla
   }
 
 
+  template <class TM, class TV_ROW, class TV_COL>
+  void JacobiPrecond<TM,TV_ROW,TV_COL> :: CalcColoring ()
+  {
+    static Timer t("JacobiPrecond::CalcColoring"); RegionTimer reg(t);
+
+    // greedy coloring, 32 colors per sweep over the rows.
+    // row i occupies its own index and all its column indices
+    Array<int> rowcolor(height);
+    rowcolor = -1;
+    Array<unsigned int> mask(mat.Width());
+
+    size_t nrows = 0;
+    for (int i = 0; i < height; i++)
+      if (!inner || inner->Test(i))
+        nrows++;
+
+    int maxcolor = -1;
+    int basecol = 0;
+    size_t found = 0;
+    while (found < nrows)
+      {
+        mask = 0;
+        for (int i = 0; i < height; i++)
+          {
+            if (rowcolor[i] >= 0 || (inner && !inner->Test(i))) continue;
+
+            unsigned check = mask[i];
+            for (int j : mat.GetRowIndices(i))
+              check |= mask[j];
+            if (check == UINT_MAX) continue;
+
+            unsigned checkbit = 1;
+            int color = basecol;
+            while (check & checkbit)
+              {
+                color++;
+                checkbit *= 2;
+              }
+
+            rowcolor[i] = color;
+            maxcolor = max2 (maxcolor, color);
+            found++;
+
+            mask[i] |= checkbit;
+            for (int j : mat.GetRowIndices(i))
+              mask[j] |= checkbit;
+          }
+        basecol += 8*sizeof(unsigned int);
+      }
+
+    TableCreator<int> creator(maxcolor+1);
+    for ( ; !creator.Done(); creator++)
+      for (int i = 0; i < height; i++)
+        if (rowcolor[i] >= 0)
+          creator.Add (rowcolor[i], i);
+    coloring = creator.MoveTable();
+
+    color_balance.SetSize (coloring.Size());
+    for (auto c : Range(coloring))
+      color_balance[c].Calc (coloring[c].Size(),
+                             [&] (size_t i) { return mat.GetRowIndices(coloring[c][i]).Size(); });
+
+    cout << IM(4) << "Gauss-Seidel smoother using " << coloring.Size() << " colors" << endl;
+  }
+
+  template <class TM, class TV_ROW, class TV_COL>
+  void JacobiPrecond<TM,TV_ROW,TV_COL> :: SetGSOrder (GS_ORDER order)
+  {
+    gsorder = order;
+    if (order == GS_MULTICOLOR && coloring.Size() == 0)
+      CalcColoring();
+    if (order == GS_HYBRID)
+      hybrid_blocks.Calc (height, [&] (size_t i) { return mat.GetRowIndices(i).Size(); },
+                          TaskManager::GetNumThreads());
+  }
+
+  template <class TM, class TV_ROW, class TV_COL>
+  void JacobiPrecond<TM,TV_ROW,TV_COL> ::
+  GSSmoothHybrid (BaseVector & x, const BaseVector & b, bool backward) const
+  {
+    static Timer timer("JacobiPrecond::GSSmoothHybrid");
+    RegionTimer reg (timer);
+    AddSparseMatrixTraffic<TM,TV_ROW,TV_COL> (timer, mat, 1, false, 2);
+
+    auto res = mat.CreateColVector();
+    *res = b;
+    mat.MultAdd (-1, x, *res);
+
+    FlatVector<TV_ROW> fx = x.FV<TV_ROW> ();
+    FlatVector<TV_COL> fr = res.template FV<TV_COL> ();
+    size_t nblocks = hybrid_blocks.Size();
+
+    ParallelJob ([&] (TaskInfo ti)
+      {
+        for (size_t blocknr = ti.task_nr; blocknr < nblocks; blocknr += ti.ntasks)
+          {
+            IntRange block = hybrid_blocks[blocknr];
+            int first = block.First();
+            int next = block.Next();
+
+            // correction of this block, couplings to other blocks are ignored
+            Vector<TV_ROW> e(block.Size());
+            e = TV_ROW(0);
+
+            if (!backward)
+              for (int i = first; i < next; i++)
+                {
+                  if (inner && !inner->Test(i)) continue;
+                  FlatArray<int> cols = mat.GetRowIndices(i);
+                  FlatVector<TM> vals = mat.GetRowValues(i);
+                  TV_COL sum = fr(i);
+                  for (size_t k = 0; k < cols.Size(); k++)
+                    if (cols[k] >= first && cols[k] < i)
+                      sum -= vals(k) * e(cols[k]-first);
+                  e(i-first) = invdiag[i] * sum;
+                }
+            else if (!symmetric_storage)
+              for (int i = next-1; i >= first; i--)
+                {
+                  if (inner && !inner->Test(i)) continue;
+                  FlatArray<int> cols = mat.GetRowIndices(i);
+                  FlatVector<TM> vals = mat.GetRowValues(i);
+                  TV_COL sum = fr(i);
+                  for (size_t k = 0; k < cols.Size(); k++)
+                    if (cols[k] > i && cols[k] < next)
+                      sum -= vals(k) * e(cols[k]-first);
+                  e(i-first) = invdiag[i] * sum;
+                }
+            else
+              // the upper triangle is the transposed row, eliminate column-wise
+              for (int i = next-1; i >= first; i--)
+                {
+                  if (inner && !inner->Test(i)) continue;
+                  FlatArray<int> cols = mat.GetRowIndices(i);
+                  FlatVector<TM> vals = mat.GetRowValues(i);
+                  TV_ROW w = invdiag[i] * fr(i);
+                  e(i-first) = w;
+                  for (size_t k = 0; k < cols.Size(); k++)
+                    if (cols[k] >= first && cols[k] < i)
+                      fr(cols[k]) -= Trans(vals(k)) * w;
+                }
+
+            fx.Range(block) += e;
+          }
+      });
+  }
+
+
   ///
   template <class TM, class TV_ROW, class TV_COL>
   void JacobiPrecond<TM,TV_ROW,TV_COL> ::
   GSSmooth (BaseVector & x, const BaseVector & b) const 
   {
+    if (gsorder == GS_HYBRID)
+      {
+        GSSmoothHybrid (x, b, false);
+        return;
+      }
+
     static Timer timer("JacobiPrecond::GSSmooth");
     RegionTimer reg (timer);
-    timer.AddFlops (mat.NZE());
+    AddSparseMatrixTraffic<TM,TV_ROW,TV_COL> (timer, mat);
 
     FlatVector<TV_ROW> fx = x.FV<TV_ROW> ();
     const FlatVector<TV_ROW> fb = b.FV<TV_ROW> ();
 
+    if (gsorder == GS_MULTICOLOR)
+      {
+        for (int c : Range(coloring))
+          ParallelForRange (color_balance[c], [&] (IntRange r)
+            {
+              for (int i : coloring[c].Range(r))
+                {
+                  TV_ROW ax = mat.RowTimesVector (i, fx);
+                  fx(i) += invdiag[i] * (fb(i) - ax);
+                }
+            });
+        return;
+      }
+
     for (int i = 0; i < height; i++)
       if (!this->inner || this->inner->Test(i))
 	{
@@ -104,13 +273,33 @@ namespace ngla
   void JacobiPrecond<TM,TV_ROW,TV_COL> ::
   GSSmoothBack (BaseVector & x, const BaseVector & b) const 
   {
+    if (gsorder == GS_HYBRID)
+      {
+        GSSmoothHybrid (x, b, true);
+        return;
+      }
+
     static Timer timer("JacobiPrecond::GSSmoothBack");
     RegionTimer reg (timer);
-    timer.AddFlops (mat.NZE());
+    AddSparseMatrixTraffic<TM,TV_ROW,TV_COL> (timer, mat);
 
     FlatVector<TV_ROW> fx = x.FV<TV_ROW> ();
     const FlatVector<TV_ROW> fb = b.FV<TV_ROW> ();
 
+    if (gsorder == GS_MULTICOLOR)
+      {
+        for (int c = coloring.Size()-1; c >= 0; c--)
+          ParallelForRange (color_balance[c], [&] (IntRange r)
+            {
+              for (int i : coloring[c].Range(r))
+                {
+                  TV_ROW ax = mat.RowTimesVector (i, fx);
+                  fx(i) += invdiag[i] * (fb(i) - ax);
+                }
+            });
+        return;
+      }
+
     for (int i = height-1; i >= 0; i--)
       if (!this->inner || this->inner->Test(i))
 	{
@@ -138,7 +327,64 @@ namespace ngla
 			  shared_ptr<BitArray> ainner, bool use_par)
     : JacobiPrecond<TM,TV,TV> (amat, ainner, use_par)
   { 
-    ;
+    this->symmetric_storage = true;
+  }
+
+  template <class TM, class TV>
+  void JacobiPrecondSymmetric<TM,TV> ::
+  CalcPartialResiduum (const BaseVector & x, const BaseVector & b, BaseVector & y) const
+  {
+    const SparseMatrixSymmetric<TM,TV> & smat =
+      dynamic_cast<const SparseMatrixSymmetric<TM,TV>&> (this->mat);
+
+    // y = b - A x + L x
+    y = b;
+    smat.MultAdd (-1, x, y);
+
+    FlatVector<TVX> fx = x.FV<TVX> ();
+    FlatVector<TVX> fy = y.FV<TVX> ();
+    ParallelFor (this->height, [&] (size_t i)
+                 {
+                   fy(i) += smat.RowTimesVectorNoDiag (i, fx);
+                 });
+  }
+
+  template <class TM, class TV>
+  void JacobiPrecondSymmetric<TM,TV> ::
+  GSSmoothMulticolor (BaseVector & x, BaseVector & y, bool backward) const
+  {
+    static Timer timer("JacobiPrecondSymmetric::GSSmoothMulticolor");
+    RegionTimer reg (timer);
+    AddSparseMatrixTraffic<TM,TV,TV> (timer, this->mat, 1, true);
+
+    FlatVector<TVX> fx = x.FV<TVX> ();
+    FlatVector<TVX> fy = y.FV<TVX> ();
+
+    const SparseMatrixSymmetric<TM,TV> & smat =
+      dynamic_cast<const SparseMatrixSymmetric<TM,TV>&> (this->mat);
+
+    // rows of one color write to disjoint entries of y
+    auto smooth_color = [&] (int c)
+      {
+        ParallelForRange (this->color_balance[c], [&] (IntRange r)
+          {
+            for (int i : this->coloring[c].Range(r))
+              {
+                TVX d = fy(i) - smat.RowTimesVectorNoDiag (i, fx);
+                TVX w = this->invdiag[i] * d;
+
+                fx(i) += w;
+                smat.AddRowTransToVector (i, -w, fy);
+              }
+          });
+      };
+
+    if (!backward)
+      for (int c = 0; c < this->coloring.Size(); c++)
+        smooth_color (c);
+    else
+      for (int c = this->coloring.Size()-1; c >= 0; c--)
+        smooth_color (c);
   }
 
   ///
@@ -146,6 +392,19 @@ namespace ngla
   void JacobiPrecondSymmetric<TM,TV> ::
   GSSmooth (BaseVector & x, const BaseVector & b) const 
   {
+    if (this->gsorder == BaseJacobiPrecond::GS_HYBRID)
+      {
+        this->GSSmoothHybrid (x, b, false);
+        return;
+      }
+    if (this->gsorder == BaseJacobiPrecond::GS_MULTICOLOR)
+      {
+        auto y = b.CreateVector();
+        CalcPartialResiduum (x, b, *y);
+        GSSmoothMulticolor (x, *y, false);
+        return;
+      }
+
     static int timer = NgProfiler::CreateTimer ("JacobiPrecondSymmetric::GSSmooth");
     NgProfiler::RegionTimer reg (timer);
 
@@ -180,6 +439,18 @@ namespace ngla
   void JacobiPrecondSymmetric<TM,TV> ::
   GSSmooth (BaseVector & x, const BaseVector & b, BaseVector & y /* , BaseVector & help */) const 
   {
+    if (this->gsorder == BaseJacobiPrecond::GS_HYBRID)
+      {
+        this->GSSmoothHybrid (x, b, false);
+        CalcPartialResiduum (x, b, y);
+        return;
+      }
+    if (this->gsorder == BaseJacobiPrecond::GS_MULTICOLOR)
+      {
+        GSSmoothMulticolor (x, y, false);
+        return;
+      }
+
     static Timer timer("JacobiPrecondSymmetric::GSSmooth-help");
     RegionTimer reg (timer);
     
@@ -216,6 +487,19 @@ namespace ngla
   void JacobiPrecondSymmetric<TM,TV> ::
   GSSmoothBack (BaseVector & x, const BaseVector & b) const 
   {
+    if (this->gsorder == BaseJacobiPrecond::GS_HYBRID)
+      {
+        this->GSSmoothHybrid (x, b, true);
+        return;
+      }
+    if (this->gsorder == BaseJacobiPrecond::GS_MULTICOLOR)
+      {
+        auto y = b.CreateVector();
+        CalcPartialResiduum (x, b, *y);
+        GSSmoothMulticolor (x, *y, true);
+        return;
+      }
+
     static int timer = NgProfiler::CreateTimer ("JacobiPrecondSymmetric::GSSmoothBack");
     NgProfiler::RegionTimer reg (timer);
 
@@ -251,6 +535,18 @@ namespace ngla
   void JacobiPrecondSymmetric<TM,TV> ::
   GSSmoothBack (BaseVector & x, const BaseVector & b, BaseVector &y) const 
   {
+    if (this->gsorder == BaseJacobiPrecond::GS_HYBRID)
+      {
+        this->GSSmoothHybrid (x, b, true);
+        CalcPartialResiduum (x, b, y);
+        return;
+      }
+    if (this->gsorder == BaseJacobiPrecond::GS_MULTICOLOR)
+      {
+        GSSmoothMulticolor (x, y, true);
+        return;
+      }
+
     static Timer timer("JacobiPrecondSymmetric::GSSmoothBack-help");
     RegionTimer reg (timer);
   
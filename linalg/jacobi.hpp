@@ -18,6 +18,16 @@ namespace ngla
   class BaseJacobiPrecond : virtual public BaseMatrix
   {
   public:
+    /**
+       Order of the Gauss-Seidel sweeps:
+       sequential: all rows one after the other
+       multicolor: rows of one color of the matrix graph are relaxed in parallel
+       hybrid: Jacobi between thread-local row blocks, Gauss-Seidel within a block
+    */
+    enum GS_ORDER { GS_SEQUENTIAL, GS_MULTICOLOR, GS_HYBRID };
+
+    virtual void SetGSOrder (GS_ORDER order) { ; }
+
     virtual void GSSmooth (BaseVector & x, const BaseVector & b) const = 0;
     virtual void GSSmooth (BaseVector & x, const BaseVector & b, BaseVector & y /* , BaseVector & help */) const = 0;
     virtual void GSSmoothBack (BaseVector & x, const BaseVector & b) const = 0;
@@ -36,6 +46,21 @@ namespace ngla
     int height;
     ///
     Array<TM> invdiag;
+    /// registers invdiag, see MemoryRegistry
+    MemoryTracker mem_invdiag { MemoryRegistry::PRECONDITIONER };
+    ///
+    GS_ORDER gsorder = GS_SEQUENTIAL;
+    /// rows of one color share no matrix entry, neither row nor column
+    Table<int> coloring;
+    Array<Partitioning> color_balance;
+    /// row blocks of the hybrid smoother
+    Partitioning hybrid_blocks;
+    /// only the lower triangle is stored
+    bool symmetric_storage = false;
+
+    void CalcColoring ();
+    /// Gauss-Seidel on the row blocks, starting from the residual r = b - A x
+    void GSSmoothHybrid (BaseVector & x, const BaseVector & b, bool backward) const;
   public:
     // typedef typename mat_traits<TM>::TV_ROW TVX;
     typedef typename mat_traits<TM>::TSCAL TSCAL;
@@ -58,6 +83,8 @@ namespace ngla
     ///
     virtual AutoVector CreateVector () const;
     ///
+    virtual void SetGSOrder (GS_ORDER order);
+    ///
     virtual void GSSmooth (BaseVector & x, const BaseVector & b) const;
 
     /// computes partial residual y
@@ -87,6 +114,10 @@ namespace ngla
   template <class TM, class TV>
   class NGS_DLL_HEADER JacobiPrecondSymmetric : public JacobiPrecond<TM,TV,TV>
   {
+    /// y = b - (D+L^t) x
+    void CalcPartialResiduum (const BaseVector & x, const BaseVector & b, BaseVector & y) const;
+    /// relaxes the colors in forward or backward order, keeps y = b - (D+L^t) x
+    void GSSmoothMulticolor (BaseVector & x, BaseVector & y, bool backward) const;
   public:
     typedef TV TVX;
 
@@ -31,8 +31,12 @@ namespace ngla
 #include "paralleldofs.hpp"
 #include "basevector.hpp"
 #include "vvector.hpp"
+#include "multivector.hpp"
 #include "basematrix.hpp"
 #include "sparsematrix.hpp"
+#include "sellmatrix.hpp"
+#include "deltaindexmatrix.hpp"
+#include "blockedsparsematrix.hpp"
 #include "order.hpp"
 #include "sparsecholesky.hpp"
 #include "pardisoinverse.hpp"
@@ -41,6 +45,9 @@ namespace ngla
 // #include "superluinverse.hpp"
 // #include "mumpsinverse.hpp"
 #include "jacobi.hpp"
+#include "floatmatrix.hpp"
+#include "snapshotstore.hpp"
+#include "sharedvector.hpp"
 #include "blockjacobi.hpp"
 #include "commutingAMG.hpp"
 #include "special_matrix.hpp"
@@ -1,14 +1,251 @@
+// all vector kernels use grid-stride loops with the same launch configuration
+constexpr int vec_blocks = 512;
+constexpr int vec_threads = 256;
+
 __global__ void SetScalarKernel (double val, int n, double * dev_ptr)
 {
-  int tid = threadIdx.x;
-  for (int i = tid; i < n; i += blockDim.x)
+  int tid = blockIdx.x*blockDim.x+threadIdx.x;
+  for (int i = tid; i < n; i += blockDim.x*gridDim.x)
     dev_ptr[i] = val;
 }
 
 
 void SetScalar (double val, int n, double * dev_ptr)
 {
-  SetScalarKernel<<<1,128>>> (val, n, dev_ptr);
-} 
+  SetScalarKernel<<<vec_blocks,vec_threads>>> (val, n, dev_ptr);
+}
+
+
+
+
+__global__ void ScaleRowsKernel (int nrows, int w, const double * d, const double * b, double * db)
+{
+  int tid = blockIdx.x*blockDim.x+threadIdx.x;
+  for (int i = tid; i < nrows*w; i += blockDim.x*gridDim.x)
+    db[i] = d[i/w] * b[i];
+}
+
+// db(i,j) = d(i) * b(i,j), all matrices row-major with width w
+void ScaleRows (int nrows, int w, const double * d, const double * b, double * db)
+{
+  ScaleRowsKernel<<<512,256>>> (nrows, w, d, b, db);
+}
+
+
+
+
+__global__ void AxpbyKernel (int n, double a, const double * x, double b, double * y)
+{
+  int tid = blockIdx.x*blockDim.x+threadIdx.x;
+  if (b == 0)
+    for (int i = tid; i < n; i += blockDim.x*gridDim.x)
+      y[i] = a * x[i];
+  else
+    for (int i = tid; i < n; i += blockDim.x*gridDim.x)
+      y[i] = a * x[i] + b * y[i];
+}
+
+// y = a x + b y, y is not read for b = 0
+void Axpby (int n, double a, const double * x, double b, double * y)
+{
+  AxpbyKernel<<<vec_blocks,vec_threads>>> (n, a, x, b, y);
+}
+
+
+__global__ void DiagMultKernel (int n, double s, const double * d, const double * x,
+                                double * y, bool add)
+{
+  int tid = blockIdx.x*blockDim.x+threadIdx.x;
+  for (int i = tid; i < n; i += blockDim.x*gridDim.x)
+    if (add)
+      y[i] += s * d[i] * x[i];
+    else
+      y[i] = s * d[i] * x[i];
+}
+
+// y = s diag(d) x, or y += s diag(d) x
+void DiagMult (int n, double s, const double * d, const double * x, double * y, bool add)
+{
+  DiagMultKernel<<<vec_blocks,vec_threads>>> (n, s, d, x, y, add);
+}
+
+
+
+
+// sums up the vec_threads values of sum in sum[0]
+__device__ void BlockSum (double * sum)
+{
+  __syncthreads();
+  for (int k = blockDim.x/2; k > 0; k /= 2)
+    {
+      if (threadIdx.x < k)
+        sum[threadIdx.x] += sum[threadIdx.x+k];
+      __syncthreads();
+    }
+}
+
+__global__ void DotPartialKernel (int n, const double * x, const double * y, double * partial)
+{
+  __shared__ double sum[vec_threads];
+  double s = 0;
+  int tid = blockIdx.x*blockDim.x+threadIdx.x;
+  for (int i = tid; i < n; i += blockDim.x*gridDim.x)
+    s += x[i] * y[i];
+  sum[threadIdx.x] = s;
+  BlockSum (sum);
+  if (threadIdx.x == 0)
+    partial[blockIdx.x] = sum[0];
+}
+
+__global__ void SumKernel (int n, const double * partial, double * res)
+{
+  __shared__ double sum[vec_threads];
+  double s = 0;
+  for (int i = threadIdx.x; i < n; i += blockDim.x)
+    s += partial[i];
+  sum[threadIdx.x] = s;
+  BlockSum (sum);
+  if (threadIdx.x == 0)
+    *res = sum[0];
+}
+
+/*
+  *res = (x,y), the result stays on the device. work holds the partial
+  sums of the blocks (vec_blocks doubles). The second stage sums them in
+  a fixed order, the result does not depend on scheduling.
+*/
+void DevDot (int n, const double * x, const double * y, double * res, double * work)
+{
+  DotPartialKernel<<<vec_blocks,vec_threads>>> (n, x, y, work);
+  SumKernel<<<1,vec_threads>>> (vec_blocks, work, res);
+}
+
+
+
+
+/*
+  Kernels of the device-resident conjugate gradient method. The step
+  sizes are quotients of inner products in device memory, they are
+  never seen by the host.
+*/
+__global__ void CGUpdateKernel (int n, const double * num, const double * den,
+                                const double * s, const double * as, double * u, double * r)
+{
+  double alpha = (*den != 0) ? *num / *den : 0;
+  int tid = blockIdx.x*blockDim.x+threadIdx.x;
+  for (int i = tid; i < n; i += blockDim.x*gridDim.x)
+    {
+      u[i] += alpha * s[i];
+      r[i] -= alpha * as[i];
+    }
+}
+
+// u += alpha s, r -= alpha as, with alpha = num/den
+void CGUpdate (int n, const double * num, const double * den,
+               const double * s, const double * as, double * u, double * r)
+{
+  CGUpdateKernel<<<vec_blocks,vec_threads>>> (n, num, den, s, as, u, r);
+}
+
+__global__ void CGDirectionKernel (int n, const double * num, const double * den,
+                                   const double * w, double * s)
+{
+  double beta = (*den != 0) ? *num / *den : 0;
+  int tid = blockIdx.x*blockDim.x+threadIdx.x;
+  for (int i = tid; i < n; i += blockDim.x*gridDim.x)
+    s[i] = w[i] + beta * s[i];
+}
+
+// s = w + beta s, with beta = num/den
+void CGDirection (int n, const double * num, const double * den,
+                  const double * w, double * s)
+{
+  CGDirectionKernel<<<vec_blocks,vec_threads>>> (n, num, den, w, s);
+}
+
+
+
+
+#if defined(__CUDA_ARCH__) && __CUDA_ARCH__ < 600
+// double atomicAdd is native from sm_60 on
+__device__ double atomicAdd (double * address, double val)
+{
+  unsigned long long int * addr = (unsigned long long int*)address;
+  unsigned long long int old = *addr, assumed;
+  do
+    {
+      assumed = old;
+      old = atomicCAS (addr, assumed,
+                       __double_as_longlong (val + __longlong_as_double(assumed)));
+    }
+  while (assumed != old);
+  return __longlong_as_double (old);
+}
+#endif
+
+__global__ void DevScatterAddKernel (int n, double s, const int * pos, const double * elvals, double * vals)
+{
+  int tid = blockIdx.x*blockDim.x+threadIdx.x;
+  for (int i = tid; i < n; i += blockDim.x*gridDim.x)
+    if (pos[i] >= 0)
+      atomicAdd (vals+pos[i], s * elvals[i]);
+}
+
+/*
+  vals[pos[i]] += s * elvals[i] for all entries of a batch of element
+  matrices or vectors, entries with pos[i] = -1 are skipped. Elements
+  sharing dofs add concurrently, no coloring is needed.
+*/
+void DevScatterAdd (int n, double s, const int * pos, const double * elvals, double * vals)
+{
+  DevScatterAddKernel<<<vec_blocks,vec_threads>>> (n, s, pos, elvals, vals);
+}
+
+__global__ void DevGatherKernel (int n, const int * pos, const double * vals, double * elvals)
+{
+  int tid = blockIdx.x*blockDim.x+threadIdx.x;
+  for (int i = tid; i < n; i += blockDim.x*gridDim.x)
+    elvals[i] = (pos[i] >= 0) ? vals[pos[i]] : 0.0;
+}
+
+// elvals[i] = vals[pos[i]], 0 for pos[i] = -1
+void DevGather (int n, const int * pos, const double * vals, double * elvals)
+{
+  DevGatherKernel<<<vec_blocks,vec_threads>>> (n, pos, vals, elvals);
+}
+
+__global__ void DevSetIndirectKernel (int n, const int * pos, double val, double * vals)
+{
+  int tid = blockIdx.x*blockDim.x+threadIdx.x;
+  for (int i = tid; i < n; i += blockDim.x*gridDim.x)
+    vals[pos[i]] = val;
+}
+
+// vals[pos[i]] = val
+void DevSetIndirect (int n, const int * pos, double val, double * vals)
+{
+  DevSetIndirectKernel<<<vec_blocks,vec_threads>>> (n, pos, val, vals);
+}
+
+
 
 
+__global__ void ChebyshevUpdateKernel (int n, double c1, double c2, const double * diaginv,
+                                       const double * r, double * d, double * x)
+{
+  int tid = blockIdx.x*blockDim.x+threadIdx.x;
+  for (int i = tid; i < n; i += blockDim.x*gridDim.x)
+    {
+      double di = c2 * diaginv[i] * r[i];
+      if (c1 != 0) di += c1 * d[i];
+      d[i] = di;
+      x[i] += di;
+    }
+}
+
+// d = c1 d + c2 diag(diaginv) r, x += d, d is not read for c1 = 0
+void ChebyshevUpdate (int n, double c1, double c2, const double * diaginv,
+                      const double * r, double * d, double * x)
+{
+  ChebyshevUpdateKernel<<<vec_blocks,vec_threads>>> (n, c1, c2, diaginv, r, d, x);
+}
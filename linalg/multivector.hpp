@@ -0,0 +1,47 @@
+#ifndef FILE_NGS_MULTIVECTOR
+#define FILE_NGS_MULTIVECTOR
+
+/* ************************************************************************/
+/* File:   multivector.hpp                                                */
+/* Date:   Oct. 2026                                                      */
+/* ************************************************************************/
+
+namespace ngla
+{
+
+  /**
+     k real vectors of length n, stored as one n x k row-major matrix.
+     Matrix-multivector products read the matrix once for all k vectors.
+   */
+  class MultiVector
+  {
+    Matrix<double> vecs;
+  public:
+    MultiVector (size_t n, size_t k) : vecs(n, k) { vecs = 0.0; }
+
+    /// length of the vectors
+    size_t Size () const { return vecs.Height(); }
+    /// number of vectors
+    size_t NumVectors () const { return vecs.Width(); }
+
+    /// entry i of vector j is (i,j)
+    FlatMatrix<double> FM () const { return vecs; }
+    
+    void SetZero () { vecs = 0.0; }
+
+    /// copies vector j to v
+    void GetVector (size_t j, BaseVector & v) const
+    {
+      v.FV<double>() = vecs.Col(j);
+    }
+    
+    /// copies v to vector j
+    void SetVector (size_t j, const BaseVector & v)
+    {
+      vecs.Col(j) = v.FV<double>();
+    }
+  };
+
+}
+
+#endif
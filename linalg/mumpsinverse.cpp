@@ -27,6 +27,160 @@ namespace ngla
 #define USE_COMM_WORLD -987654
 
   
+  template <class TM, class TV_ROW, class TV_COL>
+  void MumpsInverse<TM,TV_ROW,TV_COL> :: 
+  GetMumpsMatrix (const SparseMatrix<TM,TV_ROW,TV_COL> & a)
+  {
+    height = a.Height() * entrysize;
+    
+    Array<int> colstart(height+1);
+    Array<int> counter(height);
+    counter = 0;
+    colstart = 0;
+    
+    if ( symmetric )
+      {
+	cout << "copy matrix symmetric" << endl;
+	
+	col_indices.SetSize (a.NZE() * entrysize * entrysize);
+	row_indices.SetSize (a.NZE() * entrysize * entrysize);
+	matrix.SetSize (a.NZE() * entrysize * entrysize);
+	
+	int ii = 0;
+	for (int i = 0; i < a.Height(); i++ )
+	  {
+	    FlatArray<int> rowind = a.GetRowIndices(i);
+
+	    for (int j = 0; j < rowind.Size(); j++ )
+	      {
+		int col = rowind[j];
+		
+		if (  (!inner && !cluster) ||
+		      (inner && (inner->Test(i) && inner->Test(col) ) ) ||
+		      (!inner && cluster &&
+		       ((*cluster)[i] == (*cluster)[col] 
+			&& (*cluster)[i] ))  )
+		  {
+		    TM entry = a(i,col);
+		    for (int l = 0; l < entrysize; l++ )
+		      for (int k = 0; k < entrysize; k++)
+			{
+			  int rowi = i*entrysize+l+1;
+			  int coli = col*entrysize+k+1;
+			  TSCAL val = Access(entry,l,k);
+
+			  if (rowi >= coli)
+			    {
+			      col_indices[ii] = coli;
+			      row_indices[ii] = rowi;
+			      matrix[ii] = val;
+			      ii++;
+			    }
+			}
+		  }
+		else if (i == col)
+		  {
+		    // in the case of 'inner' or 'cluster': 1 on the diagonal for
+		    // unused dofs.
+		    for (int l=0; l<entrysize; l++ )
+		      {
+			col_indices[ii] = col*entrysize+l+1;
+			row_indices[ii] = col*entrysize+l+1;
+			matrix[ii] = 1;
+			ii++;
+		      }
+		  }
+	      }
+	  }
+	nze = ii;
+      }
+    else
+      {
+	cout << "copy matrix non-symmetric" << endl;
+	// --- transform matrix to compressed column storage format ---
+
+	// 1.) build array 'colstart':
+	// (a) get nr. of entries for each col
+	for (int i = 0; i < a.Height(); i++ )
+	  {
+	    for (int j = 0; j < a.GetRowIndices(i).Size(); j++ )
+	      {
+		int col = a.GetRowIndices(i)[j];
+	    
+		if (  (!inner && !cluster) ||
+		      (inner && (inner->Test(i) && inner->Test(col) ) ) ||
+		      (!inner && cluster && 
+		       ((*cluster)[i] == (*cluster)[col] 
+			&& (*cluster)[i] ))  )
+		  {
+		    for (int k=0; k<entrysize; k++ )
+		      colstart[col*entrysize+k+1] += entrysize;
+		  }
+		else if ( i == col )
+		  {
+		    for (int k=0; k<entrysize; k++ )
+		      colstart[col*entrysize+k+1] ++;
+		  }
+	      }
+	  }
+
+	// (b) accumulate
+	colstart[0] = 0;
+	for (int i = 1; i <= height; i++ ) colstart[i] += colstart[i-1];
+	nze = colstart[height];
+
+
+	// 2.) build whole matrix:
+	col_indices.SetSize (a.NZE() * entrysize * entrysize);
+	row_indices.SetSize (a.NZE() * entrysize * entrysize);
+	matrix.SetSize (a.NZE() * entrysize * entrysize);
+
+	for (int i = 0; i < a.Height(); i++ )
+	  {
+	    for (int j = 0; j<a.GetRowIndices(i).Size(); j++ )
+	      {
+		int col = a.GetRowIndices(i)[j];
+
+		if (  (!inner && !cluster) ||
+		      (inner && (inner->Test(i) && inner->Test(col) ) ) ||
+		      (!inner && cluster &&
+		       ((*cluster)[i] == (*cluster)[col] 
+			&& (*cluster)[i] ))  )
+		  {
+		    TM entry = a(i,col);
+		    for (int k = 0; k < entrysize; k++)
+		      for (int l = 0; l < entrysize; l++ )
+			{
+			  row_indices[ colstart[col*entrysize+k]+
+				       counter[col*entrysize+k] ] = i*entrysize+l + 1;
+			  col_indices[ colstart[col*entrysize+k]+
+				       counter[col*entrysize+k] ] = col*entrysize+k + 1;
+			  matrix[ colstart[col*entrysize+k]+
+				  counter[col*entrysize+k] ] = Access(entry,l,k);
+			  counter[col*entrysize+k]++;
+			}
+		  }
+		else if (i == col)
+		  {
+		    // in the case of 'inner' or 'cluster': 1 on the diagonal for
+		    // unused dofs.
+		    for (int l=0; l<entrysize; l++ )
+		      {
+			col_indices[ colstart[col*entrysize+l]+
+				     counter[col*entrysize+l] ] = col*entrysize+l + 1;
+			row_indices[ colstart[col*entrysize+l]+
+				     counter[col*entrysize+l] ] = col*entrysize+l + 1;
+			matrix[ colstart[col*entrysize+l]+
+				counter[col*entrysize+l] ] = 1;
+			counter[col*entrysize+l]++;
+		      }
+		  }
+	      }
+	  }
+      }
+  }
+
+
   template <class TM, class TV_ROW, class TV_COL>
   MumpsInverse<TM,TV_ROW,TV_COL> :: 
   MumpsInverse (const SparseMatrix<TM,TV_ROW,TV_COL> & a, 
@@ -69,167 +223,14 @@ namespace ngla
     iscomplex = mat_traits<TM>::IS_COMPLEX;
 
 
-    int * colstart = 0;
-    int * counter = 0;
-    int * col_indices = 0, * row_indices = 0;
-    TSCAL * matrix = 0;
-
-    if (id == 0)
+    try
       {
-	height = a.Height() * entrysize;
-	
-	int * colstart = new int[height+1];
-	int * counter = new int[height];
-	
-	for ( int i = 0; i < height; i++ ) 
-	  counter[i] = 0;
-
-	for ( int i = 0; i < height; i++ ) 
-	  colstart[i+1] = 0;
-	
-	if ( symmetric )
-	  {
-	    cout << "copy matrix symmetric" << endl;
-	    
-	    col_indices = new int[a.NZE() * entrysize * entrysize ];
-	    row_indices = new int[a.NZE() * entrysize * entrysize ];
-	    matrix = new TSCAL[a.NZE() * entrysize * entrysize ];      
-	    
-	    int ii = 0;
-	    for (int i = 0; i < a.Height(); i++ )
-	      {
-		FlatArray<int> rowind = a.GetRowIndices(i);
-
-		for (int j = 0; j < rowind.Size(); j++ )
-		  {
-		    int col = rowind[j];
-		    
-		    if (  (!inner && !cluster) ||
-			  (inner && (inner->Test(i) && inner->Test(col) ) ) ||
-			  (!inner && cluster &&
-			   ((*cluster)[i] == (*cluster)[col] 
-			    && (*cluster)[i] ))  )
-		      {
-			TM entry = a(i,col);
-			for (int l = 0; l < entrysize; l++ )
-			  for (int k = 0; k < entrysize; k++)
-			    {
-			      int rowi = i*entrysize+l+1;
-			      int coli = col*entrysize+k+1;
-			      TSCAL val = Access(entry,l,k);
-
-			      if (rowi >= coli)
-				{
-				  col_indices[ii] = coli;
-				  row_indices[ii] = rowi;
-				  matrix[ii] = val;
-				  ii++;
-				}
-			    }
-		      }
-		    else if (i == col)
-		      {
-			// in the case of 'inner' or 'cluster': 1 on the diagonal for
-			// unused dofs.
-			for (int l=0; l<entrysize; l++ )
-			  {
-			    col_indices[ii] = col*entrysize+l+1;
-			    row_indices[ii] = col*entrysize+l+1;
-			    matrix[ii] = 1;
-			    ii++;
-			  }
-		      }
-		  }
-	      }
-	    nze = ii;
-	  }
-	else
-	  {
-	    cout << "copy matrix non-symmetric" << endl;
-	    // --- transform matrix to compressed column storage format ---
-
-	    // 1.) build array 'colstart':
-	    // (a) get nr. of entries for each col
-	    for (int i = 0; i < a.Height(); i++ )
-	      {
-		for (int j = 0; j < a.GetRowIndices(i).Size(); j++ )
-		  {
-		    int col = a.GetRowIndices(i)[j];
-                
-		    if (  (!inner && !cluster) ||
-			  (inner && (inner->Test(i) && inner->Test(col) ) ) ||
-			  (!inner && cluster && 
-			   ((*cluster)[i] == (*cluster)[col] 
-			    && (*cluster)[i] ))  )
-		      {
-			for (int k=0; k<entrysize; k++ )
-			  colstart[col*entrysize+k+1] += entrysize;
-		      }
-		    else if ( i == col )
-		      {
-			for (int k=0; k<entrysize; k++ )
-			  colstart[col*entrysize+k+1] ++;
-		      }
-		  }
-	      }
-
-	    // (b) accumulate
-	    colstart[0] = 0;
-	    for (int i = 1; i <= height; i++ ) colstart[i] += colstart[i-1];
-	    nze = colstart[height];
-
-
-	    // 2.) build whole matrix:
-	    col_indices = new int[a.NZE() * entrysize * entrysize ];
-	    row_indices = new int[a.NZE() * entrysize * entrysize ];
-	    matrix = new TSCAL[a.NZE() * entrysize * entrysize ];      
-
-	    for (int i = 0; i < a.Height(); i++ )
-	      {
-		for (int j = 0; j<a.GetRowIndices(i).Size(); j++ )
-		  {
-		    int col = a.GetRowIndices(i)[j];
-
-		    if (  (!inner && !cluster) ||
-			  (inner && (inner->Test(i) && inner->Test(col) ) ) ||
-			  (!inner && cluster &&
-			   ((*cluster)[i] == (*cluster)[col] 
-			    && (*cluster)[i] ))  )
-		      {
-			TM entry = a(i,col);
-			for (int k = 0; k < entrysize; k++)
-			  for (int l = 0; l < entrysize; l++ )
-			    {
-			      row_indices[ colstart[col*entrysize+k]+
-					   counter[col*entrysize+k] ] = i*entrysize+l + 1;
-			      col_indices[ colstart[col*entrysize+k]+
-					   counter[col*entrysize+k] ] = col*entrysize+k + 1;
-			      matrix[ colstart[col*entrysize+k]+
-				      counter[col*entrysize+k] ] = Access(entry,l,k);
-			      counter[col*entrysize+k]++;
-			    }
-		      }
-		    else if (i == col)
-		      {
-			// in the case of 'inner' or 'cluster': 1 on the diagonal for
-			// unused dofs.
-			for (int l=0; l<entrysize; l++ )
-			  {
-			    col_indices[ colstart[col*entrysize+l]+
-					 counter[col*entrysize+l] ] = col*entrysize+l + 1;
-			    row_indices[ colstart[col*entrysize+l]+
-					 counter[col*entrysize+l] ] = col*entrysize+l + 1;
-			    matrix[ colstart[col*entrysize+l]+
-				    counter[col*entrysize+l] ] = 1;
-			    counter[col*entrysize+l]++;
-			  }
-		      }
-		  }
-	      }
-	  }
+        matrix_ptr = const_cast<SparseMatrix<TM,TV_ROW,TV_COL>&>(a).template SharedFromThis<BaseSparseMatrix>();
       }
+    catch (bad_weak_ptr &) { ; }  // no Update for matrices not owned by a shared_ptr
 
-
+    if (id == 0)
+      GetMumpsMatrix (a);
 
 
     for (int i = 0; i < 40; i++)
@@ -249,8 +250,8 @@ namespace ngla
     /* Define the problem on the host */
     mumps_id.n   = height; 
     mumps_id.nz  = nze;
-    mumps_id.irn = row_indices;
-    mumps_id.jcn = col_indices;
+    mumps_id.irn = row_indices.Size() ? &row_indices[0] : nullptr;
+    mumps_id.jcn = col_indices.Size() ? &col_indices[0] : nullptr;
 
     /*
       if (id == 0)
@@ -292,7 +293,7 @@ namespace ngla
 
 
 
-    mumps_id.a   = (typename mumps_trait<TSCAL>::MUMPS_TSCAL*)matrix; 
+    mumps_id.a   = (typename mumps_trait<TSCAL>::MUMPS_TSCAL*) (matrix.Size() ? &matrix[0] : nullptr); 
 
     mumps_id.job = JOB_FACTOR;
     
@@ -327,15 +328,37 @@ namespace ngla
     
     if (id == 0)
       cout << " done " << endl;
-    delete [] colstart;
-    delete [] counter;
-    // delete [] rhs;    
+    VT_ON();
+  }
+  
+
+  template <class TM, class TV_ROW, class TV_COL>
+  void MumpsInverse<TM,TV_ROW,TV_COL> :: Update ()
+  {
+    static Timer timer ("Mumps Inverse - update");
+    RegionTimer reg (timer);
 
+    if (MyMPI_GetId() == 0)
+      {
+        auto amat = dynamic_pointer_cast<SparseMatrix<TM,TV_ROW,TV_COL>> (matrix_ptr.lock());
+        if (!amat)
+          throw Exception("MumpsInverse::Update: matrix is gone");
+
+        // same graph, so the arrays keep their memory and the analysis stays valid
+        int oldnze = nze;
+        GetMumpsMatrix (*amat);
+        if (nze != oldnze)
+          throw Exception("MumpsInverse::Update: matrix graph has changed");
+      }
 
-    delete [] col_indices;
-    delete [] row_indices;
-    delete [] matrix;
-    VT_ON();
+    mumps_id.job = JOB_FACTOR;
+    mumps_trait<TSCAL>::MumpsFunction (&mumps_id);
+
+    if (mumps_id.infog[0] != 0)
+      {
+	cout << "error-code = " << mumps_id.infog[0] << endl;
+        throw Exception("MumpsInverse: Update failed.");
+      }
   }
   
   
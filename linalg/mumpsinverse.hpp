@@ -68,6 +68,13 @@ namespace ngla
     shared_ptr<BitArray> inner;
     shared_ptr<const Array<int>> cluster;
 
+    /// matrix in coordinate format, kept for the refactorization
+    Array<int> row_indices, col_indices;
+    Array<TSCAL> matrix;
+    weak_ptr<BaseSparseMatrix> matrix_ptr;
+
+    void GetMumpsMatrix (const SparseMatrix<TM,TV_ROW,TV_COL> & a);
+
   public:
     ///
     MumpsInverse (const SparseMatrix<TM,TV_ROW,TV_COL> & a, 
@@ -88,6 +95,9 @@ namespace ngla
     ///
     virtual void Mult (const BaseVector & x, BaseVector & y) const;
 
+    /// new values on the same graph: the analysis is kept, only factor again
+    virtual void Update();
+
     ///
     virtual AutoVector CreateVector () const
     {
@@ -570,6 +570,11 @@ namespace ngla
 
 
   void MinimumDegreeOrdering :: Order()
+  {
+    Order (FlatArray<int> (0, nullptr));
+  }
+
+  void MinimumDegreeOrdering :: Order (FlatArray<int> sequence)
   {
     static Timer reorder_timer("MinimumDegreeOrdering::Order");
     RegionTimer reg(reorder_timer);
@@ -590,6 +595,7 @@ namespace ngla
     if (n > 5000)
       cout << IM(4) << "order " << flush;
 
+    size_t next = 0;
     int locked_dofs = 0;
     for (int i = 0; i < n; i++)
       if (vertices[i].Eliminated())                
@@ -621,6 +627,19 @@ namespace ngla
 	    EliminateSlaveVertex (minj);
 	  }
 
+	else if (sequence.Size())
+	  {
+	    // next vertex of the sequence, indistinguishable vertices
+	    // are eliminated together with their master
+	    while (vertices[sequence[next]].Eliminated())
+	      next++;
+	    minj = vertices[sequence[next]].Master();
+	    priqueue.Invalidate(minj);
+
+	    blocknr[i] = i;
+	    EliminateMasterVertex (minj);
+	  }
+
 	else
 	  {
 	    // find new master vertex
@@ -648,6 +667,127 @@ namespace ngla
 
 
 
+  Array<int> NestedDissection (const Table<int> & graph,
+                               const BitArray & used,
+                               int leafsize)
+  {
+    static Timer t("NestedDissection"); RegionTimer reg(t);
+
+    int n = graph.Size();
+    Array<int> order;
+    order.SetAllocSize (n);
+
+    Array<int> domain(n), visited(n), level(n);
+    domain = -1;
+    visited = -1;
+    int ndomains = 0, nsearches = 0;
+
+    // sets still to be numbered, a stack of vertex lists.
+    // separators are numbered as they are, other sets are split further
+    Array<int> stack, firstonstack;
+    Array<bool> isseparator;
+    auto push = [&] (bool separator)
+      {
+        firstonstack.Append (stack.Size());
+        isseparator.Append (separator);
+      };
+
+    push (false);
+    for (int i = 0; i < n; i++)
+      if (used.Test(i))
+        stack.Append (i);
+
+    // breadth first search within the current domain
+    Array<int> queue, firstinlevel;
+    auto bfs = [&] (int start)
+      {
+        nsearches++;
+        queue.SetSize0();
+        firstinlevel.SetSize0();
+        queue.Append (start);
+        visited[start] = nsearches;
+        level[start] = 0;
+        for (size_t i = 0; i < queue.Size(); i++)
+          {
+            int v = queue[i];
+            if (level[v] == firstinlevel.Size())
+              firstinlevel.Append (i);
+            for (int w : graph[v])
+              if (domain[w] == ndomains && visited[w] != nsearches)
+                {
+                  visited[w] = nsearches;
+                  level[w] = level[v]+1;
+                  queue.Append (w);
+                }
+          }
+        firstinlevel.Append (queue.Size());
+      };
+
+    Array<int> verts;
+    while (firstonstack.Size())
+      {
+        size_t first = firstonstack.Last();
+        bool separator = isseparator.Last();
+        firstonstack.DeleteLast();
+        isseparator.DeleteLast();
+        verts = stack.Range (first, stack.Size());
+        stack.SetSize (first);
+
+        if (separator)
+          {
+            order += verts;
+            continue;
+          }
+        if (verts.Size() == 0) continue;
+
+        ndomains++;
+        for (int v : verts)
+          domain[v] = ndomains;
+
+        // pseudo-peripheral vertex
+        bfs (verts[0]);
+        for (int k = 0; k < 3; k++)
+          {
+            size_t nlevels = firstinlevel.Size();
+            bfs (queue.Last());
+            if (firstinlevel.Size() <= nlevels) break;
+          }
+
+        // not reached vertices belong to other components, numbered afterwards
+        if (queue.Size() < verts.Size())
+          {
+            push (false);
+            for (int v : verts)
+              if (visited[v] != nsearches)
+                stack.Append (v);
+          }
+
+        int nlevels = firstinlevel.Size()-1;
+        if (queue.Size() <= leafsize || nlevels < 3)
+          {
+            for (int i = queue.Size()-1; i >= 0; i--)
+              order.Append (queue[i]);
+            continue;
+          }
+
+        // the median level separates the lower from the upper levels
+        int sep = 1;
+        while (sep < nlevels-2 && firstinlevel[sep+1] < queue.Size()/2)
+          sep++;
+
+        push (true);
+        stack += queue.Range (firstinlevel[sep], firstinlevel[sep+1]);
+        push (false);
+        stack += queue.Range (firstinlevel[sep+1], queue.Size());
+        push (false);
+        stack += queue.Range (0, firstinlevel[sep]);
+      }
+
+    return order;
+  }
+
+
+
   MinimumDegreeOrdering:: ~MinimumDegreeOrdering ()
   {
     // cout << "~MDO: all data should be deleted, please double-check" << endl;
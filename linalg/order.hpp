@@ -152,6 +152,8 @@ namespace ngla
     void EliminateSlaveVertex (int v);
     ///
     void Order();
+    /// eliminate in the given sequence of vertices instead of by minimal degree
+    void Order (FlatArray<int> sequence);
     /// 
     ~MinimumDegreeOrdering();
 
@@ -199,6 +201,17 @@ namespace ngla
   };
 
 
+  /**
+     Nested dissection ordering of the used vertices of the graph.
+     Connected sets are split by the median level of a breadth first
+     search from a pseudo-peripheral vertex, the separator is numbered
+     after both halves. Sets up to leafsize vertices are not split.
+   */
+  NGS_DLL_HEADER Array<int> NestedDissection (const Table<int> & graph,
+                                              const BitArray & used,
+                                              int leafsize = 64);
+
+
 }
 
 
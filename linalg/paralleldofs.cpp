@@ -109,6 +109,28 @@ namespace ngla
     global_ndof = MyMPI_AllReduce (nlocal, MPI_SUM, comm);
   }
 
+  ParallelDofs :: ~ParallelDofs ()
+  {
+    if (neighbor_comm != MPI_COMM_NULL)
+      MPI_Comm_free (&neighbor_comm);
+  }
+
+  void ParallelDofs :: UseNeighborCollectives (bool use)
+  {
+    if (use == UsesNeighborCollectives()) return;
+    if (!use)
+      {
+        MPI_Comm_free (&neighbor_comm);
+        return;
+      }
+
+    // exchange is symmetric, the sources are the destinations
+    int nn = all_dist_procs.Size();
+    MPI_Dist_graph_create_adjacent (comm, nn, nn ? &all_dist_procs[0] : nullptr, MPI_UNWEIGHTED,
+                                    nn, nn ? &all_dist_procs[0] : nullptr, MPI_UNWEIGHTED,
+                                    MPI_INFO_NULL, 0, &neighbor_comm);
+  }
+
   shared_ptr<ParallelDofs> ParallelDofs :: SubSet (shared_ptr<BitArray> take_dofs) const
   {
     auto ndloc = this->GetNDofLocal();
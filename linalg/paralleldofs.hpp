@@ -43,6 +43,9 @@ namespace ngla
     
     /// am I the master process ?
     BitArray ismasterdof;
+
+    /// distributed graph of the exchange procs, for neighborhood collectives
+    MPI_Comm neighbor_comm = MPI_COMM_NULL;
     
   public:
     /**
@@ -55,13 +58,17 @@ namespace ngla
 
     shared_ptr<ParallelDofs> SubSet (shared_ptr<BitArray> take_dofs) const;
       
-    virtual ~ParallelDofs()  { ; }
+    virtual ~ParallelDofs();
 
     int GetNTasks() const { return exchangedofs.Size(); }
 
     FlatArray<int> GetExchangeDofs (int proc) const
     { return exchangedofs[proc]; }
 
+    /// exchange dofs of all procs, concatenated in the order of the procs
+    FlatArray<int> GetAllExchangeDofs () const
+    { return exchangedofs.AsArray(); }
+
     FlatArray<int> GetDistantProcs (int dof) const
     { return dist_procs[dof]; }
 
@@ -83,6 +90,18 @@ namespace ngla
 
     MPI_Comm GetCommunicator () const { return comm; }
 
+    /**
+       Vectors exchange by MPI_Ineighbor_alltoallv on a distributed graph
+       communicator instead of point-to-point messages. Collective over
+       the communicator.
+    */
+    void UseNeighborCollectives (bool use = true);
+
+    bool UsesNeighborCollectives () const { return neighbor_comm != MPI_COMM_NULL; }
+
+    /// MPI_COMM_NULL if neighborhood collectives are not used
+    MPI_Comm GetNeighborCommunicator () const { return neighbor_comm; }
+
     int GetMasterProc (int dof) const
     {
       int m = MyMPI_GetId(comm);
@@ -309,6 +309,47 @@ namespace ngla
   }
   
   
+  template<class TM>
+  void PardisoInverseTM<TM> :: Update ()
+  {
+    static Timer timer("Pardiso Update");
+    RegionTimer reg (timer);
+
+    auto castmatrix = dynamic_pointer_cast<SparseMatrixTM<TM>>(SparseFactorization::matrix.lock());
+    if (!castmatrix)
+      throw Exception("PardisoInverse::Update: matrix is gone");
+
+    // same graph, so the arrays keep their memory
+    if (inner)
+      GetPardisoMatrix (*castmatrix, SubsetFree (*inner));
+    else if (cluster)
+      GetPardisoMatrix (*castmatrix, SubsetCluster (*cluster));
+    else
+      GetPardisoMatrix (*castmatrix, SubsetAll());
+
+    if (rowstart[compressed_height] != nze)
+      throw Exception("PardisoInverse::Update: matrix graph has changed");
+
+    integer maxfct = 1, mnum = 1, phase = 22, nrhs = 1, msglevel = print, error;
+    integer * params = const_cast <integer*> (&hparams[0]);
+
+    if (task_manager) task_manager -> StopWorkers();
+
+    F77_FUNC(pardiso) ( pt, &maxfct, &mnum, &matrixtype, &phase, &compressed_height, 
+			reinterpret_cast<double *>(&matrix[0]),
+			&rowstart[0], &indices[0], NULL, &nrhs, params, &msglevel,
+			NULL, NULL, &error );
+
+    if (task_manager) task_manager -> StartWorkers();
+
+    if ( error != 0 )
+      {
+	cout << "Factorization: PARDISO returned error " << error << "!" << endl;
+	throw Exception("PardisoInverse: Update failed.");
+      }
+  }
+  
+  
   template<class TM> template <typename TSUBSET>
   void PardisoInverseTM<TM> :: 
   GetPardisoMatrix (const SparseMatrixTM<TM> & a, TSUBSET subset)
@@ -130,6 +130,10 @@ namespace ngla
     void GetPardisoMatrix (const SparseMatrixTM<TM> & a, TSUBSET subset);
 
     virtual ~PardisoInverseTM ();
+
+    /// same graph with new values: numerical factorization only (phase 22)
+    virtual bool SupportsUpdate() const { return true; }
+    virtual void Update();
     ///
     int VHeight() const { return height/entrysize; }
     ///
@@ -8,6 +8,9 @@ using namespace ngla;
 template<typename T>
 void ExportSparseMatrix(py::module m)
 {
+  typedef typename mat_traits<T>::TSCAL TSCAL;
+  enum { BH = mat_traits<T>::HEIGHT, BW = mat_traits<T>::WIDTH };
+
   py::class_<SparseMatrix<T>, shared_ptr<SparseMatrix<T>>, BaseSparseMatrix, S_BaseMatrix<typename mat_traits<T>::TSCAL>>
     (m, (string("SparseMatrix") + typeid(T).name()).c_str(),
      "a sparse matrix in CSR storage")
@@ -55,14 +58,80 @@ void ExportSparseMatrix(py::module m)
            return py::make_tuple (move(ri), move(ci), move(vals));
          })
     
-    .def("CSR", [] (shared_ptr<SparseMatrix<T>> sp) -> py::object
+    .def("CSR", [] (py::object self) -> py::object
          {
-           FlatArray<int> colind(sp->NZE(), sp->GetRowIndices(0).Addr(0));
-           FlatVector<T> values(sp->NZE(), sp->GetRowValues(0).Addr(0));
+           // views into the matrix, which stays alive as their base
+           auto sp = self.cast<shared_ptr<SparseMatrix<T>>>();
+           size_t nze = sp->NZE();
            FlatArray<size_t> first = sp->GetFirstArray();
-           return py::make_tuple (values, colind, first); 
+           py::array_t<int> colind (nze, nze ? sp->GetRowIndices(0).Addr(0) : nullptr, self);
+           py::array_t<size_t> pyfirst (first.Size(), &first[0], self);
+           auto data = nze ? (TSCAL*) sp->GetRowValues(0).Addr(0) : nullptr;
+           std::vector<size_t> shape { nze }, strides { sizeof(T) };
+           if (BH != 1 || BW != 1)
+             {
+               shape = { nze, size_t(BH), size_t(BW) };
+               strides = { sizeof(T), BW*sizeof(TSCAL), sizeof(TSCAL) };
+             }
+           py::array_t<TSCAL> values (shape, strides, data, self);
+           return py::make_tuple (values, colind, pyfirst);
          },
-         py::return_value_policy::reference_internal)
+         "Return (values, colind, rowstart) as NumPy arrays sharing the memory of the matrix. "
+         "The values of blocked matrices have shape (nze, h, w), as expected by scipy's bsr_matrix")
+
+    .def_static("FromCSR", [] (py::array_t<TSCAL, 0> values, py::array_t<int, 0> colind,
+                               py::array_t<size_t, 0> first, int width)
+         {
+           // no copies: the arrays must already have the right type and layout
+           for (py::array a : { py::array(values), py::array(colind), py::array(first) })
+             if (!(a.flags() & py::array::c_style))
+               throw Exception ("SparseMatrix.FromCSR: arrays must be C-contiguous");
+           if (colind.ndim() != 1 || first.ndim() != 1 || values.size() != colind.size()*BH*BW)
+             throw Exception ("SparseMatrix.FromCSR: number of values does not match colind and the block size");
+           
+           FlatArray<size_t> ffirst (first.size(), first.mutable_data());
+           FlatArray<int> fcolind (colind.size(), colind.mutable_data());
+           FlatArray<T> fvalues (colind.size(), (T*) values.mutable_data());
+           return make_shared<SparseMatrix<T>> (ffirst, fcolind, fvalues, width);
+         }, py::arg("values").noconvert(), py::arg("colind").noconvert(),
+         py::arg("rowstart").noconvert(), py::arg("width"),
+         py::keep_alive<0,1>(), py::keep_alive<0,2>(), py::keep_alive<0,3>(),
+         "Create a matrix using the memory of NumPy CSR arrays, without copying. "
+         "Column numbers must be increasing within each row. The arrays are kept alive by the matrix")
+
+    .def(py::pickle([] (const SparseMatrix<T> & sp)
+                    {
+                      // the CSR arrays are passed without copying
+                      size_t nze = sp.NZE();
+                      FlatArray<size_t> first = sp.GetFirstArray();
+                      MemoryView mfirst((void*) &first[0], sizeof(size_t) * first.Size());
+                      MemoryView mcol(nze ? (void*) sp.GetRowIndices(0).Addr(0) : nullptr, sizeof(int) * nze);
+                      MemoryView mval(nze ? (void*) sp.GetRowValues(0).Addr(0) : nullptr, sizeof(T) * nze);
+                      bool symmetric = dynamic_cast<const SparseMatrixSymmetric<T>*> (&sp) != nullptr;
+                      return py::make_tuple(sp.Height(), sp.Width(), mfirst, mcol, mval, symmetric);
+                    },
+                    [] (py::tuple state) -> shared_ptr<SparseMatrix<T>>
+                    {
+                      size_t h = state[0].cast<size_t>();
+                      auto mfirst = state[2].cast<MemoryView>();
+                      auto mcol = state[3].cast<MemoryView>();
+                      auto mval = state[4].cast<MemoryView>();
+                      auto first = (const size_t*) mfirst.Ptr();
+                      Array<int> elsperrow(h);
+                      for (size_t i = 0; i < h; i++)
+                        elsperrow[i] = first[i+1]-first[i];
+                      shared_ptr<SparseMatrix<T>> sp;
+                      if (state[5].cast<bool>())
+                        sp = make_shared<SparseMatrixSymmetric<T>> (elsperrow);
+                      else
+                        sp = make_shared<SparseMatrix<T>> (elsperrow, state[1].cast<int>());
+                      if (sp->NZE())
+                        {
+                          memcpy (sp->GetRowIndices(0).Addr(0), mcol.Ptr(), mcol.Size());
+                          memcpy (sp->GetRowValues(0).Addr(0), mval.Ptr(), mval.Size());
+                        }
+                      return sp;
+                    }))
     
     .def_static("CreateFromCOO",
                 [] (py::list indi, py::list indj, py::list values, size_t h, size_t w)
@@ -73,9 +142,20 @@ void ExportSparseMatrix(py::module m)
                   return SparseMatrix<double>::CreateFromCOO (cindi,cindj,cvalues, h,w);
                 }, py::arg("indi"), py::arg("indj"), py::arg("values"), py::arg("h"), py::arg("w"))
     
+    .def("Restrict", [] (const SparseMatrix<T> & self, const SparseMatrix<double> & prol,
+                         shared_ptr<BaseSparseMatrix> cmat)
+         { return self.Restrict (prol, cmat); },
+         py::arg("prol"), py::arg("cmat")=nullptr,
+         "Return the Galerkin product prol.T * self * prol. A coarse matrix cmat from a previous call with the same prol is refilled without rebuilding its structure")
+    .def("ToFloat", [] (const SparseMatrix<double> & sp)
+         { return ToFloat (sp); }, "Return a copy with single precision entries")
     .def("CreateTranspose", [] (const SparseMatrix<double> & sp)
          { return TransposeMatrix (sp); }, "Return transposed matrix")
 
+    .def("CreateSum", [] (const SparseMatrix<double> & a, const SparseMatrix<double> & b, double s)
+         { return MatAdd (1.0, a, s, b); }, py::arg("mat"), py::arg("s")=1.0,
+         "Return self + s*mat as a new sparse matrix, the patterns may differ")
+
     .def("__matmul__", [] (const SparseMatrix<double> & a, const SparseMatrix<double> & b)
          { return MatMult(a,b); }, py::arg("mat"))
     .def("__matmul__", [](shared_ptr<SparseMatrix<double>> a, shared_ptr<BaseMatrix> mb)
@@ -86,6 +166,61 @@ void ExportSparseMatrix(py::module m)
     (m, (string("SparseMatrixSymmetric") + typeid(T).name()).c_str());
 }
 
+template<typename SCAL>
+void ExportShiftInvertArnoldi(py::module m, string name)
+{
+  typedef ShiftInvertArnoldi<SCAL> SIA;
+  py::class_<SIA, shared_ptr<SIA>> (m, name.c_str(),
+                                    "shift-and-invert Arnoldi, keeps the factorization for several shifts")
+    .def("SetShift", &SIA::SetShift, py::arg("shift"), py::call_guard<py::gil_scoped_release>(),
+         "factors A - shift M, a known sparsity pattern is only refactored")
+    .def_property_readonly("shift", &SIA::GetShift)
+    .def_property_readonly("numfactorizations", &SIA::NumFactorizations)
+    .def_property_readonly("numupdates", &SIA::NumUpdates)
+    .def("Calc", [] (const SIA & self, int nev, int maxdim, py::object callback)
+         {
+           function<void(FlatArray<Complex>)> cb;
+           if (!callback.is_none())
+             cb = [callback] (FlatArray<Complex> lam)
+               {
+                 py::gil_scoped_acquire gil;
+                 py::list l;
+                 for (auto v : lam) l.append (py::cast(v));
+                 callback (l);
+               };
+           Array<Complex> lam;
+           Array<shared_ptr<BaseVector>> evecs;
+           {
+             py::gil_scoped_release release;
+             self.Calc (maxdim > 0 ? maxdim : 4*nev+10, nev, lam, evecs, cb);
+           }
+           Vector<Complex> vlam(lam.Size());
+           for (size_t i = 0; i < lam.Size(); i++)
+             vlam(i) = lam[i];
+           py::list vecs;
+           for (auto & v : evecs)
+             vecs.append (py::cast(v));
+           return py::make_tuple (vlam, vecs);
+         },
+         py::arg("nev"), py::arg("maxdim")=0, py::arg("callback")=py::none(), docu_string(R"raw_string(
+Eigenvalues closest to the current shift, and their eigenvectors.
+
+Parameters:
+
+nev : int
+  number of eigenvalues
+
+maxdim : int
+  maximal dimension of the Krylov space, default 4*nev+10
+
+callback : function
+  called with the list of converged eigenvalues whenever it grows
+
+Returns (eigenvalues, list of eigenvectors), sorted by distance to the shift.
+)raw_string"))
+    ;
+}
+
 void NGS_DLL_HEADER ExportNgla(py::module &m) {
 
   py::enum_<PARALLEL_STATUS>(m, "PARALLEL_STATUS", "enum of possible parallel ")
@@ -113,6 +248,9 @@ void NGS_DLL_HEADER ExportNgla(py::module &m) {
 	  }
 	  return new ParallelDofs(comm.comm, ct.MoveTable());
 	}), "dist_procs"_a, "comm"_a)
+    .def("UseNeighborCollectives", [](ParallelDofs & self, bool use)
+         { self.UseNeighborCollectives(use); }, py::arg("use")=true,
+         "exchange vectors by neighborhood collectives on a graph communicator, collective call")
 #endif
     .def_property_readonly ("ndoflocal", [](const ParallelDofs & self) 
 			    { return self.GetNDofLocal(); },
@@ -148,6 +286,15 @@ void NGS_DLL_HEADER ExportNgla(py::module &m) {
 #endif
 	  },
           py::arg("pardofs"), "complex"_a=false, "entrysize"_a=1);
+
+    m.def("CreateSharedVector", &CreateSharedVector,
+          py::arg("name"), py::arg("size"), "complex"_a=false, "entrysize"_a=1,
+          "vector in the new POSIX shared memory segment 'name'. Other processes\n"
+          "on the node attach with AttachSharedVector(name). The segment is\n"
+          "removed when this vector is deleted.");
+    m.def("AttachSharedVector", &AttachSharedVector, py::arg("name"),
+          "vector in the shared memory segment 'name' created by CreateSharedVector\n"
+          "in some process, reads and writes go to the same values");
     
   py::class_<BaseVector, shared_ptr<BaseVector>>(m, "BaseVector",
         py::dynamic_attr() // add dynamic attributes
@@ -343,7 +490,19 @@ void NGS_DLL_HEADER ExportNgla(py::module &m) {
                                               return py::cast (InnerProduct (self, other));
                                           }, py::arg("other"), py::arg("conjugate")=py::cast(true), "Computes (complex) InnerProduct"         
          )
-    .def("Norm",  [](BaseVector & self) { return self.L2Norm(); }, "Calculate Norm")
+    .def("Norm",  [](BaseVector & self) { return self.L2Norm(); },
+         py::call_guard<py::gil_scoped_release>(), "Calculate Norm")
+    .def("InnerProductAsync", [](BaseVector & self, BaseVector & other)
+         {
+           if (self.IsComplex())
+             throw Exception ("InnerProductAsync: only real vectors are supported");
+           return InnerProductAsync (self, other);
+         }, py::arg("other"),
+         "Starts the InnerProduct, the global reduction overlaps with the work until wait() of the result")
+    .def("Mask", [](BaseVector & self, const BitArray & mask, bool keep_values) -> BaseVector&
+         { return self.Mask (mask, keep_values); },
+         py::arg("mask"), py::arg("keep_values")=true, py::return_value_policy::reference,
+         "Set entries to zero where mask differs from keep_values")
     .def("Range", [](BaseVector & self, int from, int to) -> shared_ptr<BaseVector>
                                    {
                                      return shared_ptr<BaseVector>(self.Range(from,to));
@@ -365,6 +524,12 @@ void NGS_DLL_HEADER ExportNgla(py::module &m) {
            [] (py::object x, py::object y) -> py::object
          { return py::handle(x.attr("InnerProduct")) (y); }, py::arg("x"), py::arg("y"), "Computes InnerProduct of given objects");
   ;
+
+  py::class_<FusedInnerProducts<double>, shared_ptr<FusedInnerProducts<double>>>
+    (m, "InnerProductFuture", "an inner product in flight, returned by BaseVector.InnerProductAsync")
+    .def("wait", [](FusedInnerProducts<double> & self) { return self.Wait()[0]; },
+         "waits for the global reduction and returns the inner product")
+    ;
   
 
   py::class_<BlockVector, BaseVector, shared_ptr<BlockVector>> (m, "BlockVector")
@@ -528,6 +693,16 @@ void NGS_DLL_HEADER ExportNgla(py::module &m) {
   
 
 
+  py::class_<MultiVector, shared_ptr<MultiVector>> (m, "MultiVector",
+                                                    "k real vectors of length n, for products with several vectors at once")
+    .def(py::init<size_t, size_t>(), py::arg("n"), py::arg("k"))
+    .def_property_readonly("size", &MultiVector::Size)
+    .def_property_readonly("num_vectors", &MultiVector::NumVectors)
+    .def("SetZero", &MultiVector::SetZero)
+    .def("GetVector", &MultiVector::GetVector, py::arg("j"), py::arg("vec"), "copies vector j to vec")
+    .def("SetVector", &MultiVector::SetVector, py::arg("j"), py::arg("vec"), "copies vec to vector j")
+    ;
+
   py::class_<BaseMatrix, shared_ptr<BaseMatrix>, BaseMatrixTrampoline>(m, "BaseMatrix")
     /*
     .def("__init__", [](BaseMatrix *instance) { 
@@ -559,8 +734,11 @@ void NGS_DLL_HEADER ExportNgla(py::module &m) {
 
     .def("Mult",         [](BaseMatrix &m, BaseVector &x, BaseVector &y) { m.Mult(x, y); }, py::call_guard<py::gil_scoped_release>(), py::arg("x"), py::arg("y"))
     .def("MultAdd",      [](BaseMatrix &m, double s, BaseVector &x, BaseVector &y) { m.MultAdd (s, x, y); }, py::arg("value"), py::arg("x"), py::arg("y"), py::call_guard<py::gil_scoped_release>())
+    .def("Mult",         [](BaseMatrix &m, MultiVector &x, MultiVector &y) { y.SetZero(); m.MultAdd (1.0, x, y); }, py::call_guard<py::gil_scoped_release>(), py::arg("x"), py::arg("y"))
+    .def("MultAdd",      [](BaseMatrix &m, double s, MultiVector &x, MultiVector &y) { m.MultAdd (s, x, y); }, py::arg("value"), py::arg("x"), py::arg("y"), py::call_guard<py::gil_scoped_release>())
     .def("MultTrans",    [](BaseMatrix &m, double s, BaseVector &x, BaseVector &y) { y=0; m.MultTransAdd (1.0, x, y); }, py::arg("value"), py::arg("x"), py::arg("y"), py::call_guard<py::gil_scoped_release>())
     .def("MultTransAdd",  [](BaseMatrix &m, double s, BaseVector &x, BaseVector &y) { m.MultTransAdd (s, x, y); }, py::arg("value"), py::arg("x"), py::arg("y"), py::call_guard<py::gil_scoped_release>())
+    .def("MultTransAdd",  [](BaseMatrix &m, double s, MultiVector &x, MultiVector &y) { m.MultTransAdd (s, x, y); }, py::arg("value"), py::arg("x"), py::arg("y"), py::call_guard<py::gil_scoped_release>())
     .def("MultScale",    [](BaseMatrix &m, double s, BaseVector &x, BaseVector &y)
           {
               m.Mult (x,y);
@@ -586,12 +764,37 @@ void NGS_DLL_HEADER ExportNgla(py::module &m) {
                                               return GetInverseName( m.GetInverseType());
                                             })
 
-    .def("Inverse", [](BM &m, shared_ptr<BitArray> freedofs, string inverse)
+    .def("Inverse", [](BM &m, shared_ptr<BitArray> freedofs, string inverse, double memory_limit,
+                       double compression)
+                                     -> shared_ptr<BaseMatrix>
                                      { 
                                        if (inverse != "") m.SetInverseType(inverse);
+                                       if (compression > 0)
+                                         {
+                                           auto dmat = dynamic_cast<SparseMatrixTM<double>*> (&m);
+                                           if (!dmat)
+                                             throw Exception ("Inverse: compression needs a real sparse matrix");
+                                           return make_shared<SparseCholeskyBLR> (*dmat, freedofs, compression);
+                                         }
+                                       auto spmat = dynamic_cast<BaseSparseMatrix*> (&m);
+                                       if (memory_limit > 0 && spmat && !m.IsComplex())
+                                         {
+                                           auto est = SparseFactorization::Estimate (*spmat, freedofs);
+                                           if (est.peakmemory > memory_limit)
+                                             {
+                                               cout << IM(3) << "factorization needs " << est.peakmemory
+                                                    << " bytes, use CG with Jacobi preconditioner" << endl;
+                                               auto solver = make_shared<CGSolver<double>> (m);
+                                               solver->SetPrecond (spmat->CreateJacobiPrecond (freedofs));
+                                               solver->SetPrecision (1e-12);
+                                               solver->SetMaxSteps (10000);
+                                               return solver;
+                                             }
+                                         }
                                        return m.InverseMatrix(freedofs);
                                      }
-         ,"Inverse", py::arg("freedofs")=nullptr, py::arg("inverse")=py::str(""), 
+         ,"Inverse", py::arg("freedofs")=nullptr, py::arg("inverse")=py::str(""), py::arg("memory_limit")=0,
+         py::arg("compression")=0, 
          docu_string(R"raw_string(Calculate inverse of sparse matrix
 Parameters:
 
@@ -601,10 +804,21 @@ freedofs : BitArray
 inverse : string
   Solver to use, allowed values are:
     sparsecholesky - internal solver of NGSolve for symmetric matrices
+    sparsecholesky_nd - internal solver with nested dissection ordering
+    sparsecholesky_mixed - internal solver with single precision factor and iterative refinement
     umfpack        - solver by Suitesparse/UMFPACK (if NGSolve was configured with USE_UMFPACK=ON)
     pardiso        - PARDISO, either provided by libpardiso (USE_PARDISO=ON) or Intel MKL (USE_MKL=ON).
                      If neither Pardiso nor Intel MKL was linked at compile-time, NGSolve will look
                      for libmkl_rt in LD_LIBRARY_PATH (Unix) or PATH (Windows) at run-time.
+
+memory_limit : float
+  If positive, and the estimated memory of the factorization in bytes exceeds it,
+  a CG solver with Jacobi preconditioner is returned instead
+
+compression : float
+  If positive, the off-diagonal blocks of large supernodes of the sparse cholesky
+  factor are compressed to low rank with this relative tolerance. The result is
+  an approximate inverse, to be used as a preconditioner
 )raw_string"), py::call_guard<py::gil_scoped_release>())
     // .def("Inverse", [](BM &m)  { return m.InverseMatrix(); })
 
@@ -628,8 +842,22 @@ inverse : string
     .def("CreateSmoother", [](BaseSparseMatrix & m, shared_ptr<BitArray> ba) 
          { return m.CreateJacobiPrecond(ba); },
          py::arg("freedofs") = shared_ptr<BitArray>())
+
+    .def("EstimateFactorization", [](BaseSparseMatrix & m, shared_ptr<BitArray> freedofs,
+                                     bool nested_dissection)
+         {
+           auto est = SparseFactorization::Estimate (m, freedofs, nested_dissection);
+           py::dict res;
+           res["nze"] = est.nze;
+           res["memory"] = est.memory;
+           res["peakmemory"] = est.peakmemory;
+           res["flops"] = est.flops;
+           return res;
+         }, py::arg("freedofs") = shared_ptr<BitArray>(), py::arg("nested_dissection") = false,
+         "symbolic phase of the sparse cholesky factorization only: entries of the factor, memory in bytes and flops")
     
-    .def("CreateBlockSmoother", [](BaseSparseMatrix & m, py::object blocks)
+    .def("CreateBlockSmoother", [](BaseSparseMatrix & m, py::object blocks,
+                                   double singleprecision)
          {
            size_t size = py::len(blocks);
            
@@ -649,12 +877,77 @@ inverse : string
              }
 
            auto pre = m.CreateBlockJacobiPrecond (make_shared<Table<int>> (move(blocktable)));
+           if (singleprecision > 0)
+             pre->SetSinglePrecision (singleprecision);
            return pre;
-         }, py::arg("blocks"))
+         }, py::arg("blocks"), py::arg("singleprecision") = 0.0,
+         "block Jacobi/Gauss-Seidel smoother.\n"
+         "singleprecision > 0 stores groups of equal-size block inverses in float\n"
+         "if max |A_b inv_b - I| stays below this tolerance")
      ;
 
   py::class_<S_BaseMatrix<double>, shared_ptr<S_BaseMatrix<double>>, BaseMatrix>
     (m, "S_BaseMatrixD", "base sparse matrix");
+
+  py::class_<SellCSigmaMatrix, shared_ptr<SellCSigmaMatrix>, BaseMatrix>
+    (m, "SellCSigmaMatrix", "copy of a real sparse matrix in SELL-C-sigma format for fast matrix-vector products")
+    .def(py::init([] (shared_ptr<BaseMatrix> mat, int sigma)
+                  {
+                    auto spmat = dynamic_pointer_cast<SparseMatrixTM<double>> (mat);
+                    if (!spmat)
+                      throw Exception ("SellCSigmaMatrix needs a real sparse matrix");
+                    return make_shared<SellCSigmaMatrix> (*spmat, sigma);
+                  }), py::arg("mat"), py::arg("sigma")=256,
+         "rows are sorted by length within windows of sigma rows")
+    ;
+
+  py::class_<DeltaIndexSparseMatrix, shared_ptr<DeltaIndexSparseMatrix>, BaseMatrix>
+    (m, "DeltaIndexSparseMatrix", "copy of a real sparse matrix with 16-bit column offsets per row")
+    .def(py::init([] (shared_ptr<BaseMatrix> mat)
+                  {
+                    auto spmat = dynamic_pointer_cast<SparseMatrixTM<double>> (mat);
+                    if (!spmat)
+                      throw Exception ("DeltaIndexSparseMatrix needs a real sparse matrix");
+                    return make_shared<DeltaIndexSparseMatrix> (*spmat);
+                  }), py::arg("mat"))
+    .def_property_readonly("nwiderows", &DeltaIndexSparseMatrix::NumWideRows,
+                           "number of rows stored with 32-bit column numbers")
+    ;
+
+  py::class_<FloatSparseMatrix, shared_ptr<FloatSparseMatrix>, BaseMatrix>
+    (m, "FloatSparseMatrix", "copy of a real sparse matrix with single precision entries, for preconditioners")
+    .def("CreateSmoother", [](const FloatSparseMatrix & self, shared_ptr<BitArray> inner)
+         { return self.CreateJacobiPrecond (inner); },
+         py::arg("freedofs")=nullptr, "Jacobi preconditioner and Gauss-Seidel smoother reading the float entries")
+    ;
+
+  m.def("CreateBlockedSparseMatrix", [] (shared_ptr<BaseMatrix> mat, int blocksize) -> shared_ptr<BaseMatrix>
+        {
+          auto spmat = dynamic_pointer_cast<SparseMatrixTM<double>> (mat);
+          if (!spmat)
+            throw Exception ("CreateBlockedSparseMatrix needs a real sparse matrix");
+          return CreateBlockedSparseMatrix (*spmat, blocksize);
+        }, py::arg("mat"), py::arg("blocksize"),
+        "Copy of a real sparse matrix stored with blocksize x blocksize blocks,\n"
+        "for interleaved or component-wise numbered dofs. Returns None if\n"
+        "the dofs do not form blocks.");
+
+  py::class_<SnapshotStore, shared_ptr<SnapshotStore>>
+    (m, "SnapshotStore", "compressed snapshots of vectors, e.g. forward states for adjoint computations")
+    .def(py::init<string,double,bool>(), py::arg("filename")="", py::arg("tolerance")=0,
+         py::arg("background")=false,
+         "filename: keep the snapshots in this file, in memory if empty\n"
+         "tolerance: maximal error of a value, 0 is lossless\n"
+         "background: encode and write on a background thread")
+    .def("Store", &SnapshotStore::Store, py::arg("vec"), "stores a copy of vec, returns its number")
+    .def("Load", &SnapshotStore::Load, py::arg("nr"), py::arg("vec"), "vec = snapshot nr")
+    .def("Wait", &SnapshotStore::Wait, py::call_guard<py::gil_scoped_release>(),
+         "waits for encoding and writing of all snapshots")
+    .def("__len__", &SnapshotStore::Size)
+    .def_property_readonly("nbytes", &SnapshotStore::Bytes, "bytes of the encoded snapshots")
+    .def_property_readonly("rawbytes", &SnapshotStore::RawBytes, "bytes of the uncompressed snapshots")
+    .def_property_readonly("tolerance", &SnapshotStore::GetTolerance)
+    ;
   py::class_<S_BaseMatrix<Complex>, shared_ptr<S_BaseMatrix<Complex>>, BaseMatrix>
     (m, "S_BaseMatrixC", "base sparse matrix");
 
@@ -723,9 +1016,11 @@ inverse : string
      "block Jacobi and block Gauss-Seidel smoothing")
     .def("Smooth", &BaseBlockJacobiPrecond::GSSmooth,
          py::arg("x"), py::arg("b"), py::arg("steps")=1,
+         py::call_guard<py::gil_scoped_release>(),
          "performs steps block-Gauss-Seidel iterations for the linear system A x = b")
     .def("SmoothBack", &BaseBlockJacobiPrecond::GSSmoothBack,
          py::arg("x"), py::arg("b"), py::arg("steps")=1,
+         py::call_guard<py::gil_scoped_release>(),
          "performs steps block-Gauss-Seidel iterations for the linear system A x = b in reverse order")
     ;
 
@@ -735,9 +1030,11 @@ inverse : string
     .def("Smooth", [&](BaseJacobiPrecond & jac, BaseVector & x, BaseVector & b)
          { jac.GSSmooth (x, b); },
          py::arg("x"), py::arg("b"),
+         py::call_guard<py::gil_scoped_release>(),
          "performs one step Gauss-Seidel iteration for the linear system A x = b")
     .def("SmoothBack", &BaseJacobiPrecond::GSSmoothBack,
          py::arg("x"), py::arg("b"),
+         py::call_guard<py::gil_scoped_release>(),
          "performs one step Gauss-Seidel iteration for the linear system A x = b in reverse order")
     ;
 
@@ -746,11 +1043,21 @@ inverse : string
     .def("Smooth", [] (SparseFactorization & self, BaseVector & u, BaseVector & y)
          {
            self.Smooth (u, y /* this is not needed */, y);
-         }, "perform smoothing step (needs non-symmetric storage so symmetric sparse matrix)")
+         }, py::call_guard<py::gil_scoped_release>(), "perform smoothing step (needs non-symmetric storage so symmetric sparse matrix)")
     ;
 
-  py::class_<SparseCholesky<double>, shared_ptr<SparseCholesky<double>>, SparseFactorization> (m, "SparseCholesky_d");
-  py::class_<SparseCholesky<Complex>, shared_ptr<SparseCholesky<Complex>>, SparseFactorization> (m, "SparseCholesky_c");
+  py::class_<SparseCholesky<double>, shared_ptr<SparseCholesky<double>>, SparseFactorization> (m, "SparseCholesky_d")
+    .def("SwapOut", &SparseCholesky<double>::SwapOut, py::arg("filename"),
+         "writes the factor to a file and releases its memory, solves read it back block by block")
+    ;
+  py::class_<SparseCholeskyBLR, shared_ptr<SparseCholeskyBLR>, SparseCholesky<double>> (m, "SparseCholeskyBLR")
+    .def_property_readonly("num_compressed", &SparseCholeskyBLR::NumCompressed,
+                           "number of supernode panels stored in low-rank form")
+    ;
+  py::class_<SparseCholesky<Complex>, shared_ptr<SparseCholesky<Complex>>, SparseFactorization> (m, "SparseCholesky_c")
+    .def("SwapOut", &SparseCholesky<Complex>::SwapOut, py::arg("filename"),
+         "writes the factor to a file and releases its memory, solves read it back block by block")
+    ;
   
   py::class_<Projector, shared_ptr<Projector>, BaseMatrix> (m, "Projector")
     .def(py::init<shared_ptr<BitArray>,bool>(),
@@ -765,18 +1072,34 @@ inverse : string
            py::arg("size"), py::arg("complex")=false)
       ;
 
+  py::class_<KroneckerMatrix, shared_ptr<KroneckerMatrix>, BaseMatrix>
+    (m, "KroneckerMatrix",
+     "Kronecker product A (x) B of two real matrices, only the factors are stored.\n"
+     "Vector entries are numbered i*B.width+j, as the dofs of tensor product spaces")
+    .def(py::init<shared_ptr<BaseMatrix>,shared_ptr<BaseMatrix>>(), py::arg("a"), py::arg("b"))
+    .def(py::init<FlatMatrix<double>,FlatMatrix<double>>(), py::arg("a"), py::arg("b"),
+         "dense factors, applied by matrix-matrix products")
+    ;
+
   py::class_<KrylovSpaceSolver, shared_ptr<KrylovSpaceSolver>, BaseMatrix> (m, "KrylovSpaceSolver")
     .def("GetSteps", &KrylovSpaceSolver::GetSteps)
     ;
 
   m.def("CGSolver", [](const BaseMatrix & mat, const BaseMatrix & pre,
                                           bool iscomplex, bool printrates, 
-                                          double precision, int maxsteps)
+                                          double precision, int maxsteps, bool pipelined)
                                        {
                                          KrylovSpaceSolver * solver;
                                          if(mat.IsComplex()) iscomplex = true;
                                          
-                                         if (iscomplex)
+                                         if (pipelined)
+                                           {
+                                             if (iscomplex)
+                                               solver = new PipelinedCGSolver<Complex> (mat, pre);
+                                             else
+                                               solver = new PipelinedCGSolver<double> (mat, pre);
+                                           }
+                                         else if (iscomplex)
                                            solver = new CGSolver<Complex> (mat, pre);
                                          else
                                            solver = new CGSolver<double> (mat, pre);
@@ -786,7 +1109,7 @@ inverse : string
                                          return shared_ptr<KrylovSpaceSolver>(solver);
                                        },
            py::arg("mat"), py::arg("pre"), py::arg("complex") = false, py::arg("printrates")=true,
-        py::arg("precision")=1e-8, py::arg("maxsteps")=200, docu_string(R"raw_string(
+        py::arg("precision")=1e-8, py::arg("maxsteps")=200, py::arg("pipelined")=false, docu_string(R"raw_string(
 A CG Solver.
 
 Parameters:
@@ -809,6 +1132,10 @@ precision : float
 maxsteps : int
   input maximal steps. CGSolver stops after this steps.
 
+pipelined : bool
+  use the pipelined variant with one fused global reduction per
+  iteration, overlapped with preconditioner and matrix application.
+
 )raw_string"))
     ;
 
@@ -847,6 +1174,50 @@ precision : float
 maxsteps : int
   input maximal steps. GMRESSolver stops after this steps.
 
+)raw_string"))
+    ;
+
+  m.def("BlockCGSolver", [](const BaseMatrix & mat, const BaseMatrix & pre, bool gmres,
+                            bool printrates, double precision, int maxsteps)
+        {
+          if (mat.IsComplex())
+            throw Exception ("BlockCGSolver: only real matrices are supported");
+          KrylovSpaceSolver * solver;
+          if (gmres)
+            solver = new BlockGMRESSolver (mat, pre);
+          else
+            solver = new BlockCGSolver (mat, pre);
+          solver->SetPrecision(precision);
+          solver->SetMaxSteps(maxsteps);
+          solver->SetPrintRates (printrates);
+          return shared_ptr<KrylovSpaceSolver>(solver);
+        },
+        py::arg("mat"), py::arg("pre"), py::arg("gmres")=false, py::arg("printrates")=true,
+        py::arg("precision")=1e-8, py::arg("maxsteps")=200, docu_string(R"raw_string(
+A block Krylov space solver for several right hand sides. 
+Apply it to a MultiVector: all right hand sides share one Krylov space,
+the matrix and the preconditioner are applied to all vectors at once.
+
+Parameters:
+
+mat : ngsolve.la.BaseMatrix
+  input real matrix 
+
+pre : ngsolve.la.BaseMatrix
+  input preconditioner matrix
+
+gmres : bool
+  use block GMRES instead of block CG (for non-symmetric matrices)
+
+printrates : bool
+  input printrates
+
+precision : float
+  input requested precision, every right hand side must reach it.
+
+maxsteps : int
+  input maximal number of block steps.
+
 )raw_string"))
     ;
 
@@ -863,7 +1234,57 @@ maxsteps : int
     "The typical usecase of this function is to calculate the condition number of a preconditioner."
     "It uses the Lanczos algorithm and bisection for the tridiagonal matrix"
     );
-  
+
+  m.def("LOBPCG", [](const BaseMatrix & mata, const BaseMatrix & matm, MultiVector & initial,
+                     shared_ptr<BaseMatrix> pre, shared_ptr<BitArray> freedofs,
+                     double precision, int maxsteps, bool printrates)
+        {
+          if (mata.IsComplex() || matm.IsComplex())
+            throw Exception ("LOBPCG: only real matrices are supported");
+          LOBPCGSolver solver(mata, matm, pre.get(), freedofs);
+          solver.SetPrecision (precision);
+          solver.SetMaxSteps (maxsteps);
+          solver.SetPrintRates (printrates);
+          Vector<double> lam(initial.NumVectors());
+          solver.Solve (initial, lam);
+          return lam;
+        },
+        py::arg("mata"), py::arg("matm"), py::arg("initial"), py::arg("pre")=nullptr,
+        py::arg("freedofs")=nullptr, py::arg("precision")=1e-8, py::arg("maxsteps")=200,
+        py::arg("printrates")=false, py::call_guard<py::gil_scoped_release>(),
+        docu_string(R"raw_string(
+Smallest eigenvalues of  A x = lam M x  by the locally optimal block
+preconditioned conjugate gradient method. All vectors of the block
+are iterated at once, the small projected problems are solved by LAPACK.
+
+Parameters:
+
+mata : ngsolve.la.BaseMatrix
+  input real symmetric matrix A
+
+matm : ngsolve.la.BaseMatrix
+  input real symmetric positive definite matrix M
+
+initial : ngsolve.la.MultiVector
+  initial guess, one vector per eigenvalue. Overwritten by the
+  M-orthonormal eigenvectors.
+
+pre : ngsolve.la.BaseMatrix
+  input preconditioner for A
+
+freedofs : ngsolve.ngstd.BitArray
+  the eigenvectors are zero outside of freedofs
+
+precision : float
+  input relative residual for every eigenpair
+
+maxsteps : int
+  input maximal number of steps
+
+Returns the eigenvalues in ascending order.
+
+)raw_string"));
+
   py::class_<QMRSolver<double>, shared_ptr<QMRSolver<double>>, BaseMatrix> (m, "QMRSolverD")
     ;
   py::class_<QMRSolver<Complex>, shared_ptr<QMRSolver<Complex>>, BaseMatrix> (m, "QMRSolverC")
@@ -984,6 +1405,57 @@ vecs : list
 shift : object
   complex or real shift
 )raw_string"));
+
+  ExportShiftInvertArnoldi<double> (m, "ShiftInvertArnoldiD");
+  ExportShiftInvertArnoldi<Complex> (m, "ShiftInvertArnoldiC");
+
+  m.def("ShiftInvertArnoldi", [](shared_ptr<BaseMatrix> mata, shared_ptr<BaseMatrix> matm,
+                                 shared_ptr<BitArray> freedofs, string inverse,
+                                 int blocksize, double tol) -> py::object
+        {
+          if (mata->IsComplex())
+            {
+              auto sia = make_shared<ShiftInvertArnoldi<Complex>> (*mata, *matm, freedofs, inverse);
+              sia->SetBlockSize (blocksize);
+              sia->SetTolerance (tol);
+              return py::cast(sia);
+            }
+          auto sia = make_shared<ShiftInvertArnoldi<double>> (*mata, *matm, freedofs, inverse);
+          sia->SetBlockSize (blocksize);
+          sia->SetTolerance (tol);
+          return py::cast(sia);
+        },
+        py::arg("mata"), py::arg("matm"), py::arg("freedofs")=nullptr, py::arg("inverse")="",
+        py::arg("blocksize")=1, py::arg("tol")=1e-8,
+        py::keep_alive<0,1>(), py::keep_alive<0,2>(), docu_string(R"raw_string(
+Shift-and-invert Arnoldi eigenvalue solver for a sequence of shifts.
+
+Solves A*u = lam*M*u near a shift. SetShift factors A - shift M once,
+further shifts only refactor the values with the same ordering and
+symbolic factorization. The Krylov space grows by blocksize vectors,
+real problems solve the whole block at once. Calc stops as soon as the
+requested eigenvalues are converged.
+
+Parameters:
+
+mata : ngsolve.la.BaseMatrix
+  sparse matrix A
+
+matm : ngsolve.la.BaseMatrix
+  sparse matrix M, with the sparsity pattern of A
+
+freedofs : ngsolve.ngstd.BitArray
+  correct degrees of freedom
+
+inverse : str
+  type of the sparse factorization
+
+blocksize : int
+  number of vectors per Krylov step
+
+tol : float
+  relative residual of converged Ritz pairs
+)raw_string"));
   
   
 
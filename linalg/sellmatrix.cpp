@@ -0,0 +1,140 @@
+/*********************************************************************/
+/* File:   sellmatrix.cpp                                            */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+/* 
+   Sparse matrix in SELL-C-sigma format
+*/
+
+#include <la.hpp>
+namespace ngla
+{
+
+  SellCSigmaMatrix :: SellCSigmaMatrix (const SparseMatrixTM<double> & mat, int sigma)
+    : height(mat.Height()), width(mat.Width())
+  {
+    static Timer t("SellCSigmaMatrix - ctor"); RegionTimer reg(t);
+
+    // the symmetric matrix stores only the lower triangle
+    bool symmetric = dynamic_cast<const SparseMatrixSymmetric<double>*> (&mat) != nullptr;
+
+    Array<int> rowlen(height);
+    rowlen = 0;
+    for (size_t i = 0; i < height; i++)
+      for (auto j : mat.GetRowIndices(i))
+        {
+          rowlen[i]++;
+          if (symmetric && j != i) rowlen[j]++;
+        }
+
+    Table<int> rowcols(rowlen);
+    Table<double> rowvals(rowlen);
+    rowlen = 0;
+    for (size_t i = 0; i < height; i++)
+      {
+        FlatArray<int> cols = mat.GetRowIndices(i);
+        FlatVector<double> vals = mat.GetRowValues(i);
+        for (size_t k = 0; k < cols.Size(); k++)
+          {
+            int j = cols[k];
+            rowcols[i][rowlen[i]] = j;
+            rowvals[i][rowlen[i]++] = vals(k);
+            if (symmetric && j != i)
+              {
+                rowcols[j][rowlen[j]] = i;
+                rowvals[j][rowlen[j]++] = vals(k);
+              }
+          }
+      }
+    nze = rowcols.AsArray().Size();
+
+    // sort rows by length within windows of sigma rows
+    sigma = max2 (sigma, int(C));
+    Array<int> order(height);
+    for (size_t i = 0; i < height; i++)
+      order[i] = i;
+    for (size_t first = 0; first < height; first += sigma)
+      {
+        auto window = order.Range (first, min2 (first+sigma, height));
+        QuickSortI (rowlen, window, [] (int a, int b) { return a > b; });
+      }
+
+    size_t nchunks = (height + C-1) / C;
+    rownr.SetSize (nchunks*C);
+    firstchunk.SetSize (nchunks+1);
+    size_t cnt = 0;
+    for (size_t c = 0; c < nchunks; c++)
+      {
+        int chunkwidth = 0;
+        for (size_t k = 0; k < C; k++)
+          {
+            size_t ii = c*C+k;
+            rownr[ii] = (ii < height) ? order[ii] : -1;
+            if (rownr[ii] != -1)
+              chunkwidth = max2 (chunkwidth, rowlen[rownr[ii]]);
+          }
+        firstchunk[c] = cnt;
+        cnt += chunkwidth*C;
+      }
+    firstchunk[nchunks] = cnt;
+
+    colnr.SetSize (cnt);
+    values.SetSize (cnt);
+    ParallelFor (nchunks, [&] (size_t c)
+      {
+        size_t first = firstchunk[c];
+        size_t chunkwidth = (firstchunk[c+1]-first) / C;
+        for (size_t k = 0; k < C; k++)
+          {
+            int row = rownr[c*C+k];
+            size_t len = (row != -1) ? rowlen[row] : 0;
+            for (size_t j = 0; j < chunkwidth; j++)
+              {
+                size_t ii = first + j*C + k;
+                colnr[ii] = (j < len) ? rowcols[row][j] : 0;
+                values[ii] = (j < len) ? rowvals[row][j] : 0.0;
+              }
+          }
+      });
+  }
+
+  
+  void SellCSigmaMatrix :: MultAdd (double s, const BaseVector & x, BaseVector & y) const
+  {
+    static Timer t("SellCSigmaMatrix::MultAdd"); RegionTimer reg(t);
+    t.AddFlops (nze);
+    
+    FlatVector<double> fx = x.FV<double>();
+    FlatVector<double> fy = y.FV<double>();
+
+    ParallelForRange
+      (firstchunk.Size()-1, [&] (IntRange r)
+       {
+         for (size_t c : r)
+           {
+             SIMD<double> sum(0.0);
+             for (size_t j = firstchunk[c]; j < firstchunk[c+1]; j += C)
+               {
+                 const int * pcol = &colnr[j];
+                 sum += SIMD<double> (&values[j]) *
+                   SIMD<double> ([fx,pcol] (int k) { return fx(pcol[k]); });
+               }
+             
+             for (size_t k = 0; k < C; k++)
+               {
+                 int row = rownr[c*C+k];
+                 if (row != -1)
+                   fy(row) += s * sum[k];
+               }
+           }
+       });
+  }
+
+  
+  Array<MemoryUsage> SellCSigmaMatrix :: GetMemoryUsage () const
+  {
+    return { { "SellCSigmaMatrix", values.Size()*(sizeof(double)+sizeof(int)), 1 } };
+  }
+  
+}
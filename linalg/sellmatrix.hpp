@@ -0,0 +1,59 @@
+#ifndef FILE_NGS_SELLMATRIX
+#define FILE_NGS_SELLMATRIX
+
+/* ************************************************************************/
+/* File:   sellmatrix.hpp                                                 */
+/* Date:   Oct. 2026                                                      */
+/* ************************************************************************/
+
+/*
+   Sparse matrix in SELL-C-sigma format
+*/
+
+namespace ngla
+{
+
+  /**
+     A copy of a real sparse matrix for fast matrix-vector products.
+     Within windows of sigma rows the rows are sorted by length, and
+     groups of C = SIMD-width rows form a chunk. A chunk is stored column
+     by column, padded to its longest row, such that one SIMD operation
+     treats one entry of C rows.
+   */
+  class NGS_DLL_HEADER SellCSigmaMatrix : public BaseMatrix
+  {
+    static constexpr int C = SIMD<double>::Size();
+
+    size_t height, width, nze;
+    /// first entry of every chunk, nchunks+1 entries
+    Array<size_t> firstchunk;
+    /// matrix row of every chunk row, -1 for padding rows
+    Array<int> rownr;
+    /// column numbers and values, padding entries have value 0
+    Array<int> colnr;
+    Array<double> values;
+
+  public:
+    /// copies the matrix, symmetric matrices are stored in full
+    SellCSigmaMatrix (const SparseMatrixTM<double> & mat, int sigma = 256);
+
+    virtual bool IsComplex() const override { return false; }
+    virtual int VHeight() const override { return height; }
+    virtual int VWidth() const override { return width; }
+    virtual size_t NZE () const override { return nze; }
+
+    virtual AutoVector CreateVector () const override
+    { return make_shared<VVector<double>> (height); }
+    virtual AutoVector CreateRowVector () const override
+    { return make_shared<VVector<double>> (width); }
+    virtual AutoVector CreateColVector () const override
+    { return make_shared<VVector<double>> (height); }
+
+    virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const override;
+
+    virtual Array<MemoryUsage> GetMemoryUsage () const override;
+  };
+
+}
+
+#endif
@@ -0,0 +1,155 @@
+/*********************************************************************/
+/* File:   sharedvector.cpp                                          */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+/* 
+   Vectors in named shared memory
+*/
+
+#include <la.hpp>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <cerrno>
+#endif
+
+namespace ngla
+{
+
+#ifndef WIN32
+
+  // POSIX names start with a single slash
+  static string ShmName (const string & name)
+  {
+    if (name.empty())
+      throw Exception ("SharedMemory: empty name");
+    return (name[0] == '/') ? name : "/"+name;
+  }
+
+  SharedMemory :: SharedMemory (string aname, size_t abytes)
+    : name(ShmName(aname)), bytes(abytes), owner(true)
+  {
+    int fd = shm_open (name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd == -1)
+      throw Exception ("SharedMemory: cannot create '"+name+"': "+strerror(errno));
+    if (ftruncate (fd, bytes) == -1)
+      {
+        string err = strerror(errno);
+        close (fd);
+        shm_unlink (name.c_str());
+        throw Exception ("SharedMemory: cannot resize '"+name+"': "+err);
+      }
+    mem = mmap (nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close (fd);
+    if (mem == MAP_FAILED)
+      {
+        shm_unlink (name.c_str());
+        throw Exception ("SharedMemory: cannot map '"+name+"'");
+      }
+  }
+
+  SharedMemory :: SharedMemory (string aname)
+    : name(ShmName(aname)), owner(false)
+  {
+    int fd = shm_open (name.c_str(), O_RDWR, 0);
+    if (fd == -1)
+      throw Exception ("SharedMemory: cannot attach to '"+name+"': "+strerror(errno));
+    struct stat st;
+    if (fstat (fd, &st) == -1)
+      {
+        close (fd);
+        throw Exception ("SharedMemory: cannot stat '"+name+"'");
+      }
+    bytes = st.st_size;
+    mem = mmap (nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close (fd);
+    if (mem == MAP_FAILED)
+      throw Exception ("SharedMemory: cannot map '"+name+"'");
+  }
+
+  SharedMemory :: ~SharedMemory ()
+  {
+    munmap (mem, bytes);
+    if (owner)
+      shm_unlink (name.c_str());
+  }
+
+#else
+
+  SharedMemory :: SharedMemory (string aname, size_t abytes)
+  {
+    throw Exception ("SharedMemory not available on Windows");
+  }
+
+  SharedMemory :: SharedMemory (string aname)
+  {
+    throw Exception ("SharedMemory not available on Windows");
+  }
+
+  SharedMemory :: ~SharedMemory () { ; }
+
+#endif
+
+
+
+  // the segment starts with this header, the values are 64-byte aligned
+  struct SharedVectorHeader
+  {
+    uint64_t magic;
+    uint64_t size;
+    uint64_t es;
+    uint64_t is_complex;
+  };
+  static constexpr uint64_t shared_vector_magic = 0x4e4753534856ull;   // "NGSSHV"
+  static constexpr size_t shared_vector_offset = 64;
+
+  template <typename TSCAL>
+  SharedVector<TSCAL> :: SharedVector (shared_ptr<SharedMemory> ashm, size_t as, int aes)
+    : S_BaseVectorPtr<TSCAL> (as, aes, (char*)ashm->Memory()+shared_vector_offset),
+      shm(ashm)
+  { ; }
+
+  template class SharedVector<double>;
+  template class SharedVector<Complex>;
+
+  
+  shared_ptr<BaseVector>
+  CreateSharedVector (string name, size_t size, bool is_complex, int es)
+  {
+    size_t scal = is_complex ? sizeof(Complex) : sizeof(double);
+    auto shm = make_shared<SharedMemory> (name, shared_vector_offset + size*es*scal);
+
+    auto & header = *static_cast<SharedVectorHeader*> (shm->Memory());
+    header.size = size;
+    header.es = es;
+    header.is_complex = is_complex;
+    header.magic = shared_vector_magic;
+
+    if (is_complex)
+      return make_shared<SharedVector<Complex>> (shm, size, es);
+    return make_shared<SharedVector<double>> (shm, size, es);
+  }
+
+  shared_ptr<BaseVector> AttachSharedVector (string name)
+  {
+    auto shm = make_shared<SharedMemory> (name);
+    if (shm->Size() < shared_vector_offset)
+      throw Exception ("AttachSharedVector: '"+shm->Name()+"' is no shared vector");
+
+    auto & header = *static_cast<const SharedVectorHeader*> (shm->Memory());
+    size_t scal = header.is_complex ? sizeof(Complex) : sizeof(double);
+    if (header.magic != shared_vector_magic ||
+        shm->Size() < shared_vector_offset + header.size*header.es*scal)
+      throw Exception ("AttachSharedVector: '"+shm->Name()+"' is no shared vector");
+
+    if (header.is_complex)
+      return make_shared<SharedVector<Complex>> (shm, header.size, header.es);
+    return make_shared<SharedVector<double>> (shm, header.size, header.es);
+  }
+
+}
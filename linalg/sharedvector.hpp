@@ -0,0 +1,75 @@
+#ifndef FILE_SHAREDVECTOR
+#define FILE_SHAREDVECTOR
+
+/* ************************************************************************/
+/* File:   sharedvector.hpp                                               */
+/* Date:   Oct. 2026                                                      */
+/* ************************************************************************/
+
+/*
+   Vectors in named shared memory, for processes on one node working
+   on the same values
+*/
+
+namespace ngla
+{
+
+  /**
+     A named POSIX shared memory segment. The creating process owns
+     the name and removes it in the destructor, other processes attach
+     by the name and map the same memory. Processes attached before
+     keep their mapping after the name is removed.
+   */
+  class NGS_DLL_HEADER SharedMemory
+  {
+    string name;
+    void * mem = nullptr;
+    size_t bytes = 0;
+    bool owner;
+  public:
+    /// creates a new segment of bytes bytes
+    SharedMemory (string aname, size_t abytes);
+    /// attaches to an existing segment
+    SharedMemory (string aname);
+    SharedMemory (const SharedMemory &) = delete;
+    ~SharedMemory ();
+
+    void * Memory () const { return mem; }
+    size_t Size () const { return bytes; }
+    const string & Name () const { return name; }
+    bool IsOwner () const { return owner; }
+  };
+
+
+  /**
+     A vector with its values in shared memory. The segment starts
+     with the size, entry size and type of the vector, so a vector can
+     be attached by its name only.
+
+     There is no synchronization between the processes, they have to
+     wait for each other (pipe, barrier) before reading values another
+     process wrote.
+   */
+  template <typename TSCAL = double>
+  class NGS_DLL_HEADER SharedVector : public S_BaseVectorPtr<TSCAL>
+  {
+    shared_ptr<SharedMemory> shm;
+  public:
+    SharedVector (shared_ptr<SharedMemory> ashm, size_t as, int aes);
+
+    shared_ptr<SharedMemory> GetSharedMemory () const { return shm; }
+    const string & Name () const { return shm->Name(); }
+  };
+
+  extern template class SharedVector<double>;
+  extern template class SharedVector<Complex>;
+
+  /// creates a vector in the new segment name
+  NGS_DLL_HEADER shared_ptr<BaseVector>
+  CreateSharedVector (string name, size_t size, bool is_complex, int es);
+
+  /// attaches to the vector created by another process
+  NGS_DLL_HEADER shared_ptr<BaseVector> AttachSharedVector (string name);
+}
+
+#endif
@@ -0,0 +1,290 @@
+/*********************************************************************/
+/* File:   snapshotstore.cpp                                         */
+/* Date:   Oct. 2026                                                 */
+/*********************************************************************/
+
+/* 
+   Compressed storage of many vectors
+*/
+
+#include <la.hpp>
+namespace ngla
+{
+
+  // values per block, blocks are encoded and decoded independently
+  static constexpr size_t snapshot_blocksize = 4096;
+
+  enum { SNAPSHOT_RAW = 0, SNAPSHOT_QUANTIZED = 1 };
+
+  static void PutVarint (Array<unsigned char> & out, uint64_t v)
+  {
+    while (v >= 128)
+      {
+        out.Append ((v & 127) | 128);
+        v >>= 7;
+      }
+    out.Append (v);
+  }
+
+  static uint64_t GetVarint (const unsigned char *& p)
+  {
+    uint64_t v = 0;
+    for (int shift = 0; ; shift += 7)
+      {
+        unsigned char c = *p++;
+        v |= uint64_t(c & 127) << shift;
+        if (c < 128) return v;
+      }
+  }
+
+  /*
+    Quantized blocks store the differences of neighbouring integers
+    round(x/(2 tol)) as zigzag varints. Raw blocks store the xor with
+    the previous value, without its leading zero bytes. Blocks with
+    values too large for the quantization, or not finite, are raw.
+  */
+  static void EncodeBlock (FlatArray<double> x, double tol, Array<unsigned char> & out)
+  {
+    out.SetAllocSize (x.Size()+1);
+    out.SetSize (0);
+
+    bool quantize = tol > 0;
+    double scale = quantize ? 1.0 / (2*tol) : 0;
+    if (quantize)
+      for (double xi : x)
+        if (!(fabs(xi*scale) < 4.5e15))
+          {
+            quantize = false;
+            break;
+          }
+
+    out.Append (quantize ? SNAPSHOT_QUANTIZED : SNAPSHOT_RAW);
+    if (quantize)
+      {
+        int64_t prev = 0;
+        for (double xi : x)
+          {
+            int64_t q = llround (xi*scale);
+            int64_t d = q - prev;
+            prev = q;
+            PutVarint (out, (uint64_t(d) << 1) ^ uint64_t(d >> 63));
+          }
+      }
+    else
+      {
+        uint64_t prev = 0;
+        for (double xi : x)
+          {
+            uint64_t bits;
+            memcpy (&bits, &xi, sizeof(bits));
+            uint64_t d = bits ^ prev;
+            prev = bits;
+            int nbytes = 8;
+            while (nbytes > 0 && (d >> (8*(nbytes-1))) == 0)
+              nbytes--;
+            out.Append (nbytes);
+            for (int j = nbytes-1; j >= 0; j--)
+              out.Append ((d >> (8*j)) & 255);
+          }
+      }
+  }
+
+  static void DecodeBlock (const unsigned char * p, double tol, FlatArray<double> x)
+  {
+    if (*p++ == SNAPSHOT_QUANTIZED)
+      {
+        int64_t q = 0;
+        for (double & xi : x)
+          {
+            uint64_t z = GetVarint (p);
+            q += int64_t(z >> 1) ^ -int64_t(z & 1);
+            xi = (2*tol) * q;
+          }
+      }
+    else
+      {
+        uint64_t bits = 0;
+        for (double & xi : x)
+          {
+            int nbytes = *p++;
+            uint64_t d = 0;
+            for (int j = 0; j < nbytes; j++)
+              d = (d << 8) | *p++;
+            bits ^= d;
+            memcpy (&xi, &bits, sizeof(bits));
+          }
+      }
+  }
+
+
+  SnapshotStore :: SnapshotStore (string afilename, double atolerance, bool abackground)
+    : filename(afilename), tolerance(atolerance), background(abackground)
+  {
+    if (tolerance < 0)
+      throw Exception ("SnapshotStore: tolerance must not be negative");
+    if (filename.length())
+      {
+        out.open (filename, ios::binary | ios::trunc);
+        in.open (filename, ios::binary);
+        if (!out || !in)
+          throw Exception ("SnapshotStore: cannot open " + filename);
+      }
+  }
+
+  /*
+    A record is the byte size of every block, followed by the blocks.
+  */
+  void SnapshotStore :: Encode (FlatArray<double> values, Array<unsigned char> & rec,
+                                bool parallel) const
+  {
+    size_t nblocks = (values.Size() + snapshot_blocksize-1) / snapshot_blocksize;
+    Array<Array<unsigned char>> blocks(nblocks);
+
+    auto encode = [&] (size_t i)
+      {
+        size_t first = i*snapshot_blocksize;
+        size_t next = min2 (first+snapshot_blocksize, values.Size());
+        EncodeBlock (values.Range(first, next), tolerance, blocks[i]);
+      };
+    // background jobs must not use the task manager
+    if (parallel)
+      ParallelFor (nblocks, encode);
+    else
+      for (size_t i = 0; i < nblocks; i++)
+        encode(i);
+
+    size_t total = nblocks * sizeof(uint64_t);
+    for (auto & b : blocks)
+      total += b.Size();
+    rec.SetSize (total);
+
+    size_t pos = nblocks * sizeof(uint64_t);
+    for (size_t i = 0; i < nblocks; i++)
+      {
+        uint64_t size = blocks[i].Size();
+        memcpy (&rec[i*sizeof(uint64_t)], &size, sizeof(size));
+        memcpy (&rec[pos], &blocks[i][0], size);
+        pos += size;
+      }
+  }
+
+  void SnapshotStore :: Decode (const unsigned char * rec, FlatArray<double> values) const
+  {
+    size_t nblocks = (values.Size() + snapshot_blocksize-1) / snapshot_blocksize;
+    Array<size_t> first(nblocks);
+    size_t pos = nblocks * sizeof(uint64_t);
+    for (size_t i = 0; i < nblocks; i++)
+      {
+        uint64_t size;
+        memcpy (&size, rec+i*sizeof(uint64_t), sizeof(size));
+        first[i] = pos;
+        pos += size;
+      }
+
+    ParallelFor (nblocks, [&] (size_t i)
+                 {
+                   size_t begin = i*snapshot_blocksize;
+                   size_t end = min2 (begin+snapshot_blocksize, values.Size());
+                   DecodeBlock (rec+first[i], tolerance, values.Range(begin, end));
+                 });
+  }
+
+  void SnapshotStore :: Commit (Record & rec)
+  {
+    rec.bytes = rec.data.Size();
+    if (filename.length())
+      {
+        rec.offset = fileend;
+        if (rec.bytes)
+          out.write ((const char*)&rec.data[0], rec.bytes);
+        out.flush();
+        if (!out)
+          throw Exception ("SnapshotStore: cannot write " + filename);
+        fileend += rec.bytes;
+        rec.data = Array<unsigned char>();
+      }
+    rec.done = true;
+  }
+
+  size_t SnapshotStore :: Store (const BaseVector & v)
+  {
+    static Timer t("SnapshotStore::Store"); RegionTimer reg(t);
+
+    FlatVector<double> fv = v.FVDouble();
+    if (records.Size() == 0)
+      nvalues = fv.Size();
+    else if (fv.Size() != nvalues)
+      throw Exception ("SnapshotStore: vector has size " + ToString(fv.Size()) +
+                       ", the snapshots have size " + ToString(nvalues));
+
+    auto rec = make_shared<Record>();
+    FlatArray<double> values(nvalues, nvalues ? &fv(0) : nullptr);
+
+    if (!background)
+      {
+        Encode (values, rec->data, true);
+        Commit (*rec);
+        records.Append (rec);
+        return records.Size()-1;
+      }
+
+    // the staging copy is free when the previous snapshot is encoded
+    writer.Wait();
+    staging.SetSize (nvalues);
+    ParallelForRange (nvalues, [&] (IntRange r)
+                      {
+                        for (auto i : r)
+                          staging[i] = values[i];
+                      });
+    records.Append (rec);
+    writer.Submit ([this, rec] ()
+                   {
+                     Encode (staging, rec->data, false);
+                     Commit (*rec);
+                   });
+    return records.Size()-1;
+  }
+
+  void SnapshotStore :: Load (size_t nr, BaseVector & v)
+  {
+    static Timer t("SnapshotStore::Load"); RegionTimer reg(t);
+
+    if (nr >= records.Size())
+      throw Exception ("SnapshotStore: snapshot " + ToString(nr) + " not stored, have " +
+                       ToString(records.Size()));
+    auto & rec = *records[nr];
+    if (!rec.done)
+      writer.Wait();
+
+    FlatVector<double> fv = v.FVDouble();
+    if (fv.Size() != nvalues)
+      throw Exception ("SnapshotStore: vector has size " + ToString(fv.Size()) +
+                       ", the snapshots have size " + ToString(nvalues));
+    if (nvalues == 0) return;
+
+    if (filename.empty())
+      {
+        Decode (&rec.data[0], FlatArray<double> (nvalues, &fv(0)));
+        return;
+      }
+
+    // the writer may append later snapshots meanwhile, it has its own stream
+    Array<unsigned char> buffer(rec.bytes);
+    in.clear();
+    in.seekg (rec.offset);
+    in.read ((char*)&buffer[0], rec.bytes);
+    if (!in)
+      throw Exception ("SnapshotStore: cannot read snapshot " + ToString(nr) + " from " + filename);
+    Decode (&buffer[0], FlatArray<double> (nvalues, &fv(0)));
+  }
+
+  size_t SnapshotStore :: Bytes () const
+  {
+    size_t sum = 0;
+    for (auto & rec : records)
+      if (rec->done)
+        sum += rec->bytes;
+    return sum;
+  }
+
+}
@@ -0,0 +1,82 @@
+#ifndef FILE_SNAPSHOTSTORE
+#define FILE_SNAPSHOTSTORE
+
+/* ************************************************************************/
+/* File:   snapshotstore.hpp                                              */
+/* Date:   Oct. 2026                                                      */
+/* ************************************************************************/
+
+/*
+   Compressed storage of many vectors, e.g. the forward states of an
+   adjoint computation
+*/
+
+namespace ngla
+{
+
+  /**
+     Stores snapshots of vectors of one size, in memory or appended to
+     a file, and gives them back in any order by their number.
+
+     The values are delta-encoded in blocks. With tolerance > 0 they
+     are first rounded to multiples of 2*tolerance, the error of every
+     value is at most tolerance. With tolerance = 0 the snapshots are
+     lossless.
+
+     With background = true, Store only copies the vector while the
+     previous snapshot is encoded and written on a background thread.
+
+     Distributed vectors store the local values, every rank needs its
+     own file.
+   */
+  class NGS_DLL_HEADER SnapshotStore
+  {
+    struct Record
+    {
+      /// the encoded snapshot, empty after it went to the file
+      Array<unsigned char> data;
+      size_t offset = 0;
+      size_t bytes = 0;
+      atomic<bool> done{false};
+    };
+
+    string filename;
+    double tolerance;
+    bool background;
+    size_t nvalues = 0;
+
+    Array<shared_ptr<Record>> records;
+    ofstream out;
+    ifstream in;
+    size_t fileend = 0;
+    /// copy of the vector for the background job
+    Array<double> staging;
+    /// declared last, it finishes the jobs before the rest goes away
+    AsyncWriter writer;
+
+  public:
+    SnapshotStore (string afilename = "", double atolerance = 0, bool abackground = false);
+
+    /// stores a copy of v, returns the number of the snapshot
+    size_t Store (const BaseVector & v);
+    /// v = snapshot nr
+    void Load (size_t nr, BaseVector & v);
+    /// waits until all snapshots are encoded and written
+    void Wait () { writer.Wait(); }
+
+    size_t Size () const { return records.Size(); }
+    /// bytes of the encoded snapshots stored so far
+    size_t Bytes () const;
+    /// bytes the snapshots stored so far would need uncompressed
+    size_t RawBytes () const { return records.Size() * nvalues * sizeof(double); }
+    double GetTolerance () const { return tolerance; }
+
+  private:
+    void Encode (FlatArray<double> values, Array<unsigned char> & rec, bool parallel) const;
+    void Decode (const unsigned char * rec, FlatArray<double> values) const;
+    void Commit (Record & rec);
+  };
+
+}
+
+#endif
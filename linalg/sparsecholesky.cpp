@@ -7,107 +7,45 @@
 /* *************************************************************************/
 
 #include <la.hpp>
+#include <future>
 
-#include "concurrentqueue.h"
 #include <nginterface.h>
 
 
-typedef moodycamel::ConcurrentQueue<int> TQueue; 
-typedef moodycamel::ProducerToken TPToken; 
-typedef moodycamel::ConsumerToken TCToken; 
-
-
-namespace ngstd
-{
-  bool ProcessTask();
-}
-
 namespace ngla
 {
-  
-  static TQueue queue;
 
-
-  template <typename TFUNC>
-  void RunParallelDependency (const Table<int> & dag,
-                              const Table<int> & trans_dag, // transposed dag
-                              TFUNC func)
+  /*
+    Flops and bytes for the roofline report. The update of pivot i with
+    c_i off-diagonal entries touches c_i (c_i+1) / 2 entries of the
+    factor. The numeric factorization reads and writes the factor at
+    least once, a forward and backward solve reads it twice.
+   */
+  template <class TM>
+  static void AddFactorTraffic (Timer & t, FlatArray<size_t> firstinrow, size_t n, size_t nfact)
   {
-    Array<atomic<int>> cnt_dep(dag.Size());
-    for (auto i : Range(cnt_dep))
-      cnt_dep[i].store (trans_dag[i].Size(), memory_order_relaxed);
-    
-    Array<int> ready(dag.Size());
-    ready.SetSize0();
-    int num_final = 0;
-
-    for (int j : Range(cnt_dep))
-      {
-        if (cnt_dep[j] == 0) ready.Append(j);
-        if (dag[j].Size() == 0) num_final++;
-      }
-
-
-    if (!task_manager)
+    constexpr double sc = sizeof(typename mat_traits<TM>::TSCAL) / sizeof(double);
+    constexpr double h = mat_traits<TM>::HEIGHT;
+    double updates = 0;
+    for (size_t i = 0; i < n; i++)
       {
-        while (ready.Size())
-          {
-            int size = ready.Size();
-            int nr = ready[size-1];
-            ready.SetSize(size-1);
-            
-            func(nr);
-            
-            for (int j : dag[nr])
-              {
-                cnt_dep[j]--;
-                if (cnt_dep[j] == 0)
-                  ready.Append(j);
-              }
-          }
-        return;
+        double c = firstinrow[i+1]-firstinrow[i];
+        updates += c*(c+1) / 2;
       }
-
-    atomic<int> cnt_final(0);
-    SharedLoop sl(Range(ready));
-
-    task_manager -> CreateJob 
-      ([&] (const TaskInfo & ti)
-       {
-        TPToken ptoken(queue); 
-        TCToken ctoken(queue); 
-        
-        for (int i : sl)
-          queue.enqueue (ptoken, ready[i]);
-
-        while (1)
-           {
-             if (cnt_final >= num_final) break;
-
-             while (ProcessTask()); // do the nested tasks
-             
-             int nr;
-             if(!queue.try_dequeue_from_producer(ptoken, nr)) 
-               if(!queue.try_dequeue(ctoken, nr))  
-                 continue; 
-             
-             func(nr);
-
-             if (dag[nr].Size() == 0)
-               cnt_final++;
-
-             for (int j : dag[nr])
-               {
-                 if (--cnt_dep[j] == 0)
-                   queue.enqueue (ptoken, j);
-               }
-           }
-       });
+    t.AddFlops (2 * sc*sc * h*h*h * updates);
+    t.AddLoads (nfact * sizeof(TM));
+    t.AddStores (nfact * sizeof(TM));
   }
 
-
-
-
+  template <class TM, class TV>
+  static void AddSolveTraffic (Timer & t, size_t nfact, size_t nindex, size_t n, size_t k = 1)
+  {
+    constexpr double sc = sizeof(typename mat_traits<TM>::TSCAL) / sizeof(double);
+    constexpr double h = mat_traits<TM>::HEIGHT;
+    t.AddFlops (4 * sc*sc * h*h * nfact * k);
+    t.AddLoads (2 * (nfact * sizeof(TM) + nindex * sizeof(int)) + 3 * k * n * sizeof(TV));
+    t.AddStores (2 * k * n * sizeof(TV));
+  }
 
 
   template <class TM>
@@ -121,34 +59,16 @@ namespace ngla
 
 
 
-  template <class TM>
-  SparseCholeskyTM<TM> :: 
-  SparseCholeskyTM (const SparseMatrixTM<TM> & a, 
-                    shared_ptr<BitArray> ainner,
-                    shared_ptr<const Array<int>> acluster,
-                    bool allow_refactor)
-    : SparseFactorization (a, ainner, acluster), mat(a)
-  { 
-    static Timer t("SparseCholesky - total");
-    static Timer ta("SparseCholesky - allocate");
-    static Timer tf("SparseCholesky - fill factor");
-    RegionTimer reg(t);
-    // (*testout) << "matrix = " << a << endl;
-    // (*testout) << "diag a = ";
-    // for ( int i=0; i<a.Height(); i++ ) (*testout) << i << ", " << a(i,i) << endl;
-
-    int n = a.Height();
-    height = n;
-
-    int printstat = 0;
-    
-    if (printstat)
-      cout << IM(4) << "Minimal degree ordering: N = " << n << endl;
-    
-    clock_t starttime, endtime;
-    starttime = clock();
-    
-    mdo = new MinimumDegreeOrdering (n);
+  /*
+    The elimination of the graph of a, restricted to the inner dofs or
+    to the clusters. Gives the ordering and the pattern of the factor.
+  */
+  static MinimumDegreeOrdering *
+  SymbolicElimination (const MatrixGraph & a, shared_ptr<BitArray> inner,
+                       shared_ptr<const Array<int>> cluster, bool nested_dissection)
+  {
+    int n = a.Size();
+    auto mdo = new MinimumDegreeOrdering (n);
 
     if (inner)
       ParallelFor (n, [&] (size_t i)
@@ -214,11 +134,72 @@ namespace ngla
 	}
     */
 
+    // mdo -> PrintCliques ();
+    if (nested_dissection)
+      {
+        // same couplings as the mdo edges
+        auto coupled = [&] (int i, int col)
+          {
+            if (inner) return inner->Test(i) && inner->Test(col);
+            if (cluster) return (*cluster)[i] == (*cluster)[col] && (*cluster)[i] != 0;
+            return true;
+          };
+
+        BitArray used(n);
+        used.Clear();
+        for (int i = 0; i < n; i++)
+          if (!mdo->vertices[i].Eliminated())
+            used.Set(i);
+
+        TableCreator<int> creator(n);
+        for ( ; !creator.Done(); creator++)
+          for (int i = 0; i < n; i++)
+            if (used.Test(i))
+              for (int col : a.GetRowIndices(i))
+                if (col < i && coupled(i, col))
+                  {
+                    creator.Add (i, col);
+                    creator.Add (col, i);
+                  }
+        Table<int> graph = creator.MoveTable();
+
+        mdo->Order (NestedDissection (graph, used));
+      }
+    else
+      mdo->Order();
+    return mdo;
+  }
+
+
+  template <class TM>
+  SparseCholeskyTM<TM> :: 
+  SparseCholeskyTM (const SparseMatrixTM<TM> & a, 
+                    shared_ptr<BitArray> ainner,
+                    shared_ptr<const Array<int>> acluster,
+                    bool allow_refactor,
+                    bool nested_dissection)
+    : SparseFactorization (a, ainner, acluster), mat(a)
+  { 
+    static Timer t("SparseCholesky - total");
+    static Timer ta("SparseCholesky - allocate");
+    static Timer tf("SparseCholesky - fill factor");
+    RegionTimer reg(t);
+    // (*testout) << "matrix = " << a << endl;
+    // (*testout) << "diag a = ";
+    // for ( int i=0; i<a.Height(); i++ ) (*testout) << i << ", " << a(i,i) << endl;
+
+    int n = a.Height();
+    height = n;
+
+    int printstat = 0;
+    
     if (printstat)
-      cout << IM(4) << "start ordering" << endl;
+      cout << IM(4) << "Minimal degree ordering: N = " << n << endl;
     
-    // mdo -> PrintCliques ();
-    mdo->Order();
+    clock_t starttime, endtime;
+    starttime = clock();
+    
+    mdo = SymbolicElimination (a, inner, cluster, nested_dissection);
     nused = mdo->nused;
     endtime = clock();
     if (printstat)
@@ -241,6 +222,7 @@ namespace ngla
     diag.SetSize(nused);
     // lfact.SetSize (nze);
     lfact = NumaInterleavedArray<TM> (nze);
+    TrackMemory();
 
     // lfact = TM(0.0);     // first touch
     ParallelForRange (nze, [&] (IntRange r)
@@ -428,18 +410,11 @@ namespace ngla
     for (int i = 0; i < nused; i++)
       {
 	firstinrow[i] = cnt;
-	int ii = aorder[i];
-	int ncon = vertices[ii].nconnected;
+	int ncon = vertices[aorder[i]].nconnected;
 
 	if (blocknrs[i] == i)
 	  {
 	    firstinrow_ri[i] = cnt_master;
-
-	    for (int j = 0; j < ncon; j++)
-	      rowindex2[firstinrow_ri[i]+j] = order[vertices[ii].connected[j]];
-
-	    QuickSort (FlatArray<int> (ncon, &rowindex2[firstinrow_ri[i]]));
-
 	    cnt_master += ncon;
 	    cnt += ncon;
 	    maxrow = max2 (maxrow, ncon+1);
@@ -450,9 +425,21 @@ namespace ngla
 	    cnt += firstinrow[i]-firstinrow[i-1]-1;
 	  }
       }
-    tal2.Stop();
     firstinrow[nused] = cnt;
     firstinrow_ri[nused] = cnt_master;
+
+    // row-indices of the master rows, independent of each other
+    ParallelFor (nused, [&] (size_t i)
+                 {
+                   if (blocknrs[i] != int(i)) return;
+                   int ii = aorder[i];
+                   int ncon = vertices[ii].nconnected;
+                   auto rowind = rowindex2.Range (firstinrow_ri[i], firstinrow_ri[i]+ncon);
+                   for (int j = 0; j < ncon; j++)
+                     rowind[j] = order[vertices[ii].connected[j]];
+                   QuickSort (rowind);
+                 }, TasksPerThread(4));
+    tal2.Stop();
     
     
     for (int i = 1; i < blocknrs.Size(); i++)
@@ -485,33 +472,73 @@ namespace ngla
     for (int i = 0; i < blocks.Size()-1; i++)
       block_of_dof[Range(blocks[i], blocks[i+1])] = i;
 
+    // all rows of a block couple to the external dofs of the master row,
+    // which are sorted, so the dependent blocks come in ascending order
     tal3.Start();
-    DynamicTable<int> dep(blocks.Size()-1);
-    for (int i = 0; i < nused; i++)
+    block_dependency = ParallelCreateTable<int>
+      (blocks.Size()-1, [&] (ParallelTableCreator<int> & creator, size_t b)
+       {
+         if (BlockDofs(b).Size() == 0) return;
+         int last = -1;
+         for (int j : BlockExtDofs(b))
+           if (block_of_dof[j] != last)
+             {
+               last = block_of_dof[j];
+               creator.Add (b, last);
+             }
+       }, blocks.Size()-1);
+    tal3.Stop();
+
+    tal4.Start();
+    // small subtrees of the elimination tree are solved by one task,
+    // such that many tiny blocks don't drown the solve in task overhead.
+    // The parent of a block is the block of its first external dof
+    size_t nblocks = blocks.Size()-1;
+    constexpr size_t subtree_work = 4096;
+    Array<size_t> work(nblocks);
+    work = 0;
+    for (size_t b = 0; b < nblocks; b++)
       {
-        auto cols = rowindex2.Range(firstinrow_ri[i], firstinrow_ri[i+1]);
-        for (int j : cols)
-          if (block_of_dof[i] != block_of_dof[j])
-            dep.AddUnique (block_of_dof[i], block_of_dof[j]);
+        work[b] += firstinrow[blocks[b+1]] - firstinrow[blocks[b]] + BlockDofs(b).Size();
+        if (block_dependency[b].Size())
+          work[block_dependency[b][0]] += work[b];
+      }
+
+    Array<int> subtree_root(nblocks);
+    Array<int> subtree_size(nblocks);
+    subtree_size = 0;
+    for (size_t b = nblocks; b-- > 0; )
+      {
+        subtree_root[b] = -1;
+        if (work[b] >= subtree_work) continue;
+        int parent = block_dependency[b].Size() ? block_dependency[b][0] : -1;
+        subtree_root[b] = (parent != -1 && subtree_root[parent] != -1) ? subtree_root[parent] : b;
+        subtree_size[subtree_root[b]]++;
       }
-    tal3.Stop();
 
-    // generate compressed table
-    TableCreator<int> creator(dep.Size());
-    for ( ; !creator.Done(); creator++)
-      for (int i = 0; i < dep.Size(); i++)
-        for (int j : dep[i])
-          creator.Add(i, j);
+    Array<int> subtree_of(nblocks);
+    subtree_of = -1;
+    int nsubtrees = 0;
+    for (size_t b = nblocks; b-- > 0; )
+      {
+        int r = subtree_root[b];
+        if (r == -1 || subtree_size[r] < 2) continue;
+        subtree_of[b] = (r == int(b)) ? nsubtrees++ : subtree_of[r];
+      }
 
-    block_dependency = creator.MoveTable();
+    TableCreator<int> creator_sub(nsubtrees);
+    for ( ; !creator_sub.Done(); creator_sub++)
+      for (size_t b = 0; b < nblocks; b++)
+        if (subtree_of[b] != -1)
+          creator_sub.Add (subtree_of[b], b);
+    subtree_blocks = creator_sub.MoveTable();
 
-    tal4.Start();
     // genare micro-tasks:
-    Array<int> first_microtask;
-    for (int i = 0; i < blocks.Size()-1; i++)
+    Array<IntRange> block_tasks(nblocks);
+    for (size_t i = 0; i < nblocks; i++)
       {
-        // auto extdofs = BlockExtDofs (i);
-        first_microtask.Append (microtasks.Size());
+        if (subtree_of[i] != -1) continue;
+        size_t first = microtasks.Size();
 
         // int nb = extdofs.Size() / 256 + 1;
         // int nb = (extdofs.Size()+255) / 256;
@@ -550,8 +577,20 @@ namespace ngla
                 microtasks.Append (mt);
               }
           }
+        block_tasks[i] = IntRange(first, microtasks.Size());
+      }
+
+    for (int s = 0; s < nsubtrees; s++)
+      {
+        MicroTask mt;
+        mt.blocknr = s;
+        mt.type = MicroTask::S_BLOCK;
+        mt.bblock = 0;
+        mt.nbblocks = 0;
+        for (int b : subtree_blocks[s])
+          block_tasks[b] = IntRange(microtasks.Size(), microtasks.Size()+1);
+        microtasks.Append (mt);
       }
-    first_microtask.Append (microtasks.Size());
     tal4.Stop();
     tal5.Start();
     {
@@ -560,36 +599,54 @@ namespace ngla
       
       for ( ; !creator.Done(); creator++, creator_trans++)
         {
-          for (int i = 0; i < first_microtask.Size()-1; i++)
+          for (size_t i = 0; i < nblocks; i++)
             {
-              if (first_microtask[i+1] == first_microtask[i]+1)
+              if (subtree_of[i] != -1) continue;
+              if (block_tasks[i].Size() == 1)
                 { // just one LB block
-                  int b = first_microtask[i];
+                  int b = block_tasks[i].First();
                   for (int o : block_dependency[i])
                     {
-                      creator.Add (b, first_microtask[o]);
-                      creator_trans.Add (first_microtask[o], b);
+                      creator.Add (b, block_tasks[o].First());
+                      creator_trans.Add (block_tasks[o].First(), b);
                     }
                 }
               else
-                for (int b = first_microtask[i]+1; b < first_microtask[i+1]; b++)
+                for (int b = block_tasks[i].First()+1; b < block_tasks[i].Next(); b++)
                   {
                     // L to B dependency
-                    creator.Add (first_microtask[i], b);
-                    creator_trans.Add (b, first_microtask[i]);
+                    creator.Add (block_tasks[i].First(), b);
+                    creator_trans.Add (b, block_tasks[i].First());
                     
                     // B to L dependency
                     for (int o : block_dependency[i])
                       {
-                        creator.Add (b, first_microtask[o]);
-                        creator_trans.Add (first_microtask[o], b);
+                        creator.Add (b, block_tasks[o].First());
+                        creator_trans.Add (block_tasks[o].First(), b);
                       }
                   }
             }
+
+          // a subtree depends only on its own blocks, and its blocks
+          // couple only to large blocks outside
+          for (int s = 0; s < nsubtrees; s++)
+            {
+              int t = block_tasks[subtree_blocks[s][0]].First();
+              ArrayMem<int,32> succ;
+              for (int b : subtree_blocks[s])
+                for (int o : block_dependency[b])
+                  if (subtree_of[o] != s && !succ.Contains(block_tasks[o].First()))
+                    succ.Append (block_tasks[o].First());
+              for (int o : succ)
+                {
+                  creator.Add (t, o);
+                  creator_trans.Add (o, t);
+                }
+            }
         }
       tal5.Stop();
-      micro_dependency = creator.MoveTable();
-      micro_dependency_trans = creator_trans.MoveTable();
+      micro_graph.SetSuccessors (creator.MoveTable());
+      micro_graph_trans.SetSuccessors (creator_trans.MoveTable());
     }
   }
   
@@ -597,9 +654,62 @@ namespace ngla
 
 
 
+  template <class TM>
+  SparseCholeskyTM<TM> :: 
+  SparseCholeskyTM (const SparseMatrixTM<TM> & a, 
+                    const SparseCholeskyTM<TM> & symbolic)
+    : SparseFactorization (a, symbolic.inner, symbolic.cluster), mat(a)
+  {
+    static Timer t("SparseCholesky - reuse symbolic");
+    RegionTimer reg(t);
+
+    if (a.Height() != symbolic.height)
+      throw Exception ("SparseCholesky: matrix does not fit to the symbolic factorization");
+
+    height = symbolic.height;
+    nused = symbolic.nused;
+    nze = symbolic.nze;
+    order = symbolic.order;
+    inv_order = symbolic.inv_order;
+    firstinrow = symbolic.firstinrow;
+    rowindex2 = symbolic.rowindex2;
+    firstinrow_ri = symbolic.firstinrow_ri;
+    blocknrs = symbolic.blocknrs;
+    blocks = symbolic.blocks;
+    block_dependency = Table<int> (symbolic.block_dependency);
+    microtasks = symbolic.microtasks;
+    subtree_blocks = Table<int> (symbolic.subtree_blocks);
+    micro_graph = symbolic.micro_graph;
+    micro_graph_trans = symbolic.micro_graph_trans;
+    maxrow = symbolic.maxrow;
+    mdo = nullptr;
+
+    diag.SetSize (nused);
+    lfact = NumaInterleavedArray<TM> (nze);
+    TrackMemory();
+    FactorNew (a);
+  }
+
+
+  template <class TM>
+  void SparseCholeskyTM<TM> :: 
+  SwapOut (string filename)
+  {
+    static Timer t("SparseCholesky::SwapOut"); RegionTimer reg(t);
+    ofstream file(filename, ios::binary);
+    if (nze)
+      file.write (reinterpret_cast<const char*> (&lfact[0]), nze*sizeof(TM));
+    if (!file)
+      throw Exception ("SparseCholesky::SwapOut: cannot write "+filename);
+    factor_file = filename;
+    lfact = NumaInterleavedArray<TM> ();
+    TrackMemory();
+  }
+
+
   template <class TM>
   void SparseCholeskyTM<TM> :: 
-  FactorNew (const SparseMatrix<TM> & a)
+  FactorNew (const SparseMatrixTM<TM> & a)
   {
     if ( height != a.Height() )
       {
@@ -607,12 +717,23 @@ namespace ngla
 	return;
       }
 
+    string swapfile = factor_file;
+    if (IsSwappedOut())
+      {
+        lfact = NumaInterleavedArray<TM> (nze);
+        TrackMemory();
+        factor_file = "";
+      }
+
     TM id;
     id = 0.0;
     SetIdentity(id);
 
     // for (size_t i = 0; i < nze; i++) lfact[i] = 0.0;
-    lfact = TM(0.0);
+    ParallelForRange (nze, [&] (IntRange r)
+                      {
+                        lfact.Range(r) = TM(0.0);
+                      });
 
     if (!inner && !cluster)
       ParallelFor 
@@ -627,25 +748,30 @@ namespace ngla
          });
     
     else
-      
-      for (int i = 0; i < height; i++)
-        for (int j = 0; j < a.GetRowIndices(i).Size(); j++)
-          {
-            int col = a.GetRowIndices(i)[j];
+      // every row sets its own entries
+      ParallelFor 
+        (Range(height), [&](int i)
+         {
+           for (int j = 0; j < a.GetRowIndices(i).Size(); j++)
+             {
+               int col = a.GetRowIndices(i)[j];
             
-            if ((!inner && !cluster) || 
-                (inner && inner->Test(i) && inner->Test(col)) ||
-	      (!inner && cluster && (*cluster)[i] == (*cluster)[col] && (*cluster)[i]) )
-              {
-                if ( col <= i ) SetOrig (i, col, a.GetRowValues(i)[j]);
-              }
-            /*
-              else if (i == col)
-              SetOrig (i, i, id);
-            */
-          }
+               if ((!inner && !cluster) || 
+                   (inner && inner->Test(i) && inner->Test(col)) ||
+                   (!inner && cluster && (*cluster)[i] == (*cluster)[col] && (*cluster)[i]) )
+                 {
+                   if ( col <= i ) SetOrig (i, col, a.GetRowValues(i)[j]);
+                 }
+               /*
+                 else if (i == col)
+                 SetOrig (i, i, id);
+               */
+             }
+         }, TasksPerThread(5));
     
     FactorSPD(); 
+    if (swapfile != "")
+      SwapOut (swapfile);
   }
  
 
@@ -663,6 +789,7 @@ namespace ngla
 
     
     int n = nused; // Height();
+    AddFactorTraffic<TM> (factor_timer, firstinrow, n, lfact.Size());
     if (n > 2000){
       cout << IM(4) << " factor " << flush;
       Ng_PushStatus("SparseCholesky ordering");
@@ -1029,6 +1156,7 @@ namespace ngla
     RegionTimer reg (factor_timer);
     
     size_t n = nused; // Height();
+    AddFactorTraffic<TM> (factor_timer, firstinrow, n, lfact.Size());
     if (n > 20){
       cout << IM(4) << " factor SPD " << flush;
       Ng_PushStatus("SparseCholesky factoring");
@@ -1310,20 +1438,13 @@ namespace ngla
             creator_transitive.Add(block_dep_trans[i].Last(), i);
           }
     auto dep_transitive = creator_transitive.MoveTable();
-    
-    TableCreator<int> creator_trans2(block_dependency.Size());
-    for ( ; !creator_trans2.Done(); creator_trans2++)
-      for (int i : Range(dep_transitive))
-        for (int j : dep_transitive[i])
-          creator_trans2.Add(j, i);
-    auto dep_transitive_trans = creator_trans2.MoveTable();
 
     static Timer tdep("paralleldep");
     static Timer tdep1("paralleldep1");
     static Timer tdep2("paralleldep2");
     
-    RunParallelDependency
-      (dep_transitive, dep_transitive_trans, [&] (int blocknr)
+    TaskGraph(dep_transitive).Run
+      ([&] (int blocknr)
        {
          // for (size_t blocknr : Range(blocks.Size()-1))
         IntRange block = BlockDofs(blocknr);
@@ -1420,18 +1541,6 @@ namespace ngla
 #ifdef CHOLESKY_PARALLEL_ATOMIC
     
     
-    // first, find the transposed graph
-    
-    TableCreator<int> creator_trans(block_dependency.Size());
-    for ( ; !creator_trans.Done(); creator_trans++)
-      // for (int i : Range(block_dependency))
-      ParallelFor (block_dependency.Size(), [&] (int i)
-                   {
-                     for (int j : block_dependency[i])
-                       creator_trans.Add(j, i);
-                   });
-    auto block_dep_trans = creator_trans.MoveTable();
-
     /*
     static Timer tdep("paralleldep");
     static Timer tdep0("paralleldep0");
@@ -1441,8 +1550,8 @@ namespace ngla
     */
     Array<MyMutex> locks(n);
     
-    RunParallelDependency
-      (block_dependency, block_dep_trans, [&] (int blocknr)
+    TaskGraph(block_dependency).Run
+      ([&] (int blocknr)
        {
         IntRange block = BlockDofs(blocknr);
         // RegionTracer reg(TaskManager::GetThreadId(), tdep, block.Size());
@@ -1528,26 +1637,18 @@ namespace ngla
         {
           // RegionTracer reg3(TaskManager::GetThreadId(), tdep3, block.Size());
 
+          // the diagonal of the update B D B^T is already in A22
           size_t num_other = hfirstinrow[i1+1] - (hfirstinrow[i1] + last_same-i1-1);
           size_t j_ri = hfirstinrow_ri[i1] + last_same-i1-1;
 
           auto hdiag = diag.Addr(0);
-          ParallelFor (num_other, [=,&locks] (size_t j)
+          for (size_t j = 0; j < num_other; j++)
             {
               auto target_row = rowindex2[j_ri+j];
               locks[target_row].lock();
-
-              for (auto i2 : block)
-                {
-                  size_t first = hfirstinrow[i2] + block.Next()-i2-1;
-                  
-                  TM q = hdiag[i2] * hlfact[first+j];
-                  hdiag[target_row] -= Trans (hlfact[first+j]) * q;
-                }
-              
+              hdiag[target_row] += A22(j,j);
               locks[target_row].unlock();            
-            }, num_other > 50 ? TasksPerThread(1) : 1);  
-          
+            }
         }
         
        });
@@ -1726,9 +1827,128 @@ namespace ngla
 
 
 
-  template <class TM, class TV_ROW, class TV_COL>
+  /*
+    The rows of a supernode share the external dofs. The external
+    parts of the rows are not equally strided, they are passed by pointers.
+    Four rows are treated per pass over temp.
+  */
+
+  // temp += sum_k Trans(rows[k]) * x[k]
+  template <typename TM, typename TV>
+  INLINE void SupernodeAddTrans (FlatArray<const TM*> rows, FlatVector<TV> x, FlatVector<TV> temp)
+  {
+    size_t n = temp.Size(), k = 0;
+    for ( ; k+4 <= rows.Size(); k += 4)
+      {
+        const TM * p0 = rows[k], * p1 = rows[k+1], * p2 = rows[k+2], * p3 = rows[k+3];
+        TV x0 = x(k), x1 = x(k+1), x2 = x(k+2), x3 = x(k+3);
+        for (size_t j = 0; j < n; j++)
+          temp(j) += Trans(p0[j]) * x0 + Trans(p1[j]) * x1 + Trans(p2[j]) * x2 + Trans(p3[j]) * x3;
+      }
+    for ( ; k < rows.Size(); k++)
+      {
+        const TM * p0 = rows[k];
+        TV x0 = x(k);
+        for (size_t j = 0; j < n; j++)
+          temp(j) += Trans(p0[j]) * x0;
+      }
+  }
+
+  // res[k] = rows[k] * temp
+  template <typename TM, typename TV>
+  INLINE void SupernodeMult (FlatArray<const TM*> rows, FlatVector<TV> temp, FlatArray<TV> res)
+  {
+    size_t n = temp.Size(), k = 0;
+    for ( ; k+4 <= rows.Size(); k += 4)
+      {
+        const TM * p0 = rows[k], * p1 = rows[k+1], * p2 = rows[k+2], * p3 = rows[k+3];
+        TV s0(0.0), s1(0.0), s2(0.0), s3(0.0);
+        for (size_t j = 0; j < n; j++)
+          {
+            TV t = temp(j);
+            s0 += p0[j] * t;
+            s1 += p1[j] * t;
+            s2 += p2[j] * t;
+            s3 += p3[j] * t;
+          }
+        res[k] = s0; res[k+1] = s1; res[k+2] = s2; res[k+3] = s3;
+      }
+    for ( ; k < rows.Size(); k++)
+      {
+        const TM * p0 = rows[k];
+        TV s0(0.0);
+        for (size_t j = 0; j < n; j++)
+          s0 += p0[j] * temp(j);
+        res[k] = s0;
+      }
+  }
+
+  // the same for several right hand sides, the columns of x, temp and res
+  template <typename TM, typename TV>
+  INLINE void SupernodeAddTrans (FlatArray<const TM*> rows, FlatMatrix<TV> x, FlatMatrix<TV> temp)
+  {
+    size_t n = temp.Height(), nv = temp.Width(), k = 0;
+    for ( ; k+4 <= rows.Size(); k += 4)
+      {
+        const TM * p0 = rows[k], * p1 = rows[k+1], * p2 = rows[k+2], * p3 = rows[k+3];
+        for (size_t j = 0; j < n; j++)
+          {
+            TM l0 = Trans(p0[j]), l1 = Trans(p1[j]), l2 = Trans(p2[j]), l3 = Trans(p3[j]);
+            for (size_t c = 0; c < nv; c++)
+              temp(j,c) += l0 * x(k,c) + l1 * x(k+1,c) + l2 * x(k+2,c) + l3 * x(k+3,c);
+          }
+      }
+    for ( ; k < rows.Size(); k++)
+      {
+        const TM * p0 = rows[k];
+        for (size_t j = 0; j < n; j++)
+          {
+            TM l0 = Trans(p0[j]);
+            for (size_t c = 0; c < nv; c++)
+              temp(j,c) += l0 * x(k,c);
+          }
+      }
+  }
+
+  template <typename TM, typename TV>
+  INLINE void SupernodeMult (FlatArray<const TM*> rows, FlatMatrix<TV> temp, FlatMatrix<TV> res)
+  {
+    size_t n = temp.Height(), nv = temp.Width(), k = 0;
+    res = TV(0.0);
+    for ( ; k+4 <= rows.Size(); k += 4)
+      {
+        const TM * p0 = rows[k], * p1 = rows[k+1], * p2 = rows[k+2], * p3 = rows[k+3];
+        for (size_t j = 0; j < n; j++)
+          for (size_t c = 0; c < nv; c++)
+            {
+              TV t = temp(j,c);
+              res(k,c) += p0[j] * t;
+              res(k+1,c) += p1[j] * t;
+              res(k+2,c) += p2[j] * t;
+              res(k+3,c) += p3[j] * t;
+            }
+      }
+    for ( ; k < rows.Size(); k++)
+      {
+        const TM * p0 = rows[k];
+        for (size_t j = 0; j < n; j++)
+          for (size_t c = 0; c < nv; c++)
+            res(k,c) += p0[j] * temp(j,c);
+      }
+  }
+
+  // MultiVectors are real, other vector types use the default column loop
+  template <typename TV>
+  INLINE FlatMatrix<TV> MultiVectorEntries (const MultiVector & x)
+  { return FlatMatrix<TV> (0, 0, nullptr); }
+
+  template <>
+  INLINE FlatMatrix<double> MultiVectorEntries (const MultiVector & x)
+  { return x.FM(); }
+
+  template <class TM, class TV_ROW, class TV_COL> template <typename TF>
   void SparseCholesky<TM, TV_ROW, TV_COL> :: 
-  SolveReordered (FlatVector<TVX> hy) const
+  SolveReordered (FlatVector<TVX> hy, TF * factor) const
   {
     static Timer timer1("SparseCholesky<d,d,d>::MultAdd fac1");
     static Timer timer2("SparseCholesky<d,d,d>::MultAdd fac2");
@@ -1804,49 +2024,54 @@ namespace ngla
     */
     timer1.Start();
 
-    RunParallelDependency (micro_dependency, micro_dependency_trans,
-                           [&,hy] (int nr) 
+    // a whole block, first L then B
+    auto solve_block_lb = [&] (size_t blocknr)
+      {
+        auto range = BlockDofs (blocknr);
+        if (range.Size()==0) return;
+
+        for (auto i : range)
+          {
+            size_t size = range.end()-i-1;
+            if (size == 0) continue;
+            FlatVector<TF> vlfact(size, &factor[firstinrow[i]]);
+
+            TVX hyi = hy(i);
+            auto hyr = hy.Range(i+1, range.end());
+            for (size_t j = 0; j < size; j++)
+              hyr(j) -= Trans(vlfact(j)) * hyi;
+          }
+
+        auto extdofs = BlockExtDofs (blocknr);
+        if (extdofs.Size() == 0) return;
+        
+        VectorMem<520,TVX> temp(extdofs.Size());
+        temp = 0;
+        ArrayMem<const TF*,100> rows(range.Size());
+        for (auto k : Range(range))
+          rows[k] = &factor[firstinrow[range[k]] + range.Size()-k-1];
+        SupernodeAddTrans<TF,TVX> (rows, hy.Range(range), temp);
+        
+        for (size_t j : Range(extdofs))
+          MyAtomicAdd (hy(extdofs[j]), -temp(j));
+      };
+
+    micro_graph.Run ([&,hy] (int nr) 
                            {
                              auto task = microtasks[nr];
+                             if (task.type == MicroTask::S_BLOCK)
+                               {
+                                 for (int b : subtree_blocks[task.blocknr])
+                                   solve_block_lb (b);
+                                 return;
+                               }
                              size_t blocknr = task.blocknr;
                              auto range = BlockDofs (blocknr);
                              if (range.Size()==0) return;
                              
                              // if (task.solveL)
                              if (task.type == MicroTask::LB_BLOCK)
-                               { // first L, then B
-
-                                 auto extdofs = BlockExtDofs (blocknr);
-                                 VectorMem<520,TVX> temp(extdofs.Size());
-                                 temp = 0;
-
-                                 for (auto i : range)
-                                   {
-                                     TVX hyi = hy(i);
-                                     
-                                     size_t size = range.end()-i-1;
-                                     if (size > 0)
-                                       {
-                                         FlatVector<TM> vlfact(size, &lfact[firstinrow[i]]);
-                                         
-                                         auto hyr = hy.Range(i+1, range.end());
-                                         for (size_t j = 0; j < size; j++)
-                                           hyr(j) -= Trans(vlfact(j)) * hyi;
-                                       }
-                                     if (extdofs.Size() == 0)
-                                       {
-                                         // cerr << "should not be here" << endl;
-                                         continue;
-                                       }
-                                     size_t first = firstinrow[i] + range.end()-i-1;
-                                     FlatVector<TM> ext_lfact (extdofs.Size(), &lfact[first]);
-                                     for (size_t j = 0; j < temp.Size(); j++)
-                                       temp(j) += Trans(ext_lfact(j)) * hyi;
-                                   }
-                                 
-                                 for (size_t j : Range(extdofs))
-                                   MyAtomicAdd (hy(extdofs[j]), -temp(j));
-                               }
+                               solve_block_lb (blocknr);
                              
                              else if (task.type == MicroTask::L_BLOCK)
                                {
@@ -1855,7 +2080,7 @@ namespace ngla
                                    {
                                      size_t size = range.end()-i-1;
                                      if (size == 0) continue;
-                                     FlatVector<TM> vlfact(size, &lfact[firstinrow[i]]);
+                                     FlatVector<TF> vlfact(size, &factor[firstinrow[i]]);
 
                                      TVX hyi = hy(i);
                                      auto hyr = hy.Range(i+1, range.end());
@@ -1876,17 +2101,10 @@ namespace ngla
  
                                      VectorMem<520,TVX> temp(extdofs.Size());
                                      temp = 0;
-                                     
-                                     for (auto i : range)
-                                       {
-                                         size_t first = firstinrow[i] + range.end()-i-1;
-                                         
-                                         FlatVector<TM> ext_lfact (all_extdofs.Size(), &lfact[first]);
- 
-                                         TVX hyi = hy(i);
-                                         for (size_t j = 0; j < temp.Size(); j++)
-                                           temp(j) += Trans(ext_lfact(myr.begin()+j)) * hyi;
-                                       }
+                                     ArrayMem<const TF*,100> rows(range.Size());
+                                     for (auto k : Range(range))
+                                       rows[k] = &factor[firstinrow[range[k]] + range.Size()-k-1 + myr.begin()];
+                                     SupernodeAddTrans<TF,TVX> (rows, hy.Range(range), temp);
                                      
                                      for (size_t j : Range(extdofs))
                                        MyAtomicAdd (hy(extdofs[j]), -temp(j));
@@ -1915,49 +2133,59 @@ namespace ngla
       SolveBlockT (i, hy);
     */
 
+    // a whole block, first B then L
+    auto solve_block_lbt = [&] (size_t blocknr)
+      {
+        auto range = BlockDofs (blocknr);
+        if (range.Size()==0) return;
+
+        auto extdofs = BlockExtDofs (blocknr);
+        
+        VectorMem<520,TVX> temp(extdofs.Size());
+        for (auto j : Range(extdofs))
+          temp(j) = hy(extdofs[j]);
+
+        if (extdofs.Size())
+          {
+            ArrayMem<const TF*,100> rows(range.Size());
+            ArrayMem<TVX,100> vals(range.Size());
+            for (auto k : Range(range))
+              rows[k] = &factor[firstinrow[range[k]] + range.Size()-k-1];
+            SupernodeMult<TF,TVX> (rows, temp, vals);
+            for (auto k : Range(range))
+              hy(range[k]) -= vals[k];
+          }
+        for (size_t i = range.end()-1; i-- > range.begin(); )
+          {
+            size_t size = range.end()-i-1;
+            if (size == 0) continue;
+            FlatVector<TF> vlfact(size, &factor[firstinrow[i]]);
+            auto hyr = hy.Range(i+1, range.end());
+
+            TVX hyi = hy(i);
+            for (size_t j = 0; j < vlfact.Size(); j++)
+              hyi -= vlfact(j) * hyr(j);
+            hy(i) = hyi;
+          }
+      };
+
     // advanced parallel version 
-    RunParallelDependency (micro_dependency_trans, micro_dependency,
-                           [&,hy] (int nr) 
+    micro_graph_trans.Run ([&,hy] (int nr) 
                            {
                              auto task = microtasks[nr];
+                             if (task.type == MicroTask::S_BLOCK)
+                               {
+                                 auto sblocks = subtree_blocks[task.blocknr];
+                                 for (size_t k = sblocks.Size(); k-- > 0; )
+                                   solve_block_lbt (sblocks[k]);
+                                 return;
+                               }
                              int blocknr = task.blocknr;
                              auto range = BlockDofs (blocknr);
                              if (range.Size()==0) return;
                              
                              if (task.type == MicroTask::LB_BLOCK)
-                               { // first B then L
-
-                                 auto extdofs = BlockExtDofs (blocknr);
-                                 
-                                 VectorMem<520,TVX> temp(extdofs.Size());
-                                 for (auto j : Range(extdofs))
-                                   temp(j) = hy(extdofs[j]);
-
-                                 if (extdofs.Size())
-                                   for (auto i : range)
-                                     {
-                                       size_t first = firstinrow[i] + range.end()-i-1;
-                                       FlatVector<TM> ext_lfact (extdofs.Size(), &lfact[first]);
-                                       
-                                       TVX val(0.0);
-                                       for (auto j : Range(extdofs))
-                                         val += ext_lfact(j) * temp(j);
-                                       hy(i) -= val;
-                                     }
-                                 for (size_t i = range.end()-1; i-- > range.begin(); )
-                                   {
-                                     size_t size = range.end()-i-1;
-                                     if (size == 0) continue;
-                                     FlatVector<TM> vlfact(size, &lfact[firstinrow[i]]);
-                                     auto hyr = hy.Range(i+1, range.end());
-
-                                     TVX hyi = hy(i);
-                                     for (size_t j = 0; j < vlfact.Size(); j++)
-                                       hyi -= vlfact(j) * hyr(j);
-                                     hy(i) = hyi;
-                                   }
-                                 
-                               }
+                               solve_block_lbt (blocknr);
                              else if (task.type == MicroTask::L_BLOCK)                               
                                {
                                  // for (int i = range.end()-1; i >= range.begin(); i--)
@@ -1966,7 +2194,7 @@ namespace ngla
                                    {
                                      size_t size = range.end()-i-1;
                                      if (size == 0) continue;
-                                     FlatVector<TM> vlfact(size, &lfact[firstinrow[i]]);
+                                     FlatVector<TF> vlfact(size, &factor[firstinrow[i]]);
                                      auto hyr = hy.Range(i+1, range.end());
 
                                      TVX hyi = hy(i);
@@ -1990,16 +2218,13 @@ namespace ngla
                                      for (auto j : Range(extdofs))
                                        temp(j) = hy(extdofs[j]);
     
-                                     for (auto i : range)
-                                       {
-                                         size_t first = firstinrow[i] + range.end()-i-1;
-                                         FlatVector<TM> ext_lfact (all_extdofs.Size(), &lfact[first]);
-    
-                                         TVX val(0.0);
-                                         for (auto j : Range(extdofs))
-                                           val += ext_lfact(myr.begin()+j) * temp(j);
-                                         MyAtomicAdd (hy(i), -val);
-                                       }
+                                     ArrayMem<const TF*,100> rows(range.Size());
+                                     ArrayMem<TVX,100> vals(range.Size());
+                                     for (auto k : Range(range))
+                                       rows[k] = &factor[firstinrow[range[k]] + range.Size()-k-1 + myr.begin()];
+                                     SupernodeMult<TF,TVX> (rows, temp, vals);
+                                     for (auto k : Range(range))
+                                       MyAtomicAdd (hy(range[k]), -vals[k]);
                                    }
                                }
                            });
@@ -2009,13 +2234,314 @@ namespace ngla
     
   }
 
+  template <class TM, class TV_ROW, class TV_COL>
+  void SparseCholesky<TM, TV_ROW, TV_COL> :: 
+  SolveReorderedOutOfCore (FlatVector<TVX> hy) const
+  {
+    static Timer t("SparseCholesky::Solve out-of-core"); RegionTimer reg(t);
+    static Timer tr("SparseCholesky::Solve out-of-core - wait for read");
+
+    ifstream file(this->factor_file, ios::binary);
+    if (!file)
+      throw Exception ("SparseCholesky: cannot read factor file "+this->factor_file);
+
+    int nblocks = blocks.Size()-1;
+    auto panel_begin = [&] (int b) { return firstinrow[blocks[b]]; };
+    auto read_panel = [&] (int b, Array<TM> & buffer)
+      {
+        size_t first = panel_begin(b), next = firstinrow[blocks[b+1]];
+        buffer.SetSize (next-first);
+        if (next == first) return;
+        file.seekg (first*sizeof(TM));
+        file.read (reinterpret_cast<char*> (&buffer[0]), (next-first)*sizeof(TM));
+      };
+
+    // visit the blocks in the order of the sequence, with the panel of the
+    // next block read asynchronously while the current one is processed
+    auto stream_panels = [&] (FlatArray<int> sequence, auto func)
+      {
+        Array<TM> current, next;
+        future<void> prefetch = async (launch::async, [&] { read_panel (sequence[0], next); });
+        for (size_t k = 0; k < sequence.Size(); k++)
+          {
+            tr.Start();
+            prefetch.get();
+            tr.Stop();
+            if (!file)
+              throw Exception ("SparseCholesky: reading factor file "+this->factor_file+" failed");
+            current.Swap (next);
+            if (k+1 < sequence.Size())
+              prefetch = async (launch::async, [&,k] { read_panel (sequence[k+1], next); });
+            func (sequence[k], current);
+          }
+      };
+
+    if (nblocks == 0) return;
+    Array<int> sequence(nblocks);
+    for (int b = 0; b < nblocks; b++)
+      sequence[b] = b;
+
+    // elimination dependencies point to later blocks
+    stream_panels (sequence, [&] (int b, FlatArray<TM> panel)
+                   {
+                     auto range = BlockDofs (b);
+                     if (range.Size()==0) return;
+                     size_t first = panel_begin(b);
+                     auto p = [&] (size_t pos) -> TM* { return panel.Addr(pos-first); };
+
+                     for (auto i : range)
+                       {
+                         size_t size = range.end()-i-1;
+                         FlatVector<TM> vlfact(size, p(firstinrow[i]));
+                         TVX hyi = hy(i);
+                         auto hyr = hy.Range(i+1, range.end());
+                         for (size_t j = 0; j < size; j++)
+                           hyr(j) -= Trans(vlfact(j)) * hyi;
+                       }
+
+                     auto extdofs = BlockExtDofs (b);
+                     if (extdofs.Size() == 0) return;
+                     Vector<TVX> temp(extdofs.Size());
+                     temp = 0;
+                     ArrayMem<const TM*,100> rows(range.Size());
+                     for (auto k : Range(range))
+                       rows[k] = p(firstinrow[range[k]] + range.Size()-k-1);
+                     SupernodeAddTrans<TM,TVX> (rows, hy.Range(range), temp);
+                     for (size_t j : Range(extdofs))
+                       hy(extdofs[j]) -= temp(j);
+                   });
+
+    ParallelFor (hy.Size(), [&] (int i)
+                 {
+                   TVX tmp = diag[i] * hy[i];
+                   hy[i] = tmp;
+                 });
+
+    for (int b = 0; b < nblocks; b++)
+      sequence[b] = nblocks-1-b;
+
+    stream_panels (sequence, [&] (int b, FlatArray<TM> panel)
+                   {
+                     auto range = BlockDofs (b);
+                     if (range.Size()==0) return;
+                     size_t first = panel_begin(b);
+                     auto p = [&] (size_t pos) -> TM* { return panel.Addr(pos-first); };
+
+                     auto extdofs = BlockExtDofs (b);
+                     if (extdofs.Size())
+                       {
+                         Vector<TVX> temp(extdofs.Size());
+                         for (auto j : Range(extdofs))
+                           temp(j) = hy(extdofs[j]);
+                         ArrayMem<const TM*,100> rows(range.Size());
+                         ArrayMem<TVX,100> vals(range.Size());
+                         for (auto k : Range(range))
+                           rows[k] = p(firstinrow[range[k]] + range.Size()-k-1);
+                         SupernodeMult<TM,TVX> (rows, temp, vals);
+                         for (auto k : Range(range))
+                           hy(range[k]) -= vals[k];
+                       }
+
+                     for (size_t i = range.end()-1; i-- > range.begin(); )
+                       {
+                         size_t size = range.end()-i-1;
+                         FlatVector<TM> vlfact(size, p(firstinrow[i]));
+                         auto hyr = hy.Range(i+1, range.end());
+                         TVX hyi = hy(i);
+                         for (size_t j = 0; j < size; j++)
+                           hyi -= vlfact(j) * hyr(j);
+                         hy(i) = hyi;
+                       }
+                   });
+  }
+
+
+  template <class TM, class TV_ROW, class TV_COL>
+  void SparseCholesky<TM, TV_ROW, TV_COL> :: 
+  SolveReorderedMulti (FlatMatrix<TVX> hy) const
+  {
+    static Timer timer1("SparseCholesky::SolveMulti L");
+    static Timer timer2("SparseCholesky::SolveMulti L^T");
+    size_t nv = hy.Width();
+
+    // solve within the block, every row of the factor is read once for all vectors
+    auto solve_block_lower = [&] (IntRange range)
+      {
+        for (auto i : range)
+          {
+            size_t size = range.end()-i-1;
+            const TM * vlfact = &lfact[firstinrow[i]];
+            for (size_t j = 0; j < size; j++)
+              {
+                TM l = Trans(vlfact[j]);
+                for (size_t c = 0; c < nv; c++)
+                  hy(i+1+j,c) -= l * hy(i,c);
+              }
+          }
+      };
+    auto solve_block_upper = [&] (IntRange range)
+      {
+        for (size_t i = range.end()-1; i-- > range.begin(); )
+          {
+            size_t size = range.end()-i-1;
+            const TM * vlfact = &lfact[firstinrow[i]];
+            for (size_t j = 0; j < size; j++)
+              for (size_t c = 0; c < nv; c++)
+                hy(i,c) -= vlfact[j] * hy(i+1+j,c);
+          }
+      };
+
+    // rows of the supernode, restricted to the external dofs [first, next)
+    auto supernode_rows = [&] (IntRange range, size_t first, FlatArray<const TM*> rows)
+      {
+        for (auto k : Range(range))
+          rows[k] = &lfact[firstinrow[range[k]] + range.Size()-k-1 + first];
+      };
+
+    timer1.Start();
+    auto forward = [&] (MicroTask task)
+                     {
+                       auto range = BlockDofs (task.blocknr);
+                       if (range.Size()==0) return;
+
+                       if (task.type != MicroTask::B_BLOCK)
+                         solve_block_lower (range);
+                       if (task.type == MicroTask::L_BLOCK)
+                         return;
+
+                       auto all_extdofs = BlockExtDofs (task.blocknr);
+                       if (all_extdofs.Size() == 0) return;
+                       IntRange myr = Range(all_extdofs);
+                       if (task.type == MicroTask::B_BLOCK)
+                         myr = myr.Split (task.bblock, task.nbblocks);
+                       auto extdofs = all_extdofs.Range(myr);
+
+                       Matrix<TVX> temp(extdofs.Size(), nv);
+                       temp = TVX(0.0);
+                       ArrayMem<const TM*,100> rows(range.Size());
+                       supernode_rows (range, myr.begin(), rows);
+                       SupernodeAddTrans<TM,TVX> (rows, hy.Rows(range), temp);
+
+                       for (size_t j : Range(extdofs))
+                         for (size_t c = 0; c < nv; c++)
+                           MyAtomicAdd (hy(extdofs[j],c), -temp(j,c));
+                     };
+
+    micro_graph.Run ([&] (int nr) 
+                     {
+                       auto task = microtasks[nr];
+                       if (task.type != MicroTask::S_BLOCK)
+                         forward (task);
+                       else
+                         for (int b : subtree_blocks[task.blocknr])
+                           forward (MicroTask{b, MicroTask::LB_BLOCK, 0, 1});
+                     });
+    timer1.Stop();
+
+    // solve with the diagonal
+    ParallelFor (hy.Height(), [&] (size_t i)
+                 {
+                   for (size_t c = 0; c < nv; c++)
+                     {
+                       TVX tmp = diag[i] * hy(i,c);
+                       hy(i,c) = tmp;
+                     }
+                 });
+
+    timer2.Start();
+    auto backward = [&] (MicroTask task)
+                           {
+                             auto range = BlockDofs (task.blocknr);
+                             if (range.Size()==0) return;
+
+                             auto all_extdofs = BlockExtDofs (task.blocknr);
+                             if (task.type != MicroTask::L_BLOCK && all_extdofs.Size())
+                               {
+                                 IntRange myr = Range(all_extdofs);
+                                 if (task.type == MicroTask::B_BLOCK)
+                                   myr = myr.Split (task.bblock, task.nbblocks);
+                                 auto extdofs = all_extdofs.Range(myr);
+
+                                 Matrix<TVX> temp(extdofs.Size(), nv);
+                                 for (auto j : Range(extdofs))
+                                   temp.Row(j) = hy.Row(extdofs[j]);
+
+                                 ArrayMem<const TM*,100> rows(range.Size());
+                                 supernode_rows (range, myr.begin(), rows);
+                                 Matrix<TVX> vals(range.Size(), nv);
+                                 SupernodeMult<TM,TVX> (rows, temp, vals);
+
+                                 if (task.type == MicroTask::LB_BLOCK)
+                                   hy.Rows(range) -= vals;
+                                 else
+                                   for (auto k : Range(range))
+                                     for (size_t c = 0; c < nv; c++)
+                                       MyAtomicAdd (hy(range[k],c), -vals(k,c));
+                               }
+
+                             if (task.type != MicroTask::B_BLOCK)
+                               solve_block_upper (range);
+                           };
+
+    micro_graph_trans.Run ([&] (int nr) 
+                           {
+                             auto task = microtasks[nr];
+                             if (task.type != MicroTask::S_BLOCK)
+                               backward (task);
+                             else
+                               {
+                                 auto sblocks = subtree_blocks[task.blocknr];
+                                 for (size_t k = sblocks.Size(); k-- > 0; )
+                                   backward (MicroTask{sblocks[k], MicroTask::LB_BLOCK, 0, 1});
+                               }
+                           });
+    timer2.Stop();
+  }
+
+
+  template <class TM, class TV_ROW, class TV_COL>
+  void SparseCholesky<TM, TV_ROW, TV_COL> :: 
+  MultAdd (double s, const MultiVector & x, MultiVector & y) const
+  {
+    if (!is_same<TVX,double>::value || this->IsSwappedOut())
+      {
+        BaseMatrix::MultAdd (s, x, y);
+        return;
+      }
+
+    static Timer timer("SparseCholesky::MultAdd (MultiVector)");
+    RegionTimer reg (timer);
+    size_t nv = x.NumVectors();
+    AddSolveTraffic<TM,TVX> (timer, lfact.Size(), this->rowindex2.Size(), this->nused, nv);
+
+    FlatMatrix<TVX> fx = MultiVectorEntries<TVX> (x);
+    FlatMatrix<TVX> fy = MultiVectorEntries<TVX> (y);
+
+    Matrix<TVX> hy(this->nused, nv);
+    ParallelFor (Range(height), [&] (int i)
+                 {
+                   if (order[i] != -1)
+                     hy.Row(order[i]) = fx.Row(i);
+                 });
+
+    SolveReorderedMulti (hy);
+
+    ParallelFor (Range(height), [&] (int i)
+                 {
+                   bool used = inner ? inner->Test(i) :
+                     (cluster ? (*cluster)[i] != 0 : order[i] != -1);
+                   if (used)
+                     fy.Row(i) += s * hy.Row(order[i]);
+                 });
+  }
+
   template <class TM, class TV_ROW, class TV_COL>
   void SparseCholesky<TM, TV_ROW, TV_COL> :: 
   MultAdd (TSCAL_VEC s, const BaseVector & x, BaseVector & y) const
   {
     static Timer timer("SparseCholesky<d,d,d>::MultAdd");
     RegionTimer reg (timer);
-    timer.AddFlops (2.0*lfact.Size());
+    AddSolveTraffic<TM,TVX> (timer, lfact.Size(), this->rowindex2.Size(), this->nused);
 
     // int n = Height();
     
@@ -2107,6 +2633,404 @@ namespace ngla
 
 
 
+  SparseCholeskyMixed ::
+  SparseCholeskyMixed (const SparseMatrixTM<double> & a, 
+                       shared_ptr<BitArray> ainner,
+                       shared_ptr<const Array<int>> acluster,
+                       double atol, int amaxsteps)
+    : SparseCholesky<double> (a, ainner, acluster), tol(atol), maxsteps(amaxsteps)
+  {
+    RoundFactor();
+  }
+
+  void SparseCholeskyMixed :: RoundFactor ()
+  {
+    lfact_float = NumaInterleavedArray<float> (nze);
+    TrackMemory (lfact_float.OwnedBytes());
+    ParallelForRange (nze, [&] (IntRange r)
+                      {
+                        for (auto i : r)
+                          lfact_float[i] = lfact[i];
+                      });
+    lfact = NumaInterleavedArray<double> ();
+    TrackMemory (lfact_float.OwnedBytes());
+  }
+
+  void SparseCholeskyMixed :: Update ()
+  {
+    lfact = NumaInterleavedArray<double> (nze);
+    TrackMemory (lfact_float.OwnedBytes());
+    BASE::Update();
+    RoundFactor();
+  }
+
+  void SparseCholeskyMixed :: 
+  MultAdd (double s, const BaseVector & x, BaseVector & y) const
+  {
+    static Timer timer("SparseCholeskyMixed::MultAdd");
+    RegionTimer reg (timer);
+
+    auto amat = matrix.lock();
+    auto fx = x.FV<double> ();
+    auto fy = y.FV<double> ();
+
+    VVector<double> u(height), au(height);
+    auto fu = u.FV<double> ();
+    auto fau = au.FV<double> ();
+    Vector<double> r(height), hy(nused);
+
+    // residual on the dofs of the factorization
+    auto residual = [&] ()
+      {
+        ParallelFor (Range(height), [&] (int i)
+                     {
+                       r(i) = (order[i] != -1) ? fx(i) - fau(i) : 0.0;
+                     });
+        return L2Norm (r);
+      };
+
+    fu = 0.0;
+    fau = 0.0;
+    double norm0 = residual();
+    double lastnorm = norm0;
+
+    // iterative refinement, stops at tol or when the residual stagnates
+    for (int it = 0; it < maxsteps && lastnorm > tol*norm0; it++)
+      {
+        ParallelFor (Range(height), [&] (int i)
+                     {
+                       if (order[i] != -1)
+                         hy(order[i]) = r(i);
+                     });
+        SolveReordered<float> (hy, lfact_float.Addr(0));
+        ParallelFor (Range(height), [&] (int i)
+                     {
+                       if (order[i] != -1)
+                         fu(i) += hy(order[i]);
+                     });
+
+        amat->Mult (u, au);
+        double norm = residual();
+        if (norm >= lastnorm) break;
+        lastnorm = norm;
+      }
+
+    ParallelFor (Range(height), [&] (int i)
+                 {
+                   fy(i) += s * fu(i);
+                 });
+  }
+
+  
+
+
+  SparseCholeskyBLR ::
+  SparseCholeskyBLR (const SparseMatrixTM<double> & a, 
+                     shared_ptr<BitArray> ainner,
+                     double atol, int aminsize)
+    : SparseCholesky<double> (a, ainner, nullptr), tol(atol), minsize(aminsize)
+  {
+    // ancestors are solved first in the backward substitution
+    size_t nblocks = blocks.Size()-1;
+    TableCreator<int> creator_trans(nblocks);
+    for ( ; !creator_trans.Done(); creator_trans++)
+      for (size_t b : Range(nblocks))
+        for (int o : block_dependency[b])
+          creator_trans.Add (o, b);
+    block_graph_trans.SetSuccessors (creator_trans.MoveTable());
+
+    Compress();
+  }
+
+  void SparseCholeskyBLR :: Compress ()
+  {
+    static Timer t("SparseCholeskyBLR::Compress"); RegionTimer reg(t);
+
+    size_t nblocks = blocks.Size()-1;
+    rank.SetSize (nblocks);
+    Array<Matrix<double>> lowrank_u(nblocks), lowrank_v(nblocks);
+
+    // row k of the panel of block b, B(k,j) = row[j]
+    auto panel_row = [&] (IntRange range, size_t k)
+      {
+        return &lfact[firstinrow[range[k]] + range.Size()-k-1];
+      };
+
+    ParallelFor (nblocks, [&] (size_t b)
+      {
+        rank[b] = -1;
+        auto range = BlockDofs(b);
+        if (range.Size() == 0) return;
+        size_t ns = range.Size();
+        size_t ne = BlockExtDofs(b).Size();
+        if (ns < size_t(minsize) || ne < size_t(minsize)) return;
+
+        // adaptive cross approximation with full pivoting
+        Matrix<double> r(ns, ne);
+        for (size_t k = 0; k < ns; k++)
+          r.Row(k) = FlatVector<double> (ne, panel_row(range, k));
+
+        double maxb = 0;
+        for (size_t k = 0; k < ns; k++)
+          for (size_t j = 0; j < ne; j++)
+            maxb = max2 (maxb, fabs(r(k,j)));
+
+        size_t maxrank = ns*ne / (ns+ne);
+        Matrix<double> u(ns, maxrank), v(ne, maxrank);
+        size_t cnt = 0;
+        for ( ; cnt < maxrank; cnt++)
+          {
+            size_t pi = 0, pj = 0;
+            double maxr = 0;
+            for (size_t k = 0; k < ns; k++)
+              for (size_t j = 0; j < ne; j++)
+                if (fabs(r(k,j)) > maxr)
+                  {
+                    maxr = fabs(r(k,j));
+                    pi = k; pj = j;
+                  }
+            if (maxr <= tol * maxb) break;
+
+            double piv = r(pi,pj);
+            u.Col(cnt) = r.Col(pj);
+            v.Col(cnt) = (1.0/piv) * Trans(r).Col(pi);
+            r -= u.Col(cnt) * Trans(v.Col(cnt));
+          }
+
+        // not shorter than the dense panel
+        if (cnt == maxrank) return;
+
+        rank[b] = cnt;
+        lowrank_u[b].SetSize (ns, cnt);
+        lowrank_u[b] = u.Cols(0, cnt);
+        lowrank_v[b].SetSize (ne, cnt);
+        lowrank_v[b] = v.Cols(0, cnt);
+      }, TasksPerThread(4));
+
+    first_entry.SetSize (nblocks+1);
+    first_entry[0] = 0;
+    for (size_t b = 0; b < nblocks; b++)
+      {
+        size_t ns = BlockDofs(b).Size();
+        size_t ne = ns ? BlockExtDofs(b).Size() : 0;
+        size_t panel = (rank[b] == -1) ? ns*ne : rank[b]*(ns+ne);
+        first_entry[b+1] = first_entry[b] + ns*(ns-1)/2 + panel;
+      }
+
+    // block b: triangle row by row, then the dense rows of B, or U and V column by column
+    factor.SetSize (first_entry[nblocks]);
+    ParallelFor (nblocks, [&] (size_t b)
+      {
+        auto range = BlockDofs(b);
+        if (range.Size() == 0) return;
+        size_t ns = range.Size();
+        size_t ne = BlockExtDofs(b).Size();
+        double * dest = &factor[first_entry[b]];
+        for (size_t k = 0; k < ns; k++)
+          for (size_t j = 0; j < ns-k-1; j++)
+            *dest++ = lfact[firstinrow[range[k]]+j];
+
+        if (rank[b] == -1)
+          {
+            for (size_t k = 0; k < ns; k++)
+              for (size_t j = 0; j < ne; j++)
+                *dest++ = panel_row(range, k)[j];
+          }
+        else
+          for (int l = 0; l < rank[b]; l++)
+            {
+              for (size_t k = 0; k < ns; k++)
+                *dest++ = lowrank_u[b](k,l);
+              for (size_t j = 0; j < ne; j++)
+                *dest++ = lowrank_v[b](j,l);
+            }
+      }, TasksPerThread(4));
+
+    lfact = NumaInterleavedArray<double> ();
+    TrackMemory (factor.OwnedBytes());
+  }
+
+  size_t SparseCholeskyBLR :: NumCompressed () const
+  {
+    size_t cnt = 0;
+    for (int r : rank)
+      if (r != -1) cnt++;
+    return cnt;
+  }
+
+  void SparseCholeskyBLR :: Update ()
+  {
+    lfact = NumaInterleavedArray<double> (nze);
+    TrackMemory (factor.OwnedBytes());
+    BASE::Update();
+    Compress();
+  }
+
+  void SparseCholeskyBLR :: SolveBLR (FlatVector<double> hy) const
+  {
+    static Timer t("SparseCholeskyBLR::Solve"); RegionTimer reg(t);
+
+    TaskGraph(block_dependency).Run ([&] (int b)
+      {
+        auto range = BlockDofs(b);
+        if (range.Size() == 0) return;
+        size_t ns = range.Size();
+        auto extdofs = BlockExtDofs(b);
+        size_t ne = extdofs.Size();
+        const double * fac = &factor[first_entry[b]];
+
+        for (size_t k = 0; k < ns; k++)
+          {
+            double hyk = hy(range[k]);
+            for (size_t j = 0; j < ns-k-1; j++)
+              hy(range[k]+1+j) -= fac[j] * hyk;
+            fac += ns-k-1;
+          }
+        if (ne == 0) return;
+
+        // temp = B^T hy(range)
+        VectorMem<100> temp(ne);
+        temp = 0.0;
+        if (rank[b] == -1)
+          for (size_t k = 0; k < ns; k++)
+            for (size_t j = 0; j < ne; j++)
+              temp(j) += fac[k*ne+j] * hy(range[k]);
+        else
+          for (int l = 0; l < rank[b]; l++, fac += ns+ne)
+            {
+              double ul = 0;
+              for (size_t k = 0; k < ns; k++)
+                ul += fac[k] * hy(range[k]);
+              for (size_t j = 0; j < ne; j++)
+                temp(j) += ul * fac[ns+j];
+            }
+
+        for (size_t j : Range(extdofs))
+          MyAtomicAdd (hy(extdofs[j]), -temp(j));
+      });
+
+    ParallelFor (hy.Size(), [&] (size_t i)
+                 {
+                   hy(i) *= diag[i];
+                 });
+
+    block_graph_trans.Run ([&] (int b)
+      {
+        auto range = BlockDofs(b);
+        if (range.Size() == 0) return;
+        size_t ns = range.Size();
+        auto extdofs = BlockExtDofs(b);
+        size_t ne = extdofs.Size();
+        const double * tri = &factor[first_entry[b]];
+        const double * fac = tri + ns*(ns-1)/2;
+
+        // hy(range) -= B hy(extdofs)
+        if (ne)
+          {
+            VectorMem<100> temp(ne);
+            for (size_t j : Range(extdofs))
+              temp(j) = hy(extdofs[j]);
+            if (rank[b] == -1)
+              for (size_t k = 0; k < ns; k++)
+                {
+                  double sum = 0;
+                  for (size_t j = 0; j < ne; j++)
+                    sum += fac[k*ne+j] * temp(j);
+                  hy(range[k]) -= sum;
+                }
+            else
+              for (int l = 0; l < rank[b]; l++, fac += ns+ne)
+                {
+                  double vl = 0;
+                  for (size_t j = 0; j < ne; j++)
+                    vl += fac[ns+j] * temp(j);
+                  for (size_t k = 0; k < ns; k++)
+                    hy(range[k]) -= vl * fac[k];
+                }
+          }
+
+        // first entry of triangle row k
+        size_t first = ns*(ns-1)/2;
+        for (size_t k = ns; k-- > 0; )
+          {
+            first -= ns-k-1;
+            double sum = 0;
+            for (size_t j = 0; j < ns-k-1; j++)
+              sum += tri[first+j] * hy(range[k]+1+j);
+            hy(range[k]) -= sum;
+          }
+      });
+  }
+
+  void SparseCholeskyBLR :: 
+  MultAdd (double s, const BaseVector & x, BaseVector & y) const
+  {
+    static Timer timer("SparseCholeskyBLR::MultAdd");
+    RegionTimer reg (timer);
+
+    auto fx = x.FV<double> ();
+    auto fy = y.FV<double> ();
+    Vector<double> hy(nused);
+
+    ParallelFor (Range(height), [&] (int i)
+                 {
+                   if (order[i] != -1)
+                     hy(order[i]) = fx(i);
+                 });
+
+    SolveBLR (hy);
+
+    ParallelFor (Range(height), [&] (int i)
+                 {
+                   if (order[i] != -1)
+                     fy(i) += s * hy(order[i]);
+                 });
+  }
+
+
+  FactorizationEstimate SparseFactorization ::
+  Estimate (const BaseSparseMatrix & amatrix, shared_ptr<BitArray> ainner,
+            bool nested_dissection)
+  {
+    static Timer t("SparseFactorization::Estimate"); RegionTimer reg(t);
+
+    unique_ptr<MinimumDegreeOrdering> mdo
+      (SymbolicElimination (amatrix, ainner, nullptr, nested_dissection));
+
+    // column counts as in SparseCholeskyTM::Allocate
+    size_t nze = 0, nze_master = 0, maxrow = 0;
+    double flops = 0;
+    for (int i = 0; i < mdo->nused; i++)
+      {
+        int bi = mdo->blocknr[i];
+        size_t cnt = mdo->vertices[mdo->order[bi]].nconnected - (i-bi);
+        nze += cnt;
+        if (bi == i)
+          {
+            nze_master += cnt;
+            maxrow = max2 (maxrow, cnt+1);
+          }
+        // column update, and scaling of the column
+        flops += double(cnt)*(cnt+3);
+      }
+
+    // entries of non-scalar or complex matrices are stored as several doubles
+    size_t entrysize = amatrix.AsVector().EntrySize();
+    size_t bytes = entrysize*sizeof(double);
+
+    FactorizationEstimate est;
+    est.nze = nze;
+    est.memory = (nze + mdo->nused) * bytes                 // lfact and diag
+      + nze_master * sizeof(int)                            // row indices
+      + 2 * (mdo->nused+1) * sizeof(size_t)                 // firstinrow
+      + (2*size_t(mdo->nused) + amatrix.Size()) * sizeof(int);     // orderings, blocks
+    est.peakmemory = est.memory + maxrow*maxrow*bytes;
+    est.flops = flops * pow (double(entrysize), 1.5);
+    return est;
+  }
+
+
+
   SparseFactorization ::     
   SparseFactorization (const BaseSparseMatrix & amatrix,
 		       shared_ptr<BitArray> ainner,
@@ -14,6 +14,19 @@
 namespace ngla
 {
 
+  /// predicted size of a sparse factorization, from the symbolic phase only
+  struct FactorizationEstimate
+  {
+    /// non-zero entries of the L-factor
+    size_t nze = 0;
+    /// bytes of the factor values and index arrays
+    size_t memory = 0;
+    /// memory plus the dense work array of the largest supernode
+    size_t peakmemory = 0;
+    /// floating point operations of the numeric factorization
+    double flops = 0;
+  };
+
   class NGS_DLL_HEADER SparseFactorization : public BaseMatrix
   { 
   protected:
@@ -38,6 +51,15 @@ namespace ngla
     
     auto GetAMatrix() const { return matrix.lock(); }
     virtual bool SupportsUpdate() const { return false; } 
+
+    /**
+       Runs the ordering of the sparse cholesky factorization only. 
+       External solvers use their own orderings, for them the numbers
+       are an estimate of the same order.
+    */
+    static FactorizationEstimate Estimate (const BaseSparseMatrix & amatrix,
+                                           shared_ptr<BitArray> ainner = nullptr,
+                                           bool nested_dissection = false);
   };
 
 
@@ -50,7 +72,7 @@ namespace ngla
   /**
      A sparse cholesky factorization.
      The unknowns are reordered by the minimum degree
-     ordering algorithm
+     ordering algorithm, or by nested dissection
 
      computs A = L D L^t
      L is stored column-wise
@@ -76,6 +98,8 @@ namespace ngla
     // L-factor in compressed storage
     // Array<TM, size_t> lfact;
     NumaInterleavedArray<TM> lfact;
+    // if set, lfact is released and the factor is read from this file
+    string factor_file;
 
     // index-array to lfact
     Array<size_t> firstinrow;
@@ -83,6 +107,12 @@ namespace ngla
     // diagonal 
     Array<TM> diag;
 
+    // registers the factor, see MemoryRegistry
+    MemoryTracker mem_factor { MemoryRegistry::FACTORS };
+    // lfact and diag, plus the extra storage of derived factorizations
+    void TrackMemory (size_t extra = 0)
+    { mem_factor.Set (lfact.OwnedBytes() + diag.OwnedBytes() + extra); }
+
 
     // row-indices of non-zero entries
     // all row-indices within one block are identic, and stored just once
@@ -104,7 +134,8 @@ namespace ngla
     {
     public:
       int blocknr;
-      enum BT { L_BLOCK, B_BLOCK, LB_BLOCK };
+      // S_BLOCK: a small subtree, blocknr is the index into subtree_blocks
+      enum BT { L_BLOCK, B_BLOCK, LB_BLOCK, S_BLOCK };
       BT type;
       int bblock;
       int nbblocks;
@@ -112,8 +143,10 @@ namespace ngla
   protected:
     
     Array<MicroTask> microtasks;
-    Table<int> micro_dependency;     
-    Table<int> micro_dependency_trans;     
+    // blocks of small elimination subtrees, ascending, solved by one task
+    Table<int> subtree_blocks;
+    TaskGraph micro_graph;
+    TaskGraph micro_graph_trans;
 
 
     //
@@ -132,7 +165,11 @@ namespace ngla
     SparseCholeskyTM (const SparseMatrixTM<TM> & a, 
                                      shared_ptr<BitArray> ainner = nullptr,
                                      shared_ptr<const Array<int>> acluster = nullptr,
-                                     bool allow_refactor = 0);
+                                     bool allow_refactor = 0,
+                                     bool nested_dissection = false);
+    /// numeric factorization of a, using the ordering and pattern of symbolic
+    SparseCholeskyTM (const SparseMatrixTM<TM> & a,
+                      const SparseCholeskyTM<TM> & symbolic);
     ///
     virtual ~SparseCholeskyTM ();
     ///
@@ -159,7 +196,14 @@ namespace ngla
       FactorNew (*castmatrix);
     }
     ///
-    void FactorNew (const SparseMatrix<TM> & a);
+    void FactorNew (const SparseMatrixTM<TM> & a);
+
+    /**
+       Writes the factor to filename and releases it. The panels of the
+       blocks are contiguous in lfact, solves read them block by block.
+    */
+    void SwapOut (string filename);
+    bool IsSwappedOut () const { return factor_file != ""; }
 
     /**
        A = L+D+L^T
@@ -174,7 +218,7 @@ namespace ngla
 
     virtual Array<MemoryUsage> GetMemoryUsage () const
     {
-      return { MemoryUsage ("SparseChol", nze*sizeof(TM), 1) };
+      return { MemoryUsage ("SparseChol", lfact.Size()*sizeof(TM), 1) };
     }
 
     virtual size_t NZE () const { return nze; }
@@ -209,6 +253,7 @@ namespace ngla
 	   class TV_COL = typename mat_traits<TM>::TV_COL>
   class NGS_DLL_HEADER SparseCholesky : public SparseCholeskyTM<TM>
   {
+  protected:
     typedef SparseCholeskyTM<TM> BASE;
     using BASE::height;
     using BASE::Height;
@@ -224,8 +269,9 @@ namespace ngla
     using BASE::blocks;
     using typename BASE::MicroTask;
     using BASE::microtasks;
-    using BASE::micro_dependency;
-    using BASE::micro_dependency_trans;
+    using BASE::subtree_blocks;
+    using BASE::micro_graph;
+    using BASE::micro_graph_trans;
     using BASE::block_dependency;
     using BASE::BlockDofs;
     using BASE::BlockExtDofs;
@@ -238,8 +284,14 @@ namespace ngla
     SparseCholesky (const SparseMatrixTM<TM> & a, 
 		    shared_ptr<BitArray> ainner = nullptr,
 		    shared_ptr<const Array<int>> acluster = nullptr,
-		    bool allow_refactor = 0)
-      : SparseCholeskyTM<TM> (a, ainner, acluster, allow_refactor) { ; }
+		    bool allow_refactor = 0,
+                    bool nested_dissection = false)
+      : SparseCholeskyTM<TM> (a, ainner, acluster, allow_refactor, nested_dissection) { ; }
+
+    /// reuses the symbolic factorization for a matrix of the same pattern
+    SparseCholesky (const SparseMatrixTM<TM> & a, 
+                    const SparseCholeskyTM<TM> & symbolic)
+      : SparseCholeskyTM<TM> (a, symbolic) { ; }
 
     ///
     virtual ~SparseCholesky () { ; }
@@ -248,6 +300,9 @@ namespace ngla
 
     virtual void MultAdd (TSCAL_VEC s, const BaseVector & x, BaseVector & y) const;
 
+    /// solves for all vectors at once, reading the factor only once
+    virtual void MultAdd (double s, const MultiVector & x, MultiVector & y) const override;
+
     virtual AutoVector CreateVector () const
     {
       return make_shared<VVector<TV>> (height);
@@ -257,8 +312,102 @@ namespace ngla
 
     void SolveBlock (int i, FlatVector<TV> hy) const;
     void SolveBlockT (int i, FlatVector<TV> hy) const;
+  protected:
+    void SolveReordered(FlatVector<TVX> hy) const
+    {
+      if (this->IsSwappedOut())
+        SolveReorderedOutOfCore (hy);
+      else
+        SolveReordered<TM> (hy, lfact.Addr(0));
+    }
+    /// solve with the factor entries stored in factor, in the layout of lfact
+    template <typename TF>
+    void SolveReordered (FlatVector<TVX> hy, TF * factor) const;
+    void SolveReorderedMulti (FlatMatrix<TVX> hy) const;
+    /// streams the panels from the factor file, the next panel is read during the solve
+    void SolveReorderedOutOfCore (FlatVector<TVX> hy) const;
+  };
+
+
+
+  /**
+     Sparse cholesky factorization with the factor stored in single precision.
+     The factorization is computed in double precision and rounded, the
+     solve reads half of the memory. Iterative refinement with the double
+     precision matrix restores the accuracy.
+  */
+  class NGS_DLL_HEADER SparseCholeskyMixed : public SparseCholesky<double>
+  {
+    typedef SparseCholesky<double> BASE;
+    NumaInterleavedArray<float> lfact_float;
+    double tol;
+    int maxsteps;
+  public:
+    SparseCholeskyMixed (const SparseMatrixTM<double> & a, 
+                         shared_ptr<BitArray> ainner = nullptr,
+                         shared_ptr<const Array<int>> acluster = nullptr,
+                         double atol = 1e-12, int amaxsteps = 20);
+
+    virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const override;
+    virtual void MultAdd (double s, const MultiVector & x, MultiVector & y) const override
+    { BaseMatrix::MultAdd (s, x, y); }
+    virtual void Smooth (BaseVector & u, const BaseVector & f, BaseVector & y) const override
+    { SparseFactorization::Smooth (u, f, y); }
+
+    virtual void Update() override;
+
+    virtual Array<MemoryUsage> GetMemoryUsage () const override
+    {
+      return { MemoryUsage ("SparseCholMixed", nze*sizeof(float), 1) };
+    }
+  private:
+    /// rounds the double factor and releases it
+    void RoundFactor ();
+  };
+
+
+
+  /**
+     Sparse cholesky factorization with block low-rank compression.
+     The external panel B of a large supernode is replaced by U V^T,
+     found by adaptive cross approximation up to the relative tolerance.
+     The factor is an approximation, the inverse is a preconditioner.
+  */
+  class NGS_DLL_HEADER SparseCholeskyBLR : public SparseCholesky<double>
+  {
+    typedef SparseCholesky<double> BASE;
+    double tol;
+    int minsize;
+    /// block b starts at first_entry[b] with its triangle, then the dense panel or U and V
+    Array<size_t> first_entry;
+    /// rank of the panel, -1 for dense panels
+    Array<int> rank;
+    Array<double> factor;
+    TaskGraph block_graph_trans;
+  public:
+    SparseCholeskyBLR (const SparseMatrixTM<double> & a, 
+                       shared_ptr<BitArray> ainner = nullptr,
+                       double atol = 1e-6, int aminsize = 64);
+
+    virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const override;
+    virtual void MultAdd (double s, const MultiVector & x, MultiVector & y) const override
+    { BaseMatrix::MultAdd (s, x, y); }
+    virtual void Smooth (BaseVector & u, const BaseVector & f, BaseVector & y) const override
+    { SparseFactorization::Smooth (u, f, y); }
+
+    virtual void Update() override;
+
+    virtual size_t NZE () const override { return factor.Size(); }
+    virtual Array<MemoryUsage> GetMemoryUsage () const override
+    {
+      return { MemoryUsage ("SparseCholBLR", factor.Size()*sizeof(double), 1) };
+    }
+    /// number of compressed panels
+    size_t NumCompressed () const;
   private:
-    void SolveReordered(FlatVector<TVX> hy) const;
+    /// compresses the panels of the double factor and releases it
+    void Compress ();
+    void SolveBLR (FlatVector<double> hy) const;
   };
 
 
@@ -57,6 +57,8 @@ namespace ngla
       }
     firsti[size] = nze;
     
+    CalcBalancing ();
+
     // colnr.SetSize (nze+1);
     colnr = NumaDistributedArray<int> (nze+1);
 
@@ -65,18 +67,41 @@ namespace ngla
       colnr[i] = -1;
     */
     
-    FlatArray<int> hcolnr = colnr;
-    ParallelForRange (nze,
-		      [hcolnr] (auto myrange)
-		      {
-			hcolnr.Range(myrange) = -1;
-		      });
-
+    // first touch by the threads working on the rows later
+    ParallelFirstTouch (colnr.Range(0, nze), balance, FlatArray<size_t> (firsti), -1);
     colnr[nze] = 0;
+    TrackMemory();
+  }
+                                                                                                                                                                                                                  
+  MatrixGraph :: MatrixGraph (FlatArray<size_t> afirsti, FlatArray<int> acolnr, int awidth)
+  {
+    if (afirsti.Size() == 0 || afirsti[0] != 0 || afirsti.Last() != acolnr.Size())
+      throw Exception ("MatrixGraph: row starts do not match the column numbers");
+    size = afirsti.Size()-1;
+    width = awidth;
+    nze = acolnr.Size();
+    owner = false;
 
+    for (int i = 0; i < size; i++)
+      {
+        if (afirsti[i+1] < afirsti[i])
+          throw Exception ("MatrixGraph: row starts must not decrease");
+        for (size_t j = afirsti[i]; j < afirsti[i+1]; j++)
+          if (acolnr[j] < 0 || acolnr[j] >= width || (j > afirsti[i] && acolnr[j] <= acolnr[j-1]))
+            throw Exception ("MatrixGraph: column numbers must be increasing within a row and below the width");
+      }
+
+    firsti = Array<size_t> (size+1, &afirsti[0]);
+#ifdef USE_NUMA
+    colnr = NumaDistributedArray<int> (nze);
+    colnr = acolnr;
+#else
+    colnr = Array<int> (nze, nze ? &acolnr[0] : nullptr);
+#endif
     CalcBalancing ();
+    TrackMemory();
   }
-                                                                                                                                                                                                                  
+
   MatrixGraph :: MatrixGraph (int as, int max_elsperrow) 
   {
     size = as;
@@ -88,14 +113,14 @@ namespace ngla
     firsti.SetSize (as+1);
     owner = true;
     
-    for (int i = 0; i < as*max_elsperrow; i++)
-      colnr[i] = -1;
-    colnr[as*max_elsperrow] = 0;
-    
     for (int i = 0; i < as+1; i++)
       firsti[i] = i*max_elsperrow;
 
     CalcBalancing ();
+
+    ParallelFirstTouch (colnr.Range(0, nze), balance, FlatArray<size_t> (firsti), -1);
+    colnr[as*max_elsperrow] = 0;
+    TrackMemory();
   }
   
 
@@ -121,11 +146,24 @@ namespace ngla
         
 	for (int i = 0; i < size+1; i++)
 	  firsti[i] = graph.firsti[i];
-	for (size_t i = 0; i < nze; i++)
-	  colnr[i] = graph.colnr[i];
       }
     // inversetype = agraph.GetInverseType();
-    CalcBalancing ();
+    // reuse the balancing if it was computed for the current number of threads
+    if (graph.balance.Size() == size_t(task_manager ? task_manager->GetNumThreads() : 1))
+      balance = graph.balance;
+    else
+      CalcBalancing ();
+
+    if (!stealgraph)
+      // copy with the threads working on the rows later
+      ParallelForRange (balance, [&] (IntRange r)
+                        {
+                          if (r.Size() == 0) return;
+                          for (size_t i = firsti[r.First()]; i < firsti[r.Next()]; i++)
+                            colnr[i] = graph.colnr[i];
+                        });
+    TrackMemory();
+    graph.TrackMemory();
   }
 
 
@@ -396,27 +434,19 @@ namespace ngla
     bool includediag = (&rowelements == &colelements);
      
     int ndof = asize;
-    TableCreator<int> creator(ndof);
-
 
     ParallelFor (Range(colelements.Size()), 
                  [&] (int i) { QuickSort (colelements[i]); });
     
     timer_dof2el.Start();
-    for ( ; !creator.Done(); creator++)
-      {    
-        ParallelFor (Range(rowelements.Size()),
-                     [&] (int i)
-                     {
-                       for (auto e : rowelements[i])
-                         creator.Add(e, i);
-                     },
-                     TasksPerThread(10));
-      }
+    Table<int> dof2element = ParallelCreateTable<int>
+      (rowelements.Size(), [&] (ParallelTableCreator<int> & creator, size_t i)
+       {
+         for (auto e : rowelements[i])
+           creator.Add(e, i);
+       }, ndof);
     timer_dof2el.Stop();
 
-    Table<int> dof2element = creator.MoveTable();
-
     // #define NEWDOF2EL
 #ifdef NEWDOF2EL
     {
@@ -725,165 +755,111 @@ namespace ngla
     
 
 
-    for (int loop = 1; loop <= 2; loop++)
-      {
-        if (!symmetric)
-          {
-            ParallelForRange 
-              (Range(ndof), [&](IntRange myr) 
-               {
-                 ArrayMem<int, 50> sizes;
-                 ArrayMem<int*, 50> ptrs;
+    // one merge pass: every task merges the rows of its range into a
+    // task-local buffer, the buffers are compacted into colnr when the
+    // row sizes are known
+    static Timer timer_merge("MatrixGraph - merge");
+    static Timer timer_compact("MatrixGraph - compact");
+    timer_merge.Start();
+    int ntasks = TasksPerThread(20);
+    auto task_range = [ndof, ntasks] (int k) { return Range(ndof).Split (k, ntasks); };
+    Array<Array<int>> buffers(ntasks);
+    Array<size_t> bufoffset(ndof);
 
-                 for (int i : myr)
-                   {
-                     sizes.SetSize(dof2element[i].Size());
-                     ptrs.SetSize(dof2element[i].Size());
+    ParallelJob
+      ([&] (TaskInfo & ti)
+       {
+         ArrayMem<int, 50> sizes;
+         ArrayMem<int*, 50> ptrs;
+         auto & buffer = buffers[ti.task_nr];
 
-                     for (int j : dof2element[i].Range())
-                       {
-                         sizes[j] = colelements[dof2element[i][j]].Size();
-                         ptrs[j] = colelements[dof2element[i][j]].Addr(0);
-                       }
-                     
-                     if (loop == 1)
-                       {
-                         int cnti = 0;
-                         MergeArrays(ptrs, sizes, [&cnti] (int col) { cnti++; } );
-                         cnt[i] = cnti;
-                       }
-                     else
-                       {
-                         auto ptr = &colnr[firsti[i]];
-                         MergeArrays(ptrs, sizes, [&ptr] (int col) 
-                                     {
-                                       *ptr = col;
-                                       ptr++;
-                                     } );
-                       }
-                   }
-               },
-               TasksPerThread(20));
-            // 20 * task_manager->GetNumThreads());
-          }
-        else
-          {
-            ParallelForRange 
-              (Range(ndof),[&](IntRange myr)
+         for (int i : task_range(ti.task_nr))
+           {
+             auto els = dof2element[i];
+             sizes.SetSize(els.Size());
+             ptrs.SetSize(els.Size());
+
+             for (int j : els.Range())
                {
-                 Array<int> rowdofs;
-                 Array<int> rowdofs1;
-                 
-                 // for (int i : sl)
-                 for (int i : myr)
-                   {
-                     rowdofs.SetSize0();
-                     if (includediag) rowdofs += i;
-                     
-                     for (auto elnr : dof2element[i])
-                       {
-                         rowdofs.Swap (rowdofs1);
-                         auto row = colelements[elnr];
-                         
-                         rowdofs.SetSize(rowdofs1.Size()+row.Size());
-                         
-                         int i1 = 0, i2 = 0, i3 = 0;
-                         while (i1 < rowdofs1.Size() && i2 < row.Size() && row[i2] <= i)
-                           {
-                             int newel;
-                             if (rowdofs1[i1] == row[i2])
-                               {
-                                 newel = rowdofs1[i1++]; i2++;
-                               }
-                             else if (rowdofs1[i1] < row[i2])
-                               newel = rowdofs1[i1++];
-                             else
-                               newel = row[i2++];
-                             rowdofs[i3++] = newel; 
-                           }
-                         
-                         while (i1 < rowdofs1.Size())
-                           rowdofs[i3++] = rowdofs1[i1++];
-                         while (i2 < row.Size() && row[i2] <= i)
-                           rowdofs[i3++] = row[i2++];
-                         
-                         rowdofs.SetSize(i3);
-                       }
-                  
-                  
-                     if (loop == 1)
-                       cnt[i] = rowdofs.Size();
-                     else
-                       colnr.Range(firsti[i], firsti[i+1]) = rowdofs;
-                   }
-               }, TasksPerThread(5));
-            
-          }
-        
-        
-        if (loop == 1)
-          {
-            size = ndof;
-            width = awidth;
-            owner = true;
-            
-            firsti.SetSize (size+1);
-            /*
-            nze = 0;
-            for (int i = 0; i < size; i++)
-              {
-                firsti[i] = nze;
-                nze += cnt[i];
-              }
-            firsti[size] = nze;
-            */
+                 auto row = colelements[els[j]];
+                 ptrs[j] = row.Addr(0);
+                 // the symmetric graph keeps the lower triangle only
+                 int s = row.Size();
+                 if (symmetric)
+                   while (s > 0 && row[s-1] > i) s--;
+                 sizes[j] = s;
+               }
+
+             size_t first = buffer.Size();
+             bufoffset[i] = first;
+             if (symmetric && includediag && els.Size() == 0)
+               buffer.Append (i);
+             else
+               MergeArrays(ptrs, sizes, [&buffer] (int col) { buffer.Append (col); } );
+             cnt[i] = buffer.Size()-first;
+           }
+       }, ntasks);
+    timer_merge.Stop();
+
+    size = ndof;
+    width = awidth;
+    owner = true;
             
-            timer_prefix.Start();
-            Array<size_t> partial_sums(TaskManager::GetNumThreads()+1);
-            partial_sums[0] = 0;
-            ParallelJob
-              ([&] (TaskInfo ti)
-               {
-                 IntRange r = IntRange(size).Split(ti.task_nr, ti.ntasks);
-                 size_t mysum = 0;
-                 for (size_t i : r)
-                   mysum += cnt[i];
-                 partial_sums[ti.task_nr+1] = mysum;
-               });
-
-            for (size_t i = 1; i < partial_sums.Size(); i++)
-              partial_sums[i] += partial_sums[i-1];
-
-            ParallelJob
-              ([&] (TaskInfo ti)
-               {
-                 IntRange r = IntRange(size).Split(ti.task_nr, ti.ntasks);
-                 size_t mysum = partial_sums[ti.task_nr];
-                 for (size_t i : r)
-                   {
-                     firsti[i] = mysum;
-                     mysum += cnt[i];
-                   }
-               });
-            nze = partial_sums[partial_sums.Size()-1];
-            firsti[size] = nze;
-            timer_prefix.Stop();
+    firsti.SetSize (size+1);
             
-            colnr = NumaDistributedArray<int> (nze+1);
+    timer_prefix.Start();
+    Array<size_t> partial_sums(TaskManager::GetNumThreads()+1);
+    partial_sums[0] = 0;
+    ParallelJob
+      ([&] (TaskInfo ti)
+       {
+         IntRange r = IntRange(size).Split(ti.task_nr, ti.ntasks);
+         size_t mysum = 0;
+         for (size_t i : r)
+           mysum += cnt[i];
+         partial_sums[ti.task_nr+1] = mysum;
+       });
 
-	    CalcBalancing ();
+    for (size_t i = 1; i < partial_sums.Size(); i++)
+      partial_sums[i] += partial_sums[i-1];
 
-            // first touch memory (numa!)
-            ParallelFor (balance, [&](int row) 
-                         {
-                           colnr.Range(firsti[row], firsti[row+1]) = 0;
-                         });
-          }
-        else
-          {
-            ;
-          }
-      }
+    ParallelJob
+      ([&] (TaskInfo ti)
+       {
+         IntRange r = IntRange(size).Split(ti.task_nr, ti.ntasks);
+         size_t mysum = partial_sums[ti.task_nr];
+         for (size_t i : r)
+           {
+             firsti[i] = mysum;
+             mysum += cnt[i];
+           }
+       });
+    nze = partial_sums[partial_sums.Size()-1];
+    firsti[size] = nze;
+    timer_prefix.Stop();
+
+    timer_compact.Start();
+    Array<const int*> rowptr(ndof);
+    ParallelJob
+      ([&] (TaskInfo & ti)
+       {
+         for (int i : task_range(ti.task_nr))
+           rowptr[i] = buffers[ti.task_nr].Addr(0) + bufoffset[i];
+       }, ntasks);
+    
+    colnr = NumaDistributedArray<int> (nze+1);
+    CalcBalancing ();
+
+    // copy with the threads working on the rows later
+    ParallelFor (balance, [&](int row) 
+                 {
+                   size_t first = firsti[row];
+                   for (int j = 0; j < cnt[row]; j++)
+                     colnr[first+j] = rowptr[row][j];
+                 });
+    ParallelFor (ntasks, [&] (int k) { buffers[k] = Array<int>(); });
+    timer_compact.Stop();
+    TrackMemory();
     /*
     ofstream out("creategraph.out");
     double sumtime = 0;
@@ -1058,6 +1034,44 @@ namespace ngla
 
     return numeric_limits<size_t>::max();
   }
+
+
+  void MatrixGraph :: GetElementPositions (FlatArray<int> dnums1, FlatArray<int> dnums2,
+                                            FlatArray<int> pos) const
+  {
+    size_t n2 = dnums2.Size();
+    for (size_t i = 0; i < dnums1.Size(); i++)
+      for (size_t j = 0; j < n2; j++)
+        {
+          int & p = pos[i*n2+j];
+          p = -1;
+          if (dnums1[i] < 0 || dnums2[j] < 0) continue;
+          size_t k = GetPositionTest (dnums1[i], dnums2[j]);
+          if (k != numeric_limits<size_t>::max())
+            p = k - firsti[dnums1[i]];
+        }
+  }
+
+  void MatrixGraph :: GetElementPositionsSymmetric (FlatArray<int> dnums, FlatArray<int> pos) const
+  {
+    // same pairs as AddElementMatrixSymmetric: j before or at i in sorted order
+    size_t n = dnums.Size();
+    ArrayMem<int,100> map(n), rank(n);
+    for (size_t i = 0; i < n; i++) map[i] = i;
+    QuickSortI (dnums, map);
+    for (size_t i = 0; i < n; i++) rank[map[i]] = i;
+    
+    for (size_t i = 0; i < n; i++)
+      for (size_t j = 0; j < n; j++)
+        {
+          int & p = pos[i*n+j];
+          p = -1;
+          if (dnums[i] < 0 || dnums[j] < 0 || rank[j] > rank[i]) continue;
+          size_t k = GetPositionTest (dnums[i], dnums[j]);
+          if (k != numeric_limits<size_t>::max())
+            p = k - firsti[dnums[i]];
+        }
+  }
   
   size_t MatrixGraph :: CreatePosition (int i, int j)
   {
@@ -1260,10 +1274,12 @@ namespace ngla
     else if (ainversetype == "masterinverse") SetInverseType ( MASTERINVERSE );
     else if (ainversetype == "sparsecholesky") SetInverseType ( SPARSECHOLESKY );
     else if (ainversetype == "umfpack")       SetInverseType ( UMFPACK );
+    else if (ainversetype == "sparsecholesky_nd") SetInverseType ( SPARSECHOLESKY_ND );
+    else if (ainversetype == "sparsecholesky_mixed") SetInverseType ( SPARSECHOLESKY_MIXED );
     else
       {
         throw Exception (ToString("undefined inverse ")+ainversetype+
-                         "\nallowed is: 'sparsecholesky', 'pardiso', 'pardisospd', 'mumps', 'masterinverse', 'umfpack'");
+                         "\nallowed is: 'sparsecholesky', 'sparsecholesky_nd', 'sparsecholesky_mixed', 'pardiso', 'pardisospd', 'mumps', 'masterinverse', 'umfpack'");
       }
     return old_invtype;
   }
@@ -1362,6 +1378,35 @@ namespace ngla
   }
   
 
+  Timer timer_addelmat_indexed("SparseMatrix::AddElementMatrix indexed");
+
+  template <class TM>
+  void SparseMatrixTM<TM> ::
+  AddElementMatrixIndexed(FlatArray<int> dnums1, FlatArray<int> dnums2, FlatArray<int> pos,
+                          BareSliceMatrix<TSCAL> elmat1, bool use_atomic)
+  {
+    ThreadRegionTimer reg (timer_addelmat_indexed, TaskManager::GetThreadId());
+    NgProfiler::AddThreadFlops (timer_addelmat_indexed, TaskManager::GetThreadId(), dnums1.Size()*dnums2.Size());
+
+    Scalar2ElemMatrix<TM, TSCAL> elmat (elmat1);
+    size_t n2 = dnums2.Size();
+    for (size_t i = 0; i < dnums1.Size(); i++)
+      if (IsRegularIndex(dnums1[i]))
+        {
+          FlatVector<TM> rowvals = this->GetRowValues(dnums1[i]);
+          FlatArray<int> rowpos = pos.Range(i*n2, (i+1)*n2);
+          for (size_t j = 0; j < n2; j++)
+            if (rowpos[j] >= 0 && IsRegularIndex(dnums2[j]))
+              {
+                if (use_atomic)
+                  MyAtomicAdd (rowvals(rowpos[j]), elmat(i,j));
+                else
+                  rowvals(rowpos[j]) += elmat(i,j);
+              }
+        }
+  }
+  
+
   template <class TM>
   void SparseMatrixTM<TM> :: SetZero ()
   {
@@ -1389,7 +1434,7 @@ namespace ngla
   MultAdd (double s, const BaseVector & x, BaseVector & y) const
   {
     static Timer t("SparseMatrix::MultAdd"); RegionTimer reg(t);
-    t.AddFlops (this->NZE());
+    AddSparseMatrixTraffic<TM,TVX,TVY> (t, *this);
 
     if (task_manager)
       {
@@ -1424,6 +1469,84 @@ namespace ngla
 
   }
 
+  // multivector products, only real scalar matrices read the matrix once
+  template <class TM>
+  bool MultiVectorMultAdd (const SparseMatrixTM<TM> & mat, double s,
+                           FlatMatrix<double> fx, FlatMatrix<double> fy)
+  { return false; }
+
+  bool MultiVectorMultAdd (const SparseMatrixTM<double> & mat, double s,
+                           FlatMatrix<double> fx, FlatMatrix<double> fy)
+  {
+    size_t k = fx.Width();
+    ParallelForRange (mat.Height(), [&] (IntRange myrange)
+      {
+        for (auto row : myrange)
+          {
+            auto cols = mat.GetRowIndices(row);
+            auto vals = mat.GetRowValues(row);
+            auto yrow = fy.Row(row);
+            for (size_t l = 0; l < cols.Size(); l++)
+              {
+                double sv = s * vals(l);
+                auto xrow = fx.Row(cols[l]);
+                for (size_t j = 0; j < k; j++)
+                  yrow(j) += sv * xrow(j);
+              }
+          }
+      });
+    return true;
+  }
+
+  template <class TM>
+  bool MultiVectorMultAddSymmetric (const SparseMatrixTM<TM> & mat, double s,
+                                    FlatMatrix<double> fx, FlatMatrix<double> fy)
+  { return false; }
+
+  // lower triangle is stored, the transposed part scatters to other rows
+  bool MultiVectorMultAddSymmetric (const SparseMatrixTM<double> & mat, double s,
+                                    FlatMatrix<double> fx, FlatMatrix<double> fy)
+  {
+    size_t k = fx.Width();
+    for (size_t row = 0; row < mat.Height(); row++)
+      {
+        auto cols = mat.GetRowIndices(row);
+        auto vals = mat.GetRowValues(row);
+        auto xrow = fx.Row(row);
+        auto yrow = fy.Row(row);
+        for (size_t l = 0; l < cols.Size(); l++)
+          {
+            double sv = s * vals(l);
+            size_t col = cols[l];
+            auto xcol = fx.Row(col);
+            for (size_t j = 0; j < k; j++)
+              yrow(j) += sv * xcol(j);
+            if (col != row)
+              {
+                auto ycol = fy.Row(col);
+                for (size_t j = 0; j < k; j++)
+                  ycol(j) += sv * xrow(j);
+              }
+          }
+      }
+    return true;
+  }
+  
+  template <class TM, class TV_ROW, class TV_COL>
+  void SparseMatrix<TM,TV_ROW,TV_COL> ::
+  MultAdd (double s, const MultiVector & x, MultiVector & y) const
+  {
+    static Timer t("SparseMatrix::MultAdd (MultiVector)"); RegionTimer reg(t);
+    
+    if (!this->IsComplex() &&
+        MultiVectorMultAdd (static_cast<const SparseMatrixTM<TM>&> (*this), s, x.FM(), y.FM()))
+      {
+        AddSparseMatrixTraffic<TM,double,double> (t, *this, x.NumVectors());
+        return;
+      }
+    BaseMatrix::MultAdd (s, x, y);
+  }
+
   template <class TM, class TV_ROW, class TV_COL>
   void SparseMatrix<TM,TV_ROW,TV_COL> ::
   MultAdd1 (double s, const BaseVector & x, BaseVector & y,
@@ -1464,7 +1587,7 @@ namespace ngla
     for (int i = 0; i < this->Height(); i++)
       AddRowTransToVector (i, s*fx(i), fy);
 
-    timer.AddFlops (this->NZE());
+    AddSparseMatrixTraffic<TM,TVY,TVX> (timer, *this);
   }
 
 
@@ -1474,6 +1597,7 @@ namespace ngla
   {
     static Timer timer("SparseMatrix::MultAdd Complex");
     RegionTimer reg (timer);
+    AddSparseMatrixTraffic<TM,TVX,TVY> (timer, *this);
 
     FlatVector<TVX> fx = x.FV<TVX> (); //  (x.Size(), x.Memory());
     FlatVector<TVY> fy = y.FV<TVY> (); // (y.Size(), y.Memory());
@@ -1515,6 +1639,23 @@ namespace ngla
 
 
 
+  // the single precision factorization is available for real matrices and vectors
+  template <class TM, class TV>
+  shared_ptr<BaseMatrix> CreateMixedCholesky (const SparseMatrixTM<TM> & mat, TV dummy,
+                                              shared_ptr<BitArray> subset,
+                                              shared_ptr<const Array<int>> clusters)
+  {
+    throw Exception ("SparseMatrix::InverseMatrix: sparsecholesky_mixed is only available for real scalar matrices");
+  }
+
+  shared_ptr<BaseMatrix> CreateMixedCholesky (const SparseMatrixTM<double> & mat, double dummy,
+                                              shared_ptr<BitArray> subset,
+                                              shared_ptr<const Array<int>> clusters)
+  {
+    return make_shared<SparseCholeskyMixed> (mat, subset, clusters);
+  }
+
+
   template <class TM, class TV_ROW, class TV_COL>
   shared_ptr<BaseMatrix> SparseMatrix<TM,TV_ROW,TV_COL> ::
   InverseMatrix (shared_ptr<BitArray> subset) const
@@ -1554,8 +1695,11 @@ namespace ngla
 	throw Exception ("SparseMatrix::InverseMatrix: MumpsInverse not available");
 #endif
       }
+    else if (  BaseSparseMatrix :: GetInverseType()  == SPARSECHOLESKY_MIXED)
+      return CreateMixedCholesky (*this, TV_COL(), subset, nullptr);
     else
-      return make_shared<SparseCholesky<TM,TV_ROW,TV_COL>> (*this, subset);
+      return make_shared<SparseCholesky<TM,TV_ROW,TV_COL>> (*this, subset, nullptr, false,
+                                                            BaseSparseMatrix :: GetInverseType() == SPARSECHOLESKY_ND);
     //#endif
   }
 
@@ -1614,9 +1758,12 @@ namespace ngla
 	throw Exception ("SparseMatrix::InverseMatrix:  MumpsInverse not available");
 #endif
       }
+    else if (  BaseSparseMatrix :: GetInverseType()  == SPARSECHOLESKY_MIXED)
+      return CreateMixedCholesky (*this, TV_COL(), nullptr, clusters);
     else
       {
-        return make_shared<SparseCholesky<TM,TV_ROW,TV_COL>> (*this, nullptr, clusters);
+        return make_shared<SparseCholesky<TM,TV_ROW,TV_COL>> (*this, nullptr, clusters, false,
+                                                            BaseSparseMatrix :: GetInverseType() == SPARSECHOLESKY_ND);
       }
   }
 
@@ -1908,6 +2055,67 @@ namespace ngla
   }
   
   
+  // block (i,j) of a packed symmetric scalar matrix
+  template <class TSCAL>
+  INLINE void GetPackedBlock (FlatSymmetricMatrix<TSCAL> m, int i, int j, TSCAL & val)
+  {
+    val = (i >= j) ? m(i,j) : m(j,i);
+  }
+
+  template <int H, int W, class TSCAL>
+  INLINE void GetPackedBlock (FlatSymmetricMatrix<TSCAL> m, int i, int j, Mat<H,W,TSCAL> & val)
+  {
+    for (int k = 0; k < H; k++)
+      for (int l = 0; l < W; l++)
+        {
+          int r = i*H+k, c = j*W+l;
+          val(k,l) = (r >= c) ? m(r,c) : m(c,r);
+        }
+  }
+
+  template <class TM>
+  void SparseMatrixTM<TM> ::
+  AddElementMatrixSymmetric(FlatArray<int> dnums, FlatSymmetricMatrix<TSCAL> elmat, bool use_atomic)
+  {
+    ThreadRegionTimer reg (timer_addelmat, TaskManager::GetThreadId());
+    NgProfiler::AddThreadFlops (timer_addelmat, TaskManager::GetThreadId(), dnums.Size()*(dnums.Size()+1)/2);    
+
+    STACK_ARRAY(int, hmap, dnums.Size());
+    FlatArray<int> map(dnums.Size(), hmap);
+    for (int i = 0; i < dnums.Size(); i++) map[i] = i;
+    QuickSortI (dnums, map);
+
+    int first_used = 0;
+    while (first_used < dnums.Size() && !IsRegularIndex(dnums[map[first_used]]) ) first_used++;
+
+    for (int i1 = first_used; i1 < dnums.Size(); i1++)
+      {
+        if (!use_atomic && i1+2 < dnums.Size())
+          this->PrefetchRow(dnums[map[i1+2]]);
+
+        FlatArray<int> rowind = this->GetRowIndices(dnums[map[i1]]);
+        FlatVector<TM> rowvals = this->GetRowValues(dnums[map[i1]]);
+
+        size_t k = 0;
+        for (int j1 = first_used; j1 <= i1; j1++, k++)
+          {
+            while (rowind[k] != dnums[map[j1]])
+              {
+                k++;
+                if (unlikely(k >= rowind.Size()))
+                  throw Exception ("SparseMatrixSymmetricTM::AddElementMatrix: illegal dnums");
+              }
+            TM val;
+            GetPackedBlock (elmat, map[i1], map[j1], val);
+            if (use_atomic)
+              MyAtomicAdd (rowvals(k), val);
+            else
+              rowvals(k) += val;
+          }
+      }
+  }
+  
+  
   template <class TM, class TV>
   SparseMatrixSymmetric<TM,TV> :: 
   SparseMatrixSymmetric (const MatrixGraph & agraph, bool stealgraph)
@@ -1928,11 +2136,74 @@ namespace ngla
   {
     static Timer timer("SparseMatrixSymmetric::MultAdd");
     RegionTimer reg (timer);
-    timer.AddFlops (2*this->nze);
+    AddSparseMatrixTraffic<TM,TV,TV> (timer, *this, 1, true);
 
     const FlatVector<TV_ROW> fx = x.FV<TV_ROW>();
     FlatVector<TV_COL> fy = y.FV<TV_COL>();
 
+    auto & balance = this->balance;
+    size_t np = balance.Size();
+    if (task_manager && np > 1)
+      {
+        // two-phase scheme: a part owns the rows of its balance range.
+        // Transposed entries hitting rows of earlier parts go to a
+        // part-local buffer covering [mincol, first), which is added by
+        // the owning parts in the second phase.
+        Array<size_t> mincol(np), offset(np+1);
+        offset[0] = 0;
+        for (size_t p = 0; p < np; p++)
+          {
+            auto r = balance[p];
+            size_t mc = r.First();
+            for (auto row : r)
+              if (firsti[row] < firsti[row+1])
+                mc = min2(mc, size_t(colnr[firsti[row]]));
+            mincol[p] = mc;
+            offset[p+1] = offset[p] + r.First()-mc;
+          }
+
+        // badly ordered matrices would need huge buffers
+        if (offset[np] <= 2*size_t(this->Height()))
+          {
+            Vector<TV_COL> buffer(offset[np]);
+            
+            ParallelFor (np, [&] (size_t p)
+              {
+                auto r = balance[p];
+                size_t first = r.First();
+                FlatVector<TV_COL> buf = buffer.Range(offset[p], offset[p+1]);
+                buf = TV_COL(0.0);
+                for (auto row : r)
+                  {
+                    fy(row) += s * RowTimesVector (row, fx);
+                    TV_COL el = s * fx(row);
+                    for (size_t j = firsti[row]; j < firsti[row+1]; j++)
+                      {
+                        size_t col = colnr[j];
+                        if (col == row) continue;
+                        if (col >= first)
+                          fy(col) += Trans(data[j]) * el;
+                        else
+                          buf(col-mincol[p]) += Trans(data[j]) * el;
+                      }
+                  }
+              });
+
+            ParallelFor (np, [&] (size_t q)
+              {
+                auto rq = balance[q];
+                for (size_t p = q+1; p < np; p++)
+                  {
+                    size_t first = max2(mincol[p], size_t(rq.First()));
+                    size_t next = min2(size_t(balance[p].First()), size_t(rq.Next()));
+                    for (size_t row = first; row < next; row++)
+                      fy(row) += buffer(offset[p]+row-mincol[p]);
+                  }
+              });
+            return;
+          }
+      }
+
     for (int i = 0; i < this->Height(); i++)
       {
 	fy(i) += s * RowTimesVector (i, fx);
@@ -1940,6 +2211,22 @@ namespace ngla
       }
   }
 
+  template <class TM, class TV>
+  void SparseMatrixSymmetric<TM,TV> :: 
+  MultAdd (double s, const MultiVector & x, MultiVector & y) const
+  {
+    static Timer timer("SparseMatrixSymmetric::MultAdd (MultiVector)");
+    RegionTimer reg (timer);
+    
+    if (!this->IsComplex() &&
+        MultiVectorMultAddSymmetric (static_cast<const SparseMatrixTM<TM>&> (*this), s, x.FM(), y.FM()))
+      {
+        AddSparseMatrixTraffic<TM,double,double> (timer, *this, x.NumVectors(), true);
+        return;
+      }
+    BaseMatrix::MultAdd (s, x, y);
+  }
+
   template <class TM, class TV>
   void SparseMatrixSymmetric<TM,TV> :: 
   MultAdd1 (double s, const BaseVector & x, BaseVector & y,
@@ -2029,40 +2316,106 @@ namespace ngla
     static Timer t1("TransposeMatrix 1");
     static Timer t2("TransposeMatrix 2");
     t1.Start();
-    Array<int> cnt(mat.Width());
-    cnt = 0;
-    ParallelFor (mat.Height(), [&] (int i)
-                 {
-                   for (int c : mat.GetRowIndices(i))
-                     AsAtomic (cnt[c]) ++;
-                 });
+    // the rows of a row of the transpose come in increasing order,
+    // no atomics and no sorting needed
+    Table<int> rows = ParallelCreateTable<int>
+      (mat.Height(), [&] (ParallelTableCreator<int> & creator, size_t i)
+       {
+         for (int c : mat.GetRowIndices(i))
+           creator.Add (c, i);
+       }, mat.Width());
     t1.Stop();
     t2.Start();
+    Array<int> cnt(mat.Width());
+    for (size_t c = 0; c < cnt.Size(); c++)
+      cnt[c] = rows[c].Size();
     auto trans = make_shared<SparseMatrix<double>>(cnt, mat.Height());
 
-    cnt = 0;
-    ParallelFor (mat.Height(), [&] (int i)
+    ParallelFor (trans->GetBalancing(), [&] (int c)
                  {
-                   for (int ci : Range(mat.GetRowIndices(i)))
+                   auto trans_ci = trans->GetRowIndices(c);
+                   auto trans_vals = trans->GetRowValues(c);
+                   for (size_t k = 0; k < trans_ci.Size(); k++)
                      {
-                       int c = mat.GetRowIndices(i)[ci];
-                       int pos = AsAtomic(cnt[c])++;
-                       trans -> GetRowIndices(c)[pos] = i;
-                       trans -> GetRowValues(c)[pos] = mat.GetRowValues(i)[ci];
+                       int i = rows[c][k];
+                       trans_ci[k] = i;
+                       trans_vals(k) = mat.GetRowValues(i)[mat.GetPosition(i,c)-mat.First(i)];
                      }
                  });
-
-    ParallelFor (trans->Height(), [&] (int r)
-                 {
-                   auto rowvals = trans->GetRowValues(r);
-                   BubbleSort (trans->GetRowIndices(r),
-                               FlatArray<double> (rowvals.Size(), &rowvals(0)));
-                 });
-
     t2.Stop();
     return trans;
   }
 
+
+  shared_ptr<SparseMatrix<double,double>>
+  MakeFullMatrix (const SparseMatrix<double, double> & mat);
+
+  shared_ptr<SparseMatrixTM<double>>
+  MatAdd (double sa, const SparseMatrixTM<double> & mata,
+          double sb, const SparseMatrixTM<double> & matb)
+  {
+    static Timer t("sparse matrix addition"); RegionTimer reg(t);
+    if (mata.Height() != matb.Height() || mata.Width() != matb.Width())
+      throw Exception ("MatAdd: matrix sizes don't match");
+
+    auto syma = dynamic_cast<const SparseMatrixSymmetric<double>*> (&mata);
+    auto symb = dynamic_cast<const SparseMatrixSymmetric<double>*> (&matb);
+    if (syma && !symb)
+      return MatAdd (sa, *MakeFullMatrix(*syma), sb, matb);
+    if (symb && !syma)
+      return MatAdd (sa, mata, sb, *MakeFullMatrix(*symb));
+
+    // union of the sorted column arrays of the rows
+    Array<int> cnt(mata.Height());
+    ParallelForRange
+      (mata.Height(), [&] (IntRange r)
+       {
+         Array<int> merged;
+         for (auto i : r)
+           {
+             MergeSortedArrays (mata.GetRowIndices(i), matb.GetRowIndices(i), merged);
+             cnt[i] = merged.Size();
+           }
+       }, TasksPerThread(4));
+
+    shared_ptr<SparseMatrixTM<double>> sum;
+    if (syma)
+      sum = make_shared<SparseMatrixSymmetric<double>> (cnt);
+    else
+      sum = make_shared<SparseMatrix<double>> (cnt, mata.Width());
+    
+    ParallelFor (sum->GetBalancing(), [&] (int i)
+      {
+        auto ca = mata.GetRowIndices(i);
+        auto va = mata.GetRowValues(i);
+        auto cb = matb.GetRowIndices(i);
+        auto vb = matb.GetRowValues(i);
+        auto cs = sum->GetRowIndices(i);
+        auto vs = sum->GetRowValues(i);
+        size_t ia = 0, ib = 0, is = 0;
+        while (ia < ca.Size() || ib < cb.Size())
+          {
+            if (ib == cb.Size() || (ia < ca.Size() && ca[ia] < cb[ib]))
+              {
+                cs[is] = ca[ia];
+                vs(is++) = sa * va(ia++);
+              }
+            else if (ia == ca.Size() || cb[ib] < ca[ia])
+              {
+                cs[is] = cb[ib];
+                vs(is++) = sb * vb(ib++);
+              }
+            else
+              {
+                cs[is] = ca[ia];
+                vs(is++) = sa * va(ia++) + sb * vb(ib++);
+              }
+          }
+      });
+    return sum;
+  }
+
+
   shared_ptr<SparseMatrix<double,double>>
   MakeFullMatrix (const SparseMatrix<double, double> & mat)
   {
@@ -2115,11 +2468,12 @@ namespace ngla
 
     for (int i = 0; i < mat.Height(); i++)
       for (int ci : Range(mat.GetRowIndices(i)))
-        {
-          full -> GetRowIndices(i)[cnt[i]] = mat.GetRowIndices(i)[ci];
-          full -> GetRowValues(i)[cnt[i]] = mat.GetRowValues(i)[ci];
-          cnt[i] ++;
-        }
+        if (mat.GetRowIndices(i)[ci] <= i)
+          {
+            full -> GetRowIndices(i)[cnt[i]] = mat.GetRowIndices(i)[ci];
+            full -> GetRowValues(i)[cnt[i]] = mat.GetRowValues(i)[ci];
+            cnt[i] ++;
+          }
 
     return full;    
   }
@@ -2406,6 +2760,67 @@ namespace ngla
 
 
 
+  /*
+    Numeric phase of the Galerkin product cmat = P^T A P, into the
+    existing graph of cmat. Every coarse row is computed by one task
+    from the rows of P^T, A and P, such that no writes collide. 
+    fullmat stores all entries of A, for lower only the lower triangle
+    of cmat is computed.
+  */
+  template <typename TM>
+  void RestrictNumeric (const SparseMatrixTM<TM> & fullmat, const SparseMatrixTM<double> & prol,
+                        const SparseMatrixTM<double> & prolT, SparseMatrixTM<TM> & cmat,
+                        bool lower)
+  {
+    static Timer t ("sparsematrix - restrict numeric");
+    RegionTimer reg(t);
+    
+    ParallelForRange
+      (cmat.Height(), [&] (IntRange r)
+       {
+         for (auto ci : r)
+           {
+             auto cmat_ci = cmat.GetRowIndices(ci);
+             auto cmat_vals = cmat.GetRowValues(ci);
+             cmat_vals = TM(0.0);
+             
+             auto prolT_ci = prolT.GetRowIndices(ci);
+             auto prolT_vals = prolT.GetRowValues(ci);
+             for (size_t k = 0; k < prolT_ci.Size(); k++)
+               {
+                 int row = prolT_ci[k];
+                 auto mat_ci = fullmat.GetRowIndices(row);
+                 auto mat_vals = fullmat.GetRowValues(row);
+                 for (size_t l = 0; l < mat_ci.Size(); l++)
+                   {
+                     TM pa = prolT_vals(k) * mat_vals(l);
+                     auto prol_ci = prol.GetRowIndices(mat_ci[l]);
+                     auto prol_vals = prol.GetRowValues(mat_ci[l]);
+                     for (size_t m = 0; m < prol_ci.Size(); m++)
+                       {
+                         int cj = prol_ci[m];
+                         if (lower && cj > int(ci)) continue;
+                         cmat_vals(cmat.GetPosition(ci, cj)-cmat.First(ci)) += pa * prol_vals(m);
+                       }
+                   }
+               }
+           }
+       }, TasksPerThread(10));
+  }
+
+  // the coarse matrix has the size of the coarse space, and the right storage
+  template <typename TMAT>
+  shared_ptr<TMAT> ReusableCoarseMatrix (shared_ptr<BaseSparseMatrix> acmat,
+                                         const SparseMatrixTM<double> & prol, bool symmetric)
+  {
+    auto cmat = dynamic_pointer_cast<TMAT> (acmat);
+    if (!cmat) return nullptr;
+    bool cmat_symmetric = dynamic_pointer_cast<SparseMatrixSymmetric<typename TMAT::TSCAL>> (acmat) != nullptr;
+    if (cmat_symmetric != symmetric) return nullptr;
+    if (cmat->Height() != prol.Width() || cmat->Width() != prol.Width()) return nullptr;
+    return cmat;
+  }
+  
   template <> shared_ptr<BaseSparseMatrix>
   SparseMatrix<double> :: Restrict (const SparseMatrixTM<double> & prol,
                                     shared_ptr<BaseSparseMatrix> acmat ) const
@@ -2415,6 +2830,13 @@ namespace ngla
 
     auto prolT = TransposeMatrix(prol);
 
+    // structure of a previous product is reused, only the numeric phase runs
+    if (auto cmat = ReusableCoarseMatrix<SparseMatrix<double>> (acmat, prol, false))
+      {
+        RestrictNumeric<double> (*this, prol, *prolT, *cmat, false);
+        return cmat;
+      }
+
     auto prod1 = MatMult<double, double, double>(*this, prol);
     auto prod = MatMult<double, double, double>(*prolT, *prod1);
     return prod;
@@ -2429,6 +2851,12 @@ namespace ngla
     // new version
     auto prolT = TransposeMatrix(prol);
 
+    if (auto cmat = ReusableCoarseMatrix<SparseMatrix<Complex>> (acmat, prol, false))
+      {
+        RestrictNumeric<Complex> (*this, prol, *prolT, *cmat, false);
+        return cmat;
+      }
+
     auto prod1 = MatMult<std::complex<double>, std::complex<double>, double>(*this, prol);
     auto prod = MatMult<std::complex<double>, double, std::complex<double>>(*prolT, *prod1);
     return prod;
@@ -2448,6 +2876,12 @@ namespace ngla
     auto prolT = TransposeMatrix(prol);
     auto full = MakeFullMatrix(*this);
 
+    if (auto cmat = ReusableCoarseMatrix<SparseMatrixSymmetric<double>> (acmat, prol, true))
+      {
+        RestrictNumeric<double> (*full, prol, *prolT, *cmat, true);
+        return cmat;
+      }
+
     auto prod1 = MatMult<double, double, double>(*full, prol);
     auto prod = MatMult<double, double, double>(*prolT, *prod1);
 
@@ -2649,8 +3083,11 @@ namespace ngla
 	throw Exception ("SparseMatrix::InverseMatrix:  MumpsInverse not available");
 #endif
       }
+    else if (  BaseSparseMatrix :: GetInverseType()  == SPARSECHOLESKY_MIXED)
+      return CreateMixedCholesky (*this, TV_COL(), subset, nullptr);
     else
-      return make_shared<SparseCholesky<TM,TV_ROW,TV_COL>> (*this, subset);
+      return make_shared<SparseCholesky<TM,TV_ROW,TV_COL>> (*this, subset, nullptr, false,
+                                                            BaseSparseMatrix :: GetInverseType() == SPARSECHOLESKY_ND);
   }
 
   template <class TM, class TV>
@@ -2690,8 +3127,11 @@ namespace ngla
 	throw Exception ("SparseMatrix::InverseMatrix:  MumpsInverse not available");
 #endif
       }
+    else if (  BaseSparseMatrix :: GetInverseType()  == SPARSECHOLESKY_MIXED)
+      return CreateMixedCholesky (*this, TV_COL(), nullptr, clusters);
     else
-      return make_shared<SparseCholesky<TM,TV_ROW,TV_COL>> (*this, nullptr, clusters);
+      return make_shared<SparseCholesky<TM,TV_ROW,TV_COL>> (*this, nullptr, clusters, false,
+                                                            BaseSparseMatrix :: GetInverseType() == SPARSECHOLESKY_ND);
   }
 
 
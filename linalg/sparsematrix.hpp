@@ -99,6 +99,10 @@ namespace ngla
     /// owner of arrays ?
     bool owner;
 
+    /// registers colnr and firsti, see MemoryRegistry
+    MemoryTracker mem_graph { MemoryRegistry::MATRIX_GRAPH };
+    void TrackMemory () { mem_graph.Set (colnr.OwnedBytes() + firsti.OwnedBytes()); }
+
   public:
     /// arbitrary number of els/row
     MatrixGraph (const Array<int> & elsperrow, int awidth);
@@ -106,6 +110,8 @@ namespace ngla
     MatrixGraph (int as, int max_elsperrow);    
     /// shadow matrix graph
     MatrixGraph (const MatrixGraph & graph, bool stealgraph);
+    /// graph in existing CSR arrays, they are referenced and must outlive the graph
+    MatrixGraph (FlatArray<size_t> afirsti, FlatArray<int> acolnr, int awidth);
     /// 
     MatrixGraph (int size, int width,
                  const Table<int> & rowelements, const Table<int> & colelements, bool symmetric);
@@ -125,6 +131,14 @@ namespace ngla
     /// find positions of n sorted elements, overwrite pos, exception for unused
     void GetPositionsSorted (int row, int n, int * pos) const;
 
+    /// offsets within the rows of the entries (dnums1[i], dnums2[j]) of an
+    /// element matrix, stored in pos[i*dnums2.Size()+j], -1 for unused
+    void GetElementPositions (FlatArray<int> dnums1, FlatArray<int> dnums2,
+                              FlatArray<int> pos) const;
+
+    /// the same for the lower triangle added by AddElementMatrixSymmetric
+    void GetElementPositionsSymmetric (FlatArray<int> dnums, FlatArray<int> pos) const;
+
     /// returns position of new element
     size_t CreatePosition (int i, int j);
 
@@ -183,6 +197,10 @@ namespace ngla
       : MatrixGraph (agraph, stealgraph)
     { ; }   
 
+    BaseSparseMatrix (FlatArray<size_t> afirsti, FlatArray<int> acolnr, int awidth)
+      : MatrixGraph (afirsti, acolnr, awidth)
+    { ; }
+
     BaseSparseMatrix (const BaseSparseMatrix & amat)
       : BaseMatrix(amat), MatrixGraph (amat, 0)
     { ; }   
@@ -262,6 +280,8 @@ namespace ngla
     NumaDistributedArray<TM> data;
     VFlatVector<typename mat_traits<TM>::TSCAL> asvec;
     TM nul;
+    /// registers data, see MemoryRegistry
+    MemoryTracker mem_values { MemoryRegistry::MATRIX_VALUES };
 
   public:
     typedef typename mat_traits<TM>::TSCAL TSCAL;
@@ -270,14 +290,14 @@ namespace ngla
       : BaseSparseMatrix (as, max_elsperrow),
 	data(nze), nul(TSCAL(0))
     {
-      ; 
+      FirstTouch();
     }
 
     SparseMatrixTM (const Array<int> & elsperrow, int awidth)
       : BaseSparseMatrix (elsperrow, awidth), 
 	data(nze), nul(TSCAL(0))
     {
-      ; 
+      FirstTouch();
     }
 
     SparseMatrixTM (int size, int width, const Table<int> & rowelements, 
@@ -285,13 +305,14 @@ namespace ngla
       : BaseSparseMatrix (size, width, rowelements, colelements, symmetric), 
 	data(nze), nul(TSCAL(0))
     { 
-      ; 
+      FirstTouch();
     }
 
     SparseMatrixTM (const MatrixGraph & agraph, bool stealgraph)
       : BaseSparseMatrix (agraph, stealgraph), 
 	data(nze), nul(TSCAL(0))
     { 
+      FirstTouch();
       FindSameNZE();
     }
 
@@ -299,14 +320,39 @@ namespace ngla
     : BaseSparseMatrix (amat), 
       data(nze), nul(TSCAL(0))
     { 
+      mem_values.Set (data.OwnedBytes());
       AsVector() = amat.AsVector(); 
     }
 
+    /// matrix in existing CSR arrays, they are referenced and must outlive the matrix
+    SparseMatrixTM (FlatArray<size_t> afirsti, FlatArray<int> acolnr, FlatArray<TM> avalues, int awidth)
+      : BaseSparseMatrix (afirsti, acolnr, awidth), nul(TSCAL(0))
+    {
+      if (avalues.Size() != nze)
+        throw Exception ("SparseMatrix: number of values does not match the column numbers");
+#ifdef USE_NUMA
+      data = NumaDistributedArray<TM> (nze);
+      data = avalues;
+#else
+      data = Array<TM> (nze, nze ? &avalues[0] : nullptr);
+#endif
+      mem_values.Set (data.OwnedBytes());
+    }
+
     static shared_ptr<SparseMatrixTM> CreateFromCOO (FlatArray<int> i, FlatArray<int> j,
                                                      FlatArray<TSCAL> val, size_t h, size_t w);
       
     virtual ~SparseMatrixTM ();
 
+  private:
+    // zero-initialize the values with the row partitioning of MultAdd
+    void FirstTouch ()
+    {
+      mem_values.Set (data.OwnedBytes());
+      ParallelFirstTouch (FlatArray<TM> (data), balance, FlatArray<size_t> (firsti), TM(0.0));
+    }
+  public:
+
     int Height() const { return size; }
     int Width() const { return width; }
     virtual int VHeight() const { return size; }
@@ -344,6 +390,19 @@ namespace ngla
     virtual void AddElementMatrixSymmetric(FlatArray<int> dnums,
                                            BareSliceMatrix<TSCAL> elmat,
                                            bool use_atomic = false);
+
+    /// element matrix given as packed lower triangle
+    void AddElementMatrixSymmetric(FlatArray<int> dnums,
+                                   FlatSymmetricMatrix<TSCAL> elmat,
+                                   bool use_atomic = false);
+
+    /// add element matrix with positions from GetElementPositions(Symmetric),
+    /// no search in the rows
+    void AddElementMatrixIndexed(FlatArray<int> dnums1,
+                                 FlatArray<int> dnums2,
+                                 FlatArray<int> pos,
+                                 BareSliceMatrix<TSCAL> elmat,
+                                 bool use_atomic = false);
     
     virtual BaseVector & AsVector() 
     {
@@ -368,6 +427,27 @@ namespace ngla
     ///
     virtual Array<MemoryUsage> GetMemoryUsage () const;    
   };
+
+
+  /**
+     Flops and memory traffic of a product with k vectors, counted in
+     timer t for the roofline report. One multiply-add are two flops,
+     the matrix, its column indices and row pointers are read once, the
+     vectors are read once and y is written. The stored entries of a
+     symmetric matrix are used twice. Smoothers count every sweep.
+   */
+  template <class TM, class TVX, class TVY>
+  inline void AddSparseMatrixTraffic (Timer & t, const SparseMatrixTM<TM> & mat,
+                                      size_t k = 1, bool symmetric = false, double nsweeps = 1)
+  {
+    constexpr double sc = sizeof(typename mat_traits<TM>::TSCAL) / sizeof(double);
+    double nze = mat.NZE();
+    t.AddFlops ((symmetric ? 2 : 1) * nsweeps * 2 * sc * sc * nze
+                * mat_traits<TM>::HEIGHT * mat_traits<TM>::WIDTH * k);
+    t.AddLoads (nsweeps * (nze * (sizeof(TM) + sizeof(int)) + mat.Height() * sizeof(size_t)
+                           + k * (mat.Width() * sizeof(TVX) + mat.Height() * sizeof(TVY))));
+    t.AddStores (nsweeps * k * mat.Height() * sizeof(TVY));
+  }
   
 
 
@@ -403,6 +483,9 @@ namespace ngla
     SparseMatrix (const MatrixGraph & agraph, bool stealgraph);
     // : SparseMatrixTM<TM> (agraph, stealgraph) { ; }
 
+    SparseMatrix (FlatArray<size_t> afirsti, FlatArray<int> acolnr, FlatArray<TM> avalues, int awidth)
+      : SparseMatrixTM<TM> (afirsti, acolnr, avalues, awidth) { ; }
+
     SparseMatrix (const SparseMatrix & amat)
       : SparseMatrixTM<TM> (amat) { ; }
 
@@ -465,6 +548,8 @@ namespace ngla
     virtual void MultTransAdd (double s, const BaseVector & x, BaseVector & y) const override;
     virtual void MultAdd (Complex s, const BaseVector & x, BaseVector & y) const override;
     virtual void MultTransAdd (Complex s, const BaseVector & x, BaseVector & y) const override;
+    /// reads the matrix once for all vectors if TM is double
+    virtual void MultAdd (double s, const MultiVector & x, MultiVector & y) const override;
 
     virtual void MultAdd1 (double s, const BaseVector & x, BaseVector & y,
 			   const BitArray * ainner = NULL,
@@ -625,6 +710,8 @@ namespace ngla
       MultAdd (s, x, y);
     }
 
+    virtual void MultAdd (double s, const MultiVector & x, MultiVector & y) const override;
+
 
     /*
       y += s L * x
@@ -684,6 +771,11 @@ namespace ngla
 
   shared_ptr<SparseMatrixTM<double>> TransposeMatrix (const SparseMatrixTM<double> & mat);
 
+  /// sa*mata + sb*matb on the union of the patterns, symmetric if both are symmetric
+  NGS_DLL_HEADER shared_ptr<SparseMatrixTM<double>>
+  MatAdd (double sa, const SparseMatrixTM<double> & mata,
+          double sb, const SparseMatrixTM<double> & matb);
+
   shared_ptr<SparseMatrixTM<double>>
   MatMult (const SparseMatrix<double, double, double> & mata, const SparseMatrix<double, double, double> & matb);
 
@@ -16,40 +16,155 @@ namespace ngla
 
   void Projector :: MultAdd (double s, const BaseVector & x, BaseVector & y) const
   {
-    FlatSysVector<> sx = x.SV<double>();
-    FlatSysVector<> sy = y.SV<double>();
-
-    if (keep_values)
-      {
-        for (size_t i : Range(*bits))
-          if ((*bits)[i])
-            sy(i) += s * sx(i);
-      }
-    else
-      {
-        for (size_t i : Range(*bits))
-          if (!(*bits)[i])
-            sy(i) += s * sx(i);
-      }
+    FlatVector<> fx = x.FVDouble();
+    FlatVector<> fy = y.FVDouble();
+    size_t es = x.EntrySize();
+    size_t n = bits->Size();
+
+    ParallelForRange (bits->NumWords(), [&] (IntRange r)
+                      {
+                        for (size_t w : r)
+                          {
+                            uint64_t used = bits->GetWord(w);
+                            if (!keep_values) used = ~used;
+                            for ( ; used; used &= used-1)
+                              {
+                                size_t i = 64*w + TrailingZeros(used);
+                                if (i >= n) break;
+                                for (size_t k = 0; k < es; k++)
+                                  fy(es*i+k) += s * fx(es*i+k);
+                              }
+                          }
+                      });
   }
 
 
   void Projector :: Project (BaseVector & x) const
   {
-    FlatSysVector<> sx = x.SV<double>();
+    x.Mask (*bits, keep_values);
+  }
+
+
+  // y[ind[i]] += s * x[i], or y[i] += s * x[ind[i]] if trans
+  template <typename SCAL>
+  static void IndexedAdd (FlatArray<int> ind, SCAL s, FlatVector<SCAL> fx, FlatVector<SCAL> fy,
+                          size_t es, bool trans)
+  {
+    ParallelForRange (ind.Size(), [&] (IntRange r)
+                      {
+                        for (size_t i : r)
+                          {
+                            size_t ix = trans ? ind[i] : i;
+                            size_t iy = trans ? i : ind[i];
+                            for (size_t k = 0; k < es; k++)
+                              fy(es*iy+k) += s * fx(es*ix+k);
+                          }
+                      });
+  }
+
+  void IndexedEmbedding :: MultAdd (double s, const BaseVector & x, BaseVector & y) const
+  {
+    static Timer t("IndexedEmbedding::MultAdd"); RegionTimer reg(t);
+    IndexedAdd<double> (ind, s, x.FVDouble(), y.FVDouble(), x.EntrySize(), false);
+  }
+
+  void IndexedEmbedding :: MultAdd (Complex s, const BaseVector & x, BaseVector & y) const
+  {
+    static Timer t("IndexedEmbedding::MultAdd complex"); RegionTimer reg(t);
+    IndexedAdd<Complex> (ind, s, x.FVComplex(), y.FVComplex(), x.EntrySize()/2, false);
+  }
+
+  void IndexedEmbedding :: MultTransAdd (double s, const BaseVector & x, BaseVector & y) const
+  {
+    static Timer t("IndexedEmbedding::MultTransAdd"); RegionTimer reg(t);
+    IndexedAdd<double> (ind, s, x.FVDouble(), y.FVDouble(), x.EntrySize(), true);
+  }
+
+  void IndexedEmbedding :: MultTransAdd (Complex s, const BaseVector & x, BaseVector & y) const
+  {
+    static Timer t("IndexedEmbedding::MultTransAdd complex"); RegionTimer reg(t);
+    IndexedAdd<Complex> (ind, s, x.FVComplex(), y.FVComplex(), x.EntrySize()/2, true);
+  }
+
+
+
+  KroneckerMatrix :: KroneckerMatrix (shared_ptr<BaseMatrix> aa, shared_ptr<BaseMatrix> ab)
+  {
+    if (aa->IsComplex() || ab->IsComplex())
+      throw Exception ("KroneckerMatrix: real factors only");
+    a.mat = aa; a.h = aa->Height(); a.w = aa->Width();
+    b.mat = ab; b.h = ab->Height(); b.w = ab->Width();
+  }
+
+  KroneckerMatrix :: KroneckerMatrix (FlatMatrix<double> aa, FlatMatrix<double> ab)
+  {
+    a.h = aa.Height(); a.w = aa.Width();
+    b.h = ab.Height(); b.w = ab.Width();
+    a.dense.SetSize (a.h, a.w);
+    a.dense = aa;
+    b.dense.SetSize (b.h, b.w);
+    b.dense = ab;
+  }
+
+  // rows of y += s * mat * rows of x
+  static void MultRows (const BaseMatrix & mat, double s, FlatMatrix<double> x, FlatMatrix<double> y,
+                        bool trans)
+  {
+    ParallelFor (x.Height(), [&] (size_t i)
+                 {
+                   VFlatVector<double> vx(x.Width(), &x(i,0));
+                   VFlatVector<double> vy(y.Width(), &y(i,0));
+                   if (trans)
+                     mat.MultTransAdd (s, vx, vy);
+                   else
+                     mat.MultAdd (s, vx, vy);
+                 });
+  }
+
+  void KroneckerMatrix :: Apply (double s, FlatMatrix<double> x, FlatMatrix<double> y, bool trans) const
+  {
+    size_t ha = trans ? a.w : a.h, wa = trans ? a.h : a.w;
+    size_t hb = trans ? b.w : b.h;
 
-    if (keep_values)
+    // z = x B^T, the rows of x multiplied by B
+    Matrix<double> z(wa, hb);
+    if (b.mat)
       {
-        for (size_t i : Range(*bits))
-          if (!(*bits)[i])
-            sx(i) = 0.0;
+        z = 0.0;
+        MultRows (*b.mat, 1, x, z, trans);
       }
+    else if (trans)
+      z = x * b.dense;
     else
+      z = x * Trans(b.dense);
+
+    // y += s A z, the columns of z multiplied by A
+    if (a.mat)
       {
-        for (size_t i : Range(*bits))
-          if ((*bits)[i])
-            sx(i) = 0.0;
+        Matrix<double> zt(hb, wa), wt(hb, ha);
+        zt = Trans(z);
+        wt = 0.0;
+        MultRows (*a.mat, s, zt, wt, trans);
+        y += Trans(wt);
       }
+    else if (trans)
+      y += s * Trans(a.dense) * z;
+    else
+      y += s * a.dense * z;
+  }
+
+  void KroneckerMatrix :: MultAdd (double s, const BaseVector & x, BaseVector & y) const
+  {
+    static Timer t("KroneckerMatrix::MultAdd"); RegionTimer reg(t);
+    Apply (s, FlatMatrix<double> (a.w, b.w, x.FVDouble().Data()),
+           FlatMatrix<double> (a.h, b.h, y.FVDouble().Data()), false);
+  }
+
+  void KroneckerMatrix :: MultTransAdd (double s, const BaseVector & x, BaseVector & y) const
+  {
+    static Timer t("KroneckerMatrix::MultTransAdd"); RegionTimer reg(t);
+    Apply (s, FlatMatrix<double> (a.h, b.h, x.FVDouble().Data()),
+           FlatMatrix<double> (a.w, b.w, y.FVDouble().Data()), true);
   }
 
 
@@ -26,9 +26,85 @@ namespace ngla
     virtual int VWidth() const { return bits->Size(); }
 
     virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const;    
+    // symmetric
+    virtual void MultTransAdd (double s, const BaseVector & x, BaseVector & y) const
+    { MultAdd (s, x, y); }
     virtual void Project (BaseVector & x) const;    
   };
 
+  /**
+     Embeds a short vector into a long one, entry i goes to entry
+     ind[i] of the result. The transpose gathers the entries ind.
+     Works on blocks of EntrySize() scalars, so one embedding serves
+     vectors of all block sizes.
+  */
+  class NGS_DLL_HEADER IndexedEmbedding : public BaseMatrix
+  {
+    Array<int> ind;
+    size_t height;
+    bool is_complex;
+  public:
+    IndexedEmbedding (FlatArray<int> aind, size_t aheight, bool ais_complex = false)
+      : ind(aind), height(aheight), is_complex(ais_complex) { ; }
+
+    virtual bool IsComplex() const override { return is_complex; }
+
+    virtual int VHeight() const override { return height; }
+    virtual int VWidth() const override { return ind.Size(); }
+
+    virtual AutoVector CreateRowVector () const override
+    { return CreateBaseVector (ind.Size(), is_complex, 1); }
+    virtual AutoVector CreateColVector () const override
+    { return CreateBaseVector (height, is_complex, 1); }
+
+    virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const override;
+    virtual void MultAdd (Complex s, const BaseVector & x, BaseVector & y) const override;
+    virtual void MultTransAdd (double s, const BaseVector & x, BaseVector & y) const override;
+    virtual void MultTransAdd (Complex s, const BaseVector & x, BaseVector & y) const override;
+
+    FlatArray<int> GetIndices () const { return ind; }
+  };
+
+
+  /**
+     The Kronecker product A (x) B of two real factors, only the factors
+     are stored. A vector is read as matrix X with rows of length
+     B.Width(), as the dofs  dofx*ndofy+dofy  of a tensor product space,
+     and the product is  A X B^T.  Dense factors are applied by matrix
+     products, all other factors row by row.
+  */
+  class NGS_DLL_HEADER KroneckerMatrix : public BaseMatrix
+  {
+    struct Factor
+    {
+      shared_ptr<BaseMatrix> mat;   // or dense
+      Matrix<double> dense;
+      size_t h, w;
+    };
+    Factor a, b;
+  public:
+    KroneckerMatrix (shared_ptr<BaseMatrix> aa, shared_ptr<BaseMatrix> ab);
+    KroneckerMatrix (FlatMatrix<double> aa, FlatMatrix<double> ab);
+
+    virtual bool IsComplex() const override { return false; }
+
+    virtual int VHeight() const override { return a.h*b.h; }
+    virtual int VWidth() const override { return a.w*b.w; }
+
+    virtual AutoVector CreateRowVector () const override
+    { return CreateBaseVector (a.w*b.w, false, 1); }
+    virtual AutoVector CreateColVector () const override
+    { return CreateBaseVector (a.h*b.h, false, 1); }
+
+    virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const override;
+    virtual void MultTransAdd (double s, const BaseVector & x, BaseVector & y) const override;
+
+  private:
+    /// y += s (A X B^T),  or transposed factors
+    void Apply (double s, FlatMatrix<double> x, FlatMatrix<double> y, bool trans) const;
+  };
+
+
   template <class TVR, class TVC>
   class Real2ComplexMatrix : public BaseMatrix
   {
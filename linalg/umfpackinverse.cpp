@@ -125,24 +125,51 @@ namespace ngla
             status = umfpack_zl_symbolic ( compressed_height, compressed_height, &rowstart[0], &indices[0], data, nullptr, &Symbolic, Control, Info );
             umfpack_zl_report_status( nullptr, status );
             if( status!= UMFPACK_OK ) throw Exception("UmfpackInverse: Symbolic factorization failed.");
-
-            status = umfpack_zl_numeric (&rowstart[0], &indices[0], data, nullptr, Symbolic, &Numeric, nullptr, nullptr );
-            umfpack_zl_report_status( nullptr, status );
-            if( status!= UMFPACK_OK ) throw Exception("UmfpackInverse: Numeric factorization failed.");
-
-            umfpack_zl_free_symbolic ( &Symbolic );
           }
         else
           {
             status = umfpack_dl_symbolic ( compressed_height, compressed_height, &rowstart[0], &indices[0], data, &Symbolic, Control, Info );
             umfpack_dl_report_status( nullptr, status );
             if( status!= UMFPACK_OK ) throw Exception("UmfpackInverse: Symbolic factorization failed.");
+          }
+      }
+    catch(Exception e)
+      {
+        if (task_manager) task_manager -> StartWorkers();
+        throw e;
+      }
+
+    if (task_manager) task_manager -> StartWorkers();
+
+    FactorNumeric();
+    cout << IM(3) << " done" << endl;
+
+
+  }
+
 
+  template<class TM>
+  void UmfpackInverseTM<TM> :: FactorNumeric ()
+  {
+    if (task_manager) task_manager -> StopWorkers();
+
+    int status;
+    double *data = reinterpret_cast<double *>(&values[0]);
+    try
+      {
+        if(is_complex)
+          {
+            if (Numeric) umfpack_zl_free_numeric ( &Numeric );
+            status = umfpack_zl_numeric (&rowstart[0], &indices[0], data, nullptr, Symbolic, &Numeric, nullptr, nullptr );
+            umfpack_zl_report_status( nullptr, status );
+            if( status!= UMFPACK_OK ) throw Exception("UmfpackInverse: Numeric factorization failed.");
+          }
+        else
+          {
+            if (Numeric) umfpack_dl_free_numeric ( &Numeric );
             status = umfpack_dl_numeric (&rowstart[0], &indices[0], data, Symbolic, &Numeric, nullptr, nullptr );
             umfpack_dl_report_status( nullptr, status );
             if( status!= UMFPACK_OK ) throw Exception("UmfpackInverse: Numeric factorization failed.");
-
-            umfpack_dl_free_symbolic ( &Symbolic );
           }
       }
     catch(Exception e)
@@ -152,10 +179,31 @@ namespace ngla
       }
 
     if (task_manager) task_manager -> StartWorkers();
+  }
 
-    cout << IM(3) << " done" << endl;
 
+  template<class TM>
+  void UmfpackInverseTM<TM> :: Update ()
+  {
+    static Timer timer("Umfpack Update");
+    RegionTimer reg (timer);
+
+    auto castmatrix = dynamic_pointer_cast<SparseMatrixTM<TM>>(matrix.lock());
+    if (!castmatrix)
+      throw Exception("UmfpackInverse::Update: matrix is gone");
 
+    // same graph, so the arrays keep their memory
+    if (inner)
+      GetUmfpackMatrix (*castmatrix, SubsetFree (*inner));
+    else if (cluster)
+      GetUmfpackMatrix (*castmatrix, SubsetCluster (*cluster));
+    else
+      GetUmfpackMatrix (*castmatrix, SubsetAll());
+
+    if (rowstart[compressed_height] != nze)
+      throw Exception("UmfpackInverse::Update: matrix graph has changed");
+
+    FactorNumeric();
   }
 
 
@@ -417,9 +465,15 @@ namespace ngla
   UmfpackInverseTM<TM> :: ~UmfpackInverseTM()
   {
     if(is_complex)
-      umfpack_zl_free_numeric ( &Numeric );
+      {
+        umfpack_zl_free_numeric ( &Numeric );
+        umfpack_zl_free_symbolic ( &Symbolic );
+      }
     else
-      umfpack_dl_free_numeric ( &Numeric );
+      {
+        umfpack_dl_free_numeric ( &Numeric );
+        umfpack_dl_free_symbolic ( &Symbolic );
+      }
 
 #ifdef USE_MKL
     mkl_free_buffers();
@@ -45,6 +45,8 @@ namespace ngla
     bool symmetric, is_complex;
 
     void SetMatrixType();
+    /// numeric factorization, re-uses the symbolic analysis
+    void FactorNumeric();
 
     bool compressed;
     Array<int> compress;
@@ -62,6 +64,10 @@ namespace ngla
     void GetUmfpackMatrix (const SparseMatrixTM<TM> & a, TSUBSET subset);
 
     virtual ~UmfpackInverseTM ();
+
+    /// graph and symbolic analysis are kept, only values are refactored
+    virtual bool SupportsUpdate() const { return true; }
+    virtual void Update();
     ///
     int VHeight() const { return height/entrysize; }
     ///
@@ -30,17 +30,27 @@ namespace ngla
     {
       this->size = as;
       es = aes;
-      pdata = new TSCAL[as*aes];
+      pdata = MemoryPool::Alloc<TSCAL> (as*aes);
       ownmem = true;
+      MemoryRegistry::Alloc (MemoryRegistry::VECTORS, as*aes*sizeof(TSCAL));
       this->entrysize = es * sizeof(TSCAL) / sizeof(double);
+      // place pages like the (evenly split) parallel vector operations,
+      // a recycled block of the same size keeps its placement
+      ParallelFirstTouch (FlatArray<TSCAL> (as*aes, pdata));
     }
 
     void SetSize (size_t as)
     {
-      if (ownmem) delete [] pdata;
+      if (ownmem)
+        {
+          MemoryPool::Free (pdata, this->size*es);
+          MemoryRegistry::Free (MemoryRegistry::VECTORS, this->size*es*sizeof(TSCAL));
+        }
       this->size = as;
-      pdata = new TSCAL[as*es];
+      pdata = MemoryPool::Alloc<TSCAL> (as*es);
       ownmem = true;
+      MemoryRegistry::Alloc (MemoryRegistry::VECTORS, as*es*sizeof(TSCAL));
+      ParallelFirstTouch (FlatArray<TSCAL> (as*es, pdata));
     }
 
     void AssignMemory (size_t as, void * adata)
@@ -34,6 +34,8 @@ namespace ngmg
 
     SetUpdateAll (biform.UseGalerkin());
     SetUpdateAlways (0);
+    SetFusedRestriction (false);
+    SetAdditive (false);
     checksumcgpre = -17;
     //    Update ();
   }
@@ -88,6 +90,14 @@ namespace ngmg
     if (prolongation)
       prolongation->Update(fespace);
 
+    if (fused_restriction)
+      for (int level = prolmats.Size(); level < ma.GetNLevels(); level++)
+        {
+          shared_ptr<SparseMatrix<double>> prol;
+          if (level > 0)
+            prol = shared_ptr<SparseMatrix<double>> (prolongation->CreateProlongationMatrix (level));
+          prolmats.Append (prol);
+        }
 
     //  coarsegridpre = biform.GetMatrix(1).CreateJacobiPrecond();
     // InverseMatrix();
@@ -186,6 +196,50 @@ namespace ngmg
       }
   }
 
+  /// rc = P^T (f - A u), the fine residual is never stored
+  static void ResiduumRestrict (const SparseMatrix<double> & a,
+                                const SparseMatrix<double> & prol,
+                                const BaseVector & u, const BaseVector & f,
+                                BaseVector & rc)
+  {
+    static Timer t("MG residuum-restrict"); RegionTimer reg(t);
+    t.AddFlops (2*a.NZE() + 2*prol.NZE());
+
+    FlatVector<> fu = u.FV<double>();
+    FlatVector<> ff = f.FV<double>();
+    FlatVector<> frc = rc.FV<double>();
+    frc = 0.0;
+    
+    // a coarse entry receives from several fine rows
+    ParallelForRange (a.Height(), [&] (IntRange r)
+                      {
+                        for (auto i : r)
+                          {
+                            double ri = ff(i) - a.RowTimesVector (i, fu);
+                            FlatArray<int> cols = prol.GetRowIndices(i);
+                            FlatVector<double> vals = prol.GetRowValues(i);
+                            for (auto j : Range(cols))
+                              MyAtomicAdd (frc(cols[j]), vals(j) * ri);
+                          }
+                      });
+  }
+
+  /// the cached prolongation, if the fused kernel applies on this level
+  static const SparseMatrix<double> * 
+  FusedProlongation (const Array<shared_ptr<SparseMatrix<double>>> & prolmats,
+                     int level, const BaseMatrix & mat, const BaseVector & u)
+  {
+    if (level >= prolmats.Size() || !prolmats[level] || u.EntrySize() != 1)
+      return nullptr;
+    // symmetric storage has no full rows
+    auto a = dynamic_cast<const SparseMatrix<double>*> (&mat);
+    if (!a || dynamic_cast<const SparseMatrixSymmetric<double>*> (&mat))
+      return nullptr;
+    if (prolmats[level]->Height() != a->Height())
+      return nullptr;
+    return prolmats[level].get();
+  }
+
   void MultigridPreconditioner :: 
   MGM (int level, BaseVector & u, 
        const BaseVector & f, int incsm) const
@@ -235,6 +289,35 @@ namespace ngmg
 	    smoother->PostSmooth (level, u, f, smoothingsteps * incsm);
 	  }
 
+	else if (additive)
+	  {
+            // u = S f + P MGM(R f): the smoothing on this level does not
+            // wait for the coarse levels, both share the threads
+	    auto d = smoother->CreateVector(level);
+	    auto w = smoother->CreateVector(level);
+	    auto dt = d.Range (0, fespace.GetNDofLevel(level-1));
+	    auto wt = w.Range (0, fespace.GetNDofLevel(level-1));
+
+            d = f;
+	    prolongation->RestrictInline (level, d);
+	    w = 0;
+
+            ParallelJob ([&] (TaskInfo & ti)
+                         {
+                           if (ti.task_nr == 0)
+                             {
+                               smoother->PreSmooth (level, u, f, smoothingsteps * incsm);
+                               smoother->PostSmooth (level, u, f, smoothingsteps * incsm);
+                             }
+                           else
+                             for (int j = 1; j <= cycle; j++)
+                               MGM (level-1, wt, dt, incsm * incsmooth);
+                         }, 2);
+
+	    prolongation->ProlongateInline (level, w);
+	    u += w;
+	  }
+
 	else
 	  {
 	    auto d = smoother->CreateVector(level);
@@ -242,13 +325,24 @@ namespace ngmg
 	    //(*testout) << "u.Size() " << u.Size() << " d.Size() " << d.Size()
 	    //       << " w.Size() " << w.Size() << endl;
 
-	    // smoother->PreSmooth (level, u, f, smoothingsteps * incsm);
-	    smoother->PreSmoothResiduum (level, u, f, *d, smoothingsteps * incsm);
-	    
-
 	    auto dt = d.Range (0, fespace.GetNDofLevel(level-1));
 	    auto wt = w.Range (0, fespace.GetNDofLevel(level-1));
 
+            const BaseMatrix & mat = biform.GetMatrix(level);
+            auto prol = fused_restriction ? FusedProlongation (prolmats, level, mat, u) : nullptr;
+
+            if (prol)
+              {
+                smoother->PreSmooth (level, u, f, smoothingsteps * incsm);
+                ResiduumRestrict (dynamic_cast<const SparseMatrix<double>&> (mat), *prol, u, f, dt);
+              }
+            else
+              {
+                // smoother->PreSmooth (level, u, f, smoothingsteps * incsm);
+                smoother->PreSmoothResiduum (level, u, f, *d, smoothingsteps * incsm);
+                prolongation->RestrictInline (level, d);
+              }
+
 
 	    // smoother->Residuum (level, u, f, d);
 
@@ -258,8 +352,6 @@ namespace ngmg
 	    smoother->Residuum (level, u, f, d);
 	    */
 
-	    prolongation->RestrictInline (level, d);
-
 	    w = 0;
 	    for (int j = 1; j <= cycle; j++)
 	      MGM (level-1, wt, dt, incsm * incsmooth);
@@ -305,6 +397,7 @@ namespace ngmg
     : mat(amat), cpre (acpre), smoother(asmoother), level(alevel)
   {
     SetSmoothingSteps (1);
+    SetAdditive (false);
     Update();
   }
   
@@ -331,6 +424,24 @@ namespace ngmg
     */
     u = 0;
 
+    if (additive)
+      {
+        // the coarse solve runs concurrently with the smoothing
+        cres = *f.Range (0, cres.Size());
+        ParallelJob ([&] (TaskInfo & ti)
+                     {
+                       if (ti.task_nr == 0)
+                         {
+                           smoother->PreSmooth (level, u, f, smoothingsteps);
+                           smoother->PostSmooth (level, u, f, smoothingsteps);
+                         }
+                       else
+                         cw = *cpre * cres;
+                     }, 2);
+        u.Range (0, cw.Size()) += cw;
+        return;
+      }
+
       {
         // smoother->PreSmooth (level, u, f, smoothingsteps);
         // res = f - (*mat) * u;    
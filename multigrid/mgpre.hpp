@@ -54,6 +54,12 @@ namespace ngmg
     int updateall;
     /// creates a new smoother for each update
     bool update_always; 
+    /// computes the coarse residual P^T (f - A u) in one pass over A
+    bool fused_restriction;
+    /// additive cycle, the coarse levels run concurrently with the smoothers
+    bool additive;
+    /// cached prolongation matrices, nullptr if not available
+    Array<shared_ptr<SparseMatrix<double>>> prolmats;
     /// for robust prolongation
     // Array<BaseMatrix*> prol_projection;
   public:
@@ -85,6 +91,10 @@ namespace ngmg
     ///
     void SetUpdateAlways (bool ua = 1) { update_always = ua; }
     ///
+    void SetFusedRestriction (bool fr = true) { fused_restriction = fr; }
+    ///
+    void SetAdditive (bool ad = true) { additive = ad; }
+    ///
     virtual void Update () override;
 
     ///
@@ -140,6 +150,8 @@ namespace ngmg
     int level;
     ///
     int smoothingsteps;
+    /// smoother and coarse solve run concurrently
+    bool additive;
   public:
     ///
     TwoLevelMatrix (const BaseMatrix * amat, 
@@ -160,6 +172,8 @@ namespace ngmg
     ///
     void SetSmoothingSteps(int ass) { smoothingsteps = ass; }
     ///
+    void SetAdditive (bool ad = true) { additive = ad; }
+    ///
     const Smoother & GetSmoother() const
     { return *smoother; }
     ///
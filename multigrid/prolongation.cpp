@@ -26,38 +26,137 @@ namespace ngmg
   LinearProlongation :: ~LinearProlongation() { ; }
 
   
+  TransferGenerations :: 
+  TransferGenerations (size_t nc, size_t nf, 
+                       const function<INT<2>(size_t)> & getparents)
+  {
+    static Timer t("TransferGenerations"); RegionTimer reg(t);
+
+    // parents outside [0,nf) hold zeros, they don't define an order
+    auto parents_of = [&] (size_t i)
+      {
+        INT<2> pa = getparents(i);
+        for (int j = 0; j < 2; j++)
+          if (pa[j] < 0 || size_t(pa[j]) >= nf) pa[j] = -1;
+        if (pa[1] == pa[0]) pa[1] = -1;
+        return pa;
+      };
+
+    // a parent may have any number, sweep until all generations are known
+    Array<int> gen(nf-nc);
+    gen = -1;
+    int ngen = 0;
+    size_t nknown = 0;
+    while (nknown < gen.Size())
+      {
+        size_t oldknown = nknown;
+        for (size_t i = nc; i < nf; i++)
+          {
+            if (gen[i-nc] != -1) continue;
+            INT<2> pa = parents_of(i);
+            int g = 0;
+            bool ready = true;
+            for (int j = 0; j < 2; j++)
+              if (pa[j] >= int(nc))
+                {
+                  if (gen[pa[j]-nc] == -1)
+                    ready = false;
+                  else
+                    g = max2 (g, gen[pa[j]-nc]+1);
+                }
+            if (!ready) continue;
+            gen[i-nc] = g;
+            ngen = max2 (ngen, g+1);
+            nknown++;
+          }
+        if (nknown == oldknown)
+          throw Exception ("TransferGenerations: cyclic parent relation");
+      }
+
+    TableCreator<int> creator(ngen);
+    for ( ; !creator.Done(); creator++)
+      for (size_t i = nc; i < nf; i++)
+        creator.Add (gen[i-nc], int(i));
+    dofs = creator.MoveTable();
+
+    parents = Array<Array<int>> (ngen);
+    children = Array<Table<int>> (ngen);
+    for (auto g : Range(ngen))
+      {
+        FlatArray<int> gdofs = dofs[g];
+        Table<int> pc = ParallelCreateTable<int>
+          (gdofs.Size(), [&] (auto & creator, size_t k)
+           {
+             int c = gdofs[k];
+             INT<2> pa = parents_of(c);
+             for (int j = 0; j < 2; j++)
+               if (pa[j] != -1)
+                 creator.Add (pa[j], c);
+           }, nf);
+
+        // keep the rows of the parents of this generation
+        Array<int> & gparents = parents[g];
+        for (auto p : Range(pc.Size()))
+          if (pc[p].Size()) gparents.Append (p);
+        Array<int> cnt(gparents.Size());
+        for (auto k : Range(gparents))
+          cnt[k] = pc[gparents[k]].Size();
+        Table<int> gchildren(cnt);
+        ParallelFor (gparents.Size(), [&] (size_t k)
+                     {
+                       auto row = pc[gparents[k]];
+                       for (auto j : Range(row))
+                         gchildren[k][j] = row[j];
+                     });
+        children[g] = move(gchildren);
+      }
+  }
+
+
+
   void LinearProlongation :: Update (const FESpace & fes)
   {
     if (ma->GetNLevels() > nvlevel.Size())
-      nvlevel.Append (ma->GetNV());
+      {
+        nvlevel.Append (ma->GetNV());
+        if (nvlevel.Size() == 1)
+          generations.Append (nullptr);
+        else
+          {
+            auto pma = ma;
+            generations.Append (make_shared<TransferGenerations>
+                                (nvlevel[nvlevel.Size()-2], nvlevel.Last(),
+                                 [pma] (size_t i) { return pma->GetParentNodes (i); }));
+          }
+      }
   }
 
   
   void LinearProlongation :: ProlongateInline (int finelevel, BaseVector & v) const
   {
     static Timer t("Prolongate"); RegionTimer r(t);
-    size_t nc = nvlevel[finelevel-1];
     size_t nf = nvlevel[finelevel];
+    const TransferGenerations & gens = *generations[finelevel];
     
     if (v.EntrySize() == 1)
       {
         FlatVector<> fv = v.FV<double>();        
         fv.Range (nf, fv.Size()) = 0;
-        for (size_t i = nc; i < nf; i++)
-          {
-            auto parents = ma->GetParentNodes (i);
-            fv(i) = 0.5 * (fv(parents[0]) + fv(parents[1]));
-          }
+        gens.Prolongate ([&] (int i)
+                         {
+                           auto parents = ma->GetParentNodes (i);
+                           fv(i) = 0.5 * (fv(parents[0]) + fv(parents[1]));
+                         });
       }
     else
       {
         FlatSysVector<> sv = v.SV<double>();
         sv.Range (nf, sv.Size()) = 0;
-        for (size_t i = nc; i < nf; i++)
-          {
-            auto parents = ma->GetParentNodes (i);
-            sv(i) = 0.5 * (sv(parents[0]) + sv(parents[1]));
-          }
+        gens.Prolongate ([&] (int i)
+                         {
+                           auto parents = ma->GetParentNodes (i);
+                           sv(i) = 0.5 * (sv(parents[0]) + sv(parents[1]));
+                         });
       }
   }
 
@@ -66,17 +165,16 @@ namespace ngmg
     {
       static Timer t("Restrict"); RegionTimer r(t);
       
-      size_t nc = nvlevel[finelevel-1];
       size_t nf = nvlevel[finelevel];
 
       FlatSysVector<> fv = v.SV<double>();
-    
-      for (size_t i = nf; i-- > nc; )
-	{
-	  auto parents = ma->GetParentNodes (i);
-	  fv(parents[0]) += 0.5 * fv(i);
-	  fv(parents[1]) += 0.5 * fv(i);
-	}
+
+      // every parent gathers from its children
+      generations[finelevel]->Restrict ([&] (int p, FlatArray<int> children)
+                                        {
+                                          for (int c : children)
+                                            fv(p) += 0.5 * fv(c);
+                                        });
 
       for (size_t i = nf; i < fv.Size(); i++)
 	fv(i) = 0;  
@@ -85,65 +183,68 @@ namespace ngmg
 
   SparseMatrix< double >* LinearProlongation :: CreateProlongationMatrix( int finelevel ) const
   {
-    int i;
-    int parents[2];
-
-    int nc = nvlevel[finelevel-1];
-    int nf = nvlevel[finelevel];
-
-    Array< int > indicesPerRow(nf);
+    size_t nc = nvlevel[finelevel-1];
+    size_t nf = nvlevel[finelevel];
 
-    /*
-    if (space.LowOrderFESpacePtr())
+    // the row of a new vertex combines the rows of its parents, which are
+    // coarse vertices or new vertices of an earlier generation
+    Array<Array<int>> cols(nf-nc);
+    Array<Array<double>> vals(nf-nc);
+    auto add_row = [&] (size_t i, int parent, double fac)
       {
-        nf = space.LowOrderFESpacePtr()->GetNDofLevel( finelevel );
-        nc = space.LowOrderFESpacePtr()->GetNDofLevel( finelevel-1 );
-      }
-    else
-      {
-        nf = space.GetNDofLevel( finelevel );
-        nc = space.GetNDofLevel( finelevel-1 );
-      }
-    */
-    
+        Array<int> & ci = cols[i-nc];
+        Array<double> & vi = vals[i-nc];
+        auto add_entry = [&] (int col, double val)
+          {
+            for (auto k : Range(ci))
+              if (ci[k] == col)
+                {
+                  vi[k] += val;
+                  return;
+                }
+            ci.Append (col);
+            vi.Append (val);
+          };
+        if (size_t(parent) < nc)
+          add_entry (parent, fac);
+        else
+          for (auto k : Range(cols[parent-nc]))
+            add_entry (cols[parent-nc][k], fac * vals[parent-nc][k]);
+      };
+
+    const TransferGenerations & gens = *generations[finelevel];
+    for (auto g : Range(gens.NumGenerations()))
+      ParallelFor (gens.Generation(g).Size(), [&] (size_t k)
+                   {
+                     size_t i = gens.Generation(g)[k];
+                     auto parents = ma->GetParentNodes (i);
+                     for (int j = 0; j < 2; j++)
+                       if (parents[j] != -1)
+                         add_row (i, parents[j], 0.5);
+                   });
+
     // count entries per row
-    indicesPerRow = 0;
-    for( i=0; i<nc; i++ )
-      indicesPerRow[ i ]++;
-    for( i=nc; i<nf; i++ )
-      {
-        ma->GetParentNodes( i, parents );
-        if ( parents[ 0 ] != -1 )
-          indicesPerRow[ i ]++;
-        if ( parents[ 1 ] != -1 )
-          indicesPerRow[ i ]++;
-      }
+    Array< int > indicesPerRow(nf);
+    for (size_t i = 0; i < nc; i++)
+      indicesPerRow[i] = 1;
+    for (size_t i = nc; i < nf; i++)
+      indicesPerRow[i] = cols[i-nc].Size();
 
     // create matrix graph
     MatrixGraph mg( indicesPerRow, nc );
-    for( i=0; i<nc; i++ )
+    for (size_t i = 0; i < nc; i++)
       mg.CreatePosition( i, i );
-    for( i=nc; i<nf; i++ )
-      {
-        ma->GetParentNodes( i, parents );
-        if ( parents[ 0 ] != -1 )
-          mg.CreatePosition( i, parents[ 0 ] ); 
-        if ( parents[ 1 ] != -1 )
-          mg.CreatePosition( i, parents[ 1 ] ); 
-      }
+    for (size_t i = nc; i < nf; i++)
+      for (int c : cols[i-nc])
+        mg.CreatePosition( i, c );
 
     // write prolongation matrix
     SparseMatrix< double >* prol = new SparseMatrix< double >( mg, 1 );
-    for( i=0; i<nc; i++ )
+    for (size_t i = 0; i < nc; i++)
       (*prol)( i, i ) = 1;
-    for( i=nc; i<nf; i++ )
-      {
-        ma->GetParentNodes( i, parents );
-        if ( parents[ 0 ] != -1 )
-          (*prol)( i, parents[ 0 ] ) = 0.5; 
-        if ( parents[ 1 ] != -1 )
-          (*prol)( i, parents[ 1 ] ) = 0.5; 
-      }
+    for (size_t i = nc; i < nf; i++)
+      for (auto k : Range(cols[i-nc]))
+        (*prol)( i, cols[i-nc][k] ) = vals[i-nc][k];
 
     return prol;
   }
@@ -415,6 +516,98 @@ namespace ngmg
       ;
     }
 
+
+
+  void EdgeProlongation :: Update (const FESpace & fes)
+  {
+    const NedelecFESpace & fspace = space;
+    while (generations.Size() < ma->GetNLevels())
+      {
+        int level = generations.Size();
+        if (level == 0)
+          {
+            generations.Append (nullptr);
+            continue;
+          }
+        generations.Append (make_shared<TransferGenerations>
+                            (space.GetNDofLevel (level-1), space.GetNDofLevel (level),
+                             [&fspace] (size_t i)
+                             {
+                               int pa1 = fspace.ParentEdge1 (i);
+                               int pa2 = fspace.ParentEdge2 (i);
+                               return INT<2> ( (pa1 != -1) ? pa1/2 : -1, 
+                                               (pa2 != -1) ? pa2/2 : -1 );
+                             }));
+      }
+  }
+
+  void EdgeProlongation :: ProlongateInline (int finelevel, BaseVector & v) const
+  {
+    static Timer t("EdgeProlongate"); RegionTimer r(t);
+    size_t nf = space.GetNDofLevel (finelevel);
+    FlatSysVector<> fv (v.Size(), v.EntrySize(), static_cast<double*>(v.Memory()));
+
+    for (size_t i = nf; i < fv.Size(); i++)
+      fv(i) = 0;
+
+    generations[finelevel]->Prolongate ([&] (int i)
+      {
+        int pa1 = space.ParentEdge1 (i);
+        int pa2 = space.ParentEdge2 (i);
+        
+        fv(i) = 0;
+        if (pa1 != -1)
+          {
+            if (pa1 & 1)
+              fv(i) += 0.5 * fv(pa1/2);
+            else
+              fv(i) -= 0.5 * fv(pa1/2);
+          }
+        if (pa2 != -1)
+          {
+            if (pa2 & 1)
+              fv(i) += 0.5 * fv(pa2/2);
+            else
+              fv(i) -= 0.5 * fv(pa2/2);
+          }
+      });
+
+    ParallelFor (nf, [&] (size_t i)
+                 {
+                   if (space.FineLevelOfEdge(i) < finelevel)
+                     fv(i) = 0;
+                 });
+  }
+
+  void EdgeProlongation :: RestrictInline (int finelevel, BaseVector & v) const
+  {
+    static Timer t("EdgeRestrict"); RegionTimer r(t);
+    size_t nc = space.GetNDofLevel (finelevel-1);
+    size_t nf = space.GetNDofLevel (finelevel);
+    FlatSysVector<> fv (v.Size(), v.EntrySize(), static_cast<double*>(v.Memory()));
+
+    ParallelFor (nf, [&] (size_t i)
+                 {
+                   if (space.FineLevelOfEdge(i) < finelevel)
+                     fv(i) = 0;
+                 });
+
+    // every parent gathers from its children, with the orientation of the child
+    generations[finelevel]->Restrict ([&] (int p, FlatArray<int> children)
+      {
+        for (int c : children)
+          {
+            double w = 0;
+            for (int pa : { space.ParentEdge1 (c), space.ParentEdge2 (c) })
+              if (pa != -1 && pa/2 == p)
+                w += (pa & 1) ? 0.5 : -0.5;
+            fv(p) += w * fv(c);
+          }
+      });
+
+    ParallelFor (IntRange(nc, fv.Size()), [&] (size_t i) { fv(i) = 0; });
+  }
+
   /*
     void ElementProlongation :: Update ()
     {
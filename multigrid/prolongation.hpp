@@ -35,6 +35,60 @@ namespace ngmg
   };
 
 
+  /**
+     The new dofs of one level, grouped into generations. The parents of 
+     a dof are coarse dofs or dofs of earlier generations, so the dofs 
+     of one generation are prolongated in parallel. The restriction 
+     gathers the contributions of the children of one parent, no two 
+     tasks write the same entry.
+  */
+  class NGS_DLL_HEADER TransferGenerations
+  {
+    /// the dofs of every generation
+    Table<int> dofs;
+    /// per generation, the dofs receiving restricted values ...
+    Array<Array<int>> parents;
+    /// ... and their children in this generation
+    Array<Table<int>> children;
+  public:
+    /// getparents(i) returns the (up to) two parents of new dof i, -1 for none
+    TransferGenerations (size_t nc, size_t nf, 
+                         const function<INT<2>(size_t)> & getparents);
+
+    size_t NumGenerations () const { return dofs.Size(); }
+    FlatArray<int> Generation (size_t g) const { return dofs[g]; }
+
+    /// func(i) for all new dofs, generation by generation
+    template <typename TFUNC>
+    void Prolongate (TFUNC func) const
+    {
+      for (auto g : Range(dofs.Size()))
+        {
+          FlatArray<int> gdofs = dofs[g];
+          ParallelForRange (gdofs.Size(), [&] (IntRange r)
+                            {
+                              for (auto k : r) func (gdofs[k]);
+                            });
+        }
+    }
+
+    /// func(parent, children) in reverse order of the generations
+    template <typename TFUNC>
+    void Restrict (TFUNC func) const
+    {
+      for (size_t g = dofs.Size(); g-- > 0; )
+        {
+          FlatArray<int> gparents = parents[g];
+          const Table<int> & gchildren = children[g];
+          ParallelForRange (gparents.Size(), [&] (IntRange r)
+                            {
+                              for (auto k : r) func (gparents[k], gchildren[k]);
+                            });
+        }
+    }
+  };
+
+
   /**
      Standard Prolongation.
      Child nodes between 2 parent nodes.
@@ -43,6 +97,8 @@ namespace ngmg
   {
     shared_ptr<MeshAccess> ma;
     Array<size_t> nvlevel;
+    /// the vertices of every level, nullptr on the coarsest
+    Array<shared_ptr<TransferGenerations>> generations;
   public:
     LinearProlongation(shared_ptr<MeshAccess> ama)
       : ma(ama) { ; }
@@ -185,6 +241,8 @@ namespace ngmg
     shared_ptr<MeshAccess> ma;
     ///
     const NedelecFESpace & space;
+    /// the new edges of every level, nullptr on the coarsest
+    Array<shared_ptr<TransferGenerations>> generations;
   public:
     ///
     EdgeProlongation(const NedelecFESpace & aspace)
@@ -193,100 +251,16 @@ namespace ngmg
     virtual ~EdgeProlongation() { ; }
   
     ///
-    virtual void Update (const FESpace & fes) { ; }
+    virtual void Update (const FESpace & fes);
 
     ///
     virtual SparseMatrix< double >* CreateProlongationMatrix( int finelevel ) const
     { return NULL; }
 
     ///
-    virtual void ProlongateInline (int finelevel, BaseVector & v) const
-    {
-      int nc = space.GetNDofLevel (finelevel-1);
-      int nf = space.GetNDofLevel (finelevel);
-      /*    
-	    FlatVector<TV> & fv = 
-	    dynamic_cast<VFlatVector<TV> &> (v).FV();
-      */
-      //    FlatVector<TV> fv = dynamic_cast<T_BaseVector<TV> &> (v).FV();
-      FlatSysVector<> fv (v.Size(), v.EntrySize(), static_cast<double*>(v.Memory()));
-
-      int i, k;
-
-      for (i = nf; i < fv.Size(); i++)
-	fv(i) = 0;
-
-      for (k = 1; k <= 10; k++)
-	for (i = nc; i < nf; i++)
-	  {
-	    int pa1 = space.ParentEdge1 (i);
-	    int pa2 = space.ParentEdge2 (i);
-	  
-	    fv(i) = 0;
-	    if (pa1 != -1)
-	      {
-		if (pa1 & 1)
-		  fv(i) += 0.5 * fv(pa1/2);
-		else
-		  fv(i) -= 0.5 * fv(pa1/2);
-	      }
-	    if (pa2 != -1)
-	      {
-		if (pa2 & 1)
-		  fv(i) += 0.5 * fv(pa2/2);
-		else
-		  fv(i) -= 0.5 * fv(pa2/2);
-	      }
-	  }
-
-      for (i = 0; i < nf; i++)
-	if (space.FineLevelOfEdge(i) < finelevel)
-	  fv(i) = 0;
-    }
-
-
+    virtual void ProlongateInline (int finelevel, BaseVector & v) const;
     ///
-    virtual void RestrictInline (int finelevel, BaseVector & v) const
-    {
-      int nc = space.GetNDofLevel (finelevel-1);
-      int nf = space.GetNDofLevel (finelevel);
-
-      //    FlatVector<TV> & fv = 
-      //      dynamic_cast<VFlatVector<TV> &> (v).FV();
-      //    FlatVector<TV> fv = dynamic_cast<T_BaseVector<TV> &> (v).FV();
-
-      FlatSysVector<> fv (v.Size(), v.EntrySize(), static_cast<double*>(v.Memory()));
-
-      for (int i = 0; i < nf; i++)
-	if (space.FineLevelOfEdge(i) < finelevel)
-	  fv(i) = 0;
-	
-      for (int k = 1; k <= 10; k++)
-	for (int i = nf-1; i >= nc; i--)
-	  {
-	    int pa1 = space.ParentEdge1 (i);
-	    int pa2 = space.ParentEdge2 (i);
-	  
-	    if (pa1 != -1)
-	      {
-		if (pa1 & 1)
-		  fv(pa1/2) += 0.5 * fv(i);
-		else
-		  fv(pa1/2) -= 0.5 * fv(i);
-	      }
-	    if (pa2 != -1)
-	      {
-		if (pa2 & 1)
-		  fv(pa2/2) += 0.5 * fv(i);
-		else
-		  fv(pa2/2) -= 0.5 * fv(i);
-	      }
-	    fv(i) = 0;
-	  }
-
-      for (int i = nf; i < fv.Size(); i++)
-	fv(i) = 0;  
-    }
+    virtual void RestrictInline (int finelevel, BaseVector & v) const;
 
     ///
     void ApplyGradient (int level, const BaseVector & pot, BaseVector & grad) const
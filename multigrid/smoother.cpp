@@ -42,9 +42,21 @@ namespace ngmg
 
   GSSmoother :: 
   GSSmoother  (const MeshAccess & ama,
-	       const BilinearForm & abiform)
-    : /* ma(ama), */ biform(abiform)
-  {
+	       const BilinearForm & abiform,
+               const Flags & aflags)
+    : Smoother(aflags), /* ma(ama), */ biform(abiform)
+  {
+    // parallel sweeps by default if we have threads
+    string order = flags.GetStringFlag ("gsorder", TaskManager::GetNumThreads() > 1 ?
+                                        "multicolor" : "sequential");
+    if (order == "sequential")
+      gsorder = BaseJacobiPrecond::GS_SEQUENTIAL;
+    else if (order == "multicolor")
+      gsorder = BaseJacobiPrecond::GS_MULTICOLOR;
+    else if (order == "hybrid")
+      gsorder = BaseJacobiPrecond::GS_HYBRID;
+    else
+      throw Exception ("GSSmoother: unknown gsorder '" + order + "'");
     Update();
   }
 
@@ -60,8 +72,11 @@ namespace ngmg
     for (i = 0; i < biform.GetNLevels(); i++)
       {
 	if (biform.GetMatrixPtr(i))
-	  jac[i] = dynamic_cast<const BaseSparseMatrix&> (*biform.GetMatrixPtr(i))
-	    .CreateJacobiPrecond(biform.GetFESpace()->GetFreeDofs());
+	  {
+	    jac[i] = dynamic_cast<const BaseSparseMatrix&> (*biform.GetMatrixPtr(i))
+	      .CreateJacobiPrecond(biform.GetFESpace()->GetFreeDofs());
+	    jac[i]->SetGSOrder (gsorder);
+	  }
 	else
 	  jac[i] = NULL;
       }
@@ -151,6 +166,63 @@ namespace ngmg
 
 
 
+  ChebyshevSmoother :: 
+  ChebyshevSmoother  (const MeshAccess & ama,
+                      const BilinearForm & abiform,
+                      const Flags & aflags)
+    : Smoother(aflags), biform(abiform)
+  {
+    Update();
+  }
+
+  void ChebyshevSmoother :: Update (bool force_update)
+  {
+    int degree = int(flags.GetNumFlag ("chebyshevdegree", 3));
+    int eigsteps = int(flags.GetNumFlag ("eigensteps", 10));
+    double ratio = flags.GetNumFlag ("chebyshevratio", 30);
+
+    cheb.SetSize (biform.GetNLevels());
+    for (int i = 0; i < biform.GetNLevels(); i++)
+      {
+        auto mat = dynamic_pointer_cast<SparseMatrixTM<double>> (biform.GetMatrixPtr(i));
+        if (biform.GetMatrixPtr(i) && !mat)
+          throw Exception ("ChebyshevSmoother needs a real sparse matrix");
+        if (mat)
+          cheb[i] = make_shared<ChebyshevPrecond> (*mat, biform.GetFESpace()->GetFreeDofs(),
+                                                   degree, eigsteps, ratio);
+        else
+          cheb[i] = nullptr;
+      }
+  }
+
+  void ChebyshevSmoother :: PreSmooth (int level, BaseVector & u, 
+                                       const BaseVector & f, int steps) const
+  {
+    for (int i = 0; i < steps; i++)
+      cheb[level]->Smooth (u, f);
+  }
+
+  void ChebyshevSmoother :: PostSmooth (int level, BaseVector & u, 
+                                        const BaseVector & f, int steps) const
+  {
+    for (int i = 0; i < steps; i++)
+      cheb[level]->Smooth (u, f);
+  }
+
+  void ChebyshevSmoother :: 
+  Residuum (int level, BaseVector & u, 
+	    const BaseVector & f, BaseVector & d) const
+  {
+    d = f - biform.GetMatrix(level) * u;
+  }
+  
+  AutoVector ChebyshevSmoother :: CreateVector(int level) const
+  {
+    return biform.GetMatrix(level).CreateVector();
+  }
+
+
+
   AnisotropicSmoother :: 
   AnisotropicSmoother  (const MeshAccess & ama,
 			const BilinearForm & abiform)
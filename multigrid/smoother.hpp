@@ -89,11 +89,14 @@ namespace ngmg
     const BilinearForm & biform;
     ///
     Array<shared_ptr<BaseJacobiPrecond>> jac;
+    /// flag "gsorder": "sequential", "multicolor" or "hybrid"
+    BaseJacobiPrecond::GS_ORDER gsorder;
   
   public:
     ///
     GSSmoother (const MeshAccess & ama,
-		const BilinearForm & abiform);
+		const BilinearForm & abiform,
+                const Flags & aflags = Flags());
     ///
     virtual ~GSSmoother();
   
@@ -119,6 +122,39 @@ namespace ngmg
   };
 
 
+  /**
+     Chebyshev polynomial smoother.
+     Parallel replacement for point Gauss-Seidel, needs an spd matrix.
+     Flags "chebyshevdegree" (3), "eigensteps" (10) and "chebyshevratio" (30).
+  */
+  class ChebyshevSmoother : public Smoother
+  {
+    ///
+    const BilinearForm & biform;
+    ///
+    Array<shared_ptr<ChebyshevPrecond>> cheb;
+  
+  public:
+    ///
+    ChebyshevSmoother (const MeshAccess & ama,
+                       const BilinearForm & abiform,
+                       const Flags & aflags = Flags());
+    ///
+    virtual void Update (bool force_update = 0);
+    ///
+    virtual void PreSmooth (int level, ngla::BaseVector & u, 
+			    const ngla::BaseVector & f, int steps) const;
+    ///
+    virtual void PostSmooth (int level, ngla::BaseVector & u, 
+			     const ngla::BaseVector & f, int steps) const;
+    ///
+    virtual void Residuum (int level, ngla::BaseVector & u, 
+			   const ngla::BaseVector & f, ngla::BaseVector & d) const;
+    ///
+    virtual AutoVector CreateVector(int level) const;
+  };
+
+
   /**
      Anisotropic smoother.
      Common relaxation of vertically aligned nodes.
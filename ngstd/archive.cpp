@@ -6,6 +6,13 @@
 
 #include <ngstd.hpp>
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 
 namespace ngstd
 {
@@ -220,6 +227,213 @@ namespace ngstd
 
   
 
+  /* ******************* MappedOutArchive ******************* */
+
+  static const char mapped_archive_tag[8] = { 'N','G','S','M','A','P','1','\0' };
+  enum { MAPPED_ALIGN = 64, MAPPED_BUFFERSIZE = 1<<16 };
+
+  // copy big blocks in parallel, the page faults of the mapping are spread over the threads
+  static void ParallelCopy (char * dst, const char * src, size_t bytes)
+  {
+    if (bytes < (1<<22) || !task_manager)
+      {
+        memcpy (dst, src, bytes);
+        return;
+      }
+    ParallelForRange (Range(bytes), [dst, src] (IntRange r)
+                      {
+                        memcpy (dst+r.First(), src+r.First(), r.Size());
+                      }, TasksPerThread(4));
+  }
+
+#ifndef WIN32
+  MappedOutArchive :: MappedOutArchive (string filename)
+    : Archive(true)
+  {
+    fd = open (filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      throw Exception ("MappedOutArchive: cannot open file " + filename);
+    buffer.reserve (MAPPED_BUFFERSIZE);
+    WriteBytes (mapped_archive_tag, sizeof(mapped_archive_tag));
+  }
+
+  MappedOutArchive :: ~MappedOutArchive ()
+  {
+    FlushBuffer();
+    close (fd);
+  }
+
+  void MappedOutArchive :: FlushBuffer ()
+  {
+    size_t done = 0;
+    while (done < buffer.size())
+      {
+        auto res = write (fd, &buffer[done], buffer.size()-done);
+        if (res < 0)
+          throw Exception ("MappedOutArchive: write failed");
+        done += res;
+      }
+    buffer.clear();
+  }
+
+  void MappedOutArchive :: WriteBytes (const void * p, size_t bytes)
+  {
+    if (buffer.size()+bytes > MAPPED_BUFFERSIZE)
+      FlushBuffer();
+    if (bytes > MAPPED_BUFFERSIZE)
+      {
+        size_t done = 0;
+        while (done < bytes)
+          {
+            auto res = write (fd, (const char*)p+done, bytes-done);
+            if (res < 0)
+              throw Exception ("MappedOutArchive: write failed");
+            done += res;
+          }
+      }
+    else
+      buffer.insert (buffer.end(), (const char*)p, (const char*)p+bytes);
+    pos += bytes;
+  }
+
+  Archive & MappedOutArchive :: WriteBlock (const void * p, size_t bytes)
+  {
+    char zeros[MAPPED_ALIGN] = { 0 };
+    size_t pad = (MAPPED_ALIGN - pos % MAPPED_ALIGN) % MAPPED_ALIGN;
+    WriteBytes (zeros, pad);
+    WriteBytes (p, bytes);
+    return *this;
+  }
+
+  Archive & MappedOutArchive :: operator & (string & str)
+  {
+    size_t len = str.length();
+    Write (len);
+    WriteBytes (&str[0], len);
+    return *this;
+  }
+
+  Archive & MappedOutArchive :: operator & (char *& str)
+  {
+    size_t len = strlen (str);
+    Write (len);
+    WriteBytes (str, len);
+    return *this;
+  }
+
+
+  /* ******************* MappedInArchive ******************* */
+
+  MappedInArchive :: MappedInArchive (string filename, bool azero_copy)
+    : Archive(false), mem(nullptr), pos(0), zero_copy(azero_copy)
+  {
+    fd = open (filename.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw Exception ("MappedInArchive: cannot open file " + filename);
+    struct stat st;
+    fstat (fd, &st);
+    filesize = st.st_size;
+    if (filesize > 0)
+      {
+        void * p = mmap (nullptr, filesize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+          {
+            close (fd);
+            throw Exception ("MappedInArchive: cannot map file " + filename);
+          }
+        mem = (char*)p;
+        madvise (mem, filesize, MADV_SEQUENTIAL);
+      }
+
+    char tag[sizeof(mapped_archive_tag)];
+    if (filesize < sizeof(tag) || (ReadBytes (tag, sizeof(tag)), memcmp (tag, mapped_archive_tag, sizeof(tag)) != 0))
+      {
+        if (mem) munmap (mem, filesize);
+        close (fd);
+        throw Exception ("MappedInArchive: " + filename + " is not a mapped archive");
+      }
+  }
+
+  MappedInArchive :: ~MappedInArchive ()
+  {
+    if (mem) munmap (mem, filesize);
+    close (fd);
+  }
+
+  void MappedInArchive :: ReadBytes (void * p, size_t bytes)
+  {
+    if (pos+bytes > filesize)
+      throw Exception ("MappedInArchive: read beyond end of file");
+    memcpy (p, mem+pos, bytes);
+    pos += bytes;
+  }
+
+  char * MappedInArchive :: NextBlock (size_t bytes)
+  {
+    pos += (MAPPED_ALIGN - pos % MAPPED_ALIGN) % MAPPED_ALIGN;
+    if (pos+bytes > filesize)
+      throw Exception ("MappedInArchive: read beyond end of file");
+    char * block = mem+pos;
+    pos += bytes;
+    return block;
+  }
+
+  Archive & MappedInArchive :: ReadBlock (void * p, size_t bytes)
+  {
+    ParallelCopy ((char*)p, NextBlock (bytes), bytes);
+    return *this;
+  }
+
+  void * MappedInArchive :: MapBlock (size_t bytes)
+  {
+    if (!zero_copy) return nullptr;
+    return NextBlock (bytes);
+  }
+
+  Archive & MappedInArchive :: operator & (string & str)
+  {
+    size_t len;
+    Read (len);
+    str.resize (len);
+    ReadBytes (&str[0], len);
+    return *this;
+  }
+
+  Archive & MappedInArchive :: operator & (char *& str)
+  {
+    size_t len;
+    Read (len);
+    str = new char[len+1];
+    ReadBytes (str, len);
+    str[len] = '\0';
+    return *this;
+  }
+
+#else // WIN32
+
+  MappedOutArchive :: MappedOutArchive (string filename) : Archive(true)
+  { throw Exception ("MappedOutArchive not available on Windows"); }
+  MappedOutArchive :: ~MappedOutArchive () { ; }
+  void MappedOutArchive :: FlushBuffer () { ; }
+  void MappedOutArchive :: WriteBytes (const void * p, size_t bytes) { ; }
+  Archive & MappedOutArchive :: WriteBlock (const void * p, size_t bytes) { return *this; }
+  Archive & MappedOutArchive :: operator & (string & str) { return *this; }
+  Archive & MappedOutArchive :: operator & (char *& str) { return *this; }
+
+  MappedInArchive :: MappedInArchive (string filename, bool azero_copy) : Archive(false)
+  { throw Exception ("MappedInArchive not available on Windows"); }
+  MappedInArchive :: ~MappedInArchive () { ; }
+  void MappedInArchive :: ReadBytes (void * p, size_t bytes) { ; }
+  char * MappedInArchive :: NextBlock (size_t bytes) { return nullptr; }
+  Archive & MappedInArchive :: ReadBlock (void * p, size_t bytes) { return *this; }
+  void * MappedInArchive :: MapBlock (size_t bytes) { return nullptr; }
+  Archive & MappedInArchive :: operator & (string & str) { return *this; }
+  Archive & MappedInArchive :: operator & (char *& str) { return *this; }
+
+#endif
+
+
+
   /* ******************* TextOutArchive ******************* */
   
 
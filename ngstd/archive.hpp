@@ -113,6 +113,96 @@ namespace ngstd
 
 
 
+  /**
+     Binary archive for large data.
+     Blocks (Array, Do) are written as single 64 byte aligned regions,
+     the file starts with a format tag.
+  */
+  class MappedOutArchive : public Archive
+  {
+    int fd;
+    size_t pos = 0;
+    std::vector<char> buffer;
+  public:
+    MappedOutArchive (string filename);
+    virtual ~MappedOutArchive ();
+
+    using Archive::operator&;
+    virtual Archive & operator & (double & d) { return Write(d); }
+    virtual Archive & operator & (int & i) { return Write(i); }
+    virtual Archive & operator & (short & i) { return Write(i); }
+    virtual Archive & operator & (long & i) { return Write(i); }
+    virtual Archive & operator & (size_t & i) { return Write(i); }
+    virtual Archive & operator & (unsigned char & i) { return Write(i); }
+    virtual Archive & operator & (bool & b) { return Write(b); }
+    virtual Archive & operator & (string & str);
+    virtual Archive & operator & (char *& str);
+
+    virtual Archive & Do (double * d, size_t n) { return WriteBlock (d, n*sizeof(double)); }
+    virtual Archive & Do (int * i, size_t n) { return WriteBlock (i, n*sizeof(int)); }
+    virtual Archive & Do (long * i, size_t n) { return WriteBlock (i, n*sizeof(long)); }
+    virtual Archive & Do (size_t * i, size_t n) { return WriteBlock (i, n*sizeof(size_t)); }
+    virtual Archive & Do (short * i, size_t n) { return WriteBlock (i, n*sizeof(short)); }
+    virtual Archive & Do (unsigned char * i, size_t n) { return WriteBlock (i, n*sizeof(unsigned char)); }
+    virtual Archive & Do (bool * b, size_t n) { return WriteBlock (b, n*sizeof(bool)); }
+
+  private:
+    template <typename T>
+    Archive & Write (T x) { WriteBytes (&x, sizeof(T)); return *this; }
+    void WriteBytes (const void * p, size_t bytes);
+    Archive & WriteBlock (const void * p, size_t bytes);
+    void FlushBuffer();
+  };
+
+
+  /**
+     Reads a MappedOutArchive from a read-only mapping of the file.
+     With zero_copy, arrays of scalars refer to the mapping (copy on write)
+     instead of being copied; then the archive must be kept alive as long
+     as they are used.
+  */
+  class MappedInArchive : public Archive
+  {
+    int fd;
+    char * mem;
+    size_t filesize;
+    size_t pos;
+    bool zero_copy;
+  public:
+    MappedInArchive (string filename, bool azero_copy = false);
+    virtual ~MappedInArchive ();
+
+    using Archive::operator&;
+    virtual Archive & operator & (double & d) { return Read(d); }
+    virtual Archive & operator & (int & i) { return Read(i); }
+    virtual Archive & operator & (short & i) { return Read(i); }
+    virtual Archive & operator & (long & i) { return Read(i); }
+    virtual Archive & operator & (size_t & i) { return Read(i); }
+    virtual Archive & operator & (unsigned char & i) { return Read(i); }
+    virtual Archive & operator & (bool & b) { return Read(b); }
+    virtual Archive & operator & (string & str);
+    virtual Archive & operator & (char *& str);
+
+    virtual Archive & Do (double * d, size_t n) { return ReadBlock (d, n*sizeof(double)); }
+    virtual Archive & Do (int * i, size_t n) { return ReadBlock (i, n*sizeof(int)); }
+    virtual Archive & Do (long * i, size_t n) { return ReadBlock (i, n*sizeof(long)); }
+    virtual Archive & Do (size_t * i, size_t n) { return ReadBlock (i, n*sizeof(size_t)); }
+    virtual Archive & Do (short * i, size_t n) { return ReadBlock (i, n*sizeof(short)); }
+    virtual Archive & Do (unsigned char * i, size_t n) { return ReadBlock (i, n*sizeof(unsigned char)); }
+    virtual Archive & Do (bool * b, size_t n) { return ReadBlock (b, n*sizeof(bool)); }
+
+    virtual void * MapBlock (size_t bytes);
+
+  private:
+    template <typename T>
+    Archive & Read (T & x) { ReadBytes (&x, sizeof(T)); return *this; }
+    void ReadBytes (void * p, size_t bytes);
+    Archive & ReadBlock (void * p, size_t bytes);
+    char * NextBlock (size_t bytes);
+  };
+
+
+
   
   /*
   // archive a pointer ...
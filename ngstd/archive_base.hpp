@@ -9,6 +9,16 @@
 namespace ngstd
 {
 
+  // types with a virtual Archive::Do for contiguous blocks
+  template <typename T> struct is_archive_block_type : std::false_type { };
+  template <> struct is_archive_block_type<double> : std::true_type { };
+  template <> struct is_archive_block_type<int> : std::true_type { };
+  template <> struct is_archive_block_type<long> : std::true_type { };
+  template <> struct is_archive_block_type<size_t> : std::true_type { };
+  template <> struct is_archive_block_type<short> : std::true_type { };
+  template <> struct is_archive_block_type<unsigned char> : std::true_type { };
+  template <> struct is_archive_block_type<bool> : std::true_type { };
+
   class Archive
   {
     bool is_output;
@@ -56,6 +66,9 @@ namespace ngstd
     { for (size_t j = 0; j < n; j++) { (*this) & b[j]; }; return *this; };
 
 
+    /// input only: a block of bytes written by Do, used in place (nullptr if not supported)
+    virtual void * MapBlock (size_t bytes) { return nullptr; }
+
     // nvirtual Archive & Do (string * str, size_t n)
     // { for (size_t j = 0; j < n; j++) { (*this) & str[j]; }; return *this; };
     // virtual Archive & operator & (char *& str) = 0;
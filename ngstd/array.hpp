@@ -709,6 +709,12 @@ namespace ngstd
       return allocsize;
     }
 
+    /// bytes of memory owned by the array, 0 for memory of others
+    INLINE size_t OwnedBytes () const
+    {
+      return mem_to_delete ? allocsize*sizeof(T) : 0;
+    }
+
 
     /// assigns memory from local heap
     INLINE const Array & Assign (size_t asize, LocalHeap & lh)
@@ -1420,6 +1426,12 @@ namespace ngstd
       {
         size_t size;
         archive & size;
+        if (is_archive_block_type<T>::value)
+          if (T * mapped = static_cast<T*> (archive.MapBlock (size*sizeof(T))))
+            {
+              a = Array<T> (size, mapped);
+              return archive;
+            }
         a.SetSize (size);
       }
 
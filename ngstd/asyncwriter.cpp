@@ -0,0 +1,93 @@
+/**************************************************************************/
+/* File:   asyncwriter.cpp                                                */
+/* Date:   Oct. 2026                                                      */
+/**************************************************************************/
+
+#include <ngstd.hpp>
+
+namespace ngstd
+{
+
+  AsyncWriter :: ~AsyncWriter ()
+  {
+    if (!thread.joinable()) return;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      stop = true;
+    }
+    cv.notify_all();
+    thread.join();
+    if (error)
+      cerr << "AsyncWriter: output job failed" << endl;
+  }
+
+  void AsyncWriter :: Submit (std::function<void()> job)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait (lock, [this] { return jobs.size() < maxpending || error; });
+      RethrowError();
+      jobs.push_back (move(job));
+      if (!thread.joinable())
+        thread = std::thread ([this] { Run(); });
+    }
+    cv.notify_all();
+  }
+
+  void AsyncWriter :: Wait ()
+  {
+    static Timer t("AsyncWriter::Wait"); RegionTimer reg(t);
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait (lock, [this] { return (jobs.empty() && !busy) || error; });
+    RethrowError();
+  }
+
+  bool AsyncWriter :: Busy ()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    return busy || !jobs.empty();
+  }
+
+  void AsyncWriter :: RethrowError ()
+  {
+    if (!error) return;
+    auto e = error;
+    error = nullptr;
+    jobs.clear();
+    std::rethrow_exception (e);
+  }
+
+  void AsyncWriter :: Run ()
+  {
+    while (true)
+      {
+        std::function<void()> job;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          cv.wait (lock, [this] { return !jobs.empty() || stop; });
+          if (jobs.empty()) return;
+          job = move(jobs.front());
+          jobs.pop_front();
+          busy = true;
+        }
+        cv.notify_all();
+
+        try
+          {
+            job();
+          }
+        catch (...)
+          {
+            std::unique_lock<std::mutex> lock(mutex);
+            error = std::current_exception();
+          }
+
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          busy = false;
+        }
+        cv.notify_all();
+      }
+  }
+
+}
@@ -0,0 +1,52 @@
+#ifndef FILE_ASYNCWRITER
+#define FILE_ASYNCWRITER
+
+/**************************************************************************/
+/* File:   asyncwriter.hpp                                                */
+/* Date:   Oct. 2026                                                      */
+/**************************************************************************/
+
+#include <thread>
+#include <condition_variable>
+#include <deque>
+
+namespace ngstd
+{
+
+  /**
+     Runs output jobs on a background thread, in the order of
+     submission. At most maxpending jobs wait in the queue, Submit
+     blocks until a slot is free. The jobs must not use data the
+     caller modifies afterwards, they work on snapshots.
+
+     An exception of a job is rethrown by the next Submit or Wait.
+   */
+  class NGS_DLL_HEADER AsyncWriter
+  {
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> jobs;
+    size_t maxpending;
+    bool busy = false;
+    bool stop = false;
+    std::exception_ptr error;
+
+  public:
+    AsyncWriter (size_t amaxpending = 1) : maxpending(amaxpending) { ; }
+    /// finishes all pending jobs
+    ~AsyncWriter ();
+
+    void Submit (std::function<void()> job);
+    /// waits until all submitted jobs are finished
+    void Wait ();
+    bool Busy ();
+
+  private:
+    void Run ();
+    void RethrowError ();
+  };
+
+}
+
+#endif
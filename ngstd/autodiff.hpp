@@ -260,9 +260,12 @@ INLINE AutoDiff<D,SCAL> sqr (const AutoDiff<D,SCAL> & x) throw()
 template<int D, typename SCAL>
 INLINE AutoDiff<D,SCAL> Inv (const AutoDiff<D,SCAL> & x)
 {
-  AutoDiff<D,SCAL> res(1.0 / x.Value());
+  // one division, also for SIMD lanes
+  SCAL inv = 1.0 / x.Value();
+  SCAL minv2 = -inv*inv;
+  AutoDiff<D,SCAL> res(inv);
   for (int i = 0; i < D; i++)
-    res.DValue(i) = -x.DValue(i) / (x.Value() * x.Value());
+    res.DValue(i) = minv2 * x.DValue(i);
   return res;
 }
 
@@ -394,6 +397,7 @@ template<int D, typename SCAL, typename SCAL2,
 
 
 
+using std::fabs;
 template<int D, typename SCAL>
 INLINE AutoDiff<D,SCAL> fabs (const AutoDiff<D,SCAL> & x)
 {
@@ -408,14 +412,26 @@ INLINE AutoDiff<D,SCAL> fabs (const AutoDiff<D,SCAL> & x)
   return res;
 }
 
+template<int D, int N>
+INLINE AutoDiff<D,SIMD<double,N>> fabs (const AutoDiff<D,SIMD<double,N>> & x)
+{
+  SIMD<double,N> sign = IfPos (x.Value(), SIMD<double,N>(1.0),
+                               IfPos (-x.Value(), SIMD<double,N>(-1.0), SIMD<double,N>(0.0)));
+  AutoDiff<D,SIMD<double,N>> res( fabs (x.Value()) );
+  for (int i = 0; i < D; i++)
+    res.DValue(i) = sign * x.DValue(i);
+  return res;
+}
+
 using std::sqrt;
 template<int D, typename SCAL>
 INLINE AutoDiff<D,SCAL> sqrt (const AutoDiff<D,SCAL> & x)
 {
   AutoDiff<D,SCAL> res;
   res.Value() = sqrt(x.Value());
+  SCAL dsqrt = 0.5 / res.Value();
   for (int j = 0; j < D; j++)
-    res.DValue(j) = 0.5 / res.Value() * x.DValue(j);
+    res.DValue(j) = dsqrt * x.DValue(j);
   return res;
 }
 
@@ -425,8 +441,9 @@ AutoDiff<D,SCAL> log (AutoDiff<D,SCAL> x)
 {
   AutoDiff<D,SCAL> res;
   res.Value() = log(x.Value());
+  SCAL xinv = 1.0 / x.Value();
   for (int k = 0; k < D; k++)
-    res.DValue(k) = x.DValue(k) / x.Value();
+    res.DValue(k) = x.DValue(k) * xinv;
   return res;
 }
 
@@ -448,6 +465,18 @@ INLINE AutoDiff<D,SCAL> pow (AutoDiff<D,SCAL> x, AutoDiff<D,SCAL> y )
   return exp(log(x)*y);
 }
 
+/// x^p, also for x <= 0
+template <int D, typename SCAL>
+INLINE AutoDiff<D,SCAL> pow (AutoDiff<D,SCAL> x, double p)
+{
+  AutoDiff<D,SCAL> res;
+  res.Value() = pow(x.Value(), p);
+  SCAL dp = p * pow(x.Value(), p-1);
+  for (int k = 0; k < D; k++)
+    res.DValue(k) = x.DValue(k) * dp;
+  return res;
+}
+
 using std::sin;
 template <int D, typename SCAL>
 INLINE AutoDiff<D,SCAL> sin (AutoDiff<D,SCAL> x)
@@ -507,8 +536,9 @@ INLINE AutoDiff<D,SCAL> atan (AutoDiff<D,SCAL> x)
   AutoDiff<D,SCAL> res;
   SCAL a = atan(x.Value());
   res.Value() = a;
+  SCAL da = 1.0 / (1+x.Value()*x.Value());
   for (int k = 0; k < D; k++)
-    res.DValue(k) = x.DValue(k)/(1+x.Value()*x.Value()) ;
+    res.DValue(k) = x.DValue(k) * da;
   return res;
 }
 
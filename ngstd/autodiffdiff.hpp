@@ -404,12 +404,13 @@ inline AutoDiffDiff<D, SCAL> operator* (const AutoDiffDiff<D, SCAL> & x, const A
 template<int D, typename SCAL>
 inline AutoDiffDiff<D, SCAL> Inv (const AutoDiffDiff<D, SCAL> & x)
 {
-  AutoDiffDiff<D, SCAL> res(1.0 / x.Value());
+  SCAL inv = 1.0 / x.Value();
+  SCAL fac2 = inv*inv;
+  SCAL fac1 = 2*fac2*inv;
+  AutoDiffDiff<D, SCAL> res(inv);
   for (int i = 0; i < D; i++)
-    res.DValue(i) = -x.DValue(i) / (x.Value() * x.Value());
+    res.DValue(i) = -fac2 * x.DValue(i);
 
-  SCAL fac1 = 2/(x.Value()*x.Value()*x.Value());
-  SCAL fac2 = 1/sqr(x.Value());
   for (int i = 0; i < D; i++)
     for (int j = 0; j < D; j++)
       res.DDValue(i,j) = fac1*x.DValue(i)*x.DValue(j) - fac2*x.DDValue(i,j);
@@ -443,13 +444,15 @@ inline AutoDiffDiff<D, SCAL> sqrt (const AutoDiffDiff<D, SCAL> & x)
 {
   AutoDiffDiff<D, SCAL> res;
   res.Value() = sqrt(x.Value());
+  SCAL dsqrt = 0.5 / res.Value();
+  SCAL ddsqrt = -0.5 * dsqrt / x.Value();
   for (int j = 0; j < D; j++)
-    res.DValue(j) = 0.5 / res.Value() * x.DValue(j);
+    res.DValue(j) = dsqrt * x.DValue(j);
 
   
   for (int i = 0; i < D; i++)
     for (int j = 0; j < D; j++)
-      res.DDValue(i,j) = 0.5/res.Value() * x.DDValue(i,j) - 0.25 / (x.Value()*res.Value()) * x.DValue(i) * x.DValue(j);
+      res.DDValue(i,j) = dsqrt * x.DDValue(i,j) + ddsqrt * x.DValue(i) * x.DValue(j);
 
   return res;
 }
@@ -476,6 +479,22 @@ INLINE AutoDiffDiff<D,SCAL> pow (AutoDiffDiff<D,SCAL> x, AutoDiffDiff<D,SCAL> y
   return exp(log(x)*y);
 }
 
+/// x^p, also for x <= 0
+template <int D, typename SCAL>
+INLINE AutoDiffDiff<D,SCAL> pow (AutoDiffDiff<D,SCAL> x, double p)
+{
+  AutoDiffDiff<D,SCAL> res;
+  res.Value() = pow(x.Value(), p);
+  SCAL dp = p * pow(x.Value(), p-1);
+  SCAL ddp = (p == 1) ? SCAL(0.0) : p * (p-1) * pow(x.Value(), p-2);
+  for (int k = 0; k < D; k++)
+    res.DValue(k) = x.DValue(k) * dp;
+  for (int k = 0; k < D; k++)
+    for (int l = 0; l < D; l++)
+      res.DDValue(k,l) = ddp * x.DValue(k) * x.DValue(l) + dp * x.DDValue(k,l);
+  return res;
+}
+
 template <int D, typename SCAL>
 INLINE AutoDiffDiff<D, SCAL> log (AutoDiffDiff<D, SCAL> x)
 {
@@ -536,11 +555,13 @@ INLINE AutoDiffDiff<D, SCAL> atan (AutoDiffDiff<D, SCAL> x)
   AutoDiffDiff<D, SCAL> res;
   SCAL a = atan(x.Value());
   res.Value() = a;
+  SCAL da = 1.0 / (1+x.Value()*x.Value());
+  SCAL dda = -2*x.Value()*da*da;
   for (int k = 0; k < D; k++)
-    res.DValue(k) = x.DValue(k)/(1+x.Value()*x.Value()) ;
+    res.DValue(k) = x.DValue(k) * da;
   for (int k = 0; k < D; k++)
     for (int l = 0; l < D; l++)
-      res.DDValue(k,l) = -2*x.Value()/((1+x.Value()*x.Value())*(1+x.Value()*x.Value())) * x.DValue(k) * x.DValue(l) + x.DDValue(k,l)/(1+x.Value()*x.Value());
+      res.DDValue(k,l) = dda * x.DValue(k) * x.DValue(l) + x.DDValue(k,l) * da;
   return res;
 }
 
@@ -615,10 +636,9 @@ INLINE AutoDiffDiff<D,SCAL> IfPos (SCAL /* SIMD<double> */ a, AutoDiffDiff<D,SCA
   AutoDiffDiff<D,SCAL> res;
   res.Value() = IfPos (a, b.Value(), c.Value());
   for (int j = 0; j < D; j++)
-  {
     res.DValue(j) = IfPos (a, b.DValue(j), c.DValue(j));
+  for (int j = 0; j < D*D; j++)
     res.DDValue(j) = IfPos (a, b.DDValue(j), c.DDValue(j));
-  }
   return res;
 }
 
@@ -29,7 +29,7 @@ namespace ngstd
   BitArray :: BitArray (size_t asize, LocalHeap & lh)
   {
     size = asize;
-    data = new (lh) unsigned char [Addr (size)+1];
+    data = reinterpret_cast<unsigned char*> (new (lh) uint64_t [NumWords()]);
     owns_data = false;
   }
   
@@ -54,22 +54,23 @@ namespace ngstd
     if (owns_data) delete [] data;
 
     size = asize;
-    data = new unsigned char [Addr (size)+1];
+    data = new unsigned char [8*NumWords()];
+    owns_data = true;
   }
 
   BitArray & BitArray :: Set () throw()
   {
-    if (!size) return *this;
-    for (size_t i = 0; i <= Addr (size); i++)
-      data[i] = UCHAR_MAX;
+    uint64_t * words = Words();
+    for (size_t i = 0; i < NumWords(); i++)
+      words[i] = ~uint64_t(0);
     return *this;
   }
 
   BitArray & BitArray :: Clear () throw()
   {
-    if (!size) return *this;
-    for (size_t i = 0; i <= Addr (size); i++)
-      data[i] = 0;
+    uint64_t * words = Words();
+    for (size_t i = 0; i < NumWords(); i++)
+      words[i] = 0;
     return *this;
   }
 
@@ -77,26 +78,37 @@ namespace ngstd
 
   BitArray & BitArray :: Invert ()
   {
-    if (!size) return *this;
-    for (size_t i = 0; i <= Addr (size); i++)
-      data[i] ^= 255;
+    uint64_t * words = Words();
+    for (size_t i = 0; i < NumWords(); i++)
+      words[i] = ~words[i];
     return *this;
   }
 
   BitArray & BitArray :: And (const BitArray & ba2)
   {
-    if (!size) return *this;
-    for (size_t i = 0; i <= Addr (size); i++)
-      data[i] &= ba2.data[i];
-        return *this;
+    uint64_t * words = Words();
+    const uint64_t * words2 = ba2.Words();
+    for (size_t i = 0; i < NumWords(); i++)
+      words[i] &= words2[i];
+    return *this;
   }
 
 
   BitArray & BitArray :: Or (const BitArray & ba2)
   {
-    if (!size) return *this;
-    for (size_t i = 0; i <= Addr (size); i++)
-      data[i] |= ba2.data[i];
+    uint64_t * words = Words();
+    const uint64_t * words2 = ba2.Words();
+    for (size_t i = 0; i < NumWords(); i++)
+      words[i] |= words2[i];
+    return *this;
+  }
+
+  BitArray & BitArray :: AndNot (const BitArray & ba2)
+  {
+    uint64_t * words = Words();
+    const uint64_t * words2 = ba2.Words();
+    for (size_t i = 0; i < NumWords(); i++)
+      words[i] &= ~words2[i];
     return *this;
   }
 
@@ -104,10 +116,10 @@ namespace ngstd
   BitArray & BitArray :: operator= (const BitArray & ba2)
   {
     SetSize (ba2.Size());
-    if (!size) 
-      return *this;
-    for (size_t i = 0; i <= Addr (size); i++)
-      data[i] = ba2.data[i];
+    uint64_t * words = Words();
+    const uint64_t * words2 = ba2.Words();
+    for (size_t i = 0; i < NumWords(); i++)
+      words[i] = words2[i];
     return *this;
   }
 
@@ -127,8 +139,8 @@ namespace ngstd
   size_t BitArray :: NumSet () const
   {
     size_t cnt = 0;
-    for (size_t i = 0; i < Size(); i++)
-      if (Test(i)) cnt++;
+    for (size_t i = 0; i < NumWords(); i++)
+      cnt += PopCount (GetWord(i));
     return cnt;
   }
 
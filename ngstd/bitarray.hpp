@@ -8,9 +8,36 @@
 /**************************************************************************/
 
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 namespace ngstd
 {
 
+  /// number of set bits in a 64-bit word
+  INLINE int PopCount (uint64_t w)
+  {
+#ifdef _MSC_VER
+    return int(__popcnt64 (w));
+#else
+    return __builtin_popcountll (w);
+#endif
+  }
+
+  /// index of the lowest set bit, w must not be 0
+  INLINE int TrailingZeros (uint64_t w)
+  {
+#ifdef _MSC_VER
+    unsigned long pos;
+    _BitScanForward64 (&pos, w);
+    return int(pos);
+#else
+    return __builtin_ctzll (w);
+#endif
+  }
+
+
 /**
    A compressed array of bools.
 
@@ -130,8 +157,81 @@ public:
   /// copy from ba2
   NGS_DLL_HEADER BitArray & operator= (const BitArray & ba2);
 
-  size_t NumSet () const;
+  /// logical AND with the complement of ba2
+  NGS_DLL_HEADER BitArray & AndNot (const BitArray & ba2);
+
+  /// number of set bits
+  NGS_DLL_HEADER size_t NumSet () const;
+
+  /// number of 64-bit words holding the bits
+  size_t NumWords () const { return (size+63) / 64; }
+
+  /// bits 64*w ... 64*w+63, bits beyond Size() are cleared
+  uint64_t GetWord (size_t w) const
+  {
+    uint64_t word = Words()[w];
+    if (w == size/64)
+      word &= (uint64_t(1) << (size%64)) - 1;
+    return word;
+  }
+
+  /// iterates over the indices of the set bits
+  class SetBitIterator
+  {
+    const BitArray & ba;
+    size_t w;
+    uint64_t word;
+  public:
+    SetBitIterator (const BitArray & aba, size_t aw)
+      : ba(aba), w(aw), word(aw < aba.NumWords() ? aba.GetWord(aw) : 0)
+    { Skip(); }
+    size_t operator* () const { return 64*w + TrailingZeros(word); }
+    SetBitIterator & operator++ ()
+    {
+      word &= word-1;
+      Skip();
+      return *this;
+    }
+    bool operator!= (const SetBitIterator & it2) const
+    { return w != it2.w || word != it2.word; }
+  private:
+    void Skip ()
+    {
+      size_t nw = ba.NumWords();
+      while (!word && w < nw)
+        {
+          w++;
+          if (w < nw) word = ba.GetWord(w);
+        }
+    }
+  };
+
+  class SetBitRange
+  {
+    const BitArray & ba;
+  public:
+    SetBitRange (const BitArray & aba) : ba(aba) { ; }
+    SetBitIterator begin () const { return SetBitIterator(ba, 0); }
+    SetBitIterator end () const { return SetBitIterator(ba, ba.NumWords()); }
+  };
+
+  /// for (size_t i : ba.SetBits()) visits all set bits in increasing order
+  SetBitRange SetBits () const { return SetBitRange(*this); }
+
+  /// calls func(i) for all set bits i in increasing order
+  template <typename FUNC>
+  void ForEachSet (FUNC func) const
+  {
+    for (size_t w = 0; w < NumWords(); w++)
+      for (uint64_t word = GetWord(w); word; word &= word-1)
+        func (64*w + TrailingZeros(word));
+  }
+
 private:
+  /// storage is padded to full 64-bit words
+  uint64_t * Words () const
+  { return reinterpret_cast<uint64_t*> (data); }
+
   ///
   unsigned char Mask (size_t i) const
   { return char(1) << (i % CHAR_BIT); }
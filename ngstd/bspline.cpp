@@ -10,12 +10,14 @@ namespace ngstd
                       Array<double> at,
                       Array<double> ac)
     : order(aorder), t(at), c(ac) 
-  { ; }
-  
-  
-  BSpline BSpline :: Differentiate () const
   {
-    if (order <= 1) throw Exception ("cannot differentiate B-spline of order <= 1");
+    Setup();
+  }
+
+
+  // coefficients of the derivative, on the same knots
+  static Array<double> DiffCoefficients (int order, FlatArray<double> t, FlatArray<double> c)
+  {
     Array<double> cp(c.Size());
     cp = 0;
     if (t[order-1] != t[0])
@@ -25,8 +27,59 @@ namespace ngstd
         cp[j] = (order-1) * (c[j]-c[j-1]) / (t[j+order-1] - t[j]);
       else
         cp[j] = 0;
+    return cp;
+  }
+
+  void BSpline :: Setup ()
+  {
+    int n = t.Size();
+    tmin = n ? t[0] : 0;
+    tmax = n ? t[n-1] : 0;
+    if (!(tmax > tmin)) return;    // empty support, the spline is 0
+
+    // outside the knots, the recursion sees t[0] and t[n-1] repeated,
+    // and zero coefficients
+    tp.SetSize (n+2*order);
+    tp.Range(0, order) = t[0];
+    tp.Range(order, n+order) = t;
+    tp.Range(n+order, n+2*order) = t[n-1];
+
+    Array<double> dc(c);
+    cp.SetSize (3*tp.Size());
+    cp = 0;
+    for (int l = 0; l < 3; l++)
+      {
+        if (order-l < 1) continue;
+        for (int i = 0; i < min2(n, int(dc.Size())); i++)
+          cp[l*tp.Size()+order+i] = dc[i];
+        if (order-l > 1 && l < 2)
+          dc = DiffCoefficients (order-l, t, dc);
+      }
+
+    // about one knot per cell. A knot m with cell(t[m]) < k is left of
+    // all x in cell k, so the search starts there. The cell is computed
+    // by the same floating point operations for double and SIMD
+    int ncells = max2(1, n-1);
+    invh = ncells / (tmax-tmin);
+    auto cell = [&] (double x) { return min2 (int((x-tmin)*invh), ncells-1); };
+    cell_first.SetSize (ncells+1);
+    int m = 0;
+    for (int k = 0; k <= ncells; k++)
+      {
+        while (m+1 <= n-2 && cell(t[m+1]) < k) m++;
+        cell_first[k] = m;
+      }
+    maxsteps = 0;
+    for (int k = 0; k < ncells; k++)
+      maxsteps = max2 (maxsteps, cell_first[k+1]-cell_first[k]);
+  }
+  
+  
+  BSpline BSpline :: Differentiate () const
+  {
+    if (order <= 1) throw Exception ("cannot differentiate B-spline of order <= 1");
     // throw Exception ("cannot differentiate, B-spline is discontinuous");
-    return BSpline (order-1, Array<double>(t), move(cp));
+    return BSpline (order-1, Array<double>(t), DiffCoefficients (order, t, c));
   }
   
   BSpline BSpline :: Integrate () const
@@ -75,69 +128,150 @@ namespace ngstd
   }
 
   
-  double BSpline :: Evaluate (double x) const
+  template <typename T> struct BSplineLanes;
+
+  template <> struct BSplineLanes<double>
+  {
+    enum { N = 1 };
+    static double Get (double x, int i) { return x; }
+    template <typename FUNC> static double Make (FUNC f) { return f(0); }
+  };
+
+  template <> struct BSplineLanes<SIMD<double>>
   {
-    // for (int m = order-1; m < t.Size()-order+1; m++)
-    // for (int m = 0; m < t.Size()-order+1; m++)
-    for (int m = 0; m < t.Size()-1; m++)
+    enum { N = SIMD<double>::Size() };
+    static double Get (SIMD<double> x, int i) { return x[i]; }
+    template <typename FUNC> static SIMD<double> Make (FUNC f) { return SIMD<double>(f); }
+  };
+  
+  template <typename T>
+  void BSpline :: EvaluateDerivatives (T x, int nd, T * vals) const
+  {
+    typedef BSplineLanes<T> L;
+    if (!(tmax > tmin))
       {
-        // cout << "m = " << m << endl;
-        if ( (t[m] <= x) && (x < t[m+1]))
+        for (int l = 0; l <= nd; l++)
+          vals[l] = T(0.0);
+        return;
+      }
+
+    // the spline vanishes outside [tmin, tmax), these lanes search at tmin
+    T inside = L::Make ([&] (int i)
+                        {
+                          double xi = L::Get(x, i);
+                          return (xi >= tmin && xi < tmax) ? 1.0 : 0.0;
+                        });
+    T xs = IfPos (inside, x, T(tmin));
+
+    // knot interval t[m] <= x < t[m+1]: start in the grid cell and
+    // step over the knots of the cell, the same number of steps in
+    // all lanes
+    const double * pt = &tp[order];
+    int m[L::N];
+    T cell = (xs-tmin)*invh;
+    for (int i = 0; i < L::N; i++)
+      m[i] = cell_first[min2 (int(L::Get(cell, i)), int(cell_first.Size())-2)];
+    for (int s = 0; s < maxsteps; s++)
+      {
+        T tnext = L::Make ([&] (int i) { return pt[m[i]+1]; });
+        T step = IfPos (tnext-xs, T(0.0), T(1.0));
+        for (int i = 0; i < L::N; i++)
+          m[i] += int(L::Get(step, i));
+      }
+
+    // de Boor's recursion, the derivatives are splines of lower order
+    // on the same knots
+    STACK_ARRAY(T, d, order);
+    for (int l = 0; l <= nd; l++)
+      {
+        int ord = order-l;
+        if (ord < 1)
           {
-            Array<double> hc (c);
-            for (int p = 1; p < order; p++)
-              for (int j = m; j >= m-order+1+p; j--)
-                {
-                  // cout << "j = " << j << ", p = " << p << endl;
-                  if (j > 0)
-                    hc[j] = ((x-t[j]) * hc[j] + (t[j+order-p]-x) * hc[j-1])
-                      / (t[j+order-p]-t[j]);
-                  else if (j == 0)
-                    hc[j] = ((x-t[0]) * hc[j]) / (t[j+order-p]-t[j]);
-                }
-            return hc[m];
+            vals[l] = T(0.0);
+            continue;
           }
+        const double * pc = &cp[l*tp.Size()+order];
+        for (int i = 0; i < ord; i++)
+          d[i] = L::Make ([&] (int k) { return pc[m[k]-ord+1+i]; });
+        for (int p = 1; p < ord; p++)
+          for (int i = ord-1; i >= p; i--)
+            {
+              T tj = L::Make ([&] (int k) { return pt[m[k]-ord+1+i]; });
+              T tjp = L::Make ([&] (int k) { return pt[m[k]+1+i-p]; });
+              d[i] = ((xs-tj) * d[i] + (tjp-xs) * d[i-1]) / (tjp-tj);
+            }
+        vals[l] = IfPos (inside, d[ord-1], T(0.0));
       }
-    return 0;
+  }
+  
+  double BSpline :: Evaluate (double x) const
+  {
+    double val;
+    EvaluateDerivatives (x, 0, &val);
+    return val;
   }
 
-  AutoDiff<1> BSpline :: operator() (AutoDiff<1> x) const
+  SIMD<double> BSpline :: Evaluate (SIMD<double> x) const
+  {
+    SIMD<double> val;
+    EvaluateDerivatives (x, 0, &val);
+    return val;
+  }
+
+  void BSpline :: Evaluate (double x, double & val, double & dval) const
   {
-    // double eps = 1e-5;
-    double val = (*this)(x.Value());
-    // double valr = (*this)(x.Value()+eps);
-    // double vall = (*this)(x.Value()-eps);
-    // double dval = (valr-vall) / (2*eps);
+    double vals[2];
+    EvaluateDerivatives (x, 1, vals);
+    val = vals[0];
+    dval = vals[1];
+  }
 
-    double dval2 = Differentiate()(x.Value());
-    // cout << "dval = " << dval << " =?= " << dval2 << endl;
+  void BSpline :: Evaluate (SIMD<double> x, SIMD<double> & val, SIMD<double> & dval) const
+  {
+    SIMD<double> vals[2];
+    EvaluateDerivatives (x, 1, vals);
+    val = vals[0];
+    dval = vals[1];
+  }
 
-    AutoDiff<1> res(val);
-    res.DValue(0) = dval2 * x.DValue(0);
+  template <typename SCAL>
+  INLINE AutoDiff<1,SCAL> T_EvaluateAD (const BSpline & sp, AutoDiff<1,SCAL> x)
+  {
+    SCAL val, dval;
+    sp.Evaluate (x.Value(), val, dval);
+    AutoDiff<1,SCAL> res(val);
+    res.DValue(0) = dval * x.DValue(0);
     return res;
   }
-  AutoDiffDiff<1> BSpline :: operator() (AutoDiffDiff<1> x) const
+  
+  AutoDiff<1> BSpline :: operator() (AutoDiff<1> x) const
   {
-    /*
-    double eps = 1e-5;
-    double val = (*this)(x.Value());
-    double valr = (*this)(x.Value()+eps);
-    double vall = (*this)(x.Value()-eps);
+    return T_EvaluateAD (*this, x);
+  }
 
-    double dval = (valr-vall) / (2*eps);
-    double ddval = (valr+vall-2*val) / (eps*eps);
-    */
-    auto diff = Differentiate();
-    auto ddiff = diff.Differentiate();
-    double val = (*this)(x.Value());
-    double dval = diff(x.Value());
-    double ddval = ddiff(x.Value());
+  AutoDiff<1,SIMD<double>> BSpline :: operator() (AutoDiff<1,SIMD<double>> x) const
+  {
+    return T_EvaluateAD (*this, x);
+  }
 
-    AutoDiffDiff<1> res(val);
-    res.DValue(0) = dval * x.DValue(0);
-    res.DDValue(0) = ddval * x.DValue(0)*x.DValue(0) + dval*x.DDValue(0);
+  AutoDiffDiff<1> BSpline :: operator() (AutoDiffDiff<1> x) const
+  {
+    double vals[3];
+    EvaluateDerivatives (x.Value(), 2, vals);
+    AutoDiffDiff<1> res(vals[0]);
+    res.DValue(0) = vals[1] * x.DValue(0);
+    res.DDValue(0) = vals[2] * x.DValue(0)*x.DValue(0) + vals[1]*x.DDValue(0);
     return res;
+  }
 
+  AutoDiffDiff<1,SIMD<double>> BSpline :: operator() (AutoDiffDiff<1,SIMD<double>> x) const
+  {
+    SIMD<double> vals[3];
+    EvaluateDerivatives (x.Value(), 2, vals);
+    AutoDiffDiff<1,SIMD<double>> res(vals[0]);
+    res.DValue(0) = vals[1] * x.DValue(0);
+    res.DDValue(0) = vals[2] * x.DValue(0)*x.DValue(0) + vals[1]*x.DDValue(0);
+    return res;
   }
  
   ostream & operator<< (ostream & ost, const BSpline & sp)
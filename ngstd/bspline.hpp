@@ -16,6 +16,17 @@ namespace ngstd
     int order;
     Array<double> t;
     Array<double> c;
+
+    // evaluation data: knots, and the coefficients of the spline and its
+    // first two derivatives (one after the other), padded by order
+    // entries at both ends
+    Array<double> tp;
+    Array<double> cp;
+    // uniform grid on [tmin, tmax): the knot interval of x is found from
+    // cell_first[cell(x)] within at most maxsteps steps
+    double tmin, tmax, invh;
+    Array<int> cell_first;
+    int maxsteps;
     
   public:
     BSpline (int aorder, 
@@ -28,11 +39,25 @@ namespace ngstd
     BSpline Integrate () const;
 
     double Evaluate (double x) const;
+    SIMD<double> Evaluate (SIMD<double> x) const;
+    /// value and first derivative
+    void Evaluate (double x, double & val, double & dval) const;
+    void Evaluate (SIMD<double> x, SIMD<double> & val, SIMD<double> & dval) const;
+    
     double operator() (double x) const { return Evaluate(x); }
+    SIMD<double> operator() (SIMD<double> x) const { return Evaluate(x); }
     AutoDiff<1> operator() (AutoDiff<1> x) const;
     AutoDiffDiff<1> operator() (AutoDiffDiff<1> x) const;
+    AutoDiff<1,SIMD<double>> operator() (AutoDiff<1,SIMD<double>> x) const;
+    AutoDiffDiff<1,SIMD<double>> operator() (AutoDiffDiff<1,SIMD<double>> x) const;
     
     friend ostream & operator<< (ostream & ost, const BSpline & sp);
+
+  private:
+    void Setup ();
+    /// values and nd derivatives, T = double or SIMD<double>
+    template <typename T>
+    void EvaluateDerivatives (T x, int nd, T * vals) const;
   };
 
   extern ostream & operator<< (ostream & ost, const BSpline & sp);
@@ -447,6 +447,239 @@ namespace ngstd
 
 
 
+  void EvalFunction :: Eval (const SIMD<double> * x, SIMD<double> * y, int ydim) const
+  {
+    if (res_type.vecdim != ydim)
+      {
+	cout << "Eval SIMD called with ydim = " << ydim << ", but result.dim = " << res_type.vecdim << endl;
+	return;
+      }
+    if (res_type.iscomplex)
+      throw Exception ("Eval SIMD called for complex EvalFunction");
+
+    typedef SIMD<double> TS;
+    // truth values are 0 and 1, as for the scalar stack
+    auto True = [this] (TS a) { return IfPos (a-eps, TS(1.0), TS(0.0)); };
+    auto Lanes = [] (TS a, double (*fun) (double))
+      { return TS([&] (int i) { return (*fun) (a[i]); }); };
+
+    ArrayMem<TS, 100> stack(program.Size());
+    int stacksize = -1;
+    for (int i = 0; i < program.Size(); i++)
+      {
+	switch (program[i].op)
+	  {
+	  case ADD:
+	    stack[stacksize-1] += stack[stacksize];
+	    stacksize--;
+	    break;
+	  case SUB:
+	    stack[stacksize-1] -= stack[stacksize];
+	    stacksize--;
+	    break;
+	  case MULT:
+	    stack[stacksize-1] *= stack[stacksize];
+	    stacksize--;
+	    break;
+	  case DIV:
+	    stack[stacksize-1] = stack[stacksize-1] / stack[stacksize];
+	    stacksize--;
+	    break;
+
+	  case VEC_ADD:
+	    {
+	      int dim = program[i].vecdim;
+	      for (int j = 0; j < dim; j++)
+		stack[stacksize-2*dim+j+1] += stack[stacksize-dim+j+1];
+	      stacksize -= dim;
+	      break;
+	    }
+	  case VEC_SUB:
+	    {
+	      int dim = program[i].vecdim;
+	      for (int j = 0; j < dim; j++)
+		stack[stacksize-2*dim+j+1] -= stack[stacksize-dim+j+1];
+	      stacksize -= dim;
+	      break;
+	    }
+	  case SCAL_VEC_MULT:
+	    {
+	      int dim = program[i].vecdim;
+	      TS scal = stack[stacksize-dim];
+	      for (int j = 0; j < dim; j++)
+		stack[stacksize-dim+j] = scal * stack[stacksize-dim+j+1];
+	      stacksize--;
+	      break;
+	    }
+	  case VEC_VEC_MULT:
+	    {
+	      int dim = program[i].vecdim;
+	      TS scal = 0.0;
+	      for (int j = 0; j < dim; j++)
+		scal += stack[stacksize-2*dim+j+1] * stack[stacksize-dim+j+1];
+	      stacksize-=2*dim-1;
+              stack[stacksize] = scal;
+	      break;
+	    }
+	  case VEC_ELEM:
+	    {
+	      // the index is the same in all points
+	      int dim = program[i-1].vecdim;
+              int index = int(stack[stacksize][0]);
+              stack[stacksize-dim] = stack[stacksize-dim+index-1];
+	      stacksize -= dim;
+	      break;
+	    }
+	  case VEC_DIM:
+	    {
+	      int dim = program[i-1].vecdim;
+	      stacksize -= dim-1;
+              stack[stacksize] = double(dim);
+	      break;
+	    }
+
+	  case NEG:
+	    stack[stacksize] = -stack[stacksize];
+	    break;
+
+	  case AND:
+	    stack[stacksize-1] = True(stack[stacksize-1]) * True(stack[stacksize]);
+	    stacksize--;
+	    break;
+	  case OR:
+	    stack[stacksize-1] = IfPos (stack[stacksize-1]-eps, TS(1.0), True(stack[stacksize]));
+	    stacksize--;
+	    break;
+	  case NOT:
+	    stack[stacksize] = 1.0 - True(stack[stacksize]);
+	    break;
+	  case GREATER:
+	    stack[stacksize-1] = IfPos (stack[stacksize-1]-stack[stacksize], TS(1.0), TS(0.0));
+	    stacksize--;
+	    break;
+	  case GREATEREQUAL:
+	    stack[stacksize-1] = IfPos (stack[stacksize]-stack[stacksize-1], TS(0.0), TS(1.0));
+	    stacksize--;
+	    break;
+	  case EQUAL:
+	    stack[stacksize-1] = IfPos (eps-fabs(stack[stacksize-1]-stack[stacksize]), TS(1.0), TS(0.0));
+	    stacksize--;
+	    break;
+	  case LESSEQUAL:
+	    stack[stacksize-1] = IfPos (stack[stacksize-1]-stack[stacksize], TS(0.0), TS(1.0));
+	    stacksize--;
+	    break;
+	  case LESS:
+	    stack[stacksize-1] = IfPos (stack[stacksize]-stack[stacksize-1], TS(1.0), TS(0.0));
+	    stacksize--;
+	    break;
+
+	  case CONSTANT:
+	    stacksize++;
+	    stack[stacksize] = program[i].operand.val;
+	    break;
+	  case VARIABLE:
+	    for (int j = 0; j < program[i].vecdim; j++)
+	      {
+		stacksize++;
+		stack[stacksize] = x[program[i].operand.varnum+j];
+	      }
+	    break;
+	  case GLOBVAR:
+	    stacksize++;
+	    stack[stacksize] = *program[i].operand.globvar;
+	    break;
+	  case GLOBGENVAR:
+            for (int j = 0; j < program[i].operand.globgenvar->Dimension(); j++)
+              {
+                stacksize++;
+                stack[stacksize] = program[i].operand.globgenvar->Value<double>(j);
+              }
+	    break;
+	  case IMAG:
+	    throw Exception ("Eval SIMD called for complex EvalFunction");
+
+	  case FUNCTION:
+	    stack[stacksize] = Lanes (stack[stacksize], program[i].operand.fun);
+	    break;
+	  case SIN:
+	    stack[stacksize] = sin (stack[stacksize]);
+	    break;
+	  case COS:
+	    stack[stacksize] = cos (stack[stacksize]);
+	    break;
+	  case TAN:
+	    stack[stacksize] = tan (stack[stacksize]);
+	    break;
+	  case ATAN:
+	    stack[stacksize] = atan (stack[stacksize]);
+	    break;
+	  case ATAN2:
+	    {
+	      TS a = stack[stacksize-1], b = stack[stacksize];
+	      stack[stacksize-1] = TS([&] (int j) { return atan2 (a[j], b[j]); });
+	      stacksize--;
+	      break;
+	    }
+	  case EXP:
+	    stack[stacksize] = exp (stack[stacksize]);
+	    break;
+	  case LOG:
+	    stack[stacksize] = log (stack[stacksize]);
+	    break;
+	  case ABS:
+	    {
+	      int dim = program[i].vecdim;
+	      if (dim == 1)
+		stack[stacksize] = fabs (stack[stacksize]);
+	      else
+		{
+		  TS sum = 0.0;
+		  for (int j = 0; j < dim; j++)
+		    sum += stack[stacksize-j] * stack[stacksize-j];
+		  stacksize -= dim-1;
+		  stack[stacksize] = sqrt(sum);
+		}
+	      break;
+	    }
+	  case SIGN:
+	    stack[stacksize] = IfPos (stack[stacksize], TS(1.0),
+                                      IfPos (-stack[stacksize], TS(-1.0), TS(0.0)));
+	    break;
+	  case SQRT:
+	    stack[stacksize] = sqrt (stack[stacksize]);
+	    break;
+	  case STEP:
+	    stack[stacksize] = IfPos (-stack[stacksize], TS(0.0), TS(1.0));
+	    break;
+
+	  case COMMA:
+	    break;
+
+	  case BESSELJ0:
+	    stack[stacksize] = Lanes (stack[stacksize], bessj0);
+	    break;
+	  case BESSELJ1:
+	    stack[stacksize] = Lanes (stack[stacksize], bessj1);
+	    break;
+	  case BESSELY0:
+	    stack[stacksize] = Lanes (stack[stacksize], bessy0);
+	    break;
+	  case BESSELY1:
+	    stack[stacksize] = Lanes (stack[stacksize], bessy1);
+	    break;
+
+	  default:
+	    cerr << "undefined operation for EvalFunction" << endl;
+	  }
+      }
+
+    for (int i = 0; i < res_type.vecdim; i++)
+      y[i] = stack[i];
+  }
+
+
+
   bool EvalFunction :: IsConstant () const
   {
     if (res_type.iscomplex) return false;
@@ -119,7 +119,7 @@ namespace ngstd
 */
 class NGS_DLL_HEADER EvalFunction
 {
-
+public:
   ///
   enum EVAL_TOKEN
   {
@@ -167,6 +167,12 @@ public:
   void Eval (const complex<double> * x, complex<double> * y, int ydim) const;
   /// evaluate multi-value complex function with real result
   void Eval (const complex<double> * x, double * y, int ydim) const;
+  /**
+     evaluate a real function in a batch of SIMD<double>::Size() points,
+     x[i] holds argument i in all points. Scalar functions (FUNCTION,
+     atan2, Bessel functions) are applied lane by lane
+  */
+  void Eval (const SIMD<double> * x, SIMD<double> * y, int ydim) const;
 
   /*
   /// evaluate multi-value function
@@ -286,6 +292,10 @@ protected:
 
   /// the evaluation sequence
   Array<step> program;
+public:
+  /// the evaluation sequence, e.g. for translation into other representations
+  FlatArray<step> GetProgram () const { return program; }
+protected:
 
   class ResultType
   {
@@ -0,0 +1,203 @@
+/**************************************************************************/
+/* File:   eventlog.cpp                                                   */
+/* Date:   Oct. 2026                                                      */
+/**************************************************************************/
+
+#include <ngstd.hpp>
+
+namespace ngstd
+{
+
+  shared_ptr<EventLog> EventLog :: active;
+
+
+  static void AppendJSONString (string & line, const string & str)
+  {
+    line += '"';
+    for (char c : str)
+      switch (c)
+        {
+        case '"': line += "\\\""; break;
+        case '\\': line += "\\\\"; break;
+        case '\n': line += "\\n"; break;
+        case '\t': line += "\\t"; break;
+        default:
+          if ((unsigned char)(c) < 0x20)
+            {
+              char hex[8];
+              snprintf (hex, sizeof(hex), "\\u%04x", c);
+              line += hex;
+            }
+          else
+            line += c;
+        }
+    line += '"';
+  }
+
+  static void AppendKey (string & line, const string & key)
+  {
+    line += ',';
+    AppendJSONString (line, key);
+    line += ':';
+  }
+
+
+  EventLog::Record :: Record (EventLog & alog, const string & event)
+    : log(alog)
+  {
+    line = "{\"event\":";
+    AppendJSONString (line, event);
+    (*this)("t", WallTime()-log.starttime);
+    (*this)("rank", log.rank);
+  }
+
+  EventLog::Record :: ~Record ()
+  {
+    if (line.empty()) return;
+    line += "}\n";
+    // a failed background write must not escape a destructor
+    try
+      {
+        log.Append (line);
+      }
+    catch (Exception & e)
+      {
+        cerr << "EventLog: " << e.What() << endl;
+      }
+  }
+
+  auto EventLog::Record :: operator() (const string & key, double val) -> Record &
+  {
+    AppendKey (line, key);
+    if (std::isfinite (val))
+      {
+        char str[32];
+        snprintf (str, sizeof(str), "%.17g", val);
+        line += str;
+      }
+    else
+      line += "null";
+    return *this;
+  }
+
+  auto EventLog::Record :: operator() (const string & key, size_t val) -> Record &
+  {
+    AppendKey (line, key);
+    line += ToString (val);
+    return *this;
+  }
+
+  auto EventLog::Record :: operator() (const string & key, const string & val) -> Record &
+  {
+    AppendKey (line, key);
+    AppendJSONString (line, val);
+    return *this;
+  }
+
+
+
+  EventLog :: EventLog (const string & afilename, size_t aflushsize)
+    : filename(afilename), flushsize(aflushsize), starttime(WallTime()),
+      rank(MyMPI_GetId()), writer(4)
+  {
+    if (MyMPI_GetNTasks() > 1)
+      filename += "_" + ToString(rank);
+    out = make_shared<ofstream> (filename);
+    if (!*out)
+      throw Exception ("EventLog: cannot open " + filename);
+    Event("start")("ntasks", MyMPI_GetNTasks())("nthreads", TaskManager::GetMaxThreads());
+  }
+
+  EventLog :: ~EventLog ()
+  {
+    try
+      {
+        Flush();
+      }
+    catch (Exception & e)
+      {
+        cerr << "EventLog: " << e.What() << endl;
+      }
+  }
+
+  void EventLog :: Append (const string & line)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      buffer += line;
+      if (buffer.size() < flushsize) return;
+    }
+    Submit();
+  }
+
+  void EventLog :: Submit ()
+  {
+    auto data = make_shared<string>();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      swap (*data, buffer);
+    }
+    if (data->empty()) return;
+
+    auto file = out;
+    auto name = filename;
+    writer.Submit ([file, data, name] ()
+                   {
+                     file->write (data->data(), data->size());
+                     file->flush();
+                     if (!*file)
+                       throw Exception ("EventLog: cannot write " + name);
+                   });
+  }
+
+  void EventLog :: Flush ()
+  {
+    Submit();
+    writer.Wait();
+  }
+
+
+  void EventLog :: LogTimers ()
+  {
+    for (int i = 0; i < NgProfiler::SIZE; i++)
+      if (NgProfiler::GetCounts(i) != 0 && NgProfiler::usedcounter[i])
+        {
+          auto rec = Event("timer");
+          rec("name", NgProfiler::GetName(i))
+            ("calls", size_t(NgProfiler::GetCounts(i)))
+            ("time", NgProfiler::GetTime(i));
+          if (NgProfiler::GetFlops(i))
+            rec("flops", double(NgProfiler::GetFlops(i)));
+        }
+  }
+
+  void EventLog :: LogMPIStatistics ()
+  {
+#ifdef PARALLEL
+    auto & stat = MPIStatistics::Get();
+    for (int i = 0; i < MPIStatistics::NUM_OPS; i++)
+      {
+        auto op = MPIStatistics::OP(i);
+        Timer & t = stat.GetTimer (op);
+        if (t.GetCounts() == 0) continue;
+        Event("mpi")("name", MPIStatistics::GetName(op))
+          ("calls", size_t(t.GetCounts()))
+          ("time", t.GetTime())
+          ("bytes", stat.GetBytes(op));
+      }
+#endif
+  }
+
+  void EventLog :: LogMemory (const string & name, FlatArray<MemoryUsage> mu)
+  {
+    size_t total = 0;
+    for (auto & m : mu)
+      {
+        Event("memory")("object", name)("name", m.Name())
+          ("bytes", m.NBytes())("blocks", m.NBlocks());
+        total += m.NBytes();
+      }
+    Event("memory")("object", name)("name", "total")("bytes", total);
+  }
+
+}
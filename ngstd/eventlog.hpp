@@ -0,0 +1,87 @@
+#ifndef FILE_EVENTLOG
+#define FILE_EVENTLOG
+
+/**************************************************************************/
+/* File:   eventlog.hpp                                                   */
+/* Date:   Oct. 2026                                                      */
+/**************************************************************************/
+
+namespace ngstd
+{
+
+  /**
+     Structured log of events (solver iterations, timers, memory, MPI
+     statistics) as line-delimited JSON, one object per line:
+
+       {"event":"iteration","t":0.0123,"rank":0,"solver":"CG","it":3,"res":1.5e-05}
+
+     Records are collected in a buffer, full buffers are written by a
+     background AsyncWriter. With MPI every rank writes its own file,
+     with '_rank' appended to the name. Non-finite values are written as
+     null.
+   */
+  class NGS_DLL_HEADER EventLog
+  {
+    string filename;
+    size_t flushsize;
+    double starttime;
+    int rank;
+    std::mutex mutex;
+    string buffer;
+    /// only used by the writer thread
+    shared_ptr<ofstream> out;
+    AsyncWriter writer;
+
+    static shared_ptr<EventLog> active;
+
+  public:
+    /// a record, written to the log at destruction
+    class NGS_DLL_HEADER Record
+    {
+      EventLog & log;
+      string line;
+    public:
+      Record (EventLog & alog, const string & event);
+      Record (Record && other) : log(other.log), line(move(other.line)) { other.line.clear(); }
+      ~Record ();
+
+      Record & operator() (const string & key, double val);
+      Record & operator() (const string & key, size_t val);
+      Record & operator() (const string & key, int val) { return (*this)(key, double(val)); }
+      Record & operator() (const string & key, const string & val);
+      Record & operator() (const string & key, const char * val) { return (*this)(key, string(val)); }
+    };
+
+    EventLog (const string & afilename, size_t aflushsize = 1 << 16);
+    /// writes the remaining records
+    ~EventLog ();
+
+    Record Event (const string & event) { return Record (*this, event); }
+
+    void Iteration (const string & solver, int it, double res)
+    { Event("iteration")("solver",solver)("it",it)("res",res); }
+
+    /// time, calls and flops of all used NgProfiler timers
+    void LogTimers ();
+    /// time, calls and bytes of the MPI operations, see MPIStatistics
+    void LogMPIStatistics ();
+    /// memory usage as reported by GetMemoryUsage of an object
+    void LogMemory (const string & name, FlatArray<MemoryUsage> mu);
+
+    /// hands the buffer to the writer and waits until it is written
+    void Flush ();
+
+    const string & GetFileName () const { return filename; }
+
+    /// the log written by the library (solvers, ...), nullptr if none
+    static EventLog * Active () { return active.get(); }
+    static void SetActive (shared_ptr<EventLog> log) { active = log; }
+
+  private:
+    void Append (const string & line);
+    void Submit ();
+  };
+
+}
+
+#endif
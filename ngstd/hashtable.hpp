@@ -820,6 +820,145 @@ namespace ngstd
     return ost;
   }
 
+
+
+  /**
+     A closed hash-table for concurrent insertion, e.g. within a ParallelFor.
+     Lock-free: a slot is claimed by a compare-exchange of its state, and
+     the key is published when it is written. Keys set by other threads
+     are found as soon as they are published, their values are complete
+     after the parallel phase. The size is fixed, it should be the double
+     of the expected number of entries, an overflow throws.
+  */
+  template <class T_HASH, class T>
+  class ParallelClosedHashTable
+  {
+    enum : char { EMPTY = 0, BUSY = 1, USED = 2 };
+    size_t size;
+    size_t mask;
+    atomic<size_t> used;
+    Array<atomic<char>> state;
+    Array<T_HASH> hash;
+    Array<T> cont;
+  public:
+    ParallelClosedHashTable (size_t asize = 128)
+      : size(RoundUp2(asize)), mask(size-1), used(0), state(size), hash(size), cont(size)
+    {
+      ParallelFor (size, [&] (size_t i) { state[i].store (EMPTY, memory_order_relaxed); });
+    }
+
+    size_t Size() const { return size; }
+
+    /// is position used
+    bool UsedPos (size_t pos) const
+    {
+      return state[pos].load (memory_order_acquire) == USED;
+    }
+
+    /// number of used elements
+    size_t UsedElements () const { return used; }
+
+    size_t Position (const T_HASH & ind) const
+    {
+      size_t i = HashValue2 (ind, mask);
+      for (size_t cnt = 0; cnt < size; cnt++)
+        {
+          char st = WaitPublished (i);
+          if (st == EMPTY) return size_t(-1);
+          if (hash[i] == ind) return i;
+          i = (i+1) & mask;
+        }
+      return size_t(-1);
+    }
+
+    // returns true if new position is created
+    bool PositionCreate (const T_HASH & ind, size_t & apos)
+    {
+      size_t i = HashValue2 (ind, mask);
+      for (size_t cnt = 0; cnt < size; cnt++)
+        {
+          char st = state[i].load (memory_order_acquire);
+          if (st == EMPTY)
+            {
+              if (state[i].compare_exchange_strong (st, char(BUSY), memory_order_acq_rel))
+                {
+                  hash[i] = ind;
+                  state[i].store (USED, memory_order_release);
+                  used++;
+                  apos = i;
+                  return true;
+                }
+              // somebody else took the slot, maybe for the same key
+            }
+          if (st == BUSY) WaitPublished (i);
+          if (hash[i] == ind)
+            {
+              apos = i;
+              return false;
+            }
+          i = (i+1) & mask;
+        }
+      throw Exception ("ParallelClosedHashTable: table is full, size = "+ToString(size));
+    }
+
+    ///
+    void Set (const T_HASH & ahash, const T & acont)
+    {
+      size_t pos;
+      PositionCreate (ahash, pos);
+      cont[pos] = acont;
+    }
+
+    ///
+    const T & Get (const T_HASH & ahash) const
+    {
+      size_t pos = Position (ahash);
+      if (pos == size_t(-1))
+        throw Exception (string("illegal key: ") + ToString(ahash) );
+      return cont[pos];
+    }
+
+    ///
+    bool Used (const T_HASH & ahash) const
+    {
+      return (Position (ahash) != size_t(-1));
+    }
+
+    void GetData (size_t pos, T_HASH & ahash, T & acont) const
+    {
+      ahash = hash[pos];
+      acont = cont[pos];
+    }
+
+    const T & operator[] (T_HASH key) const { return Get(key); }
+    /// creates the key, the value is written by the caller
+    T & operator[] (T_HASH key)
+    {
+      size_t pos;
+      PositionCreate(key, pos);
+      return cont[pos];
+    }
+
+    template <typename FUNC>
+    void IterateParallel (FUNC func) const
+    {
+      ParallelFor (size, [&] (size_t i)
+                   {
+                     if (UsedPos(i))
+                       func (hash[i], cont[i]);
+                   });
+    }
+
+  private:
+    char WaitPublished (size_t pos) const
+    {
+      char st;
+      while ( (st = state[pos].load (memory_order_acquire)) == BUSY)
+        _mm_pause();
+      return st;
+    }
+  };
+
   
   template <typename TI>  
   INLINE size_t HashValue (const INT<2,TI> ind)
@@ -947,8 +1086,6 @@ namespace ngstd
     };
 
     Array<ClosedHT> hts;
-    class alignas(64) MyMutex64 : public MyMutex { };
-    
     Array<MyMutex64> locks;
 
   public:
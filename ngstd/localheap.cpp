@@ -9,20 +9,107 @@
 
 namespace ngstd
 {
+  bool LocalHeap :: grow_on_overflow = true;
+  atomic<size_t> LocalHeap :: high_water_mark(0);
+
+  struct Chunk
+  {
+    Chunk * prev;
+    char * prev_data;
+    char * prev_p;
+    size_t prev_totsize;
+    size_t size;
+  };
+
+  /*
+    Blocks released by a LocalHeap are kept by the thread, so repeated
+    assemblies reuse memory which is already mapped.
+    Allocated and cached blocks are registered as HEAPS.
+   */
+  class LocalHeapBlockCache
+  {
+    enum { NBLOCKS = 2 };
+    char * blocks[NBLOCKS] = { nullptr };
+    size_t sizes[NBLOCKS] = { 0 };
+  public:
+    ~LocalHeapBlockCache () { Clear(); }
+
+    void Clear ()
+    {
+      for (int i = 0; i < NBLOCKS; i++)
+        {
+          FreeBlock (blocks[i], sizes[i]);
+          blocks[i] = nullptr;
+          sizes[i] = 0;
+        }
+    }
+
+    // smallest cached block of at least size bytes
+    char * Get (size_t & size)
+    {
+      int best = -1;
+      for (int i = 0; i < NBLOCKS; i++)
+        if (blocks[i] && sizes[i] >= size && (best == -1 || sizes[i] < sizes[best]))
+          best = i;
+      if (best == -1)
+        {
+          char * block = new char[size];
+          MemoryRegistry::Alloc (MemoryRegistry::HEAPS, size);
+          return block;
+        }
+      char * block = blocks[best];
+      size = sizes[best];
+      blocks[best] = nullptr;
+      sizes[best] = 0;
+      return block;
+    }
+
+    // keep the largest blocks
+    void Put (char * block, size_t size)
+    {
+      int smallest = 0;
+      for (int i = 1; i < NBLOCKS; i++)
+        if (sizes[i] < sizes[smallest])
+          smallest = i;
+      if (size <= sizes[smallest])
+        {
+          FreeBlock (block, size);
+          return;
+        }
+      FreeBlock (blocks[smallest], sizes[smallest]);
+      blocks[smallest] = block;
+      sizes[smallest] = size;
+    }
+
+  private:
+    static void FreeBlock (char * block, size_t size)
+    {
+      if (!block) return;
+      delete [] block;
+      MemoryRegistry::Free (MemoryRegistry::HEAPS, size);
+    }
+  };
+
+  static thread_local LocalHeapBlockCache block_cache;
+
+  void LocalHeap :: ReleaseCachedBlocks ()
+  {
+    block_cache.Clear();
+  }
 
   LocalHeap :: LocalHeap (size_t asize, const char * aname, bool mult_by_threads)
   {
     if (mult_by_threads)
       asize *= TaskManager::GetMaxThreads();
-    totsize = asize;
     try
       {
-        data = new char[asize];
+        data = block_cache.Get(asize);
       }
     catch (exception & e)
       {
         throw Exception (ToString ("Could not allocate localheap, heapsize = ") + ToString(asize));
       }
+    totsize = asize;
 
     next = data + totsize;
     p = data;
@@ -40,6 +127,86 @@ namespace ngstd
     return LocalHeap (p + i * size_of_piece, size_of_piece, name);
   }
 
+  void * LocalHeap :: Overflow (size_t size)
+  {
+    p -= size;
+    if (!grow_on_overflow)
+      ThrowException();
+
+    // at least double the memory
+    size_t chunk_size = max2 (totsize, size+sizeof(Chunk)+2*ALIGN);
+    char * mem;
+    try
+      {
+        mem = block_cache.Get(chunk_size);
+      }
+    catch (exception & e)
+      {
+        ThrowException();
+      }
+    
+    Chunk * chunk = reinterpret_cast<Chunk*> (mem);
+    chunk->prev = chunks;
+    chunk->prev_data = data;
+    chunk->prev_p = p;
+    chunk->prev_totsize = totsize;
+    chunk->size = chunk_size;
+    chunks = chunk;
+    chunk_offset += p-data;
+
+    data = mem + sizeof(Chunk);
+    totsize = chunk_size - sizeof(Chunk);
+    next = data + totsize;
+    p = data + (ALIGN - (size_t(data) & (ALIGN-1)));
+
+    char * oldp = p;
+    p += size;
+    return oldp;
+  }
+
+  void LocalHeap :: ReleaseChunks (char * addr)
+  {
+    while (chunks && (addr == nullptr || addr < data || addr > next))
+      {
+        Chunk * chunk = chunks;
+        size_t used = chunk_offset + (p-data);
+        if (used > max_used) max_used = used;
+
+        data = chunk->prev_data;
+        p = chunk->prev_p;
+        totsize = chunk->prev_totsize;
+        next = data + totsize;
+        chunk_offset -= p-data;
+        chunks = chunk->prev;
+        block_cache.Put ((char*)chunk, chunk->size);
+      }
+  }
+
+  void LocalHeap :: Release ()
+  {
+    size_t used = chunk_offset + (p-data);
+    if (used > max_used) max_used = used;
+    if (chunks)
+      {
+        static atomic<int> cnt_warnings(0);
+        if (cnt_warnings++ == 0)
+          cout << IM(3) << "LocalHeap '" << (name ? name : "noname")
+               << "' overflowed and grew, consider a larger heapsize" << endl;
+        ReleaseChunks (nullptr);
+      }
+
+    size_t hw = high_water_mark.load(memory_order_relaxed);
+    while (max_used > hw && !high_water_mark.compare_exchange_weak(hw, max_used))
+      ;
+    max_used = 0;
+
+    if (owner)
+      {
+        block_cache.Put (data, totsize);
+        owner = false;
+      }
+  }
+
   void LocalHeap :: ThrowException() // throw (LocalHeapOverflow)
   {
     /*
@@ -41,6 +41,9 @@ namespace ngstd
      One can allocate memory out of it. This increases the stack pointer.
      With \Ref{CleanUp}, the pointer is reset to the beginning or to a
      specific position. 
+     If the block is exhausted, an extra block is chained (see
+     SetGrowOnOverflow), and released again by CleanUp. Blocks are
+     cached per thread and reused by the next LocalHeap.
   */
   class LocalHeap : public Allocator
   {
@@ -48,6 +51,14 @@ namespace ngstd
     char * next;
     char * p;
     size_t totsize;
+    // extra blocks after overflow, the header stores the previous block
+    struct Chunk * chunks = nullptr;
+    // memory used in the previous blocks, and maximal use
+    size_t chunk_offset = 0;
+    size_t max_used = 0;
+
+    NGS_DLL_HEADER static bool grow_on_overflow;
+    NGS_DLL_HEADER static atomic<size_t> high_water_mark;
   public:
     bool owner;
     const char * name;
@@ -89,11 +100,13 @@ namespace ngstd
     INLINE LocalHeap (const LocalHeap & lh2) = delete;
 
     INLINE LocalHeap (LocalHeap && lh2)
-      : data(lh2.data), p(lh2.p), totsize(lh2.totsize), owner(lh2.owner),
-        name(lh2.name)
+      : data(lh2.data), p(lh2.p), totsize(lh2.totsize),
+        chunks(lh2.chunks), chunk_offset(lh2.chunk_offset), max_used(lh2.max_used),
+        owner(lh2.owner), name(lh2.name)
     {
       next = data + totsize;
       lh2.owner = false;
+      lh2.chunks = nullptr;
     }
     
     INLINE LocalHeap Borrow() 
@@ -104,17 +117,21 @@ namespace ngstd
 
     INLINE LocalHeap & operator= (LocalHeap && lh2)
     {
-      if (owner)
-        delete [] data;
+      if (owner || chunks)
+        Release();
       
       data = lh2.data;
       p = lh2.p;
       totsize = lh2.totsize;
+      chunks = lh2.chunks;
+      chunk_offset = lh2.chunk_offset;
+      max_used = lh2.max_used;
       owner = lh2.owner;
       name = lh2.name;
 
       next = data + totsize;
       lh2.owner = false;
+      lh2.chunks = nullptr;
       return *this;
     }
 
@@ -125,13 +142,15 @@ namespace ngstd
     /// free memory
     INLINE virtual ~LocalHeap ()
     {
-      if (owner)
-	delete [] data;
+      if (owner || chunks || max_used > high_water_mark.load(memory_order_relaxed))
+        Release();
     }
   
     /// delete all memory on local heap
     INLINE void CleanUp() throw ()
     {
+      if (unlikely(chunks != nullptr))
+        ReleaseChunks (nullptr);
       p = data;
       // p += (16 - (long(p) & 15) );
       p += (ALIGN - (size_t(p) & (ALIGN-1) ) );
@@ -146,6 +165,10 @@ namespace ngstd
     /// deletes memory back to heap-pointer
     INLINE void CleanUp (void * addr) throw ()
     {
+      size_t used = chunk_offset + (p-data);
+      if (used > max_used) max_used = used;
+      if (unlikely(chunks != nullptr) && ((char*)addr < data || (char*)addr > next))
+        ReleaseChunks ((char*)addr);
       p = (char*)addr;
     }
 
@@ -160,8 +183,8 @@ namespace ngstd
 
       // if ( size_t(p - data) >= totsize )
 #ifndef FULLSPEED
-      if (likely(p >= next))
-        ThrowException();
+      if (unlikely(p >= next))
+        return Overflow (size);
 #endif
       return oldp;
     }
@@ -178,19 +201,37 @@ namespace ngstd
       p += size;
 
 #ifndef FULLSPEED
-      if (likely(p >= next))
-	ThrowException();
+      if (unlikely(p >= next))
+	return reinterpret_cast<T*> (Overflow (size));
 #endif
 
       return reinterpret_cast<T*> (oldp);
     }
 
+    /// chain a new block if the heap is exhausted (default), or throw LocalHeapOverflow
+    static void SetGrowOnOverflow (bool grow) { grow_on_overflow = grow; }
+    static bool GetGrowOnOverflow () { return grow_on_overflow; }
+
+    /// maximal memory used by one LocalHeap (or one thread's piece) so far
+    static size_t GetHighWaterMark () { return high_water_mark; }
+    static void ResetHighWaterMark () { high_water_mark = 0; }
+
+    /// release the blocks cached by the calling thread
+    NGS_DLL_HEADER static void ReleaseCachedBlocks ();
+
   private: 
     ///
 #ifndef __CUDA_ARCH__
     [[noreturn]] NGS_DLL_HEADER void ThrowException(); 
+    /// size bytes did not fit, p is already advanced
+    NGS_DLL_HEADER void * Overflow (size_t size);
+    NGS_DLL_HEADER void ReleaseChunks (char * addr);
+    NGS_DLL_HEADER void Release ();
 #else
     INLINE void ThrowException() { ; }
+    INLINE void * Overflow (size_t size) { return p-size; }
+    INLINE void ReleaseChunks (char * addr) { ; }
+    INLINE void Release () { ; }
 #endif
 
   public:
@@ -200,7 +241,7 @@ namespace ngstd
       ;
     }
 
-    /// available memory on LocalHeap
+    /// available memory on LocalHeap (in the current block)
     INLINE size_t Available () const throw () { return (totsize - (p-data)); }
 
     /// Split free memory on heap into pieces for each thread
@@ -0,0 +1,243 @@
+/**************************************************************************/
+/* File:   memusage.cpp                                                   */
+/* Date:   Oct. 2026                                                      */
+/**************************************************************************/
+
+#include <ngstd.hpp>
+#include <new>
+
+namespace ngstd
+{
+  atomic<size_t> MemoryRegistry :: current[NCATEGORIES];
+  atomic<size_t> MemoryRegistry :: peak[NCATEGORIES];
+  atomic<size_t> MemoryRegistry :: total_current(0);
+  atomic<size_t> MemoryRegistry :: total_peak(0);
+
+  static void UpdatePeak (atomic<size_t> & peak, size_t val)
+  {
+    size_t old = peak.load(memory_order_relaxed);
+    while (val > old && !peak.compare_exchange_weak(old, val))
+      ;
+  }
+
+  void MemoryRegistry :: Alloc (CATEGORY cat, size_t bytes)
+  {
+    UpdatePeak (peak[cat], current[cat] += bytes);
+    UpdatePeak (total_peak, total_current += bytes);
+  }
+
+  void MemoryRegistry :: ResetPeaks ()
+  {
+    for (int i = 0; i < NCATEGORIES; i++)
+      peak[i] = current[i].load();
+    total_peak = total_current.load();
+  }
+
+  const char * MemoryRegistry :: Name (CATEGORY cat)
+  {
+    static const char * names[NCATEGORIES] =
+      { "matrix values", "matrix graph", "factors", "heaps", "vectors",
+        "preconditioner", "pool", "other" };
+    return names[cat];
+  }
+
+  void MemoryRegistry :: Print (ostream & ost)
+  {
+    // no allocations, it is also called if the memory is exhausted
+    char line[128];
+    ost << "category              current MB     peak MB" << endl;
+    for (int i = 0; i < NCATEGORIES; i++)
+      {
+        snprintf (line, sizeof(line), "%-18s %12.1f %12.1f",
+                  Name(CATEGORY(i)), current[i]/1e6, peak[i]/1e6);
+        ost << line << endl;
+      }
+    snprintf (line, sizeof(line), "%-18s %12.1f %12.1f", "total",
+              total_current/1e6, total_peak/1e6);
+    ost << line << endl;
+  }
+
+
+  static std::new_handler prev_new_handler = nullptr;
+
+  static void PrintOnOutOfMemory ()
+  {
+    // print once, then let the previous handler (or bad_alloc) take over
+    std::set_new_handler (prev_new_handler);
+    cerr << "out of memory, registered memory:" << endl;
+    MemoryRegistry::Print (cerr);
+    if (prev_new_handler)
+      prev_new_handler();
+    else
+      throw std::bad_alloc();
+  }
+
+  void MemoryRegistry :: SetPrintOnOutOfMemory (bool print)
+  {
+    if (print)
+      {
+        std::new_handler old = std::set_new_handler (PrintOnOutOfMemory);
+        if (old != PrintOnOutOfMemory)
+          prev_new_handler = old;
+      }
+    else if (std::get_new_handler() == PrintOnOutOfMemory)
+      std::set_new_handler (prev_new_handler);
+  }
+
+  static bool init_print_on_oom = (MemoryRegistry::SetPrintOnOutOfMemory(true), true);
+
+
+
+  namespace
+  {
+    struct PoolBlock
+    {
+      void * p;
+      size_t bytes;    // as requested
+    };
+
+    struct PoolState
+    {
+      mutex mtx;
+      Array<PoolBlock> lists[256];
+      size_t max_cached = size_t(1) << 30;
+      MemoryPool::Statistics stats;
+    };
+
+    // never destroyed, vectors may be freed after the static destructors
+    PoolState & GetPool ()
+    {
+      static PoolState * pool = new PoolState;
+      return *pool;
+    }
+
+    // the smallest class size >= bytes, classes are (4+i)/4 * 2^e
+    size_t PoolClass (size_t bytes, int & cls)
+    {
+      size_t b = bytes-1;
+      int e = 2;
+      while ((b >> e) > 1) e++;
+      size_t m = b >> (e-2);      // 4 <= m < 8
+      cls = 4*e + int(m) - 4;
+      return (m+1) << (e-2);
+    }
+  }
+
+  void * MemoryPool :: Alloc (size_t bytes)
+  {
+    if (bytes < MIN_BYTES)
+      return ::operator new (bytes);
+
+    int cls;
+    size_t size = PoolClass (bytes, cls);
+    auto & pool = GetPool();
+    {
+      lock_guard<mutex> guard(pool.mtx);
+      pool.stats.allocs++;
+      auto & list = pool.lists[cls];
+      if (list.Size())
+        {
+          size_t pos = list.Size()-1;
+          for (size_t i = list.Size(); i-- > 0; )
+            if (list[i].bytes == bytes)
+              {
+                pos = i;
+                pool.stats.reused_same++;
+                break;
+              }
+          void * p = list[pos].p;
+          list[pos] = list.Last();
+          list.DeleteLast();
+          pool.stats.reused++;
+          pool.stats.cached_blocks--;
+          pool.stats.cached_bytes -= size;
+          MemoryRegistry::Free (MemoryRegistry::POOL, size);
+          return p;
+        }
+    }
+
+    try
+      {
+        return ::operator new (size);
+      }
+    catch (std::bad_alloc &)
+      {
+        // the waiting blocks of other classes may make room
+        Clear();
+        return ::operator new (size);
+      }
+  }
+
+  void MemoryPool :: Free (void * p, size_t bytes)
+  {
+    if (!p) return;
+    if (bytes >= MIN_BYTES)
+      {
+        int cls;
+        size_t size = PoolClass (bytes, cls);
+        auto & pool = GetPool();
+        lock_guard<mutex> guard(pool.mtx);
+        if (pool.stats.cached_bytes + size <= pool.max_cached)
+          {
+            pool.lists[cls].Append (PoolBlock { p, bytes });
+            pool.stats.cached_blocks++;
+            pool.stats.cached_bytes += size;
+            MemoryRegistry::Alloc (MemoryRegistry::POOL, size);
+            return;
+          }
+        pool.stats.released++;
+      }
+    ::operator delete (p);
+  }
+
+  void MemoryPool :: SetMaxCached (size_t bytes)
+  {
+    {
+      auto & pool = GetPool();
+      lock_guard<mutex> guard(pool.mtx);
+      pool.max_cached = bytes;
+      if (pool.stats.cached_bytes <= bytes) return;
+    }
+    Clear();
+  }
+
+  size_t MemoryPool :: GetMaxCached ()
+  {
+    return GetPool().max_cached;
+  }
+
+  void MemoryPool :: Clear ()
+  {
+    Array<void*> blocks;
+    {
+      auto & pool = GetPool();
+      lock_guard<mutex> guard(pool.mtx);
+      for (auto & list : pool.lists)
+        {
+          for (auto & block : list)
+            blocks.Append (block.p);
+          list.DeleteAll();
+        }
+      pool.stats.released += blocks.Size();
+      MemoryRegistry::Free (MemoryRegistry::POOL, pool.stats.cached_bytes);
+      pool.stats.cached_blocks = 0;
+      pool.stats.cached_bytes = 0;
+    }
+    for (void * p : blocks)
+      ::operator delete (p);
+  }
+
+  MemoryPool::Statistics MemoryPool :: GetStatistics ()
+  {
+    auto & pool = GetPool();
+    lock_guard<mutex> guard(pool.mtx);
+    return pool.stats;
+  }
+
+  void MemoryPool :: ResetStatistics ()
+  {
+    auto & pool = GetPool();
+    lock_guard<mutex> guard(pool.mtx);
+    pool.stats.allocs = pool.stats.reused = pool.stats.reused_same = pool.stats.released = 0;
+  }
+}
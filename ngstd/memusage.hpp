@@ -36,6 +36,141 @@ public:
   size_t NBlocks () const { return nblocks; }
 };
 
+
+
+/**
+   Central accounting of the large allocations.
+   Matrices, factors, heaps and vectors register their memory under a
+   category, the registry keeps the current and the peak number of
+   bytes per category and in total. The table is printed to cerr if an
+   allocation fails (see SetPrintOnOutOfMemory).
+ */
+class NGS_DLL_HEADER MemoryRegistry
+{
+public:
+  enum CATEGORY { MATRIX_VALUES, MATRIX_GRAPH, FACTORS, HEAPS, VECTORS,
+                  PRECONDITIONER, POOL, OTHER, NCATEGORIES };
+
+private:
+  static atomic<size_t> current[NCATEGORIES];
+  static atomic<size_t> peak[NCATEGORIES];
+  static atomic<size_t> total_current;
+  static atomic<size_t> total_peak;
+
+public:
+  static void Alloc (CATEGORY cat, size_t bytes);
+  static void Free (CATEGORY cat, size_t bytes)
+  {
+    current[cat] -= bytes;
+    total_current -= bytes;
+  }
+
+  static size_t Current (CATEGORY cat) { return current[cat]; }
+  static size_t Peak (CATEGORY cat) { return peak[cat]; }
+  static size_t Current () { return total_current; }
+  static size_t Peak () { return total_peak; }
+  /// peaks start again from the current values
+  static void ResetPeaks ();
+
+  static const char * Name (CATEGORY cat);
+  static void Print (ostream & ost);
+
+  /// print the registry before std::bad_alloc is thrown (default on)
+  static void SetPrintOnOutOfMemory (bool print);
+};
+
+
+/**
+   Registers the memory of an object under a category, for the lifetime
+   of the object. A copy starts with zero bytes, the copied object has
+   to set the size of its own memory.
+ */
+class MemoryTracker
+{
+  MemoryRegistry::CATEGORY cat;
+  size_t bytes = 0;
+public:
+  MemoryTracker (MemoryRegistry::CATEGORY acat) : cat(acat) { ; }
+  MemoryTracker (const MemoryTracker & t2) : cat(t2.cat) { ; }
+  MemoryTracker (MemoryTracker && t2) : cat(t2.cat), bytes(t2.bytes) { t2.bytes = 0; }
+  ~MemoryTracker () { Set(0); }
+
+  MemoryTracker & operator= (const MemoryTracker &) { return *this; }
+  MemoryTracker & operator= (MemoryTracker && t2)
+  {
+    Set(0);
+    bytes = t2.bytes;
+    t2.bytes = 0;
+    return *this;
+  }
+
+  void Set (size_t abytes)
+  {
+    if (abytes > bytes)
+      MemoryRegistry::Alloc (cat, abytes-bytes);
+    else if (abytes < bytes)
+      MemoryRegistry::Free (cat, bytes-abytes);
+    bytes = abytes;
+  }
+
+  /// the sum of the memory usage reported by GetMemoryUsage
+  void Set (FlatArray<MemoryUsage> mu)
+  {
+    size_t sum = 0;
+    for (auto & m : mu)
+      sum += m.NBytes();
+    Set (sum);
+  }
+
+  size_t NBytes () const { return bytes; }
+};
+
+
+
+/**
+   Recycles large blocks, as the storage of vectors. Freed blocks wait
+   in free lists by size class, four classes per power of two. An
+   allocation takes a waiting block of its class, preferably one freed
+   with the same size: if that block was first touched in parallel, its
+   pages are on the NUMA nodes of the threads working on the same
+   entries again. Smaller blocks than MIN_BYTES go to new directly.
+   The cached bytes are registered as category POOL.
+ */
+class NGS_DLL_HEADER MemoryPool
+{
+public:
+  static constexpr size_t MIN_BYTES = 32768;
+
+  struct Statistics
+  {
+    size_t allocs = 0;        // allocations of pooled size
+    size_t reused = 0;        // ... served from the free lists
+    size_t reused_same = 0;   // ... by a block of the same size
+    size_t released = 0;      // blocks given back to the system
+    size_t cached_blocks = 0;
+    size_t cached_bytes = 0;
+  };
+
+  /// a block of at least bytes
+  static void * Alloc (size_t bytes);
+  /// bytes as requested by Alloc
+  static void Free (void * p, size_t bytes);
+
+  template <typename T>
+  static T * Alloc (size_t n) { return static_cast<T*> (Alloc (n*sizeof(T))); }
+  template <typename T>
+  static void Free (T * p, size_t n) { Free (static_cast<void*>(p), n*sizeof(T)); }
+
+  /// bytes kept at most in the free lists, 0 disables the pool
+  static void SetMaxCached (size_t bytes);
+  static size_t GetMaxCached ();
+  /// gives all waiting blocks back to the system
+  static void Clear ();
+
+  static Statistics GetStatistics ();
+  static void ResetStatistics ();
+};
+
 }
 
 #endif
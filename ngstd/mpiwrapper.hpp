@@ -134,11 +134,68 @@ namespace ngstd
     return id;
   }
 
-  INLINE void MyMPI_Barrier (MPI_Comm comm = ngs_comm)
+
+  /**
+     Communication statistics of the MyMPI wrappers and the exchange of
+     parallel vectors. Calls and time per kind of operation are NgProfiler
+     timers ("MPI send", ...), the transferred bytes are accumulated and
+     written to the trace as counters. MyMPI_PrintStatistics reduces them
+     over the ranks.
+  */
+  class MPIStatistics
   {
-    static Timer t("dummy - barrier");
-    RegionTimer r(t);
+  public:
+    enum OP { SEND, RECV, WAIT, REDUCE, COLLECTIVE, NUM_OPS };
+
+    static MPIStatistics & Get () { static MPIStatistics stat; return stat; }
+
+    static const char * GetName (OP op)
+    {
+      static const char * names[] = { "MPI send", "MPI recv", "MPI wait",
+                                      "MPI reduce", "MPI collective" };
+      return names[op];
+    }
+
+    Timer & GetTimer (OP op) { return timers[op]; }
+    size_t GetBytes (OP op) const { return bytes[op]; }
+
+    /// only called by the communicating thread, see MyMPI
+    void AddBytes (OP op, size_t nbytes)
+    {
+      bytes[op] += nbytes;
+      if (trace) trace->SetCounter (TaskManager::GetThreadId(), counters[op], bytes[op]);
+    }
+
+    void Reset () { for (auto & b : bytes) b = 0; }
+
+  private:
+    MPIStatistics ()
+    {
+      for (int i = 0; i < NUM_OPS; i++)
+        {
+          timers.emplace_back (GetName(OP(i)));
+          counters[i] = PajeTrace::CreateCounter (string(GetName(OP(i))) + " bytes");
+          bytes[i] = 0;
+        }
+    }
 
+    std::vector<Timer> timers;
+    int counters[NUM_OPS];
+    size_t bytes[NUM_OPS];
+  };
+
+  template <typename T>
+  INLINE void MyMPI_CountBytes (MPIStatistics::OP op, size_t n)
+  {
+    MPIStatistics::Get().AddBytes (op, n * sizeof(T));
+  }
+
+  /// time, calls and bytes per operation, min/avg/max over the ranks of comm
+  NGS_DLL_HEADER void MyMPI_PrintStatistics (ostream & ost, MPI_Comm comm = ngs_comm);
+
+  INLINE void MyMPI_Barrier (MPI_Comm comm = ngs_comm)
+  {
+    RegionTimer r(MPIStatistics::Get().GetTimer(MPIStatistics::WAIT));
     MPI_Barrier (comm);
   }
 
@@ -154,26 +211,44 @@ namespace ngstd
 
   template<typename T, NGSMPI_ENABLE_FOR_STD>
   INLINE void MyMPI_Send( T & val, int dest, int tag = MPI_TAG_SOLVE, MPI_Comm comm = ngs_comm)
-  { MPI_Send (&val, 1, MyGetMPIType<T>(), dest, tag, comm); }
+  {
+    RegionTimer r(MPIStatistics::Get().GetTimer(MPIStatistics::SEND));
+    MyMPI_CountBytes<T> (MPIStatistics::SEND, 1);
+    MPI_Send (&val, 1, MyGetMPIType<T>(), dest, tag, comm);
+  }
   template<typename T, NGSMPI_ENABLE_FOR_STD>
   INLINE void MyMPI_Recv (T & val, int src, int tag = MPI_TAG_SOLVE, MPI_Comm comm = ngs_comm)
-  { MPI_Recv (&val, 1, MyGetMPIType<T>(), src, tag, comm, MPI_STATUS_IGNORE); }
+  {
+    RegionTimer r(MPIStatistics::Get().GetTimer(MPIStatistics::RECV));
+    MyMPI_CountBytes<T> (MPIStatistics::RECV, 1);
+    MPI_Recv (&val, 1, MyGetMPIType<T>(), src, tag, comm, MPI_STATUS_IGNORE);
+  }
 
   template<typename T, NGSMPI_ENABLE_FOR_STD>
   INLINE void MyMPI_Send(FlatArray<T> s, int dest, int tag = MPI_TAG_SOLVE, MPI_Comm comm = ngs_comm)
-  { MPI_Send( &s[0], s.Size(), MyGetMPIType<T>(), dest, tag, comm); }
+  {
+    RegionTimer r(MPIStatistics::Get().GetTimer(MPIStatistics::SEND));
+    MyMPI_CountBytes<T> (MPIStatistics::SEND, s.Size());
+    MPI_Send( &s[0], s.Size(), MyGetMPIType<T>(), dest, tag, comm);
+  }
   template <typename T, NGSMPI_ENABLE_FOR_STD>
   INLINE void MyMPI_Recv (FlatArray <T> s, int src, int tag = MPI_TAG_SOLVE, MPI_Comm comm = ngs_comm)
-  { MPI_Recv (&s[0], s.Size(), MyGetMPIType<T> (), src, tag, comm, MPI_STATUS_IGNORE); }
+  {
+    RegionTimer r(MPIStatistics::Get().GetTimer(MPIStatistics::RECV));
+    MyMPI_CountBytes<T> (MPIStatistics::RECV, s.Size());
+    MPI_Recv (&s[0], s.Size(), MyGetMPIType<T> (), src, tag, comm, MPI_STATUS_IGNORE);
+  }
   template <typename T, NGSMPI_ENABLE_FOR_STD>
   INLINE void MyMPI_Recv (Array <T> &s, int src, int tag = MPI_TAG_SOLVE, MPI_Comm comm = ngs_comm)
   {
+    RegionTimer r(MPIStatistics::Get().GetTimer(MPIStatistics::RECV));
     MPI_Status status;
     int len;
     const MPI_Datatype MPI_T  = MyGetMPIType<T> ();
     MPI_Probe (src, tag, comm, &status);
     MPI_Get_count (&status, MPI_T, &len);
     s.SetSize (len);
+    MyMPI_CountBytes<T> (MPIStatistics::RECV, len);
     MPI_Recv (&s[0], len, MPI_T, src, tag, comm, MPI_STATUS_IGNORE);
   }
 
@@ -215,8 +290,8 @@ namespace ngstd
   template <typename T, NGSMPI_ENABLE_FOR_STD>
   INLINE MPI_Request MyMPI_ISend (const FlatArray<T> & s, int dest, int tag = MPI_TAG_SOLVE, MPI_Comm comm = ngs_comm)
   { 
-    static Timer t("dummy - isend");
-    RegionTimer r(t);
+    RegionTimer r(MPIStatistics::Get().GetTimer(MPIStatistics::SEND));
+    MyMPI_CountBytes<T> (MPIStatistics::SEND, s.Size());
 
     MPI_Request request;
     MPI_Datatype MPI_T  = MyGetMPIType<T> ();
@@ -226,8 +301,8 @@ namespace ngstd
   template <typename T, NGSMPI_ENABLE_FOR_STD>
   INLINE MPI_Request  MyMPI_IRecv (const FlatArray<T> & s, int src, int tag = MPI_TAG_SOLVE, MPI_Comm comm = ngs_comm)
   { 
-    static Timer t("dummy - irecv");
-    RegionTimer r(t);
+    RegionTimer r(MPIStatistics::Get().GetTimer(MPIStatistics::RECV));
+    MyMPI_CountBytes<T> (MPIStatistics::RECV, s.Size());
 
     MPI_Request request;
     MPI_Datatype MPI_T = MyGetMPIType<T> ();
@@ -237,16 +312,14 @@ namespace ngstd
 
   INLINE void MyMPI_WaitAll (const Array<MPI_Request> & requests)
   {
-    static Timer t("dummy - waitall");
-    RegionTimer r(t);
+    RegionTimer r(MPIStatistics::Get().GetTimer(MPIStatistics::WAIT));
     if (!requests.Size()) return;
     MPI_Waitall (requests.Size(), &requests[0], MPI_STATUSES_IGNORE);
   }
   
   INLINE int MyMPI_WaitAny (const Array<MPI_Request> & requests)
   {
-    static Timer t("dummy - waitany");
-    RegionTimer r(t);
+    RegionTimer r(MPIStatistics::Get().GetTimer(MPIStatistics::WAIT));
 
     int nr;
     MPI_Waitany (requests.Size(), &requests[0], &nr, MPI_STATUS_IGNORE);
@@ -259,8 +332,8 @@ namespace ngstd
   template <typename T, NGSMPI_ENABLE_FOR_STD>
   INLINE T MyMPI_Reduce (T d, const MPI_Op & op = MPI_SUM, MPI_Comm comm = ngs_comm, int root = 0)
   {
-    static Timer t("dummy - AllReduce");
-    RegionTimer r(t);
+    RegionTimer r(MPIStatistics::Get().GetTimer(MPIStatistics::REDUCE));
+    MyMPI_CountBytes<T> (MPIStatistics::REDUCE, 1);
 
     T global_d;
     MPI_Reduce (&d, &global_d, 1, MyGetMPIType<T>(), op, root, comm);
@@ -270,20 +343,30 @@ namespace ngstd
   template <typename T, NGSMPI_ENABLE_FOR_STD>
   INLINE T MyMPI_AllReduce (T d, const MPI_Op & op = MPI_SUM, MPI_Comm comm = ngs_comm)
   {
-    static Timer t("dummy - AllReduce");
-    RegionTimer r(t);
+    RegionTimer r(MPIStatistics::Get().GetTimer(MPIStatistics::REDUCE));
+    MyMPI_CountBytes<T> (MPIStatistics::REDUCE, 1);
 
     T global_d;
     MPI_Allreduce ( &d, &global_d, 1, MyGetMPIType<T>(), op, comm);
     return global_d;
   }
   
+  /// non-blocking global reduction in place, MPI_Wait for the request before using d
+  template <typename T, NGSMPI_ENABLE_FOR_STD>
+  INLINE MPI_Request MyMPI_IAllReduce (FlatArray<T> d, const MPI_Op & op = MPI_SUM, MPI_Comm comm = ngs_comm)
+  {
+    MyMPI_CountBytes<T> (MPIStatistics::REDUCE, d.Size());
+    MPI_Request request;
+    MPI_Iallreduce (MPI_IN_PLACE, &d[0], d.Size(), MyGetMPIType<T>(), op, comm, &request);
+    return request;
+  }
+
   template <typename T, NGSMPI_ENABLE_FOR_STD>
   INLINE void MyMPI_Gather (T d, FlatArray<T> recv = FlatArray<T>(0, NULL),
 			    MPI_Comm comm = ngs_comm, int root = 0)
   {
-    static Timer t ("dummy - Gather");
-    RegionTimer r(t);
+    RegionTimer r(MPIStatistics::Get().GetTimer(MPIStatistics::COLLECTIVE));
+    MyMPI_CountBytes<T> (MPIStatistics::COLLECTIVE, 1);
 
     MPI_Gather( &d, 1, MyGetMPIType<T>(),
 		recv.Size()?&recv[0]:NULL, 1, MyGetMPIType<T>(), root, comm);
@@ -292,8 +375,8 @@ namespace ngstd
   template <typename T, NGSMPI_ENABLE_FOR_STD>
   INLINE void MyMPI_AllGather (T d, FlatArray<T> recv, MPI_Comm comm = ngs_comm)
   {
-    static Timer t("dummy - AllGather");
-    RegionTimer r(t);
+    RegionTimer r(MPIStatistics::Get().GetTimer(MPIStatistics::COLLECTIVE));
+    MyMPI_CountBytes<T> (MPIStatistics::COLLECTIVE, 1);
 
     MPI_Allgather (&d, 1, MyGetMPIType<T>(), 
 		   &recv[0], 1, MyGetMPIType<T>(), comm);
@@ -302,8 +385,8 @@ namespace ngstd
   template <typename T, NGSMPI_ENABLE_FOR_STD>
   INLINE void MyMPI_AllToAll (FlatArray<T> send, FlatArray<T> recv, MPI_Comm comm = ngs_comm)
   {
-    static Timer t("dummy - AlltoAll");
-    RegionTimer r(t);
+    RegionTimer r(MPIStatistics::Get().GetTimer(MPIStatistics::COLLECTIVE));
+    MyMPI_CountBytes<T> (MPIStatistics::COLLECTIVE, send.Size());
 
     MPI_Alltoall (&send[0], 1, MyGetMPIType<T>(), 
 		  &recv[0], 1, MyGetMPIType<T>(), comm);
@@ -312,7 +395,11 @@ namespace ngstd
   
   template <typename T, NGSMPI_ENABLE_FOR_STD>
   INLINE void MyMPI_Bcast (T & s, MPI_Comm comm = ngs_comm, int root = 0)
-  { MPI_Bcast (&s, 1, MyGetMPIType<T>(), root, comm); }
+  {
+    RegionTimer r(MPIStatistics::Get().GetTimer(MPIStatistics::COLLECTIVE));
+    MyMPI_CountBytes<T> (MPIStatistics::COLLECTIVE, 1);
+    MPI_Bcast (&s, 1, MyGetMPIType<T>(), root, comm);
+  }
 
   INLINE void MyMPI_Bcast (string & s, MPI_Comm comm = ngs_comm, int root = 0)
   {
@@ -333,20 +420,39 @@ public:
   {
     int is_init = -1;
     MPI_Initialized(&is_init);
+    int provided;
     if (!is_init)
       {
-        MPI_Init (&argc, &argv);
+        // only the master thread of the TaskManager communicates
+        MPI_Init_thread (&argc, &argv, MPI_THREAD_FUNNELED, &provided);
         initialized_by_me = true;
       }
     else
-      initialized_by_me = false;
+      {
+        MPI_Query_thread (&provided);
+        initialized_by_me = false;
+      }
       
     // MPI_Comm_dup ( MPI_COMM_WORLD, &ngs_comm);      
     ngs_comm = MPI_COMM_WORLD;
     NGSOStream::SetGlobalActive (MyMPI_GetId() == 0);
     
     if (MyMPI_GetNTasks (ngs_comm) > 1)
-      TaskManager::SetNumThreads (1);
+      {
+        if (provided < MPI_THREAD_FUNNELED)
+          TaskManager::SetNumThreads (1);
+        else if (getenv ("NGS_NUM_THREADS"))
+          ; // explicitly chosen threads per rank
+        else
+          {
+            // share the cores of a node among its ranks
+            MPI_Comm node_comm;
+            MPI_Comm_split_type (ngs_comm, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node_comm);
+            int ranks_on_node = MyMPI_GetNTasks (node_comm);
+            MPI_Comm_free (&node_comm);
+            TaskManager::SetNumThreads (max2 (1, TaskManager::GetMaxThreads() / ranks_on_node));
+          }
+      }
   }
 
   ~MyMPI()
@@ -183,6 +183,9 @@ namespace std
     }
   };
   
+  /// a MyMutex on its own cache line, for arrays of locks
+  class alignas(64) MyMutex64 : public MyMutex { };
+
   class MyLock
   {
     MyMutex & mutex;
@@ -160,6 +160,7 @@ namespace ngstd
 
 #include "autodiff.hpp"
 #include "autodiffdiff.hpp"
+#include "bspline.hpp"
 #include "polorder.hpp"
 #include "stringops.hpp"
 #include "statushandler.hpp"
@@ -169,6 +170,8 @@ namespace ngstd
 #include "sockets.hpp"
 #endif
 #include "archive.hpp"
+#include "asyncwriter.hpp"
+#include "eventlog.hpp"
 
 namespace ngstd
 {
@@ -20,6 +20,19 @@ namespace ngstd
   bool PajeTrace::trace_thread_counter = true;
   bool PajeTrace::trace_threads = true;
 
+  int PajeTrace::trace_format = (getenv("NGS_TRACE_FORMAT") && string(getenv("NGS_TRACE_FORMAT")) == "chrome")
+    ? PajeTrace::CHROME : PajeTrace::PAJE;
+  bool PajeTrace::ring_buffer = false;
+  std::vector<std::string> PajeTrace::counter_names;
+  static mutex counter_mutex;
+
+  int PajeTrace::CreateCounter( const std::string & name )
+  {
+    lock_guard<mutex> guard(counter_mutex);
+    counter_names.push_back (name);
+    return counter_names.size()-1;
+  }
+
   string Demangle(string mangled_name)
   {
       string result = mangled_name;
@@ -38,6 +51,7 @@ namespace ngstd
   PajeTrace :: PajeTrace(int anthreads, std::string aname)
   {
     start_time = GetTime();
+    start_wall_time = std::chrono::system_clock::now();
     
     nthreads = anthreads;
     tracefile_name = aname;
@@ -65,6 +79,9 @@ namespace ngstd
     links.resize(nthreads);
     for(auto & l : links)
       l.reserve(reserve_size);
+
+    counters.resize(nthreads);
+    tasks_dropped.assign(nthreads, 0);
     
     jobs.reserve(reserve_size);
     timer_events.reserve(reserve_size);
@@ -79,6 +96,16 @@ namespace ngstd
   }
   
   
+  void PajeTrace::DropTasks (int thread_id)
+    {
+      auto & t = tasks[thread_id];
+      int half = t.Size()/2;
+      for (int i = half; i < t.Size(); i++)
+        t[i-half] = t[i];
+      t.SetSize (t.Size()-half);
+      tasks_dropped[thread_id] += half;
+    }
+
   void PajeTrace::StopTracing()
     {
       if(tracing_enabled && max_num_events_per_thread>0)
@@ -363,6 +390,14 @@ namespace ngstd
   NGS_DLL_HEADER PajeTrace *trace;
 
   void PajeTrace::Write( string filename )
+    {
+      if (trace_format == CHROME)
+        WriteChrome (filename);
+      else
+        WritePaje (filename);
+    }
+
+  void PajeTrace::WritePaje( string filename )
     {
       int n_events = jobs.size() + timer_events.size();
       for(auto & vtasks : tasks)
@@ -460,7 +495,7 @@ namespace ngstd
               timerdepth++;
               maxdepth = timerdepth>maxdepth ? timerdepth : maxdepth;
             }
-          else
+          else if(timerdepth>0)   // start may be dropped by the ring buffer
             timerdepth--;
         }
 
@@ -478,7 +513,7 @@ namespace ngstd
         {
           if(event.is_start)
             paje.PushState( event.time, state_type_timer, timer_container_aliases[timerdepth++], timer_aliases[event.timer_id] );
-          else
+          else if(timerdepth>0)
             paje.PopState( event.time, state_type_timer, timer_container_aliases[--timerdepth] );
         }
 
@@ -490,7 +525,9 @@ namespace ngstd
               switch(t.id_type)
                 {
                 case Task::ID_JOB:
-                  value_id = job_task_map[jobs[t.id-1].type];
+                  if(t.id-1-jobs_dropped < 0 || t.id-1-jobs_dropped >= int(jobs.size()))
+                    break;
+                  value_id = job_task_map[jobs[t.id-1-jobs_dropped].type];
                   if(trace_thread_counter)
                     {
                       paje.AddVariable( t.start_time, variable_type_active_threads, container_jobs, 1.0 );
@@ -515,6 +552,15 @@ namespace ngstd
           }
         }
 
+      std::map<int,int> counter_aliases;
+      for(auto & vcounters : counters)
+        for(auto & c : vcounters)
+          {
+            if(counter_aliases.find(c.counter_id) == counter_aliases.end())
+              counter_aliases[c.counter_id] = paje.DefineVariableType( container_type_jobs, counter_names[c.counter_id] );
+            paje.SetVariable( c.time, counter_aliases[c.counter_id], container_jobs, c.value );
+          }
+
       // Merge link event
       int nlinks = 0;
       for( auto & l : links)
@@ -575,6 +621,112 @@ namespace ngstd
         }
       paje.WriteEvents();
     }
+
+  static string JsonEscape (const string & s)
+    {
+      string res;
+      for (char c : s)
+        {
+          if (c == '"' || c == '\\')
+            res += '\\';
+          if (c == '\n' || c == '\t')
+            c = ' ';
+          res += c;
+        }
+      return res;
+    }
+
+  void PajeTrace::WriteChrome( string filename )
+    {
+      int n_events = jobs.size() + timer_events.size();
+      for(auto & vtasks : tasks)
+        n_events += vtasks.Size();
+
+      cout << n_events << " events traced." << endl;
+
+      if(n_events==0)
+        {
+          cout << "Skip writing trace file." << endl;
+          return;
+        }
+
+      // calibrate the time stamp counter against the wall clock
+      double ticks = GetTime()-start_time;
+      double wall_us = std::chrono::duration<double,std::micro>(std::chrono::system_clock::now()-start_wall_time).count();
+      double ticks_per_us = (wall_us > 0 && ticks > 0) ? ticks/wall_us : 2.7e3;
+      auto us = [&] (TTimePoint t) { return (double(t)-double(start_time)) / ticks_per_us; };
+
+      FILE * ctrace_stream = fopen (filename.c_str(), "w");
+      if (!ctrace_stream)
+        throw Exception("cannot open trace file " + filename);
+
+      const int tid_jobs = nthreads;
+      const int tid_timers = nthreads+1;
+
+      fprintf(ctrace_stream, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+      fprintf(ctrace_stream, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"Task Manager\"}}");
+      for (int i = 0; i < nthreads; i++)
+        fprintf(ctrace_stream, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"Thread %d\"}}", i, i);
+      fprintf(ctrace_stream, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"Jobs\"}}", tid_jobs);
+      fprintf(ctrace_stream, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"Timers\"}}", tid_timers);
+
+      std::map<const std::type_info *, string> job_names;
+      for(Job & j : jobs)
+        if(job_names.find(j.type) == job_names.end())
+          job_names[j.type] = JsonEscape(Demangle(j.type->name()));
+
+      for(Job & j : jobs)
+        fprintf(ctrace_stream, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"job\":%d}}",
+                job_names[j.type].c_str(), tid_jobs, us(j.start_time), us(j.stop_time)-us(j.start_time), j.job_id);
+
+      for(auto & vtasks : tasks)
+        for (Task & t : vtasks)
+          {
+            string name;
+            switch(t.id_type)
+              {
+              case Task::ID_JOB:
+                if(t.id-1-jobs_dropped < 0 || t.id-1-jobs_dropped >= int(jobs.size()))
+                  continue;
+                name = job_names[jobs[t.id-1-jobs_dropped].type];
+                break;
+              case Task::ID_TIMER:
+                name = JsonEscape(NgProfiler::GetName(t.id));
+                break;
+              default:
+                name = "Task " + ToString(t.id);
+                break;
+              }
+            fprintf(ctrace_stream, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"value\":%d}}",
+                    name.c_str(), t.thread_id, us(t.start_time), us(t.stop_time)-us(t.start_time), t.additional_value);
+          }
+
+      int timerdepth = 0;
+      for(auto & event : timer_events)
+        {
+          if(!event.is_start && timerdepth == 0)   // start dropped by the ring buffer
+            continue;
+          timerdepth += event.is_start ? 1 : -1;
+          fprintf(ctrace_stream, ",\n{\"name\":\"%s\",\"ph\":\"%s\",\"pid\":0,\"tid\":%d,\"ts\":%.3f}",
+                  JsonEscape(NgProfiler::GetName(event.timer_id)).c_str(), event.is_start ? "B" : "E", tid_timers, us(event.time));
+        }
+
+      for(auto & vlinks : links)
+        for(auto & l : vlinks)
+          fprintf(ctrace_stream, ",\n{\"name\":\"link\",\"cat\":\"link\",\"ph\":\"%s\",%s\"id\":%d,\"pid\":0,\"tid\":%d,\"ts\":%.3f}",
+                  l.is_start ? "s" : "f", l.is_start ? "" : "\"bp\":\"e\",", l.key, l.thread_id, us(l.time));
+
+      for(auto & vcounters : counters)
+        for(auto & c : vcounters)
+          {
+            string name = JsonEscape(counter_names[c.counter_id]);
+            fprintf(ctrace_stream, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":0,\"ts\":%.3f,\"args\":{\"%s\":%g}}",
+                    name.c_str(), us(c.time), name.c_str(), c.value);
+          }
+
+      fprintf(ctrace_stream, "\n]}\n");
+      fclose (ctrace_stream);
+    }
 }
 
 const char *header =
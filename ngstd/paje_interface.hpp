@@ -29,11 +29,19 @@ namespace ngstd
       NGS_DLL_HEADER static size_t max_tracefile_size;
       static bool trace_thread_counter;
       static bool trace_threads;
+      NGS_DLL_HEADER static int trace_format;
+      NGS_DLL_HEADER static bool ring_buffer;
+      static std::vector<std::string> counter_names;
 
       bool tracing_enabled;
       TTimePoint start_time;
+      std::chrono::system_clock::time_point start_wall_time;
       int nthreads;
 
+      // ring buffer mode: number of events dropped at the front
+      std::vector<int> tasks_dropped;
+      int jobs_dropped = 0;
+
     public:
 
       // Approximate number of events to trace. Tracing will
@@ -55,6 +63,18 @@ namespace ngstd
           max_tracefile_size = max_size;
         }
 
+      enum { PAJE = 0, CHROME = 1 };
+      /// PAJE (ViTE) or CHROME (chrome://tracing, Perfetto), default from NGS_TRACE_FORMAT
+      static void SetTraceFormat( int format ) { trace_format = format; }
+      static int GetTraceFormat() { return trace_format; }
+
+      /// keep only the newest events instead of stopping when the buffer is full
+      static void SetRingBuffer( bool aring_buffer ) { ring_buffer = aring_buffer; }
+
+      /// a named counter, to be set with SetCounter (e.g. scattered bytes, flops)
+      NGS_DLL_HEADER static int CreateCounter( const std::string & name );
+      static const std::string & GetCounterName( int counter_id ) { return counter_names[counter_id]; }
+
       std::string tracefile_name;
 
       struct Job
@@ -101,11 +121,19 @@ namespace ngstd
           bool operator < (const ThreadLink & other) const { return time < other.time; }
         };
 
+      struct CounterEvent
+        {
+          int counter_id;
+          TTimePoint time;
+          double value;
+        };
+
       // std::vector<std::vector<Task> > tasks;
       std::vector<ngstd::Array<Task> > tasks;
       std::vector<Job> jobs;
       std::vector<TimerEvent> timer_events;
       std::vector<std::vector<ThreadLink> > links;
+      std::vector<std::vector<CounterEvent> > counters;
 
       TTimePoint GetTime()
         {
@@ -113,6 +141,22 @@ namespace ngstd
           return TTimePoint(__rdtsc());
         }
 
+    private:
+      // buffer full: stop tracing, or drop the older half in ring buffer mode
+      template <typename TVEC>
+      bool BufferFull (TVEC & events)
+        {
+          if (!ring_buffer)
+            {
+              StopTracing();
+              return false;
+            }
+          size_t half = events.size()/2;
+          events.erase (events.begin(), events.begin()+half);
+          return true;
+        }
+      NGS_DLL_HEADER void DropTasks (int thread_id);
+
     public:
       NGS_DLL_HEADER void StopTracing();
 
@@ -123,7 +167,7 @@ namespace ngstd
         {
           if(!tracing_enabled) return;
           if(unlikely(timer_events.size() == max_num_events_per_thread))
-            StopTracing();
+            BufferFull(timer_events);
           timer_events.push_back(TimerEvent{timer_id, GetTime(), true});
         }
 
@@ -131,7 +175,7 @@ namespace ngstd
         {
           if(!tracing_enabled) return;
           if(unlikely(timer_events.size() == max_num_events_per_thread))
-            StopTracing();
+            BufferFull(timer_events);
           timer_events.push_back(TimerEvent{timer_id, GetTime(), false});
         }
 
@@ -140,21 +184,28 @@ namespace ngstd
           if(!tracing_enabled) return -1;
           if(!trace_threads && !trace_thread_counter) return -1;
 	  if(unlikely(tasks[thread_id].Size() == max_num_events_per_thread))
-            StopTracing();
+            {
+              if (ring_buffer)
+                DropTasks(thread_id);
+              else
+                StopTracing();
+            }
           int task_num = tasks[thread_id].Size();
           tasks[thread_id].Append( Task{thread_id, id, id_type, additional_value, GetTime()} );
-          return task_num;
+          return task_num + tasks_dropped[thread_id];
         }
 
       void StopTask(int thread_id, int task_num)
         {
           if(!trace_threads && !trace_thread_counter) return;
+          task_num -= tasks_dropped[thread_id];
           if(task_num>=0)
             tasks[thread_id][task_num].stop_time = GetTime();
         }
 
       void SetTask(int thread_id, int task_num, int additional_value) {
           if(!trace_threads && !trace_thread_counter) return;
+          task_num -= tasks_dropped[thread_id];
           if(task_num>=0)
             tasks[thread_id][task_num].additional_value = additional_value;
       }
@@ -163,7 +214,8 @@ namespace ngstd
         {
           if(!tracing_enabled) return;
           if(jobs.size() == max_num_events_per_thread)
-            StopTracing();
+            if (BufferFull(jobs))
+              jobs_dropped = jobs.front().job_id;
           jobs.push_back( Job{job_id, &type, GetTime()} );
         }
 
@@ -177,7 +229,7 @@ namespace ngstd
         {
           if(!tracing_enabled) return;
           if(links[thread_id].size() == max_num_events_per_thread)
-            StopTracing();
+            BufferFull(links[thread_id]);
           links[thread_id].push_back( ThreadLink{thread_id, key, GetTime(), true} );
         }
 
@@ -185,11 +237,23 @@ namespace ngstd
         {
           if(!tracing_enabled) return;
           if(links[thread_id].size() == max_num_events_per_thread)
-            StopTracing();
+            BufferFull(links[thread_id]);
           links[thread_id].push_back( ThreadLink{thread_id, key, GetTime(), false} );
         }
 
+      void SetCounter(int thread_id, int counter_id, double value)
+        {
+          if(!tracing_enabled) return;
+          if(counters[thread_id].size() == max_num_events_per_thread)
+            BufferFull(counters[thread_id]);
+          counters[thread_id].push_back( CounterEvent{counter_id, GetTime(), value} );
+        }
+
+      /// writes in the selected trace format
       void Write( std::string filename );
+      void WritePaje( std::string filename );
+      /// Chrome trace-event json, streamed to the file
+      void WriteChrome( std::string filename );
 
     };
 
@@ -5,6 +5,14 @@
 /**************************************************************************/
 
 #include <ngstd.hpp>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
 /*
 #ifdef PARALLEL
 #include <mpi.h>
@@ -31,6 +39,133 @@ namespace ngstd
   size_t dummy_thread_flops[NgProfiler::SIZE];
   size_t * NgProfiler::thread_flops = dummy_thread_flops;
 
+  bool NgProfiler::use_hw_counters = getenv("NGS_HW_COUNTERS") && atoi(getenv("NGS_HW_COUNTERS"));
+  size_t NgProfiler::hw_counters[SIZE][NUM_HW_COUNTERS];
+  size_t * NgProfiler::thread_hw_counters = nullptr;
+  double NgProfiler::peak_gflops = 0;
+  double NgProfiler::peak_gbs = 0;
+
+
+  /*
+    One perf_event group per thread (cycles is the group leader),
+    opened at the first use and read with one system call.
+  */
+  class HardwareCounterGroup
+  {
+    int fd[NgProfiler::NUM_HW_COUNTERS];
+    bool ok = false;
+  public:
+    HardwareCounterGroup ()
+    {
+      for (auto & f : fd) f = -1;
+#ifdef __linux__
+      uint64_t configs[][2] =
+        {
+          { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+          { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+          { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+          { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES }
+        };
+      for (int k = 0; k < NgProfiler::NUM_HW_COUNTERS; k++)
+        {
+          perf_event_attr attr;
+          memset (&attr, 0, sizeof(attr));
+          attr.size = sizeof(attr);
+          attr.type = configs[k][0];
+          attr.config = configs[k][1];
+          attr.disabled = (k == 0);
+          attr.exclude_kernel = 1;
+          attr.exclude_hv = 1;
+          attr.read_format = PERF_FORMAT_GROUP;
+          fd[k] = syscall (__NR_perf_event_open, &attr, 0, -1, k == 0 ? -1 : fd[0], 0);
+          if (fd[k] < 0)
+            {
+              static bool first = true;
+              if (first)
+                {
+                  first = false;
+                  cerr << "hardware counters not available (" << strerror(errno)
+                       << "), check /proc/sys/kernel/perf_event_paranoid" << endl;
+                }
+              return;
+            }
+        }
+      ioctl (fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl (fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+      ok = true;
+#endif
+    }
+
+    ~HardwareCounterGroup ()
+    {
+#ifdef __linux__
+      for (int f : fd)
+        if (f >= 0) close (f);
+#endif
+    }
+
+    bool Read (size_t * values)
+    {
+      if (!ok) return false;
+#ifdef __linux__
+      uint64_t buf[1+NgProfiler::NUM_HW_COUNTERS];
+      if (read (fd[0], buf, sizeof(buf)) != sizeof(buf))
+        return false;
+      for (int k = 0; k < NgProfiler::NUM_HW_COUNTERS; k++)
+        values[k] = buf[1+k];
+      return true;
+#else
+      return false;
+#endif
+    }
+  };
+
+  bool NgProfiler :: ReadHardwareCounters (size_t * values)
+  {
+    static thread_local HardwareCounterGroup group;
+    return group.Read (values);
+  }
+
+  void NgProfiler :: SetHardwareCounters (bool use)
+  {
+    if (task_manager)
+      cerr << "NgProfiler::SetHardwareCounters called while the TaskManager is running" << endl;
+    use_hw_counters = use;
+  }
+
+  void NgProfiler :: StartHardwareCounters (int nr)
+  {
+    size_t values[NUM_HW_COUNTERS];
+    if (ReadHardwareCounters (values))
+      for (int k = 0; k < NUM_HW_COUNTERS; k++)
+        AsAtomic(hw_counters[nr][k]) -= values[k];
+  }
+
+  void NgProfiler :: StopHardwareCounters (int nr)
+  {
+    size_t values[NUM_HW_COUNTERS];
+    if (ReadHardwareCounters (values))
+      for (int k = 0; k < NUM_HW_COUNTERS; k++)
+        AsAtomic(hw_counters[nr][k]) += values[k];
+  }
+
+  void NgProfiler :: StartThreadHardwareCounters (size_t nr, size_t tid)
+  {
+    size_t values[NUM_HW_COUNTERS];
+    if (ReadHardwareCounters (values))
+      for (int k = 0; k < NUM_HW_COUNTERS; k++)
+        thread_hw_counters[(tid*SIZE+nr)*NUM_HW_COUNTERS+k] -= values[k];
+  }
+
+  void NgProfiler :: StopThreadHardwareCounters (size_t nr, size_t tid)
+  {
+    size_t values[NUM_HW_COUNTERS];
+    if (ReadHardwareCounters (values))
+      for (int k = 0; k < NUM_HW_COUNTERS; k++)
+        thread_hw_counters[(tid*SIZE+nr)*NUM_HW_COUNTERS+k] += values[k];
+  }
+
   NgProfiler :: NgProfiler()
   {
     for (int i = 0; i < SIZE; i++)
@@ -131,6 +266,19 @@ namespace ngstd
 	    fprintf(prof,", MLoads = %6.2f",loads[i] / (double(tottimes[i])*fac) * 1e-6);
 	  if(stores[i])
 	    fprintf(prof,", MStores = %6.2f",stores[i] / (double(tottimes[i])*fac) * 1e-6);
+          if(flops[i] && (loads[i]+stores[i]))
+            fprintf(prof,", flop/byte = %6.3f",flops[i] / (loads[i]+stores[i]));
+          if(RooflineFraction(i))
+            fprintf(prof,", roofline = %5.1f%% (%s bound)",100*RooflineFraction(i),
+                    flops[i] < (loads[i]+stores[i]) * peak_gflops / peak_gbs ? "memory" : "compute");
+          if(hw_counters[i][HW_CYCLES])
+            {
+              auto hw = hw_counters[i];
+              // memory traffic estimated from last level cache misses of 64 byte lines
+              fprintf(prof,", IPC = %4.2f, L1D misses = %8.3g, LLC misses = %8.3g, LLC GB/s = %6.2f",
+                      double(hw[HW_INSTRUCTIONS])/hw[HW_CYCLES], double(hw[HW_L1D_MISSES]), double(hw[HW_LLC_MISSES]),
+                      64.0*hw[HW_LLC_MISSES] / (double(tottimes[i])*fac) * 1e-9);
+            }
 	  if(usedcounter[i])
 	    fprintf(prof," %s",names[i].c_str());
 	  fprintf(prof,"\n");
@@ -138,6 +286,61 @@ namespace ngstd
   }
 
 
+  void NgProfiler :: MeasureRoofline ()
+  {
+    int nthreads = task_manager ? TaskManager::GetNumThreads() : 1;
+    
+    // independent FMA chains on every thread
+    constexpr int NACC = 12;
+    constexpr size_t steps = 100000;
+    double tflops = RunTiming([&]()
+      {
+        ParallelJob ([&] (const TaskInfo & ti)
+          {
+            SIMD<double> acc[NACC];
+            for (int k = 0; k < NACC; k++)
+              acc[k] = SIMD<double>(1e-3*k);
+            SIMD<double> a(0.999999), b(1e-9);
+            for (size_t i = 0; i < steps; i++)
+              for (int k = 0; k < NACC; k++)
+                acc[k] = FMA(a, acc[k], b);
+            SIMD<double> sum(0.0);
+            for (int k = 0; k < NACC; k++)
+              sum += acc[k];
+            if (HSum(sum) == 42.0) cout << "";   // keep the loop
+          }, nthreads);
+      }, 0.2, 3);
+    double gflops = 2.0 * NACC * SIMD<double>::Size() * steps * nthreads / tflops * 1e-9;
+
+    // STREAM triad, every thread initializes its own part (first touch)
+    size_t n = size_t(1) << 25;
+    Array<double> a(n), b(n), c(n);
+    ParallelForRange (n, [&] (IntRange r)
+                      { for (auto i : r) { a[i] = 0; b[i] = 1; c[i] = 2; } });
+    double tstream = RunTiming([&]()
+      {
+        ParallelForRange (n, [&] (IntRange r)
+                          { for (auto i : r) a[i] = b[i] + 3.0 * c[i]; });
+      }, 0.5, 3);
+    double gbs = 3.0 * sizeof(double) * n / tstream * 1e-9;
+
+    SetRoofline (gflops, gbs);
+    cout << IM(3) << "roofline: peak " << gflops << " GFlop/s, " << gbs << " GB/s, "
+         << nthreads << " threads" << endl;
+  }
+
+  double NgProfiler :: RooflineFraction (int nr)
+  {
+    double bytes = loads[nr] + stores[nr];
+    double time = GetTime(nr);
+    if (peak_gflops == 0 || flops[nr] == 0 || time == 0)
+      return 0;
+    // without byte counts the kernel is taken as compute bound
+    double attainable = bytes ? min2 (peak_gflops, flops[nr]/bytes * peak_gbs) : peak_gflops;
+    return flops[nr] / time * 1e-9 / attainable;
+  }
+
+
   int NgProfiler :: CreateTimer (const string & name)
   {
     static mutex createtimer_mutex;
@@ -166,18 +369,68 @@ namespace ngstd
 
   void NgProfiler :: Reset () 
   {
-      for(int i=0; i<SIZE; i++) {
-          tottimes[i] = 0;
-          counts[i] = 0;
-          flops[i] = 0;
-          loads[i] = 0;
-          stores[i] = 0;
-      }
+      for(int i=0; i<SIZE; i++)
+        Reset (i);
+#ifdef PARALLEL
+      MPIStatistics::Get().Reset();
+#endif
+  }
+
+  void NgProfiler :: Reset (int nr)
+  {
+    tottimes[nr] = 0;
+    counts[nr] = 0;
+    flops[nr] = 0;
+    loads[nr] = 0;
+    stores[nr] = 0;
+    for (auto & hw : hw_counters[nr])
+      hw = 0;
   }
 
   NgProfiler prof;
 
 
+#ifdef PARALLEL
+  void MyMPI_PrintStatistics (ostream & ost, MPI_Comm comm)
+  {
+    constexpr int NOPS = MPIStatistics::NUM_OPS;
+    auto & stat = MPIStatistics::Get();
+
+    // time, calls, bytes per operation
+    double local[3*NOPS], vmin[3*NOPS], vsum[3*NOPS], vmax[3*NOPS];
+    struct { double val; int rank; } tloc[NOPS], tmax[NOPS];
+    int rank = MyMPI_GetId (comm);
+    for (int i = 0; i < NOPS; i++)
+      {
+        Timer & t = stat.GetTimer (MPIStatistics::OP(i));
+        local[3*i] = t.GetTime();
+        local[3*i+1] = t.GetCounts();
+        local[3*i+2] = stat.GetBytes (MPIStatistics::OP(i));
+        tloc[i].val = local[3*i];
+        tloc[i].rank = rank;
+      }
+    MPI_Reduce (local, vmin, 3*NOPS, MPI_DOUBLE, MPI_MIN, 0, comm);
+    MPI_Reduce (local, vsum, 3*NOPS, MPI_DOUBLE, MPI_SUM, 0, comm);
+    MPI_Reduce (local, vmax, 3*NOPS, MPI_DOUBLE, MPI_MAX, 0, comm);
+    MPI_Reduce (tloc, tmax, NOPS, MPI_DOUBLE_INT, MPI_MAXLOC, 0, comm);
+    if (rank != 0) return;
+
+    int ntasks = MyMPI_GetNTasks (comm);
+    ost << "MPI statistics of " << ntasks << " ranks, min / avg / max" << endl;
+    for (int i = 0; i < NOPS; i++)
+      {
+        if (vmax[3*i+1] == 0) continue;
+        ost << setw(16) << left << MPIStatistics::GetName (MPIStatistics::OP(i)) << right
+            << " time " << vmin[3*i] << " / " << vsum[3*i]/ntasks << " / " << vmax[3*i]
+            << " s (max on rank " << tmax[i].rank << ")"
+            << ", calls " << vmin[3*i+1] << " / " << vsum[3*i+1]/ntasks << " / " << vmax[3*i+1]
+            << ", MB " << 1e-6*vmin[3*i+2] << " / " << 1e-6*vsum[3*i+2]/ntasks
+            << " / " << 1e-6*vmax[3*i+2] << endl;
+      }
+  }
+#endif
+
+
 
 #ifdef  VTRACE
 #ifdef PARALLEL
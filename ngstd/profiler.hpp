@@ -76,6 +76,7 @@ namespace ngstd
 
     NGS_DLL_HEADER static long int counts[SIZE];
     NGS_DLL_HEADER static double flops[SIZE];
+    /// bytes read and written
     NGS_DLL_HEADER static double loads[SIZE];
     NGS_DLL_HEADER static double stores[SIZE];
     NGS_DLL_HEADER static string names[SIZE];
@@ -83,6 +84,17 @@ namespace ngstd
 
     NGS_DLL_HEADER static size_t * thread_times;
     NGS_DLL_HEADER static size_t * thread_flops;
+
+    /// hardware counters (Linux perf_event), enabled by NGS_HW_COUNTERS=1
+    enum { HW_CYCLES, HW_INSTRUCTIONS, HW_L1D_MISSES, HW_LLC_MISSES, NUM_HW_COUNTERS };
+    NGS_DLL_HEADER static bool use_hw_counters;
+    NGS_DLL_HEADER static size_t hw_counters[SIZE][NUM_HW_COUNTERS];
+    /// per thread counters of thread timers, allocated by the TaskManager if enabled
+    NGS_DLL_HEADER static size_t * thread_hw_counters;
+
+    /// machine peak for the roofline report, zero if not set
+    NGS_DLL_HEADER static double peak_gflops;
+    NGS_DLL_HEADER static double peak_gbs;
   private:
 
     // int total_timer;
@@ -99,6 +111,25 @@ namespace ngstd
     NGS_DLL_HEADER static int CreateTimer (const string & name);
 
     NGS_DLL_HEADER static void Reset ();
+    /// reset time, counts, flops and hardware counters of one timer
+    NGS_DLL_HEADER static void Reset (int nr);
+
+    /// must not be changed while the TaskManager is running
+    NGS_DLL_HEADER static void SetHardwareCounters (bool use);
+    static bool GetHardwareCounters () { return use_hw_counters; }
+    /// current counter values of the calling thread, false if not available
+    NGS_DLL_HEADER static bool ReadHardwareCounters (size_t * values);
+    NGS_DLL_HEADER static void StartHardwareCounters (int nr);
+    NGS_DLL_HEADER static void StopHardwareCounters (int nr);
+    NGS_DLL_HEADER static void StartThreadHardwareCounters (size_t nr, size_t tid);
+    NGS_DLL_HEADER static void StopThreadHardwareCounters (size_t nr, size_t tid);
+
+    /// peak flop rate and memory bandwidth used by the roofline report
+    static void SetRoofline (double agflops, double agbs) { peak_gflops = agflops; peak_gbs = agbs; }
+    /// measures FMA throughput and STREAM triad bandwidth of all threads, and sets them
+    NGS_DLL_HEADER static void MeasureRoofline ();
+    /// fraction of the attainable rate min(peak, intensity*bandwidth), 0 if unknown
+    NGS_DLL_HEADER static double RooflineFraction (int nr);
 
 
 #ifndef NOPROFILE
@@ -114,6 +145,7 @@ namespace ngstd
       AsAtomic(tottimes[nr]) += -(time.tv_sec + 1e-6 * time.tv_usec);
       // #pragma omp atomic
       AsAtomic(counts[nr])++; 
+      if (unlikely(use_hw_counters)) StartHardwareCounters (nr);
       VT_USER_START (const_cast<char*> (names[nr].c_str())); 
     }
 
@@ -124,17 +156,20 @@ namespace ngstd
       // tottimes[nr] += time.tv_sec + 1e-6 * time.tv_usec - starttimes[nr];
       // #pragma omp atomic
       AsAtomic(tottimes[nr]) += time.tv_sec + 1e-6 * time.tv_usec;
+      if (unlikely(use_hw_counters)) StopHardwareCounters (nr);
       VT_USER_END (const_cast<char*> (names[nr].c_str())); 
     }
 
     static void StartThreadTimer (size_t nr, size_t tid)
     {
       thread_times[tid*SIZE+nr] -= __rdtsc();
+      if (unlikely(thread_hw_counters != nullptr)) StartThreadHardwareCounters (nr, tid);
     }
 
     static void StopThreadTimer (size_t nr, size_t tid)
     {
       thread_times[tid*SIZE+nr] += __rdtsc();
+      if (unlikely(thread_hw_counters != nullptr)) StopThreadHardwareCounters (nr, tid);
     }
 
     static void AddThreadFlops (size_t nr, size_t tid, size_t flops)
@@ -148,6 +183,7 @@ namespace ngstd
     static void StartTimer (int nr) 
     {
       starttimes[nr] = clock(); counts[nr]++; 
+      if (unlikely(use_hw_counters)) StartHardwareCounters (nr);
       VT_USER_START (const_cast<char*> (names[nr].c_str())); 
     }
 
@@ -155,17 +191,20 @@ namespace ngstd
     static void StopTimer (int nr) 
     { 
       tottimes[nr] += clock()-starttimes[nr]; 
+      if (unlikely(use_hw_counters)) StopHardwareCounters (nr);
       VT_USER_END (const_cast<char*> (names[nr].c_str())); 
     }
 
     static void StartThreadTimer (size_t nr, size_t tid)
     {
       thread_times[tid*SIZE+nr] -= __rdtsc();
+      if (unlikely(thread_hw_counters != nullptr)) StartThreadHardwareCounters (nr, tid);
     }
 
     static void StopThreadTimer (size_t nr, size_t tid)
     {
       thread_times[tid*SIZE+nr] += __rdtsc();
+      if (unlikely(thread_hw_counters != nullptr)) StopThreadHardwareCounters (nr, tid);
     }
 
     static void AddThreadFlops (size_t nr, size_t tid, size_t flops)
@@ -225,6 +264,9 @@ namespace ngstd
       return flops[nr];
     }
 
+    static double GetLoads (int nr) { return loads[nr]; }
+    static double GetStores (int nr) { return stores[nr]; }
+
     /// change name
     static void SetName (int nr, const string & name) { names[nr] = name; }
     static string GetName (int nr) { return names[nr]; }
@@ -284,6 +326,18 @@ namespace ngstd
       if (priority <= 2)
 	NgProfiler::AddFlops (timernr, aflops);
     }
+    /// bytes read from memory
+    void AddLoads (double aloads)
+    {
+      if (priority <= 2)
+	NgProfiler::AddLoads (timernr, aloads);
+    }
+    /// bytes written to memory
+    void AddStores (double astores)
+    {
+      if (priority <= 2)
+	NgProfiler::AddStores (timernr, astores);
+    }
 
     double GetTime () { return NgProfiler::GetTime(timernr); }
     long int GetCounts () { return NgProfiler::GetCounts(timernr); }
@@ -411,6 +465,8 @@ namespace ngstd
     }
     void SetName (const string & /* st */) { ; }
     void AddFlops (double aflops)  { ; }
+    void AddLoads (double aloads)  { ; }
+    void AddStores (double astores)  { ; }
     double GetTime () { return 0; }
     long int GetCounts () { return 0; }
     operator int () { return timer_id; }
@@ -453,6 +509,8 @@ namespace ngstd
 
     void SetName (const string & st) { ; }
     void AddFlops (double aflops)  { ; }
+    void AddLoads (double aloads)  { ; }
+    void AddStores (double astores)  { ; }
     double GetTime () { return 0; }
     long int GetCounts () { return 0; }
   };
@@ -186,6 +186,17 @@ void NGS_DLL_HEADER  ExportNgstd(py::module & m) {
     .def("SetTraceThreads", &PajeTrace::SetTraceThreads)
     .def("SetTraceThreadCounter", &PajeTrace::SetTraceThreadCounter)
     .def("SetMaxTracefileSize", &PajeTrace::SetMaxTracefileSize)
+    .def_static("SetTraceFormat", [] (string format)
+                {
+                  if (format == "chrome")
+                    PajeTrace::SetTraceFormat(PajeTrace::CHROME);
+                  else if (format == "paje")
+                    PajeTrace::SetTraceFormat(PajeTrace::PAJE);
+                  else
+                    throw Exception("unknown trace format '"+format+"', use 'paje' or 'chrome'");
+                }, "format"_a, "'paje' (ViTE) or 'chrome' (chrome://tracing, Perfetto)")
+    .def_static("SetRingBuffer", &PajeTrace::SetRingBuffer, "ringbuffer"_a,
+                "keep the newest events instead of stopping when the trace buffer is full")
     ;
 
 
@@ -240,6 +251,11 @@ void NGS_DLL_HEADER  ExportNgstd(py::module & m) {
   
   py::class_<ngstd::LocalHeap> (m, "LocalHeap", "A heap for fast memory allocation")
      .def(py::init<size_t,const char*>(), "size"_a=1000000, "name"_a="PyLocalHeap")
+    .def_static("SetGrowOnOverflow", &LocalHeap::SetGrowOnOverflow, "grow"_a,
+                "chain a new block on overflow instead of throwing LocalHeapOverflow")
+    .def_static("GetHighWaterMark", &LocalHeap::GetHighWaterMark,
+                "maximal memory used by one LocalHeap (or one thread's piece) so far")
+    .def_static("ResetHighWaterMark", &LocalHeap::ResetHighWaterMark)
     ;
 
   py::class_<ngstd::HeapReset>
@@ -324,6 +340,20 @@ void NGS_DLL_HEADER  ExportNgstd(py::module & m) {
                                      else
                                        throw py::value_error();
                                    }, py::arg("i") = DummyArgument(), "Clear bit at given position")
+    .def("AndNot", [] (BitArray & self, const BitArray & other) -> BitArray&
+         {
+           if (other.Size() != self.Size())
+             throw py::value_error();
+           return self.AndNot(other);
+         }, py::arg("ba"), py::return_value_policy::reference_internal,
+         "Clear all bits which are set in ba")
+    .def("SetBits", [] (BitArray & self)
+         {
+           py::list res;
+           for (size_t i : self.SetBits())
+             res.append(i);
+           return res;
+         }, "Return list of indices of set bits")
 
 
     .def(py::self | py::self)
@@ -409,30 +439,240 @@ void NGS_DLL_HEADER  ExportNgstd(py::module & m) {
       py::keep_alive<0,1>()
     );
 
-  py::class_<Timer> (m, "Timer")
-    .def(py::init<const string&>())
+  py::class_<Timer> (m, "Timer", docu_string(R"raw_string(
+Timer of the profiler, shows up in Timers() by its name. Use it as
+context manager:  with Timer("my step"): ...
+
+Parameters:
+
+name : string
+  name of the timer, timers with the same name share the entry
+
+priority : int
+  timers with priority > 2 are disabled, start and stop do nothing
+)raw_string"))
+    .def(py::init<const string&, int>(), "name"_a, "priority"_a=1)
     .def("Start", &Timer::Start, "start timer")
     .def("Stop", &Timer::Stop, "stop timer")
+    .def("__enter__", [] (Timer & self) -> Timer& { self.Start(); return self; },
+         py::return_value_policy::reference)
+    .def("__exit__", [] (Timer & self, py::object, py::object, py::object) { self.Stop(); })
+    .def("AddFlops", &Timer::AddFlops, "flops"_a, "count flops for the Gflop/s of the timer")
+    .def("AddLoads", &Timer::AddLoads, "bytes"_a, "count bytes read, for GB/s and the roofline")
+    .def("AddStores", &Timer::AddStores, "bytes"_a, "count bytes written, for GB/s and the roofline")
+    .def("Reset", [] (Timer & self) { NgProfiler::Reset (int(self)); },
+         "reset time, counts and flops of this timer")
+    .def_property_readonly("nr", [] (Timer & self) { return int(self); })
+    .def_property_readonly("time", &Timer::GetTime, "accumulated time in seconds")
+    .def_property_readonly("counts", &Timer::GetCounts, "number of starts")
+    .def_property_readonly("flops", [] (Timer & self) { return NgProfiler::GetFlops (int(self)); })
+    .def_property_readonly("loads", [] (Timer & self) { return NgProfiler::GetLoads (int(self)); })
+    .def_property_readonly("stores", [] (Timer & self) { return NgProfiler::GetStores (int(self)); })
     ;
   
+  m.def("SetHardwareCounters", [](bool use) { NgProfiler::SetHardwareCounters(use); }, "use"_a,
+        "record cycles, instructions and cache misses in the timers (Linux perf_event)");
+
+  m.def("ResetTimers", [] () { NgProfiler::Reset(); }, "reset all timers");
+
+  m.def("SetRoofline", [](double gflops, double gbs)
+        {
+          if (gflops == 0 && gbs == 0)
+            {
+              py::gil_scoped_release release;
+              NgProfiler::MeasureRoofline();
+            }
+          else
+            NgProfiler::SetRoofline (gflops, gbs);
+          return py::make_tuple (NgProfiler::peak_gflops, NgProfiler::peak_gbs);
+        }, "gflops"_a=0, "gbs"_a=0, docu_string(R"raw_string(
+Sets the peak flop rate and memory bandwidth for the roofline data of
+Timers() and of the profile printout. Without arguments both are
+measured (FMA throughput and STREAM triad) with the threads of the
+running TaskManager. Returns (GFlop/s, GB/s).
+)raw_string"));
+
   m.def("Timers",
-	  []() 
+	  [](py::object since, bool used_only)
 	   {
+             // values of a previous Timers() call, by timer number
+             std::map<int, py::dict> old;
+             if (!since.is_none())
+               for (auto item : py::cast<py::list> (since))
+                 {
+                   py::dict d = py::cast<py::dict> (item);
+                   old[py::cast<int> (d["nr"])] = d;
+                 }
+             auto diff = [&] (int nr, const char * key, auto value)
+               {
+                 auto it = old.find(nr);
+                 if (it == old.end() || !it->second.contains(key)) return value;
+                 return value - py::cast<decltype(value)> (it->second[key]);
+               };
+
 	     py::list timers;
 	     for (int i = 0; i < NgProfiler::SIZE; i++)
 	       if (!NgProfiler::names[i].empty())
                {
+                 long int counts = diff(i, "counts", NgProfiler::GetCounts(i));
+                 if (used_only && counts == 0) continue;
+                 double time = diff(i, "time", NgProfiler::GetTime(i));
+                 long int flops = diff(i, "flops", NgProfiler::GetFlops(i));
+                 double loads = diff(i, "loads", NgProfiler::GetLoads(i));
+                 double stores = diff(i, "stores", NgProfiler::GetStores(i));
                  py::dict timer;
+                 timer["nr"] = py::int_(i);
                  timer["name"] = py::str(NgProfiler::names[i]);
-                 timer["time"] = py::float_(NgProfiler::GetTime(i));
-                 timer["counts"] = py::int_(NgProfiler::GetCounts(i));
-                 timer["flops"] = py::int_(NgProfiler::GetFlops(i));
-                 timer["Gflop/s"] = py::float_(NgProfiler::GetFlops(i)/NgProfiler::GetTime(i)*1e-9);
+                 timer["time"] = py::float_(time);
+                 timer["counts"] = py::int_(counts);
+                 timer["flops"] = py::int_(flops);
+                 timer["Gflop/s"] = py::float_(time > 0 ? flops/time*1e-9 : 0.0);
+                 timer["loads"] = py::float_(loads);
+                 timer["stores"] = py::float_(stores);
+                 timer["GB/s"] = py::float_(time > 0 ? (loads+stores)/time*1e-9 : 0.0);
+                 if (NgProfiler::peak_gflops > 0 && flops > 0 && time > 0)
+                   {
+                     // without byte counts the kernel is taken as compute bound
+                     bool membound = flops < (loads+stores) * NgProfiler::peak_gflops / NgProfiler::peak_gbs;
+                     double attainable = membound ? flops / (loads+stores) * NgProfiler::peak_gbs
+                       : NgProfiler::peak_gflops;
+                     if (loads+stores > 0)
+                       timer["flop/byte"] = py::float_(flops / (loads+stores));
+                     timer["roofline"] = py::float_(flops/time*1e-9 / attainable);
+                     timer["bound"] = py::str(membound ? "memory" : "compute");
+                   }
+                 if (NgProfiler::hw_counters[i][NgProfiler::HW_CYCLES])
+                   {
+                     auto hw = NgProfiler::hw_counters[i];
+                     timer["cycles"] = py::int_(diff(i, "cycles", hw[NgProfiler::HW_CYCLES]));
+                     timer["instructions"] = py::int_(diff(i, "instructions", hw[NgProfiler::HW_INSTRUCTIONS]));
+                     timer["L1D misses"] = py::int_(diff(i, "L1D misses", hw[NgProfiler::HW_L1D_MISSES]));
+                     timer["LLC misses"] = py::int_(diff(i, "LLC misses", hw[NgProfiler::HW_LLC_MISSES]));
+                   }
                  timers.append(timer);
                }
 	     return timers;
-	   }, "Returns list of timers"
-	   );
+	   }, "since"_a=py::none(), "used_only"_a=false, docu_string(R"raw_string(
+Returns list of timers, as dicts with name, time, counts, flops, bytes
+loaded and stored, and the hardware counters if enabled. After
+SetRoofline the timers with flops and bytes also get their arithmetic
+intensity, the fraction of the attainable roofline rate and whether
+they are memory or compute bound.
+
+since : list
+  the result of an earlier Timers() call, the values are the differences
+  to it, e.g. for the statistics of one time step
+
+used_only : bool
+  only timers started at least once (since the snapshot)
+)raw_string"));
+
+  m.def("MemoryRegistry", [] (bool reset_peaks)
+        {
+          py::dict res;
+          for (int i = 0; i < MemoryRegistry::NCATEGORIES; i++)
+            {
+              auto cat = MemoryRegistry::CATEGORY(i);
+              py::dict entry;
+              entry["current"] = MemoryRegistry::Current(cat);
+              entry["peak"] = MemoryRegistry::Peak(cat);
+              res[MemoryRegistry::Name(cat)] = entry;
+            }
+          py::dict total;
+          total["current"] = MemoryRegistry::Current();
+          total["peak"] = MemoryRegistry::Peak();
+          res["total"] = total;
+          if (reset_peaks)
+            MemoryRegistry::ResetPeaks();
+          return res;
+        }, "reset_peaks"_a=false, docu_string(R"raw_string(
+Returns the registered memory as dict category -> {current, peak}, in
+bytes. Categories are matrix values, matrix graph, factors, heaps,
+vectors, preconditioner, pool (blocks waiting in the MemoryPool) and
+other, plus the total.
+
+reset_peaks : bool
+  afterwards the peaks start again from the current values, e.g. for
+  the memory of one solve
+)raw_string"));
+
+  m.def("MemoryPool", [] (bool reset)
+        {
+          auto stats = MemoryPool::GetStatistics();
+          py::dict res;
+          res["allocs"] = stats.allocs;
+          res["reused"] = stats.reused;
+          res["reused_same"] = stats.reused_same;
+          res["released"] = stats.released;
+          res["cached_blocks"] = stats.cached_blocks;
+          res["cached_bytes"] = stats.cached_bytes;
+          res["max_cached"] = MemoryPool::GetMaxCached();
+          if (reset)
+            MemoryPool::ResetStatistics();
+          return res;
+        }, "reset"_a=false, docu_string(R"raw_string(
+Statistics of the pool recycling the storage of vectors, as dict:
+
+allocs         allocations of pooled size (at least 32 kB)
+reused         ... served by a waiting block, no new allocation
+reused_same    ... by a block of the same size, with the same page placement
+released       blocks given back to the system
+cached_blocks, cached_bytes
+               blocks waiting for reuse
+max_cached     limit of the waiting bytes
+
+reset : bool
+  afterwards the counters start from zero
+)raw_string"));
+
+  m.def("SetMemoryPool", [] (size_t max_cached) { MemoryPool::SetMaxCached(max_cached); },
+        "max_cached"_a, "bytes of freed vector storage kept for reuse at most, 0 disables the pool (default 1 GB)");
+  m.def("ClearMemoryPool", [] () { MemoryPool::Clear(); },
+        "give the vector storage waiting for reuse back to the system");
+
+  m.def("PrintMemoryRegistry", [] () { MemoryRegistry::Print(cout); },
+        "print the registered memory by category");
+  m.def("SetPrintMemoryOnOutOfMemory", [] (bool print) { MemoryRegistry::SetPrintOnOutOfMemory(print); },
+        "print"_a, "print the registered memory to cerr if an allocation fails (default on)");
+
+  py::class_<EventLog, shared_ptr<EventLog>> (m, "EventLog", docu_string(R"raw_string(
+Structured event log, one JSON object per line. Records are buffered and
+written by a background thread. Activated by SetEventLog, the solvers
+write their iterations and a summary of every solve.
+
+Parameters:
+
+filename : string
+  output file, with MPI '_rank' is appended
+
+flushsize : int
+  buffered bytes before the buffer is handed to the writer
+)raw_string"))
+    .def(py::init<string, size_t>(), "filename"_a, "flushsize"_a = 1 << 16)
+    .def("Write", [] (EventLog & self, string event, py::kwargs kwargs)
+         {
+           auto rec = self.Event (event);
+           for (auto item : kwargs)
+             {
+               string key = py::cast<string> (item.first);
+               if (py::isinstance<py::str> (item.second))
+                 rec (key, py::cast<string> (item.second));
+               else
+                 rec (key, py::cast<double> (item.second));
+             }
+         }, "event"_a, "write a record with the keyword arguments as values (numbers or strings)")
+    .def("LogTimers", &EventLog::LogTimers, "write all used timers")
+    .def("LogMPIStatistics", &EventLog::LogMPIStatistics, "write time, calls and bytes of MPI operations")
+    .def("Flush", [] (EventLog & self)
+         {
+           py::gil_scoped_release release;
+           self.Flush();
+         }, "write the buffered records and wait for the writer")
+    .def_property_readonly("filename", &EventLog::GetFileName)
+    ;
+
+  m.def("SetEventLog", [] (shared_ptr<EventLog> log) { EventLog::SetActive (log); },
+        "log"_a, "make log the event log of the library, None switches logging off");
 
   py::class_<Archive, shared_ptr<Archive>> (m, "Archive")
       /*
@@ -454,8 +694,14 @@ void NGS_DLL_HEADER  ExportNgstd(py::module & m) {
                            })
       */
       .def(py::init<> ([](const string & filename, bool write,
-                          bool binary) -> shared_ptr<Archive>
+                          bool binary, bool mapped, bool zero_copy) -> shared_ptr<Archive>
                        {
+                         if(mapped) {
+                           if (write)
+                             return make_shared<MappedOutArchive> (filename);
+                           else
+                             return make_shared<MappedInArchive> (filename, zero_copy);
+                         }
                          if(binary) {
                            if (write)
                              return make_shared<BinaryOutArchive> (filename);
@@ -468,7 +714,10 @@ void NGS_DLL_HEADER  ExportNgstd(py::module & m) {
                            else
                              return make_shared<TextInArchive> (filename);
                          }
-                       }), py::arg("filename"), py::arg("write"), py::arg("binary"))
+                       }), py::arg("filename"), py::arg("write"), py::arg("binary"),
+           py::arg("mapped")=false, py::arg("zero_copy")=false,
+           "mapped: aligned binary blocks, read from a memory mapping of the file\n"
+           "zero_copy: arrays refer to the mapping, keep the archive alive while they are used")
     .def("__and__" , [](shared_ptr<Archive> & self, Array<int> & a) 
                                          { cout << "output array" << endl;
                                            *self & a; return self; }, py::arg("array"))
@@ -498,6 +747,76 @@ threads : int
 
 )raw_string") );
 
+  m.def("SetWorkStealing", &TaskManager::SetWorkStealing, py::arg("enable"), docu_string(R"raw_string(
+Switch the TaskManager between the shared task counter (default)
+and per-thread task deques with randomized work stealing
+
+Parameters:
+
+enable : bool
+  use work stealing for the following parallel jobs
+
+)raw_string") );
+
+  m.def("SetPinThreads", &TaskManager::SetPinThreads, py::arg("pin"), docu_string(R"raw_string(
+Bind the threads of the TaskManager to cores, filling one NUMA
+node after the other. Takes effect when the TaskManager is started.
+
+Parameters:
+
+pin : bool
+  pin the threads
+
+)raw_string") );
+
+  m.def("SetJobStatistics", &TaskManager::SetJobStatistics, py::arg("enable"), docu_string(R"raw_string(
+Record time, idle time per thread and number of tasks of the parallel
+jobs (ParallelFor, ParallelJob, ...), by call site and number of
+threads. With NGS_JOB_STATISTICS=1 they are on from the start and
+printed at exit.
+
+Parameters:
+
+enable : bool
+  record the following parallel jobs
+
+)raw_string") );
+
+  m.def("JobStatistics", [] (bool reset)
+        {
+          py::list res;
+          for (auto & stat : TaskManager::CollectJobStatistics(reset))
+            {
+              py::dict d;
+              d["name"] = stat.name;
+              d["threads"] = stat.nthreads;
+              d["calls"] = stat.calls;
+              d["tasks"] = stat.tasks;
+              d["time"] = stat.time;
+              d["busy"] = stat.busy;
+              py::list idle;
+              for (double t : stat.idle)
+                idle.append (t);
+              d["idle"] = idle;
+              d["efficiency"] = stat.Efficiency();
+              d["imbalance"] = stat.Imbalance();
+              res.append (d);
+            }
+          return res;
+        }, "reset"_a=false, docu_string(R"raw_string(
+Returns the statistics recorded since SetJobStatistics(True), as list of
+dicts, the most expensive call site first. 'time' is the wall time of
+the jobs, 'busy' the time in tasks summed over the threads, 'idle' the
+time without task per thread, 'efficiency' is busy/(threads*time) and
+'imbalance' the busiest thread over the average thread.
+
+reset : bool
+  clear the statistics afterwards
+)raw_string"));
+
+  m.def("PrintJobStatistics", [] () { TaskManager::PrintJobStatistics (cout); },
+        "print the recorded statistics of the parallel jobs");
+
   // local TaskManager class to be used as context manager in Python
   class ParallelContextManager {
       int num_threads;
@@ -546,6 +865,21 @@ threads : int
           unpickler.attr("append")(MemoryView(mem,size));
         }, py::arg("unpickler"));
   py::class_<MemoryView>(m, "_MemoryView");
+  // pickle protocol 5: the memory is handed out as buffer, without copying
+  m.def("_MemoryViewBuffer", [](MemoryView& view)
+        {
+          py::buffer_info bi((char*) view.Ptr(), view.Size());
+          return py::memoryview(bi);
+        }, py::arg("view"));
+  m.def("_MemoryViewFromBuffer", [](py::buffer buffer)
+        {
+          py::buffer_info bi = buffer.request();
+          size_t size = bi.size * bi.itemsize;
+          char* mem = new char[size];
+          if (size)
+            memcpy(mem, bi.ptr, size);
+          return MemoryView(mem, size);
+        }, py::arg("buffer"));
 
   
   py::class_<PyMPI_Comm> (m, "MPI_Comm")
@@ -554,6 +888,8 @@ threads : int
     .def("Barrier", [](PyMPI_Comm c) { MyMPI_Barrier(c.comm); })
 #ifdef PARALLEL
     .def("WTime", [](PyMPI_Comm c) { return MPI_Wtime(); })
+    .def("PrintStatistics", [](PyMPI_Comm c) { MyMPI_PrintStatistics (cout, c.comm); },
+         "prints time, calls and bytes of the MPI operations, min/avg/max over the ranks (collective)")
 #endif
     .def("Sum", [](PyMPI_Comm c, double x) { return MyMPI_AllReduce(x, MPI_SUM, c.comm); })
     .def("Min", [](PyMPI_Comm c, double x) { return MyMPI_AllReduce(x, MPI_MIN, c.comm); })
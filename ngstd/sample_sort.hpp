@@ -100,6 +100,171 @@ void SampleSortI(FlatArray<T> data, FlatArray<TI> index)
 }
 
 
+
+
+
+  /*
+    Parallel LSD radix sort on unsigned keys, 8 bit digits, stable.
+    Digits in which all keys agree are skipped.
+    vals are moved with the keys (vals may be empty).
+  */
+  template <typename TU, typename TVAL>
+  void RadixSortUnsigned (FlatArray<TU> keys, FlatArray<TVAL> vals)
+  {
+    static_assert (std::is_unsigned<TU>::value, "RadixSortUnsigned needs unsigned keys");
+    size_t n = keys.Size();
+    bool with_vals = vals.Size() > 0;
+    if (with_vals && vals.Size() != n)
+      throw Exception ("RadixSort: keys and values of different size");
+    if (n < 2) return;
+
+    if (n < 64)
+      { // stable insertion sort
+        for (size_t i = 1; i < n; i++)
+          for (size_t j = i; j > 0 && keys[j] < keys[j-1]; j--)
+            {
+              Swap (keys[j], keys[j-1]);
+              if (with_vals) Swap (vals[j], vals[j-1]);
+            }
+        return;
+      }
+
+    int ntasks = max2 (1, min2 (TaskManager::GetNumThreads(), int(n / 16384)));
+    auto task_range = [n, ntasks] (int k) { return Range(n).Split (k, ntasks); };
+
+    TU first = keys[0];
+    Array<TU> diffs(ntasks);
+    ParallelJob ([&] (TaskInfo & ti)
+                 {
+                   TU diff = 0;
+                   for (auto i : task_range(ti.task_nr))
+                     diff |= keys[i] ^ first;
+                   diffs[ti.task_nr] = diff;
+                 }, ntasks);
+    TU diff = 0;
+    for (auto d : diffs) diff |= d;
+
+    Array<TU> keys2(n);
+    Array<TVAL> vals2(with_vals ? n : 0);
+    TU * src = keys.Addr(0), * dst = keys2.Addr(0);
+    TVAL * srcv = with_vals ? vals.Addr(0) : nullptr;
+    TVAL * dstv = with_vals ? vals2.Addr(0) : nullptr;
+    Array<size_t> offsets(256*ntasks);
+
+    for (int shift = 0; shift < int(8*sizeof(TU)); shift += 8)
+      {
+        if (((diff >> shift) & 255) == 0) continue;
+
+        ParallelJob ([&] (TaskInfo & ti)
+                     {
+                       auto myoffsets = offsets.Range(256*ti.task_nr, 256*(ti.task_nr+1));
+                       myoffsets = 0;
+                       for (auto i : task_range(ti.task_nr))
+                         myoffsets[(src[i] >> shift) & 255]++;
+                     }, ntasks);
+
+        size_t sum = 0;
+        for (int d = 0; d < 256; d++)
+          for (int k = 0; k < ntasks; k++)
+            {
+              size_t cnt = offsets[256*k+d];
+              offsets[256*k+d] = sum;
+              sum += cnt;
+            }
+
+        ParallelJob ([&] (TaskInfo & ti)
+                     {
+                       size_t * myoffsets = &offsets[256*ti.task_nr];
+                       for (auto i : task_range(ti.task_nr))
+                         {
+                           size_t pos = myoffsets[(src[i] >> shift) & 255]++;
+                           dst[pos] = src[i];
+                           if (with_vals) dstv[pos] = srcv[i];
+                         }
+                     }, ntasks);
+        Swap (src, dst);
+        Swap (srcv, dstv);
+      }
+
+    if (src != (TU*)keys.Addr(0))
+      ParallelJob ([&] (TaskInfo & ti)
+                   {
+                     for (auto i : task_range(ti.task_nr))
+                       {
+                         keys[i] = src[i];
+                         if (with_vals) vals[i] = srcv[i];
+                       }
+                   }, ntasks);
+  }
+
+  // order preserving map of integers to unsigned integers
+  template <typename T>
+  INLINE typename std::make_unsigned<T>::type RadixKey (T key)
+  {
+    typedef typename std::make_unsigned<T>::type TU;
+    if (std::is_signed<T>::value)
+      return TU(key) ^ (TU(1) << (8*sizeof(T)-1));
+    return TU(key);
+  }
+
+
+  /// parallel stable sort of integer keys, values are moved with the keys
+  template <typename T, typename TVAL>
+  void ParallelRadixSort (FlatArray<T> keys, FlatArray<TVAL> vals)
+  {
+    static_assert (std::is_integral<T>::value, "ParallelRadixSort needs integer keys");
+    static Timer t("ParallelRadixSort");
+    RegionTimer reg(t);
+    typedef typename std::make_unsigned<T>::type TU;
+    FlatArray<TU> ukeys(keys.Size(), reinterpret_cast<TU*>((T*)keys.Addr(0)));
+    ParallelForRange (keys.Size(), [&] (IntRange r) { for (auto i : r) ukeys[i] = RadixKey(keys[i]); });
+    RadixSortUnsigned (ukeys, vals);
+    if (std::is_signed<T>::value)
+      ParallelForRange (keys.Size(), [&] (IntRange r) { for (auto i : r) ukeys[i] = RadixKey(T(ukeys[i])); });
+  }
+
+  /// parallel sort of integer keys
+  template <typename T>
+  void ParallelRadixSort (FlatArray<T> keys)
+  {
+    ParallelRadixSort (keys, FlatArray<int> (0, nullptr));
+  }
+
+  /**
+     Parallel version of QuickSortI for keys with ncomp integer components, 
+     sorted lexicographically: index is reordered such that data[index[i]] 
+     is ascending, comp(data[i], j) is the j-th component. Stable.
+   */
+  template <typename T, typename TI, typename TCOMP>
+  void ParallelRadixSortI (FlatArray<T> data, FlatArray<TI> index, int ncomp, TCOMP comp)
+  {
+    static Timer t("ParallelRadixSortI");
+    RegionTimer reg(t);
+    typedef decltype(RadixKey(comp(data[0],0))) TU;
+    Array<TU> ukeys(index.Size());
+    for (int j = ncomp-1; j >= 0; j--)
+      {
+        ParallelForRange (index.Size(), [&] (IntRange r)
+                          {
+                            for (auto i : r)
+                              ukeys[i] = RadixKey(comp(data[index[i]], j));
+                          });
+        RadixSortUnsigned (FlatArray<TU>(ukeys), index);
+      }
+  }
+
+  template <typename T, typename TI>
+  void ParallelRadixSortI (FlatArray<T> data, FlatArray<TI> index)
+  {
+    ParallelRadixSortI (data, index, 1, [] (T key, int j) { return key; });
+  }
+
+  template <int N, typename T, typename TI>
+  void ParallelRadixSortI (FlatArray<INT<N,T>> data, FlatArray<TI> index)
+  {
+    ParallelRadixSortI (data, index, N, [] (const INT<N,T> & key, int j) { return key[j]; });
+  }
+
 } 
 
 #endif  // SAMPLE_SORT_HPP_
@@ -64,6 +64,8 @@ namespace ngstd
     return 4;
 #elif defined __SSE__
     return 2;
+#elif defined __aarch64__
+    return 2;
 #else
     return 1;
 #endif
@@ -179,6 +181,22 @@ namespace ngstd
     static constexpr int Size() { return 2; }    
     mask64 operator[] (int i) const { return ((mask64*)(&mask))[i]; }    
   };
+#elif defined(__aarch64__)
+  template <> 
+  class SIMD<mask64,2>
+  {
+    int64x2_t mask;
+  public:
+    SIMD (int i)
+    {
+      int64x2_t ind = { 0, 1 };
+      mask = vreinterpretq_s64_u64(vcgtq_s64(vdupq_n_s64(i), ind));
+    }
+    SIMD (int64x2_t _mask) : mask(_mask) { ; }
+    int64x2_t Data() const { return mask; }
+    static constexpr int Size() { return 2; }    
+    mask64 operator[] (int i) const { return ((mask64*)(&mask))[i]; }    
+  };
 #endif
   
   
@@ -336,6 +354,59 @@ namespace ngstd
                       SIMD<double,2>(_mm_unpackhi_pd(a.Data(),b.Data())));
   }
   
+#elif defined(__aarch64__)
+  // NEON
+  template<>
+  class alignas(16) SIMD<double,2> : public AlignedAlloc<SIMD<double,2>>
+  {
+    float64x2_t data;
+    
+  public:
+    static constexpr int Size() { return 2; }
+    SIMD () = default;
+    SIMD (const SIMD &) = default;
+    SIMD (double v0, double v1) { data = float64x2_t{v0,v1}; }
+    
+    SIMD & operator= (const SIMD &) = default;
+
+    SIMD (double val) { data = vdupq_n_f64(val); }
+    SIMD (int val)    { data = vdupq_n_f64(val); }
+    SIMD (size_t val) { data = vdupq_n_f64(val); }
+
+    SIMD (double const * p) { data = vld1q_f64(p); }
+    SIMD (double const * p, SIMD<mask64,2> mask)
+      {
+        data = float64x2_t{ mask[0] ? p[0] : 0.0, mask[1] ? p[1] : 0.0 };
+      }
+    SIMD (float64x2_t _data) { data = _data; }
+
+    void Store (double * p) { vst1q_f64(p, data); }
+    void Store (double * p, SIMD<mask64,2> mask)
+    {
+      if (mask[0]) p[0] = (*this)[0];
+      if (mask[1]) p[1] = (*this)[1];
+    }    
+    
+    template<typename T, typename std::enable_if<std::is_convertible<T, std::function<double(int)>>::value, int>::type = 0>
+    SIMD (const T & func)
+    {   
+      data = float64x2_t{func(0), func(1)};
+    }   
+    
+    INLINE double operator[] (int i) const { return ((double*)(&data))[i]; }
+    INLINE double & operator[] (int i) { return ((double*)(&data))[i]; }
+    INLINE float64x2_t Data() const { return data; }
+    INLINE float64x2_t & Data() { return data; }
+
+    operator tuple<double&,double&> ()
+    { return tuple<double&,double&>((*this)[0], (*this)[1]); }
+  };
+
+  INLINE auto Unpack (SIMD<double,2> a, SIMD<double,2> b)
+  {
+    return make_tuple(SIMD<double,2>(vzip1q_f64(a.Data(),b.Data())),
+                      SIMD<double,2>(vzip2q_f64(a.Data(),b.Data())));
+  }
 #endif
 
   
@@ -425,7 +496,7 @@ namespace ngstd
     void Store (double * p, SIMD<mask64,4> mask)
     {
       data[0].Store(p, mask.Lo());
-      data[1].Store(p, mask.Hi());
+      data[1].Store(p+2, mask.Hi());
     }    
 
     /*
@@ -544,6 +615,183 @@ namespace ngstd
   };
 
 #endif
+
+
+
+  /*
+    single precision storage with the lane count of SIMD<double,N>.
+    Values are converted to SIMD<double,N> for computation, so float
+    matrices can be used with double accumulation.
+  */
+  
+  template <int N>
+  class SIMD<float,N>
+  {
+    float data[N];
+  public:
+    static constexpr int Size() { return N; }
+    SIMD () = default;
+    SIMD (const SIMD &) = default;
+    SIMD & operator= (const SIMD &) = default;
+
+    SIMD (float val) { for (int i = 0; i < N; i++) data[i] = val; }
+    SIMD (float const * p) { for (int i = 0; i < N; i++) data[i] = p[i]; }
+    SIMD (float const * p, SIMD<mask64,N> mask)
+    {
+      double hm[N] = { 0.0 };
+      SIMD<double,N>(1.0).Store (hm, mask);
+      for (int i = 0; i < N; i++) data[i] = (hm[i] != 0.0) ? p[i] : 0.0f;
+    }
+    SIMD (SIMD<double,N> v) { for (int i = 0; i < N; i++) data[i] = v[i]; }
+
+    void Store (float * p) { for (int i = 0; i < N; i++) p[i] = data[i]; }
+    void Store (float * p, SIMD<mask64,N> mask)
+    {
+      double hm[N] = { 0.0 };
+      SIMD<double,N>(1.0).Store (hm, mask);
+      for (int i = 0; i < N; i++)
+        if (hm[i] != 0.0) p[i] = data[i];
+    }
+
+    operator SIMD<double,N> () const
+    {
+      double hd[N];
+      for (int i = 0; i < N; i++) hd[i] = data[i];
+      return SIMD<double,N> (&hd[0]);
+    }
+    
+    INLINE float operator[] (int i) const { return data[i]; }
+  };
+
+
+#ifdef __SSE__
+  template<>
+  class SIMD<float,2>
+  {
+    __m128 data;   // lower two lanes used
+  public:
+    static constexpr int Size() { return 2; }
+    SIMD () = default;
+    SIMD (const SIMD &) = default;
+    SIMD & operator= (const SIMD &) = default;
+
+    SIMD (float val) { data = _mm_set1_ps(val); }
+    SIMD (float const * p) { data = _mm_castpd_ps(_mm_load_sd((double const*)p)); }
+    SIMD (float const * p, SIMD<mask64,2> mask)
+    { data = _mm_set_ps (0.0f, 0.0f, mask[1] ? p[1] : 0.0f, mask[0] ? p[0] : 0.0f); }
+    SIMD (__m128 _data) { data = _data; }
+    SIMD (SIMD<double,2> v) { data = _mm_cvtpd_ps(v.Data()); }
+
+    void Store (float * p) { _mm_store_sd((double*)p, _mm_castps_pd(data)); }
+    void Store (float * p, SIMD<mask64,2> mask)
+    {
+      if (mask[0]) p[0] = (*this)[0];
+      if (mask[1]) p[1] = (*this)[1];
+    }
+
+    operator SIMD<double,2> () const { return _mm_cvtps_pd(data); }
+
+    INLINE float operator[] (int i) const { return ((float*)(&data))[i]; }
+    INLINE __m128 Data() const { return data; }
+  };
+#elif defined(__aarch64__)
+  template<>
+  class SIMD<float,2>
+  {
+    float32x2_t data;
+  public:
+    static constexpr int Size() { return 2; }
+    SIMD () = default;
+    SIMD (const SIMD &) = default;
+    SIMD & operator= (const SIMD &) = default;
+
+    SIMD (float val) { data = vdup_n_f32(val); }
+    SIMD (float const * p) { data = vld1_f32(p); }
+    SIMD (float const * p, SIMD<mask64,2> mask)
+    { data = float32x2_t{ mask[0] ? p[0] : 0.0f, mask[1] ? p[1] : 0.0f }; }
+    SIMD (float32x2_t _data) { data = _data; }
+    SIMD (SIMD<double,2> v) { data = vcvt_f32_f64(v.Data()); }
+
+    void Store (float * p) { vst1_f32(p, data); }
+    void Store (float * p, SIMD<mask64,2> mask)
+    {
+      if (mask[0]) p[0] = (*this)[0];
+      if (mask[1]) p[1] = (*this)[1];
+    }
+
+    operator SIMD<double,2> () const { return vcvt_f64_f32(data); }
+
+    INLINE float operator[] (int i) const { return ((float*)(&data))[i]; }
+    INLINE float32x2_t Data() const { return data; }
+  };
+#endif
+
+  
+#ifdef __AVX__
+  template<>
+  class SIMD<float,4>
+  {
+    __m128 data;
+    
+    // 32 bit lanes from the 64 bit mask
+    static __m128i Mask32 (SIMD<mask64,4> mask)
+    {
+      __m256i m = mask.Data();
+      return _mm_castps_si128 (_mm_shuffle_ps (_mm_castsi128_ps(_mm256_castsi256_si128(m)),
+                                               _mm_castsi128_ps(_mm256_extractf128_si256(m,1)),
+                                               _MM_SHUFFLE(2,0,2,0)));
+    }
+  public:
+    static constexpr int Size() { return 4; }
+    SIMD () = default;
+    SIMD (const SIMD &) = default;
+    SIMD & operator= (const SIMD &) = default;
+
+    SIMD (float val) { data = _mm_set1_ps(val); }
+    SIMD (float const * p) { data = _mm_loadu_ps(p); }
+    SIMD (float const * p, SIMD<mask64,4> mask) { data = _mm_maskload_ps(p, Mask32(mask)); }
+    SIMD (__m128 _data) { data = _data; }
+    SIMD (SIMD<double,4> v) { data = _mm256_cvtpd_ps(v.Data()); }
+
+    void Store (float * p) { _mm_storeu_ps(p, data); }
+    void Store (float * p, SIMD<mask64,4> mask) { _mm_maskstore_ps(p, Mask32(mask), data); }
+
+    operator SIMD<double,4> () const { return _mm256_cvtps_pd(data); }
+
+    INLINE float operator[] (int i) const { return ((float*)(&data))[i]; }
+    INLINE __m128 Data() const { return data; }
+  };
+#endif
+
+  
+#ifdef __AVX512F__
+  template<>
+  class SIMD<float,8>
+  {
+    __m256 data;
+  public:
+    static constexpr int Size() { return 8; }
+    SIMD () = default;
+    SIMD (const SIMD &) = default;
+    SIMD & operator= (const SIMD &) = default;
+
+    SIMD (float val) { data = _mm256_set1_ps(val); }
+    SIMD (float const * p) { data = _mm256_loadu_ps(p); }
+    SIMD (float const * p, SIMD<mask64,8> mask)
+    { data = _mm512_castps512_ps256 (_mm512_maskz_loadu_ps (__mmask16(mask.Data()), p)); }
+    SIMD (__m256 _data) { data = _data; }
+    SIMD (SIMD<double,8> v) { data = _mm512_cvtpd_ps(v.Data()); }
+
+    void Store (float * p) { _mm256_storeu_ps(p, data); }
+    void Store (float * p, SIMD<mask64,8> mask)
+    { _mm512_mask_storeu_ps (p, __mmask16(mask.Data()), _mm512_castps256_ps512(data)); }
+
+    operator SIMD<double,8> () const { return _mm512_cvtps_pd(data); }
+
+    INLINE float operator[] (int i) const { return ((float*)(&data))[i]; }
+    INLINE __m256 Data() const { return data; }
+  };
+#endif
   
 
 
@@ -634,7 +882,10 @@ namespace ngstd
   INLINE SIMD<double,2> ceil (SIMD<double,2> a) 
   { return ngstd::SIMD<double,2>([&](int i)->double { return ceil(a[i]); } ); }
   INLINE SIMD<double,2> IfPos (SIMD<double,2> a, SIMD<double,2> b, SIMD<double,2> c)
-  { return ngstd::SIMD<double,2>([&](int i)->double { return a[i]>0 ? b[i] : c[i]; }); }
+  {
+    __m128d cp = _mm_cmpgt_pd (a.Data(), _mm_setzero_pd());
+    return _mm_or_pd (_mm_and_pd (cp, b.Data()), _mm_andnot_pd (cp, c.Data()));
+  }
 
   
   INLINE double HSum (SIMD<double,2> sd)
@@ -655,6 +906,34 @@ namespace ngstd
     SIMD<double,2> hsum2 = my_mm_hadd_pd (v3.Data(), v4.Data());
     return SIMD<double,4> (hsum1, hsum2);
   }
+
+#elif defined(__aarch64__)
+
+  INLINE SIMD<double,2> sqrt (SIMD<double,2> a) { return vsqrtq_f64(a.Data()); }
+  INLINE SIMD<double,2> fabs (SIMD<double,2> a) { return vabsq_f64(a.Data()); }
+  using std::floor;
+  INLINE SIMD<double,2> floor (SIMD<double,2> a) { return vrndmq_f64(a.Data()); }
+  using std::ceil;  
+  INLINE SIMD<double,2> ceil (SIMD<double,2> a) { return vrndpq_f64(a.Data()); }
+  INLINE SIMD<double,2> IfPos (SIMD<double,2> a, SIMD<double,2> b, SIMD<double,2> c)
+  { return vbslq_f64 (vcgtq_f64(a.Data(), vdupq_n_f64(0.0)), b.Data(), c.Data()); }
+
+  INLINE double HSum (SIMD<double,2> sd)
+  {
+    return vaddvq_f64 (sd.Data());
+  }
+
+  INLINE auto HSum (SIMD<double,2> sd1, SIMD<double,2> sd2)
+  {
+    return SIMD<double,2> (vpaddq_f64(sd1.Data(), sd2.Data()));
+  }
+
+  INLINE auto HSum (SIMD<double,2> v1, SIMD<double,2> v2, SIMD<double,2> v3, SIMD<double,2> v4)
+  {
+    SIMD<double,2> hsum1 = vpaddq_f64 (v1.Data(), v2.Data());
+    SIMD<double,2> hsum2 = vpaddq_f64 (v3.Data(), v4.Data());
+    return SIMD<double,4> (hsum1, hsum2);
+  }
 #endif
 
   
@@ -823,7 +1102,7 @@ namespace ngstd
   using std::exp;
   template <int N>
   INLINE ngstd::SIMD<double,N> exp (ngstd::SIMD<double,N> a) {
-    return ngstd::SIMD<double>([&](int i)->double { return exp(a[i]); } );
+    return ngstd::SIMD<double,N>([&](int i)->double { return exp(a[i]); } );
   }
 
   using std::log;
@@ -838,6 +1117,168 @@ namespace ngstd
     return ngstd::SIMD<double,N>([&](int i)->double { return pow(a[i],x); } );
   }
 
+
+  /*
+    exp, log and pow (a > 0) evaluated in all lanes at once, for the
+    native register widths. The exponent field is set and extracted by
+    integer shifts of the 64 bit lanes, the rest is SIMD arithmetic.
+    exp and log are accurate to about 1 ulp, and handle 0, inf, nan
+    and subnormals as the scalar versions (up to flush-to-zero modes).
+    The relative error of pow grows with |y log a|, it is about 1e-14
+    for moderate arguments.
+  */
+
+  INLINE double DoubleFromBits (uint64_t bits)
+  {
+    double d;
+    memcpy (&d, &bits, sizeof(d));
+    return d;
+  }
+
+#ifdef __SSE__
+  INLINE SIMD<double,2> BitShiftLeft52 (SIMD<double,2> a)
+  { return _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(a.Data()), 52)); }
+  INLINE SIMD<double,2> BitShiftRight52 (SIMD<double,2> a)
+  { return _mm_castsi128_pd(_mm_srli_epi64(_mm_castpd_si128(a.Data()), 52)); }
+  INLINE SIMD<double,2> BitAnd (SIMD<double,2> a, SIMD<double,2> b)
+  { return _mm_and_pd(a.Data(), b.Data()); }
+  INLINE SIMD<double,2> BitOr (SIMD<double,2> a, SIMD<double,2> b)
+  { return _mm_or_pd(a.Data(), b.Data()); }
+#elif defined(__aarch64__)
+  INLINE SIMD<double,2> BitShiftLeft52 (SIMD<double,2> a)
+  { return vreinterpretq_f64_u64(vshlq_n_u64(vreinterpretq_u64_f64(a.Data()), 52)); }
+  INLINE SIMD<double,2> BitShiftRight52 (SIMD<double,2> a)
+  { return vreinterpretq_f64_u64(vshrq_n_u64(vreinterpretq_u64_f64(a.Data()), 52)); }
+  INLINE SIMD<double,2> BitAnd (SIMD<double,2> a, SIMD<double,2> b)
+  { return vreinterpretq_f64_u64(vandq_u64(vreinterpretq_u64_f64(a.Data()), vreinterpretq_u64_f64(b.Data()))); }
+  INLINE SIMD<double,2> BitOr (SIMD<double,2> a, SIMD<double,2> b)
+  { return vreinterpretq_f64_u64(vorrq_u64(vreinterpretq_u64_f64(a.Data()), vreinterpretq_u64_f64(b.Data()))); }
+#endif
+
+#ifdef __AVX__
+#ifdef __AVX2__
+  INLINE SIMD<double,4> BitShiftLeft52 (SIMD<double,4> a)
+  { return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(a.Data()), 52)); }
+  INLINE SIMD<double,4> BitShiftRight52 (SIMD<double,4> a)
+  { return _mm256_castsi256_pd(_mm256_srli_epi64(_mm256_castpd_si256(a.Data()), 52)); }
+#else
+  INLINE SIMD<double,4> BitShiftLeft52 (SIMD<double,4> a)
+  { return SIMD<double,4> (BitShiftLeft52(a.Lo()), BitShiftLeft52(a.Hi())); }
+  INLINE SIMD<double,4> BitShiftRight52 (SIMD<double,4> a)
+  { return SIMD<double,4> (BitShiftRight52(a.Lo()), BitShiftRight52(a.Hi())); }
+#endif
+  INLINE SIMD<double,4> BitAnd (SIMD<double,4> a, SIMD<double,4> b)
+  { return _mm256_and_pd(a.Data(), b.Data()); }
+  INLINE SIMD<double,4> BitOr (SIMD<double,4> a, SIMD<double,4> b)
+  { return _mm256_or_pd(a.Data(), b.Data()); }
+#endif
+
+#ifdef __AVX512F__
+  INLINE SIMD<double,8> BitShiftLeft52 (SIMD<double,8> a)
+  { return _mm512_castsi512_pd(_mm512_slli_epi64(_mm512_castpd_si512(a.Data()), 52)); }
+  INLINE SIMD<double,8> BitShiftRight52 (SIMD<double,8> a)
+  { return _mm512_castsi512_pd(_mm512_srli_epi64(_mm512_castpd_si512(a.Data()), 52)); }
+  INLINE SIMD<double,8> BitAnd (SIMD<double,8> a, SIMD<double,8> b)
+  { return _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(a.Data()), _mm512_castpd_si512(b.Data()))); }
+  INLINE SIMD<double,8> BitOr (SIMD<double,8> a, SIMD<double,8> b)
+  { return _mm512_castsi512_pd(_mm512_or_si512(_mm512_castpd_si512(a.Data()), _mm512_castpd_si512(b.Data()))); }
+#endif
+
+  template <int N>
+  INLINE SIMD<double,N> SIMD_exp (SIMD<double,N> x)
+  {
+    typedef SIMD<double,N> TS;
+    // x = n ln2 + r, |r| <= ln2/2. Adding 1.5*2^52 rounds to an integer,
+    // the low mantissa bits of t are then the biased exponent n+1023
+    constexpr double ln2hi = 6.93147180369123816490e-01, ln2lo = 1.90821492927058770002e-10;
+    constexpr double shift = 6755399441055744.0 + 1023;
+    TS xc = IfPos (x-TS(710.0), TS(710.0), IfPos (TS(-746.0)-x, TS(-746.0), x));
+    TS t = xc * 1.4426950408889634 + TS(shift);
+    TS n = t - TS(shift);
+    TS r = (xc - n * ln2hi) - n * ln2lo;
+
+    // Taylor polynomial, the remainder is below 1e-17
+    TS p(1.0/6227020800.0);
+    constexpr double c[] = { 1.0, 1.0, 1.0/2, 1.0/6, 1.0/24, 1.0/120, 1.0/720, 1.0/5040,
+                             1.0/40320, 1.0/362880, 1.0/3628800, 1.0/39916800, 1.0/479001600 };
+    for (int i = 12; i >= 0; i--)
+      p = p * r + TS(c[i]);
+
+    // 2^n, in two factors for subnormal results and for n = 1024
+    TS sub = IfPos (TS(-1000.0)-n, TS(1.0), TS(0.0));
+    TS big = IfPos (n-TS(1000.0), TS(1.0), TS(0.0));
+    t = IfPos (sub, t + TS(54.0), IfPos (big, t - TS(1.0), t));
+    TS fac = IfPos (sub, TS(DoubleFromBits(uint64_t(1023-54) << 52)), IfPos (big, TS(2.0), TS(1.0)));
+    TS res = p * BitShiftLeft52(t) * fac;
+
+    res = IfPos (x-TS(709.782712893384), TS(std::numeric_limits<double>::infinity()), res);
+    return IfPos (TS(-745.1332191019412)-x, TS(0.0), res);
+  }
+
+  template <int N>
+  INLINE SIMD<double,N> SIMD_log (SIMD<double,N> x)
+  {
+    typedef SIMD<double,N> TS;
+    constexpr double ln2hi = 6.93147180369123816490e-01, ln2lo = 1.90821492927058770002e-10;
+    constexpr double two52 = 4503599627370496.0;
+
+    // x = m 2^e with m in [sqrt(2)/2, sqrt(2)), subnormals scaled first
+    TS sub = IfPos (TS(std::numeric_limits<double>::min())-x, TS(1.0), TS(0.0));
+    TS xs = IfPos (sub, x * (4*two52), x);
+    TS e = BitOr (BitShiftRight52(xs), TS(two52)) - TS(two52+1023) - IfPos (sub, TS(54.0), TS(0.0));
+    TS m = BitOr (BitAnd (xs, TS(DoubleFromBits(0x000FFFFFFFFFFFFFull))), TS(1.0));
+    TS big = IfPos (m-TS(1.4142135623730951), TS(1.0), TS(0.0));
+    m = IfPos (big, m*0.5, m);
+    e += big;
+
+    // log(1+f) = f - (f^2/2 - s (f^2/2 + R(s^2))), s = f/(2+f), as in fdlibm
+    TS f = m - TS(1.0);
+    TS s = f / (TS(2.0)+f);
+    TS z = s*s;
+    TS R = z * (TS(6.666666666666735130e-01) + z * (TS(3.999999999940941908e-01) + z * (TS(2.857142874366239149e-01)
+        + z * (TS(2.222219843214978396e-01) + z * (TS(1.818357216161805012e-01) + z * (TS(1.531383769920937332e-01)
+        + z * TS(1.479819860511658591e-01)))))));
+    TS hfsq = 0.5*f*f;
+    TS res = e*ln2hi - ((hfsq - (s*(hfsq+R) + e*ln2lo)) - f);
+
+    // nan stays nan, inf -> inf, 0 -> -inf, x < 0 -> nan
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    res += x*0.0;
+    res = IfPos (x-TS(std::numeric_limits<double>::max()), TS(inf), res);
+    return IfPos (TS(std::numeric_limits<double>::denorm_min())-x,
+                  IfPos (-x, TS(std::numeric_limits<double>::quiet_NaN()), TS(-inf)), res);
+  }
+
+  template <int N>
+  INLINE SIMD<double,N> SIMD_pow (SIMD<double,N> a, double y)
+  {
+    // a^y = exp(y log(a)) for a > 0, the other lanes by std::pow
+    SIMD<double,N> res = SIMD_exp (y * SIMD_log (a));
+    SIMD<double,N> other = IfPos (a, SIMD<double,N>(0.0), SIMD<double,N>(1.0));
+    bool any = false;
+    for (int i = 0; i < N; i++)
+      any |= other[i] != 0.0;
+    if (any)
+      res = SIMD<double,N>([&](int i)->double { return other[i] != 0.0 ? std::pow(a[i],y) : res[i]; });
+    return res;
+  }
+
+#if defined(__SSE__) || defined(__aarch64__)
+  INLINE SIMD<double,2> exp (SIMD<double,2> a) { return SIMD_exp(a); }
+  INLINE SIMD<double,2> log (SIMD<double,2> a) { return SIMD_log(a); }
+  INLINE SIMD<double,2> pow (SIMD<double,2> a, double x) { return SIMD_pow(a, x); }
+#endif
+#ifdef __AVX__
+  INLINE SIMD<double,4> exp (SIMD<double,4> a) { return SIMD_exp(a); }
+  INLINE SIMD<double,4> log (SIMD<double,4> a) { return SIMD_log(a); }
+  INLINE SIMD<double,4> pow (SIMD<double,4> a, double x) { return SIMD_pow(a, x); }
+#endif
+#ifdef __AVX512F__
+  INLINE SIMD<double,8> exp (SIMD<double,8> a) { return SIMD_exp(a); }
+  INLINE SIMD<double,8> log (SIMD<double,8> a) { return SIMD_log(a); }
+  INLINE SIMD<double,8> pow (SIMD<double,8> a, double x) { return SIMD_pow(a, x); }
+#endif
+
   template <int N>
   INLINE ngstd::SIMD<double,N> pow (ngstd::SIMD<double,N> a, ngstd::SIMD<double,N> b) {
     return ngstd::SIMD<double,N>([&](int i)->double { return pow(a[i],b[i]); } );
@@ -1015,6 +1456,16 @@ namespace ngstd
     return _mm256_fmadd_pd (_mm256_set1_pd(a), b.Data(), c.Data());
   }
 #endif
+#ifdef __aarch64__
+  INLINE SIMD<double,2> FMA (SIMD<double,2> a, SIMD<double,2> b, SIMD<double,2> c)
+  {
+    return vfmaq_f64 (c.Data(), a.Data(), b.Data());
+  }
+  INLINE SIMD<double,2> FMA (const double & a, SIMD<double,2> b, SIMD<double,2> c)
+  {
+    return vfmaq_n_f64 (c.Data(), b.Data(), a);
+  }
+#endif
 
   // update form of fma
   template <int N>
@@ -26,6 +26,8 @@ namespace ngstd
 #elif defined(__SSE__)
     return _mm_cmpgt_epi32(_mm_set1_epi32(nr),
                            _mm_set_epi32(0, 0, 0, 0));
+#elif defined(__aarch64__)
+    return SIMD<mask64>(nr > 0 ? 2 : 0);
 #else
     return false;
 #endif
@@ -109,6 +111,37 @@ namespace ngstd
   INLINE SIMD<Complex> & operator*= (SIMD<Complex> & a, SIMD<Complex> b)
   { a = a*b; return a; }
 
+  // mixed real/complex operations work on the real parts only, the
+  // double overloads avoid ambiguous conversions in generated code
+  INLINE SIMD<Complex> operator- (SIMD<Complex> a)
+  { return SIMD<Complex> (-a.real(), -a.imag()); }
+  INLINE SIMD<Complex> operator+ (SIMD<Complex> a, SIMD<double> b)
+  { return SIMD<Complex> (a.real()+b, a.imag()); }
+  INLINE SIMD<Complex> operator+ (SIMD<double> a, SIMD<Complex> b)
+  { return SIMD<Complex> (a+b.real(), b.imag()); }
+  INLINE SIMD<Complex> operator+ (SIMD<Complex> a, double b)
+  { return SIMD<Complex> (a.real()+b, a.imag()); }
+  INLINE SIMD<Complex> operator+ (double a, SIMD<Complex> b)
+  { return SIMD<Complex> (a+b.real(), b.imag()); }
+  INLINE SIMD<Complex> operator- (SIMD<Complex> a, SIMD<double> b)
+  { return SIMD<Complex> (a.real()-b, a.imag()); }
+  INLINE SIMD<Complex> operator- (SIMD<double> a, SIMD<Complex> b)
+  { return SIMD<Complex> (a-b.real(), -b.imag()); }
+  INLINE SIMD<Complex> operator- (SIMD<Complex> a, double b)
+  { return SIMD<Complex> (a.real()-b, a.imag()); }
+  INLINE SIMD<Complex> operator- (double a, SIMD<Complex> b)
+  { return SIMD<Complex> (a-b.real(), -b.imag()); }
+  INLINE SIMD<Complex> & operator-= (SIMD<Complex> & a, SIMD<Complex> b)
+  { a.real()-=b.real(); a.imag()-=b.imag(); return a; }
+  INLINE SIMD<Complex> operator* (double a, SIMD<Complex> b)
+  { return SIMD<Complex> (a*b.real(), a*b.imag()); }
+  INLINE SIMD<Complex> operator* (SIMD<Complex> b, double a)
+  { return SIMD<Complex> (a*b.real(), a*b.imag()); }
+  INLINE SIMD<Complex> operator/ (SIMD<Complex> a, SIMD<double> b)
+  { return SIMD<Complex> (a.real()/b, a.imag()/b); }
+  INLINE SIMD<Complex> operator/ (SIMD<Complex> a, double b)
+  { return SIMD<Complex> (a.real()/b, a.imag()/b); }
+
   INLINE SIMD<Complex> Inv (SIMD<Complex> a)
   {
     SIMD<double> n2 = a.real()*a.real()+a.imag()*a.imag();
@@ -176,6 +209,18 @@ namespace ngstd
   inline SIMD<Complex> Conj (SIMD<Complex> x)
   { return SIMD<Complex> (x.real(), -x.imag()); } 
 
+  inline SIMD<Complex> pow (SIMD<Complex> x, SIMD<Complex> y)
+  { return exp(log(x)*y); }
+
+  INLINE SIMD<double> abs (SIMD<Complex> x)
+  { return sqrt(x.real()*x.real()+x.imag()*x.imag()); }
+
+  INLINE SIMD<double> L2Norm2 (SIMD<Complex> x)
+  { return x.real()*x.real()+x.imag()*x.imag(); }
+
+  INLINE SIMD<Complex> IfPos (SIMD<double> a, SIMD<Complex> b, SIMD<Complex> c)
+  { return SIMD<Complex> (IfPos (a, b.real(), c.real()), IfPos (a, b.imag(), c.imag())); }
+
 }
 
 
@@ -359,6 +359,140 @@ template <class T>
 
 
 
+  /**
+     Collects the entries of one task for ParallelCreateTable.
+     Same Add functions as the TableCreator.
+  */
+  template <typename T>
+  class ParallelTableCreator
+  {
+    Array<size_t> rows;
+    Array<T> values;
+    template <typename T2, typename TFUNC>
+    friend Table<T2> ParallelCreateTable (size_t, TFUNC, size_t);
+  public:
+    void Add (size_t blocknr, const T & data)
+    {
+      rows.Append (blocknr);
+      values.Append (data);
+    }
+
+    void Add (size_t blocknr, IntRange range)
+    {
+      for (auto i : range)
+        Add (blocknr, i);
+    }
+
+    void Add (size_t blocknr, const FlatArray<int> & dofs)
+    {
+      for (auto d : dofs)
+        Add (blocknr, d);
+    }
+  };
+
+  /**
+     Builds a table in parallel, without atomic counters:
+     func(creator, i) is called once for every i in Range(n) and adds entries
+     by creator.Add(row, data). Every task collects the entries of its range of i,
+     buckets them by blocks of rows, and then one task per block of rows counts
+     and fills its rows. The entries of a row are ordered by i.
+     The number of rows is determined from the entries if nrows is not given.
+  */
+  template <typename T, typename TFUNC>
+  Table<T> ParallelCreateTable (size_t n, TFUNC func, size_t nrows = size_t(-1))
+  {
+    int ntasks = max2 (1, min2 (int(n), TasksPerThread(4)));
+    auto task_range = [n, ntasks] (int k) { return Range(n).Split (k, ntasks); };
+
+    Array<ParallelTableCreator<T>> creators(ntasks);
+    Array<size_t> maxrow(ntasks);
+    ParallelJob ([&] (TaskInfo & ti)
+                 {
+                   auto & creator = creators[ti.task_nr];
+                   for (auto i : task_range(ti.task_nr))
+                     func (creator, i);
+                   size_t mymax = 0;
+                   for (auto r : creator.rows)
+                     mymax = max2 (mymax, r+1);
+                   maxrow[ti.task_nr] = mymax;
+                 }, ntasks);
+
+    if (nrows == size_t(-1))
+      {
+        nrows = 0;
+        for (auto m : maxrow) nrows = max2 (nrows, m);
+      }
+    else
+      for (auto m : maxrow)
+        if (m > nrows)
+          throw Exception ("ParallelCreateTable: row "+ToString(m-1)+" out of range");
+
+    // sort the entries of every task into blocks of rows (stable counting sort)
+    int nblocks = ntasks;
+    auto block_of = [nrows, nblocks] (size_t row) { return int(row * nblocks / max2(nrows, size_t(1))); };
+    Array<size_t> blockfirst((nblocks+1)*ntasks);
+    ParallelJob ([&] (TaskInfo & ti)
+                 {
+                   auto & creator = creators[ti.task_nr];
+                   auto first = blockfirst.Range (ti.task_nr*(nblocks+1), (ti.task_nr+1)*(nblocks+1));
+                   first = 0;
+                   for (auto r : creator.rows)
+                     first[block_of(r)+1]++;
+                   for (int b = 0; b < nblocks; b++)
+                     first[b+1] += first[b];
+                   Array<size_t> pos(nblocks);
+                   for (int b = 0; b < nblocks; b++)
+                     pos[b] = first[b];
+                   Array<size_t> rows(creator.rows.Size());
+                   Array<T> values(creator.values.Size());
+                   for (size_t j = 0; j < creator.rows.Size(); j++)
+                     {
+                       size_t p = pos[block_of(creator.rows[j])]++;
+                       rows[p] = creator.rows[j];
+                       values[p] = creator.values[j];
+                     }
+                   creator.rows = move(rows);
+                   creator.values = move(values);
+                 }, ntasks);
+
+    // count and fill row-blocks, every row is touched by one task only
+    Array<int> cnt(nrows);
+    auto block_rows = [&] (int b, auto f)
+      {
+        for (int k = 0; k < ntasks; k++)
+          {
+            auto & creator = creators[k];
+            for (size_t j = blockfirst[k*(nblocks+1)+b]; j < blockfirst[k*(nblocks+1)+b+1]; j++)
+              f (creator.rows[j], creator.values[j]);
+          }
+      };
+    auto my_rows = [nrows, nblocks] (int b)
+      {
+        // rows r with block_of(r) == b
+        size_t first = (b*nrows + nblocks-1) / nblocks;
+        size_t next = ((b+1)*nrows + nblocks-1) / nblocks;
+        return Range (first, next);
+      };
+
+    ParallelJob ([&] (TaskInfo & ti)
+                 {
+                   cnt.Range (my_rows(ti.task_nr)) = 0;
+                   block_rows (ti.task_nr, [&] (size_t row, const T & val) { cnt[row]++; });
+                 }, nblocks);
+
+    Table<T> table(cnt);
+
+    ParallelJob ([&] (TaskInfo & ti)
+                 {
+                   cnt.Range (my_rows(ti.task_nr)) = 0;
+                   block_rows (ti.task_nr, [&] (size_t row, const T & val)
+                               { table[row][cnt[row]++] = val; });
+                 }, nblocks);
+    return table;
+  }
+
+
+
 
 
 
@@ -495,6 +629,43 @@ public:
 
 
 
+/**
+   A DynamicTable for concurrent insertion, e.g. within a ParallelFor.
+   The rows grow independently, every row is protected by one of a
+   fixed set of spin locks. Reading is not locked, it should follow
+   the parallel phase.
+*/
+template <class T>
+class ParallelDynamicTable : public DynamicTable<T>
+{
+  enum { NLOCKS = 1024 };
+  Array<MyMutex64> locks;
+
+  MyMutex & RowLock (int i) { return locks[i & (NLOCKS-1)]; }
+public:
+  ParallelDynamicTable (int size = 0)
+    : DynamicTable<T> (size), locks(NLOCKS) { ; }
+
+  /// Inserts element acont into row i. Does not test if already used.
+  void Add (int i, const T & acont)
+  {
+    MyLock lock(RowLock(i));
+    DynamicTable<T>::Add (i, acont);
+  }
+
+  /// Inserts element acont into row i, iff not yet exists. Returns true if inserted.
+  bool AddUnique (int i, const T & acont)
+  {
+    MyLock lock(RowLock(i));
+    for (auto & val : (*this)[i])
+      if (val == acont)
+        return false;
+    DynamicTable<T>::Add (i, acont);
+    return true;
+  }
+};
+
+
 /// Print table
 template <class T>
 inline ostream & operator<< (ostream & s, const DynamicTable<T> & table)
@@ -6,6 +6,7 @@
 
 #include <ngstd.hpp>
 #include <thread>
+#include <typeindex>
 
 #include "taskmanager.hpp"
 #include "paje_interface.hpp"
@@ -55,9 +56,24 @@ namespace ngstd
 
   TaskManager::NodeData *TaskManager::nodedata[8];
   int TaskManager::num_nodes;
+
+  bool TaskManager :: use_work_stealing = getenv("NGS_WORK_STEALING") ? atoi(getenv("NGS_WORK_STEALING")) != 0 : false;
+  bool TaskManager :: pin_threads = getenv("NGS_PIN_THREADS") ? atoi(getenv("NGS_PIN_THREADS")) != 0 : false;
+  TaskManager::TaskDeque * TaskManager::ws_deques = nullptr;
+  atomic<int> TaskManager::ws_remaining;
+  bool TaskManager :: use_job_statistics = getenv("NGS_JOB_STATISTICS") ? atoi(getenv("NGS_JOB_STATISTICS")) != 0 : false;
+  TaskManager::JobCounter * TaskManager::job_counters = nullptr;
   
   static mutex copyex_mutex;
 
+  // jobs from different outside threads (e.g. python threads with
+  // released GIL) run one after the other, only tasks of the running
+  // job are nested
+  static mutex job_mutex;
+  static thread_local bool in_job = false;
+  // nesting depth of jobs run serially, only the outermost one is recorded
+  static thread_local int serial_depth = 0;
+
   int EnterTaskManager ()
   {
     if (task_manager)
@@ -121,6 +137,16 @@ namespace ngstd
       max_threads = amax_threads;
     }
 
+  void TaskManager :: SetWorkStealing (bool use)
+    {
+      if (func)
+        {
+          cerr << "Warning: can't change scheduling mode while a job is running!" << endl;
+          return;
+        }
+      use_work_stealing = use;
+    }
+
 
   TaskManager :: TaskManager()
     {
@@ -146,6 +172,10 @@ namespace ngstd
       workers_on_node[0] = 0;
 #endif
 
+      ws_deques = new TaskDeque[num_threads];
+      ws_remaining = 0;
+      job_counters = new JobCounter[num_threads];
+
       jobnr = 0;
       done = 0;
       sleep = false;
@@ -156,10 +186,11 @@ namespace ngstd
       char buf[100];
       if (use_paje_trace)
         {
+          const char * ext = PajeTrace::GetTraceFormat() == PajeTrace::CHROME ? "json" : "trace";
 #ifdef PARALLEL
-          sprintf(buf, "ng%d_rank%d.trace", cnt++, MyMPI_GetId());
+          sprintf(buf, "ng%d_rank%d.%s", cnt++, MyMPI_GetId(), ext);
 #else
-          sprintf(buf, "ng%d.trace", cnt++);
+          sprintf(buf, "ng%d.%s", cnt++, ext);
 #endif
         }
       else
@@ -173,6 +204,10 @@ namespace ngstd
   {
     delete trace;
     trace = nullptr;
+    delete [] ws_deques;
+    ws_deques = nullptr;
+    delete [] job_counters;
+    job_counters = nullptr;
     num_threads = 1;
   }
 
@@ -192,6 +227,7 @@ namespace ngstd
         std::thread([this,i]() { this->Loop(i); }).detach();
       }
     thread_id = 0;
+    if (pin_threads) PinThread (0);
     
     size_t alloc_size = num_threads*NgProfiler::SIZE;
     NgProfiler::thread_times = new size_t[alloc_size];
@@ -200,6 +236,13 @@ namespace ngstd
     NgProfiler::thread_flops = new size_t[alloc_size];
     for (size_t i = 0; i < alloc_size; i++)
       NgProfiler::thread_flops[i] = 0;
+    if (NgProfiler::use_hw_counters)
+      {
+        size_t hw_size = alloc_size*NgProfiler::NUM_HW_COUNTERS;
+        NgProfiler::thread_hw_counters = new size_t[hw_size];
+        for (size_t i = 0; i < hw_size; i++)
+          NgProfiler::thread_hw_counters[i] = 0;
+      }
 
     while (active_workers < num_threads-1)
       ;
@@ -226,11 +269,17 @@ namespace ngstd
           if (!NgProfiler::usedcounter[j]) break;
           NgProfiler::tottimes[j] += 1.0/frequ * NgProfiler::thread_times[i*NgProfiler::SIZE+j];
           NgProfiler::flops[j] += NgProfiler::thread_flops[i*NgProfiler::SIZE+j];
+          if (NgProfiler::thread_hw_counters)
+            for (int k = 0; k < NgProfiler::NUM_HW_COUNTERS; k++)
+              NgProfiler::hw_counters[j][k] +=
+                NgProfiler::thread_hw_counters[(i*NgProfiler::SIZE+j)*NgProfiler::NUM_HW_COUNTERS+k];
         }
     delete [] NgProfiler::thread_times;
     NgProfiler::thread_times = dummy_thread_times;
     delete [] NgProfiler::thread_flops;
     NgProfiler::thread_flops = dummy_thread_flops;
+    delete [] NgProfiler::thread_hw_counters;
+    NgProfiler::thread_hw_counters = nullptr;
     
     while (active_workers)
       ;
@@ -306,19 +355,33 @@ namespace ngstd
       {
         if (startup_function) (*startup_function)();
         
-        TaskInfo ti;
-        ti.ntasks = antasks;
-        ti.thread_nr = 0; ti.nthreads = 1;
-        // ti.node_nr = 0; ti.nnodes = 1;
-        for (ti.task_nr = 0; ti.task_nr < antasks; ti.task_nr++)
-          afunc(ti);
+        bool record = use_job_statistics && serial_depth == 0;
+        double starttime = record ? WallTime() : 0;
+        serial_depth++;
+        try
+          {
+            TaskInfo ti;
+            ti.ntasks = antasks;
+            ti.thread_nr = 0; ti.nthreads = 1;
+            // ti.node_nr = 0; ti.nnodes = 1;
+            for (ti.task_nr = 0; ti.task_nr < antasks; ti.task_nr++)
+              afunc(ti);
+          }
+        catch (...)
+          {
+            serial_depth--;
+            throw;
+          }
+        serial_depth--;
+        if (record)
+          RecordJobStatistics (afunc.target_type(), antasks, WallTime()-starttime, 0);
 
         if (cleanup_function) (*cleanup_function)();        
         return;
       }
 
 
-    if (func)
+    if (in_job)
       { // we are already parallel, use nested tasks
         // startup for inner function not supported ...
         // if (startup_function) (*startup_function)();
@@ -345,6 +408,9 @@ namespace ngstd
       }
     
     
+    lock_guard<mutex> job_guard(job_mutex);
+    in_job = true;
+
     trace->StartJob(jobnr, afunc.target_type());
 
     func = &afunc;
@@ -355,6 +421,25 @@ namespace ngstd
 
     nodedata[0]->start_cnt.store (0, memory_order_relaxed);
 
+    bool stealing = use_work_stealing;
+    if (stealing)
+      {
+        for (int i = 0; i < num_threads; i++)
+          ws_deques[i].Reset (Range(antasks).Split (i, num_threads));
+        ws_remaining.store (antasks, memory_order_relaxed);
+      }
+
+    bool record = use_job_statistics;
+    double starttime = 0;
+    size_t startticks = 0;
+    if (record)
+      {
+        for (int i = 0; i < num_threads; i++)
+          job_counters[i] = JobCounter();
+        starttime = WallTime();
+        startticks = __rdtsc();
+      }
+
     jobnr++;
     
     for (int j = 0; j < num_nodes; j++)
@@ -377,19 +462,18 @@ namespace ngstd
 
     try
       {
-        while (1)
-          {
-            int mytask = mynode_data.start_cnt++;
-            if (mytask >= mytasks.Size()) break;
-            
-            ti.task_nr = mytasks.First()+mytask;
-            ti.ntasks = ntasks;
-
+        if (stealing)
+          StealingLoop (ti);
+        else
+          while (1)
             {
-              RegionTracer t(ti.thread_nr, jobnr, RegionTracer::ID_JOB, ti.task_nr);
-              (*func)(ti); 
+              int mytask = mynode_data.start_cnt++;
+              if (mytask >= mytasks.Size()) break;
+            
+              ti.task_nr = mytasks.First()+mytask;
+              ti.ntasks = ntasks;
+              RunTask (ti);
             }
-          }
 
       }
     catch (Exception e)
@@ -399,6 +483,7 @@ namespace ngstd
           delete ex;
           ex = new Exception (e);
           mynode_data.start_cnt = mytasks.Size();
+          ws_remaining = 0;
         }
       }
 
@@ -411,7 +496,11 @@ namespace ngstd
             _mm_pause();
         }
 
+    if (record)
+      RecordJobStatistics (afunc.target_type(), antasks, WallTime()-starttime, __rdtsc()-startticks);
+
     func = nullptr;
+    in_job = false;
     if (ex)
       throw Exception (*ex);
 
@@ -430,6 +519,7 @@ namespace ngstd
     static Timer tdec("decrement");
     */
     thread_id = thd;
+    in_job = true;
 
     int thds = GetNumThreads();
 
@@ -449,6 +539,7 @@ namespace ngstd
 #ifdef USE_NUMA
     numa_run_on_node (mynode);
 #endif
+    if (pin_threads) PinThread (thd);
     active_workers++;
     workers_on_node[mynode]++;
     int jobdone = 0;
@@ -503,21 +594,19 @@ namespace ngstd
           
         try
           {
-            
-            while (1)
-              {
-                if (mynode_data.start_cnt >= mytasks.Size()) break;
-		int mytask = mynode_data.start_cnt.fetch_add(1, memory_order_relaxed);
-                if (mytask >= mytasks.Size()) break;
-                
-                ti.task_nr = mytasks.First()+mytask;
-                ti.ntasks = ntasks;
-                
+            if (use_work_stealing)
+              StealingLoop (ti);
+            else
+              while (1)
                 {
-                  RegionTracer t(ti.thread_nr, jobnr, RegionTracer::ID_JOB, ti.task_nr);
-                  (*func)(ti);
+                  if (mynode_data.start_cnt >= mytasks.Size()) break;
+                  int mytask = mynode_data.start_cnt.fetch_add(1, memory_order_relaxed);
+                  if (mytask >= mytasks.Size()) break;
+                
+                  ti.task_nr = mytasks.First()+mytask;
+                  ti.ntasks = ntasks;
+                  RunTask (ti);
                 }
-              }
 
           }
         catch (Exception e)
@@ -528,6 +617,7 @@ namespace ngstd
               delete ex;
               ex = new Exception (e);
               mynode_data.start_cnt = mytasks.Size();
+              ws_remaining = 0;
             }
           }
 
@@ -569,6 +659,297 @@ namespace ngstd
   }
 
 
+  void TaskManager :: PinThread (int thd)
+  {
+#if defined(__linux__)
+    int thds = GetNumThreads();
+    int mynode = num_nodes * thd/thds;
+    // my position among the threads of my node
+    int first_on_node = (mynode*thds + num_nodes-1) / num_nodes;
+    int nr_on_node = thd - first_on_node;
+
+    cpu_set_t cpuset;
+    CPU_ZERO (&cpuset);
+#ifdef USE_NUMA
+    struct bitmask * cpus = numa_allocate_cpumask();
+    numa_node_to_cpus (mynode, cpus);
+    int num_cpus = numa_bitmask_weight (cpus);
+    if (num_cpus == 0)
+      {
+        numa_free_cpumask (cpus);
+        return;
+      }
+    int k = nr_on_node % num_cpus;
+    for (unsigned int cpu = 0; cpu < cpus->size; cpu++)
+      if (numa_bitmask_isbitset (cpus, cpu) && k-- == 0)
+        {
+          CPU_SET (cpu, &cpuset);
+          break;
+        }
+    numa_free_cpumask (cpus);
+#else
+    (void)nr_on_node;
+    CPU_SET (thd % std::thread::hardware_concurrency(), &cpuset);
+#endif
+    pthread_setaffinity_np (pthread_self(), sizeof(cpuset), &cpuset);
+#endif
+  }
+
+
+  void TaskManager :: StealingLoop (TaskInfo & ti)
+  {
+    int me = ti.thread_nr;
+    int thds = ti.nthreads;
+    ti.ntasks = ntasks;
+    TaskDeque & mydeque = ws_deques[me];
+
+    unsigned seed = 2654435761u * (me+1);
+    int task;
+    while (ws_remaining.load(memory_order_acquire) > 0)
+      {
+        bool found = mydeque.Pop(task);
+        if (!found && thds > 1)
+          {
+            // xorshift random victim, never myself
+            seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+            int victim = seed % (thds-1);
+            if (victim >= me) victim++;
+            found = ws_deques[victim].Steal(task);
+          }
+        if (!found) continue;
+
+        ti.task_nr = task;
+        RunTask (ti);
+        ws_remaining.fetch_sub (1, memory_order_release);
+      }
+  }
+
+
+  static mutex job_statistics_mutex;
+  static map<tuple<std::type_index,int>, JobStatistics> job_statistics;
+
+  /*
+    The function type of ParallelFor & co is the wrapper lambda, the call
+    site is the function containing the user's lambda, its last template
+    argument: "ngstd::ParallelForRange<unsigned long, ngla::X::MultAdd(...)
+    const::{lambda(...)#1}>(...)::{lambda(ngstd::TaskInfo&)#1}" becomes
+    "ngla::X::MultAdd::{lambda#1}".
+   */
+  static string CallSiteName (const string & name)
+  {
+    if (name.compare (0, 15, "ngstd::Parallel") == 0)
+      {
+        size_t first = name.find ('<');
+        int depth = 0;
+        size_t lastarg = first+1;
+        for (size_t i = first; i < name.size(); i++)
+          {
+            char c = name[i];
+            if (c == '<' || c == '(') depth++;
+            else if (c == '>' || c == ')')
+              {
+                if (--depth == 0)
+                  return CallSiteName (name.substr (lastarg, i-lastarg));
+              }
+            else if (c == ',' && depth == 1)
+              lastarg = i+2;
+          }
+      }
+
+    // remove template arguments and parameter lists
+    string res;
+    int depth = 0;
+    for (char c : name)
+      {
+        if (c == '<' || c == '(') depth++;
+        else if (c == '>' || c == ')') depth--;
+        else if (depth == 0) res += c;
+      }
+    size_t pos;
+    while ( (pos = res.find (" const")) != string::npos)
+      res.erase (pos, 6);
+    return res;
+  }
+
+  void TaskManager :: RecordJobStatistics (const std::type_info & type, int antasks,
+                                           double wall, size_t wall_ticks)
+  {
+    int nthreads = wall_ticks ? num_threads : 1;
+    lock_guard<mutex> guard(job_statistics_mutex);
+    JobStatistics & stat = job_statistics[make_tuple(std::type_index(type), nthreads)];
+    if (stat.calls == 0)
+      {
+        stat.name = CallSiteName (Demangle (type.name()));
+        stat.nthreads = nthreads;
+        stat.idle.SetSize (nthreads);
+        stat.idle = 0.0;
+      }
+    stat.calls++;
+    stat.time += wall;
+
+    if (!wall_ticks)
+      {
+        stat.tasks += antasks;
+        stat.busy += wall;
+        stat.maxbusy += wall;
+        return;
+      }
+
+    // the threads' ticks are measured with the same clock
+    double sec_per_tick = wall / wall_ticks;
+    size_t maxticks = 0;
+    for (int i = 0; i < nthreads; i++)
+      {
+        size_t ticks = min2 (job_counters[i].ticks, wall_ticks);
+        stat.tasks += job_counters[i].tasks;
+        stat.busy += ticks * sec_per_tick;
+        stat.idle[i] += (wall_ticks-ticks) * sec_per_tick;
+        maxticks = max2 (maxticks, ticks);
+      }
+    stat.maxbusy += maxticks * sec_per_tick;
+  }
+
+  void TaskManager :: SetJobStatistics (bool use)
+  {
+    if (func)
+      {
+        cerr << "Warning: can't change job statistics while a job is running!" << endl;
+        return;
+      }
+    use_job_statistics = use;
+  }
+
+  Array<JobStatistics> TaskManager :: CollectJobStatistics (bool reset)
+  {
+    lock_guard<mutex> guard(job_statistics_mutex);
+    Array<JobStatistics> stats;
+    for (auto & entry : job_statistics)
+      stats.Append (entry.second);
+    if (reset)
+      job_statistics.clear();
+
+    Array<int> index(stats.Size());
+    Array<double> time(stats.Size());
+    for (int i : Range(stats))
+      {
+        index[i] = i;
+        time[i] = -stats[i].time;
+      }
+    QuickSortI (time, index);
+
+    Array<JobStatistics> sorted;
+    for (int i : index)
+      sorted.Append (stats[i]);
+    return sorted;
+  }
+
+  void TaskManager :: PrintJobStatistics (ostream & ost)
+  {
+    auto stats = CollectJobStatistics();
+    if (stats.Size() == 0) return;
+    ost << "parallel job statistics:" << endl;
+    ost << "    time  threads    calls    tasks  efficiency  imbalance  call site" << endl;
+    char line[128];
+    for (auto & stat : stats)
+      {
+        snprintf (line, sizeof(line), "%8.4f %8d %8zu %8zu  %9.1f%%  %9.2f  ",
+                  stat.time, stat.nthreads, stat.calls, stat.tasks,
+                  100*stat.Efficiency(), stat.Imbalance());
+        ost << line << stat.name << endl;
+      }
+  }
+
+  // statistics enabled by NGS_JOB_STATISTICS are printed at exit
+  static struct JobStatisticsPrinter
+  {
+    ~JobStatisticsPrinter ()
+    {
+      if (TaskManager::GetJobStatistics())
+        TaskManager::PrintJobStatistics (cout);
+    }
+  } job_statistics_printer;
+
+
+  void TaskGraph :: Run (const function<void(int)> & func) const
+  {
+    size_t n = Size();
+    if (n == 0) return;
+
+    Array<atomic<int>> cnt_pred(n);
+    for (size_t i : Range(n))
+      cnt_pred[i].store (num_pred[i], memory_order_relaxed);
+
+    Array<int> ready;
+    for (size_t i : Range(n))
+      if (num_pred[i] == 0)
+        ready.Append (i);
+
+    if (!task_manager || TaskManager::GetNumThreads() == 1)
+      {
+        while (ready.Size())
+          {
+            int nr = ready.Last();
+            ready.DeleteLast();
+            func(nr);
+            for (int j : Successors(nr))
+              if (--cnt_pred[j] == 0)
+                ready.Append(j);
+          }
+        return;
+      }
+
+    // a queue per run, such that nested graphs don't mix their tasks
+    moodycamel::ConcurrentQueue<int> queue;
+    atomic<size_t> cnt_final(0);
+    atomic<bool> failed(false);
+    SharedLoop sl(Range(ready));
+
+    ParallelJob
+      ([&] (TaskInfo & ti)
+       {
+         moodycamel::ProducerToken ptoken(queue);
+         moodycamel::ConsumerToken ctoken(queue);
+
+         for (int i : sl)
+           queue.enqueue (ptoken, ready[i]);
+
+         size_t my_final = 0;
+         while (cnt_final < num_final && !failed)
+           {
+             int nr;
+             if (!queue.try_dequeue_from_producer(ptoken, nr))
+               if (!queue.try_dequeue(ctoken, nr))
+                 {
+                   if (my_final)
+                     {
+                       cnt_final += my_final;
+                       my_final = 0;
+                     }
+                   while (ProcessTask()); // do the nested tasks
+                   continue;
+                 }
+
+             try
+               {
+                 func(nr);
+               }
+             catch (Exception & e)
+               {
+                 failed = true;
+                 throw;
+               }
+
+             auto succ_nr = Successors(nr);
+             if (succ_nr.Size() == 0)
+               my_final++;
+             for (int j : succ_nr)
+               if (--cnt_pred[j] == 0)
+                 queue.enqueue (ptoken, j);
+           }
+       });
+  }
+
+
   list<tuple<string,double>> TaskManager :: Timing ()
   {
     /*
@@ -638,6 +1019,22 @@ namespace ngstd
     while (time < maxtime);
     timings.push_back(make_tuple("ParallelJob 100 task/thread", time/steps*1e9));
 
+    bool old_stealing = use_work_stealing;
+    use_work_stealing = true;
+    starttime = WallTime();
+    steps = 0;
+    do
+      {
+        for (size_t i = 0; i < 1000; i++)
+          ParallelJob ( [] (TaskInfo ti) { ; },
+                        TasksPerThread(100));
+        steps += 1000;
+        time = WallTime()-starttime;
+      }
+    while (time < maxtime);
+    use_work_stealing = old_stealing;
+    timings.push_back(make_tuple("ParallelJob 100 task/thread, work stealing", time/steps*1e9));
+
     
     starttime = WallTime();
     steps = 0;
@@ -29,6 +29,35 @@ namespace ngstd
     // int nnodes;
   };
 
+
+  /**
+     Statistics of the parallel jobs started at one call site, recorded
+     if TaskManager::SetJobStatistics is on, separately for every number
+     of threads. The call site is found from the type of the job
+     function, e.g. the lambda passed to ParallelFor.
+   */
+  class JobStatistics
+  {
+  public:
+    string name;
+    int nthreads = 1;
+    size_t calls = 0;
+    size_t tasks = 0;
+    /// wall time of the jobs
+    double time = 0;
+    /// time in tasks, summed over the threads
+    double busy = 0;
+    /// time of the busiest thread, summed over the calls
+    double maxbusy = 0;
+    /// time without a task, per thread
+    Array<double> idle;
+
+    /// busiest thread over average thread, 1 for perfect balance
+    double Imbalance () const { return busy > 0 ? maxbusy * nthreads / busy : 1; }
+    /// fraction of the thread time spent in tasks
+    double Efficiency () const { return time > 0 ? busy / (time * nthreads) : 0; }
+  };
+
   NGS_DLL_HEADER extern class TaskManager * task_manager;
   
   class TaskManager
@@ -41,6 +70,58 @@ namespace ngstd
       atomic<int> start_cnt{0};
       atomic<int> participate{0};
     };
+
+    // Chase-Lev deque of task numbers used by the work-stealing mode.
+    // Tasks never spawn new tasks, so the entries are always the
+    // contiguous range first+[top,bottom) and no buffer is needed.
+    class alignas(64) TaskDeque : public AlignedAlloc<TaskDeque>
+    {
+      atomic<int> top{0};
+      atomic<int> bottom{0};
+      int first = 0;
+    public:
+      // must not be called while a job is running
+      void Reset (IntRange r)
+      {
+        first = r.First();
+        top.store (0, memory_order_relaxed);
+        bottom.store (r.Size(), memory_order_relaxed);
+      }
+
+      // owner takes from the bottom
+      bool Pop (int & task)
+      {
+        int b = bottom.load(memory_order_relaxed) - 1;
+        bottom.store (b, memory_order_relaxed);
+        atomic_thread_fence (memory_order_seq_cst);
+        int t = top.load(memory_order_relaxed);
+        if (t > b)
+          {
+            bottom.store (b+1, memory_order_relaxed);
+            return false;
+          }
+        task = first+b;
+        if (t < b) return true;
+
+        // last entry, race against the thieves
+        bool won = top.compare_exchange_strong (t, t+1, memory_order_seq_cst,
+                                                memory_order_relaxed);
+        bottom.store (b+1, memory_order_relaxed);
+        return won;
+      }
+
+      // thieves take from the top
+      bool Steal (int & task)
+      {
+        int t = top.load(memory_order_acquire);
+        atomic_thread_fence (memory_order_seq_cst);
+        int b = bottom.load(memory_order_acquire);
+        if (t >= b) return false;
+        task = first+t;
+        return top.compare_exchange_strong (t, t+1, memory_order_seq_cst,
+                                            memory_order_relaxed);
+      }
+    };
     
     static const function<void(TaskInfo&)> * func;
     static const function<void()> * startup_function;
@@ -60,6 +141,21 @@ namespace ngstd
 
     static NodeData *nodedata[8];
 
+    NGS_DLL_HEADER static bool use_work_stealing;
+    NGS_DLL_HEADER static bool pin_threads;
+    static TaskDeque * ws_deques;     // one per thread
+    static atomic<int> ws_remaining;  // tasks of the current job not finished yet
+
+    // ticks in tasks and number of tasks of the current job
+    class alignas(64) JobCounter : public AlignedAlloc<JobCounter>
+    {
+    public:
+      size_t ticks = 0;
+      size_t tasks = 0;
+    };
+    NGS_DLL_HEADER static bool use_job_statistics;
+    static JobCounter * job_counters;  // one per thread
+
     static int num_nodes;
     NGS_DLL_HEADER static int num_threads;
     NGS_DLL_HEADER static int max_threads;
@@ -97,6 +193,24 @@ namespace ngstd
     int GetNumNodes() const { return num_nodes; }
 
     static void SetPajeTrace (bool use)  { use_paje_trace = use; }
+
+    /// distribute tasks over per-thread deques with randomized stealing,
+    /// instead of the shared task counter (default from NGS_WORK_STEALING)
+    NGS_DLL_HEADER static void SetWorkStealing (bool use);
+    static bool GetWorkStealing () { return use_work_stealing; }
+
+    /// bind every thread to one core, filling the NUMA nodes one after
+    /// the other (default from NGS_PIN_THREADS). Takes effect on start-up
+    static void SetPinThreads (bool pin) { pin_threads = pin; }
+    static bool GetPinThreads () { return pin_threads; }
+
+    /// record time, idle time per thread and tasks of the parallel jobs,
+    /// by call site (default from NGS_JOB_STATISTICS, printed at exit)
+    NGS_DLL_HEADER static void SetJobStatistics (bool use);
+    static bool GetJobStatistics () { return use_job_statistics; }
+    /// the recorded statistics, the most expensive call site first
+    NGS_DLL_HEADER static Array<JobStatistics> CollectJobStatistics (bool reset = false);
+    NGS_DLL_HEADER static void PrintJobStatistics (ostream & ost);
     
     NGS_DLL_HEADER static void CreateJob (const function<void(TaskInfo&)> & afunc, 
                     int antasks = task_manager->GetNumThreads());
@@ -108,6 +222,26 @@ namespace ngstd
 
     void Done() { done = true; }
     void Loop(int thread_num);
+  private:
+    static void StealingLoop (TaskInfo & ti);
+    static void PinThread (int thd);
+    /// runs task ti.task_nr of the current job
+    static void RunTask (TaskInfo & ti)
+    {
+      RegionTracer t(ti.thread_nr, jobnr, RegionTracer::ID_JOB, ti.task_nr);
+      if (!use_job_statistics)
+        {
+          (*func)(ti);
+          return;
+        }
+      size_t start = __rdtsc();
+      (*func)(ti);
+      job_counters[ti.thread_nr].ticks += __rdtsc()-start;
+      job_counters[ti.thread_nr].tasks++;
+    }
+    static void RecordJobStatistics (const std::type_info & type, int antasks,
+                                     double wall, size_t wall_ticks);
+  public:
 
     static list<tuple<string,double>> Timing ();
   };
@@ -765,11 +899,147 @@ public:
   }
 
 
+  /*
+    Exclusive prefix sum in place, a[i] = start + a[0] + ... + a[i-1].
+    Returns start plus the sum of all entries.
+  */
+  template <typename T>
+  T ParallelPrefixSum (FlatArray<T> a, T start = T(0))
+  {
+    size_t n = a.Size();
+    Array<T> partial(TaskManager::GetNumThreads()+1);
+    partial = T(0);
+    ParallelJob ([&] (TaskInfo ti)
+                 {
+                   T sum(0);
+                   for (auto i : Range(n).Split(ti.task_nr, ti.ntasks))
+                     sum += a[i];
+                   partial[ti.task_nr+1] = sum;
+                 });
+    partial[0] = start;
+    for (size_t i = 1; i < partial.Size(); i++)
+      partial[i] += partial[i-1];
+    ParallelJob ([&] (TaskInfo ti)
+                 {
+                   T sum = partial[ti.task_nr];
+                   for (auto i : Range(n).Split(ti.task_nr, ti.ntasks))
+                     {
+                       T ai = a[i];
+                       a[i] = sum;
+                       sum += ai;
+                     }
+                 });
+    return partial.Last();
+  }
+
+
 
 
 
   
 
+  /*
+    Tasks with dependencies, forming a directed acyclic graph.
+    A task becomes ready as soon as all its predecessors are finished.
+    Ready tasks are taken from a concurrent queue by all threads,
+    there are no barriers between the levels of the graph.
+
+    Usage example:
+
+    TaskGraph graph(dag);     // dag[i] ... tasks waiting for task i
+    graph.Run ([&] (int i)
+    {
+      cout << "task " << i << endl;
+    });
+  */
+  class TaskGraph
+  {
+    Array<size_t> first_succ;
+    Array<int> succ;
+    Array<int> num_pred;
+    size_t num_final = 0;     // tasks without successors
+  public:
+    TaskGraph () = default;
+
+    template <typename TDAG>
+    TaskGraph (const TDAG & dag) { SetSuccessors (dag); }
+
+    /// dag[i] are the successors of task i (a Table, or an array of arrays)
+    template <typename TDAG>
+    void SetSuccessors (const TDAG & dag)
+    {
+      size_t n = dag.Size();
+      first_succ.SetSize (n+1);
+      first_succ[0] = 0;
+      for (size_t i = 0; i < n; i++)
+        first_succ[i+1] = first_succ[i] + dag[i].Size();
+
+      succ.SetSize (first_succ[n]);
+      num_pred.SetSize (n);
+      num_pred = 0;
+      num_final = 0;
+      for (size_t i = 0; i < n; i++)
+        {
+          size_t pos = first_succ[i];
+          for (int j : dag[i])
+            {
+              succ[pos++] = j;
+              num_pred[j]++;
+            }
+          if (first_succ[i+1] == first_succ[i])
+            num_final++;
+        }
+    }
+
+    size_t Size() const { return num_pred.Size(); }
+    FlatArray<int> Successors (size_t i) const { return succ.Range (first_succ[i], first_succ[i+1]); }
+    int NumPredecessors (size_t i) const { return num_pred[i]; }
+
+    /// calls func(i) for all tasks, respecting the dependencies
+    NGS_DLL_HEADER void Run (const function<void(int)> & func) const;
+  };
+
+
+
+  /*
+    Initialize freshly allocated memory in parallel, with the same task
+    distribution as a later ParallelFor over the same range or
+    partitioning. Due to the first-touch policy of the OS, the pages
+    are then placed on the NUMA node of the thread working on them.
+    Tasks run on the same node again if the TaskManager is compiled
+    with USE_NUMA (tasks are split per node), or runs with work
+    stealing and pinned threads (tasks start in the deque of their thread).
+  */
+  template <typename T>
+  INLINE void ParallelFirstTouch (FlatArray<T> a, T val = T(0))
+  {
+    if (a.Size() < 16384 || !task_manager)
+      {
+        a = val;
+        return;
+      }
+    ParallelForRange (a.Size(), [a,val] (IntRange r) { a.Range(r) = val; });
+  }
+
+  // entries of a[first[i], first[i+1]) are touched by the task working on item i
+  template <typename T, typename TFIRST>
+  INLINE void ParallelFirstTouch (FlatArray<T> a, const Partitioning & part,
+                                  FlatArray<TFIRST> first, T val = T(0))
+  {
+    if (a.Size() < 16384 || !task_manager)
+      {
+        a = val;
+        return;
+      }
+    ParallelForRange (part, [a,first,val] (IntRange r)
+                      {
+                        if (r.Size())
+                          a.Range(first[r.First()], first[r.Next()]) = val;
+                      });
+  }
+
+
+
   //  some suggar for working with arrays 
 
   template <typename T> template <typename T2>
@@ -874,6 +1144,8 @@ public:
     return *this;
   }
 
+  size_t OwnedBytes () const { return numa_size*sizeof(T); }
+
   void Swap (NumaInterleavedArray & b)
   {
     Array<T>::Swap(b);    
@@ -932,6 +1204,8 @@ public:
     return *this;
   }
 
+  size_t OwnedBytes () const { return numa_size*sizeof(T); }
+
   void Swap (NumaDistributedArray & b)
   {
     Array<T>::Swap(b);    
@@ -981,6 +1255,8 @@ public:
     return *this;
   }
 
+  size_t OwnedBytes () const { return numa_size*sizeof(T); }
+
   void Swap (NumaLocalArray & b)
   {
     Array<T>::Swap(b);    
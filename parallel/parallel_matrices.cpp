@@ -213,20 +213,20 @@ namespace ngla
 	cout << "now build graph" << endl;
 
 	// build matrix
-	DynamicTable<int> graph(num_glob_dofs);
+	ParallelDynamicTable<int> graph(num_glob_dofs);
 	cout << "n = " << num_glob_dofs << endl;
-	for (int i = 0; i < rows.Size(); i++)
+	ParallelFor (rows.Size(), [&] (size_t i)
 	  {
 	    int r = rows[i], c = cols[i];
 	    if (symmetric && (r < c)) swap (r, c);
 	    graph.AddUnique (r, c);
-	  }
+	  });
 
 	// *testout << "graphi = " << endl << graph << endl;
 
 	Array<int> els_per_row(num_glob_dofs);
-	for (int i = 0; i < num_glob_dofs; i++)
-	  els_per_row[i] = graph[i].Size();
+	ParallelFor (num_glob_dofs, [&] (size_t i)
+	  { els_per_row[i] = graph[i].Size(); });
 
 	cout << "now build matrix" << endl;
 
@@ -361,6 +361,47 @@ namespace ngla
 #else
     mat->SetInverseType(MASTERINVERSE);
 #endif
+    SplitRows();
+  }
+
+  void ParallelMatrix :: SplitRows ()
+  {
+    // symmetric matrices store only half of the rows
+    auto spmat = dynamic_cast<const SparseMatrix<double>*> (mat.get());
+    if (!spmat || dynamic_cast<const SparseMatrixSymmetric<double>*> (mat.get()))
+      return;
+    if (!row_paralleldofs || !col_paralleldofs) return;
+
+    interior_rows.SetSize0();
+    interface_rows.SetSize0();
+    for (int i = 0; i < spmat->Height(); i++)
+      {
+        bool interior = true;
+        for (int c : spmat->GetRowIndices(i))
+          if (row_paralleldofs->GetDistantProcs(c).Size())
+            {
+              interior = false;
+              break;
+            }
+        if (interior)
+          interior_rows.Append(i);
+        else
+          interface_rows.Append(i);
+      }
+    overlap = true;
+  }
+
+  void ParallelMatrix :: MultAddRows (double s, FlatArray<int> rows,
+                                      const BaseVector & x, BaseVector & y) const
+  {
+    auto & spmat = dynamic_cast<const SparseMatrix<double>&> (*mat);
+    FlatVector<double> fx = x.FVDouble();
+    FlatVector<double> fy = y.FVDouble();
+    ParallelForRange (IntRange(rows.Size()), [&] (IntRange r)
+                      {
+                        for (auto i : r)
+                          fy(rows[i]) += s * spmat.RowTimesVector (rows[i], fx);
+                      });
   }
 
   ParallelMatrix :: ParallelMatrix (shared_ptr<BaseMatrix> amat,
@@ -397,6 +438,24 @@ namespace ngla
 
   void ParallelMatrix :: MultAdd (double s, const BaseVector & x, BaseVector & y) const
   {
+    static Timer t("ParallelMatrix::MultAdd"); RegionTimer reg(t);
+    if (overlap && x.GetParallelStatus() == DISTRIBUTED)
+      {
+        /*
+          Distributed values of local dofs are already the cumulated 
+          ones. The interior rows are computed while the interface 
+          values are exchanged.
+        */
+        auto & px = dynamic_cast_ParallelBaseVector (x);
+        ParallelBaseVector::CumulateRequest req;
+        px.StartCumulate (req);
+        y.Distribute();
+        MultAddRows (s, interior_rows, x, y);
+        px.FinishCumulate (req);
+        MultAddRows (s, interface_rows, x, y);
+        return;
+      }
+
     x.Cumulate();
     y.Distribute();
     mat->MultAdd (s, x, y);
@@ -464,13 +523,31 @@ namespace ngla
     const SparseMatrixTM<TM> * dmat = dynamic_cast<const SparseMatrixTM<TM>*> (mat.get());
     if (!dmat) return NULL;
 
+    /*
+      The master process would hold the whole matrix and its factor. 
+      Above master_maxsize the factorization is distributed, unless 
+      masterinverse was asked for explicitly.
+    */
+    size_t nmaster = 0;
+    for (size_t i = 0; i < paralleldofs->GetNDofLocal(); i++)
+      if (paralleldofs->IsMasterDof(i) && (!subset || subset->Test(i)))
+        nmaster++;
+    size_t nglobal = MyMPI_AllReduce (nmaster, MPI_SUM, paralleldofs->GetCommunicator());
+    bool large = (nglobal > master_maxsize) && (mat->GetInverseType() != MASTERINVERSE);
+
 #ifdef USE_MUMPS
     bool symmetric = dynamic_cast<const SparseMatrixSymmetric<TM>*> (mat.get()) != NULL;
-    if (mat->GetInverseType() == MUMPS)
-      return make_shared<ParallelMumpsInverse<TM>> (*dmat, subset, nullptr, paralleldofs, symmetric);
-    else 
+    if (mat->GetInverseType() == MUMPS || large)
+      {
+        cout << IM(3) << "distributed coarse inverse, global size = " << nglobal << endl;
+        return make_shared<ParallelMumpsInverse<TM>> (*dmat, subset, nullptr, paralleldofs, symmetric);
+      }
+#else
+    if (large)
+      cout << IM(3) << "ParallelMatrix: no distributed direct solver available, gathering "
+           << nglobal << " dofs for MasterInverse" << endl;
 #endif
-      return make_shared<MasterInverse<TM>> (*dmat, subset, paralleldofs);
+    return make_shared<MasterInverse<TM>> (*dmat, subset, paralleldofs);
   }
 
 
@@ -542,7 +619,14 @@ namespace ngla
 
     this->jump_paralleldofs = make_shared<ParallelDofs>(paralleldofs->GetCommunicator(), move(dps));
 
-    return;
+    firstjump.Append (0);
+    for (auto p : paralleldofs->GetDistantProcs())
+      firstjump.Append (firstjump.Last() + paralleldofs->GetExchangeDofs(p).Size());
+  }
+
+  FETI_Jump_Matrix :: ~FETI_Jump_Matrix ()
+  {
+    FreeChannels();
   }
 
 
@@ -595,6 +679,87 @@ namespace ngla
     }
   }
 
+
+  void FETI_Jump_Matrix :: MultAdd (double s, const MultiVector & x, MultiVector & y) const
+  {
+    static Timer t("FETI_Jump::MultAdd (MultiVector)"); RegionTimer reg(t);
+    auto me = MyMPI_GetId(paralleldofs->GetCommunicator());
+    auto fx = x.FM();
+    auto fy = y.FM();
+    auto procs = paralleldofs->GetDistantProcs();
+    for (auto i : Range(procs))
+      {
+        double signed_s = (procs[i] < me) ? -s : s;
+        auto exdofs = paralleldofs->GetExchangeDofs(procs[i]);
+        for (auto k : Range(exdofs))
+          fy.Row(firstjump[i]+k) += signed_s * fx.Row(exdofs[k]);
+      }
+  }
+
+  void FETI_Jump_Matrix :: MultTransAdd (double s, const MultiVector & x, MultiVector & y) const
+  {
+    static Timer t("FETI_Jump::MultTransAdd (MultiVector)"); RegionTimer reg(t);
+    auto me = MyMPI_GetId(paralleldofs->GetCommunicator());
+    auto procs = paralleldofs->GetDistantProcs();
+    size_t width = x.NumVectors();
+    auto fx = x.FM();
+    auto fy = y.FM();
+    if (!procs.Size()) return;
+
+    InitChannels (width);
+    FlatMatrix<double> (firstjump.Last(), width, &sendbuf[0]) = fx;
+    MPI_Startall (recvrequests.Size(), &recvrequests[0]);
+    MPI_Startall (sendrequests.Size(), &sendrequests[0]);
+
+    auto add_jumps = [&] (int i, FlatMatrix<double> jumps)
+      {
+        double signed_s = (procs[i] < me) ? -s : s;
+        auto exdofs = paralleldofs->GetExchangeDofs(procs[i]);
+        for (auto k : Range(exdofs))
+          fy.Row(exdofs[k]) += signed_s * jumps.Row(k);
+      };
+
+    // own jumps first, then the neighbours' in the order they arrive
+    for (auto i : Range(procs))
+      add_jumps (i, fx.Rows(firstjump[i], firstjump[i+1]));
+    for (size_t cnt = 0; cnt < procs.Size(); cnt++)
+      {
+        int i = MyMPI_WaitAny (recvrequests);
+        add_jumps (i, FlatMatrix<double> (firstjump[i+1]-firstjump[i], width,
+                                          &recvbuf[firstjump[i]*width]));
+      }
+    MyMPI_WaitAll (sendrequests);
+  }
+
+  void FETI_Jump_Matrix :: InitChannels (size_t width) const
+  {
+    if (width == channel_width) return;
+    FreeChannels();
+
+    auto comm = paralleldofs->GetCommunicator();
+    auto procs = paralleldofs->GetDistantProcs();
+    sendbuf.SetSize (firstjump.Last()*width);
+    recvbuf.SetSize (firstjump.Last()*width);
+    sendrequests.SetSize (procs.Size());
+    recvrequests.SetSize (procs.Size());
+    for (auto i : Range(procs))
+      {
+        int cnt = (firstjump[i+1]-firstjump[i]) * width;
+        MPI_Send_init (&sendbuf[firstjump[i]*width], cnt, MPI_DOUBLE, procs[i],
+                       MPI_TAG_SOLVE, comm, &sendrequests[i]);
+        MPI_Recv_init (&recvbuf[firstjump[i]*width], cnt, MPI_DOUBLE, procs[i],
+                       MPI_TAG_SOLVE, comm, &recvrequests[i]);
+      }
+    channel_width = width;
+  }
+
+  void FETI_Jump_Matrix :: FreeChannels () const
+  {
+    if (!channel_width) return;
+    for (auto & req : sendrequests) MPI_Request_free (&req);
+    for (auto & req : recvrequests) MPI_Request_free (&req);
+    channel_width = 0;
+  }
   
   AutoVector FETI_Jump_Matrix :: CreateRowVector () const
   {
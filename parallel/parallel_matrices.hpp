@@ -43,6 +43,18 @@ namespace ngla
 
     shared_ptr<ParallelDofs> row_paralleldofs, col_paralleldofs;
 
+    /// rows coupling only to local dofs, and rows coupling to exchange dofs
+    Array<int> interior_rows, interface_rows;
+    /// MultAdd overlaps the exchange with the interior rows
+    bool overlap = false;
+
+    /// larger coarse problems are not gathered to rank 0
+    size_t master_maxsize = 50000;
+
+    void SplitRows ();
+    void MultAddRows (double s, FlatArray<int> rows,
+                      const BaseVector & x, BaseVector & y) const;
+
   public:
     ParallelMatrix (shared_ptr<BaseMatrix> amat, shared_ptr<ParallelDofs> apardofs);
     // : mat(*amat), pardofs(*apardofs) 
@@ -74,6 +86,13 @@ namespace ngla
     shared_ptr<ParallelDofs> GetRowParallelDofs () const { return row_paralleldofs; }
     shared_ptr<ParallelDofs> GetColParallelDofs () const { return col_paralleldofs; }
 
+    /**
+       Global size up to which the inverse is computed by MasterInverse.
+       Larger problems are factorized distributed by MUMPS, if available.
+    */
+    void SetMasterInverseMaxSize (size_t asize) { master_maxsize = asize; }
+    size_t GetMasterInverseMaxSize () const { return master_maxsize; }
+
     virtual shared_ptr<BaseMatrix> InverseMatrix (shared_ptr<BitArray> subset = 0) const override;
     template <typename TM>
     shared_ptr<BaseMatrix> InverseMatrixTM (shared_ptr<BitArray> subset = 0) const;
@@ -89,10 +108,20 @@ namespace ngla
   {
   public:
     FETI_Jump_Matrix (shared_ptr<ParallelDofs> pardofs, shared_ptr<ParallelDofs> au_paralleldofs = nullptr);
+    virtual ~FETI_Jump_Matrix ();
     
     virtual bool IsComplex() const override { return false; }
     virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const override;
     virtual void MultTransAdd (double s, const BaseVector & x, BaseVector & y) const override;
+
+    /// jumps of all vectors, the rows of y are distributed jumps
+    virtual void MultAdd (double s, const MultiVector & x, MultiVector & y) const override;
+    /**
+       y += s B^T x for distributed jumps x. One message per neighbour
+       carries the jumps of all vectors, through persistent channels.
+       The own jumps are added while the messages are in flight.
+     */
+    virtual void MultTransAdd (double s, const MultiVector & x, MultiVector & y) const override;
     
     virtual AutoVector CreateRowVector () const override;
     virtual AutoVector CreateColVector () const override;
@@ -108,6 +137,15 @@ namespace ngla
     shared_ptr<ParallelDofs> jump_paralleldofs;
     shared_ptr<ParallelDofs> u_paralleldofs;
 
+    /// first jump of every distant proc, the jumps of a proc are contiguous
+    Array<size_t> firstjump;
+
+    /// persistent channels for the jumps of channel_width vectors
+    void InitChannels (size_t width) const;
+    void FreeChannels () const;
+    mutable size_t channel_width = 0;
+    mutable Array<double> sendbuf, recvbuf;
+    mutable Array<MPI_Request> sendrequests, recvrequests;
   };
 
 #endif
@@ -72,6 +72,23 @@ namespace ngla
     { return local_vec; }
     
     virtual void Cumulate () const; 
+
+    /// exchange of a distributed vector in flight, see StartCumulate
+    struct CumulateRequest
+    {
+      Array<int> exprocs;
+      Array<MPI_Request> sendrequest, recvrequest;
+      bool active = false;
+    };
+
+    /**
+       Cumulate split in two: StartCumulate posts the non-blocking 
+       exchange of the interface values, FinishCumulate waits and adds
+       them. Between the two calls the vector may be read, but not
+       written.
+    */
+    virtual void StartCumulate (CumulateRequest & req) const;
+    virtual void FinishCumulate (CumulateRequest & req) const;
     
     virtual void Distribute() const = 0;
     // { cerr << "ERROR -- Distribute called for BaseVector, is not parallel" << endl; }
@@ -170,6 +187,21 @@ namespace ngla
 
     Table<SCAL> * recvvalues;
 
+    /**
+       Packed interface values and persistent requests for Cumulate.
+       They are set up at the first exchange and kept as long as the
+       parallel dofs do not change.
+     */
+    mutable Table<SCAL> sendvalues;
+    mutable Array<int> persistent_procs;
+    mutable Array<MPI_Request> persistent_send, persistent_recv;
+    mutable bool exchange_initialized = false;
+
+    /// the same buffers, exchanged by one neighborhood collective
+    mutable bool exchange_neighbor = false;
+    mutable Array<int> neighbor_counts, neighbor_displs;
+    mutable MPI_Request neighbor_request;
+
     using S_BaseVectorPtr<TSCAL> :: pdata;
     using ParallelBaseVector :: local_vec;
 
@@ -180,6 +212,10 @@ namespace ngla
     virtual ~S_ParallelBaseVectorPtr ();
     virtual void SetParallelDofs (shared_ptr<ParallelDofs> aparalleldofs, const Array<int> * procs=0 );
 
+    /// packs the interface values, and starts the persistent requests
+    virtual void StartCumulate (ParallelBaseVector::CumulateRequest & req) const;
+    virtual void FinishCumulate (ParallelBaseVector::CumulateRequest & req) const;
+
     virtual void Distribute() const;
     virtual ostream & Print (ostream & ost) const;
 
@@ -189,6 +225,10 @@ namespace ngla
     virtual AutoVector CreateVector () const;
 
     virtual double L2Norm () const;
+
+  private:
+    void InitPersistentRequests () const;
+    void FreePersistentRequests () const;
   };
  
 
@@ -251,6 +291,55 @@ namespace ngla
     virtual ~ParallelVFlatVector() throw()
     { ; }
   };
+
+
+
+#ifdef CUDA
+  class DevParallelDofs;
+
+  /**
+     Distributed vector with host and device copies. Cumulate packs the
+     interface values with device kernels. With CUDA-aware MPI the device
+     buffers are sent directly, otherwise only the packed interface
+     values are staged through the host, never the whole vector.
+     CUDA-awareness is queried from the MPI library, or set by the
+     environment variable NGS_CUDA_AWARE_MPI=0/1.
+  */
+  class NGS_DLL_HEADER ParallelUnifiedVector : public UnifiedVector, 
+                                               public ParallelBaseVector
+  {
+    shared_ptr<DevParallelDofs> devdofs;
+    /// packed interface values on the device, and their host copies
+    double * dev_sendbuf = nullptr;
+    double * dev_recvbuf = nullptr;
+    mutable Array<double> host_sendbuf, host_recvbuf;
+
+  public:
+    ParallelUnifiedVector (shared_ptr<ParallelDofs> aparalleldofs,
+                           PARALLEL_STATUS astatus = CUMULATED);
+    virtual ~ParallelUnifiedVector ();
+
+    virtual void SetParallelDofs (shared_ptr<ParallelDofs> aparalleldofs, 
+				  const Array<int> * procs = 0) override;
+
+    virtual BaseVector & SetScalar (double scal) override;
+    virtual BaseVector & Set (double scal, const BaseVector & v) override;
+    virtual BaseVector & Add (double scal, const BaseVector & v) override;
+    virtual double InnerProduct (const BaseVector & v2) const override;
+    virtual double L2Norm () const override;
+
+    virtual void Distribute() const override;
+    virtual void StartCumulate (CumulateRequest & req) const override;
+    virtual void FinishCumulate (CumulateRequest & req) const override;
+    virtual void IRecvVec (int dest, MPI_Request & request) override;
+    virtual void AddRecvValues (int sender) override;
+
+    virtual AutoVector CreateVector () const override;
+  };
+
+  /// true if MPI can send from and receive into device memory
+  NGS_DLL_HEADER bool CudaAwareMPI ();
+#endif
 }
 
 #endif
@@ -108,34 +108,51 @@ namespace ngla
 
   void ParallelBaseVector :: Cumulate () const
   {
+    CumulateRequest req;
+    StartCumulate (req);
+    FinishCumulate (req);
+  }
+
+  void ParallelBaseVector :: StartCumulate (CumulateRequest & req) const
+  {
+    req.active = false;
     if (status != DISTRIBUTED) return;
     
     int ntasks = paralleldofs->GetNTasks();
-    Array<int> exprocs;
+    req.exprocs.SetSize0();
     for (int i = 0; i < ntasks; i++)
       if (paralleldofs -> GetExchangeDofs (i).Size())
-	exprocs.Append(i);
+	req.exprocs.Append(i);
     
-    int nexprocs = exprocs.Size();
+    int nexprocs = req.exprocs.Size();
     
     ParallelBaseVector * constvec = const_cast<ParallelBaseVector * > (this);
     
-    Array<MPI_Request> sendrequest(nexprocs), recvrequest(nexprocs);
+    req.sendrequest.SetSize(nexprocs);
+    req.recvrequest.SetSize(nexprocs);
 
     for (int idest = 0; idest < nexprocs; idest ++ ) 
-      constvec->ISend (exprocs[idest], sendrequest[idest] );
+      constvec->ISend (req.exprocs[idest], req.sendrequest[idest] );
     for (int isender=0; isender < nexprocs; isender++)
-      constvec -> IRecvVec (exprocs[isender], recvrequest[isender] );
-    
-    MyMPI_WaitAll (sendrequest);
+      constvec -> IRecvVec (req.exprocs[isender], req.recvrequest[isender] );
+    req.active = true;
+  }
+
+  void ParallelBaseVector :: FinishCumulate (CumulateRequest & req) const
+  {
+    if (!req.active) return;
+    ParallelBaseVector * constvec = const_cast<ParallelBaseVector * > (this);
+
+    MyMPI_WaitAll (req.sendrequest);
     
     // cumulate
-    for (int cntexproc=0; cntexproc < nexprocs; cntexproc++)
+    for (int cntexproc=0; cntexproc < req.exprocs.Size(); cntexproc++)
       {
-	int isender = MyMPI_WaitAny (recvrequest);
-	constvec->AddRecvValues(exprocs[isender]);
+	int isender = MyMPI_WaitAny (req.recvrequest);
+	constvec->AddRecvValues(req.exprocs[isender]);
       } 
 
+    req.active = false;
     SetStatus(CUMULATED);
   }
 
@@ -144,6 +161,9 @@ namespace ngla
   void ParallelBaseVector :: ISend ( int dest, MPI_Request & request ) const
   {
     MPI_Datatype mpi_t = this->paralleldofs->MyGetMPI_Type(dest);
+    int size;
+    MPI_Type_size (mpi_t, &size);
+    MPIStatistics::Get().AddBytes (MPIStatistics::SEND, size);
     MPI_Isend( Memory(), 1, mpi_t, dest, MPI_TAG_SOLVE, this->paralleldofs->GetCommunicator(), &request);
   }
 
@@ -253,6 +273,7 @@ namespace ngla
   template <class SCAL>
   S_ParallelBaseVectorPtr<SCAL> :: ~S_ParallelBaseVectorPtr ()
   {
+    FreePersistentRequests();
     delete recvvalues;
   }
 
@@ -263,6 +284,7 @@ namespace ngla
   {
     if (this->paralleldofs == aparalleldofs) return;
 
+    FreePersistentRequests();
     this -> paralleldofs = aparalleldofs;
     if ( this -> paralleldofs == 0 ) return;
     
@@ -288,6 +310,147 @@ namespace ngla
 
 
 
+  template <typename SCAL>
+  void S_ParallelBaseVectorPtr<SCAL> :: InitPersistentRequests () const
+  {
+    MPI_Datatype MPI_TS = MyGetMPIType<TSCAL> ();
+    MPI_Comm comm = paralleldofs->GetCommunicator();
+
+    int ntasks = paralleldofs->GetNTasks();
+    Array<int> exdofs(ntasks);
+    for (int i = 0; i < ntasks; i++)
+      exdofs[i] = this->es * paralleldofs->GetExchangeDofs(i).Size();
+    sendvalues = Table<TSCAL> (exdofs);
+
+    persistent_procs.SetSize0();
+    for (int i = 0; i < ntasks; i++)
+      if (exdofs[i]) persistent_procs.Append (i);
+
+    exchange_initialized = true;
+    exchange_neighbor = paralleldofs->UsesNeighborCollectives();
+    if (exchange_neighbor)
+      {
+        // neighbors are ordered as the procs, as are the rows of the tables
+        neighbor_counts.SetSize (persistent_procs.Size());
+        neighbor_displs.SetSize (persistent_procs.Size());
+        int displ = 0;
+        for (int i : Range(persistent_procs))
+          {
+            neighbor_counts[i] = exdofs[persistent_procs[i]];
+            neighbor_displs[i] = displ;
+            displ += neighbor_counts[i];
+          }
+        return;
+      }
+
+    persistent_send.SetSize (persistent_procs.Size());
+    persistent_recv.SetSize (persistent_procs.Size());
+    for (int i : Range(persistent_procs))
+      {
+        int p = persistent_procs[i];
+        MPI_Send_init (&sendvalues[p][0], sendvalues[p].Size(), MPI_TS, p, 
+                       MPI_TAG_SOLVE, comm, &persistent_send[i]);
+        MPI_Recv_init (&(*recvvalues)[p][0], (*recvvalues)[p].Size(), MPI_TS, p, 
+                       MPI_TAG_SOLVE, comm, &persistent_recv[i]);
+      }
+  }
+
+  template <typename SCAL>
+  void S_ParallelBaseVectorPtr<SCAL> :: FreePersistentRequests () const
+  {
+    for (auto & r : persistent_send) MPI_Request_free (&r);
+    for (auto & r : persistent_recv) MPI_Request_free (&r);
+    persistent_send.SetSize0();
+    persistent_recv.SetSize0();
+    persistent_procs.SetSize0();
+    exchange_initialized = false;
+  }
+
+  template <typename SCAL>
+  void S_ParallelBaseVectorPtr<SCAL> :: StartCumulate (ParallelBaseVector::CumulateRequest & req) const
+  {
+    req.active = false;
+    if (status != DISTRIBUTED) return;
+
+    static Timer t("ParallelVector::StartCumulate"); RegionTimer reg(t);
+    if (exchange_initialized && exchange_neighbor != paralleldofs->UsesNeighborCollectives())
+      FreePersistentRequests();
+    if (!exchange_initialized)
+      InitPersistentRequests();
+
+    // the send buffers are the exchange dofs of all procs, in one piece
+    FlatArray<int> exdofs = paralleldofs->GetAllExchangeDofs();
+    FlatArray<TSCAL> buf = sendvalues.AsArray();
+    const TSCAL * data = (const TSCAL*)pdata;
+    int es = this->es;
+    ParallelForRange (IntRange(exdofs.Size()), [&] (IntRange r)
+                      {
+                        for (auto i : r)
+                          for (int j = 0; j < es; j++)
+                            buf[i*es+j] = data[exdofs[i]*es+j];
+                      });
+    // the same number of values comes back
+    MyMPI_CountBytes<TSCAL> (MPIStatistics::SEND, buf.Size());
+    MyMPI_CountBytes<TSCAL> (MPIStatistics::RECV, buf.Size());
+
+    if (exchange_neighbor)
+      {
+        MPI_Datatype MPI_TS = MyGetMPIType<TSCAL> ();
+        FlatArray<TSCAL> rbuf = recvvalues->AsArray();
+        int nn = neighbor_counts.Size();
+        MPI_Ineighbor_alltoallv (nn ? &buf[0] : nullptr, nn ? &neighbor_counts[0] : nullptr,
+                                 nn ? &neighbor_displs[0] : nullptr, MPI_TS,
+                                 nn ? &rbuf[0] : nullptr, nn ? &neighbor_counts[0] : nullptr,
+                                 nn ? &neighbor_displs[0] : nullptr, MPI_TS,
+                                 paralleldofs->GetNeighborCommunicator(), &neighbor_request);
+        req.active = true;
+        return;
+      }
+
+    if (persistent_recv.Size())
+      MPI_Startall (persistent_recv.Size(), &persistent_recv[0]);
+    if (persistent_send.Size())
+      MPI_Startall (persistent_send.Size(), &persistent_send[0]);
+    req.active = true;
+  }
+
+  template <typename SCAL>
+  void S_ParallelBaseVectorPtr<SCAL> :: FinishCumulate (ParallelBaseVector::CumulateRequest & req) const
+  {
+    if (!req.active) return;
+    static Timer t("ParallelVector::FinishCumulate"); RegionTimer reg(t);
+
+    auto constvec = const_cast<S_ParallelBaseVectorPtr<SCAL>*> (this);
+    TSCAL * data = (TSCAL*)pdata;
+    int es = this->es;
+    if (exchange_neighbor)
+      {
+        RegionTimer rw(MPIStatistics::Get().GetTimer(MPIStatistics::WAIT));
+        MPI_Wait (&neighbor_request, MPI_STATUS_IGNORE);
+      }
+    int nrecv = exchange_neighbor ? persistent_procs.Size() : persistent_recv.Size();
+    for (int cnt = 0; cnt < nrecv; cnt++)
+      {
+        int sender = exchange_neighbor ? persistent_procs[cnt] 
+          : persistent_procs[MyMPI_WaitAny (persistent_recv)];
+        // a dof appears once per sender, the adds of one sender do not collide
+        FlatArray<int> exdofs = paralleldofs->GetExchangeDofs(sender);
+        FlatArray<TSCAL> rec = (*constvec->recvvalues)[sender];
+        ParallelForRange (IntRange(exdofs.Size()), [&] (IntRange r)
+                          {
+                            for (auto i : r)
+                              for (int j = 0; j < es; j++)
+                                data[exdofs[i]*es+j] += rec[i*es+j];
+                          });
+      }
+    MyMPI_WaitAll (persistent_send);
+
+    req.active = false;
+    this->SetStatus(CUMULATED);
+  }
+
+
+
   template < class SCAL >
   ostream & S_ParallelBaseVectorPtr<SCAL> :: Print (ostream & ost) const
   {
@@ -301,6 +464,7 @@ namespace ngla
   void S_ParallelBaseVectorPtr<SCAL> :: IRecvVec ( int dest, MPI_Request & request )
   {
     MPI_Datatype MPI_TS = MyGetMPIType<TSCAL> ();
+    MyMPI_CountBytes<TSCAL> (MPIStatistics::RECV, (*recvvalues)[dest].Size());
     MPI_Irecv( &( (*recvvalues)[dest][0]), 
 	       (*recvvalues)[dest].Size(), 
 	       MPI_TS, dest, 
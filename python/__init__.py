@@ -30,7 +30,7 @@ del TmpRedraw
 
 
 
-ngstd.__all__ = ['ArrayD', 'ArrayI', 'BitArray', 'Flags', 'HeapReset', 'IntRange', 'LocalHeap', 'Timers', 'RunWithTaskManager', 'TaskManager', 'SetNumThreads', 'MPI_Init']
+ngstd.__all__ = ['ArrayD', 'ArrayI', 'BitArray', 'Flags', 'HeapReset', 'IntRange', 'LocalHeap', 'Timers', 'Timer', 'ResetTimers', 'SetRoofline', 'EventLog', 'SetEventLog', 'MemoryRegistry', 'PrintMemoryRegistry', 'SetJobStatistics', 'JobStatistics', 'PrintJobStatistics', 'RunWithTaskManager', 'TaskManager', 'SetNumThreads', 'MPI_Init']
 bla.__all__ = ['Matrix', 'Vector', 'InnerProduct', 'Norm']
 la.__all__ = ['BaseMatrix', 'BaseVector', 'BlockVector', 'BlockMatrix', 'CreateVVector', 'InnerProduct', 'CGSolver', 'QMRSolver', 'GMRESSolver', 'ArnoldiSolver', 'Projector', 'IdentityMatrix']
 fem.__all__ =  ['BFI', 'CoefficientFunction', 'Parameter', 'CoordCF', 'ET', 'ElementTransformation', 'ElementTopology', 'FiniteElement', 'ScalarFE', 'H1FE', 'HEX', 'L2FE', 'LFI', 'POINT', 'PRISM', 'PYRAMID', 'QUAD', 'SEGM', 'TET', 'TRIG', 'VERTEX', 'EDGE', 'FACE', 'CELL', 'ELEMENT', 'FACET', 'SetPMLParameters', 'sin', 'cos', 'tan', 'atan', 'acos', 'asin', 'exp', 'log', 'sqrt', 'floor', 'ceil', 'Conj', 'atan2', 'pow', 'specialcf', \
@@ -51,8 +51,9 @@ from ngsolve.utils import *
 from . import timing
 
 
-# add flags docu to docstring
-all_classes = comp.__dict__
+# add flags docu to docstring, not needed without docstrings (python -OO)
+import sys
+all_classes = comp.__dict__ if sys.flags.optimize < 2 else {}
 for classname in all_classes:
     instance = all_classes[classname]
     try:
@@ -96,7 +97,16 @@ finite element shape functions, and element-matrix/vector integrators
 # register our own memory pickler
 import pickle
 import ngsolve
-pickle._Pickler.dispatch[ngsolve.ngstd._MemoryView] = ngsolve.ngstd._PickleMemory
+def _PickleMemory(pickler, view):
+    # protocol 5 passes the memory as PickleBuffer, with a buffer_callback
+    # it goes out-of-band and is not copied
+    if pickler.proto >= 5 and hasattr(pickle, "PickleBuffer"):
+        pickler.save_reduce(_UnpickleBuffer, (pickle.PickleBuffer(ngsolve.ngstd._MemoryViewBuffer(view)),))
+    else:
+        ngsolve.ngstd._PickleMemory(pickler, view)
+def _UnpickleBuffer(buffer):
+    return ngsolve.ngstd._MemoryViewFromBuffer(buffer)
+pickle._Pickler.dispatch[ngsolve.ngstd._MemoryView] = _PickleMemory
 pickle._Unpickler.dispatch[b"\xf0"[0]] = ngsolve.ngstd._UnpickleMemory
 # use the python pickler and not cPickle one (cause we can't patch it)
 pickle.Pickler, pickle.Unpickler = pickle._Pickler, pickle._Unpickler
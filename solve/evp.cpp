@@ -22,10 +22,12 @@ namespace ngsolve
 
     double prec, shift, shifti;
     bool print;
+    int blocksize;
+    string inverse;
 
     string filename;
 
-    enum SOLVER { DENSE, ARNOLDI };
+    enum SOLVER { DENSE, ARNOLDI, LOBPCG };
     SOLVER solver;
 
   public:
@@ -61,77 +63,107 @@ namespace ngsolve
     shift = flags.GetNumFlag ("shift",1); 
     shifti = flags.GetNumFlag ("shifti",0); 
 
+    prec = flags.GetNumFlag ("prec", 1e-8);
+    print = flags.GetDefineFlag ("printrates");
+    blocksize = int(flags.GetNumFlag ("blocksize", 1));
+    inverse = flags.GetStringFlag ("inverse", "");
+
     filename = flags.GetStringFlag ("filename","eigen.out"); 
 
     solver = ARNOLDI;
     if (flags.GetDefineFlag("dense")) solver = DENSE;
+    if (flags.GetDefineFlag("lobpcg")) solver = LOBPCG;
   }
 
 
 
   void NumProcEVP :: Do(LocalHeap & lh)
   {
-    if (solver == ARNOLDI)
+    if (solver == LOBPCG)
       {
-        cout << "new version using linalg - Arnoldi" << endl;
-
-        if (bfa->GetFESpace()->IsComplex())
+        // smallest eigenvalues, the preconditioner (e.g. multigrid, h1amg
+        // or bddc) replaces the factorization of the shifted matrix
+        const BaseMatrix & mata = bfa->GetMatrix();
+        const BaseMatrix & matm = bfm->GetMatrix();
+        if (mata.IsComplex() || matm.IsComplex())
+          throw Exception ("evp: lobpcg needs real matrices");
+
+        int nev = gfu->GetMultiDim();
+        BaseVector & vecu = gfu->GetVector(0);
+        auto hv = vecu.CreateVector();
+        MultiVector x(vecu.FVDouble().Size(), nev);
+        for (int i = 0; i < nev; i++)
           {
-            cout << "complex evp" << endl;
-            
-            Arnoldi<Complex> arnoldi (bfa->GetMatrix(), bfm->GetMatrix(), 
-                                      bfa->GetFESpace()->GetFreeDofs() );
-            arnoldi.SetShift (Complex(shift,shifti));
-            
-            int nev = gfu->GetMultiDim();
-            Array<shared_ptr<BaseVector>> evecs(nev);
-
-            Array<Complex> lam(nev);
+            hv->SetRandom();
             if (pre)
-              arnoldi.Calc (num, lam, nev, evecs, &pre->GetMatrix());
+              vecu = pre->GetMatrix() * *hv;
             else
-              arnoldi.Calc (num, lam, nev, evecs, 0);
-            
-            ofstream eigenout(filename.c_str());
-            eigenout.precision(16);
-            for (int i = 0; i < lam.Size(); ++i)
-              eigenout << lam[i].real() << "\t" << lam[i].imag() << "\t"
-                       << sqrt(lam[i]).real() << "\t" << sqrt(lam[i]).imag() 
-                       << endl;
-            
-            for (int i = 0; i < nev; i++)
-              gfu->GetVector(i) = *evecs[i];
+              vecu = *hv;
+            x.SetVector (i, vecu);
+          }
+
+        LOBPCGSolver lobpcg(mata, matm, pre ? &pre->GetMatrix() : nullptr,
+                            bfa->GetFESpace()->GetFreeDofs());
+        lobpcg.SetPrecision (prec);
+        lobpcg.SetMaxSteps (num);
+        lobpcg.SetPrintRates (print);
+        Vector<double> lam(nev);
+        lobpcg.Solve (x, lam);
+
+        ofstream eigenout(filename.c_str());
+        eigenout.precision(16);
+        for (int i = 0; i < nev; ++i)
+          eigenout << lam(i) << endl;
+
+        for (int i = 0; i < nev; i++)
+          x.GetVector (i, gfu->GetVector(i));
+
+        cout << "lam = " << endl << lam << endl;
+        return;
+      }
 
-            cout << "lam = " << endl << lam << endl;
+    if (solver == ARNOLDI)
+      {
+        cout << "shift-invert Arnoldi, blocksize = " << blocksize << endl;
+
+        int nev = gfu->GetMultiDim();
+        Array<shared_ptr<BaseVector>> evecs(nev);
+        Array<Complex> lam(nev);
+        bool iscomplex = bfa->GetFESpace()->IsComplex();
+
+        if (iscomplex)
+          {
+            ShiftInvertArnoldi<Complex> arnoldi (bfa->GetMatrix(), bfm->GetMatrix(), 
+                                                 bfa->GetFESpace()->GetFreeDofs(), inverse);
+            arnoldi.SetBlockSize (blocksize);
+            arnoldi.SetTolerance (prec);
+            arnoldi.SetShift (Complex(shift,shifti));
+            arnoldi.Calc (num, nev, lam, evecs);
           }
         else
           {
-            cout << "real evp" << endl;
-            Arnoldi<double> arnoldi (bfa->GetMatrix(), bfm->GetMatrix(), 
-                                     bfa->GetFESpace()->GetFreeDofs() );
+            ShiftInvertArnoldi<double> arnoldi (bfa->GetMatrix(), bfm->GetMatrix(), 
+                                                bfa->GetFESpace()->GetFreeDofs(), inverse);
+            arnoldi.SetBlockSize (blocksize);
+            arnoldi.SetTolerance (prec);
             arnoldi.SetShift (shift);
-            
-            int nev = gfu->GetMultiDim();
-            Array<shared_ptr<BaseVector>> evecs(nev);
-            // for (int i = 0; i  < nev; i++)
-            // evecs[i] = &gfu->GetVector(i);
-            Array<Complex> lam(nev);
-            if (pre)
-              arnoldi.Calc (num, lam, nev, evecs, &pre->GetMatrix());
-            else
-              arnoldi.Calc (num, lam, nev, evecs, 0);
-            
-            ofstream eigenout(filename.c_str());
-            eigenout.precision(16);
-            for (int i = 0; i < lam.Size(); ++i)
-              eigenout << lam[i].real() << "\t" << lam[i].imag() << endl;
-            
-            for (int i = 0; i < nev; i++)
-              gfu->GetVector(i) = *evecs[i];
+            arnoldi.Calc (num, nev, lam, evecs);
+          }
 
-            cout << "lam = " << endl << lam << endl;
+        ofstream eigenout(filename.c_str());
+        eigenout.precision(16);
+        for (int i = 0; i < lam.Size(); ++i)
+          {
+            eigenout << lam[i].real() << "\t" << lam[i].imag();
+            if (iscomplex)
+              eigenout << "\t" << sqrt(lam[i]).real() << "\t" << sqrt(lam[i]).imag();
+            eigenout << endl;
           }
-        
+            
+        for (int i = 0; i < evecs.Size(); i++)
+          gfu->GetVector(i) = *evecs[i];
+
+        cout << "lam = " << endl << lam << endl;
         return;
       }
 
@@ -9,7 +9,8 @@
 
   A u = lam M u
 
-  Uses a simultaneous preconditioned inverse iteration
+  Uses the block LOBPCG solver, or the older simultaneous 
+  preconditioned inverse iteration (flag -simultaneous)
 
  */
 
@@ -28,6 +29,7 @@ namespace ngsolve
     double prec;
     bool print;
     bool coarse;
+    bool simultaneous;
     string variable;
 
   public:
@@ -64,8 +66,16 @@ namespace ngsolve
 	"-gridfunction=<gfname>\n" 
 	"    a gridfunction. multidim=xx defines num of calculated ev\n"	\
 	"-preconditioner=<prename>\n" \
-	"    a preconditioner for the stiffness matrix\n" \
-	"-maxsteps=n\n" 
+	"    a preconditioner for the stiffness matrix, e.g. multigrid, h1amg or bddc\n" \
+	"Optional flags:\n" \
+	"-maxsteps=n\n" \
+	"    maximal number of iterations\n" \
+	"-prec=eps\n" \
+	"    relative residual of every eigenpair, default 1e-8\n" \
+	"-printrates\n" \
+	"    print the eigenvalue residuals in every step\n" \
+	"-simultaneous\n" \
+	"    use the old simultaneous iteration instead of LOBPCG\n" 
 	  << endl;
     }
   };
@@ -80,6 +90,9 @@ namespace ngsolve
     gfu = apde->GetGridFunction (flags.GetStringFlag ("gridfunction", ""));
     pre = apde->GetPreconditioner (flags.GetStringFlag ("preconditioner", ""));
     maxsteps = int(flags.GetNumFlag ("maxsteps", 200));
+    prec = flags.GetNumFlag ("prec", 1e-8);
+    print = flags.GetDefineFlag ("printrates");
+    simultaneous = flags.GetDefineFlag ("simultaneous");
     variable = flags.GetStringFlag ("variable", "eigenvalue");
 
     maxnewton = int(flags.GetNumFlag ("maxnewton", 0));
@@ -96,6 +109,50 @@ namespace ngsolve
   {
     cout << "solve  evp" << endl;
 
+    if (!simultaneous)
+      {
+        const BaseMatrix & mata = bfa->GetMatrix();
+        const BaseMatrix & matm = bfm->GetMatrix();
+        if (mata.IsComplex() || matm.IsComplex())
+          throw Exception ("evpAM: LOBPCG needs real matrices, use -simultaneous");
+
+        int num = gfu -> GetMultiDim();
+        BaseVector & vecu = gfu->GetVector(0);
+        auto hv = vecu.CreateVector();
+
+        // random initial guess, in the range of the precond
+        MultiVector x(vecu.FVDouble().Size(), num);
+        for (int i = 0; i < num; i++)
+          {
+            hv->SetRandom();
+            if (pre)
+              vecu = pre->GetMatrix() * *hv;
+            else
+              vecu = *hv;
+            x.SetVector (i, vecu);
+          }
+
+        LOBPCGSolver solver(mata, matm, pre ? &pre->GetMatrix() : nullptr,
+                            bfa->GetFESpace()->GetFreeDofs());
+        solver.SetPrecision (prec);
+        solver.SetMaxSteps (maxsteps);
+        solver.SetPrintRates (print);
+        Vector<double> lami(num);
+        solver.Solve (x, lami);
+        cout << "LOBPCG: " << solver.GetSteps() << " steps" << endl;
+
+        cout.precision(16);
+        for (int i = 0; i < num; i++)
+          {
+            cout << "lam(" << i << ") = " << lami(i) << endl;
+            x.GetVector (i, gfu->GetVector(i));
+            stringstream vn;
+            vn << variable << i;
+            shared_ptr<PDE> (pde)->AddVariable (vn.str(), lami(i));
+          }
+        return;
+      }
+
     // simultaneous iteration without coarse grid
 
     const BaseMatrix & mata = bfa->GetMatrix();
@@ -0,0 +1,32 @@
+#ifndef FILE_NGS_BENCHMARK
+#define FILE_NGS_BENCHMARK
+
+#include <benchmark/benchmark.h>
+
+/*
+  Common helpers of the kernel benchmarks. The machine peak is
+  measured once in main.cpp, single threaded like the benchmarks.
+*/
+
+/// peak double precision FMA throughput of one core
+double PeakGFlops ();
+/// STREAM triad bandwidth of one core
+double PeakGBs ();
+
+/// flops and bytes moved by one iteration of the benchmark loop
+inline void SetKernelCounters (benchmark::State & state, double flops, double bytes)
+{
+  using benchmark::Counter;
+  if (flops > 0)
+    {
+      state.counters["GFlop/s"] = Counter(1e-9*flops, Counter::kIsIterationInvariantRate);
+      state.counters["%flops"] = Counter(1e-7*flops/PeakGFlops(), Counter::kIsIterationInvariantRate);
+    }
+  if (bytes > 0)
+    {
+      state.counters["GB/s"] = Counter(1e-9*bytes, Counter::kIsIterationInvariantRate);
+      state.counters["%bw"] = Counter(1e-7*bytes/PeakGBs(), Counter::kIsIterationInvariantRate);
+    }
+}
+
+#endif
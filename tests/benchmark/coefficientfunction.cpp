@@ -0,0 +1,54 @@
+#include "benchmark.hpp"
+#include <fem.hpp>
+
+using namespace ngfem;
+
+/*
+  SIMD evaluation of CoefficientFunction trees, interpreted and
+  compiled (without C++ code generation). The number of flops depends
+  on the tree, so only the points per second and the bytes of the
+  result are reported.
+*/
+
+static void BM_CFEvaluate (benchmark::State & state, shared_ptr<CoefficientFunction> cf)
+{
+  LocalHeap lh(1000000, "benchmark - cf");
+  FE_ElementTransformation<3,3> trafo(ET_TET);
+  SIMD_IntegrationRule simdir(ET_TET, state.range(0));
+  SIMD_MappedIntegrationRule<3,3> simdmir(simdir, trafo, lh);
+  Matrix<SIMD<double>> values(cf->Dimension(), simdir.Size());
+  for (auto _ : state)
+    {
+      cf->Evaluate (simdmir, values);
+      benchmark::DoNotOptimize(values(0,0));
+    }
+  state.counters["Points/s"] = benchmark::Counter(simdir.GetNIP(), benchmark::Counter::kIsIterationInvariantRate);
+  SetKernelCounters (state, 0, sizeof(SIMD<double>)*values.Height()*values.Width());
+}
+
+
+static int dummy_register = []()
+  {
+    auto x = MakeCoordinateCoefficientFunction(0);
+    auto y = MakeCoordinateCoefficientFunction(1);
+    auto z = MakeCoordinateCoefficientFunction(2);
+    auto xyz = MakeVectorialCoefficientFunction({x,y,z});
+    auto mat = MakeVectorialCoefficientFunction({x,y,z,y,z,x,z,x,y});
+    mat->SetDimensions (Array<int>({3,3}));
+
+    auto one = make_shared<ConstantCoefficientFunction> (1);
+    auto two = make_shared<ConstantCoefficientFunction> (2);
+
+    Array<string> names = { "poly", "quotient", "innerproduct", "matvec", "matmat" };
+    Array<shared_ptr<CoefficientFunction>> cfs =
+      { one+x*(two+y*(one+z*x)), (x+y)/(one+z*z), InnerProduct(xyz, xyz),
+        mat*xyz, mat*TransposeCF(mat) };
+
+    for (size_t i = 0; i < cfs.Size(); i++)
+      {
+        benchmark::RegisterBenchmark (("CF/"+names[i]).c_str(), BM_CFEvaluate, cfs[i])->Arg(2)->Arg(6);
+        benchmark::RegisterBenchmark (("CF/"+names[i]+"/compiled").c_str(), BM_CFEvaluate,
+                                      Compile(cfs[i], false))->Arg(2)->Arg(6);
+      }
+    return 0;
+  } ();
@@ -0,0 +1,91 @@
+#include "benchmark.hpp"
+#include <fem.hpp>
+
+using namespace ngfem;
+
+/*
+  SIMD kernels of the H1 and L2 high order elements, for all element
+  types and orders 1 ... 8.  Flops count one multiply-add per dof and
+  integration point, bytes count the shape matrix and the vectors.
+*/
+
+template <typename FEL>
+static void BM_CalcShape (benchmark::State & state, FEL fel)
+{
+  SIMD_IntegrationRule simdir(fel.ElementType(), 2*fel.Order());
+  Matrix<SIMD<double>> shape(fel.GetNDof(), simdir.Size());
+  for (auto _ : state)
+    {
+      fel.CalcShape (simdir, shape);
+      benchmark::DoNotOptimize(shape(0,0));
+    }
+  SetKernelCounters (state, 0, sizeof(SIMD<double>)*shape.Height()*shape.Width());
+}
+
+template <typename FEL>
+static void BM_Evaluate (benchmark::State & state, FEL fel)
+{
+  SIMD_IntegrationRule simdir(fel.ElementType(), 2*fel.Order());
+  Vector<> coefs(fel.GetNDof());
+  Vector<SIMD<double>> values(simdir.Size());
+  for (size_t i = 0; i < coefs.Size(); i++)
+    coefs(i) = 0.5*i;
+  for (auto _ : state)
+    {
+      fel.Evaluate (simdir, coefs, values);
+      benchmark::DoNotOptimize(values(0));
+    }
+  size_t nip = simdir.GetNIP();
+  SetKernelCounters (state, 2.0*fel.GetNDof()*nip, sizeof(double)*(fel.GetNDof()+nip));
+}
+
+template <typename FEL>
+static void BM_AddTrans (benchmark::State & state, FEL fel)
+{
+  SIMD_IntegrationRule simdir(fel.ElementType(), 2*fel.Order());
+  Vector<> coefs(fel.GetNDof());
+  Vector<SIMD<double>> values(simdir.Size());
+  values = SIMD<double>(1.0);
+  coefs = 0.0;
+  for (auto _ : state)
+    {
+      fel.AddTrans (simdir, values, coefs);
+      benchmark::DoNotOptimize(coefs(0));
+    }
+  size_t nip = simdir.GetNIP();
+  SetKernelCounters (state, 2.0*fel.GetNDof()*nip, sizeof(double)*(2*fel.GetNDof()+nip));
+}
+
+
+template <typename FEL>
+static void RegisterElement (string name, int order)
+{
+  FEL fel(order);
+  string suffix = "/" + name + "/" + ToString(order);
+  benchmark::RegisterBenchmark (("CalcShape"+suffix).c_str(), BM_CalcShape<FEL>, fel);
+  benchmark::RegisterBenchmark (("Evaluate"+suffix).c_str(), BM_Evaluate<FEL>, fel);
+  benchmark::RegisterBenchmark (("AddTrans"+suffix).c_str(), BM_AddTrans<FEL>, fel);
+}
+
+template <ELEMENT_TYPE ET>
+static void RegisterET ()
+{
+  string etname = ElementTopology::GetElementName(ET);
+  for (int order = 1; order <= 8; order++)
+    {
+      RegisterElement<H1HighOrderFE<ET>> ("H1/"+etname, order);
+      RegisterElement<L2HighOrderFE<ET>> ("L2/"+etname, order);
+    }
+}
+
+static int dummy_register = []()
+  {
+    RegisterET<ET_SEGM>();
+    RegisterET<ET_TRIG>();
+    RegisterET<ET_QUAD>();
+    RegisterET<ET_TET>();
+    RegisterET<ET_PRISM>();
+    RegisterET<ET_PYRAMID>();
+    RegisterET<ET_HEX>();
+    return 0;
+  } ();
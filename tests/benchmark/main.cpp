@@ -0,0 +1,62 @@
+#include "benchmark.hpp"
+#include <bla.hpp>
+
+using namespace ngbla;
+
+static double peak_gflops = 0;
+static double peak_gbs = 0;
+
+double PeakGFlops () { return peak_gflops; }
+double PeakGBs () { return peak_gbs; }
+
+
+// independent FMA chains, enough to fill the pipelines
+static double MeasurePeakFlops ()
+{
+  constexpr int NACC = 12;
+  constexpr size_t steps = 1000000;
+  SIMD<double> acc[NACC];
+  for (int k = 0; k < NACC; k++)
+    acc[k] = SIMD<double>(1e-3*k);
+  SIMD<double> a(0.999999), b(1e-9);
+
+  double time = RunTiming([&]()
+                          {
+                            for (size_t i = 0; i < steps; i++)
+                              for (int k = 0; k < NACC; k++)
+                                acc[k] = FMA(a, acc[k], b);
+                            benchmark::DoNotOptimize(acc);
+                          }, 0.2, 3);
+  return 2.0 * NACC * SIMD<double>::Size() * steps / time * 1e-9;
+}
+
+// STREAM triad on arrays much larger than the caches
+static double MeasurePeakBandwidth ()
+{
+  size_t n = size_t(1) << 24;
+  Vector<> a(n), b(n), c(n);
+  b = 1.0; c = 2.0;
+  double time = RunTiming([&]()
+                          {
+                            for (size_t i = 0; i < n; i++)
+                              a(i) = b(i) + 3.0 * c(i);
+                            benchmark::DoNotOptimize(a(n-1));
+                          }, 0.5, 3);
+  return 3.0 * sizeof(double) * n / time * 1e-9;
+}
+
+
+int main (int argc, char ** argv)
+{
+  peak_gflops = MeasurePeakFlops();
+  peak_gbs = MeasurePeakBandwidth();
+  benchmark::AddCustomContext ("peak GFlop/s", std::to_string(peak_gflops));
+  benchmark::AddCustomContext ("peak GB/s", std::to_string(peak_gbs));
+  benchmark::AddCustomContext ("SIMD width", std::to_string(SIMD<double>::Size()));
+
+  benchmark::Initialize (&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments (argc, argv))
+    return 1;
+  benchmark::RunSpecifiedBenchmarks ();
+  return 0;
+}
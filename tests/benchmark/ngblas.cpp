@@ -0,0 +1,66 @@
+#include "benchmark.hpp"
+#include <bla.hpp>
+
+using namespace ngbla;
+
+static void SetRandom (SliceMatrix<> mat)
+{
+  for (size_t i = 0; i < mat.Height(); i++)
+    for (size_t j = 0; j < mat.Width(); j++)
+      mat(i,j) = sin(2+3*i+5*j);
+}
+
+
+// c = a * b, square matrices of size n
+static void BM_NgGEMM (benchmark::State & state)
+{
+  size_t n = state.range(0);
+  Matrix<> a(n,n), b(n,n), c(n,n);
+  SetRandom(a);
+  SetRandom(b);
+  for (auto _ : state)
+    {
+      NgGEMM<false,true> (make_SliceMatrix(a), make_SliceMatrix(b), c);
+      benchmark::DoNotOptimize(c(0,0));
+    }
+  SetKernelCounters (state, 2.0*n*n*n, 3.0*sizeof(double)*n*n);
+}
+BENCHMARK(BM_NgGEMM)->RangeMultiplier(2)->Range(4, 256);
+
+
+// c += a * b  with a of size n x k, the typical shape of element matrix kernels
+static void BM_NgGEMM_Rect (benchmark::State & state)
+{
+  size_t n = state.range(0), k = state.range(1);
+  Matrix<> a(n,k), b(k,n), c(n,n);
+  SetRandom(a);
+  SetRandom(b);
+  c = 0.0;
+  for (auto _ : state)
+    {
+      NgGEMM<true,true> (make_SliceMatrix(a), make_SliceMatrix(b), c);
+      benchmark::DoNotOptimize(c(0,0));
+    }
+  SetKernelCounters (state, 2.0*n*n*k, sizeof(double)*(2.0*n*k+2.0*n*n));
+}
+BENCHMARK(BM_NgGEMM_Rect)->Ranges({{8, 128}, {16, 512}});
+
+
+// c -= a^T diag b, the update of the (sparse) Cholesky factorization
+static void BM_SubAtDB (benchmark::State & state)
+{
+  size_t n = state.range(0), k = state.range(1);
+  Matrix<> a(k,n), b(k,n), c(n,n);
+  Vector<> diag(k);
+  SetRandom(a);
+  SetRandom(b);
+  diag = 1.0;
+  c = 0.0;
+  for (auto _ : state)
+    {
+      SubAtDB (a, diag, b, c);
+      benchmark::DoNotOptimize(c(0,0));
+    }
+  SetKernelCounters (state, 2.0*n*n*k, sizeof(double)*(2.0*n*k+2.0*n*n+k));
+}
+BENCHMARK(BM_SubAtDB)->Ranges({{8, 256}, {8, 256}});
@@ -0,0 +1,37 @@
+#include "catch.hpp"
+#include <ngstd.hpp>
+
+using namespace ngstd;
+
+TEST_CASE ("AsyncWriter", "[asyncwriter]")
+{
+  SECTION ("jobs run in order of submission")
+    {
+      Array<int> done;
+      {
+        AsyncWriter writer(2);
+        for (int i = 0; i < 100; i++)
+          writer.Submit ([&done, i] () { done.Append (i); });
+        writer.Wait();
+        CHECK(done.Size() == 100);
+        CHECK(!writer.Busy());
+        writer.Submit ([&done] () { done.Append (100); });
+      }
+      // the destructor finishes pending jobs
+      REQUIRE(done.Size() == 101);
+      for (int i = 0; i <= 100; i++)
+        CHECK(done[i] == i);
+    }
+
+  SECTION ("exceptions of jobs are rethrown")
+    {
+      AsyncWriter writer;
+      writer.Submit ([] () { throw Exception ("write failed"); });
+      CHECK_THROWS_AS(writer.Wait(), Exception);
+      // the writer remains usable
+      bool done = false;
+      writer.Submit ([&done] () { done = true; });
+      writer.Wait();
+      CHECK(done);
+    }
+}
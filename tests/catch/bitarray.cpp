@@ -0,0 +1,55 @@
+#include "catch.hpp"
+#include <ngstd.hpp>
+
+using namespace ngstd;
+
+TEST_CASE ("BitArray", "[bitarray]")
+{
+  for (size_t n : { 0, 1, 63, 64, 65, 200 })
+    {
+      SECTION ("size = "+to_string(n))
+        {
+          BitArray a(n), b(n);
+          a.Clear();
+          b.Clear();
+          for (size_t i = 0; i < n; i += 3) a.Set(i);
+          for (size_t i = 0; i < n; i += 2) b.Set(i);
+
+          size_t cnt = 0;
+          for (size_t i = 0; i < n; i++)
+            if (a.Test(i)) cnt++;
+          CHECK(a.NumSet() == cnt);
+
+          Array<size_t> visited;
+          for (size_t i : a.SetBits())
+            visited.Append(i);
+          CHECK(visited.Size() == cnt);
+          for (size_t j = 0; j < visited.Size(); j++)
+            CHECK(visited[j] == 3*j);
+
+          size_t sum = 0;
+          a.ForEachSet ([&] (size_t i) { sum += i; });
+          size_t expected = 0;
+          for (size_t i : visited) expected += i;
+          CHECK(sum == expected);
+
+          BitArray c = a;
+          c.AndNot(b);
+          BitArray d = a & b;
+          BitArray e = a | b;
+          for (size_t i = 0; i < n; i++)
+            {
+              CHECK(c.Test(i) == (i%3 == 0 && i%2 != 0));
+              CHECK(d.Test(i) == (i%6 == 0));
+              CHECK(e.Test(i) == (i%3 == 0 || i%2 == 0));
+            }
+
+          // bits beyond the size must not be counted
+          BitArray f(n);
+          f.Set();
+          CHECK(f.NumSet() == n);
+          f.Invert();
+          CHECK(f.NumSet() == 0);
+        }
+    }
+}
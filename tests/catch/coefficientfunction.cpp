@@ -257,6 +257,10 @@ auto p = make_shared<ParameterCoefficientFunction>(42.39);
 TEST_OPERATOR_COEFFICIENTFUNCTION(p);
 TEST_OPERATOR_COEFFICIENTFUNCTION(a*x+y/(b+z));
 
+// region-constant subtree, folded into a per-domain table when compiled
+auto dw = MakeDomainWiseCoefficientFunction({a, b});
+TEST_OPERATOR_COEFFICIENTFUNCTION((2*dw+b)*x);
+
 auto diffop = make_shared<T_DifferentialOperator<DiffOpId<3>>>();
 auto u = make_shared<ProxyFunction>(shared_ptr<ngcomp::FESpace>(), false, false, diffop, nullptr, nullptr, nullptr, nullptr, nullptr);
 
@@ -278,3 +282,77 @@ TEST_OPERATOR_COEFFICIENTFUNCTION(mat*xyz);
 
 auto longvec = MakeVectorialCoefficientFunction({x,y,z,x,y,z,z,x,y,x,x,x});
 // TEST_OPERATOR_COEFFICIENTFUNCTION(InnerProduct(longvec, longvec));
+
+TEST_CASE ("QuadraturePointCF")
+{
+  LocalHeap lh(100000, "lh");
+  FE_ElementTransformation<3,3> trafo(ET_TET);
+  trafo.SetElement (&trafo.GetElement(), 0, 0);
+  IntegrationRule ir(ET_TET, 3);
+  SIMD_IntegrationRule simd_ir(ir);
+  auto & simd_mir = trafo(simd_ir, lh);
+  MappedIntegrationRule<3,3> mir(ir, trafo, lh);
+
+  auto qp = make_shared<QuadraturePointCoefficientFunction> (1, 1);
+  Matrix<> vals(ir.Size(), 1);
+  qp->Evaluate (mir, vals);
+  for (size_t i = 0; i < ir.Size(); i++)
+    CHECK(vals(i,0) == 0.0);
+
+  qp->Set (simd_mir, *x, lh);
+  // in place update depending on the old values
+  qp->Set (simd_mir, *(2*qp+a), lh);
+  qp->Evaluate (mir, vals);
+  for (size_t i = 0; i < ir.Size(); i++)
+    CHECK(vals(i,0) == Approx(2*mir[i].GetPoint()(0)+1).epsilon(tolerance));
+}
+
+// bytecode of the PDE parser, interpreted and translated into a tree
+auto evalfun = make_shared<DomainVariableCoefficientFunction>
+  (EvalFunction("sin(x)*exp(y) + (x > 0.25)*z*z + sqrt(x*x+y*y) - abs(z-0.5)"));
+TEST_OPERATOR_COEFFICIENTFUNCTION(evalfun->GetCoefficientFunction());
+
+TEST_CASE ("DomainVariableCF")
+{
+  LocalHeap lh(100000, "lh");
+  FE_ElementTransformation<3,3> trafo(ET_TET);
+  trafo.SetElement (&trafo.GetElement(), 0, 0);
+  IntegrationRule ir(ET_TET, 3);
+  SIMD_IntegrationRule simd_ir(ir);
+  auto & simd_mir = trafo(simd_ir, lh);
+  MappedIntegrationRule<3,3> mir(ir, trafo, lh);
+
+  Matrix<> vals(ir.Size(), 1), tree_vals(ir.Size(), 1);
+  evalfun->Evaluate (mir, vals);
+  evalfun->GetCoefficientFunction()->Evaluate (mir, tree_vals);
+  CHECK(L2Norm(vals-tree_vals) < tolerance);
+
+  Matrix<SIMD<double>> simd_vals (1, simd_ir.Size());
+  evalfun->Evaluate (simd_mir, simd_vals);
+  for (size_t i = 0; i < ir.Size(); i++)
+    CHECK(simd_vals(0, i/SIMD<double>::Size())[i%SIMD<double>::Size()] == Approx(vals(i,0)).epsilon(tolerance));
+
+  // user functions have no coefficient function counterpart
+  auto besselcf = make_shared<DomainVariableCoefficientFunction> (EvalFunction("besselj0(x)"));
+  CHECK(besselcf->GetCoefficientFunction() == nullptr);
+}
+
+// tabulated material law, a B-spline of the coordinate
+auto bh_curve = make_shared<BSpline> (3, Array<double>({ 0, 0, 0, 0.2, 0.3, 0.6, 0.9, 1.2, 1.2, 1.2 }),
+                                      Array<double>({ 0, 0.1, 0.5, 0.8, 0.9, 1.3, 2, 0, 0, 0 }));
+TEST_OPERATOR_COEFFICIENTFUNCTION(MakeBSplineCoefficientFunction(bh_curve, x+y));
+
+TEST_CASE ("BSpline")
+{
+  for (double t = -0.1; t < 1.3; t += 0.0173)
+    {
+      SIMD<double> ts([&](int i) { return t + 0.21*i; });
+      SIMD<double> val, dval;
+      bh_curve->Evaluate (ts, val, dval);
+      for (int i = 0; i < SIMD<double>::Size(); i++)
+        {
+          CHECK(val[i] == Approx((*bh_curve)(ts[i])).epsilon(tolerance));
+          CHECK(dval[i] == Approx(bh_curve->Differentiate()(ts[i])).epsilon(tolerance));
+        }
+    }
+}
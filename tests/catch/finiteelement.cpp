@@ -1,6 +1,7 @@
 
 #include "catch.hpp"
 #include <fem.hpp>
+#include <h1hofefo.hpp>
 
 using namespace ngfem;
 
@@ -127,3 +128,254 @@ TEST_CASE ("FiniteElement", "[fem][finiteelement]")
         });
     }
 }
+
+TEST_CASE ("ReferenceShapeCache", "[fem][finiteelement]")
+{
+  constexpr size_t SW = SIMD<double>::Size();
+  ForET<ET_TRIG,ET_TET,ET_HEX>([&](auto ET) {
+      for (auto order : Range(1,5)) {
+        SECTION ("order = " + std::to_string(order),"")
+          {
+            H1<ET.ElementType()> fel(order);
+            for (int v = 0; v < ET.N_VERTEX; v++)
+              fel.SetVertexNumber (v, (3*v+1) % ET.N_VERTEX);
+
+            IntegrationRule ir(ET.ElementType(), 2*order);
+            SIMD_IntegrationRule simdir(ET.ElementType(), 2*order);
+            CHECK(simdir.IsPersistent());
+
+            Matrix<> shape(fel.GetNDof(), ir.Size());
+            fel.CalcShape (ir, shape);
+
+            // first call fills the cache, second one reads from it
+            for (int k = 0; k < 2; k++)
+              {
+                Matrix<SIMD<double>> simdshape(fel.GetNDof(), simdir.Size());
+                fel.CalcShape (simdir, simdshape);
+                double err = 0;
+                for (size_t j = 0; j < shape.Height(); j++)
+                  for (size_t i = 0; i < ir.Size(); i++)
+                    err += fabs(shape(j,i) - simdshape(j,i/SW)[i%SW]);
+                CHECK(err < 1e-10);
+              }
+          }
+      }
+    });
+}
+
+TEST_CASE ("H1FixedOrder", "[fem][finiteelement]")
+{
+  // fixed order elements have to reproduce the variable order basis
+  ForET<ET_SEGM,ET_TRIG,ET_TET>([&](auto ET) {
+      constexpr ELEMENT_TYPE ET_ = ET.ElementType();
+      Iterate<H1_MAX_FIXED_ORDER> ([&] (auto p) {
+          constexpr int ORDER = p.value+1;
+          SECTION ("order = " + std::to_string(ORDER),"")
+            {
+              int vnums[4];
+              for (int v = 0; v < ET.N_VERTEX; v++)
+                vnums[v] = (3*v+1) % ET.N_VERTEX;
+
+              H1<ET_> fel(ORDER);
+              for (int v = 0; v < ET.N_VERTEX; v++)
+                fel.SetVertexNumber (v, vnums[v]);
+              fel.ComputeNDof();
+              H1HighOrderFEFO<ET_,ORDER> felfo;
+              felfo.SetVertexNumbers (vnums);
+              REQUIRE(felfo.GetNDof() == fel.GetNDof());
+
+              IntegrationRule ir(ET_, 2*ORDER);
+              Matrix<> shape(fel.GetNDof(), ir.Size()), shapefo(fel.GetNDof(), ir.Size());
+              fel.CalcShape (ir, shape);
+              felfo.CalcShape (ir, shapefo);
+              CHECK(L2Norm(shape-shapefo) < 1e-10);
+            }
+        });
+    });
+}
+
+TEST_CASE ("L2SumFactorization", "[fem][finiteelement]")
+{
+  constexpr size_t SW = SIMD<double>::Size();
+  ForET<ET_QUAD,ET_HEX>([&](auto ET) {
+      constexpr int DIM = ET.DIM;
+      typedef T_ScalarFiniteElement<L2HighOrderFE_Shape<ET.ElementType()>, ET.ElementType(),
+                                    DGFiniteElement<DIM>> T_IMPL;
+      LocalHeap lh(10000000, "l2sumfac");
+      for (auto order : Range(5)) {
+        SECTION ("order = " + std::to_string(order),"")
+          {
+            L2<ET.ElementType()> fel(order);
+            for (int v = 0; v < ET.N_VERTEX; v++)
+              fel.SetVertexNumber (v, (3*v+1) % ET.N_VERTEX);
+            fel.ComputeNDof();
+
+            auto & ir = SIMD_SelectIntegrationRule (ET.ElementType(), 2*order+1);
+            CHECK(ir.IsTP());
+            FE_ElementTransformation<DIM,DIM> trafo(ET.ElementType());
+            auto & mir = trafo(ir, lh);
+
+            Vector<> coefs(fel.GetNDof());
+            for (size_t i = 0; i < coefs.Size(); i++)
+              coefs(i) = sin(i+1.0);
+
+            Vector<SIMD<double>> vals(ir.Size()), vals_ref(ir.Size());
+            Matrix<SIMD<double>> grads(DIM, ir.Size()), grads_ref(DIM, ir.Size());
+            vals = SIMD<double>(0.0);
+            grads = SIMD<double>(0.0);
+            fel.Evaluate (ir, coefs, vals);
+            fel.EvaluateGrad (mir, coefs, grads);
+            fel.T_IMPL::Evaluate (ir, coefs, vals_ref);
+            fel.T_IMPL::EvaluateGrad (mir, coefs, grads_ref);
+
+            double err = 0;
+            for (size_t i = 0; i < ir.GetNIP(); i++)
+              {
+                err += fabs(vals(i/SW)[i%SW] - vals_ref(i/SW)[i%SW]);
+                for (int k = 0; k < DIM; k++)
+                  err += fabs(grads(k,i/SW)[i%SW] - grads_ref(k,i/SW)[i%SW]);
+              }
+            CHECK(err < 1e-10);
+
+            // padding lanes have to vanish for the transposed operations
+            for (size_t i = 0; i < ir.Size(); i++)
+              {
+                vals(i) = SIMD<double>(0.0);
+                for (int k = 0; k < DIM; k++)
+                  grads(k,i) = SIMD<double>(0.0);
+              }
+            for (size_t i = 0; i < ir.GetNIP(); i++)
+              {
+                ((double*)&vals(i/SW))[i%SW] = cos(i+1.0);
+                for (int k = 0; k < DIM; k++)
+                  ((double*)&grads(k,i/SW))[i%SW] = cos(k+i+1.0);
+              }
+            Vector<> res(fel.GetNDof()), res_ref(fel.GetNDof());
+            res = 0.0; res_ref = 0.0;
+            fel.AddTrans (ir, vals, res);
+            fel.AddGradTrans (mir, grads, res);
+            fel.T_IMPL::AddTrans (ir, vals, res_ref);
+            fel.T_IMPL::AddGradTrans (mir, grads, res_ref);
+            CHECK(L2Norm(res-res_ref) < 1e-10 * (1+L2Norm(res_ref)));
+          }
+      }
+    });
+}
+
+TEST_CASE ("RecursivePolynomialBatch", "[fem][polynomials]")
+{
+  constexpr size_t SW = SIMD<double>::Size();
+  int n = 12;
+  size_t np = 5;
+  Vector<SIMD<double>> x(np), y(np);
+  for (size_t k = 0; k < np; k++)
+    for (size_t l = 0; l < SW; l++)
+      {
+        ((double*)&x(k))[l] = -1 + 2.0*(k*SW+l)/(np*SW);
+        ((double*)&y(k))[l] = 0.5 + 0.1*l;
+      }
+
+  auto check = [&] (Matrix<SIMD<double>> & batch, auto single)
+    {
+      double err = 0;
+      for (size_t k = 0; k < np; k++)
+        {
+          Vector<SIMD<double>> vals(n+1);
+          single (x(k), y(k), vals);
+          for (int i = 0; i <= n; i++)
+            err += HSum (L2Norm2 (batch(i,k)-vals(i)));
+        }
+      CHECK(err < 1e-20);
+    };
+
+  Matrix<SIMD<double>> batch(n+1, np);
+  SECTION ("Legendre")
+    {
+      LegendrePolynomial::EvalBatch (n, x, batch);
+      check (batch, [&] (auto xk, auto yk, auto & vals) { LegendrePolynomial::Eval (n, xk, vals); });
+      LegendrePolynomial::EvalScaledBatch (n, x, y, batch);
+      check (batch, [&] (auto xk, auto yk, auto & vals) { LegendrePolynomial::EvalScaled (n, xk, yk, vals); });
+    }
+  SECTION ("JacobiAlpha")
+    {
+      JacobiPolynomialAlpha jac(3);
+      jac.EvalBatch (n, x, batch);
+      check (batch, [&] (auto xk, auto yk, auto & vals) { jac.Eval (n, xk, vals); });
+      jac.EvalScaledBatch (n, x, y, batch);
+      check (batch, [&] (auto xk, auto yk, auto & vals) { jac.EvalScaled (n, xk, yk, vals); });
+    }
+  SECTION ("JacobiFix")
+    {
+      // tabulated coefficients against the closed formula
+      for (int i = 2; i < 40; i++)
+        {
+          CHECK(JacobiPolynomialFix<3,1>::A(i) == Approx(JacobiPolynomialFix<3,1>::CalcA(i)));
+          CHECK(JacobiPolynomialFix<3,1>::B(i) == Approx(JacobiPolynomialFix<3,1>::CalcB(i)));
+          CHECK(JacobiPolynomialFix<3,1>::C(i) == Approx(JacobiPolynomialFix<3,1>::CalcC(i)));
+        }
+      JacobiPolynomialFix<3,1>::EvalBatch (n, x, batch);
+      check (batch, [&] (auto xk, auto yk, auto & vals) { JacobiPolynomialFix<3,1>::Eval (n, xk, vals); });
+    }
+}
+
+TEST_CASE ("FacetRuleCache", "[fem][intrule]")
+{
+  LocalHeap lh(1000000, "facetrulecache");
+  int vnums[4] = { 3, 1, 2, 0 };
+  Facet2ElementTrafo transform(ET_TET, FlatArray<int>(4, vnums));
+  auto & irfacet = SIMD_SelectIntegrationRule (ET_TRIG, 5);
+  REQUIRE(irfacet.IsPersistent());
+  // same points, but not persistent, so mapped into the LocalHeap
+  SIMD_IntegrationRule irfacet2(irfacet.Size(), &irfacet[0]);
+  irfacet2.SetNIP (irfacet.GetNIP());
+
+  for (int fnr = 0; fnr < 4; fnr++)
+    {
+      auto & ir1 = transform(fnr, irfacet, lh);
+      auto & ir2 = transform(fnr, irfacet, lh);
+      auto & ir3 = transform(fnr, irfacet2, lh);
+      CHECK(&ir1 == &ir2);
+      CHECK(ir1.IsPersistent());
+      CHECK(!ir3.IsPersistent());
+      double err = 0;
+      for (size_t i = 0; i < ir1.Size(); i++)
+        for (int k = 0; k < 3; k++)
+          err += HSum(L2Norm2(ir1[i](k)-ir3[i](k)));
+      CHECK(err == 0.0);
+      CHECK(ir1[0].FacetNr() == fnr);
+    }
+}
+
+TEST_CASE ("CollapsedTPRules", "[fem][intrule]")
+{
+  for (ELEMENT_TYPE et : { ET_TRIG, ET_TET, ET_PRISM, ET_PYRAMID })
+    for (int order : { 0, 1, 4, 7 })
+      SECTION (std::string(ElementTopology::GetElementName(et)) + ", order = " + std::to_string(order), "")
+        {
+          auto & irtp = SIMD_SelectIntegrationRuleTP (et, order);
+          REQUIRE(irtp.IsTP());
+          CHECK(irtp.IsPersistent());
+          size_t nz = (et == ET_TRIG) ? 1 : irtp.GetIRZ().GetNIP();
+          CHECK(irtp.GetNIP() == irtp.GetIRX().GetNIP()*irtp.GetIRY().GetNIP()*nz);
+
+          // exact for all monomials up to order, compare with the standard rule
+          IntegrationRule ir(et, order);
+          for (int a = 0; a <= order; a++)
+            for (int b = 0; a+b <= order; b++)
+              for (int c = 0; a+b+c <= order; c++)
+                {
+                  if (et == ET_TRIG && c > 0) continue;
+                  auto f = [a,b,c] (auto x, auto y, auto z) { return pow(x,a)*pow(y,b)*pow(z,c); };
+                  double ref = 0;
+                  for (auto ip : ir)
+                    ref += ip.Weight() * f(ip(0), ip(1), ip(2));
+                  double val = 0;
+                  for (size_t i = 0; i < irtp.GetNIP(); i++)
+                    {
+                      auto ip = irtp[i/SIMD<double>::Size()][i%SIMD<double>::Size()];
+                      val += ip.Weight() * f(ip(0), ip(1), ip(2));
+                    }
+                  CHECK(val == Approx(ref).epsilon(1e-12));
+                }
+        }
+}
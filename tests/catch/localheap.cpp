@@ -0,0 +1,54 @@
+#include "catch.hpp"
+#include <ngstd.hpp>
+
+using namespace ngstd;
+
+TEST_CASE ("LocalHeap grows on overflow", "[localheap]")
+{
+  LocalHeap lh(1000, "test heap");
+  double * first = lh.Alloc<double> (10);
+  first[9] = 1;
+  {
+    HeapReset hr(lh);
+    // much more than the initial block
+    for (int i = 0; i < 100; i++)
+      {
+        double * d = lh.Alloc<double> (100);
+        for (int j = 0; j < 100; j++)
+          d[j] = i;
+        CHECK(d[99] == i);
+      }
+  }
+  CHECK(first[9] == 1);
+  // back in the first block
+  void * pos = lh.GetPointer();
+  CHECK(lh.Alloc<double>(10) == pos);
+
+  SECTION ("throw if growing is disabled")
+    {
+      LocalHeap::SetGrowOnOverflow (false);
+      LocalHeap lh2(1000, "small heap");
+      CHECK_THROWS_AS(lh2.Alloc<double> (1000), LocalHeapOverflow);
+      LocalHeap::SetGrowOnOverflow (true);
+    }
+}
+
+TEST_CASE ("LocalHeap split grows per thread", "[localheap]")
+{
+  LocalHeap::ResetHighWaterMark();
+  RunWithTaskManager ([&] ()
+    {
+      LocalHeap clh(1000, "parallel heap", true);
+      atomic<int> wrong(0);
+      ParallelFor (Range(100), [&] (size_t i)
+                   {
+                     LocalHeap lh = clh.Split();
+                     int * p = lh.Alloc<int> (10000);
+                     for (int j = 0; j < 10000; j++) p[j] = i;
+                     for (int j = 0; j < 10000; j++)
+                       if (p[j] != int(i)) wrong++;
+                   });
+      CHECK(wrong == 0);
+    });
+  CHECK(LocalHeap::GetHighWaterMark() >= 10000*sizeof(int));
+}
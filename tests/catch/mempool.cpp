@@ -0,0 +1,60 @@
+#include "catch.hpp"
+#include <ngstd.hpp>
+
+using namespace ngstd;
+
+TEST_CASE ("MemoryPool recycles blocks", "[mempool]")
+{
+  MemoryPool::Clear();
+  MemoryPool::ResetStatistics();
+
+  SECTION ("a freed block is reused, preferably one of the same size")
+    {
+      void * a = MemoryPool::Alloc (100000);
+      void * b = MemoryPool::Alloc (101000);    // same size class
+      MemoryPool::Free (a, 100000);
+      MemoryPool::Free (b, 101000);
+      CHECK(MemoryPool::Alloc (100000) == a);
+      CHECK(MemoryPool::Alloc (100000) == b);
+      auto stats = MemoryPool::GetStatistics();
+      CHECK(stats.allocs == 4);
+      CHECK(stats.reused == 2);
+      CHECK(stats.reused_same == 1);
+      MemoryPool::Free (a, 100000);
+      MemoryPool::Free (b, 100000);
+      CHECK(MemoryRegistry::Current (MemoryRegistry::POOL) == MemoryPool::GetStatistics().cached_bytes);
+    }
+
+  SECTION ("the limit of cached bytes")
+    {
+      size_t max_cached = MemoryPool::GetMaxCached();
+      MemoryPool::SetMaxCached (0);
+      void * a = MemoryPool::Alloc (100000);
+      MemoryPool::Free (a, 100000);
+      auto stats = MemoryPool::GetStatistics();
+      CHECK(stats.cached_blocks == 0);
+      CHECK(stats.released == 1);
+      MemoryPool::SetMaxCached (max_cached);
+    }
+
+  SECTION ("concurrent allocations")
+    {
+      RunWithTaskManager ([] ()
+        {
+          ParallelFor (1000, [] (size_t i)
+            {
+              size_t n = 5000 + 100 * (i % 20);
+              double * p = MemoryPool::Alloc<double> (n);
+              p[0] = p[n-1] = i;
+              MemoryPool::Free (p, n);
+            });
+        });
+      auto stats = MemoryPool::GetStatistics();
+      CHECK(stats.allocs == 1000);
+      CHECK(stats.reused + stats.cached_blocks >= 1000);
+    }
+
+  MemoryPool::Clear();
+  CHECK(MemoryPool::GetStatistics().cached_bytes == 0);
+  CHECK(MemoryRegistry::Current (MemoryRegistry::POOL) == 0);
+}
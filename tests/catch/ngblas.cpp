@@ -220,6 +220,120 @@ TEST_CASE ("SubAtDB", "[ngblas]") {
     }
 }
 
+static Matrix<Complex> RefMultAB (SliceMatrix<Complex> a, SliceMatrix<Complex> b)
+{
+  Matrix<Complex> c(a.Height(), b.Width());
+  for (size_t i = 0; i < c.Height(); i++)
+    for (size_t j = 0; j < c.Width(); j++)
+      {
+        Complex sum = 0.0;
+        for (size_t k = 0; k < a.Width(); k++)
+          sum += a(i,k) * b(k,j);
+        c(i,j) = sum;
+      }
+  return c;
+}
+
+TEST_CASE ("ComplexMultMatMat", "[ngblas]") {
+    for (int n : { 1, 2, 3, 7, 20 }) {
+        SECTION ("n = "+to_string(n)) {
+            for (int m : { 0, 1, 5, 17, 130, 300 }) {
+                SECTION ("m = "+to_string(m)) {
+                    for (int k : { 1, 3, 4, 9, 33, 50 }) {
+                        SECTION ("k = "+to_string(k)) {
+                            Matrix<Complex> a(n,m), b(m,k), c(n,k), c0(n,k);
+                            SetRandom(a);
+                            SetRandom(b);
+                            SetRandom(c0);
+                            Matrix<Complex> ab = RefMultAB(a, b);
+
+                            c = a*b;
+                            CHECK(L2Norm(c-ab) < 1e-10);
+                            c = -a*b;
+                            CHECK(L2Norm(c+ab) < 1e-10);
+                            c = c0;
+                            c += a*b;
+                            CHECK(L2Norm(c-c0-ab) < 1e-10);
+                            c = c0;
+                            c -= a*b;
+                            CHECK(L2Norm(c-c0+ab) < 1e-10);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE ("ComplexMatVec", "[ngblas]") {
+    for (int n : { 1, 2, 3, 7, 20 }) {
+        SECTION ("n = "+to_string(n)) {
+            for (int m : { 1, 2, 3, 5, 8, 19 }) {
+                SECTION ("m = "+to_string(m)) {
+                  Matrix<Complex> a(n,m);
+                  Vector<Complex> x(m), y(n), xt(n), yt(m);
+                  SetRandom(a);
+                  SetRandom(x);
+                  SetRandom(xt);
+                  y = a*x;
+                  yt = Trans(a)*xt;
+                  double err = 0, errt = 0;
+                  for (int i = 0; i < n; i++)
+                    {
+                      Complex sum = 0.0;
+                      for (int j = 0; j < m; j++)
+                        sum += a(i,j)*x(j);
+                      err += norm(sum-y(i));
+                    }
+                  for (int j = 0; j < m; j++)
+                    {
+                      Complex sum = 0.0;
+                      for (int i = 0; i < n; i++)
+                        sum += a(i,j)*xt(i);
+                      errt += norm(sum-yt(j));
+                    }
+                  CHECK(sqrt(err) < 1e-12);
+                  CHECK(sqrt(errt) < 1e-12);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE ("FloatMatVec", "[ngblas]") {
+    for (int n : { 1, 3, 4, 7, 20 }) {
+        SECTION ("n = "+to_string(n)) {
+            for (int m : { 1, 2, 3, 5, 8, 19, 150 }) {
+                SECTION ("m = "+to_string(m)) {
+                  Matrix<> a(n,m);
+                  SetRandom(a);
+                  Matrix<float> af(n,m);
+                  for (int i = 0; i < n; i++)
+                    for (int j = 0; j < m; j++)
+                      af(i,j) = a(i,j);
+                  // reference with the rounded entries
+                  for (int i = 0; i < n; i++)
+                    for (int j = 0; j < m; j++)
+                      a(i,j) = af(i,j);
+                  
+                  Vector<> x(m), y(n), xt(n), yt(m);
+                  SetRandom(x);
+                  SetRandom(xt);
+                  y = af*x;
+                  yt = Trans(af)*xt;
+                  CHECK(L2Norm(y-a*x) < 1e-12);
+                  CHECK(L2Norm(yt-Trans(a)*xt) < 1e-12);
+
+                  Matrix<> b(m,5), c(n,5);
+                  SetRandom(b);
+                  c = af*b;
+                  CHECK(L2Norm(c-a*b) < 1e-12);
+                }
+            }
+        }
+    }
+}
+
 TEST_CASE ("SIMD<double>", "[simd]") {
     constexpr size_t N = SIMD<double>::Size();
     double src[N];
@@ -272,6 +386,36 @@ TEST_CASE ("SIMD<Complex>", "[simd]") {
     }
 }
 
+TEST_CASE ("SIMD<float>", "[simd]") {
+    constexpr size_t N = SIMD<float>::Size();
+    float src[N];
+    float dst[N];
+    for (auto i : Range(N)) {
+        src[i] = i+1.5f;
+        dst[i] = 0.0f;
+    }
+
+    SECTION ("Mask load/store") {
+        for (auto k : Range(N+1)) {
+            SIMD<float> simd(src,k);
+            simd.Store(dst,k);
+            for (auto i : Range(N)) {
+                CHECK(simd[i] == ( i<k? src[i] : 0.0f ));
+                CHECK(dst[i] == ( i<k? src[i] : 0.0f ));
+            }
+        }
+    }
+
+    SECTION ("Conversion") {
+        SIMD<double> d = SIMD<float>(src);
+        for (auto i : Range(N))
+            CHECK(d[i] == src[i]);
+        SIMD<float> f(2.0*d);
+        for (auto i : Range(N))
+            CHECK(f[i] == 2*src[i]);
+    }
+}
+
 TEST_CASE ("Vec", "[double]") {
     Vec<1,double> v2{42};
     CHECK(v2[0] == 42);
@@ -287,3 +431,184 @@ TEST_CASE ("Vec", "[double]") {
     for (int i : Range(N))
       CHECK(v1[i] == vals[i]);
 }
+
+TEST_CASE ("BatchedAtB", "[ngblas]") {
+    constexpr size_t SW = SIMD<double>::Size();
+    LocalHeap lh(1000000, "batchtest");
+    for (size_t n : { 1, 3, 4, 7, 12 }) {
+        SECTION ("n = "+to_string(n)) {
+            size_t np = 5, dim1 = 3, dim2 = 2;
+            Matrix<SIMD<double>> b1(np*dim1, n), b2(np*dim2, n+1), d(np, dim1*dim2), c(n+1, n);
+            auto lane = [] (SIMD<double> & x, size_t e) -> double& { return ((double*)&x)[e]; };
+            for (size_t e = 0; e < SW; e++) {
+                for (size_t i = 0; i < b1.Height(); i++)
+                    for (size_t j = 0; j < b1.Width(); j++)
+                        lane(b1(i,j),e) = sin(1+i+3*j+7*e);
+                for (size_t i = 0; i < b2.Height(); i++)
+                    for (size_t j = 0; j < b2.Width(); j++)
+                        lane(b2(i,j),e) = cos(2+i+2*j+5*e);
+                for (size_t i = 0; i < d.Height(); i++)
+                    for (size_t j = 0; j < d.Width(); j++)
+                        lane(d(i,j),e) = 1+i+j*e;
+            }
+            c = SIMD<double>(0.0);
+            AddBtDB_Batch (b1, d, b2, c, lh);
+
+            double err = 0;
+            for (size_t e = 0; e < SW; e++)
+                for (size_t i2 = 0; i2 < n+1; i2++)
+                    for (size_t i1 = 0; i1 < n; i1++) {
+                        double sum = 0;
+                        for (size_t p = 0; p < np; p++)
+                            for (size_t k = 0; k < dim1; k++)
+                                for (size_t l = 0; l < dim2; l++)
+                                    sum += lane(b2(p*dim2+l,i2),e) * lane(d(p,k*dim2+l),e) * lane(b1(p*dim1+k,i1),e);
+                        err += fabs(sum - lane(c(i2,i1),e));
+                    }
+            CHECK(err < 1e-10);
+        }
+    }
+}
+
+TEST_CASE ("ApplyTensorProduct", "[ngblas]") {
+    Matrix<> a(3,4), b(5,2), c(2,6);
+    for (size_t i = 0; i < a.Height(); i++)
+        for (size_t j = 0; j < a.Width(); j++)
+            a(i,j) = sin(1+i+3*j);
+    for (size_t i = 0; i < b.Height(); i++)
+        for (size_t j = 0; j < b.Width(); j++)
+            b(i,j) = cos(2+2*i+j);
+    for (size_t i = 0; i < c.Height(); i++)
+        for (size_t j = 0; j < c.Width(); j++)
+            c(i,j) = 1.0/(1+i+j);
+
+    // Kronecker product, first factor outermost
+    Matrix<> k(3*5*2, 4*2*6);
+    for (size_t i1 = 0; i1 < 3; i1++)
+        for (size_t i2 = 0; i2 < 5; i2++)
+            for (size_t i3 = 0; i3 < 2; i3++)
+                for (size_t j1 = 0; j1 < 4; j1++)
+                    for (size_t j2 = 0; j2 < 2; j2++)
+                        for (size_t j3 = 0; j3 < 6; j3++)
+                            k((i1*5+i2)*2+i3, (j1*2+j2)*6+j3) = a(i1,j1)*b(i2,j2)*c(i3,j3);
+
+    SliceMatrix<> mats[3] = { a, b, c };
+
+    Vector<> x(k.Width()), y(k.Height()), yref(k.Height());
+    for (size_t i = 0; i < x.Size(); i++)
+        x(i) = sin(3.0*i);
+    ApplyTensorProduct (FlatArray<SliceMatrix<>> (3, mats), x, y);
+    yref = k * x;
+    CHECK(L2Norm(y-yref) < 1e-12);
+
+    Vector<> xt(k.Height()), z(k.Width()), zref(k.Width());
+    for (size_t i = 0; i < xt.Size(); i++)
+        xt(i) = cos(2.0*i);
+    ApplyTensorProductTrans (FlatArray<SliceMatrix<>> (3, mats), xt, z);
+    zref = Trans(k) * xt;
+    CHECK(L2Norm(z-zref) < 1e-12);
+}
+
+TEST_CASE ("AddABtSymPacked", "[ngblas]") {
+    constexpr size_t SW = SIMD<double>::Size();
+    for (int n : { 1, 2, 3, 5, 7, 12, 17, 30 }) {
+        SECTION ("n = "+to_string(n)) {
+            int k = 9;
+            Matrix<> a(n,k), c(n,n);
+            SetRandom(a);
+            c = a * Trans(a);
+
+            Array<double> mem(n*(n+1)/2);
+            FlatSymmetricMatrix<double> cp(n, &mem[0]);
+            cp = 1.0;
+            AddABtSym (a, a, cp);
+
+            Matrix<SIMD<double>> asimd(n,(k+SW-1)/SW);
+            asimd = SIMD<double>(0.0);
+            for (int i = 0; i < n; i++)
+                for (int j = 0; j < k; j++)
+                    asimd(i,j/SW)[j%SW] = a(i,j);
+            Array<double> mem2(n*(n+1)/2);
+            FlatSymmetricMatrix<double> cp2(n, &mem2[0]);
+            cp2 = 0.0;
+            AddABtSym (asimd, asimd, cp2);
+
+            for (int i = 0; i < n; i++)
+                for (int j = 0; j <= i; j++) {
+                    CHECK(fabs(cp(i,j) - 1.0 - c(i,j)) < 1e-12);
+                    CHECK(fabs(cp2(i,j) - c(i,j)) < 1e-12);
+                }
+        }
+    }
+}
+
+TEST_CASE ("BandCholesky", "[ngblas]") {
+    constexpr size_t SW = SIMD<double>::Size();
+    for (int bw : { 1, 2, 3, 6, 11 }) {
+        SECTION ("bw = "+to_string(bw)) {
+            int n = 23;
+            auto entry = [bw] (int i, int j, size_t lane) {
+                if (i == j) return 2.0*bw + 1 + lane;
+                return 1.0/(1+i+j+lane);
+            };
+
+            Array<SIMD<double>> msimd(n*bw), memsimd(FlatBandCholeskyFactors<>::RequiredMem(n,bw));
+            FlatSymBandMatrix<SIMD<double>> asimd(n, bw, &msimd[0]);
+            FlatBandCholeskyFactors<SIMD<double>> invsimd(n, bw, &memsimd[0]);
+            for (int i = 0; i < n; i++)
+                for (int j = max2(0, i-bw+1); j <= i; j++)
+                    asimd(i,j) = SIMD<double>([&] (size_t lane) { return entry(i,j,lane); });
+            invsimd.Factor (asimd);
+
+            Vector<SIMD<double>> xsimd(n), ysimd(n);
+            for (int i = 0; i < n; i++)
+                xsimd(i) = SIMD<double>([&] (size_t lane) { return sin(i+3.0*lane); });
+            invsimd.Mult (xsimd, ysimd);
+
+            for (size_t lane = 0; lane < SW; lane++) {
+                SymBandMatrix<double> a(n, bw);
+                Matrix<> dense(n,n);
+                dense = 0.0;
+                for (int i = 0; i < n; i++)
+                    for (int j = max2(0, i-bw+1); j <= i; j++)
+                        dense(i,j) = dense(j,i) = a(i,j) = entry(i,j,lane);
+                BandCholeskyFactors<double> inv(a);
+
+                Vector<> x(n), y(n);
+                for (int i = 0; i < n; i++)
+                    x(i) = sin(i+3.0*lane);
+                inv.Mult (x, y);
+
+                Vector<> r = x - dense * y;
+                CHECK(L2Norm(r) < 1e-12);
+                for (int i = 0; i < n; i++)
+                    CHECK(fabs(ysimd(i)[lane] - y(i)) < 1e-12);
+            }
+        }
+    }
+}
+
+TEST_CASE ("BlockedFactorizations", "[ngblas]") {
+    for (size_t n : { 130, 300 }) {
+        SECTION ("n = "+to_string(n)) {
+            Matrix<> a(n,n), inv(n,n);
+            for (size_t i = 0; i < n; i++)
+                for (size_t j = 0; j < n; j++)
+                    a(i,j) = sin(1.0+i*j+2*i+j);
+            inv = a;
+            CalcInverse (inv, INVERSE_LIB::INV_NGBLA);
+            Matrix<> id = a * inv;
+            id -= Identity(n);
+            CHECK(L2Norm(id) < 1e-8);
+
+            Matrix<> spd = Trans(a) * a + n * Identity(n);
+            CholeskyFactors<double> chol(spd);
+            Vector<> x(n), y(n);
+            for (size_t i = 0; i < n; i++)
+                x(i) = cos(i);
+            chol.Mult (x, y);
+            Vector<> r = x - spd * y;
+            CHECK(L2Norm(r) < 1e-10 * L2Norm(x));
+        }
+    }
+}
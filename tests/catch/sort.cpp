@@ -0,0 +1,57 @@
+#include "catch.hpp"
+#include <ngstd.hpp>
+
+using namespace ngstd;
+
+TEST_CASE ("ParallelRadixSort", "[sort]")
+{
+  RunWithTaskManager ([&] ()
+    {
+      for (size_t n : { size_t(0), size_t(1), size_t(50), size_t(100000) })
+        {
+          Array<int> keys(n), vals(n);
+          for (size_t i = 0; i < n; i++)
+            {
+              keys[i] = int((i * 2654435761u) % 1000) - 500;
+              vals[i] = i;
+            }
+          Array<int> orig_keys(keys);
+          ParallelRadixSort (FlatArray<int>(keys), FlatArray<int>(vals));
+          bool ok = true;
+          for (size_t i = 0; i+1 < n; i++)
+            {
+              if (keys[i] > keys[i+1]) ok = false;
+              // stable
+              if (keys[i] == keys[i+1] && vals[i] > vals[i+1]) ok = false;
+            }
+          for (size_t i = 0; i < n; i++)
+            if (orig_keys[vals[i]] != keys[i]) ok = false;
+          CHECK(ok);
+
+          Array<size_t> skeys(n);
+          for (size_t i = 0; i < n; i++)
+            skeys[i] = (i * 11400714819323198485ull) >> 3;
+          ParallelRadixSort (FlatArray<size_t>(skeys));
+          ok = true;
+          for (size_t i = 0; i+1 < n; i++)
+            if (skeys[i] > skeys[i+1]) ok = false;
+          CHECK(ok);
+        }
+
+      size_t n = 30000;
+      Array<INT<3>> tuples(n);
+      for (size_t i = 0; i < n; i++)
+        tuples[i] = INT<3> (i%7, (i*13)%11, (i*31)%5);
+      Array<int> index(n);
+      for (size_t i = 0; i < n; i++) index[i] = i;
+      ParallelRadixSortI (FlatArray<INT<3>>(tuples), FlatArray<int>(index));
+      bool ok = true;
+      for (size_t i = 0; i+1 < n; i++)
+        {
+          auto a = tuples[index[i]], b = tuples[index[i+1]];
+          if (a[0] > b[0] || (a[0] == b[0] && (a[1] > b[1] || (a[1] == b[1] && a[2] > b[2]))))
+            ok = false;
+        }
+      CHECK(ok);
+    });
+}
@@ -0,0 +1,591 @@
+#include "catch.hpp"
+#include <la.hpp>
+
+using namespace ngla;
+
+// number of entries per row of the FillMatrix pattern
+Array<int> RowLengths (size_t n, bool lower)
+{
+  Array<int> cnt(n);
+  for (size_t i = 0; i < n; i++)
+    {
+      size_t far = (i*7) % n;
+      cnt[i] = 1;
+      if (i > 0) cnt[i]++;
+      if (!lower && i+1 < n) cnt[i]++;
+      if ((!lower || far <= i) && far != i && far+1 != i && far != i+1)
+        cnt[i]++;
+    }
+  return cnt;
+}
+
+// tridiagonal matrix with one long-range coupling per row
+template <class TMAT>
+void FillMatrix (TMAT & mat, size_t n, bool lower)
+{
+  for (size_t i = 0; i < n; i++)
+    {
+      size_t far = (i*7) % n;
+      if (!lower || far <= i)
+        mat.CreatePosition (i, far);
+      if (i > 0) mat.CreatePosition (i, i-1);
+      mat.CreatePosition (i, i);
+      if (!lower && i+1 < n) mat.CreatePosition (i, i+1);
+    }
+  for (size_t i = 0; i < n; i++)
+    {
+      auto cols = mat.GetRowIndices(i);
+      auto vals = mat.GetRowValues(i);
+      for (size_t j = 0; j < cols.Size(); j++)
+        vals(j) = (cols[j] == int(i)) ? 4.0 : -1.0 / (1+i+cols[j]);
+    }
+}
+
+template <class TMAT>
+void CompareMultiVector (const TMAT & mat, size_t n, size_t k)
+{
+  MultiVector x(n, k), y(n, k);
+  for (size_t i = 0; i < n; i++)
+    for (size_t j = 0; j < k; j++)
+      {
+        x.FM()(i,j) = sin(i+3*j);
+        y.FM()(i,j) = cos(i+j);
+      }
+
+  MultiVector yref(n, k);
+  yref.FM() = y.FM();
+  auto hx = mat.CreateRowVector();
+  auto hy = mat.CreateColVector();
+  for (size_t j = 0; j < k; j++)
+    {
+      x.GetVector (j, hx);
+      yref.GetVector (j, hy);
+      mat.MultAdd (0.5, hx, hy);
+      yref.SetVector (j, hy);
+    }
+
+  mat.MultAdd (0.5, x, y);
+  double err = 0;
+  for (size_t i = 0; i < n; i++)
+    for (size_t j = 0; j < k; j++)
+      err = max2(err, fabs(y.FM()(i,j)-yref.FM()(i,j)));
+  CHECK(err < 1e-12);
+}
+
+TEST_CASE ("MultiVector MultAdd", "[sparsematrix]")
+{
+  size_t n = 50;
+  for (size_t k : { 1, 3, 8 })
+    {
+      SECTION ("nonsymmetric, k = "+to_string(k))
+        {
+          SparseMatrix<double> mat(RowLengths(n, false));
+          FillMatrix (mat, n, false);
+          CompareMultiVector (mat, n, k);
+        }
+      SECTION ("symmetric, k = "+to_string(k))
+        {
+          SparseMatrixSymmetric<double> mat(RowLengths(n, true));
+          FillMatrix (mat, n, true);
+          CompareMultiVector (mat, n, k);
+        }
+    }
+}
+
+TEST_CASE ("MatrixGraph from elements", "[sparsematrix]")
+{
+  // 1D chain of elements with dofs {2i, 2i+1, 2i+2}
+  size_t nel = 100, ndof = 2*nel+1;
+  Array<int> elsize(nel);
+  elsize = 3;
+  Table<int> el2dof(elsize);
+  for (size_t i = 0; i < nel; i++)
+    for (int k = 0; k < 3; k++)
+      el2dof[i][2-k] = 2*i+k;   // unsorted on purpose
+
+  for (bool symmetric : { false, true })
+    {
+      SECTION (string("symmetric = ")+(symmetric ? "true" : "false"))
+        {
+          MatrixGraph graph(ndof, ndof, el2dof, el2dof, symmetric);
+          size_t nze = 0;
+          for (size_t i = 0; i < ndof; i++)
+            {
+              Array<int> expected;
+              int lo = (i % 2) ? i-1 : max2(int(i)-2, 0);
+              int hi = (i % 2) ? i+1 : min2(int(i)+2, int(ndof)-1);
+              for (int j = lo; j <= hi; j++)
+                if (!symmetric || j <= int(i))
+                  expected.Append (j);
+              auto cols = graph.GetRowIndices(i);
+              REQUIRE(cols.Size() == expected.Size());
+              for (size_t j = 0; j < cols.Size(); j++)
+                CHECK(cols[j] == expected[j]);
+              nze += cols.Size();
+            }
+          CHECK(graph.NZE() == nze);
+        }
+    }
+}
+
+TEST_CASE ("Transpose and MatAdd", "[sparsematrix]")
+{
+  size_t n = 40;
+  Array<int> bandwidth(n);
+  bandwidth = 2;
+  SparseMatrix<double> a(RowLengths(n, false)), b(bandwidth);
+  FillMatrix (a, n, false);
+  // b has a different pattern: diagonal and a shifted band
+  for (size_t i = 0; i < n; i++)
+    {
+      b.CreatePosition (i, i);
+      b.CreatePosition (i, (i+5) % n);
+    }
+  for (size_t i = 0; i < n; i++)
+    {
+      b(i,i) = 2.0;
+      b(i,(i+5)%n) = 1.0+i;
+    }
+
+  // const access, the non-const operator() creates positions
+  const SparseMatrix<double> & ca = a, & cb = b;
+  auto at = TransposeMatrix (a);
+  const SparseMatrixTM<double> & cat = *at;
+  for (size_t i = 0; i < n; i++)
+    {
+      auto cols = at->GetRowIndices(i);
+      for (size_t j = 1; j < cols.Size(); j++)
+        CHECK(cols[j-1] < cols[j]);
+      for (size_t j = 0; j < n; j++)
+        CHECK(cat(i,j) == ca(j,i));
+    }
+
+  auto sum = MatAdd (1.0, a, -0.5, b);
+  const SparseMatrixTM<double> & csum = *sum;
+  for (size_t i = 0; i < n; i++)
+    for (size_t j = 0; j < n; j++)
+      CHECK(csum(i,j) == Approx(ca(i,j) - 0.5*cb(i,j)));
+}
+
+TEST_CASE ("SparseCholesky reuses symbolic factorization", "[sparsematrix]")
+{
+  size_t n = 60;
+  auto a = make_shared<SparseMatrixSymmetric<double>> (RowLengths(n, true));
+  auto b = make_shared<SparseMatrixSymmetric<double>> (RowLengths(n, true));
+  FillMatrix (*a, n, true);
+  FillMatrix (*b, n, true);
+  b->AsVector() *= 2.0;
+
+  SparseCholesky<double> inva(*a);
+  SparseCholesky<double> invb(*b, inva);
+  CHECK(invb.NZE() == inva.NZE());
+
+  auto f = a->CreateColVector();
+  auto ua = a->CreateColVector();
+  auto ub = a->CreateColVector();
+  auto fv = f.FV<double>();
+  for (size_t i = 0; i < n; i++)
+    fv(i) = sin(i);
+  inva.Mult (f, ua);
+  invb.Mult (f, ub);
+  auto uav = ua.FV<double>(), ubv = ub.FV<double>();
+  for (size_t i = 0; i < n; i++)
+    CHECK(ubv(i) == Approx(0.5*uav(i)));
+}
+
+TEST_CASE ("SparseCholesky solve on grid", "[sparsematrix]")
+{
+  // 5-point Laplacian, many small subtrees in the elimination tree
+  size_t nx = 40, n = nx*nx;
+  Array<int> elsperrow(n);
+  for (size_t i = 0; i < n; i++)
+    elsperrow[i] = 1 + (i % nx > 0) + (i >= nx);
+  auto a = make_shared<SparseMatrixSymmetric<double>> (elsperrow);
+  for (size_t i = 0; i < n; i++)
+    {
+      if (i % nx > 0) a->CreatePosition (i, i-1);
+      if (i >= nx) a->CreatePosition (i, i-nx);
+      a->CreatePosition (i, i);
+    }
+  for (size_t i = 0; i < n; i++)
+    {
+      auto cols = a->GetRowIndices(i);
+      auto vals = a->GetRowValues(i);
+      for (size_t j = 0; j < cols.Size(); j++)
+        vals(j) = (cols[j] == int(i)) ? 4.01 : -1.0;
+    }
+
+  SparseCholesky<double> inv(*a);
+  auto f = a->CreateColVector();
+  auto u = a->CreateColVector();
+  auto r = a->CreateColVector();
+  auto fv = f.FV<double>();
+  for (size_t i = 0; i < n; i++)
+    fv(i) = sin(i);
+
+  inv.Mult (f, u);
+  a->Mult (u, r);
+  r -= f;
+  CHECK(L2Norm(r) < 1e-10 * L2Norm(f));
+
+  MultiVector x(n, 3), y(n, 3);
+  for (size_t j = 0; j < 3; j++)
+    for (size_t i = 0; i < n; i++)
+      x.FM()(i,j) = cos(i+j);
+  y.FM() = 0.0;
+  inv.MultAdd (1.0, x, y);
+  double err = 0;
+  for (size_t j = 0; j < 3; j++)
+    {
+      x.GetVector (j, f);
+      inv.Mult (f, u);
+      for (size_t i = 0; i < n; i++)
+        err = max2(err, fabs(y.FM()(i,j)-u.FV<double>()(i)));
+    }
+  CHECK(err < 1e-12);
+}
+
+TEST_CASE ("Block Krylov solvers", "[sparsematrix]")
+{
+  size_t nx = 20, n = nx*nx, k = 5;
+  Array<int> elsperrow(n);
+  for (size_t i = 0; i < n; i++)
+    elsperrow[i] = 1 + (i % nx > 0) + (i >= nx);
+  SparseMatrixSymmetric<double> a(elsperrow);
+  for (size_t i = 0; i < n; i++)
+    {
+      if (i % nx > 0) a.CreatePosition (i, i-1);
+      if (i >= nx) a.CreatePosition (i, i-nx);
+      a.CreatePosition (i, i);
+    }
+  for (size_t i = 0; i < n; i++)
+    {
+      auto cols = a.GetRowIndices(i);
+      auto vals = a.GetRowValues(i);
+      for (size_t j = 0; j < cols.Size(); j++)
+        vals(j) = (cols[j] == int(i)) ? 4.01 : -1.0;
+    }
+
+  // the last right hand side depends on the first one
+  MultiVector f(n, k), u(n, k), r(n, k);
+  for (size_t i = 0; i < n; i++)
+    for (size_t j = 0; j < k-1; j++)
+      f.FM()(i,j) = sin((j+1)*i+j);
+  f.FM().Col(k-1) = 2.0 * f.FM().Col(0);
+
+  CGSolver<double> cg(a);
+  cg.SetPrecision (1e-10);
+  auto hf = a.CreateColVector();
+  auto hu = a.CreateColVector();
+  f.GetVector (0, hf);
+  cg.Mult (hf, hu);
+
+  auto check = [&] (BlockKrylovSpaceSolver & solver)
+    {
+      solver.SetPrecision (1e-10);
+      solver.SetMaxSteps (400);
+      solver.Solve (f, u);
+      r.FM() = f.FM();
+      a.MultAdd (-1, u, r);
+      for (size_t j = 0; j < k; j++)
+        CHECK(L2Norm(r.FM().Col(j)) < 1e-8 * L2Norm(f.FM().Col(j)));
+      CHECK(solver.GetSteps() <= cg.GetSteps());
+    };
+
+  SECTION ("BlockCG")
+    {
+      BlockCGSolver solver(a);
+      check (solver);
+    }
+  SECTION ("BlockGMRES")
+    {
+      BlockGMRESSolver solver(a);
+      check (solver);
+    }
+}
+
+TEST_CASE ("GMRES solver", "[sparsematrix]")
+{
+  // 1D convection-diffusion, non-symmetric
+  size_t n = 300;
+  Array<int> elsperrow(n);
+  for (size_t i = 0; i < n; i++)
+    elsperrow[i] = 1 + (i > 0) + (i+1 < n);
+  SparseMatrix<double> a(elsperrow, n);
+  for (size_t i = 0; i < n; i++)
+    {
+      if (i > 0) a.CreatePosition (i, i-1);
+      a.CreatePosition (i, i);
+      if (i+1 < n) a.CreatePosition (i, i+1);
+    }
+  for (size_t i = 0; i < n; i++)
+    {
+      if (i > 0) a(i,i-1) = -1.5;
+      a(i,i) = 2.2;
+      if (i+1 < n) a(i,i+1) = -0.5;
+    }
+
+  auto f = a.CreateColVector();
+  auto u = a.CreateColVector();
+  auto r = a.CreateColVector();
+  auto fv = f.FV<double>();
+  for (size_t i = 0; i < n; i++)
+    fv(i) = sin(i);
+
+  GMRESSolver<double> gmres(a);
+  gmres.SetPrecision (1e-10);
+  gmres.SetMaxSteps (300);
+  gmres.Mult (f, u);
+  a.Mult (u, r);
+  r -= f;
+  CHECK(L2Norm(r) < 1e-8 * L2Norm(f));
+  CHECK(gmres.GetSteps() < 300);
+}
+
+TEST_CASE ("Krylov solvers reuse their work vectors", "[sparsematrix]")
+{
+  size_t n = 2000;
+  SparseMatrix<double> a(RowLengths(n, false), n);
+  FillMatrix (a, n, false);
+
+  auto f = a.CreateColVector();
+  auto u = a.CreateColVector();
+  auto r = a.CreateColVector();
+  auto fv = f.FV<double>();
+
+  CGSolver<double> cg(a);
+  BiCGStabSolver<double> bicg(a);
+  for (KrylovSpaceSolver * solver : { (KrylovSpaceSolver*)&cg, (KrylovSpaceSolver*)&bicg })
+    {
+      solver->SetPrecision (1e-12);
+      for (int k = 0; k < 3; k++)
+        {
+          for (size_t i = 0; i < n; i++)
+            fv(i) = sin(i+k);
+          // u = 1 + a^{-1} f with the temporary from the workspace
+          u = 1.0;
+          solver->MultAdd (1.0, f, u);
+          auto uv = u.FV<double>();
+          for (size_t i = 0; i < n; i++)
+            uv(i) -= 1.0;
+          a.Mult (u, r);
+          r -= f;
+          CHECK(L2Norm(r) < 1e-8 * L2Norm(f));
+        }
+    }
+}
+
+template <class TMAT>
+void CheckGSOrders (TMAT & mat, size_t n)
+{
+  auto f = mat.CreateColVector();
+  auto u = mat.CreateColVector();
+  auto r = mat.CreateColVector();
+  auto fv = f.template FV<double>();
+  for (size_t i = 0; i < n; i++)
+    fv(i) = sin(i);
+
+  auto jac = mat.CreateJacobiPrecond (nullptr);
+  for (auto order : { BaseJacobiPrecond::GS_SEQUENTIAL, BaseJacobiPrecond::GS_MULTICOLOR,
+                      BaseJacobiPrecond::GS_HYBRID })
+    {
+      jac->SetGSOrder (order);
+      u = 0.0;
+      for (int k = 0; k < 30; k++)
+        {
+          jac->GSSmooth (u, f);
+          jac->GSSmoothBack (u, f);
+        }
+      r = f - mat * u;
+      CHECK(L2Norm(r) < 1e-10 * L2Norm(f));
+    }
+}
+
+TEST_CASE ("Parallel Gauss-Seidel", "[sparsematrix]")
+{
+  RunWithTaskManager ([&] ()
+    {
+      size_t n = 3000;
+      SECTION ("nonsymmetric")
+        {
+          SparseMatrix<double> mat(RowLengths(n, false), n);
+          FillMatrix (mat, n, false);
+          CheckGSOrders (mat, n);
+        }
+      SECTION ("symmetric")
+        {
+          SparseMatrixSymmetric<double> mat(RowLengths(n, true));
+          FillMatrix (mat, n, true);
+          CheckGSOrders (mat, n);
+
+          // the multicolor sweep keeps y = f - (D+L^t) u up to date
+          auto f = mat.CreateColVector();
+          auto u = mat.CreateColVector();
+          auto y = mat.CreateColVector();
+          auto r = mat.CreateColVector();
+          f.FV<double>() = 1.0;
+          auto jac = dynamic_pointer_cast<JacobiPrecondSymmetric<double,double>>
+            (mat.CreateJacobiPrecond (nullptr));
+          jac->SetGSOrder (BaseJacobiPrecond::GS_MULTICOLOR);
+          u = 0.0;
+          y = f;
+          jac->GSSmooth (u, f, y);
+          mat.MultAdd1 (-1, u, y);
+          r = f - mat * u;
+          r -= y;
+          CHECK(L2Norm(r) < 1e-12);
+        }
+    });
+}
+
+// max |A_bb y_b - x_b| over all blocks, or with A_bb^T
+double BlockResidual (const SparseMatrix<double> & mat, const Table<int> & blocks,
+                      FlatVector<double> x, FlatVector<double> y, bool trans)
+{
+  size_t n = mat.Height();
+  Array<int> blocknr(n);
+  blocknr = -1;
+  for (size_t b = 0; b < blocks.Size(); b++)
+    for (int d : blocks[b])
+      blocknr[d] = b;
+
+  Vector<double> ay(n);
+  ay = 0.0;
+  for (size_t i = 0; i < n; i++)
+    {
+      auto cols = mat.GetRowIndices(i);
+      auto vals = mat.GetRowValues(i);
+      for (size_t j = 0; j < cols.Size(); j++)
+        if (blocknr[i] != -1 && blocknr[cols[j]] == blocknr[i])
+          {
+            if (trans)
+              ay(cols[j]) += vals(j) * y(i);
+            else
+              ay(i) += vals(j) * y(cols[j]);
+          }
+    }
+  double err = 0;
+  for (size_t i = 0; i < n; i++)
+    err = max2(err, fabs(blocknr[i] != -1 ? ay(i)-x(i) : y(i)));
+  return err;
+}
+
+TEST_CASE ("BlockJacobi with SIMD block groups", "[sparsematrix]")
+{
+  RunWithTaskManager ([&] ()
+    {
+      size_t n = 3000, nfree = n-5;
+      SparseMatrix<double> mat(RowLengths(n, false), n);
+      FillMatrix (mat, n, false);
+
+      // mixed block sizes, the last dofs are in no block
+      int sizes[] = { 3, 3, 3, 2, 4, 1, 3 };
+      Array<int> cnt;
+      for (size_t i = 0; i < nfree; i += cnt.Last())
+        cnt.Append (min2(int(nfree-i), sizes[cnt.Size()%7]));
+      auto blocks = make_shared<Table<int>> (cnt);
+      for (size_t b = 0, i = 0; b < cnt.Size(); b++)
+        for (int k = 0; k < cnt[b]; k++)
+          (*blocks)[b][k] = i++;
+      auto bj = mat.CreateBlockJacobiPrecond (blocks);
+
+      auto x = mat.CreateColVector();
+      auto y = mat.CreateColVector();
+      auto y2 = mat.CreateColVector();
+      auto u = mat.CreateColVector();
+      auto r = mat.CreateColVector();
+      for (size_t i = 0; i < n; i++)
+        x.FV<double>()(i) = cos(i);
+
+      auto gsres = [&] ()
+        {
+          u = 0.0;
+          for (int k = 0; k < 30; k++)
+            {
+              bj->GSSmooth (u, x);
+              bj->GSSmoothBack (u, x);
+            }
+          r = x - mat * u;
+          r.FV<double>().Range(nfree, n) = 0.0;
+          return L2Norm(r) / L2Norm(x);
+        };
+
+      y = 0.0;
+      bj->MultTransAdd (1, x, y);
+      CHECK(BlockResidual (mat, *blocks, x.FV<double>(), y.FV<double>(), true) < 1e-12);
+      y = 0.0;
+      bj->MultAdd (1, x, y);
+      CHECK(BlockResidual (mat, *blocks, x.FV<double>(), y.FV<double>(), false) < 1e-12);
+      CHECK(gsres() < 1e-12);
+
+      bj->SetSinglePrecision (1e-3);
+      y2 = 0.0;
+      bj->MultAdd (1, x, y2);
+      y2 -= y;
+      CHECK(L2Norm(y2) < 1e-5 * L2Norm(y));
+      CHECK(gsres() < 1e-12);
+    });
+}
+
+TEST_CASE ("Chebyshev smoother", "[sparsematrix]")
+{
+  RunWithTaskManager ([&] ()
+    {
+      // 5-point Laplacian, diag(A)^{-1} A has eigenvalues in (0,2)
+      size_t nx = 40, n = nx*nx;
+      Array<int> elsperrow(n);
+      for (size_t i = 0; i < n; i++)
+        elsperrow[i] = 1 + (i % nx > 0) + (i >= nx);
+      SparseMatrixSymmetric<double> a(elsperrow);
+      for (size_t i = 0; i < n; i++)
+        {
+          if (i % nx > 0) a.CreatePosition (i, i-1);
+          if (i >= nx) a.CreatePosition (i, i-nx);
+          a.CreatePosition (i, i);
+        }
+      for (size_t i = 0; i < n; i++)
+        {
+          auto cols = a.GetRowIndices(i);
+          auto vals = a.GetRowValues(i);
+          for (size_t j = 0; j < cols.Size(); j++)
+            vals(j) = (cols[j] == int(i)) ? 4.01 : -1.0;
+        }
+      auto freedofs = make_shared<BitArray> (n);
+      freedofs->Set();
+      freedofs->Clear(0);
+
+      ChebyshevPrecond cheb(a, freedofs, 4);
+      CHECK(cheb.GetMaxEigenValue() > 1.8);
+      CHECK(cheb.GetMaxEigenValue() < 2.0);
+
+      auto x = a.CreateColVector();
+      auto y = a.CreateColVector();
+      auto cx = a.CreateColVector();
+      auto cy = a.CreateColVector();
+      for (size_t i = 0; i < n; i++)
+        {
+          x.FV<double>()(i) = sin(i);
+          y.FV<double>()(i) = cos(3*i);
+        }
+      cx = cheb * x;
+      cy = cheb * y;
+      CHECK(fabs(InnerProduct(cx,y) - InnerProduct(cy,x)) < 1e-12 * L2Norm(cx) * L2Norm(y));
+      CHECK(InnerProduct(cx,x) > 0);
+      CHECK(cx.FV<double>()(0) == 0.0);
+
+      // a symmetric preconditioner for CG, better than Jacobi
+      x.FV<double>()(0) = 0.0;
+      auto jac = a.CreateJacobiPrecond (freedofs);
+      CGSolver<double> chebcg(a, cheb), jaccg(a, *jac);
+      for (auto cg : { &chebcg, &jaccg })
+        {
+          cg->SetPrecision (1e-10);
+          cg->SetMaxSteps (500);
+        }
+      y = chebcg * x;
+      cy = jaccg * x;
+      CHECK(chebcg.GetSteps() < jaccg.GetSteps() / 2);
+      cy -= y;
+      CHECK(L2Norm(cy) < 1e-6 * L2Norm(y));
+    });
+}
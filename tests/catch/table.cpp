@@ -0,0 +1,134 @@
+#include "catch.hpp"
+#include <ngstd.hpp>
+
+using namespace ngstd;
+
+TEST_CASE ("ParallelCreateTable", "[table]")
+{
+  // element -> vertex and the transposed vertex -> element table
+  size_t nel = 10000, nv = 3000;
+  auto vertex = [nv] (size_t el, int j) { return int((el*7+j*13) % nv); };
+  
+  RunWithTaskManager ([&] ()
+    {
+      Table<int> el2v = ParallelCreateTable<int>
+        (nel, [&] (ParallelTableCreator<int> & creator, size_t el)
+         {
+           for (int j = 0; j < 3; j++)
+             creator.Add (el, vertex(el, j));
+         });
+      CHECK(el2v.Size() == nel);
+      CHECK(el2v.NElements() == 3*nel);
+      for (size_t el = 0; el < nel; el++)
+        for (int j = 0; j < 3; j++)
+          CHECK(el2v[el][j] == vertex(el, j));
+
+      Table<int> v2el = ParallelCreateTable<int>
+        (nel, [&] (ParallelTableCreator<int> & creator, size_t el)
+         {
+           for (auto v : el2v[el])
+             creator.Add (v, el);
+         }, nv);
+
+      TableCreator<int> creator(nv);
+      for ( ; !creator.Done(); creator++)
+        for (size_t el = 0; el < nel; el++)
+          for (auto v : el2v[el])
+            creator.Add (v, el);
+      Table<int> v2el_serial = creator.MoveTable();
+
+      CHECK(v2el.Size() == nv);
+      bool same = true;
+      for (size_t v = 0; v < nv; v++)
+        {
+          // ordered by element number
+          for (size_t j = 0; j+1 < v2el[v].Size(); j++)
+            if (v2el[v][j] >= v2el[v][j+1]) same = false;
+          if (v2el[v].Size() != v2el_serial[v].Size()) same = false;
+        }
+      CHECK(same);
+    });
+}
+
+TEST_CASE ("ParallelDynamicTable", "[table]")
+{
+  // vertex -> vertex graph of the edges, every edge is added from both ends
+  size_t ned = 20000, nv = 3000;
+  auto edge = [nv] (size_t i) { return INT<2> (int(i % nv), int((i*11+1) % nv)); };
+
+  RunWithTaskManager ([&] ()
+    {
+      ParallelDynamicTable<int> graph(nv);
+      ParallelFor (2*ned, [&] (size_t i)
+                   {
+                     auto e = edge(i/2);
+                     if (i % 2) Swap (e[0], e[1]);
+                     graph.AddUnique (e[0], e[1]);
+                   });
+
+      DynamicTable<int> serial(nv);
+      for (size_t i = 0; i < ned; i++)
+        {
+          auto e = edge(i);
+          serial.AddUnique (e[0], e[1]);
+          serial.AddUnique (e[1], e[0]);
+        }
+
+      bool same = true;
+      for (size_t v = 0; v < nv; v++)
+        {
+          Array<int> a, b;
+          for (auto w : graph[v]) a.Append (w);
+          for (auto w : serial[v]) b.Append (w);
+          QuickSort (a);
+          QuickSort (b);
+          if (a.Size() != b.Size()) same = false;
+          else
+            for (size_t j = 0; j < a.Size(); j++)
+              if (a[j] != b[j]) same = false;
+        }
+      CHECK(same);
+    });
+}
+
+TEST_CASE ("ParallelClosedHashTable", "[table]")
+{
+  // edges of the graph above, numbered by their first occurrence
+  size_t n = 50000, nv = 3000;
+  auto edge = [nv] (size_t i)
+    {
+      INT<2> e (int(i % nv), int((i*11+1) % nv));
+      e.Sort();
+      return e;
+    };
+
+  RunWithTaskManager ([&] ()
+    {
+      ParallelClosedHashTable<INT<2>, int> ht(4*n);
+      atomic<size_t> created(0);
+      ParallelFor (n, [&] (size_t i)
+                   {
+                     size_t pos;
+                     if (ht.PositionCreate (edge(i), pos))
+                       created++;
+                   });
+
+      ClosedHashTable<INT<2>, int> serial(4*n);
+      for (size_t i = 0; i < n; i++)
+        serial[edge(i)] = i;
+
+      CHECK(created == serial.UsedElements());
+      CHECK(ht.UsedElements() == serial.UsedElements());
+
+      ParallelFor (n, [&] (size_t i)
+                   {
+                     if (serial.Get (edge(i)) == int(i))
+                       ht[edge(i)] = i;
+                   });
+      bool same = true;
+      for (size_t i = 0; i < n; i++)
+        if (ht.Get (edge(i)) != serial.Get (edge(i))) same = false;
+      CHECK(same);
+      CHECK(!ht.Used (INT<2> (-5, 7)));
+    });
+}
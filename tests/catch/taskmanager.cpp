@@ -0,0 +1,123 @@
+#include "catch.hpp"
+#include <ngstd.hpp>
+
+using namespace ngstd;
+
+static void CheckAllTasksOnce (int ntasks)
+{
+  Array<atomic<int>> cnt(ntasks);
+  for (auto & c : cnt) c = 0;
+  ParallelJob ([&] (TaskInfo & ti)
+               {
+                 CHECK(ti.ntasks == ntasks);
+                 cnt[ti.task_nr]++;
+               }, ntasks);
+  for (auto & c : cnt)
+    CHECK(c == 1);
+}
+
+TEST_CASE ("WorkStealing", "[taskmanager]")
+{
+  bool old_mode = TaskManager::GetWorkStealing();
+  RunWithTaskManager ([&] ()
+    {
+      for (bool stealing : { false, true })
+        {
+          SECTION ("work stealing = "+to_string(stealing))
+            {
+              TaskManager::SetWorkStealing (stealing);
+              for (int ntasks : { 1, 3, TaskManager::GetNumThreads(), TasksPerThread(7), 1000 })
+                CheckAllTasksOnce (ntasks);
+
+              // very uneven costs
+              atomic<size_t> sum(0);
+              ParallelFor (Range(200), [&] (size_t i)
+                           {
+                             size_t mysum = 0;
+                             for (size_t k = 0; k < (i%17==0 ? 100000 : 10); k++)
+                               mysum += k%3;
+                             sum += mysum + i;
+                           }, TasksPerThread(4));
+              size_t expected = 0;
+              for (size_t i = 0; i < 200; i++)
+                {
+                  for (size_t k = 0; k < (i%17==0 ? 100000 : 10); k++)
+                    expected += k%3;
+                  expected += i;
+                }
+              CHECK(sum == expected);
+
+              bool caught = false;
+              try
+                {
+                  ParallelJob ([] (TaskInfo & ti)
+                               {
+                                 if (ti.task_nr == 5)
+                                   throw Exception ("task 5 failed");
+                               }, 100);
+                }
+              catch (Exception & e)
+                {
+                  caught = true;
+                }
+              CHECK(caught);
+            }
+        }
+    });
+  TaskManager::SetWorkStealing (old_mode);
+}
+
+TEST_CASE ("TaskGraph", "[taskmanager]")
+{
+  // task i waits for its divisors
+  size_t n = 500;
+  TableCreator<int> creator(n);
+  for ( ; !creator.Done(); creator++)
+    for (size_t i = 1; i < n; i++)
+      for (size_t j = 2*i; j < n; j += i)
+        creator.Add (i, j);
+  Table<int> dag = creator.MoveTable();
+  TaskGraph graph(dag);
+  CHECK(graph.Size() == n);
+  CHECK(graph.NumPredecessors(12) == 5);
+
+  RunWithTaskManager ([&] ()
+    {
+      Array<atomic<int>> finished(n);
+      for (auto & f : finished) f = 0;
+      atomic<int> wrong_order(0);
+      graph.Run ([&] (int i)
+                 {
+                   for (size_t j = 1; j < size_t(i); j++)
+                     if (i % j == 0 && !finished[j])
+                       wrong_order++;
+                   finished[i] = 1;
+                 });
+      for (auto & f : finished)
+        CHECK(f == 1);
+      CHECK(wrong_order == 0);
+    });
+}
+
+TEST_CASE ("ParallelPrefixSum", "[taskmanager]")
+{
+  RunWithTaskManager ([&] ()
+    {
+      for (size_t n : { 0, 1, 7, 10000 })
+        {
+          Array<size_t> a(n);
+          for (size_t i = 0; i < n; i++)
+            a[i] = i%5;
+          size_t total = ParallelPrefixSum<size_t> (a, 3);
+          size_t sum = 3;
+          bool ok = true;
+          for (size_t i = 0; i < n; i++)
+            {
+              if (a[i] != sum) ok = false;
+              sum += i%5;
+            }
+          CHECK(ok);
+          CHECK(total == sum);
+        }
+    });
+}
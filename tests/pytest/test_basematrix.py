@@ -36,3 +36,13 @@ def test_derive_basematrix():
 
 
 
+
+def test_innerproduct_async():
+    x = CreateVVector(5)
+    y = CreateVVector(5)
+    for i in range(len(x)):
+        x[i] = 1+i
+        y[i] = 2
+    ip = x.InnerProductAsync(y)
+    assert ip.wait() == 30
+    assert ip.wait() == InnerProduct(x, y)
@@ -89,3 +89,26 @@ if __name__ == "__main__":
     test_real()
     test_domainwise_cf()
     test_evaluate()
+
+def test_probeset(tmpdir):
+    from netgen.geom2d import unit_square
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = H1(mesh, order=2)
+    gfu = GridFunction(fes)
+    points = [(0.1,0.2), (0.5,0.5), (0.51,0.5), (0.9,0.3), (2,2)]
+    filename = str(tmpdir.join("probes.csv"))
+    probes = ProbeSet(mesh, points, [gfu, CoefficientFunction((x,y))], names=["u","xy"], filename=filename)
+    assert probes.found == [True]*4 + [False]
+    for step in range(3):
+        gfu.Set(step*x*y)
+        probes.Do(time=0.1*step)
+        values = probes.Evaluate()
+        for i,p in enumerate(points[:4]):
+            assert abs(values[i,0] - step*p[0]*p[1]) < 1e-12
+            assert abs(values[i,1] - p[0]) < 1e-12
+            assert abs(values[i,2] - p[1]) < 1e-12
+        assert values[4,0] != values[4,0]   # NaN outside
+    del probes
+    lines = open(filename).readlines()
+    assert len(lines) == 4
+    assert lines[0].startswith("time,u_0,xy_0_0,xy_0_1")
@@ -3,13 +3,15 @@ from netgen import meshing
 from netgen.csg import Pnt
 from ngsolve import *
     
-def test_convection1d_dg():
+def Periodic1DMesh(points=None):
     m = meshing.Mesh()
     m.dim = 1
-    nel = 20
+    if points is None:
+        points = [i/20 for i in range(21)]
+    nel = len(points)-1
     pnums = []
-    for i in range(0, nel+1):
-        pnums.append (m.Add (meshing.MeshPoint (Pnt(i/nel, 0, 0))))
+    for p in points:
+        pnums.append (m.Add (meshing.MeshPoint (Pnt(p, 0, 0))))
 
     for i in range(0,nel):
         m.Add (meshing.Element1D ([pnums[i],pnums[i+1]], index=1))
@@ -18,7 +20,10 @@ def test_convection1d_dg():
     m.Add (meshing.Element0D (pnums[nel], index=2))
     m.AddPointIdentification(pnums[0],pnums[nel],identnr=1,type=2)
 
-    mesh = Mesh (m)
+    return Mesh (m)
+
+def test_convection1d_dg():
+    mesh = Periodic1DMesh()
 
     fes = L2(mesh, order=4)
 
@@ -53,3 +58,53 @@ def test_convection1d_dg():
     l2error = sqrt(Integrate((u-u0)*(u-u0),mesh))
     print(l2error)
     assert l2error < 1e-2
+
+def test_convection1d_dg_timestepper():
+    mesh = Periodic1DMesh()
+    fes = L2(mesh, order=4)
+    u,v = fes.TnT()
+    bn = specialcf.normal(1)
+
+    a = BilinearForm(fes, nonassemble=True)
+    a += SymbolicBFI (-u * grad(v))
+    a += SymbolicBFI (bn*IfPos(bn, u, u.Other()) * v, element_boundary=True)
+
+    u0 = exp (-100 * (x-0.5)*(x-0.5) )
+    gfu = GridFunction(fes)
+    for scheme in ["ssprk3", "lsrk45"]:
+        gfu.Set(u0)
+        ts = ExplicitTimeStepper(a, scheme=scheme)
+        with TaskManager():
+            ts.Do(gfu.vec, tend=1, dt=1e-3)
+        assert abs(ts.t-1) < 1e-12
+        assert ts.nsteps == 1000
+        l2error = sqrt(Integrate((gfu-u0)*(gfu-u0),mesh))
+        assert l2error < 1e-2
+
+def test_convection1d_dg_localtimestepping():
+    # h = 1/10 on the left, 1/40 on the right half
+    mesh = Periodic1DMesh([i/10 for i in range(5)] + [0.5+i/40 for i in range(21)])
+    fes = L2(mesh, order=3)
+    u,v = fes.TnT()
+    bn = specialcf.normal(1)
+
+    a = BilinearForm(fes, nonassemble=True)
+    a += SymbolicBFI (-u * grad(v))
+    a += SymbolicBFI (bn*IfPos(bn, u, u.Other()) * v, element_boundary=True)
+
+    u0 = exp (-100 * (x-0.5)*(x-0.5) )
+    gfu = GridFunction(fes)
+    gfu.Set(u0)
+    ts = ExplicitTimeStepper(a, scheme="lsrk45")
+    ts.SetLocalTimeStepping(3)
+    assert ts.nclasses == 3
+    assert sorted(set(ts.elementclasses)) == [0, 2]
+    with TaskManager():
+        ts.Do(gfu.vec, tend=1, dt=8e-3)
+
+    gfref = GridFunction(fes)
+    gfref.Set(u0)
+    ref = ExplicitTimeStepper(a, scheme="lsrk45")
+    with TaskManager():
+        ref.Do(gfref.vec, tend=1, dt=2e-3)
+    assert sqrt(Integrate((gfu-gfref)**2, mesh)) < 1e-3
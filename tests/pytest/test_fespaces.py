@@ -32,3 +32,165 @@ def test_GetFE():
                 for el in space.Elements(vb):
                     assert space.GetFE(el).ndof == len(space.GetDofNrs(el)), [spacename,vb,order]
                     
+
+def test_ElementWeights():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = H1(mesh, order=3)
+    weights = fes.ElementWeights()
+    assert len(weights) == mesh.ne
+    for el in fes.Elements(VOL):
+        assert weights[el.nr] == len(fes.GetDofNrs(el))
+    # a single partition is balanced
+    assert fes.LoadImbalance() == 1
+
+def test_fespace_cache(tmpdir):
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    cachefile = str(tmpdir.join("h1.cache"))
+    mats = []
+    for run in range(2):
+        fes = H1(mesh, order=3, dirichlet=".*", cache=cachefile)
+        u,v = fes.TnT()
+        a = BilinearForm(fes)
+        a += grad(u)*grad(v)*dx
+        a.Assemble()
+        mats.append(a.mat)
+    import os
+    assert os.path.exists(cachefile)
+    vec = mats[0].CreateColVector()
+    for i in range(len(vec)):
+        vec[i] = i % 7
+    w = vec.CreateVector()
+    w.data = mats[0]*vec - mats[1]*vec
+    assert Norm(w) < 1e-12 * Norm(vec)
+
+    # a different order does not use the stale cache
+    fes = H1(mesh, order=2, cache=cachefile)
+    a = BilinearForm(fes)
+    a += fes.TrialFunction()*fes.TestFunction()*dx
+    a.Assemble()
+    assert a.mat.height == fes.ndof
+
+def test_dof_tables():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    results = []
+    for dof_tables in [False, True]:
+        fes = H1(mesh, order=3, dirichlet="left", dof_tables=dof_tables)
+        u,v = fes.TnT()
+        a = BilinearForm(fes)
+        a += grad(u)*grad(v)*dx + u*v*ds
+        a.Assemble()
+        gfu = GridFunction(fes)
+        gfu.Set(x*y)
+        results.append((a.mat, fes, Integrate(gfu*gfu, mesh)))
+        names = [mu[0] for mu in fes.__memory__]
+        assert ("element dof table" in names) == dof_tables
+    (m0, fes0, i0), (m1, fes1, i1) = results
+    for el0, el1 in zip(fes0.Elements(BND), fes1.Elements(BND)):
+        assert list(el0.dofs) == list(el1.dofs)
+    vec = m0.CreateColVector()
+    for i in range(len(vec)):
+        vec[i] = i % 5
+    w = vec.CreateVector()
+    w.data = m0*vec - m1*vec
+    assert Norm(w) < 1e-12 * Norm(vec)
+    assert abs(i0-i1) < 1e-12
+
+def test_coloring_strategies():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.1))
+    mats = []
+    with TaskManager():
+        for coloring in ["default", "balanced", "local"]:
+            fes = H1(mesh, order=2, coloring=coloring)
+            u,v = fes.TnT()
+            a = BilinearForm(fes)
+            a += (grad(u)*grad(v)+u*v)*dx
+            a.Assemble()
+            mats.append(a.mat)
+    vec = mats[0].CreateColVector()
+    for i in range(len(vec)):
+        vec[i] = i % 3
+    w = vec.CreateVector()
+    for m in mats[1:]:
+        w.data = mats[0]*vec - m*vec
+        assert Norm(w) < 1e-12 * Norm(vec)
+    with pytest.raises(Exception):
+        H1(mesh, order=1, coloring="unknown")
+
+def test_fe_cache():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2, quad_dominated=True))
+    mats = []
+    for fe_cache in [False, True]:
+        fes = H1(mesh, order=4, fe_cache=fe_cache)
+        u,v = fes.TnT()
+        a = BilinearForm(fes)
+        a += (grad(u)*grad(v)+u*v)*dx + u*v*ds
+        a.Assemble()
+        mats.append(a.mat)
+        names = [mu[0] for mu in fes.__memory__]
+        assert ("H1HighOrder::fe_cache" in names) == fe_cache
+        for el in fes.Elements(VOL):
+            assert fes.GetFE(el).ndof == len(el.dofs)
+    vec = mats[0].CreateColVector()
+    for i in range(len(vec)):
+        vec[i] = i % 7
+    w = vec.CreateVector()
+    w.data = mats[0]*vec - mats[1]*vec
+    assert Norm(w) < 1e-12 * Norm(vec)
+
+def test_compress_embedding():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = H1(mesh, order=3, dirichlet="left|bottom")
+    cfes = Compress(fes, active_dofs=fes.FreeDofs())
+    assert cfes.ndof == sum(fes.FreeDofs())
+    mats = []
+    for space in [fes, cfes]:
+        u,v = space.TnT()
+        a = BilinearForm(space)
+        a += (grad(u)*grad(v)+u*v)*dx
+        a.Assemble()
+        mats.append(a.mat)
+    E = cfes.Embedding()
+    assert E.height == fes.ndof and E.width == cfes.ndof
+    x = mats[1].CreateColVector()
+    for i in range(len(x)):
+        x[i] = i % 5
+    w = x.CreateVector()
+    w.data = (E.T @ mats[0] @ E) * x - mats[1] * x
+    assert Norm(w) < 1e-12 * Norm(x)
+    # restriction followed by embedding keeps exactly the free dofs
+    full = mats[0].CreateColVector()
+    full[:] = 1
+    y = full.CreateVector()
+    y.data = (E @ E.T) * full
+    assert InnerProduct(y, y) == sum(fes.FreeDofs())
+
+def test_transfer_matrix():
+    mesh1 = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    mesh2 = Mesh(unit_square.GenerateMesh(maxh=0.13))
+    func = x*x + 2*x*y - y
+    fes1 = H1(mesh1, order=3)
+    gf1 = GridFunction(fes1)
+    gf1.Set(func)
+    for fes2 in [H1(mesh2, order=2), L2(mesh2, order=2)]:
+        T = TransferMatrix(fes1, fes2)
+        assert T.height == fes2.ndof and T.width == fes1.ndof
+        gf2 = GridFunction(fes2)
+        gf2.vec.data = T * gf1.vec
+        assert sqrt(Integrate((gf2-func)**2, mesh2)) < 1e-10
+
+def test_set_values():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    func = x*x*y + 2*x - y*y
+    for fes, cf in [(H1(mesh, order=3), func),
+                    (H1(mesh, order=3, complex=True), func),
+                    (H1(mesh, order=3, dim=2), CoefficientFunction((func, x*y)))]:
+        gfu = GridFunction(fes)
+        gfu.Set(cf)
+        assert sqrt(abs(Integrate(InnerProduct(gfu-cf, gfu-cf), mesh))) < 1e-10
+    fes = H1(mesh, order=3, dirichlet="left|bottom")
+    gfu = GridFunction(fes)
+    gfu.Set(func, BND)
+    assert sqrt(Integrate((gfu-func)**2, mesh, definedon=mesh.Boundaries("left|bottom"))) < 1e-10
+    assert Norm(gfu.vec) > 0
+    gfu.Set(func, definedon=mesh.Boundaries("right"))
+    assert sqrt(Integrate((gfu-func)**2, mesh, definedon=mesh.Boundaries("right"))) < 1e-10
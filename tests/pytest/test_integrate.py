@@ -25,3 +25,91 @@ def test_integrate_xy():
     intC = Integrate(1j*x*y,mesh)
     assert abs(intR-1./4) < 1e-14
     assert abs(intC- 1j*1./4) < 1e-14
+
+def test_threaded_solves():
+    import threading
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.1))
+
+    def solve(order):
+        fes = H1(mesh, order=order, dirichlet=".*")
+        u,v = fes.TnT()
+        a = BilinearForm(fes)
+        a += grad(u)*grad(v)*dx
+        a.Assemble()
+        f = LinearForm(fes)
+        f += v*dx
+        f.Assemble()
+        gfu = GridFunction(fes)
+        inv = CGSolver(a.mat, a.mat.CreateSmoother(fes.FreeDofs()), precision=1e-12, maxsteps=1000)
+        gfu.vec.data = inv * f.vec
+        return Integrate(gfu, mesh)
+
+    expected = [solve(order) for order in range(1,5)]
+    results = [None]*len(expected)
+    def run(i):
+        results[i] = solve(i+1)
+    with TaskManager():
+        threads = [threading.Thread(target=run, args=(i,)) for i in range(len(expected))]
+        for t in threads: t.start()
+        for t in threads: t.join()
+    for r,e in zip(results, expected):
+        assert abs(r-e) < 1e-10
+
+def test_integrate_list():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    cfs = [x, x*y, CoefficientFunction((x,y)), 1j*y, 3]
+    with TaskManager():
+        res = Integrate(cfs, mesh, order=4)
+        bnd = Integrate(cfs, mesh, BND, order=4, region_wise=True)
+    for cf, r in zip(cfs, res):
+        single = Integrate(cf, mesh, order=4)
+        if isinstance(r, (int, float, complex)):
+            assert abs(r-single) < 1e-12
+        else:
+            assert max(abs(a-b) for a,b in zip(r, single)) < 1e-12
+    assert abs(res[3]-0.5j) < 1e-12
+    for i, cf in enumerate([x, x*y, 1j*y, 3]):
+        k = [0,1,3,4][i]
+        single = Integrate(cf, mesh, BND, order=4, region_wise=True)
+        for a,b in zip(bnd[k], single):
+            assert abs(a-b) < 1e-12
+
+def test_zz_error_estimator():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = H1(mesh, order=2, dirichlet=".*")
+    u,v = fes.TnT()
+    a = BilinearForm(fes, symmetric=True)
+    a += SymbolicBFI(grad(u)*grad(v))
+    f = LinearForm(fes)
+    f += SymbolicLFI(v)
+    a.Assemble()
+    f.Assemble()
+    gfu = GridFunction(fes)
+    gfu.vec.data = a.mat.Inverse(fes.FreeDofs()) * f.vec
+
+    gfflux = GridFunction(H1(mesh, order=2, dim=2))
+    with TaskManager():
+        err = ZZErrorEstimator(gfu, gfflux, BFI("laplace", coef=1))
+    diff = grad(gfu)-gfflux
+    ref = Integrate(diff*diff, mesh, order=4, element_wise=True)
+    assert len(err) == mesh.ne
+    for i in range(mesh.ne):
+        assert abs(err[i]-ref[i]) < 1e-10 + 1e-8*ref[i]
+    assert max(err) > 0
+
+def test_element_norms():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = H1(mesh, order=2)
+    gfu = GridFunction(fes)
+    gfu.Set(x*x*y)
+    uex = sin(x)*y
+    cfs = [gfu-uex, grad(gfu)-CoefficientFunction((cos(x)*y, sin(x))), 1j*(gfu-uex)]
+    with TaskManager():
+        err = ElementNorms(cfs, mesh, order=6)
+    assert err.shape == (mesh.ne, 3)
+    e0 = Integrate((gfu-uex)*(gfu-uex), mesh, order=6, element_wise=True)
+    e1 = Integrate(InnerProduct(cfs[1],cfs[1]), mesh, order=6, element_wise=True)
+    for i in range(mesh.ne):
+        assert abs(err[i,0]-e0[i]) < 1e-12 + 1e-10*e0[i]
+        assert abs(err[i,1]-e1[i]) < 1e-12 + 1e-10*e1[i]
+        assert abs(err[i,2]-e0[i]) < 1e-12 + 1e-10*e0[i]
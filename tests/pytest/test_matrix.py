@@ -103,3 +103,504 @@ if __name__ == "__main__":
     test_matrix()
     test_matrix_numpy()
     test_sparsematrix_access()
+
+def test_shared_matrix_graph():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.3))
+    fes = H1(mesh, order=3)
+    u,v = fes.TnT()
+
+    mats = []
+    for i in range(2):
+        a = BilinearForm(fes)
+        a += SymbolicBFI((i+1)*u*v)
+        a.Assemble()
+        mats.append(a.mat)
+    assert mats[0].nze == mats[1].nze
+    tmp = mats[0].AsVector().CreateVector()
+    tmp.data = 2*mats[0].AsVector() - mats[1].AsVector()
+    assert Norm(tmp) < 1e-12
+
+    ac = BilinearForm(fes, condense=True)
+    ac += SymbolicBFI(u*v)
+    ac.Assemble()
+    assert ac.mat.nze < mats[0].nze
+
+    mesh.Refine()
+    fes.Update()
+    a = BilinearForm(fes)
+    a += SymbolicBFI(u*v)
+    a.Assemble()
+    assert a.mat.height == fes.ndof
+
+def test_scattermap():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.3))
+    fes = H1(mesh, order=3)
+    u,v = fes.TnT()
+
+    for flags in [{}, {"symmetric" : True}, {"condense" : True}]:
+        mats = []
+        for scattermap in [False, True]:
+            a = BilinearForm(fes, scattermap=scattermap, **flags)
+            a += SymbolicBFI(grad(u)*grad(v)+u*v)
+            a += SymbolicBFI(u*v, BND)
+            a.Assemble()
+            mats.append(a.mat)
+        tmp = mats[0].AsVector().CreateVector()
+        tmp.data = mats[0].AsVector() - mats[1].AsVector()
+        assert Norm(tmp) < 1e-12 * Norm(mats[0].AsVector())
+
+def test_compress_condensed():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = H1(mesh, order=4)
+    u,v = fes.TnT()
+
+    results = []
+    for flags in [{}, {"compress_condensed" : True}, {"compress_condensed_share" : True},
+                  {"compress_condensed_single" : True}]:
+        a = BilinearForm(fes, condense=True, **flags)
+        a += SymbolicBFI(grad(u)*grad(v)+u*v)
+        with TaskManager():
+            a.Assemble()
+        x = a.mat.CreateColVector()
+        x.FV().NumPy()[:] = np.arange(fes.ndof) / fes.ndof
+        res = []
+        for m in [a.harmonic_extension, a.harmonic_extension_trans, a.inner_solve]:
+            y = x.CreateVector()
+            with TaskManager():
+                y.data = m * x
+            res.append(y)
+        results.append(res)
+
+    for res, tol in zip(results[1:], [1e-12, 1e-12, 1e-6]):
+        for y, yref in zip(res, results[0]):
+            tmp = y.CreateVector()
+            tmp.data = y - yref
+            assert Norm(tmp) < tol * Norm(yref)
+
+def test_batch_condense():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    order = 3
+    V = L2(mesh, order=order)
+    F = FacetFESpace(mesh, order=order, dirichlet=".*")
+    fes = FESpace([V,F])
+    (u,uhat),(v,vhat) = fes.TnT()
+    n = specialcf.normal(2)
+    h = specialcf.mesh_size
+    alpha = 4*order**2
+
+    results = []
+    for batch in [False, True]:
+        a = BilinearForm(fes, symmetric=True, condense=True, batch_condense=batch)
+        a += SymbolicBFI(grad(u)*grad(v))
+        a += SymbolicBFI(alpha/h*(u-uhat)*(v-vhat) - grad(u)*n*(v-vhat) - grad(v)*n*(u-uhat),
+                         element_boundary=True)
+        with TaskManager():
+            a.Assemble()
+        x = a.mat.CreateColVector()
+        x.FV().NumPy()[:] = np.arange(fes.ndof) / fes.ndof
+        res = []
+        for m in [a.mat, a.harmonic_extension, a.harmonic_extension_trans, a.inner_solve]:
+            y = x.CreateVector()
+            y.data = m * x
+            res.append(y)
+        results.append(res)
+
+    for y, yref in zip(results[1], results[0]):
+        tmp = y.CreateVector()
+        tmp.data = y - yref
+        assert Norm(tmp) < 1e-10 * Norm(yref)
+
+def test_atomic_assembly():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = H1(mesh, order=2)
+    u,v = fes.TnT()
+
+    for flags in [{}, {"symmetric" : True}]:
+        mats = []
+        for atomic in [False, True]:
+            a = BilinearForm(fes, atomic_assembly=atomic, **flags)
+            a += SymbolicBFI(grad(u)*grad(v)+u*v)
+            with TaskManager():
+                a.Assemble()
+            mats.append(a.mat)
+        tmp = mats[0].AsVector().CreateVector()
+        tmp.data = mats[0].AsVector() - mats[1].AsVector()
+        assert Norm(tmp) < 1e-12 * Norm(mats[0].AsVector())
+
+def test_reassemble_region():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.3))
+    fes = H1(mesh, order=2)
+    u,v = fes.TnT()
+    p = Parameter(1)
+
+    a = BilinearForm(fes, store_elmats=True)
+    a += SymbolicBFI(p*grad(u)*grad(v)+u*v)
+    a.Assemble()
+
+    p.Set(3)
+    a.ReassembleRegion(mesh.Materials("nonexisting"))
+    b = BilinearForm(fes)
+    b += SymbolicBFI(grad(u)*grad(v)+u*v)
+    b.Assemble()
+    tmp = a.mat.AsVector().CreateVector()
+    tmp.data = a.mat.AsVector() - b.mat.AsVector()
+    assert Norm(tmp) < 1e-12 * Norm(b.mat.AsVector())
+
+    a.ReassembleRegion(mesh.Materials(".*"))
+    b = BilinearForm(fes)
+    b += SymbolicBFI(3*grad(u)*grad(v)+u*v)
+    b.Assemble()
+    tmp.data = a.mat.AsVector() - b.mat.AsVector()
+    assert Norm(tmp) < 1e-12 * Norm(b.mat.AsVector())
+
+def test_cached_elmats():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.3))
+    fes = H1(mesh, order=2)
+    u,v = fes.TnT()
+    dt = Parameter(0.1)
+
+    a = BilinearForm(fes)
+    a += SymbolicBFI(u*v).CacheElementMatrices()
+    a += SymbolicBFI(grad(u)*grad(v)).CacheElementMatrices(factor=dt)
+    a.Assemble()
+
+    dt.Set(0.5)
+    a.Assemble()
+    b = BilinearForm(fes)
+    b += SymbolicBFI(u*v+0.5*grad(u)*grad(v))
+    b.Assemble()
+    tmp = a.mat.AsVector().CreateVector()
+    tmp.data = a.mat.AsVector() - b.mat.AsVector()
+    assert Norm(tmp) < 1e-12 * Norm(b.mat.AsVector())
+
+def test_pipelined_assembly():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = H1(mesh, order=3)
+    u,v = fes.TnT()
+
+    mats = []
+    for batch in [0, 7]:
+        a = BilinearForm(fes, pipeline_batch=batch)
+        a += SymbolicBFI(grad(u)*grad(v)+u*v)
+        a += SymbolicBFI(u*v, BND)
+        a.Assemble()
+        mats.append(a.mat)
+    tmp = mats[0].AsVector().CreateVector()
+    tmp.data = mats[0].AsVector() - mats[1].AsVector()
+    assert Norm(tmp) < 1e-12 * Norm(mats[0].AsVector())
+
+def test_linearization_plan():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.3))
+    fes = H1(mesh, order=2)
+    u,v = fes.TnT()
+    lin = GridFunction(fes)
+
+    mats = []
+    for plan in [False, True]:
+        a = BilinearForm(fes, linearization_plan=plan)
+        a += SymbolicBFI(grad(u)*grad(v)+u*u*u*v)
+        a += SymbolicBFI(u*u*v, BND)
+        for val in [1, 2]:
+            lin.Set(val*x)
+            a.AssembleLinearization(lin.vec)
+        mats.append(a.mat)
+    tmp = mats[0].AsVector().CreateVector()
+    tmp.data = mats[0].AsVector() - mats[1].AsVector()
+    assert Norm(tmp) < 1e-12 * Norm(mats[0].AsVector())
+
+def test_atomic_linearform():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.3))
+    for fes in [H1(mesh, order=3), H1(mesh, order=3, complex=True)]:
+        v = fes.TestFunction()
+        vecs = []
+        for atomic in [False, True]:
+            f = LinearForm(fes, atomic_assembly=atomic)
+            f += SymbolicLFI(x*v)
+            f += SymbolicLFI(y*v)
+            f += SymbolicLFI(v, BND)
+            f.Assemble()
+            vecs.append(f.vec)
+        tmp = vecs[0].CreateVector()
+        tmp.data = vecs[0] - vecs[1]
+        assert Norm(tmp) < 1e-12 * Norm(vecs[0])
+
+def test_sellcsigma():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = H1(mesh, order=3, dirichlet="left")
+    u,v = fes.TnT()
+    for sym in [False, True]:
+        a = BilinearForm(fes, symmetric=sym)
+        a += SymbolicBFI(grad(u)*grad(v)+u*v)
+        a.Assemble()
+        sell = SellCSigmaMatrix(a.mat, sigma=32)
+
+        gfu = GridFunction(fes)
+        gfu.Set(sin(3*x)*y+1)
+        y1 = a.mat.CreateColVector()
+        y2 = a.mat.CreateColVector()
+        y1.data = a.mat * gfu.vec
+        y2.data = sell * gfu.vec
+        y2.data -= y1
+        assert Norm(y2) < 1e-12 * Norm(y1)
+
+def test_blocked_sparsematrix():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = VectorH1(mesh, order=2)
+    u,v = fes.TnT()
+    gfu = GridFunction(fes)
+    gfu.Set((sin(3*x)*y+1, x*x))
+    for sym in [False, True]:
+        a = BilinearForm(fes, symmetric=sym)
+        a += SymbolicBFI(InnerProduct(grad(u),grad(v))+div(u)*div(v)+u*v)
+        a.Assemble()
+        blocked = CreateBlockedSparseMatrix(a.mat, 2)
+        assert blocked != None
+
+        y1 = a.mat.CreateColVector()
+        y2 = a.mat.CreateColVector()
+        y1.data = a.mat * gfu.vec
+        y2.data = blocked * gfu.vec
+        y2.data -= y1
+        assert Norm(y2) < 1e-12 * Norm(y1)
+
+def test_symmetric_multadd():
+    mesh = Mesh(unit_cube.GenerateMesh(maxh=0.3))
+    fes = H1(mesh, order=3)
+    u,v = fes.TnT()
+    gfu = GridFunction(fes)
+    gfu.Set(sin(3*x)*y+z)
+    mats = []
+    for sym in [False, True]:
+        a = BilinearForm(fes, symmetric=sym)
+        a += SymbolicBFI(grad(u)*grad(v)+u*v)
+        a.Assemble()
+        mats.append(a.mat)
+
+    y1 = mats[0].CreateColVector()
+    y2 = mats[0].CreateColVector()
+    y1.data = mats[0] * gfu.vec
+    with TaskManager():
+        y2.data = mats[1] * gfu.vec
+    y2.data -= y1
+    assert Norm(y2) < 1e-12 * Norm(y1)
+
+def test_reordered_fespace():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.1))
+    fes = H1(mesh, order=2, dirichlet="left|bottom")
+    results = []
+    for space in [fes, Reorder(fes)]:
+        assert space.ndof == fes.ndof
+        u,v = space.TnT()
+        a = BilinearForm(space)
+        a += SymbolicBFI(grad(u)*grad(v))
+        a.Assemble()
+        f = LinearForm(space)
+        f += SymbolicLFI(v)
+        f.Assemble()
+        gfu = GridFunction(space)
+        gfu.vec.data = a.mat.Inverse(space.FreeDofs()) * f.vec
+        rows,cols,vals = a.mat.COO()
+        bandwidth = max(abs(np.array(rows)-np.array(cols)))
+        results.append((Integrate(gfu*gfu, mesh), bandwidth))
+    assert abs(results[0][0]-results[1][0]) < 1e-10
+    assert results[1][1] < results[0][1]
+
+def test_deltaindex_sparsematrix():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = Reorder(H1(mesh, order=3))
+    u,v = fes.TnT()
+    gfu = GridFunction(fes)
+    gfu.Set(sin(3*x)*y+1)
+    for sym in [False, True]:
+        a = BilinearForm(fes, symmetric=sym)
+        a += SymbolicBFI(grad(u)*grad(v)+u*v)
+        a.Assemble()
+        dmat = DeltaIndexSparseMatrix(a.mat)
+        assert dmat.nwiderows == 0
+
+        y1 = a.mat.CreateColVector()
+        y2 = a.mat.CreateColVector()
+        y1.data = a.mat * gfu.vec
+        y2.data = dmat * gfu.vec
+        y2.data -= y1
+        assert Norm(y2) < 1e-12 * Norm(y1)
+
+def test_restrict_reuse():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = H1(mesh, order=2)
+    u,v = fes.TnT()
+    # prolongation from the vertex dofs
+    nv = mesh.nv
+    prol = SparseMatrixd.CreateFromCOO(list(range(nv)), list(range(nv)), [1.0]*nv, fes.ndof, nv)
+    for sym in [False, True]:
+        a = BilinearForm(fes, symmetric=sym)
+        a += SymbolicBFI(grad(u)*grad(v)+u*v)
+        a.Assemble()
+        cmat = a.mat.Restrict(prol)
+
+        b = BilinearForm(fes, symmetric=sym)
+        b += SymbolicBFI(3*grad(u)*grad(v)+u*v)
+        b.Assemble()
+        cref = b.mat.Restrict(prol)
+        cmat2 = b.mat.Restrict(prol, cmat)
+
+        x = cref.CreateColVector()
+        x.FV().NumPy()[:] = np.random.rand(nv)
+        y1 = x.CreateVector()
+        y2 = x.CreateVector()
+        y1.data = cref * x
+        y2.data = cmat2 * x
+        y2.data -= y1
+        assert Norm(y2) < 1e-12 * Norm(y1)
+
+def test_float_sparsematrix():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = H1(mesh, order=2, dirichlet="left")
+    u,v = fes.TnT()
+    gfu = GridFunction(fes)
+    gfu.Set(sin(3*x)*y+1)
+    for sym in [False, True]:
+        a = BilinearForm(fes, symmetric=sym)
+        a += SymbolicBFI(grad(u)*grad(v)+u*v)
+        a.Assemble()
+        fmat = a.mat.ToFloat()
+
+        y1 = a.mat.CreateColVector()
+        y2 = a.mat.CreateColVector()
+        y1.data = a.mat * gfu.vec
+        y2.data = fmat * gfu.vec
+        y2.data -= y1
+        assert Norm(y2) < 1e-6 * Norm(y1)
+
+        # Gauss-Seidel with float entries converges to the double solution
+        f = LinearForm(fes)
+        f += SymbolicLFI(v)
+        f.Assemble()
+        sol = gfu.vec.CreateVector()
+        sol.data = a.mat.Inverse(fes.FreeDofs()) * f.vec
+        smoother = fmat.CreateSmoother(fes.FreeDofs())
+        w = gfu.vec.CreateVector()
+        w[:] = 0
+        for it in range(500):
+            smoother.Smooth(w, f.vec)
+            smoother.SmoothBack(w, f.vec)
+        w.data -= sol
+        assert Norm(w) < 1e-4 * Norm(sol)
+
+def test_kronecker_matrix():
+    mesh1 = Mesh(unit_square.GenerateMesh(maxh=0.4))
+    mesh2 = Mesh(unit_square.GenerateMesh(maxh=0.3))
+    fes1 = H1(mesh1, order=2)
+    fes2 = H1(mesh2, order=1)
+    u1,v1 = fes1.TnT()
+    u2,v2 = fes2.TnT()
+    a1 = BilinearForm(fes1)
+    a1 += SymbolicBFI(grad(u1)*grad(v1)+x*u1*v1)
+    a1.Assemble()
+    a2 = BilinearForm(fes2)
+    a2 += SymbolicBFI(u2*v2+y*grad(u2)[0]*v2)
+    a2.Assemble()
+
+    def dense(sp):
+        ri, ci, vals = sp.COO()
+        d = np.zeros((sp.height, sp.width))
+        for i, j, v in zip(ri, ci, vals):
+            d[i,j] += v
+        return d
+    d1 = dense(a1.mat)
+    d2 = dense(a2.mat)
+    kron = np.kron(d1, d2)
+
+    m1 = Matrix(*d1.shape)
+    m1.NumPy()[:] = d1
+    m2 = Matrix(*d2.shape)
+    m2.NumPy()[:] = d2
+    for op in [KroneckerMatrix(a1.mat, a2.mat), KroneckerMatrix(m1, m2)]:
+        assert op.height == fes1.ndof*fes2.ndof and op.width == fes1.ndof*fes2.ndof
+        x = op.CreateRowVector()
+        y = op.CreateColVector()
+        x.FV().NumPy()[:] = np.random.rand(len(x))
+        y.data = op * x
+        assert np.linalg.norm(y.FV().NumPy() - kron @ x.FV().NumPy()) < 1e-10 * np.linalg.norm(y.FV().NumPy())
+        y.data = op.T * x
+        assert np.linalg.norm(y.FV().NumPy() - kron.T @ x.FV().NumPy()) < 1e-10 * np.linalg.norm(y.FV().NumPy())
+
+def test_csr_views():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.3))
+    fes = H1(mesh, order=2)
+    u,v = fes.TnT()
+    a = BilinearForm(fes, symmetric=False)
+    a += SymbolicBFI(grad(u)*grad(v)+u*v)
+    a.Assemble()
+
+    # views share the memory with the matrix
+    vals, colind, first = a.mat.CSR()
+    assert len(first) == a.mat.height+1 and len(vals) == len(colind) == first[-1]
+    ri, ci, cvals = a.mat.COO()
+    assert np.allclose(np.array(cvals), vals)
+    vals[0] = 17
+    assert a.mat[0, colind[0]] == 17
+    vals[0] = cvals[0]
+
+    # a matrix on numpy arrays, without copying
+    nvals, ncolind, nfirst = np.array(vals), np.array(colind), np.array(first)
+    mat = type(a.mat).FromCSR(nvals, ncolind, nfirst, a.mat.width)
+    del nvals, ncolind, nfirst
+    x = a.mat.CreateColVector()
+    y1 = a.mat.CreateColVector()
+    y2 = a.mat.CreateColVector()
+    x.FV().NumPy()[:] = np.random.rand(len(x))
+    y1.data = a.mat * x
+    y2.data = mat * x
+    y2.data -= y1
+    assert Norm(y2) < 1e-12 * Norm(y1)
+    mvals = mat.CSR()[0]
+    mvals *= 2
+    y2.data = mat * x
+    y2.data -= 2*y1
+    assert Norm(y2) < 1e-12 * Norm(y1)
+
+    with pytest.raises(Exception):
+        type(a.mat).FromCSR(np.array(vals), np.array(colind[::-1]), np.array(first), a.mat.width)
+
+    # blocked values have the shape of scipy's bsr_matrix data
+    fes2 = H1(mesh, order=1, dim=2)
+    u,v = fes2.TnT()
+    a2 = BilinearForm(fes2, symmetric=False)
+    a2 += SymbolicBFI(InnerProduct(grad(u),grad(v)) + InnerProduct(u,v))
+    a2.Assemble()
+    vals2, colind2, first2 = a2.mat.CSR()
+    assert vals2.shape == (len(colind2), 2, 2)
+    mat2 = type(a2.mat).FromCSR(np.array(vals2), np.array(colind2), np.array(first2), a2.mat.width)
+    x = a2.mat.CreateColVector()
+    y1 = a2.mat.CreateColVector()
+    y2 = a2.mat.CreateColVector()
+    x.FV().NumPy()[:] = np.random.rand(len(x.FV()))
+    y1.data = a2.mat * x
+    y2.data = mat2 * x
+    y2.data -= y1
+    assert Norm(y2) < 1e-12 * Norm(y1)
+
+def test_composed_operators():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.3))
+    fes = H1(mesh, order=2)
+    u,v = fes.TnT()
+    a = BilinearForm(grad(u)*grad(v)*dx).Assemble()
+    m = BilinearForm(u*v*dx).Assemble()
+    x = a.mat.CreateColVector()
+    x.FV().NumPy()[:] = np.random.rand(len(x))
+    ma, mm = a.mat, m.mat
+    op = ma @ mm + 2*mm - ma.T @ mm.T
+    tmp, y, z = x.CreateVector(), x.CreateVector(), x.CreateVector()
+    for i in range(3):
+        # repeated applications reuse the intermediate vectors
+        y.data = op * x
+        z.data = mm * x
+        tmp.data = ma * z
+        z.data = 2 * mm * x + tmp
+        tmp.data = mm * x
+        z.data -= ma * tmp
+        assert Norm(y-z) < 1e-10 * Norm(z)
+    z.data = op.T * x
+    y.data = (mm @ ma).T * x + 2 * mm * x - (mm.T @ ma.T).T * x
+    assert Norm(y-z) < 1e-10 * Norm(z)
@@ -18,3 +18,41 @@ def test_call_operator_with_vectorization():
     mesh = Mesh(unit_cube.GenerateMesh(maxh=1))
     p = mesh(0.5,0.5,0.5)
     p2 = mesh([0.5, 0.1],0.5,0.5)
+
+def test_find_elements_of_points():
+    mesh = Mesh(unit_cube.GenerateMesh(maxh=0.3))
+    import random
+    random.seed(1)
+    points = [(random.random(), random.random(), random.random()) for i in range(200)]
+    points.append((1.5, 0.5, 0.5))
+    mips = mesh.FindElementsOfPoints(points)
+    assert mips[-1].nr == -1
+    cf = CoefficientFunction((x,y,z))
+    for p, mip in zip(points[:-1], mips[:-1]):
+        assert mip.nr >= 0
+        assert max(abs(a-b) for a,b in zip(cf(mip), p)) < 1e-10
+    # the previous elements as hints, as for slowly moving particles
+    moved = [(p[0]*0.99, p[1], p[2]) for p in points[:-1]]
+    mips2 = mesh.FindElementsOfPoints(moved, hints=[mip.nr for mip in mips[:-1]])
+    for p, mip in zip(moved, mips2):
+        assert mip.nr >= 0
+        assert max(abs(a-b) for a,b in zip(cf(mip), p)) < 1e-10
+
+def test_evaluate_at_points():
+    import numpy as np
+    mesh = Mesh(unit_cube.GenerateMesh(maxh=0.3))
+    np.random.seed(1)
+    points = np.random.rand(2000, 3)
+    points[0] = (1.5, 0.5, 0.5)
+    fes = H1(mesh, order=2)
+    gfu = GridFunction(fes)
+    gfu.Set(x*x+y*z)
+    with TaskManager():
+        vals = EvaluateAtPoints(CoefficientFunction((gfu, 1j*x)), mesh, points)
+    assert vals.shape == (2000, 2)
+    assert np.isnan(vals[0]).all()
+    px, py, pz = points[1:].T
+    assert np.max(abs(vals[1:,0] - (px*px+py*pz))) < 1e-10
+    assert np.max(abs(vals[1:,1] - 1j*px)) < 1e-10
+    vals2 = EvaluateAtPoints(x, mesh, points[1:], hints=np.zeros(1999, dtype=int))
+    assert np.max(abs(vals2[:,0] - px)) < 1e-10
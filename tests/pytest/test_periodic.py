@@ -103,3 +103,37 @@ def test_quasiperiodic():
 
     u_true = exp(1J * k * (d[0] * x + d[1] * y + d[2] * z))
     assert sqrt(Integrate(Conj(u_true-u)*(u_true-u),mesh).real) < 1e-8
+
+def test_quasiperiodic_setphase():
+    geo = CSGeometry()
+    left = Plane(Pnt(0,0,0),Vec(-1,0,0))
+    right = Plane(Pnt(1,0,0),Vec(1,0,0))
+    bot = Plane(Pnt(0,0,0),Vec(0,0,-1))
+    top = Plane(Pnt(0,0,1),Vec(0,0,1))
+    back = Plane(Pnt(0,0,0),Vec(0,-1,0))
+    front = Plane(Pnt(0,1,0),Vec(0,1,0))
+    geo.Add(left * right * top * bot * back * front)
+    geo.PeriodicSurfaces(left,right)
+    geo.PeriodicSurfaces(back,front)
+    geo.PeriodicSurfaces(bot,top)
+    mesh = Mesh(geo.GenerateMesh(maxh=0.4))
+
+    def assemble(fes):
+        u,v = fes.TnT()
+        a = BilinearForm(fes)
+        a += (grad(u) * grad(v) + u * v) * dx
+        a.Assemble()
+        return a.mat
+
+    sweep = Periodic(H1(mesh,order=3,complex=True), phase=[1,1,1])
+    for kx in [0.3, 1.2]:
+        phase = [exp(1J*kx), exp(2J*kx), 1]
+        sweep.SetPhase(phase)
+        m1 = assemble(sweep)
+        m2 = assemble(Periodic(H1(mesh,order=3,complex=True), phase=phase))
+        vec = m1.CreateColVector()
+        for i in range(len(vec)):
+            vec[i] = (i % 7) + 1J * (i % 3)
+        w = vec.CreateVector()
+        w.data = m1*vec - m2*vec
+        assert Norm(w) < 1e-12 * Norm(vec)
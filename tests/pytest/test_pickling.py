@@ -1,6 +1,7 @@
 from netgen.geom2d import *
 from ngsolve import *
 import pickle
+import pytest
 import io
 
 def test_pickle_volume_fespaces():
@@ -183,6 +184,36 @@ def test_pickle_periodic():
     assert sqrt(Integrate((u-u2)*(u-u2),mesh)) < 1e-14
 
 
+def test_collective_checkpoint(tmpdir):
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.3))
+    fes = H1(mesh,order=3)
+    u = GridFunction(fes)
+    u.Set(x*x*y)
+    filename = str(tmpdir.join("u.gf"))
+    u.Save(filename, collective=True)
+
+    u2 = GridFunction(fes)
+    u2.Load(filename, collective=True)
+    assert sqrt(Integrate((u-u2)*(u-u2),mesh)) < 1e-14
+
+def test_background_save(tmpdir):
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.3))
+    fes = H1(mesh,order=3)
+    u = GridFunction(fes)
+    for parallel in [False, True]:
+        u.Set(x*x*y)
+        filename = str(tmpdir.join("u.gf"))
+        u.Save(filename, parallel=parallel, background=True)
+        # the snapshot is written, not the modified vector
+        u.vec[:] = 0
+        u.WaitSave()
+
+        u2 = GridFunction(fes)
+        u2.Load(filename, parallel=parallel)
+        u.Set(x*x*y)
+        assert sqrt(Integrate((u-u2)*(u-u2),mesh)) < 1e-14
+
+
 if __name__ == "__main__":
     test_pickle_volume_fespaces()
     test_pickle_surface_fespaces()
@@ -191,3 +222,32 @@ if __name__ == "__main__":
     test_pickle_compoundfespace()
     test_pickle_hcurl()
     test_pickle_periodic()
+
+def test_pickle_protocol5_buffers():
+    if pickle.HIGHEST_PROTOCOL < 5:
+        pytest.skip("pickle protocol 5 needs python 3.8")
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = H1(mesh, order=3)
+    u, v = fes.TnT()
+    a = BilinearForm(fes)
+    a += grad(u)*grad(v)*dx
+    a.Assemble()
+    gfu = GridFunction(fes)
+    gfu.Set(x*y)
+
+    for obj in [gfu.vec, a.mat]:
+        buffers = []
+        data = pickle.dumps(obj, protocol=5, buffer_callback=buffers.append)
+        # the large arrays are not part of the pickle
+        assert len(buffers) > 0
+        assert len(data) < 1000
+        obj2 = pickle.loads(data, buffers=buffers)
+        # in-band protocol 5 gives the same result
+        obj3 = pickle.loads(pickle.dumps(obj, protocol=5))
+        for o in [obj2, obj3]:
+            w = gfu.vec.CreateVector()
+            if obj is a.mat:
+                w.data = o * gfu.vec - a.mat * gfu.vec
+            else:
+                w.data = o - gfu.vec
+            assert Norm(w) == 0
@@ -1,6 +1,7 @@
 from netgen.geom2d import unit_square
 from ngsolve import *
 import pytest
+import math
 
 def test_arnoldi():
     SetHeapSize (10*1000*1000)
@@ -43,6 +44,545 @@ def test_arnoldi():
     Draw(laplace(evec),mesh,"laplace")
 
 
+def test_shift_invert_arnoldi():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = H1(mesh, order=4, dirichlet=".*")
+    u,v = fes.TnT()
+    a = BilinearForm(fes, symmetric=True)
+    a += SymbolicBFI(grad(u)*grad(v))
+    m = BilinearForm(fes, symmetric=True)
+    m += SymbolicBFI(u*v)
+    a.Assemble()
+    m.Assemble()
+
+    sia = ShiftInvertArnoldi(a.mat, m.mat, fes.FreeDofs(), inverse="sparsecholesky", blocksize=2)
+    reported = []
+    sia.SetShift(20)
+    lam, vecs = sia.Calc(1, callback=lambda conv: reported.append(conv))
+    assert abs(lam[0]-2*math.pi**2) < 1e-3*lam[0].real
+    assert len(reported) > 0 and len(reported[-1]) == 1
+
+    sia.SetShift(50)
+    lam, vecs = sia.Calc(2)
+    for l in lam:
+        assert abs(l-5*math.pi**2) < 1e-3*l.real
+    assert sia.numfactorizations == 1 and sia.numupdates == 1
+    assert len(vecs) == 2
+
+
 
 if __name__ == "__main__":
     test_arnoldi()
+
+def test_nonassemble_complex():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.3))
+    fes = H1(mesh,order=4,complex=True)
+    u,v = fes.TnT()
+
+    forms = []
+    for nonassemble in [False, True]:
+        a = BilinearForm(fes, nonassemble=nonassemble)
+        a += SymbolicBFI(grad(u)*grad(v)+(1+1j*x)*u*v)
+        a.Assemble()
+        forms.append(a)
+
+    gfx = GridFunction(fes)
+    gfx.Set((1+2j)*x*y)
+    ya = gfx.vec.CreateVector()
+    yn = gfx.vec.CreateVector()
+    ya.data = forms[0].mat * gfx.vec
+    yn.data = forms[1].mat * gfx.vec
+    ya.data -= yn
+    assert Norm(ya) < 1e-10 * Norm(yn)
+
+def test_compute_internal():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.3))
+    fes = H1(mesh, order=4, dirichlet="left")
+    u,v = fes.TnT()
+    a = BilinearForm(fes, condense=True)
+    a += SymbolicBFI(grad(u)*grad(v)+u*v)
+    f = LinearForm(fes)
+    f += SymbolicLFI(x*v)
+    a.Assemble()
+    f.Assemble()
+
+    rhs = f.vec.CreateVector()
+    rhs.data = f.vec
+    rhs.data += a.harmonic_extension_trans * rhs
+    inv = a.mat.Inverse(fes.FreeDofs(True))
+    gfu = GridFunction(fes)
+    gfu.vec.data = inv * rhs
+    gfu.vec.data += a.harmonic_extension * gfu.vec
+    gfu.vec.data += a.inner_solve * rhs
+
+    gfu2 = GridFunction(fes)
+    gfu2.vec.data = inv * rhs
+    a.ComputeInternal(gfu2.vec, rhs)
+    tmp = gfu.vec.CreateVector()
+    tmp.data = gfu.vec - gfu2.vec
+    assert Norm(tmp) < 1e-10 * Norm(gfu.vec)
+
+def test_sparsecholesky_supernodes():
+    from netgen.csg import unit_cube
+    mesh = Mesh(unit_cube.GenerateMesh(maxh=0.3))
+    for cplx in [False, True]:
+        fes = H1(mesh, order=3, dirichlet=".*", complex=cplx)
+        u,v = fes.TnT()
+        a = BilinearForm(fes, symmetric=True)
+        a += SymbolicBFI(grad(u)*grad(v)+u*v)
+        a.Assemble()
+        f = LinearForm(fes)
+        f += SymbolicLFI(x*v)
+        f.Assemble()
+        gfu = GridFunction(fes)
+        with TaskManager():
+            inv = a.mat.Inverse(fes.FreeDofs(), inverse="sparsecholesky")
+            gfu.vec.data = inv * f.vec
+        res = f.vec.CreateVector()
+        res.data = f.vec - a.mat * gfu.vec
+        for i in range(fes.ndof):
+            if not fes.FreeDofs()[i]: res[i] = 0
+        assert Norm(res) < 1e-10 * Norm(f.vec)
+
+def test_sparsecholesky_nested_dissection():
+    from netgen.geom2d import unit_square
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.05))
+    fes = H1(mesh, order=2, dirichlet=".*")
+    u,v = fes.TnT()
+    a = BilinearForm(fes, symmetric=True)
+    a += SymbolicBFI(grad(u)*grad(v))
+    a.Assemble()
+    f = LinearForm(fes)
+    f += SymbolicLFI(v)
+    f.Assemble()
+    gfu = GridFunction(fes)
+    gfu2 = GridFunction(fes)
+    with TaskManager():
+        gfu.vec.data = a.mat.Inverse(fes.FreeDofs(), inverse="sparsecholesky") * f.vec
+        gfu2.vec.data = a.mat.Inverse(fes.FreeDofs(), inverse="sparsecholesky_nd") * f.vec
+    assert a.mat.GetInverseType() == "sparsecholesky_nd"
+    tmp = gfu.vec.CreateVector()
+    tmp.data = gfu.vec - gfu2.vec
+    assert Norm(tmp) < 1e-10 * Norm(gfu.vec)
+
+def test_sparsecholesky_multivector():
+    from netgen.geom2d import unit_square
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.1))
+    fes = H1(mesh, order=3, dirichlet=".*")
+    u,v = fes.TnT()
+    a = BilinearForm(fes, symmetric=True)
+    a += SymbolicBFI(grad(u)*grad(v)+u*v)
+    a.Assemble()
+    inv = a.mat.Inverse(fes.FreeDofs(), inverse="sparsecholesky")
+    k = 5
+    x = MultiVector(fes.ndof, k)
+    y = MultiVector(fes.ndof, k)
+    vec = a.mat.CreateColVector()
+    for j in range(k):
+        for i in range(fes.ndof):
+            vec[i] = math.sin(i+j)
+        x.SetVector(j, vec)
+    with TaskManager():
+        inv.Mult(x, y)
+    res = a.mat.CreateColVector()
+    for j in range(k):
+        x.GetVector(j, vec)
+        res.data = inv * vec
+        y.GetVector(j, vec)
+        res.data -= vec
+        assert Norm(res) < 1e-12 * Norm(vec)
+
+def test_sparsecholesky_mixed():
+    from netgen.csg import unit_cube
+    mesh = Mesh(unit_cube.GenerateMesh(maxh=0.3))
+    fes = H1(mesh, order=3, dirichlet=".*")
+    u,v = fes.TnT()
+    a = BilinearForm(fes, symmetric=True)
+    a += SymbolicBFI(grad(u)*grad(v))
+    a.Assemble()
+    f = LinearForm(fes)
+    f += SymbolicLFI(x*v)
+    f.Assemble()
+    gfu = GridFunction(fes)
+    gfu2 = GridFunction(fes)
+    with TaskManager():
+        gfu.vec.data = a.mat.Inverse(fes.FreeDofs(), inverse="sparsecholesky") * f.vec
+        gfu2.vec.data = a.mat.Inverse(fes.FreeDofs(), inverse="sparsecholesky_mixed") * f.vec
+    tmp = gfu.vec.CreateVector()
+    tmp.data = gfu.vec - gfu2.vec
+    assert Norm(tmp) < 1e-9 * Norm(gfu.vec)
+
+def test_sparsecholesky_swapout(tmpdir):
+    from netgen.csg import unit_cube
+    mesh = Mesh(unit_cube.GenerateMesh(maxh=0.3))
+    fes = H1(mesh, order=3, dirichlet=".*")
+    u,v = fes.TnT()
+    a = BilinearForm(fes, symmetric=True)
+    a += SymbolicBFI(grad(u)*grad(v)+u*v)
+    a.Assemble()
+    f = LinearForm(fes)
+    f += SymbolicLFI(x*v)
+    f.Assemble()
+    gfu = GridFunction(fes)
+    gfu2 = GridFunction(fes)
+    with TaskManager():
+        inv = a.mat.Inverse(fes.FreeDofs(), inverse="sparsecholesky")
+        gfu.vec.data = inv * f.vec
+        inv.SwapOut(str(tmpdir.join("factor.bin")))
+        gfu2.vec.data = inv * f.vec
+    tmp = gfu.vec.CreateVector()
+    tmp.data = gfu.vec - gfu2.vec
+    assert Norm(tmp) < 1e-12 * Norm(gfu.vec)
+
+def test_estimate_factorization():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.1))
+    fes = H1(mesh, order=2, dirichlet=".*")
+    u,v = fes.TnT()
+    a = BilinearForm(fes, symmetric=True)
+    a += SymbolicBFI(grad(u)*grad(v))
+    a.Assemble()
+    f = LinearForm(fes)
+    f += SymbolicLFI(v)
+    f.Assemble()
+    est = a.mat.EstimateFactorization(fes.FreeDofs())
+    inv = a.mat.Inverse(fes.FreeDofs(), inverse="sparsecholesky")
+    assert est["nze"] == inv.nze
+    assert est["peakmemory"] >= est["memory"] > 8*est["nze"]
+    assert est["flops"] > 0
+
+    # fall back to CG if the factorization does not fit
+    gfu = GridFunction(fes)
+    gfu2 = GridFunction(fes)
+    gfu.vec.data = inv * f.vec
+    cg = a.mat.Inverse(fes.FreeDofs(), inverse="sparsecholesky", memory_limit=est["memory"]/2)
+    assert isinstance(cg, KrylovSpaceSolver)
+    gfu2.vec.data = cg * f.vec
+    tmp = gfu.vec.CreateVector()
+    tmp.data = gfu.vec - gfu2.vec
+    assert Norm(tmp) < 1e-8 * Norm(gfu.vec)
+
+def test_sparsecholesky_blr():
+    from netgen.csg import unit_cube
+    mesh = Mesh(unit_cube.GenerateMesh(maxh=0.2))
+    fes = H1(mesh, order=3, dirichlet=".*")
+    u,v = fes.TnT()
+    a = BilinearForm(fes, symmetric=True)
+    a += SymbolicBFI(grad(u)*grad(v))
+    a.Assemble()
+    f = LinearForm(fes)
+    f += SymbolicLFI(x*v)
+    f.Assemble()
+    gfu = GridFunction(fes)
+    gfu2 = GridFunction(fes)
+    with TaskManager():
+        inv = a.mat.Inverse(fes.FreeDofs(), inverse="sparsecholesky")
+        pre = a.mat.Inverse(fes.FreeDofs(), compression=1e-4)
+        assert pre.num_compressed > 0
+        assert pre.nze < inv.nze
+        gfu.vec.data = inv * f.vec
+        solver = CGSolver(a.mat, pre, printrates=False, precision=1e-12, maxsteps=100)
+        gfu2.vec.data = solver * f.vec
+    assert solver.GetSteps() < 30
+    tmp = gfu.vec.CreateVector()
+    tmp.data = gfu.vec - gfu2.vec
+    assert Norm(tmp) < 1e-8 * Norm(gfu.vec)
+
+def test_pipelined_cg():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.1))
+    fes = H1(mesh, order=3, dirichlet=".*")
+    u,v = fes.TnT()
+    a = BilinearForm(fes, symmetric=True)
+    a += SymbolicBFI(grad(u)*grad(v))
+    c = Preconditioner(a, "local")
+    a.Assemble()
+    f = LinearForm(fes)
+    f += SymbolicLFI(v)
+    f.Assemble()
+    gfu = GridFunction(fes)
+    gfu2 = GridFunction(fes)
+    cg = CGSolver(a.mat, c.mat, printrates=False, precision=1e-10, maxsteps=1000)
+    pcg = CGSolver(a.mat, c.mat, printrates=False, precision=1e-10, maxsteps=1000, pipelined=True)
+    gfu.vec.data = cg * f.vec
+    gfu2.vec.data = pcg * f.vec
+    assert abs(pcg.GetSteps() - cg.GetSteps()) <= 3
+    tmp = gfu.vec.CreateVector()
+    tmp.data = gfu.vec - gfu2.vec
+    assert Norm(tmp) < 1e-6 * Norm(gfu.vec)
+
+def test_block_cg():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.1))
+    fes = H1(mesh, order=2, dirichlet=".*")
+    u,v = fes.TnT()
+    a = BilinearForm(fes, symmetric=True)
+    a += SymbolicBFI(grad(u)*grad(v))
+    c = Preconditioner(a, "local")
+    a.Assemble()
+    k = 4
+    f = MultiVector(fes.ndof, k)
+    gfu = GridFunction(fes)
+    for j in range(k):
+        lf = LinearForm(fes)
+        lf += SymbolicLFI(sin((j+1)*x)*y*v)
+        lf.Assemble()
+        f.SetVector(j, lf.vec)
+    for gmres in [False, True]:
+        solver = BlockCGSolver(a.mat, c.mat, gmres=gmres, printrates=False, precision=1e-10, maxsteps=500)
+        sol = MultiVector(fes.ndof, k)
+        solver.Mult(f, sol)
+        cg = CGSolver(a.mat, c.mat, printrates=False, precision=1e-10, maxsteps=500)
+        for j in range(k):
+            hf = gfu.vec.CreateVector()
+            f.GetVector(j, hf)
+            gfu.vec.data = cg * hf
+            hu = gfu.vec.CreateVector()
+            sol.GetVector(j, hu)
+            hu.data -= gfu.vec
+            assert Norm(hu) < 1e-6 * Norm(gfu.vec)
+
+def test_lobpcg():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.1))
+    fes = H1(mesh, order=3, dirichlet=".*")
+    u,v = fes.TnT()
+    a = BilinearForm(fes, symmetric=True)
+    a += SymbolicBFI(grad(u)*grad(v))
+    pre = Preconditioner(a, "local")
+    a.Assemble()
+    m = BilinearForm(fes, symmetric=True)
+    m += SymbolicBFI(u*v)
+    m.Assemble()
+    k = 4
+    gfu = GridFunction(fes)
+    x0 = MultiVector(fes.ndof, k)
+    for j in range(k):
+        gfu.Set(x*(1-x)*y*(1-y)*(1+x**j+0.3*j*y))
+        x0.SetVector(j, gfu.vec)
+    lam = LOBPCG(a.mat, m.mat, x0, pre=pre.mat, freedofs=fes.FreeDofs(),
+                 precision=1e-8, maxsteps=500)
+    exact = [2*math.pi**2, 5*math.pi**2, 5*math.pi**2, 8*math.pi**2]
+    for j in range(k):
+        assert abs(lam[j]-exact[j]) < 1e-3 * exact[j]
+        # eigenvectors are M-normalized and fulfil A x = lam M x
+        x0.GetVector(j, gfu.vec)
+        ax = gfu.vec.CreateVector()
+        mx = gfu.vec.CreateVector()
+        ax.data = a.mat * gfu.vec
+        mx.data = m.mat * gfu.vec
+        assert abs(InnerProduct(mx, gfu.vec) - 1) < 1e-8
+        mx.data = ax - lam[j] * mx
+        assert Norm(mx) < 1e-6 * Norm(ax)
+
+def test_pmultigrid_nonassemble():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = H1(mesh, order=4, dirichlet=".*")
+    u,v = fes.TnT()
+    f = LinearForm(fes)
+    f += SymbolicLFI(x*v)
+    f.Assemble()
+    gfu = GridFunction(fes)
+    gfu2 = GridFunction(fes)
+
+    a = BilinearForm(fes, symmetric=True)
+    a += SymbolicBFI(grad(u)*grad(v))
+    a.Assemble()
+    gfu.vec.data = a.mat.Inverse(fes.FreeDofs()) * f.vec
+
+    an = BilinearForm(fes, nonassemble=True)
+    an += SymbolicBFI(grad(u)*grad(v))
+    c = Preconditioner(an, "pmultigrid")
+    an.Assemble()
+    c.Update()
+    with TaskManager():
+        solver = CGSolver(an.mat, c.mat, printrates=False, precision=1e-10, maxsteps=200)
+        gfu2.vec.data = solver * f.vec
+    assert solver.GetSteps() < 100
+    tmp = gfu.vec.CreateVector()
+    tmp.data = gfu.vec - gfu2.vec
+    assert Norm(tmp) < 1e-7 * Norm(gfu.vec)
+
+def test_auto_preconditioner(tmpdir):
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.1))
+    fes = H1(mesh, order=3, dirichlet=".*")
+    u,v = fes.TnT()
+    f = LinearForm(fes)
+    f += SymbolicLFI(x*v)
+    f.Assemble()
+    cachefile = str(tmpdir.join("autosolver.txt"))
+
+    def Solve():
+        a = BilinearForm(fes, symmetric=True)
+        a += SymbolicBFI(grad(u)*grad(v))
+        c = Preconditioner(a, "auto", cachefile=cachefile)
+        a.Assemble()
+        gfu = GridFunction(fes)
+        solver = CGSolver(a.mat, c.mat, printrates=False, precision=1e-10, maxsteps=500)
+        gfu.vec.data = solver * f.vec
+        res = gfu.vec.CreateVector()
+        res.data = f.vec - a.mat * gfu.vec
+        assert Norm(res) < 1e-8 * Norm(f.vec)
+
+    # the first run tries the candidates and stores the winner
+    Solve()
+    lines = open(cachefile).readlines()
+    assert len(lines) == 1
+    signature, choice = lines[0].strip().rsplit(" | ", 1)
+    assert "H1HighOrderFESpace:3" in signature
+    assert choice in ["local", "block", "h1amg", "bddc", "direct"]
+
+    # the second run takes the cached choice, and appends nothing
+    Solve()
+    assert open(cachefile).readlines() == lines
+
+def test_eventlog(tmpdir):
+    import json
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = H1(mesh, order=2, dirichlet=".*")
+    u,v = fes.TnT()
+    a = BilinearForm(fes)
+    a += SymbolicBFI(grad(u)*grad(v))
+    c = Preconditioner(a, "local")
+    a.Assemble()
+    f = LinearForm(fes)
+    f += SymbolicLFI(v)
+    f.Assemble()
+    gfu = GridFunction(fes)
+
+    log = EventLog(str(tmpdir.join("events.jsonl")), flushsize=256)
+    SetEventLog(log)
+    try:
+        solver = CGSolver(a.mat, c.mat, printrates=False, precision=1e-10, maxsteps=200)
+        gfu.vec.data = solver * f.vec
+        log.Write("user", value=1.5, label="done")
+        log.LogTimers()
+    finally:
+        SetEventLog(None)
+    log.Flush()
+
+    records = [json.loads(line) for line in open(log.filename)]
+    its = [r for r in records if r["event"] == "iteration"]
+    solves = [r for r in records if r["event"] == "solve"]
+    assert len(its) == solver.GetSteps()+1
+    assert all(r["solver"] == "CG" for r in its)
+    assert len(solves) == 1 and solves[0]["steps"] == solver.GetSteps()
+    assert solves[0]["matrix_bytes"] > 0
+    assert any(r["event"] == "user" and r["label"] == "done" for r in records)
+    assert any(r["event"] == "timer" and r["name"] == "CG solver" for r in records)
+
+def test_timers():
+    t = Timer("pytest timer")
+    t.Reset()
+    snap = Timers()
+    for i in range(3):
+        with t:
+            t.AddFlops(100)
+    assert t.counts == 3 and t.flops == 300
+    step = Timers(since=snap, used_only=True)
+    mine = [tm for tm in step if tm["nr"] == t.nr]
+    assert len(mine) == 1 and mine[0]["counts"] == 3
+    assert all(tm["counts"] > 0 for tm in step)
+    off = Timer("pytest disabled timer", priority=3)
+    with off:
+        pass
+    assert off.counts == 0
+    t.Reset()
+    assert t.counts == 0 and t.time == 0
+
+def test_roofline():
+    peak_gflops, peak_gbs = SetRoofline(10, 5)
+    assert (peak_gflops, peak_gbs) == (10, 5)
+    t = Timer("pytest roofline timer")
+    t.Reset()
+    with t:
+        t.AddFlops(1000)
+        t.AddLoads(8000)
+        t.AddStores(8000)
+    mine = [tm for tm in Timers(used_only=True) if tm["nr"] == t.nr][0]
+    assert mine["loads"] == 8000 and mine["stores"] == 8000
+    assert mine["bound"] == "memory"
+    assert mine["flop/byte"] == pytest.approx(1000/16000)
+
+    # the sparse matrix-vector product counts its flops and bytes
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = H1(mesh, order=2)
+    u,v = fes.TnT()
+    a = BilinearForm(fes)
+    a += SymbolicBFI(u*v)
+    a.Assemble()
+    x = a.mat.CreateColVector()
+    y = a.mat.CreateColVector()
+    x[:] = 1
+    snap = Timers()
+    y.data = a.mat * x
+    mult = [tm for tm in Timers(since=snap, used_only=True) if tm["name"] == "SparseMatrix::MultAdd"]
+    assert len(mult) == 1
+    assert mult[0]["flops"] == 2*a.mat.nze
+    assert mult[0]["loads"] > 12*a.mat.nze
+
+def test_memory_registry():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = H1(mesh, order=3, dirichlet=".*")
+    u,v = fes.TnT()
+    before = MemoryRegistry(reset_peaks=True)
+    a = BilinearForm(fes)
+    a += SymbolicBFI(grad(u)*grad(v))
+    a.Assemble()
+    inv = a.mat.Inverse(fes.FreeDofs(), inverse="sparsecholesky")
+    mem = MemoryRegistry()
+    assert mem["matrix values"]["current"] - before["matrix values"]["current"] >= 8*a.mat.nze
+    assert mem["matrix graph"]["current"] > before["matrix graph"]["current"]
+    assert mem["factors"]["current"] > before["factors"]["current"]
+    assert mem["total"]["peak"] >= mem["total"]["current"]
+    del inv
+    assert MemoryRegistry()["factors"]["current"] == before["factors"]["current"]
+
+def test_job_statistics():
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.1))
+    fes = H1(mesh, order=3)
+    u,v = fes.TnT()
+    a = BilinearForm(fes)
+    a += SymbolicBFI(u*v)
+    a.Assemble()
+    x = a.mat.CreateColVector()
+    y = a.mat.CreateColVector()
+    x[:] = 1
+    SetNumThreads(2)
+    with TaskManager():
+        SetJobStatistics(True)
+        for i in range(10):
+            y.data = a.mat * x
+        SetJobStatistics(False)
+    stats = JobStatistics(reset=True)
+    mult = [s for s in stats if "SparseMatrix::MultAdd" in s["name"] and s["threads"] == 2]
+    assert len(mult) == 1
+    assert mult[0]["calls"] == 10 and len(mult[0]["idle"]) == 2
+    assert 0 < mult[0]["efficiency"] <= 1
+    assert mult[0]["imbalance"] >= 1 - 1e-8
+    assert JobStatistics() == []
+
+def test_newton_solver():
+    from ngsolve.solvers import Newton
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.2))
+    fes = H1(mesh, order=3, dirichlet=[1,2,3,4])
+    u,v = fes.TnT()
+    # minimization of 1/2 |grad u|^2 + 1/4 u^4 - 10 u
+    a = BilinearForm(fes, symmetric=False)
+    a += SymbolicEnergy(0.5*grad(u)*grad(u) + 0.25*u**4 - 10*u)
+    aref = BilinearForm(fes, symmetric=False)
+    aref += SymbolicBFI(grad(u)*grad(v) + u**3*v - 10*v)
+
+    ref = GridFunction(fes)
+    Newton(aref, ref, inverse="sparsecholesky", printing=False)
+
+    gfu = GridFunction(fes)
+    r = gfu.vec.CreateVector()
+    for opts in [dict(), dict(linesearch=True, energy=True),
+                 dict(jacobian_lag=3), dict(jacobian_lag=3, krylov=True, krylov_tol=1e-3)]:
+        gfu.vec[:] = 0
+        newton = NewtonSolver(a, inverse="sparsecholesky", maxerr=1e-10, **opts)
+        status, numit = newton.Solve(gfu.vec)
+        assert status == 0
+        r.data = gfu.vec - ref.vec
+        assert Norm(r) < 1e-8 * Norm(ref.vec)
+        if "jacobian_lag" in opts:
+            assert newton.nassemble < numit
+            assert newton.nupdate == newton.nassemble - 1
+
@@ -40,3 +40,63 @@ def test_vector_numpy():
     assert d[0] == c[0]
     d[1] = 1+3j
     assert d[1] == c[1]
+
+def test_snapshotstore(tmpdir):
+    n = 10000
+    v = Vector(n)
+    for i in range(n):
+        v[i] = i/n
+    w = Vector(n)
+    for filename in ["", str(tmpdir.join("snapshots.bin"))]:
+        for tol, background in [(0, False), (1e-6, True)]:
+            store = SnapshotStore(filename=filename, tolerance=tol, background=background)
+            for k in range(5):
+                v[0] = k
+                assert store.Store(v) == k
+            store.Wait()
+            assert len(store) == 5
+            assert store.nbytes < store.rawbytes
+            for k in [3, 0, 4]:
+                store.Load(k, w)
+                v[0] = k
+                assert max(abs(v[i]-w[i]) for i in range(n)) <= tol
+
+@pytest.mark.skipif(not hasattr(__import__("os"), "fork"), reason="needs fork")
+def test_sharedvector():
+    import os
+    name = "ngs_test_sharedvector_" + str(os.getpid())
+    v = CreateSharedVector(name, 100)
+    v[:] = 1
+    pid = os.fork()
+    if pid == 0:
+        w = AttachSharedVector(name)
+        ok = len(w) == 100 and w.FV()[0] == 1
+        w[:] = 3
+        os._exit(0 if ok else 1)
+    _, status = os.waitpid(pid, 0)
+    assert status == 0
+    assert all(x == 3 for x in v.FV())
+
+    from netgen.geom2d import unit_square
+    mesh = Mesh(unit_square.GenerateMesh(maxh=0.3))
+    fes = H1(mesh, order=2) * H1(mesh, order=1)
+    gf1, gf2 = GridFunction(fes), GridFunction(fes)
+    gf1.components[0].Set(x)
+    gf1.ShareVector(name + "_gf")
+    gf2.ShareVector(name + "_gf", create=False)
+    assert Integrate((gf2.components[0]-x)**2, mesh) < 1e-20
+    gf2.components[1].Set(y)
+    assert Integrate((gf1.components[1]-y)**2, mesh) < 1e-20
+
+def test_memory_pool():
+    ClearMemoryPool()
+    v = BaseVector(100000)
+    MemoryPool(reset=True)
+    for i in range(10):
+        w = v.CreateVector()
+        w[:] = 1
+        del w
+    stats = MemoryPool()
+    assert stats["allocs"] == 10
+    assert stats["reused"] == 9
+    assert stats["reused_same"] == 9
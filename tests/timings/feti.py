@@ -0,0 +1,54 @@
+# Timings of the FETI jump operator, call with
+# mpirun -np <n> ngspy feti.py [nvectors]
+#
+# Compares k applications of B^T to single vectors (one exchange each)
+# with one application to a MultiVector (one aggregated exchange).
+
+import sys
+import time
+from netgen.csg import unit_cube
+import netgen.meshing as netgen
+from ngsolve import *
+from ngsolve.la import FETI_Jump, MultiVector
+ngsglobals.msg_level=0
+
+comm = MPI_Init()
+nvecs = int(sys.argv[1]) if len(sys.argv) > 1 else 8
+
+if comm.rank == 0:
+    unit_cube.GenerateMesh(maxh=0.05).Save("feti_mesh.vol")
+comm.Barrier()
+ngmesh = netgen.Mesh(dim=3)
+ngmesh.Load("feti_mesh.vol")
+mesh = Mesh(ngmesh)
+
+fes = H1(mesh, order=2)
+B = FETI_Jump(fes.ParallelDofs())
+nu = B.height         # u-dofs
+nj = B.width          # jumps
+
+uvec = B.CreateRowVector()
+jvec = B.CreateColVector()
+X = MultiVector(nj, nvecs)
+Y = MultiVector(nu, nvecs)
+
+def measure(func, runs=20):
+    comm.Barrier()
+    start = time.time()
+    for i in range(runs):
+        func()
+    return comm.Max((time.time()-start)/runs)
+
+def single():
+    for j in range(nvecs):
+        jvec[:] = 1
+        uvec[:] = 0
+        B.MultTransAdd(1, jvec, uvec)
+
+t_single = measure(single)
+t_multi = measure(lambda: B.MultTransAdd(1, X, Y))
+
+if comm.rank == 0:
+    print("ranks:", comm.size, "global ndof:", fes.ndofglobal, "vectors:", nvecs)
+    print("B^T, vector by vector: {:.6f} s".format(t_single))
+    print("B^T, multivector:      {:.6f} s".format(t_multi))
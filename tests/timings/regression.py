@@ -0,0 +1,192 @@
+#
+# End to end performance regression harness.
+#
+# Every workload runs in its own process, once per thread count, so that
+# the memory high-water mark belongs to this workload only. The results,
+# including the timer table of the profiler, the memory registry by
+# category, the reuse of vector storage and the statistics of the
+# parallel jobs, are written as JSON.
+#
+#   python3 regression.py                       all workloads, 1 and all threads
+#   python3 regression.py -w poisson3 -t 1 2 4  selected workloads and threads
+#
+
+import argparse
+import json
+import multiprocessing
+import os
+import resource
+import socket
+import subprocess
+import sys
+import time
+
+workloads = ["poisson1", "poisson2", "poisson3", "poisson4", "poisson5", "poisson6",
+             "elasticity", "maxwell", "hdg", "poisson_amg", "poisson_bddc"]
+
+
+def Run(name, nthreads, maxh):
+    from netgen.csg import unit_cube
+    from ngsolve import (Mesh, H1, VectorH1, HCurl, L2, FacetFESpace, FESpace,
+                         BilinearForm, LinearForm, GridFunction, Preconditioner,
+                         SymbolicBFI, SymbolicLFI, grad, curl, specialcf,
+                         Sym, InnerProduct, Trace, CoefficientFunction, y,
+                         SetNumThreads, TaskManager, Timers, ResetTimers, MemoryRegistry, MemoryPool,
+                         SetJobStatistics, JobStatistics, ngsglobals)
+    from ngsolve.solvers import CG
+    ngsglobals.msg_level = 0
+
+    times = {}
+    def timed(key, func):
+        t = time.time()
+        res = func()
+        times[key] = times.get(key, 0.0) + time.time() - t
+        return res
+
+    mesh = timed("mesh", lambda: Mesh(unit_cube.GenerateMesh(maxh=maxh)))
+    SetNumThreads(nthreads)
+    with TaskManager():
+        ResetTimers()
+        MemoryPool(reset=True)
+        SetJobStatistics(True)
+        pre = None
+        inverse = "sparsecholesky"
+        condense = False
+        if name.startswith("poisson"):
+            order = int(name[7]) if name[7:8].isdigit() else 3
+            fes = H1(mesh, order=order, dirichlet=".*")
+            u,v = fes.TnT()
+            blf = grad(u)*grad(v)
+            lf = v
+            if name == "poisson_amg":
+                fes = H1(mesh, order=1, dirichlet=".*")
+                u,v = fes.TnT()
+                blf = grad(u)*grad(v)
+                lf = v
+                pre = "h1amg"
+            elif name == "poisson_bddc":
+                pre = "bddc"
+        elif name == "elasticity":
+            fes = VectorH1(mesh, order=3, dirichlet="left")
+            u,v = fes.TnT()
+            eps = lambda w: Sym(grad(w))
+            blf = 2*InnerProduct(eps(u), eps(v)) + Trace(eps(u))*Trace(eps(v))
+            lf = v[2]
+            pre = "bddc"
+        elif name == "maxwell":
+            fes = HCurl(mesh, order=2, dirichlet=".*", nograds=True)
+            u,v = fes.TnT()
+            blf = curl(u)*curl(v) + 1e-3*u*v
+            lf = CoefficientFunction((y,0,0))*v
+            pre = "bddc"
+        elif name == "hdg":
+            order = 3
+            V = L2(mesh, order=order)
+            F = FacetFESpace(mesh, order=order, dirichlet=".*")
+            fes = FESpace([V,F])
+            (u,uhat),(v,vhat) = fes.TnT()
+            n = specialcf.normal(3)
+            h = specialcf.mesh_size
+            alpha = 4*order**2
+            jump_u = u-uhat
+            jump_v = v-vhat
+            blf = grad(u)*grad(v)
+            bfacet = (alpha/h*jump_u*jump_v - grad(u)*n*jump_v - grad(v)*n*jump_u)
+            lf = v
+            condense = True
+            pre = "bddc"
+
+        a = BilinearForm(fes, symmetric=True, condense=condense)
+        a += SymbolicBFI(blf)
+        if name == "hdg":
+            a += SymbolicBFI(bfacet, element_boundary=True)
+        f = LinearForm(fes)
+        f += SymbolicLFI(lf)
+        c = Preconditioner(a, pre) if pre else None
+        gfu = GridFunction(fes)
+
+        timed("assemble", lambda: (a.Assemble(), f.Assemble()))
+
+        rhs = gfu.vec.CreateVector()
+        rhs.data = f.vec
+        if condense:
+            rhs.data += a.harmonic_extension_trans * rhs
+
+        if c is None:
+            inv = timed("setup", lambda: a.mat.Inverse(fes.FreeDofs(condense), inverse=inverse))
+            t = time.time()
+            gfu.vec.data = inv * rhs
+            times["solve"] = time.time() - t
+        else:
+            # the preconditioner is built by Assemble, count it as setup
+            times["setup"] = times.pop("assemble")
+            times["assemble"] = 0.0
+            t = time.time()
+            CG(a.mat, rhs, pre=c.mat, sol=gfu.vec, tol=1e-8, maxsteps=1000, printrates=False)
+            times["solve"] = time.time() - t
+
+        if condense:
+            t = time.time()
+            gfu.vec.data += a.harmonic_extension * gfu.vec
+            gfu.vec.data += a.inner_solve * f.vec
+            times["solve"] += time.time() - t
+
+        timers = Timers(used_only=True)
+        memory = MemoryRegistry()
+        pool = MemoryPool()
+        SetJobStatistics(False)
+        # the most expensive parallel regions, for the scaling by call site
+        jobs = JobStatistics()[:20]
+
+    maxrss = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    if sys.platform == "darwin":
+        maxrss //= 1024
+    return { "workload" : name, "nthreads" : nthreads, "maxh" : maxh,
+             "ndof" : fes.ndof, "nze" : a.mat.nze,
+             "times" : times, "maxrss_kb" : maxrss, "memory" : memory, "pool" : pool, "jobs" : jobs,
+             "timers" : timers }
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='End to end NGSolve performance regression runs')
+    parser.add_argument('-w', '--workloads', nargs='+', default=workloads, choices=workloads)
+    parser.add_argument('-t', '--threads', nargs='+', type=int,
+                        default=sorted(set([1, multiprocessing.cpu_count()])))
+    parser.add_argument('--maxh', type=float, default=0.1, help='mesh size of the unit cube')
+    parser.add_argument('-o', '--output', default='regression.json')
+    parser.add_argument('--run', help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.run:
+        # child process: a single workload, result on stdout
+        print(json.dumps(Run(args.run, args.threads[0], args.maxh)))
+        sys.exit(0)
+
+    results = { "runs" : [] }
+    if "CI_BUILD_REF" in os.environ:
+        results['commit'] = os.environ["CI_BUILD_REF"]
+    results['build'] = { 'compiler' : "@CMAKE_CXX_COMPILER_ID@-@CMAKE_CXX_COMPILER_VERSION@",
+                         'cxx_flags' : "@CMAKE_CXX_FLAGS@ @NGSOLVE_COMPILE_OPTIONS@".strip(),
+                         'hostname' : socket.gethostname(),
+                         'ncpus' : multiprocessing.cpu_count() }
+
+    for name in args.workloads:
+        for nthreads in args.threads:
+            out = subprocess.check_output([sys.executable, __file__, "--run", name,
+                                           "-t", str(nthreads), "--maxh", str(args.maxh)])
+            run = json.loads(out.decode().strip().splitlines()[-1])
+            results["runs"].append(run)
+            t = run["times"]
+            print("{:14s} threads = {:3d}  ndof = {:8d}  assemble = {:7.3f}  setup = {:7.3f}  solve = {:7.3f}  maxrss = {:8.1f} MB"
+                  .format(name, nthreads, run["ndof"], t["assemble"], t["setup"], t["solve"],
+                          run["maxrss_kb"]/1024))
+
+    # speedup against the smallest thread count
+    for name in args.workloads:
+        runs = [r for r in results["runs"] if r["workload"] == name]
+        base = min(runs, key=lambda r: r["nthreads"])
+        for r in runs:
+            r["speedup"] = { key : base["times"][key] / r["times"][key] if r["times"][key] > 0 else 0.0
+                             for key in ["assemble", "setup", "solve"] }
+
+    json.dump(results, open(args.output, 'w'), indent=1)